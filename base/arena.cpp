@@ -0,0 +1,120 @@
+#include "base/arena.hpp"
+
+#include "base/assert.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace base
+{
+namespace
+{
+// Returns the first address in [pos, end) aligned to |alignment| after which |size| bytes fit
+// or nullptr.
+char * Align(char * pos, char * end, size_t size, size_t alignment)
+{
+  if (pos == nullptr)
+    return nullptr;
+
+  auto const address = reinterpret_cast<uintptr_t>(pos);
+  auto const aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+  auto const last = reinterpret_cast<uintptr_t>(end);
+  if (aligned > last || last - aligned < size)
+    return nullptr;
+  return reinterpret_cast<char *>(aligned);
+}
+}  // namespace
+
+Arena::Arena(size_t chunkSize, memory::Tag * tag) : m_chunkSize(chunkSize), m_heldChunksSize(tag)
+{
+  CHECK_GREATER(m_chunkSize, 0, ());
+}
+
+void * Arena::Allocate(size_t size, size_t alignment)
+{
+  CHECK(alignment != 0 && (alignment & (alignment - 1)) == 0, (alignment));
+  if (size == 0)
+    size = 1;
+
+  auto & slot = GetSlot();
+  std::lock_guard<std::mutex> lock(slot.m_mutex);
+  if (auto * result = Align(slot.m_pos, slot.m_end, size, alignment))
+  {
+    slot.m_pos = result + size;
+    return result;
+  }
+
+  // A large block gets its own chunk, the current chunk of the thread is kept.
+  if (size > m_chunkSize / 4 || size + alignment > m_chunkSize)
+  {
+    auto * chunk = NewChunk(size + alignment);
+    return Align(chunk, chunk + size + alignment, size, alignment);
+  }
+
+  auto * chunk = NewChunk(m_chunkSize);
+  auto * result = Align(chunk, chunk + m_chunkSize, size, alignment);
+  CHECK(result, ());
+  slot.m_pos = result + size;
+  slot.m_end = chunk + m_chunkSize;
+  return result;
+}
+
+void Arena::Reset()
+{
+  for (auto & slot : m_slots)
+  {
+    std::lock_guard<std::mutex> lock(slot.m_mutex);
+    slot.m_pos = nullptr;
+    slot.m_end = nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(m_chunksMutex);
+  size_t droppedSize = 0;
+  for (auto & chunk : m_chunks)
+  {
+    if (chunk.m_size == m_chunkSize)
+      m_freeChunks.push_back(std::move(chunk));
+    else
+      droppedSize += chunk.m_size;
+  }
+  m_heldChunksSize.Set(m_heldChunksSize.Get() - droppedSize);
+  m_chunks.clear();
+  m_usedChunksSize = 0;
+}
+
+size_t Arena::GetUsedChunksSize() const
+{
+  std::lock_guard<std::mutex> lock(m_chunksMutex);
+  return m_usedChunksSize;
+}
+
+Arena::Slot & Arena::GetSlot()
+{
+  static std::atomic<size_t> threadsCount{0};
+  static thread_local size_t const index = threadsCount++ % kSlotsCount;
+  return m_slots[index];
+}
+
+char * Arena::NewChunk(size_t size)
+{
+  std::lock_guard<std::mutex> lock(m_chunksMutex);
+  Chunk chunk;
+  if (size == m_chunkSize && !m_freeChunks.empty())
+  {
+    chunk = std::move(m_freeChunks.back());
+    m_freeChunks.pop_back();
+  }
+  else
+  {
+    // The memory is not value-initialized unlike std::make_unique<char[]>.
+    chunk.m_data.reset(new char[size]);
+    chunk.m_size = size;
+    m_heldChunksSize.Set(m_heldChunksSize.Get() + size);
+  }
+
+  auto * data = chunk.m_data.get();
+  m_usedChunksSize += chunk.m_size;
+  m_chunks.push_back(std::move(chunk));
+  return data;
+}
+}  // namespace base
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "base/macros.hpp"
+#include "base/memory_accounting.hpp"
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+// A monotonic allocator for the huge numbers of the small objects which die together.
+// Allocate() bumps a pointer in the current chunk, the memory is never freed one by one
+// and is released at once by Reset() or by the destructor. The destructors of the objects
+// are not called by the arena.
+// Allocate() may be called from several threads: every thread bumps its own current chunk,
+// so the threads do not share a lock on the fast path.
+class Arena
+{
+public:
+  static size_t constexpr kDefaultChunkSize = 64 * 1024;
+
+  // The chunks held by the arena, both used and free, are counted in |tag| if it is not null.
+  explicit Arena(size_t chunkSize = kDefaultChunkSize, memory::Tag * tag = nullptr);
+
+  void * Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  // The object is not destroyed by the arena, so T should be trivially destructible
+  // or be destroyed by the caller.
+  template <typename T, typename... Args>
+  T * New(Args &&... args)
+  {
+    return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  // Releases all the allocated memory at once. The chunks of the default size are kept
+  // for the next allocations. Must not be called concurrently with Allocate().
+  void Reset();
+
+  // The total size of the chunks which are in use.
+  size_t GetUsedChunksSize() const;
+
+private:
+  // The current chunk of a thread. The padding keeps the slots in the different cache lines.
+  struct Slot
+  {
+    std::mutex m_mutex;
+    char * m_pos = nullptr;
+    char * m_end = nullptr;
+    char m_padding[64];
+  };
+
+  struct Chunk
+  {
+    std::unique_ptr<char[]> m_data;
+    size_t m_size = 0;
+  };
+
+  static size_t constexpr kSlotsCount = 32;
+
+  // Returns the slot of the calling thread. The threads which are more than kSlotsCount
+  // share the slots.
+  Slot & GetSlot();
+  char * NewChunk(size_t size);
+
+  size_t const m_chunkSize;
+  std::array<Slot, kSlotsCount> m_slots;
+
+  mutable std::mutex m_chunksMutex;
+  std::vector<Chunk> m_chunks;
+  std::vector<Chunk> m_freeChunks;
+  size_t m_usedChunksSize = 0;
+  memory::ScopedBytes m_heldChunksSize;
+
+  DISALLOW_COPY_AND_MOVE(Arena);
+};
+
+// An STL allocator in an Arena. The arena should outlive the containers and the objects
+// which use the allocator, deallocate() does nothing.
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena & arena) noexcept : m_arena(&arena) {}
+
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const & other) noexcept : m_arena(&other.GetArena())
+  {
+  }
+
+  T * allocate(size_t n)
+  {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    return static_cast<T *>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) noexcept {}
+
+  Arena & GetArena() const noexcept { return *m_arena; }
+
+private:
+  Arena * m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(ArenaAllocator<T> const & lhs, ArenaAllocator<U> const & rhs) noexcept
+{
+  return &lhs.GetArena() == &rhs.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(ArenaAllocator<T> const & lhs, ArenaAllocator<U> const & rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}  // namespace base
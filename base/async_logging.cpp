@@ -0,0 +1,327 @@
+#include "base/async_logging.hpp"
+
+#include "base/assert.hpp"
+#include "base/timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+namespace
+{
+struct Record
+{
+  LogLevel m_level = LINFO;
+  SrcPoint m_srcPoint;
+  std::string m_msg;
+  double m_seconds = 0.0;
+};
+
+// A single producer single consumer ring of the records of a thread.
+class Ring
+{
+public:
+  Ring(size_t size, int threadId) : m_records(std::max(size, size_t{1})), m_threadId(threadId) {}
+
+  int GetThreadId() const { return m_threadId; }
+
+  // Called by the owner thread only.
+  bool TryPush(Record && record)
+  {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == m_records.size())
+      return false;
+
+    m_records[tail % m_records.size()] = std::move(record);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the writer only.
+  template <typename Fn>
+  void PopAll(Fn && fn)
+  {
+    auto head = m_head.load(std::memory_order_relaxed);
+    auto const tail = m_tail.load(std::memory_order_acquire);
+    for (; head != tail; ++head)
+    {
+      auto & record = m_records[head % m_records.size()];
+      fn(record);
+      record.m_msg = {};
+    }
+    m_head.store(head, std::memory_order_release);
+  }
+
+  bool IsHalfFull() const
+  {
+    return 2 * (m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed)) >=
+           m_records.size();
+  }
+
+  bool IsEmpty() const
+  {
+    return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+  }
+
+  std::atomic<bool> m_closed{false};
+
+private:
+  std::vector<Record> m_records;
+  std::atomic<size_t> m_head{0};
+  std::atomic<size_t> m_tail{0};
+  int const m_threadId;
+};
+
+// The counters of the call sites for the current second. The sites with the same hash share
+// a counter.
+class RateLimiter
+{
+public:
+  bool Allow(SrcPoint const & srcPoint, uint64_t second, uint32_t limit)
+  {
+    auto const hash = std::hash<char const *>()(srcPoint.FileName()) * 31 +
+                      static_cast<size_t>(srcPoint.Line());
+    auto & site = m_sites[hash % m_sites.size()];
+    auto siteSecond = site.m_second.load(std::memory_order_relaxed);
+    if (siteSecond != second &&
+        site.m_second.compare_exchange_strong(siteSecond, second, std::memory_order_relaxed))
+    {
+      site.m_count.store(0, std::memory_order_relaxed);
+    }
+    return site.m_count.fetch_add(1, std::memory_order_relaxed) < limit;
+  }
+
+private:
+  struct Site
+  {
+    std::atomic<uint64_t> m_second{0};
+    std::atomic<uint32_t> m_count{0};
+  };
+
+  std::array<Site, 1024> m_sites;
+};
+
+class AsyncLogger
+{
+public:
+  // The logger is never destroyed: the threads may log while the static objects are destroyed.
+  static AsyncLogger & Instance()
+  {
+    static auto * logger = new AsyncLogger();
+    return *logger;
+  }
+
+  void Start(AsyncLoggingParams const & params)
+  {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    CHECK(!m_writer.joinable(), ("Async logging is already started."));
+    m_params = params;
+    m_output = params.m_output ? params.m_output : &std::cerr;
+    m_stop = false;
+    m_writer = std::thread(&AsyncLogger::WriterLoop, this);
+    m_started.store(true);
+  }
+
+  void Stop()
+  {
+    m_started.store(false);
+    {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_writer.joinable())
+      m_writer.join();
+    Flush();
+  }
+
+  bool IsStarted() const { return m_started.load(); }
+
+  void Push(LogLevel level, SrcPoint const & srcPoint, std::string const & msg)
+  {
+    auto const seconds = m_timer.ElapsedSeconds();
+    if (!m_limiter.Allow(srcPoint, static_cast<uint64_t>(seconds),
+                         m_params.m_maxMessagesPerSecondPerSite))
+    {
+      ++m_dropped;
+      return;
+    }
+
+    auto & ring = GetRing();
+    Record record;
+    record.m_level = level;
+    record.m_srcPoint = srcPoint;
+    record.m_msg = msg;
+    record.m_seconds = seconds;
+    if (!ring.TryPush(std::move(record)))
+    {
+      ++m_dropped;
+      return;
+    }
+
+    if (ring.IsHalfFull())
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_flushRequested = true;
+      }
+      m_wake.notify_one();
+    }
+  }
+
+  // Writes all the records which are visible to the calling thread.
+  void Flush()
+  {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    WriteLocked();
+  }
+
+  uint64_t GetDropped() const { return m_dropped.load(); }
+
+private:
+  struct RingHolder
+  {
+    ~RingHolder()
+    {
+      if (m_ring)
+        m_ring->m_closed = true;
+    }
+
+    std::shared_ptr<Ring> m_ring;
+  };
+
+  AsyncLogger() = default;
+
+  Ring & GetRing()
+  {
+    static thread_local RingHolder holder;
+    if (!holder.m_ring)
+    {
+      std::lock_guard<std::mutex> lock(m_ringsMutex);
+      holder.m_ring =
+          std::make_shared<Ring>(m_params.m_threadBufferSize, static_cast<int>(++m_threadsCount));
+      m_rings.push_back(holder.m_ring);
+    }
+    return *holder.m_ring;
+  }
+
+  void WriterLoop()
+  {
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_params.m_flushPeriodMs),
+                        [this] { return m_stop || m_flushRequested; });
+        if (m_stop)
+          return;
+        m_flushRequested = false;
+      }
+      Flush();
+    }
+  }
+
+  void WriteLocked()
+  {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+      std::lock_guard<std::mutex> lock(m_ringsMutex);
+      // The rings of the finished threads are removed when they are written out.
+      auto const it = std::remove_if(m_rings.begin(), m_rings.end(), [](auto const & ring) {
+        return ring->m_closed.load() && ring->IsEmpty();
+      });
+      m_rings.erase(it, m_rings.end());
+      rings = m_rings;
+    }
+
+    auto const & names = GetLogLevelNames();
+    std::ostringstream out;
+    for (auto const & ring : rings)
+    {
+      ring->PopAll([&](Record const & record) {
+        auto const name = names[record.m_level];
+        out << "LOG TID(" << ring->GetThreadId() << ") " << name << " " << std::setfill(' ')
+            << std::setw(static_cast<int>(16 - strlen(name))) << record.m_seconds << " "
+            << DebugPrint(record.m_srcPoint) << record.m_msg << "\n";
+      });
+    }
+
+    auto const dropped = m_dropped.load();
+    if (dropped != m_reportedDropped)
+    {
+      out << "LOG " << names[LWARNING] << " " << dropped - m_reportedDropped
+          << " messages have been dropped by the async logging\n";
+      m_reportedDropped = dropped;
+    }
+
+    auto const str = out.str();
+    if (!str.empty())
+      *m_output << str << std::flush;
+  }
+
+  AsyncLoggingParams m_params;
+  std::ostream * m_output = &std::cerr;
+  base::Timer m_timer;
+  RateLimiter m_limiter;
+  std::atomic<bool> m_started{false};
+  std::atomic<uint64_t> m_dropped{0};
+
+  std::mutex m_ringsMutex;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+  unsigned int m_threadsCount = 0;
+
+  // Guards the output and |m_reportedDropped|.
+  std::mutex m_writeMutex;
+  uint64_t m_reportedDropped = 0;
+
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  bool m_stop = false;
+  bool m_flushRequested = false;
+  std::thread m_writer;
+};
+}  // namespace
+
+void LogMessageAsync(LogLevel level, SrcPoint const & srcPoint, std::string const & msg)
+{
+  auto & logger = AsyncLogger::Instance();
+  if (!logger.IsStarted() || level >= g_LogAbortLevel)
+  {
+    // The pending records go first.
+    logger.Flush();
+    LogMessageDefault(level, srcPoint, msg);
+    return;
+  }
+
+  logger.Push(level, srcPoint, msg);
+}
+
+void FlushAsyncLogging() { AsyncLogger::Instance().Flush(); }
+
+uint64_t GetDroppedLogMessagesCount() { return AsyncLogger::Instance().GetDropped(); }
+
+ScopedAsyncLogging::ScopedAsyncLogging(AsyncLoggingParams const & params)
+{
+  AsyncLogger::Instance().Start(params);
+  m_prevLogMessage = SetLogMessageFn(&LogMessageAsync);
+}
+
+ScopedAsyncLogging::~ScopedAsyncLogging()
+{
+  SetLogMessageFn(m_prevLogMessage);
+  AsyncLogger::Instance().Stop();
+}
+}  // namespace base
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "base/logging.hpp"
+#include "base/macros.hpp"
+#include "base/src_point.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace base
+{
+struct AsyncLoggingParams
+{
+  // The records of a thread which are not yet written. The records which do not fit are dropped.
+  size_t m_threadBufferSize = 4096;
+  // The records of a call site per second. The records above the limit are dropped.
+  uint32_t m_maxMessagesPerSecondPerSite = 100;
+  uint32_t m_flushPeriodMs = 50;
+  // std::cerr if it is not set.
+  std::ostream * m_output = nullptr;
+};
+
+// An asynchronous LogMessage. The message is put into the ring buffer of the calling thread
+// and is written by a background thread, so a worker does not wait for the output and
+// for the other loggers. The messages of a call site (a file and a line) are rate limited.
+// The messages of the abort level and higher are written synchronously after all the
+// pending records and abort as LogMessageDefault does.
+// The sink is switched on by ScopedAsyncLogging, so the call sites do not change.
+void LogMessageAsync(LogLevel level, SrcPoint const & srcPoint, std::string const & msg);
+
+// Waits until all the records put before the call are written.
+void FlushAsyncLogging();
+
+// The number of the records dropped because of the full buffers and of the rate limits.
+uint64_t GetDroppedLogMessagesCount();
+
+// Starts the background writer and sets LogMessageAsync as LogMessage.
+// The destructor writes the pending records and restores the previous LogMessage.
+// There should be a single instance at a time.
+class ScopedAsyncLogging
+{
+public:
+  explicit ScopedAsyncLogging(AsyncLoggingParams const & params = {});
+  ~ScopedAsyncLogging();
+
+private:
+  LogMessageFn m_prevLogMessage;
+
+  DISALLOW_COPY_AND_MOVE(ScopedAsyncLogging);
+};
+}  // namespace base
@@ -0,0 +1,101 @@
+#include "testing/testing.hpp"
+
+#include "base/arena.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+UNIT_TEST(Arena_Allocate)
+{
+  Arena arena(1024 /* chunkSize */);
+  std::vector<char *> blocks;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    size_t const alignment = size_t{1} << (i % 5);
+    auto * block = static_cast<char *>(arena.Allocate(i % 17 + 1, alignment));
+    TEST_EQUAL(reinterpret_cast<uintptr_t>(block) % alignment, 0, ());
+    std::memset(block, static_cast<int>(i % 256), i % 17 + 1);
+    blocks.push_back(block);
+  }
+
+  // The blocks do not overlap.
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    for (size_t j = 0; j < i % 17 + 1; ++j)
+      TEST_EQUAL(static_cast<unsigned char>(blocks[i][j]), i % 256, (i, j));
+  }
+
+  // A large block gets its own chunk.
+  auto * large = static_cast<char *>(arena.Allocate(10000));
+  std::memset(large, 0, 10000);
+  TEST_GREATER_OR_EQUAL(arena.GetUsedChunksSize(), 10000, ());
+}
+
+UNIT_TEST(Arena_Reset)
+{
+  Arena arena(1024 /* chunkSize */);
+  for (size_t i = 0; i < 100; ++i)
+    arena.Allocate(100);
+  auto const used = arena.GetUsedChunksSize();
+  TEST_GREATER_OR_EQUAL(used, 100 * 100, ());
+
+  arena.Reset();
+  TEST_EQUAL(arena.GetUsedChunksSize(), 0, ());
+
+  for (size_t i = 0; i < 100; ++i)
+    arena.Allocate(100);
+  TEST_EQUAL(arena.GetUsedChunksSize(), used, ());
+}
+
+UNIT_TEST(Arena_Allocator)
+{
+  Arena arena;
+  ArenaVector<uint64_t> v{ArenaAllocator<uint64_t>(arena)};
+  for (uint64_t i = 0; i < 10000; ++i)
+    v.push_back(i * i);
+  for (uint64_t i = 0; i < v.size(); ++i)
+    TEST_EQUAL(v[i], i * i, ());
+
+  using String = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+  String s("A string which does not fit the short string buffer", ArenaAllocator<char>(arena));
+  s += s;
+  TEST_EQUAL(s.size(), 102, ());
+
+  auto ptr = std::allocate_shared<std::string>(ArenaAllocator<std::string>(arena), "value");
+  TEST_EQUAL(*ptr, "value", ());
+
+  Arena other;
+  TEST(ArenaAllocator<int>(arena) == ArenaAllocator<char>(arena), ());
+  TEST(ArenaAllocator<int>(arena) != ArenaAllocator<int>(other), ());
+}
+
+UNIT_TEST(Arena_Threads)
+{
+  Arena arena(4096 /* chunkSize */);
+  size_t const threadsCount = 8;
+  size_t const blocksCount = 10000;
+  std::vector<std::vector<uint32_t *>> blocks(threadsCount);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threadsCount; ++t)
+  {
+    threads.emplace_back([&arena, &blocks, t, blocksCount] {
+      for (size_t i = 0; i < blocksCount; ++i)
+        blocks[t].push_back(arena.New<uint32_t>(static_cast<uint32_t>(t * blocksCount + i)));
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  for (size_t t = 0; t < threadsCount; ++t)
+  {
+    for (size_t i = 0; i < blocksCount; ++i)
+      TEST_EQUAL(*blocks[t][i], t * blocksCount + i, ());
+  }
+}
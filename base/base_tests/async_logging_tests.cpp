@@ -0,0 +1,91 @@
+#include "testing/testing.hpp"
+
+#include "base/async_logging.hpp"
+#include "base/logging.hpp"
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+namespace
+{
+size_t CountLines(std::string const & text, std::string const & substr)
+{
+  size_t count = 0;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.find(substr) != std::string::npos)
+      ++count;
+  }
+  return count;
+}
+}  // namespace
+
+UNIT_TEST(AsyncLogging_Threads)
+{
+  std::ostringstream out;
+  {
+    AsyncLoggingParams params;
+    params.m_output = &out;
+    params.m_maxMessagesPerSecondPerSite = 1000000;
+    params.m_threadBufferSize = 1 << 16;
+    ScopedAsyncLogging logging(params);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+      threads.emplace_back([t] {
+        for (size_t i = 0; i < 1000; ++i)
+          LOG(LINFO, ("thread", t, "message", i));
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+  }
+
+  auto const text = out.str();
+  TEST_EQUAL(CountLines(text, "message"), 4000, ());
+
+  // The messages of a thread keep their order.
+  for (size_t t = 0; t < 4; ++t)
+  {
+    size_t prev = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      auto const pos =
+          text.find("thread " + std::to_string(t) + " message " + std::to_string(i) + "\n");
+      TEST(pos != std::string::npos, (t, i));
+      TEST_GREATER_OR_EQUAL(pos, prev, (t, i));
+      prev = pos;
+    }
+  }
+}
+
+UNIT_TEST(AsyncLogging_Drops)
+{
+  std::ostringstream out;
+  auto const droppedBefore = GetDroppedLogMessagesCount();
+  {
+    AsyncLoggingParams params;
+    params.m_output = &out;
+    params.m_maxMessagesPerSecondPerSite = 10;
+    ScopedAsyncLogging logging(params);
+
+    for (size_t i = 0; i < 100; ++i)
+      LOG(LINFO, ("limited", i));
+    FlushAsyncLogging();
+  }
+
+  auto const text = out.str();
+  // The messages may be split between two seconds.
+  TEST_GREATER_OR_EQUAL(CountLines(text, "limited"), 10, ());
+  TEST_LESS_OR_EQUAL(CountLines(text, "limited"), 20, ());
+  TEST_GREATER_OR_EQUAL(GetDroppedLogMessagesCount() - droppedBefore, 80, ());
+  TEST_GREATER_OR_EQUAL(CountLines(text, "have been dropped"), 1, ());
+}
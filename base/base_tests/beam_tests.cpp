@@ -73,6 +73,24 @@ UNIT_TEST(Beam_Smoke)
   Smoke<base::HeapBeam>();
 }
 
+UNIT_TEST(Beam_LowestValue)
+{
+  base::Beam<uint32_t, double> beam(3 /* capacity */);
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    TEST(!beam.IsFull(), ());
+    beam.Add(i, static_cast<double>(i + 1));
+    TEST_EQUAL(beam.GetLowestValue(), 1.0, ());
+  }
+  TEST(beam.IsFull(), ());
+
+  beam.Add(3, 0.5);
+  TEST_EQUAL(beam.GetLowestValue(), 1.0, ());
+  beam.Add(4, 2.5);
+  TEST_EQUAL(beam.GetLowestValue(), 2.0, ());
+  TEST(beam.IsFull(), ());
+}
+
 UNIT_TEST(Beam_Benchmark)
 {
   size_t const kCapacity = 100;
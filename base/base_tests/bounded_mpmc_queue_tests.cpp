@@ -0,0 +1,144 @@
+#include "testing/testing.hpp"
+
+#include "base/bounded_mpmc_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace base::threads;
+
+namespace
+{
+template <typename Queue>
+void TestProducersConsumers(size_t producersCount, size_t consumersCount, bool batches)
+{
+  size_t const kValuesPerProducer = 20000;
+  size_t const kBatchSize = 7;
+
+  Queue queue(16);
+  std::atomic<uint64_t> sum{0};
+  std::atomic<size_t> popped{0};
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producersCount; ++p)
+  {
+    threads.emplace_back([&queue, p, batches, kValuesPerProducer, kBatchSize]() {
+      std::vector<uint64_t> batch;
+      for (uint64_t i = 1; i <= kValuesPerProducer; ++i)
+      {
+        uint64_t const value = p * kValuesPerProducer + i;
+        if (!batches)
+        {
+          queue.Push(value);
+          continue;
+        }
+
+        batch.push_back(value);
+        if (batch.size() == kBatchSize || i == kValuesPerProducer)
+        {
+          queue.PushBatch(batch.begin(), batch.end());
+          batch.clear();
+        }
+      }
+    });
+  }
+
+  // Every consumer stops at its own zero.
+  for (size_t c = 0; c < consumersCount; ++c)
+  {
+    threads.emplace_back([&queue, &sum, &popped, batches, kBatchSize]() {
+      std::vector<uint64_t> values;
+      while (true)
+      {
+        values.clear();
+        if (batches)
+        {
+          queue.WaitAndPopBatch(values, kBatchSize);
+        }
+        else
+        {
+          values.emplace_back();
+          queue.WaitAndPop(values.back());
+        }
+
+        // All the values precede the zeros, so only the zeros may follow a zero in a batch.
+        auto const zero = std::find(values.begin(), values.end(), 0);
+        for (auto it = values.begin(); it != zero; ++it)
+        {
+          sum += *it;
+          ++popped;
+        }
+
+        if (zero != values.end())
+        {
+          // Returns the zeros of the other consumers.
+          for (auto it = std::next(zero); it != values.end(); ++it)
+            queue.Push(0);
+          return;
+        }
+      }
+    });
+  }
+
+  for (size_t p = 0; p < producersCount; ++p)
+    threads[p].join();
+  for (size_t c = 0; c < consumersCount; ++c)
+    queue.Push(0);
+  for (size_t c = producersCount; c < threads.size(); ++c)
+    threads[c].join();
+
+  uint64_t const n = producersCount * kValuesPerProducer;
+  TEST_EQUAL(popped, n, ());
+  TEST_EQUAL(sum, n * (n + 1) / 2, ());
+  TEST(queue.Empty(), ());
+}
+}  // namespace
+
+UNIT_TEST(BoundedMpmcQueue_Smoke)
+{
+  BoundedMpmcQueue<std::unique_ptr<int>> queue(3);
+  TEST_EQUAL(queue.GetCapacity(), 4, ());
+  TEST(queue.Empty(), ());
+
+  std::unique_ptr<int> value;
+  TEST(!queue.TryPop(value), ());
+  for (int i = 0; i < 4; ++i)
+    TEST(queue.TryPush(std::make_unique<int>(i)), ());
+  TEST(!queue.TryPush(std::make_unique<int>(4)), ());
+  TEST_EQUAL(queue.Size(), 4, ());
+
+  for (int i = 0; i < 4; ++i)
+  {
+    TEST(queue.TryPop(value), ());
+    TEST_EQUAL(*value, i, ());
+  }
+  TEST(queue.Empty(), ());
+}
+
+UNIT_TEST(BoundedMpmcQueue_Batches)
+{
+  BoundedMpmcQueue<int> queue(8);
+  std::vector<int> values = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  auto const it = queue.TryPushBatch(values.begin(), values.end());
+  TEST_EQUAL(it - values.begin(), 8, ());
+
+  std::vector<int> popped;
+  TEST_EQUAL(queue.TryPopBatch(popped, 3), 3, ());
+  TEST_EQUAL(queue.TryPushBatch(it, values.end()), values.end(), ());
+  TEST_EQUAL(queue.TryPopBatch(popped, 100), 7, ());
+  TEST_EQUAL(popped, values, ());
+  TEST_EQUAL(queue.TryPopBatch(popped, 100), 0, ());
+}
+
+UNIT_TEST(BoundedMpmcQueue_ProducersConsumers)
+{
+  TestProducersConsumers<BoundedMpmcQueue<uint64_t>>(4, 4, false /* batches */);
+  TestProducersConsumers<BoundedMpmcQueue<uint64_t>>(1, 3, true /* batches */);
+  TestProducersConsumers<BoundedMpmcQueue<uint64_t, BlockingWait>>(3, 1, false /* batches */);
+  TestProducersConsumers<BoundedMpmcQueue<uint64_t, BlockingWait>>(4, 4, true /* batches */);
+}
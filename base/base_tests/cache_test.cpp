@@ -92,6 +92,18 @@ UNIT_TEST(CacheSmoke_0)
   TEST_EQUAL(v, std::vector<char>(8, 0), ());
 }
 
+UNIT_TEST(CacheSmoke_HasKey)
+{
+  base::Cache<uint32_t, char> cache(3); // it contains 2^3=8 elements
+  TEST(!cache.HasKey(5), ());
+  TEST(!cache.HasKey(5), ());
+
+  bool found = true;
+  cache.Find(5, found);
+  TEST(!found, ());
+  TEST(cache.HasKey(5), ());
+}
+
 UNIT_TEST(CacheSmoke_1)
 {
   base::Cache<uint32_t, char> cache(3); // it contains 2^3=8 elements
@@ -0,0 +1,112 @@
+#include "testing/testing.hpp"
+
+#include "base/flat_hash_map.hpp"
+#include "base/geo_object_id.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace base;
+using namespace std;
+
+UNIT_TEST(FlatHashMap_Smoke)
+{
+  FlatHashMap<uint64_t, string> m;
+  TEST(m.empty(), ());
+  TEST(m.find(1) == m.end(), ());
+
+  TEST(m.emplace(1, "a").second, ());
+  TEST(!m.emplace(1, "b").second, ());
+  TEST_EQUAL(m.find(1)->second, "a", ());
+  m[2] = "b";
+  TEST_EQUAL(m.size(), 2, ());
+  TEST_EQUAL(m.count(2), 1, ());
+  TEST_EQUAL(m.count(3), 0, ());
+
+  TEST_EQUAL(m.erase(1), 1, ());
+  TEST_EQUAL(m.erase(1), 0, ());
+  TEST(m.find(1) == m.end(), ());
+  TEST_EQUAL(m.find(2)->second, "b", ());
+
+  vector<pair<uint64_t, string>> entries(m.begin(), m.end());
+  TEST_EQUAL(entries, (vector<pair<uint64_t, string>>{{2, "b"}}), ());
+}
+
+UNIT_TEST(FlatHashMap_GeoObjectId)
+{
+  FlatHashMap<GeoObjectId, unique_ptr<int>> m;
+  for (int i = 0; i < 1000; ++i)
+  {
+    m.emplace(MakeOsmNode(i), make_unique<int>(i));
+    m.emplace(MakeOsmWay(i), make_unique<int>(-i));
+  }
+
+  TEST_EQUAL(m.size(), 2000, ());
+  for (int i = 0; i < 1000; ++i)
+  {
+    TEST_EQUAL(*m.find(MakeOsmNode(i))->second, i, ());
+    TEST_EQUAL(*m.find(MakeOsmWay(i))->second, -i, ());
+  }
+  TEST(m.find(MakeOsmRelation(1)) == m.end(), ());
+}
+
+UNIT_TEST(FlatHashMap_Random)
+{
+  mt19937 rng(0);
+  uniform_int_distribution<uint64_t> keys(0, 5000);
+  FlatHashMap<uint64_t, uint64_t> m;
+  unordered_map<uint64_t, uint64_t> expected;
+  for (size_t i = 0; i < 100000; ++i)
+  {
+    auto const key = keys(rng);
+    if (i % 3 == 0)
+    {
+      TEST_EQUAL(m.erase(key), expected.erase(key), (key));
+    }
+    else
+    {
+      m[key] += i;
+      expected[key] += i;
+    }
+  }
+
+  TEST_EQUAL(m.size(), expected.size(), ());
+  for (auto const & kv : expected)
+  {
+    auto const it = m.find(kv.first);
+    TEST(it != m.end(), (kv.first));
+    TEST_EQUAL(it->second, kv.second, (kv.first));
+  }
+
+  size_t count = 0;
+  for (auto const & kv : m)
+  {
+    TEST_EQUAL(expected.at(kv.first), kv.second, ());
+    ++count;
+  }
+  TEST_EQUAL(count, expected.size(), ());
+}
+
+UNIT_TEST(FlatHashSet_Smoke)
+{
+  FlatHashSet<string> s;
+  TEST(s.insert("a").second, ());
+  TEST(s.insert("b").second, ());
+  TEST(!s.insert("a").second, ());
+  TEST_EQUAL(s.size(), 2, ());
+  TEST_EQUAL(s.count("a"), 1, ());
+  TEST(s.find("c") == s.end(), ());
+
+  vector<string> keys(s.begin(), s.end());
+  sort(keys.begin(), keys.end());
+  TEST_EQUAL(keys, (vector<string>{"a", "b"}), ());
+
+  TEST_EQUAL(s.erase("a"), 1, ());
+  TEST_EQUAL(s.count("a"), 0, ());
+}
@@ -38,7 +38,8 @@ struct Result
   size_t m_prefixErrorsMade = 0;
 };
 
-Result GetResult(LevenshteinDFA const & dfa, std::string const & s)
+template <typename DFA>
+Result GetResult(DFA const & dfa, std::string const & s)
 {
   auto it = dfa.Begin();
   DFAMove(it, s);
@@ -49,17 +50,20 @@ Result GetResult(LevenshteinDFA const & dfa, std::string const & s)
   return Result(Status::Intermediate, it.ErrorsMade(), it.PrefixErrorsMade());
 }
 
-bool Accepts(LevenshteinDFA const & dfa, std::string const & s)
+template <typename DFA>
+bool Accepts(DFA const & dfa, std::string const & s)
 {
   return GetResult(dfa, s).m_status == Status::Accepts;
 }
 
-bool Rejects(LevenshteinDFA const & dfa, std::string const & s)
+template <typename DFA>
+bool Rejects(DFA const & dfa, std::string const & s)
 {
   return GetResult(dfa, s).m_status == Status::Rejects;
 }
 
-bool Intermediate(LevenshteinDFA const & dfa, std::string const & s)
+template <typename DFA>
+bool Intermediate(DFA const & dfa, std::string const & s)
 {
   return GetResult(dfa, s).m_status == Status::Intermediate;
 }
@@ -276,4 +280,99 @@ UNIT_TEST(LevenshteinDFA_PrefixDFASmoke)
     }
   }
 }
+
+UNIT_TEST(UniversalLevenshteinDFA_Smoke)
+{
+  {
+    UniversalLevenshteinDFA dfa("abc", 1 /* maxErrors */);
+    TEST(Accepts(dfa, "abc"), ());
+    TEST(Accepts(dfa, "ab"), ());
+    TEST(Accepts(dfa, "abcd"), ());
+    TEST(Accepts(dfa, "bac"), ());
+    TEST(Intermediate(dfa, "a"), ());
+    TEST(Rejects(dfa, "abcde"), ());
+    TEST(Rejects(dfa, "cba"), ());
+  }
+
+  {
+    UniversalLevenshteinDFA dfa("ленинградский", 2 /* maxErrors */);
+    TEST(Accepts(dfa, "ленинградский"), ());
+    TEST(Accepts(dfa, "ленингадский"), ());
+    TEST(Accepts(dfa, "ленигнрадский"), ());
+    TEST(Rejects(dfa, "ленинский"), ());
+  }
+
+  {
+    vector<UniString> const allowedMisprints = {MakeUniString("yj")};
+    string const str = "yekaterinburg";
+    vector<pair<string, Result>> const queries = {
+        {"jekaterinburg", Result(Status::Accepts, 1 /* errorsMade */, 1 /* prefixErrorsMade */)},
+        {"ekaterinburg", Result(Status::Accepts, 1 /* errorsMade */, 1 /* prefixErrorsMade */)},
+        {"iekaterinburg", Result(Status::Rejects)}};
+
+    for (auto const & q : queries)
+    {
+      UniversalLevenshteinDFA dfa(MakeUniString(q.first), 1 /* prefixSize */, allowedMisprints,
+                                  1 /* maxErrors */);
+      TEST_EQUAL(GetResult(dfa, str), q.second, ("Query:", q.first, "string:", str));
+    }
+  }
+
+  // The starting and the rejecting states only are needed for the exact matching.
+  TEST_EQUAL(UniversalLevenshteinDFA::GetNumStates(0 /* maxErrors */), 2, ());
+  TEST_GREATER(UniversalLevenshteinDFA::GetNumStates(2 /* maxErrors */),
+               UniversalLevenshteinDFA::GetNumStates(1 /* maxErrors */), ());
+}
+
+// The universal automaton moves through the same states as LevenshteinDFA does.
+UNIT_TEST(UniversalLevenshteinDFA_SameAsLevenshteinDFA)
+{
+  vector<UniString> const allowedMisprints = {MakeUniString("ab")};
+  auto const generate = [](size_t size, vector<string> & result) {
+    result.assign(1, string());
+    for (size_t i = 0; i < size; ++i)
+    {
+      auto const count = result.size();
+      for (size_t j = 0; j < count; ++j)
+      {
+        if (result[j].size() != i)
+          continue;
+        for (char const c : {'a', 'b', 'c'})
+          result.push_back(result[j] + c);
+      }
+    }
+  };
+
+  vector<string> sources;
+  vector<string> queries;
+  generate(5 /* size */, sources);
+  generate(6 /* size */, queries);
+  for (auto const & source : sources)
+  {
+    auto const s = MakeUniString(source);
+    for (size_t maxErrors = 0; maxErrors <= UniversalLevenshteinDFA::kMaxErrors; ++maxErrors)
+    {
+      for (size_t prefixSize = 0; prefixSize <= min(s.size(), size_t{1}); ++prefixSize)
+      {
+        LevenshteinDFA const dfa(s, prefixSize, allowedMisprints, maxErrors);
+        UniversalLevenshteinDFA const universal(s, prefixSize, allowedMisprints, maxErrors);
+        for (auto const & query : queries)
+        {
+          auto it = dfa.Begin();
+          auto universalIt = universal.Begin();
+          for (auto const c : query)
+          {
+            it.Move(c);
+            universalIt.Move(c);
+            TEST_EQUAL(it.Accepts(), universalIt.Accepts(), (source, query, maxErrors));
+            TEST_EQUAL(it.Rejects(), universalIt.Rejects(), (source, query, maxErrors));
+            TEST_EQUAL(it.ErrorsMade(), universalIt.ErrorsMade(), (source, query, maxErrors));
+            TEST_EQUAL(it.PrefixErrorsMade(), universalIt.PrefixErrorsMade(),
+                       (source, query, maxErrors));
+          }
+        }
+      }
+    }
+  }
+}
 }  // namespace
@@ -1,5 +1,6 @@
 #include "testing/testing.hpp"
 
+#include "base/frozen_mem_trie.hpp"
 #include "base/mem_trie.hpp"
 
 #include <algorithm>
@@ -16,6 +17,7 @@ namespace
 using Key = string;
 using Value = int;
 using Trie = MemTrie<Key, VectorValues<Value>>;
+using FrozenTrie = FrozenMemTrie<Key, Value>;
 using Data = vector<pair<Key, Value>>;
 
 Data GetTrieContents(Trie const & trie)
@@ -188,4 +190,66 @@ UNIT_CLASS_TEST(MemTrieTest, ForEachInSubtree)
   TEST_EQUAL(GetContentsByPrefix("abra"), all, ());
   TEST_EQUAL(GetContentsByPrefix("abrau"), Data({{"abrau", 3}}), ());
 }
+
+UNIT_CLASS_TEST(MemTrieTest, Frozen)
+{
+  Add("abracadabra", 0);
+  Add("abra", 1);
+  Add("abra", 2);
+  Add("abrau", 3);
+  Add("arbuz", 4);
+  Add("", 5);
+  Add("b", 6);
+
+  FrozenTrie const frozen(m_trie);
+  TEST_EQUAL(frozen.GetNumNodes(), m_trie.GetNumNodes(), ());
+
+  auto const getContents = [&](Key const & prefix) {
+    Data data;
+    frozen.ForEachInSubtree(prefix,
+                            [&data](Key const & k, Value const & v) { data.emplace_back(k, v); });
+    sort(data.begin(), data.end());
+    return data;
+  };
+
+  Data all;
+  frozen.ForEachInTrie([&all](Key const & k, Value const & v) { all.emplace_back(k, v); });
+  sort(all.begin(), all.end());
+  TEST_EQUAL(all, GetActualContents(), ());
+
+  for (Key const key : {"", "a", "ab", "abra", "abrac", "abracadabr", "abracadabra",
+                        "abracadabraa", "abrau", "ar", "arbuz", "b", "ba", "void"})
+  {
+    vector<Value> values;
+    frozen.ForEachInNode(key, [&values](Value const & value) { values.push_back(value); });
+    sort(values.begin(), values.end());
+
+    TEST_EQUAL(values, GetValuesByKey(key), (key));
+    TEST_EQUAL(getContents(key), GetContentsByPrefix(key), (key));
+    TEST_EQUAL(frozen.HasKey(key), HasKey(key), (key));
+    TEST_EQUAL(frozen.HasPrefix(key), HasPrefix(key), (key));
+  }
+
+  // The moves of a node are visited in the order of the chars.
+  string moves;
+  frozen.GetRootIterator().ForEachMove(
+      [&moves](char c, FrozenTrie::Iterator const & /* it */) { moves.push_back(c); });
+  TEST_EQUAL(moves, "ab", ());
+}
+
+UNIT_TEST(FrozenMemTrie_Empty)
+{
+  FrozenTrie const frozen;
+  TEST_EQUAL(frozen.GetNumNodes(), 1, ());
+  TEST(!frozen.HasKey(""), ());
+  TEST(!frozen.HasPrefix(""), ());
+  TEST(!frozen.HasPrefix("a"), ());
+
+  size_t count = 0;
+  frozen.ForEachInTrie([&count](Key const & /* k */, Value const & /* v */) { ++count; });
+  TEST_EQUAL(count, 0, ());
+
+  Trie const trie;
+  TEST_EQUAL(FrozenTrie(trie).GetNumNodes(), 1, ());
+}
 }  // namespace
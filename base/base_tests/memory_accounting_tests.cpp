@@ -0,0 +1,97 @@
+#include "testing/testing.hpp"
+
+#include "base/arena.hpp"
+#include "base/memory_accounting.hpp"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace base::memory;
+
+UNIT_TEST(MemoryAccounting_ScopedBytes)
+{
+  auto & tag = GetTag("memory_accounting_test_scoped_bytes");
+  TEST_EQUAL(&tag, &GetTag("memory_accounting_test_scoped_bytes"), ());
+  TEST_EQUAL(tag.GetBytes(), 0, ());
+  {
+    ScopedBytes bytes(tag, 100);
+    TEST_EQUAL(tag.GetBytes(), 100, ());
+
+    bytes.Set(300);
+    bytes.Set(200);
+    TEST_EQUAL(tag.GetBytes(), 200, ());
+    TEST_EQUAL(tag.GetPeakBytes(), 300, ());
+
+    // A copy counts the bytes once more, a move does not.
+    auto copy = bytes;
+    TEST_EQUAL(tag.GetBytes(), 400, ());
+    auto moved = std::move(copy);
+    TEST_EQUAL(tag.GetBytes(), 400, ());
+    moved.Set(50);
+    TEST_EQUAL(tag.GetBytes(), 250, ());
+
+    // Nothing is counted without a tag.
+    ScopedBytes untagged;
+    untagged.Set(1000);
+    TEST_EQUAL(tag.GetBytes(), 250, ());
+  }
+  TEST_EQUAL(tag.GetBytes(), 0, ());
+  TEST_EQUAL(tag.GetPeakBytes(), 400, ());
+
+  bool found = false;
+  for (auto const & usage : GetUsage())
+  {
+    if (usage.m_name == tag.GetName())
+    {
+      found = true;
+      TEST_EQUAL(usage.m_peakBytes, 400, ());
+    }
+  }
+  TEST(found, ());
+}
+
+UNIT_TEST(MemoryAccounting_TaggedAllocator)
+{
+  auto & tag = GetTag("memory_accounting_test_allocator");
+  {
+    std::vector<int, TaggedAllocator<int>> values{TaggedAllocator<int>(tag)};
+    values.reserve(100);
+    TEST_EQUAL(tag.GetBytes(), 100 * sizeof(int), ());
+  }
+  TEST_EQUAL(tag.GetBytes(), 0, ());
+}
+
+UNIT_TEST(MemoryAccounting_Threads)
+{
+  auto & tag = GetTag("memory_accounting_test_threads");
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&tag]() {
+      for (size_t j = 0; j < 1000; ++j)
+        ScopedBytes bytes(tag, j);
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+  TEST_EQUAL(tag.GetBytes(), 0, ());
+  TEST_GREATER_OR_EQUAL(tag.GetPeakBytes(), 999, ());
+}
+
+UNIT_TEST(MemoryAccounting_Arena)
+{
+  auto & tag = GetTag("memory_accounting_test_arena");
+  {
+    base::Arena arena(1024 /* chunkSize */, &tag);
+    arena.Allocate(100);
+    TEST_EQUAL(tag.GetBytes(), 1024, ());
+    arena.Allocate(10000);
+    TEST_GREATER_OR_EQUAL(tag.GetBytes(), 1024 + 10000, ());
+
+    // The chunks of the default size are kept by Reset().
+    arena.Reset();
+    TEST_EQUAL(tag.GetBytes(), 1024, ());
+  }
+  TEST_EQUAL(tag.GetBytes(), 0, ());
+}
@@ -0,0 +1,110 @@
+#include "testing/testing.hpp"
+
+#include "base/prof.hpp"
+#include "base/scope_guard.hpp"
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base::prof;
+
+namespace
+{
+ZoneStats GetZoneStats(std::string const & name)
+{
+  for (auto const & stats : GetZonesStats())
+  {
+    if (stats.m_name == name)
+      return stats;
+  }
+  return {};
+}
+}  // namespace
+
+UNIT_TEST(Prof_Disabled)
+{
+  Reset();
+  SetEnabled(false);
+  {
+    PROF_ZONE("disabled zone");
+    PROF_COUNTER_ADD("disabled counter", 10);
+  }
+  TEST_EQUAL(GetZoneStats("disabled zone").m_count, 0, ());
+  TEST(DumpJson().find("\"disabled counter\": 0") != std::string::npos, ());
+}
+
+UNIT_TEST(Prof_Zones)
+{
+  Reset();
+  SetEnabled(true);
+  SCOPE_GUARD(disable, [] { SetEnabled(false); });
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([] {
+      for (size_t i = 0; i < 100; ++i)
+      {
+        PROF_ZONE("outer");
+        PROF_ZONE(std::string("inner ") + std::to_string(i % 2));
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  TEST_EQUAL(GetZoneStats("outer").m_count, 400, ());
+  TEST_EQUAL(GetZoneStats("inner 0").m_count, 200, ());
+  TEST_EQUAL(GetZoneStats("inner 1").m_count, 200, ());
+  TEST_GREATER_OR_EQUAL(GetZoneStats("outer").m_totalSeconds,
+                        GetZoneStats("outer").m_maxSeconds, ());
+
+  auto const trace = DumpChromeTrace();
+  TEST(trace.find("\"name\": \"outer\", \"ph\": \"X\"") != std::string::npos, ());
+  TEST(trace.find("\"name\": \"inner 1\"") != std::string::npos, ());
+  TEST_EQUAL(GetDroppedZonesCount(), 0, ());
+
+  Reset();
+  TEST_EQUAL(GetZoneStats("outer").m_count, 0, ());
+}
+
+UNIT_TEST(Prof_CountersAndHistograms)
+{
+  Reset();
+  SetEnabled(true);
+  SCOPE_GUARD(disable, [] { SetEnabled(false); });
+
+  static Counter counter("test \"counter\"");
+  static Histogram histogram("test histogram");
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([] {
+      for (uint64_t i = 0; i < 1000; ++i)
+      {
+        counter.Add(2);
+        histogram.Add(i);
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  TEST_EQUAL(counter.Get(), 8000, ());
+  TEST_EQUAL(histogram.GetCount(), 4000, ());
+  TEST_EQUAL(histogram.GetSum(), 4 * 999 * 1000 / 2, ());
+
+  auto const buckets = histogram.GetBuckets();
+  TEST_EQUAL(buckets[0], 4, ());
+  TEST_EQUAL(buckets[1], 4, ());
+  TEST_EQUAL(buckets[2], 4 * 2, ());
+  TEST_EQUAL(buckets[10], 4 * (1000 - 512), ());
+  TEST_EQUAL(Histogram::GetBucket(1023), 10, ());
+  TEST_EQUAL(Histogram::GetBucket(1024), 11, ());
+
+  auto const json = DumpJson();
+  TEST(json.find("\"test \\\"counter\\\"\": 8000") != std::string::npos, (json));
+  TEST(json.find("\"test histogram\": {\"count\": 4000") != std::string::npos, (json));
+}
@@ -0,0 +1,56 @@
+#include "testing/testing.hpp"
+
+#include "base/string_interner.hpp"
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+UNIT_TEST(StringInterner_Smoke)
+{
+  StringInterner interner;
+  TEST_EQUAL(interner.Find("highway"), StringInterner::kInvalidId, ());
+
+  auto const highway = interner.Intern("highway");
+  auto const building = interner.Intern("building");
+  TEST_EQUAL(highway, 0, ());
+  TEST_EQUAL(building, 1, ());
+  TEST_EQUAL(interner.Intern("highway"), highway, ());
+  TEST_EQUAL(interner.Find("building"), building, ());
+  TEST_EQUAL(interner.Get(highway), "highway", ());
+  TEST_EQUAL(interner.Size(), 2, ());
+
+  auto const copy = interner;
+  TEST_EQUAL(copy.Find("highway"), highway, ());
+  TEST_EQUAL(copy.Get(building), "building", ());
+  TEST_NOT_EQUAL(&copy.Get(building), &interner.Get(building), ());
+}
+
+UNIT_TEST(StringInterner_Threads)
+{
+  size_t const kThreadsCount = 4;
+  size_t const kStringsCount = 1000;
+  StringInterner interner;
+  std::vector<std::vector<StringInterner::Id>> ids(kThreadsCount);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadsCount; ++i)
+  {
+    threads.emplace_back([&interner, &ids, i] {
+      for (size_t j = 0; j < kStringsCount; ++j)
+        ids[i].push_back(interner.Intern(std::to_string(j)));
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  TEST_EQUAL(interner.Size(), kStringsCount, ());
+  for (size_t i = 0; i < kThreadsCount; ++i)
+  {
+    TEST_EQUAL(ids[i], ids[0], ());
+    for (size_t j = 0; j < kStringsCount; ++j)
+      TEST_EQUAL(interner.Get(ids[i][j]), std::to_string(j), ());
+  }
+}
@@ -0,0 +1,79 @@
+#include "testing/testing.hpp"
+
+#include "base/thread_affinity.hpp"
+#include "base/thread_pool_computational.hpp"
+#include "base/thread_pool_work_stealing.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base::threads;
+
+UNIT_TEST(ThreadAffinity_FromString)
+{
+  for (auto const affinity :
+       {ThreadsAffinity::None, ThreadsAffinity::Cores, ThreadsAffinity::Nodes})
+  {
+    ThreadsAffinity parsed = ThreadsAffinity::None;
+    TEST(FromString(DebugPrint(affinity), parsed), (affinity));
+    TEST_EQUAL(parsed, affinity, ());
+  }
+
+  ThreadsAffinity parsed;
+  TEST(!FromString("numa", parsed), ());
+}
+
+UNIT_TEST(ThreadAffinity_ParseCpuList)
+{
+  TEST_EQUAL(ParseCpuList("0"), std::vector<size_t>({0}), ());
+  TEST_EQUAL(ParseCpuList("0-3,8,10-11\n"), std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}), ());
+  TEST(ParseCpuList("").empty(), ());
+  TEST(ParseCpuList("3-1").empty(), ());
+  TEST(ParseCpuList("0,a").empty(), ());
+}
+
+UNIT_TEST(ThreadAffinity_SetCurrentThreadAffinity)
+{
+  TEST(!SetCurrentThreadAffinity(ThreadsAffinity::None, 0), ());
+
+  auto const nodes = GetNumaNodesCpus();
+  for (auto const & node : nodes)
+    TEST(!node.empty(), ());
+
+  // The binding of a thread does not leak to the others, so it is checked on the new threads.
+  for (auto const affinity : {ThreadsAffinity::Cores, ThreadsAffinity::Nodes})
+  {
+    for (size_t i = 0; i < 3; ++i)
+    {
+      bool bound = false;
+      std::thread thread([&bound, affinity, i] { bound = SetCurrentThreadAffinity(affinity, i); });
+      thread.join();
+#if defined(__linux__)
+      TEST_EQUAL(bound, !nodes.empty(), (affinity, i));
+#else
+      TEST(!bound, (affinity, i));
+#endif
+    }
+  }
+}
+
+UNIT_TEST(ThreadAffinity_BoundPools)
+{
+  for (auto const affinity : {ThreadsAffinity::Cores, ThreadsAffinity::Nodes})
+  {
+    std::atomic<size_t> counter{0};
+    {
+      base::thread_pool::computational::ThreadPool computational(3, affinity);
+      base::thread_pool::work_stealing::ThreadPool workStealing(3, affinity);
+      for (size_t i = 0; i < 100; ++i)
+      {
+        computational.SubmitWork([&counter] { ++counter; });
+        workStealing.SubmitWork([&counter] { ++counter; });
+      }
+    }
+    TEST_EQUAL(counter, 200, (affinity));
+  }
+}
@@ -0,0 +1,121 @@
+#include "testing/testing.hpp"
+
+#include "base/thread_pool_work_stealing.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using base::thread_pool::work_stealing::TaskGroup;
+using base::thread_pool::work_stealing::ThreadPool;
+
+namespace
+{
+size_t const kTimes = 100;
+}  // namespace
+
+UNIT_TEST(ThreadPoolWorkStealing_SubmitWork)
+{
+  for (size_t t = 0; t < kTimes; ++t)
+  {
+    size_t const taskCount = 1000;
+    std::atomic<size_t> counter{0};
+    {
+      ThreadPool threadPool(4);
+      for (size_t i = 0; i < taskCount; ++i)
+        threadPool.SubmitWork([&counter]() { ++counter; });
+    }
+
+    TEST_EQUAL(counter, taskCount, ());
+  }
+}
+
+UNIT_TEST(ThreadPoolWorkStealing_ReturnValue)
+{
+  size_t const threadCount = 4;
+  ThreadPool threadPool(threadCount);
+  std::vector<std::future<size_t>> futures;
+  for (size_t i = 0; i < 100; ++i)
+    futures.push_back(threadPool.Submit([](size_t i) { return i * i; }, i));
+
+  for (size_t i = 0; i < futures.size(); ++i)
+    TEST_EQUAL(futures[i].get(), i * i, ());
+}
+
+UNIT_TEST(ThreadPoolWorkStealing_ParallelFor)
+{
+  ThreadPool threadPool(4);
+  for (size_t grain : {1, 7, 1000})
+  {
+    std::vector<std::atomic<size_t>> visits(1003);
+    threadPool.ParallelFor(0, visits.size(), grain, [&visits](size_t i) { ++visits[i]; });
+    for (auto const & v : visits)
+      TEST_EQUAL(v, 1, (grain));
+  }
+
+  // An empty range.
+  threadPool.ParallelFor(5, 5, 1, [](size_t) { TEST(false, ()); });
+}
+
+UNIT_TEST(ThreadPoolWorkStealing_NestedTaskGroups)
+{
+  // The tasks wait for the nested tasks, so the pool would deadlock if the waiting workers
+  // did not run the pending tasks.
+  ThreadPool threadPool(2);
+  std::atomic<size_t> counter{0};
+  TaskGroup group(threadPool);
+  for (size_t i = 0; i < 16; ++i)
+  {
+    group.Run([&threadPool, &counter]() {
+      threadPool.ParallelFor(0, 100, 3, [&counter](size_t) { ++counter; });
+    });
+  }
+  group.Wait();
+  TEST_EQUAL(counter, 1600, ());
+}
+
+UNIT_TEST(ThreadPoolWorkStealing_TaskGroupException)
+{
+  ThreadPool threadPool(3);
+  TaskGroup group(threadPool);
+  std::atomic<size_t> counter{0};
+  for (size_t i = 0; i < 10; ++i)
+  {
+    group.Run([i, &counter]() {
+      ++counter;
+      if (i == 5)
+        throw std::runtime_error("Task failed");
+    });
+  }
+
+  bool thrown = false;
+  try
+  {
+    group.Wait();
+  }
+  catch (std::runtime_error const &)
+  {
+    thrown = true;
+  }
+  TEST(thrown, ());
+  TEST_EQUAL(counter, 10, ());
+}
+
+UNIT_TEST(ThreadPoolWorkStealing_Stop)
+{
+  ThreadPool threadPool(2);
+  threadPool.Stop();
+
+  // The stopped pool ignores the tasks, the task group runs them in place.
+  auto future = threadPool.Submit([]() { return 1; });
+  TEST(!future.valid(), ());
+
+  size_t counter = 0;
+  TaskGroup group(threadPool);
+  group.Run([&counter]() { ++counter; });
+  group.Wait();
+  TEST_EQUAL(counter, 1, ());
+}
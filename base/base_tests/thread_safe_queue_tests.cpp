@@ -3,6 +3,7 @@
 #include "base/thread_pool_delayed.hpp"
 #include "base/thread_safe_queue.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <set>
@@ -121,3 +122,37 @@ UNIT_TEST(ThreadSafeQueue_ExampleWithDataWrapper)
 
   thread.join();
 }
+
+UNIT_TEST(ThreadSafeQueue_Bounded)
+{
+  size_t const kMaxSize = 3;
+  size_t const kSize = 1000;
+  base::threads::ThreadSafeQueue<size_t> queue(kMaxSize);
+  TEST_EQUAL(queue.GetMaxSize(), kMaxSize, ());
+
+  std::atomic<size_t> pushed{0};
+  auto thread = std::thread([&]() {
+    for (size_t i = 0; i < kSize; ++i)
+    {
+      queue.Push(i);
+      ++pushed;
+    }
+  });
+
+  // The producer waits for the consumer when the queue is full.
+  while (queue.Size() != kMaxSize)
+    std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  TEST_EQUAL(pushed, kMaxSize, ());
+
+  for (size_t i = 0; i < kSize; ++i)
+  {
+    size_t value = 0;
+    queue.WaitAndPop(value);
+    TEST_EQUAL(value, i, ());
+    TEST_LESS_OR_EQUAL(queue.Size(), kMaxSize, ());
+  }
+
+  thread.join();
+  TEST(queue.Empty(), ());
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/assert.hpp"
 #include "base/geo_object_id.hpp"
 #include "base/macros.hpp"
 
@@ -71,6 +72,17 @@ public:
   // The order of returned entries is not specified.
   std::vector<Entry> const & GetEntries() const { return m_entries; }
 
+  // Removes all entries, the reserved memory is kept.
+  void Clear() { m_entries.clear(); }
+
+  // When the beam is full, the pairs with the values less than GetLowestValue() are not added.
+  bool IsFull() const { return m_entries.size() >= m_capacity; }
+  Value const & GetLowestValue() const
+  {
+    ASSERT(!m_entries.empty(), ());
+    return m_entries.back().m_value;
+  }
+
 private:
   size_t m_capacity;
   std::vector<Entry> m_entries;
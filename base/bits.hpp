@@ -5,6 +5,10 @@
 #include <limits>
 #include <type_traits>
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 namespace bits
 {
   // Count the number of 1 bits. Implementation: see Hacker's delight book.
@@ -124,7 +128,7 @@ namespace bits
     return (x >> 1) ^ -static_cast<std::make_signed_t<T>>(x & 1);
   }
 
-  inline uint32_t PerfectShuffle(uint32_t x)
+  constexpr uint32_t PerfectShuffle(uint32_t x)
   {
     x = ((x & 0x0000FF00) << 8) | ((x >> 8) & 0x0000FF00) | (x & 0xFF0000FF);
     x = ((x & 0x00F000F0) << 4) | ((x >> 4) & 0x00F000F0) | (x & 0xF00FF00F);
@@ -133,7 +137,7 @@ namespace bits
     return x;
   }
 
-  inline uint32_t PerfectUnshuffle(uint32_t x)
+  constexpr uint32_t PerfectUnshuffle(uint32_t x)
   {
     x = ((x & 0x22222222) << 1) | ((x >> 1) & 0x22222222) | (x & 0x99999999);
     x = ((x & 0x0C0C0C0C) << 2) | ((x >> 2) & 0x0C0C0C0C) | (x & 0xC3C3C3C3);
@@ -148,19 +152,29 @@ namespace bits
   // That is, if the bits of |x| are {x31, x30, ..., x0},
   //         and the bits of |y| are {y31, y30, ..., y0},
   // then the bits of the result are {y31, x31, y30, x30, ..., y0, x0}.
+  // With BMI2 the bits are deposited by pdep, otherwise they are shuffled by the magic masks.
   inline uint64_t BitwiseMerge(uint32_t x, uint32_t y)
   {
+#if defined(__BMI2__)
+    return _pdep_u64(x, 0x5555555555555555ULL) | _pdep_u64(y, 0xAAAAAAAAAAAAAAAAULL);
+#else
     uint32_t const hi = PerfectShuffle((y & 0xFFFF0000) | (x >> 16));
     uint32_t const lo = PerfectShuffle(((y & 0xFFFF) << 16 ) | (x & 0xFFFF));
     return (static_cast<uint64_t>(hi) << 32) + lo;
+#endif
   }
 
   inline void BitwiseSplit(uint64_t v, uint32_t & x, uint32_t & y)
   {
+#if defined(__BMI2__)
+    x = static_cast<uint32_t>(_pext_u64(v, 0x5555555555555555ULL));
+    y = static_cast<uint32_t>(_pext_u64(v, 0xAAAAAAAAAAAAAAAAULL));
+#else
     uint32_t const hi = bits::PerfectUnshuffle(static_cast<uint32_t>(v >> 32));
     uint32_t const lo = bits::PerfectUnshuffle(static_cast<uint32_t>(v & 0xFFFFFFFFULL));
     x = ((hi & 0xFFFF) << 16) | (lo & 0xFFFF);
     y =     (hi & 0xFFFF0000) | (lo >> 16);
+#endif
   }
 
   // Returns 1 if bit is set and 0 otherwise.
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "base/assert.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+namespace threads
+{
+// The wait policies of BoundedMpmcQueue: how a thread waits for a free cell to push to
+// or for a value to pop.
+
+// Spins for a while, then yields and then sleeps for the growing periods.
+// Costs nothing on the fast path and fits the queues which are rarely full or empty.
+class BackoffWait
+{
+public:
+  template <typename Ready>
+  void Wait(Ready && ready)
+  {
+    for (uint32_t i = 0; !ready(); ++i)
+    {
+      if (i < kSpinsCount)
+        continue;
+
+      if (i < kSpinsCount + kYieldsCount)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      uint32_t const shift = i - kSpinsCount - kYieldsCount;
+      uint32_t const sleepShift = shift < kMaxSleepShift ? shift : kMaxSleepShift;
+      std::this_thread::sleep_for(std::chrono::microseconds(1u << sleepShift));
+    }
+  }
+
+  void Notify() {}
+
+private:
+  static uint32_t constexpr kSpinsCount = 64;
+  static uint32_t constexpr kYieldsCount = 16;
+  // The longest sleep is 1024 microseconds.
+  static uint32_t constexpr kMaxSleepShift = 10;
+};
+
+// Spins for a while and then blocks on a condition variable.
+// Notify() takes the lock only when there are blocked threads.
+// Fits the queues where a side may wait for a long time.
+class BlockingWait
+{
+public:
+  template <typename Ready>
+  void Wait(Ready && ready)
+  {
+    for (uint32_t i = 0; i < kSpinsCount; ++i)
+    {
+      if (ready())
+        return;
+    }
+
+    while (true)
+    {
+      // |ready| is called without the lock: it pushes or pops and notifies the other side.
+      auto const generation = m_generation.load();
+      if (ready())
+        return;
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      ++m_waiters;
+      // A notification after the check of |ready| changes the generation, so the waiter
+      // either sees the new generation or is counted by the notifier.
+      m_cond.wait(lock, [&] { return m_generation.load() != generation; });
+      --m_waiters;
+    }
+  }
+
+  void Notify()
+  {
+    ++m_generation;
+    if (m_waiters.load() == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cond.notify_all();
+  }
+
+private:
+  static uint32_t constexpr kSpinsCount = 64;
+
+  std::atomic<uint64_t> m_generation{0};
+  std::atomic<uint32_t> m_waiters{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+};
+
+// A bounded lock-free multi-producer multi-consumer queue over a ring buffer
+// (D. Vyukov's algorithm). Every cell has a sequence number which tells whether the cell
+// is free for the producer or holds a value for the consumer at the position, so the producers
+// and the consumers synchronize by a single CAS on the position per value or per batch.
+// The capacity is rounded up to a power of two. Unlike ThreadSafeQueue the blocking calls
+// wait according to |WaitPolicy| and never wait on a shared lock on the fast path.
+// T must be default constructible and move assignable.
+template <typename T, typename WaitPolicy = BackoffWait>
+class BoundedMpmcQueue
+{
+public:
+  explicit BoundedMpmcQueue(size_t capacity)
+  {
+    CHECK_GREATER(capacity, 0, ());
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+
+    m_mask = size - 1;
+    m_cells = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i)
+      m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+  }
+
+  BoundedMpmcQueue(BoundedMpmcQueue const &) = delete;
+  BoundedMpmcQueue & operator=(BoundedMpmcQueue const &) = delete;
+
+  // Returns false if the queue is full.
+  bool TryPush(T && value)
+  {
+    size_t pos;
+    if (ClaimPushPositions(1 /* maxCount */, pos) == 0)
+      return false;
+
+    Cell & cell = GetCell(pos);
+    cell.m_data = std::move(value);
+    cell.m_sequence.store(pos + 1, std::memory_order_release);
+    m_notEmpty.Notify();
+    return true;
+  }
+
+  bool TryPush(T const & value)
+  {
+    T copy(value);
+    return TryPush(std::move(copy));
+  }
+
+  // Returns false if the queue is empty.
+  bool TryPop(T & value)
+  {
+    size_t pos;
+    if (ClaimPopPositions(1 /* maxCount */, pos) == 0)
+      return false;
+
+    Cell & cell = GetCell(pos);
+    value = std::move(cell.m_data);
+    cell.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+    m_notFull.Notify();
+    return true;
+  }
+
+  // Moves the values from [first, last) to the queue while there are free cells.
+  // The free cells are claimed by a single CAS. Returns the iterator past the pushed values.
+  template <typename It>
+  It TryPushBatch(It first, It last)
+  {
+    size_t pos;
+    size_t const count =
+        ClaimPushPositions(static_cast<size_t>(std::distance(first, last)), pos);
+    for (size_t i = 0; i < count; ++i, ++first)
+    {
+      Cell & cell = GetCell(pos + i);
+      cell.m_data = std::move(*first);
+      cell.m_sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    if (count != 0)
+      m_notEmpty.Notify();
+    return first;
+  }
+
+  // Appends at most |maxCount| values to |values|. The values are claimed by a single CAS.
+  // Returns the number of the popped values.
+  size_t TryPopBatch(std::vector<T> & values, size_t maxCount)
+  {
+    size_t pos;
+    size_t const count = ClaimPopPositions(maxCount, pos);
+    for (size_t i = 0; i < count; ++i)
+    {
+      Cell & cell = GetCell(pos + i);
+      values.push_back(std::move(cell.m_data));
+      cell.m_sequence.store(pos + i + 1 + m_mask, std::memory_order_release);
+    }
+
+    if (count != 0)
+      m_notFull.Notify();
+    return count;
+  }
+
+  // Waits for a free cell.
+  void Push(T && value)
+  {
+    if (TryPush(std::move(value)))
+      return;
+
+    m_notFull.Wait([&] { return TryPush(std::move(value)); });
+  }
+
+  void Push(T const & value)
+  {
+    T copy(value);
+    Push(std::move(copy));
+  }
+
+  // Waits until all the values from [first, last) are pushed.
+  template <typename It>
+  void PushBatch(It first, It last)
+  {
+    first = TryPushBatch(first, last);
+    if (first == last)
+      return;
+
+    m_notFull.Wait([&] {
+      first = TryPushBatch(first, last);
+      return first == last;
+    });
+  }
+
+  // Waits for a value.
+  void WaitAndPop(T & value)
+  {
+    if (TryPop(value))
+      return;
+
+    m_notEmpty.Wait([&] { return TryPop(value); });
+  }
+
+  // Waits for at least one value and appends at most |maxCount| values to |values|.
+  size_t WaitAndPopBatch(std::vector<T> & values, size_t maxCount)
+  {
+    CHECK_GREATER(maxCount, 0, ());
+    size_t count = TryPopBatch(values, maxCount);
+    if (count != 0)
+      return count;
+
+    m_notEmpty.Wait([&] {
+      count = TryPopBatch(values, maxCount);
+      return count != 0;
+    });
+    return count;
+  }
+
+  // The size and the emptiness are approximate when the queue is used concurrently.
+  size_t Size() const
+  {
+    size_t const pushed = m_pushPos.load(std::memory_order_acquire);
+    size_t const popped = m_popPos.load(std::memory_order_acquire);
+    return pushed > popped ? pushed - popped : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  size_t GetCapacity() const { return m_mask + 1; }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> m_sequence{0};
+    T m_data;
+  };
+
+  // The padding keeps the positions of the producers and of the consumers
+  // in the different cache lines.
+  static size_t constexpr kCacheLineSize = 64;
+
+  Cell & GetCell(size_t pos) { return m_cells[pos & m_mask]; }
+
+  // Claims at most |maxCount| consecutive free cells starting from |pos|.
+  // Returns the number of the claimed cells.
+  size_t ClaimPushPositions(size_t maxCount, size_t & pos)
+  {
+    pos = m_pushPos.load(std::memory_order_relaxed);
+    if (maxCount == 0)
+      return 0;
+
+    while (true)
+    {
+      size_t count = 0;
+      while (count < maxCount &&
+             GetCell(pos + count).m_sequence.load(std::memory_order_acquire) == pos + count)
+      {
+        ++count;
+      }
+
+      if (count == 0)
+      {
+        // The cell is not free either because the queue is full or because another
+        // producer has already claimed it.
+        auto const seq = GetCell(pos).m_sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq - pos) < 0)
+          return 0;
+        pos = m_pushPos.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (m_pushPos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+        return count;
+    }
+  }
+
+  // Claims at most |maxCount| consecutive cells with the values starting from |pos|.
+  // Returns the number of the claimed cells.
+  size_t ClaimPopPositions(size_t maxCount, size_t & pos)
+  {
+    pos = m_popPos.load(std::memory_order_relaxed);
+    if (maxCount == 0)
+      return 0;
+
+    while (true)
+    {
+      size_t count = 0;
+      while (count < maxCount &&
+             GetCell(pos + count).m_sequence.load(std::memory_order_acquire) == pos + count + 1)
+      {
+        ++count;
+      }
+
+      if (count == 0)
+      {
+        auto const seq = GetCell(pos).m_sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq - (pos + 1)) < 0)
+          return 0;
+        pos = m_popPos.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (m_popPos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+        return count;
+    }
+  }
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask = 0;
+  char m_padding0[kCacheLineSize];
+  std::atomic<size_t> m_pushPos{0};
+  char m_padding1[kCacheLineSize];
+  std::atomic<size_t> m_popPos{0};
+  char m_padding2[kCacheLineSize];
+
+  WaitPolicy m_notEmpty;
+  WaitPolicy m_notFull;
+};
+}  // namespace threads
+}  // namespace base
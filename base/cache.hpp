@@ -61,6 +61,9 @@ namespace base
       return data.m_Value;
     }
 
+    // Returns true if @key is in cache, doesn't change the cache.
+    bool HasKey(KeyT const & key) const { return m_cache[Index(key)].m_Key == key; }
+
     template <typename F>
     void ForEachValue(F && f)
     {
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "base/assert.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+// The finalizer of SplitMix64. It spreads the structured 64-bit values, e.g. the encoded
+// GeoObjectIds with the type in the high bits or the sequential ids, over all the bits.
+inline uint64_t MixHash64(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// std::hash of integers and of GeoObjectId is the identity, so it is mixed for the open addressing.
+template <typename Key>
+struct FlatHash
+{
+  size_t operator()(Key const & key) const
+  {
+    return static_cast<size_t>(MixHash64(static_cast<uint64_t>(std::hash<Key>()(key))));
+  }
+};
+
+// A hash map with the open addressing and the linear probing in one array of entries. A control
+// byte per slot keeps 7 bits of the hash of the key, so the keys are compared only when their
+// hashes may match. An entry is erased by shifting the next entries of its chain back, so there
+// are no tombstones.
+// Unlike std::unordered_map, the entries are moved on rehash and on erase: any insertion or erasure
+// invalidates the iterators, the pointers and the references. The keys and the values must be
+// default constructible and movable, the key of an entry must not be changed through an iterator.
+template <typename Key, typename Value, typename Hash = FlatHash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap
+{
+public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key, Value>;
+  using size_type = size_t;
+
+  template <bool IsConst>
+  class Iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = FlatHashMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, value_type const *, value_type *>;
+    using reference = std::conditional_t<IsConst, value_type const &, value_type &>;
+    using Map = std::conditional_t<IsConst, FlatHashMap const, FlatHashMap>;
+
+    Iterator() = default;
+    Iterator(Map * map, size_t index) : m_map(map), m_index(index) { SkipEmpty(); }
+    // Conversion of an iterator to a const iterator.
+    template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+    Iterator(Iterator<WasConst> const & it) : m_map(it.m_map), m_index(it.m_index)
+    {
+    }
+
+    reference operator*() const { return m_map->m_slots[m_index]; }
+    pointer operator->() const { return &m_map->m_slots[m_index]; }
+
+    Iterator & operator++()
+    {
+      ++m_index;
+      SkipEmpty();
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      auto const it = *this;
+      ++(*this);
+      return it;
+    }
+
+    bool operator==(Iterator const & rhs) const { return m_index == rhs.m_index; }
+    bool operator!=(Iterator const & rhs) const { return m_index != rhs.m_index; }
+
+  private:
+    friend class FlatHashMap;
+    template <bool>
+    friend class Iterator;
+
+    void SkipEmpty()
+    {
+      while (m_index < m_map->m_ctrl.size() && m_map->m_ctrl[m_index] == kEmpty)
+        ++m_index;
+    }
+
+    Map * m_map = nullptr;
+    size_t m_index = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+  explicit FlatHashMap(size_t count) { reserve(count); }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  void clear()
+  {
+    m_ctrl.clear();
+    m_slots.clear();
+    m_size = 0;
+  }
+
+  // Makes room for |count| entries without rehashing.
+  void reserve(size_t count)
+  {
+    size_t capacity = kMinCapacity;
+    while (capacity * kMaxLoadNum < count * kMaxLoadDen)
+      capacity *= 2;
+    if (capacity > m_ctrl.size())
+      Rehash(capacity);
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, m_ctrl.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_ctrl.size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  iterator find(Key const & key)
+  {
+    auto const index = FindExisting(key);
+    return index == kNotFound ? end() : iterator(this, index);
+  }
+
+  const_iterator find(Key const & key) const
+  {
+    auto const index = FindExisting(key);
+    return index == kNotFound ? end() : const_iterator(this, index);
+  }
+
+  size_t count(Key const & key) const { return FindExisting(key) == kNotFound ? 0 : 1; }
+
+  // Constructs the value from |args| only if there is no |key| in the map yet, as
+  // std::unordered_map::try_emplace() does.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K && key, Args &&... args)
+  {
+    GrowIfNeeded();
+    auto const hash = m_hash(key);
+    auto const index = FindSlot(key, hash);
+    if (m_ctrl[index] != kEmpty)
+      return {iterator(this, index), false};
+
+    m_ctrl[index] = Fingerprint(hash);
+    m_slots[index] = value_type(std::forward<K>(key), Value(std::forward<Args>(args)...));
+    ++m_size;
+    return {iterator(this, index), true};
+  }
+
+  std::pair<iterator, bool> insert(value_type && value)
+  {
+    return emplace(std::move(value.first), std::move(value.second));
+  }
+
+  std::pair<iterator, bool> insert(value_type const & value)
+  {
+    return emplace(value.first, value.second);
+  }
+
+  Value & operator[](Key const & key) { return emplace(key).first->second; }
+
+  size_t erase(Key const & key)
+  {
+    auto const index = FindExisting(key);
+    if (index == kNotFound)
+      return 0;
+
+    EraseAt(index);
+    return 1;
+  }
+
+  void swap(FlatHashMap & rhs)
+  {
+    std::swap(m_ctrl, rhs.m_ctrl);
+    std::swap(m_slots, rhs.m_slots);
+    std::swap(m_size, rhs.m_size);
+  }
+
+private:
+  static uint8_t constexpr kEmpty = 0;
+  static size_t constexpr kMinCapacity = 16;
+  // The maximal load factor is 3/4.
+  static size_t constexpr kMaxLoadNum = 3;
+  static size_t constexpr kMaxLoadDen = 4;
+  static size_t constexpr kNotFound = std::numeric_limits<size_t>::max();
+
+  static uint8_t Fingerprint(size_t hash)
+  {
+    return static_cast<uint8_t>(0x80 | (hash >> (sizeof(size_t) * 8 - 7)));
+  }
+
+  // Returns the slot of |key| or the empty slot where it has to be inserted.
+  size_t FindSlot(Key const & key, size_t hash) const
+  {
+    ASSERT(!m_ctrl.empty(), ());
+    auto const fingerprint = Fingerprint(hash);
+    auto const mask = m_ctrl.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+      if (m_ctrl[i] == kEmpty || (m_ctrl[i] == fingerprint && m_equal(m_slots[i].first, key)))
+        return i;
+    }
+  }
+
+  size_t FindExisting(Key const & key) const
+  {
+    if (m_size == 0)
+      return kNotFound;
+
+    auto const index = FindSlot(key, m_hash(key));
+    return m_ctrl[index] == kEmpty ? kNotFound : index;
+  }
+
+  void GrowIfNeeded()
+  {
+    if ((m_size + 1) * kMaxLoadDen > m_ctrl.size() * kMaxLoadNum)
+      Rehash(m_ctrl.empty() ? kMinCapacity : m_ctrl.size() * 2);
+  }
+
+  void Rehash(size_t capacity)
+  {
+    ASSERT_EQUAL(capacity & (capacity - 1), 0, ());
+    std::vector<uint8_t> ctrl(capacity, kEmpty);
+    std::vector<value_type> slots(capacity);
+    std::swap(ctrl, m_ctrl);
+    std::swap(slots, m_slots);
+
+    auto const mask = capacity - 1;
+    for (size_t i = 0; i < ctrl.size(); ++i)
+    {
+      if (ctrl[i] == kEmpty)
+        continue;
+
+      auto index = m_hash(slots[i].first) & mask;
+      while (m_ctrl[index] != kEmpty)
+        index = (index + 1) & mask;
+      m_ctrl[index] = ctrl[i];
+      m_slots[index] = std::move(slots[i]);
+    }
+  }
+
+  void EraseAt(size_t index)
+  {
+    auto const mask = m_ctrl.size() - 1;
+    for (size_t i = (index + 1) & mask; m_ctrl[i] != kEmpty; i = (i + 1) & mask)
+    {
+      // The entry may fill the hole if its home slot is not in the cyclic range (hole, i].
+      auto const home = m_hash(m_slots[i].first) & mask;
+      if (((i - home) & mask) < ((i - index) & mask))
+        continue;
+
+      m_ctrl[index] = m_ctrl[i];
+      m_slots[index] = std::move(m_slots[i]);
+      index = i;
+    }
+
+    m_ctrl[index] = kEmpty;
+    m_slots[index] = value_type();
+    --m_size;
+  }
+
+  std::vector<uint8_t> m_ctrl;
+  std::vector<value_type> m_slots;
+  size_t m_size = 0;
+  Hash m_hash;
+  KeyEqual m_equal;
+};
+
+// A hash set on the top of FlatHashMap, see the notes on the invalidation there.
+template <typename Key, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashSet
+{
+  struct Empty
+  {
+  };
+
+  using Map = FlatHashMap<Key, Empty, Hash, KeyEqual>;
+
+public:
+  using key_type = Key;
+  using value_type = Key;
+  using size_type = size_t;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Key const *;
+    using reference = Key const &;
+
+    const_iterator() = default;
+    explicit const_iterator(typename Map::const_iterator it) : m_it(it) {}
+
+    reference operator*() const { return m_it->first; }
+    pointer operator->() const { return &m_it->first; }
+
+    const_iterator & operator++()
+    {
+      ++m_it;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto const it = *this;
+      ++m_it;
+      return it;
+    }
+
+    bool operator==(const_iterator const & rhs) const { return m_it == rhs.m_it; }
+    bool operator!=(const_iterator const & rhs) const { return m_it != rhs.m_it; }
+
+  private:
+    typename Map::const_iterator m_it;
+  };
+
+  using iterator = const_iterator;
+
+  FlatHashSet() = default;
+  explicit FlatHashSet(size_t count) : m_map(count) {}
+
+  size_t size() const { return m_map.size(); }
+  bool empty() const { return m_map.empty(); }
+  void clear() { m_map.clear(); }
+  void reserve(size_t count) { m_map.reserve(count); }
+
+  const_iterator begin() const { return const_iterator(m_map.begin()); }
+  const_iterator end() const { return const_iterator(m_map.end()); }
+
+  const_iterator find(Key const & key) const { return const_iterator(m_map.find(key)); }
+  size_t count(Key const & key) const { return m_map.count(key); }
+
+  template <typename K>
+  std::pair<const_iterator, bool> insert(K && key)
+  {
+    auto const res = m_map.emplace(std::forward<K>(key));
+    return {const_iterator(res.first), res.second};
+  }
+
+  template <typename K>
+  std::pair<const_iterator, bool> emplace(K && key)
+  {
+    return insert(std::forward<K>(key));
+  }
+
+  size_t erase(Key const & key) { return m_map.erase(key); }
+
+  void swap(FlatHashSet & rhs) { m_map.swap(rhs.m_map); }
+
+private:
+  Map m_map;
+};
+}  // namespace base
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "base/assert.hpp"
+#include "base/mem_trie.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+// A read-only copy of a built MemTrie in a few contiguous arrays. The nodes are numbered
+// in the breadth-first order with the children of a node sorted by their chars, so the
+// children of a node are a range of the nodes and a move is a binary search in the chars
+// of the range. The edge labels and the values of all the nodes are pooled in two arrays,
+// the ones of a node are the range up to the ones of the next node. A node costs three
+// offsets and a char, versus the heap allocated children container, label and values of
+// a MemTrie node.
+template <typename String, typename Value>
+class FrozenMemTrie
+{
+public:
+  using Char = typename String::value_type;
+
+  // A read-only iterator wrapping a node, see MemTrie::Iterator.
+  class Iterator
+  {
+  public:
+    using Char = FrozenMemTrie::Char;
+
+    Iterator(FrozenMemTrie const & trie, uint32_t node) : m_trie(&trie), m_node(node) {}
+
+    // Calls |toDo| with (Char of the move, Iterator wrapping the node of the move)
+    // in the order of the chars.
+    template <typename ToDo>
+    void ForEachMove(ToDo && toDo) const
+    {
+      auto const & nodes = m_trie->m_nodes;
+      for (auto child = nodes[m_node].m_firstChild; child < nodes[m_node + 1].m_firstChild;
+           ++child)
+      {
+        toDo(m_trie->m_chars[child], Iterator(*m_trie, child));
+      }
+    }
+
+    template <typename ToDo>
+    void ForEachInNode(ToDo && toDo) const
+    {
+      m_trie->ForEachValue(m_node, toDo);
+    }
+
+    String GetLabel() const
+    {
+      auto const & nodes = m_trie->m_nodes;
+      auto const & labels = m_trie->m_labels;
+      return String(labels.begin() + nodes[m_node].m_labelBegin,
+                    labels.begin() + nodes[m_node + 1].m_labelBegin);
+    }
+
+  private:
+    FrozenMemTrie const * m_trie;
+    uint32_t m_node;
+  };
+
+  // An empty trie: the root without values and children and the sentinel.
+  FrozenMemTrie() : m_nodes(2), m_chars(1)
+  {
+    m_nodes[0].m_firstChild = 1;
+    m_nodes[1].m_firstChild = 1;
+  }
+
+  template <typename ValuesHolder, template <typename...> class Moves>
+  explicit FrozenMemTrie(MemTrie<String, ValuesHolder, Moves> const & trie)
+  {
+    using TrieIterator = typename MemTrie<String, ValuesHolder, Moves>::Iterator;
+
+    std::vector<TrieIterator> queue;
+    queue.push_back(trie.GetRootIterator());
+    m_chars.push_back(Char());
+
+    std::vector<TrieIterator> children;
+    std::vector<Char> chars;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+      auto const it = queue[i];
+
+      Node node;
+      node.m_firstChild = ToOffset(queue.size());
+      node.m_labelBegin = ToOffset(m_labels.size());
+      node.m_valuesBegin = ToOffset(m_values.size());
+      m_nodes.push_back(node);
+
+      auto const label = it.GetLabel();
+      m_labels.insert(m_labels.end(), label.begin(), label.end());
+      it.ForEachInNode([this](Value const & value) { m_values.push_back(value); });
+
+      children.clear();
+      chars.clear();
+      it.ForEachMove([&](Char const & c, TrieIterator const & child) {
+        chars.push_back(c);
+        children.push_back(child);
+      });
+      order.resize(chars.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(),
+                [&chars](size_t lhs, size_t rhs) { return chars[lhs] < chars[rhs]; });
+      for (auto const j : order)
+      {
+        queue.push_back(children[j]);
+        m_chars.push_back(chars[j]);
+      }
+    }
+
+    Node sentinel;
+    sentinel.m_firstChild = ToOffset(queue.size());
+    sentinel.m_labelBegin = ToOffset(m_labels.size());
+    sentinel.m_valuesBegin = ToOffset(m_values.size());
+    m_nodes.push_back(sentinel);
+
+    m_nodes.shrink_to_fit();
+    m_chars.shrink_to_fit();
+    m_labels.shrink_to_fit();
+    m_values.shrink_to_fit();
+  }
+
+  // Traverses all key-value pairs in the trie and calls |toDo| on each of them.
+  template <typename ToDo>
+  void ForEachInTrie(ToDo && toDo) const
+  {
+    String prefix;
+    ForEachInSubtree(kRoot, prefix, toDo);
+  }
+
+  // Calls |toDo| for each value in the node that is reachable
+  // by |prefix| from the trie root.
+  template <typename ToDo>
+  void ForEachInNode(String const & prefix, ToDo && toDo) const
+  {
+    MoveTo(prefix, true /* fullMatch */,
+           [&](uint32_t node, size_t /* offset */) { ForEachValue(node, toDo); });
+  }
+
+  // Calls |toDo| for each key-value pair in a subtree that is
+  // reachable by |prefix| from the trie root.
+  template <typename ToDo>
+  void ForEachInSubtree(String const & prefix, ToDo && toDo) const
+  {
+    MoveTo(prefix, false /* fullMatch */, [&](uint32_t node, size_t offset) {
+      String p = prefix;
+      auto const label = m_labels.begin() + m_nodes[node].m_labelBegin;
+      p.insert(p.end(), label + offset, m_labels.begin() + m_nodes[node + 1].m_labelBegin);
+      ForEachInSubtree(node, p, toDo);
+    });
+  }
+
+  bool HasKey(String const & key) const
+  {
+    bool exists = false;
+    MoveTo(key, true /* fullMatch */, [&](uint32_t node, size_t /* offset */) {
+      exists = m_nodes[node].m_valuesBegin != m_nodes[node + 1].m_valuesBegin;
+    });
+    return exists;
+  }
+
+  bool HasPrefix(String const & prefix) const
+  {
+    bool exists = false;
+    MoveTo(prefix, false /* fullMatch */, [&](uint32_t node, size_t /* offset */) {
+      exists = m_nodes[node].m_firstChild != m_nodes[node + 1].m_firstChild ||
+               m_nodes[node].m_valuesBegin != m_nodes[node + 1].m_valuesBegin;
+    });
+    return exists;
+  }
+
+  Iterator GetRootIterator() const { return Iterator(*this, kRoot); }
+
+  size_t GetNumNodes() const { return m_nodes.size() - 1; }
+
+  size_t GetMemorySize() const
+  {
+    return m_nodes.capacity() * sizeof(Node) + m_chars.capacity() * sizeof(Char) +
+           m_labels.capacity() * sizeof(Char) + m_values.capacity() * sizeof(Value);
+  }
+
+private:
+  struct Node
+  {
+    uint32_t m_firstChild = 0;
+    uint32_t m_labelBegin = 0;
+    uint32_t m_valuesBegin = 0;
+  };
+
+  static uint32_t constexpr kRoot = 0;
+
+  static uint32_t ToOffset(size_t offset)
+  {
+    CHECK_LESS(offset, std::numeric_limits<uint32_t>::max(), ());
+    return static_cast<uint32_t>(offset);
+  }
+
+  template <typename ToDo>
+  void ForEachValue(uint32_t node, ToDo && toDo) const
+  {
+    for (auto i = m_nodes[node].m_valuesBegin; i < m_nodes[node + 1].m_valuesBegin; ++i)
+      toDo(m_values[i]);
+  }
+
+  // Returns the child of |node| by |c| or kRoot when there is no such child.
+  uint32_t GetMove(uint32_t node, Char const & c) const
+  {
+    auto const begin = m_chars.begin() + m_nodes[node].m_firstChild;
+    auto const end = m_chars.begin() + m_nodes[node + 1].m_firstChild;
+    auto const it = std::lower_bound(begin, end, c);
+    if (it == end || *it != c)
+      return kRoot;
+    return static_cast<uint32_t>(it - m_chars.begin());
+  }
+
+  // Calls |fn| with the node reachable by |prefix| and the length of the matched part of
+  // its label. The label is matched completely when |fullMatch| is set.
+  template <typename Fn>
+  void MoveTo(String const & prefix, bool fullMatch, Fn && fn) const
+  {
+    uint32_t node = kRoot;
+    size_t offset = 0;
+    auto it = prefix.begin();
+    while (it != prefix.end())
+    {
+      node = GetMove(node, *it++);
+      if (node == kRoot)
+        return;
+
+      auto const labelBegin = m_nodes[node].m_labelBegin;
+      auto const labelSize = m_nodes[node + 1].m_labelBegin - labelBegin;
+      offset = 0;
+      while (offset < labelSize && it != prefix.end() && m_labels[labelBegin + offset] == *it)
+      {
+        ++offset;
+        ++it;
+      }
+
+      if (offset < labelSize && (it != prefix.end() || fullMatch))
+        return;
+    }
+    fn(node, offset);
+  }
+
+  // |prefix| is the key of |node|, it is the same after the call.
+  template <typename ToDo>
+  void ForEachInSubtree(uint32_t node, String & prefix, ToDo && toDo) const
+  {
+    ForEachValue(node, [&](Value const & value) {
+      toDo(static_cast<String const &>(prefix), value);
+    });
+
+    for (auto child = m_nodes[node].m_firstChild; child < m_nodes[node + 1].m_firstChild; ++child)
+    {
+      auto const size = prefix.size();
+      prefix.push_back(m_chars[child]);
+      prefix.insert(prefix.end(), m_labels.begin() + m_nodes[child].m_labelBegin,
+                    m_labels.begin() + m_nodes[child + 1].m_labelBegin);
+      ForEachInSubtree(child, prefix, toDo);
+      prefix.resize(size);
+    }
+  }
+
+  // The nodes with a sentinel at the end.
+  std::vector<Node> m_nodes;
+  // m_chars[node] is the first char of the edge to |node|, the rest is the label of |node|.
+  std::vector<Char> m_chars;
+  std::vector<Char> m_labels;
+  std::vector<Value> m_values;
+};
+}  // namespace base
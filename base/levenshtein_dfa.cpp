@@ -4,7 +4,10 @@
 #include "base/stl_helpers.hpp"
 
 #include <algorithm>
+#include <array>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <queue>
 #include <set>
 #include <vector>
@@ -114,6 +117,90 @@ private:
   std::vector<UniString> const m_prefixMisprints;
   size_t const m_prefixSize;
 };
+
+// The kinds of the input of the universal automaton by the prefix rules of the leftmost
+// position: out of the prefix, in the prefix and the char is not an allowed misprint of
+// the first char, in the prefix and the char is an allowed misprint.
+size_t constexpr kNoPrefix = 0;
+size_t constexpr kPrefix = 1;
+size_t constexpr kPrefixMisprint = 2;
+size_t constexpr kPrefixKindsCount = 3;
+
+// The same moves as TransitionTable makes, but the positions are relative to the window of
+// the |restSize| first chars of the rest of the string, and |mask| is the characteristic
+// vector of the input char in the window. |restSize| is the window size when the rest of
+// the string is at least as long as the window.
+class UniversalTransitionTable
+{
+public:
+  UniversalTransitionTable(uint32_t mask, size_t restSize, size_t prefixKind)
+    : m_mask(mask), m_size(restSize), m_prefixKind(prefixKind)
+  {
+  }
+
+  void Move(LevenshteinDFA::State const & s, LevenshteinDFA::State & t) const
+  {
+    t.Clear();
+    for (auto const & p : s.m_positions)
+      GetMoves(p, t);
+    t.Normalize();
+  }
+
+private:
+  bool Matches(size_t offset) const { return offset < m_size && ((m_mask >> offset) & 1) != 0; }
+
+  void GetMoves(LevenshteinDFA::Position const & p, LevenshteinDFA::State & t) const
+  {
+    auto & ps = t.m_positions;
+
+    if (p.IsTransposed())
+    {
+      if (p.m_offset + 2 <= m_size && Matches(p.m_offset))
+        ps.emplace_back(p.m_offset + 2, p.m_errorsLeft, false /* transposed */);
+      return;
+    }
+
+    if (Matches(p.m_offset))
+    {
+      ps.emplace_back(p.m_offset + 1, p.m_errorsLeft, false /* transposed */);
+      return;
+    }
+
+    if (p.m_errorsLeft == 0)
+      return;
+
+    ps.emplace_back(p.m_offset, p.m_errorsLeft - 1, false /* transposed */);
+
+    // The prefix is at most one char, so only the leftmost position at the string begin is in it.
+    if (m_prefixKind != kNoPrefix && p.m_offset == 0)
+    {
+      if (m_prefixKind == kPrefixMisprint)
+        ps.emplace_back(p.m_offset + 1, p.m_errorsLeft - 1, false /* transposed */);
+      return;
+    }
+
+    if (p.m_offset == m_size)
+      return;
+
+    ps.emplace_back(p.m_offset + 1, p.m_errorsLeft - 1, false /* transposed */);
+
+    size_t const limit = std::min(m_size - p.m_offset, p.m_errorsLeft + 1);
+    for (size_t i = 1; i < limit; ++i)
+    {
+      if (!Matches(p.m_offset + i))
+        continue;
+
+      ps.emplace_back(p.m_offset + i + 1, p.m_errorsLeft - i, false /* transposed */);
+      if (i == 1)
+        ps.emplace_back(p.m_offset, p.m_errorsLeft - 1, true /* transposed */);
+      break;
+    }
+  }
+
+  uint32_t const m_mask;
+  size_t const m_size;
+  size_t const m_prefixKind;
+};
 }  // namespace
 
 // LevenshteinDFA ----------------------------------------------------------------------------------
@@ -374,6 +461,264 @@ size_t LevenshteinDFA::Move(size_t s, UniChar c) const
   return m_transitions[s][i];
 }
 
+// UniversalLevenshteinDFA::Tables ---------------------------------------------------------------
+struct UniversalLevenshteinDFA::Tables
+{
+  struct Transition
+  {
+    uint16_t m_state = 0;
+    // The shift of the window.
+    uint8_t m_shift = 0;
+  };
+
+  static uint32_t constexpr kStartingState = 0;
+  static uint32_t constexpr kRejectingState = 1;
+
+  explicit Tables(size_t maxErrors);
+
+  // The index of the input by the window size of the rest of the string, the characteristic
+  // vector of the input char in the window and the prefix kind.
+  size_t GetInputIndex(size_t restSize, uint32_t mask, size_t prefixKind) const
+  {
+    return prefixKind * m_inputsPerPrefixKind + (size_t{1} << restSize) - 1 + mask;
+  }
+
+  size_t m_maxErrors;
+  // The positions of a state are in [0, m_window) along with the chars which they examine,
+  // so the window of m_window chars of the rest of the string defines the moves.
+  size_t m_window;
+  size_t m_inputsPerPrefixKind;
+  size_t m_inputsCount;
+
+  size_t m_statesCount = 0;
+  // m_transitions[state * m_inputsCount + input].
+  std::vector<Transition> m_transitions;
+  // m_accepting[state * (m_window + 1) + restSize], the rest of the string is at least
+  // m_window chars long when restSize is m_window. So is m_errorsMade.
+  std::vector<bool> m_accepting;
+  std::vector<uint8_t> m_errorsMade;
+  std::vector<uint8_t> m_prefixErrorsMade;
+};
+
+// static
+uint32_t constexpr UniversalLevenshteinDFA::Tables::kStartingState;
+// static
+uint32_t constexpr UniversalLevenshteinDFA::Tables::kRejectingState;
+
+UniversalLevenshteinDFA::Tables::Tables(size_t maxErrors)
+  : m_maxErrors(maxErrors)
+  , m_window(3 * maxErrors + 2)
+  , m_inputsPerPrefixKind((size_t{1} << (m_window + 1)) - 1)
+  , m_inputsCount(kPrefixKindsCount * m_inputsPerPrefixKind)
+{
+  using State = LevenshteinDFA::State;
+
+  std::vector<State> states;
+  std::map<State, uint32_t> ids;
+  auto const getId = [&](State const & state) {
+    auto const it = ids.find(state);
+    if (it != ids.end())
+      return it->second;
+
+    for (auto const & p : state.m_positions)
+    {
+      CHECK_LESS_OR_EQUAL(p.m_offset + std::max<size_t>(p.m_errorsLeft + 1, 2), m_window,
+                          (state));
+    }
+    CHECK_LESS(states.size(), std::numeric_limits<uint16_t>::max(), ());
+    auto const id = static_cast<uint32_t>(states.size());
+    ids.emplace(state, id);
+    states.push_back(state);
+    return id;
+  };
+
+  State start;
+  start.m_positions.emplace_back(0 /* offset */, maxErrors /* errorsLeft */,
+                                 false /* transposed */);
+  CHECK_EQUAL(getId(start), kStartingState, ());
+  CHECK_EQUAL(getId(State()), kRejectingState, ());
+
+  // The states are numbered in the order of the breadth-first search.
+  State next;
+  for (size_t id = 0; id < states.size(); ++id)
+  {
+    m_transitions.resize(m_transitions.size() + m_inputsCount);
+    auto * transitions = &m_transitions[id * m_inputsCount];
+    for (size_t prefixKind = 0; prefixKind < kPrefixKindsCount; ++prefixKind)
+    {
+      for (size_t restSize = 0; restSize <= m_window; ++restSize)
+      {
+        for (uint32_t mask = 0; mask < (uint32_t{1} << restSize); ++mask)
+        {
+          UniversalTransitionTable(mask, restSize, prefixKind).Move(states[id], next);
+          size_t shift = 0;
+          if (!next.m_positions.empty())
+          {
+            // The positions are sorted by the offsets.
+            shift = next.m_positions.front().m_offset;
+            for (auto & p : next.m_positions)
+              p.m_offset -= shift;
+          }
+
+          auto & transition = transitions[GetInputIndex(restSize, mask, prefixKind)];
+          transition.m_state = static_cast<uint16_t>(getId(next));
+          transition.m_shift = static_cast<uint8_t>(shift);
+        }
+      }
+    }
+  }
+
+  m_statesCount = states.size();
+  m_accepting.resize(m_statesCount * (m_window + 1));
+  m_errorsMade.resize(m_statesCount * (m_window + 1));
+  m_prefixErrorsMade.resize(m_statesCount);
+  for (size_t id = 0; id < m_statesCount; ++id)
+  {
+    size_t prefixErrorsMade = maxErrors;
+    for (auto const & p : states[id].m_positions)
+      prefixErrorsMade = std::min(prefixErrorsMade, maxErrors - p.m_errorsLeft);
+    m_prefixErrorsMade[id] = static_cast<uint8_t>(prefixErrorsMade);
+
+    for (size_t restSize = 0; restSize <= m_window; ++restSize)
+    {
+      auto const index = id * (m_window + 1) + restSize;
+      size_t errorsMade = maxErrors;
+      for (auto const & p : states[id].m_positions)
+      {
+        if (p.IsTransposed() || p.m_offset > restSize || restSize - p.m_offset > p.m_errorsLeft)
+          continue;
+        m_accepting[index] = true;
+        errorsMade = std::min(errorsMade, maxErrors - (p.m_errorsLeft - (restSize - p.m_offset)));
+      }
+      m_errorsMade[index] = static_cast<uint8_t>(errorsMade);
+    }
+  }
+}
+
+// UniversalLevenshteinDFA::Iterator ---------------------------------------------------------------
+UniversalLevenshteinDFA::Iterator & UniversalLevenshteinDFA::Iterator::Move(UniChar c)
+{
+  auto const & tables = m_dfa.m_tables;
+  if (m_state == Tables::kRejectingState)
+    return *this;
+
+  auto const & s = m_dfa.m_s;
+  auto const restSize = std::min(s.size() - m_offset, tables.m_window);
+  uint32_t mask = 0;
+  for (size_t i = 0; i < restSize; ++i)
+  {
+    if (s[m_offset + i] == c)
+      mask |= uint32_t{1} << i;
+  }
+
+  size_t prefixKind = kNoPrefix;
+  if (m_offset < m_dfa.m_prefixSize)
+    prefixKind = m_dfa.IsPrefixMisprint(c) ? kPrefixMisprint : kPrefix;
+
+  auto const & transition =
+      tables.m_transitions[m_state * tables.m_inputsCount +
+                           tables.GetInputIndex(restSize, mask, prefixKind)];
+  m_state = transition.m_state;
+  m_offset += transition.m_shift;
+  return *this;
+}
+
+bool UniversalLevenshteinDFA::Iterator::Accepts() const
+{
+  return m_dfa.m_tables.m_accepting[GetRestIndex()];
+}
+
+bool UniversalLevenshteinDFA::Iterator::Rejects() const
+{
+  return m_state == Tables::kRejectingState;
+}
+
+size_t UniversalLevenshteinDFA::Iterator::ErrorsMade() const
+{
+  return m_dfa.m_tables.m_errorsMade[GetRestIndex()];
+}
+
+size_t UniversalLevenshteinDFA::Iterator::PrefixErrorsMade() const
+{
+  return m_dfa.m_tables.m_prefixErrorsMade[m_state];
+}
+
+size_t UniversalLevenshteinDFA::Iterator::GetRestIndex() const
+{
+  auto const & tables = m_dfa.m_tables;
+  auto const restSize = std::min(m_dfa.m_s.size() - m_offset, tables.m_window);
+  return m_state * (tables.m_window + 1) + restSize;
+}
+
+// UniversalLevenshteinDFA -------------------------------------------------------------------------
+namespace
+{
+UniversalLevenshteinDFA::Tables const & GetUniversalTables(size_t maxErrors)
+{
+  static auto const tables = []() {
+    std::vector<UniversalLevenshteinDFA::Tables> tables;
+    for (size_t maxErrors = 0; maxErrors <= UniversalLevenshteinDFA::kMaxErrors; ++maxErrors)
+      tables.emplace_back(maxErrors);
+    return tables;
+  }();
+
+  CHECK_LESS_OR_EQUAL(maxErrors, UniversalLevenshteinDFA::kMaxErrors, ());
+  return tables[maxErrors];
+}
+}  // namespace
+
+// static
+size_t constexpr UniversalLevenshteinDFA::kMaxErrors;
+// static
+size_t constexpr UniversalLevenshteinDFA::kMaxPrefixSize;
+
+UniversalLevenshteinDFA::UniversalLevenshteinDFA(UniString const & s, size_t prefixSize,
+                                                 std::vector<UniString> const & prefixMisprints,
+                                                 size_t maxErrors)
+  : m_s(s), m_prefixSize(prefixSize), m_tables(GetUniversalTables(maxErrors))
+{
+  CHECK_LESS_OR_EQUAL(prefixSize, s.size(), ());
+  CHECK_LESS_OR_EQUAL(prefixSize, kMaxPrefixSize, ());
+
+  if (prefixSize == 0)
+    return;
+
+  for (auto const & misprints : prefixMisprints)
+  {
+    if (std::find(misprints.begin(), misprints.end(), s[0]) != misprints.end())
+      m_prefixMisprints.insert(m_prefixMisprints.end(), misprints.begin(), misprints.end());
+  }
+  base::SortUnique(m_prefixMisprints);
+}
+
+UniversalLevenshteinDFA::UniversalLevenshteinDFA(std::string const & s, size_t prefixSize,
+                                                 size_t maxErrors)
+  : UniversalLevenshteinDFA(MakeUniString(s), prefixSize, {} /* prefixMisprints */, maxErrors)
+{
+}
+
+UniversalLevenshteinDFA::UniversalLevenshteinDFA(UniString const & s, size_t maxErrors)
+  : UniversalLevenshteinDFA(s, 0 /* prefixSize */, {} /* prefixMisprints */, maxErrors)
+{
+}
+
+UniversalLevenshteinDFA::UniversalLevenshteinDFA(std::string const & s, size_t maxErrors)
+  : UniversalLevenshteinDFA(MakeUniString(s), 0 /* prefixSize */, {} /* prefixMisprints */,
+                            maxErrors)
+{
+}
+
+// static
+size_t UniversalLevenshteinDFA::GetNumStates(size_t maxErrors)
+{
+  return GetUniversalTables(maxErrors).m_statesCount;
+}
+
+bool UniversalLevenshteinDFA::IsPrefixMisprint(UniChar c) const
+{
+  return std::binary_search(m_prefixMisprints.begin(), m_prefixMisprints.end(), c);
+}
+
 std::string DebugPrint(LevenshteinDFA::Position const & p)
 {
   std::ostringstream os;
@@ -3,6 +3,7 @@
 #include "base/string_utils.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -24,8 +25,8 @@ namespace strings
 //
 // *NOTE* The class *IS* thread-safe.
 //
-// TODO (@y): consider to implement a factory of automata, that will
-// be able to construct them quickly for a fixed number of errors.
+// See UniversalLevenshteinDFA for an automaton which is not built
+// for every string.
 class LevenshteinDFA
 {
 public:
@@ -144,6 +145,73 @@ private:
   std::vector<size_t> m_prefixErrorsMade;
 };
 
+// An automaton recognizing the same language as LevenshteinDFA with the same errors made,
+// but nothing is built for a string. The universal (parametric) automaton by Schulz and
+// Mihov is precomputed once for every number of errors: its states are the sets of
+// LevenshteinDFA positions relative to the leftmost position, and its transitions are
+// taken by the characteristic vectors of the input chars, i.e. by the masks of the chars
+// of a window of the string equal to the input char. An iterator keeps the offset of the
+// window and a universal state, and a move costs a few char comparisons and a table lookup.
+//
+// Only |maxErrors| <= kMaxErrors and |prefixSize| <= kMaxPrefixSize are supported.
+//
+// *NOTE* The class *IS* thread-safe.
+class UniversalLevenshteinDFA
+{
+public:
+  static size_t constexpr kMaxErrors = 2;
+  static size_t constexpr kMaxPrefixSize = 1;
+
+  struct Tables;
+
+  // *NOTE* The class *IS NOT* thread safe. Moreover, it should not be
+  // used after destruction of the corresponding DFA.
+  class Iterator
+  {
+  public:
+    Iterator & Move(UniChar c);
+
+    bool Accepts() const;
+    bool Rejects() const;
+
+    size_t ErrorsMade() const;
+    size_t PrefixErrorsMade() const;
+
+  private:
+    friend class UniversalLevenshteinDFA;
+
+    explicit Iterator(UniversalLevenshteinDFA const & dfa) : m_dfa(dfa) {}
+
+    // The index of the window of the state in the tables.
+    size_t GetRestIndex() const;
+
+    UniversalLevenshteinDFA const & m_dfa;
+    // The offset in the string of the leftmost position of the state.
+    size_t m_offset = 0;
+    uint32_t m_state = 0;
+  };
+
+  UniversalLevenshteinDFA(UniString const & s, size_t prefixSize,
+                          std::vector<UniString> const & prefixMisprints, size_t maxErrors);
+  UniversalLevenshteinDFA(std::string const & s, size_t prefixSize, size_t maxErrors);
+  UniversalLevenshteinDFA(UniString const & s, size_t maxErrors);
+  UniversalLevenshteinDFA(std::string const & s, size_t maxErrors);
+
+  Iterator Begin() const { return Iterator(*this); }
+
+  // The number of the states of the universal automaton for |maxErrors|.
+  static size_t GetNumStates(size_t maxErrors);
+
+private:
+  bool IsPrefixMisprint(UniChar c) const;
+
+  UniString m_s;
+  size_t m_prefixSize;
+  // The chars which may replace the first char of |m_s| when |m_prefixSize| is 1, sorted.
+  std::vector<UniChar> m_prefixMisprints;
+  Tables const & m_tables;
+};
+
 std::string DebugPrint(LevenshteinDFA::Position const & p);
 std::string DebugPrint(LevenshteinDFA::State const & s);
 }  // namespace strings
@@ -0,0 +1,151 @@
+#include "base/memory_accounting.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace base
+{
+namespace memory
+{
+namespace
+{
+class Registry
+{
+public:
+  static Registry & Instance()
+  {
+    // The tags are referenced by the static objects, so the registry is never destroyed.
+    static auto * registry = new Registry();
+    return *registry;
+  }
+
+  Tag & GetTag(std::string const & name)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto & tag = m_tags[name];
+    if (!tag)
+      tag = std::make_unique<Tag>(name);
+    return *tag;
+  }
+
+  std::vector<TagUsage> GetUsage() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<TagUsage> usage;
+    for (auto const & tag : m_tags)
+      usage.push_back({tag.first, tag.second->GetBytes(), tag.second->GetPeakBytes()});
+    return usage;
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<Tag>> m_tags;
+};
+}  // namespace
+
+// Tag ---------------------------------------------------------------------------------------------
+void Tag::Add(size_t bytes)
+{
+  auto const current = m_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  auto peak = m_peakBytes.load(std::memory_order_relaxed);
+  while (peak < current &&
+         !m_peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+  {
+  }
+}
+
+void Tag::Remove(size_t bytes)
+{
+  auto const previous = m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  ASSERT_GREATER_OR_EQUAL(previous, bytes, (m_name));
+  UNUSED_VALUE(previous);
+}
+
+Tag & GetTag(std::string const & name) { return Registry::Instance().GetTag(name); }
+
+std::vector<TagUsage> GetUsage() { return Registry::Instance().GetUsage(); }
+
+std::string DebugPrint(TagUsage const & usage)
+{
+  auto const toMb = [](uint64_t bytes) { return bytes / (1024 * 1024); };
+  std::ostringstream out;
+  out << usage.m_name << ": " << toMb(usage.m_bytes) << " MB (peak " << toMb(usage.m_peakBytes)
+      << " MB)";
+  return out.str();
+}
+
+std::string DebugPrint(std::vector<TagUsage> const & usage)
+{
+  std::ostringstream out;
+  out << "[";
+  for (size_t i = 0; i < usage.size(); ++i)
+    out << (i == 0 ? "" : ", ") << DebugPrint(usage[i]);
+  out << "]";
+  return out.str();
+}
+
+// ScopedBytes -------------------------------------------------------------------------------------
+ScopedBytes & ScopedBytes::operator=(ScopedBytes const & rhs)
+{
+  if (this != &rhs)
+  {
+    Set(0);
+    m_tag = rhs.m_tag;
+    Set(rhs.m_bytes);
+  }
+  return *this;
+}
+
+ScopedBytes & ScopedBytes::operator=(ScopedBytes && rhs) noexcept
+{
+  if (this != &rhs)
+  {
+    Set(0);
+    m_tag = rhs.m_tag;
+    m_bytes = rhs.m_bytes;
+    rhs.m_bytes = 0;
+  }
+  return *this;
+}
+
+void ScopedBytes::Set(size_t bytes)
+{
+  if (!m_tag || bytes == m_bytes)
+  {
+    m_bytes = bytes;
+    return;
+  }
+
+  if (bytes > m_bytes)
+    m_tag->Add(bytes - m_bytes);
+  else
+    m_tag->Remove(m_bytes - bytes);
+  m_bytes = bytes;
+}
+
+// PeriodicUsageLogger -----------------------------------------------------------------------------
+PeriodicUsageLogger::PeriodicUsageLogger(std::chrono::milliseconds period)
+{
+  CHECK_GREATER(period.count(), 0, ());
+  m_thread = std::thread([this, period]() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cv.wait_for(lock, period, [this]() { return m_stopped; }))
+      LOG(LINFO, ("Memory usage:", GetUsage()));
+  });
+}
+
+PeriodicUsageLogger::~PeriodicUsageLogger()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_cv.notify_one();
+  m_thread.join();
+}
+}  // namespace memory
+}  // namespace base
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "base/macros.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace base
+{
+namespace memory
+{
+// The counter of the bytes held by the data structures of a subsystem, e.g. the node storage
+// or the geocoder index. The subsystems count their large buffers and containers, not every
+// allocation, so the counters attribute the bulk of the memory but do not sum up to the RSS.
+class Tag
+{
+public:
+  explicit Tag(std::string const & name) : m_name(name) {}
+
+  std::string const & GetName() const { return m_name; }
+
+  void Add(size_t bytes);
+  void Remove(size_t bytes);
+
+  uint64_t GetBytes() const { return m_bytes.load(std::memory_order_relaxed); }
+  uint64_t GetPeakBytes() const { return m_peakBytes.load(std::memory_order_relaxed); }
+
+private:
+  std::string const m_name;
+  std::atomic<uint64_t> m_bytes{0};
+  std::atomic<uint64_t> m_peakBytes{0};
+
+  DISALLOW_COPY_AND_MOVE(Tag);
+};
+
+// Returns the tag of |name|, it is created on the first call and lives until the process exit.
+Tag & GetTag(std::string const & name);
+
+struct TagUsage
+{
+  std::string m_name;
+  uint64_t m_bytes = 0;
+  uint64_t m_peakBytes = 0;
+};
+
+// The usage of all the tags ordered by the names.
+std::vector<TagUsage> GetUsage();
+
+std::string DebugPrint(TagUsage const & usage);
+std::string DebugPrint(std::vector<TagUsage> const & usage);
+
+// Counts the bytes of an object in a tag while the object lives. It is meant to be a member
+// of the object: a copy counts the bytes once more, Set() updates them when the object grows.
+// A default constructed or a null |tag| ScopedBytes counts nothing.
+class ScopedBytes
+{
+public:
+  ScopedBytes() = default;
+  explicit ScopedBytes(Tag * tag, size_t bytes = 0) : m_tag(tag) { Set(bytes); }
+  explicit ScopedBytes(Tag & tag, size_t bytes = 0) : ScopedBytes(&tag, bytes) {}
+  explicit ScopedBytes(std::string const & tagName, size_t bytes = 0)
+    : ScopedBytes(GetTag(tagName), bytes)
+  {
+  }
+
+  ScopedBytes(ScopedBytes const & rhs) : m_tag(rhs.m_tag) { Set(rhs.m_bytes); }
+  ScopedBytes(ScopedBytes && rhs) noexcept : m_tag(rhs.m_tag), m_bytes(rhs.m_bytes)
+  {
+    rhs.m_bytes = 0;
+  }
+
+  ScopedBytes & operator=(ScopedBytes const & rhs);
+  ScopedBytes & operator=(ScopedBytes && rhs) noexcept;
+
+  ~ScopedBytes() { Set(0); }
+
+  void Set(size_t bytes);
+  size_t Get() const { return m_bytes; }
+
+private:
+  Tag * m_tag = nullptr;
+  size_t m_bytes = 0;
+};
+
+// An STL allocator which counts the memory of a container in a tag.
+template <typename T>
+class TaggedAllocator
+{
+public:
+  using value_type = T;
+
+  explicit TaggedAllocator(Tag & tag) noexcept : m_tag(&tag) {}
+
+  template <typename U>
+  TaggedAllocator(TaggedAllocator<U> const & other) noexcept : m_tag(&other.GetTag())
+  {
+  }
+
+  T * allocate(size_t n)
+  {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    auto * p = std::allocator<T>().allocate(n);
+    m_tag->Add(n * sizeof(T));
+    return p;
+  }
+
+  void deallocate(T * p, size_t n) noexcept
+  {
+    std::allocator<T>().deallocate(p, n);
+    m_tag->Remove(n * sizeof(T));
+  }
+
+  Tag & GetTag() const noexcept { return *m_tag; }
+
+private:
+  Tag * m_tag;
+};
+
+template <typename T, typename U>
+bool operator==(TaggedAllocator<T> const & lhs, TaggedAllocator<U> const & rhs) noexcept
+{
+  return &lhs.GetTag() == &rhs.GetTag();
+}
+
+template <typename T, typename U>
+bool operator!=(TaggedAllocator<T> const & lhs, TaggedAllocator<U> const & rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+// Logs the usage of the tags every |period| from a thread of its own until the destruction.
+class PeriodicUsageLogger
+{
+public:
+  explicit PeriodicUsageLogger(std::chrono::milliseconds period);
+  ~PeriodicUsageLogger();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stopped = false;
+  std::thread m_thread;
+
+  DISALLOW_COPY_AND_MOVE(PeriodicUsageLogger);
+};
+}  // namespace memory
+}  // namespace base
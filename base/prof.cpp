@@ -0,0 +1,347 @@
+#include "base/prof.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace base
+{
+namespace prof
+{
+namespace
+{
+// The limit of the trace of a thread, the zones are still accumulated in the stats.
+size_t const kMaxEventsPerThread = 1 << 20;
+
+struct Event
+{
+  char const * m_name;
+  uint64_t m_start;
+  uint64_t m_duration;
+};
+
+struct Accumulator
+{
+  uint64_t m_count = 0;
+  uint64_t m_total = 0;
+  uint64_t m_max = 0;
+};
+
+// The zones of a thread. Only the owner thread appends, so the mutex is not contended
+// except for the dumps.
+struct ThreadBuffer
+{
+  explicit ThreadBuffer(uint32_t id) : m_id(id) {}
+
+  uint32_t const m_id;
+  std::mutex m_mutex;
+  std::vector<Event> m_events;
+  std::unordered_map<char const *, Accumulator> m_stats;
+  uint64_t m_dropped = 0;
+};
+
+// The buffers outlive their threads, so the zones of the finished threads are in the dumps.
+class Registry
+{
+public:
+  static Registry & Instance()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  ThreadBuffer & GetThreadBuffer()
+  {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      buffer = std::make_shared<ThreadBuffer>(static_cast<uint32_t>(m_buffers.size()) + 1);
+      m_buffers.push_back(buffer);
+    }
+    return *buffer;
+  }
+
+  char const * Intern(std::string const & name)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_names.insert(name).first->c_str();
+  }
+
+  void Add(Counter & counter)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters.push_back(&counter);
+  }
+
+  void Add(Histogram & histogram)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_histograms.push_back(&histogram);
+  }
+
+  template <typename Fn>
+  void ForEachBuffer(Fn && fn)
+  {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      buffers = m_buffers;
+    }
+    for (auto const & buffer : buffers)
+    {
+      std::lock_guard<std::mutex> lock(buffer->m_mutex);
+      fn(*buffer);
+    }
+  }
+
+  std::vector<Counter *> GetCounters()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_counters;
+  }
+
+  std::vector<Histogram *> GetHistograms()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_histograms;
+  }
+
+private:
+  Registry() = default;
+
+  std::mutex m_mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+  std::set<std::string> m_names;
+  std::vector<Counter *> m_counters;
+  std::vector<Histogram *> m_histograms;
+};
+
+std::string Escape(char const * s)
+{
+  std::string result;
+  for (; *s != '\0'; ++s)
+  {
+    auto const c = *s;
+    if (c == '"' || c == '\\')
+    {
+      result += '\\';
+      result += c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+      result += buffer;
+    }
+    else
+    {
+      result += c;
+    }
+  }
+  return result;
+}
+}  // namespace
+
+namespace internal
+{
+std::atomic<bool> g_enabled{false};
+
+uint64_t NowMicroseconds()
+{
+  using namespace std::chrono;
+  static auto const start = steady_clock::now();
+  return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+char const * Intern(std::string const & name) { return Registry::Instance().Intern(name); }
+
+void RecordZone(char const * name, uint64_t startMicroseconds, uint64_t endMicroseconds)
+{
+  auto & buffer = Registry::Instance().GetThreadBuffer();
+  auto const duration = endMicroseconds - startMicroseconds;
+  std::lock_guard<std::mutex> lock(buffer.m_mutex);
+  auto & stats = buffer.m_stats[name];
+  ++stats.m_count;
+  stats.m_total += duration;
+  stats.m_max = std::max(stats.m_max, duration);
+
+  if (buffer.m_events.size() < kMaxEventsPerThread)
+    buffer.m_events.push_back({name, startMicroseconds, duration});
+  else
+    ++buffer.m_dropped;
+}
+}  // namespace internal
+
+void SetEnabled(bool enabled)
+{
+  // The clock starts at the first use, so the trace starts with the profiling.
+  internal::NowMicroseconds();
+  internal::g_enabled.store(enabled);
+}
+
+// Counter -----------------------------------------------------------------------------------------
+Counter::Counter(char const * name) : m_name(name) { Registry::Instance().Add(*this); }
+
+// Histogram ---------------------------------------------------------------------------------------
+Histogram::Histogram(char const * name) : m_name(name)
+{
+  for (auto & bucket : m_buckets)
+    bucket.store(0, std::memory_order_relaxed);
+  Registry::Instance().Add(*this);
+}
+
+std::array<uint64_t, Histogram::kBucketsCount> Histogram::GetBuckets() const
+{
+  std::array<uint64_t, kBucketsCount> buckets;
+  for (size_t i = 0; i < kBucketsCount; ++i)
+    buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+  return buckets;
+}
+
+uint64_t Histogram::GetCount() const
+{
+  uint64_t count = 0;
+  for (auto const & bucket : m_buckets)
+    count += bucket.load(std::memory_order_relaxed);
+  return count;
+}
+
+void Histogram::Reset()
+{
+  for (auto & bucket : m_buckets)
+    bucket.store(0, std::memory_order_relaxed);
+  m_sum.store(0, std::memory_order_relaxed);
+}
+
+// Dumps -------------------------------------------------------------------------------------------
+std::vector<ZoneStats> GetZonesStats()
+{
+  std::map<std::string, Accumulator> accumulated;
+  Registry::Instance().ForEachBuffer([&accumulated](ThreadBuffer const & buffer) {
+    for (auto const & item : buffer.m_stats)
+    {
+      auto & a = accumulated[item.first];
+      a.m_count += item.second.m_count;
+      a.m_total += item.second.m_total;
+      a.m_max = std::max(a.m_max, item.second.m_max);
+    }
+  });
+
+  std::vector<ZoneStats> result;
+  for (auto const & item : accumulated)
+  {
+    ZoneStats stats;
+    stats.m_name = item.first;
+    stats.m_count = item.second.m_count;
+    stats.m_totalSeconds = static_cast<double>(item.second.m_total) * 1e-6;
+    stats.m_maxSeconds = static_cast<double>(item.second.m_max) * 1e-6;
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+uint64_t GetDroppedZonesCount()
+{
+  uint64_t dropped = 0;
+  Registry::Instance().ForEachBuffer(
+      [&dropped](ThreadBuffer const & buffer) { dropped += buffer.m_dropped; });
+  return dropped;
+}
+
+std::string DumpJson()
+{
+  std::ostringstream out;
+  out << "{\n  \"zones\": [";
+  bool first = true;
+  for (auto const & zone : GetZonesStats())
+  {
+    out << (first ? "\n" : ",\n") << "    {\"name\": \"" << Escape(zone.m_name.c_str())
+        << "\", \"count\": " << zone.m_count << ", \"total_seconds\": " << zone.m_totalSeconds
+        << ", \"max_seconds\": " << zone.m_maxSeconds << "}";
+    first = false;
+  }
+
+  out << "\n  ],\n  \"counters\": {";
+  first = true;
+  for (auto const * counter : Registry::Instance().GetCounters())
+  {
+    out << (first ? "\n" : ",\n") << "    \"" << Escape(counter->GetName())
+        << "\": " << counter->Get();
+    first = false;
+  }
+
+  out << "\n  },\n  \"histograms\": {";
+  first = true;
+  for (auto const * histogram : Registry::Instance().GetHistograms())
+  {
+    out << (first ? "\n" : ",\n") << "    \"" << Escape(histogram->GetName())
+        << "\": {\"count\": " << histogram->GetCount() << ", \"sum\": " << histogram->GetSum()
+        << ", \"buckets\": [";
+    auto const buckets = histogram->GetBuckets();
+    for (size_t i = 0; i < buckets.size(); ++i)
+      out << (i == 0 ? "" : ", ") << buckets[i];
+    out << "]}";
+    first = false;
+  }
+  out << "\n  },\n  \"dropped_zones\": " << GetDroppedZonesCount() << "\n}";
+  return out.str();
+}
+
+std::string DumpChromeTrace()
+{
+  std::ostringstream out;
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+  Registry::Instance().ForEachBuffer([&out, &first](ThreadBuffer const & buffer) {
+    for (auto const & event : buffer.m_events)
+    {
+      out << (first ? "\n" : ",\n") << "{\"name\": \"" << Escape(event.m_name)
+          << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer.m_id
+          << ", \"ts\": " << event.m_start << ", \"dur\": " << event.m_duration << "}";
+      first = false;
+    }
+  });
+
+  auto const now = internal::NowMicroseconds();
+  for (auto const * counter : Registry::Instance().GetCounters())
+  {
+    out << (first ? "\n" : ",\n") << "{\"name\": \"" << Escape(counter->GetName())
+        << "\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << now << ", \"args\": {\"value\": "
+        << counter->Get() << "}}";
+    first = false;
+  }
+  out << "\n]}";
+  return out.str();
+}
+
+void SaveChromeTrace(std::string const & filename)
+{
+  std::ofstream stream;
+  stream.exceptions(std::ios::failbit | std::ios::badbit);
+  stream.open(filename);
+  stream << DumpChromeTrace() << std::endl;
+}
+
+void Reset()
+{
+  Registry::Instance().ForEachBuffer([](ThreadBuffer & buffer) {
+    buffer.m_events.clear();
+    buffer.m_stats.clear();
+    buffer.m_dropped = 0;
+  });
+
+  for (auto * counter : Registry::Instance().GetCounters())
+    counter->Reset();
+  for (auto * histogram : Registry::Instance().GetHistograms())
+    histogram->Reset();
+}
+}  // namespace prof
+}  // namespace base
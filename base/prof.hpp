@@ -0,0 +1,174 @@
+#pragma once
+
+#include "base/macros.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// In-process profiling: the scoped zones, the counters and the histograms which are collected
+// in one timeline and are dumped as json or as the Chrome trace (chrome://tracing, Perfetto).
+// Everything is disabled by default and costs a relaxed atomic load then.
+//
+// Usage:
+//   base::prof::SetEnabled(true);
+//   {
+//     PROF_ZONE("decode");
+//     PROF_COUNTER_ADD("decoded elements", elements.size());
+//   }
+//   base::prof::SaveChromeTrace("trace.json");
+namespace base
+{
+namespace prof
+{
+namespace internal
+{
+extern std::atomic<bool> g_enabled;
+
+uint64_t NowMicroseconds();
+// Returns the stable copy of |name|.
+char const * Intern(std::string const & name);
+void RecordZone(char const * name, uint64_t startMicroseconds, uint64_t endMicroseconds);
+}  // namespace internal
+
+void SetEnabled(bool enabled);
+inline bool IsEnabled() { return internal::g_enabled.load(std::memory_order_relaxed); }
+
+// A named counter. The counters register themselves, so they should have the static
+// storage duration, see PROF_COUNTER_ADD.
+class Counter
+{
+public:
+  explicit Counter(char const * name);
+
+  void Add(uint64_t value = 1)
+  {
+    if (IsEnabled())
+      m_value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  char const * GetName() const { return m_name; }
+  uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+  void Reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+  char const * m_name;
+  std::atomic<uint64_t> m_value{0};
+
+  DISALLOW_COPY_AND_MOVE(Counter);
+};
+
+// A named histogram of the values in the power of two buckets: the bucket 0 is for zero,
+// the bucket i is for [2^(i-1), 2^i). Registers itself like Counter.
+class Histogram
+{
+public:
+  static size_t constexpr kBucketsCount = 65;
+
+  explicit Histogram(char const * name);
+
+  void Add(uint64_t value)
+  {
+    if (!IsEnabled())
+      return;
+
+    m_buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  static size_t GetBucket(uint64_t value)
+  {
+    return value == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(value));
+  }
+
+  char const * GetName() const { return m_name; }
+  std::array<uint64_t, kBucketsCount> GetBuckets() const;
+  uint64_t GetCount() const;
+  uint64_t GetSum() const { return m_sum.load(std::memory_order_relaxed); }
+  void Reset();
+
+private:
+  char const * m_name;
+  std::array<std::atomic<uint64_t>, kBucketsCount> m_buckets;
+  std::atomic<uint64_t> m_sum{0};
+
+  DISALLOW_COPY_AND_MOVE(Histogram);
+};
+
+// Records the time from the construction to the destruction to the buffer of the thread.
+// |name| should outlive the dumps, so it is a literal usually. The names which are built
+// at runtime are copied, but only when the profiling is enabled.
+class Zone
+{
+public:
+  explicit Zone(char const * name) : m_name(IsEnabled() ? name : nullptr)
+  {
+    if (m_name)
+      m_start = internal::NowMicroseconds();
+  }
+
+  explicit Zone(std::string const & name)
+    : m_name(IsEnabled() ? internal::Intern(name) : nullptr)
+  {
+    if (m_name)
+      m_start = internal::NowMicroseconds();
+  }
+
+  ~Zone()
+  {
+    if (m_name)
+      internal::RecordZone(m_name, m_start, internal::NowMicroseconds());
+  }
+
+private:
+  char const * m_name;
+  uint64_t m_start = 0;
+
+  DISALLOW_COPY_AND_MOVE(Zone);
+};
+
+struct ZoneStats
+{
+  std::string m_name;
+  uint64_t m_count = 0;
+  double m_totalSeconds = 0.0;
+  double m_maxSeconds = 0.0;
+};
+
+// The zones of all the threads accumulated by the names, sorted by the names.
+std::vector<ZoneStats> GetZonesStats();
+// The number of the zones which are not in the trace because the buffer of a thread was full.
+uint64_t GetDroppedZonesCount();
+
+// The zones stats, the counters and the histograms.
+std::string DumpJson();
+// The zones as the complete events and the counters of the Chrome trace event format.
+std::string DumpChromeTrace();
+// Throws std::ios_base::failure when the file can't be written.
+void SaveChromeTrace(std::string const & filename);
+
+// Removes the recorded zones and resets the counters and the histograms.
+void Reset();
+}  // namespace prof
+}  // namespace base
+
+#define PROF_CONCAT_IMPL(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_IMPL(a, b)
+
+#define PROF_ZONE(name) ::base::prof::Zone PROF_CONCAT(profZone, __LINE__)(name)
+
+#define PROF_COUNTER_ADD(name, value)               \
+  do                                                \
+  {                                                 \
+    static ::base::prof::Counter profCounter(name); \
+    profCounter.Add(value);                         \
+  } while (false)
+
+#define PROF_HISTOGRAM_ADD(name, value)                 \
+  do                                                    \
+  {                                                     \
+    static ::base::prof::Histogram profHistogram(name); \
+    profHistogram.Add(value);                           \
+  } while (false)
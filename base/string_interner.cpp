@@ -0,0 +1,65 @@
+#include "base/string_interner.hpp"
+
+#include "base/assert.hpp"
+
+namespace base
+{
+// static
+StringInterner::Id constexpr StringInterner::kInvalidId;
+
+StringInterner::StringInterner(StringInterner const & other) { *this = other; }
+
+StringInterner & StringInterner::operator=(StringInterner const & other)
+{
+  if (this == &other)
+    return *this;
+
+  std::unordered_map<std::string, Id> ids;
+  {
+    std::lock_guard<std::mutex> lock(other.m_mutex);
+    ids = other.m_ids;
+  }
+
+  std::vector<std::string const *> strings(ids.size());
+  for (auto const & p : ids)
+    strings[p.second] = &p.first;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ids.swap(ids);
+  m_strings.swap(strings);
+  return *this;
+}
+
+StringInterner::Id StringInterner::Intern(std::string const & s)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_ids.find(s);
+  if (it != m_ids.cend())
+    return it->second;
+
+  CHECK_LESS(m_strings.size(), static_cast<size_t>(kInvalidId), ());
+  auto const id = static_cast<Id>(m_strings.size());
+  m_strings.push_back(&m_ids.emplace(s, id).first->first);
+  return id;
+}
+
+StringInterner::Id StringInterner::Find(std::string const & s) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_ids.find(s);
+  return it == m_ids.cend() ? kInvalidId : it->second;
+}
+
+std::string const & StringInterner::Get(Id id) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CHECK_LESS(id, m_strings.size(), ());
+  return *m_strings[id];
+}
+
+size_t StringInterner::Size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_strings.size();
+}
+}  // namespace base
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace base
+{
+// Maps the strings to the dense 32-bit ids, so the equal strings are stored once and are
+// compared as integers. The ids and the strings are never removed, so a string returned by
+// Get() lives as long as the interner. Is thread-safe.
+class StringInterner
+{
+public:
+  using Id = uint32_t;
+
+  static Id constexpr kInvalidId = std::numeric_limits<Id>::max();
+
+  StringInterner() = default;
+  StringInterner(StringInterner const & other);
+  StringInterner & operator=(StringInterner const & other);
+
+  // Returns the id of |s|, adds |s| if it is not interned yet.
+  Id Intern(std::string const & s);
+  // Returns the id of |s| or kInvalidId if |s| is not interned.
+  Id Find(std::string const & s) const;
+  std::string const & Get(Id id) const;
+  size_t Size() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, Id> m_ids;
+  // The keys of |m_ids| by the ids.
+  std::vector<std::string const *> m_strings;
+};
+}  // namespace base
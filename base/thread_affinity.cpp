@@ -0,0 +1,222 @@
+#include "base/thread_affinity.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/macros.hpp"
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <utility>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace base
+{
+namespace threads
+{
+namespace
+{
+#if defined(__linux__)
+std::vector<size_t> GetAllowedCpus()
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  std::vector<size_t> cpus;
+  if (sched_getaffinity(0 /* pid */, sizeof(set), &set) != 0)
+    return cpus;
+
+  for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (CPU_ISSET(cpu, &set))
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::vector<std::vector<size_t>> ReadNumaNodesCpus(std::vector<size_t> const & allowed)
+{
+  std::string const nodesDir = "/sys/devices/system/node";
+  std::vector<std::pair<size_t, std::vector<size_t>>> nodes;
+  DIR * dir = opendir(nodesDir.c_str());
+  if (dir == nullptr)
+    return {};
+
+  while (auto const * entry = readdir(dir))
+  {
+    std::string const name = entry->d_name;
+    uint64_t node;
+    if (!strings::StartsWith(name, "node") || !strings::to_uint64(name.substr(4), node))
+      continue;
+
+    std::ifstream in(nodesDir + "/" + name + "/cpulist");
+    std::string list;
+    if (!std::getline(in, list))
+      continue;
+
+    std::vector<size_t> cpus;
+    for (auto const cpu : ParseCpuList(list))
+    {
+      if (std::binary_search(allowed.cbegin(), allowed.cend(), cpu))
+        cpus.push_back(cpu);
+    }
+    if (!cpus.empty())
+      nodes.emplace_back(static_cast<size_t>(node), std::move(cpus));
+  }
+  closedir(dir);
+
+  std::sort(nodes.begin(), nodes.end());
+  std::vector<std::vector<size_t>> result;
+  for (auto & node : nodes)
+    result.push_back(std::move(node.second));
+  return result;
+}
+
+bool SetCurrentThreadCpus(std::vector<size_t> const & cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto const cpu : cpus)
+    CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#endif
+
+std::vector<std::vector<size_t>> LoadNumaNodesCpus()
+{
+#if defined(__linux__)
+  auto const allowed = GetAllowedCpus();
+  auto nodes = ReadNumaNodesCpus(allowed);
+  if (nodes.empty() && !allowed.empty())
+    nodes.push_back(allowed);
+  return nodes;
+#else
+  return {};
+#endif
+}
+
+// The CPUs of the nodes in turn: the first CPU of every node, the second CPU of every node etc.
+std::vector<size_t> InterleaveNodes(std::vector<std::vector<size_t>> const & nodes)
+{
+  std::vector<size_t> cpus;
+  for (size_t i = 0;; ++i)
+  {
+    bool found = false;
+    for (auto const & node : nodes)
+    {
+      if (i < node.size())
+      {
+        cpus.push_back(node[i]);
+        found = true;
+      }
+    }
+    if (!found)
+      return cpus;
+  }
+}
+}  // namespace
+
+std::string DebugPrint(ThreadsAffinity affinity)
+{
+  switch (affinity)
+  {
+  case ThreadsAffinity::None: return "none";
+  case ThreadsAffinity::Cores: return "cores";
+  case ThreadsAffinity::Nodes: return "nodes";
+  }
+  UNREACHABLE();
+}
+
+bool FromString(std::string const & s, ThreadsAffinity & affinity)
+{
+  for (auto const a : {ThreadsAffinity::None, ThreadsAffinity::Cores, ThreadsAffinity::Nodes})
+  {
+    if (s == DebugPrint(a))
+    {
+      affinity = a;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<size_t> ParseCpuList(std::string const & s)
+{
+  std::string list = s;
+  strings::Trim(list);
+  std::vector<size_t> cpus;
+  bool ok = true;
+  strings::Tokenize(list, ",", [&](std::string const & range) {
+    auto const dash = range.find('-');
+    uint64_t first;
+    uint64_t last;
+    if (!strings::to_uint64(range.substr(0, dash), first))
+    {
+      ok = false;
+      return;
+    }
+    last = first;
+    if (dash != std::string::npos && !strings::to_uint64(range.substr(dash + 1), last))
+    {
+      ok = false;
+      return;
+    }
+    if (last < first)
+    {
+      ok = false;
+      return;
+    }
+    for (auto cpu = first; cpu <= last; ++cpu)
+      cpus.push_back(static_cast<size_t>(cpu));
+  });
+
+  if (!ok)
+    return {};
+  return cpus;
+}
+
+std::vector<std::vector<size_t>> GetNumaNodesCpus()
+{
+  // The topology does not change while the process runs.
+  static auto const nodes = LoadNumaNodesCpus();
+  return nodes;
+}
+
+bool SetCurrentThreadAffinity(ThreadsAffinity affinity, size_t threadIndex)
+{
+  if (affinity == ThreadsAffinity::None)
+    return false;
+
+#if defined(__linux__)
+  auto const nodes = GetNumaNodesCpus();
+  if (nodes.empty())
+    return false;
+
+  std::vector<size_t> cpus;
+  if (affinity == ThreadsAffinity::Nodes)
+  {
+    cpus = nodes[threadIndex % nodes.size()];
+  }
+  else
+  {
+    auto const all = InterleaveNodes(nodes);
+    cpus.push_back(all[threadIndex % all.size()]);
+  }
+
+  if (SetCurrentThreadCpus(cpus))
+    return true;
+
+  LOG(LWARNING, ("Failed to set the affinity", affinity, "of the thread", threadIndex));
+  return false;
+#else
+  UNUSED_VALUE(threadIndex);
+  return false;
+#endif
+}
+}  // namespace threads
+}  // namespace base
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace base
+{
+namespace threads
+{
+// How the worker threads are bound to the CPUs.
+enum class ThreadsAffinity
+{
+  // The threads migrate freely.
+  None,
+  // The i-th thread is bound to a single CPU, the CPUs are taken from the NUMA nodes in turn.
+  Cores,
+  // The i-th thread is bound to all the CPUs of a NUMA node, the nodes are taken in turn.
+  Nodes
+};
+
+std::string DebugPrint(ThreadsAffinity affinity);
+
+// Parses "none", "cores" and "nodes". Returns false for the other strings.
+bool FromString(std::string const & s, ThreadsAffinity & affinity);
+
+// Parses the "0-3,8,10-11" lists of the CPUs of the kernel.
+// Returns an empty vector if |s| is malformed.
+std::vector<size_t> ParseCpuList(std::string const & s);
+
+// Returns the CPUs of the NUMA nodes which are allowed for the process.
+// There is a single node with all the allowed CPUs when the nodes are unknown.
+std::vector<std::vector<size_t>> GetNumaNodesCpus();
+
+// Binds the calling thread, which is the |threadIndex|-th worker of a pool,
+// according to |affinity|. Memory allocated and first touched by a bound thread is placed
+// on its NUMA node by the kernel. Returns false if the thread is not bound.
+bool SetCurrentThreadAffinity(ThreadsAffinity affinity, size_t threadIndex);
+}  // namespace threads
+}  // namespace base
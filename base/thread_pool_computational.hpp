@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base/assert.hpp"
+#include "base/thread_affinity.hpp"
 #include "base/thread_utils.hpp"
 
 #include <atomic>
@@ -31,8 +32,10 @@ public:
 
   // Constructs a ThreadPool.
   // threadCount - number of threads used by the thread pool.
+  // affinity - binding of the i-th thread to the CPUs, see SetCurrentThreadAffinity().
   // Warning: The constructor may throw exceptions.
-  ThreadPool(size_t threadCount) : m_done(false), m_joiner(m_threads)
+  ThreadPool(size_t threadCount, ThreadsAffinity affinity = ThreadsAffinity::None)
+    : m_done(false), m_joiner(m_threads)
   {
     CHECK_GREATER(threadCount, 0, ());
 
@@ -40,7 +43,7 @@ public:
     try
     {
       for (size_t i = 0; i < threadCount; i++)
-        m_threads.emplace_back(&ThreadPool::Worker, this);
+        m_threads.emplace_back(&ThreadPool::Worker, this, affinity, i);
     }
     catch (...)  // std::system_error etc.
     {
@@ -147,8 +150,9 @@ public:
   unsigned int Size() const noexcept { return static_cast<unsigned int>(m_threads.size()); }
 
 private:
-  void Worker()
+  void Worker(ThreadsAffinity affinity, size_t index)
   {
+    SetCurrentThreadAffinity(affinity, index);
     while (true)
     {
       FunctionType task;
@@ -0,0 +1,416 @@
+#pragma once
+
+#include "base/assert.hpp"
+#include "base/thread_affinity.hpp"
+#include "base/thread_utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace base
+{
+using namespace threads;
+namespace thread_pool
+{
+namespace work_stealing
+{
+// ThreadPool with the same interface as computational::ThreadPool which is suitable
+// for huge numbers of small tasks.
+// Every worker has its own deque of tasks. The tasks submitted by a worker are pushed
+// to its deque and are taken by it in the LIFO order, the tasks submitted by the other
+// threads are distributed among the deques. An idle worker steals the oldest tasks
+// from the deques of the other workers. So there is no lock which is shared by all the
+// workers and all the submitting threads.
+// When the destructor is called, all the submitted tasks are completed and all threads join.
+// Warning: ThreadPool works with std::thread instead of SimpleThread and therefore
+// should not be used when the JVM is needed.
+class ThreadPool
+{
+public:
+  using FunctionType = FunctionWrapper;
+  using Threads = std::vector<std::thread>;
+
+  // Constructs a ThreadPool.
+  // threadCount - number of threads used by the thread pool.
+  // affinity - binding of the i-th thread to the CPUs, see SetCurrentThreadAffinity().
+  // Warning: The constructor may throw exceptions.
+  explicit ThreadPool(size_t threadCount, ThreadsAffinity affinity = ThreadsAffinity::None)
+    : m_queues(threadCount), m_joiner(m_threads)
+  {
+    CHECK_GREATER(threadCount, 0, ());
+
+    m_threads.reserve(threadCount);
+    try
+    {
+      for (size_t i = 0; i < threadCount; i++)
+        m_threads.emplace_back(&ThreadPool::Worker, this, affinity, i);
+    }
+    catch (...)  // std::system_error etc.
+    {
+      Stop();
+      throw;
+    }
+  }
+
+  // Destroys the ThreadPool.
+  // This function will block until all runnables have been completed.
+  ~ThreadPool()
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done = true;
+    }
+    m_condition.notify_all();
+  }
+
+  // Submit task for execution.
+  // func - task to be performed.
+  // args - arguments for func.
+  // The function will return the object future.
+  // Warning: If the thread pool is stopped then the call will be ignored.
+  template <typename F, typename... Args>
+  auto Submit(F && func, Args &&... args) -> std::future<decltype(func(args...))>
+  {
+    using ResultType = decltype(func(args...));
+    std::packaged_task<ResultType()> task(std::bind(std::forward<F>(func),
+                                                    std::forward<Args>(args)...));
+    std::future<ResultType> result(task.get_future());
+    FunctionType wrapper(std::move(task));
+    if (!Push(wrapper))
+      return {};
+    return result;
+  }
+
+  // Submit work for execution. Unlike Submit() it does not create the future
+  // and the packaged task, func is stored in the queue as is.
+  // func - task to be performed.
+  // Warning: If the thread pool is stopped then the call will be ignored.
+  template <typename F>
+  void SubmitWork(F && func)
+  {
+    std::decay_t<F> f(std::forward<F>(func));
+    FunctionType wrapper(std::move(f));
+    Push(wrapper);
+  }
+
+  // Submit work for execution.
+  // func - task to be performed.
+  // args - arguments for func
+  // Warning: If the thread pool is stopped then the call will be ignored.
+  template <typename F, typename Arg, typename... Args>
+  void SubmitWork(F && func, Arg && arg, Args &&... args)
+  {
+    SubmitWork(std::bind(std::forward<F>(func), std::forward<Arg>(arg),
+                         std::forward<Args>(args)...));
+  }
+
+  // Submit min(|workersCountHint|, Size()) tasks and wait completions.
+  // func - task to be performed.
+  // Warning: If the thread pool is stopped then the call will be ignored.
+  template <typename F>
+  void PerformParallelWorks(F && func, size_t workersCountHint)
+  {
+    size_t const workersCount = std::min(std::max(size_t{1}, workersCountHint),
+                                         static_cast<size_t>(Size()));
+
+    std::vector<std::future<void>> workers{};
+    workers.reserve(workersCount);
+    for (size_t i = 0; i < workersCount; ++i)
+      workers.push_back(Submit(func));
+
+    for (auto & worker : workers)
+    {
+      if (worker.valid())
+        worker.wait();
+    }
+  }
+
+  // Calls |fn(i)| for each i in [begin, end) on the workers and waits the completion.
+  // The range is split into the tasks of |grain| indices. May be called from the tasks
+  // of this pool: the waiting thread runs the pending tasks meanwhile.
+  template <typename Fn>
+  void ParallelFor(size_t begin, size_t end, size_t grain, Fn && fn);
+
+  // Runs a pending task on the calling thread.
+  // Returns false if there are no pending tasks.
+  bool RunPendingTask()
+  {
+    FunctionType task;
+    if (!Pop(GetWorkerIndex(), task))
+      return false;
+
+    task();
+    return true;
+  }
+
+  // Stop a ThreadPool.
+  // Removes the tasks that are not yet started from the queues.
+  // Unlike the destructor, this function does not wait for all runnables to complete:
+  // the tasks will stop as soon as possible.
+  void Stop()
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done = true;
+      for (auto & queue : m_queues)
+      {
+        std::lock_guard<std::mutex> queueLock(queue.m_mutex);
+        m_pending -= queue.m_tasks.size();
+        queue.m_tasks.clear();
+      }
+    }
+    m_condition.notify_all();
+  }
+
+  void WaitingStop()
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done = true;
+    }
+    m_condition.notify_all();
+    m_joiner.Join();
+  }
+
+  unsigned int Size() const noexcept { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+  friend class TaskGroup;
+
+  struct Queue
+  {
+    std::mutex m_mutex;
+    std::deque<FunctionType> m_tasks;
+  };
+
+  struct WorkerInfo
+  {
+    ThreadPool const * m_pool = nullptr;
+    size_t m_index = 0;
+  };
+
+  static WorkerInfo & GetWorkerInfo()
+  {
+    static thread_local WorkerInfo info;
+    return info;
+  }
+
+  // Returns the index of the worker of the calling thread
+  // or Size() if the calling thread is not a worker of this pool.
+  size_t GetWorkerIndex() const
+  {
+    auto const & info = GetWorkerInfo();
+    return info.m_pool == this ? info.m_index : m_queues.size();
+  }
+
+  // Moves |task| to a queue. Returns false and leaves |task| intact if the pool is stopped.
+  bool Push(FunctionType & task)
+  {
+    if (m_done)
+      return false;
+
+    size_t index = GetWorkerIndex();
+    if (index == m_queues.size())
+      index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    // |m_pending| is increased first so it never underflows when the task is taken at once.
+    m_pending.fetch_add(1);
+    {
+      std::lock_guard<std::mutex> lock(m_queues[index].m_mutex);
+      m_queues[index].m_tasks.push_back(std::move(task));
+    }
+
+    if (m_sleeping.load() != 0)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_condition.notify_one();
+    }
+    return true;
+  }
+
+  // Takes the newest task of the own queue of the worker |index| or steals
+  // the oldest task of another queue.
+  bool Pop(size_t index, FunctionType & task)
+  {
+    if (m_pending.load() == 0)
+      return false;
+
+    if (index < m_queues.size())
+    {
+      auto & queue = m_queues[index];
+      std::lock_guard<std::mutex> lock(queue.m_mutex);
+      if (!queue.m_tasks.empty())
+      {
+        task = std::move(queue.m_tasks.back());
+        queue.m_tasks.pop_back();
+        --m_pending;
+        return true;
+      }
+    }
+
+    for (size_t i = 1; i <= m_queues.size(); ++i)
+    {
+      auto & queue = m_queues[(index + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.m_mutex);
+      if (!queue.m_tasks.empty())
+      {
+        task = std::move(queue.m_tasks.front());
+        queue.m_tasks.pop_front();
+        --m_pending;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Worker(ThreadsAffinity affinity, size_t index)
+  {
+    SetCurrentThreadAffinity(affinity, index);
+    auto & info = GetWorkerInfo();
+    info.m_pool = this;
+    info.m_index = index;
+
+    while (true)
+    {
+      FunctionType task;
+      if (Pop(index, task))
+      {
+        task();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      ++m_sleeping;
+      m_condition.wait(lock, [&] { return m_done || m_pending.load() != 0; });
+      --m_sleeping;
+
+      if (m_done && m_pending.load() == 0)
+        return;
+    }
+  }
+
+  std::atomic<bool> m_done{false};
+  std::vector<Queue> m_queues;
+  std::atomic<size_t> m_nextQueue{0};
+  // The number of the tasks in the queues.
+  std::atomic<size_t> m_pending{0};
+  // The number of the workers which wait on |m_condition|.
+  std::atomic<size_t> m_sleeping{0};
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  Threads m_threads;
+  ThreadsJoiner<> m_joiner;
+};
+
+// TaskGroup runs the tasks on the ThreadPool and waits for all of them without the futures.
+// The first exception thrown by the tasks is rethrown by Wait().
+class TaskGroup
+{
+public:
+  explicit TaskGroup(ThreadPool & pool) : m_pool(pool) {}
+
+  ~TaskGroup()
+  {
+    try
+    {
+      Wait();
+    }
+    catch (...)
+    {
+    }
+  }
+
+  template <typename Fn>
+  void Run(Fn && fn)
+  {
+    ++m_running;
+    ThreadPool::FunctionType task([this, fn = std::forward<Fn>(fn)]() mutable {
+      try
+      {
+        fn();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_error)
+          m_error = std::current_exception();
+      }
+      Done();
+    });
+
+    // The stopped pool does not accept the tasks, so they are run in place.
+    if (!m_pool.Push(task))
+      task();
+  }
+
+  // Waits for all the tasks run by this group. The calling thread runs the pending tasks
+  // of the pool meanwhile, so Wait() may be called from the tasks of the pool.
+  void Wait()
+  {
+    while (m_running.load() != 0)
+    {
+      if (m_pool.RunPendingTask())
+        continue;
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait_for(lock, std::chrono::milliseconds(1),
+                           [this] { return m_running.load() == 0; });
+    }
+
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      std::swap(error, m_error);
+    }
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+private:
+  void Done()
+  {
+    if (--m_running == 0)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_condition.notify_all();
+    }
+  }
+
+  ThreadPool & m_pool;
+  std::atomic<size_t> m_running{0};
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::exception_ptr m_error;
+};
+
+template <typename Fn>
+void ThreadPool::ParallelFor(size_t begin, size_t end, size_t grain, Fn && fn)
+{
+  CHECK_GREATER(grain, 0, ());
+
+  TaskGroup group(*this);
+  for (size_t first = begin; first < end; first += std::min(grain, end - first))
+  {
+    size_t const last = first + std::min(grain, end - first);
+    group.Run([&fn, first, last]() {
+      for (size_t i = first; i < last; ++i)
+        fn(i);
+    });
+  }
+  group.Wait();
+}
+}  // namespace work_stealing
+}  // namespace thread_pool
+}  // namespace base
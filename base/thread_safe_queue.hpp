@@ -1,6 +1,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <cstddef>
 #include <mutex>
 #include <queue>
 #include <utility>
@@ -31,21 +32,26 @@ private:
   bool m_isEmpty;
 };
 
+// A queue with |maxSize| > 0 is bounded: Push() waits until there is room for the value,
+// so fast producers are throttled by slow consumers.
 template <typename T>
 class ThreadSafeQueue
 {
 public:
   ThreadSafeQueue() = default;
+  explicit ThreadSafeQueue(size_t maxSize) : m_maxSize(maxSize) {}
   ThreadSafeQueue(ThreadSafeQueue const & other)
   {
     std::lock_guard<std::mutex> lk(other.m_mutex);
     m_queue = other.m_queue;
+    m_maxSize = other.m_maxSize;
   }
 
   void Push(T const & value)
   {
     {
-      std::lock_guard<std::mutex> lk(m_mutex);
+      std::unique_lock<std::mutex> lk(m_mutex);
+      WaitForRoom(lk);
       m_queue.push(value);
     }
     m_cond.notify_one();
@@ -54,7 +60,8 @@ public:
   void Push(T && value)
   {
     {
-      std::lock_guard<std::mutex> lk(m_mutex);
+      std::unique_lock<std::mutex> lk(m_mutex);
+      WaitForRoom(lk);
       m_queue.push(std::move(value));
     }
     m_cond.notify_one();
@@ -62,22 +69,27 @@ public:
 
   void WaitAndPop(T & value)
   {
-    std::unique_lock<std::mutex> lk(m_mutex);
-    m_cond.wait(lk, [this]{ return !m_queue.empty(); });
-    value = std::move(m_queue.front());
-    m_queue.pop();
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_cond.wait(lk, [this]{ return !m_queue.empty(); });
+      value = std::move(m_queue.front());
+      m_queue.pop();
+    }
+    m_notFullCond.notify_one();
   }
 
   bool TryPop(T & value)
   {
-    std::lock_guard<std::mutex> lk(m_mutex);
-    if (m_queue.empty())
-      return false;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_queue.empty())
+        return false;
 
-    value = std::move(m_queue.front());
-    m_queue.pop();
+      value = std::move(m_queue.front());
+      m_queue.pop();
+    }
+    m_notFullCond.notify_one();
     return true;
-
   }
 
   bool Empty() const
@@ -92,10 +104,21 @@ public:
     return m_queue.size();
   }
 
+  size_t GetMaxSize() const { return m_maxSize; }
+
 private:
+  void WaitForRoom(std::unique_lock<std::mutex> & lk)
+  {
+    if (m_maxSize != 0)
+      m_notFullCond.wait(lk, [this]{ return m_queue.size() < m_maxSize; });
+  }
+
   mutable std::mutex m_mutex;
   std::queue<T> m_queue;
   std::condition_variable m_cond;
+  std::condition_variable m_notFullCond;
+  // Zero is an unbounded queue.
+  size_t m_maxSize = 0;
 };
 }  // namespace threads
 }  // namespace base
@@ -0,0 +1,180 @@
+#include "coding/async_buffered_file_writer.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <utility>
+
+// static
+size_t constexpr AsyncBufferedFileWriter::kDefaultBufferSize;
+
+AsyncBufferedFileWriter::AsyncBufferedFileWriter(std::string const & fileName,
+                                                 Op operation /* = OP_WRITE_TRUNCATE */,
+                                                 size_t bufferSize /* = kDefaultBufferSize */,
+                                                 size_t buffersCount /* = 2 */)
+  : FileWriter(fileName, operation)
+  , m_bufferSize(bufferSize)
+  , m_pos(FileWriter::Pos())
+{
+  CHECK_GREATER(bufferSize, 0, ());
+  CHECK_GREATER_OR_EQUAL(buffersCount, 2, ());
+
+  m_buf.reserve(m_bufferSize);
+  m_free.resize(buffersCount - 1);
+  for (auto & buffer : m_free)
+    buffer.reserve(m_bufferSize);
+
+  m_thread = std::thread(&AsyncBufferedFileWriter::WriteBuffers, this);
+}
+
+AsyncBufferedFileWriter::~AsyncBufferedFileWriter()
+{
+  try
+  {
+    SubmitBuffer();
+    WaitForWrites();
+  }
+  catch (std::exception const & e)
+  {
+    LOG(LERROR, ("Could not write", GetName(), ":", e.what()));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+void AsyncBufferedFileWriter::Seek(uint64_t pos)
+{
+  SubmitBuffer();
+  WaitForWrites();
+  FileWriter::Seek(pos);
+  m_pos = pos;
+}
+
+uint64_t AsyncBufferedFileWriter::Pos() const
+{
+  return m_pos + m_buf.size();
+}
+
+void AsyncBufferedFileWriter::Write(void const * p, size_t size)
+{
+  ThrowIfFailed();
+
+  auto src = static_cast<uint8_t const *>(p);
+  while (size != 0)
+  {
+    auto const copyCount = std::min(size, m_bufferSize - m_buf.size());
+    m_buf.insert(m_buf.end(), src, src + copyCount);
+    src += copyCount;
+    size -= copyCount;
+
+    if (m_buf.size() == m_bufferSize)
+      SubmitBuffer();
+  }
+}
+
+uint64_t AsyncBufferedFileWriter::Size() const
+{
+  WaitForWrites();
+  return std::max(FileWriter::Size(), Pos());
+}
+
+void AsyncBufferedFileWriter::Flush()
+{
+  SubmitBuffer();
+  WaitForWrites();
+  FileWriter::Flush();
+}
+
+AsyncBufferedFileWriter::Stats AsyncBufferedFileWriter::GetStats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void AsyncBufferedFileWriter::SubmitBuffer()
+{
+  if (m_buf.empty())
+    return;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_pos += m_buf.size();
+  m_pending.push_back(std::move(m_buf));
+  m_cv.notify_all();
+
+  if (m_free.empty())
+  {
+    auto const start = std::chrono::steady_clock::now();
+    m_cv.wait(lock, [this]() { return !m_free.empty(); });
+    m_stats.m_stallTime += std::chrono::steady_clock::now() - start;
+  }
+  m_buf = std::move(m_free.back());
+  m_free.pop_back();
+}
+
+void AsyncBufferedFileWriter::WaitForWrites() const
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_pending.empty() || m_writing)
+    {
+      auto const start = std::chrono::steady_clock::now();
+      m_cv.wait(lock, [this]() { return m_pending.empty() && !m_writing; });
+      m_stats.m_stallTime += std::chrono::steady_clock::now() - start;
+    }
+  }
+  ThrowIfFailed();
+}
+
+void AsyncBufferedFileWriter::ThrowIfFailed() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_error)
+    std::rethrow_exception(m_error);
+}
+
+void AsyncBufferedFileWriter::WriteBuffers()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_cv.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+    if (m_pending.empty())
+      return;
+
+    auto buffer = std::move(m_pending.front());
+    m_pending.pop_front();
+    m_writing = true;
+    bool const failed = static_cast<bool>(m_error);
+    lock.unlock();
+
+    // The data submitted after a failure is dropped.
+    std::exception_ptr error;
+    if (!failed)
+    {
+      try
+      {
+        FileWriter::Write(buffer.data(), buffer.size());
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+    }
+
+    lock.lock();
+    if (error)
+      m_error = error;
+    else if (!failed)
+      m_stats.m_bytesWritten += buffer.size();
+    buffer.clear();
+    m_free.push_back(std::move(buffer));
+    m_writing = false;
+    m_cv.notify_all();
+  }
+}
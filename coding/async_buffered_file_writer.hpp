@@ -0,0 +1,75 @@
+#pragma once
+
+#include "coding/file_writer.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Buffered file writer which writes the filled buffers to the file on a background thread,
+// so the producer blocks only when all the buffers are waiting to be written.
+// Not thread safe: the writer must be used by one producer thread.
+// The errors of the background writes are rethrown by the next Write(), Seek() or Flush().
+class AsyncBufferedFileWriter : public FileWriter
+{
+public:
+  static size_t constexpr kDefaultBufferSize = 4 * 1024 * 1024;
+
+  struct Stats
+  {
+    // The number of bytes written to the file by the background thread.
+    uint64_t m_bytesWritten = 0;
+    // The time the producer waited for a free buffer or for the background writes.
+    std::chrono::steady_clock::duration m_stallTime{};
+  };
+
+  explicit AsyncBufferedFileWriter(std::string const & fileName,
+                                   Op operation = OP_WRITE_TRUNCATE,
+                                   size_t bufferSize = kDefaultBufferSize,
+                                   size_t buffersCount = 2);
+
+  // Writer overrides:
+  ~AsyncBufferedFileWriter() override;
+  void Seek(uint64_t pos) override;
+  uint64_t Pos() const override;
+  void Write(void const * p, size_t size) override;
+
+  // FileWriter overrides:
+  uint64_t Size() const override;
+  // A barrier: returns when all the data written before is written to the file.
+  void Flush() override;
+
+  Stats GetStats() const;
+
+private:
+  // Hands the current buffer to the background thread and takes a free one.
+  void SubmitBuffer();
+  // Waits for the background thread to write all the submitted buffers.
+  void WaitForWrites() const;
+  void ThrowIfFailed() const;
+  void WriteBuffers();
+
+  std::vector<uint8_t> m_buf;
+  size_t const m_bufferSize;
+  // The position of the beginning of |m_buf| in the file.
+  uint64_t m_pos;
+
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_cv;
+  // The buffers to be written in the order of submission.
+  std::deque<std::vector<uint8_t>> m_pending;
+  std::vector<std::vector<uint8_t>> m_free;
+  bool m_writing = false;
+  bool m_stop = false;
+  std::exception_ptr m_error;
+  mutable Stats m_stats;
+
+  std::thread m_thread;
+};
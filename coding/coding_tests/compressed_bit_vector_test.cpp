@@ -471,3 +471,138 @@ UNIT_TEST(CompressedBitVector_SparseLeaveFirstNBits)
   for (uint64_t bit = 0; bit < (1 << 10); ++bit)
     TEST(!cbv->GetBit(bit), (bit));
 }
+
+UNIT_TEST(CompressedBitVector_DenseRankSelect)
+{
+  vector<uint64_t> setBits;
+  for (uint64_t i = 0; i < 5000; ++i)
+  {
+    if (i % 3 == 0 || i % 7 == 0 || (i >= 1000 && i < 1100))
+      setBits.push_back(i);
+  }
+  coding::DenseCBV const dense(setBits);
+  auto const cbv = coding::DenseCBV::BuildFromBitGroups(vector<uint64_t>(dense.GetBitGroups()));
+  TEST_EQUAL(cbv->PopCount(), setBits.size(), ());
+
+  for (size_t i = 0; i < setBits.size(); ++i)
+  {
+    TEST_EQUAL(dense.Select(i), setBits[i], (i));
+    TEST_EQUAL(cbv->Select(i), setBits[i], (i));
+    TEST_EQUAL(cbv->Rank(setBits[i]), i, (i));
+    TEST_EQUAL(cbv->Rank(setBits[i] + 1), i + 1, (i));
+  }
+  TEST_EQUAL(cbv->Rank(0), 0, ());
+  TEST_EQUAL(cbv->Rank(1000000), setBits.size(), ());
+}
+
+UNIT_TEST(CompressedBitVector_GallopingOps)
+{
+  vector<uint64_t> setBits1;
+  for (uint64_t i = 0; i < 100; ++i)
+    setBits1.push_back(i * 1000 + 1);
+  vector<uint64_t> setBits2;
+  for (uint64_t i = 0; i < 100000; i += 5)
+    setBits2.push_back(i * 3 + 1);
+
+  auto const cbv1 = coding::CompressedBitVectorBuilder::FromBitPositions(setBits1);
+  auto const cbv2 = coding::CompressedBitVectorBuilder::FromBitPositions(setBits2);
+  TEST_EQUAL(coding::CompressedBitVector::StorageStrategy::Sparse, cbv1->GetStorageStrategy(), ());
+  TEST_EQUAL(coding::CompressedBitVector::StorageStrategy::Sparse, cbv2->GetStorageStrategy(), ());
+
+  auto const cbv12 = coding::CompressedBitVector::Intersect(*cbv1, *cbv2);
+  auto const cbv21 = coding::CompressedBitVector::Intersect(*cbv2, *cbv1);
+  TEST(cbv12.get(), ());
+  TEST(cbv21.get(), ());
+  TEST_GREATER(cbv12->PopCount(), 0, ());
+  CheckIntersection(setBits1, setBits2, *cbv12);
+  CheckIntersection(setBits1, setBits2, *cbv21);
+
+  auto const cbv3 = coding::CompressedBitVector::Subtract(*cbv1, *cbv2);
+  TEST(cbv3.get(), ());
+  CheckSubtraction(setBits1, setBits2, *cbv3);
+}
+
+UNIT_TEST(CompressedBitVector_Views)
+{
+  using coding::CompressedBitVector;
+  using coding::CompressedBitVectorBuilder;
+  using coding::CompressedBitVectorView;
+
+  vector<vector<uint64_t>> setBits(4);
+  for (uint64_t i = 0; i < 1000; ++i)
+  {
+    setBits[0].push_back(i * 2);
+    if (i % 3 != 0)
+      setBits[1].push_back(i);
+  }
+  for (uint64_t i = 0; i < 100; ++i)
+    setBits[2].push_back(i * 37 + 1);
+  for (uint64_t i = 0; i < 10000; ++i)
+    setBits[3].push_back(i * 5);
+
+  // The bit vectors are serialized one after another, so most of them are not aligned.
+  vector<uint8_t> buf;
+  vector<size_t> offsets;
+  vector<unique_ptr<CompressedBitVector>> cbvs;
+  {
+    MemWriter<vector<uint8_t>> writer(buf);
+    for (auto const & bits : setBits)
+    {
+      offsets.push_back(buf.size());
+      cbvs.push_back(CompressedBitVectorBuilder::FromBitPositions(bits));
+      cbvs.back()->Serialize(writer);
+    }
+  }
+  offsets.push_back(buf.size());
+  TEST_EQUAL(cbvs[0]->GetStorageStrategy(), CompressedBitVector::StorageStrategy::Dense, ());
+  TEST_EQUAL(cbvs[1]->GetStorageStrategy(), CompressedBitVector::StorageStrategy::Dense, ());
+  TEST_EQUAL(cbvs[2]->GetStorageStrategy(), CompressedBitVector::StorageStrategy::Sparse, ());
+  TEST_EQUAL(cbvs[3]->GetStorageStrategy(), CompressedBitVector::StorageStrategy::Sparse, ());
+
+  vector<CompressedBitVectorView> views(setBits.size());
+  for (size_t i = 0; i < views.size(); ++i)
+  {
+    TEST(CompressedBitVectorBuilder::DeserializeView(buf.data() + offsets[i],
+                                                     offsets[i + 1] - offsets[i], views[i]),
+         (i));
+    auto const & view = views[i];
+    TEST_EQUAL(view.GetStorageStrategy(), cbvs[i]->GetStorageStrategy(), (i));
+    TEST_EQUAL(view.PopCount(), setBits[i].size(), (i));
+    for (uint64_t pos = 0; pos < 200; ++pos)
+      TEST_EQUAL(view.GetBit(pos), cbvs[i]->GetBit(pos), (i, pos));
+
+    vector<uint64_t> positions;
+    view.ForEach([&positions](uint64_t pos) { positions.push_back(pos); });
+    TEST_EQUAL(positions, setBits[i], (i));
+
+    auto const clone = view.Clone();
+    TEST_EQUAL(clone->GetStorageStrategy(), cbvs[i]->GetStorageStrategy(), (i));
+    TEST_EQUAL(clone->PopCount(), setBits[i].size(), (i));
+    for (auto const pos : setBits[i])
+      TEST(clone->GetBit(pos), (i, pos));
+  }
+
+  for (size_t i = 0; i < views.size(); ++i)
+  {
+    for (size_t j = 0; j < views.size(); ++j)
+    {
+      auto const expected = CompressedBitVector::Intersect(*cbvs[i], *cbvs[j]);
+      auto const fromViews = CompressedBitVectorView::Intersect(views[i], views[j]);
+      auto const fromMixed = CompressedBitVectorView::Intersect(*cbvs[i], views[j]);
+      TEST_EQUAL(fromViews->GetStorageStrategy(), expected->GetStorageStrategy(), (i, j));
+      TEST_EQUAL(fromMixed->GetStorageStrategy(), expected->GetStorageStrategy(), (i, j));
+      CheckIntersection(setBits[i], setBits[j], *fromViews);
+      CheckIntersection(setBits[i], setBits[j], *fromMixed);
+    }
+  }
+
+  // Malformed data is not viewed.
+  CompressedBitVectorView view;
+  TEST(!CompressedBitVectorBuilder::DeserializeView(buf.data(), 0, view), ());
+  TEST(!CompressedBitVectorBuilder::DeserializeView(buf.data(), offsets[1] - 1, view), ());
+  uint8_t const unknownStrategy[] = {2, 0};
+  TEST(!CompressedBitVectorBuilder::DeserializeView(unknownStrategy, sizeof(unknownStrategy),
+                                                    view),
+       ());
+  TEST_EQUAL(view.PopCount(), 0, ());
+}
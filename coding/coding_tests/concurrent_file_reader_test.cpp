@@ -0,0 +1,94 @@
+#include "testing/testing.hpp"
+
+#include "coding/concurrent_file_reader.hpp"
+#include "coding/file_writer.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+string const kFileName = "concurrent_file_reader_test_tmp.dat";
+
+vector<uint8_t> WriteTestFile(size_t size)
+{
+  vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<uint8_t>((i * 31) ^ (i >> 8));
+
+  FileWriter writer(kFileName);
+  writer.Write(data.data(), data.size());
+  return data;
+}
+}  // namespace
+
+UNIT_TEST(ConcurrentFileReader_Smoke)
+{
+  // Not a multiple of the page size to read the short last page.
+  auto const data = WriteTestFile(100 * 1000 + 7);
+  {
+    ConcurrentPageCache cache(8 /* logPageSize */, 16 /* pagesCount */, 4 /* shardsCount */);
+    ConcurrentFileReader reader(kFileName, cache);
+    TEST_EQUAL(reader.Size(), data.size(), ());
+
+    vector<uint8_t> buffer(data.size());
+    reader.Read(0, buffer.data(), buffer.size());
+    TEST_EQUAL(buffer, data, ());
+
+    auto const subReader = reader.SubReader(1000, 50 * 1000);
+    vector<uint8_t> chunk(300);
+    subReader.Read(90, chunk.data(), chunk.size());
+    TEST(equal(chunk.begin(), chunk.end(), data.begin() + 1090), ());
+    subReader.Read(90, chunk.data(), chunk.size());
+    TEST(equal(chunk.begin(), chunk.end(), data.begin() + 1090), ());
+
+    reader.Read(data.size() - 3, chunk.data(), 3);
+    TEST(equal(chunk.begin(), chunk.begin() + 3, data.end() - 3), ());
+
+    auto const stats = cache.GetStats();
+    TEST_GREATER(stats.m_hits, 0, ());
+    TEST_GREATER(stats.m_misses, 0, ());
+
+    TEST_ANY_THROW(subReader.Read(50 * 1000 - 1, chunk.data(), 2), ());
+  }
+  FileWriter::DeleteFileX(kFileName);
+}
+
+UNIT_TEST(ConcurrentFileReader_Threads)
+{
+  auto const data = WriteTestFile(1000 * 1000);
+  {
+    ConcurrentPageCache cache(10 /* logPageSize */, 64 /* pagesCount */, 8 /* shardsCount */);
+    ConcurrentFileReader const reader(kFileName, cache);
+
+    vector<thread> threads;
+    vector<size_t> errors(8);
+    for (size_t t = 0; t < errors.size(); ++t)
+    {
+      threads.emplace_back([&, t]() {
+        mt19937 rng(static_cast<uint32_t>(t));
+        uniform_int_distribution<size_t> positions(0, data.size() - 5000);
+        uniform_int_distribution<size_t> sizes(0, 5000);
+        vector<uint8_t> buffer;
+        for (size_t i = 0; i < 2000; ++i)
+        {
+          auto const pos = positions(rng);
+          buffer.resize(sizes(rng));
+          reader.Read(pos, buffer.data(), buffer.size());
+          if (!equal(buffer.begin(), buffer.end(), data.begin() + pos))
+            ++errors[t];
+        }
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+
+    TEST_EQUAL(errors, vector<size_t>(errors.size(), 0), ());
+  }
+  FileWriter::DeleteFileX(kFileName);
+}
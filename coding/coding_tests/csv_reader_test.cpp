@@ -5,6 +5,8 @@
 
 #include "platform/platform_tests_support/scoped_file.hpp"
 
+#include <algorithm>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -72,3 +74,49 @@ UNIT_TEST(CSVReaderEmptyFile)
   CSVReader reader;
   reader.Read(fileReader, [](File const & file) { TEST_EQUAL(file.size(), 0, ()); });
 }
+
+UNIT_TEST(CSVReaderMapped)
+{
+  std::string csv = "h1, h2 ,h3\n\na,,b\n c ,d\r\n";
+  for (size_t i = 0; i < 1000; ++i)
+    csv += std::to_string(i) + "," + std::to_string(i * i) + "\n";
+  csv += "last, row";
+
+  ScopedFile sf("test_mapped.csv", csv);
+  FileReader fileReader(sf.GetFullPath());
+  CSVReader reader;
+  for (bool readHeader : {false, true})
+  {
+    CSVReader::Params p;
+    p.m_readHeader = readHeader;
+    File expected;
+    reader.Read(fileReader, [&](File && file) { expected = std::move(file); }, p);
+
+    auto const toRow = [](CSVReader::RowView const & rowView) {
+      Row row;
+      for (auto const & column : rowView)
+        row.emplace_back(column.begin(), column.end());
+      return row;
+    };
+
+    File file;
+    reader.ReadMapped(sf.GetFullPath(), [&](CSVReader::RowView const & row) {
+      file.push_back(toRow(row));
+    }, p);
+    TEST_EQUAL(file, expected, ());
+
+    std::mutex mutex;
+    File parallelFile;
+    reader.ReadMappedParallel(sf.GetFullPath(), [&](CSVReader::RowView const & row) {
+      auto r = toRow(row);
+      std::lock_guard<std::mutex> lock(mutex);
+      parallelFile.push_back(std::move(r));
+    }, 4 /* threadsCount */, p);
+    std::sort(parallelFile.begin(), parallelFile.end());
+    std::sort(expected.begin(), expected.end());
+    TEST_EQUAL(parallelFile, expected, ());
+  }
+
+  ScopedFile emptyFile("test_mapped_empty.csv", kCSV3);
+  reader.ReadMapped(emptyFile.GetFullPath(), [](CSVReader::RowView const &) { TEST(false, ()); });
+}
@@ -3,9 +3,31 @@
 #include "coding/dd_vector.hpp"
 #include "coding/reader.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+namespace
+{
+// A reader of the memory which reads it by copying, like the readers of the files do.
+class CopyingReader : public Reader
+{
+public:
+  explicit CopyingReader(MemReader const & reader) : m_reader(reader) {}
+
+  uint64_t Size() const override { return m_reader.Size(); }
+  void Read(uint64_t pos, void * p, size_t size) const override { m_reader.Read(pos, p, size); }
+  std::unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const override
+  {
+    return m_reader.CreateSubReader(pos, size);
+  }
+
+private:
+  MemReader m_reader;
+};
+}  // namespace
+
 UNIT_TEST(DDVector_Smoke)
 {
   std::vector<uint16_t> data;
@@ -43,3 +65,35 @@ UNIT_TEST(DDVector_IncorrectSize)
 
   TEST(exceptionCaught, ());
 }
+
+UNIT_TEST(DDVector_DirectData)
+{
+  std::vector<uint64_t> data;
+  for (uint64_t i = 0; i < 100; ++i)
+    data.push_back(i * i * 0x9E3779B1ULL);
+
+  // The data of the reader is unaligned for the elements.
+  std::vector<char> buffer(1, 0);
+  auto const * begin = reinterpret_cast<char const *>(data.data());
+  buffer.insert(buffer.end(), begin, begin + data.size() * sizeof(data[0]));
+  MemReader const reader(buffer.data() + 1, buffer.size() - 1);
+  TEST(reader.GetDirectData(), ());
+
+  DDVector<uint64_t, MemReader> const direct(reader);
+  DDVector<uint64_t, CopyingReader> const copying{CopyingReader(reader)};
+  TEST_EQUAL(direct.size(), data.size(), ());
+  TEST_EQUAL(copying.size(), data.size(), ());
+
+  for (uint32_t i = 0; i < data.size(); ++i)
+  {
+    TEST_EQUAL(direct[i], data[i], ());
+    TEST_EQUAL(copying[i], data[i], ());
+
+    uint64_t value = 0;
+    direct.Read(i, value);
+    TEST_EQUAL(value, data[i], ());
+  }
+
+  TEST(std::equal(direct.begin(), direct.end(), data.begin(), data.end()), ());
+  TEST(std::equal(copying.begin(), copying.end(), data.begin(), data.end()), ());
+}
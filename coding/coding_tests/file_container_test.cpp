@@ -1,6 +1,7 @@
 #include "testing/testing.hpp"
 
 #include "coding/file_container.hpp"
+#include "coding/internal/file_data.hpp"
 #include "coding/varint.hpp"
 
 #include "base/logging.hpp"
@@ -10,6 +11,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -370,3 +373,81 @@ UNIT_TEST(FilesMappingContainer_PageSize)
 
   FileWriter::DeleteFileX(fName);
 }
+
+UNIT_TEST(FilesContainerBuilder_Smoke)
+{
+  string const fName = "file_container_builder.tmp";
+  string const expectedName = "file_container_builder_expected.tmp";
+  string const sectionFile = "file_container_builder_section.tmp";
+  SCOPE_GUARD(deleteFiles, [&]() {
+    FileWriter::DeleteFileX(fName);
+    FileWriter::DeleteFileX(expectedName);
+    FileWriter::DeleteFileX(sectionFile);
+  });
+
+  auto const makeData = [](size_t i) {
+    vector<uint8_t> data(i * 37 + 3);
+    for (size_t j = 0; j < data.size(); ++j)
+      data[j] = static_cast<uint8_t>(i + j);
+    return data;
+  };
+
+  size_t const count = 16;
+  {
+    FileWriter writer(sectionFile);
+    auto const data = makeData(count);
+    writer.Write(data.data(), data.size());
+  }
+
+  {
+    FilesContainerBuilder builder(fName);
+    vector<thread> threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+      threads.emplace_back([&builder, &makeData, i]() {
+        auto const tag = "section_" + strings::to_string(count - i);
+        if (i % 2 == 0)
+        {
+          builder.AddSection(tag, makeData(count - i));
+        }
+        else
+        {
+          builder.ProduceSection(tag, [&](Writer & writer) {
+            auto const data = makeData(count - i);
+            writer.Write(data.data(), data.size());
+          });
+        }
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+
+    builder.AddSectionFile("section_0", sectionFile);
+    builder.Finish();
+  }
+
+  {
+    FilesContainerW writer(expectedName);
+    for (size_t i = 0; i <= count; ++i)
+    {
+      auto const tag = "section_" + strings::to_string(i);
+      writer.Write(makeData(i == 0 ? count : i), tag);
+    }
+  }
+
+  {
+    FilesContainerR reader(fName);
+    FilesContainerR expectedReader(expectedName);
+    for (size_t i = 0; i <= count; ++i)
+    {
+      auto const tag = "section_" + strings::to_string(i);
+      string section;
+      reader.GetReader(tag).ReadAsString(section);
+      string expectedSection;
+      expectedReader.GetReader(tag).ReadAsString(expectedSection);
+      TEST_EQUAL(section, expectedSection, (tag));
+      uint64_t tempSize = 0;
+      TEST(!base::GetFileSize(fName + "." + tag + ".section.tmp", tempSize), (tag));
+    }
+  }
+}
@@ -102,3 +102,30 @@ UNIT_TEST(Equal_Function_Test_For_Big_Files)
     TEST(base::DeleteFileX(name2), ());
   }
 }
+
+UNIT_TEST(FileData_AppendFileToFile)
+{
+  MakeFile(name1, 100, 'a');
+  MakeFile(name2, 50, 'b');
+  base::AppendFileToFile(name2, name1);
+  base::AppendFileToFile(name2, name1);
+
+  uint64_t sz;
+  TEST(base::GetFileSize(name1, sz), ());
+  TEST_EQUAL(sz, 200, ());
+
+  {
+    base::FileData f(name1, base::FileData::OP_READ);
+    string data(200, '\0');
+    f.Read(0, &data[0], data.size());
+    TEST_EQUAL(data, string(100, 'a') + string(100, 'b'), ());
+  }
+
+  string const name3 = "test3.file";
+  base::AppendFileToFile(name1, name3);
+  TEST(base::IsEqualFiles(name1, name3), ());
+
+  TEST(base::DeleteFileX(name1), ());
+  TEST(base::DeleteFileX(name2), ());
+  TEST(base::DeleteFileX(name3), ());
+}
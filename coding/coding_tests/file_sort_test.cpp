@@ -34,6 +34,22 @@ namespace
     reader.Read(0, &result[0], reader.Size());
     TEST_EQUAL(result, data, ());
   }
+
+  template <typename T>
+  void TestParallelFileSorter(vector<T> data, char const * tmpFileName, size_t bufferBytes,
+                              unsigned int threadsCount, FileSorterRunFormat format)
+  {
+    vector<T> result;
+    auto out = [&result](T const & item) { result.push_back(item); };
+    ParallelFileSorter<T, decltype(out)> sorter(bufferBytes, tmpFileName, out, less<T>(),
+                                                threadsCount, format);
+    for (auto const & item : data)
+      sorter.Add(item);
+    sorter.SortAndFinish();
+
+    sort(data.begin(), data.end());
+    TEST_EQUAL(result, data, ());
+  }
 }
 
 UNIT_TEST(FileSorter_Smoke)
@@ -55,3 +71,37 @@ UNIT_TEST(FileSorter_Random)
 
   TestFileSorter(data, "file_sorter_test_random.tmp", data.size() / 10);
 }
+
+UNIT_TEST(ParallelFileSorter_Random)
+{
+  mt19937 rng(0);
+  vector<uint64_t> data(100000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = i % 7 == 0 && i >= 20 ? data[i - 20] : (rng() % 1000000) * 0x10001;
+
+  for (auto const format : {FileSorterRunFormat::Raw, FileSorterRunFormat::ByteDelta})
+  {
+    for (unsigned int threadsCount : {1, 4})
+    {
+      // Many runs of a non-power-of-two count.
+      TestParallelFileSorter(data, "parallel_file_sorter_test_random.tmp",
+                             data.size() * sizeof(uint64_t) / 5, threadsCount, format);
+      // A single run.
+      TestParallelFileSorter(data, "parallel_file_sorter_test_random.tmp",
+                             4 * data.size() * sizeof(uint64_t), threadsCount, format);
+    }
+  }
+}
+
+UNIT_TEST(ParallelFileSorter_Pairs)
+{
+  mt19937 rng(1);
+  vector<pair<uint64_t, uint32_t>> data(5000);
+  for (auto & item : data)
+    item = {rng() % 100, static_cast<uint32_t>(rng())};
+
+  TestParallelFileSorter(data, "parallel_file_sorter_test_pairs.tmp", 1000, 2,
+                         FileSorterRunFormat::ByteDelta);
+  TestParallelFileSorter(vector<pair<uint64_t, uint32_t>>(), "parallel_file_sorter_test_pairs.tmp",
+                         1000, 2, FileSorterRunFormat::ByteDelta);
+}
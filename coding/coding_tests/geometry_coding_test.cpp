@@ -187,3 +187,55 @@ UNIT_TEST(DecodeEncodePolyline_DataSet1)
 
   TestPolylineEncode("DataSet1", points, GetMaxPoint(), &EncodePolyline, &DecodePolyline);
 }
+
+UNIT_TEST(EncodeDecodePointsBlocks)
+{
+  size_t const count = ARRAY_SIZE(geometry_coding_tests::arr1);
+  vector<m2::PointU> dataSet;
+  for (size_t i = 0; i < count; ++i)
+    dataSet.push_back(D2U(geometry_coding_tests::arr1[i]));
+
+  // The sizes around the block boundaries, the equal points and the jumps across the map.
+  vector<vector<m2::PointU>> polylines = {
+      {}, {PU(5, 7)}, {PU(5, 7), PU(5, 7), PU(5, 7)}, {PU(0, 0), GetMaxPoint(), PU(0, 0)}, dataSet};
+  for (size_t size : {kPointsBlockSize - 1, kPointsBlockSize, kPointsBlockSize + 1,
+                      3 * kPointsBlockSize + 5})
+  {
+    vector<m2::PointU> points;
+    for (size_t i = 0; i < size; ++i)
+      points.emplace_back(1000 + i * i, 2000000 - 3 * i);
+    polylines.push_back(points);
+  }
+
+  m2::PointU const basePoint(1 << 20, 1 << 21);
+  for (auto const & points : polylines)
+  {
+    vector<char> buffer;
+    EncodePointsBlocks(make_read_adapter(points), basePoint, buffer);
+
+    vector<m2::PointU> decodedPoints(points.size());
+    OutPointsT decodedPointsA(decodedPoints);
+    void const * end = DecodePointsBlocks(buffer.data(), points.size(), basePoint, decodedPointsA);
+    TEST_EQUAL(points, decodedPoints, ());
+    TEST_EQUAL(end, buffer.data() + buffer.size(), (points.size()));
+  }
+}
+
+UNIT_TEST(SaveLoadOuterPathBlocks_DataSet1)
+{
+  using namespace geometry_coding_tests;
+
+  vector<m2::PointD> const points(arr1, arr1 + ARRAY_SIZE(arr1));
+  vector<char> buffer;
+  PushBackByteSink<vector<char>> sink(buffer);
+  serial::GeometryCodingParams const cp;
+  serial::SaveOuterPathBlocks(points, cp, sink);
+
+  vector<m2::PointD> loadedPoints;
+  ArrayByteSource source(buffer.data());
+  serial::LoadOuterPathBlocks(source, cp, loadedPoints);
+  TEST_EQUAL(source.PtrC(), buffer.data() + buffer.size(), ());
+  TEST_EQUAL(points.size(), loadedPoints.size(), ());
+  for (size_t i = 0; i < points.size(); ++i)
+    TEST(points[i].EqualDxDy(loadedPoints[i], kMwmPointAccuracy), (points[i], loadedPoints[i]));
+}
@@ -2,6 +2,7 @@
 
 #include "coding/huffman.hpp"
 #include "coding/reader.hpp"
+#include "coding/write_to_sink.hpp"
 #include "coding/writer.hpp"
 
 #include "base/string_utils.hpp"
@@ -132,4 +133,51 @@ UNIT_TEST(Huffman_Serialization_Data)
   TEST_EQUAL(expected, received, ());
 }
 
+UNIT_TEST(Huffman_Serialization_LongCodes)
+{
+  // The Fibonacci frequencies give the codes of all the lengths up to the number of symbols.
+  vector<strings::UniString> strs;
+  uint32_t prev = 1;
+  uint32_t cur = 1;
+  for (strings::UniChar c = 'a'; c < 'a' + 20; ++c)
+  {
+    strs.push_back(strings::UniString(static_cast<size_t>(cur), c));
+    auto const next = prev + cur;
+    prev = cur;
+    cur = next;
+  }
+  HuffmanCoder hW;
+  hW.Init(strs);
+
+  vector<strings::UniString> expected;
+  for (size_t i = 0; i < 50; ++i)
+  {
+    strings::UniString s;
+    for (size_t j = 0; j < i; ++j)
+      s.push_back(static_cast<strings::UniChar>('a' + (i * 7 + j * j) % 20));
+    expected.push_back(s);
+  }
+
+  vector<uint8_t> buf;
+  MemWriter<vector<uint8_t>> writer(buf);
+  hW.WriteEncoding(writer);
+  for (auto const & s : expected)
+  {
+    hW.EncodeAndWrite(writer, s);
+    // The decoder must not read past the encoded string.
+    WriteToSink(writer, static_cast<uint8_t>(0xA5));
+  }
+
+  HuffmanCoder hR;
+  MemReader memReader(buf.data(), buf.size());
+  ReaderSource<MemReader> reader(memReader);
+  hR.ReadEncoding(reader);
+  for (auto const & s : expected)
+  {
+    TEST_EQUAL(s, hR.ReadAndDecode(reader), ());
+    TEST_EQUAL(ReadPrimitiveFromSource<uint8_t>(reader), 0xA5, ());
+  }
+  TEST_EQUAL(reader.Size(), 0, ());
+}
+
 }  // namespace coding
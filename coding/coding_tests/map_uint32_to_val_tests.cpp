@@ -58,3 +58,79 @@ UNIT_TEST(MapUint32ValTest)
     }
   }
 }
+
+UNIT_TEST(MapUint32ValTest_GetManyAndFixedWidth)
+{
+  // Every third id has an entry.
+  vector<pair<uint32_t, uint64_t>> data;
+  for (uint32_t i = 0; i < 1000; i += 3)
+    data.emplace_back(i, static_cast<uint64_t>(i) * i + (uint64_t{1} << 40));
+
+  vector<uint32_t> ids;
+  for (uint32_t i = 0; i < 1010; i += 2)
+    ids.push_back(i);
+
+  vector<pair<uint32_t, uint64_t>> expected;
+  for (auto const & d : data)
+  {
+    if (d.first % 2 == 0)
+      expected.push_back(d);
+  }
+
+  Buffer buffer;
+  {
+    MapUint32ToValueBuilder<uint64_t> builder;
+    for (auto const & d : data)
+      builder.Put(d.first, d.second);
+
+    MemWriter<Buffer> writer(buffer);
+    builder.FreezeFixedWidth(writer);
+  }
+
+  MemReader reader(buffer.data(), buffer.size());
+  auto const readBlockCallback = [](NonOwningReaderSource & source, uint32_t blockSize,
+                                    vector<uint64_t> & values) {
+    values.resize(blockSize);
+    for (size_t i = 0; i < blockSize && source.Size() > 0; ++i)
+      values[i] = ReadPrimitiveFromSource<uint64_t>(source);
+  };
+
+  auto blockTable = MapUint32ToValue<uint64_t>::Load(reader, readBlockCallback);
+  auto fixedWidthTable = MapUint32ToValue<uint64_t>::LoadFixedWidth(reader);
+  TEST(blockTable, ());
+  TEST(fixedWidthTable, ());
+
+  for (auto * table : {blockTable.get(), fixedWidthTable.get()})
+  {
+    // The first block is cached by Get and the others are decoded by GetMany.
+    uint64_t value;
+    TEST(table->Get(3, value), ());
+    TEST_EQUAL(value, 9 + (uint64_t{1} << 40), ());
+    TEST(!table->Get(4, value), ());
+
+    vector<pair<uint32_t, uint64_t>> actual;
+    table->GetMany(ids, [&actual](uint32_t id, uint64_t value) { actual.emplace_back(id, value); });
+    TEST_EQUAL(actual, expected, ());
+
+    actual.clear();
+    table->ForEach([&actual](uint32_t id, uint64_t value) { actual.emplace_back(id, value); });
+    TEST_EQUAL(actual, data, ());
+  }
+
+  // The table of the variable width values is not loaded as the fixed width one.
+  Buffer varintBuffer;
+  {
+    MapUint32ToValueBuilder<uint64_t> builder;
+    for (auto const & d : data)
+      builder.Put(d.first, d.second);
+
+    MemWriter<Buffer> writer(varintBuffer);
+    builder.Freeze(writer, [](Writer & w, vector<uint64_t>::const_iterator begin,
+                              vector<uint64_t>::const_iterator end) {
+      for (auto it = begin; it != end; ++it)
+        WriteVarUint(w, *it);
+    });
+  }
+  MemReader varintReader(varintBuffer.data(), varintBuffer.size());
+  TEST(!MapUint32ToValue<uint64_t>::LoadFixedWidth(varintReader), ());
+}
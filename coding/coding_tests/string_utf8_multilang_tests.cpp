@@ -1,6 +1,8 @@
 #include "testing/testing.hpp"
 
+#include "coding/byte_stream.hpp"
 #include "coding/string_utf8_multilang.hpp"
+#include "coding/varint.hpp"
 
 #include "base/control_flow.hpp"
 
@@ -133,6 +135,51 @@ UNIT_TEST(MultilangString_LangNames)
   TEST_EQUAL(langs[international].m_code, string("int_name"), ());
 }
 
+UNIT_TEST(MultilangString_View)
+{
+  StringUtf8Multilang s;
+  for (size_t i = 0; i < ARRAY_SIZE(gArr); ++i)
+    s.AddString(gArr[i].m_lang, gArr[i].m_str);
+
+  vector<char> buffer;
+  PushBackByteSink<vector<char>> sink(buffer);
+  s.Write(sink);
+  buffer.push_back('x');
+  ArrayByteSource source(buffer.data());
+  auto const view = StringUtf8MultilangView::Read(source);
+  TEST_EQUAL(source.PtrC(), &buffer.back(), ());
+  TEST_EQUAL(view.CountLangs(), s.CountLangs(), ());
+  TEST_EQUAL(StringUtf8Multilang(view), s, ());
+
+  string cmp;
+  boost::string_view cmpView;
+  for (size_t i = 0; i < ARRAY_SIZE(gArr); ++i)
+  {
+    auto const lang = StringUtf8Multilang::GetLangIndex(gArr[i].m_lang);
+    TEST(view.HasString(lang), ());
+    TEST(view.GetString(lang, cmp), ());
+    TEST_EQUAL(cmp, gArr[i].m_str, ());
+    TEST(view.GetString(lang, cmpView), ());
+    TEST_EQUAL(cmpView, gArr[i].m_str, ());
+    TEST_GREATER_OR_EQUAL(cmpView.data(), buffer.data(), ());
+    TEST_LESS(cmpView.data(), buffer.data() + buffer.size(), ());
+  }
+  TEST(!view.GetString(StringUtf8Multilang::kUnsupportedLanguageCode, cmp), ());
+
+  size_t count = 0;
+  view.ForEach([&](int8_t code, boost::string_view name) {
+    string expected;
+    TEST(s.GetString(code, expected), ());
+    TEST_EQUAL(name, expected, ());
+    ++count;
+  });
+  TEST_EQUAL(count, ARRAY_SIZE(gArr), ());
+  TEST_EQUAL(DebugPrint(view), DebugPrint(s), ());
+
+  TEST(StringUtf8MultilangView().IsEmpty(), ());
+  TEST_EQUAL(StringUtf8Multilang(s.GetView()), s, ());
+}
+
 UNIT_TEST(MultilangString_HasString)
 {
   StringUtf8Multilang s;
@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,6 +28,22 @@ namespace
     vector<pair<uint64_t, string> > & m_Data;
   };
 
+  // A reader of the memory which reads it by copying, like the readers of the files do.
+  class CopyingReader : public Reader
+  {
+  public:
+    explicit CopyingReader(MemReader const & reader) : m_reader(reader) {}
+
+    uint64_t Size() const override { return m_reader.Size(); }
+    void Read(uint64_t pos, void * p, size_t size) const override { m_reader.Read(pos, p, size); }
+    unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const override
+    {
+      return m_reader.CreateSubReader(pos, size);
+    }
+
+  private:
+    MemReader m_reader;
+  };
 }
 
 UNIT_TEST(VarRecordReader_Simple)
@@ -76,5 +93,19 @@ UNIT_TEST(VarRecordReader_Simple)
     expectedForEachCalls.push_back(pair<uint64_t, string>(4, longString));
     expectedForEachCalls.push_back(pair<uint64_t, string>(6 + longStringSize, "defg"));
     TEST_EQUAL(forEachCalls, expectedForEachCalls, ());
+
+    // The records are read in place from the memory of the reader.
+    vector<char const *> recordsData;
+    recordReader.ForEachRecord([&](uint32_t pos, char const * pData, uint32_t /* size */) {
+      TEST_EQUAL(pData, &data[0] + pos + (pos == 4 ? 2 : 1), ());
+      recordsData.push_back(pData);
+    });
+    TEST_EQUAL(recordsData.size(), 3, ());
+
+    VarRecordReader<CopyingReader, &VarRecordSizeReaderVarint> copyingRecordReader(
+        CopyingReader(reader), chunkSizes[chunkSize]);
+    forEachCalls.clear();
+    copyingRecordReader.ForEachRecord(SaveForEachParams(forEachCalls));
+    TEST_EQUAL(forEachCalls, expectedForEachCalls, ());
   }
 }
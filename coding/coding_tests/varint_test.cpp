@@ -6,6 +6,7 @@
 #include "base/macros.hpp"
 #include "base/stl_helpers.hpp"
 
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -181,3 +182,41 @@ UNIT_TEST(ReadVarInt64Array)
   }
 }
 
+
+UNIT_TEST(ReadVarUint64Array_ByWords)
+{
+  mt19937_64 rng(0);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    // Mostly short values with some long ones, so both the words of one-byte values
+    // and the values crossing the words are read.
+    vector<uint64_t> values(rng() % 50);
+    for (auto & v : values)
+    {
+      auto const bitsCount = rng() % 65;
+      v = bitsCount == 0 ? 0 : rng() >> (64 - bitsCount);
+      if (rng() % 2 == 0)
+        v &= 127;
+    }
+
+    vector<unsigned char> data;
+    {
+      PushBackByteSink<vector<unsigned char>> dst(data);
+      for (auto const v : values)
+        WriteVarUint(dst, v);
+    }
+
+    vector<uint64_t> result;
+    void const * pEnd = ReadVarUint64Array(data.data(), data.data() + data.size(),
+                                           base::MakeBackInsertFunctor(result));
+    TEST_EQUAL(pEnd, data.data() + data.size(), (i));
+    TEST_EQUAL(result, values, (i));
+
+    vector<int64_t> signedResult;
+    ReadVarInt64Array(data.data(), data.data() + data.size(),
+                      base::MakeBackInsertFunctor(signedResult));
+    TEST_EQUAL(signedResult.size(), values.size(), (i));
+    for (size_t j = 0; j < values.size(); ++j)
+      TEST_EQUAL(signedResult[j], bits::ZigZagDecode(values[j]), (i, j));
+  }
+}
@@ -1,5 +1,6 @@
 #include "testing/testing.hpp"
 
+#include "coding/async_buffered_file_writer.hpp"
 #include "coding/buffered_file_writer.hpp"
 #include "coding/file_writer.hpp"
 #include "coding/file_reader.hpp"
@@ -242,6 +243,43 @@ UNIT_TEST(BufferedFileWriter_Smoke)
   WriteToFileAndTest<BufferedFileWriter>();
 }
 
+UNIT_TEST(AsyncBufferedFileWriter_Smoke)
+{
+  WriteToFileAndTest<AsyncBufferedFileWriter>();
+}
+
+UNIT_TEST(AsyncBufferedFileWriter_SmallBuffers)
+{
+  char const fileName[] = "async_buffered_file_writer_test.tmp";
+  string expected;
+  {
+    AsyncBufferedFileWriter writer(fileName, FileWriter::OP_WRITE_TRUNCATE, 7 /* bufferSize */,
+                                   3 /* buffersCount */);
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      string const s(i % 20, static_cast<char>('a' + i % 26));
+      writer.Write(s.data(), s.size());
+      expected += s;
+      TEST_EQUAL(writer.Pos(), expected.size(), ());
+    }
+    writer.Flush();
+    TEST_EQUAL(writer.GetStats().m_bytesWritten, expected.size(), ());
+    TEST_EQUAL(writer.Size(), expected.size(), ());
+
+    writer.Seek(3);
+    writer.Write("xyz", 3);
+    expected.replace(3, 3, "xyz");
+    TEST_EQUAL(writer.Size(), expected.size(), ());
+  }
+  {
+    FileReader reader(fileName);
+    string s;
+    reader.ReadAsString(s);
+    TEST_EQUAL(s, expected, ());
+  }
+  FileWriter::DeleteFileX(fileName);
+}
+
 UNIT_TEST(MemWriter_Chunks)
 {
   string buffer;
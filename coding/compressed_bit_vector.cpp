@@ -1,11 +1,13 @@
 #include "coding/compressed_bit_vector.hpp"
 
+#include "coding/varint.hpp"
 #include "coding/write_to_sink.hpp"
 
 #include "base/assert.hpp"
 #include "base/bits.hpp"
 
 #include <algorithm>
+#include <cstddef>
 
 using namespace std;
 
@@ -13,18 +15,144 @@ namespace coding
 {
 namespace
 {
+// When one of the sorted sequences is this many times longer than the other one,
+// the elements of the shorter sequence are looked up in the longer one by galloping.
+size_t const kGallopingRatio = 16;
+
+bool ShouldGallop(size_t shortSize, size_t longSize)
+{
+  return shortSize * kGallopingRatio <= longSize;
+}
+
+// Returns the first element of [first, last) which is not less than |value|.
+// The search takes O(log(d)) steps where d is the distance to the found element,
+// so a sequence of searches for increasing values walks [first, last) once.
+template <typename TIterator>
+TIterator Gallop(TIterator first, TIterator last, uint64_t value)
+{
+  size_t step = 1;
+  auto lo = first;
+  while (last - lo > static_cast<ptrdiff_t>(step) && *(lo + step) < value)
+  {
+    lo += step;
+    step *= 2;
+  }
+  auto const hi = last - lo > static_cast<ptrdiff_t>(step) ? lo + step + 1 : last;
+  return lower_bound(lo, hi, value);
+}
+
+// Intersects the sorted sequence [sb, se) with a much longer sorted sequence [lb, le).
+template <typename TShortIterator, typename TLongIterator>
+vector<uint64_t> GallopingIntersection(TShortIterator sb, TShortIterator se, TLongIterator lb,
+                                       TLongIterator le)
+{
+  vector<uint64_t> resPos;
+  for (; sb != se && lb != le; ++sb)
+  {
+    lb = Gallop(lb, le, *sb);
+    if (lb != le && *lb == *sb)
+      resPos.push_back(*sb);
+  }
+  return resPos;
+}
+
+struct DenseTag
+{
+};
+
+struct SparseTag
+{
+};
+
+DenseTag GetTag(DenseCBV const &) { return {}; }
+DenseTag GetTag(DenseCBVView const &) { return {}; }
+SparseTag GetTag(SparseCBV const &) { return {}; }
+SparseTag GetTag(SparseCBVView const &) { return {}; }
+
+// The intersections below work with both the bit vectors and their views.
+template <typename TDenseA, typename TDenseB>
+unique_ptr<CompressedBitVector> IntersectDense(TDenseA const & a, TDenseB const & b)
+{
+  vector<uint64_t> resGroups(min(a.NumBitGroups(), b.NumBitGroups()));
+  for (size_t i = 0; i < resGroups.size(); ++i)
+    resGroups[i] = a.GetBitGroup(i) & b.GetBitGroup(i);
+  return CompressedBitVectorBuilder::FromBitGroups(move(resGroups));
+}
+
+// The intersection of dense and sparse is always sparse.
+template <typename TDense, typename TSparse>
+unique_ptr<CompressedBitVector> IntersectDenseSparse(TDense const & a, TSparse const & b)
+{
+  uint64_t const numBits = a.NumBitGroups() * DenseCBV::kBlockSize;
+  vector<uint64_t> resPos;
+  for (auto it = b.Begin(); it != b.End() && *it < numBits; ++it)
+  {
+    auto const pos = *it;
+    if (a.GetBit(pos))
+      resPos.push_back(pos);
+  }
+  return make_unique<SparseCBV>(move(resPos));
+}
+
+template <typename TSparseA, typename TSparseB>
+unique_ptr<CompressedBitVector> IntersectSparse(TSparseA const & a, TSparseB const & b)
+{
+  size_t const sizeA = a.PopCount();
+  size_t const sizeB = b.PopCount();
+  if (ShouldGallop(sizeA, sizeB))
+    return make_unique<SparseCBV>(GallopingIntersection(a.Begin(), a.End(), b.Begin(), b.End()));
+  if (ShouldGallop(sizeB, sizeA))
+    return make_unique<SparseCBV>(GallopingIntersection(b.Begin(), b.End(), a.Begin(), a.End()));
+
+  vector<uint64_t> resPos;
+  set_intersection(a.Begin(), a.End(), b.Begin(), b.End(), back_inserter(resPos));
+  return make_unique<SparseCBV>(move(resPos));
+}
+
+template <typename TA, typename TB>
+unique_ptr<CompressedBitVector> Intersect(TA const & a, DenseTag, TB const & b, DenseTag)
+{
+  return IntersectDense(a, b);
+}
+
+template <typename TA, typename TB>
+unique_ptr<CompressedBitVector> Intersect(TA const & a, DenseTag, TB const & b, SparseTag)
+{
+  return IntersectDenseSparse(a, b);
+}
+
+template <typename TA, typename TB>
+unique_ptr<CompressedBitVector> Intersect(TA const & a, SparseTag, TB const & b, DenseTag)
+{
+  return IntersectDenseSparse(b, a);
+}
+
+template <typename TA, typename TB>
+unique_ptr<CompressedBitVector> Intersect(TA const & a, SparseTag, TB const & b, SparseTag)
+{
+  return IntersectSparse(a, b);
+}
+
 struct IntersectOp
 {
   IntersectOp() {}
 
+  // The intersections with the views.
+  template <typename TA, typename TB>
+  unique_ptr<coding::CompressedBitVector> operator()(TA const & a, TB const & b) const
+  {
+    return Intersect(a, GetTag(a), b, GetTag(b));
+  }
+
   unique_ptr<coding::CompressedBitVector> operator()(coding::DenseCBV const & a,
                                                      coding::DenseCBV const & b) const
   {
-    size_t const sizeA = a.NumBitGroups();
-    size_t const sizeB = b.NumBitGroups();
-    vector<uint64_t> resGroups(min(sizeA, sizeB));
+    // The loops over the raw groups are vectorized by the compiler.
+    auto const & groupsA = a.GetBitGroups();
+    auto const & groupsB = b.GetBitGroups();
+    vector<uint64_t> resGroups(min(groupsA.size(), groupsB.size()));
     for (size_t i = 0; i < resGroups.size(); ++i)
-      resGroups[i] = a.GetBitGroup(i) & b.GetBitGroup(i);
+      resGroups[i] = groupsA[i] & groupsB[i];
     return coding::CompressedBitVectorBuilder::FromBitGroups(move(resGroups));
   }
 
@@ -32,28 +160,19 @@ struct IntersectOp
   unique_ptr<coding::CompressedBitVector> operator()(coding::DenseCBV const & a,
                                                      coding::SparseCBV const & b) const
   {
-    vector<uint64_t> resPos;
-    for (size_t i = 0; i < b.PopCount(); ++i)
-    {
-      auto pos = b.Select(i);
-      if (a.GetBit(pos))
-        resPos.push_back(pos);
-    }
-    return make_unique<coding::SparseCBV>(move(resPos));
+    return IntersectDenseSparse(a, b);
   }
 
   unique_ptr<coding::CompressedBitVector> operator()(coding::SparseCBV const & a,
                                                      coding::DenseCBV const & b) const
   {
-    return operator()(b, a);
+    return IntersectDenseSparse(b, a);
   }
 
   unique_ptr<coding::CompressedBitVector> operator()(coding::SparseCBV const & a,
                                                      coding::SparseCBV const & b) const
   {
-    vector<uint64_t> resPos;
-    set_intersection(a.Begin(), a.End(), b.Begin(), b.End(), back_inserter(resPos));
-    return make_unique<coding::SparseCBV>(move(resPos));
+    return IntersectSparse(a, b);
   }
 };
 
@@ -64,11 +183,12 @@ struct SubtractOp
   unique_ptr<coding::CompressedBitVector> operator()(coding::DenseCBV const & a,
                                                      coding::DenseCBV const & b) const
   {
-    size_t const sizeA = a.NumBitGroups();
-    size_t const sizeB = b.NumBitGroups();
-    vector<uint64_t> resGroups(min(sizeA, sizeB));
-    for (size_t i = 0; i < resGroups.size(); ++i)
-      resGroups[i] = a.GetBitGroup(i) & ~b.GetBitGroup(i);
+    auto const & groupsA = a.GetBitGroups();
+    auto const & groupsB = b.GetBitGroups();
+    size_t const commonSize = min(groupsA.size(), groupsB.size());
+    vector<uint64_t> resGroups(groupsA);
+    for (size_t i = 0; i < commonSize; ++i)
+      resGroups[i] &= ~groupsB[i];
     return CompressedBitVectorBuilder::FromBitGroups(move(resGroups));
   }
 
@@ -115,6 +235,18 @@ struct SubtractOp
                                                      coding::SparseCBV const & b) const
   {
     vector<uint64_t> resPos;
+    if (ShouldGallop(a.PopCount(), b.PopCount()))
+    {
+      auto j = b.Begin();
+      for (auto i = a.Begin(); i != a.End(); ++i)
+      {
+        j = Gallop(j, b.End(), *i);
+        if (j == b.End() || *j != *i)
+          resPos.push_back(*i);
+      }
+      return CompressedBitVectorBuilder::FromBitPositions(move(resPos));
+    }
+
     set_difference(a.Begin(), a.End(), b.Begin(), b.End(), back_inserter(resPos));
     return CompressedBitVectorBuilder::FromBitPositions(move(resPos));
   }
@@ -127,24 +259,14 @@ struct UnionOp
   unique_ptr<coding::CompressedBitVector> operator()(coding::DenseCBV const & a,
                                                      coding::DenseCBV const & b) const
   {
-    size_t const sizeA = a.NumBitGroups();
-    size_t const sizeB = b.NumBitGroups();
-
-    size_t commonSize = min(sizeA, sizeB);
-    size_t resultSize = max(sizeA, sizeB);
-    vector<uint64_t> resGroups(resultSize);
-    for (size_t i = 0; i < commonSize; ++i)
-      resGroups[i] = a.GetBitGroup(i) | b.GetBitGroup(i);
-    if (a.NumBitGroups() == resultSize)
-    {
-      for (size_t i = commonSize; i < resultSize; ++i)
-        resGroups[i] = a.GetBitGroup(i);
-    }
-    else
-    {
-      for (size_t i = commonSize; i < resultSize; ++i)
-        resGroups[i] = b.GetBitGroup(i);
-    }
+    auto const & groupsA = a.GetBitGroups();
+    auto const & groupsB = b.GetBitGroups();
+    auto const & longer = groupsA.size() >= groupsB.size() ? groupsA : groupsB;
+    auto const & shorter = groupsA.size() >= groupsB.size() ? groupsB : groupsA;
+
+    vector<uint64_t> resGroups(longer);
+    for (size_t i = 0; i < shorter.size(); ++i)
+      resGroups[i] |= shorter[i];
     return CompressedBitVectorBuilder::FromBitGroups(move(resGroups));
   }
 
@@ -168,6 +290,8 @@ struct UnionOp
           resPos.push_back(*j);
           ++j;
         }
+        if (j < b.End() && *j == va)
+          ++j;
         resPos.push_back(va);
       };
       a.ForEach(merge);
@@ -248,6 +372,15 @@ unique_ptr<coding::CompressedBitVector> Apply(TBinaryOp const & op, CompressedBi
   return nullptr;
 }
 
+template <typename TBinaryOp, typename TLhs>
+unique_ptr<CompressedBitVector> ApplyToView(TBinaryOp const & op, TLhs const & lhs,
+                                            CompressedBitVectorView const & rhs)
+{
+  if (rhs.GetStorageStrategy() == CompressedBitVector::StorageStrategy::Dense)
+    return op(lhs, rhs.GetDense());
+  return op(lhs, rhs.GetSparse());
+}
+
 // Returns true if a bit vector with popCount bits set out of totalBits
 // is fit to be represented as a DenseCBV. Note that we do not
 // account for possible irregularities in the distribution of bits.
@@ -275,6 +408,8 @@ unique_ptr<CompressedBitVector> BuildFromBitPositions(TBitPositions && setBits)
 
 // static
 uint64_t const DenseCBV::kBlockSize;
+// static
+size_t const DenseCBV::kGroupsPerRank;
 
 DenseCBV::DenseCBV(vector<uint64_t> const & setBits)
 {
@@ -291,6 +426,7 @@ DenseCBV::DenseCBV(vector<uint64_t> const & setBits)
     m_bitGroups[static_cast<size_t>(pos / kBlockSize)] |= static_cast<uint64_t>(1)
                                                           << (pos % kBlockSize);
   }
+  BuildRanks();
 }
 
 // static
@@ -301,6 +437,7 @@ unique_ptr<DenseCBV> DenseCBV::BuildFromBitGroups(vector<uint64_t> && bitGroups)
   for (size_t i = 0; i < bitGroups.size(); ++i)
     cbv->m_popCount += bits::PopCount(bitGroups[i]);
   cbv->m_bitGroups = move(bitGroups);
+  cbv->BuildRanks();
   return cbv;
 }
 
@@ -309,6 +446,44 @@ uint64_t DenseCBV::GetBitGroup(size_t i) const
   return i < m_bitGroups.size() ? m_bitGroups[i] : 0;
 }
 
+uint64_t DenseCBV::Rank(uint64_t pos) const
+{
+  size_t const group = static_cast<size_t>(pos / kBlockSize);
+  if (group >= m_bitGroups.size())
+    return m_popCount;
+
+  size_t const rank = group / kGroupsPerRank;
+  uint64_t result = m_ranks[rank];
+  for (size_t i = rank * kGroupsPerRank; i < group; ++i)
+    result += bits::PopCount(m_bitGroups[i]);
+  uint64_t const mask = (static_cast<uint64_t>(1) << (pos % kBlockSize)) - 1;
+  return result + bits::PopCount(m_bitGroups[group] & mask);
+}
+
+uint64_t DenseCBV::Select(uint64_t i) const
+{
+  ASSERT_LESS(i, m_popCount, ());
+
+  // The last rank entry which does not exceed |i|.
+  auto const it = upper_bound(m_ranks.begin(), m_ranks.end(), i);
+  ASSERT(it != m_ranks.begin(), ());
+  size_t group = static_cast<size_t>(it - m_ranks.begin() - 1) * kGroupsPerRank;
+  i -= *(it - 1);
+  for (; group < m_bitGroups.size(); ++group)
+  {
+    uint32_t const bits = bits::PopCount(m_bitGroups[group]);
+    if (i < bits)
+      break;
+    i -= bits;
+  }
+  CHECK_LESS(group, m_bitGroups.size(), ());
+
+  uint64_t bitGroup = m_bitGroups[group];
+  for (; i != 0; --i)
+    bitGroup &= bitGroup - 1;
+  return group * kBlockSize + bits::FloorLog(bitGroup & (~bitGroup + 1));
+}
+
 uint64_t DenseCBV::PopCount() const { return m_popCount; }
 
 bool DenseCBV::GetBit(uint64_t pos) const
@@ -364,9 +539,23 @@ unique_ptr<CompressedBitVector> DenseCBV::Clone() const
   DenseCBV * cbv = new DenseCBV();
   cbv->m_popCount = m_popCount;
   cbv->m_bitGroups = m_bitGroups;
+  cbv->m_ranks = m_ranks;
   return unique_ptr<CompressedBitVector>(cbv);
 }
 
+void DenseCBV::BuildRanks()
+{
+  m_ranks.clear();
+  m_ranks.reserve(m_bitGroups.size() / kGroupsPerRank + 1);
+  uint64_t rank = 0;
+  for (size_t i = 0; i < m_bitGroups.size(); ++i)
+  {
+    if (i % kGroupsPerRank == 0)
+      m_ranks.push_back(rank);
+    rank += bits::PopCount(m_bitGroups[i]);
+  }
+}
+
 SparseCBV::SparseCBV(vector<uint64_t> const & setBits) : m_positions(setBits)
 {
   ASSERT(is_sorted(m_positions.begin(), m_positions.end()), ());
@@ -451,15 +640,105 @@ unique_ptr<CompressedBitVector> CompressedBitVectorBuilder::FromBitGroups(
     return DenseCBV::BuildFromBitGroups(move(bitGroups));
 
   vector<uint64_t> setBits;
+  setBits.reserve(popCount);
   for (size_t i = 0; i < bitGroups.size(); ++i)
   {
-    for (size_t j = 0; j < kBlockSize; ++j)
-    {
-      if (((bitGroups[i] >> j) & 1) > 0)
-        setBits.push_back(kBlockSize * i + j);
-    }
+    for (uint64_t group = bitGroups[i]; group != 0; group &= group - 1)
+      setBits.push_back(kBlockSize * i + bits::FloorLog(group & (~group + 1)));
+  }
+  return make_unique<SparseCBV>(move(setBits));
+}
+
+uint64_t DenseCBVView::PopCount() const
+{
+  uint64_t popCount = 0;
+  for (size_t i = 0; i < m_numBitGroups; ++i)
+    popCount += bits::PopCount(GetBitGroup(i));
+  return popCount;
+}
+
+bool DenseCBVView::GetBit(uint64_t pos) const
+{
+  uint64_t bitGroup = GetBitGroup(static_cast<size_t>(pos / DenseCBV::kBlockSize));
+  return ((bitGroup >> (pos % DenseCBV::kBlockSize)) & 1) > 0;
+}
+
+bool SparseCBVView::GetBit(uint64_t pos) const { return binary_search(Begin(), End(), pos); }
+
+// static
+unique_ptr<CompressedBitVector> CompressedBitVectorView::Intersect(
+    CompressedBitVectorView const & lhs, CompressedBitVectorView const & rhs)
+{
+  static IntersectOp const op;
+  if (lhs.GetStorageStrategy() == StorageStrategy::Dense)
+    return ApplyToView(op, lhs.GetDense(), rhs);
+  return ApplyToView(op, lhs.GetSparse(), rhs);
+}
+
+// static
+unique_ptr<CompressedBitVector> CompressedBitVectorView::Intersect(
+    CompressedBitVector const & lhs, CompressedBitVectorView const & rhs)
+{
+  static IntersectOp const op;
+  if (lhs.GetStorageStrategy() == StorageStrategy::Dense)
+    return ApplyToView(op, static_cast<DenseCBV const &>(lhs), rhs);
+  return ApplyToView(op, static_cast<SparseCBV const &>(lhs), rhs);
+}
+
+uint64_t CompressedBitVectorView::PopCount() const
+{
+  return m_strategy == StorageStrategy::Dense ? m_dense.PopCount() : m_sparse.PopCount();
+}
+
+bool CompressedBitVectorView::GetBit(uint64_t pos) const
+{
+  return m_strategy == StorageStrategy::Dense ? m_dense.GetBit(pos) : m_sparse.GetBit(pos);
+}
+
+unique_ptr<CompressedBitVector> CompressedBitVectorView::Clone() const
+{
+  if (m_strategy == StorageStrategy::Dense)
+  {
+    vector<uint64_t> bitGroups(m_dense.NumBitGroups());
+    for (size_t i = 0; i < bitGroups.size(); ++i)
+      bitGroups[i] = m_dense.GetBitGroup(i);
+    return DenseCBV::BuildFromBitGroups(move(bitGroups));
+  }
+  return make_unique<SparseCBV>(vector<uint64_t>(m_sparse.Begin(), m_sparse.End()));
+}
+
+// static
+bool CompressedBitVectorBuilder::DeserializeView(uint8_t const * data, size_t size,
+                                                 CompressedBitVectorView & view)
+{
+  uint8_t header = 0;
+  uint32_t count = 0;
+  uint64_t offset = 0;
+  try
+  {
+    ReaderSource<MemReaderWithExceptions> src(MemReaderWithExceptions(data, size));
+    header = ReadPrimitiveFromSource<uint8_t>(src);
+    // The number of the words written by rw::WriteVectorOfPOD().
+    count = ReadVarUint<uint32_t>(src);
+    if (count > src.Size() / sizeof(uint64_t))
+      return false;
+    offset = src.Pos();
+  }
+  catch (Reader::Exception const &)
+  {
+    return false;
+  }
+
+  switch (static_cast<CompressedBitVector::StorageStrategy>(header))
+  {
+  case CompressedBitVector::StorageStrategy::Dense:
+    view = CompressedBitVectorView(DenseCBVView(data + offset, count));
+    return true;
+  case CompressedBitVector::StorageStrategy::Sparse:
+    view = CompressedBitVectorView(SparseCBVView(data + offset, count));
+    return true;
   }
-  return make_unique<SparseCBV>(setBits);
+  return false;
 }
 
 string DebugPrint(CompressedBitVector::StorageStrategy strat)
@@ -5,11 +5,14 @@
 #include "coding/writer.hpp"
 
 #include "base/assert.hpp"
+#include "base/bits.hpp"
 #include "base/control_flow.hpp"
 #include "base/ref_counted.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -102,6 +105,7 @@ public:
   static std::unique_ptr<DenseCBV> BuildFromBitGroups(std::vector<uint64_t> && bitGroups);
 
   size_t NumBitGroups() const { return m_bitGroups.size(); }
+  std::vector<uint64_t> const & GetBitGroups() const { return m_bitGroups; }
 
   template <typename Fn>
   void ForEach(Fn && f) const
@@ -109,12 +113,13 @@ public:
     base::ControlFlowWrapper<Fn> wrapper(std::forward<Fn>(f));
     for (size_t i = 0; i < m_bitGroups.size(); ++i)
     {
-      for (size_t j = 0; j < kBlockSize; ++j)
+      // Only the set bits of the group are visited.
+      for (uint64_t group = m_bitGroups[i]; group != 0; group &= group - 1)
       {
-        if (((m_bitGroups[i] >> j) & 1) > 0)
+        if (wrapper(kBlockSize * i + bits::FloorLog(group & (~group + 1))) ==
+            base::ControlFlow::Break)
         {
-          if (wrapper(kBlockSize * i + j) == base::ControlFlow::Break)
-            return;
+          return;
         }
       }
     }
@@ -123,6 +128,12 @@ public:
   // Returns 0 if the group number is too large to be contained in m_bits.
   uint64_t GetBitGroup(size_t i) const;
 
+  // Returns the number of set bits at the positions less than |pos|.
+  uint64_t Rank(uint64_t pos) const;
+
+  // Returns the position of the i'th (0-based) set bit, |i| must be less than PopCount().
+  uint64_t Select(uint64_t i) const;
+
   // CompressedBitVector overrides:
   uint64_t PopCount() const override;
   bool GetBit(uint64_t pos) const override;
@@ -132,8 +143,15 @@ public:
   std::unique_ptr<CompressedBitVector> Clone() const override;
 
 private:
+  // The number of bit groups covered by an entry of the rank directory.
+  static size_t const kGroupsPerRank = 8;
+
+  void BuildRanks();
+
   std::vector<uint64_t> m_bitGroups;
   uint64_t m_popCount = 0;
+  // m_ranks[i] is the number of set bits in the first i * kGroupsPerRank bit groups.
+  std::vector<uint64_t> m_ranks;
 };
 
 class SparseCBV : public CompressedBitVector
@@ -178,6 +196,220 @@ private:
   std::vector<uint64_t> m_positions;
 };
 
+// Views of the serialized bit vectors, see CompressedBitVector::Serialize(). The views operate
+// on the serialized words, e.g. in the mapped mwm sections: a view is created without
+// copying the words or allocating memory. The serialized words are not aligned in general,
+// so they are read with memcpy(). The words must outlive the views.
+class DenseCBVView
+{
+public:
+  DenseCBVView() = default;
+  // |bitGroups| are |numBitGroups| words of the groups of DenseCBV.
+  DenseCBVView(uint8_t const * bitGroups, size_t numBitGroups)
+    : m_bitGroups(bitGroups), m_numBitGroups(numBitGroups)
+  {
+  }
+
+  size_t NumBitGroups() const { return m_numBitGroups; }
+
+  // Returns 0 if the group number is too large to be contained in the view.
+  uint64_t GetBitGroup(size_t i) const
+  {
+    if (i >= m_numBitGroups)
+      return 0;
+    uint64_t group = 0;
+    std::memcpy(&group, m_bitGroups + i * sizeof(group), sizeof(group));
+    return group;
+  }
+
+  template <typename Fn>
+  void ForEach(Fn && f) const
+  {
+    base::ControlFlowWrapper<Fn> wrapper(std::forward<Fn>(f));
+    for (size_t i = 0; i < m_numBitGroups; ++i)
+    {
+      for (uint64_t group = GetBitGroup(i); group != 0; group &= group - 1)
+      {
+        if (wrapper(DenseCBV::kBlockSize * i + bits::FloorLog(group & (~group + 1))) ==
+            base::ControlFlow::Break)
+        {
+          return;
+        }
+      }
+    }
+  }
+
+  // Unlike DenseCBV::PopCount(), the set bits are counted on every call.
+  uint64_t PopCount() const;
+  bool GetBit(uint64_t pos) const;
+
+private:
+  uint8_t const * m_bitGroups = nullptr;
+  size_t m_numBitGroups = 0;
+};
+
+class SparseCBVView
+{
+public:
+  // A random access iterator over the positions of the set bits.
+  class Iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = uint64_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = uint64_t const *;
+    using reference = uint64_t;
+
+    Iterator() = default;
+    explicit Iterator(uint8_t const * position) : m_position(position) {}
+
+    uint64_t operator*() const
+    {
+      uint64_t position = 0;
+      std::memcpy(&position, m_position, sizeof(position));
+      return position;
+    }
+    uint64_t operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator & operator++() { return *this += 1; }
+    Iterator operator++(int)
+    {
+      auto const it = *this;
+      ++*this;
+      return it;
+    }
+    Iterator & operator--() { return *this -= 1; }
+    Iterator operator--(int)
+    {
+      auto const it = *this;
+      --*this;
+      return it;
+    }
+    Iterator & operator+=(difference_type n)
+    {
+      m_position += n * static_cast<difference_type>(sizeof(uint64_t));
+      return *this;
+    }
+    Iterator & operator-=(difference_type n) { return *this += -n; }
+
+    friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(Iterator const & lhs, Iterator const & rhs)
+    {
+      return (lhs.m_position - rhs.m_position) / static_cast<difference_type>(sizeof(uint64_t));
+    }
+
+    friend bool operator==(Iterator const & lhs, Iterator const & rhs)
+    {
+      return lhs.m_position == rhs.m_position;
+    }
+    friend bool operator!=(Iterator const & lhs, Iterator const & rhs) { return !(lhs == rhs); }
+    friend bool operator<(Iterator const & lhs, Iterator const & rhs)
+    {
+      return lhs.m_position < rhs.m_position;
+    }
+    friend bool operator>(Iterator const & lhs, Iterator const & rhs) { return rhs < lhs; }
+    friend bool operator<=(Iterator const & lhs, Iterator const & rhs) { return !(rhs < lhs); }
+    friend bool operator>=(Iterator const & lhs, Iterator const & rhs) { return !(lhs < rhs); }
+
+  private:
+    uint8_t const * m_position = nullptr;
+  };
+
+  SparseCBVView() = default;
+  // |positions| are |numPositions| words of the sorted positions of SparseCBV.
+  SparseCBVView(uint8_t const * positions, size_t numPositions)
+    : m_positions(positions), m_numPositions(numPositions)
+  {
+  }
+
+  // Returns the position of the i'th set bit.
+  uint64_t Select(size_t i) const
+  {
+    ASSERT_LESS(i, m_numPositions, ());
+    return Begin()[static_cast<Iterator::difference_type>(i)];
+  }
+
+  template <typename Fn>
+  void ForEach(Fn && f) const
+  {
+    base::ControlFlowWrapper<Fn> wrapper(std::forward<Fn>(f));
+    for (auto it = Begin(); it != End(); ++it)
+    {
+      if (wrapper(*it) == base::ControlFlow::Break)
+        return;
+    }
+  }
+
+  uint64_t PopCount() const { return m_numPositions; }
+  bool GetBit(uint64_t pos) const;
+
+  Iterator Begin() const { return Iterator(m_positions); }
+  Iterator End() const { return Iterator(m_positions + m_numPositions * sizeof(uint64_t)); }
+
+private:
+  uint8_t const * m_positions = nullptr;
+  size_t m_numPositions = 0;
+};
+
+// A view of a serialized bit vector of any strategy.
+class CompressedBitVectorView
+{
+public:
+  using StorageStrategy = CompressedBitVector::StorageStrategy;
+
+  // An empty bit vector.
+  CompressedBitVectorView() = default;
+  explicit CompressedBitVectorView(DenseCBVView const & dense)
+    : m_strategy(StorageStrategy::Dense), m_dense(dense)
+  {
+  }
+  explicit CompressedBitVectorView(SparseCBVView const & sparse)
+    : m_strategy(StorageStrategy::Sparse), m_sparse(sparse)
+  {
+  }
+
+  // Intersects the bit vectors, the same as CompressedBitVector::Intersect().
+  static std::unique_ptr<CompressedBitVector> Intersect(CompressedBitVectorView const & lhs,
+                                                        CompressedBitVectorView const & rhs);
+  static std::unique_ptr<CompressedBitVector> Intersect(CompressedBitVector const & lhs,
+                                                        CompressedBitVectorView const & rhs);
+
+  StorageStrategy GetStorageStrategy() const { return m_strategy; }
+  DenseCBVView const & GetDense() const
+  {
+    ASSERT(m_strategy == StorageStrategy::Dense, ());
+    return m_dense;
+  }
+  SparseCBVView const & GetSparse() const
+  {
+    ASSERT(m_strategy == StorageStrategy::Sparse, ());
+    return m_sparse;
+  }
+
+  template <typename Fn>
+  void ForEach(Fn && f) const
+  {
+    if (m_strategy == StorageStrategy::Dense)
+      m_dense.ForEach(std::forward<Fn>(f));
+    else
+      m_sparse.ForEach(std::forward<Fn>(f));
+  }
+
+  uint64_t PopCount() const;
+  bool GetBit(uint64_t pos) const;
+
+  // Copies the viewed bit vector.
+  std::unique_ptr<CompressedBitVector> Clone() const;
+
+private:
+  StorageStrategy m_strategy = StorageStrategy::Sparse;
+  DenseCBVView m_dense;
+  SparseCBVView m_sparse;
+};
+
 class CompressedBitVectorBuilder
 {
 public:
@@ -226,6 +458,11 @@ public:
     }
     return std::unique_ptr<CompressedBitVector>();
   }
+
+  // Makes a view of the bit vector serialized to |size| bytes at |data| (see
+  // CompressedBitVector::Serialize for the format) without copying it. Returns false
+  // if |data| is not a valid bit vector representation.
+  static bool DeserializeView(uint8_t const * data, size_t size, CompressedBitVectorView & view);
 };
 
 // ForEach is generic and therefore cannot be virtual: a helper class is needed.
@@ -0,0 +1,263 @@
+#include "coding/concurrent_file_reader.hpp"
+
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+// The reads of more pages bypass the cache not to evict the pages of the other readers.
+size_t const kMaxCachedReadPages = 4;
+}  // namespace
+
+// ConcurrentPageCache -----------------------------------------------------------------------------
+// static
+uint32_t const ConcurrentPageCache::kDefaultLogPageSize = 12;
+// static
+size_t const ConcurrentPageCache::kDefaultPagesCount = 16 * 1024;
+// static
+size_t const ConcurrentPageCache::kDefaultShardsCount = 64;
+
+ConcurrentPageCache::ConcurrentPageCache(uint32_t logPageSize, size_t pagesCount,
+                                         size_t shardsCount)
+  : m_logPageSize(logPageSize)
+{
+  CHECK_GREATER(shardsCount, 0, ());
+  auto const pagesPerShard = max<size_t>(1, pagesCount / shardsCount);
+  m_shards.reserve(shardsCount);
+  for (size_t i = 0; i < shardsCount; ++i)
+  {
+    auto shard = make_unique<Shard>();
+    shard->m_pages.resize(pagesPerShard);
+    shard->m_data.resize(pagesPerShard << m_logPageSize);
+    shard->m_index.reserve(pagesPerShard);
+    m_shards.push_back(move(shard));
+  }
+}
+
+// static
+ConcurrentPageCache & ConcurrentPageCache::Instance()
+{
+  static ConcurrentPageCache cache(kDefaultLogPageSize, kDefaultPagesCount, kDefaultShardsCount);
+  return cache;
+}
+
+// static
+uint64_t ConcurrentPageCache::NewFileId()
+{
+  static atomic<uint64_t> lastId{0};
+  return ++lastId;
+}
+
+void ConcurrentPageCache::Read(uint64_t fileId, uint64_t pageNum, size_t offset, size_t size,
+                               void * dst, PageLoader const & loader)
+{
+  ASSERT_LESS_OR_EQUAL(offset + size, GetPageSize(), ());
+  Key const key{fileId, pageNum};
+  auto & shard = *m_shards[KeyHash()(key) % m_shards.size()];
+  {
+    lock_guard<mutex> lock(shard.m_mutex);
+    auto const it = shard.m_index.find(key);
+    if (it != shard.m_index.end())
+    {
+      auto & page = shard.m_pages[it->second];
+      ASSERT_LESS_OR_EQUAL(offset + size, page.m_size, ());
+      page.m_referenced = true;
+      memcpy(dst, shard.m_data.data() + (it->second << m_logPageSize) + offset, size);
+      ++shard.m_hits;
+      return;
+    }
+    ++shard.m_misses;
+  }
+
+  // Other threads may load the same page meanwhile, the first loaded copy is kept.
+  vector<char> buffer(GetPageSize());
+  auto const pageSize = loader(pageNum, buffer.data());
+  CHECK_LESS_OR_EQUAL(offset + size, pageSize, (fileId, pageNum));
+  memcpy(dst, buffer.data() + offset, size);
+
+  lock_guard<mutex> lock(shard.m_mutex);
+  if (shard.m_index.count(key) != 0)
+    return;
+
+  auto const index = Evict(shard);
+  auto & page = shard.m_pages[index];
+  page.m_key = key;
+  page.m_size = pageSize;
+  page.m_used = true;
+  page.m_referenced = true;
+  memcpy(shard.m_data.data() + (index << m_logPageSize), buffer.data(), pageSize);
+  shard.m_index.emplace(key, index);
+}
+
+ConcurrentPageCache::Stats ConcurrentPageCache::GetStats() const
+{
+  Stats stats;
+  for (auto const & shard : m_shards)
+  {
+    lock_guard<mutex> lock(shard->m_mutex);
+    stats.m_hits += shard->m_hits;
+    stats.m_misses += shard->m_misses;
+  }
+  return stats;
+}
+
+size_t ConcurrentPageCache::Evict(Shard & shard)
+{
+  auto & pages = shard.m_pages;
+  while (true)
+  {
+    auto const index = shard.m_hand;
+    shard.m_hand = (shard.m_hand + 1) % pages.size();
+
+    auto & page = pages[index];
+    if (!page.m_used)
+      return index;
+
+    if (page.m_referenced)
+    {
+      page.m_referenced = false;
+      continue;
+    }
+
+    shard.m_index.erase(page.m_key);
+    page.m_used = false;
+    return index;
+  }
+}
+
+// ConcurrentFileReader::FileData ------------------------------------------------------------------
+class ConcurrentFileReader::FileData
+{
+public:
+  explicit FileData(string const & fileName) : m_id(ConcurrentPageCache::NewFileId())
+  {
+    m_fd = open(fileName.c_str(), O_RDONLY);
+    if (m_fd == -1)
+      MYTHROW(OpenException, ("open failed for file", fileName, strerror(errno)));
+
+    struct stat s;
+    if (fstat(m_fd, &s) == -1)
+    {
+      close(m_fd);
+      MYTHROW(OpenException, ("fstat failed for file", fileName, strerror(errno)));
+    }
+    m_size = static_cast<uint64_t>(s.st_size);
+  }
+
+  ~FileData() { close(m_fd); }
+
+  uint64_t GetId() const { return m_id; }
+  uint64_t Size() const { return m_size; }
+
+  void Read(uint64_t pos, void * p, size_t size) const
+  {
+    auto * dst = static_cast<char *>(p);
+    while (size > 0)
+    {
+      auto const read = pread(m_fd, dst, size, static_cast<off_t>(pos));
+      if (read == -1 && errno == EINTR)
+        continue;
+      if (read <= 0)
+        MYTHROW(Reader::ReadException, ("pread failed at", pos, "size", size, strerror(errno)));
+
+      dst += read;
+      pos += static_cast<uint64_t>(read);
+      size -= static_cast<size_t>(read);
+    }
+  }
+
+private:
+  int m_fd = -1;
+  uint64_t m_id;
+  uint64_t m_size = 0;
+};
+
+// ConcurrentFileReader ----------------------------------------------------------------------------
+ConcurrentFileReader::ConcurrentFileReader(string const & fileName)
+  : ConcurrentFileReader(fileName, ConcurrentPageCache::Instance())
+{
+}
+
+ConcurrentFileReader::ConcurrentFileReader(string const & fileName, ConcurrentPageCache & cache)
+  : ModelReader(fileName)
+  , m_fileData(make_shared<FileData>(fileName))
+  , m_cache(&cache)
+  , m_offset(0)
+  , m_size(m_fileData->Size())
+{
+}
+
+ConcurrentFileReader::ConcurrentFileReader(ConcurrentFileReader const & reader, uint64_t offset,
+                                           uint64_t size)
+  : ModelReader(reader.GetName())
+  , m_fileData(reader.m_fileData)
+  , m_cache(reader.m_cache)
+  , m_offset(offset)
+  , m_size(size)
+{
+}
+
+void ConcurrentFileReader::Read(uint64_t pos, void * p, size_t size) const
+{
+  CheckPosAndSize(pos, size);
+  if (size == 0)
+    return;
+
+  pos += m_offset;
+  auto const logPageSize = m_cache->GetLogPageSize();
+  auto const pageSize = m_cache->GetPageSize();
+  if (size > kMaxCachedReadPages * pageSize)
+    return m_fileData->Read(pos, p, size);
+
+  auto const & file = *m_fileData;
+  auto const loader = [&file, logPageSize, pageSize](uint64_t pageNum, char * page) {
+    auto const pagePos = pageNum << logPageSize;
+    auto const size = static_cast<size_t>(min<uint64_t>(pageSize, file.Size() - pagePos));
+    file.Read(pagePos, page, size);
+    return size;
+  };
+
+  auto * dst = static_cast<char *>(p);
+  while (size > 0)
+  {
+    auto const pageNum = pos >> logPageSize;
+    auto const offset = static_cast<size_t>(pos - (pageNum << logPageSize));
+    auto const copySize = min(size, pageSize - offset);
+    m_cache->Read(file.GetId(), pageNum, offset, copySize, dst, loader);
+    dst += copySize;
+    pos += copySize;
+    size -= copySize;
+  }
+}
+
+ConcurrentFileReader ConcurrentFileReader::SubReader(uint64_t pos, uint64_t size) const
+{
+  CheckPosAndSize(pos, size);
+  return ConcurrentFileReader(*this, m_offset + pos, size);
+}
+
+unique_ptr<Reader> ConcurrentFileReader::CreateSubReader(uint64_t pos, uint64_t size) const
+{
+  CheckPosAndSize(pos, size);
+  // Can't use make_unique with private constructor.
+  return unique_ptr<Reader>(new ConcurrentFileReader(*this, m_offset + pos, size));
+}
+
+void ConcurrentFileReader::CheckPosAndSize(uint64_t pos, uint64_t size) const
+{
+  if (pos + size > Size())
+    MYTHROW(Reader::SizeException, (pos, size, Size()));
+
+  if (m_offset + pos + size > m_fileData->Size())
+    MYTHROW(Reader::SizeException, (pos, size, m_fileData->Size()));
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "coding/reader.hpp"
+
+#include "base/flat_hash_map.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A cache of the file pages shared by all the ConcurrentFileReaders of the process. The pages are
+// split into the shards by a hash of (file, page), a shard is guarded by its own mutex and evicts
+// its pages by the CLOCK algorithm. A missed page is read out of the lock.
+class ConcurrentPageCache
+{
+public:
+  struct Stats
+  {
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+  };
+
+  // Reads the page |pageNum| into |page| and returns the size of the page, it is less than the
+  // page size for the last page of a file.
+  using PageLoader = std::function<size_t(uint64_t pageNum, char * page)>;
+
+  static uint32_t const kDefaultLogPageSize;
+  static size_t const kDefaultPagesCount;
+  static size_t const kDefaultShardsCount;
+
+  ConcurrentPageCache(uint32_t logPageSize, size_t pagesCount, size_t shardsCount);
+
+  // The cache of kDefaultPagesCount pages of 2^kDefaultLogPageSize bytes.
+  static ConcurrentPageCache & Instance();
+
+  // Returns a unique id of a file for the keys of the cache.
+  static uint64_t NewFileId();
+
+  uint32_t GetLogPageSize() const { return m_logPageSize; }
+  size_t GetPageSize() const { return size_t{1} << m_logPageSize; }
+
+  // Copies |size| bytes from |offset| of the page |pageNum| of the file |fileId| to |dst|.
+  // The page is read by |loader| if it is not in the cache.
+  void Read(uint64_t fileId, uint64_t pageNum, size_t offset, size_t size, void * dst,
+            PageLoader const & loader);
+
+  Stats GetStats() const;
+
+private:
+  struct Key
+  {
+    bool operator==(Key const & rhs) const
+    {
+      return m_fileId == rhs.m_fileId && m_pageNum == rhs.m_pageNum;
+    }
+
+    uint64_t m_fileId = 0;
+    uint64_t m_pageNum = 0;
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(Key const & key) const
+    {
+      return static_cast<size_t>(
+          base::MixHash64((key.m_fileId * 0x9e3779b97f4a7c15ULL) ^ key.m_pageNum));
+    }
+  };
+
+  struct Page
+  {
+    Key m_key;
+    size_t m_size = 0;
+    bool m_used = false;
+    bool m_referenced = false;
+  };
+
+  struct Shard
+  {
+    std::mutex m_mutex;
+    std::vector<Page> m_pages;
+    std::vector<char> m_data;
+    base::FlatHashMap<Key, size_t, KeyHash> m_index;
+    size_t m_hand = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+  };
+
+  // Returns the index of the page to replace, the caller holds the lock of |shard|.
+  size_t Evict(Shard & shard);
+
+  uint32_t m_logPageSize;
+  std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+// FileReader that is safe to share between the threads, the copies and the sub readers too.
+// The file is read by pread() through the pages of ConcurrentPageCache, so all the threads
+// reading a file share one warm cache. The big reads go to the file directly.
+// It is assumed that the file is not modified during the reader lifetime.
+class ConcurrentFileReader : public ModelReader
+{
+public:
+  explicit ConcurrentFileReader(std::string const & fileName);
+  ConcurrentFileReader(std::string const & fileName, ConcurrentPageCache & cache);
+
+  // Reader overrides:
+  uint64_t Size() const override { return m_size; }
+  void Read(uint64_t pos, void * p, size_t size) const override;
+  std::unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const override;
+
+  ConcurrentFileReader SubReader(uint64_t pos, uint64_t size) const;
+  uint64_t GetOffset() const { return m_offset; }
+
+private:
+  class FileData;
+
+  ConcurrentFileReader(ConcurrentFileReader const & reader, uint64_t offset, uint64_t size);
+
+  // Throws an exception if a (pos, size) read would result in an out-of-bounds access.
+  void CheckPosAndSize(uint64_t pos, uint64_t size) const;
+
+  std::shared_ptr<FileData> m_fileData;
+  ConcurrentPageCache * m_cache;
+  uint64_t m_offset;
+  uint64_t m_size;
+};
@@ -1,8 +1,19 @@
 #include "coding/csv_reader.hpp"
 
+#include "coding/internal/file_data.hpp"
+#include "coding/mmap_reader.hpp"
+
+#include "base/assert.hpp"
 #include "base/logging.hpp"
 #include "base/string_utils.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace coding
 {
 using namespace std;
@@ -36,4 +47,117 @@ void CSVReader::Read(istringstream & stream, FullFileCallback const & fn,
 
   fn(move(file));
 }
+
+namespace
+{
+bool IsSpace(char c) { return isspace(static_cast<unsigned char>(c)) != 0; }
+
+boost::string_view Trim(boost::string_view s)
+{
+  while (!s.empty() && IsSpace(s.front()))
+    s.remove_prefix(1);
+  while (!s.empty() && IsSpace(s.back()))
+    s.remove_suffix(1);
+  return s;
+}
+
+// Returns the beginning of the line next to the one of |p|.
+// memchr() scans the buffer by machine words or vector registers.
+char const * SkipLine(char const * p, char const * end)
+{
+  auto const eol = static_cast<char const *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+  return eol ? eol + 1 : end;
+}
+
+template <typename Fn>
+void ForEachRange(std::string const & fileName, unsigned int rangesCount,
+                  CSVReader::Params const & params, Fn && fn)
+{
+  // It is not possible to map a file of zero size.
+  uint64_t size = 0;
+  if (!base::GetFileSize(fileName, size) || size == 0)
+    return;
+
+  MmapReader const reader(fileName);
+  auto const data = reinterpret_cast<char const *>(reader.Data());
+  auto const end = data + reader.Size();
+  auto const begin = params.m_readHeader ? data : SkipLine(data, end);
+
+  vector<pair<char const *, char const *>> ranges;
+  auto const rangeSize = static_cast<size_t>(end - begin) / rangesCount + 1;
+  for (auto rangeBegin = begin; rangeBegin != end;)
+  {
+    auto const rangeEnd = static_cast<size_t>(end - rangeBegin) <= rangeSize
+                              ? end
+                              : SkipLine(rangeBegin + rangeSize, end);
+    ranges.emplace_back(rangeBegin, rangeEnd);
+    rangeBegin = rangeEnd;
+  }
+  fn(ranges);
+}
+}  // namespace
+
+void CSVReader::ReadMapped(std::string const & fileName, RowViewCallback const & fn,
+                           Params const & params) const
+{
+  ForEachRange(fileName, 1 /* rangesCount */, params, [&](auto const & ranges) {
+    for (auto const & range : ranges)
+      ParseLines(range.first, range.second, params.m_delimiter, fn);
+  });
+}
+
+void CSVReader::ReadMappedParallel(std::string const & fileName, RowViewCallback const & fn,
+                                   unsigned int threadsCount, Params const & params) const
+{
+  CHECK_GREATER_OR_EQUAL(threadsCount, 1, ());
+  ForEachRange(fileName, threadsCount, params, [&](auto const & ranges) {
+    vector<thread> threads;
+    threads.reserve(ranges.size());
+    for (auto const & range : ranges)
+    {
+      threads.emplace_back([&fn, &params, range]() {
+        ParseLines(range.first, range.second, params.m_delimiter, fn);
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+  });
+}
+
+// static
+void CSVReader::ParseLines(char const * begin, char const * end, char delimiter,
+                           RowViewCallback const & fn)
+{
+  RowView row;
+  while (begin != end)
+  {
+    auto const next = SkipLine(begin, end);
+    auto const lineEnd = *(next - 1) == '\n' ? next - 1 : next;
+    ParseRow(boost::string_view(begin, static_cast<size_t>(lineEnd - begin)), delimiter, row);
+    fn(row);
+    begin = next;
+  }
+}
+
+// static
+void CSVReader::ParseRow(boost::string_view line, char delimiter, RowView & row)
+{
+  row.clear();
+  auto begin = line.data();
+  auto const end = line.data() + line.size();
+  while (true)
+  {
+    auto const next =
+        static_cast<char const *>(memchr(begin, delimiter, static_cast<size_t>(end - begin)));
+    auto const columnEnd = next ? next : end;
+    row.push_back(Trim(boost::string_view(begin, static_cast<size_t>(columnEnd - begin))));
+    if (!next)
+      break;
+    begin = next + 1;
+  }
+
+  // Special case: if the line is empty, return an empty row instead of {""}.
+  if (row.size() == 1 && row[0].empty())
+    row.clear();
+}
 }  // namespace coding
@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/utility/string_view.hpp>
+
 namespace coding
 {
 class CSVReader
@@ -25,6 +27,9 @@ public:
   using File = std::vector<Row>;
   using RowByRowCallback = std::function<void(Row && row)>;
   using FullFileCallback = std::function<void(File && file)>;
+  // The columns of a row as views into the parsed buffer.
+  using RowView = std::vector<boost::string_view>;
+  using RowViewCallback = std::function<void(RowView const & row)>;
 
   void Read(std::istringstream & stream, RowByRowCallback const & fn,
             Params const & params = {}) const;
@@ -40,5 +45,23 @@ public:
     std::istringstream stream(str);
     Read(stream, fn, params);
   }
+
+  // Parses the file without copying: the rows passed to |fn| are views into the mapped file
+  // and are valid during the call only. The rows are the same as the ones of Read().
+  void ReadMapped(std::string const & fileName, RowViewCallback const & fn,
+                  Params const & params = {}) const;
+
+  // Same as ReadMapped() but the file is split into |threadsCount| ranges of lines
+  // which are parsed concurrently. |fn| is called concurrently and the order of rows
+  // is kept only within a range.
+  void ReadMappedParallel(std::string const & fileName, RowViewCallback const & fn,
+                          unsigned int threadsCount, Params const & params = {}) const;
+
+  // Calls |fn| for the rows of the lines in [begin, end).
+  static void ParseLines(char const * begin, char const * end, char delimiter,
+                         RowViewCallback const & fn);
+
+  // Splits |line| into the trimmed columns. An empty line has no columns.
+  static void ParseRow(boost::string_view line, char delimiter, RowView & row);
 };
 }  // namespace coding
@@ -1,15 +1,18 @@
 #pragma once
 
+#include "coding/endianness.hpp"
 #include "coding/reader.hpp"
 
 #include "base/assert.hpp"
 #include "base/exception.hpp"
 
+#include <cstring>
 #include <type_traits>
 
 #include <boost/iterator/iterator_facade.hpp>
 
-// Disk-driven vector.
+// Disk-driven vector. When the reader is a block of memory (see Reader::GetDirectData()),
+// the elements are copied straight from the memory instead of the virtual Read() calls.
 template <typename T, class TReader, typename TSize = uint32_t>
 class DDVector
 {
@@ -41,6 +44,8 @@ public:
 
   T const operator [] (size_type i) const
   {
+    if (m_data)
+      return ReadFromData(m_data, i);
     return ReadPrimitiveFromPos<T>(m_reader, static_cast<uint64_t>(i) * sizeof(T));
   }
 
@@ -50,19 +55,19 @@ public:
       boost::random_access_traversal_tag>
   {
   public:
-    const_iterator() : m_pReader(NULL), m_I(0), m_bValueRead(false)
+    const_iterator() : m_pReader(NULL), m_data(nullptr), m_I(0), m_bValueRead(false)
     {
     }
 
 #ifdef DEBUG
-    const_iterator(ReaderType const * pReader, size_type i, size_type size)
-      : m_pReader(pReader), m_I(i), m_bValueRead(false), m_Size(size)
+    const_iterator(ReaderType const * pReader, char const * data, size_type i, size_type size)
+      : m_pReader(pReader), m_data(data), m_I(i), m_bValueRead(false), m_Size(size)
     {
       ASSERT(static_cast<difference_type>(m_Size) >= 0, ());
     }
 #else
-    const_iterator(ReaderType const * pReader, size_type i)
-      : m_pReader(pReader), m_I(i), m_bValueRead(false)
+    const_iterator(ReaderType const * pReader, char const * data, size_type i)
+      : m_pReader(pReader), m_data(data), m_I(i), m_bValueRead(false)
     {
     }
 #endif
@@ -72,7 +77,10 @@ public:
       ASSERT_LESS(m_I, m_Size, (m_bValueRead));
       if (!m_bValueRead)
       {
-        m_Value = ReadPrimitiveFromPos<T>(*m_pReader, static_cast<uint64_t>(m_I) * sizeof(T));
+        if (m_data)
+          m_Value = ReadFromData(m_data, m_I);
+        else
+          m_Value = ReadPrimitiveFromPos<T>(*m_pReader, static_cast<uint64_t>(m_I) * sizeof(T));
         m_bValueRead = true;
       }
       return m_Value;
@@ -121,6 +129,7 @@ public:
 
   private:
     ReaderType const * m_pReader;
+    char const * m_data;
     size_type m_I;
     mutable T m_Value;
     mutable bool m_bValueRead;
@@ -132,34 +141,49 @@ public:
   const_iterator begin() const
   {
 #ifdef DEBUG
-    return const_iterator(&m_reader, 0, m_Size);
+    return const_iterator(&m_reader, m_data, 0, m_Size);
 #else
-    return const_iterator(&m_reader, 0);
+    return const_iterator(&m_reader, m_data, 0);
 #endif
   }
 
   const_iterator end() const
   {
 #ifdef DEBUG
-    return const_iterator(&m_reader, m_Size, m_Size);
+    return const_iterator(&m_reader, m_data, m_Size, m_Size);
 #else
-    return const_iterator(&m_reader, m_Size);
+    return const_iterator(&m_reader, m_data, m_Size);
 #endif
   }
 
   void Read(size_type i, T & result) const
   {
     ASSERT_LESS(i, m_Size, ());
-    ReadFromPos(m_reader, i * sizeof(T), &result, sizeof(T));
+    if (m_data)
+      memcpy(&result, m_data + static_cast<uint64_t>(i) * sizeof(T), sizeof(T));
+    else
+      ReadFromPos(m_reader, i * sizeof(T), &result, sizeof(T));
   }
 
   void Read(size_type i, T * result, size_t count)
   {
     ASSERT_LESS(i + count, m_Size, (i, count));
-    ReadFromPos(m_reader, i * sizeof(T), result, count * sizeof(T));
+    if (m_data)
+      memcpy(result, m_data + static_cast<uint64_t>(i) * sizeof(T), count * sizeof(T));
+    else
+      ReadFromPos(m_reader, i * sizeof(T), result, count * sizeof(T));
   }
 
 private:
+  // The memory may be unaligned for T, so the element is copied out instead of dereferenced.
+  static T ReadFromData(char const * data, size_type i)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    T value;
+    memcpy(&value, data + static_cast<uint64_t>(i) * sizeof(T), sizeof(T));
+    return SwapIfBigEndianMacroBased(value);
+  }
+
   void InitSize()
   {
     uint64_t const sz = m_reader.Size();
@@ -167,9 +191,12 @@ private:
       MYTHROW(OpenException, ("Element size", sizeof(T), "does not divide total size", sz));
 
     m_Size = static_cast<size_type>(sz / sizeof(T));
+    m_data = static_cast<char const *>(m_reader.GetDirectData());
   }
 
   // TODO: Refactor me to use Reader by pointer.
   ReaderType m_reader;
+  // The data of |m_reader| when it is a block of memory, nullptr otherwise.
+  char const * m_data = nullptr;
   size_type m_Size;
 };
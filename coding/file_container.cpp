@@ -11,6 +11,7 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/fcntl.h>
+#include <sys/stat.h>
 
 #include <errno.h>
 
@@ -137,6 +138,10 @@ void MappedFile::Close()
 
 MappedFile::Handle MappedFile::Map(uint64_t offset, uint64_t size, string const & tag) const
 {
+  // Empty sections can't be mapped, an invalid handle is returned for them.
+  if (size == 0)
+    return Handle();
+
   long const align = sysconf(_SC_PAGE_SIZE);
 
   uint64_t const alignedOffset = (offset / align) * align;
@@ -432,3 +437,173 @@ void FilesContainerW::Finish()
 
   m_finished = true;
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// FilesContainerBuilder
+/////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+class FileDescriptor
+{
+public:
+  FileDescriptor(string const & fName, int flags) : m_name(fName)
+  {
+    m_fd = open(fName.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (m_fd == -1)
+      MYTHROW(Writer::OpenException, ("Can't open file:", fName, ", reason:", strerror(errno)));
+  }
+
+  ~FileDescriptor() { close(m_fd); }
+
+  int Get() const { return m_fd; }
+  string const & GetName() const { return m_name; }
+
+private:
+  string m_name;
+  int m_fd;
+
+  DISALLOW_COPY_AND_MOVE(FileDescriptor);
+};
+
+void WriteAt(FileDescriptor const & file, void const * p, size_t size, uint64_t pos)
+{
+  auto src = static_cast<char const *>(p);
+  while (size != 0)
+  {
+    auto const written = pwrite(file.Get(), src, size, static_cast<off_t>(pos));
+    if (written == -1 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      MYTHROW(Writer::WriteException, ("Can't write file:", file.GetName(), strerror(errno)));
+
+    src += written;
+    size -= static_cast<size_t>(written);
+    pos += static_cast<uint64_t>(written);
+  }
+}
+
+// Copies the file |from| to |to| at |pos| and returns the size of the copied data.
+uint64_t CopyFileAt(string const & from, FileDescriptor const & to, uint64_t pos)
+{
+  FileDescriptor const src(from, O_RDONLY);
+  struct stat st;
+  if (fstat(src.Get(), &st) != 0)
+    MYTHROW(Reader::SizeException, ("Can't get size of file:", from, strerror(errno)));
+  auto const size = static_cast<uint64_t>(st.st_size);
+
+  base::CopyFileRange(src.Get(), 0 /* fromPos */, to.Get(), pos, size);
+  return size;
+}
+}  // namespace
+
+FilesContainerBuilder::FilesContainerBuilder(string const & fName) : m_name(fName) {}
+
+FilesContainerBuilder::~FilesContainerBuilder()
+{
+  if (!m_finished)
+    RemoveTempFiles();
+}
+
+void FilesContainerBuilder::AddSection(Tag const & tag, vector<uint8_t> && data)
+{
+  AddSectionImpl(tag, {} /* path */, false /* isTemp */, move(data));
+}
+
+void FilesContainerBuilder::AddSection(Tag const & tag, vector<char> const & data)
+{
+  AddSection(tag, vector<uint8_t>(data.begin(), data.end()));
+}
+
+void FilesContainerBuilder::AddSectionFile(Tag const & tag, string const & path)
+{
+  AddSectionImpl(tag, path, false /* isTemp */, {});
+}
+
+string FilesContainerBuilder::GetTempSectionPath(Tag const & tag) const
+{
+  return m_name + "." + tag + ".section.tmp";
+}
+
+void FilesContainerBuilder::AddSectionImpl(Tag const & tag, string const & path, bool isTemp,
+                                           vector<uint8_t> && data)
+{
+  lock_guard<mutex> lock(m_mutex);
+  ASSERT(!m_finished, ());
+  CHECK(find_if(m_sections.begin(), m_sections.end(),
+                [&tag](Section const & s) { return s.m_tag == tag; }) == m_sections.end(),
+        ("Duplicate section:", tag));
+
+  Section section;
+  section.m_tag = tag;
+  section.m_path = path;
+  section.m_isTemp = isTemp;
+  section.m_data = move(data);
+  m_sections.push_back(move(section));
+}
+
+void FilesContainerBuilder::Finish()
+{
+  lock_guard<mutex> lock(m_mutex);
+  ASSERT(!m_finished, ());
+
+  sort(m_sections.begin(), m_sections.end(),
+       [](Section const & l, Section const & r) { return l.m_tag < r.m_tag; });
+
+  {
+    FileDescriptor const file(m_name, O_WRONLY | O_CREAT | O_TRUNC);
+
+    // The offset of the service info is written in the end.
+    uint64_t pos = sizeof(uint64_t);
+    m_info.clear();
+    for (auto const & section : m_sections)
+    {
+      uint64_t const padding = (kSectionAlignment - pos % kSectionAlignment) % kSectionAlignment;
+      if (padding != 0)
+      {
+        uint64_t const zeros = 0;
+        WriteAt(file, &zeros, static_cast<size_t>(padding), pos);
+        pos += padding;
+      }
+
+      m_info.emplace_back(section.m_tag, pos);
+      if (section.m_path.empty())
+      {
+        WriteAt(file, section.m_data.data(), section.m_data.size(), pos);
+        m_info.back().m_size = section.m_data.size();
+      }
+      else
+      {
+        m_info.back().m_size = CopyFileAt(section.m_path, file, pos);
+      }
+      pos += m_info.back().m_size;
+    }
+
+    vector<uint8_t> info;
+    {
+      MemWriter<vector<uint8_t>> writer(info);
+      rw::Write(writer, m_info);
+    }
+    WriteAt(file, info.data(), info.size(), pos);
+
+    vector<uint8_t> header;
+    {
+      MemWriter<vector<uint8_t>> writer(header);
+      WriteToSink(writer, pos);
+    }
+    WriteAt(file, header.data(), header.size(), 0 /* pos */);
+  }
+
+  RemoveTempFiles();
+  m_sections.clear();
+  m_finished = true;
+}
+
+void FilesContainerBuilder::RemoveTempFiles()
+{
+  for (auto const & section : m_sections)
+  {
+    if (section.m_isTemp)
+      base::DeleteFileX(section.m_path);
+  }
+}
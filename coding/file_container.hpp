@@ -2,6 +2,7 @@
 
 #include "coding/file_reader.hpp"
 #include "coding/file_container_writers.hpp"
+#include "coding/file_writer.hpp"
 
 #include "base/assert.hpp"
 #include "base/macros.hpp"
@@ -10,6 +11,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -161,6 +163,11 @@ public:
     }
 
     Handle(Handle && h) { Assign(std::move(h)); }
+    Handle & operator=(Handle && h)
+    {
+      Assign(std::move(h));
+      return *this;
+    }
 
     ~Handle();
 
@@ -262,3 +269,67 @@ private:
   bool m_needRewrite;
   bool m_finished;
 };
+
+// Builds a files container from the sections which may be produced concurrently.
+// The sections are kept in memory or in temporary files until Finish() assembles
+// the container at once: the contents of the files are copied by the kernel
+// and the service info is written once at the end.
+// The format is the same as the one of FilesContainerW.
+class FilesContainerBuilder : public FilesContainerBase
+{
+public:
+  explicit FilesContainerBuilder(std::string const & fName);
+  ~FilesContainerBuilder();
+
+  // The Add* methods and ProduceSection() are thread safe.
+  void AddSection(Tag const & tag, std::vector<uint8_t> && data);
+  void AddSection(Tag const & tag, std::vector<char> const & data);
+
+  // Adds the contents of the file |path| as the section |tag|. The file must not be changed
+  // until Finish().
+  void AddSectionFile(Tag const & tag, std::string const & path);
+
+  // Calls |fn| with a writer to the temporary file of the section |tag|.
+  template <typename Fn>
+  void ProduceSection(Tag const & tag, Fn && fn)
+  {
+    auto const path = GetTempSectionPath(tag);
+    try
+    {
+      FileWriter writer(path);
+      fn(writer);
+    }
+    catch (...)
+    {
+      FileWriter::DeleteFileX(path);
+      throw;
+    }
+    AddSectionImpl(tag, path, true /* isTemp */, {});
+  }
+
+  // Writes the container sorting the sections by tags.
+  void Finish();
+
+  std::string const & GetFileName() const { return m_name; }
+
+private:
+  struct Section
+  {
+    Tag m_tag;
+    // The path of the file with the contents of the section or an empty string
+    // if the contents are in |m_data|.
+    std::string m_path;
+    bool m_isTemp = false;
+    std::vector<uint8_t> m_data;
+  };
+
+  std::string GetTempSectionPath(Tag const & tag) const;
+  void AddSectionImpl(Tag const & tag, std::string const & path, bool isTemp,
+                      std::vector<uint8_t> && data);
+  void RemoveTempFiles();
+
+  std::string m_name;
+  std::mutex m_mutex;
+  std::vector<Section> m_sections;
+  bool m_finished = false;
+};
@@ -1,22 +1,31 @@
 #pragma once
 
+#include "coding/byte_stream.hpp"
 #include "coding/file_reader.hpp"
 #include "coding/file_writer.hpp"
+#include "coding/varint.hpp"
 
+#include "base/assert.hpp"
 #include "base/base.hpp"
 #include "base/logging.hpp"
 #include "base/exception.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <functional>
+#include <future>
 #include <memory>
 #include <queue>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <boost/sort/sort.hpp>
+
 template <typename LessT>
 struct Sorter
 {
@@ -141,3 +150,347 @@ private:
   uint64_t m_ItemCount;
   LessT m_Less;
 };
+
+// Format of the sorted runs in the temporary file of ParallelFileSorter.
+enum class FileSorterRunFormat
+{
+  // The items as they are in memory.
+  Raw,
+  // Each item is the varint mask of its bytes which differ from the bytes of the previous item
+  // followed by these bytes. The neighbour items of a sorted run usually share most of the bytes
+  // of their keys, so the runs are several times smaller. The items must be at most 64 bytes.
+  ByteDelta
+};
+
+// The drop-in variant of FileSorter for the large inputs. A run is sorted with |threadsCount|
+// threads and written in the background while the next run is collected, so |bufferBytes| are
+// shared by two runs. The runs are written and read in large blocks and merged with a loser tree.
+// The items are output in the same order as with FileSorter up to the order of equal items.
+template <typename T,                      // Item type.
+          class OutputSinkT = FileWriter,  // Sink to output into result file.
+          typename LessT = std::less<T>    // Item comparator.
+          >
+class ParallelFileSorter
+{
+public:
+  static_assert(std::is_trivially_copy_constructible<T>::value &&
+                    std::is_trivially_destructible<T>::value,
+                "The items are copied as bytes.");
+
+  ParallelFileSorter(size_t bufferBytes, std::string const & tmpFileName,
+                     OutputSinkT & outputSink, LessT fLess = LessT(),
+                     unsigned int threadsCount = 1,
+                     FileSorterRunFormat format = FileSorterRunFormat::Raw)
+    : m_tmpFileName(tmpFileName)
+    , m_bufferBytes(bufferBytes)
+    , m_bufferCapacity(std::max(size_t(16), bufferBytes / 2 / sizeof(T)))
+    , m_outputSink(outputSink)
+    , m_less(fLess)
+    , m_threadsCount(std::max(threadsCount, 1u))
+    , m_format(format)
+  {
+    CHECK(m_format != FileSorterRunFormat::ByteDelta || sizeof(T) <= 64, (sizeof(T)));
+    m_buffer.reserve(m_bufferCapacity);
+    m_tmpWriter = std::make_unique<FileWriter>(tmpFileName);
+  }
+
+  void Add(T const & item)
+  {
+    if (m_buffer.size() == m_bufferCapacity)
+      FlushToTmpFile();
+    m_buffer.push_back(item);
+  }
+
+  void SortAndFinish()
+  {
+    ASSERT(m_tmpWriter, ());
+    FlushToTmpFile();
+    WaitForFlush();
+
+    // Write output.
+    {
+      m_tmpWriter.reset();
+      FileReader reader(m_tmpFileName);
+      size_t const blockBytes = m_runs.empty()
+                                    ? 0
+                                    : std::max(kMinBlockBytes, m_bufferBytes / m_runs.size());
+      std::vector<RunReader> runs;
+      runs.reserve(m_runs.size());
+      for (auto const & run : m_runs)
+        runs.emplace_back(reader, run, m_format, blockBytes);
+
+      LoserTree tree(runs, m_less);
+      while (!tree.IsEmpty())
+      {
+        m_outputSink(tree.Top());
+        tree.Next();
+      }
+    }
+    FileWriter::DeleteFileX(m_tmpFileName);
+  }
+
+  ~ParallelFileSorter()
+  {
+    if (m_tmpWriter)
+    {
+      try
+      {
+        SortAndFinish();
+      }
+      catch(RootException const & e)
+      {
+        LOG(LERROR, (e.Msg()));
+      }
+      catch(std::exception const & e)
+      {
+        LOG(LERROR, (e.what()));
+      }
+    }
+  }
+
+private:
+  static size_t constexpr kMinBlockBytes = 64 * 1024;
+  // The longest varint of a 64 bits mask and the item.
+  static size_t constexpr kMaxEncodedItemBytes = 10 + sizeof(T);
+
+  struct Run
+  {
+    uint64_t m_offset = 0;
+    uint64_t m_size = 0;
+    uint64_t m_count = 0;
+  };
+
+  class RunReader
+  {
+  public:
+    RunReader(FileReader const & reader, Run const & run, FileSorterRunFormat format,
+              size_t blockBytes)
+      : m_reader(reader)
+      , m_offset(run.m_offset)
+      , m_end(run.m_offset + run.m_size)
+      , m_itemsLeft(run.m_count)
+      , m_format(format)
+      , m_blockBytes(std::max(blockBytes, kMaxEncodedItemBytes))
+    {
+      m_block.reserve(m_blockBytes);
+      Next();
+    }
+
+    bool IsEmpty() const { return !m_hasItem; }
+    T const & Top() const
+    {
+      ASSERT(m_hasItem, ());
+      return m_item;
+    }
+
+    void Next()
+    {
+      m_hasItem = m_itemsLeft != 0;
+      if (!m_hasItem)
+        return;
+
+      --m_itemsLeft;
+      if (m_format == FileSorterRunFormat::Raw)
+      {
+        FillBlock(sizeof(T));
+        CHECK_LESS_OR_EQUAL(m_pos + sizeof(T), m_block.size(), ());
+        memcpy(static_cast<void *>(&m_item), m_block.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return;
+      }
+
+      FillBlock(kMaxEncodedItemBytes);
+      ArrayByteSource src(m_block.data() + m_pos);
+      auto const mask = ReadVarUint<uint64_t>(src);
+      for (size_t i = 0; i < sizeof(T); ++i)
+      {
+        if ((mask >> i) & 1)
+          m_bytes[i] = src.ReadByte();
+      }
+      m_pos = static_cast<size_t>(src.PtrUC() - m_block.data());
+      CHECK_LESS_OR_EQUAL(m_pos, m_block.size(), ());
+      memcpy(static_cast<void *>(&m_item), m_bytes, sizeof(T));
+    }
+
+  private:
+    // Reads the next block of the run if there are less than |bytes| bytes in the block.
+    void FillBlock(size_t bytes)
+    {
+      size_t const available = m_block.size() - m_pos;
+      if (available >= bytes || m_offset == m_end)
+        return;
+
+      m_block.erase(m_block.begin(), m_block.begin() + m_pos);
+      m_pos = 0;
+      auto const size = static_cast<size_t>(
+          std::min<uint64_t>(m_blockBytes - available, m_end - m_offset));
+      m_block.resize(available + size);
+      m_reader.Read(m_offset, m_block.data() + available, size);
+      m_offset += size;
+    }
+
+    FileReader const & m_reader;
+    uint64_t m_offset;
+    uint64_t m_end;
+    uint64_t m_itemsLeft;
+    FileSorterRunFormat m_format;
+    size_t m_blockBytes;
+    std::vector<uint8_t> m_block;
+    size_t m_pos = 0;
+    // The bytes of the previous item of the ByteDelta runs.
+    uint8_t m_bytes[sizeof(T)] = {};
+    T m_item;
+    bool m_hasItem = false;
+  };
+
+  // The losers of the matches between the runs are kept in the inner nodes of the tree,
+  // the winner is kept in the root, so the next item is found with log(runs) comparisons.
+  class LoserTree
+  {
+  public:
+    LoserTree(std::vector<RunReader> & runs, LessT const & fLess) : m_runs(runs), m_less(fLess)
+    {
+      if (m_runs.empty())
+        return;
+
+      m_tree.resize(m_runs.size());
+      m_tree[0] = Build(1);
+    }
+
+    bool IsEmpty() const { return m_tree.empty() || m_runs[m_tree[0]].IsEmpty(); }
+    T const & Top() const { return m_runs[m_tree[0]].Top(); }
+
+    void Next()
+    {
+      auto winner = m_tree[0];
+      m_runs[winner].Next();
+      for (auto node = (winner + m_runs.size()) / 2; node > 0; node /= 2)
+      {
+        if (Beats(m_tree[node], winner))
+          std::swap(m_tree[node], winner);
+      }
+      m_tree[0] = winner;
+    }
+
+  private:
+    // The leaves of the runs are the nodes [runs, 2 * runs).
+    size_t Build(size_t node)
+    {
+      if (node >= m_runs.size())
+        return node - m_runs.size();
+
+      auto const left = Build(2 * node);
+      auto const right = Build(2 * node + 1);
+      if (Beats(left, right))
+      {
+        m_tree[node] = right;
+        return left;
+      }
+      m_tree[node] = left;
+      return right;
+    }
+
+    // The empty runs lose, the equal items are output in the order of the runs.
+    bool Beats(size_t l, size_t r) const
+    {
+      if (m_runs[l].IsEmpty() || m_runs[r].IsEmpty())
+        return !m_runs[l].IsEmpty() || (m_runs[r].IsEmpty() && l < r);
+      if (m_less(m_runs[l].Top(), m_runs[r].Top()))
+        return true;
+      return !m_less(m_runs[r].Top(), m_runs[l].Top()) && l < r;
+    }
+
+    std::vector<RunReader> & m_runs;
+    LessT const & m_less;
+    std::vector<size_t> m_tree;
+  };
+
+  void FlushToTmpFile()
+  {
+    WaitForFlush();
+    if (m_buffer.empty())
+      return;
+
+    m_buffer.swap(m_sortingBuffer);
+    m_buffer.reserve(m_bufferCapacity);
+    m_flush = std::async(std::launch::async, [this]() { SortAndWriteRun(); });
+  }
+
+  void WaitForFlush()
+  {
+    if (m_flush.valid())
+      m_flush.get();
+  }
+
+  void SortAndWriteRun()
+  {
+    if (m_threadsCount > 1)
+    {
+      boost::sort::block_indirect_sort(m_sortingBuffer.begin(), m_sortingBuffer.end(), m_less,
+                                       m_threadsCount);
+    }
+    else
+    {
+      std::sort(m_sortingBuffer.begin(), m_sortingBuffer.end(), m_less);
+    }
+
+    Run run;
+    run.m_offset = m_tmpWriter->Pos();
+    run.m_count = m_sortingBuffer.size();
+    if (m_format == FileSorterRunFormat::Raw)
+    {
+      m_tmpWriter->Write(m_sortingBuffer.data(), m_sortingBuffer.size() * sizeof(T));
+    }
+    else
+    {
+      m_encoded.clear();
+      PushBackByteSink<std::vector<uint8_t>> sink(m_encoded);
+      uint8_t prev[sizeof(T)] = {};
+      uint8_t bytes[sizeof(T)];
+      for (auto const & item : m_sortingBuffer)
+      {
+        memcpy(bytes, &item, sizeof(T));
+        uint64_t mask = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+          if (bytes[i] != prev[i])
+            mask |= uint64_t{1} << i;
+        }
+        WriteVarUint(sink, mask);
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+          if ((mask >> i) & 1)
+            m_encoded.push_back(bytes[i]);
+        }
+        memcpy(prev, bytes, sizeof(T));
+      }
+      m_tmpWriter->Write(m_encoded.data(), m_encoded.size());
+    }
+    run.m_size = m_tmpWriter->Pos() - run.m_offset;
+    m_runs.push_back(run);
+    m_sortingBuffer.clear();
+  }
+
+  std::string const m_tmpFileName;
+  size_t const m_bufferBytes;
+  size_t const m_bufferCapacity;
+  OutputSinkT & m_outputSink;
+  LessT m_less;
+  unsigned int const m_threadsCount;
+  FileSorterRunFormat const m_format;
+  std::unique_ptr<FileWriter> m_tmpWriter;
+  std::vector<T> m_buffer;
+  // The run which is sorted and written by |m_flush|.
+  std::vector<T> m_sortingBuffer;
+  std::vector<uint8_t> m_encoded;
+  std::vector<Run> m_runs;
+  std::future<void> m_flush;
+};
+
+// static
+template <typename T, class OutputSinkT, typename LessT>
+size_t constexpr ParallelFileSorter<T, OutputSinkT, LessT>::kMinBlockBytes;
+
+// static
+template <typename T, class OutputSinkT, typename LessT>
+size_t constexpr ParallelFileSorter<T, OutputSinkT, LessT>::kMaxEncodedItemBytes;
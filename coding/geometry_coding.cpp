@@ -1,12 +1,17 @@
 #include "coding/geometry_coding.hpp"
 
+#include "coding/byte_stream.hpp"
 #include "coding/point_coding.hpp"
+#include "coding/reader.hpp"
+#include "coding/varint.hpp"
 
 #include "geometry/mercator.hpp"
 
 #include "base/assert.hpp"
 
+#include <algorithm>
 #include <complex>
+#include <cstring>
 #include <stack>
 
 using namespace std;
@@ -26,6 +31,55 @@ inline m2::PointU ClampPoint(m2::PointU const & maxPoint, m2::Point<double> cons
       static_cast<uvalue_t>(base::clamp(point.y, 0.0, static_cast<double>(maxPoint.y))));
 }
 
+// Writes the column of |count| deltas as the minimum delta, the width of the differences from it
+// and the differences packed by the width starting from the low bits.
+void WriteDeltasColumn(PushBackByteSink<vector<char>> & sink, int64_t const * deltas, size_t count)
+{
+  auto const minmax = minmax_element(deltas, deltas + count);
+  int64_t const minDelta = *minmax.first;
+  auto const width = static_cast<uint8_t>(
+      bits::NumUsedBits(static_cast<uint64_t>(*minmax.second - minDelta)));
+  WriteVarInt(sink, minDelta);
+  WriteToSink(sink, width);
+
+  uint64_t bitsBuffer = 0;
+  uint32_t bitsCount = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    bitsBuffer |= static_cast<uint64_t>(deltas[i] - minDelta) << bitsCount;
+    bitsCount += width;
+    for (; bitsCount >= 8; bitsCount -= 8)
+    {
+      WriteToSink(sink, static_cast<uint8_t>(bitsBuffer));
+      bitsBuffer >>= 8;
+    }
+  }
+  if (bitsCount != 0)
+    WriteToSink(sink, static_cast<uint8_t>(bitsBuffer));
+}
+
+// Reads the column of |count| deltas written by WriteDeltasColumn().
+void ReadDeltasColumn(ArrayByteSource & source, size_t count, int64_t * deltas)
+{
+  int64_t const minDelta = ReadVarInt<int64_t>(source);
+  uint8_t const width = ReadPrimitiveFromSource<uint8_t>(source);
+  CHECK_LESS_OR_EQUAL(width, 33, ());
+
+  // The column is copied with a zero tail, so the values are read by 8 bytes.
+  size_t const size = (count * width + 7) / 8;
+  uint8_t packed[(coding::kPointsBlockSize * 33 + 7) / 8 + sizeof(uint64_t)] = {};
+  source.Read(packed, size);
+
+  uint64_t const mask = bits::GetFullMask(width);
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t const bit = i * width;
+    uint64_t word;
+    memcpy(&word, packed + bit / 8, sizeof(word));
+    deltas[i] = minDelta + static_cast<int64_t>((word >> (bit % 8)) & mask);
+  }
+}
+
 struct edge_less_p0
 {
   using edge_t = tesselator::Edge;
@@ -291,6 +345,50 @@ void DecodeTriangleStrip(InDeltasT const & deltas, m2::PointU const & basePoint,
     }
   }
 }
+
+void EncodePointsBlocks(InPointsT const & points, m2::PointU const & basePoint,
+                        vector<char> & buffer)
+{
+  PushBackByteSink<vector<char>> sink(buffer);
+  int64_t dx[kPointsBlockSize];
+  int64_t dy[kPointsBlockSize];
+  m2::PointU prev = basePoint;
+  for (size_t beg = 0; beg < points.size(); beg += kPointsBlockSize)
+  {
+    size_t const count = min(kPointsBlockSize, points.size() - beg);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto const & p = points[beg + i];
+      dx[i] = static_cast<int64_t>(p.x) - static_cast<int64_t>(prev.x);
+      dy[i] = static_cast<int64_t>(p.y) - static_cast<int64_t>(prev.y);
+      prev = p;
+    }
+    WriteDeltasColumn(sink, dx, count);
+    WriteDeltasColumn(sink, dy, count);
+  }
+}
+
+void const * DecodePointsBlocks(void const * pBeg, size_t count, m2::PointU const & basePoint,
+                                OutPointsT & points)
+{
+  ArrayByteSource source(pBeg);
+  int64_t dx[kPointsBlockSize];
+  int64_t dy[kPointsBlockSize];
+  m2::PointU prev = basePoint;
+  for (size_t beg = 0; beg < count; beg += kPointsBlockSize)
+  {
+    size_t const blockCount = min(kPointsBlockSize, count - beg);
+    ReadDeltasColumn(source, blockCount, dx);
+    ReadDeltasColumn(source, blockCount, dy);
+    for (size_t i = 0; i < blockCount; ++i)
+    {
+      prev = m2::PointU(static_cast<uint32_t>(prev.x + dx[i]),
+                        static_cast<uint32_t>(prev.y + dy[i]));
+      points.push_back(prev);
+    }
+  }
+  return source.Ptr();
+}
 }  // namespace coding
 
 namespace serial
@@ -2,6 +2,7 @@
 
 #include "geometry/point2d.hpp"
 
+#include "coding/byte_stream.hpp"
 #include "coding/point_coding.hpp"
 #include "coding/tesselator_decl.hpp"
 #include "coding/varint.hpp"
@@ -97,6 +98,22 @@ void EncodeTriangleStrip(InPointsT const & points, m2::PointU const & basePoint,
 
 void DecodeTriangleStrip(InDeltasT const & deltas, m2::PointU const & basePoint,
                          m2::PointU const & maxPoint, OutPointsT & points);
+
+// The points of a block of the columnar encoding.
+size_t constexpr kPointsBlockSize = 64;
+
+// Columnar encoding of a polyline: the points are split into the blocks of kPointsBlockSize
+// points, and a block stores the x deltas and then the y deltas from the previous points.
+// A column of deltas is the minimum delta of the block and the fixed width bit-packed
+// differences from it, so the values of a column are unpacked independently of each other
+// and the points are their prefix sums.
+void EncodePointsBlocks(InPointsT const & points, m2::PointU const & basePoint,
+                        std::vector<char> & buffer);
+
+// Decodes |count| points encoded by EncodePointsBlocks() from |pBeg|.
+// Returns the end of the encoded points.
+void const * DecodePointsBlocks(void const * pBeg, size_t count, m2::PointU const & basePoint,
+                                OutPointsT & points);
 }  // namespace coding
 
 namespace serial
@@ -283,6 +300,46 @@ void LoadOuterPath(TSource & src, GeometryCodingParams const & params, TPoints &
   LoadOuter(&coding::DecodePolyline, src, params, points);
 }
 
+/// @name Paths in the columnar point blocks, see coding::EncodePointsBlocks().
+template <class TSink>
+void SaveOuterPathBlocks(std::vector<m2::PointD> const & points,
+                         GeometryCodingParams const & params, TSink & sink)
+{
+  pts::PointsU upoints;
+  upoints.reserve(points.size());
+  for (auto const & p : points)
+    upoints.push_back(pts::D2U(p, params.GetCoordBits()));
+
+  std::vector<char> buffer;
+  {
+    MemWriter<std::vector<char>> writer(buffer);
+    WriteVarUint(writer, static_cast<uint32_t>(upoints.size()));
+  }
+  coding::EncodePointsBlocks(make_read_adapter(upoints), pts::GetBasePoint(params), buffer);
+
+  WriteBufferToSink(buffer, sink);
+}
+
+template <class TSource, class TPoints>
+void LoadOuterPathBlocks(TSource & src, GeometryCodingParams const & params, TPoints & points)
+{
+  uint32_t const size = ReadVarUint<uint32_t>(src);
+  std::vector<char> buffer(size);
+  src.Read(buffer.data(), size);
+
+  ArrayByteSource source(buffer.data());
+  uint32_t const count = ReadVarUint<uint32_t>(source);
+  pts::PointsU upoints;
+  upoints.resize(count);
+  coding::OutPointsT adapt(upoints);
+  coding::DecodePointsBlocks(source.Ptr(), count, pts::GetBasePoint(params), adapt);
+
+  if (points.size() < 2)
+    points.reserve(count);
+  for (auto const & p : upoints)
+    points.push_back(pts::U2D(p, params.GetCoordBits()));
+}
+
 /// @name Triangles.
 template <class TSink>
 void SaveInnerTriangles(std::vector<m2::PointD> const & points, GeometryCodingParams const & params,
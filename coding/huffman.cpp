@@ -2,6 +2,8 @@
 
 #include "base/logging.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <queue>
 #include <utility>
 
@@ -9,6 +11,11 @@ using namespace std;
 
 namespace coding
 {
+// static
+uint8_t constexpr HuffmanCoder::kLookupBits;
+// static
+size_t constexpr HuffmanCoder::kMaxSymbolsPerLookup;
+
 HuffmanCoder::~HuffmanCoder()
 {
   DeleteHuffmanTree(m_root);
@@ -47,12 +54,48 @@ void HuffmanCoder::BuildTables(Node * root, uint32_t path)
   BuildTables(root->r, path + (static_cast<uint32_t>(1) << root->depth));
 }
 
+void HuffmanCoder::BuildLookupTable()
+{
+  m_lookupTable.clear();
+  m_minCodeLen = 0;
+  if (!m_root || m_root->isLeaf)
+    return;
+
+  m_minCodeLen = numeric_limits<size_t>::max();
+  for (auto const & kv : m_decoderTable)
+    m_minCodeLen = min(m_minCodeLen, kv.first.len);
+
+  m_lookupTable.resize(static_cast<size_t>(1) << kLookupBits);
+  for (uint32_t index = 0; index < m_lookupTable.size(); ++index)
+  {
+    auto & entry = m_lookupTable[index];
+    uint8_t start = 0;
+    Node const * cur = m_root;
+    for (uint8_t i = 0; i < kLookupBits && cur; ++i)
+    {
+      cur = ((index >> i) & 1) == 0 ? cur->l : cur->r;
+      if (!cur || !cur->isLeaf)
+        continue;
+
+      entry.symbols[entry.numSymbols] = cur->symbol;
+      entry.lens[entry.numSymbols] = i + 1 - start;
+      ++entry.numSymbols;
+      if (entry.numSymbols == kMaxSymbolsPerLookup)
+        break;
+      start = i + 1;
+      cur = m_root;
+    }
+  }
+}
+
 void HuffmanCoder::Clear()
 {
   DeleteHuffmanTree(m_root);
   m_root = nullptr;
   m_encoderTable.clear();
   m_decoderTable.clear();
+  m_lookupTable.clear();
+  m_minCodeLen = 0;
 }
 
 void HuffmanCoder::DeleteHuffmanTree(Node * root)
@@ -102,6 +102,7 @@ public:
     Clear();
     BuildHuffmanTree(Freqs(args...));
     BuildTables(m_root, 0);
+    BuildLookupTable();
   }
 
   void Clear();
@@ -163,6 +164,8 @@ public:
       cur->isLeaf = true;
       cur->symbol = symbol;
     }
+
+    BuildLookupTable();
   }
 
   bool Encode(uint32_t symbol, Code & code) const;
@@ -196,14 +199,45 @@ public:
     return EncodeAndWrite(writer, s.begin(), s.end());
   }
 
+  // Decodes up to kMaxSymbolsPerLookup symbols per probe of the lookup table
+  // and walks the tree only for the codes longer than kLookupBits.
+  // Reads exactly the same bytes from |src| as the decoding bit by bit would do.
   template <typename TSource, typename OutIt>
   OutIt ReadAndDecode(TSource & src, OutIt out) const
   {
-    BitReader<TSource> bitReader(src);
     size_t sz = static_cast<size_t>(ReadVarUint<uint32_t, TSource>(src));
-    std::vector<strings::UniChar> v(sz);
-    for (size_t i = 0; i < sz; ++i)
-      *out++ = ReadAndDecode(bitReader);
+    if (sz == 0)
+      return out;
+
+    CHECK(m_root, ("Could not decode a Huffman-encoded symbol."));
+    if (m_root->isLeaf)
+    {
+      for (size_t i = 0; i < sz; ++i)
+        *out++ = m_root->symbol;
+      return out;
+    }
+
+    BufferedBits<TSource> bits(src, m_minCodeLen);
+    while (sz != 0)
+    {
+      bits.Refill(sz);
+      if (bits.Size() >= kLookupBits)
+      {
+        auto const & entry = m_lookupTable[bits.Peek(kLookupBits)];
+        if (entry.numSymbols != 0)
+        {
+          for (size_t i = 0; i < entry.numSymbols && sz != 0; ++i, --sz)
+          {
+            *out++ = entry.symbols[i];
+            bits.Skip(entry.lens[i]);
+          }
+          continue;
+        }
+      }
+
+      *out++ = ReadAndDecode(bits);
+      --sz;
+    }
     return out;
   }
 
@@ -216,6 +250,76 @@ public:
   }
 
 private:
+  // The number of bits used to index the lookup table.
+  static uint8_t constexpr kLookupBits = 10;
+  static size_t constexpr kMaxSymbolsPerLookup = 3;
+
+  // The symbols whose codes fit into the kLookupBits bits of the index, in the order of decoding.
+  struct LookupEntry
+  {
+    uint32_t symbols[kMaxSymbolsPerLookup];
+    uint8_t lens[kMaxSymbolsPerLookup];
+    uint8_t numSymbols = 0;
+  };
+
+  // Bits of the encoded string buffered in a machine word. Reads a byte from the source
+  // only when the remaining symbols have a bit in it, so the source is not read past
+  // the encoded string.
+  template <typename TSource>
+  class BufferedBits
+  {
+  public:
+    BufferedBits(TSource & src, size_t minCodeLen) : m_src(src), m_minCodeLen(minCodeLen) {}
+
+    // Buffers the bits of the next |numSymbols| symbols but not more than a machine word
+    // can hold.
+    void Refill(size_t numSymbols)
+    {
+      // Every symbol has at least m_minCodeLen bits.
+      uint64_t const minRemaining = static_cast<uint64_t>(numSymbols) * m_minCodeLen;
+      while (m_size <= 64 - CHAR_BIT && m_size < minRemaining)
+        ReadByte();
+    }
+
+    uint8_t Size() const { return m_size; }
+
+    uint32_t Peek(uint8_t n) const
+    {
+      return static_cast<uint32_t>(m_buf & ((static_cast<uint64_t>(1) << n) - 1));
+    }
+
+    void Skip(uint8_t n)
+    {
+      ASSERT_LESS_OR_EQUAL(n, m_size, ());
+      m_buf >>= n;
+      m_size -= n;
+    }
+
+    // Returns the next bit. The caller guarantees that the encoded string has one.
+    uint8_t ReadBit()
+    {
+      if (m_size == 0)
+        ReadByte();
+      auto const bit = static_cast<uint8_t>(m_buf & 1);
+      Skip(1);
+      return bit;
+    }
+
+  private:
+    void ReadByte()
+    {
+      uint8_t byte;
+      m_src.Read(&byte, 1);
+      m_buf |= static_cast<uint64_t>(byte) << m_size;
+      m_size += CHAR_BIT;
+    }
+
+    TSource & m_src;
+    size_t const m_minCodeLen;
+    uint64_t m_buf = 0;
+    uint8_t m_size = 0;
+  };
+
   struct Node
   {
     Node *l, *r;
@@ -273,14 +377,14 @@ private:
   }
 
   template <typename TSource>
-  uint32_t ReadAndDecode(BitReader<TSource> & bitReader) const
+  uint32_t ReadAndDecode(BufferedBits<TSource> & bits) const
   {
     Node * cur = m_root;
     while (cur)
     {
       if (cur->isLeaf)
         return cur->symbol;
-      uint8_t bit = bitReader.Read(1);
+      uint8_t bit = bits.ReadBit();
       if (bit == 0)
         cur = cur->l;
       else
@@ -294,6 +398,9 @@ private:
   // of encoding and decoding tables.
   void BuildTables(Node * root, uint32_t path);
 
+  // Builds the lookup table of the decoder from the Huffman tree.
+  void BuildLookupTable();
+
   void DeleteHuffmanTree(Node * root);
 
   void BuildHuffmanTree(Freqs const & freqs);
@@ -305,5 +412,7 @@ private:
   Node * m_root;
   std::map<Code, uint32_t> m_decoderTable;
   std::map<uint32_t, Code> m_encoderTable;
+  std::vector<LookupEntry> m_lookupTable;
+  size_t m_minCodeLen = 0;
 };
 }  // namespace coding
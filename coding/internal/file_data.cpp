@@ -6,6 +6,7 @@
 
 #include "base/exception.hpp"
 #include "base/logging.hpp"
+#include "base/scope_guard.hpp"
 #include "base/string_utils.hpp"
 
 
@@ -17,6 +18,10 @@
 #include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace std;
 
 namespace base
@@ -205,19 +210,69 @@ bool WriteToTempAndRenameToFile(string const & dest, function<bool(string const
   return true;
 }
 
-void AppendFileToFile(string const & fromFilename, string const & toFilename)
+void CopyFileRange(int fromFd, uint64_t fromPos, int toFd, uint64_t toPos, uint64_t size)
 {
-  ifstream from;
-  from.exceptions(fstream::failbit | fstream::badbit);
-  from.open(fromFilename, ios::binary);
+  auto srcPos = static_cast<off64_t>(fromPos);
+  auto dstPos = static_cast<off64_t>(toPos);
+  auto const srcEnd = static_cast<off64_t>(fromPos + size);
+  while (srcPos < srcEnd)
+  {
+    auto const copied = copy_file_range(fromFd, &srcPos, toFd, &dstPos,
+                                        static_cast<size_t>(srcEnd - srcPos), 0 /* flags */);
+    if (copied == -1 && errno == EINTR)
+      continue;
+    if (copied <= 0)
+      break;
+  }
 
-  ofstream to;
-  to.exceptions(fstream::badbit);
-  to.open(toFilename, ios::binary | ios::app);
+  // Copying between the file systems is not supported by old kernels.
+  vector<char> buffer;
+  while (srcPos < srcEnd)
+  {
+    buffer.resize(static_cast<size_t>(min<off64_t>(srcEnd - srcPos, 1024 * 1024)));
+    auto const read = pread(fromFd, buffer.data(), buffer.size(), srcPos);
+    if (read == -1 && errno == EINTR)
+      continue;
+    if (read <= 0)
+      MYTHROW(Reader::ReadException, ("Can't read file:", strerror(errno)));
+
+    for (ssize_t offset = 0; offset < read;)
+    {
+      auto const written = pwrite(toFd, buffer.data() + offset, static_cast<size_t>(read - offset),
+                                  dstPos);
+      if (written == -1 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        MYTHROW(Writer::WriteException, ("Can't write file:", strerror(errno)));
+
+      offset += written;
+      dstPos += written;
+    }
+    srcPos += read;
+  }
+}
 
-  auto * buffer = from.rdbuf();
-  if (from.peek() != ifstream::traits_type::eof())
-    to << buffer;
+void AppendFileToFile(string const & fromFilename, string const & toFilename)
+{
+  int const from = open(fromFilename.c_str(), O_RDONLY);
+  if (from == -1)
+    MYTHROW(Reader::OpenException, ("Can't open file:", fromFilename, strerror(errno)));
+  SCOPE_GUARD(closeFrom, [from]() { close(from); });
+
+  // The data is copied to the end explicitly, because copy_file_range() fails with O_APPEND.
+  int const to = open(toFilename.c_str(), O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (to == -1)
+    MYTHROW(Writer::OpenException, ("Can't open file:", toFilename, strerror(errno)));
+  SCOPE_GUARD(closeTo, [to]() { close(to); });
+
+  struct stat fromStat;
+  struct stat toStat;
+  if (fstat(from, &fromStat) != 0 || fstat(to, &toStat) != 0)
+    MYTHROW(Reader::SizeException, ("Can't get size of files:", fromFilename, toFilename,
+                                    strerror(errno)));
+
+  CopyFileRange(from, 0 /* fromPos */, to, static_cast<uint64_t>(toStat.st_size),
+                static_cast<uint64_t>(fromStat.st_size));
 }
 
 bool CopyFileX(string const & fOld, string const & fNew)
@@ -54,6 +54,13 @@ bool WriteToTempAndRenameToFile(std::string const & dest,
                                 std::function<bool(std::string const &)> const & write,
                                 std::string const & tmp = "");
 
+/// Copies |size| bytes of the file |fromFd| at |fromPos| to the file |toFd| at |toPos|.
+/// The kernel copies the data without moving it through the user space, if the file systems
+/// allow it. Throws Reader::ReadException or Writer::WriteException.
+void CopyFileRange(int fromFd, uint64_t fromPos, int toFd, uint64_t toPos, uint64_t size);
+
+/// Appends |fromFilename| to the end of |toFilename|, see CopyFileRange().
+/// Creates |toFilename| if it doesn't exist.
 void AppendFileToFile(std::string const & fromFilename, std::string const & toFilename);
 
 /// @return false if copy fails. DO NOT THROWS exceptions
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <type_traits>
 #include <unordered_map>
@@ -66,6 +67,10 @@
 // encoded by block encoding callback.
 //
 // On Get call kBlockSize consecutive variables are decoded and cached in RAM.
+//
+// The integral values may be written in the fixed width form by FreezeFixedWidth(): the value
+// of the i-th id is stored raw at the i-th place of the variables, so the table loaded
+// by LoadFixedWidth() reads the single value on Get without decoding and caching the block.
 
 template <typename Value>
 class MapUint32ToValue
@@ -157,31 +162,65 @@ public:
       return false;
 
     uint32_t const rank = static_cast<uint32_t>(m_ids.rank(id));
+    if (m_fixedWidth)
+    {
+      value = ReadFixedWidthValue(rank);
+      return true;
+    }
+
     uint32_t const base = rank / kBlockSize;
     uint32_t const offset = rank % kBlockSize;
 
     auto & entry = m_cache[base];
     if (entry.empty())
-    {
-      entry.resize(kBlockSize);
+      ReadBlock(base, entry);
 
-      auto const start = m_offsets.select(base);
-      auto const end = base + 1 < m_offsets.num_ones()
-                           ? m_offsets.select(base + 1)
-                           : m_header.m_endOffset - m_header.m_variablesOffset;
+    value = entry[offset];
+    return true;
+  }
 
-      std::vector<uint8_t> data(static_cast<size_t>(end - start));
+  // Calls |fn(id, value)| for each of the sorted |ids| which has an entry in the table.
+  // Each block is decoded once for all the ids it covers and the decoded blocks are not
+  // added to the cache, so the batch does not grow the memory footprint of the table.
+  template <typename Fn>
+  void GetMany(std::vector<uint32_t> const & ids, Fn && fn)
+  {
+    ASSERT(std::is_sorted(ids.begin(), ids.end()), ());
 
-      m_reader.Read(m_header.m_variablesOffset + start, data.data(), data.size());
+    std::vector<Value> block;
+    std::vector<Value> * values = nullptr;
+    uint32_t valuesBase = std::numeric_limits<uint32_t>::max();
+    for (auto const id : ids)
+    {
+      if (id >= m_ids.size() || !m_ids[id])
+        continue;
 
-      MemReader mreader(data.data(), data.size());
-      NonOwningReaderSource msource(mreader);
+      uint32_t const rank = static_cast<uint32_t>(m_ids.rank(id));
+      if (m_fixedWidth)
+      {
+        Value value = ReadFixedWidthValue(rank);
+        fn(id, value);
+        continue;
+      }
 
-      m_readBlockCallback(msource, kBlockSize, entry);
-    }
+      uint32_t const base = rank / kBlockSize;
+      if (base != valuesBase)
+      {
+        valuesBase = base;
+        auto const it = m_cache.find(base);
+        if (it != m_cache.end() && !it->second.empty())
+        {
+          values = &it->second;
+        }
+        else
+        {
+          ReadBlock(base, block);
+          values = &block;
+        }
+      }
 
-    value = entry[offset];
-    return true;
+      fn(id, (*values)[rank % kBlockSize]);
+    }
   }
 
   // Loads MapUint32ToValue instance. Note that |reader| must be alive
@@ -203,20 +242,72 @@ public:
     return table;
   }
 
+  // Loads the table written by MapUint32ToValueBuilder::FreezeFixedWidth().
+  // Returns nullptr if the table can't be loaded.
+  static std::unique_ptr<MapUint32ToValue> LoadFixedWidth(Reader & reader)
+  {
+    static_assert(std::is_integral<Value>::value, "Only integral values have the fixed width.");
+
+    uint16_t const version = ReadPrimitiveFromPos<uint16_t>(reader, 0 /* pos */);
+    if (version != 0)
+      return {};
+
+    auto table = std::make_unique<MapUint32ToValue>(reader, ReadBlockCallback());
+    table->m_fixedWidth = true;
+    if (!table->Init())
+      return {};
+    return table;
+  }
+
+  // Calls |fn(id, value)| for all the entries in the order of ids.
+  // The blocks are decoded one by one and are not added to the cache.
   template <typename Fn>
   void ForEach(Fn && fn)
   {
+    std::vector<Value> block;
     for (uint64_t i = 0; i < m_ids.num_ones(); ++i)
     {
       auto const j = static_cast<uint32_t>(m_ids.select(i));
-      Value value{};
-      bool const ok = Get(j, value);
-      CHECK(ok, ());
-      fn(j, value);
+      auto const rank = static_cast<uint32_t>(i);
+      if (m_fixedWidth)
+      {
+        Value value = ReadFixedWidthValue(rank);
+        fn(j, value);
+        continue;
+      }
+
+      if (rank % kBlockSize == 0)
+        ReadBlock(rank / kBlockSize, block);
+      fn(j, block[rank % kBlockSize]);
     }
   }
 
 private:
+  void ReadBlock(uint32_t base, std::vector<Value> & values)
+  {
+    values.resize(kBlockSize);
+
+    auto const start = m_offsets.select(base);
+    auto const end = base + 1 < m_offsets.num_ones()
+                         ? m_offsets.select(base + 1)
+                         : m_header.m_endOffset - m_header.m_variablesOffset;
+
+    std::vector<uint8_t> data(static_cast<size_t>(end - start));
+
+    m_reader.Read(m_header.m_variablesOffset + start, data.data(), data.size());
+
+    MemReader mreader(data.data(), data.size());
+    NonOwningReaderSource msource(mreader);
+
+    m_readBlockCallback(msource, kBlockSize, values);
+  }
+
+  Value ReadFixedWidthValue(uint32_t rank) const
+  {
+    return ReadPrimitiveFromPos<Value>(
+        m_reader, m_header.m_variablesOffset + static_cast<uint64_t>(rank) * sizeof(Value));
+  }
+
   bool Init()
   {
     m_header.Read(m_reader);
@@ -244,6 +335,13 @@ private:
       EndiannessAwareMap(endiannesMismatch, *m_offsetsRegion, m_offsets);
     }
 
+    if (m_fixedWidth &&
+        m_header.m_endOffset - m_header.m_variablesOffset != m_ids.num_ones() * sizeof(Value))
+    {
+      LOG(LERROR, ("The values are not of the fixed width:", sizeof(Value)));
+      return false;
+    }
+
     return true;
   }
 
@@ -275,6 +373,7 @@ private:
   succinct::elias_fano m_offsets;
 
   ReadBlockCallback m_readBlockCallback;
+  bool m_fixedWidth = false;
 
   std::unordered_map<uint32_t, std::vector<Value>> m_cache;
 };
@@ -296,6 +395,14 @@ public:
     m_ids.push_back(id);
   }
 
+  // Calls |fn(id, value)| for all the put entries in the order of ids.
+  template <typename Fn>
+  void ForEach(Fn && fn) const
+  {
+    for (size_t i = 0; i < m_ids.size(); ++i)
+      fn(m_ids[i], m_values[i]);
+  }
+
   // It's guaranteed that |writeBlockCallback| will not be called for empty block.
   void Freeze(Writer & writer, WriteBlockCallback const & writeBlockCallback) const
   {
@@ -355,6 +462,17 @@ public:
     writer.Seek(endOffset);
   }
 
+  // Writes the values of the fixed width to be read by Map::LoadFixedWidth().
+  void FreezeFixedWidth(Writer & writer) const
+  {
+    static_assert(std::is_integral<Value>::value, "Only integral values have the fixed width.");
+
+    Freeze(writer, [](Writer & w, Iter begin, Iter end) {
+      for (auto it = begin; it != end; ++it)
+        WriteToSink(w, *it);
+    });
+  }
+
 private:
   std::vector<Value> m_values;
   std::vector<uint32_t> m_ids;
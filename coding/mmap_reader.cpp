@@ -1,6 +1,5 @@
 #include "coding/mmap_reader.hpp"
 
-
 #include <cstring>
 
 #include <unistd.h>
@@ -76,6 +75,38 @@ unique_ptr<Reader> MmapReader::CreateSubReader(uint64_t pos, uint64_t size) cons
   return unique_ptr<Reader>(new MmapReader(*this, m_offset + pos, size));
 }
 
+void const * MmapReader::GetDirectData() const
+{
+  return m_data->m_memory + m_offset;
+}
+
+void MmapReader::Advise(Advice advice, bool hugePages) const
+{
+  if (m_size == 0)
+    return;
+
+  // madvise() needs the page aligned address.
+  auto const pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  auto const begin = m_offset / pageSize * pageSize;
+  auto * memory = m_data->m_memory + begin;
+  auto const size = static_cast<size_t>(m_offset + m_size - begin);
+
+  int flag = MADV_NORMAL;
+  switch (advice)
+  {
+  case Advice::Normal: flag = MADV_NORMAL; break;
+  case Advice::Sequential: flag = MADV_SEQUENTIAL; break;
+  case Advice::Random: flag = MADV_RANDOM; break;
+  case Advice::WillNeed: flag = MADV_WILLNEED; break;
+  }
+  madvise(memory, size, flag);
+
+#ifdef MADV_HUGEPAGE
+  if (hugePages)
+    madvise(memory, size, MADV_HUGEPAGE);
+#endif
+}
+
 uint8_t * MmapReader::Data() const
 {
   return m_data->m_memory;
@@ -10,11 +10,28 @@
 class MmapReader : public ModelReader
 {
 public:
+  // The expected access pattern of the memory of a reader.
+  enum class Advice
+  {
+    Normal,
+    Sequential,
+    Random,
+    // The memory will be accessed soon, the kernel may read it ahead.
+    WillNeed
+  };
+
   explicit MmapReader(std::string const & fileName);
 
   uint64_t Size() const override;
   void Read(uint64_t pos, void * p, size_t size) const override;
   std::unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const override;
+  void const * GetDirectData() const override;
+
+  // Hints the kernel how the range of this reader will be accessed. The hint applies to the
+  // mapping shared by all the sub readers, the pages which the range only touches are
+  // advised too. |hugePages| asks for the transparent huge pages where the kernel
+  // supports them for the files. The hints are best effort: the failures are ignored.
+  void Advise(Advice advice, bool hugePages = false) const;
 
   /// Direct file/memory access
   uint8_t * Data() const;
@@ -28,6 +28,10 @@ public:
   virtual void Read(uint64_t pos, void * p, size_t size) const = 0;
   virtual std::unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const = 0;
 
+  // The data of the reader when it is a block of memory which lives as long as the reader,
+  // nullptr otherwise. Allows to decode the data in place instead of copying it with Read().
+  virtual void const * GetDirectData() const { return nullptr; }
+
   void ReadAsString(std::string & s) const;
 
   // Reads the contents of this Reader to a vector of 8-bit bytes.
@@ -68,6 +72,8 @@ public:
     return std::make_unique<MemReaderTemplate>(m_pData + pos, static_cast<size_t>(size));
   }
 
+  void const * GetDirectData() const override { return m_pData; }
+
 private:
   bool GoodPosAndSize(uint64_t pos, uint64_t size) const
   {
@@ -129,6 +135,8 @@ public:
     return {m_p->CreateSubReader(pos, size)};
   }
 
+  void const * GetDirectData() const { return m_p->GetDirectData(); }
+
   TReader * GetPtr() const { return m_p.get(); }
 };
 
@@ -89,6 +89,31 @@ bool IsSupportedLangCode(int8_t langCode)
   return langCode >= 0 && langCode < static_cast<int8_t>(kLanguages.size()) &&
          kLanguages[langCode].m_code != StringUtf8Multilang::kReservedLang;
 }
+
+size_t GetNextIndex(char const * s, size_t sz, size_t i)
+{
+  ++i;
+
+  while (i < sz && (s[i] & 0xC0) != 0x80)
+  {
+    if ((s[i] & 0x80) == 0)
+      i += 1;
+    else if ((s[i] & 0xFE) == 0xFE)
+      i += 7;
+    else if ((s[i] & 0xFC) == 0xFC)
+      i += 6;
+    else if ((s[i] & 0xF8) == 0xF8)
+      i += 5;
+    else if ((s[i] & 0xF0) == 0xF0)
+      i += 4;
+    else if ((s[i] & 0xE0) == 0xE0)
+      i += 3;
+    else if ((s[i] & 0xC0) == 0xC0)
+      i += 2;
+  }
+
+  return i;
+}
 }  // namespace
 
 int8_t constexpr StringUtf8Multilang::kUnsupportedLanguageCode;
@@ -154,30 +179,14 @@ char const * StringUtf8Multilang::GetTransliteratorIdByCode(int8_t langCode)
   return kLanguages[langCode].m_transliteratorId;
 }
 
-size_t StringUtf8Multilang::GetNextIndex(size_t i) const
+StringUtf8Multilang::StringUtf8Multilang(StringUtf8MultilangView const & view)
+  : m_s(view.Data(), view.Size())
 {
-  ++i;
-  size_t const sz = m_s.size();
-
-  while (i < sz && (m_s[i] & 0xC0) != 0x80)
-  {
-    if ((m_s[i] & 0x80) == 0)
-      i += 1;
-    else if ((m_s[i] & 0xFE) == 0xFE)
-      i += 7;
-    else if ((m_s[i] & 0xFC) == 0xFC)
-      i += 6;
-    else if ((m_s[i] & 0xF8) == 0xF8)
-      i += 5;
-    else if ((m_s[i] & 0xF0) == 0xF0)
-      i += 4;
-    else if ((m_s[i] & 0xE0) == 0xE0)
-      i += 3;
-    else if ((m_s[i] & 0xC0) == 0xC0)
-      i += 2;
-  }
+}
 
-  return i;
+size_t StringUtf8Multilang::GetNextIndex(size_t i) const
+{
+  return ::GetNextIndex(m_s.data(), m_s.size(), i);
 }
 
 void StringUtf8Multilang::AddString(int8_t lang, string const & utf8s)
@@ -205,27 +214,7 @@ void StringUtf8Multilang::AddString(int8_t lang, string const & utf8s)
 
 bool StringUtf8Multilang::GetString(int8_t lang, string & utf8s) const
 {
-  if (!IsSupportedLangCode(lang))
-    return false;
-
-  size_t i = 0;
-  size_t const sz = m_s.size();
-
-  while (i < sz)
-  {
-    size_t const next = GetNextIndex(i);
-
-    if ((m_s[i] & 0x3F) == lang)
-    {
-      ++i;
-      utf8s.assign(m_s.c_str() + i, next - i);
-      return true;
-    }
-
-    i = next;
-  }
-
-  return false;
+  return GetView().GetString(lang, utf8s);
 }
 
 StringUtf8Multilang::TranslationPositions StringUtf8Multilang::GenerateTranslationPositions() const
@@ -254,16 +243,7 @@ std::string StringUtf8Multilang::GetTranslation(
 
 bool StringUtf8Multilang::HasString(int8_t lang) const
 {
-  if (!IsSupportedLangCode(lang))
-    return false;
-
-  for (size_t i = 0; i < m_s.size(); i = GetNextIndex(i))
-  {
-    if ((m_s[i] & 0x3F) == lang)
-      return true;
-  }
-
-  return false;
+  return GetView().HasString(lang);
 }
 
 int8_t StringUtf8Multilang::FindString(string const & utf8s) const
@@ -284,11 +264,7 @@ int8_t StringUtf8Multilang::FindString(string const & utf8s) const
 
 size_t StringUtf8Multilang::CountLangs() const
 {
-  size_t count = 0;
-  for (size_t i = 0; i < m_s.size(); i = GetNextIndex(i))
-    ++count;
-
-  return count;
+  return GetView().CountLangs();
 }
 
 string DebugPrint(StringUtf8Multilang const & s)
@@ -301,3 +277,61 @@ string DebugPrint(StringUtf8Multilang const & s)
 
   return result;
 }
+
+bool StringUtf8MultilangView::GetString(int8_t lang, boost::string_view & utf8s) const
+{
+  if (!IsSupportedLangCode(lang))
+    return false;
+
+  size_t i = 0;
+  while (i < m_size)
+  {
+    size_t const next = GetNextIndex(i);
+
+    if ((m_data[i] & 0x3F) == lang)
+    {
+      ++i;
+      utf8s = boost::string_view(m_data + i, next - i);
+      return true;
+    }
+
+    i = next;
+  }
+
+  return false;
+}
+
+bool StringUtf8MultilangView::GetString(int8_t lang, string & utf8s) const
+{
+  boost::string_view view;
+  if (!GetString(lang, view))
+    return false;
+
+  utf8s.assign(view.data(), view.size());
+  return true;
+}
+
+bool StringUtf8MultilangView::HasString(int8_t lang) const
+{
+  boost::string_view unused;
+  return GetString(lang, unused);
+}
+
+size_t StringUtf8MultilangView::CountLangs() const
+{
+  size_t count = 0;
+  for (size_t i = 0; i < m_size; i = GetNextIndex(i))
+    ++count;
+
+  return count;
+}
+
+size_t StringUtf8MultilangView::GetNextIndex(size_t i) const
+{
+  return ::GetNextIndex(m_data, m_size, i);
+}
+
+string DebugPrint(StringUtf8MultilangView const & s)
+{
+  return DebugPrint(StringUtf8Multilang(s));
+}
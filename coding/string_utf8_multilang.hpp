@@ -14,6 +14,8 @@
 #include <string>
 #include <utility>
 
+#include <boost/utility/string_view.hpp>
+
 namespace utils
 {
 template <class TSink, bool EnableExceptions = false>
@@ -61,6 +63,8 @@ void ReadString(TSource & src, std::string & s)
 //   string for the next language. Note that this breaks the self-synchronization property.
 //
 // * The order of the stored strings is not specified. Any language may come first.
+class StringUtf8MultilangView;
+
 class StringUtf8Multilang
 {
 public:
@@ -107,9 +111,16 @@ public:
   inline bool operator==(StringUtf8Multilang const & rhs) const { return m_s == rhs.m_s; }
   inline bool operator!=(StringUtf8Multilang const & rhs) const { return !(*this == rhs); }
 
+  StringUtf8Multilang() = default;
+  // Copies the strings of |view|.
+  explicit StringUtf8Multilang(StringUtf8MultilangView const & view);
+
   inline void Clear() { m_s.clear(); }
   inline bool IsEmpty() const { return m_s.empty(); }
 
+  // The view is valid while this multilang string is alive and not modified.
+  StringUtf8MultilangView GetView() const;
+
   void AddString(int8_t lang, std::string const & utf8s);
   void AddString(std::string const & lang, std::string const & utf8s)
   {
@@ -201,4 +212,66 @@ private:
   std::string m_s;
 };
 
+// A non-owning view of the strings of StringUtf8Multilang serialized in a memory buffer,
+// e.g. in the feature data or in an arena. The buffer must outlive the view.
+class StringUtf8MultilangView
+{
+public:
+  StringUtf8MultilangView() = default;
+  StringUtf8MultilangView(char const * data, size_t size) : m_data(data), m_size(size) {}
+
+  // Reads the view of the string written by StringUtf8Multilang::Write() from |src|
+  // and skips the string in |src|.
+  template <class TSource>
+  static StringUtf8MultilangView Read(TSource & src)
+  {
+    uint32_t const sz = ReadVarUint<uint32_t>(src) + 1;
+    StringUtf8MultilangView view(src.PtrC(), sz);
+    src.Advance(sz);
+    return view;
+  }
+
+  char const * Data() const { return m_data; }
+  size_t Size() const { return m_size; }
+  bool IsEmpty() const { return m_size == 0; }
+
+  // Calls |fn| for each pair of |lang| and |utf8s| in the view.
+  // |utf8s| is a boost::string_view into the viewed buffer.
+  template <typename Fn>
+  void ForEach(Fn && fn) const
+  {
+    size_t i = 0;
+    base::ControlFlowWrapper<Fn> wrapper(std::forward<Fn>(fn));
+    while (i < m_size)
+    {
+      size_t const next = GetNextIndex(i);
+      int8_t const code = m_data[i] & 0x3F;
+      if (StringUtf8Multilang::GetLangByCode(code) != StringUtf8Multilang::kReservedLang &&
+          wrapper(code, boost::string_view(m_data + i + 1, next - i - 1)) ==
+              base::ControlFlow::Break)
+      {
+        break;
+      }
+      i = next;
+    }
+  }
+
+  bool GetString(int8_t lang, boost::string_view & utf8s) const;
+  bool GetString(int8_t lang, std::string & utf8s) const;
+  bool HasString(int8_t lang) const;
+  size_t CountLangs() const;
+
+private:
+  size_t GetNextIndex(size_t i) const;
+
+  char const * m_data = nullptr;
+  size_t m_size = 0;
+};
+
+inline StringUtf8MultilangView StringUtf8Multilang::GetView() const
+{
+  return StringUtf8MultilangView(m_s.data(), m_s.size());
+}
+
 std::string DebugPrint(StringUtf8Multilang const & s);
+std::string DebugPrint(StringUtf8MultilangView const & s);
@@ -11,8 +11,12 @@
 #include "3party/icu/i18n/unicode/translit.h"
 #include "3party/icu/i18n/unicode/utrans.h"
 
+#include <array>
 #include <cstring>
+#include <functional>
 #include <mutex>
+#include <unordered_map>
+#include <utility>
 
 struct Transliteration::TransliteratorInfo
 {
@@ -25,8 +29,86 @@ struct Transliteration::TransliteratorInfo
   std::unique_ptr<Transliterator> m_transliterator;
 };
 
+// The memoized results of the transliterations keyed by the language code followed by the string.
+// A thread looks the results up in its own cache first and then in the shared one, which is split
+// into the shards with their own mutexes. A cache is cleared when it grows too big.
+class Transliteration::Cache
+{
+public:
+  template <typename Fn>
+  bool Get(std::string const & str, int8_t langCode, std::string & out, Fn && transliterate)
+  {
+    thread_local LocalCache local;
+    local.m_key.assign(1, static_cast<char>(langCode));
+    local.m_key.append(str);
+
+    auto const it = local.m_results.find(local.m_key);
+    if (it != local.m_results.end())
+      return Output(it->second, out);
+
+    auto & shard = m_shards[std::hash<std::string>()(local.m_key) % kShardsCount];
+    Result result;
+    bool found = false;
+    {
+      std::lock_guard<std::mutex> lock(shard.m_mutex);
+      auto const sit = shard.m_results.find(local.m_key);
+      if (sit != shard.m_results.end())
+      {
+        result = sit->second;
+        found = true;
+      }
+    }
+
+    if (!found)
+    {
+      result.first = transliterate(result.second);
+      std::lock_guard<std::mutex> lock(shard.m_mutex);
+      if (shard.m_results.size() >= kMaxShardSize)
+        shard.m_results.clear();
+      shard.m_results.emplace(local.m_key, result);
+    }
+
+    if (local.m_results.size() >= kMaxLocalSize)
+      local.m_results.clear();
+    auto const & cached = local.m_results.emplace(local.m_key, std::move(result)).first->second;
+    return Output(cached, out);
+  }
+
+private:
+  // Whether the transliteration succeeded and its result.
+  using Result = std::pair<bool, std::string>;
+  using Results = std::unordered_map<std::string, Result>;
+
+  struct LocalCache
+  {
+    // The buffer of the key is reused by the lookups.
+    std::string m_key;
+    Results m_results;
+  };
+
+  struct Shard
+  {
+    std::mutex m_mutex;
+    Results m_results;
+  };
+
+  static size_t constexpr kShardsCount = 16;
+  static size_t constexpr kMaxShardSize = 64 * 1024;
+  static size_t constexpr kMaxLocalSize = 16 * 1024;
+
+  static bool Output(Result const & result, std::string & out)
+  {
+    // The result is appended to |out| as UnicodeString::toUTF8String() does.
+    if (result.first)
+      out.append(result.second);
+    return result.first;
+  }
+
+  std::array<Shard, kShardsCount> m_shards;
+};
+
 Transliteration::Transliteration()
-  : m_mode(Mode::Enabled)
+  : m_mode(Mode::Enabled), m_cache(std::make_unique<Cache>())
 {}
 
 Transliteration::~Transliteration()
@@ -74,6 +156,14 @@ bool Transliteration::Transliterate(std::string const & str, int8_t langCode, st
   if (str.empty() || strings::IsASCIIString(str))
     return false;
 
+  return m_cache->Get(str, langCode, out, [&](std::string & result) {
+    return TransliterateImpl(str, langCode, result);
+  });
+}
+
+bool Transliteration::TransliterateImpl(std::string const & str, int8_t langCode,
+                                        std::string & out) const
+{
   std::string transliteratorId(StringUtf8Multilang::GetTransliteratorIdByCode(langCode));
 
   if (transliteratorId.empty())
@@ -110,8 +200,16 @@ bool Transliteration::Transliterate(std::string const & str, int8_t langCode, st
   if (it->second->m_transliterator == nullptr)
     return false;
 
+  // ICU transliterators must not be used by several threads at once, so every thread uses
+  // its own clones. They are destroyed with the thread.
+  thread_local std::unordered_map<TransliteratorInfo const *, std::unique_ptr<Transliterator>>
+      threadTransliterators;
+  auto & transliterator = threadTransliterators[it->second.get()];
+  if (!transliterator)
+    transliterator.reset(it->second->m_transliterator->clone());
+
   UnicodeString ustr(str.c_str());
-  it->second->m_transliterator->transliterate(ustr);
+  transliterator->transliterate(ustr);
 
   if (ustr.isEmpty())
     return false;
@@ -22,13 +22,20 @@ public:
   void Init(std::string const & icuDataDir);
 
   void SetMode(Mode mode);
+  // The results are memoized: a repeated transliteration of the same string costs a lookup in
+  // a thread local cache or in a shared one. Safe to call from several threads.
   bool Transliterate(std::string const & str, int8_t langCode, std::string & out) const;
 
 private:
+  struct TransliteratorInfo;
+  class Cache;
+
   Transliteration();
 
+  bool TransliterateImpl(std::string const & str, int8_t langCode, std::string & out) const;
+
   std::atomic<Mode> m_mode;
 
-  struct TransliteratorInfo;
   std::map<std::string, std::unique_ptr<TransliteratorInfo>> m_transliterators;
+  std::unique_ptr<Cache> m_cache;
 };
@@ -23,7 +23,8 @@ inline uint32_t VarRecordSizeReaderFixed(ArrayByteSource & source)
 
 // Efficiently reads records, encoded as [VarUint size] [Data] .. [VarUint size] [Data].
 // If size of a record is less than expectedRecordSize, exactly 1 Reader.Read() call is made,
-// otherwise exactly 2 Reader.Read() calls are made.
+// otherwise exactly 2 Reader.Read() calls are made. When the reader is a block of memory
+// (see Reader::GetDirectData()), ForEachRecord() hands out the records in place without copying.
 // Second template parameter is strategy for reading record size,
 // either &VarRecordSizeReaderVarint or &VarRecordSizeReaderFixed.
 template <class ReaderT, uint32_t (*VarRecordSizeReaderFn)(ArrayByteSource &)>
@@ -31,7 +32,10 @@ class VarRecordReader
 {
 public:
   VarRecordReader(ReaderT const & reader, uint32_t expectedRecordSize)
-  : m_Reader(reader), m_ReaderSize(reader.Size()), m_ExpectedRecordSize(expectedRecordSize)
+  : m_Reader(reader)
+  , m_ReaderSize(reader.Size())
+  , m_Data(static_cast<char const *>(m_Reader.GetDirectData()))
+  , m_ExpectedRecordSize(expectedRecordSize)
   {
     ASSERT_GREATER_OR_EQUAL(expectedRecordSize, 4, ());
   }
@@ -66,6 +70,20 @@ public:
   void ForEachRecord(F const & f) const
   {
     uint64_t pos = 0;
+    if (m_Data)
+    {
+      while (pos < m_ReaderSize)
+      {
+        ArrayByteSource source(m_Data + pos);
+        uint32_t const size = VarRecordSizeReaderFn(source);
+        // uint64_t -> uint32_t : assume that feature dat file not more than 4Gb
+        f(static_cast<uint32_t>(pos), source.PtrC(), size);
+        pos = static_cast<uint64_t>(source.PtrC() - m_Data) + size;
+      }
+      ASSERT_EQUAL(pos, m_ReaderSize, ());
+      return;
+    }
+
     std::vector<char> buffer;
     while (pos < m_ReaderSize)
     {
@@ -83,5 +101,7 @@ public:
 protected:
   ReaderT m_Reader;
   uint64_t m_ReaderSize;
+  // The data of |m_Reader| when it is a block of memory, nullptr otherwise.
+  char const * m_Data;
   uint32_t m_ExpectedRecordSize; // Expected size of a record.
 };
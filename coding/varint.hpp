@@ -1,5 +1,6 @@
 #pragma once
 
+#include "coding/endianness.hpp"
 #include "coding/write_to_sink.hpp"
 
 #include "base/assert.hpp"
@@ -10,6 +11,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 /// This function writes, using optimal bytes count.
@@ -251,19 +253,58 @@ void const * ReadVarInt64Array(void const * pBeg, WhileConditionT whileCondition
   return p;
 }
 
+// Reads the varints by 8-byte words while the whole word is before |pEnd|. The word without
+// the continuation bits is 8 one-byte values, and a value up to 8 bytes long is gathered
+// from the word at once by its stop bit. The longer values and the tail are read byte by byte.
+// The results are the same as the ones of the byte loop.
+template <typename ConverterT, typename F>
+void const * ReadVarInt64ArrayByWords(void const * pBeg, void const * pEnd, F f,
+                                      ConverterT converter)
+{
+  uint8_t const * p = static_cast<uint8_t const *>(pBeg);
+  uint8_t const * const end = static_cast<uint8_t const *>(pEnd);
+  uint64_t constexpr kHighBits = 0x8080808080808080ULL;
+  while (!IsBigEndianMacroBased() && end - p >= 8)
+  {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    uint64_t const stops = ~word & kHighBits;
+    if (stops == kHighBits)
+    {
+      for (size_t i = 0; i < 8; ++i)
+        f(converter(static_cast<uint64_t>(p[i])));
+      p += 8;
+      continue;
+    }
+
+    if (stops == 0)
+      break;
+
+    auto const stopBit = static_cast<uint32_t>(__builtin_ctzll(stops));
+    uint64_t const bytes = word & (~0ULL >> (63 - stopBit));
+    uint64_t const value = (bytes & 0x7FULL) | ((bytes >> 1) & (0x7FULL << 7)) |
+                           ((bytes >> 2) & (0x7FULL << 14)) | ((bytes >> 3) & (0x7FULL << 21)) |
+                           ((bytes >> 4) & (0x7FULL << 28)) | ((bytes >> 5) & (0x7FULL << 35)) |
+                           ((bytes >> 6) & (0x7FULL << 42)) | ((bytes >> 7) & (0x7FULL << 49));
+    f(converter(value));
+    p += (stopBit + 1) / 8;
+  }
+
+  return ReadVarInt64Array(p, ReadVarInt64ArrayUntilBufferEnd(pEnd), f, converter);
 }
+}  // namespace impl
 
 template <typename F>
 void const * ReadVarInt64Array(void const * pBeg, void const * pEnd, F f)
 {
-  return impl::ReadVarInt64Array<int64_t (*)(uint64_t)>(
-        pBeg, impl::ReadVarInt64ArrayUntilBufferEnd(pEnd), f, &bits::ZigZagDecode);
+  return impl::ReadVarInt64ArrayByWords<int64_t (*)(uint64_t)>(pBeg, pEnd, f,
+                                                               &bits::ZigZagDecode);
 }
 
 template <typename F>
 void const * ReadVarUint64Array(void const * pBeg, void const * pEnd, F f)
 {
-  return impl::ReadVarInt64Array(pBeg, impl::ReadVarInt64ArrayUntilBufferEnd(pEnd), f, base::IdFunctor());
+  return impl::ReadVarInt64ArrayByWords(pBeg, pEnd, f, base::IdFunctor());
 }
 
 template <typename F>
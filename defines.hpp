@@ -8,6 +8,7 @@
 #define DIFF_APPLYING_FILE_EXTENSION ".diff.applying"
 #define FONT_FILE_EXTENSION ".ttf"
 #define OSM2FEATURE_FILE_EXTENSION ".osm2ft"
+#define FEATURES_CHUNKS_FILE_EXTENSION ".chunks"
 #define EXTENSION_TMP ".tmp"
 #define ADDR_FILE_EXTENSION ".addr"
 #define RAW_GEOM_FILE_EXTENSION ".rawgeom"
@@ -19,8 +20,11 @@
 #define WAYS_FILE "ways.dat"
 #define RELATIONS_FILE "relations.dat"
 #define TOWNS_FILE "towns.csv"
+#define O5M_RESETS_FILE "o5m_resets.dat"
 #define OFFSET_EXT ".offs"
 #define ID2REL_EXT ".id2rel"
+#define SUCCINCT_OFFSET_EXT ".ef"
+#define OVERLAY_EXT ".overlay"
 
 #define CENTERS_FILE_TAG "centers"
 #define DATA_FILE_TAG "dat"
@@ -1,7 +1,36 @@
 #include "generator/affiliation.hpp"
 
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace generator::regions;
+
 namespace feature
 {
+namespace
+{
+// A point may be placed to a neighbouring cell by the rounding, so the cells are tested
+// with the margins of this share of the cell size.
+double const kCellMargin = 1e-3;
+
+size_t GetIndex(double value, double min, double step, size_t count)
+{
+  auto const index = std::floor((value - min) / step);
+  if (!(index > 0))
+    return 0;
+  return std::min(static_cast<size_t>(index), count - 1);
+}
+
+double GetStep(double min, double max, size_t count)
+{
+  auto const step = (max - min) / count;
+  return step > 0 ? step : 1.0;
+}
+}  // namespace
+
 SingleAffiliation::SingleAffiliation(std::string const & filename)
   : m_filename(filename)
   , m_affilations{std::make_shared<std::vector<std::string>>(std::vector<std::string>{m_filename})}
@@ -18,4 +47,119 @@ bool SingleAffiliation::HasRegionByName(std::string const & name) const
 {
   return name == m_filename;
 }
+// static
+size_t constexpr CountriesAffiliation::kGridSize;
+
+CountriesAffiliation::CountriesAffiliation(Borders const & borders)
+{
+  boost::geometry::assign_inverse(m_rect);
+  m_countries.reserve(borders.size());
+  for (auto const & country : borders)
+  {
+    auto const countryIndex = static_cast<uint32_t>(m_countries.size());
+    m_countries.emplace_back(country.first);
+    for (auto const & polygon : country.second)
+    {
+      m_polygons.push_back({PreparedPolygon(polygon), countryIndex});
+      boost::geometry::expand(m_rect, m_polygons.back().m_polygon.GetRect());
+    }
+  }
+
+  m_cellOffsets.assign(kGridSize * kGridSize + 1, 0);
+  if (m_polygons.empty())
+    return;
+
+  auto const & minCorner = m_rect.min_corner();
+  auto const & maxCorner = m_rect.max_corner();
+  m_cellWidth = GetStep(minCorner.get<0>(), maxCorner.get<0>(), kGridSize);
+  m_cellHeight = GetStep(minCorner.get<1>(), maxCorner.get<1>(), kGridSize);
+
+  auto const forEachCell = [this](PreparedPolygon const & polygon, auto && toDo) {
+    auto const & rect = polygon.GetRect();
+    auto const fromX = GetCellX(rect.min_corner().get<0>());
+    auto const toX = GetCellX(rect.max_corner().get<0>());
+    auto const fromY = GetCellY(rect.min_corner().get<1>());
+    auto const toY = GetCellY(rect.max_corner().get<1>());
+    for (auto y = fromY; y <= toY; ++y)
+    {
+      for (auto x = fromX; x <= toX; ++x)
+        toDo(x, y);
+    }
+  };
+
+  // Count the polygons of the cells and place them by the counts.
+  for (auto const & polygon : m_polygons)
+  {
+    forEachCell(polygon.m_polygon,
+                [this](size_t x, size_t y) { ++m_cellOffsets[y * kGridSize + x + 1]; });
+  }
+  for (size_t i = 1; i < m_cellOffsets.size(); ++i)
+    m_cellOffsets[i] += m_cellOffsets[i - 1];
+
+  m_cellPolygons.resize(m_cellOffsets.back());
+  auto positions = m_cellOffsets;
+  auto const marginX = kCellMargin * m_cellWidth;
+  auto const marginY = kCellMargin * m_cellHeight;
+  for (uint32_t i = 0; i < m_polygons.size(); ++i)
+  {
+    auto const & polygon = m_polygons[i].m_polygon;
+    forEachCell(polygon, [&](size_t x, size_t y) {
+      BoostRect const cell{{minCorner.get<0>() + x * m_cellWidth - marginX,
+                            minCorner.get<1>() + y * m_cellHeight - marginY},
+                           {minCorner.get<0>() + (x + 1) * m_cellWidth + marginX,
+                            minCorner.get<1>() + (y + 1) * m_cellHeight + marginY}};
+      m_cellPolygons[positions[y * kGridSize + x]++] = {i, polygon.CoversRectRough(cell)};
+    });
+  }
+}
+
+std::shared_ptr<std::vector<std::string>> CountriesAffiliation::GetAffiliations(
+    FeatureBuilder const & fb) const
+{
+  std::vector<uint32_t> countries;
+  fb.ForEachGeometryPoint([&](m2::PointD const & point) {
+    Affiliate({point.x, point.y}, countries);
+    return true;
+  });
+
+  auto affiliations = std::make_shared<std::vector<std::string>>();
+  affiliations->reserve(countries.size());
+  std::sort(countries.begin(), countries.end());
+  for (auto const country : countries)
+    affiliations->emplace_back(m_countries[country]);
+  return affiliations;
+}
+
+bool CountriesAffiliation::HasRegionByName(std::string const & name) const
+{
+  return std::binary_search(m_countries.cbegin(), m_countries.cend(), name);
+}
+
+size_t CountriesAffiliation::GetCellX(double x) const
+{
+  return GetIndex(x, m_rect.min_corner().get<0>(), m_cellWidth, kGridSize);
+}
+
+size_t CountriesAffiliation::GetCellY(double y) const
+{
+  return GetIndex(y, m_rect.min_corner().get<1>(), m_cellHeight, kGridSize);
+}
+
+void CountriesAffiliation::Affiliate(BoostPoint const & point,
+                                     std::vector<uint32_t> & countries) const
+{
+  if (!boost::geometry::covered_by(point, m_rect))
+    return;
+
+  auto const cell = GetCellY(point.get<1>()) * kGridSize + GetCellX(point.get<0>());
+  for (auto i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i)
+  {
+    auto const & cellPolygon = m_cellPolygons[i];
+    auto const & polygon = m_polygons[cellPolygon.m_polygon];
+    if (std::find(countries.cbegin(), countries.cend(), polygon.m_country) != countries.cend())
+      continue;
+    if (cellPolygon.m_inside || polygon.m_polygon.Covers(point))
+      countries.emplace_back(polygon.m_country);
+  }
+}
 }  // namespace feature
@@ -1,7 +1,13 @@
 #pragma once
 
 #include "generator/feature_builder.hpp"
+#include "generator/regions/prepared_polygon.hpp"
+#include "generator/regions/region_base.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -31,4 +37,55 @@ private:
   std::string m_filename;
   std::shared_ptr<std::vector<std::string>> m_affilations;
 };
+
+// Affiliates a feature with the countries whose borders cover any point of it. A grid over all
+// the borders keeps the polygons of every cell: the cell is either entirely inside a polygon or
+// near its boundary, the polygons of the other cells are not kept. So most of the points are
+// affiliated by a cell lookup and the exact tests are made near the borders only.
+class CountriesAffiliation : public AffiliationInterface
+{
+public:
+  // The polygons of the country borders by the country names.
+  using Borders = std::map<std::string, std::vector<generator::regions::BoostPolygon>>;
+
+  explicit CountriesAffiliation(Borders const & borders);
+
+  // AffiliationInterface overrides:
+  std::shared_ptr<std::vector<std::string>> GetAffiliations(
+      FeatureBuilder const & fb) const override;
+  bool HasRegionByName(std::string const & name) const override;
+
+private:
+  static size_t constexpr kGridSize = 256;
+
+  struct Polygon
+  {
+    generator::regions::PreparedPolygon m_polygon;
+    uint32_t m_country;
+  };
+
+  struct CellPolygon
+  {
+    uint32_t m_polygon;
+    // The cell is entirely inside the polygon.
+    bool m_inside;
+  };
+
+  size_t GetCellX(double x) const;
+  size_t GetCellY(double y) const;
+  // Adds the countries covering |point| to |countries|.
+  void Affiliate(generator::regions::BoostPoint const & point,
+                 std::vector<uint32_t> & countries) const;
+
+  // Sorted.
+  std::vector<std::string> m_countries;
+  std::vector<Polygon> m_polygons;
+
+  generator::regions::BoostRect m_rect;
+  double m_cellWidth = 1.0;
+  double m_cellHeight = 1.0;
+  // The polygons of cell i are m_cellPolygons[m_cellOffsets[i], m_cellOffsets[i + 1]).
+  std::vector<uint32_t> m_cellOffsets;
+  std::vector<CellPolygon> m_cellPolygons;
+};
 }  // namespace feature
@@ -0,0 +1,129 @@
+#include "generator/batches_governor.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <unistd.h>
+
+namespace generator
+{
+namespace
+{
+// The weight of the last batch in the moving averages.
+double const kAverageWeight = 0.2;
+// The share of the physical memory for the batches in flight.
+uint64_t const kPhysicalMemoryPerBudget = 8;
+// The budget when the physical memory is unknown.
+uint64_t const kFallbackMemoryBudget = uint64_t{1} << 30;
+
+double UpdateAverage(double average, double value)
+{
+  return average == 0.0 ? value : average + kAverageWeight * (value - average);
+}
+}  // namespace
+
+BatchesGovernor::BatchesGovernor(Params const & params)
+  : m_params(params)
+  , m_batchSize(std::min(std::max(params.m_initialBatchSize, params.m_minBatchSize),
+                         params.m_maxBatchSize))
+{
+  CHECK_GREATER(m_params.m_slotsCount, 0, ());
+  CHECK_GREATER(m_params.m_minBatchSize, 0, ());
+  CHECK_LESS_OR_EQUAL(m_params.m_minBatchSize, m_params.m_maxBatchSize, ());
+}
+
+void BatchesGovernor::Acquire(uint64_t bytes)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto const fits = [&] {
+    return m_params.m_memoryBudget == 0 || m_inFlightBytes == 0 ||
+           m_inFlightBytes + bytes <= m_params.m_memoryBudget;
+  };
+  if (!fits())
+  {
+    base::Timer timer;
+    m_cond.wait(lock, fits);
+    m_blockedSeconds += timer.ElapsedSeconds();
+  }
+
+  m_inFlightBytes += bytes;
+  m_maxInFlightBytes = std::max(m_maxInFlightBytes, m_inFlightBytes);
+}
+
+void BatchesGovernor::Release(uint64_t bytes)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CHECK_LESS_OR_EQUAL(bytes, m_inFlightBytes, ());
+    m_inFlightBytes -= bytes;
+  }
+  m_cond.notify_all();
+}
+
+void BatchesGovernor::AddProcessedBatch(size_t elementsCount, uint64_t bytes, double seconds,
+                                        size_t queueDepth)
+{
+  if (elementsCount == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_secondsPerElement = UpdateAverage(m_secondsPerElement, seconds / elementsCount);
+  m_bytesPerElement = UpdateAverage(m_bytesPerElement, static_cast<double>(bytes) / elementsCount);
+
+  auto size = static_cast<double>(m_params.m_maxBatchSize);
+  if (m_secondsPerElement > 0.0)
+    size = std::min(size, m_params.m_targetBatchSeconds / m_secondsPerElement);
+  if (queueDepth == 0)
+    size /= 2;
+  if (m_params.m_memoryBudget != 0 && m_bytesPerElement > 0.0)
+  {
+    auto const slotBytes = static_cast<double>(m_params.m_memoryBudget) / m_params.m_slotsCount;
+    size = std::min(size, slotBytes / m_bytesPerElement);
+  }
+
+  auto const batchSize = static_cast<size_t>(std::round(size));
+  m_batchSize.store(std::min(std::max(batchSize, m_params.m_minBatchSize), m_params.m_maxBatchSize),
+                    std::memory_order_relaxed);
+}
+
+uint64_t BatchesGovernor::GetInFlightBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_inFlightBytes;
+}
+
+uint64_t BatchesGovernor::GetMaxInFlightBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_maxInFlightBytes;
+}
+
+double BatchesGovernor::GetBlockedSeconds() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_blockedSeconds;
+}
+
+void BatchesGovernor::Log() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  LOG(LINFO, ("Batches memory budget:", m_params.m_memoryBudget,
+              "max in flight:", m_maxInFlightBytes, "blocked, s:", m_blockedSeconds,
+              "last batch size:", GetBatchSize(), "bytes per element:", m_bytesPerElement));
+}
+
+uint64_t GetDefaultBatchesMemoryBudget()
+{
+  auto const pages = sysconf(_SC_PHYS_PAGES);
+  auto const pageSize = sysconf(_SC_PAGE_SIZE);
+  if (pages <= 0 || pageSize <= 0)
+    return kFallbackMemoryBudget;
+
+  return static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize) /
+         kPhysicalMemoryPerBudget;
+}
+}  // namespace generator
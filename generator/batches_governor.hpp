@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace generator
+{
+// Governs the batches of a producer-consumer stage of the features generation pipeline, see
+// RawGenerator. The producers acquire the memory of a batch before it is queued and block while
+// the batches in flight use up the memory budget, the consumers release the memory when a batch
+// is processed. The consumers report the processing time of the batches and the governor sizes
+// the next batches to be processed for about the target time: small batches of heavy elements
+// spread the work between the consumers, large batches of light ones cost less synchronization.
+// The batch size is bounded to keep the batches of all the queued and processed slots within
+// the budget.
+class BatchesGovernor
+{
+public:
+  struct Params
+  {
+    // Zero is no limit of the memory of the batches in flight.
+    uint64_t m_memoryBudget = 0;
+    // The batches which fill the queue and are processed by the consumers.
+    size_t m_slotsCount = 1;
+    size_t m_initialBatchSize = 1024;
+    size_t m_minBatchSize = 64;
+    size_t m_maxBatchSize = 64 * 1024;
+    double m_targetBatchSeconds = 0.01;
+  };
+
+  explicit BatchesGovernor(Params const & params);
+
+  // Returns the elements count of the next batch of a producer.
+  size_t GetBatchSize() const { return m_batchSize.load(std::memory_order_relaxed); }
+
+  // Blocks until a batch of |bytes| fits into the budget. A batch is admitted when nothing is
+  // in flight, so a batch larger than the budget does not block forever.
+  void Acquire(uint64_t bytes);
+  void Release(uint64_t bytes);
+
+  // Updates the batch size with a batch of |elementsCount| elements of |bytes| which was
+  // processed for |seconds|. The batches are made smaller when the consumers find
+  // |queueDepth| to be zero, so the work of the starving consumers is spread finer.
+  void AddProcessedBatch(size_t elementsCount, uint64_t bytes, double seconds, size_t queueDepth);
+
+  uint64_t GetInFlightBytes() const;
+  uint64_t GetMaxInFlightBytes() const;
+  // Returns the time producers were blocked by the budget.
+  double GetBlockedSeconds() const;
+
+  void Log() const;
+
+private:
+  Params const m_params;
+  std::atomic<size_t> m_batchSize;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cond;
+  uint64_t m_inFlightBytes = 0;
+  uint64_t m_maxInFlightBytes = 0;
+  double m_blockedSeconds = 0.0;
+  // The moving averages of the processing time and the memory of an element.
+  double m_secondsPerElement = 0.0;
+  double m_bytesPerElement = 0.0;
+};
+
+// Returns the memory budget of the batches in flight of a stage when no one is set: a share of
+// the physical memory of the machine.
+uint64_t GetDefaultBatchesMemoryBudget();
+}  // namespace generator
@@ -0,0 +1,180 @@
+#include "generator/binary_hierarchy_collector.hpp"
+
+#include "geocoder/types.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace generator
+{
+namespace
+{
+// The values are the members of the jansson objects or of the changes of the jansson objects,
+// see JsonObjectPatch::ForEachMember().
+template <typename Fn>
+void ForEachMember(json_t const * object, Fn && fn)
+{
+  if (!json_is_object(object))
+    return;
+
+  char const * key;
+  json_t * value;
+  json_object_foreach(const_cast<json_t *>(object), key, value)
+    fn(key, static_cast<json_t const *>(value));
+}
+
+template <typename Fn>
+void ForEachMember(JsonObjectPatch const & object, Fn && fn)
+{
+  object.ForEachMember(fn);
+}
+
+template <typename Value, typename Fn>
+void ForEachMember(Value const & /* value */, Fn && /* fn */)
+{
+}
+
+bool GetString(json_t const * value, std::string & string)
+{
+  if (!json_is_string(value))
+    return false;
+
+  string.assign(json_string_value(value), json_string_length(value));
+  return true;
+}
+
+bool GetString(std::string const & value, std::string & string)
+{
+  string = value;
+  return true;
+}
+
+template <typename Value>
+bool GetString(Value const & /* value */, std::string & /* string */)
+{
+  return false;
+}
+
+bool GetInt(json_t const * value, int64_t & integer)
+{
+  if (!json_is_integer(value))
+    return false;
+
+  integer = json_integer_value(value);
+  return true;
+}
+
+bool GetInt(int64_t value, int64_t & integer)
+{
+  integer = value;
+  return true;
+}
+
+template <typename Value>
+bool GetInt(Value const & /* value */, int64_t & /* integer */)
+{
+  return false;
+}
+
+bool IsNull(json_t const * value) { return json_is_null(value); }
+
+bool IsNull(JsonObjectPatch::Null) { return true; }
+
+template <typename Value>
+bool IsNull(Value const & /* value */)
+{
+  return false;
+}
+
+// Returns geocoder::Type::Count if |key| is not an address field.
+geocoder::Type GetAddressFieldType(char const * key)
+{
+  static auto const kTypeKeys = []() {
+    std::array<std::string, static_cast<size_t>(geocoder::Type::Count)> keys;
+    for (size_t i = 0; i < keys.size(); ++i)
+      keys[i] = geocoder::ToString(static_cast<geocoder::Type>(i));
+    return keys;
+  }();
+
+  for (size_t i = 0; i < kTypeKeys.size(); ++i)
+  {
+    if (kTypeKeys[i] == key)
+      return static_cast<geocoder::Type>(i);
+  }
+  return geocoder::Type::Count;
+}
+}  // namespace
+
+void BinaryHierarchyCollector::Add(uint64_t key, JsonValue const & value)
+{
+  AddEntry(key, static_cast<json_t const *>(value));
+}
+
+void BinaryHierarchyCollector::Add(uint64_t key, JsonObjectPatch const & value)
+{
+  AddEntry(key, value);
+}
+
+template <typename Value>
+void BinaryHierarchyCollector::AddEntry(uint64_t key, Value const & value)
+{
+  m_entry.Clear();
+  m_entry.m_osmId = base::GeoObjectId(key);
+  m_hasNullField = false;
+
+  ForEachMember(value, [this](char const * name, auto const & properties) {
+    if (std::strcmp(name, "properties") != 0)
+      return;
+
+    ForEachMember(properties, [this](char const * name, auto const & property) {
+      int64_t rank = 0;
+      if (std::strcmp(name, "locales") == 0)
+      {
+        ForEachMember(property, [this](char const * locale, auto const & localeValue) {
+          AddLocale(locale, localeValue);
+        });
+      }
+      else if (std::strcmp(name, "kind") == 0 && GetString(property, m_string))
+      {
+        m_entry.m_kind = geocoder::KindFromString(m_string);
+      }
+      else if (std::strcmp(name, "rank") == 0 && GetInt(property, rank))
+      {
+        m_entry.m_rank = static_cast<uint8_t>(rank);
+      }
+    });
+  });
+
+  if (!m_hasNullField)
+    m_chunk.Add(m_entry);
+}
+
+template <typename Value>
+void BinaryHierarchyCollector::AddLocale(char const * locale, Value const & value)
+{
+  ForEachMember(value, [this, locale](char const * name, auto const & member) {
+    if (std::strcmp(name, "name") == 0)
+    {
+      if (std::strcmp(locale, "default") == 0 && GetString(member, m_string) && !m_string.empty())
+        m_entry.m_hasName = true;
+      return;
+    }
+
+    if (std::strcmp(name, "address") != 0)
+      return;
+
+    ForEachMember(member, [this, locale](char const * field, auto const & fieldValue) {
+      auto const type = GetAddressFieldType(field);
+      if (type == geocoder::Type::Count)
+        return;
+
+      if (IsNull(fieldValue))
+        m_hasNullField = true;
+      else if (GetString(fieldValue, m_string) && !m_string.empty())
+        m_entry.m_address[static_cast<size_t>(type)].emplace_back(locale, m_string);
+    });
+  });
+}
+}  // namespace generator
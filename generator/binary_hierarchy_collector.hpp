@@ -0,0 +1,39 @@
+#pragma once
+
+#include "generator/json_writer.hpp"
+#include "generator/key_value_storage.hpp"
+
+#include "geocoder/binary_hierarchy.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace generator
+{
+// |BinaryHierarchyCollector| collects the hierarchy entries of the key-value values to the chunks
+// of the binary hierarchy of the geocoder, see geocoder::BinaryHierarchyEntry. The entries are
+// taken from the values in memory, so the geocoder loads the hierarchy without the json of
+// the key-value.
+class BinaryHierarchyCollector
+{
+public:
+  // The values with a null address field are not collected, the geocoder skips them.
+  void Add(uint64_t key, JsonValue const & value);
+  void Add(uint64_t key, JsonObjectPatch const & value);
+
+  bool IsEmpty() const { return m_chunk.IsEmpty(); }
+  // Returns the chunk of the collected entries and starts a new one.
+  std::string ReleaseChunk() { return m_chunk.Release(); }
+
+private:
+  template <typename Value>
+  void AddEntry(uint64_t key, Value const & value);
+  template <typename Value>
+  void AddLocale(char const * locale, Value const & value);
+
+  geocoder::BinaryHierarchyEntry m_entry;
+  geocoder::BinaryHierarchyChunkBuilder m_chunk;
+  bool m_hasNullField = false;
+  std::string m_string;
+};
+}  // namespace generator
@@ -11,9 +11,16 @@
 #include "base/string_utils.hpp"
 #include "base/logging.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 
 using namespace std;
@@ -92,7 +99,141 @@ void CoastlineFeaturesGenerator::Process(FeatureBuilder const & fb)
   if (fb.IsGeometryClosed())
     AddRegionToTree(fb);
   else
+    m_fragments.push_back(fb);
+}
+
+void CoastlineFeaturesGenerator::MergeFragments()
+{
+  // The coastlines are directed, so a fragment of a ring is continued by the fragment which
+  // starts at its last point. The fragments are joined by the hash tables of their first and
+  // last points in the linear time.
+  using Key = int64_t;
+  size_t constexpr kInvalidIndex = numeric_limits<size_t>::max();
+  auto const getKey = [](m2::PointD const & p) { return PointToInt64Obsolete(p, kPointCoordBits); };
+
+  vector<Key> firstKeys;
+  vector<Key> lastKeys;
+  unordered_map<Key, vector<size_t>> byFirstKey;
+  unordered_map<Key, vector<size_t>> byLastKey;
+  for (size_t i = 0; i < m_fragments.size(); ++i)
+  {
+    auto const & points = m_fragments[i].GetOuterGeometry();
+    firstKeys.push_back(points.empty() ? 0 : getKey(points.front()));
+    lastKeys.push_back(points.empty() ? 0 : getKey(points.back()));
+    if (points.size() < 2)
+      continue;
+
+    byFirstKey[firstKeys.back()].push_back(i);
+    byLastKey[lastKeys.back()].push_back(i);
+  }
+
+  vector<bool> used(m_fragments.size(), false);
+  auto const takeFragment = [&used, kInvalidIndex](unordered_map<Key, vector<size_t>> const & index,
+                                                   Key key) {
+    auto const it = index.find(key);
+    if (it == index.cend())
+      return kInvalidIndex;
+
+    for (auto const i : it->second)
+    {
+      if (!used[i])
+      {
+        used[i] = true;
+        return i;
+      }
+    }
+    return kInvalidIndex;
+  };
+
+  vector<FeatureBuilder::PointSeq> rings;
+  deque<size_t> chain;
+  for (size_t start = 0; start < m_fragments.size(); ++start)
+  {
+    if (used[start])
+      continue;
+
+    used[start] = true;
+    if (m_fragments[start].GetOuterGeometry().size() < 2)
+    {
+      m_merger(m_fragments[start]);
+      continue;
+    }
+
+    chain.assign(1, start);
+    Key firstKey = firstKeys[start];
+    Key lastKey = lastKeys[start];
+    while (firstKey != lastKey)
+    {
+      auto const next = takeFragment(byFirstKey, lastKey);
+      if (next == kInvalidIndex)
+        break;
+      chain.push_back(next);
+      lastKey = lastKeys[next];
+    }
+    while (firstKey != lastKey)
+    {
+      auto const prev = takeFragment(byLastKey, firstKey);
+      if (prev == kInvalidIndex)
+        break;
+      chain.push_front(prev);
+      firstKey = firstKeys[prev];
+    }
+
+    FeatureBuilder::PointSeq points;
+    for (auto const i : chain)
+    {
+      auto const & fragment = m_fragments[i].GetOuterGeometry();
+      points.insert(points.end(), points.empty() ? fragment.begin() : next(fragment.begin()),
+                    fragment.end());
+    }
+
+    if (firstKey == lastKey)
+    {
+      rings.push_back(move(points));
+      continue;
+    }
+
+    auto fb = m_fragments[chain.front()];
+    fb.ResetGeometry();
+    for (auto const & p : points)
+      fb.AddPoint(p);
+    for (auto it = next(chain.begin()); it != chain.end(); ++it)
+    {
+      for (auto const & id : m_fragments[*it].GetOsmIds())
+        fb.AddOsmId(id);
+    }
     m_merger(fb);
+  }
+  m_fragments.clear();
+  m_fragments.shrink_to_fit();
+
+  // The points of the rings are converted in parallel, the regions are added in the order of
+  // the rings.
+  vector<RegionT> regions(rings.size());
+  atomic<size_t> nextRing{0};
+  vector<thread> threads;
+  size_t const threadsCount = min(static_cast<size_t>(max(thread::hardware_concurrency(), 1U)),
+                                  max(rings.size(), size_t{1}));
+  for (size_t i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([&]() {
+      for (size_t r = nextRing++; r < rings.size(); r = nextRing++)
+      {
+        // Skip the last point of the ring, which is equal to the first one.
+        auto const & ring = rings[r];
+        for (size_t j = 0; j + 1 < ring.size(); ++j)
+          regions[r].AddPoint(D2I(ring[j]));
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  for (auto & region : regions)
+  {
+    auto const rect = GetLimitRect(region);
+    m_tree.Add(move(region), rect);
+  }
 }
 
 namespace
@@ -145,6 +286,8 @@ namespace
 
 bool CoastlineFeaturesGenerator::Finish()
 {
+  MergeFragments();
+
   DoAddToTree doAdd(*this);
   m_merger.DoMerge(doAdd);
 
@@ -214,7 +357,7 @@ class RegionInCellSplitter final
 {
 public:
   using TCell = RectId;
-  using TIndex = m4::Tree<m2::RegionI>;
+  using TIndex = m4::PackedTree<m2::RegionI>;
   using TProcessResultFunc = function<void(TCell const &, DoDifference &)>;
 
   static int constexpr kStartLevel = 4;
@@ -323,6 +466,8 @@ void CoastlineFeaturesGenerator::GetFeatures(vector<FeatureBuilder> & features)
   size_t const maxThreads = thread::hardware_concurrency();
   CHECK_GREATER(maxThreads, 0, ("Not supported platform"));
 
+  m_tree.Build();
+
   mutex featuresMutex;
   RegionInCellSplitter::Process(
       maxThreads, RegionInCellSplitter::kStartLevel, m_tree,
@@ -4,7 +4,7 @@
 
 #include "indexer/cell_id.hpp"
 
-#include "geometry/tree4d.hpp"
+#include "geometry/packed_tree4d.hpp"
 #include "geometry/region2d.hpp"
 
 #include <vector>
@@ -17,9 +17,18 @@ class FeatureBuilder;
 
 class CoastlineFeaturesGenerator
 {
+  // Joins the not closed coastlines by their endpoints. The rings are added to the tree,
+  // the rest is passed to |m_merger|.
+  void MergeFragments();
+
+  // The not closed coastlines in the order of Process().
+  std::vector<feature::FeatureBuilder> m_fragments;
+  // Merges the chains of the fragments which are not closed by MergeFragments(), e.g. the
+  // fragments with the wrong direction.
   FeatureMergeProcessor m_merger;
 
-  using TTree = m4::Tree<m2::RegionI>;
+  // Is filled once and then is queried by the cells of all the threads.
+  using TTree = m4::PackedTree<m2::RegionI>;
   TTree m_tree;
 
 public:
@@ -0,0 +1,147 @@
+#include "generator/compressed_features.hpp"
+
+#include "coding/byte_stream.hpp"
+#include "coding/file_reader.hpp"
+#include "coding/reader.hpp"
+#include "coding/varint.hpp"
+#include "coding/write_to_sink.hpp"
+
+#include "platform/platform.hpp"
+
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+namespace feature
+{
+namespace
+{
+// The varint of the size of a raw feature cannot start with five bytes of 0xFF.
+char const kFrameMagic[] = {'\xFF', '\xFF', '\xFF', '\xFF', '\xFF', 'G', 'Z', 'F'};
+size_t constexpr kFrameMagicSize = sizeof(kFrameMagic);
+}  // namespace
+
+bool IsCompressedFeaturesFile(char const * data, uint64_t size)
+{
+  return size >= kFrameMagicSize && std::memcmp(data, kFrameMagic, kFrameMagicSize) == 0;
+}
+
+FeaturesCompression GetFeaturesCompression(std::string const & filename,
+                                           FeaturesCompression defaultCompression)
+{
+  if (!Platform::IsFileExistsByFullPath(filename))
+    return defaultCompression;
+
+  FileReader reader(filename);
+  if (reader.Size() == 0)
+    return defaultCompression;
+
+  char magic[kFrameMagicSize];
+  auto const size = std::min(reader.Size(), static_cast<uint64_t>(kFrameMagicSize));
+  reader.Read(0 /* pos */, magic, static_cast<size_t>(size));
+  return IsCompressedFeaturesFile(magic, size) ? FeaturesCompression::Zlib
+                                               : FeaturesCompression::None;
+}
+
+std::vector<CompressedFeaturesFrame> ReadCompressedFeaturesFrames(char const * data,
+                                                                  uint64_t size)
+{
+  std::vector<CompressedFeaturesFrame> frames;
+  MemReaderWithExceptions reader(data, static_cast<size_t>(size));
+  ReaderSource<MemReaderWithExceptions> src(reader);
+  uint64_t rawOffset = 0;
+  while (src.Size() > 0)
+  {
+    if (!IsCompressedFeaturesFile(data + src.Pos(), src.Size()))
+      MYTHROW(Reader::ReadException, ("No frame magic at", src.Pos()));
+    src.Skip(kFrameMagicSize);
+
+    CompressedFeaturesFrame frame;
+    ReadPrimitiveFromSource(src, frame.m_compressedSize);
+    ReadPrimitiveFromSource(src, frame.m_rawSize);
+    ReadPrimitiveFromSource(src, frame.m_featuresCount);
+    frame.m_offset = src.Pos();
+    frame.m_rawOffset = rawOffset;
+    if (frame.m_compressedSize > src.Size())
+      MYTHROW(Reader::ReadException, ("Truncated frame at", frame.m_offset));
+
+    src.Skip(frame.m_compressedSize);
+    rawOffset += frame.m_rawSize;
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+void DecompressFeaturesFrame(char const * data, CompressedFeaturesFrame const & frame,
+                             std::vector<char> & rawFrame)
+{
+  namespace io = boost::iostreams;
+  rawFrame.clear();
+  rawFrame.reserve(frame.m_rawSize);
+  try
+  {
+    io::filtering_streambuf<io::input> in;
+    in.push(io::zlib_decompressor());
+    in.push(io::array_source(data + frame.m_offset, frame.m_compressedSize));
+    io::copy(in, io::back_inserter(rawFrame));
+  }
+  catch (io::zlib_error const & e)
+  {
+    MYTHROW(Reader::ReadException, ("Failed to inflate the frame at", frame.m_offset, e.what()));
+  }
+
+  if (rawFrame.size() != frame.m_rawSize)
+  {
+    MYTHROW(Reader::ReadException, ("Frame size", rawFrame.size(), "differs from",
+                                    frame.m_rawSize, "at", frame.m_offset));
+  }
+}
+
+// CompressedFeaturesWriter ------------------------------------------------------------------------
+// static
+uint32_t constexpr CompressedFeaturesWriter::kMaxFeaturesInFrame;
+// static
+size_t constexpr CompressedFeaturesWriter::kMaxFrameSize;
+
+void CompressedFeaturesWriter::Write(char const * data, size_t size)
+{
+  PushBackByteSink<std::vector<char>> sink(m_frame);
+  WriteVarUint(sink, static_cast<uint32_t>(size));
+  sink.Write(data, size);
+
+  if (++m_featuresCount == kMaxFeaturesInFrame || m_frame.size() >= kMaxFrameSize)
+    Flush();
+}
+
+void CompressedFeaturesWriter::Flush()
+{
+  if (m_featuresCount == 0)
+    return;
+
+  namespace io = boost::iostreams;
+  m_compressedFrame.clear();
+  {
+    // The intermediate files are written and read once, so the speed matters most.
+    io::filtering_streambuf<io::output> out;
+    out.push(io::zlib_compressor(io::zlib_params(io::zlib::best_speed)));
+    out.push(io::back_inserter(m_compressedFrame));
+    io::copy(io::array_source(m_frame.data(), m_frame.size()), out);
+  }
+
+  m_writer.Write(kFrameMagic, kFrameMagicSize);
+  WriteToSink(m_writer, static_cast<uint32_t>(m_compressedFrame.size()));
+  WriteToSink(m_writer, static_cast<uint32_t>(m_frame.size()));
+  WriteToSink(m_writer, m_featuresCount);
+  m_writer.Write(m_compressedFrame.data(), m_compressedFrame.size());
+
+  m_frame.clear();
+  m_featuresCount = 0;
+}
+}  // namespace feature
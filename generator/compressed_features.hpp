@@ -0,0 +1,67 @@
+#pragma once
+
+#include "coding/writer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace feature
+{
+// The features file is either the raw sequence of the serialized features with their sizes or
+// the sequence of the independently compressed frames of such features. Every frame starts with
+// a header that includes the magic, which cannot begin a raw features file, so the files are
+// recognized by their first bytes and the compressed files can be concatenated and appended to.
+// The offsets of the features of a compressed file are the offsets in the raw sequence.
+enum class FeaturesCompression
+{
+  None,
+  Zlib
+};
+
+struct CompressedFeaturesFrame
+{
+  // The offset and the size of the compressed data of the frame in the file.
+  uint64_t m_offset = 0;
+  uint32_t m_compressedSize = 0;
+  // The offset and the size of the features of the frame in the raw sequence.
+  uint64_t m_rawOffset = 0;
+  uint32_t m_rawSize = 0;
+  uint32_t m_featuresCount = 0;
+};
+
+bool IsCompressedFeaturesFile(char const * data, uint64_t size);
+// Returns |defaultCompression| for an empty or an absent file.
+FeaturesCompression GetFeaturesCompression(std::string const & filename,
+                                           FeaturesCompression defaultCompression);
+
+// Reads the headers of the frames of the compressed file of |size| bytes at |data|.
+// Throws Reader::ReadException if the file is broken.
+std::vector<CompressedFeaturesFrame> ReadCompressedFeaturesFrames(char const * data,
+                                                                  uint64_t size);
+// Decompresses the features of |frame| of the file at |data| to |rawFrame|.
+void DecompressFeaturesFrame(char const * data, CompressedFeaturesFrame const & frame,
+                             std::vector<char> & rawFrame);
+
+// Writes the features to |writer| as the compressed frames. The frames are written by at most
+// kMaxFeaturesInFrame features or kMaxFrameSize bytes of them, Flush() writes the last frame.
+class CompressedFeaturesWriter
+{
+public:
+  static uint32_t constexpr kMaxFeaturesInFrame = 1000;
+  static size_t constexpr kMaxFrameSize = 8 * 1024 * 1024;
+
+  explicit CompressedFeaturesWriter(Writer & writer) : m_writer(writer) {}
+
+  // |data| is the serialized feature without its size.
+  void Write(char const * data, size_t size);
+  void Flush();
+
+private:
+  Writer & m_writer;
+  std::vector<char> m_frame;
+  std::vector<char> m_compressedFrame;
+  uint32_t m_featuresCount = 0;
+};
+}  // namespace feature
@@ -160,9 +160,9 @@ void CoverFeatures(
     std::string const & featuresFile, FeatureFilter && featureFilter,
     IndexBuilder && indexBuilder, unsigned int threadsCount, uint64_t chunkFeaturesCount,
     base::thread_pool::computational::ThreadPool & threadPool,
-    covering::ObjectsCovering & objectsCovering)
+    covering::ObjectsCoverings & objectsCoverings)
 {
-  std::list<covering::ObjectsCovering> coveringsParts{};
+  covering::ObjectsCoverings coveringsParts{};
   auto makeProcessor = [&] {
     coveringsParts.emplace_back();
     auto & covering = coveringsParts.back();
@@ -186,14 +186,8 @@ void CoverFeatures(
       threadsCount, chunkFeaturesCount, featuresFile, makeProcessor);
   LOG(LINFO, ("Finish features geometry covering from", featuresFile));
 
-  LOG(LINFO, ("Merge geometry coverings..."));
-  while (!coveringsParts.empty())
-  {
-    auto const & part = coveringsParts.back();
-    objectsCovering.insert(objectsCovering.end(), part.begin(), part.end());
-    coveringsParts.pop_back();
-  }
-  LOG(LINFO, ("Finish merging of geometry coverings of features from ", featuresFile));
+  // The parts are merged on the index building.
+  objectsCoverings.splice(objectsCoverings.end(), coveringsParts);
 }
 
 namespace
@@ -236,12 +230,12 @@ bool GenerateRegionsIndex(std::string const & outPath, std::string const & featu
   indexer::RegionsIndexBuilder indexBuilder{threadPool};
 
   auto const featuresFilter = [](FeatureBuilder & fb) { return fb.IsArea(); };
-  covering::ObjectsCovering objectsCovering;
+  covering::ObjectsCoverings objectsCoverings;
   CoverFeatures(featuresFile, featuresFilter, indexBuilder, threadsCount,
-                1 /* chunkFeaturesCount */, threadPool, objectsCovering);
+                1 /* chunkFeaturesCount */, threadPool, objectsCoverings);
 
   LOG(LINFO, ("Build locality index..."));
-  if (!indexBuilder.BuildCoveringIndex(std::move(objectsCovering), outPath))
+  if (!indexBuilder.BuildCoveringIndex(std::move(objectsCoverings), outPath))
     return false;
   LOG(LINFO, ("Finish locality index building", outPath));
   return true;
@@ -254,7 +248,7 @@ bool GenerateGeoObjectsIndex(
     boost::optional<std::string> const & streetsFeaturesFile)
 {
   base::thread_pool::computational::ThreadPool threadPool{threadsCount};
-  covering::ObjectsCovering objectsCovering;
+  covering::ObjectsCoverings objectsCoverings;
   indexer::GeoObjectsIndexBuilder indexBuilder{threadPool};
 
   set<uint64_t> nodeIds;
@@ -274,7 +268,7 @@ bool GenerateGeoObjectsIndex(
   };
 
   CoverFeatures(geoObjectsFeaturesFile, geoObjectsFilter, indexBuilder, threadsCount,
-                10 /* chunkFeaturesCount */, threadPool, objectsCovering);
+                10 /* chunkFeaturesCount */, threadPool, objectsCoverings);
 
   if (streetsFeaturesFile)
   {
@@ -284,11 +278,11 @@ bool GenerateGeoObjectsIndex(
     };
 
     CoverFeatures(*streetsFeaturesFile, streetsFilter, indexBuilder, threadsCount,
-                  1 /* chunkFeaturesCount */, threadPool, objectsCovering);
+                  1 /* chunkFeaturesCount */, threadPool, objectsCoverings);
   }
 
   LOG(LINFO, ("Build objects index..."));
-  if (!indexBuilder.BuildCoveringIndex(std::move(objectsCovering), outPath))
+  if (!indexBuilder.BuildCoveringIndex(std::move(objectsCoverings), outPath))
     return false;
   LOG(LINFO, ("Finish objects index building", outPath));
   return true;
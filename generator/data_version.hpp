@@ -19,10 +19,11 @@ public:
   void DumpToPath(std::string const & path) const;
   static DataVersion LoadFromPath(std::string const & path);
   static std::string GetCodeVersion();
+  // The name of the file in the path of DumpToPath() and LoadFromPath().
+  static std::string const & FileName();
 private:
   DataVersion() = default;
   static std::string ReadWholeFile(std::string const & filePath);
-  static std::string const & FileName();
   static std::string const & Key();
   base::JSONPtr m_json;
 };
@@ -51,6 +51,14 @@ namespace feature
       if (!found.second)
         found.first->second++;
     }
+
+    void Merge(TypesCollector const & collector)
+    {
+      for (auto const & p : collector.m_stats)
+        m_stats[p.first] += p.second;
+      m_namesCount += collector.m_namesCount;
+      m_totalCount += collector.m_totalCount;
+    }
   };
 
   template <class T>
@@ -59,11 +67,8 @@ namespace feature
     return first.second > second.second;
   }
 
-  void DumpTypes(string const & fPath)
+  void PrintTypes(TypesCollector const & doClass)
   {
-    TypesCollector doClass;
-    feature::ForEachFromDat(fPath, doClass);
-
     typedef pair<vector<uint32_t>, size_t> stats_elem_type;
     typedef vector<stats_elem_type> vec_to_sort;
     vec_to_sort vecToSort(doClass.m_stats.begin(), doClass.m_stats.end());
@@ -80,6 +85,33 @@ namespace feature
     cout << "Features with names: " << doClass.m_namesCount << endl;
   }
 
+  template <class Collector>
+  Collector MergeCollectors(vector<Collector> const & collectors)
+  {
+    Collector res;
+    for (auto const & collector : collectors)
+      res.Merge(collector);
+    return res;
+  }
+
+  void DumpTypes(string const & fPath)
+  {
+    TypesCollector doClass;
+    feature::ForEachFromDat(fPath, doClass);
+    PrintTypes(doClass);
+  }
+
+  void DumpTypes(string const & fPath, unsigned int threadsCount)
+  {
+    PrintTypes(
+        MergeCollectors(feature::ForEachFromDatParallel(fPath, TypesCollector(), threadsCount)));
+  }
+
+  void DumpTypes(vector<string> const & fPaths, unsigned int threadsCount)
+  {
+    PrintTypes(MergeCollectors(feature::ForEachFromDats(fPaths, TypesCollector(), threadsCount)));
+  }
+
   ///////////////////////////////////////////////////////////////////
 
   typedef map<int8_t, map<strings::UniString, pair<unsigned int, string> > > TokensContainerT;
@@ -118,6 +150,21 @@ namespace feature
     {
       f.ForEachName(*this);
     }
+
+    // The sample name of a prefix is kept from the first collector which has the prefix.
+    void Merge(PrefixesCollector const & collector)
+    {
+      for (auto const & lang : collector.m_stats)
+      {
+        auto & prefixes = m_stats[lang.first];
+        for (auto const & p : lang.second)
+        {
+          auto found = prefixes.insert(p);
+          if (!found.second)
+            found.first->second.first += p.second.first;
+        }
+      }
+    }
   };
 
   static size_t const MIN_OCCURRENCE = 3;
@@ -145,15 +192,29 @@ namespace feature
     }
   }
 
+  void PrintPrefixes(PrefixesCollector const & doClass)
+  {
+    for (auto it = doClass.m_stats.begin(); it != doClass.m_stats.end(); ++it)
+      Print(it->first, it->second);
+  }
+
   void DumpPrefixes(string const & fPath)
   {
     PrefixesCollector doClass;
     feature::ForEachFromDat(fPath, doClass);
-    for (TokensContainerT::iterator it = doClass.m_stats.begin();
-         it != doClass.m_stats.end(); ++it)
-    {
-      Print(it->first, it->second);
-    }
+    PrintPrefixes(doClass);
+  }
+
+  void DumpPrefixes(string const & fPath, unsigned int threadsCount)
+  {
+    PrintPrefixes(
+        MergeCollectors(feature::ForEachFromDatParallel(fPath, PrefixesCollector(), threadsCount)));
+  }
+
+  void DumpPrefixes(vector<string> const & fPaths, unsigned int threadsCount)
+  {
+    PrintPrefixes(
+        MergeCollectors(feature::ForEachFromDats(fPaths, PrefixesCollector(), threadsCount)));
   }
 
   void DumpFeatureNames(string const & fPath, string const & lang)
@@ -172,4 +233,35 @@ namespace feature
                               f.ForEachName(printName);
                             });
   }
+
+  void DumpFeatureNames(string const & fPath, string const & lang, unsigned int threadsCount)
+  {
+    int8_t const langIndex = StringUtf8Multilang::GetLangIndex(lang);
+    // The names of a range of the features are collected to be printed in the order of the
+    // features.
+    struct NamesCollector
+    {
+      int8_t m_langIndex;
+      string m_names;
+
+      void operator()(FeatureType & f, uint32_t)
+      {
+        f.ForEachName([this](int8_t langCode, string const & name) {
+          CHECK(!name.empty(), ("Feature name is empty"));
+          if (m_langIndex == StringUtf8Multilang::kUnsupportedLanguageCode)
+            m_names.append(StringUtf8Multilang::GetLangByCode(langCode)).append(" ");
+          else if (langCode != m_langIndex)
+            return;
+          m_names.append(name).append("\n");
+        });
+      }
+    };
+
+    for (auto const & collector :
+         feature::ForEachFromDatParallel(fPath, NamesCollector{langIndex, {}}, threadsCount))
+    {
+      cout << collector.m_names;
+    }
+    cout.flush();
+  }
 }  // namespace feature
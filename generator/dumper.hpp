@@ -1,12 +1,21 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace feature
 {
   void DumpTypes(std::string const & fPath);
   void DumpPrefixes(std::string const & fPath);
 
+  // The same as above but the features of fPath are split between threadsCount threads.
+  void DumpTypes(std::string const & fPath, unsigned int threadsCount);
+  void DumpPrefixes(std::string const & fPath, unsigned int threadsCount);
+
+  // Dumps the merged stats of all fPaths, threadsCount files are processed concurrently.
+  void DumpTypes(std::vector<std::string> const & fPaths, unsigned int threadsCount);
+  void DumpPrefixes(std::vector<std::string> const & fPaths, unsigned int threadsCount);
+
   // Writes top maxTokensToShow tokens sorted by their
   // frequency, i.e. by the number of features in
   // an mwm that contain the token in their name.
@@ -16,4 +25,6 @@ namespace feature
   // (e.g. "en", "ru", "sv"). If the locale is not recognized, writes all names
   // preceded by their locales.
   void DumpFeatureNames(std::string const & fPath, std::string const & lang);
+  void DumpFeatureNames(std::string const & fPath, std::string const & lang,
+                        unsigned int threadsCount);
 }
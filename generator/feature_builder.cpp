@@ -4,10 +4,17 @@
 #include "indexer/feature_impl.hpp"
 #include "indexer/feature_visibility.hpp"
 
+#include "platform/platform.hpp"
+
 #include "coding/bit_streams.hpp"
 #include "coding/byte_stream.hpp"
+#include "coding/file_reader.hpp"
+#include "coding/file_writer.hpp"
 #include "coding/geometry_coding.hpp"
 #include "coding/read_write_utils.hpp"
+#include "coding/reader.hpp"
+#include "coding/varint.hpp"
+#include "coding/write_to_sink.hpp"
 
 #include "geometry/region2d.hpp"
 
@@ -16,10 +23,14 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
+#include <iterator>
 #include <vector>
 
 #include <sys/mman.h>
 
+#include "defines.hpp"
+
 using namespace std;
 
 namespace
@@ -432,27 +443,26 @@ void FeatureBuilder::DeserializeFromIntermediate(Buffer & data)
   serial::GeometryCodingParams cp;
 
   ArrayByteSource source(&data[0]);
+  ResetForDeserialization();
   m_params.Read(source);
 
-  m_limitRect.MakeEmpty();
-
   GeomType const type = m_params.GetGeomType();
   if (type == GeomType::Point)
   {
+    ResetPolygons(1 /* count */);
     m_center = serial::LoadPoint(source, cp);
     m_limitRect.Add(m_center);
   }
   else
   {
-    m_polygons.clear();
     uint32_t const count = ReadVarUint<uint32_t>(source);
     ASSERT_GREATER( count, 0, (*this) );
 
-    for (uint32_t i = 0; i < count; ++i)
+    ResetPolygons(count);
+    for (auto & polygon : m_polygons)
     {
-      m_polygons.push_back(PointSeq());
-      serial::LoadOuterPath(source, cp, m_polygons.back());
-      CalcRect(m_polygons.back(), m_limitRect);
+      serial::LoadOuterPath(source, cp, polygon);
+      CalcRect(polygon, m_limitRect);
     }
 
     m_coastCell = ReadVarInt<int64_t>(source);
@@ -497,23 +507,23 @@ void FeatureBuilder::SerializeAccuratelyForIntermediate(Buffer & data) const
 void FeatureBuilder::DeserializeAccuratelyFromIntermediate(Buffer & data)
 {
   ArrayByteSource source(&data[0]);
+  ResetForDeserialization();
   m_params.Read(source);
-  m_limitRect.MakeEmpty();
   if (IsPoint())
   {
+    ResetPolygons(1 /* count */);
     ReadPOD(source, m_center);
     m_limitRect.Add(m_center);
   }
   else
   {
-    m_polygons.clear();
     uint32_t const count = ReadVarUint<uint32_t>(source);
     ASSERT_GREATER(count, 0, (*this));
-    for (uint32_t i = 0; i < count; ++i)
+    ResetPolygons(count);
+    for (auto & polygon : m_polygons)
     {
-      m_polygons.push_back(PointSeq());
-      rw::ReadVectorOfPOD(source, m_polygons.back());
-      CalcRect(m_polygons.back(), m_limitRect);
+      rw::ReadVectorOfPOD(source, polygon);
+      CalcRect(polygon, m_limitRect);
     }
 
     m_coastCell = ReadVarInt<int64_t>(source);
@@ -523,6 +533,26 @@ void FeatureBuilder::DeserializeAccuratelyFromIntermediate(Buffer & data)
   Check(*this);
 }
 
+void FeatureBuilder::ResetForDeserialization()
+{
+  m_center = m2::PointD();
+  m_limitRect.MakeEmpty();
+  m_osmIds.clear();
+  m_params.Clear();
+  m_coastCell = -1;
+}
+
+void FeatureBuilder::ResetPolygons(size_t count)
+{
+  if (m_polygons.size() > count)
+    m_polygons.erase(std::next(m_polygons.begin(), count), m_polygons.end());
+  else
+    m_polygons.resize(count);
+
+  for (auto & polygon : m_polygons)
+    polygon.clear();
+}
+
 void FeatureBuilder::AddOsmId(base::GeoObjectId id) { m_osmIds.push_back(id); }
 
 void FeatureBuilder::SetOsmId(base::GeoObjectId id) { m_osmIds.assign(1, id); }
@@ -600,17 +630,10 @@ size_t FeatureBuilder::GetPointsCount() const
 
 bool FeatureBuilder::IsDrawableInRange(int lowScale, int highScale) const
 {
-  if (!GetOuterGeometry().empty())
-  {
-    auto const types = GetTypesHolder();
-    while (lowScale <= highScale)
-    {
-      if (IsDrawableForIndex(types, m_limitRect, lowScale++))
-        return true;
-    }
-  }
+  if (GetOuterGeometry().empty())
+    return false;
 
-  return false;
+  return IsDrawableForIndexInRange(GetTypesHolder(), m_limitRect, lowScale, highScale);
 }
 
 bool FeatureBuilder::PreSerializeAndRemoveUselessNamesForMwm(SupportingData const & data)
@@ -788,13 +811,156 @@ TypeSerializationVersion const MinSize::kSerializationVersion;
 TypeSerializationVersion const MaxAccuracy::kSerializationVersion;
 }  // namespace serialization_policy
 
+// FeaturesChunksIndex -----------------------------------------------------------------------------
+// static
+size_t constexpr FeaturesChunksIndex::kFeaturesInChunk;
+
+void FeaturesChunksIndex::Save(std::string const & featuresFilename, uint64_t fileSize)
+{
+  m_fileSize = fileSize;
+
+  FileWriter writer(GetFeaturesChunksIndexFilename(featuresFilename));
+  WriteToSink(writer, static_cast<uint32_t>(kFeaturesInChunk));
+  WriteToSink(writer, m_fileSize);
+  WriteToSink(writer, m_featuresCount);
+  WriteToSink(writer, m_fingerprint);
+  uint64_t prev = 0;
+  for (auto const offset : m_offsets)
+  {
+    WriteVarUint(writer, offset - prev);
+    prev = offset;
+  }
+}
+
+// static
+FeaturesChunksIndex FeaturesChunksIndex::Load(std::string const & featuresFilename,
+                                              char const * data, uint64_t size)
+{
+  FeaturesChunksIndex index;
+  auto const indexFilename = GetFeaturesChunksIndexFilename(featuresFilename);
+  if (Platform::IsFileExistsByFullPath(indexFilename))
+  {
+    try
+    {
+      FileReader reader(indexFilename);
+      ReaderSource<FileReader> src(reader);
+      auto const featuresInChunk = ReadPrimitiveFromSource<uint32_t>(src);
+      ReadPrimitiveFromSource(src, index.m_fileSize);
+      ReadPrimitiveFromSource(src, index.m_featuresCount);
+      ReadPrimitiveFromSource(src, index.m_fingerprint);
+      if (featuresInChunk == kFeaturesInChunk && index.m_fileSize == size)
+      {
+        index.m_offsets.resize((index.m_featuresCount + kFeaturesInChunk - 1) / kFeaturesInChunk);
+        uint64_t prev = 0;
+        for (auto & offset : index.m_offsets)
+        {
+          offset = prev + ReadVarUint<uint64_t>(src);
+          prev = offset;
+        }
+
+        if (src.Size() == 0 && index.IsValid(data, size))
+          return index;
+      }
+    }
+    catch (Reader::Exception const & e)
+    {
+      LOG(LWARNING, ("Failed to read the chunks index of", featuresFilename, e.Msg()));
+    }
+
+    LOG(LINFO, ("The chunks index of", featuresFilename, "is stale."));
+    index = FeaturesChunksIndex();
+  }
+
+  MemReaderWithExceptions reader(data, static_cast<size_t>(size));
+  ReaderSource<MemReaderWithExceptions> src(reader);
+  while (src.Size() > 0)
+  {
+    auto const offset = src.Pos();
+    auto const featureSize = ReadVarUint<uint32_t>(src);
+    index.AddFeature(offset, data + src.Pos(), featureSize);
+    src.Skip(featureSize);
+  }
+  index.m_fileSize = size;
+  return index;
+}
+
+// static
+FeaturesChunksIndex FeaturesChunksIndex::Make(std::vector<CompressedFeaturesFrame> const & frames)
+{
+  FeaturesChunksIndex index;
+  for (auto const & frame : frames)
+  {
+    index.m_offsets.push_back(frame.m_rawOffset);
+    index.m_featuresCount += frame.m_featuresCount;
+  }
+  if (!frames.empty())
+    index.m_fileSize = frames.back().m_rawOffset + frames.back().m_rawSize;
+  return index;
+}
+
+void FeaturesChunksIndex::AddToFingerprint(char const * data, size_t size)
+{
+  // FNV-1a of the first bytes of the feature. The order of the features in the chunks is
+  // verified this way without reading the whole file.
+  size_t constexpr kFingerprintBytes = 32;
+  for (size_t i = 0; i < std::min(size, kFingerprintBytes); ++i)
+  {
+    m_fingerprint ^= static_cast<uint8_t>(data[i]);
+    m_fingerprint *= 1099511628211ULL;
+  }
+  m_fingerprint ^= size;
+  m_fingerprint *= 1099511628211ULL;
+}
+
+bool FeaturesChunksIndex::IsValid(char const * data, uint64_t size) const
+{
+  if (m_fileSize != size)
+    return false;
+  if (m_offsets.empty())
+    return m_featuresCount == 0 && size == 0;
+  if (m_offsets.front() != 0 || m_offsets.back() >= size)
+    return false;
+  if (std::adjacent_find(m_offsets.cbegin(), m_offsets.cend(), std::greater_equal<uint64_t>()) !=
+      m_offsets.cend())
+  {
+    return false;
+  }
+
+  FeaturesChunksIndex actual;
+  MemReaderWithExceptions reader(data, static_cast<size_t>(size));
+  for (auto const offset : m_offsets)
+  {
+    ReaderSource<MemReaderWithExceptions> src(reader);
+    src.Skip(offset);
+    auto const featureSize = ReadVarUint<uint32_t>(src);
+    if (featureSize > src.Size())
+      return false;
+    actual.AddToFingerprint(data + src.Pos(), featureSize);
+  }
+  return actual.m_fingerprint == m_fingerprint;
+}
+
+std::string GetFeaturesChunksIndexFilename(std::string const & featuresFilename)
+{
+  return featuresFilename + FEATURES_CHUNKS_FILE_EXTENSION;
+}
+
 // FeaturesFileMmap --------------------------------------------------------------------------------
 FeaturesFileMmap::FeaturesFileMmap(std::string const & filename)
-  : m_fileMmap{filename}
+  : m_filename{filename}
+  , m_fileMmap{filename}
 {
   if (!m_fileMmap.is_open())
     MYTHROW(Writer::OpenException, ("Failed to open", filename));
 
+  m_size = m_fileMmap.size();
+  m_compressed = IsCompressedFeaturesFile(m_fileMmap.data(), m_fileMmap.size());
+  if (m_compressed)
+  {
+    m_frames = ReadCompressedFeaturesFrames(m_fileMmap.data(), m_fileMmap.size());
+    m_size = m_frames.empty() ? 0 : m_frames.back().m_rawOffset + m_frames.back().m_rawSize;
+  }
+
   // Try aggressively (MADV_WILLNEED) and asynchronously read ahead the feature-file.
   auto readaheadTask = std::thread([data = m_fileMmap.data(), size = m_fileMmap.size()] {
     ::madvise(const_cast<char*>(data), size, MADV_WILLNEED);
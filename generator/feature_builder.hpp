@@ -1,17 +1,26 @@
 #pragma once
 
+#include "generator/compressed_features.hpp"
+
 #include "indexer/feature_data.hpp"
 
 #include "coding/file_reader.hpp"
 #include "coding/file_writer.hpp"
 #include "coding/read_write_utils.hpp"
 
+#include "base/exception.hpp"
 #include "base/geo_object_id.hpp"
+#include "base/logging.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/thread_pool_delayed.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -187,6 +196,8 @@ public:
   void SerializeForIntermediate(Buffer & data) const;
   void SerializeBorderForIntermediate(serial::GeometryCodingParams const & params,
                                       Buffer & data) const;
+  // The deserialization overwrites all the data of the feature and keeps the capacity of its
+  // geometry, ids and params, so a feature builder can be reused for the features of a file.
   void DeserializeFromIntermediate(Buffer & data);
 
   // These methods use geometry without loss of accuracy.
@@ -218,6 +229,10 @@ public:
   bool IsCoastCell() const { return (m_coastCell != -1); }
 
 protected:
+  void ResetForDeserialization();
+  // Makes |count| empty polygons reusing the current ones.
+  void ResetPolygons(size_t count);
+
   template <class ToDo>
   class ToDoWrapper
   {
@@ -303,6 +318,56 @@ void ReadFromSourceRawFormat(Source & src, FeatureBuilder & fb)
   SerializationPolicy::Deserialize(fb, buffer);
 }
 
+// The offsets of the chunks of kFeaturesInChunk features of a features file. The writers of
+// the file save it next to the file, so the parallel readers seek to their chunks instead
+// of reading the sizes of all the previous features.
+class FeaturesChunksIndex
+{
+public:
+  static size_t constexpr kFeaturesInChunk = 1000;
+
+  // Is called for every feature of the features file in turn with the offset of the feature
+  // and its serialized data without the size.
+  void AddFeature(uint64_t offset, char const * data, size_t size)
+  {
+    if (m_featuresCount++ % kFeaturesInChunk != 0)
+      return;
+
+    m_offsets.push_back(offset);
+    AddToFingerprint(data, size);
+  }
+
+  // |fileSize| is the size of the features file |featuresFilename|. It is saved with the index
+  // as well as the fingerprint of the first features of the chunks, so the index of a rewritten
+  // or an appended file is not used.
+  void Save(std::string const & featuresFilename, uint64_t fileSize);
+  // Loads the saved index of the features file |featuresFilename| of |size| bytes at |data|.
+  // Builds the index by a single pass through the file if there is no valid saved index.
+  static FeaturesChunksIndex Load(std::string const & featuresFilename, char const * data,
+                                  uint64_t size);
+  // The chunks of a compressed features file are its frames.
+  static FeaturesChunksIndex Make(std::vector<CompressedFeaturesFrame> const & frames);
+
+  uint64_t GetFeaturesCount() const { return m_featuresCount; }
+  size_t GetChunksCount() const { return m_offsets.size(); }
+  uint64_t GetChunkBegin(size_t chunk) const { return m_offsets[chunk]; }
+  uint64_t GetChunkEnd(size_t chunk) const
+  {
+    return chunk + 1 < m_offsets.size() ? m_offsets[chunk + 1] : m_fileSize;
+  }
+
+private:
+  void AddToFingerprint(char const * data, size_t size);
+  bool IsValid(char const * data, uint64_t size) const;
+
+  std::vector<uint64_t> m_offsets;
+  uint64_t m_featuresCount = 0;
+  uint64_t m_fileSize = 0;
+  uint64_t m_fingerprint = 0;
+};
+
+std::string GetFeaturesChunksIndexFilename(std::string const & featuresFilename);
+
 class FeaturesFileMmap
 {
 public:
@@ -310,43 +375,87 @@ public:
 
   FeaturesFileMmap(std::string const & filename);
 
-  template <typename SerializationPolicy, typename Handler>
-  void ForEachTaskChunk(unsigned int taskIndex, unsigned int tasksCount, size_t chunkSize,
-                        Handler && handler) const
+  // The size of the raw features of a compressed file.
+  uint64_t GetSize() const { return m_size; }
+  FeaturesChunksIndex LoadChunksIndex() const
   {
-    auto && reader =
-        MemReaderTemplate<true /* WithExceptions */>{m_fileMmap.data(), m_fileMmap.size()};
-    auto && src = ReaderSource<MemReaderTemplate<true>>{reader};
+    if (m_compressed)
+      return FeaturesChunksIndex::Make(m_frames);
 
-    auto && buffer = FeatureBuilder::Buffer{};
-    auto && fileSize = reader.Size();
+    return FeaturesChunksIndex::Load(m_filename, m_fileMmap.data(), m_fileMmap.size());
+  }
 
-    for (size_t featuresCounter = 0; src.Pos() < fileSize; ++featuresCounter)
+  // Calls |handler| for the features at [begin, end) of the file. |begin| and |end| must be
+  // the offsets of the features or the size of the file. The features are deserialized to
+  // |fb| using |buffer|, so the same feature builder is passed to |handler| for all the
+  // features and the memory is reused.
+  template <typename SerializationPolicy, typename Handler>
+  void ForEachInRange(uint64_t begin, uint64_t end, FeatureBuilder & fb,
+                      FeatureBuilder::Buffer & buffer, Handler && handler) const
+  {
+    CHECK_LESS_OR_EQUAL(begin, end, ());
+    CHECK_LESS_OR_EQUAL(end, m_size, ());
+    if (!m_compressed)
     {
-      auto const featurePos = src.Pos();
+      ForEachInData<SerializationPolicy>(m_fileMmap.data() + begin, end - begin, begin, fb,
+                                         buffer, handler);
+      return;
+    }
 
-      uint32_t const featureSize = ReadVarUint<uint32_t>(src);
+    // The frames of the range are decompressed one by one.
+    auto frame = std::upper_bound(m_frames.cbegin(), m_frames.cend(), begin,
+                                  [](uint64_t offset, CompressedFeaturesFrame const & frame) {
+                                    return offset < frame.m_rawOffset + frame.m_rawSize;
+                                  });
+    std::vector<char> rawFrame;
+    for (; frame != m_frames.cend() && frame->m_rawOffset < end; ++frame)
+    {
+      DecompressFeaturesFrame(m_fileMmap.data(), *frame, rawFrame);
+      auto const frameBegin = std::max(begin, frame->m_rawOffset);
+      auto const frameEnd = std::min(end, frame->m_rawOffset + frame->m_rawSize);
+      ForEachInData<SerializationPolicy>(rawFrame.data() + (frameBegin - frame->m_rawOffset),
+                                         frameEnd - frameBegin, frameBegin, fb, buffer, handler);
+    }
+  }
 
-      auto const featureChunkIndex = featuresCounter / chunkSize;
-      auto const featureTaskIndex = featureChunkIndex % tasksCount;
-      if (featureTaskIndex != taskIndex)
-      {
-        src.Skip(featureSize);
-        continue;
-      }
+  template <typename SerializationPolicy, typename Handler>
+  void ForEachInRange(uint64_t begin, uint64_t end, Handler && handler) const
+  {
+    FeatureBuilder fb;
+    FeatureBuilder::Buffer buffer;
+    ForEachInRange<SerializationPolicy>(begin, end, fb, buffer, std::forward<Handler>(handler));
+  }
+
+private:
+  // Calls |handler| for the raw features of |size| bytes at |data| which are at |offset| of
+  // the file.
+  template <typename SerializationPolicy, typename Handler>
+  static void ForEachInData(char const * data, uint64_t size, uint64_t offset,
+                            FeatureBuilder & fb, FeatureBuilder::Buffer & buffer,
+                            Handler & handler)
+  {
+    auto && reader = MemReaderTemplate<true /* WithExceptions */>{data, static_cast<size_t>(size)};
+    auto && src = ReaderSource<MemReaderTemplate<true>>{reader};
 
+    while (src.Size() > 0)
+    {
+      auto const featurePos = offset + src.Pos();
+
+      uint32_t const featureSize = ReadVarUint<uint32_t>(src);
       buffer.resize(featureSize);
       src.Read(buffer.data(), featureSize);
 
-      auto && fb = FeatureBuilder{};
       SerializationPolicy::Deserialize(fb, buffer);
 
       handler(fb, featurePos);
     }
   }
 
-private:
+  std::string m_filename;
   boost::iostreams::mapped_file_source m_fileMmap;
+  bool m_compressed = false;
+  std::vector<CompressedFeaturesFrame> m_frames;
+  uint64_t m_size = 0;
 };
 
 // Process features in .dat file.
@@ -358,11 +467,14 @@ void ForEachFromDatRawFormat(std::string const & filename, Handler && handler)
     return;
   auto && featuresMmap = FeaturesFileMmap{filename};
 
-  featuresMmap.ForEachTaskChunk<SerializationPolicy>(
-      0 /* taskIndex */, 1 /* taskCount*/, 1 /* chunkSize */, std::forward<Handler>(handler));
+  featuresMmap.ForEachInRange<SerializationPolicy>(0 /* begin */, featuresMmap.GetSize(),
+                                                   std::forward<Handler>(handler));
 }
 
-// Parallel process features in .dat file.
+// Parallel process features in .dat file. The threads take the next features from the chunks
+// index of the file as soon as they are done with the previous ones. A task is a share of the
+// remaining features and at least |chunkSize| of them, so the tasks are large at the beginning
+// and the threads are balanced with the small ones at the end.
 template <class SerializationPolicy = serialization_policy::MinSize, class ProcessorMaker>
 void ProcessParallelFromDatRawFormat(unsigned int threadsCount, uint64_t chunkSize,
                                      std::string const & filename,
@@ -376,14 +488,44 @@ void ProcessParallelFromDatRawFormat(unsigned int threadsCount, uint64_t chunkSi
   if (!boost::filesystem::file_size(filename))
     return;
   auto && featuresMmap = FeaturesFileMmap{filename};
+  auto const chunksIndex = featuresMmap.LoadChunksIndex();
+  auto const minChunksInTask = std::max(
+      static_cast<size_t>(chunkSize / FeaturesChunksIndex::kFeaturesInChunk), size_t{1});
+  // The share of the remaining chunks of a task is 1 / (threadsCount * kTasksPerThread).
+  size_t const kTasksPerThread = 4;
+  auto const chunksCount = chunksIndex.GetChunksCount();
+  std::atomic<size_t> nextChunk{0};
+  auto const takeTask = [&nextChunk, chunksCount, minChunksInTask,
+                         tasksDivisor = threadsCount * kTasksPerThread](size_t & first,
+                                                                        size_t & last) {
+    first = nextChunk.load();
+    size_t count = 0;
+    do
+    {
+      if (first >= chunksCount)
+        return false;
+      count = std::max((chunksCount - first) / tasksDivisor, minChunksInTask);
+    } while (!nextChunk.compare_exchange_weak(first, first + count));
+    last = std::min(first + count, chunksCount) - 1;
+    return true;
+  };
 
   auto && threads = std::vector<std::thread>{};
   for (unsigned int i = 0; i < threadsCount; ++i)
   {
     auto && processor = processorMaker();
-    threads.emplace_back([i, threadsCount, chunkSize, &featuresMmap,
+    threads.emplace_back([&featuresMmap, &chunksIndex, &takeTask,
                           processor = std::move(processor)]() mutable {
-      featuresMmap.ForEachTaskChunk<SerializationPolicy>(i, threadsCount, chunkSize, processor);
+      FeatureBuilder fb;
+      FeatureBuilder::Buffer buffer;
+      size_t first = 0;
+      size_t last = 0;
+      while (takeTask(first, last))
+      {
+        featuresMmap.ForEachInRange<SerializationPolicy>(chunksIndex.GetChunkBegin(first),
+                                                         chunksIndex.GetChunkEnd(last), fb, buffer,
+                                                         processor);
+      }
     });
   }
 
@@ -423,25 +565,61 @@ template <class SerializationPolicy = serialization_policy::MinSize, class Write
 class FeatureBuilderWriter
 {
 public:
+  // The features are appended to a non-empty file with the compression of the file.
   explicit FeatureBuilderWriter(std::string const & filename,
-                                FileWriter::Op op = FileWriter::Op::OP_WRITE_TRUNCATE)
+                                FileWriter::Op op = FileWriter::Op::OP_WRITE_TRUNCATE,
+                                FeaturesCompression compression = FeaturesCompression::None)
     : m_writer(filename, op)
   {
+    if (op == FileWriter::Op::OP_APPEND)
+      compression = GetFeaturesCompression(filename, compression);
+    if (compression != FeaturesCompression::None)
+      m_compressedWriter = std::make_unique<CompressedFeaturesWriter>(m_writer);
+
+    // The offsets of the features which are already in the file are unknown.
+    m_writeChunksIndex = op != FileWriter::Op::OP_APPEND && !m_compressedWriter;
+
     // TODO(maksimandrianov): I would like to support the verification of serialization versions,
     // but this requires reworking of FeatureCollector class and its derived classes. It is in
     // future plans WriteVarUint(m_writer,
     // static_cast<serialization_policy::TypeSerializationVersion>(SerializationPolicy::kSerializationVersion));
   }
 
+  ~FeatureBuilderWriter()
+  {
+    try
+    {
+      if (m_compressedWriter)
+        m_compressedWriter->Flush();
+      if (m_writeChunksIndex)
+        m_chunksIndex.Save(m_writer.GetName(), m_writer.Pos());
+    }
+    catch (RootException const & e)
+    {
+      LOG(LERROR, ("Failed to finish", m_writer.GetName(), e.Msg()));
+    }
+  }
+
   void Write(FeatureBuilder const & fb)
   {
     FeatureBuilder::Buffer buffer;
     SerializationPolicy::Serialize(fb, buffer);
+    if (m_compressedWriter)
+    {
+      m_compressedWriter->Write(buffer.data(), buffer.size());
+      return;
+    }
+
+    if (m_writeChunksIndex)
+      m_chunksIndex.AddFeature(m_writer.Pos(), buffer.data(), buffer.size());
     WriteVarUint(m_writer, static_cast<uint32_t>(buffer.size()));
     m_writer.Write(buffer.data(), buffer.size() * sizeof(FeatureBuilder::Buffer::value_type));
   }
 
 private:
   Writer m_writer;
+  std::unique_ptr<CompressedFeaturesWriter> m_compressedWriter;
+  bool m_writeChunksIndex = false;
+  FeaturesChunksIndex m_chunksIndex;
 };
 }  // namespace feature
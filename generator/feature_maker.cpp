@@ -8,6 +8,7 @@
 #include "indexer/feature_visibility.hpp"
 
 #include <utility>
+#include <vector>
 
 using namespace feature;
 
@@ -42,15 +43,13 @@ bool FeatureMakerSimple::BuildFromWay(OsmElement & p, FeatureParams const & para
   if (nodes.size() < 2)
     return false;
 
-  FeatureBuilder fb;
-  m2::PointD pt;
-  for (uint64_t ref : nodes)
-  {
-    if (!cache->GetNode(ref, pt.y, pt.x))
-      return false;
+  std::vector<m2::PointD> points;
+  if (!cache->GetNodes(nodes, points))
+    return false;
 
+  FeatureBuilder fb;
+  for (auto const & pt : points)
     fb.AddPoint(pt);
-  }
 
   fb.SetOsmId(base::MakeOsmWay(p.m_id));
   fb.SetParams(params);
@@ -6,6 +6,11 @@
 
 #include "coding/point_coding.hpp"
 
+#include "base/stl_helpers.hpp"
+
+#include <algorithm>
+#include <utility>
+
 using namespace feature;
 
 MergedFeatureBuilder::MergedFeatureBuilder(FeatureBuilder const & fb)
@@ -140,9 +145,9 @@ void FeatureMergeProcessor::operator() (MergedFeatureBuilder * p)
   Key const k1 = GetKey(p->FirstPoint());
   Key const k2 = GetKey(p->LastPoint());
 
-  m_map[k1].push_back(p);
+  m_index.emplace_back(k1, p);
   if (k1 != k2)
-    m_map[k2].push_back(p);
+    m_index.emplace_back(k2, p);
   else
   {
     ///@ todo Do it only for small round features!
@@ -154,17 +159,30 @@ void FeatureMergeProcessor::operator() (MergedFeatureBuilder * p)
 
 void FeatureMergeProcessor::Insert(m2::PointD const & pt, MergedFeatureBuilder * p)
 {
-  m_map[GetKey(pt)].push_back(p);
+  m_index.emplace_back(GetKey(pt), p);
+}
+
+std::pair<FeatureMergeProcessor::Index::iterator, FeatureMergeProcessor::Index::iterator>
+FeatureMergeProcessor::EqualRange(Key key)
+{
+  return std::equal_range(m_index.begin(), m_index.end(), KeyToMergedFeatureBuilder(key, nullptr),
+                          base::LessBy(&KeyToMergedFeatureBuilder::first));
+}
+
+MergedFeatureBuilder * FeatureMergeProcessor::GetFirstNotRemoved()
+{
+  while (m_firstNotRemoved < m_index.size() && !m_index[m_firstNotRemoved].second)
+    ++m_firstNotRemoved;
+  return m_firstNotRemoved < m_index.size() ? m_index[m_firstNotRemoved].second : nullptr;
 }
 
 void FeatureMergeProcessor::Remove(Key key, MergedFeatureBuilder const * p)
 {
-  auto i = m_map.find(key);
-  if (i != m_map.end())
+  auto const range = EqualRange(key);
+  for (auto it = range.first; it != range.second; ++it)
   {
-    MergedFeatureBuilders & v = i->second;
-    v.erase(remove(v.begin(), v.end(), p), v.end());
-    if (v.empty()) m_map.erase(i);
+    if (it->second == p)
+      it->second = nullptr;
   }
 }
 
@@ -186,13 +204,14 @@ void FeatureMergeProcessor::Remove(MergedFeatureBuilder const * p)
 
 void FeatureMergeProcessor::DoMerge(FeatureEmitterIFace & emitter)
 {
-  while (!m_map.empty())
-  {
-    // Get any starting feature.
-    MergedFeatureBuilders & vS = m_map.begin()->second;
-    CHECK(!vS.empty(), ());
-    MergedFeatureBuilder * p = vS.front();  // may be 'back' is better
+  // The features are only removed while merging, so the index is sorted once. The features
+  // of a key keep the order of adding.
+  std::stable_sort(m_index.begin(), m_index.end(), base::LessBy(&KeyToMergedFeatureBuilder::first));
+  m_firstNotRemoved = 0;
 
+  // Get any starting feature.
+  while (MergedFeatureBuilder * p = GetFirstNotRemoved())
+  {
     // Remove next processing type. If it's a last type - remove from map.
     uint32_t type;
     bool isRemoved = false;
@@ -211,48 +230,45 @@ void FeatureMergeProcessor::DoMerge(FeatureEmitterIFace & emitter)
     while (ind < curr.GetKeyPointsCount())  // GetKeyPointsCount() can be different on each iteration
     {
       std::pair<m2::PointD, bool> const pt = curr.GetKeyPoint(ind++);
-      auto it = m_map.find(GetKey(pt.first));
+      auto const range = EqualRange(GetKey(pt.first));
 
+      // Find best feature to continue.
       MergedFeatureBuilder * pp = 0;
-      if (it != m_map.end())
+      double bestPr = -1.0;
+      for (auto it = range.first; it != range.second; ++it)
       {
-        // Find best feature to continue.
-        double bestPr = -1.0;
-        for (size_t i = 0; i < it->second.size(); ++i)
+        MergedFeatureBuilder * pTest = it->second;
+        if (pTest && pTest->HasType(type))
         {
-          MergedFeatureBuilder * pTest = it->second[i];
-          if (pTest->HasType(type))
+          double const pr = pTest->GetPriority();
+          // It's not necessery assert, because it's possible in source data
+//          ASSERT_GREATER ( pr, 0.0, () );
+          if (pr > bestPr)
           {
-            double const pr = pTest->GetPriority();
-            // It's not necessery assert, because it's possible in source data
-//            ASSERT_GREATER ( pr, 0.0, () );
-            if (pr > bestPr)
-            {
-              pp = pTest;
-              bestPr = pr;
-            }
+            pp = pTest;
+            bestPr = pr;
           }
         }
+      }
 
-        // Merge current feature with best feature.
-        if (pp)
-        {
-          bool const toBack = pt.second;
-          bool fromBegin = true;
-          if ((pt.first.SquaredLength(pp->FirstPoint()) > pt.first.SquaredLength(pp->LastPoint())) == toBack)
-            fromBegin = false;
+      // Merge current feature with best feature.
+      if (pp)
+      {
+        bool const toBack = pt.second;
+        bool fromBegin = true;
+        if ((pt.first.SquaredLength(pp->FirstPoint()) > pt.first.SquaredLength(pp->LastPoint())) == toBack)
+          fromBegin = false;
 
-          curr.AppendFeature(*pp, fromBegin, toBack);
+        curr.AppendFeature(*pp, fromBegin, toBack);
 
-          if (pp->PopExactType(type))
-          {
-            Remove(pp);
-            delete pp;
-          }
-
-          // start from the beginning if we have a successful merge
-          ind = 0;
+        if (pp->PopExactType(type))
+        {
+          Remove(pp);
+          delete pp;
         }
+
+        // start from the beginning if we have a successful merge
+        ind = 0;
       }
     }
 
@@ -267,13 +283,16 @@ void FeatureMergeProcessor::DoMerge(FeatureEmitterIFace & emitter)
       // emit m_last and set curr as last processed feature (m_last)
       if (m_last.NotEmpty())
         emitter(m_last);
-      m_last = curr;
+      m_last = std::move(curr);
     }
 
     // Delete if the feature was removed from map.
     if (isRemoved) delete p;
   }
 
+  m_index.clear();
+  m_firstNotRemoved = 0;
+
   if (m_last.NotEmpty())
     emitter(m_last);
 }
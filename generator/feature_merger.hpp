@@ -62,9 +62,17 @@ class FeatureMergeProcessor
 
   MergedFeatureBuilder m_last;
 
-  using MergedFeatureBuilders = std::vector<MergedFeatureBuilder *>;
-  using KeyToMergedFeatureBuilders = std::map<Key, MergedFeatureBuilders>;
-  KeyToMergedFeatureBuilders m_map;
+  // The keys of the ends (and of the middle points of the round features) with the features in
+  // the order of adding. Is sorted by the keys in DoMerge(), the removed features are reset to
+  // nullptr, so there are no allocations per key.
+  using KeyToMergedFeatureBuilder = std::pair<Key, MergedFeatureBuilder *>;
+  using Index = std::vector<KeyToMergedFeatureBuilder>;
+  Index m_index;
+  // All the features before it in the sorted |m_index| are removed.
+  size_t m_firstNotRemoved = 0;
+
+  std::pair<Index::iterator, Index::iterator> EqualRange(Key key);
+  MergedFeatureBuilder * GetFirstNotRemoved();
 
   void Insert(m2::PointD const & pt, MergedFeatureBuilder * p);
 
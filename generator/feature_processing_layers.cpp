@@ -9,6 +9,9 @@
 
 #include "base/assert.hpp"
 #include "base/geo_object_id.hpp"
+#include "base/stl_helpers.hpp"
+
+#include <utility>
 
 using namespace feature;
 
@@ -45,6 +48,18 @@ void LayerBase::Handle(FeatureBuilder & fb)
     m_next->Handle(fb);
 }
 
+void LayerBase::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  for (auto & fb : batch)
+    Handle(fb);
+}
+
+void LayerBase::HandleNextBatch(std::vector<FeatureBuilder> & batch)
+{
+  if (m_next)
+    m_next->HandleBatch(batch);
+}
+
 void LayerBase::Merge(std::shared_ptr<LayerBase> const & other)
 {
   CHECK(other, ());
@@ -166,6 +181,65 @@ void RepresentationLayer::Handle(FeatureBuilder & fb)
   }
 }
 
+void RepresentationLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void RepresentationLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  m_represented.clear();
+  m_represented.reserve(batch.size());
+  for (auto & fb : batch)
+    Represent(std::move(fb), m_represented);
+  batch.swap(m_represented);
+}
+
+// static
+void RepresentationLayer::Represent(FeatureBuilder && fb, std::vector<FeatureBuilder> & batch)
+{
+  auto const sourceType = fb.GetMostGenericOsmId().GetType();
+  auto const geomType = fb.GetGeomType();
+  switch (sourceType)
+  {
+  case base::GeoObjectId::Type::ObsoleteOsmNode:
+    batch.push_back(std::move(fb));
+    return;
+  case base::GeoObjectId::Type::ObsoleteOsmWay:
+    if (geomType == feature::GeomType::Line)
+    {
+      batch.push_back(std::move(fb));
+      return;
+    }
+    CHECK_EQUAL(geomType, feature::GeomType::Area, ());
+    break;
+  case base::GeoObjectId::Type::ObsoleteOsmRelation:
+    CHECK_EQUAL(geomType, feature::GeomType::Area, ());
+    break;
+  default:
+    UNREACHABLE();
+  }
+
+  // The same features in the same order as by Handle().
+  auto const & params = fb.GetParams();
+  bool const isLine =
+      sourceType == base::GeoObjectId::Type::ObsoleteOsmWay && CanBeLine(params);
+  if (CanBeArea(params))
+  {
+    auto line = isLine ? MakeLineFromArea(fb) : FeatureBuilder();
+    batch.push_back(std::move(fb));
+    if (isLine)
+      batch.push_back(std::move(line));
+    return;
+  }
+
+  if (CanBePoint(params))
+    batch.push_back(MakePointFromArea(fb));
+  if (isLine)
+    batch.push_back(MakeLineFromArea(fb));
+}
+
 void RepresentationLayer::HandleArea(FeatureBuilder & fb, FeatureParams const & params)
 {
   if (CanBeArea(params))
@@ -209,6 +283,24 @@ void PrepareFeatureLayer::Handle(FeatureBuilder & fb)
     LayerBase::Handle(fb);
 }
 
+void PrepareFeatureLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void PrepareFeatureLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  base::EraseIf(batch, [](FeatureBuilder & fb) {
+    auto const type = fb.GetGeomType();
+    auto & params = fb.GetParams();
+    feature::RemoveUselessTypes(params.m_types, type);
+    fb.PreSerializeAndRemoveUselessNamesForIntermediate();
+    FixLandType(fb);
+    return !feature::HasUsefulType(params.m_types, type);
+  });
+}
+
 void RepresentationCoastlineLayer::Handle(FeatureBuilder & fb)
 {
   auto const sourceType = fb.GetMostGenericOsmId().GetType();
@@ -239,6 +331,22 @@ void RepresentationCoastlineLayer::Handle(FeatureBuilder & fb)
   }
 }
 
+void RepresentationCoastlineLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void RepresentationCoastlineLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  base::EraseIf(batch, [](FeatureBuilder const & fb) {
+    if (fb.GetMostGenericOsmId().GetType() != base::GeoObjectId::Type::ObsoleteOsmWay)
+      return true;
+    CHECK(fb.IsArea() || fb.IsLine(), ());
+    return false;
+  });
+}
+
 
 void PrepareCoastlineFeatureLayer::Handle(FeatureBuilder & fb)
 {
@@ -255,21 +363,81 @@ void PrepareCoastlineFeatureLayer::Handle(FeatureBuilder & fb)
   LayerBase::Handle(fb);
 }
 
+void PrepareCoastlineFeatureLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void PrepareCoastlineFeatureLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  auto const & isCoastlineChecker = ftypes::IsCoastlineChecker::Instance();
+  auto const kCoastType = isCoastlineChecker.GetCoastlineType();
+  for (auto & fb : batch)
+  {
+    if (fb.IsArea())
+    {
+      auto & params = fb.GetParams();
+      feature::RemoveUselessTypes(params.m_types, fb.GetGeomType());
+    }
+
+    fb.PreSerializeAndRemoveUselessNamesForIntermediate();
+    fb.SetType(kCoastType);
+  }
+}
+
 void WorldLayer::Handle(FeatureBuilder & fb)
 {
   if (fb.RemoveInvalidTypes() && m_filter.IsAccepted(fb))
     LayerBase::Handle(fb);
 }
 
+void WorldLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void WorldLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  base::EraseIf(batch, [this](FeatureBuilder & fb) {
+    return !fb.RemoveInvalidTypes() || !m_filter.IsAccepted(fb);
+  });
+}
+
 void CountryLayer::Handle(feature::FeatureBuilder & fb)
 {
   if (fb.RemoveInvalidTypes() && PreprocessForCountryMap(fb))
     LayerBase::Handle(fb);
 }
 
+void CountryLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void CountryLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  base::EraseIf(batch, [](FeatureBuilder & fb) {
+    return !fb.RemoveInvalidTypes() || !PreprocessForCountryMap(fb);
+  });
+}
+
 void PreserializeLayer::Handle(FeatureBuilder & fb)
 {
   if (fb.PreSerialize())
     LayerBase::Handle(fb);
 }
+
+void PreserializeLayer::HandleBatch(std::vector<FeatureBuilder> & batch)
+{
+  ApplyBatch(batch);
+  HandleNextBatch(batch);
+}
+
+void PreserializeLayer::ApplyBatch(std::vector<FeatureBuilder> & batch)
+{
+  base::EraseIf(batch, [](FeatureBuilder & fb) { return !fb.PreSerialize(); });
+}
 }  // namespace generator
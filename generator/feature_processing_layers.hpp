@@ -8,9 +8,13 @@
 #include "generator/processor_interface.hpp"
 #include "generator/world_map_generator.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 class CoastlineFeaturesGenerator;
 
@@ -59,6 +63,10 @@ public:
 
   // The function works in linear time from the number of layers that exist after that.
   virtual void Handle(feature::FeatureBuilder & fb);
+  // Handles the features of |batch| one by one if the layer does not process the batches.
+  // The layers which do pass the whole batch to the next layer at once, the features which are
+  // not passed on are removed from |batch|.
+  virtual void HandleBatch(std::vector<feature::FeatureBuilder> & batch);
 
   void Merge(std::shared_ptr<LayerBase> const & other);
   void MergeChain(std::shared_ptr<LayerBase> const & other);
@@ -77,6 +85,9 @@ public:
   std::string GetAsString() const;
   std::string GetAsStringRecursive() const;
 
+protected:
+  void HandleNextBatch(std::vector<feature::FeatureBuilder> & batch);
+
 private:
   LogBuffer m_logBuffer;
   std::shared_ptr<LayerBase> m_next;
@@ -90,8 +101,13 @@ private:
 // with type "leisure=playground" and line object with type "barrier=fence".
 class RepresentationLayer : public LayerBase
 {
+public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 
 private:
   static bool CanBeArea(FeatureParams const & params);
@@ -99,6 +115,11 @@ private:
   static bool CanBeLine(FeatureParams const & params);
 
   void HandleArea(feature::FeatureBuilder & fb, FeatureParams const & params);
+  // Appends the features |fb| is represented by to |batch|.
+  static void Represent(feature::FeatureBuilder && fb,
+                        std::vector<feature::FeatureBuilder> & batch);
+
+  std::vector<feature::FeatureBuilder> m_represented;
 };
 
 // Responsibility of class PrepareFeatureLayer is the removal of unused types and names,
@@ -108,6 +129,10 @@ class PrepareFeatureLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 };
 
 // Responsibility of class RepresentationCoastlineLayer is converting features from one form to
@@ -117,6 +142,10 @@ class RepresentationCoastlineLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 };
 
 // Responsibility of class PrepareCoastlineFeatureLayer is the removal of unused types and names,
@@ -126,6 +155,10 @@ class PrepareCoastlineFeatureLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 };
 
 class WorldLayer : public LayerBase
@@ -133,6 +166,10 @@ class WorldLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 
 private:
   FilterWorld m_filter;
@@ -143,6 +180,10 @@ class CountryLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 };
 
 class PreserializeLayer : public LayerBase
@@ -150,6 +191,10 @@ class PreserializeLayer : public LayerBase
 public:
   // LayerBase overrides:
   void Handle(feature::FeatureBuilder & fb) override;
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override;
+
+  // Processes |batch| without passing it on, see LayersPipeline.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch);
 };
 
 template <class SerializePolicy = feature::serialization_policy::MaxAccuracy>
@@ -157,7 +202,8 @@ class AffiliationsFeatureLayer : public LayerBase
 {
 public:
   AffiliationsFeatureLayer(
-      size_t bufferedItemsCountMax, std::shared_ptr<feature::AffiliationInterface> const & affiliation,
+      size_t bufferedItemsCountMax,
+      std::shared_ptr<feature::AffiliationInterface const> const & affiliation,
       std::shared_ptr<FeatureProcessorQueue> const & queue)
     : m_bufferedItemsCountMax{bufferedItemsCountMax}
     , m_affiliation(affiliation)
@@ -174,6 +220,16 @@ public:
     newItem.m_affiliations = m_affiliation->GetAffiliations(fb);
   }
 
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch) override { ApplyBatch(batch); }
+
+  // The layer is the last one: all the features of |batch| are taken.
+  void ApplyBatch(std::vector<feature::FeatureBuilder> & batch)
+  {
+    for (auto & fb : batch)
+      Handle(fb);
+    batch.clear();
+  }
+
   void Flush()
   {
     if (m_bufferedItemsCount == 0)
@@ -224,7 +280,64 @@ private:
   size_t m_bufferedItemsCount{0};
   size_t const m_bufferedItemsCountMax{100};
   std::list<std::shared_ptr<std::vector<ProcessedData>>> m_queuedChunks;
-  std::shared_ptr<feature::AffiliationInterface> m_affiliation;
+  std::shared_ptr<feature::AffiliationInterface const> m_affiliation;
   std::shared_ptr<FeatureProcessorQueue> m_queue;
 };
+
+// A chain of layers composed at compile time. The layers are held by value and every layer
+// processes the whole batch by its ApplyBatch() before the next one, so there are no virtual
+// calls and no shared_ptr hops per feature. Every layer is constructed from its own tuple
+// of the arguments, e.g.
+//   LayersPipeline<PreserializeLayer, AffiliationsFeatureLayer<>> pipeline(
+//       std::make_tuple(), std::make_tuple(bufferSize, affiliation, queue));
+template <class... Layers>
+class LayersPipeline;
+
+template <>
+class LayersPipeline<>
+{
+public:
+  void HandleBatch(std::vector<feature::FeatureBuilder> &) {}
+  void Merge(LayersPipeline const &) {}
+};
+
+template <class Layer, class... Layers>
+class LayersPipeline<Layer, Layers...>
+{
+public:
+  template <class... Args, class... NextArgs>
+  explicit LayersPipeline(std::tuple<Args...> && layerArgs, NextArgs &&... nextArgs)
+    : LayersPipeline(std::index_sequence_for<Args...>{}, std::move(layerArgs),
+                     std::forward<NextArgs>(nextArgs)...)
+  {
+  }
+
+  void HandleBatch(std::vector<feature::FeatureBuilder> & batch)
+  {
+    m_layer.ApplyBatch(batch);
+    if (!batch.empty())
+      m_next.HandleBatch(batch);
+  }
+
+  // Merges the logs of the layers like LayerBase::MergeChain().
+  void Merge(LayersPipeline const & other)
+  {
+    m_layer.AppendLine(other.m_layer.GetAsString());
+    m_next.Merge(other.m_next);
+  }
+
+  Layer & GetLayer() { return m_layer; }
+  LayersPipeline<Layers...> & GetNext() { return m_next; }
+
+private:
+  template <size_t... Is, class... Args, class... NextArgs>
+  LayersPipeline(std::index_sequence<Is...>, std::tuple<Args...> && layerArgs,
+                 NextArgs &&... nextArgs)
+    : m_layer(std::get<Is>(std::move(layerArgs))...), m_next(std::forward<NextArgs>(nextArgs)...)
+  {
+  }
+
+  Layer m_layer;
+  LayersPipeline<Layers...> m_next;
+};
 }  // namespace generator
@@ -2,6 +2,7 @@
 
 #include "generator/feature_builder.hpp"
 
+#include "base/bounded_mpmc_queue.hpp"
 #include "base/thread_safe_queue.hpp"
 
 #include <cstddef>
@@ -22,5 +23,8 @@ struct ProcessedData
 
 using FeatureProcessorChunk =
     base::threads::DataWrapper<std::shared_ptr<std::vector<ProcessedData>>>;
-using FeatureProcessorQueue = base::threads::ThreadSafeQueue<FeatureProcessorChunk>;
+// The translators push the chunks and RawGeneratorWriter pops them without a shared lock.
+// The writer may wait for the chunks for a long time, so the waiting threads block.
+using FeatureProcessorQueue =
+    base::threads::BoundedMpmcQueue<FeatureProcessorChunk, base::threads::BlockingWait>;
 }  // namespace generator
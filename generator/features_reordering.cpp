@@ -0,0 +1,102 @@
+#include "generator/features_reordering.hpp"
+
+#include "generator/feature_builder.hpp"
+
+#include "coding/byte_stream.hpp"
+#include "coding/file_writer.hpp"
+#include "coding/internal/file_data.hpp"
+#include "coding/mmap_reader.hpp"
+#include "coding/point_coding.hpp"
+#include "coding/varint.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace generator
+{
+namespace
+{
+// The Hilbert index and the position of a feature record.
+using FeatureKey = std::pair<uint64_t, uint64_t>;
+}  // namespace
+
+uint64_t GetHilbertIndex(m2::PointD const & point)
+{
+  auto const cell = PointDToPointU(point, kPointCoordBits);
+  auto x = static_cast<uint32_t>(cell.x);
+  auto y = static_cast<uint32_t>(cell.y);
+  uint32_t const side = 1u << kPointCoordBits;
+
+  uint64_t index = 0;
+  for (uint32_t s = side / 2; s > 0; s /= 2)
+  {
+    uint32_t const rx = (x & s) != 0 ? 1 : 0;
+    uint32_t const ry = (y & s) != 0 ? 1 : 0;
+    index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+    // Rotate the quadrant.
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+
+  return index;
+}
+
+void ReorderFeaturesAlongHilbertCurve(std::string const & featuresFile, unsigned int threadsCount)
+{
+  std::list<std::vector<FeatureKey>> keysParts;
+  feature::ProcessParallelFromDatRawFormat(threadsCount, featuresFile, [&keysParts]() {
+    keysParts.emplace_back();
+    auto & keys = keysParts.back();
+    return [&keys](feature::FeatureBuilder & fb, uint64_t pos) {
+      keys.emplace_back(GetHilbertIndex(fb.GetLimitRect().Center()), pos);
+    };
+  });
+
+  std::vector<FeatureKey> keys;
+  for (auto & part : keysParts)
+  {
+    keys.insert(keys.end(), part.begin(), part.end());
+    part = {};
+  }
+  if (keys.empty())
+    return;
+
+  std::sort(keys.begin(), keys.end());
+
+  auto const reorderedFile = featuresFile + ".reordered";
+  feature::FeaturesChunksIndex chunksIndex;
+  uint64_t reorderedSize = 0;
+  {
+    MmapReader const reader(featuresFile);
+    auto const data = static_cast<char const *>(reader.GetDirectData());
+    FileWriter writer(reorderedFile);
+    for (auto const & key : keys)
+    {
+      ArrayByteSource source(data + key.second);
+      auto const size = ReadVarUint<uint32_t>(source);
+      auto const recordSize = static_cast<size_t>(source.PtrC() - (data + key.second)) + size;
+      CHECK_LESS_OR_EQUAL(key.second + recordSize, reader.Size(), ());
+      chunksIndex.AddFeature(writer.Pos(), source.PtrC(), size);
+      writer.Write(data + key.second, recordSize);
+    }
+    reorderedSize = writer.Pos();
+  }
+
+  CHECK(base::RenameFileX(reorderedFile, featuresFile), (reorderedFile, featuresFile));
+  chunksIndex.Save(featuresFile, reorderedSize);
+  LOG(LINFO, ("Reordered", keys.size(), "features of", featuresFile, "along the Hilbert curve"));
+}
+}  // namespace generator
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "geometry/point2d.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace generator
+{
+// Returns the index of the cell of |point| on the Hilbert curve filling the mercator bounds
+// with the cells of the point coding grid. The close indices are the close cells.
+uint64_t GetHilbertIndex(m2::PointD const & point);
+
+// Reorders the features of the .dat file |featuresFile| along the Hilbert curve by the centers
+// of their limit rects, so the spatially close features are stored close to each other.
+// The features with the same index keep their order, the records are copied as they are.
+void ReorderFeaturesAlongHilbertCurve(std::string const & featuresFile, unsigned int threadsCount);
+}  // namespace generator
@@ -0,0 +1,173 @@
+#include "generator/features_sharding.hpp"
+
+#include "generator/feature_builder.hpp"
+#include "generator/regions/region_info_getter.hpp"
+
+#include "coding/file_writer.hpp"
+#include "coding/internal/file_data.hpp"
+
+#include "platform/platform.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <utility>
+
+namespace generator
+{
+namespace
+{
+// The position of a feature in its file and the id of its country.
+using FeatureCountry = std::pair<uint64_t, uint64_t>;
+
+std::vector<FeatureCountry> GetFeaturesCountries(CountryIdGetter const & countryIdGetter,
+                                                 std::string const & featuresFile,
+                                                 unsigned int threadsCount)
+{
+  std::list<std::vector<FeatureCountry>> parts;
+  feature::ProcessParallelFromDatRawFormat(threadsCount, featuresFile, [&]() {
+    parts.emplace_back();
+    auto & part = parts.back();
+    return [&countryIdGetter, &part](feature::FeatureBuilder & fb, uint64_t pos) {
+      part.emplace_back(pos, countryIdGetter(fb.GetKeyPoint()));
+    };
+  });
+
+  std::vector<FeatureCountry> countries;
+  for (auto & part : parts)
+  {
+    countries.insert(countries.end(), part.begin(), part.end());
+    part = {};
+  }
+  std::sort(countries.begin(), countries.end());
+  return countries;
+}
+}  // namespace
+
+std::string GetShardFilename(std::string const & filename, size_t shard)
+{
+  return filename + ".shard" + std::to_string(shard);
+}
+
+std::map<uint64_t, size_t> AssignCountriesToShards(std::map<uint64_t, uint64_t> const & counts,
+                                                   size_t shardsCount)
+{
+  CHECK_GREATER(shardsCount, 0, ());
+
+  std::vector<std::pair<uint64_t, uint64_t>> countries(counts.cbegin(), counts.cend());
+  // The countries of the same count keep the order of their ids.
+  std::stable_sort(countries.begin(), countries.end(),
+                   [](auto const & l, auto const & r) { return l.second > r.second; });
+
+  std::map<uint64_t, size_t> shards;
+  std::vector<uint64_t> loads(shardsCount, 0);
+  for (auto const & country : countries)
+  {
+    auto const shard =
+        static_cast<size_t>(std::min_element(loads.cbegin(), loads.cend()) - loads.cbegin());
+    shards.emplace(country.first, shard);
+    loads[shard] += country.second;
+  }
+
+  LOG(LINFO, ("Features of", countries.size(), "countries by shards:", loads));
+  return shards;
+}
+
+void ShardFeatures(CountryIdGetter const & countryIdGetter,
+                   std::vector<std::string> const & featuresFiles, size_t shardsCount,
+                   unsigned int threadsCount)
+{
+  std::vector<std::vector<FeatureCountry>> filesCountries;
+  std::map<uint64_t, uint64_t> counts;
+  for (auto const & featuresFile : featuresFiles)
+  {
+    filesCountries.emplace_back(GetFeaturesCountries(countryIdGetter, featuresFile, threadsCount));
+    for (auto const & featureCountry : filesCountries.back())
+      ++counts[featureCountry.second];
+  }
+
+  auto const shards = AssignCountriesToShards(counts, shardsCount);
+  for (size_t i = 0; i < featuresFiles.size(); ++i)
+  {
+    auto const & featuresFile = featuresFiles[i];
+    auto const & countries = filesCountries[i];
+    auto const compression =
+        feature::GetFeaturesCompression(featuresFile, feature::FeaturesCompression::None);
+
+    std::vector<std::unique_ptr<feature::FeatureBuilderWriter<>>> writers;
+    for (size_t shard = 0; shard < shardsCount; ++shard)
+    {
+      writers.emplace_back(std::make_unique<feature::FeatureBuilderWriter<>>(
+          GetShardFilename(featuresFile, shard), FileWriter::Op::OP_WRITE_TRUNCATE, compression));
+    }
+
+    size_t next = 0;
+    feature::ForEachFromDatRawFormat(featuresFile, [&](feature::FeatureBuilder & fb,
+                                                       uint64_t pos) {
+      CHECK(next < countries.size() && countries[next].first == pos, (featuresFile, pos));
+      writers[shards.at(countries[next].second)]->Write(fb);
+      ++next;
+    });
+    CHECK_EQUAL(next, countries.size(), (featuresFile));
+    LOG(LINFO, (countries.size(), "features of", featuresFile, "are split to", shardsCount,
+                "shards"));
+  }
+}
+
+void ShardFeaturesByCountries(std::string const & regionsIndex, std::string const & regionsKv,
+                              std::vector<std::string> const & featuresFiles, size_t shardsCount,
+                              unsigned int threadsCount)
+{
+  auto const sharedRegionInfoGetter = regions::RegionInfoGetter::GetShared(regionsIndex, regionsKv);
+  auto const & regionInfoGetter = *sharedRegionInfoGetter;
+  auto const & storage = regionInfoGetter.GetStorage();
+  auto const countryIdGetter = [&](m2::PointD const & point) -> uint64_t {
+    auto const region = regionInfoGetter.FindDeepest(point);
+    if (!region)
+      return 0;
+
+    // The country is the root of the path of the regions.
+    auto id = region->first;
+    while (auto const record = storage.FindRecord(id))
+    {
+      auto const dref = record->GetDref();
+      if (!dref)
+        break;
+      id = *dref;
+    }
+    return id;
+  };
+
+  ShardFeatures(countryIdGetter, featuresFiles, shardsCount, threadsCount);
+}
+
+void MergeShardFiles(std::string const & filename, size_t shardsCount)
+{
+  // The merged file exists even if the files of the shards are empty.
+  FileWriter(filename, FileWriter::Op::OP_WRITE_TRUNCATE);
+  for (size_t shard = 0; shard < shardsCount; ++shard)
+  {
+    auto const shardFilename = GetShardFilename(filename, shard);
+    CHECK(Platform::IsFileExistsByFullPath(shardFilename), (shardFilename));
+    base::AppendFileToFile(shardFilename, filename);
+  }
+}
+
+void MergeShardFeatures(std::string const & filename, size_t shardsCount)
+{
+  CHECK_GREATER(shardsCount, 0, ());
+  auto const compression = feature::GetFeaturesCompression(GetShardFilename(filename, 0),
+                                                           feature::FeaturesCompression::None);
+  feature::FeatureBuilderWriter<> writer(filename, FileWriter::Op::OP_WRITE_TRUNCATE, compression);
+  for (size_t shard = 0; shard < shardsCount; ++shard)
+  {
+    feature::ForEachFromDatRawFormat(GetShardFilename(filename, shard),
+                                     [&writer](feature::FeatureBuilder & fb, uint64_t) {
+                                       writer.Write(fb);
+                                     });
+  }
+}
+}  // namespace generator
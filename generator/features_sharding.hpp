@@ -0,0 +1,47 @@
+#pragma once
+
+#include "geometry/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+// The streets and the geo objects stages may run on the shards of the intermediate features.
+// The features are split to the shards by the countries, so a shard is processed independently,
+// on another machine too, with the regions index and key-value of the whole planet, and the
+// outputs of the shards are merged.
+
+// Returns the id of the country of |point| or 0 if the point is out of the countries.
+using CountryIdGetter = std::function<uint64_t(m2::PointD const & point)>;
+
+// The name of the file of |shard| of |filename|.
+std::string GetShardFilename(std::string const & filename, size_t shard);
+
+// Assigns the countries with the counts of their features to |shardsCount| shards, so the shards
+// have close counts of the features. The largest countries are assigned first, each one to the
+// least loaded shard.
+std::map<uint64_t, size_t> AssignCountriesToShards(std::map<uint64_t, uint64_t> const & counts,
+                                                   size_t shardsCount);
+
+// Splits each of |featuresFiles| to the files of |shardsCount| shards by the countries of the
+// key points of the features, all the files are split by the same assignment of the countries.
+// The features keep their order and the compression of their file.
+void ShardFeatures(CountryIdGetter const & countryIdGetter,
+                   std::vector<std::string> const & featuresFiles, size_t shardsCount,
+                   unsigned int threadsCount);
+// The same where the countries are the root regions of the regions index and key-value.
+void ShardFeaturesByCountries(std::string const & regionsIndex, std::string const & regionsKv,
+                              std::vector<std::string> const & featuresFiles, size_t shardsCount,
+                              unsigned int threadsCount);
+
+// Concatenates the files of the shards of |filename|, e.g. the key-value files, to |filename|.
+// The files of the shards are kept.
+void MergeShardFiles(std::string const & filename, size_t shardsCount);
+// The same for the features files, the merged file has the chunks index.
+void MergeShardFeatures(std::string const & filename, size_t shardsCount);
+}  // namespace generator
@@ -19,6 +19,19 @@ std::shared_ptr<FilterInterface> FilterCollection::Clone() const
 
 bool FilterCollection::IsAccepted(OsmElement const & element)
 {
+  if (m_masks.size() != m_collection.size())
+    PrepareMasks();
+
+  if (!m_signature.IsEmpty())
+  {
+    auto const signature = m_signature.Get(element);
+    for (auto const mask : m_masks)
+    {
+      if (mask != 0 && (signature & mask) == 0)
+        return false;
+    }
+  }
+
   return std::all_of(std::begin(m_collection), std::end(m_collection), [&] (auto & filter) {
     return filter->IsAccepted(element);
   });
@@ -30,4 +43,26 @@ bool FilterCollection::IsAccepted(FeatureBuilder const & feature)
     return filter->IsAccepted(feature);
   });
 }
+
+std::vector<std::string> FilterCollection::GetRequiredTagKeys() const
+{
+  // All the filters must accept an element, so the requirement of any one of them holds
+  // for the whole collection.
+  for (auto const & filter : m_collection)
+  {
+    auto keys = filter->GetRequiredTagKeys();
+    if (!keys.empty())
+      return keys;
+  }
+  return {};
+}
+
+void FilterCollection::PrepareMasks()
+{
+  m_signature = {};
+  m_masks.clear();
+  m_masks.reserve(m_collection.size());
+  for (auto const & filter : m_collection)
+    m_masks.emplace_back(m_signature.AddKeys(filter->GetRequiredTagKeys()));
+}
 }  // namespace generator
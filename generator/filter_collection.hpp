@@ -2,8 +2,11 @@
 
 #include "generator/collection_base.hpp"
 #include "generator/filter_interface.hpp"
+#include "generator/tag_keys_signature.hpp"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 struct OsmElement;
 namespace feature
@@ -22,5 +25,14 @@ public:
 
   bool IsAccepted(OsmElement const & element) override;
   bool IsAccepted(feature::FeatureBuilder const & feature) override;
+  std::vector<std::string> GetRequiredTagKeys() const override;
+
+private:
+  void PrepareMasks();
+
+  // The masks of the required keys of the filters, a zero mask means no requirement.
+  // They are built lazily because the filters are appended after construction.
+  TagKeysSignature m_signature;
+  std::vector<TagKeysSignature::Mask> m_masks;
 };
 }  // namespace generator
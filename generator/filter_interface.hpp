@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 struct OsmElement;
 namespace feature
@@ -20,5 +22,10 @@ public:
 
   virtual bool IsAccepted(OsmElement const &) { return true; }
   virtual bool IsAccepted(feature::FeatureBuilder const &) { return true; }
+
+  // Returns the keys an OsmElement must have at least one tag with to be accepted.
+  // An empty list means that there is no such requirement. It lets the callers reject
+  // the most of elements by a precomputed signature of their tags without calling IsAccepted.
+  virtual std::vector<std::string> GetRequiredTagKeys() const { return {}; }
 };
 }  // namespace generator
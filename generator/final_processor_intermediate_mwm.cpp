@@ -34,13 +34,16 @@ namespace generator
 {
 namespace
 {
+// Calls |toDo| for the countries tmp.mwm files by |threadsCount| threads, so every call must
+// write to its own country only.
 template <typename ToDo>
-void ForEachCountry(std::string const & temporaryMwmPath, ToDo && toDo)
+void ForEachCountry(std::string const & temporaryMwmPath, size_t threadsCount, ToDo && toDo)
 {
   Platform::FilesList fileList;
   Platform::GetFilesByExt(temporaryMwmPath, DATA_FILE_EXTENSION_TMP, fileList);
+  ThreadPool pool(threadsCount);
   for (auto const & filename : fileList)
-    toDo(filename);
+    pool.SubmitWork([&toDo, &filename]() { toDo(filename); });
 }
 
 // Writes |fbs| to countries tmp.mwm files that |fbs| belongs to according to |affiliations|.
@@ -74,6 +77,26 @@ FinalProcessorIntermediateMwmInterface::FinalProcessorIntermediateMwmInterface(F
 {
 }
 
+void FinalProcessorIntermediateMwmInterface::AddDependency(
+    std::shared_ptr<FinalProcessorIntermediateMwmInterface> const & processor)
+{
+  CHECK(processor, ());
+  CHECK_NOT_EQUAL(processor.get(), this, ());
+  m_dependencies.emplace_back(processor);
+}
+
+bool FinalProcessorIntermediateMwmInterface::DependsOn(
+    FinalProcessorIntermediateMwmInterface const & processor) const
+{
+  if (m_dependencies.empty())
+    return m_priority < processor.m_priority;
+
+  return std::any_of(m_dependencies.cbegin(), m_dependencies.cend(),
+                     [&processor](auto const & dependency) {
+                       return dependency.get() == &processor;
+                     });
+}
+
 bool FinalProcessorIntermediateMwmInterface::operator<(FinalProcessorIntermediateMwmInterface const & other) const
 {
   return m_priority < other.m_priority;
@@ -6,7 +6,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace generator
 {
@@ -20,8 +22,9 @@ enum class FinalProcessorPriority : uint8_t
 // For example, attempt to merge the coastline or adding external elements.
 // Each derived class has a priority. This is done to comply with the order of processing intermediate mwm,
 // taking into account the dependencies between them. For example, before adding a coastline to
-// a country, we must build coastline. Processors with higher priority will be called first.
-// Processors with the same priority can run in parallel.
+// a country, we must build coastline. A processor waits for the processors with higher priority,
+// or only for its dependencies when they are added. The processors which do not wait for each
+// other run in parallel, so the world may be finished while the countries are processed.
 class FinalProcessorIntermediateMwmInterface
 {
 public:
@@ -30,11 +33,27 @@ public:
 
   virtual bool Process() = 0;
 
+  FinalProcessorPriority GetPriority() const { return m_priority; }
+
+  void AddDependency(std::shared_ptr<FinalProcessorIntermediateMwmInterface> const & processor);
+  std::vector<std::shared_ptr<FinalProcessorIntermediateMwmInterface>> const &
+  GetDependencies() const
+  {
+    return m_dependencies;
+  }
+  // Returns true when the processor must be finished before this one.
+  bool DependsOn(FinalProcessorIntermediateMwmInterface const & processor) const;
+
+  // The country files are processed by a pool of this size.
+  void SetThreadsCount(size_t threadsCount) { m_threadsCount = threadsCount; }
+
   bool operator<(FinalProcessorIntermediateMwmInterface const & other) const;
   bool operator==(FinalProcessorIntermediateMwmInterface const & other) const;
   bool operator!=(FinalProcessorIntermediateMwmInterface const & other) const;
 
 protected:
   FinalProcessorPriority m_priority;
+  std::vector<std::shared_ptr<FinalProcessorIntermediateMwmInterface>> m_dependencies;
+  size_t m_threadsCount = 1;
 };
 }  // namespace generator
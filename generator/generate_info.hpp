@@ -2,6 +2,7 @@
 
 #include "base/file_name_utils.hpp"
 #include "base/logging.hpp"
+#include "base/thread_affinity.hpp"
 
 #include "defines.hpp"
 
@@ -17,13 +18,15 @@ struct GenerateInfo
   {
     Memory,
     Index,
-    File
+    File,
+    Compressed
   };
 
   enum class OsmSourceType
   {
     XML,
-    O5M
+    O5M,
+    PBF
   };
 
   // Directory for .mwm.tmp files.
@@ -40,6 +43,24 @@ struct GenerateInfo
   std::string m_osmFileName;
 
   unsigned int m_threadsCount{1};
+  // The workers of the decode and the translate stages of the features generation,
+  // zero is a share of m_threadsCount, see RawGenerator.
+  unsigned int m_decodeThreadsCount{0};
+  unsigned int m_translateThreadsCount{0};
+  // The threads writing the intermediate features, every file is written by one of them,
+  // zero is a share of m_threadsCount.
+  unsigned int m_writeThreadsCount{0};
+  // The memory of the batches of the osm elements which are decoded and not translated yet,
+  // zero is a share of the physical memory, see BatchesGovernor.
+  uint64_t m_batchesMemoryBudget{0};
+  // Write the intermediate features as the compressed frames, see feature::FeaturesCompression.
+  bool m_compressFeatures = false;
+  // The binding of the worker threads to the CPUs and the NUMA nodes.
+  base::threads::ThreadsAffinity m_threadsAffinity = base::threads::ThreadsAffinity::None;
+
+  // Build the succinct indices of the offsets files in the preprocessing,
+  // see cache::SuccinctOffsetsIndex.
+  bool m_succinctOffsets = false;
 
   bool m_verbose = false;
 
@@ -51,6 +72,8 @@ struct GenerateInfo
       m_osmFileType = OsmSourceType::XML;
     else if (type == "o5m")
       m_osmFileType = OsmSourceType::O5M;
+    else if (type == "pbf")
+      m_osmFileType = OsmSourceType::PBF;
     else
       LOG(LCRITICAL, ("Unknown source type:", type));
   }
@@ -63,10 +86,18 @@ struct GenerateInfo
       m_nodeStorageType = NodeStorageType::Index;
     else if (type == "mem")
       m_nodeStorageType = NodeStorageType::Memory;
+    else if (type == "compressed")
+      m_nodeStorageType = NodeStorageType::Compressed;
     else
       LOG(LCRITICAL, ("Incorrect node_storage type:", type));
   }
 
+  void SetThreadsAffinity(std::string const & affinity)
+  {
+    if (!base::threads::FromString(affinity, m_threadsAffinity))
+      LOG(LCRITICAL, ("Incorrect threads_affinity:", affinity));
+  }
+
   std::string GetTmpFileName(std::string const & fileName,
                              std::string const & ext = DATA_FILE_EXTENSION_TMP) const
   {
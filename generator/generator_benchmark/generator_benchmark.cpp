@@ -0,0 +1,434 @@
+#include "generator/covering_index_generator.hpp"
+#include "generator/feature_builder.hpp"
+#include "generator/generate_info.hpp"
+#include "generator/geo_objects/geo_objects_generator.hpp"
+#include "generator/osm_element.hpp"
+#include "generator/osm_source.hpp"
+#include "generator/raw_generator.hpp"
+#include "generator/regions/collector_region_info.hpp"
+#include "generator/regions/regions.hpp"
+#include "generator/stages_report.hpp"
+#include "generator/streets/streets.hpp"
+#include "generator/synthetic_planet.hpp"
+
+#include "indexer/classificator_loader.hpp"
+#include "indexer/map_style_reader.hpp"
+
+#include "platform/platform.hpp"
+
+#include "base/assert.hpp"
+#include "base/file_name_utils.hpp"
+#include "base/logging.hpp"
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+using namespace std;
+
+namespace po = boost::program_options;
+
+namespace
+{
+struct BenchmarkOptions
+{
+  string m_osmFileName;
+  string m_osmFileType;
+  string m_nodeStorage;
+  string m_userResourcePath;
+  string m_dataPath;
+  string m_threads;
+  uint32_t m_syntheticScale = 0;
+  bool m_json = false;
+};
+
+// A stage of a run with the items it has processed: the osm elements of the preprocessing and
+// the features of the other stages.
+struct StageResult
+{
+  StageReport m_report;
+  uint64_t m_items = 0;
+};
+
+// The files of a run, all of them are in the run directory.
+struct RunFiles
+{
+  explicit RunFiles(string const & dir)
+    : m_regionsFeatures(base::JoinPath(dir, "regions" DATA_FILE_EXTENSION_TMP))
+    , m_streetsFeatures(base::JoinPath(dir, "streets" DATA_FILE_EXTENSION_TMP))
+    , m_geoObjectsFeatures(base::JoinPath(dir, "geo_objects" DATA_FILE_EXTENSION_TMP))
+    , m_regionsIndex(base::JoinPath(dir, "regions.locidx"))
+    , m_regionsKeyValue(base::JoinPath(dir, "regions.jsonl"))
+    , m_streetsKeyValue(base::JoinPath(dir, "streets.jsonl"))
+    , m_geoObjectsKeyValue(base::JoinPath(dir, "geo_objects.jsonl"))
+    , m_idsWithoutAddresses(base::JoinPath(dir, "ids_without_addresses.txt"))
+    , m_geoObjectsIndex(base::JoinPath(dir, "geo_objects.locidx"))
+  {
+  }
+
+  string m_regionsFeatures;
+  string m_streetsFeatures;
+  string m_geoObjectsFeatures;
+  string m_regionsIndex;
+  string m_regionsKeyValue;
+  string m_streetsKeyValue;
+  string m_geoObjectsKeyValue;
+  string m_idsWithoutAddresses;
+  string m_geoObjectsIndex;
+};
+
+// Returns the threads counts of the runs: |threads| is a comma separated list, the default
+// ones are 1, N/2 and N where N is the number of the cores.
+vector<unsigned int> GetThreadsCounts(string const & threads)
+{
+  vector<unsigned int> counts;
+  if (threads.empty())
+  {
+    auto const cores = max(GetPlatform().CpuCores(), 1u);
+    counts = {1, max(cores / 2, 1u), cores};
+  }
+  else
+  {
+    for (auto const & token : strings::Tokenize(threads, ","))
+    {
+      unsigned int count = 0;
+      if (!strings::to_uint(token, count) || count == 0)
+        return {};
+      counts.push_back(count);
+    }
+  }
+
+  sort(counts.begin(), counts.end());
+  counts.erase(unique(counts.begin(), counts.end()), counts.end());
+  return counts;
+}
+
+uint64_t CountOsmElements(feature::GenerateInfo const & info)
+{
+  SourceReader reader(info.m_osmFileName);
+  unique_ptr<ProcessorOsmElementsInterface> processor;
+  switch (info.m_osmFileType)
+  {
+  case feature::GenerateInfo::OsmSourceType::XML:
+    processor = make_unique<ProcessorOsmElementsFromXml>(reader);
+    break;
+  case feature::GenerateInfo::OsmSourceType::O5M:
+    processor = make_unique<ProcessorOsmElementsFromO5M>(reader);
+    break;
+  case feature::GenerateInfo::OsmSourceType::PBF:
+    processor = make_unique<ProcessorOsmElementsFromPbf>(reader);
+    break;
+  }
+
+  uint64_t count = 0;
+  OsmElement element;
+  while (processor->TryRead(element))
+    ++count;
+  return count;
+}
+
+uint64_t CountFeatures(string const & filename)
+{
+  if (!Platform::IsFileExistsByFullPath(filename))
+    return 0;
+
+  uint64_t count = 0;
+  feature::ForEachFromDatRawFormat(
+      filename, [&count](feature::FeatureBuilder const &, uint64_t /* currPos */) { ++count; });
+  return count;
+}
+
+// Runs |fn| as a stage which has processed |items|.
+template <typename Fn>
+StageResult RunStage(string const & name, uint64_t items, Fn && fn)
+{
+  LOG(LINFO, ("Benchmark stage", name, "...."));
+  {
+    ScopedStage stage(name);
+    fn();
+  }
+
+  // The nested stages of the generator are finished before the stage.
+  auto const stages = StagesReport::Instance().GetStages();
+  CHECK(!stages.empty(), ());
+  CHECK_EQUAL(stages.back().m_name, name, ());
+  return {stages.back(), items};
+}
+
+// Runs all the stages in |threadsCount| threads with the files in |dir|.
+vector<StageResult> RunStages(feature::GenerateInfo info, unsigned int threadsCount,
+                              string const & dir, uint64_t osmElementsCount)
+{
+  info.m_threadsCount = threadsCount;
+  info.m_dataPath = base::AddSlashIfNeeded(dir);
+  info.m_targetDir = info.m_dataPath;
+  info.m_tmpDir = info.m_dataPath;
+  RunFiles const files(dir);
+  auto const regionsInfoPath =
+      info.GetTmpFileName("region", regions::CollectorRegionInfo::kDefaultExt);
+
+  vector<StageResult> results;
+  results.push_back(RunStage("preprocess", osmElementsCount, [&]() {
+    CHECK(GenerateIntermediateData(info), ());
+  }));
+
+  {
+    RawGenerator rawGenerator(info);
+    rawGenerator.GenerateRegionFeatures(files.m_regionsFeatures, regionsInfoPath);
+    rawGenerator.GenerateStreetsFeatures(files.m_streetsFeatures);
+    rawGenerator.GenerateGeoObjectsFeatures(files.m_geoObjectsFeatures);
+    results.push_back(RunStage("features", 0 /* items */, [&]() {
+      CHECK(rawGenerator.Execute(), ());
+    }));
+  }
+  auto const regionsCount = CountFeatures(files.m_regionsFeatures);
+  auto const streetsCount = CountFeatures(files.m_streetsFeatures);
+  auto const geoObjectsCount = CountFeatures(files.m_geoObjectsFeatures);
+  results.back().m_items = regionsCount + streetsCount + geoObjectsCount;
+
+  results.push_back(RunStage("regions index", regionsCount, [&]() {
+    CHECK(GenerateRegionsIndex(files.m_regionsIndex, files.m_regionsFeatures, threadsCount), ());
+    CHECK(GenerateBorders(files.m_regionsIndex, files.m_regionsFeatures), ());
+  }));
+  results.push_back(RunStage("regions key-value", regionsCount, [&]() {
+    regions::GenerateRegions(files.m_regionsFeatures, regionsInfoPath, files.m_regionsKeyValue,
+                             false /* verbose */, threadsCount);
+  }));
+  results.push_back(RunStage("streets", streetsCount, [&]() {
+    streets::GenerateStreets(files.m_regionsIndex, files.m_regionsKeyValue,
+                             files.m_streetsFeatures, files.m_geoObjectsFeatures,
+                             files.m_streetsKeyValue, false /* verbose */, threadsCount);
+  }));
+  results.push_back(RunStage("geo objects", geoObjectsCount, [&]() {
+    CHECK(geo_objects::GenerateGeoObjects(files.m_regionsIndex, files.m_regionsKeyValue,
+                                          files.m_geoObjectsFeatures, files.m_idsWithoutAddresses,
+                                          files.m_geoObjectsKeyValue, 0 /* geoDataMemoryBudget */,
+                                          false /* verbose */, threadsCount),
+          ());
+  }));
+  results.push_back(RunStage("geo objects index", geoObjectsCount, [&]() {
+    CHECK(GenerateGeoObjectsIndex(files.m_geoObjectsIndex, files.m_geoObjectsFeatures,
+                                  threadsCount, files.m_idsWithoutAddresses,
+                                  files.m_streetsFeatures),
+          ());
+  }));
+  return results;
+}
+
+double GetItemsPerSecond(StageResult const & stage)
+{
+  auto const seconds = stage.m_report.m_wallSeconds;
+  return seconds > 0 ? static_cast<double>(stage.m_items) / seconds : 0.0;
+}
+
+base::JSONPtr ToJson(unsigned int threadsCount, vector<StageResult> const & stages)
+{
+  auto stagesJson = base::NewJSONArray();
+  for (auto const & stage : stages)
+  {
+    auto const & report = stage.m_report;
+    auto json = base::NewJSONObject();
+    ToJSONObject(*json, "name", report.m_name);
+    ToJSONObject(*json, "items", stage.m_items);
+    ToJSONObject(*json, "items_per_second", GetItemsPerSecond(stage));
+    ToJSONObject(*json, "wall_seconds", report.m_wallSeconds);
+    ToJSONObject(*json, "cpu_seconds", report.m_cpuSeconds);
+    ToJSONObject(*json, "peak_rss_bytes", report.m_peakRssBytes);
+    ToJSONObject(*json, "read_bytes", report.m_readBytes);
+    ToJSONObject(*json, "written_bytes", report.m_writtenBytes);
+    ToJSONArray(*stagesJson, json);
+  }
+
+  auto run = base::NewJSONObject();
+  ToJSONObject(*run, "threads", threadsCount);
+  ToJSONObject(*run, "stages", stagesJson);
+  return run;
+}
+
+void PrintText(unsigned int threadsCount, vector<StageResult> const & stages)
+{
+  auto const toMb = [](uint64_t bytes) { return bytes / (1024 * 1024); };
+  cout << "Threads: " << threadsCount << endl;
+  for (auto const & stage : stages)
+  {
+    auto const & report = stage.m_report;
+    cout << "  " << report.m_name << ": " << fixed << setprecision(3) << report.m_wallSeconds
+         << " s, " << stage.m_items << " items, " << setprecision(0) << GetItemsPerSecond(stage)
+         << " items/s, cpu " << setprecision(3) << report.m_cpuSeconds << " s, peak RSS "
+         << toMb(report.m_peakRssBytes) << " MB, read " << toMb(report.m_readBytes)
+         << " MB, written " << toMb(report.m_writtenBytes) << " MB" << endl;
+  }
+}
+
+// Every run is made by a child process, so the peak RSS of a run and the state of
+// the allocator do not depend on the previous runs. The child prints the text report or writes
+// the json one to |jsonReportPath|. Returns false if the run has failed.
+bool Run(feature::GenerateInfo const & info, unsigned int threadsCount, string const & dir,
+         uint64_t osmElementsCount, string const & jsonReportPath)
+{
+  cout.flush();
+  auto const pid = fork();
+  CHECK_NOT_EQUAL(pid, -1, ("Can't fork the run in", threadsCount, "threads"));
+  if (pid == 0)
+  {
+    bool isSuccess = false;
+    if (Platform::MkDirChecked(dir))
+    {
+      auto const stages = RunStages(info, threadsCount, dir, osmElementsCount);
+      if (jsonReportPath.empty())
+      {
+        PrintText(threadsCount, stages);
+        isSuccess = static_cast<bool>(cout.flush());
+      }
+      else
+      {
+        ofstream stream(jsonReportPath);
+        stream << base::DumpToString(ToJson(threadsCount, stages));
+        isSuccess = static_cast<bool>(stream.flush());
+      }
+    }
+    // The child does not run the destructors of the parent objects.
+    _exit(isSuccess ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  int status = 0;
+  CHECK_EQUAL(waitpid(pid, &status, 0), pid, ());
+  Platform::RmDirRecursively(dir);
+  return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+string ReadFile(string const & path)
+{
+  ifstream stream(path);
+  return {istreambuf_iterator<char>(stream), istreambuf_iterator<char>()};
+}
+
+BenchmarkOptions DefineOptions(int argc, char * argv[])
+{
+  BenchmarkOptions o;
+  po::options_description optionsDescription;
+
+  optionsDescription.add_options()
+    ("osm_file_name", po::value(&o.m_osmFileName)->default_value(""), "Input osm file, e.g. the unpacked data/minsk-pass.osm.bz2 extract to compare the commits")
+    ("osm_file_type", po::value(&o.m_osmFileType)->default_value("xml"), "Input osm file type [xml, o5m, pbf]")
+    ("node_storage", po::value(&o.m_nodeStorage)->default_value("map"), "Type of storage for intermediate points representation [raw, map, mem, compressed]")
+    ("user_resource_path", po::value(&o.m_userResourcePath)->default_value(""), "Path to classificator.txt and etc.")
+    ("data_path", po::value(&o.m_dataPath)->default_value(""), "Directory for the files of the runs, they are removed after every run")
+    ("threads", po::value(&o.m_threads)->default_value(""), "Comma separated threads counts of the runs, 1, N/2 and N cores by default")
+    ("synthetic_scale", po::value(&o.m_syntheticScale)->default_value(0), "Run on the synthetic planet of the scale instead of osm_file_name, see synthetic_planet_tool")
+    ("json", po::bool_switch(&o.m_json), "Print the report as json")
+    ("help", "produce help message");
+
+  po::variables_map vm;
+
+  po::store(po::parse_command_line(argc, argv, optionsDescription), vm);
+  po::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << optionsDescription << std::endl;
+    exit(1);
+  }
+
+  return o;
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  BenchmarkOptions options;
+  try
+  {
+    options = DefineOptions(argc, argv);
+  }
+  catch(po::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    return 1;
+  }
+
+  if ((options.m_osmFileName.empty() && options.m_syntheticScale == 0) ||
+      options.m_userResourcePath.empty() || options.m_dataPath.empty())
+  {
+    std::cerr << "ERROR: osm_file_name or synthetic_scale, user_resource_path and data_path are "
+                 "required"
+              << std::endl;
+    return 1;
+  }
+  auto const threadsCounts = GetThreadsCounts(options.m_threads);
+  if (threadsCounts.empty())
+  {
+    std::cerr << "ERROR: threads must be positive numbers" << std::endl;
+    return 1;
+  }
+
+  auto & platform = GetPlatform();
+  platform.SetWritableDir(options.m_dataPath);
+  platform.SetResourceDir(options.m_userResourcePath);
+  GetStyleReader().SetCurrentStyle(MapStyleMerged);
+  classificator::Load();
+
+  feature::GenerateInfo info;
+  info.m_osmFileName = options.m_osmFileName;
+  info.SetOsmFileType(options.m_osmFileType);
+  info.SetNodeStorageType(options.m_nodeStorage);
+
+  // The synthetic planet is the same for the same scale, so the runs of the commits compare.
+  string syntheticPlanet;
+  if (options.m_syntheticScale != 0)
+  {
+    syntheticPlanet = base::JoinPath(options.m_dataPath, "synthetic_planet.o5m");
+    SyntheticPlanetParams params;
+    params.Scale(options.m_syntheticScale);
+    GenerateSyntheticPlanet(params, syntheticPlanet);
+    info.m_osmFileName = syntheticPlanet;
+    info.SetOsmFileType("o5m");
+  }
+
+  // The elements are counted out of the runs, so the counting does not warm up the page cache
+  // for the first run only.
+  auto const osmElementsCount = CountOsmElements(info);
+  LOG(LINFO, ("Osm elements:", osmElementsCount));
+
+  auto runs = base::NewJSONArray();
+  for (auto const threadsCount : threadsCounts)
+  {
+    auto const dir = base::JoinPath(options.m_dataPath, "run_" + to_string(threadsCount));
+    auto const jsonReportPath = options.m_json ? dir + ".json" : string();
+    if (!Run(info, threadsCount, dir, osmElementsCount, jsonReportPath))
+    {
+      std::cerr << "ERROR: the run in " << threadsCount << " threads has failed" << std::endl;
+      return 1;
+    }
+
+    if (options.m_json)
+    {
+      auto run = base::LoadFromString(ReadFile(jsonReportPath));
+      ToJSONArray(*runs, run);
+      Platform::RemoveFileIfExists(jsonReportPath);
+    }
+  }
+
+  if (!syntheticPlanet.empty())
+    Platform::RemoveFileIfExists(syntheticPlanet);
+
+  if (options.m_json)
+    cout << base::DumpToString(runs, JSON_INDENT(2)) << endl;
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "testing/testing.hpp"
+
+#include "generator/affiliation.hpp"
+#include "generator/feature_builder.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace feature;
+using namespace generator::regions;
+
+namespace
+{
+BoostPolygon MakeRect(double minX, double minY, double maxX, double maxY)
+{
+  BoostPolygon polygon;
+  boost::geometry::convert(BoostRect{{minX, minY}, {maxX, maxY}}, polygon);
+  return polygon;
+}
+
+CountriesAffiliation::Borders MakeBorders()
+{
+  CountriesAffiliation::Borders borders;
+  borders["Left"] = {MakeRect(0.0, 0.0, 10.0, 10.0), MakeRect(30.0, 30.0, 31.0, 31.0)};
+  borders["Right"] = {MakeRect(10.0, 0.0, 20.0, 10.0)};
+  return borders;
+}
+
+FeatureBuilder MakePoint(double x, double y)
+{
+  FeatureBuilder fb;
+  fb.SetCenter({x, y});
+  return fb;
+}
+
+std::vector<std::string> GetAffiliations(CountriesAffiliation const & affiliation,
+                                         FeatureBuilder const & fb)
+{
+  return *affiliation.GetAffiliations(fb);
+}
+}  // namespace
+
+UNIT_TEST(CountriesAffiliation_Smoke)
+{
+  CountriesAffiliation const affiliation(MakeBorders());
+  using Names = std::vector<std::string>;
+
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(5.0, 5.0)), Names({"Left"}), ());
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(30.5, 30.5)), Names({"Left"}), ());
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(15.0, 5.0)), Names({"Right"}), ());
+  // The common border.
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(10.0, 5.0)), Names({"Left", "Right"}), ());
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(25.0, 25.0)), Names(), ());
+  TEST_EQUAL(GetAffiliations(affiliation, MakePoint(-1.0, 5.0)), Names(), ());
+
+  FeatureBuilder line;
+  line.AddPoint({5.0, 5.0});
+  line.AddPoint({15.0, 5.0});
+  line.AddPoint({16.0, 6.0});
+  line.SetLinear();
+  TEST_EQUAL(GetAffiliations(affiliation, line), Names({"Left", "Right"}), ());
+
+  TEST(affiliation.HasRegionByName("Left"), ());
+  TEST(affiliation.HasRegionByName("Right"), ());
+  TEST(!affiliation.HasRegionByName("Center"), ());
+}
+
+UNIT_TEST(CountriesAffiliation_Points)
+{
+  // Stars, which are crossed by many cells of the grid.
+  CountriesAffiliation::Borders borders;
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-100.0, 100.0);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    BoostPolygon polygon;
+    auto const centerX = distribution(engine);
+    auto const centerY = distribution(engine);
+    size_t const kRays = 20;
+    for (size_t j = 0; j < 2 * kRays; ++j)
+    {
+      auto const angle = M_PI * j / kRays;
+      auto const radius = j % 2 == 0 ? 30.0 : 10.0;
+      polygon.outer().emplace_back(centerX + radius * std::cos(angle),
+                                   centerY + radius * std::sin(angle));
+    }
+    boost::geometry::correct(polygon);
+    borders["Country " + std::to_string(i)] = {polygon};
+  }
+
+  CountriesAffiliation const affiliation(borders);
+  for (size_t i = 0; i < 10000; ++i)
+  {
+    BoostPoint const point{1.5 * distribution(engine), 1.5 * distribution(engine)};
+    std::vector<std::string> expected;
+    for (auto const & country : borders)
+    {
+      if (boost::geometry::covered_by(point, country.second.front()))
+        expected.emplace_back(country.first);
+    }
+
+    TEST_EQUAL(GetAffiliations(affiliation, MakePoint(point.get<0>(), point.get<1>())), expected,
+               (point.get<0>(), point.get<1>()));
+  }
+}
@@ -0,0 +1,88 @@
+#include "testing/testing.hpp"
+
+#include "generator/batches_governor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace generator;
+
+UNIT_TEST(BatchesGovernor_BatchSize)
+{
+  BatchesGovernor::Params params;
+  params.m_initialBatchSize = 1000;
+  params.m_minBatchSize = 10;
+  params.m_maxBatchSize = 10000;
+  params.m_targetBatchSeconds = 0.01;
+  BatchesGovernor governor(params);
+  TEST_EQUAL(governor.GetBatchSize(), 1000, ());
+
+  // 10 microseconds per element.
+  governor.AddProcessedBatch(1000 /* elementsCount */, 1000 /* bytes */, 0.01 /* seconds */,
+                             1 /* queueDepth */);
+  TEST_EQUAL(governor.GetBatchSize(), 1000, ());
+
+  // The consumers starve.
+  governor.AddProcessedBatch(1000 /* elementsCount */, 1000 /* bytes */, 0.01 /* seconds */,
+                             0 /* queueDepth */);
+  TEST_EQUAL(governor.GetBatchSize(), 500, ());
+
+  // Heavy elements.
+  for (size_t i = 0; i < 100; ++i)
+  {
+    governor.AddProcessedBatch(10 /* elementsCount */, 10 /* bytes */, 1.0 /* seconds */,
+                               1 /* queueDepth */);
+  }
+  TEST_EQUAL(governor.GetBatchSize(), params.m_minBatchSize, ());
+
+  // Light elements.
+  BatchesGovernor lightGovernor(params);
+  lightGovernor.AddProcessedBatch(1000 /* elementsCount */, 1000 /* bytes */, 0.0 /* seconds */,
+                                  1 /* queueDepth */);
+  TEST_EQUAL(lightGovernor.GetBatchSize(), params.m_maxBatchSize, ());
+}
+
+UNIT_TEST(BatchesGovernor_BatchSizeFitsBudget)
+{
+  BatchesGovernor::Params params;
+  params.m_memoryBudget = 100000;
+  params.m_slotsCount = 10;
+  params.m_minBatchSize = 10;
+  BatchesGovernor governor(params);
+
+  // The elements of 100 bytes, a slot is 10000 bytes.
+  governor.AddProcessedBatch(1000 /* elementsCount */, 100000 /* bytes */, 0.0 /* seconds */,
+                             1 /* queueDepth */);
+  TEST_EQUAL(governor.GetBatchSize(), 100, ());
+}
+
+UNIT_TEST(BatchesGovernor_Backpressure)
+{
+  BatchesGovernor::Params params;
+  params.m_memoryBudget = 100;
+  BatchesGovernor governor(params);
+
+  // A batch larger than the budget is admitted when nothing is in flight.
+  governor.Acquire(150);
+  TEST_EQUAL(governor.GetInFlightBytes(), 150, ());
+  governor.Release(150);
+
+  governor.Acquire(60);
+  std::atomic<bool> acquired{false};
+  std::thread producer([&] {
+    governor.Acquire(60);
+    acquired = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  TEST(!acquired, ());
+
+  governor.Release(60);
+  producer.join();
+  TEST(acquired, ());
+  TEST_EQUAL(governor.GetInFlightBytes(), 60, ());
+  TEST_EQUAL(governor.GetMaxInFlightBytes(), 150, ());
+  TEST_GREATER(governor.GetBlockedSeconds(), 0.0, ());
+  governor.Release(60);
+  TEST_EQUAL(governor.GetInFlightBytes(), 0, ());
+}
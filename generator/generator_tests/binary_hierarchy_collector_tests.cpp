@@ -0,0 +1,112 @@
+#include "testing/testing.hpp"
+
+#include "generator/binary_hierarchy_collector.hpp"
+#include "generator/json_writer.hpp"
+#include "generator/key_value_storage.hpp"
+
+#include "geocoder/binary_hierarchy.hpp"
+#include "geocoder/types.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+
+namespace
+{
+using Entry = geocoder::BinaryHierarchyEntry;
+
+std::vector<Entry> ReadChunk(std::string const & chunk)
+{
+  geocoder::BinaryHierarchyChunkHeader header;
+  TEST_GREATER_OR_EQUAL(chunk.size(), geocoder::BinaryHierarchyChunkHeader::kSize, ());
+  TEST(header.Read(chunk.data()), ());
+  TEST_EQUAL(header.m_version, geocoder::BinaryHierarchyChunkHeader::kVersion, ());
+  TEST_EQUAL(header.m_entriesSize + geocoder::BinaryHierarchyChunkHeader::kSize, chunk.size(),
+             ());
+
+  auto const chunkEntries = chunk.substr(geocoder::BinaryHierarchyChunkHeader::kSize);
+  geocoder::BinaryHierarchyChunkReader reader(chunkEntries);
+  std::vector<Entry> entries;
+  Entry entry;
+  while (reader.Read(entry))
+    entries.push_back(entry);
+  return entries;
+}
+
+std::vector<Entry::Name> const & GetNames(Entry const & entry, geocoder::Type type)
+{
+  return entry.m_address[static_cast<size_t>(type)];
+}
+}  // namespace
+
+UNIT_TEST(BinaryHierarchyCollector_JsonValue)
+{
+  auto const value = JsonValue{base::LoadFromString(
+      R"({"type": "Feature", "properties": {"kind": "city", "rank": 8, "locales": {)"
+      R"("default": {"name": "Москва", "address": {"locality": "Москва", "country": "Россия"}},)"
+      R"("en": {"name": "Moscow", "address": {"locality": "Moscow", "country": "Russia",)"
+      R"("region": ""}}}}})")};
+  auto const nullFieldValue = JsonValue{base::LoadFromString(
+      R"({"properties": {"locales": {"default": {"address": {"street": null}}}}})")};
+
+  BinaryHierarchyCollector collector;
+  TEST(collector.IsEmpty(), ());
+  collector.Add(0x10, value);
+  collector.Add(0x20, nullFieldValue);
+  TEST(!collector.IsEmpty(), ());
+
+  auto const entries = ReadChunk(collector.ReleaseChunk());
+  TEST(collector.IsEmpty(), ());
+  TEST_EQUAL(entries.size(), 1, ());
+  auto const & entry = entries.front();
+  TEST_EQUAL(entry.m_osmId, base::GeoObjectId(0x10), ());
+  TEST_EQUAL(entry.m_kind, geocoder::Kind::City, ());
+  TEST_EQUAL(entry.m_rank, 8, ());
+  TEST(entry.m_hasName, ());
+  TEST_EQUAL(GetNames(entry, geocoder::Type::Locality),
+             std::vector<Entry::Name>({{"default", "москва"}, {"en", "moscow"}}), ());
+  TEST_EQUAL(GetNames(entry, geocoder::Type::Country),
+             std::vector<Entry::Name>({{"default", "россия"}, {"en", "russia"}}), ());
+  TEST(GetNames(entry, geocoder::Type::Region).empty(), ());
+  TEST(GetNames(entry, geocoder::Type::Street).empty(), ());
+}
+
+UNIT_TEST(BinaryHierarchyCollector_JsonObjectPatch)
+{
+  auto const source = base::LoadFromString(
+      R"({"properties": {"kind": "building", "locales": {"default": {"address": {)"
+      R"("locality": "Москва"}}}}})");
+
+  JsonObjectPatch patch(source.get());
+  auto & address = patch.GetObligatoryObject("properties")
+                       .GetObligatoryObject("locales")
+                       .GetObligatoryObject("default")
+                       .GetObligatoryObject("address");
+  address.Set("street", "Тверская улица");
+  address.Set("building", "7");
+
+  BinaryHierarchyCollector collector;
+  collector.Add(0x30, patch);
+  auto const entries = ReadChunk(collector.ReleaseChunk());
+  TEST_EQUAL(entries.size(), 1, ());
+  auto const & entry = entries.front();
+  TEST_EQUAL(entry.m_osmId, base::GeoObjectId(0x30), ());
+  TEST_EQUAL(entry.m_kind, geocoder::Kind::Building, ());
+  TEST(!entry.m_hasName, ());
+  TEST_EQUAL(GetNames(entry, geocoder::Type::Locality),
+             std::vector<Entry::Name>({{"default", "москва"}}), ());
+  TEST_EQUAL(GetNames(entry, geocoder::Type::Street),
+             std::vector<Entry::Name>({{"default", "тверская улица"}}), ());
+  TEST_EQUAL(GetNames(entry, geocoder::Type::Building),
+             std::vector<Entry::Name>({{"default", "7"}}), ());
+
+  address.SetNull("street");
+  collector.Add(0x30, patch);
+  TEST(collector.IsEmpty(), ());
+}
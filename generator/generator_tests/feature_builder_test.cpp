@@ -3,6 +3,7 @@
 #include "types_helper.hpp"
 
 #include "generator/feature_builder.hpp"
+#include "generator/generator_tests/common.hpp"
 #include "generator/generator_tests_support/test_with_classificator.hpp"
 #include "generator/geometry_holder.hpp"
 
@@ -11,9 +12,17 @@
 #include "indexer/data_header.cpp"
 #include "indexer/feature_visibility.hpp"
 
+#include "coding/internal/file_data.hpp"
+
 #include "base/geo_object_id.hpp"
 
+#include <algorithm>
 #include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "defines.hpp"
 
 using namespace feature;
 
@@ -357,3 +366,190 @@ UNIT_TEST(FeatureBuilder_SerializeAccuratelyForIntermediate)
   Check(fb2);
   TEST(fb1.IsExactEq(fb2), ());
 }
+
+UNIT_TEST(FeatureBuilder_ReuseForDeserialization)
+{
+  classificator::Load();
+
+  FeatureBuilder line;
+  {
+    FeatureParams params;
+    char const * arr[][2] = {{"railway", "rail"}, {"hwtag", "oneway"}};
+    AddTypes(params, arr);
+    params.FinishAddingTypes();
+    params.AddName("default", "Line");
+    params.GetMetadata().Set(Metadata::FMD_OPEN_HOURS, "24/7");
+    line.SetParams(params);
+    for (size_t i = 0; i < 10; ++i)
+      line.AddPoint(m2::PointD(i, i + 1));
+    line.SetLinear();
+    line.SetOsmId(base::MakeOsmWay(1));
+    line.AddOsmId(base::MakeOsmWay(2));
+  }
+
+  FeatureBuilder point;
+  {
+    FeatureParams params;
+    char const * arr[][1] = {{"building"}};
+    AddTypes(params, arr);
+    params.FinishAddingTypes();
+    point.SetParams(params);
+    point.SetCenter(m2::PointD(5, 6));
+  }
+
+  std::vector<FeatureBuilder::Buffer> buffers(2);
+  line.SerializeAccuratelyForIntermediate(buffers[0]);
+  point.SerializeAccuratelyForIntermediate(buffers[1]);
+
+  FeatureBuilder reused;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    auto & buffer = buffers[i % buffers.size()];
+    FeatureBuilder fresh;
+    fresh.DeserializeAccuratelyFromIntermediate(buffer);
+    reused.DeserializeAccuratelyFromIntermediate(buffer);
+    TEST(reused.IsExactEq(fresh), (i, reused, fresh));
+    TEST_EQUAL(reused.GetTypes(), fresh.GetTypes(), (i));
+    TEST(reused.GetMetadata().Equals(fresh.GetMetadata()), (i));
+  }
+
+  // A moved from feature builder is reused too.
+  auto const moved = std::move(reused);
+  reused.DeserializeAccuratelyFromIntermediate(buffers[1]);
+  TEST(reused.IsExactEq(moved), ());
+}
+
+UNIT_TEST(FeatureBuilder_ParallelReadingByChunksIndex)
+{
+  using generator_tests::ScopedFile;
+
+  classificator::Load();
+  std::string const featuresFilename = "features_chunks_index.dat";
+  ScopedFile const featuresFile{featuresFilename, ScopedFile::Mode::DoNotCreate};
+  ScopedFile const chunksIndexFile{featuresFilename + FEATURES_CHUNKS_FILE_EXTENSION,
+                                   ScopedFile::Mode::DoNotCreate};
+  auto const makeFeature = [](uint64_t id) {
+    return generator_tests::FeatureBuilderFromOmsElementData(
+        {id, {{"building", "yes"}}, {{id * 0.01, 0.0}}, {}});
+  };
+  auto const readFeatures = [&](unsigned int threadsCount) {
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t, base::GeoObjectId>> features;
+    ProcessParallelFromDatRawFormat(threadsCount, featuresFile.GetFullPath(), [&]() {
+      return [&](FeatureBuilder & fb, uint64_t pos) {
+        std::lock_guard<std::mutex> lock(mutex);
+        features.emplace_back(pos, fb.GetMostGenericOsmId());
+      };
+    });
+    std::sort(features.begin(), features.end());
+    return features;
+  };
+
+  size_t const kFeaturesCount = 2500;
+  {
+    FeatureBuilderWriter<> writer(featuresFile.GetFullPath());
+    for (uint64_t id = 1; id <= kFeaturesCount; ++id)
+      writer.Write(makeFeature(id));
+  }
+  TEST(chunksIndexFile.Exists(), ());
+
+  auto const features = readFeatures(1 /* threadsCount */);
+  TEST_EQUAL(features.size(), kFeaturesCount, ());
+  TEST_EQUAL(readFeatures(4 /* threadsCount */), features, ());
+
+  {
+    FeaturesFileMmap const mmap(featuresFile.GetFullPath());
+    auto const chunksIndex = mmap.LoadChunksIndex();
+    TEST_EQUAL(chunksIndex.GetFeaturesCount(), kFeaturesCount, ());
+    TEST_EQUAL(chunksIndex.GetChunksCount(), 3, ());
+    TEST_EQUAL(chunksIndex.GetChunkBegin(0), 0, ());
+    TEST_EQUAL(chunksIndex.GetChunkBegin(1), features[FeaturesChunksIndex::kFeaturesInChunk].first,
+               ());
+    TEST_EQUAL(chunksIndex.GetChunkEnd(2), mmap.GetSize(), ());
+  }
+
+  // The saved index is stale after an append, the offsets are found by the features.
+  {
+    FeatureBuilderWriter<> writer(featuresFile.GetFullPath(), FileWriter::Op::OP_APPEND);
+    writer.Write(makeFeature(kFeaturesCount + 1));
+  }
+  auto const appendedFeatures = readFeatures(4 /* threadsCount */);
+  TEST_EQUAL(appendedFeatures.size(), kFeaturesCount + 1, ());
+  TEST(std::equal(features.begin(), features.end(), appendedFeatures.begin()), ());
+}
+
+UNIT_TEST(FeatureBuilder_CompressedFeaturesFile)
+{
+  using generator_tests::ScopedFile;
+
+  classificator::Load();
+  ScopedFile const rawFile{"features_raw.dat", ScopedFile::Mode::DoNotCreate};
+  ScopedFile const rawChunksIndexFile{"features_raw.dat" FEATURES_CHUNKS_FILE_EXTENSION,
+                                      ScopedFile::Mode::DoNotCreate};
+  ScopedFile const compressedFile{"features_compressed.dat", ScopedFile::Mode::DoNotCreate};
+  auto const makeFeature = [](uint64_t id) {
+    return generator_tests::FeatureBuilderFromOmsElementData(
+        {id, {{"building", "yes"}}, {{id * 0.01, 0.0}}, {}});
+  };
+  auto const readFeatures = [](std::string const & path, unsigned int threadsCount) {
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t, base::GeoObjectId>> features;
+    ProcessParallelFromDatRawFormat(threadsCount, path, [&]() {
+      return [&](FeatureBuilder & fb, uint64_t pos) {
+        std::lock_guard<std::mutex> lock(mutex);
+        features.emplace_back(pos, fb.GetMostGenericOsmId());
+      };
+    });
+    std::sort(features.begin(), features.end());
+    return features;
+  };
+
+  size_t const kFeaturesCount = 2500;
+  {
+    FeatureBuilderWriter<> rawWriter(rawFile.GetFullPath());
+    FeatureBuilderWriter<> compressedWriter(compressedFile.GetFullPath(),
+                                            FileWriter::Op::OP_WRITE_TRUNCATE,
+                                            FeaturesCompression::Zlib);
+    for (uint64_t id = 1; id <= kFeaturesCount; ++id)
+    {
+      rawWriter.Write(makeFeature(id));
+      compressedWriter.Write(makeFeature(id));
+    }
+  }
+  TEST_EQUAL(GetFeaturesCompression(compressedFile.GetFullPath(), FeaturesCompression::None),
+             FeaturesCompression::Zlib, ());
+  TEST_EQUAL(GetFeaturesCompression(rawFile.GetFullPath(), FeaturesCompression::Zlib),
+             FeaturesCompression::None, ());
+
+  // The offsets of the features are the same as the offsets of the raw file.
+  auto const features = readFeatures(rawFile.GetFullPath(), 1 /* threadsCount */);
+  TEST_EQUAL(readFeatures(compressedFile.GetFullPath(), 1 /* threadsCount */), features, ());
+  TEST_EQUAL(readFeatures(compressedFile.GetFullPath(), 4 /* threadsCount */), features, ());
+
+  {
+    FeaturesFileMmap const rawMmap(rawFile.GetFullPath());
+    FeaturesFileMmap const mmap(compressedFile.GetFullPath());
+    TEST_EQUAL(mmap.GetSize(), rawMmap.GetSize(), ());
+    uint64_t compressedSize = 0;
+    TEST(base::GetFileSize(compressedFile.GetFullPath(), compressedSize), ());
+    TEST_LESS(compressedSize, rawMmap.GetSize(), ());
+
+    auto const chunksIndex = mmap.LoadChunksIndex();
+    TEST_EQUAL(chunksIndex.GetFeaturesCount(), kFeaturesCount, ());
+    TEST_EQUAL(chunksIndex.GetChunksCount(), 3, ());
+    TEST_EQUAL(chunksIndex.GetChunkBegin(1), features[FeaturesChunksIndex::kFeaturesInChunk].first,
+               ());
+    TEST_EQUAL(chunksIndex.GetChunkEnd(2), mmap.GetSize(), ());
+  }
+
+  // The features are appended to the compressed file as the compressed frames.
+  {
+    FeatureBuilderWriter<> writer(compressedFile.GetFullPath(), FileWriter::Op::OP_APPEND);
+    writer.Write(makeFeature(kFeaturesCount + 1));
+  }
+  auto const appendedFeatures = readFeatures(compressedFile.GetFullPath(), 4 /* threadsCount */);
+  TEST_EQUAL(appendedFeatures.size(), kFeaturesCount + 1, ());
+  TEST(std::equal(features.begin(), features.end(), appendedFeatures.begin()), ());
+  TEST_EQUAL(appendedFeatures.back().second, makeFeature(kFeaturesCount + 1).GetMostGenericOsmId(),
+             ());
+}
@@ -0,0 +1,106 @@
+#include "testing/testing.hpp"
+
+#include "generator/feature_builder.hpp"
+#include "generator/features_reordering.hpp"
+#include "generator/generator_tests/common.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "coding/file_reader.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+
+using namespace generator_tests;
+using namespace generator;
+using namespace feature;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+std::vector<OsmElementData> MakeBuildings()
+{
+  std::vector<OsmElementData> buildings;
+  uint64_t id = 1;
+  for (double x = -170.0; x < 170.0; x += 37.0)
+  {
+    for (double y = 160.0; y > -170.0; y -= 41.0)
+    {
+      buildings.push_back({id++,
+                           {{"addr:housenumber", std::to_string(id)}, {"building", "yes"}},
+                           {{x, y}},
+                           {}});
+    }
+  }
+  return buildings;
+}
+
+std::vector<base::GeoObjectId> ReadIds(std::string const & featuresFile)
+{
+  std::vector<base::GeoObjectId> ids;
+  for (auto const & fb : ReadAllDatRawFormat(featuresFile))
+    ids.push_back(fb.GetMostGenericOsmId());
+  return ids;
+}
+
+std::string ReadFile(std::string const & path)
+{
+  std::string data;
+  FileReader(path).ReadAsString(data);
+  return data;
+}
+}  // namespace
+
+UNIT_TEST(FeaturesReordering_HilbertIndex)
+{
+  // The quadrants of the first level of the curve.
+  auto const lowerLeft = GetHilbertIndex({-90.0, -90.0});
+  auto const upperLeft = GetHilbertIndex({-90.0, 90.0});
+  auto const upperRight = GetHilbertIndex({90.0, 90.0});
+  auto const lowerRight = GetHilbertIndex({90.0, -90.0});
+  TEST_LESS(lowerLeft, upperLeft, ());
+  TEST_LESS(upperLeft, upperRight, ());
+  TEST_LESS(upperRight, lowerRight, ());
+
+  TEST_EQUAL(GetHilbertIndex({-180.0, -180.0}), 0, ());
+  TEST_EQUAL(GetHilbertIndex({10.0, 20.0}), GetHilbertIndex({10.0, 20.0}), ());
+}
+
+UNIT_TEST(FeaturesReordering_AlongHilbertCurve)
+{
+  ScopedFile const sequentialFile{"features_reordering_1.dat", ScopedFile::Mode::DoNotCreate};
+  ScopedFile const parallelFile{"features_reordering_4.dat", ScopedFile::Mode::DoNotCreate};
+  ScopedFile const sequentialChunksIndexFile{
+      "features_reordering_1.dat" FEATURES_CHUNKS_FILE_EXTENSION, ScopedFile::Mode::DoNotCreate};
+  ScopedFile const parallelChunksIndexFile{
+      "features_reordering_4.dat" FEATURES_CHUNKS_FILE_EXTENSION, ScopedFile::Mode::DoNotCreate};
+  auto const buildings = MakeBuildings();
+  WriteFeatures(buildings, sequentialFile);
+  WriteFeatures(buildings, parallelFile);
+
+  auto const originalIds = ReadIds(sequentialFile.GetFullPath());
+  ReorderFeaturesAlongHilbertCurve(sequentialFile.GetFullPath(), 1 /* threadsCount */);
+  ReorderFeaturesAlongHilbertCurve(parallelFile.GetFullPath(), 4 /* threadsCount */);
+  TEST(sequentialChunksIndexFile.Exists(), ());
+  TEST_EQUAL(ReadFile(sequentialFile.GetFullPath()), ReadFile(parallelFile.GetFullPath()), ());
+
+  auto const features = ReadAllDatRawFormat(sequentialFile.GetFullPath());
+  TEST_EQUAL(features.size(), buildings.size(), ());
+  for (size_t i = 1; i < features.size(); ++i)
+  {
+    TEST_LESS_OR_EQUAL(GetHilbertIndex(features[i - 1].GetLimitRect().Center()),
+                       GetHilbertIndex(features[i].GetLimitRect().Center()), ());
+  }
+
+  auto ids = ReadIds(sequentialFile.GetFullPath());
+  TEST_NOT_EQUAL(ids, originalIds, ());
+  std::sort(ids.begin(), ids.end());
+  auto sortedOriginalIds = originalIds;
+  std::sort(sortedOriginalIds.begin(), sortedOriginalIds.end());
+  TEST_EQUAL(ids, sortedOriginalIds, ());
+}
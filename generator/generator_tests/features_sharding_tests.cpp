@@ -0,0 +1,117 @@
+#include "testing/testing.hpp"
+
+#include "generator/feature_builder.hpp"
+#include "generator/features_sharding.hpp"
+#include "generator/generator_tests/common.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "coding/file_reader.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+
+using namespace generator_tests;
+using namespace generator;
+using namespace feature;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+// The country of the points of the negative coordinates is 1, of the positive ones is 2.
+uint64_t GetCountryId(m2::PointD const & point) { return point.x < 0.0 ? 1 : 2; }
+
+std::vector<OsmElementData> MakePoints(uint64_t firstId, std::vector<double> const & coordinates)
+{
+  std::vector<OsmElementData> points;
+  for (auto const coordinate : coordinates)
+  {
+    auto const id = firstId++;
+    points.push_back({id,
+                      {{"addr:housenumber", std::to_string(id)}, {"building", "yes"}},
+                      {{coordinate, coordinate}},
+                      {}});
+  }
+  return points;
+}
+
+std::vector<uint64_t> ReadIds(std::string const & featuresFile)
+{
+  std::vector<uint64_t> ids;
+  for (auto const & fb : ReadAllDatRawFormat(featuresFile))
+    ids.push_back(fb.GetMostGenericOsmId().GetSerialId());
+  return ids;
+}
+}  // namespace
+
+UNIT_TEST(FeaturesSharding_AssignCountriesToShards)
+{
+  std::map<uint64_t, uint64_t> const counts = {{0, 1}, {1, 10}, {2, 7}, {3, 5}, {4, 3}};
+  std::map<uint64_t, size_t> const expected = {{0, 1}, {1, 0}, {2, 1}, {3, 1}, {4, 0}};
+  TEST_EQUAL(AssignCountriesToShards(counts, 2 /* shardsCount */), expected, ());
+
+  for (auto const & shard : AssignCountriesToShards(counts, 1 /* shardsCount */))
+    TEST_EQUAL(shard.second, 0, ());
+}
+
+UNIT_TEST(FeaturesSharding_ShardAndMerge)
+{
+  std::string const geoObjectsFilename = "features_sharding_geo_objects.dat";
+  std::string const streetsFilename = "features_sharding_streets.dat";
+  std::vector<std::unique_ptr<ScopedFile>> files;
+  for (auto const & filename : {geoObjectsFilename, streetsFilename})
+  {
+    for (auto const & name : {filename, GetShardFilename(filename, 0),
+                              GetShardFilename(filename, 1)})
+    {
+      files.push_back(std::make_unique<ScopedFile>(name, ScopedFile::Mode::DoNotCreate));
+      files.push_back(std::make_unique<ScopedFile>(name + FEATURES_CHUNKS_FILE_EXTENSION,
+                                                   ScopedFile::Mode::DoNotCreate));
+    }
+  }
+  auto const & geoObjectsFile = *files[0];
+  auto const & streetsFile = *files[6];
+
+  // The country 1 has more geo objects, the country 2 has more streets.
+  WriteFeatures(MakePoints(1, {-10.0, 10.0, -20.0, -30.0, 20.0, -40.0}), geoObjectsFile);
+  WriteFeatures(MakePoints(100, {30.0, -50.0, 40.0}), streetsFile);
+
+  ShardFeatures(GetCountryId, {geoObjectsFile.GetFullPath(), streetsFile.GetFullPath()},
+                2 /* shardsCount */, 2 /* threadsCount */);
+
+  // The features of the same country are in the same shard of all files and keep their order.
+  auto const geoObjectsPath = geoObjectsFile.GetFullPath();
+  auto const streetsPath = streetsFile.GetFullPath();
+  TEST_EQUAL(ReadIds(GetShardFilename(geoObjectsPath, 0)), std::vector<uint64_t>({1, 3, 4, 6}), ());
+  TEST_EQUAL(ReadIds(GetShardFilename(geoObjectsPath, 1)), std::vector<uint64_t>({2, 5}), ());
+  TEST_EQUAL(ReadIds(GetShardFilename(streetsPath, 0)), std::vector<uint64_t>({101}), ());
+  TEST_EQUAL(ReadIds(GetShardFilename(streetsPath, 1)), std::vector<uint64_t>({100, 102}), ());
+
+  MergeShardFeatures(geoObjectsPath, 2 /* shardsCount */);
+  MergeShardFeatures(streetsPath, 2 /* shardsCount */);
+  TEST_EQUAL(ReadIds(geoObjectsPath), std::vector<uint64_t>({1, 3, 4, 6, 2, 5}), ());
+  TEST_EQUAL(ReadIds(streetsPath), std::vector<uint64_t>({101, 100, 102}), ());
+}
+
+UNIT_TEST(FeaturesSharding_MergeShardFiles)
+{
+  std::string const filename = "features_sharding.jsonl";
+  ScopedFile const merged{filename, "stale"};
+  ScopedFile const shard0{GetShardFilename(filename, 0), "1\t{}\n"};
+  ScopedFile const shard1{GetShardFilename(filename, 1), "2\t{}\n3\t{}\n"};
+
+  MergeShardFiles(merged.GetFullPath(), 2 /* shardsCount */);
+
+  std::string data;
+  FileReader(merged.GetFullPath()).ReadAsString(data);
+  TEST_EQUAL(data, "1\t{}\n2\t{}\n3\t{}\n", ());
+  TEST(shard0.Exists(), ());
+  TEST(shard1.Exists(), ());
+}
@@ -0,0 +1,85 @@
+#include "testing/testing.hpp"
+
+#include "generator/filter_collection.hpp"
+#include "generator/generator_tests/common.hpp"
+#include "generator/osm_element.hpp"
+#include "generator/tag_keys_signature.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace generator;
+using namespace generator_tests;
+
+namespace
+{
+class FilterByKeys : public FilterInterface
+{
+public:
+  FilterByKeys(std::vector<std::string> const & keys, size_t & calls) : m_keys(keys), m_calls(calls) {}
+
+  // FilterInterface overrides:
+  std::shared_ptr<FilterInterface> Clone() const override
+  {
+    return std::make_shared<FilterByKeys>(m_keys, m_calls);
+  }
+
+  bool IsAccepted(OsmElement const & element) override
+  {
+    ++m_calls;
+    for (auto const & key : m_keys)
+    {
+      if (element.HasTag(key))
+        return true;
+    }
+    return false;
+  }
+
+  std::vector<std::string> GetRequiredTagKeys() const override { return m_keys; }
+
+private:
+  std::vector<std::string> m_keys;
+  size_t & m_calls;
+};
+}  // namespace
+
+UNIT_TEST(TagKeysSignature_Smoke)
+{
+  TagKeysSignature signature;
+  auto const buildingMask = signature.AddKeys({"building"});
+  auto const placeMask = signature.AddKeys({"place", "boundary"});
+  TEST_EQUAL(signature.AddKeys({}), 0, ());
+  TEST_EQUAL(buildingMask & placeMask, 0, ());
+
+  auto const element = MakeOsmElement(1, {{"building", "yes"}, {"name", "Name"}}, OsmElement::EntityType::Node);
+  TEST_EQUAL(signature.Get(element), buildingMask, ());
+
+  auto const other = MakeOsmElement(2, {{"name", "Name"}}, OsmElement::EntityType::Node);
+  TEST_EQUAL(signature.Get(other), 0, ());
+}
+
+UNIT_TEST(FilterCollection_RequiredTagKeys)
+{
+  size_t buildingCalls = 0;
+  size_t nameCalls = 0;
+  FilterCollection filters;
+  filters.Append(std::make_shared<FilterByKeys>(std::vector<std::string>{"building"}, buildingCalls));
+  filters.Append(std::make_shared<FilterByKeys>(std::vector<std::string>{"name"}, nameCalls));
+  TEST_EQUAL(filters.GetRequiredTagKeys(), std::vector<std::string>{"building"}, ());
+
+  auto const building = MakeOsmElement(1, {{"building", "yes"}, {"name", "Name"}}, OsmElement::EntityType::Way);
+  TEST(filters.IsAccepted(building), ());
+  TEST_EQUAL(buildingCalls, 1, ());
+  TEST_EQUAL(nameCalls, 1, ());
+
+  auto const unnamed = MakeOsmElement(2, {{"building", "yes"}}, OsmElement::EntityType::Way);
+  TEST(!filters.IsAccepted(unnamed), ());
+  TEST_EQUAL(buildingCalls, 1, ());
+  TEST_EQUAL(nameCalls, 1, ());
+
+  auto const highway = MakeOsmElement(3, {{"highway", "primary"}}, OsmElement::EntityType::Way);
+  TEST(!filters.IsAccepted(highway), ());
+  TEST_EQUAL(buildingCalls, 1, ());
+  TEST_EQUAL(nameCalls, 1, ());
+}
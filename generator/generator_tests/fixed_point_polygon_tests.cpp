@@ -0,0 +1,94 @@
+#include "testing/testing.hpp"
+
+#include "generator/regions/fixed_point_polygon.hpp"
+
+#include "coding/point_coding.hpp"
+
+#include "base/math.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace generator::regions;
+
+namespace
+{
+// A star with a square hole.
+BoostPolygon MakePolygon()
+{
+  BoostPolygon polygon;
+  size_t const kRays = 50;
+  for (size_t i = 0; i < 2 * kRays; ++i)
+  {
+    auto const angle = M_PI * i / kRays;
+    auto const radius = i % 2 == 0 ? 10.0 : 4.0;
+    polygon.outer().emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+  }
+
+  polygon.inners().resize(1);
+  auto & hole = polygon.inners().front();
+  hole = {{-1.0, -1.0}, {-1.0, 1.0}, {1.0, 1.0}, {1.0, -1.0}};
+  boost::geometry::correct(polygon);
+  return polygon;
+}
+
+BoostPoint Quantize(BoostPoint const & point)
+{
+  auto const p = PointUToPointD(PointDToPointU(point.get<0>(), point.get<1>(), kPointCoordBits),
+                                kPointCoordBits);
+  return {p.x, p.y};
+}
+}  // namespace
+
+UNIT_TEST(FixedPointPolygon_Covers)
+{
+  auto const polygon = MakePolygon();
+  FixedPointPolygon const fixedPointPolygon(polygon);
+  auto const quantizedPolygon = fixedPointPolygon.ToBoostPolygon();
+  TEST_EQUAL(fixedPointPolygon.GetPointsCount(), boost::geometry::num_points(polygon), ());
+
+  std::vector<BoostPoint> points{{0.0, 0.0}, {2.0, 0.0}, {10.5, 0.0}, {-20.0, 3.0}};
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-11.0, 11.0);
+  for (size_t i = 0; i < 10000; ++i)
+    points.emplace_back(distribution(engine), distribution(engine));
+
+  for (auto const & point : points)
+  {
+    auto const quantizedPoint = Quantize(point);
+    TEST_EQUAL(fixedPointPolygon.Covers(point),
+               boost::geometry::covered_by(quantizedPoint, quantizedPolygon),
+               (point.get<0>(), point.get<1>()));
+  }
+
+  // The boundary is covered.
+  for (auto const & point : polygon.outer())
+    TEST(fixedPointPolygon.Covers(point), (point.get<0>(), point.get<1>()));
+  for (auto const & point : polygon.inners().front())
+    TEST(fixedPointPolygon.Covers(point), (point.get<0>(), point.get<1>()));
+  TEST(fixedPointPolygon.Covers(BoostPoint(1.0, 0.0)), ());
+  TEST(fixedPointPolygon.Covers(BoostPoint(-1.0, 0.5)), ());
+}
+
+UNIT_TEST(FixedPointPolygon_Area)
+{
+  auto const polygon = MakePolygon();
+  FixedPointPolygon const fixedPointPolygon(polygon);
+  auto const area = boost::geometry::area(polygon);
+  TEST(base::AlmostEqualRel(fixedPointPolygon.GetArea(), area, 1e-6),
+       (fixedPointPolygon.GetArea(), area));
+
+  // The area does not depend on the orientation of the rings.
+  auto reversed = polygon;
+  boost::geometry::reverse(reversed);
+  TEST_EQUAL(FixedPointPolygon(reversed).GetArea(), fixedPointPolygon.GetArea(), ());
+
+  // The mercator plane.
+  BoostPolygon world;
+  world.outer() = {{-180.0, -180.0}, {-180.0, 180.0}, {180.0, 180.0}, {180.0, -180.0},
+                   {-180.0, -180.0}};
+  TEST(base::AlmostEqualRel(FixedPointPolygon(world).GetArea(), 360.0 * 360.0, 1e-9),
+       (FixedPointPolygon(world).GetArea()));
+}
@@ -0,0 +1,85 @@
+#include "testing/testing.hpp"
+
+#include "generator/geo_objects/geo_data_table.hpp"
+
+#include "platform/platform.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+using namespace generator::geo_objects;
+
+namespace
+{
+GeoObjectData MakeData(uint64_t id)
+{
+  return {"Street " + std::to_string(id % 100), id % 3 == 0 ? "" : std::to_string(id),
+          base::GeoObjectId(base::GeoObjectId::Type::OsmRelation, id % 10 + 1)};
+}
+
+void TestEqual(GeoObjectData const & data, GeoObjectData const & expected)
+{
+  TEST_EQUAL(data.m_street, expected.m_street, ());
+  TEST_EQUAL(data.m_house, expected.m_house, ());
+  TEST_EQUAL(data.m_regionId, expected.m_regionId, ());
+}
+
+void TestTable(GeoDataTable & table, size_t count)
+{
+  for (uint64_t i = 1; i <= count; ++i)
+    table.Insert(base::GeoObjectId(base::GeoObjectId::Type::OsmWay, i), MakeData(i));
+
+  // The first data is kept.
+  table.Insert(base::GeoObjectId(base::GeoObjectId::Type::OsmWay, 1), MakeData(2));
+  TEST_EQUAL(table.Size(), count, ());
+
+  for (uint64_t i = 1; i <= count; ++i)
+  {
+    auto const data = table.Find(base::GeoObjectId(base::GeoObjectId::Type::OsmWay, i));
+    TEST(data, (i));
+    TestEqual(*data, MakeData(i));
+  }
+  TEST(!table.Find(base::GeoObjectId(base::GeoObjectId::Type::OsmNode, 1)), ());
+  TEST(!table.Find(base::GeoObjectId(base::GeoObjectId::Type::OsmWay, count + 1)), ());
+
+  std::map<base::GeoObjectId, GeoObjectData> items;
+  table.ForEach([&](base::GeoObjectId id, GeoObjectData const & data) {
+    TEST(items.emplace(id, data).second, (id));
+  });
+  TEST_EQUAL(items.size(), count, ());
+  for (auto const & item : items)
+    TestEqual(item.second, MakeData(item.first.GetSerialId()));
+}
+}  // namespace
+
+UNIT_TEST(GeoDataTable_InMemory)
+{
+  GeoDataTable table;
+  TEST(table.Empty(), ());
+  TEST(!table.Find(base::GeoObjectId(base::GeoObjectId::Type::OsmWay, 1)), ());
+
+  TestTable(table, 1000 /* count */);
+  TEST(!table.IsPoolSpilled(), ());
+}
+
+UNIT_TEST(GeoDataTable_Spilled)
+{
+  auto const poolFilename = GetPlatform().TmpPathForFile();
+  {
+    GeoDataTable table(poolFilename, 1024 /* poolMemoryBudget */);
+    table.Reserve(100);
+    TestTable(table, 1000 /* count */);
+    TEST(table.IsPoolSpilled(), ());
+    TEST(Platform::IsFileExistsByFullPath(poolFilename), ());
+
+    // The strings inserted after the lookups are read from the remapped pool.
+    auto const id = base::GeoObjectId(base::GeoObjectId::Type::OsmRelation, 1);
+    table.Insert(id, MakeData(5));
+    TestEqual(*table.Find(id), MakeData(5));
+  }
+  // The pool is removed with the table.
+  TEST(!Platform::IsFileExistsByFullPath(poolFilename), ());
+}
@@ -10,19 +10,29 @@
 #include "generator/generator_tests/common.hpp"
 #include "generator/generator_tests/source_data.hpp"
 
+#include "generator/intermediate_data.hpp"
 #include "generator/intermediate_elements.hpp"
 #include "generator/osm_element.hpp"
 #include "generator/osm_source.hpp"
 
+#include "geometry/mercator.hpp"
+
 #include "coding/reader.hpp"
 #include "coding/writer.hpp"
 
+#include "platform/platform.hpp"
+
+#include "base/file_name_utils.hpp"
+#include "base/math.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <functional>
 #include <map>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace generator_tests;
@@ -77,6 +87,23 @@ UNIT_TEST(Intermediate_Data_way_element_save_load_test)
   TEST_EQUAL(e2.nodes, testData, ());
 }
 
+UNIT_TEST(Intermediate_Data_way_element_delta_save_load_test)
+{
+  WayElement e1(1 /* fake osm id */);
+  e1.nodes = {5'000'000'000, 5'000'000'001, 5'000'000'002, 4'999'999'990, 5'000'000'000};
+
+  vector<uint8_t> buffer;
+  MemWriter<vector<uint8_t>> w(buffer);
+  e1.Write(w);
+  // The close ids take one byte.
+  TEST_LESS(buffer.size(), 16, ());
+
+  MemReader r(buffer.data(), buffer.size());
+  WayElement e2(1 /* fake osm id */);
+  e2.Read(r);
+  TEST_EQUAL(e2.nodes, e1.nodes, ());
+}
+
 UNIT_TEST(Intermediate_Data_relation_element_save_load_test)
 {
   std::vector<RelationElement::Member> testData = {{1, "inner"},
@@ -126,6 +153,188 @@ UNIT_TEST(Intermediate_Data_relation_element_save_load_test)
   TEST_NOT_EQUAL(e2.tags["key2old"], "value2old", ());
 }
 
+UNIT_TEST(Intermediate_Data_compressed_point_storage_test)
+{
+  auto const & dataPath = ScopedDir{"compressed_point_storage", true /* recursiveForceRemove */};
+  auto const filename = base::JoinPath(dataPath.GetFullPath(), "nodes.dat");
+
+  // Sparse ids with blocks of nodes of different batches interleaved in the storage.
+  PointStorageWriterInterface::Nodes firstBatch;
+  PointStorageWriterInterface::Nodes secondBatch;
+  for (uint64_t i = 0; i < 1000; ++i)
+  {
+    auto const id = i * i * 7 + 1;
+    NodeElement node{id, -80.0 + i * 0.1234567, 170.0 - i * 0.3456789};
+    (i < 500 ? firstBatch : secondBatch).emplace_back(id, node);
+  }
+  uint64_t const kLastId = 10'000'000'000;
+
+  {
+    auto writer = CreatePointStorageWriter(feature::GenerateInfo::NodeStorageType::Compressed,
+                                           filename);
+    writer->AddPoints(secondBatch, true /* concurrent */);
+    writer->AddPoints(firstBatch, true /* concurrent */);
+    writer->AddPoint(kLastId, 55.7558, 37.6173);
+    TEST_EQUAL(writer->GetNumProcessedPoints(), 1001, ());
+  }
+
+  auto reader = CreatePointStorageReader(feature::GenerateInfo::NodeStorageType::Compressed,
+                                         filename);
+  for (auto const & batch : {firstBatch, secondBatch})
+  {
+    for (auto const & node : batch)
+    {
+      double lat = 0.0;
+      double lon = 0.0;
+      TEST(reader->GetPoint(node.first, lat, lon), (node.first));
+      TEST(base::AlmostEqualAbs(lat, node.second.m_lat, 1e-7), (node.first, lat));
+      TEST(base::AlmostEqualAbs(lon, node.second.m_lon, 1e-7), (node.first, lon));
+    }
+  }
+
+  double lat = 0.0;
+  double lon = 0.0;
+  TEST(reader->GetPoint(kLastId, lat, lon), ());
+  TEST(base::AlmostEqualAbs(lat, 55.7558, 1e-7), (lat));
+  TEST(base::AlmostEqualAbs(lon, 37.6173, 1e-7), (lon));
+
+  TEST(!reader->GetPoint(0, lat, lon), ());
+  TEST(!reader->GetPoint(2, lat, lon), ());
+  TEST(!reader->GetPoint(kLastId + 1, lat, lon), ());
+
+  // The ids of the different blocks are mixed in a batch.
+  vector<uint64_t> ids;
+  for (size_t i = 0; i < firstBatch.size(); ++i)
+  {
+    ids.emplace_back(secondBatch[i].first);
+    ids.emplace_back(firstBatch[firstBatch.size() - i - 1].first);
+  }
+  ids.emplace_back(kLastId);
+
+  vector<m2::PointD> points;
+  TEST(reader->GetPoints(ids, points), ());
+  TEST_EQUAL(points.size(), ids.size(), ());
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    TEST(reader->GetPoint(ids[i], lat, lon), (ids[i]));
+    TEST_EQUAL(points[i], m2::PointD(lon, lat), (ids[i]));
+  }
+
+  TEST(!reader->GetPoints({kLastId, 2, firstBatch[0].first}, points), ());
+  TEST_EQUAL(points.size(), 3, ());
+  TEST_EQUAL(points[1], m2::PointD::Zero(), ());
+  TEST_NOT_EQUAL(points[0], m2::PointD::Zero(), ());
+  TEST_NOT_EQUAL(points[2], m2::PointD::Zero(), ());
+}
+
+UNIT_TEST(Intermediate_Data_succinct_offsets_index_test)
+{
+  auto const & dataPath = ScopedDir{"succinct_offsets_index", true /* recursiveForceRemove */};
+  auto const filename = base::JoinPath(dataPath.GetFullPath(), "ways.dat.id2rel");
+
+  // Unsorted keys with several values of some keys and big values.
+  vector<pair<Key, uint64_t>> elements;
+  for (uint64_t i = 0; i < 1000; ++i)
+  {
+    auto const key = (i * 7919) % 500 * 1000 + 3;
+    elements.emplace_back(key, i * 1'000'003);
+  }
+  elements.emplace_back(40'000'000'000, uint64_t{1} << 40);
+
+  {
+    IndexFileWriter writer(filename);
+    for (auto const & element : elements)
+      writer.Add(element.first, element.second);
+    writer.WriteAllWithSuccinctIndex();
+  }
+  TEST(Platform::IsFileExistsByFullPath(filename + SUCCINCT_OFFSET_EXT), ());
+
+  IndexFileReader const reader(filename);
+  map<Key, vector<uint64_t>> expected;
+  for (auto const & element : elements)
+    expected[element.first].push_back(element.second);
+
+  for (auto & keyValues : expected)
+  {
+    auto & values = keyValues.second;
+    sort(values.begin(), values.end());
+
+    uint64_t value = 0;
+    TEST(reader.GetValueByKey(keyValues.first, value), (keyValues.first));
+    TEST_EQUAL(value, values.front(), (keyValues.first));
+
+    vector<uint64_t> actual;
+    reader.ForEachByKey(keyValues.first, [&](uint64_t v) {
+      actual.push_back(v);
+      return base::ControlFlow::Continue;
+    });
+    TEST_EQUAL(actual, values, (keyValues.first));
+  }
+
+  uint64_t value = 0;
+  for (Key key : {Key{0}, Key{4}, Key{499'004}, Key{40'000'000'001}})
+    TEST(!reader.GetValueByKey(key, value), (key));
+}
+
+UNIT_TEST(Intermediate_Data_concurrent_offsets_index_test)
+{
+  auto const & dataPath = ScopedDir{"concurrent_offsets_index", true /* recursiveForceRemove */};
+  auto const filename = base::JoinPath(dataPath.GetFullPath(), "ways.dat.offs");
+
+  size_t const kThreadsCount = 4;
+  size_t const kBatchesCount = 50;
+  size_t const kBatchSize = 37;
+  {
+    // The small flush count makes the sorted runs to be merged.
+    ConcurrentIndexFileWriter writer(filename, 100 /* flushCount */);
+    vector<thread> threads;
+    for (size_t t = 0; t < kThreadsCount; ++t)
+    {
+      threads.emplace_back([&writer, t]() {
+        for (size_t b = 0; b < kBatchesCount; ++b)
+        {
+          vector<ConcurrentIndexFileWriter::Element> batch;
+          for (size_t i = 0; i < kBatchSize; ++i)
+          {
+            auto const n = (t * kBatchesCount + b) * kBatchSize + i;
+            batch.emplace_back(n * 7919 % 100'003, i);
+          }
+          writer.Add(batch, 1'000 * b);
+        }
+        writer.Add(200'000 + t, 5);
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+    writer.WriteAll();
+  }
+
+  uint64_t fileSize = 0;
+  TEST(Platform::GetFileSizeByFullPath(filename, fileSize), ());
+  auto const elements = IndexFileReader::LoadElements(filename, fileSize);
+  TEST_EQUAL(elements.size(), kThreadsCount * (kBatchesCount * kBatchSize + 1), ());
+  TEST(is_sorted(elements.begin(), elements.end()), ());
+
+  IndexFileReader const reader(filename);
+  for (size_t t = 0; t < kThreadsCount; ++t)
+  {
+    for (size_t b = 0; b < kBatchesCount; ++b)
+    {
+      for (size_t i = 0; i < kBatchSize; ++i)
+      {
+        auto const n = (t * kBatchesCount + b) * kBatchSize + i;
+        uint64_t value = 0;
+        TEST(reader.GetValueByKey(n * 7919 % 100'003, value), (n));
+        TEST_EQUAL(value, 1'000 * b + i, (n));
+      }
+    }
+
+    uint64_t value = 0;
+    TEST(reader.GetValueByKey(200'000 + t, value), (t));
+    TEST_EQUAL(value, 5, (t));
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // Intermediate data generations tests.
 std::vector<OsmElement> ReadOsmElements(std::string const & filename, OsmFormatParser parser)
@@ -170,24 +379,27 @@ void TestIntermediateDataGeneration(
     auto const & osmFileData = sample.second;
 
     // Skip test for node storage type "mem": 64Gb required.
-    for (auto const & nodeStorageType : {"raw"s, "map"s})
+    for (auto const & nodeStorageType : {"raw"s, "map"s, "compressed"s})
     {
       for (auto threadsCount : {1, 2, 4})
       {
-        auto const & osmFile = ScopedFile{"planet." + osmFileTypeExtension, osmFileData};
-        auto const & dataPath = ScopedDir{"intermediate_data", true /* recursiveForceRemove */};
-
-        auto const & genInfo = MakeGenerateInfo(dataPath.GetFullPath(), osmFile.GetFullPath(),
-                                                osmFileTypeExtension, nodeStorageType,
-                                                threadsCount);
-        auto generation = GenerateIntermediateData(genInfo);
-        CHECK(generation, ());
-
-        auto osmElements =
-            ReadOsmElements(genInfo.m_osmFileName, osmFormatParsers.at(osmFileTypeExtension));
-        auto const & intermediateData = cache::IntermediateData{genInfo};
-        auto const & cache = intermediateData.GetCache();
-        dataTester(osmElements, *cache);
+        for (auto succinctOffsets : {false, true})
+        {
+          auto const & osmFile = ScopedFile{"planet." + osmFileTypeExtension, osmFileData};
+          auto const & dataPath = ScopedDir{"intermediate_data", true /* recursiveForceRemove */};
+
+          auto genInfo = MakeGenerateInfo(dataPath.GetFullPath(), osmFile.GetFullPath(),
+                                          osmFileTypeExtension, nodeStorageType, threadsCount);
+          genInfo.m_succinctOffsets = succinctOffsets;
+          auto generation = GenerateIntermediateData(genInfo);
+          CHECK(generation, ());
+
+          auto osmElements =
+              ReadOsmElements(genInfo.m_osmFileName, osmFormatParsers.at(osmFileTypeExtension));
+          auto const & intermediateData = cache::IntermediateData{genInfo};
+          auto const & cache = intermediateData.GetCache();
+          dataTester(osmElements, *cache);
+        }
       }
     }
   }
@@ -236,6 +448,15 @@ UNIT_TEST(IntermediateData_RelationsGenerationTest)
     auto intermediateWay = WayElement{273163};
     TEST(intermediateData.GetWay(273163, intermediateWay), ());
 
+    // Missing ways are skipped by the batched reading, the order of ids is kept.
+    auto foundIds = std::vector<uint64_t>{};
+    intermediateData.ForEachWay({273163, 1 /* missing */, 273163},
+                                [&](uint64_t id, WayElement const & way) {
+      TEST_EQUAL(way.nodes, intermediateWay.nodes, ());
+      foundIds.push_back(id);
+    });
+    TEST_EQUAL(foundIds, std::vector<uint64_t>({273163, 273163}), ());
+
     auto relationTesting = [](auto && relationId, auto && /* reader */) {
       TEST_EQUAL(relationId, 273177, ());
       return base::ControlFlow::Continue;
@@ -243,3 +464,124 @@ UNIT_TEST(IntermediateData_RelationsGenerationTest)
     intermediateData.ForEachRelationByWayCached(273163, relationTesting);
   });
 }
+
+UNIT_TEST(IntermediateData_OsmChangeTest)
+{
+  auto const planet = R"(<?xml version='1.0' encoding='UTF-8'?>
+<osm version='0.6'>
+<node id='1' lat='55.75' lon='37.6' />
+<node id='2' lat='55.76' lon='37.61' />
+<node id='3' lat='55.77' lon='37.62' />
+<way id='10'><nd ref='1' /><nd ref='2' /></way>
+<way id='11'><nd ref='2' /><nd ref='3' /></way>
+<relation id='20'>
+<member type='way' ref='10' role='outer' />
+<tag k='type' v='multipolygon' />
+</relation>
+</osm>)"s;
+
+  auto const firstChange = R"(<?xml version='1.0' encoding='UTF-8'?>
+<osmChange version='0.6'>
+<modify>
+<node id='1' lat='55.8' lon='37.7' />
+</modify>
+<delete>
+<way id='11' />
+</delete>
+<create>
+<way id='12'><nd ref='1' /><nd ref='3' /></way>
+</create>
+<modify>
+<relation id='20'>
+<member type='way' ref='12' role='outer' />
+<tag k='type' v='multipolygon' />
+</relation>
+</modify>
+</osmChange>)"s;
+
+  auto const secondChange = R"(<?xml version='1.0' encoding='UTF-8'?>
+<osmChange version='0.6'>
+<delete>
+<node id='2' />
+</delete>
+<create>
+<way id='11'><nd ref='1' /><nd ref='3' /></way>
+</create>
+</osmChange>)"s;
+
+  auto const getRelationsByWay = [](IntermediateDataReader const & cache, Key wayId) {
+    vector<uint64_t> ids;
+    auto collectIds = [&ids](uint64_t id, RelationElement const &) {
+      ids.push_back(id);
+      return base::ControlFlow::Continue;
+    };
+    cache.ForEachRelationByWay(wayId, collectIds);
+    return ids;
+  };
+
+  auto const testNode = [](IntermediateDataReader const & cache, Key id, double lat, double lon) {
+    double y = 0.0;
+    double x = 0.0;
+    TEST(cache.GetNode(id, y, x), (id));
+    auto const point = MercatorBounds::FromLatLon(lat, lon);
+    TEST(base::AlmostEqualAbs(y, point.y, 1e-6), (id, y));
+    TEST(base::AlmostEqualAbs(x, point.x, 1e-6), (id, x));
+  };
+
+  for (auto const & nodeStorageType : {"raw"s, "map"s, "compressed"s})
+  {
+    auto const & osmFile = ScopedFile{"planet.xml", planet};
+    auto const & firstChangeFile = ScopedFile{"first.osc", firstChange};
+    auto const & secondChangeFile = ScopedFile{"second.osc", secondChange};
+    auto const & dataPath = ScopedDir{"intermediate_data", true /* recursiveForceRemove */};
+
+    auto const genInfo = MakeGenerateInfo(dataPath.GetFullPath(), osmFile.GetFullPath(), "xml",
+                                          nodeStorageType, 1 /* threadsCount */);
+    TEST(GenerateIntermediateData(genInfo), ());
+    TEST(ApplyOsmChange(genInfo, firstChangeFile.GetFullPath()), ());
+
+    {
+      IntermediateDataReader const cache(genInfo);
+      testNode(cache, 1, 55.8, 37.7);
+      testNode(cache, 2, 55.76, 37.61);
+
+      WayElement way(11);
+      TEST(!cache.GetWay(11, way), ());
+      TEST(cache.GetWay(10, way), ());
+      TEST(cache.GetWay(12, way), ());
+      TEST_EQUAL(way.nodes, vector<uint64_t>({1, 3}), ());
+
+      TEST(getRelationsByWay(cache, 10).empty(), ());
+      TEST_EQUAL(getRelationsByWay(cache, 12), vector<uint64_t>({20}), ());
+    }
+
+    // The changes are merged with the applied ones.
+    TEST(ApplyOsmChange(genInfo, secondChangeFile.GetFullPath()), ());
+
+    {
+      IntermediateDataReader const cache(genInfo);
+      testNode(cache, 1, 55.8, 37.7);
+      double y = 0.0;
+      double x = 0.0;
+      TEST(!cache.GetNode(2, y, x), ());
+
+      WayElement way(11);
+      TEST(cache.GetWay(11, way), ());
+      TEST_EQUAL(way.nodes, vector<uint64_t>({1, 3}), ());
+      TEST(cache.GetWay(12, way), ());
+      TEST_EQUAL(getRelationsByWay(cache, 12), vector<uint64_t>({20}), ());
+    }
+
+    // The preprocessing drops the changes.
+    TEST(GenerateIntermediateData(genInfo), ());
+
+    {
+      IntermediateDataReader const cache(genInfo);
+      testNode(cache, 2, 55.76, 37.61);
+
+      WayElement way(12);
+      TEST(!cache.GetWay(12, way), ());
+      TEST_EQUAL(getRelationsByWay(cache, 10), vector<uint64_t>({20}), ());
+    }
+  }
+}
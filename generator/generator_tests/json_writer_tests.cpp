@@ -0,0 +1,154 @@
+#include "testing/testing.hpp"
+
+#include "generator/json_writer.hpp"
+#include "generator/key_value_storage.hpp"
+#include "generator/translation.hpp"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+
+namespace
+{
+class Localizee
+{
+public:
+  Localizee(std::string const & name, std::string const & en, std::string const & ru)
+    : m_name(name), m_en(en), m_ru(ru)
+  {
+  }
+
+  std::string GetName() const { return m_name; }
+  std::string GetTranslatedOrTransliteratedName(LanguageCode languageCode) const
+  {
+    if (languageCode == StringUtf8Multilang::kEnglishCode)
+      return m_en;
+    if (languageCode == StringUtf8Multilang::GetLangIndex("ru"))
+      return m_ru;
+    return {};
+  }
+
+private:
+  std::string m_name;
+  std::string m_en;
+  std::string m_ru;
+};
+
+std::string Write(JsonObjectPatch const & patch)
+{
+  std::string result;
+  JsonWriter writer(result, KeyValueStorage::kDefaultPrecision);
+  patch.Write(writer);
+  return result;
+}
+
+base::JSONPtr Load(std::string const & json) { return base::LoadFromString(json); }
+}  // namespace
+
+UNIT_TEST(JsonWriter_SameAsJansson)
+{
+  std::vector<double> const values = {0.0,    -0.0,     1.0,        -3.5,     37.617698,
+                                      1e20,   1.5e-7,  123456789.0, 1234567891.0, 55.75583,
+                                      -1e-300, 2.0 / 3};
+
+  auto array = base::NewJSONArray();
+  for (auto const value : values)
+    ToJSONArray(*array, value);
+  ToJSONArray(*array, 42);
+  ToJSONArray(*array, -9007199254740993);
+  ToJSONArray(*array, "quote \" slash / back \\ tab \t line \n \x01 \x1f юникод");
+  ToJSONArray(*array, true);
+  auto object = base::NewJSONObject();
+  ToJSONObject(*object, "z", base::NewJSONNull());
+  ToJSONObject(*object, "a", base::NewJSONObject());
+  ToJSONObject(*object, "m", base::NewJSONArray());
+  ToJSONArray(*array, *object.release());
+
+  auto const expected = KeyValueStorage::Serialize(array);
+
+  std::string streamed;
+  JsonWriter writer(streamed, KeyValueStorage::kDefaultPrecision);
+  writer.StartArray();
+  for (auto const value : values)
+    writer.Double(value);
+  for (size_t i = values.size(); i < json_array_size(array.get()); ++i)
+    writer.Json(json_array_get(array.get(), i));
+  writer.EndArray();
+
+  TEST_EQUAL(streamed, expected, ());
+}
+
+UNIT_TEST(JsonObjectPatch_Changes)
+{
+  auto const source = Load(R"({"a":1,"b":{"c":"d","e":[1,2.5]},"f":null,"g":"h"})");
+
+  JsonObjectPatch unchanged(source.get());
+  TEST_EQUAL(Write(unchanged), KeyValueStorage::Serialize(source), ());
+
+  auto json = base::JSONPtr{json_deep_copy(source.get())};
+  JsonObjectPatch patch(source.get());
+
+  ToJSONObject(*json, "g", 2);
+  patch.Set("g", 2);
+  ToJSONObject(*json, "x", "y");
+  patch.Set("x", "y");
+  json_object_del(json.get(), "a");
+  patch.Remove("a");
+  json_object_del(json.get(), "absent");
+  patch.Remove("absent");
+  ToJSONObject(*json_object_get(json.get(), "b"), "c", base::NewJSONNull());
+  patch.GetObligatoryObject("b").SetNull("c");
+  ToJSONObject(*json, "a", std::vector<double>{1.25, 3.0});
+  patch.Set("a", std::vector<double>{1.25, 3.0});
+  // The invalid utf8 and the not finite values are not set by jansson.
+  ToJSONObject(*json, "x", "\xff");
+  patch.Set("x", "\xff");
+  ToJSONObject(*json, "n", std::numeric_limits<double>::infinity());
+  patch.Set("n", std::numeric_limits<double>::infinity());
+
+  TEST(!patch.GetObject("g"), ());
+  TEST(!patch.GetObject("f"), ());
+  TEST_EQUAL(patch.GetSource("f"), json_object_get(source.get(), "f"), ());
+  patch.GetOrCreateObject("f").Set("i", 0.5);
+
+  TEST_EQUAL(Write(patch),
+             R"({"b":{"c":null,"e":[1,2.5]},"f":{"i":0.5},"g":2,"x":"y","a":[1.25,3.0]})", ());
+  ToJSONObject(*json, "f", base::NewJSONObject());
+  ToJSONObject(*json_object_get(json.get(), "f"), "i", 0.5);
+  TEST_EQUAL(Write(patch), KeyValueStorage::Serialize(json), ());
+}
+
+UNIT_TEST(JsonObjectPatch_Localizator)
+{
+  auto const source = Load(
+      R"({"locales":{"default":{"address":{"region":"Область","locality":"Город"},)"
+      R"("name":"Город"},"en":{"address":{"region":"Oblast"},"name":"Gorod"},"ru":null}})");
+
+  auto json = base::JSONPtr{json_deep_copy(source.get())};
+  JsonObjectPatch patch(source.get());
+
+  Localizator localizator(*json);
+  PatchLocalizator patchLocalizator(patch);
+  for (auto const & localizee : {Localizee("Улица", "", "Улица"), Localizee("", "Street", "")})
+  {
+    localizator.SetLocale("name", localizee);
+    localizator.SetLocale("street", localizee, "address");
+    patchLocalizator.SetLocale("name", localizee);
+    patchLocalizator.SetLocale("street", localizee, "address");
+    TEST_EQUAL(Write(patch), KeyValueStorage::Serialize(json), ());
+  }
+
+  JsonObjectPatch newPatch;
+  auto newJson = base::NewJSONObject();
+  Localizator newLocalizator(*newJson);
+  PatchLocalizator newPatchLocalizator(newPatch);
+  newLocalizator.SetLocale("country", Localizee("Страна", "Country", ""), "address");
+  newPatchLocalizator.SetLocale("country", Localizee("Страна", "Country", ""), "address");
+  newLocalizator.SetLocale("name", Localizee("", "", "Страна"));
+  newPatchLocalizator.SetLocale("name", Localizee("", "", "Страна"));
+  TEST_EQUAL(Write(newPatch), KeyValueStorage::Serialize(newJson), ());
+}
@@ -0,0 +1,140 @@
+#include "testing/testing.hpp"
+
+#include "generator/key_value_concurrent_writer.hpp"
+#include "generator/key_value_storage.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+std::string const kKeyValues =
+    "0000000000000002 {\"name\":\"second\"}\n"
+    "broken line\n"
+    "000000000000000X {\"name\":\"bad key\"}\n"
+    "0000000000000001 {\"name\":\"first\"}\n"
+    "0000000000000002 {\"name\":\"duplicate\"}\n"
+    "0000000000000003 {\"name\":\n"
+    "00000000000000A4 {\"name\":\"last\"}";
+
+std::string GetName(std::shared_ptr<JsonValue> const & value)
+{
+  TEST(value, ());
+  return FromJSONObject<std::string>(*value, "name");
+}
+}  // namespace
+
+UNIT_TEST(KeyValueStorage_LazyMode)
+{
+  ScopedFile const kv{"key_value_storage.jsonl", kKeyValues};
+
+  KeyValueStorage const eager{kv.GetFullPath()};
+  KeyValueStorage const lazy{kv.GetFullPath(), KeyValueStorage::Mode::Lazy, 2 /* cacheSize */};
+  TEST_EQUAL(eager.Size(), 3, ());
+  // The invalid value of the key 3 is found on Find() only.
+  TEST_EQUAL(lazy.Size(), 4, ());
+
+  for (auto const & storage : {&eager, &lazy})
+  {
+    TEST_EQUAL(GetName(storage->Find(1)), "first", ());
+    TEST_EQUAL(GetName(storage->Find(2)), "second", ());
+    TEST_EQUAL(GetName(storage->Find(0xA4)), "last", ());
+    TEST(!storage->Find(3), ());
+    TEST(!storage->Find(5), ());
+  }
+}
+
+UNIT_TEST(KeyValueStorage_LazyModeCache)
+{
+  ScopedFile const kv{"key_value_storage.jsonl", kKeyValues};
+  KeyValueStorage const lazy{kv.GetFullPath(), KeyValueStorage::Mode::Lazy, 2 /* cacheSize */};
+
+  auto const first = lazy.Find(1);
+  TEST_EQUAL(lazy.Find(1), first, ());
+  lazy.Find(2);
+  TEST_EQUAL(lazy.Find(1), first, ());
+  // The key 2 is the least recently found one.
+  lazy.Find(0xA4);
+  TEST_EQUAL(lazy.Find(1), first, ());
+
+  auto const second = lazy.Find(2);
+  lazy.Find(0xA4);
+  lazy.Find(2);
+  // The key 1 is dropped from the cache, but the found value is alive.
+  auto const firstAgain = lazy.Find(1);
+  TEST_NOT_EQUAL(firstAgain, first, ());
+  TEST_EQUAL(GetName(first), GetName(firstAgain), ());
+  TEST_EQUAL(lazy.Find(2), second, ());
+}
+
+UNIT_TEST(KeyValueStorage_LazyModeEmptyFile)
+{
+  ScopedFile const kv{"key_value_storage.jsonl", ""};
+  KeyValueStorage const lazy{kv.GetFullPath(), KeyValueStorage::Mode::Lazy};
+  TEST_EQUAL(lazy.Size(), 0, ());
+  TEST(!lazy.Find(1), ());
+}
+
+UNIT_TEST(KeyValueStorage_ParallelEagerMode)
+{
+  ScopedFile const kv{"key_value_storage.jsonl", kKeyValues};
+  ScopedFile const empty{"key_value_storage_empty.jsonl", ""};
+
+  // There are more threads than lines, some of the ranges are empty.
+  for (unsigned int threadsCount : {2, 3, 16})
+  {
+    KeyValueStorage const storage{kv.GetFullPath(), KeyValueStorage::Mode::Eager,
+                                  KeyValueStorage::kDefaultCacheSize, threadsCount};
+    TEST_EQUAL(storage.Size(), 3, ());
+    TEST_EQUAL(GetName(storage.Find(1)), "first", ());
+    // The first value of a key wins as in the single thread.
+    TEST_EQUAL(GetName(storage.Find(2)), "second", ());
+    TEST_EQUAL(GetName(storage.Find(0xA4)), "last", ());
+    TEST(!storage.Find(3), ());
+
+    KeyValueStorage const emptyStorage{empty.GetFullPath(), KeyValueStorage::Mode::Eager,
+                                       KeyValueStorage::kDefaultCacheSize, threadsCount};
+    TEST_EQUAL(emptyStorage.Size(), 0, ());
+  }
+}
+
+UNIT_TEST(KeyValueConcurrentWriter_SharedFile)
+{
+  ScopedFile const kv{"key_value_storage.jsonl", "0000000000000001 {\"name\":\"first\"}\n"};
+  size_t const kThreadsCount = 4;
+  uint64_t const kKeysPerThread = 1000;
+  {
+    auto const file = std::make_shared<KeyValueConcurrentFile>(kv.GetFullPath());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreadsCount; ++i)
+    {
+      threads.emplace_back([&file, i, kKeysPerThread]() {
+        // The small buffer is flushed many times.
+        KeyValueConcurrentWriter writer{file, 2'000 /* bufferSize */};
+        for (uint64_t key = 0; key < kKeysPerThread; ++key)
+        {
+          auto value = base::NewJSONObject();
+          ToJSONObject(*value, "name", strings::to_string(key));
+          writer.Write(base::GeoObjectId(2 + i * kKeysPerThread + key), JsonValue{std::move(value)});
+        }
+      });
+    }
+    for (auto & thread : threads)
+      thread.join();
+  }
+
+  KeyValueStorage const storage{kv.GetFullPath()};
+  TEST_EQUAL(storage.Size(), 1 + kThreadsCount * kKeysPerThread, ());
+  TEST_EQUAL(GetName(storage.Find(1)), "first", ());
+  for (uint64_t key = 0; key < kThreadsCount * kKeysPerThread; ++key)
+    TEST_EQUAL(GetName(storage.Find(2 + key)), strings::to_string(key % kKeysPerThread), ());
+}
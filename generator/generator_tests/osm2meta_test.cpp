@@ -55,3 +55,29 @@ UNIT_TEST(ValidateAndFormat_building_levels)
   TEST_EQUAL(tp.ValidateAndFormat_building_levels("2.51"), "2.5", ());
   TEST_EQUAL(tp.ValidateAndFormat_building_levels("250"), "", ("Too many levels."));
 }
+
+UNIT_TEST(ValidateAndFormat_internet)
+{
+  FeatureParams params;
+  MetadataTagProcessorImpl tp(params);
+  TEST_EQUAL(tp.ValidateAndFormat_internet("wlan"), "wlan", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("WLAN"), "wlan", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("Wired"), "wired", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("yes"), "yes", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("No"), "no", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("free"), "wlan", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("terminal"), "", ());
+  TEST_EQUAL(tp.ValidateAndFormat_internet("wlan;wired"), "", ());
+}
+
+UNIT_TEST(ValidateAndFormat_level)
+{
+  FeatureParams params;
+  MetadataTagProcessorImpl tp(params);
+  TEST_EQUAL(tp.ValidateAndFormat_level("1"), "1", ());
+  TEST_EQUAL(tp.ValidateAndFormat_level("-2"), "-2", ());
+  TEST_EQUAL(tp.ValidateAndFormat_level("－１"), "", ());
+  TEST_EQUAL(tp.ValidateAndFormat_level("２"), "2", ());
+  TEST_EQUAL(tp.ValidateAndFormat_level("-7"), "", ());
+  TEST_EQUAL(tp.ValidateAndFormat_level("ground"), "", ());
+}
@@ -1,9 +1,22 @@
 #include "testing/testing.hpp"
 
+#include "generator/osm_element.hpp"
+#include "generator/osm_element_view.hpp"
 #include "generator/osm_o5m_source.hpp"
+#include "generator/osm_o5m_writer.hpp"
+#include "generator/osm_source.hpp"
 
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "coding/file_reader.hpp"
+
+#include "base/string_utils.hpp"
+
+#include <cstdint>
 #include <iterator>
 #include <set>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -324,3 +337,188 @@ UNIT_TEST(OSM_O5M_Source_Relation_read_test)
     }
   }
 }
+
+UNIT_TEST(OSM_O5M_Source_Ranges_test)
+{
+  string const data(begin(way_o5m_data), end(way_o5m_data));
+
+  auto const resetOffsets = generator::FindO5MResetOffsets(data.data(), data.size());
+  TEST_EQUAL(resetOffsets, vector<uint64_t>({0, 7, 103}), ());
+
+  auto const ranges = generator::SplitO5MAtResets(resetOffsets, data.size(), 0 /* minRangeSize */);
+  TEST_EQUAL(ranges.size(), 3, ());
+  TEST_EQUAL(generator::SplitO5MAtResets(resetOffsets, data.size(), 50).size(), 2, ());
+  TEST_EQUAL(generator::SplitO5MAtResets(resetOffsets, data.size(), 1000).size(), 1, ());
+
+  auto const readElements = [](string const & data, bool withHeader) {
+    stringstream ss(data);
+    generator::SourceReader reader(ss);
+    generator::ProcessorOsmElementsFromO5M o5mReader(reader, 1 /* taskCount */, 0 /* taskId */,
+                                                     1 /* chunkSize */, withHeader);
+    vector<OsmElement> elements;
+    OsmElement element;
+    while (o5mReader.TryRead(element))
+      elements.push_back(element);
+    return elements;
+  };
+
+  vector<OsmElement> rangesElements;
+  for (auto const & range : ranges)
+  {
+    TEST_EQUAL(static_cast<uint8_t>(data[range.m_begin]), 0xFF, ());
+    auto const elements = readElements(data.substr(range.m_begin, range.m_end - range.m_begin),
+                                       range.m_begin == 0 /* withHeader */);
+    rangesElements.insert(rangesElements.end(), elements.begin(), elements.end());
+  }
+
+  auto const fileElements = readElements(data, true /* withHeader */);
+  TEST_EQUAL(fileElements.size(), 10, ());
+  TEST_EQUAL(rangesElements, fileElements, ());
+}
+
+UNIT_TEST(OSM_O5M_Source_Resets_index_test)
+{
+  platform::tests_support::ScopedFile const index("o5m_resets_test.dat",
+                                                  platform::tests_support::ScopedFile::Mode::DoNotCreate);
+  vector<uint64_t> const resetOffsets = {0, 7, 103};
+  generator::SaveO5MResetOffsets(index.GetFullPath(), 175 /* fileSize */, resetOffsets);
+
+  vector<uint64_t> loaded;
+  TEST(generator::LoadO5MResetOffsets(index.GetFullPath(), 175 /* fileSize */, loaded), ());
+  TEST_EQUAL(loaded, resetOffsets, ());
+
+  // The index of another file is ignored.
+  TEST(!generator::LoadO5MResetOffsets(index.GetFullPath(), 176 /* fileSize */, loaded), ());
+
+  // Ranges [0, 103) and [103, 175) are enough for 2 threads but not for 4 threads.
+  TEST_EQUAL(generator::MakeO5MRangesForThreads(resetOffsets, 175, 2).size(), 2, ());
+  TEST(generator::MakeO5MRangesForThreads(resetOffsets, 175, 4).empty(), ());
+  TEST(generator::MakeO5MRangesForThreads(resetOffsets, 175, 1).empty(), ());
+}
+
+UNIT_TEST(OSM_O5M_Source_Element_views_test)
+{
+  auto const readElements = [](string const & data) {
+    stringstream ss(data);
+    generator::SourceReader reader(ss);
+    vector<OsmElement> elements;
+    generator::ProcessOsmElementsFromO5M(reader, [&elements](OsmElement && element) {
+      elements.push_back(move(element));
+    });
+    return elements;
+  };
+
+  auto const readViews = [](string const & data) {
+    stringstream ss(data);
+    generator::SourceReader reader(ss);
+    vector<OsmElement> elements;
+    generator::ProcessOsmElementViewsFromO5M(reader, [&elements](OsmElementView const & view) {
+      elements.push_back(view.Materialize());
+    });
+    return elements;
+  };
+
+  for (auto const & data : {string(begin(way_o5m_data), end(way_o5m_data)),
+                            string(begin(relation_o5m_data), end(relation_o5m_data))})
+  {
+    auto const elements = readElements(data);
+    TEST(!elements.empty(), ());
+    TEST_EQUAL(readViews(data), elements, ());
+  }
+}
+
+UNIT_TEST(OSM_O5M_Source_Elements_chunk_test)
+{
+  OsmElementsChunk chunk;
+  string const longValue(100 * 1024, 'a');
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    chunk.Clear();
+    for (uint64_t id = 1; id <= 1000; ++id)
+    {
+      chunk.AddElement(OsmElement::EntityType::Way, id);
+      chunk.AddNd(id);
+      chunk.AddNd(id + 1);
+      chunk.AddTag("name", strings::to_string(id).c_str());
+    }
+    chunk.AddElement(OsmElement::EntityType::Relation, 1);
+    chunk.AddMember(1, OsmElement::EntityType::Way, "outer");
+    chunk.AddTag("description", longValue.c_str());
+
+    TEST_EQUAL(chunk.Size(), 1001, ());
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      auto const & view = chunk[i];
+      TEST_EQUAL(view.m_id, i + 1, ());
+      TEST_EQUAL(view.Nodes().size(), 2, ());
+      TEST_EQUAL(view.Nodes()[1], i + 2, ());
+      TEST(view.Members().empty(), ());
+      TEST_EQUAL(view.Tags().size(), 1, ());
+      TEST_EQUAL(string(view.Tags()[0].m_value), strings::to_string(i + 1), ());
+    }
+
+    auto const relation = chunk[1000].Materialize();
+    TEST_EQUAL(relation.Members().size(), 1, ());
+    TEST_EQUAL(relation.Members()[0].m_role, "outer", ());
+    TEST_EQUAL(relation.GetTag("description"), longValue, ());
+  }
+}
+
+UNIT_TEST(OSM_O5M_Writer_test)
+{
+  platform::tests_support::ScopedFile const file(
+      "o5m_writer_test.o5m", platform::tests_support::ScopedFile::Mode::DoNotCreate);
+
+  vector<OsmElement> elements;
+  for (auto const id : vector<uint64_t>{5, 3, 1000000000000})
+  {
+    OsmElement node;
+    node.m_type = OsmElement::EntityType::Node;
+    node.m_id = id;
+    node.m_lat = -55.7558 + id % 7;
+    node.m_lon = 37.6173 - id % 11;
+    node.AddTag("name", "Node " + strings::to_string(id));
+    node.AddTag("place", "city");
+    elements.push_back(node);
+  }
+
+  OsmElement way;
+  way.m_type = OsmElement::EntityType::Way;
+  way.m_id = 7;
+  way.AddNd(5);
+  way.AddNd(3);
+  way.AddNd(1000000000000);
+  way.AddNd(5);
+  way.AddTag("building", "yes");
+  elements.push_back(way);
+
+  OsmElement relation;
+  relation.m_type = OsmElement::EntityType::Relation;
+  relation.m_id = 2;
+  relation.AddMember(7, OsmElement::EntityType::Way, "outer");
+  relation.AddMember(3, OsmElement::EntityType::Node, "label");
+  relation.AddMember(1, OsmElement::EntityType::Relation, "");
+  relation.AddTag("type", "multipolygon");
+  elements.push_back(relation);
+
+  {
+    generator::O5MWriter writer(file.GetFullPath(), 2 /* elementsPerReset */);
+    for (auto const & element : elements)
+      writer.Write(element);
+    TEST_EQUAL(writer.GetElementsCount(), elements.size(), ());
+  }
+
+  string data;
+  FileReader(file.GetFullPath()).ReadAsString(data);
+  // The header reset and the resets after every 2 elements.
+  TEST_EQUAL(generator::FindO5MResetOffsets(data.data(), data.size()).size(), 3, ());
+
+  stringstream ss(data);
+  generator::SourceReader reader(ss);
+  generator::ProcessorOsmElementsFromO5M o5mReader(reader);
+  vector<OsmElement> readElements;
+  OsmElement element;
+  while (o5mReader.TryRead(element))
+    readElements.push_back(element);
+  TEST_EQUAL(readElements, elements, ());
+}
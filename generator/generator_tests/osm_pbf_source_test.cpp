@@ -0,0 +1,300 @@
+#include "testing/testing.hpp"
+
+#include "generator/osm_element.hpp"
+#include "generator/osm_pbf_source.hpp"
+#include "generator/osm_source.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+using namespace generator;
+using namespace std;
+
+namespace
+{
+// Writes the protobuf wire format of the osm.pbf messages.
+class MessageWriter
+{
+public:
+  void Varint(uint32_t field, uint64_t value)
+  {
+    WriteVarint(uint64_t{field} << 3);
+    WriteVarint(value);
+  }
+
+  void SignedVarint(uint32_t field, int64_t value) { Varint(field, ZigZag(value)); }
+
+  void Bytes(uint32_t field, string const & value)
+  {
+    WriteVarint((uint64_t{field} << 3) | 2);
+    WriteVarint(value.size());
+    m_data += value;
+  }
+
+  void Packed(uint32_t field, vector<uint64_t> const & values)
+  {
+    MessageWriter packed;
+    for (auto const value : values)
+      packed.WriteVarint(value);
+    Bytes(field, packed.m_data);
+  }
+
+  void PackedSigned(uint32_t field, vector<int64_t> const & values)
+  {
+    MessageWriter packed;
+    for (auto const value : values)
+      packed.WriteVarint(ZigZag(value));
+    Bytes(field, packed.m_data);
+  }
+
+  string const & GetData() const { return m_data; }
+
+private:
+  static uint64_t ZigZag(int64_t value)
+  {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+
+  void WriteVarint(uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      m_data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    m_data.push_back(static_cast<char>(value));
+  }
+
+  string m_data;
+};
+
+string Compress(string const & data)
+{
+  namespace io = boost::iostreams;
+  string result;
+  io::filtering_streambuf<io::input> in;
+  in.push(io::zlib_compressor());
+  in.push(io::array_source(data.data(), data.size()));
+  io::copy(in, io::back_inserter(result));
+  return result;
+}
+
+void AppendBlob(string const & type, string const & content, bool compressed, string & file)
+{
+  MessageWriter blob;
+  if (compressed)
+  {
+    blob.Varint(2 /* raw_size */, content.size());
+    blob.Bytes(3 /* zlib_data */, Compress(content));
+  }
+  else
+  {
+    blob.Bytes(1 /* raw */, content);
+  }
+
+  MessageWriter header;
+  header.Bytes(1 /* type */, type);
+  header.Varint(3 /* datasize */, blob.GetData().size());
+
+  auto const headerSize = static_cast<uint32_t>(header.GetData().size());
+  for (int shift = 24; shift >= 0; shift -= 8)
+    file.push_back(static_cast<char>((headerSize >> shift) & 0xff));
+  file += header.GetData();
+  file += blob.GetData();
+}
+
+string MakeHeaderBlock(vector<string> const & requiredFeatures)
+{
+  MessageWriter header;
+  for (auto const & feature : requiredFeatures)
+    header.Bytes(4 /* required_features */, feature);
+  header.Bytes(16 /* writingprogram */, "generator_tests");
+  return header.GetData();
+}
+
+string MakeStringTable(vector<string> const & strings)
+{
+  MessageWriter table;
+  for (auto const & s : strings)
+    table.Bytes(1, s);
+  return table.GetData();
+}
+
+// Dense nodes 1, 2 with a name, 3 and way 10 with the default granularity.
+string MakeFirstDataBlock()
+{
+  MessageWriter dense;
+  dense.PackedSigned(1 /* id */, {1, 1, 1});
+  dense.PackedSigned(8 /* lat */, {557500000, 10, -20});
+  dense.PackedSigned(9 /* lon */, {376000000, -10, 30});
+  dense.Packed(10 /* keys_vals */, {0, 1, 2, 0, 0});
+
+  MessageWriter way;
+  way.Varint(1 /* id */, 10);
+  way.Packed(2 /* keys */, {3});
+  way.Packed(3 /* vals */, {4});
+  way.PackedSigned(8 /* refs */, {1, 1, 1});
+
+  MessageWriter nodesGroup;
+  nodesGroup.Bytes(2 /* dense */, dense.GetData());
+  MessageWriter waysGroup;
+  waysGroup.Bytes(3 /* ways */, way.GetData());
+
+  MessageWriter block;
+  block.Bytes(1 /* stringtable */,
+              MakeStringTable({"", "name", "Node 2", "highway", "residential"}));
+  block.Bytes(2 /* primitivegroup */, nodesGroup.GetData());
+  block.Bytes(2 /* primitivegroup */, waysGroup.GetData());
+  return block.GetData();
+}
+
+// Node 4 and relation 20 with a custom granularity and offsets.
+string MakeSecondDataBlock()
+{
+  MessageWriter node;
+  node.SignedVarint(1 /* id */, 4);
+  node.SignedVarint(8 /* lat */, 5000);
+  node.SignedVarint(9 /* lon */, -5000);
+
+  MessageWriter relation;
+  relation.Varint(1 /* id */, 20);
+  relation.Packed(2 /* keys */, {1});
+  relation.Packed(3 /* vals */, {2});
+  relation.Packed(8 /* roles_sid */, {3, 4});
+  relation.PackedSigned(9 /* memids */, {10, -6});
+  relation.Packed(10 /* types */, {1, 0});
+
+  MessageWriter group;
+  group.Bytes(1 /* nodes */, node.GetData());
+  group.Bytes(4 /* relations */, relation.GetData());
+
+  MessageWriter block;
+  // Groups may precede the string table.
+  block.Bytes(2 /* primitivegroup */, group.GetData());
+  block.Bytes(1 /* stringtable */, MakeStringTable({"", "type", "multipolygon", "outer", "label"}));
+  block.Varint(17 /* granularity */, 1000);
+  block.Varint(19 /* lat_offset */, 10000000000);
+  block.Varint(20 /* lon_offset */, 20000000000);
+  return block.GetData();
+}
+
+string MakePbf(vector<string> const & requiredFeatures = {"OsmSchema-V0.6", "DenseNodes"})
+{
+  string file;
+  AppendBlob("OSMHeader", MakeHeaderBlock(requiredFeatures), false /* compressed */, file);
+  AppendBlob("OSMData", MakeFirstDataBlock(), false /* compressed */, file);
+  AppendBlob("OSMData", MakeSecondDataBlock(), true /* compressed */, file);
+  return file;
+}
+
+vector<OsmElement> MakeExpectedElements()
+{
+  vector<OsmElement> elements(6);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    elements[i].m_type = OsmElement::EntityType::Node;
+    elements[i].m_id = i + 1;
+  }
+  elements[0].m_lat = 55.75;
+  elements[0].m_lon = 37.6;
+  elements[1].m_lat = 55.750001;
+  elements[1].m_lon = 37.599999;
+  elements[1].AddTag("name", "Node 2");
+  elements[2].m_lat = 55.749999;
+  elements[2].m_lon = 37.600002;
+
+  elements[3].m_type = OsmElement::EntityType::Way;
+  elements[3].m_id = 10;
+  for (uint64_t nd : {1, 2, 3})
+    elements[3].AddNd(nd);
+  elements[3].AddTag("highway", "residential");
+
+  elements[4].m_type = OsmElement::EntityType::Node;
+  elements[4].m_id = 4;
+  elements[4].m_lat = 10.005;
+  elements[4].m_lon = 19.995;
+
+  elements[5].m_type = OsmElement::EntityType::Relation;
+  elements[5].m_id = 20;
+  elements[5].AddMember(10, OsmElement::EntityType::Way, "outer");
+  elements[5].AddMember(4, OsmElement::EntityType::Node, "label");
+  elements[5].AddTag("type", "multipolygon");
+  return elements;
+}
+
+void SortElements(vector<OsmElement> & elements)
+{
+  sort(elements.begin(), elements.end(), [](OsmElement const & lhs, OsmElement const & rhs) {
+    return make_pair(lhs.m_type, lhs.m_id) < make_pair(rhs.m_type, rhs.m_id);
+  });
+}
+}  // namespace
+
+UNIT_TEST(OSM_PBF_Source_Sequential_test)
+{
+  stringstream ss(MakePbf());
+  SourceReader reader(ss);
+  ProcessorOsmElementsFromPbf processor(reader);
+
+  vector<OsmElement> elements;
+  OsmElement element;
+  while (processor.TryRead(element))
+    elements.push_back(element);
+
+  TEST_EQUAL(elements, MakeExpectedElements(), ());
+}
+
+UNIT_TEST(OSM_PBF_Source_Blobs_test)
+{
+  auto const file = MakePbf();
+  auto const blobs = pbf::FindDataBlobs(file.data(), file.size());
+  TEST_EQUAL(blobs.size(), 2, ());
+
+  // Processors sharing the blobs counter decode every blob once.
+  atomic<size_t> nextBlob{0};
+  ProcessorOsmElementsFromPbf first(file.data(), blobs, nextBlob);
+  ProcessorOsmElementsFromPbf second(file.data(), blobs, nextBlob);
+
+  vector<OsmElement> firstElements;
+  vector<OsmElement> secondElements;
+  TEST(second.ReadBlob(secondElements), ());
+  TEST(first.ReadBlob(firstElements), ());
+  TEST(!first.ReadBlob(firstElements), ());
+  TEST(!second.ReadBlob(secondElements), ());
+
+  nextBlob = 0;
+  vector<OsmElement> elements;
+  OsmElement element;
+  while (second.TryRead(element))
+    elements.push_back(element);
+  while (first.TryRead(element))
+    elements.push_back(element);
+
+  auto expected = MakeExpectedElements();
+  SortElements(expected);
+  SortElements(elements);
+  TEST_EQUAL(elements, expected, ());
+}
+
+UNIT_TEST(OSM_PBF_Source_Unsupported_features_test)
+{
+  auto const file = MakePbf({"OsmSchema-V0.6", "HistoricalInformation"});
+  TEST_THROW(pbf::FindDataBlobs(file.data(), file.size()), pbf::PbfException, ());
+
+  stringstream ss(file);
+  SourceReader reader(ss);
+  ProcessorOsmElementsFromPbf processor(reader);
+  OsmElement element;
+  TEST_THROW(processor.TryRead(element), pbf::PbfException, ());
+}
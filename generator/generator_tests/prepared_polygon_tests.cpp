@@ -0,0 +1,130 @@
+#include "testing/testing.hpp"
+
+#include "generator/regions/prepared_polygon.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace generator::regions;
+
+namespace
+{
+// A star with a square hole.
+BoostPolygon MakePolygon()
+{
+  BoostPolygon polygon;
+  size_t const kRays = 50;
+  for (size_t i = 0; i < 2 * kRays; ++i)
+  {
+    auto const angle = M_PI * i / kRays;
+    auto const radius = i % 2 == 0 ? 10.0 : 4.0;
+    polygon.outer().emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+  }
+
+  polygon.inners().resize(1);
+  auto & hole = polygon.inners().front();
+  hole = {{-1.0, -1.0}, {-1.0, 1.0}, {1.0, 1.0}, {1.0, -1.0}};
+  boost::geometry::correct(polygon);
+  return polygon;
+}
+}  // namespace
+
+UNIT_TEST(PreparedPolygon_Covers)
+{
+  auto const polygon = MakePolygon();
+  PreparedPolygon const prepared(polygon);
+
+  std::vector<BoostPoint> points{{0.0, 0.0}, {1.0, 0.0}, {1.0, 1.0}, {0.5, 1.0}, {2.0, 0.0},
+                                 {10.0, 0.0}, {10.5, 0.0}, {-20.0, 3.0}};
+  for (auto const & point : polygon.outer())
+    points.push_back(point);
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-11.0, 11.0);
+  for (size_t i = 0; i < 10000; ++i)
+    points.emplace_back(distribution(engine), distribution(engine));
+
+  for (auto const & point : points)
+  {
+    TEST_EQUAL(prepared.Covers(point), boost::geometry::covered_by(point, polygon),
+               (point.get<0>(), point.get<1>()));
+  }
+}
+
+UNIT_TEST(PreparedPolygon_CoversRectRough)
+{
+  auto const polygon = MakePolygon();
+  PreparedPolygon const prepared(polygon);
+
+  TEST(prepared.CoversRectRough({{1.5, 1.5}, {2.0, 2.0}}), ());
+  // The hole.
+  TEST(!prepared.CoversRectRough({{-0.5, -0.5}, {0.5, 0.5}}), ());
+  // The rect is outside the polygon rect.
+  TEST(!prepared.CoversRectRough({{9.0, 9.0}, {11.0, 11.0}}), ());
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-11.0, 11.0);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BoostRect rect{{distribution(engine), distribution(engine)},
+                   {distribution(engine), distribution(engine)}};
+    boost::geometry::correct(rect);
+    if (!prepared.CoversRectRough(rect))
+      continue;
+
+    BoostPolygon rectPolygon;
+    boost::geometry::convert(rect, rectPolygon);
+    TEST(boost::geometry::covered_by(rectPolygon, polygon), ());
+  }
+}
+
+UNIT_TEST(PreparedPolygon_PolygonsRough)
+{
+  auto const polygon = MakePolygon();
+  PreparedPolygon const prepared(polygon);
+
+  auto const makeRect = [](double minX, double minY, double maxX, double maxY) {
+    BoostPolygon rectPolygon;
+    boost::geometry::convert(BoostRect{{minX, minY}, {maxX, maxY}}, rectPolygon);
+    return rectPolygon;
+  };
+
+  PreparedPolygon const inside(makeRect(1.5, 1.5, 2.0, 2.0));
+  TEST(prepared.CoversRough(inside), ());
+  TEST(!prepared.MissesRough(inside), ());
+  TEST(!prepared.DisjointRough(inside), ());
+
+  PreparedPolygon const outside(makeRect(9.0, 9.0, 10.0, 10.0));
+  TEST(!prepared.CoversRough(outside), ());
+  TEST(prepared.MissesRough(outside), ());
+  TEST(prepared.DisjointRough(outside), ());
+  TEST(outside.DisjointRough(prepared), ());
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-11.0, 11.0);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    BoostRect rect{{distribution(engine), distribution(engine)},
+                   {distribution(engine), distribution(engine)}};
+    boost::geometry::correct(rect);
+    BoostPolygon rectPolygon;
+    boost::geometry::convert(rect, rectPolygon);
+    PreparedPolygon const preparedRect(rectPolygon);
+
+    auto const covered = boost::geometry::covered_by(rectPolygon, polygon);
+    if (prepared.CoversRough(preparedRect))
+      TEST(covered, ());
+    if (prepared.MissesRough(preparedRect))
+      TEST(!covered, ());
+
+    if (prepared.DisjointRough(preparedRect) || preparedRect.DisjointRough(prepared))
+    {
+      std::vector<BoostPolygon> intersection;
+      boost::geometry::intersection(rectPolygon, polygon, intersection);
+      for (auto const & part : intersection)
+        TEST_NEAR(boost::geometry::area(part), 0.0, 1e-9, ());
+    }
+  }
+}
@@ -0,0 +1,75 @@
+#include "testing/testing.hpp"
+
+#include "generator/regions/region_properties_store.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include <string>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+using namespace generator::regions;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+std::string const kRegionsKv =
+    "0000000000000001 {\"type\":\"Feature\",\"properties\":{\"locales\":{\"default\":"
+    "{\"name\":\"Russia\",\"address\":{\"country\":\"Russia\"}},\"en\":{\"name\":\"Russia\"}},"
+    "\"rank\":2,\"dref\":null},\"bbox\":[19.6,41.1,191.0,81.9]}\n"
+    "0000000000000002 {\"type\":\"Feature\",\"properties\":{\"locales\":{\"default\":"
+    "{\"name\":\"Moscow\",\"address\":{\"country\":\"Russia\",\"locality\":\"Moscow\"}},"
+    "\"en\":{\"name\":\"Moscow\"},\"ru\":{\"name\":\"Москва\"}},"
+    "\"rank\":4,\"dref\":\"0000000000000001\"},\"bbox\":[36.8,55.1,37.9,56.0]}\n"
+    "broken line\n"
+    "0000000000000003 {\"properties\":\n"
+    "0000000000000002 {\"properties\":{\"rank\":10,\"dref\":null}}\n";
+}  // namespace
+
+UNIT_TEST(RegionPropertiesStore_Build)
+{
+  ScopedFile const kv{"regions_properties_store.jsonl", kRegionsKv};
+  auto const storePath = RegionPropertiesStore::GetStorePath(kv.GetFullPath());
+  ScopedFile const store{
+      "regions_properties_store.jsonl" + std::string{RegionPropertiesStore::kExtension},
+      ScopedFile::Mode::DoNotCreate};
+  TEST_EQUAL(store.GetFullPath(), storePath, ());
+  RegionPropertiesStore::BuildIfNeeded(kv.GetFullPath());
+
+  RegionPropertiesStore const properties{storePath};
+  TEST_EQUAL(properties.Size(), 2, ());
+  TEST(!properties.FindRecord(3), ());
+  TEST(!properties.Find(3), ());
+
+  auto const country = properties.FindRecord(1);
+  TEST(country, ());
+  TEST_EQUAL(country->m_rank, 2, ());
+  TEST(!country->GetDref(), ());
+  TEST_EQUAL(country->GetLevel(), PlaceLevel::Country, ());
+  TEST(country->HasAddressLevel(PlaceLevel::Country), ());
+  TEST(!country->HasAddressLevel(PlaceLevel::Locality), ());
+  TEST_EQUAL(country->m_bbox[0], 19.6, ());
+  TEST_EQUAL(country->m_bbox[3], 81.9, ());
+  TEST_EQUAL(*properties.GetName(*country, "en"), "Russia", ());
+  TEST(!properties.GetName(*country, "ru"), ());
+
+  // The first line of an id is kept.
+  auto const city = properties.FindRecord(2);
+  TEST(city, ());
+  TEST_EQUAL(city->m_rank, 4, ());
+  TEST(city->GetDref(), ());
+  TEST_EQUAL(*city->GetDref(), 1, ());
+  TEST_EQUAL(city->GetLevel(), PlaceLevel::Locality, ());
+  TEST(city->HasAddressLevel(PlaceLevel::Country), ());
+  TEST(!city->HasAddressLevel(PlaceLevel::Region), ());
+  TEST_EQUAL(*properties.GetName(*city, "default"), "Moscow", ());
+  TEST_EQUAL(*properties.GetName(*city, "ru"), u8"Москва", ());
+
+  auto const json = properties.GetJson(*city);
+  TEST(json, ());
+  TEST_EQUAL(properties.Find(2), json, ());
+  auto && cityProperties = base::GetJSONObligatoryField(*json, "properties");
+  TEST_EQUAL(FromJSONObject<int>(cityProperties, "rank"), 4, ());
+  TEST_EQUAL(FromJSONObject<std::string>(cityProperties, "dref"), "0000000000000001", ());
+}
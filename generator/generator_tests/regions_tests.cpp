@@ -1,11 +1,13 @@
 #include "testing/testing.hpp"
 
 #include "generator/feature_builder.hpp"
+#include "generator/feature_generator.hpp"
 #include "generator/generator_tests/common.hpp"
 #include "generator/osm2type.hpp"
 #include "generator/osm_element.hpp"
 #include "generator/regions/collector_region_info.hpp"
 #include "generator/regions/place_point.hpp"
+#include "generator/regions/regions.hpp"
 #include "generator/regions/regions_builder.hpp"
 #include "generator/translator_region.hpp"
 
@@ -20,6 +22,8 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <fstream>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -79,18 +83,19 @@ void BuildTestData(std::vector<OsmElementData> const & testData, RegionsBuilder:
   }
 }
 
-std::string ToLabelingString(vector<Node::Ptr> const & path, bool withGeometry)
+std::string ToLabelingString(FlatRegionsTree const & tree, FlatRegionsTree::Path const & path,
+                             bool withGeometry)
 {
   CHECK(!path.empty(), ());
   std::stringstream stream;
   auto i = path.begin();
-  auto const & countryName = (*i)->GetData().GetName();
+  auto const & countryName = tree.GetData(*i).GetName();
   CHECK(!countryName.empty(), ());
-  stream << (*i)->GetData().GetName();
+  stream << countryName;
   ++i;
   for (; i != path.end(); ++i)
   {
-    auto const & region = (*i)->GetData();
+    auto const & region = tree.GetData(*i);
     stream << ", " << GetLabel(region.GetLevel()) << ": " << region.GetName();
 
     if (withGeometry)
@@ -126,18 +131,42 @@ std::vector<std::string> GenerateTestRegions(std::vector<OsmElementData> const &
   base::thread_pool::computational::ThreadPool threadsPool{1};
   RegionsBuilder builder(std::move(regions), std::move(placePointsMap), threadsPool);
   std::vector<std::string> kvRegions;
-  builder.ForEachCountry([&](std::string const & /*name*/, Node::PtrList const & outers) {
-    for (auto const & tree : outers)
-    {
-      ForEachLevelPath(tree, [&](std::vector<Node::Ptr> const & path) {
-        kvRegions.push_back(ToLabelingString(path, withGeometry));
-      });
-    }
+  builder.ForEachCountry([&](std::string const & /*name*/, FlatRegionsTree && tree) {
+    tree.ForEachLevelPath([&](FlatRegionsTree::Path const & path) {
+      kvRegions.push_back(ToLabelingString(tree, path, withGeometry));
+    });
   });
 
   return kvRegions;
 }
 
+std::string GenerateTestRegionsKv(std::vector<OsmElementData> const & testData,
+                                  unsigned int threadsCount)
+{
+  classificator::Load();
+
+  auto const collectorFilename = GetFileName();
+  auto const featuresFilename = GetFileName();
+  auto const kvFilename = GetFileName();
+  SCOPE_GUARD(removeFiles, [&]() {
+    for (auto const & filename : {collectorFilename, featuresFilename, kvFilename})
+      Platform::RemoveFileIfExists(filename);
+  });
+
+  CollectRegionInfo(collectorFilename, testData);
+  {
+    FeaturesCollector collector(featuresFilename);
+    for (auto const & elementData : testData)
+      collector.Collect(FeatureBuilderFromOmsElementData(elementData));
+  }
+
+  GenerateRegions(featuresFilename, collectorFilename, kvFilename, false /* verbose */,
+                  threadsCount);
+
+  std::ifstream stream(kvFilename);
+  return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
 bool HasName(std::vector<string> const & coll, std::string const & name)
 {
   auto const end = std::end(coll);
@@ -271,11 +300,11 @@ RegionsBuilder::Regions MakeTestDataSet1(RegionInfo & collector)
 class StringJoinPolicy
 {
 public:
-  std::string ToString(NodePath const & nodePath) const
+  std::string ToString(FlatRegionsTree const & tree, FlatRegionsTree::Path const & path) const
   {
     std::stringstream stream;
-    for (auto const & n : nodePath)
-      stream << n->GetData().GetName();
+    for (auto const n : path)
+      stream << tree.GetData(n).GetName();
 
     return stream.str();
   }
@@ -327,14 +356,11 @@ UNIT_TEST(RegionsBuilderTest_GetCountryTrees)
   std::vector<std::string> bankOfNames;
   base::thread_pool::computational::ThreadPool threadsPool{1};
   RegionsBuilder builder(MakeTestDataSet1(collector), {} /* placePointsMap */, threadsPool);
-  builder.ForEachCountry([&](std::string const & /*name*/, Node::PtrList const & outers) {
-    for (auto const & tree : outers)
-    {
-      ForEachLevelPath(tree, [&](NodePath const & path) {
-        StringJoinPolicy stringifier;
-        bankOfNames.push_back(stringifier.ToString(path));
-      });
-    }
+  builder.ForEachCountry([&](std::string const & /*name*/, FlatRegionsTree && tree) {
+    tree.ForEachLevelPath([&](FlatRegionsTree::Path const & path) {
+      StringJoinPolicy stringifier;
+      bankOfNames.push_back(stringifier.ToString(tree, path));
+    });
   });
 
   TEST(NameExists(bankOfNames, "Country_2"), ());
@@ -348,6 +374,30 @@ UNIT_TEST(RegionsBuilderTest_GetCountryTrees)
   TEST(NameExists(bankOfNames, "Country_1Country_1_Region_5Country_1_Region_5_Subregion_7"), ());
 }
 
+UNIT_TEST(RegionsGeneratorTest_KvDoesNotDependOnThreadsCount)
+{
+  Tag const admin{"admin_level"};
+  Tag const place{"place"};
+  Tag const name{"name"};
+  TagValue const ba{"boundary", "administrative"};
+
+  std::vector<OsmElementData> const testData{
+      {1, {name = u8"Country_1", admin = "2", ba}, RectArea{{0.00, 0.00}, {0.50, 0.50}}, {}},
+      {2, {name = u8"State_1", place = "state", admin = "4", ba},
+       RectArea{{0.10, 0.10}, {0.20, 0.20}}, {}},
+      {3, {name = u8"City_1", place = "city", admin = "8", ba},
+       RectArea{{0.12, 0.12}, {0.18, 0.18}}, {}},
+      {4, {name = u8"Country_2", admin = "2", ba}, RectArea{{1.00, 1.00}, {1.50, 1.50}}, {}},
+      {5, {name = u8"State_2", place = "state", admin = "4", ba},
+       RectArea{{1.10, 1.10}, {1.20, 1.20}}, {}},
+      {6, {name = u8"Country_3", admin = "2", ba}, RectArea{{2.00, 2.00}, {2.50, 2.50}}, {}},
+  };
+
+  auto const kv = GenerateTestRegionsKv(testData, 1 /* threadsCount */);
+  TEST_EQUAL(std::count(kv.begin(), kv.end(), '\n'), testData.size(), (kv));
+  TEST_EQUAL(GenerateTestRegionsKv(testData, 4 /* threadsCount */), kv, ());
+}
+
 // City generation tests ---------------------------------------------------------------------------
 UNIT_TEST(RegionsBuilderTest_GenerateCityPointRegionByAround)
 {
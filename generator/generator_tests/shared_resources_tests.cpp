@@ -0,0 +1,94 @@
+#include "testing/testing.hpp"
+
+#include "generator/shared_resources.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+using namespace generator;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+std::string ReadFile(std::string const & filename)
+{
+  std::ifstream stream(filename);
+  return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+UNIT_TEST(SharedResources_Share)
+{
+  ScopedFile const file("shared_resources.txt", "content");
+
+  size_t loads = 0;
+  auto const get = [&]() {
+    return SharedResources::Get<std::string>({file.GetFullPath()}, [&]() {
+      ++loads;
+      return std::make_shared<std::string>(ReadFile(file.GetFullPath()));
+    });
+  };
+
+  {
+    auto const first = get();
+    auto const second = get();
+    TEST_EQUAL(*first, "content", ());
+    TEST_EQUAL(first, second, ());
+    TEST_EQUAL(loads, 1, ());
+  }
+
+  // The resource is released with its last user.
+  TEST_EQUAL(*get(), "content", ());
+  TEST_EQUAL(loads, 2, ());
+
+  {
+    SharedResources::Scope const scope;
+    TEST_EQUAL(*get(), "content", ());
+    TEST_EQUAL(*get(), "content", ());
+    TEST_EQUAL(loads, 3, ());
+  }
+  TEST_EQUAL(*get(), "content", ());
+  TEST_EQUAL(loads, 4, ());
+}
+
+UNIT_TEST(SharedResources_ChangedFile)
+{
+  ScopedFile const file("shared_resources.txt", "content");
+
+  size_t loads = 0;
+  auto const get = [&]() {
+    return SharedResources::Get<std::string>({file.GetFullPath()}, [&]() {
+      ++loads;
+      return std::make_shared<std::string>(ReadFile(file.GetFullPath()));
+    });
+  };
+
+  SharedResources::Scope const scope;
+  auto const original = get();
+  {
+    std::ofstream stream(file.GetFullPath());
+    stream << "changed content";
+  }
+
+  // The change is seen by the size of the file even if the modification time is the same.
+  auto const changed = get();
+  TEST_EQUAL(*original, "content", ());
+  TEST_EQUAL(*changed, "changed content", ());
+  TEST_EQUAL(get(), changed, ());
+  TEST_EQUAL(loads, 2, ());
+
+  // The resources of the absent files are not shared.
+  auto const absent = [&]() {
+    return SharedResources::Get<std::string>({file.GetFullPath() + ".absent"}, [&]() {
+      ++loads;
+      return std::make_shared<std::string>();
+    });
+  };
+  absent();
+  absent();
+  TEST_EQUAL(loads, 4, ());
+}
@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -27,6 +28,38 @@ UNIT_TEST(Source_To_Element_create_from_xml_test)
   TEST_EQUAL(elements.size(), 10, (elements));
 }
 
+UNIT_TEST(Source_To_Element_create_from_xml_chunks_test)
+{
+  std::string const src(way_xml_data);
+  std::istringstream ss(src);
+  SourceReader reader(ss);
+
+  std::vector<OsmElement> expected;
+  ProcessOsmElementsFromXML(reader, [&expected](OsmElement && e)
+  {
+    expected.push_back(std::move(e));
+  });
+
+  for (size_t const chunkSize : {size_t{1}, size_t{100}, src.size()})
+  {
+    auto const chunks = xml::FindChunks(src.data(), src.size(), chunkSize);
+    TEST_EQUAL(chunks.front().m_offset, 0, ());
+    TEST_EQUAL(chunks.back().m_offset + chunks.back().m_size, src.size(), ());
+    if (chunkSize == src.size())
+      TEST_EQUAL(chunks.size(), 1, ());
+    else
+      TEST_GREATER(chunks.size(), 1, ());
+
+    std::vector<OsmElement> elements;
+    for (auto const & chunk : chunks)
+    {
+      TEST(chunk.m_offset == 0 || src.compare(chunk.m_offset, 1, "<") == 0, (chunk.m_offset));
+      xml::DecodeChunk(src.data(), chunk, elements);
+    }
+    TEST_EQUAL(elements, expected, (chunkSize));
+  }
+}
+
 UNIT_TEST(Source_To_Element_create_from_o5m_test)
 {
   std::string src(std::begin(relation_o5m_data), std::end(relation_o5m_data));
@@ -0,0 +1,112 @@
+#include "testing/testing.hpp"
+
+#include "generator/stages_manifest.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace generator;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+void WriteFile(std::string const & filename, std::string const & content)
+{
+  std::ofstream stream;
+  stream.exceptions(std::ios::failbit | std::ios::badbit);
+  stream.open(filename);
+  stream << content;
+}
+
+std::string ReadFile(std::string const & filename)
+{
+  std::ifstream stream(filename);
+  return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+UNIT_TEST(StagesManifest_SkipUpToDate)
+{
+  ScopedFile const manifestFile("stages_manifest.json", ScopedFile::Mode::DoNotCreate);
+  ScopedFile const input("stages_manifest_input.txt", "input");
+  ScopedFile const output("stages_manifest_output.txt", ScopedFile::Mode::DoNotCreate);
+  ScopedFile const index("stages_manifest_index.txt", ScopedFile::Mode::DoNotCreate);
+
+  StagesManifest::Stage features{"features", "threads=1", {input.GetFullPath()},
+                                 {output.GetFullPath(), "stages_manifest_optional.txt"}};
+  // The indexer changes its input in place.
+  StagesManifest::Stage indexer{"index", "", {output.GetFullPath(), "" /* not set option */},
+                                {output.GetFullPath(), index.GetFullPath()}};
+
+  size_t featuresRuns = 0;
+  size_t indexerRuns = 0;
+  auto const run = [&](StagesManifest::Stage const & stage) {
+    StagesManifest manifest(manifestFile.GetFullPath());
+    return manifest.Run(stage, [&]() {
+      if (stage.m_name == features.m_name)
+      {
+        ++featuresRuns;
+        WriteFile(output.GetFullPath(), ReadFile(input.GetFullPath()) + " features");
+      }
+      else
+      {
+        ++indexerRuns;
+        WriteFile(output.GetFullPath(), ReadFile(output.GetFullPath()) + " indexed");
+        WriteFile(index.GetFullPath(), "index");
+      }
+      return true;
+    });
+  };
+
+  TEST(run(features), ());
+  TEST(run(features), ());
+  TEST_EQUAL(featuresRuns, 1, ());
+  TEST(manifestFile.Exists(), ());
+
+  features.m_parameters = "threads=2";
+  TEST(run(features), ());
+  TEST_EQUAL(featuresRuns, 2, ());
+
+  // The same content is rewritten.
+  WriteFile(input.GetFullPath(), "input");
+  TEST(run(features), ());
+  TEST_EQUAL(featuresRuns, 2, ());
+
+  WriteFile(input.GetFullPath(), "changed input");
+  TEST(run(features), ());
+  TEST_EQUAL(featuresRuns, 3, ());
+
+  TEST(run(indexer), ());
+  TEST(run(indexer), ());
+  TEST(run(features), ());
+  TEST_EQUAL(indexerRuns, 1, ());
+  TEST_EQUAL(featuresRuns, 3, ());
+  TEST_EQUAL(ReadFile(output.GetFullPath()), "changed input features indexed", ());
+
+  WriteFile(index.GetFullPath(), "broken index");
+  TEST(run(indexer), ());
+  TEST_EQUAL(indexerRuns, 2, ());
+
+  // The failed stage is not recorded.
+  StagesManifest manifest(manifestFile.GetFullPath());
+  StagesManifest::Stage failed{"failed", "", {input.GetFullPath()}, {}};
+  TEST(!manifest.Run(failed, []() { return false; }), ());
+  TEST(!manifest.IsUpToDate(failed), ());
+  TEST(manifest.IsUpToDate(features), ());
+}
+
+UNIT_TEST(StagesManifest_Disabled)
+{
+  ScopedFile const input("stages_manifest_input.txt", "input");
+  StagesManifest manifest("" /* filename */);
+  StagesManifest::Stage const stage{"stage", "", {input.GetFullPath()}, {}};
+
+  size_t runs = 0;
+  for (size_t i = 0; i < 2; ++i)
+    TEST(manifest.Run(stage, [&]() { return ++runs > 0; }), ());
+  TEST_EQUAL(runs, 2, ());
+  TEST(!manifest.IsUpToDate(stage), ());
+}
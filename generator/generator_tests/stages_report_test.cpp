@@ -0,0 +1,65 @@
+#include "testing/testing.hpp"
+
+#include "generator/stages_report.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace generator;
+
+UNIT_TEST(StagesReport_ScopedStages)
+{
+  auto & report = StagesReport::Instance();
+  report.Clear();
+  {
+    ScopedStage outer("outer");
+    {
+      ScopedStage inner("inner");
+    }
+  }
+
+  auto const stages = report.GetStages();
+  TEST_EQUAL(stages.size(), 2, ());
+  // Stages are added when they are finished.
+  TEST_EQUAL(stages[0].m_name, "inner", ());
+  TEST_EQUAL(stages[1].m_name, "outer", ());
+  TEST_LESS_OR_EQUAL(stages[1].m_startSeconds, stages[0].m_startSeconds, ());
+  TEST_LESS_OR_EQUAL(stages[0].m_wallSeconds, stages[1].m_wallSeconds, ());
+  TEST_GREATER(stages[1].m_peakRssBytes, 0u, ());
+
+  auto const json = base::LoadFromString(report.ToJson());
+  auto const jsonStages = base::GetJSONObligatoryField(json.get(), "stages");
+  TEST_EQUAL(json_array_size(jsonStages), 2, ());
+  auto const jsonOuter = json_array_get(jsonStages, 1);
+  TEST_EQUAL(FromJSONObject<std::string>(jsonOuter, "name"), "outer", ());
+  TEST_EQUAL(FromJSONObject<uint64_t>(jsonOuter, "peak_rss_bytes"), stages[1].m_peakRssBytes, ());
+  report.Clear();
+}
+
+UNIT_TEST(StagesReport_Memory)
+{
+  auto & report = StagesReport::Instance();
+  report.Clear();
+  {
+    base::memory::ScopedBytes bytes("stages_report_test", 1000);
+    ScopedStage stage("stage");
+  }
+
+  auto const stages = report.GetStages();
+  TEST_EQUAL(stages.size(), 1, ());
+  auto const & memory = stages[0].m_memory;
+  auto const it = std::find_if(memory.begin(), memory.end(), [](auto const & usage) {
+    return usage.m_name == "stages_report_test";
+  });
+  TEST(it != memory.end(), ());
+  TEST_EQUAL(it->m_bytes, 1000, ());
+  TEST_GREATER_OR_EQUAL(it->m_peakBytes, 1000, ());
+
+  auto const json = base::LoadFromString(report.ToJson());
+  auto const jsonStage = json_array_get(base::GetJSONObligatoryField(json.get(), "stages"), 0);
+  auto const jsonMemory = base::GetJSONObligatoryField(jsonStage, "memory");
+  TEST_EQUAL(json_array_size(jsonMemory), memory.size(), ());
+  report.Clear();
+}
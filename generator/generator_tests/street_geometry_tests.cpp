@@ -29,3 +29,28 @@ UNIT_TEST(HighwayGeometryTest_PinAtHalfWaySegmentCenter)
   TEST_EQUAL(pin.m_osmId, base::MakeOsmWay(3), ());
   TEST(m2::AlmostEqualAbs(pin.m_position, {1.75, 0.5}, 0.001), ());
 }
+
+UNIT_TEST(HighwayGeometryTest_LinesJoining)
+{
+  HighwayGeometry highway{};
+  highway.AddLine(base::MakeOsmWay(1), {{0.0, 0.0}, {1.0, 0.0}});
+  highway.AddLine(base::MakeOsmWay(2), {{3.0, 0.0}, {2.0, 0.0}});
+  highway.AddLine(base::MakeOsmWay(4), {{5.0, 5.0}, {6.0, 6.0}});
+  highway.AddLine(base::MakeOsmWay(3), {{2.0, 0.0}, {1.0, 0.0}});
+
+  std::vector<base::GeoObjectId> ids;
+  std::vector<m2::PointD> points;
+  highway.ForEachLineSegment([&](base::GeoObjectId const & osmId, m2::PointD const * segment,
+                                 size_t size) {
+    ids.push_back(osmId);
+    points.insert(points.end(), segment, segment + size);
+  });
+
+  TEST_EQUAL(ids, std::vector<base::GeoObjectId>({base::MakeOsmWay(2), base::MakeOsmWay(3),
+                                                  base::MakeOsmWay(1), base::MakeOsmWay(4)}),
+             ());
+  TEST_EQUAL(points, std::vector<m2::PointD>({{3.0, 0.0}, {2.0, 0.0}, {2.0, 0.0}, {1.0, 0.0},
+                                              {1.0, 0.0}, {0.0, 0.0}, {5.0, 5.0}, {6.0, 6.0}}),
+             ());
+  TEST_EQUAL(highway.GetBbox(), m2::RectD(0.0, 0.0, 6.0, 6.0), ());
+}
@@ -62,3 +62,36 @@ UNIT_TEST(StreetRegionTracingTest_StreetWithTransitRegion)
   TEST_EQUAL(segments[1].m_region.first, 2, ());
   TEST_EQUAL(segments[2].m_region.first, 1, ());
 }
+
+UNIT_TEST(StreetRegionTracingTest_BorderCrossings)
+{
+  // The regions are split by the borders x == 0.5 and x == 0.501.
+  size_t lookupsCount = 0;
+  auto regionGetter = [&lookupsCount] (auto && point) {
+    ++lookupsCount;
+    if (0.5 <= point.x && point.x <= 0.501)
+      return KeyValue{2, {}};
+    return KeyValue{1, {}};
+  };
+  auto borderCrossingFinder = [] (auto && from, auto && to) -> boost::optional<double> {
+    for (auto const border : {0.5, 0.501})
+    {
+      if (from.x < border && border <= to.x)
+        return (border - from.x) / (to.x - from.x);
+    }
+    return {};
+  };
+  auto && tracing = StreetRegionsTracing{{{0.0, 0.0}, {0.25, 0.0}, {0.5, 0.0}, {1.0, 0.0}},
+                                         regionGetter, borderCrossingFinder};
+  auto && segments = tracing.StealPathSegments();
+
+  TEST_EQUAL(segments.size(), 3, ());
+  TEST_EQUAL(segments[0].m_region.first, 1, ());
+  TEST_EQUAL(segments[1].m_region.first, 2, ());
+  TEST_EQUAL(segments[2].m_region.first, 1, ());
+  TEST_EQUAL(segments[0].m_path.front(), m2::PointD(0.0, 0.0), ());
+  TEST_EQUAL(segments[1].m_path.front(), m2::PointD(0.5, 0.0), ());
+  TEST_EQUAL(segments[2].m_path.back(), m2::PointD(1.0, 0.0), ());
+  // The start point and the points past the two crossings are looked up.
+  TEST_EQUAL(lookupsCount, 3, ());
+}
@@ -10,6 +10,7 @@
 #include "3party/jansson/myjansson.hpp"
 
 #include <algorithm>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -111,3 +112,63 @@ UNIT_TEST(StreetsBuilderTest_AggregatedStreetsInFeatures)
         ());
   TEST(featureIds.find(MakeOsmWay(3)) != featureIds.end(), ());
 }
+
+UNIT_TEST(StreetsBuilderTest_StreetsDoNotDependOnThreadsCount)
+{
+  std::vector<OsmElementData> osmElements;
+  for (uint64_t i = 1; i <= 40; ++i)
+  {
+    auto const x = 1.0 + 0.001 * i;
+    osmElements.push_back({i, {{"name", "Street " + std::to_string(i % 10)},
+                               {"highway", "residential"}},
+                           {{x, 2.001}, {x, 2.002}}, {}});
+  }
+  ScopedFile const streetsFeatures{"streets.mwm", ScopedFile::Mode::DoNotCreate};
+  WriteFeatures(osmElements, streetsFeatures);
+
+  auto const countStreets = [&streetsFeatures](unsigned int threadsCount) {
+    StreetsBuilder streetsBuilder{RussiaFinder(), threadsCount};
+    streetsBuilder.AssembleStreets(streetsFeatures.GetFullPath());
+    std::ostringstream streetsKv;
+    streetsBuilder.SaveStreetsKv(RussiaGetter, streetsKv);
+    auto const kv = streetsKv.str();
+    return std::count(kv.begin(), kv.end(), '\n');
+  };
+
+  TEST_EQUAL(countStreets(1), 10, ());
+  TEST_EQUAL(countStreets(4), 10, ());
+}
+
+UNIT_TEST(StreetsBuilderTest_AggregatedStreetsFeaturesDoNotDependOnThreadsCount)
+{
+  std::vector<OsmElementData> osmElements;
+  for (uint64_t i = 1; i <= 40; ++i)
+  {
+    auto const x = 1.0 + 0.001 * i;
+    osmElements.push_back({i, {{"name", "Street " + std::to_string(i % 10)},
+                               {"highway", "residential"}},
+                           {{x, 2.001}, {x, 2.002}}, {}});
+  }
+
+  auto const regenerateStreets = [&osmElements](unsigned int threadsCount) {
+    ScopedFile const streetsFeatures{"streets.mwm", ScopedFile::Mode::DoNotCreate};
+    WriteFeatures(osmElements, streetsFeatures);
+
+    StreetsBuilder streetsBuilder{RussiaFinder(), threadsCount};
+    streetsBuilder.AssembleStreets(streetsFeatures.GetFullPath());
+    streetsBuilder.RegenerateAggregatedStreetsFeatures(streetsFeatures.GetFullPath());
+
+    std::vector<std::pair<std::string, size_t>> streets;
+    feature::ForEachFromDatRawFormat(streetsFeatures.GetFullPath(), [&](auto && fb, ...) {
+      streets.emplace_back(fb.GetName(), fb.GetPointsCount());
+    });
+    return streets;
+  };
+
+  auto const streets = regenerateStreets(1);
+  TEST_EQUAL(streets.size(), 40, ());
+  // The features of a street are written together in place of the first feature of the street.
+  for (size_t i = 0; i < streets.size(); ++i)
+    TEST_EQUAL(streets[i].first, "Street " + std::to_string((i / 4 + 1) % 10), ());
+  TEST_EQUAL(regenerateStreets(4), streets, ());
+}
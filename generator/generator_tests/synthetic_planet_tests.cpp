@@ -0,0 +1,138 @@
+#include "testing/testing.hpp"
+
+#include "generator/osm_element.hpp"
+#include "generator/osm_source.hpp"
+#include "generator/synthetic_planet.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "coding/file_reader.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace generator;
+using platform::tests_support::ScopedFile;
+
+namespace
+{
+SyntheticPlanetParams MakeParams()
+{
+  SyntheticPlanetParams params;
+  params.m_countriesCount = 2;
+  params.m_regionsPerCountry = 2;
+  params.m_subregionsPerRegion = 1;
+  params.m_citiesPerSubregion = 1;
+  params.m_villagesPerSubregion = 1;
+  params.m_streetsPerCity = 3;
+  params.m_buildingsPerBlock = 2;
+  params.m_poisPerBlock = 1;
+  params.m_boundaryPointsPerSide = 2;
+  return params;
+}
+
+std::string ReadFile(std::string const & path)
+{
+  std::string data;
+  FileReader(path).ReadAsString(data);
+  return data;
+}
+}  // namespace
+
+UNIT_TEST(SyntheticPlanet_Generate)
+{
+  ScopedFile const file("synthetic_planet_test.o5m", ScopedFile::Mode::DoNotCreate);
+  auto const stats = GenerateSyntheticPlanet(MakeParams(), file.GetFullPath());
+
+  // 2 countries, 4 regions, 4 subregions and 4 cities.
+  TEST_EQUAL(stats.m_relations, 14, ());
+  // The boundaries, 6 streets and 8 buildings of a city.
+  TEST_EQUAL(stats.m_ways, 14 + 4 * (6 + 8), ());
+  // The boundaries, the villages and a label, 9 crossings, 32 building nodes and 4 pois of a
+  // city.
+  TEST_EQUAL(stats.m_nodes, 14 * 4 * 2 + 4 + 4 * (1 + 9 + 32 + 4), ());
+
+  std::stringstream stream(ReadFile(file.GetFullPath()));
+  SourceReader reader(stream);
+  ProcessorOsmElementsFromO5M o5mReader(reader);
+  std::vector<OsmElement> elements;
+  OsmElement element;
+  while (o5mReader.TryRead(element))
+    elements.push_back(element);
+  TEST_EQUAL(elements.size(), stats.m_nodes + stats.m_ways + stats.m_relations, ());
+
+  uint64_t nodes = 0;
+  uint64_t ways = 0;
+  uint64_t relations = 0;
+  uint64_t countries = 0;
+  uint64_t addresses = 0;
+  for (auto const & e : elements)
+  {
+    if (e.IsNode())
+    {
+      // The nodes precede the other elements and are sorted by the ids.
+      TEST_EQUAL(ways + relations, 0, ());
+      TEST_EQUAL(e.m_id, ++nodes, ());
+    }
+    else if (e.IsWay())
+    {
+      TEST_EQUAL(relations, 0, ());
+      TEST_EQUAL(e.m_id, ++ways, ());
+      for (auto const node : e.Nodes())
+        TEST(node >= 1 && node <= stats.m_nodes, (e));
+    }
+    else
+    {
+      TEST(e.IsRelation(), (e));
+      TEST_EQUAL(e.m_id, ++relations, ());
+      for (auto const & member : e.Members())
+      {
+        auto const count = member.m_type == OsmElement::EntityType::Way ? stats.m_ways
+                                                                        : stats.m_nodes;
+        TEST(member.m_ref >= 1 && member.m_ref <= count, (e));
+      }
+      if (e.GetTag("admin_level") == "2")
+      {
+        ++countries;
+        TEST(!e.GetTag("ISO3166-1").empty(), (e));
+      }
+    }
+
+    if (e.HasTag("addr:housenumber"))
+    {
+      ++addresses;
+      TEST(!e.GetTag("addr:street").empty(), (e));
+    }
+  }
+
+  TEST_EQUAL(countries, 2, ());
+  // All the buildings and some pois have the addresses.
+  TEST_GREATER_OR_EQUAL(addresses, 4 * 8, ());
+}
+
+UNIT_TEST(SyntheticPlanet_Deterministic)
+{
+  ScopedFile const file1("synthetic_planet_test1.o5m", ScopedFile::Mode::DoNotCreate);
+  ScopedFile const file2("synthetic_planet_test2.o5m", ScopedFile::Mode::DoNotCreate);
+  ScopedFile const file3("synthetic_planet_test3.o5m", ScopedFile::Mode::DoNotCreate);
+
+  auto params = MakeParams();
+  GenerateSyntheticPlanet(params, file1.GetFullPath());
+  GenerateSyntheticPlanet(params, file2.GetFullPath());
+  TEST_EQUAL(ReadFile(file1.GetFullPath()), ReadFile(file2.GetFullPath()), ());
+
+  params.m_seed += 1;
+  GenerateSyntheticPlanet(params, file3.GetFullPath());
+  TEST_NOT_EQUAL(ReadFile(file1.GetFullPath()), ReadFile(file3.GetFullPath()), ());
+
+  // The planet grows linearly with the scale.
+  auto scaled = MakeParams();
+  scaled.Scale(3);
+  auto const stats = GenerateSyntheticPlanet(scaled, file3.GetFullPath());
+  auto const baseStats = GenerateSyntheticPlanet(MakeParams(), file3.GetFullPath());
+  TEST_EQUAL(stats.m_nodes, 3 * baseStats.m_nodes, ());
+  TEST_EQUAL(stats.m_ways, 3 * baseStats.m_ways, ());
+  TEST_EQUAL(stats.m_relations, 3 * baseStats.m_relations, ());
+}
@@ -7,6 +7,7 @@
 #include "platform/platform.hpp"
 
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -55,3 +56,36 @@ UNIT_TEST(Transliteration)
   TEST(TestTransliteration(scotlandTranslations, "Шотландия", "ru"), ());
   TEST(TestTransliteration(michiganTranslations, "Мичиган", "ru"), ());
 }
+
+UNIT_TEST(Transliteration_Memoized)
+{
+  Transliteration & translit = Transliteration::Instance();
+  translit.Init(GetPlatform().ResourcesDir());
+
+  auto const ru = StringUtf8Multilang::GetLangIndex("ru");
+  std::string expected;
+  TEST(translit.Transliterate("Шотландия", ru, expected), ());
+  TEST(!expected.empty(), ());
+
+  std::vector<std::thread> threads;
+  std::vector<std::string> results(4);
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    threads.emplace_back([&translit, &results, ru, i]() {
+      for (size_t j = 0; j < 100; ++j)
+      {
+        std::string out;
+        if (!translit.Transliterate("Шотландия", ru, out) ||
+            (!results[i].empty() && out != results[i]))
+        {
+          return results[i].clear();
+        }
+        results[i] = out;
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  TEST_EQUAL(results, std::vector<std::string>(results.size(), expected), ());
+}
@@ -1,5 +1,7 @@
 #include "generator/covering_index_generator.hpp"
 #include "generator/data_version.hpp"
+#include "generator/features_reordering.hpp"
+#include "generator/features_sharding.hpp"
 #include "generator/generate_info.hpp"
 #include "generator/geo_objects/geo_objects_generator.hpp"
 #include "generator/osm_source.hpp"
@@ -7,6 +9,9 @@
 #include "generator/raw_generator.hpp"
 #include "generator/regions/collector_region_info.hpp"
 #include "generator/regions/regions.hpp"
+#include "generator/shared_resources.hpp"
+#include "generator/stages_manifest.hpp"
+#include "generator/stages_report.hpp"
 #include "generator/statistics.hpp"
 #include "generator/streets/streets.hpp"
 #include "generator/translator_collection.hpp"
@@ -21,15 +26,23 @@
 
 #include "coding/endianness.hpp"
 
+#include "base/async_logging.hpp"
 #include "base/file_name_utils.hpp"
+#include "base/memory_accounting.hpp"
+#include "base/prof.hpp"
+#include "base/scope_guard.hpp"
 
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #define BOOST_STACKTRACE_GNU_SOURCE_NOT_REQUIRED
 #include <boost/stacktrace.hpp>
@@ -48,6 +61,53 @@ char const * GetDataPathHelp()
 
   return kHelp.c_str();
 }
+
+// The parameters of a stage for the stages manifest, a new build of the generator outdates the
+// stages.
+std::string MakeStageParameters(std::vector<std::pair<std::string, std::string>> const & options)
+{
+  auto result = generator::DataVersion::GetCodeVersion();
+  for (auto const & option : options)
+    result += " " + option.first + "=" + option.second;
+  return result;
+}
+
+// The nodes/ways/relations data of the 1st pass with the changes, most of the files are optional.
+std::vector<std::string> GetIntermediateDataFiles(feature::GenerateInfo const & info)
+{
+  std::vector<std::string> files;
+  for (auto const & overlay : {"", OVERLAY_EXT})
+  {
+    for (auto const & name : {NODES_FILE, WAYS_FILE, RELATIONS_FILE})
+    {
+      for (auto const & ext : {"", OFFSET_EXT, ID2REL_EXT})
+      {
+        auto const filename = info.GetIntermediateFileName(name, overlay + std::string(ext));
+        files.push_back(filename);
+        files.push_back(filename + SUCCINCT_OFFSET_EXT);
+      }
+    }
+  }
+  files.push_back(info.GetIntermediateFileName(TOWNS_FILE));
+  files.push_back(info.GetIntermediateFileName(O5M_RESETS_FILE));
+  return files;
+}
+
+// The intermediate features file with its chunks index.
+std::vector<std::string> GetFeaturesFiles(std::string const & filename)
+{
+  if (filename.empty())
+    return {};
+  return {filename, filename + FEATURES_CHUNKS_FILE_EXTENSION};
+}
+
+std::vector<std::string> Concat(std::vector<std::vector<std::string>> const & lists)
+{
+  std::vector<std::string> result;
+  for (auto const & list : lists)
+    result.insert(result.end(), list.cbegin(), list.cend());
+  return result;
+}
 }  // namespace
 
 struct CliCommandOptions
@@ -61,21 +121,44 @@ struct CliCommandOptions
   std::string m_regions_features;
   std::string m_ids_without_addresses;
   std::string m_geo_objects_key_value;
+  std::string m_geo_objects_hierarchy;
   std::string m_regions_index;
   std::string m_regions_key_value;
+  std::string m_regions_hierarchy;
   std::string m_streets_key_value;
+  std::string m_streets_hierarchy;
   std::string m_streets_features;
   std::string m_geo_objects_features;
   std::string m_geo_objects_index;
   std::string m_key_value;
+  std::string m_apply_osm_change;
+  std::string m_stages_report;
+  std::string m_stages_manifest;
+  std::string m_profile_trace;
+  std::string m_threads_affinity;
+  unsigned int m_memory_log_period_seconds = 0;
+  bool m_async_logging = false;
+  unsigned int m_decode_threads = 0;
+  unsigned int m_translate_threads = 0;
+  unsigned int m_write_threads = 0;
+  uint64_t m_batches_memory_mb = 0;
+  unsigned int m_shards_count = 1;
+  int m_shard = -1;
+  uint64_t m_geo_data_memory_budget_mb = 0;
+  bool m_compress_features = false;
   bool m_preprocess = false;
+  bool m_succinct_offsets = false;
   bool m_generate_region_features = false;
   bool m_generate_features = false;
   bool m_generate_regions = false;
   bool m_generate_geo_objects_index = false;
   bool m_generate_regions_kv = false;
+  bool m_regions_fixed_point_polygons = false;
   bool m_generate_streets_features = false;
   bool m_generate_geo_objects_features = false;
+  bool m_reorder_features = false;
+  bool m_shard_features = false;
+  bool m_merge_shards = false;
   bool m_verbose = false;
 };
 
@@ -92,7 +175,7 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
          "Input osm area file.")
      ("osm_file_type",
          po::value(&o.m_osm_file_type)->default_value("xml"),
-         "Input osm area file type [xml, o5m].")
+         "Input osm area file type [xml, o5m, pbf].")
      ("data_path",
          po::value(&o.m_data_path)->default_value(""),
          GetDataPathHelp())
@@ -101,13 +184,38 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
          "User defined resource path for classificator.txt and etc.")
      ("node_storage",
          po::value(&o.m_node_storage)->default_value("map"),
-         "Type of storage for intermediate points representation. Available: raw, map, mem.")
+         "Type of storage for intermediate points representation. Available: raw, map, mem, compressed.")
      ("preprocess",
          po::value(&o.m_preprocess)->default_value(false),
          "1st pass - create nodes/ways/relations data.")
+     ("succinct_offsets",
+         po::value(&o.m_succinct_offsets)->default_value(false),
+         "Build mapped Elias-Fano indices of the ways/relations offsets in the 1st pass.")
+     ("apply_osm_change",
+         po::value(&o.m_apply_osm_change)->default_value(""),
+         "Apply the osmChange (.osc) diff to the nodes/ways/relations data of the 1st pass.")
      ("generate_features",
          po::value(&o.m_generate_features)->default_value(false),
          "2nd pass - generate intermediate features.")
+     ("decode_threads",
+         po::value(&o.m_decode_threads)->default_value(0),
+         "Threads decoding the osm file in the 2nd pass, 0 is a share of the cores.")
+     ("translate_threads",
+         po::value(&o.m_translate_threads)->default_value(0),
+         "Threads translating the osm elements to features in the 2nd pass, 0 is the rest of the cores.")
+     ("batches_memory_mb",
+         po::value(&o.m_batches_memory_mb)->default_value(0),
+         "Memory for the osm elements decoded and not translated yet in the 2nd pass, MB, 0 is a share of the physical memory.")
+     ("write_threads",
+         po::value(&o.m_write_threads)->default_value(0),
+         "Threads writing the intermediate features files in the 2nd pass, 0 is a share of the cores.")
+     ("compress_features",
+         po::value(&o.m_compress_features)->default_value(false),
+         "Write the intermediate features of the 2nd pass as the compressed frames.")
+     ("threads_affinity",
+         po::value(&o.m_threads_affinity)->default_value("none"),
+         "Binding of the worker threads to the CPUs [none, cores, nodes]: nodes keeps a thread "
+         "and the memory it allocates on a single NUMA node.")
      ("generate_region_features",
          po::value(&o.m_generate_region_features)->default_value(false),
          "Generate intermediate features for regions to use in regions index and borders generation.")
@@ -117,6 +225,30 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
      ("generate_geo_objects_features",
          po::value(&o.m_generate_geo_objects_features)->default_value(false),
          "Generate intermediate features for geo objects to use in geo objects index.")
+     ("reorder_features",
+         po::value(&o.m_reorder_features)->default_value(false),
+         "Reorder the generated intermediate features along the Hilbert curve, so the spatially "
+         "close features are read from the close pages.")
+     ("shards_count",
+         po::value(&o.m_shards_count)->default_value(1),
+         "Shards of the streets and geo objects features split by the countries. The streets and "
+         "geo objects key-value are generated for the shards one by one or for the given shard.")
+     ("shard_features",
+         po::value(&o.m_shard_features)->default_value(false),
+         "Split the streets and geo objects features to the shards by the regions index and "
+         "key-value.")
+     ("shard",
+         po::value(&o.m_shard)->default_value(-1),
+         "The only shard to generate the streets and geo objects key-value for, e.g. on a machine "
+         "of a cluster. All the shards are generated if it is -1.")
+     ("merge_shards",
+         po::value(&o.m_merge_shards)->default_value(false),
+         "Concatenate the streets and geo objects key-value, the ids without addresses and the "
+         "features of the shards.")
+     ("geo_data_memory_budget_mb",
+         po::value(&o.m_geo_data_memory_budget_mb)->default_value(0),
+         "Megabytes of the streets and the houses of the buildings kept in memory while the geo "
+         "objects key-value is generated, the rest is spilled to a temporary file. No limit if 0.")
      ("generate_geo_objects_index",
          po::value(&o.m_generate_geo_objects_index)->default_value(false),
          "Generate objects and index for server-side reverse geocoder.")
@@ -126,6 +258,11 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
      ("generate_regions_kv",
          po::value(&o.m_generate_regions_kv)->default_value(false),
          "Generate regions key-value for server-side reverse geocoder.")
+     ("regions_fixed_point_polygons",
+         po::value(&o.m_regions_fixed_point_polygons)->default_value(false),
+         "Keep the polygons of the built regions with the 32-bit fixed point coordinates to "
+         "halve their memory. The containment and the areas are computed in the integer "
+         "arithmetic.")
      ("nodes_list_path",
          po::value(&o.m_nodes_list_path)->default_value(""),
          "Path to file containing list of node ids we need to add to locality index. May be empty.")
@@ -135,12 +272,20 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
      ("regions_key_value",
          po::value(&o.m_regions_key_value)->default_value(""),
          "Input/Output regions key-value file.")
+     ("regions_hierarchy",
+         po::value(&o.m_regions_hierarchy)->default_value(""),
+         "Output regions binary hierarchy file which the geocoder loads instead of the regions "
+         "key-value file. Generated with the regions key-value.")
      ("streets_features",
          po::value(&o.m_streets_features)->default_value(""),
          "Input/Output tmp.mwm file with streets.")
      ("streets_key_value",
          po::value(&o.m_streets_key_value)->default_value(""),
          "Output streets key-value file.")
+     ("streets_hierarchy",
+         po::value(&o.m_streets_hierarchy)->default_value(""),
+         "Output streets binary hierarchy file which the geocoder loads instead of the streets "
+         "key-value file. Generated with the streets key-value.")
      ("geo_objects_features",
          po::value(&o.m_geo_objects_features)->default_value(""),
          "Input/Output tmp.mwm file with geo objects.")
@@ -153,6 +298,10 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
      ("geo_objects_key_value",
          po::value(&o.m_geo_objects_key_value)->default_value(""),
          "Input/Output geo objects key-value file.")
+     ("geo_objects_hierarchy",
+         po::value(&o.m_geo_objects_hierarchy)->default_value(""),
+         "Output geo objects binary hierarchy file which the geocoder loads instead of the geo "
+         "objects key-value file. Generated with the geo objects key-value.")
      ("regions_features",
          po::value(&o.m_regions_features)->default_value(""),
          "Input/Output tmp.mwm file with regions.")
@@ -162,6 +311,24 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
      ("verbose",
          po::value(&o.m_verbose)->default_value(false),
          "Provide more detailed output.")
+     ("async_logging",
+         po::value(&o.m_async_logging)->default_value(false),
+         "Write the log in a background thread. The repeated messages of a call site are rate "
+         "limited.")
+     ("stages_report",
+         po::value(&o.m_stages_report)->default_value(""),
+         "Output json file with the wall and cpu time, peak memory and io of the run stages.")
+     ("memory_log_period_seconds",
+         po::value(&o.m_memory_log_period_seconds)->default_value(0),
+         "Log the memory held by the subsystems (node storage, key-value storage, regions, "
+         "streets, geocoder index) every given number of seconds. Zero disables the log.")
+     ("stages_manifest",
+         po::value(&o.m_stages_manifest)->default_value(""),
+         "Input/Output json file with the inputs, outputs and parameters of the finished stages. "
+         "The stages which are up to date are skipped by the rerun.")
+     ("profile_trace",
+         po::value(&o.m_profile_trace)->default_value(""),
+         "Output Chrome trace json file with the profiling zones and counters of the run.")
      ("version", "get version")
      ("help", "produce help message");
 
@@ -195,6 +362,47 @@ int GeneratorToolMain(int argc, char ** argv)
 
   options = DefineOptions(argc, argv);
 
+  // Is declared first to write the log of the other scope guards.
+  std::unique_ptr<base::ScopedAsyncLogging> asyncLogging;
+  if (options.m_async_logging)
+    asyncLogging = std::make_unique<base::ScopedAsyncLogging>();
+
+  auto const & stagesReport = StagesReport::Instance();
+  SCOPE_GUARD(saveStagesReport, [&]() {
+    if (options.m_stages_report.empty())
+      return;
+    try
+    {
+      stagesReport.Save(options.m_stages_report);
+    }
+    catch (std::ios_base::failure const & e)
+    {
+      LOG(LERROR, ("Can't write stages report to", options.m_stages_report, e.what()));
+    }
+  });
+
+  std::unique_ptr<base::memory::PeriodicUsageLogger> memoryLogger;
+  if (options.m_memory_log_period_seconds != 0)
+  {
+    memoryLogger = std::make_unique<base::memory::PeriodicUsageLogger>(
+        std::chrono::seconds(options.m_memory_log_period_seconds));
+  }
+
+  base::prof::SetEnabled(!options.m_profile_trace.empty());
+  SCOPE_GUARD(saveProfileTrace, [&]() {
+    if (options.m_profile_trace.empty())
+      return;
+    try
+    {
+      base::prof::SaveChromeTrace(options.m_profile_trace);
+      LOG(LINFO, ("Profile trace has been written in", options.m_profile_trace));
+    }
+    catch (std::ios_base::failure const & e)
+    {
+      LOG(LERROR, ("Can't write profile trace to", options.m_profile_trace, e.what()));
+    }
+  });
+
   Platform & pl = GetPlatform();
 
   if (options.m_user_resource_path.empty())
@@ -232,6 +440,14 @@ int GeneratorToolMain(int argc, char ** argv)
     genInfo.SetNodeStorageType(options.m_node_storage);
   if (!options.m_osm_file_type.empty())
     genInfo.SetOsmFileType(options.m_osm_file_type);
+  genInfo.m_succinctOffsets = options.m_succinct_offsets;
+  genInfo.m_decodeThreadsCount = options.m_decode_threads;
+  genInfo.m_translateThreadsCount = options.m_translate_threads;
+  genInfo.m_writeThreadsCount = options.m_write_threads;
+  genInfo.m_batchesMemoryBudget = options.m_batches_memory_mb * 1024 * 1024;
+  genInfo.m_compressFeatures = options.m_compress_features;
+  if (!options.m_threads_affinity.empty())
+    genInfo.SetThreadsAffinity(options.m_threads_affinity);
 
   genInfo.m_osmFileName = options.m_osm_file_name;
 
@@ -243,13 +459,48 @@ int GeneratorToolMain(int argc, char ** argv)
 
   classificator::Load();
 
+  StagesManifest stagesManifest(options.m_stages_manifest);
+  auto const dataVersionFile = base::JoinPath(genInfo.m_dataPath, DataVersion::FileName());
+  auto const intermediateDataFiles = GetIntermediateDataFiles(genInfo);
+  auto const regionsFeaturesFiles = GetFeaturesFiles(options.m_regions_features);
+  auto const streetsFeaturesFiles = GetFeaturesFiles(options.m_streets_features);
+  auto const geoObjectsFeaturesFiles = GetFeaturesFiles(options.m_geo_objects_features);
+
+  auto const applyOsmChange = [&]() {
+    LOG(LINFO, ("Applying changes to intermediate data ...."));
+    ScopedStage stage("osm change");
+    return ApplyOsmChange(genInfo, options.m_apply_osm_change);
+  };
+
   // Generate intermediate files.
   if (options.m_preprocess)
   {
-    DataVersion{options.m_osm_file_name}.DumpToPath(genInfo.m_dataPath);
-
-    LOG(LINFO, ("Generating intermediate data ...."));
-    if (!GenerateIntermediateData(genInfo))
+    // The changes are applied to the new data as a part of the stage.
+    StagesManifest::Stage const manifestStage{
+        "intermediate data",
+        MakeStageParameters({{"osm_file_type", options.m_osm_file_type},
+                             {"node_storage", options.m_node_storage},
+                             {"succinct_offsets", std::to_string(options.m_succinct_offsets)},
+                             {"elements_version", std::to_string(kIntermediateElementsVersion)}}),
+        {options.m_osm_file_name, options.m_apply_osm_change},
+        Concat({intermediateDataFiles, {dataVersionFile}})};
+    bool const isSuccess = stagesManifest.Run(manifestStage, [&]() {
+      DataVersion{options.m_osm_file_name}.DumpToPath(genInfo.m_dataPath);
+
+      LOG(LINFO, ("Generating intermediate data ...."));
+      {
+        ScopedStage stage("intermediate data");
+        if (!GenerateIntermediateData(genInfo))
+          return false;
+      }
+      return options.m_apply_osm_change.empty() || applyOsmChange();
+    });
+    if (!isSuccess)
+      return EXIT_FAILURE;
+  }
+  else if (!options.m_apply_osm_change.empty())
+  {
+    if (!applyOsmChange())
       return EXIT_FAILURE;
   }
 
@@ -257,33 +508,204 @@ int GeneratorToolMain(int argc, char ** argv)
   if (options.m_generate_features || options.m_generate_region_features ||
       options.m_generate_streets_features || options.m_generate_geo_objects_features)
   {
-    RawGenerator rawGenerator(genInfo);
+    std::vector<std::string> outputs;
     if (options.m_generate_region_features)
-      rawGenerator.GenerateRegionFeatures(options.m_regions_features, regionsInfoPath);
+      outputs = Concat({outputs, regionsFeaturesFiles, {regionsInfoPath}});
     if (options.m_generate_streets_features)
-      rawGenerator.GenerateStreetsFeatures(options.m_streets_features);
+      outputs = Concat({outputs, streetsFeaturesFiles});
     if (options.m_generate_geo_objects_features)
-      rawGenerator.GenerateGeoObjectsFeatures(options.m_geo_objects_features);
-
-    if (!rawGenerator.Execute())
+      outputs = Concat({outputs, geoObjectsFeaturesFiles});
+
+    StagesManifest::Stage const manifestStage{
+        "features",
+        MakeStageParameters(
+            {{"osm_file_type", options.m_osm_file_type},
+             {"node_storage", options.m_node_storage},
+             {"compress_features", std::to_string(options.m_compress_features)},
+             {"reorder_features", std::to_string(options.m_reorder_features)},
+             {"generate_region_features", std::to_string(options.m_generate_region_features)},
+             {"generate_streets_features", std::to_string(options.m_generate_streets_features)},
+             {"generate_geo_objects_features",
+              std::to_string(options.m_generate_geo_objects_features)}}),
+        Concat({{options.m_osm_file_name}, intermediateDataFiles}), outputs};
+    bool const isSuccess = stagesManifest.Run(manifestStage, [&]() {
+      RawGenerator rawGenerator(genInfo);
+      if (options.m_generate_region_features)
+        rawGenerator.GenerateRegionFeatures(options.m_regions_features, regionsInfoPath);
+      if (options.m_generate_streets_features)
+        rawGenerator.GenerateStreetsFeatures(options.m_streets_features);
+      if (options.m_generate_geo_objects_features)
+        rawGenerator.GenerateGeoObjectsFeatures(options.m_geo_objects_features);
+
+      if (!rawGenerator.Execute())
+        return false;
+
+      if (options.m_reorder_features)
+      {
+        ScopedStage stage("reorder features");
+        if (options.m_generate_region_features)
+          ReorderFeaturesAlongHilbertCurve(options.m_regions_features, genInfo.m_threadsCount);
+        if (options.m_generate_streets_features)
+          ReorderFeaturesAlongHilbertCurve(options.m_streets_features, genInfo.m_threadsCount);
+        if (options.m_generate_geo_objects_features)
+          ReorderFeaturesAlongHilbertCurve(options.m_geo_objects_features, genInfo.m_threadsCount);
+      }
+      return true;
+    });
+    if (!isSuccess)
       return EXIT_FAILURE;
   }
 
-  if (!options.m_streets_key_value.empty())
+  auto const shardsCount = static_cast<size_t>(options.m_shards_count);
+  if (shardsCount == 0 ||
+      (options.m_shard >= 0 && static_cast<size_t>(options.m_shard) >= shardsCount))
   {
-    streets::GenerateStreets(options.m_regions_index, options.m_regions_key_value,
-                             options.m_streets_features, options.m_geo_objects_features,
-                             options.m_streets_key_value, options.m_verbose,
-                             genInfo.m_threadsCount);
+    LOG(LCRITICAL, ("Incorrect shard", options.m_shard, "of", options.m_shards_count, "shards."));
+    return EXIT_FAILURE;
   }
 
-  if (!options.m_geo_objects_key_value.empty())
+  // The streets and the geo objects key-value are generated for the shards of the features.
+  std::vector<boost::optional<size_t>> shards;
+  if (shardsCount == 1)
   {
-    if (!geo_objects::GenerateGeoObjects(
-            options.m_regions_index, options.m_regions_key_value, options.m_geo_objects_features,
-            options.m_ids_without_addresses, options.m_geo_objects_key_value, options.m_verbose,
-            genInfo.m_threadsCount))
-      return EXIT_FAILURE;
+    shards.emplace_back();
+  }
+  else if (options.m_shard >= 0)
+  {
+    shards.emplace_back(static_cast<size_t>(options.m_shard));
+  }
+  else
+  {
+    for (size_t shard = 0; shard < shardsCount; ++shard)
+      shards.emplace_back(shard);
+  }
+
+  auto const getShardPaths = [](std::vector<std::string> paths,
+                                boost::optional<size_t> const & shard) {
+    for (auto & path : paths)
+    {
+      if (shard && !path.empty())
+        path = GetShardFilename(path, *shard);
+    }
+    return paths;
+  };
+  auto const getAllShardsPaths = [&](std::vector<std::string> const & paths) {
+    std::vector<std::string> result;
+    for (size_t shard = 0; shard < shardsCount; ++shard)
+      result = Concat({result, getShardPaths(paths, shard)});
+    return result;
+  };
+
+  // The regions index and key-value are loaded once for the sharding and the streets and
+  // the geo objects stages of all the shards.
+  auto sharedResources = std::make_unique<SharedResources::Scope>();
+
+  if (options.m_shard_features)
+  {
+    std::vector<std::string> featuresFiles;
+    for (auto const & path : {options.m_geo_objects_features, options.m_streets_features})
+    {
+      if (!path.empty())
+        featuresFiles.push_back(path);
+    }
+
+    StagesManifest::Stage const manifestStage{
+        "features shards",
+        MakeStageParameters({{"shards_count", std::to_string(options.m_shards_count)}}),
+        Concat({{options.m_regions_index, options.m_regions_key_value},
+                geoObjectsFeaturesFiles, streetsFeaturesFiles}),
+        getAllShardsPaths(Concat({geoObjectsFeaturesFiles, streetsFeaturesFiles}))};
+    stagesManifest.Run(manifestStage, [&]() {
+      LOG(LINFO, ("Splitting features to", options.m_shards_count, "shards ...."));
+      ScopedStage stage("features shards");
+      ShardFeaturesByCountries(options.m_regions_index, options.m_regions_key_value,
+                               featuresFiles, shardsCount, genInfo.m_threadsCount);
+      return true;
+    });
+  }
+
+  for (auto const & shard : shards)
+  {
+    auto const shardName = shard ? " shard " + std::to_string(*shard) : std::string();
+    auto const shardStreetsFeaturesFiles = getShardPaths(streetsFeaturesFiles, shard);
+    auto const shardGeoObjectsFeaturesFiles = getShardPaths(geoObjectsFeaturesFiles, shard);
+    auto const shardStreetsFeatures = getShardPaths({options.m_streets_features}, shard)[0];
+    auto const shardGeoObjectsFeatures = getShardPaths({options.m_geo_objects_features}, shard)[0];
+
+    if (!options.m_streets_key_value.empty())
+    {
+      auto const outputs =
+          getShardPaths({options.m_streets_key_value, options.m_streets_hierarchy}, shard);
+      // The streets features are aggregated in place.
+      StagesManifest::Stage const manifestStage{
+          "streets key-value" + shardName, MakeStageParameters({}),
+          Concat({{options.m_regions_index, options.m_regions_key_value},
+                  shardStreetsFeaturesFiles, shardGeoObjectsFeaturesFiles}),
+          Concat({outputs, shardStreetsFeaturesFiles})};
+      stagesManifest.Run(manifestStage, [&]() {
+        streets::GenerateStreets(options.m_regions_index, options.m_regions_key_value,
+                                 shardStreetsFeatures, shardGeoObjectsFeatures, outputs[0],
+                                 options.m_verbose, genInfo.m_threadsCount, outputs[1]);
+        return true;
+      });
+    }
+
+    if (!options.m_geo_objects_key_value.empty())
+    {
+      auto const outputs =
+          getShardPaths({options.m_geo_objects_key_value, options.m_ids_without_addresses,
+                         options.m_geo_objects_hierarchy},
+                        shard);
+      // The addresses of the geo objects features are enriched in place.
+      StagesManifest::Stage const manifestStage{
+          "geo objects key-value" + shardName, MakeStageParameters({}),
+          Concat({{options.m_regions_index, options.m_regions_key_value},
+                  shardGeoObjectsFeaturesFiles}),
+          Concat({outputs, shardGeoObjectsFeaturesFiles})};
+      bool const isSuccess = stagesManifest.Run(manifestStage, [&]() {
+        return geo_objects::GenerateGeoObjects(
+            options.m_regions_index, options.m_regions_key_value, shardGeoObjectsFeatures,
+            outputs[1], outputs[0], options.m_geo_data_memory_budget_mb * 1024 * 1024,
+            options.m_verbose, genInfo.m_threadsCount, outputs[2]);
+      });
+      if (!isSuccess)
+        return EXIT_FAILURE;
+    }
+  }
+
+  sharedResources.reset();
+
+  if (options.m_merge_shards)
+  {
+    std::vector<std::string> files;
+    std::vector<std::string> featuresFiles;
+    for (auto const & path : {options.m_streets_key_value, options.m_geo_objects_key_value,
+                              options.m_ids_without_addresses, options.m_streets_hierarchy,
+                              options.m_geo_objects_hierarchy})
+    {
+      if (!path.empty())
+        files.push_back(path);
+    }
+    for (auto const & path : {options.m_geo_objects_features, options.m_streets_features})
+    {
+      if (!path.empty())
+        featuresFiles.push_back(path);
+    }
+
+    auto const outputs = Concat({files, geoObjectsFeaturesFiles, streetsFeaturesFiles});
+    StagesManifest::Stage const manifestStage{
+        "shards merge",
+        MakeStageParameters({{"shards_count", std::to_string(options.m_shards_count)}}),
+        getAllShardsPaths(outputs), outputs};
+    stagesManifest.Run(manifestStage, [&]() {
+      LOG(LINFO, ("Merging", options.m_shards_count, "shards ...."));
+      ScopedStage stage("shards merge");
+      for (auto const & file : files)
+        MergeShardFiles(file, shardsCount);
+      for (auto const & file : featuresFiles)
+        MergeShardFeatures(file, shardsCount);
+      return true;
+    });
   }
 
   if (options.m_generate_geo_objects_index)
@@ -299,16 +721,29 @@ int GeneratorToolMain(int argc, char ** argv)
     auto const streetsFeaturesPath =
         boost::make_optional(!options.m_streets_features.empty(), options.m_streets_features);
 
-    LOG(LINFO, ("Saving geo objects index to", options.m_geo_objects_index));
-    if (!GenerateGeoObjectsIndex(options.m_geo_objects_index, options.m_geo_objects_features,
-                                 genInfo.m_threadsCount, nodesListPath, streetsFeaturesPath))
-    {
-      LOG(LCRITICAL, ("Error generating geo objects index."));
+    StagesManifest::Stage const manifestStage{
+        "geo objects index", MakeStageParameters({}),
+        Concat({geoObjectsFeaturesFiles, streetsFeaturesFiles,
+                {options.m_nodes_list_path, dataVersionFile}}),
+        {options.m_geo_objects_index}};
+    bool const isSuccess = stagesManifest.Run(manifestStage, [&]() {
+      LOG(LINFO, ("Saving geo objects index to", options.m_geo_objects_index));
+      {
+        ScopedStage stage("geo objects index");
+        if (!GenerateGeoObjectsIndex(options.m_geo_objects_index, options.m_geo_objects_features,
+                                     genInfo.m_threadsCount, nodesListPath, streetsFeaturesPath))
+        {
+          LOG(LCRITICAL, ("Error generating geo objects index."));
+          return false;
+        }
+      }
+
+      WriteDataVersionSection(options.m_geo_objects_index,
+                              DataVersion::LoadFromPath(genInfo.m_dataPath).GetVersionJson());
+      return true;
+    });
+    if (!isSuccess)
       return EXIT_FAILURE;
-    }
-
-    WriteDataVersionSection(options.m_geo_objects_index,
-                            DataVersion::LoadFromPath(genInfo.m_dataPath).GetVersionJson());
   }
 
   if (options.m_generate_regions)
@@ -319,30 +754,56 @@ int GeneratorToolMain(int argc, char ** argv)
       return EXIT_FAILURE;
     }
 
-    LOG(LINFO, ("Saving regions index to", options.m_regions_index));
-    if (!GenerateRegionsIndex(options.m_regions_index, options.m_regions_features,
-                              genInfo.m_threadsCount))
-    {
-      LOG(LCRITICAL, ("Error generating regions index."));
+    StagesManifest::Stage const manifestStage{
+        "regions index", MakeStageParameters({}),
+        Concat({regionsFeaturesFiles, {dataVersionFile}}), {options.m_regions_index}};
+    bool const isSuccess = stagesManifest.Run(manifestStage, [&]() {
+      LOG(LINFO, ("Saving regions index to", options.m_regions_index));
+      {
+        ScopedStage stage("regions index");
+        if (!GenerateRegionsIndex(options.m_regions_index, options.m_regions_features,
+                                  genInfo.m_threadsCount))
+        {
+          LOG(LCRITICAL, ("Error generating regions index."));
+          return false;
+        }
+      }
+
+      LOG(LINFO, ("Saving regions borders to", options.m_regions_index));
+      {
+        ScopedStage stage("regions borders");
+        if (!GenerateBorders(options.m_regions_index, options.m_regions_features))
+        {
+          LOG(LCRITICAL, ("Error generating regions borders."));
+          return false;
+        }
+      }
+
+      WriteDataVersionSection(options.m_regions_index,
+                              DataVersion::LoadFromPath(genInfo.m_dataPath).GetVersionJson());
+      return true;
+    });
+    if (!isSuccess)
       return EXIT_FAILURE;
-    }
-
-    LOG(LINFO, ("Saving regions borders to", options.m_regions_index));
-    if (!GenerateBorders(options.m_regions_index, options.m_regions_features))
-    {
-      LOG(LCRITICAL, ("Error generating regions borders."));
-      return EXIT_FAILURE;
-    }
-
-    WriteDataVersionSection(options.m_regions_index,
-                            DataVersion::LoadFromPath(genInfo.m_dataPath).GetVersionJson());
   }
 
   if (options.m_generate_regions_kv)
   {
-    regions::GenerateRegions(options.m_regions_features, regionsInfoPath,
-                             options.m_regions_key_value, options.m_verbose,
-                             genInfo.m_threadsCount);
+    // The regions features are repacked in place.
+    StagesManifest::Stage const manifestStage{
+        "regions key-value",
+        MakeStageParameters({{"regions_fixed_point_polygons",
+                               std::to_string(options.m_regions_fixed_point_polygons)}}),
+        Concat({regionsFeaturesFiles, {regionsInfoPath}}),
+        Concat({{options.m_regions_key_value, options.m_regions_hierarchy},
+                regionsFeaturesFiles})};
+    stagesManifest.Run(manifestStage, [&]() {
+      regions::GenerateRegions(options.m_regions_features, regionsInfoPath,
+                               options.m_regions_key_value, options.m_verbose,
+                               genInfo.m_threadsCount, options.m_regions_fixed_point_polygons,
+                               options.m_regions_hierarchy);
+      return true;
+    });
   }
 
   return 0;
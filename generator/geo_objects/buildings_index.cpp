@@ -0,0 +1,97 @@
+#include "generator/geo_objects/buildings_index.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace generator
+{
+namespace geo_objects
+{
+namespace
+{
+class StringsInterner
+{
+public:
+  explicit StringsInterner(std::string & strings) : m_strings(strings)
+  {
+    m_strings.assign(1, '\0');
+    m_offsets.emplace(std::string{}, BuildingsIndex::kEmptyString);
+  }
+
+  uint32_t Intern(std::string const & s)
+  {
+    auto const it = m_offsets.find(s);
+    if (it != m_offsets.end())
+      return it->second;
+
+    CHECK_LESS(m_strings.size() + s.size(), std::numeric_limits<uint32_t>::max(), ());
+    auto const offset = static_cast<uint32_t>(m_strings.size());
+    m_strings.append(s.c_str(), s.size() + 1);
+    m_offsets.emplace(s, offset);
+    return offset;
+  }
+
+private:
+  std::string & m_strings;
+  std::unordered_map<std::string, uint32_t> m_offsets;
+};
+}  // namespace
+
+// static
+uint32_t constexpr BuildingsIndex::kEmptyString;
+
+BuildingsIndex::BuildingsIndex(GeoIndex const & geoIndex, GeoId2GeoData && geoId2GeoData)
+{
+  CHECK_LESS(geoId2GeoData.Size(), std::numeric_limits<uint32_t>::max(), ());
+  m_buildings.reserve(geoId2GeoData.Size());
+  {
+    StringsInterner interner{m_strings};
+    geoId2GeoData.ForEach([&](base::GeoObjectId id, GeoObjectData const & data) {
+      m_buildings.push_back({id, data.m_regionId, interner.Intern(data.m_street),
+                             interner.Intern(data.m_house)});
+    });
+  }
+  geoId2GeoData = {};
+  m_strings.shrink_to_fit();
+
+  std::sort(m_buildings.begin(), m_buildings.end(),
+            [](Building const & l, Building const & r) { return l.m_id < r.m_id; });
+
+  geoIndex.ForEachCell([this](uint64_t cell, base::GeoObjectId const & id) {
+    auto const building = Find(id);
+    if (!building)
+      return;
+
+    m_cells.push_back(cell);
+    m_cellBuildings.push_back(static_cast<uint32_t>(building - m_buildings.data()));
+  });
+  CHECK(std::is_sorted(m_cells.begin(), m_cells.end()), ());
+  m_cells.shrink_to_fit();
+  m_cellBuildings.shrink_to_fit();
+
+  LOG(LINFO, ("Buildings index:", m_buildings.size(), "buildings,", m_cells.size(), "cells,",
+              m_strings.size(), "bytes of strings"));
+}
+
+BuildingsIndex::Building const * BuildingsIndex::Find(base::GeoObjectId id) const
+{
+  auto const it = std::lower_bound(m_buildings.begin(), m_buildings.end(), id,
+                                   [](Building const & b, base::GeoObjectId id) {
+                                     return b.m_id < id;
+                                   });
+  if (it == m_buildings.end() || it->m_id != id)
+    return nullptr;
+
+  return &*it;
+}
+
+GeoObjectData BuildingsIndex::GetGeoData(Building const & building) const
+{
+  return {GetString(building.m_street), GetString(building.m_house), building.m_regionId};
+}
+}  // namespace geo_objects
+}  // namespace generator
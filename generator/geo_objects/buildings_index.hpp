@@ -0,0 +1,87 @@
+#pragma once
+
+#include "generator/geo_objects/geo_data_table.hpp"
+
+#include "indexer/covering_index.hpp"
+
+#include "coding/reader.hpp"
+
+#include "geometry/point2d.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+namespace geo_objects
+{
+// An in-memory index of the buildings and the houses with their address data. The addresses
+// are packed in the entries sorted by id with the interned streets and houses. The cells of
+// the entries are copied from the geo objects index into the arrays sorted by cell, so the point
+// lookups are binary searches in memory instead of decoding the index for each point.
+// The lookups return the same objects in the same order as the geo objects index does.
+class BuildingsIndex
+{
+public:
+  using GeoIndex = indexer::GeoObjectsIndex<ReaderPtr<Reader>>;
+  using GeoId2GeoData = GeoDataTable;
+
+  struct Building
+  {
+    bool HasStreet() const { return m_street != kEmptyString; }
+    bool HasHouse() const { return m_house != kEmptyString; }
+
+    base::GeoObjectId m_id;
+    base::GeoObjectId m_regionId;
+    // Offsets in the strings.
+    uint32_t m_street;
+    uint32_t m_house;
+  };
+
+  static uint32_t constexpr kEmptyString = 0;
+
+  BuildingsIndex() = default;
+  // Packs |geoId2GeoData| and the cells of its objects in |geoIndex|.
+  BuildingsIndex(GeoIndex const & geoIndex, GeoId2GeoData && geoId2GeoData);
+
+  size_t Size() const { return m_buildings.size(); }
+
+  Building const * Find(base::GeoObjectId id) const;
+  char const * GetString(uint32_t offset) const { return m_strings.data() + offset; }
+  GeoObjectData GetGeoData(Building const & building) const;
+
+  // Returns the first building at |point| that satisfies |pred| in the order of
+  // GeoIndex::ForEachAtPoint() or nullptr.
+  template <typename Pred>
+  Building const * FindAtPoint(m2::PointD const & point, Pred && pred) const
+  {
+    for (auto const & interval : GeoIndex::GetRectIntervals(m2::RectD(point, point)))
+    {
+      auto const beg = static_cast<uint64_t>(interval.first);
+      auto const end = static_cast<uint64_t>(interval.second);
+      auto it = std::lower_bound(m_cells.begin(), m_cells.end(), beg);
+      for (; it != m_cells.end() && *it < end; ++it)
+      {
+        auto const & building = m_buildings[m_cellBuildings[it - m_cells.begin()]];
+        if (pred(building))
+          return &building;
+      }
+    }
+
+    return nullptr;
+  }
+
+private:
+  std::vector<Building> m_buildings;
+  // Zero-terminated strings, the first one is the empty string.
+  std::string m_strings;
+  // Cells and the indices of their buildings sorted by cell.
+  std::vector<uint64_t> m_cells;
+  std::vector<uint32_t> m_cellBuildings;
+};
+}  // namespace geo_objects
+}  // namespace generator
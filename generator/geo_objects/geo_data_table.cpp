@@ -0,0 +1,189 @@
+#include "generator/geo_objects/geo_data_table.hpp"
+
+#include "platform/platform.hpp"
+
+#include "coding/byte_stream.hpp"
+#include "coding/varint.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace generator
+{
+namespace geo_objects
+{
+namespace
+{
+size_t constexpr kMinCapacity = 16;
+
+// The finalizer of MurmurHash3, the encoded ids differ mostly in the low bits and the type bits.
+uint64_t Hash(uint64_t key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+// The load factor is at most 3/4.
+size_t GetCapacity(size_t count)
+{
+  size_t capacity = kMinCapacity;
+  while (capacity / 4 * 3 < count)
+    capacity *= 2;
+  return capacity;
+}
+
+template <typename Sink>
+void WriteString(Sink & sink, std::string const & s)
+{
+  WriteVarUint(sink, static_cast<uint64_t>(s.size()));
+  sink.Write(s.data(), s.size());
+}
+
+std::string ReadString(ArrayByteSource & source)
+{
+  auto const size = ReadVarUint<uint64_t>(source);
+  std::string s(source.PtrC(), static_cast<size_t>(size));
+  source.Advance(static_cast<size_t>(size));
+  return s;
+}
+}  // namespace
+
+// GeoDataTable::SpilledPool -----------------------------------------------------------------------
+GeoDataTable::SpilledPool::SpilledPool(std::string const & filename)
+  : m_filename(filename)
+  , m_writer(std::make_unique<FileWriter>(filename, FileWriter::Op::OP_WRITE_TRUNCATE))
+{
+}
+
+GeoDataTable::SpilledPool::~SpilledPool()
+{
+  m_reader.reset();
+  m_writer.reset();
+  Platform::RemoveFileIfExists(m_filename);
+}
+
+char const * GeoDataTable::SpilledPool::GetData(uint64_t offset)
+{
+  if (!m_reader || m_reader->Size() <= offset)
+  {
+    m_writer->Flush();
+    m_reader = std::make_unique<MmapReader>(m_filename);
+  }
+
+  CHECK_LESS(offset, m_reader->Size(), (m_filename));
+  return static_cast<char const *>(m_reader->GetDirectData()) + offset;
+}
+
+// GeoDataTable ------------------------------------------------------------------------------------
+GeoDataTable::GeoDataTable(std::string const & poolFilename, uint64_t poolMemoryBudget)
+  : m_poolFilename(poolFilename)
+  , m_poolMemoryBudget(poolMemoryBudget)
+{
+}
+
+void GeoDataTable::Reserve(size_t count)
+{
+  auto const capacity = GetCapacity(count);
+  if (capacity > m_slots.size())
+    Rehash(capacity);
+}
+
+void GeoDataTable::Insert(base::GeoObjectId id, GeoObjectData const & data)
+{
+  auto const encodedId = id.GetEncodedId();
+  CHECK_NOT_EQUAL(encodedId, base::GeoObjectId::kInvalid, ());
+
+  if (m_slots.size() / 4 * 3 <= m_size)
+    Rehash(GetCapacity(m_size + 1));
+
+  auto & slot = m_slots[FindSlot(encodedId)];
+  if (slot.m_id != base::GeoObjectId::kInvalid)
+    return;
+
+  slot.m_id = encodedId;
+  slot.m_regionId = data.m_regionId.GetEncodedId();
+  slot.m_offset = AppendToPool(data);
+  ++m_size;
+}
+
+boost::optional<GeoObjectData> GeoDataTable::Find(base::GeoObjectId id) const
+{
+  if (m_slots.empty())
+    return {};
+
+  auto const & slot = m_slots[FindSlot(id.GetEncodedId())];
+  if (slot.m_id == base::GeoObjectId::kInvalid)
+    return {};
+
+  return GetData(slot);
+}
+
+size_t GeoDataTable::FindSlot(uint64_t id) const
+{
+  auto const mask = m_slots.size() - 1;
+  auto index = static_cast<size_t>(Hash(id)) & mask;
+  while (m_slots[index].m_id != base::GeoObjectId::kInvalid && m_slots[index].m_id != id)
+    index = (index + 1) & mask;
+  return index;
+}
+
+void GeoDataTable::Rehash(size_t capacity)
+{
+  std::vector<Slot> slots(capacity);
+  std::swap(m_slots, slots);
+  for (auto const & slot : slots)
+  {
+    if (slot.m_id != base::GeoObjectId::kInvalid)
+      m_slots[FindSlot(slot.m_id)] = slot;
+  }
+}
+
+uint64_t GeoDataTable::AppendToPool(GeoObjectData const & data)
+{
+  auto const offset = m_poolSize;
+  if (m_spilledPool)
+  {
+    auto & writer = m_spilledPool->GetWriter();
+    WriteString(writer, data.m_street);
+    WriteString(writer, data.m_house);
+    m_poolSize = writer.Pos();
+    return offset;
+  }
+
+  PushBackByteSink<std::string> sink(m_pool);
+  WriteString(sink, data.m_street);
+  WriteString(sink, data.m_house);
+  m_poolSize = m_pool.size();
+
+  if (m_poolMemoryBudget != 0 && m_poolSize > m_poolMemoryBudget && !m_poolFilename.empty())
+  {
+    LOG(LINFO, ("Geo data pool of", m_poolSize, "bytes for", m_size + 1, "objects is spilled to",
+                m_poolFilename));
+    m_spilledPool = std::make_unique<SpilledPool>(m_poolFilename);
+    m_spilledPool->GetWriter().Write(m_pool.data(), m_pool.size());
+    m_pool = {};
+  }
+
+  return offset;
+}
+
+GeoObjectData GeoDataTable::GetData(Slot const & slot) const
+{
+  auto const data =
+      m_spilledPool ? m_spilledPool->GetData(slot.m_offset) : m_pool.data() + slot.m_offset;
+  ArrayByteSource source(data);
+  GeoObjectData geoData;
+  geoData.m_street = ReadString(source);
+  geoData.m_house = ReadString(source);
+  geoData.m_regionId = base::GeoObjectId(slot.m_regionId);
+  return geoData;
+}
+}  // namespace geo_objects
+}  // namespace generator
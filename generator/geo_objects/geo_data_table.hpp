@@ -0,0 +1,108 @@
+#pragma once
+
+#include "coding/file_writer.hpp"
+#include "coding/mmap_reader.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace generator
+{
+namespace geo_objects
+{
+struct GeoObjectData
+{
+  std::string m_street;
+  std::string m_house;
+  base::GeoObjectId m_regionId;
+};
+
+// A compact hash table of the address data of the buildings and the houses by their ids.
+// The slots of the open addressing with the linear probing keep the encoded ids, the regions ids
+// and the offsets of the streets and the houses in an append-only pool. The pool is kept in
+// memory while it fits the memory budget, then it is moved to a file and the next strings are
+// appended to the file, which is mapped into memory to read them.
+// The table is not thread safe, the lookups must not be concurrent with each other either.
+class GeoDataTable
+{
+public:
+  // The pool is always kept in memory.
+  GeoDataTable() = default;
+  // The pool is moved to |poolFilename| when it exceeds |poolMemoryBudget| bytes, zero budget
+  // means no limit. The file is removed with the table.
+  GeoDataTable(std::string const & poolFilename, uint64_t poolMemoryBudget);
+
+  GeoDataTable(GeoDataTable &&) = default;
+  GeoDataTable & operator=(GeoDataTable &&) = default;
+
+  size_t Size() const { return m_size; }
+  bool Empty() const { return m_size == 0; }
+  bool IsPoolSpilled() const { return m_spilledPool != nullptr; }
+
+  void Reserve(size_t count);
+  // Does nothing if |id| is already in the table as std::unordered_map::insert() does.
+  void Insert(base::GeoObjectId id, GeoObjectData const & data);
+
+  boost::optional<GeoObjectData> Find(base::GeoObjectId id) const;
+
+  // Calls |toDo| with the id and the data of each object in the order of the slots.
+  template <typename ToDo>
+  void ForEach(ToDo && toDo) const
+  {
+    for (auto const & slot : m_slots)
+    {
+      if (slot.m_id != base::GeoObjectId::kInvalid)
+        toDo(base::GeoObjectId(slot.m_id), GetData(slot));
+    }
+  }
+
+private:
+  struct Slot
+  {
+    uint64_t m_id = base::GeoObjectId::kInvalid;
+    uint64_t m_regionId = base::GeoObjectId::kInvalid;
+    uint64_t m_offset = 0;
+  };
+
+  class SpilledPool
+  {
+  public:
+    explicit SpilledPool(std::string const & filename);
+    ~SpilledPool();
+
+    FileWriter & GetWriter() { return *m_writer; }
+    // Returns the data at |offset| of the file with all the written data.
+    char const * GetData(uint64_t offset);
+
+  private:
+    std::string m_filename;
+    std::unique_ptr<FileWriter> m_writer;
+    std::unique_ptr<MmapReader> m_reader;
+  };
+
+  // Returns the index of the slot of |id| or of the empty slot where it has to be inserted.
+  size_t FindSlot(uint64_t id) const;
+  void Rehash(size_t capacity);
+
+  uint64_t AppendToPool(GeoObjectData const & data);
+  GeoObjectData GetData(Slot const & slot) const;
+
+  // The size is zero or a power of two.
+  std::vector<Slot> m_slots;
+  size_t m_size = 0;
+
+  std::string m_pool;
+  uint64_t m_poolSize = 0;
+  std::string m_poolFilename;
+  uint64_t m_poolMemoryBudget = 0;
+  std::unique_ptr<SpilledPool> m_spilledPool;
+};
+}  // namespace geo_objects
+}  // namespace generator
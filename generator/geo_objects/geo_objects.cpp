@@ -14,6 +14,9 @@
 #include "indexer/classificator.hpp"
 #include "indexer/covering_index.hpp"
 
+#include "platform/platform.hpp"
+
+#include "coding/file_writer.hpp"
 #include "coding/files_merger.hpp"
 #include "coding/internal/file_data.hpp"
 #include "coding/mmap_reader.hpp"
@@ -27,10 +30,11 @@
 #include <cstdint>
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
-#include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
 
 using namespace feature;
@@ -39,8 +43,22 @@ namespace generator
 {
 namespace geo_objects
 {
+using Building = BuildingsIndex::Building;
+
+namespace
+{
+// Returns nullptr if the binary hierarchy is not written.
+std::shared_ptr<KeyValueConcurrentFile> MakeHierarchyFile(std::string const & hierarchyPath)
+{
+  if (hierarchyPath.empty())
+    return {};
+  return std::make_shared<KeyValueConcurrentFile>(hierarchyPath);
+}
+}  // namespace
+
 // BufferedCuncurrentUnorderedMapUpdater -----------------------------------------------------------
-template <typename Key, typename Value>
+// Updates std::unordered_map, base::FlatHashMap or GeoDataTable.
+template <typename Key, typename Value, typename Map = std::unordered_map<Key, Value>>
 class BufferedCuncurrentUnorderedMapUpdater
 {
 public:
@@ -48,8 +66,7 @@ public:
   // Max size for try-lock flushing into target.
   static constexpr size_t kValuesBufferSizeMax{100'000};
 
-  BufferedCuncurrentUnorderedMapUpdater(std::unordered_map<Key, Value> & map,
-                                        std::mutex & mapMutex)
+  BufferedCuncurrentUnorderedMapUpdater(Map & map, std::mutex & mapMutex)
     : m_map{map}
     , m_mapMutex{mapMutex}
   { }
@@ -72,7 +89,17 @@ public:
   }
 
 private:
-  using MapValue = typename std::unordered_map<Key, Value>::value_type;
+  using MapValue = std::pair<Key, Value>;
+
+  template <typename HashMap>
+  static void Insert(HashMap & map, MapValue && value)
+  {
+    map.insert(std::move(value));
+  }
+  static void Insert(GeoDataTable & table, MapValue && value)
+  {
+    table.Insert(value.first, value.second);
+  }
 
   void FlushBuffer(bool force)
   {
@@ -87,13 +114,13 @@ private:
       return;
 
     for (auto & value : m_valuesBuffer)
-      m_map.insert(std::move(value));
+      Insert(m_map, std::move(value));
     lock.unlock();
 
     m_valuesBuffer.clear();
   }
 
-  std::unordered_map<Key, Value> & m_map;
+  Map & m_map;
   std::mutex & m_mapMutex;
   std::vector<MapValue> m_valuesBuffer;
 };
@@ -106,25 +133,27 @@ public:
   BuildingsAndHousesGenerator & operator=(BuildingsAndHousesGenerator const &) = delete;
 
   BuildingsAndHousesGenerator(
-      std::string const & geoObjectKeyValuePath, GeoObjectMaintainer & geoObjectMaintainer,
-      RegionInfoLocater const & regionInfoLocater)
+      std::string const & geoObjectKeyValuePath, std::string const & geoObjectHierarchyPath,
+      GeoObjectMaintainer & geoObjectMaintainer, RegionInfoLocater const & regionInfoLocater)
     : m_geoObjectKeyValuePath{geoObjectKeyValuePath}
+    , m_geoObjectHierarchyPath{geoObjectHierarchyPath}
     , m_geoObjectMaintainer{geoObjectMaintainer}
     , m_regionInfoLocater{regionInfoLocater}
   {
   }
 
-  void GenerateBuildingsAndHouses(
-      std::string const & geoObjectsTmpMwmPath, unsigned int threadsCount)
+  void GenerateBuildingsAndHouses(std::string const & geoObjectsTmpMwmPath,
+                                  uint64_t geoDataMemoryBudget, unsigned int threadsCount)
   {
-    GeoId2GeoData geoId2GeoData;
-    uint64_t const fileSize = boost::filesystem::file_size(geoObjectsTmpMwmPath);
-    geoId2GeoData.reserve(std::min(uint64_t{500'000'000}, fileSize / 10));
+    // The table grows by rehashing, the estimate by the file size would reserve too much.
+    GeoId2GeoData geoId2GeoData{GetPlatform().TmpPathForFile(), geoDataMemoryBudget};
 
     std::mutex geoId2GeoDataMutex;
 
+    auto const kvFile = std::make_shared<KeyValueConcurrentFile>(m_geoObjectKeyValuePath);
+    auto const hierarchyFile = MakeHierarchyFile(m_geoObjectHierarchyPath);
     feature::ProcessParallelFromDatRawFormat(threadsCount, geoObjectsTmpMwmPath, [&] {
-      return Processor{*this, m_geoObjectKeyValuePath, geoId2GeoData, geoId2GeoDataMutex};
+      return Processor{*this, kvFile, hierarchyFile, geoId2GeoData, geoId2GeoDataMutex};
     });
 
     m_geoObjectMaintainer.SetGeoData(std::move(geoId2GeoData));
@@ -138,12 +167,15 @@ private:
   {
   public:
     Processor(BuildingsAndHousesGenerator & generator,
-              std::string const & geoObjectKeyValuePath,
+              std::shared_ptr<KeyValueConcurrentFile> const & kvFile,
+              std::shared_ptr<KeyValueConcurrentFile> const & hierarchyFile,
               GeoId2GeoData & geoId2GeoData, std::mutex & geoId2GeoDataMutex)
       : m_generator{generator}
-      , m_kvWriter{geoObjectKeyValuePath}
+      , m_kvWriter{kvFile}
       , m_geoDataCache{geoId2GeoData, geoId2GeoDataMutex}
     {
+      if (hierarchyFile)
+        m_kvWriter.SetHierarchyFile(hierarchyFile);
     }
 
     void operator()(FeatureBuilder & fb, uint64_t /* currPos */)
@@ -163,10 +195,11 @@ private:
     void WriteIntoKv(FeatureBuilder & fb, KeyValue const & regionKeyValue)
     {
       auto const id = fb.GetMostGenericOsmId();
-      auto jsonValue = AddAddress(fb.GetParams().GetStreet(), fb.GetParams().house.Get(),
-                                  fb.GetKeyPoint(), fb.GetMultilangName(), regionKeyValue);
+      auto const value =
+          AddAddressPatch(fb.GetParams().GetStreet(), fb.GetParams().house.Get(),
+                          fb.GetKeyPoint(), fb.GetMultilangName(), regionKeyValue);
 
-      m_kvWriter.Write(id, JsonValue{std::move(jsonValue)});
+      m_kvWriter.Write(id, value);
     }
 
     void CacheGeoData(FeatureBuilder & fb, KeyValue const & regionKeyValue)
@@ -179,22 +212,25 @@ private:
 
     BuildingsAndHousesGenerator & m_generator;
     KeyValueConcurrentWriter m_kvWriter;
-    BufferedCuncurrentUnorderedMapUpdater<base::GeoObjectId, GeoObjectData> m_geoDataCache;
+    BufferedCuncurrentUnorderedMapUpdater<base::GeoObjectId, GeoObjectData, GeoId2GeoData>
+        m_geoDataCache;
   };
 
   std::string m_geoObjectKeyValuePath;
+  std::string m_geoObjectHierarchyPath;
   GeoObjectMaintainer & m_geoObjectMaintainer;
   RegionInfoLocater const & m_regionInfoLocater;
 };
 
 void AddBuildingsAndThingsWithHousesThenEnrichAllWithRegionAddresses(
-    std::string const & geoObjectKeyValuePath,  GeoObjectMaintainer & geoObjectMaintainer,
-    std::string const & pathInGeoObjectsTmpMwm, RegionInfoLocater const & regionInfoLocater,
-    bool /*verbose*/, unsigned int threadsCount)
+    std::string const & geoObjectKeyValuePath, std::string const & geoObjectHierarchyPath,
+    GeoObjectMaintainer & geoObjectMaintainer, std::string const & pathInGeoObjectsTmpMwm,
+    RegionInfoLocater const & regionInfoLocater, uint64_t geoDataMemoryBudget, bool /*verbose*/,
+    unsigned int threadsCount)
 {
-  auto && generator =
-      BuildingsAndHousesGenerator{geoObjectKeyValuePath, geoObjectMaintainer, regionInfoLocater};
-  generator.GenerateBuildingsAndHouses(pathInGeoObjectsTmpMwm, threadsCount);
+  auto && generator = BuildingsAndHousesGenerator{geoObjectKeyValuePath, geoObjectHierarchyPath,
+                                                  geoObjectMaintainer, regionInfoLocater};
+  generator.GenerateBuildingsAndHouses(pathInGeoObjectsTmpMwm, geoDataMemoryBudget, threadsCount);
   LOG(LINFO, ("Added", geoObjectMaintainer.Size(), "geo objects with addresses."));
 }
 
@@ -203,9 +239,11 @@ class NullBuildingsAddressing
 {
 public:
   NullBuildingsAddressing(std::string const & geoObjectsTmpMwmPath,
+                          std::string const & buildingsFeaturesPath,
                           GeoObjectMaintainer & geoObjectMaintainer,
                           unsigned int threadsCount)
     : m_geoObjectsTmpMwmPath{geoObjectsTmpMwmPath}
+    , m_buildingsFeaturesPath{buildingsFeaturesPath}
     , m_geoObjectMaintainer{geoObjectMaintainer}
     , m_threadsCount{threadsCount}
   {
@@ -242,23 +280,21 @@ private:
 
       // search for ids of Buildinds not stored with geoObjectsMantainer
       // they are nullBuildings
-      auto const buildingId =
-          m_goObjectsView.SearchIdOfFirstMatchedObject(fb.GetKeyPoint(), [&](base::GeoObjectId id) {
-            auto const & geoData = m_goObjectsView.GetGeoData(id);
-            return geoData && geoData->m_house.empty();
-          });
+      auto const building = m_goObjectsView.SearchFirstMatchedBuilding(
+          fb.GetKeyPoint(), [](Building const & building) { return !building.HasHouse(); });
 
-      if (!buildingId)
+      if (!building)
         return;
 
       auto const id = fb.GetMostGenericOsmId();
-      m_addressPoints2Buildings.Emplace(id, *buildingId);
-      m_buildings2AddressPoints.Emplace(*buildingId, id);
+      m_addressPoints2Buildings.Emplace(id, building->m_id);
+      m_buildings2AddressPoints.Emplace(building->m_id, id);
     }
 
   private:
-    using Updater =
-        BufferedCuncurrentUnorderedMapUpdater<base::GeoObjectId, base::GeoObjectId>;
+    using Updater = BufferedCuncurrentUnorderedMapUpdater<
+        base::GeoObjectId, base::GeoObjectId,
+        base::FlatHashMap<base::GeoObjectId, base::GeoObjectId>>;
 
     GeoObjectMaintainer::GeoObjectsView m_goObjectsView;
     Updater m_addressPoints2Buildings;
@@ -358,7 +394,7 @@ private:
 
   void FillBuildingsInfo()
   {
-    feature::ProcessParallelFromDatRawFormat(m_threadsCount, m_geoObjectsTmpMwmPath, [&] {
+    feature::ProcessParallelFromDatRawFormat(m_threadsCount, m_buildingsFeaturesPath, [&] {
       return BuildingsInfoFiller{*this};
     });
 
@@ -370,7 +406,7 @@ private:
 
   void FillBuildingsGeometries()
   {
-    feature::ProcessParallelFromDatRawFormat(m_threadsCount, m_geoObjectsTmpMwmPath, [&] {
+    feature::ProcessParallelFromDatRawFormat(m_threadsCount, m_buildingsFeaturesPath, [&] {
       return BuildingsGeometriesFiller{*this};
     });
 
@@ -394,6 +430,7 @@ private:
   }
 
   std::string m_geoObjectsTmpMwmPath;
+  std::string m_buildingsFeaturesPath;
   GeoObjectMaintainer & m_geoObjectMaintainer;
   unsigned int m_threadsCount;
 
@@ -407,10 +444,11 @@ private:
 
 NullBuildingsInfo EnrichPointsWithOuterBuildingGeometry(GeoObjectMaintainer & geoObjectMaintainer,
                                                         std::string const & pathInGeoObjectsTmpMwm,
+                                                        std::string const & buildingsFeaturesPath,
                                                         unsigned int threadsCount)
 {
-  auto && addressing =
-      NullBuildingsAddressing{pathInGeoObjectsTmpMwm, geoObjectMaintainer, threadsCount};
+  auto && addressing = NullBuildingsAddressing{pathInGeoObjectsTmpMwm, buildingsFeaturesPath,
+                                               geoObjectMaintainer, threadsCount};
   addressing.AddAddresses();
   return addressing.GetNullBuildingsInfo();
 }
@@ -420,12 +458,14 @@ class PoisAddressEnricher
 {
 public:
   PoisAddressEnricher(std::string geoObjectKeyValuePath,
+                      std::string const & geoObjectHierarchyPath,
                       std::string const & geoObjectsTmpMwmPath,
                       std::string const & localityIndexedPoiIdsPath,
                       GeoObjectMaintainer & geoObjectMaintainer,
                       NullBuildingsInfo const & buildingsInfo,
                       unsigned int threadsCount)
     : m_geoObjectKeyValuePath{geoObjectKeyValuePath}
+    , m_geoObjectHierarchyPath{geoObjectHierarchyPath}
     , m_geoObjectsTmpMwmPath{geoObjectsTmpMwmPath}
     , m_localityIndexedPoiIdsPath{localityIndexedPoiIdsPath}
     , m_geoObjectMaintainer{geoObjectMaintainer}
@@ -438,8 +478,10 @@ public:
   {
     auto poiIdsFilesMerger = FilesMerger(m_localityIndexedPoiIdsPath);
     auto && poisAddressEnrichedStat = std::atomic_size_t{0};
+    auto const kvFile = std::make_shared<KeyValueConcurrentFile>(m_geoObjectKeyValuePath);
+    auto const hierarchyFile = MakeHierarchyFile(m_geoObjectHierarchyPath);
     feature::ProcessParallelFromDatRawFormat(m_threadsCount, m_geoObjectsTmpMwmPath, [&] {
-      return Processor{*this, poiIdsFilesMerger, poisAddressEnrichedStat};
+      return Processor{*this, kvFile, hierarchyFile, poiIdsFilesMerger, poisAddressEnrichedStat};
     });
     poiIdsFilesMerger.Merge();
 
@@ -450,13 +492,18 @@ private:
   class Processor
   {
   public:
-    Processor(PoisAddressEnricher & enricher, FilesMerger & poiIdsFilesMerger,
-              std::atomic_size_t & poisAddressEnrichedStat)
+    Processor(PoisAddressEnricher & enricher,
+              std::shared_ptr<KeyValueConcurrentFile> const & kvFile,
+              std::shared_ptr<KeyValueConcurrentFile> const & hierarchyFile,
+              FilesMerger & poiIdsFilesMerger, std::atomic_size_t & poisAddressEnrichedStat)
       : m_goObjectsView{enricher.m_geoObjectMaintainer.CreateView()}
       , m_buildingsInfo{enricher.m_buildingsInfo}
-      , m_kvWriter{enricher.m_geoObjectKeyValuePath}
+      , m_kvWriter{kvFile}
       , m_poisAddressEnrichedStat{poisAddressEnrichedStat}
     {
+      if (hierarchyFile)
+        m_kvWriter.SetHierarchyFile(hierarchyFile);
+
       auto const poiIdsPath = GetPlatform().TmpPathForFile();
       m_localityIndexedPoiIds.open(poiIdsPath);
       if (!m_localityIndexedPoiIds.is_open())
@@ -486,24 +533,21 @@ private:
   private:
     JsonValue FindHouse(FeatureBuilder const & fb)
     {
-      base::JSONPtr house =
-          m_goObjectsView.GetFullGeoObject(
-              fb.GetKeyPoint(), [](GeoObjectMaintainer::GeoObjectData const & data)
-          {
-            return !data.m_house.empty();
-          });
+      base::JSONPtr house = m_goObjectsView.GetFullGeoObject(
+          fb.GetKeyPoint(), [](Building const & building) { return building.HasHouse(); });
       if (house)
         return JsonValue{std::move(house)};
 
-      auto && potentialIds = m_goObjectsView.SearchObjectsInIndex(fb.GetKeyPoint());
-
+      // Null buildings are the buildings with address points inside.
       auto const & buildings2AddressPoints = m_buildingsInfo.m_buildings2AddressPoints;
-      for (base::GeoObjectId id : potentialIds)
-      {
-        auto const it = buildings2AddressPoints.find(id);
-        if (it != buildings2AddressPoints.end())
-          return JsonValue{m_goObjectsView.GetFullGeoObjectWithoutNameAndCoordinates(it->second)};
-      }
+      auto it = buildings2AddressPoints.end();
+      m_goObjectsView.SearchFirstMatchedBuilding(
+          fb.GetKeyPoint(), [&](Building const & building) {
+            it = buildings2AddressPoints.find(building.m_id);
+            return it != buildings2AddressPoints.end();
+          });
+      if (it != buildings2AddressPoints.end())
+        return JsonValue{m_goObjectsView.GetFullGeoObjectWithoutNameAndCoordinates(it->second)};
 
       return JsonValue{};
     }
@@ -537,6 +581,7 @@ private:
   };
 
   std::string m_geoObjectKeyValuePath;
+  std::string m_geoObjectHierarchyPath;
   std::string m_geoObjectsTmpMwmPath;
   std::string m_localityIndexedPoiIdsPath;
   GeoObjectMaintainer & m_geoObjectMaintainer;
@@ -547,16 +592,63 @@ private:
 void AddPoisEnrichedWithHouseAddresses(GeoObjectMaintainer & geoObjectMaintainer,
                                        NullBuildingsInfo const & buildingsInfo,
                                        std::string const & geoObjectKeyValuePath,
+                                       std::string const & geoObjectHierarchyPath,
                                        std::string const & pathInGeoObjectsTmpMwm,
                                        std::string const & localityIndexedPoiIdsPath,
                                        bool /*verbose*/, unsigned int threadsCount)
 {
   auto && poisAddressEnricher =
-      PoisAddressEnricher{geoObjectKeyValuePath, pathInGeoObjectsTmpMwm, localityIndexedPoiIdsPath,
-                          geoObjectMaintainer, buildingsInfo, threadsCount};
+      PoisAddressEnricher{geoObjectKeyValuePath, geoObjectHierarchyPath, pathInGeoObjectsTmpMwm,
+                          localityIndexedPoiIdsPath, geoObjectMaintainer, buildingsInfo,
+                          threadsCount};
   poisAddressEnricher.AddAddresses();
 }
 
+// FeaturesSplitter --------------------------------------------------------------------------------
+class FeaturesSplitter
+{
+public:
+  FeaturesSplitter(FilesMerger & buildingsMerger, FilesMerger & poisMerger)
+    : m_buildings{MakeCollector(buildingsMerger)}, m_pois{MakeCollector(poisMerger)}
+  {
+  }
+
+  void operator()(FeatureBuilder & fb, uint64_t /* currPos */)
+  {
+    if (GeoObjectsFilter::IsBuilding(fb) || GeoObjectsFilter::HasHouse(fb))
+      m_buildings->Collect(fb);
+    else if (GeoObjectsFilter::IsPoi(fb))
+      m_pois->Collect(fb);
+  }
+
+private:
+  static std::unique_ptr<FeaturesCollector> MakeCollector(FilesMerger & merger)
+  {
+    auto collector = std::make_unique<FeaturesCollector>(GetPlatform().TmpPathForFile());
+    merger.DeferMergeAndDelete(collector->GetFilePath());
+    return collector;
+  }
+
+  std::unique_ptr<FeaturesCollector> m_buildings;
+  std::unique_ptr<FeaturesCollector> m_pois;
+};
+
+void SplitGeoObjectsFeatures(std::string const & pathInGeoObjectsTmpMwm,
+                             GeoObjectsFeaturesStreams const & streams, unsigned int threadsCount)
+{
+  // The streams are created for the empty features file too.
+  for (auto const & path : {streams.m_buildingsPath, streams.m_poisPath})
+    FileWriter const writer(path);
+
+  auto buildingsMerger = FilesMerger(streams.m_buildingsPath);
+  auto poisMerger = FilesMerger(streams.m_poisPath);
+  feature::ProcessParallelFromDatRawFormat(threadsCount, pathInGeoObjectsTmpMwm, [&] {
+    return FeaturesSplitter{buildingsMerger, poisMerger};
+  });
+  buildingsMerger.Merge();
+  poisMerger.Merge();
+}
+
 //--------------------------------------------------------------------------------------------------
 bool JsonHasBuilding(JsonValue const & json)
 {
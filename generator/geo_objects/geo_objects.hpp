@@ -7,12 +7,14 @@
 #include "geometry/meter.hpp"
 #include "geometry/point2d.hpp"
 
+#include "base/flat_hash_map.hpp"
 #include "base/logging.hpp"
 #include "base/scope_guard.hpp"
 #include "base/timer.hpp"
 
 #include "platform/platform.hpp"
 
+#include <cstdint>
 #include <string>
 
 #include <boost/optional.hpp>
@@ -25,32 +27,53 @@ namespace geo_objects
 using IndexReader = ReaderPtr<Reader>;
 using RegionInfoLocater = std::function<boost::optional<KeyValue>(m2::PointD const & pathPoint)>;
 
+// Features of the geo objects stages. The stages read their streams instead of decoding
+// all the geo objects features in each stage.
+struct GeoObjectsFeaturesStreams
+{
+  // Buildings and the features with houses, the objects of the temporary index.
+  std::string m_buildingsPath;
+  // POIs without buildings and houses.
+  std::string m_poisPath;
+};
+
+// Splits the features of |pathInGeoObjectsTmpMwm| into |streams| in one pass.
+void SplitGeoObjectsFeatures(std::string const & pathInGeoObjectsTmpMwm,
+                             GeoObjectsFeaturesStreams const & streams, unsigned int threadsCount);
+
 boost::optional<indexer::GeoObjectsIndex<IndexReader>> MakeTempGeoObjectsIndex(
     std::string const & pathToGeoObjectsTmpMwm, unsigned int threadsCount);
 
 bool JsonHasBuilding(JsonValue const & json);
 
+// The strings of the address data of the buildings are spilled to a temporary file when they
+// exceed |geoDataMemoryBudget| bytes, zero budget means no limit. The binary hierarchy of the
+// geocoder is appended to |geoObjectHierarchyPath| if it is not empty.
 void AddBuildingsAndThingsWithHousesThenEnrichAllWithRegionAddresses(
-    std::string const & geoObjectKeyValuePath, GeoObjectMaintainer & geoObjectMaintainer,
-    std::string const & pathInGeoObjectsTmpMwm, RegionInfoLocater const & regionInfoLocater,
-    bool verbose, unsigned int threadsCount);
+    std::string const & geoObjectKeyValuePath, std::string const & geoObjectHierarchyPath,
+    GeoObjectMaintainer & geoObjectMaintainer, std::string const & pathInGeoObjectsTmpMwm,
+    RegionInfoLocater const & regionInfoLocater, uint64_t geoDataMemoryBudget, bool verbose,
+    unsigned int threadsCount);
 
 struct NullBuildingsInfo
 {
-  std::unordered_map<base::GeoObjectId, base::GeoObjectId> m_addressPoints2Buildings;
+  base::FlatHashMap<base::GeoObjectId, base::GeoObjectId> m_addressPoints2Buildings;
   // Quite possible to have many points for one building. We want to use
   // their addresses for POIs according to buildings and have no idea how to distinguish between
   // them, so take one random
-  std::unordered_map<base::GeoObjectId, base::GeoObjectId> m_buildings2AddressPoints;
+  base::FlatHashMap<base::GeoObjectId, base::GeoObjectId> m_buildings2AddressPoints;
 };
 
+// Null buildings are searched in |buildingsFeaturesPath|, the address points of
+// |pathInGeoObjectsTmpMwm| get their geometry and the null buildings are removed from it.
 NullBuildingsInfo EnrichPointsWithOuterBuildingGeometry(
     GeoObjectMaintainer & geoObjectMaintainer, std::string const & pathInGeoObjectsTmpMwm,
-    unsigned int threadsCount);
+    std::string const & buildingsFeaturesPath, unsigned int threadsCount);
 
 void AddPoisEnrichedWithHouseAddresses(
     GeoObjectMaintainer & geoObjectMaintainer, NullBuildingsInfo const & buildingsInfo,
-    std::string const & geoObjectKeyValuePath, std::string const & pathInGeoObjectsTmpMwm,
-    std::string const & localityIndexedPoiIdsPath, bool verbose, unsigned int threadsCount);
+    std::string const & geoObjectKeyValuePath, std::string const & geoObjectHierarchyPath,
+    std::string const & pathInGeoObjectsTmpMwm, std::string const & localityIndexedPoiIdsPath,
+    bool verbose, unsigned int threadsCount);
 }  // namespace geo_objects
 }  // namespace generator
@@ -31,6 +31,14 @@ bool GeoObjectsFilter::IsAccepted(FeatureBuilder const & feature)
   return IsBuilding(feature) || HasHouse(feature) || IsPoi(feature);
 }
 
+std::vector<std::string> GeoObjectsFilter::GetRequiredTagKeys() const
+{
+  std::vector<std::string> keys = {"building", "addr:housenumber", "addr:housename"};
+  auto const & poiTypes = ftypes::IsPoiChecker::kPoiTypes;
+  keys.insert(std::end(keys), std::begin(poiTypes), std::end(poiTypes));
+  return keys;
+}
+
 // static
 bool GeoObjectsFilter::IsBuilding(FeatureBuilder const & fb)
 {
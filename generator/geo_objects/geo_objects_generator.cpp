@@ -1,5 +1,7 @@
 #include "generator/geo_objects/geo_objects_generator.hpp"
 
+#include "generator/stages_report.hpp"
+
 #include "base/logging.hpp"
 #include "base/scope_guard.hpp"
 #include "base/timer.hpp"
@@ -12,6 +14,7 @@ template <class Activist>
 auto Measure(std::string activity, Activist && activist)
 {
   LOG(LINFO, ("Start", activity));
+  generator::ScopedStage stage(activity);
   auto timer = base::Timer();
   SCOPE_GUARD(_, [&]() { LOG(LINFO, ("Finish", activity, timer.ElapsedSeconds(), "seconds.")); });
 
@@ -46,31 +49,63 @@ bool GeoObjectsGenerator::GenerateGeoObjects()
 
 bool GeoObjectsGenerator::GenerateGeoObjectsPrivate()
 {
+  // The stages read the features of their streams, the features file is decoded
+  // only to split it and to enrich the address points with the null buildings geometry.
+  GeoObjectsFeaturesStreams const streams{GetPlatform().TmpPathForFile(),
+                                          GetPlatform().TmpPathForFile()};
+  SCOPE_GUARD(removeStreams, [&streams]() {
+    Platform::RemoveFileIfExists(streams.m_buildingsPath);
+    Platform::RemoveFileIfExists(streams.m_poisPath);
+  });
+  {
+    ScopedStage stage("geo objects: features split");
+    SplitGeoObjectsFeatures(m_pathInGeoObjectsTmpMwm, streams, m_threadsCount);
+  }
+
   // Index buidling requires a lot of memory (~140GB).
   // Build index when there is a lot of memory,
   // before AddBuildingsAndThingsWithHousesThenEnrichAllWithRegionAddresses().
-  auto geoObjectIndex = MakeTempGeoObjectsIndex(m_pathInGeoObjectsTmpMwm, m_threadsCount);
-  if (!geoObjectIndex)
-    return false;
-  LOG(LINFO, ("Index was built."));
-  m_geoObjectMaintainer.SetIndex(std::move(*geoObjectIndex));
-
-  AddBuildingsAndThingsWithHousesThenEnrichAllWithRegionAddresses(
-      m_pathOutGeoObjectsKv, m_geoObjectMaintainer, m_pathInGeoObjectsTmpMwm, m_regionInfoLocater,
-      m_verbose, m_threadsCount);
-  LOG(LINFO, ("Geo objects with addresses were built."));
+  {
+    ScopedStage stage("geo objects: index");
+    auto geoObjectIndex = MakeTempGeoObjectsIndex(streams.m_buildingsPath, m_threadsCount);
+    if (!geoObjectIndex)
+      return false;
+    LOG(LINFO, ("Index was built."));
+    m_geoObjectMaintainer.SetIndex(std::move(*geoObjectIndex));
+  }
+
+  {
+    ScopedStage stage("geo objects: buildings with addresses");
+    AddBuildingsAndThingsWithHousesThenEnrichAllWithRegionAddresses(
+        m_pathOutGeoObjectsKv, m_pathOutGeoObjectsHierarchy, m_geoObjectMaintainer,
+        streams.m_buildingsPath,
+        m_regionInfoLocater, m_geoDataMemoryBudget, m_verbose, m_threadsCount);
+    LOG(LINFO, ("Geo objects with addresses were built."));
+  }
 
   LOG(LINFO, ("Enrich address points with outer null building geometry."));
-  NullBuildingsInfo const & buildingInfo = EnrichPointsWithOuterBuildingGeometry(
-      m_geoObjectMaintainer, m_pathInGeoObjectsTmpMwm, m_threadsCount);
-
-  AddPoisEnrichedWithHouseAddresses(m_geoObjectMaintainer, buildingInfo,
-                                    m_pathOutGeoObjectsKv, m_pathInGeoObjectsTmpMwm,
-                                    m_pathOutPoiIdsToAddToCoveringIndex,
-                                    m_verbose, m_threadsCount);
+  NullBuildingsInfo buildingInfo;
+  {
+    ScopedStage stage("geo objects: null buildings");
+    buildingInfo = EnrichPointsWithOuterBuildingGeometry(
+        m_geoObjectMaintainer, m_pathInGeoObjectsTmpMwm, streams.m_buildingsPath, m_threadsCount);
+  }
+
+  // The POIs stream is not changed by the null buildings enrichment: it has
+  // no address points and no buildings.
+  {
+    ScopedStage stage("geo objects: pois");
+    AddPoisEnrichedWithHouseAddresses(m_geoObjectMaintainer, buildingInfo,
+                                      m_pathOutGeoObjectsKv, m_pathOutGeoObjectsHierarchy,
+                                      streams.m_poisPath,
+                                      m_pathOutPoiIdsToAddToCoveringIndex,
+                                      m_verbose, m_threadsCount);
+  }
 
   LOG(LINFO, ("Geo objects without addresses were built."));
   LOG(LINFO, ("Geo objects key-value storage saved to", m_pathOutGeoObjectsKv));
+  if (!m_pathOutGeoObjectsHierarchy.empty())
+    LOG(LINFO, ("Geo objects binary hierarchy saved to", m_pathOutGeoObjectsHierarchy));
   LOG(LINFO, ("Ids of POIs without addresses saved to", m_pathOutPoiIdsToAddToCoveringIndex));
   return true;
 }
@@ -78,10 +113,13 @@ bool GeoObjectsGenerator::GenerateGeoObjectsPrivate()
 bool GenerateGeoObjects(std::string const & regionsIndex, std::string const & regionsKeyValue,
                         std::string const & geoObjectsFeatures,
                         std::string const & nodesListToIndex, std::string const & geoObjectKeyValue,
-                        bool verbose, unsigned int threadsCount)
+                        uint64_t geoDataMemoryBudget, bool verbose, unsigned int threadsCount,
+                        std::string const & geoObjectsHierarchy)
 
 {
-  auto regionInfoGetter = regions::RegionInfoGetter(regionsIndex, regionsKeyValue);
+  auto const sharedRegionInfoGetter =
+      regions::RegionInfoGetter::GetShared(regionsIndex, regionsKeyValue);
+  auto const & regionInfoGetter = *sharedRegionInfoGetter;
   LOG(LINFO, ("Size of regions key-value storage:", regionInfoGetter.GetStorage().Size()));
 
   auto findDeepest = [&regionInfoGetter](auto && point) {
@@ -98,6 +136,8 @@ bool GenerateGeoObjects(std::string const & regionsIndex, std::string const & re
                                                        geoObjectKeyValue,
                                                        verbose,
                                                        threadsCount};
+  geoObjectsGenerator.SetGeoDataMemoryBudget(geoDataMemoryBudget);
+  geoObjectsGenerator.SetHierarchyPath(geoObjectsHierarchy);
 
   return geoObjectsGenerator.GenerateGeoObjects();
 }
@@ -9,7 +9,9 @@
 
 #include "platform/platform.hpp"
 
+#include <cstdint>
 #include <string>
+#include <utility>
 
 namespace generator
 {
@@ -30,6 +32,12 @@ public:
   // we build an index for houses. And then we finish building key-value pairs for poi using this
   // index for houses.
   bool GenerateGeoObjects();
+  // The address data of the buildings is spilled to a temporary file when its strings exceed
+  // |bytes|, zero means no limit which is the default.
+  void SetGeoDataMemoryBudget(uint64_t bytes) { m_geoDataMemoryBudget = bytes; }
+  // The binary hierarchy of the geocoder is written to |path| along with the key-value,
+  // see BinaryHierarchyCollector. Empty path, which is the default, means no hierarchy.
+  void SetHierarchyPath(std::string path) { m_pathOutGeoObjectsHierarchy = std::move(path); }
   GeoObjectMaintainer& GetMaintainer()
   {
     return m_geoObjectMaintainer;
@@ -41,9 +49,11 @@ private:
   std::string m_pathInGeoObjectsTmpMwm;
   std::string m_pathOutPoiIdsToAddToCoveringIndex;
   std::string m_pathOutGeoObjectsKv;
+  std::string m_pathOutGeoObjectsHierarchy;
 
   bool m_verbose = false;
   unsigned int m_threadsCount = 1;
+  uint64_t m_geoDataMemoryBudget = 0;
   GeoObjectMaintainer m_geoObjectMaintainer;
   RegionInfoLocater m_regionInfoLocater;
 };
@@ -51,6 +61,7 @@ private:
 bool GenerateGeoObjects(std::string const & regionsIndex, std::string const & regionsKeyValue,
                         std::string const & geoObjectsFeatures,
                         std::string const & nodesListToIndex, std::string const & geoObjectKeyValue,
-                        bool verbose, unsigned int threadsCount);
+                        uint64_t geoDataMemoryBudget, bool verbose, unsigned int threadsCount,
+                        std::string const & geoObjectsHierarchy = {});
 }  // namespace geo_objects
 }  // namespace generator
@@ -5,6 +5,7 @@
 #include "generator/translation.hpp"
 
 #include <utility>
+#include <vector>
 
 namespace generator
 {
@@ -56,73 +57,81 @@ base::JSONPtr AddAddress(std::string const & street, std::string const & house,
   return result;
 }
 
-// GeoObjectMaintainer::GeoObjectsView
-base::JSONPtr GeoObjectMaintainer::GeoObjectsView::GetFullGeoObject(
-    m2::PointD point,
-    std::function<bool(GeoObjectMaintainer::GeoObjectData const &)> && pred) const
+void UpdateCoordinates(m2::PointD const & point, JsonObjectPatch & json)
 {
-  auto const ids = SearchGeoObjectIdsByPoint(m_geoIndex, point);
-  for (auto const & id : ids)
+  auto coordinates = json_object_get(json.GetSource("geometry"), "coordinates");
+  if (json_array_size(coordinates) == 2)
   {
-    auto const it = m_geoId2GeoData.find(id);
-    if (it == m_geoId2GeoData.end())
-      continue;
+    auto const latLon = MercatorBounds::ToLatLon(point);
+    json.GetObligatoryObject("geometry").Set("coordinates",
+                                             std::vector<double>{latLon.m_lon, latLon.m_lat});
+  }
+}
+
+JsonObjectPatch AddAddressPatch(std::string const & street, std::string const & house,
+                                m2::PointD point, StringUtf8Multilang const & name,
+                                KeyValue const & regionKeyValue)
+{
+  JsonObjectPatch result(*regionKeyValue.second);
+
+  UpdateCoordinates(point, result);
 
-    auto const geoData = it->second;
-    if (!pred(geoData))
-      continue;
+  auto & properties = result.GetObligatoryObject("properties");
+  auto & address = properties.GetObligatoryObject("locales")
+                       .GetObligatoryObject("default")
+                       .GetObligatoryObject("address");
+  if (!street.empty())
+    address.Set("street", street);
 
+  // By writing home null in the field we can understand that the house has no address.
+  if (!house.empty())
+    address.Set("building", house);
+  else
+    address.SetNull("building");
 
-    auto const & regionJsonValue = m_regionIdGetter(geoData.m_regionId);
-    if (!regionJsonValue)
-      return {};
+  PatchLocalizator localizator(properties);
+  localizator.SetLocale("name", Localizator::EasyObjectWithTranslation(name));
 
-    return AddAddress(geoData.m_street, geoData.m_house, point, StringUtf8Multilang(),
-                      KeyValue(geoData.m_regionId.GetEncodedId(), regionJsonValue));
-  }
+  int const kHouseOrPoiRank = 30;
+  properties.Set("kind", "building");
+  properties.Set("rank", kHouseOrPoiRank);
 
-  return {};
+  properties.Set("dref", KeyValueStorage::SerializeDref(regionKeyValue.first));
+  return result;
 }
 
-base::JSONPtr GeoObjectMaintainer::GeoObjectsView::GetFullGeoObjectWithoutNameAndCoordinates(
-    base::GeoObjectId id) const
+// GeoObjectMaintainer::GeoObjectsView
+base::JSONPtr GeoObjectMaintainer::GeoObjectsView::MakeAddress(Building const & building,
+                                                               m2::PointD point) const
 {
-  auto const it = m_geoId2GeoData.find(id);
-  if (it == m_geoId2GeoData.end())
-    return {};
-
-  auto const geoData = it->second;
-  auto const & regionJsonValue = m_regionIdGetter(geoData.m_regionId);
+  auto const & regionJsonValue = m_regionIdGetter(building.m_regionId);
   if (!regionJsonValue)
     return {};
 
-  // no need to store name here, it will be overriden by poi name
-  return AddAddress(geoData.m_street, geoData.m_house, m2::PointD(), StringUtf8Multilang(),
-                    KeyValue(geoData.m_regionId.GetEncodedId(), regionJsonValue));
+  return AddAddress(m_buildings.GetString(building.m_street),
+                    m_buildings.GetString(building.m_house), point, StringUtf8Multilang(),
+                    KeyValue(building.m_regionId.GetEncodedId(), regionJsonValue));
 }
 
-boost::optional<GeoObjectMaintainer::GeoObjectData> GeoObjectMaintainer::GeoObjectsView::GetGeoData(
+base::JSONPtr GeoObjectMaintainer::GeoObjectsView::GetFullGeoObjectWithoutNameAndCoordinates(
     base::GeoObjectId id) const
 {
-  auto const it = m_geoId2GeoData.find(id);
-  if (it == m_geoId2GeoData.end())
+  auto const building = m_buildings.Find(id);
+  if (!building)
     return {};
 
-  return it->second;
+  // no need to store name here, it will be overriden by poi name
+  return MakeAddress(*building, m2::PointD());
 }
 
-boost::optional<base::GeoObjectId>
-GeoObjectMaintainer::GeoObjectsView::SearchIdOfFirstMatchedObject(
-    m2::PointD const & point, std::function<bool(base::GeoObjectId)> && pred) const
+boost::optional<GeoObjectMaintainer::GeoObjectData> GeoObjectMaintainer::GeoObjectsView::GetGeoData(
+    base::GeoObjectId id) const
 {
-  auto const ids = SearchObjectsInIndex(point);
-  for (auto const & id : ids)
-  {
-    if (pred(id))
-      return id;
-  }
+  auto const building = m_buildings.Find(id);
+  if (!building)
+    return {};
 
-  return {};
+  return m_buildings.GetGeoData(*building);
 }
 
 std::vector<base::GeoObjectId> GeoObjectMaintainer::GeoObjectsView::SearchGeoObjectIdsByPoint(
@@ -2,6 +2,7 @@
 
 #include "generator/key_value_storage.hpp"
 
+#include "generator/geo_objects/buildings_index.hpp"
 #include "generator/regions/region_info_getter.hpp"
 
 #include "generator/feature_builder.hpp"
@@ -31,53 +32,60 @@ void UpdateCoordinates(m2::PointD const & point, base::JSONPtr & json);
 base::JSONPtr AddAddress(std::string const & street, std::string const & house, m2::PointD point,
                          StringUtf8Multilang const & name, KeyValue const & regionKeyValue);
 
+void UpdateCoordinates(m2::PointD const & point, JsonObjectPatch & json);
+// The same value as the one of AddAddress() to stream it by JsonWriter without the copy of the
+// region value. The region value must be alive until the result is written.
+JsonObjectPatch AddAddressPatch(std::string const & street, std::string const & house,
+                                m2::PointD point, StringUtf8Multilang const & name,
+                                KeyValue const & regionKeyValue);
+
 class GeoObjectMaintainer
 {
 public:
   using RegionIdGetter = std::function<std::shared_ptr<JsonValue>(base::GeoObjectId id)>;
 
-  struct GeoObjectData
-  {
-    std::string m_street;
-    std::string m_house;
-    base::GeoObjectId m_regionId;
-  };
-
-  using GeoId2GeoData = std::unordered_map<base::GeoObjectId, GeoObjectData>;
-  using GeoIndex = indexer::GeoObjectsIndex<ReaderPtr<Reader>>;
+  using GeoObjectData = geo_objects::GeoObjectData;
+  using GeoId2GeoData = BuildingsIndex::GeoId2GeoData;
+  using GeoIndex = BuildingsIndex::GeoIndex;
+  using Building = BuildingsIndex::Building;
 
   class GeoObjectsView
   {
   public:
-    GeoObjectsView(GeoIndex const & geoIndex, GeoId2GeoData const & geoId2GeoData,
-                   RegionIdGetter const & regionIdGetter)
-      : m_geoIndex(geoIndex)
-      , m_geoId2GeoData(geoId2GeoData)
-      , m_regionIdGetter(regionIdGetter)
+    GeoObjectsView(BuildingsIndex const & buildings, RegionIdGetter const & regionIdGetter)
+      : m_buildings(buildings), m_regionIdGetter(regionIdGetter)
     {
     }
-    boost::optional<base::GeoObjectId> SearchIdOfFirstMatchedObject(
-        m2::PointD const & point, std::function<bool(base::GeoObjectId)> && pred) const;
 
-    boost::optional<GeoObjectData> GetGeoData(base::GeoObjectId id) const;
-
-    std::vector<base::GeoObjectId> SearchObjectsInIndex(m2::PointD const & point) const
+    // Returns the first building at |point| that satisfies |pred|.
+    template <typename Pred>
+    Building const * SearchFirstMatchedBuilding(m2::PointD const & point, Pred && pred) const
     {
-      return SearchGeoObjectIdsByPoint(m_geoIndex, point);
+      return m_buildings.FindAtPoint(point, pred);
     }
 
+    boost::optional<GeoObjectData> GetGeoData(base::GeoObjectId id) const;
+
     base::JSONPtr GetFullGeoObjectWithoutNameAndCoordinates(base::GeoObjectId id) const;
 
-    base::JSONPtr GetFullGeoObject(
-        m2::PointD point,
-        std::function<bool(GeoObjectMaintainer::GeoObjectData const &)> && pred) const;
+    // Address of the first building at |point| that satisfies |pred|.
+    template <typename Pred>
+    base::JSONPtr GetFullGeoObject(m2::PointD point, Pred && pred) const
+    {
+      auto const building = m_buildings.FindAtPoint(point, pred);
+      if (!building)
+        return {};
+
+      return MakeAddress(*building, point);
+    }
 
     static std::vector<base::GeoObjectId> SearchGeoObjectIdsByPoint(GeoIndex const & index,
                                                                     m2::PointD point);
 
   private:
-    GeoIndex const & m_geoIndex;
-    GeoId2GeoData const & m_geoId2GeoData;
+    base::JSONPtr MakeAddress(Building const & building, m2::PointD point) const;
+
+    BuildingsIndex const & m_buildings;
     RegionIdGetter const & m_regionIdGetter;
   };
 
@@ -85,19 +93,20 @@ public:
 
   void SetIndex(GeoIndex && index) { m_index = std::move(index); }
 
-  void SetGeoData(GeoId2GeoData && geoId2GeoData) { m_geoId2GeoData = std::move(geoId2GeoData); }
-
-  size_t Size() const { return m_geoId2GeoData.size(); }
-
-  GeoObjectsView CreateView()
+  // Packs |geoId2GeoData| into the buildings index, the index must be set before.
+  void SetGeoData(GeoId2GeoData && geoId2GeoData)
   {
-    return GeoObjectsView(m_index, m_geoId2GeoData, m_regionIdGetter);
+    m_buildings = BuildingsIndex(m_index, std::move(geoId2GeoData));
   }
 
+  size_t Size() const { return m_buildings.Size(); }
+
+  GeoObjectsView CreateView() { return GeoObjectsView(m_buildings, m_regionIdGetter); }
+
 private:
   GeoIndex m_index;
   RegionIdGetter m_regionIdGetter;
-  GeoId2GeoData m_geoId2GeoData;
+  BuildingsIndex m_buildings;
 };
 }  // namespace geo_objects
 }  // namespace generator
@@ -182,7 +182,10 @@ private:
     auto const pos = feature::CheckedFilePosCast(m_geoFileGetter(i));
     m_buffer.m_ptsOffset.push_back(pos);
 
-    serial::SaveOuterPath(toSave, cp, m_geoFileGetter(i));
+    if (m_header.HasPointsBlocks())
+      serial::SaveOuterPathBlocks(toSave, cp, m_geoFileGetter(i));
+    else
+      serial::SaveOuterPath(toSave, cp, m_geoFileGetter(i));
   }
 
   void FillInnerPointsMask(Points const & points, uint32_t scaleIndex)
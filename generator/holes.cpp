@@ -4,6 +4,7 @@
 #include "generator/osm_element.hpp"
 
 #include <utility>
+#include <vector>
 
 using namespace feature;
 
@@ -62,15 +63,21 @@ HolesRelation::HolesRelation(std::shared_ptr<cache::IntermediateDataReader> cons
 void HolesRelation::Build(OsmElement const * p)
 {
   // Iterate ways to get 'outer' and 'inner' geometries.
+  // The ways are read by two batches to prefetch their scattered values.
+  std::vector<uint64_t> outerIds;
+  std::vector<uint64_t> innerIds;
   for (auto const & e : p->Members())
   {
     if (e.m_type != OsmElement::EntityType::Way)
       continue;
 
     if (e.m_role == "outer")
-      m_outer.AddWay(e.m_ref);
+      outerIds.push_back(e.m_ref);
     else if (e.m_role == "inner")
-      m_holes(e.m_ref);
+      innerIds.push_back(e.m_ref);
   }
+
+  m_outer.AddWays(outerIds);
+  m_holes.AddWays(innerIds);
 }
 }  // namespace generator
@@ -6,6 +6,7 @@
 #include "base/control_flow.hpp"
 
 #include <cstdint>
+#include <vector>
 
 struct OsmElement;
 
@@ -22,6 +23,7 @@ public:
   explicit HolesAccumulator(std::shared_ptr<cache::IntermediateDataReader> const & cache);
 
   void operator() (uint64_t id) { m_merger.AddWay(id); }
+  void AddWays(std::vector<uint64_t> const & ids) { m_merger.AddWays(ids); }
   feature::FeatureBuilder::Geometry & GetHoles();
 
 private:
@@ -2,20 +2,38 @@
 
 #include "platform/platform.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <fstream>
+#include <functional>
 #include <new>
+#include <numeric>
+#include <queue>
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "coding/byte_stream.hpp"
+#include "coding/internal/file_data.hpp"
+#include "coding/varint.hpp"
 
 #include "base/assert.hpp"
+#include "base/bits.hpp"
 #include "base/checked_cast.hpp"
 #include "base/logging.hpp"
+#include "base/memory_accounting.hpp"
 
 #include "defines.hpp"
 
@@ -27,9 +45,16 @@ namespace cache
 {
 namespace
 {
+// The memory tag of the in-memory parts of the node storages. The mapped files are not counted.
+char const kNodeStorageTag[] = "node_storage";
+
 size_t const kFlushCount = 10'000'000;
 double const kValueOrder = 1e7;
 string const kShortExtension = ".short";
+string const kBlocksDirectoryExtension = ".dir";
+// The number of points in a block of the compressed storage: a lookup decodes
+// the whole block, so it is a trade off between the lookup speed and the directory size.
+size_t const kCompressedBlockSize = 128;
 
 // An estimation.
 // OSM had around 4.1 billion nodes on 2017-11-08,
@@ -63,6 +88,41 @@ bool FromLatLon(LatLon const & ll, double & lat, double & lon)
   return false;
 }
 
+// Calls |fn(i)| for the indices of |ids| in the ascending order of the ids.
+template <typename Fn>
+void ForEachIndexByIds(vector<uint64_t> const & ids, Fn && fn)
+{
+  if (is_sorted(ids.cbegin(), ids.cend()))
+  {
+    for (size_t i = 0; i < ids.size(); ++i)
+      fn(i);
+    return;
+  }
+
+  vector<size_t> order(ids.size());
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(), [&ids](size_t lhs, size_t rhs) { return ids[lhs] < ids[rhs]; });
+  for (auto const i : order)
+    fn(i);
+}
+
+// Gets the points of a storage with the ordered ids, like the mapped arrays or the blocks
+// of the nodes, in the order of the ids.
+bool GetPointsByIds(PointStorageReaderInterface const & storage, vector<uint64_t> const & ids,
+                    vector<m2::PointD> & points)
+{
+  points.assign(ids.size(), m2::PointD::Zero());
+  bool found = true;
+  ForEachIndexByIds(ids, [&](size_t i) {
+    if (!storage.GetPoint(ids[i], points[i].y, points[i].x))
+    {
+      points[i] = m2::PointD::Zero();
+      found = false;
+    }
+  });
+  return found;
+}
+
 template <class Index, class Container>
 void AddToIndex(Index & index, Key relationId, Container const & values)
 {
@@ -90,6 +150,11 @@ public:
     return ret;
   }
 
+  bool GetPoints(vector<uint64_t> const & ids, vector<m2::PointD> & points) const override
+  {
+    return GetPointsByIds(*this, ids, points);
+  }
+
 private:
   MmapReader m_mmapReader;
 };
@@ -156,6 +221,11 @@ public:
     return ret;
   }
 
+  bool GetPoints(vector<uint64_t> const & ids, vector<m2::PointD> & points) const override
+  {
+    return GetPointsByIds(*this, ids, points);
+  }
+
 private:
   boost::iostreams::mapped_file_source m_fileMap;
 };
@@ -244,6 +314,9 @@ public:
       m_map.emplace(llp.m_pos, ll);
     }
 
+    // A node of the map and a bucket pointer per bucket.
+    m_memory.Set(m_map.size() * (sizeof(decltype(m_map)::value_type) + 2 * sizeof(void *)) +
+                 m_map.bucket_count() * sizeof(void *));
     LOG(LINFO, ("Nodes reading is finished"));
   }
 
@@ -264,6 +337,7 @@ public:
 
 private:
   unordered_map<uint64_t, LatLon> m_map;
+  base::memory::ScopedBytes m_memory{base::memory::GetTag(kNodeStorageTag)};
 };
 
 // MapFilePointStorageWriter -----------------------------------------------------------------------
@@ -303,8 +377,447 @@ private:
   std::mutex m_updateMutex;
   uint64_t m_numProcessedPoints = 0;
 };
+
+// The compressed storage is a sequence of blocks of points sorted by ids and a directory
+// of the blocks. A block contains up to kCompressedBlockSize points:
+// the points count followed by varint deltas of ids and coordinates from the previous point.
+struct CompressedBlockInfo
+{
+  uint64_t m_firstId = 0;
+  uint64_t m_lastId = 0;
+  uint64_t m_offset = 0;
+};
+static_assert(sizeof(CompressedBlockInfo) == 24, "Invalid structure size");
+
+// Appends blocks of sorted |points| to |data|, |blocks| get offsets relative to |data| begin.
+void EncodeCompressedBlocks(vector<LatLonPos> const & points, vector<uint8_t> & data,
+                            vector<CompressedBlockInfo> & blocks)
+{
+  PushBackByteSink<vector<uint8_t>> sink(data);
+  for (size_t begin = 0; begin < points.size(); begin += kCompressedBlockSize)
+  {
+    auto const end = min(begin + kCompressedBlockSize, points.size());
+
+    CompressedBlockInfo block;
+    block.m_firstId = points[begin].m_pos;
+    block.m_lastId = points[end - 1].m_pos;
+    block.m_offset = data.size();
+    blocks.push_back(block);
+
+    WriteVarUint(sink, static_cast<uint32_t>(end - begin));
+    LatLonPos prev;
+    prev.m_pos = block.m_firstId;
+    for (size_t i = begin; i < end; ++i)
+    {
+      auto const & point = points[i];
+      WriteVarUint(sink, point.m_pos - prev.m_pos);
+      WriteVarInt(sink, static_cast<int64_t>(point.m_lat) - prev.m_lat);
+      WriteVarInt(sink, static_cast<int64_t>(point.m_lon) - prev.m_lon);
+      prev = point;
+    }
+  }
+}
+
+void DecodeCompressedBlock(uint8_t const * data, CompressedBlockInfo const & block,
+                           vector<LatLonPos> & points)
+{
+  ArrayByteSource source(data + block.m_offset);
+  auto const count = ReadVarUint<uint32_t>(source);
+  points.resize(count);
+
+  LatLonPos prev;
+  prev.m_pos = block.m_firstId;
+  for (auto & point : points)
+  {
+    point.m_pos = prev.m_pos + ReadVarUint<uint64_t>(source);
+    point.m_lat = static_cast<int32_t>(prev.m_lat + ReadVarInt<int64_t>(source));
+    point.m_lon = static_cast<int32_t>(prev.m_lon + ReadVarInt<int64_t>(source));
+    prev = point;
+  }
+}
+
+// CompressedPointStorageReader --------------------------------------------------------------------
+class CompressedPointStorageReader : public PointStorageReaderInterface
+{
+public:
+  explicit CompressedPointStorageReader(string const & name)
+    : m_instanceId{++s_instancesCount}
+  {
+    LOG(LINFO, ("Nodes blocks directory reading is started"));
+
+    auto const directoryFilename = name + kBlocksDirectoryExtension;
+    auto fileStream = std::ifstream{directoryFilename, std::ios::binary};
+    if (!fileStream.is_open())
+      MYTHROW(Writer::OpenException, ("Failed to open", directoryFilename));
+
+    CompressedBlockInfo block;
+    while (fileStream.good() && fileStream.read(reinterpret_cast<char*>(&block), sizeof(block)))
+      m_blocks.push_back(block);
+
+    // Blocks of concurrent writers are interleaved in the file.
+    sort(m_blocks.begin(), m_blocks.end(),
+         [](CompressedBlockInfo const & lhs, CompressedBlockInfo const & rhs) {
+           return lhs.m_firstId < rhs.m_firstId;
+         });
+    for (size_t i = 1; i < m_blocks.size(); ++i)
+    {
+      CHECK_LESS(m_blocks[i - 1].m_lastId, m_blocks[i].m_firstId,
+                 ("Overlapped blocks of nodes, the nodes must be added in ascending order of ids"));
+    }
+
+    m_blocks.shrink_to_fit();
+    m_memory.Set(m_blocks.capacity() * sizeof(CompressedBlockInfo));
+    LOG(LINFO, ("Nodes blocks directory reading is finished, blocks:", m_blocks.size()));
+
+    if (m_blocks.empty())
+      return;
+
+    m_fileMap.open(name);
+    if (!m_fileMap.is_open())
+      MYTHROW(Writer::OpenException, ("Failed to open", name));
+
+    // Try aggressively (MADV_WILLNEED) and asynchronously read ahead the node file.
+    auto readaheadTask = std::thread([data = m_fileMap.data(), size = m_fileMap.size()] {
+      ::madvise(const_cast<char*>(data), size, MADV_WILLNEED);
+    });
+    readaheadTask.detach();
+  }
+
+  // PointStorageReaderInterface overrides:
+  bool GetPoint(uint64_t id, double & lat, double & lon) const override
+  {
+    auto it = upper_bound(m_blocks.begin(), m_blocks.end(), id,
+                          [](uint64_t id, CompressedBlockInfo const & block) {
+                            return id < block.m_firstId;
+                          });
+    if (it == m_blocks.begin())
+      return false;
+    --it;
+    if (id > it->m_lastId)
+      return false;
+
+    // Nodes of a way are usually close to each other, so a thread keeps the last decoded block.
+    static thread_local DecodedBlock decoded;
+    auto const blockIndex = static_cast<size_t>(distance(m_blocks.begin(), it));
+    if (decoded.m_readerId != m_instanceId || decoded.m_blockIndex != blockIndex)
+    {
+      auto const * data = reinterpret_cast<uint8_t const *>(m_fileMap.data());
+      DecodeCompressedBlock(data, *it, decoded.m_points);
+      decoded.m_readerId = m_instanceId;
+      decoded.m_blockIndex = blockIndex;
+    }
+
+    auto const & points = decoded.m_points;
+    auto const point = lower_bound(points.begin(), points.end(), id,
+                                   [](LatLonPos const & point, uint64_t id) {
+                                     return point.m_pos < id;
+                                   });
+    if (point == points.end() || point->m_pos != id)
+      return false;
+
+    LatLon ll;
+    ll.m_lat = point->m_lat;
+    ll.m_lon = point->m_lon;
+    bool ret = FromLatLon(ll, lat, lon);
+    if (!ret)
+    {
+      LOG(LERROR, ("Inconsistent CompressedPointStorageReader. Node with id =", id,
+                   "must exist but was not found"));
+    }
+    return ret;
+  }
+
+  // A block is decoded once for the sorted ids of a way.
+  bool GetPoints(vector<uint64_t> const & ids, vector<m2::PointD> & points) const override
+  {
+    return GetPointsByIds(*this, ids, points);
+  }
+
+private:
+  struct DecodedBlock
+  {
+    uint64_t m_readerId = 0;
+    size_t m_blockIndex = 0;
+    vector<LatLonPos> m_points;
+  };
+
+  static atomic<uint64_t> s_instancesCount;
+
+  // Identifies a reader in the thread local cache of decoded blocks.
+  uint64_t const m_instanceId;
+  boost::iostreams::mapped_file_source m_fileMap;
+  vector<CompressedBlockInfo> m_blocks;
+  base::memory::ScopedBytes m_memory{base::memory::GetTag(kNodeStorageTag)};
+};
+
+atomic<uint64_t> CompressedPointStorageReader::s_instancesCount{0};
+
+// CompressedPointStorageWriter --------------------------------------------------------------------
+class CompressedPointStorageWriter : public PointStorageWriterInterface
+{
+public:
+  explicit CompressedPointStorageWriter(string const & name)
+    : m_fileWriter(name)
+    , m_directoryFilename(name + kBlocksDirectoryExtension)
+  {
+  }
+
+  ~CompressedPointStorageWriter() override
+  {
+    FlushPendingPoints();
+
+    FileWriter directoryWriter(m_directoryFilename);
+    if (!m_blocks.empty())
+      directoryWriter.Write(m_blocks.data(), m_blocks.size() * sizeof(CompressedBlockInfo));
+  }
+
+  // PointStorageWriterInterface overrides:
+  void AddPoint(uint64_t id, double lat, double lon) override
+  {
+    LatLon ll;
+    ToLatLon(lat, lon, ll);
+
+    if (!m_pendingPoints.empty() && id <= m_pendingPoints.back().m_pos)
+      FlushPendingPoints();
+
+    LatLonPos llp;
+    llp.m_pos = id;
+    llp.m_lat = ll.m_lat;
+    llp.m_lon = ll.m_lon;
+    m_pendingPoints.push_back(llp);
+    if (m_pendingPoints.size() == kCompressedBlockSize)
+      FlushPendingPoints();
+
+    m_numProcessedPoints.fetch_add(1, std::memory_order_relaxed);
+  }
+  void AddPoints(Nodes const & nodes, bool /* concurrent */) override
+  {
+    if (nodes.empty())
+      return;
+
+    vector<LatLonPos> points;
+    points.reserve(nodes.size());
+    for (auto const & node : nodes)
+    {
+      LatLon ll;
+      ToLatLon(node.second.m_lat, node.second.m_lon, ll);
+
+      LatLonPos llp;
+      llp.m_pos = node.first;
+      llp.m_lat = ll.m_lat;
+      llp.m_lon = ll.m_lon;
+      points.push_back(llp);
+    }
+
+    auto const byId = [](LatLonPos const & lhs, LatLonPos const & rhs) {
+      return lhs.m_pos < rhs.m_pos;
+    };
+    if (!is_sorted(points.begin(), points.end(), byId))
+      sort(points.begin(), points.end(), byId);
+
+    // Points are encoded out of the lock.
+    vector<uint8_t> data;
+    vector<CompressedBlockInfo> blocks;
+    EncodeCompressedBlocks(points, data, blocks);
+    Append(data, blocks);
+
+    m_numProcessedPoints.fetch_add(nodes.size(), std::memory_order_relaxed);
+  }
+  uint64_t GetNumProcessedPoints() const override { return m_numProcessedPoints; }
+
+private:
+  void FlushPendingPoints()
+  {
+    if (m_pendingPoints.empty())
+      return;
+
+    vector<uint8_t> data;
+    vector<CompressedBlockInfo> blocks;
+    EncodeCompressedBlocks(m_pendingPoints, data, blocks);
+    Append(data, blocks);
+    m_pendingPoints.clear();
+  }
+
+  void Append(vector<uint8_t> const & data, vector<CompressedBlockInfo> & blocks)
+  {
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+    auto const offset = m_fileWriter.Pos();
+    m_fileWriter.Write(data.data(), data.size());
+    for (auto & block : blocks)
+    {
+      block.m_offset += offset;
+      m_blocks.push_back(block);
+    }
+    m_memory.Set(m_blocks.capacity() * sizeof(CompressedBlockInfo));
+  }
+
+  FileWriter m_fileWriter;
+  string m_directoryFilename;
+  std::mutex m_updateMutex;
+  vector<CompressedBlockInfo> m_blocks;
+  // Guarded by m_updateMutex as m_blocks.
+  base::memory::ScopedBytes m_memory{base::memory::GetTag(kNodeStorageTag)};
+  // Points of AddPoint() calls which are not written yet.
+  vector<LatLonPos> m_pendingPoints;
+  std::atomic<uint64_t> m_numProcessedPoints{0};
+};
+
+uint64_t PackLatLon(LatLon const & ll)
+{
+  uint64_t value = 0;
+  memcpy(&value, &ll, sizeof(ll));
+  return value;
+}
+
+LatLon UnpackLatLon(uint64_t value)
+{
+  LatLon ll;
+  memcpy(static_cast<void *>(&ll), &value, sizeof(ll));
+  return ll;
+}
+
+// OverlayPointStorageReader -----------------------------------------------------------------------
+// The nodes of the overlay take precedence over the nodes of the storage.
+class OverlayPointStorageReader : public PointStorageReaderInterface
+{
+public:
+  OverlayPointStorageReader(unique_ptr<PointStorageReaderInterface> && storage,
+                            string const & overlayName)
+    : m_storage(move(storage)), m_overlay(overlayName)
+  {
+  }
+
+  // PointStorageReaderInterface overrides:
+  bool GetPoint(uint64_t id, double & lat, double & lon) const override
+  {
+    uint64_t value = 0;
+    if (!m_overlay.GetValueByKey(id, value))
+      return m_storage->GetPoint(id, lat, lon);
+
+    // A deleted node.
+    return FromLatLon(UnpackLatLon(value), lat, lon);
+  }
+
+  bool GetPoints(vector<uint64_t> const & ids, vector<m2::PointD> & points) const override
+  {
+    points.assign(ids.size(), m2::PointD::Zero());
+    bool found = true;
+    // The nodes which are not in the overlay are got from the storage by one batch.
+    vector<uint64_t> storageIds;
+    vector<size_t> storageIndices;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      uint64_t value = 0;
+      if (!m_overlay.GetValueByKey(ids[i], value))
+      {
+        storageIds.emplace_back(ids[i]);
+        storageIndices.emplace_back(i);
+      }
+      else if (!FromLatLon(UnpackLatLon(value), points[i].y, points[i].x))
+      {
+        // A deleted node.
+        found = false;
+      }
+    }
+
+    if (storageIds.empty())
+      return found;
+
+    vector<m2::PointD> storagePoints;
+    found = m_storage->GetPoints(storageIds, storagePoints) && found;
+    for (size_t i = 0; i < storageIndices.size(); ++i)
+      points[storageIndices[i]] = storagePoints[i];
+    return found;
+  }
+
+private:
+  unique_ptr<PointStorageReaderInterface> m_storage;
+  IndexFileReader m_overlay;
+};
+
+IndexFileReader ReadOverlayIndex(string const & name)
+{
+  return Platform::IsFileExistsByFullPath(name) ? IndexFileReader(name) : IndexFileReader();
+}
 }  // namespace
 
+// PointStorageReaderInterface ---------------------------------------------------------------------
+bool PointStorageReaderInterface::GetPoints(vector<uint64_t> const & ids,
+                                            vector<m2::PointD> & points) const
+{
+  points.assign(ids.size(), m2::PointD::Zero());
+  bool found = true;
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    if (!GetPoint(ids[i], points[i].y, points[i].x))
+    {
+      points[i] = m2::PointD::Zero();
+      found = false;
+    }
+  }
+  return found;
+}
+
+// SuccinctOffsetsIndex ----------------------------------------------------------------------------
+SuccinctOffsetsIndex::SuccinctOffsetsIndex(vector<Element> const & elements, uint64_t sourceSize)
+  : m_sourceSize(sourceSize), m_count(elements.size())
+{
+  if (elements.empty())
+    return;
+
+  Value maxValue = 0;
+  for (auto const & element : elements)
+    maxValue = max(maxValue, element.second);
+  m_valueBits = maxValue == 0 ? 1 : bits::FloorLog(maxValue) + 1;
+
+  // The universe is one more than the max key for rank() to be defined on all the keys.
+  succinct::elias_fano::elias_fano_builder keysBuilder(elements.back().first + 1, m_count);
+  succinct::bit_vector_builder valuesBuilder;
+  valuesBuilder.reserve(m_count * m_valueBits);
+  for (auto const & element : elements)
+  {
+    keysBuilder.push_back(element.first);
+    valuesBuilder.append_bits(element.second, m_valueBits);
+  }
+
+  succinct::elias_fano(&keysBuilder, true /* with_rank_index */).swap(m_keys);
+  succinct::bit_vector(&valuesBuilder).swap(m_values);
+}
+
+SuccinctOffsetsIndex::SuccinctOffsetsIndex(string const & filename)
+{
+  m_fileMap.open(filename);
+  if (!m_fileMap.is_open())
+    MYTHROW(Reader::OpenException, ("Failed to open", filename));
+
+  succinct::mapper::map(*this, m_fileMap);
+}
+
+void SuccinctOffsetsIndex::Save(string const & filename)
+{
+  auto const filenameTmp = filename + EXTENSION_TMP;
+  succinct::mapper::freeze(*this, filenameTmp.c_str());
+  CHECK(base::RenameFileX(filenameTmp, filename), (filenameTmp, filename));
+}
+
+bool SuccinctOffsetsIndex::GetValueByKey(Key key, Value & value) const
+{
+  auto const i = LowerBound(key);
+  if (i == m_count || m_keys.select(i) != key)
+    return false;
+
+  value = GetValue(i);
+  return true;
+}
+
+uint64_t SuccinctOffsetsIndex::LowerBound(Key key) const
+{
+  if (m_count == 0 || key >= m_keys.size())
+    return m_count;
+
+  return m_keys.rank(key);
+}
+
 // IndexFileReader ---------------------------------------------------------------------------------
 IndexFileReader::IndexFileReader(string const & name)
 {
@@ -312,6 +825,27 @@ IndexFileReader::IndexFileReader(string const & name)
   if (fileSize == 0)
     return;
 
+  auto const succinctIndexName = name + SUCCINCT_OFFSET_EXT;
+  if (Platform::IsFileExistsByFullPath(succinctIndexName))
+  {
+    auto index = make_unique<SuccinctOffsetsIndex>(succinctIndexName);
+    if (index->GetSourceSize() == fileSize)
+    {
+      LOG_SHORT(LINFO, ("Offsets are mapped from", succinctIndexName));
+      m_succinctIndex = move(index);
+      return;
+    }
+
+    LOG_SHORT(LWARNING, ("Succinct index", succinctIndexName, "is outdated, skip it"));
+  }
+
+  m_elements = LoadElements(name, fileSize);
+}
+
+// static
+vector<IndexFileReader::Element> IndexFileReader::LoadElements(string const & name,
+                                                               uint64_t fileSize)
+{
   auto fileStream = std::ifstream{};
   fileStream.exceptions(std::ifstream::failbit);
   fileStream.open(name, std::ios::binary);
@@ -319,24 +853,39 @@ IndexFileReader::IndexFileReader(string const & name)
   LOG_SHORT(LINFO, ("Offsets reading is started for file", name));
   CHECK_EQUAL(0, fileSize % sizeof(Element), ("Damaged file."));
 
+  vector<Element> elements;
   try
   {
-    m_elements.resize(base::checked_cast<size_t>(fileSize / sizeof(Element)));
+    elements.resize(base::checked_cast<size_t>(fileSize / sizeof(Element)));
   }
   catch (bad_alloc const &)
   {
     LOG(LCRITICAL, ("Insufficient memory for required offset map"));
   }
 
-  fileStream.read(reinterpret_cast<char*>(&m_elements[0]), base::checked_cast<size_t>(fileSize));
+  fileStream.read(reinterpret_cast<char*>(&elements[0]), base::checked_cast<size_t>(fileSize));
 
-  sort(m_elements.begin(), m_elements.end(), ElementComparator());
+  // The offsets of the elements cache are written sorted, see ConcurrentIndexFileWriter.
+  if (!is_sorted(elements.begin(), elements.end(), ElementComparator()))
+    sort(elements.begin(), elements.end(), ElementComparator());
 
   LOG_SHORT(LINFO, ("Offsets reading is finished"));
+  return elements;
+}
+
+// static
+void IndexFileReader::BuildSuccinctIndex(string const & name)
+{
+  uint64_t const fileSize = boost::filesystem::file_size(name);
+  auto const elements = fileSize == 0 ? vector<Element>{} : LoadElements(name, fileSize);
+  SuccinctOffsetsIndex(elements, fileSize).Save(name + SUCCINCT_OFFSET_EXT);
 }
 
 bool IndexFileReader::GetValueByKey(Key key, Value & value) const
 {
+  if (m_succinctIndex)
+    return m_succinctIndex->GetValueByKey(key, value);
+
   auto it = lower_bound(m_elements.begin(), m_elements.end(), key, ElementComparator());
   if (it != m_elements.end() && it->first == key)
   {
@@ -362,6 +911,13 @@ void IndexFileWriter::WriteAll()
   m_elements.clear();
 }
 
+void IndexFileWriter::WriteAllWithSuccinctIndex()
+{
+  WriteAll();
+  m_fileWriter.Flush();
+  IndexFileReader::BuildSuccinctIndex(m_fileWriter.GetName());
+}
+
 void IndexFileWriter::Add(Key k, Value const & v)
 {
   if (m_elements.size() > kFlushCount)
@@ -370,11 +926,141 @@ void IndexFileWriter::Add(Key k, Value const & v)
   m_elements.emplace_back(k, v);
 }
 
+// ConcurrentIndexFileWriter -----------------------------------------------------------------------
+ConcurrentIndexFileWriter::ConcurrentIndexFileWriter(string const & name, size_t flushCount)
+  : m_shards(max(thread::hardware_concurrency(), 1u))
+  , m_shardFlushCount(max(flushCount / m_shards.size(), size_t{1}))
+  , m_name(name)
+  , m_fileWriter(make_unique<FileWriter>(name))
+{
+}
+
+void ConcurrentIndexFileWriter::Add(Key k, Value const & v)
+{
+  auto & shard = GetThreadShard();
+  vector<Element> run;
+  {
+    lock_guard<mutex> lock(shard.m_mutex);
+    shard.m_elements.emplace_back(k, v);
+    if (shard.m_elements.size() < m_shardFlushCount)
+      return;
+
+    run.swap(shard.m_elements);
+  }
+  WriteRun(run);
+}
+
+void ConcurrentIndexFileWriter::Add(vector<Element> const & elements, Value offset)
+{
+  auto & shard = GetThreadShard();
+  vector<Element> run;
+  {
+    lock_guard<mutex> lock(shard.m_mutex);
+    for (auto const & element : elements)
+      shard.m_elements.emplace_back(element.first, offset + element.second);
+    if (shard.m_elements.size() < m_shardFlushCount)
+      return;
+
+    run.swap(shard.m_elements);
+  }
+  WriteRun(run);
+}
+
+void ConcurrentIndexFileWriter::WriteAll()
+{
+  for (auto & shard : m_shards)
+  {
+    WriteRun(shard.m_elements);
+    vector<Element>().swap(shard.m_elements);
+  }
+
+  m_fileWriter.reset();
+  MergeRuns();
+}
+
+void ConcurrentIndexFileWriter::WriteAllWithSuccinctIndex()
+{
+  WriteAll();
+  IndexFileReader::BuildSuccinctIndex(m_name);
+}
+
+ConcurrentIndexFileWriter::Shard & ConcurrentIndexFileWriter::GetThreadShard()
+{
+  // The threads are numbered in the order of their first writes, so the shards of the threads
+  // differ while the threads are not more than the shards.
+  static atomic<size_t> threadsCount{0};
+  thread_local size_t const threadIndex = threadsCount++;
+  return m_shards[threadIndex % m_shards.size()];
+}
+
+void ConcurrentIndexFileWriter::WriteRun(vector<Element> & elements)
+{
+  if (elements.empty())
+    return;
+
+  sort(elements.begin(), elements.end());
+
+  lock_guard<mutex> lock(m_fileWriterMutex);
+  Run run;
+  run.m_begin = m_fileWriter->Pos() / sizeof(Element);
+  m_fileWriter->Write(elements.data(), elements.size() * sizeof(Element));
+  run.m_end = run.m_begin + elements.size();
+  m_runs.push_back(run);
+}
+
+void ConcurrentIndexFileWriter::MergeRuns()
+{
+  if (m_runs.size() <= 1)
+    return;
+
+  LOG_SHORT(LINFO, ("Merging", m_runs.size(), "runs of offsets of", m_name));
+  boost::iostreams::mapped_file_source fileMap(m_name);
+  auto const * elements = reinterpret_cast<Element const *>(fileMap.data());
+
+  // The heads of the runs by the elements, the least element is on the top.
+  using Head = pair<Element, size_t>;
+  priority_queue<Head, vector<Head>, greater<Head>> heads;
+  auto runs = m_runs;
+  for (size_t i = 0; i < runs.size(); ++i)
+    heads.emplace(elements[runs[i].m_begin++], i);
+
+  auto const mergedName = m_name + ".merged";
+  {
+    FileWriter writer(mergedName);
+    vector<Element> buffer;
+    buffer.reserve(m_shardFlushCount);
+    while (!heads.empty())
+    {
+      auto const head = heads.top();
+      heads.pop();
+      buffer.push_back(head.first);
+      if (buffer.size() == buffer.capacity())
+      {
+        writer.Write(buffer.data(), buffer.size() * sizeof(Element));
+        buffer.clear();
+      }
+
+      auto & run = runs[head.second];
+      if (run.m_begin != run.m_end)
+        heads.emplace(elements[run.m_begin++], head.second);
+    }
+    writer.Write(buffer.data(), buffer.size() * sizeof(Element));
+  }
+
+  fileMap.close();
+  CHECK(base::RenameFileX(mergedName, m_name), (mergedName, m_name));
+  m_runs.clear();
+}
+
 // OSMElementCacheReader ---------------------------------------------------------------------------
 OSMElementCacheReader::OSMElementCacheReader(string const & name)
   : m_offsetsReader(name + OFFSET_EXT)
   , m_name(name)
 {
+  auto const overlayName = name + OVERLAY_EXT;
+  if (Platform::IsFileExistsByFullPath(overlayName + OFFSET_EXT))
+    m_overlay = make_unique<OSMElementCacheReader>(overlayName);
+
   if (!Platform::IsFileExistsByFullPath(name) || !boost::filesystem::file_size(name))
     return;
 
@@ -389,16 +1075,119 @@ OSMElementCacheReader::OSMElementCacheReader(string const & name)
   readaheadTask.detach();
 }
 
+bool OSMElementCacheReader::IsOverlaid(Key id) const
+{
+  uint64_t pos = 0;
+  return m_overlay && m_overlay->m_offsetsReader.GetValueByKey(id, pos);
+}
+
+void OSMElementCacheReader::Prefetch(std::vector<Key> const & ids) const
+{
+  if (ids.size() < 2 || !m_fileMap.is_open())
+    return;
+
+  std::vector<uint64_t> offsets;
+  offsets.reserve(ids.size());
+  for (auto const id : ids)
+  {
+    uint64_t pos = 0;
+    if (m_offsetsReader.GetValueByKey(id, pos))
+      offsets.push_back(pos);
+  }
+  std::sort(offsets.begin(), offsets.end());
+
+  // The sizes of the values are not read to not fault on them, most of the values
+  // fit into kPrefetchSize bytes.
+  static auto const pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  uint64_t constexpr kPrefetchSize = 4 * 1024;
+  auto const adviseRange = [this](uint64_t begin, uint64_t end) {
+    end = std::min<uint64_t>(end, m_fileMap.size());
+    ::madvise(const_cast<char *>(m_fileMap.data()) + begin, end - begin, MADV_WILLNEED);
+  };
+
+  uint64_t rangeBegin = 0;
+  uint64_t rangeEnd = 0;
+  for (auto const pos : offsets)
+  {
+    auto const begin = pos / pageSize * pageSize;
+    auto const end = begin + (pos - begin + kPrefetchSize + pageSize - 1) / pageSize * pageSize;
+    if (rangeEnd != 0 && begin <= rangeEnd)
+    {
+      rangeEnd = std::max(rangeEnd, end);
+      continue;
+    }
+
+    if (rangeEnd != 0)
+      adviseRange(rangeBegin, rangeEnd);
+    rangeBegin = begin;
+    rangeEnd = end;
+  }
+
+  if (rangeEnd != 0)
+    adviseRange(rangeBegin, rangeEnd);
+}
+
 // OSMElementCacheWriter ---------------------------------------------------------------------------
+// static
+size_t constexpr OSMElementCacheWriter::kBufferSize;
+
 OSMElementCacheWriter::OSMElementCacheWriter(string const & name)
-  : m_fileWriter(name, FileWriter::OP_WRITE_TRUNCATE, 10 * 1024 * 1024 /* bufferSize */)
-  , m_currOffset{m_fileWriter.Pos()}
-  , m_offsets(name + OFFSET_EXT)
+  : m_offsets(name + OFFSET_EXT)
   , m_name(name)
 {
+  // Posix API are used for concurrent writes of the reserved ranges from threads.
+  ::mode_t const mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  m_file = ::open(name.c_str(), O_CREAT | O_WRONLY | O_TRUNC, mode);
+  if (m_file == -1)
+    MYTHROW(Writer::OpenException, ("Failed to open", name, strerror(errno)));
+
+  m_data.reserve(kBufferSize);
+}
+
+OSMElementCacheWriter::~OSMElementCacheWriter()
+{
+  FlushData();
+  ::close(m_file);
+}
+
+void OSMElementCacheWriter::SaveOffsets(bool withSuccinctIndex)
+{
+  FlushData();
+  if (withSuccinctIndex)
+    m_offsets.WriteAllWithSuccinctIndex();
+  else
+    m_offsets.WriteAll();
 }
 
-void OSMElementCacheWriter::SaveOffsets() { m_offsets.WriteAll(); }
+uint64_t OSMElementCacheWriter::WriteData(vector<uint8_t> const & data)
+{
+  auto const dataOffset = m_currOffset.fetch_add(data.size());
+  auto const * p = data.data();
+  auto size = data.size();
+  auto offset = dataOffset;
+  while (size != 0)
+  {
+    auto const written = ::pwrite(m_file, p, size, static_cast<off_t>(offset));
+    if (written == -1 && errno == EINTR)
+      continue;
+
+    CHECK_GREATER(written, 0, (m_name, strerror(errno)));
+    p += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+  return dataOffset;
+}
+
+void OSMElementCacheWriter::FlushData()
+{
+  if (m_data.empty())
+    return;
+
+  m_offsets.Add(m_dataOffsets, WriteData(m_data));
+  m_data.clear();
+  m_dataOffsets.clear();
+}
 
 // IntermediateDataReader
 IntermediateDataReader::IntermediateDataReader(feature::GenerateInfo const & info)
@@ -408,6 +1197,10 @@ IntermediateDataReader::IntermediateDataReader(feature::GenerateInfo const & inf
   , m_relations(info.GetIntermediateFileName(RELATIONS_FILE))
   , m_nodeToRelations(info.GetIntermediateFileName(NODES_FILE, ID2REL_EXT))
   , m_wayToRelations(info.GetIntermediateFileName(WAYS_FILE, ID2REL_EXT))
+  , m_nodeToRelationsOverlay(
+        ReadOverlayIndex(info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT ID2REL_EXT)))
+  , m_wayToRelationsOverlay(
+        ReadOverlayIndex(info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT ID2REL_EXT)))
 {}
 
 // IntermediateDataWriter
@@ -418,6 +1211,7 @@ IntermediateDataWriter::IntermediateDataWriter(PointStorageWriterInterface & nod
   , m_relations(info.GetIntermediateFileName(RELATIONS_FILE))
   , m_nodeToRelations(info.GetIntermediateFileName(NODES_FILE, ID2REL_EXT))
   , m_wayToRelations(info.GetIntermediateFileName(WAYS_FILE, ID2REL_EXT))
+  , m_succinctOffsets(info.m_succinctOffsets)
 {}
 
 void IntermediateDataWriter::AddNode(Key id, double lat, double lon)
@@ -472,27 +1266,196 @@ void IntermediateDataWriter::AddRelation(Key id, RelationElement const & e)
 
 void IntermediateDataWriter::SaveIndex()
 {
-  m_ways.SaveOffsets();
-  m_relations.SaveOffsets();
+  m_ways.SaveOffsets(m_succinctOffsets);
+  m_relations.SaveOffsets(m_succinctOffsets);
+
+  if (m_succinctOffsets)
+  {
+    m_nodeToRelations.WriteAllWithSuccinctIndex();
+    m_wayToRelations.WriteAllWithSuccinctIndex();
+  }
+  else
+  {
+    m_nodeToRelations.WriteAll();
+    m_wayToRelations.WriteAll();
+  }
+}
 
-  m_nodeToRelations.WriteAll();
-  m_wayToRelations.WriteAll();
+// IntermediateDataOverlayWriter
+IntermediateDataOverlayWriter::IntermediateDataOverlayWriter(feature::GenerateInfo const & info)
+  : m_info(info)
+{
+  Load();
+}
+
+void IntermediateDataOverlayWriter::AddNode(Key id, double lat, double lon)
+{
+  LatLon ll;
+  ToLatLon(lat, lon, ll);
+  m_nodes[id] = PackLatLon(ll);
+}
+
+void IntermediateDataOverlayWriter::AddWay(Key id, WayElement const & e)
+{
+  m_deletedWays.erase(id);
+  m_ways.erase(id);
+  m_ways.emplace(id, e);
+}
+
+void IntermediateDataOverlayWriter::AddRelation(Key id, RelationElement const & e)
+{
+  m_deletedRelations.erase(id);
+  m_relations[id] = e;
+}
+
+void IntermediateDataOverlayWriter::DeleteNode(Key id) { m_nodes[id] = PackLatLon(LatLon{}); }
+
+void IntermediateDataOverlayWriter::DeleteWay(Key id)
+{
+  m_ways.erase(id);
+  m_deletedWays.insert(id);
+}
+
+void IntermediateDataOverlayWriter::DeleteRelation(Key id)
+{
+  m_relations.erase(id);
+  m_deletedRelations.insert(id);
+}
+
+void IntermediateDataOverlayWriter::Save()
+{
+  {
+    IndexFileWriter nodes(m_info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT));
+    for (auto const & node : m_nodes)
+      nodes.Add(node.first, node.second);
+    nodes.WriteAll();
+  }
+
+  SaveElements(m_info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT), m_ways, m_deletedWays);
+  SaveElements(m_info.GetIntermediateFileName(RELATIONS_FILE, OVERLAY_EXT), m_relations,
+               m_deletedRelations);
+
+  IndexFileWriter nodeToRelations(
+      m_info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT ID2REL_EXT));
+  IndexFileWriter wayToRelations(m_info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT ID2REL_EXT));
+  for (auto const & relation : m_relations)
+  {
+    for (auto const & node : relation.second.nodes)
+      nodeToRelations.Add(node.first, relation.first);
+    for (auto const & way : relation.second.ways)
+      wayToRelations.Add(way.first, relation.first);
+  }
+  nodeToRelations.WriteAll();
+  wayToRelations.WriteAll();
+
+  LOG(LINFO, ("Overlay of", m_nodes.size(), "nodes,", m_ways.size() + m_deletedWays.size(),
+              "ways and", m_relations.size() + m_deletedRelations.size(), "relations is saved"));
+}
+
+// static
+void IntermediateDataOverlayWriter::Remove(feature::GenerateInfo const & info)
+{
+  for (auto const & name : {info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT),
+                            info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT),
+                            info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT OFFSET_EXT),
+                            info.GetIntermediateFileName(RELATIONS_FILE, OVERLAY_EXT),
+                            info.GetIntermediateFileName(RELATIONS_FILE, OVERLAY_EXT OFFSET_EXT),
+                            info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT ID2REL_EXT),
+                            info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT ID2REL_EXT)})
+  {
+    Platform::RemoveFileIfExists(name);
+  }
+}
+
+void IntermediateDataOverlayWriter::Load()
+{
+  auto const nodesName = m_info.GetIntermediateFileName(NODES_FILE, OVERLAY_EXT);
+  if (Platform::IsFileExistsByFullPath(nodesName))
+  {
+    uint64_t const fileSize = boost::filesystem::file_size(nodesName);
+    if (fileSize != 0)
+    {
+      for (auto const & node : IndexFileReader::LoadElements(nodesName, fileSize))
+        m_nodes[node.first] = node.second;
+    }
+  }
+
+  LoadElements(m_info.GetIntermediateFileName(WAYS_FILE, OVERLAY_EXT),
+               [](Key id) { return WayElement(id); }, m_ways, m_deletedWays);
+  LoadElements(m_info.GetIntermediateFileName(RELATIONS_FILE, OVERLAY_EXT),
+               [](Key) { return RelationElement(); }, m_relations, m_deletedRelations);
+}
+
+// static
+template <typename MakeElement, typename Element>
+void IntermediateDataOverlayWriter::LoadElements(string const & name, MakeElement && makeElement,
+                                                 map<Key, Element> & elements,
+                                                 set<Key> & deleted)
+{
+  auto const offsetsName = name + OFFSET_EXT;
+  if (!Platform::IsFileExistsByFullPath(offsetsName))
+    return;
+
+  uint64_t const fileSize = boost::filesystem::file_size(offsetsName);
+  if (fileSize == 0)
+    return;
+
+  vector<Key> ids;
+  for (auto const & offset : IndexFileReader::LoadElements(offsetsName, fileSize))
+  {
+    if (offset.second == kDeletedElementOffset)
+      deleted.insert(offset.first);
+    else
+      ids.push_back(offset.first);
+  }
+
+  OSMElementCacheReader const reader(name);
+  reader.ReadMany(ids, makeElement, [&elements](Key id, Element const & e) {
+    elements.emplace(id, e);
+  });
+}
+
+// static
+template <typename Element>
+void IntermediateDataOverlayWriter::SaveElements(string const & name,
+                                                 map<Key, Element> const & elements,
+                                                 set<Key> const & deleted)
+{
+  OSMElementCacheWriter writer(name);
+  for (auto const & element : elements)
+    writer.Write(element.first, element.second);
+  for (auto const id : deleted)
+    writer.WriteDeleted(id);
+  writer.SaveOffsets();
 }
 
 // Functions
 unique_ptr<PointStorageReaderInterface>
 CreatePointStorageReader(feature::GenerateInfo::NodeStorageType type, string const & name)
 {
+  unique_ptr<PointStorageReaderInterface> storage;
   switch (type)
   {
   case feature::GenerateInfo::NodeStorageType::File:
-    return make_unique<RawFilePointStorageMmapReader>(name);
+    storage = make_unique<RawFilePointStorageMmapReader>(name);
+    break;
   case feature::GenerateInfo::NodeStorageType::Index:
-    return make_unique<MapFilePointStorageReader>(name);
+    storage = make_unique<MapFilePointStorageReader>(name);
+    break;
   case feature::GenerateInfo::NodeStorageType::Memory:
-    return make_unique<RawMemPointStorageReader>(name);
+    storage = make_unique<RawMemPointStorageReader>(name);
+    break;
+  case feature::GenerateInfo::NodeStorageType::Compressed:
+    storage = make_unique<CompressedPointStorageReader>(name);
+    break;
   }
-  UNREACHABLE();
+  CHECK(storage, ());
+
+  auto const overlayName = name + OVERLAY_EXT;
+  if (!Platform::IsFileExistsByFullPath(overlayName))
+    return storage;
+
+  return make_unique<OverlayPointStorageReader>(move(storage), overlayName);
 }
 
 unique_ptr<PointStorageWriterInterface>
@@ -506,6 +1469,8 @@ CreatePointStorageWriter(feature::GenerateInfo::NodeStorageType type, string con
     return make_unique<MapFilePointStorageWriter>(name);
   case feature::GenerateInfo::NodeStorageType::Memory:
     return make_unique<RawMemPointStorageWriter>(name);
+  case feature::GenerateInfo::NodeStorageType::Compressed:
+    return make_unique<CompressedPointStorageWriter>(name);
   }
   UNREACHABLE();
 }
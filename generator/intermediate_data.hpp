@@ -3,22 +3,27 @@
 #include "generator/generate_info.hpp"
 #include "generator/intermediate_elements.hpp"
 
-#include "coding/buffered_file_writer.hpp"
 #include "coding/file_reader.hpp"
 #include "coding/file_writer.hpp"
 #include "coding/mmap_reader.hpp"
 
+#include "geometry/point2d.hpp"
+
 #include "base/assert.hpp"
 #include "base/control_flow.hpp"
 #include "base/file_name_utils.hpp"
 #include "base/logging.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -27,6 +32,19 @@
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-private-field"
+#endif
+
+#include "3party/succinct/bit_vector.hpp"
+#include "3party/succinct/elias_fano.hpp"
+#include "3party/succinct/mapper.hpp"
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
 #include "defines.hpp"
 
 // Classes for reading and writing any data in file with map of offsets for
@@ -38,6 +56,9 @@ namespace cache
 using Key = uint64_t;
 static_assert(std::is_integral<Key>::value, "Key must be an integral type");
 
+// The offset of the elements deleted by the overlay, see IntermediateDataOverlayWriter.
+uint64_t constexpr kDeletedElementOffset = std::numeric_limits<uint64_t>::max();
+
 // Used to store all world nodes inside temporary index file.
 // To find node by id, just calculate offset inside index file:
 // offset_in_file = sizeof(LatLon) * node_ID
@@ -74,6 +95,66 @@ class PointStorageReaderInterface
 public:
   virtual ~PointStorageReaderInterface() {}
   virtual bool GetPoint(uint64_t id, double & lat, double & lon) const = 0;
+  // Gets the points of |ids| in the order of |ids|, the lat and the lon of a point are its y
+  // and x. The points of the not found ids are zero. Returns false if a point is not found.
+  // The storages are read in the order of their pages, not in the order of |ids|.
+  virtual bool GetPoints(std::vector<uint64_t> const & ids,
+                         std::vector<m2::PointD> & points) const;
+};
+
+// A mapped index of the sorted (key, value) pairs of an offsets file: keys are Elias-Fano coded
+// and values are bit packed. It takes about 2 + log(maxKey / count) bits per key and
+// log(maxValue) bits per value instead of 16 bytes per pair, and the pages of the mapped
+// file are shared by all the processes reading the same intermediate data.
+class SuccinctOffsetsIndex
+{
+public:
+  using Value = uint64_t;
+  using Element = std::pair<Key, Value>;
+
+  // |elements| must be sorted by keys. |sourceSize| is the size of the offsets file
+  // to check that the index is built for it.
+  SuccinctOffsetsIndex(std::vector<Element> const & elements, uint64_t sourceSize);
+  explicit SuccinctOffsetsIndex(std::string const & filename);
+
+  void Save(std::string const & filename);
+
+  uint64_t GetSourceSize() const { return m_sourceSize; }
+  uint64_t GetCount() const { return m_count; }
+
+  bool GetValueByKey(Key key, Value & value) const;
+
+  template <typename ToDo>
+  void ForEachByKey(Key key, ToDo && toDo) const
+  {
+    for (auto i = LowerBound(key); i < m_count && m_keys.select(i) == key; ++i)
+    {
+      if (toDo(GetValue(i)) == base::ControlFlow::Break)
+        break;
+    }
+  }
+
+  template <typename Visitor>
+  void map(Visitor & visit)
+  {
+    visit(m_sourceSize, "m_sourceSize")
+        (m_count, "m_count")
+        (m_valueBits, "m_valueBits")
+        (m_keys, "m_keys")
+        (m_values, "m_values");
+  }
+
+private:
+  // Returns the index of the first key which is not less than |key|.
+  uint64_t LowerBound(Key key) const;
+  Value GetValue(uint64_t i) const { return m_values.get_bits(i * m_valueBits, m_valueBits); }
+
+  boost::iostreams::mapped_file_source m_fileMap;
+  uint64_t m_sourceSize = 0;
+  uint64_t m_count = 0;
+  uint64_t m_valueBits = 0;
+  succinct::elias_fano m_keys;
+  succinct::bit_vector m_values;
 };
 
 class IndexFileReader
@@ -82,13 +163,28 @@ public:
   using Value = uint64_t;
 
   IndexFileReader() = default;
+  // Maps the succinct index of |name| when it is built for the file, see BuildSuccinctIndex(),
+  // otherwise loads the file.
   explicit IndexFileReader(std::string const & name);
 
+  using Element = std::pair<Key, Value>;
+
+  // Builds SuccinctOffsetsIndex of the offsets file |name| to |name| + SUCCINCT_OFFSET_EXT.
+  static void BuildSuccinctIndex(std::string const & name);
+  // Reads the elements of the offsets file |name| of |fileSize| bytes sorted by keys.
+  static std::vector<Element> LoadElements(std::string const & name, uint64_t fileSize);
+
   bool GetValueByKey(Key key, Value & value) const;
 
   template <typename ToDo>
   void ForEachByKey(Key k, ToDo && toDo) const
   {
+    if (m_succinctIndex)
+    {
+      m_succinctIndex->ForEachByKey(k, std::forward<ToDo>(toDo));
+      return;
+    }
+
     auto range = std::equal_range(m_elements.begin(), m_elements.end(), k, ElementComparator());
     for (; range.first != range.second; ++range.first)
     {
@@ -98,8 +194,6 @@ public:
   }
 
 private:
-  using Element = std::pair<Key, Value>;
-
   struct ElementComparator
   {
     bool operator()(Element const & r1, Element const & r2) const
@@ -111,6 +205,7 @@ private:
   };
 
   std::vector<Element> m_elements;
+  std::unique_ptr<SuccinctOffsetsIndex> m_succinctIndex;
 };
 
 
@@ -122,6 +217,8 @@ public:
   explicit IndexFileWriter(std::string const & name);
 
   void WriteAll();
+  // Writes the pending elements and builds the succinct index of the file.
+  void WriteAllWithSuccinctIndex();
   void Add(Key k, Value const & v);
 
 private:
@@ -140,12 +237,44 @@ public:
   bool Read(Key id, Value & value) const
   {
     uint64_t pos = 0;
+    if (m_overlay && m_overlay->m_offsetsReader.GetValueByKey(id, pos))
+      return pos != kDeletedElementOffset && m_overlay->ReadAt(pos, value);
+
     if (!m_offsetsReader.GetValueByKey(id, pos))
     {
       LOG_SHORT(LWARNING, ("Can't find offset in file", m_name + OFFSET_EXT, "by id", id));
       return false;
     }
 
+    return ReadAt(pos, value);
+  }
+
+  // Returns true when the element |id| is replaced or deleted by the overlay.
+  bool IsOverlaid(Key id) const;
+
+  // Requests readahead of the pages of the values of |ids|. The values of a relation or
+  // of a way are scattered over the file, so on slow volumes their page faults are much
+  // cheaper when they are served by one batch of asynchronous reads.
+  void Prefetch(std::vector<Key> const & ids) const;
+
+  // Calls |toDo(id, value)| for |ids| in their order, missing values are skipped.
+  // |makeValue(id)| makes the value to read to.
+  template <typename MakeValue, typename ToDo>
+  void ReadMany(std::vector<Key> const & ids, MakeValue && makeValue, ToDo && toDo) const
+  {
+    Prefetch(ids);
+    for (auto const id : ids)
+    {
+      auto value = makeValue(id);
+      if (Read(id, value))
+        toDo(id, value);
+    }
+  }
+
+protected:
+  template <class Value>
+  bool ReadAt(uint64_t pos, Value & value) const
+  {
     uint32_t const valueSize = *(reinterpret_cast<uint32_t const *>(m_fileMap.data() + pos));
     size_t const valueOffset = pos + sizeof(uint32_t);
     MemReader reader(m_fileMap.data() + valueOffset, valueSize);
@@ -153,40 +282,98 @@ public:
     return true;
   }
 
-protected:
   boost::iostreams::mapped_file_source m_fileMap;
   IndexFileReader m_offsetsReader;
   std::string m_name;
+  // The elements of name + OVERLAY_EXT which take precedence over the ones of the file.
+  std::unique_ptr<OSMElementCacheReader> m_overlay;
+};
+
+// Writes the offsets of the elements added by the threads concurrently. The elements are added to
+// the per-thread shards, a full shard is sorted by the thread and is written as a sorted run to
+// the file. WriteAll() merges the runs, so the file is sorted by the keys.
+class ConcurrentIndexFileWriter
+{
+public:
+  using Value = uint64_t;
+  using Element = std::pair<Key, Value>;
+
+  // At most |flushCount| elements are kept in the memory of all the shards.
+  explicit ConcurrentIndexFileWriter(std::string const & name,
+                                     size_t flushCount = 10'000'000);
+
+  // Thread-safe.
+  void Add(Key k, Value const & v);
+  // Thread-safe. Adds |elements| with |offset| added to the values.
+  void Add(std::vector<Element> const & elements, Value offset);
+
+  // Writes the pending elements and merges the sorted runs of the file. The writer can not be
+  // used after the call.
+  void WriteAll();
+  // Also builds the succinct index of the file, see IndexFileReader::BuildSuccinctIndex().
+  void WriteAllWithSuccinctIndex();
+
+private:
+  struct Shard
+  {
+    std::mutex m_mutex;
+    std::vector<Element> m_elements;
+  };
+
+  // The elements [m_begin, m_end) of the file are sorted.
+  struct Run
+  {
+    uint64_t m_begin = 0;
+    uint64_t m_end = 0;
+  };
+
+  Shard & GetThreadShard();
+  void WriteRun(std::vector<Element> & elements);
+  void MergeRuns();
+
+  std::vector<Shard> m_shards;
+  size_t m_shardFlushCount;
+  std::string m_name;
+  std::unique_ptr<FileWriter> m_fileWriter;
+  std::mutex m_fileWriterMutex;
+  std::vector<Run> m_runs;
 };
 
+// Writes the elements to the file and their offsets to the file with OFFSET_EXT. The batches of
+// the elements are written by the threads concurrently: a thread reserves the range of the file
+// for the serialized batch by an atomic offset and writes it by pwrite().
 class OSMElementCacheWriter
 {
 public:
+  static size_t constexpr kBufferSize = 10 * 1024 * 1024;
+
   explicit OSMElementCacheWriter(std::string const & name);
+  ~OSMElementCacheWriter();
+
+  OSMElementCacheWriter(OSMElementCacheWriter const &) = delete;
+  OSMElementCacheWriter & operator=(OSMElementCacheWriter const &) = delete;
 
+  // No thread-safety. The elements are buffered and are written by the batches.
   template <typename Value>
   void Write(Key id, Value const & value)
   {
-    m_offsets.Add(id, m_currOffset);
-    m_data.clear();
-    MemWriter<decltype(m_data)> w(m_data);
+    MemWriter<decltype(m_data)> writer(m_data);
+    writer.Seek(m_data.size());
+    m_dataOffsets.emplace_back(id, writer.Pos());
+    WriteValue(value, writer);
 
-    value.Write(w);
-
-    ASSERT_LESS(m_data.size(), std::numeric_limits<uint32_t>::max(), ());
-    uint32_t sz = static_cast<uint32_t>(m_data.size());
-    m_fileWriter.Write(&sz, sizeof(sz));
-    m_fileWriter.Write(m_data.data(), sz);
-    m_currOffset += sizeof(sz) + sz;
+    if (m_data.size() >= kBufferSize)
+      FlushData();
   }
 
+  // Thread-safe.
   template <typename Key, typename Value>
   void Write(std::vector<std::pair<Key, Value>> const & elements, bool /* concurrent */)
   {
     auto data = std::vector<uint8_t>{};
     data.reserve(elements.size() * 1024);
 
-    auto elementsOffsets = std::vector<std::pair<Key, uint64_t>>{};
+    auto elementsOffsets = std::vector<ConcurrentIndexFileWriter::Element>{};
     elementsOffsets.reserve(elements.size());
 
     auto writer = MemWriter<decltype(data)>{data};
@@ -197,34 +384,20 @@ public:
       elementsOffsets.emplace_back(element.first, pos);
     }
 
-    uint64_t dataOffset = 0;
-
-    {
-      std::lock_guard<std::mutex> lock{m_fileWriterMutex};
-      dataOffset = m_currOffset;
-      m_fileWriter.Write(data.data(), data.size());
-      m_currOffset += data.size();
-    }
-
-    {
-      std::lock_guard<std::mutex> lock{m_offsetsMutex};
-      for (auto const & elementOffset : elementsOffsets)
-        m_offsets.Add(elementOffset.first, dataOffset + elementOffset.second);
-    }
+    m_offsets.Add(elementsOffsets, WriteData(data));
   }
 
-  void SaveOffsets();
+  // Writes the offset of a deleted element for the overlay, see IntermediateDataOverlayWriter.
+  void WriteDeleted(Key id) { m_offsets.Add(id, kDeletedElementOffset); }
 
-protected:
-  BufferedFileWriter m_fileWriter;
-  std::mutex m_fileWriterMutex;
-  uint64_t m_currOffset{0};
-  IndexFileWriter m_offsets;
-  std::mutex m_offsetsMutex;
-  std::string m_name;
-  std::vector<uint8_t> m_data;
+  // Also builds the succinct index of the offsets, see IndexFileReader::BuildSuccinctIndex().
+  void SaveOffsets(bool withSuccinctIndex = false);
 
 private:
+  // Thread-safe. Writes |data| to the reserved range of the file and returns its offset.
+  uint64_t WriteData(std::vector<uint8_t> const & data);
+  void FlushData();
+
   template <typename Value, typename Writer>
   void WriteValue(Value const & element, Writer & writer)
   {
@@ -242,6 +415,14 @@ private:
     writer.Write(&elementDataSize, sizeof(elementDataSize));
     writer.Seek(elementDataEndPos);
   }
+
+  int m_file = -1;
+  std::atomic<uint64_t> m_currOffset{0};
+  ConcurrentIndexFileWriter m_offsets;
+  std::string m_name;
+  // The buffered elements of Write(id, value) and their offsets in the buffer.
+  std::vector<uint8_t> m_data;
+  std::vector<ConcurrentIndexFileWriter::Element> m_dataOffsets;
 };
 
 class IntermediateDataReader
@@ -251,32 +432,84 @@ public:
 
   // TODO |GetNode()|, |lat|, |lon| are used as y, x in real.
   bool GetNode(Key id, double & lat, double & lon) const { return m_nodes->GetPoint(id, lat, lon); }
+  // |points| are like the ones of GetNode(), see PointStorageReaderInterface::GetPoints().
+  bool GetNodes(std::vector<Key> const & ids, std::vector<m2::PointD> & points) const
+  {
+    return m_nodes->GetPoints(ids, points);
+  }
   bool GetWay(Key id, WayElement & e) const { return m_ways.Read(id, e); }
 
+  // Calls |toDo(id, way)| for the found ways of |ids| in their order, see
+  // OSMElementCacheReader::Prefetch().
+  template <typename ToDo>
+  void ForEachWay(std::vector<Key> const & ids, ToDo && toDo) const
+  {
+    m_ways.ReadMany(ids, [](Key id) { return WayElement(id); }, std::forward<ToDo>(toDo));
+  }
+
   template <typename ToDo>
   void ForEachRelationByWay(Key id, ToDo && toDo) const
   {
     RelationProcessor<ToDo> processor(m_relations, std::forward<ToDo>(toDo));
-    m_wayToRelations.ForEachByKey(id, processor);
+    ForEachRelation(m_wayToRelations, m_wayToRelationsOverlay, id, processor);
   }
 
-  template <typename ToDo>
-  void ForEachRelationByWayCached(Key id, ToDo && toDo) const
+  struct NotCached
+  {
+    bool operator()(Key) const { return false; }
+  };
+
+  // |isCached(relationId)| returns true for the relations which |toDo| doesn't read, they are
+  // not prefetched.
+  template <typename ToDo, typename IsCached = NotCached>
+  void ForEachRelationByWayCached(Key id, ToDo && toDo, IsCached && isCached = {}) const
   {
     CachedRelationProcessor<ToDo> processor(m_relations, std::forward<ToDo>(toDo));
-    m_wayToRelations.ForEachByKey(id, processor);
+    ForEachRelation(m_wayToRelations, m_wayToRelationsOverlay, id, processor, isCached);
   }
 
-  template <typename ToDo>
-  void ForEachRelationByNodeCached(Key id, ToDo && toDo) const
+  template <typename ToDo, typename IsCached = NotCached>
+  void ForEachRelationByNodeCached(Key id, ToDo && toDo, IsCached && isCached = {}) const
   {
     CachedRelationProcessor<ToDo> processor(m_relations, std::forward<ToDo>(toDo));
-    m_nodeToRelations.ForEachByKey(id, processor);
+    ForEachRelation(m_nodeToRelations, m_nodeToRelationsOverlay, id, processor, isCached);
   }
 
 private:
   using CacheReader = cache::OSMElementCacheReader;
 
+  // The relations of |id| are prefetched before they are processed in the index order.
+  // The relations changed by the overlay are taken from |overlayIndex| only.
+  template <typename Processor, typename IsCached = NotCached>
+  void ForEachRelation(IndexFileReader const & index, IndexFileReader const & overlayIndex, Key id,
+                       Processor & processor, IsCached const & isCached = {}) const
+  {
+    std::vector<Key> relationIds;
+    index.ForEachByKey(id, [&](uint64_t relationId) {
+      if (!m_relations.IsOverlaid(relationId))
+        relationIds.push_back(relationId);
+      return base::ControlFlow::Continue;
+    });
+    overlayIndex.ForEachByKey(id, [&relationIds](uint64_t relationId) {
+      relationIds.push_back(relationId);
+      return base::ControlFlow::Continue;
+    });
+
+    if (relationIds.size() > 1)
+    {
+      std::vector<Key> notCachedIds;
+      std::copy_if(relationIds.cbegin(), relationIds.cend(), std::back_inserter(notCachedIds),
+                   [&isCached](Key relationId) { return !isCached(relationId); });
+      m_relations.Prefetch(notCachedIds);
+    }
+
+    for (auto const relationId : relationIds)
+    {
+      if (processor(relationId) == base::ControlFlow::Break)
+        break;
+    }
+  }
+
   template <typename Element, typename ToDo>
   class ElementProcessorBase
   {
@@ -317,6 +550,8 @@ private:
   cache::OSMElementCacheReader m_relations;
   cache::IndexFileReader m_nodeToRelations;
   cache::IndexFileReader m_wayToRelations;
+  cache::IndexFileReader m_nodeToRelationsOverlay;
+  cache::IndexFileReader m_wayToRelationsOverlay;
 };
 
 class IntermediateDataWriter
@@ -358,6 +593,7 @@ private:
   std::mutex m_nodeToRelationsUpdateMutex;
   cache::IndexFileWriter m_wayToRelations;
   std::mutex m_wayToRelationsUpdateMutex;
+  bool m_succinctOffsets = false;
 };
 
 std::unique_ptr<PointStorageReaderInterface>
@@ -366,6 +602,49 @@ CreatePointStorageReader(feature::GenerateInfo::NodeStorageType type, std::strin
 std::unique_ptr<PointStorageWriterInterface>
 CreatePointStorageWriter(feature::GenerateInfo::NodeStorageType type, std::string const & name);
 
+// Keeps the changes of the intermediate data made after the preprocessing in the overlay files
+// (the names of the preprocessed files + OVERLAY_EXT). The overlay takes precedence over
+// the preprocessed data by ids, so applying a diff does not rewrite the whole cache.
+// The changes of the existing overlay are loaded and merged with the new ones.
+class IntermediateDataOverlayWriter
+{
+public:
+  explicit IntermediateDataOverlayWriter(feature::GenerateInfo const & info);
+
+  void AddNode(Key id, double lat, double lon);
+  void AddWay(Key id, WayElement const & e);
+  void AddRelation(Key id, RelationElement const & e);
+
+  void DeleteNode(Key id);
+  void DeleteWay(Key id);
+  void DeleteRelation(Key id);
+
+  void Save();
+
+  // Removes the overlay of |info|, the overlay is outdated by the preprocessing.
+  static void Remove(feature::GenerateInfo const & info);
+
+private:
+  void Load();
+
+  // |makeElement(id)| makes the element to read to, see OSMElementCacheReader::ReadMany().
+  template <typename MakeElement, typename Element>
+  static void LoadElements(std::string const & name, MakeElement && makeElement,
+                           std::map<Key, Element> & elements, std::set<Key> & deleted);
+
+  template <typename Element>
+  static void SaveElements(std::string const & name, std::map<Key, Element> const & elements,
+                           std::set<Key> const & deleted);
+
+  feature::GenerateInfo const & m_info;
+  // Packed LatLon of the nodes, LatLon{} is a deleted node.
+  std::map<Key, uint64_t> m_nodes;
+  std::map<Key, WayElement> m_ways;
+  std::set<Key> m_deletedWays;
+  std::map<Key, RelationElement> m_relations;
+  std::set<Key> m_deletedRelations;
+};
+
 class IntermediateData
 {
 public:
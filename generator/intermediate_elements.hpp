@@ -7,6 +7,7 @@
 #include "coding/writer.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <map>
@@ -15,6 +16,10 @@
 #include <utility>
 #include <vector>
 
+// The version of the serialization of the elements, the intermediate data of another version
+// must be generated again.
+uint32_t constexpr kIntermediateElementsVersion = 1;
+
 struct NodeElement
 {
   uint64_t m_nodeOsmId;
@@ -56,13 +61,19 @@ struct WayElement
       std::for_each(nodes.rbegin(), nodes.rend(), std::ref(toDo));
   }
 
+  // The nodes of a way are usually close to each other in the ids, so the ids are saved
+  // as the signed varint deltas of the previous ones.
   template <class TWriter>
   void Write(TWriter & writer) const
   {
     uint64_t count = nodes.size();
     WriteVarUint(writer, count);
+    uint64_t prev = 0;
     for (uint64_t e : nodes)
-      WriteVarUint(writer, e);
+    {
+      WriteVarInt(writer, static_cast<int64_t>(e - prev));
+      prev = e;
+    }
   }
 
   template <class TReader>
@@ -71,8 +82,12 @@ struct WayElement
     ReaderSource<MemReader> r(reader);
     uint64_t count = ReadVarUint<uint64_t>(r);
     nodes.resize(count);
+    uint64_t prev = 0;
     for (uint64_t & e : nodes)
-      e = ReadVarUint<uint64_t>(r);
+    {
+      e = prev + static_cast<uint64_t>(ReadVarInt<int64_t>(r));
+      prev = e;
+    }
   }
 
   std::string ToString() const
@@ -0,0 +1,303 @@
+#include "generator/json_writer.hpp"
+
+#include "base/assert.hpp"
+#include "base/exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "3party/utfcpp/source/utf8.h"
+
+namespace generator
+{
+namespace
+{
+// The same string as the one of jansson json_string(): it is cut by the first zero char and it
+// is not created for the invalid utf8.
+bool MakeJsonString(char const * value, std::string & result)
+{
+  auto const end = value + std::strlen(value);
+  if (!utf8::is_valid(value, end))
+    return false;
+
+  result.assign(value, end);
+  return true;
+}
+}  // namespace
+
+// JsonWriter --------------------------------------------------------------------------------------
+
+JsonWriter::JsonWriter(std::string & out, int precision)
+  : m_stream(out), m_writer(m_stream), m_precision(precision)
+{
+}
+
+void JsonWriter::Double(double value)
+{
+  CHECK(std::isfinite(value), (value));
+
+  // As jsonp_dtostr() of jansson.
+  char buffer[32];
+  auto length = std::snprintf(buffer, sizeof(buffer), "%.*g", m_precision, value);
+  CHECK(length > 0 && static_cast<size_t>(length) + 3 < sizeof(buffer), (value));
+
+  if (!std::strchr(buffer, '.') && !std::strchr(buffer, 'e'))
+  {
+    buffer[length++] = '.';
+    buffer[length++] = '0';
+    buffer[length] = '\0';
+  }
+
+  // The positive exponent is written without '+' and the exponent is written without leading
+  // zeros.
+  if (auto start = std::strchr(buffer, 'e'))
+  {
+    ++start;
+    auto end = start + 1;
+    if (*start == '-')
+      ++start;
+
+    while (*end == '0')
+      ++end;
+
+    if (end != start)
+    {
+      std::memmove(start, end, static_cast<size_t>(buffer + length + 1 - end));
+      length -= static_cast<int>(end - start);
+    }
+  }
+
+  m_writer.RawValue(buffer, static_cast<size_t>(length), rapidjson::kNumberType);
+}
+
+void JsonWriter::Json(json_t const * value)
+{
+  CHECK(value, ());
+
+  switch (json_typeof(value))
+  {
+  case JSON_OBJECT:
+  {
+    StartObject();
+    // The members are iterated in the order of the jansson dump.
+    for (auto it = json_object_iter(const_cast<json_t *>(value)); it;
+         it = json_object_iter_next(const_cast<json_t *>(value), it))
+    {
+      Key(json_object_iter_key(it));
+      Json(json_object_iter_value(it));
+    }
+    EndObject();
+    break;
+  }
+  case JSON_ARRAY:
+  {
+    StartArray();
+    for (size_t i = 0; i < json_array_size(value); ++i)
+      Json(json_array_get(value, i));
+    EndArray();
+    break;
+  }
+  case JSON_STRING:
+    m_writer.String(json_string_value(value), json_string_length(value));
+    break;
+  case JSON_INTEGER: Int(json_integer_value(value)); break;
+  case JSON_REAL: Double(json_real_value(value)); break;
+  case JSON_TRUE: m_writer.Bool(true); break;
+  case JSON_FALSE: m_writer.Bool(false); break;
+  case JSON_NULL: Null(); break;
+  }
+}
+
+// JsonObjectPatch::ValueWriter --------------------------------------------------------------------
+
+class JsonObjectPatch::ValueWriter : public boost::static_visitor<void>
+{
+public:
+  explicit ValueWriter(JsonWriter & writer) : m_writer(writer) {}
+
+  void operator()(json_t const * value) const { m_writer.Json(value); }
+  void operator()(std::unique_ptr<JsonObjectPatch> const & object) const
+  {
+    object->Write(m_writer);
+  }
+  void operator()(Null) const { m_writer.Null(); }
+  void operator()(std::string const & value) const { m_writer.String(value); }
+  void operator()(int64_t value) const { m_writer.Int(value); }
+  void operator()(double value) const { m_writer.Double(value); }
+  void operator()(std::vector<double> const & values) const
+  {
+    m_writer.StartArray();
+    for (auto const value : values)
+      m_writer.Double(value);
+    m_writer.EndArray();
+  }
+
+private:
+  JsonWriter & m_writer;
+};
+
+// JsonObjectPatch ---------------------------------------------------------------------------------
+
+JsonObjectPatch::JsonObjectPatch(json_t const * object)
+  : m_object(object), m_materialized(object == nullptr)
+{
+  CHECK(!object || json_is_object(object), ());
+}
+
+void JsonObjectPatch::Set(std::string const & key, std::string const & value)
+{
+  Set(key, value.c_str());
+}
+
+void JsonObjectPatch::Set(std::string const & key, char const * value)
+{
+  std::string string;
+  // jansson does not set the member without the value.
+  if (MakeJsonString(value, string))
+    SetValue(key, std::move(string));
+}
+
+void JsonObjectPatch::Set(std::string const & key, double value)
+{
+  if (std::isfinite(value))
+    SetValue(key, value);
+}
+
+void JsonObjectPatch::Set(std::string const & key, std::vector<double> const & values)
+{
+  std::vector<double> array;
+  array.reserve(values.size());
+  // jansson does not append the values which are not finite.
+  std::copy_if(values.cbegin(), values.cend(), std::back_inserter(array),
+               [](double value) { return std::isfinite(value); });
+  SetValue(key, std::move(array));
+}
+
+void JsonObjectPatch::SetNull(std::string const & key) { SetValue(key, Null{}); }
+
+void JsonObjectPatch::Set(std::string const & key, json_t const * value)
+{
+  CHECK(value, ());
+  SetValue(key, value);
+}
+
+void JsonObjectPatch::Remove(std::string const & key)
+{
+  if (!m_materialized && !json_object_get(m_object, key.c_str()))
+    return;
+
+  Materialize();
+  m_members.erase(std::remove_if(m_members.begin(), m_members.end(),
+                                 [&key](Member const & member) { return member.m_key == key; }),
+                  m_members.end());
+}
+
+JsonObjectPatch * JsonObjectPatch::GetObject(std::string const & key)
+{
+  if (!m_materialized && !json_is_object(json_object_get(m_object, key.c_str())))
+    return nullptr;
+
+  auto member = Find(key);
+  if (!member)
+    return nullptr;
+
+  if (auto object = boost::get<std::unique_ptr<JsonObjectPatch>>(&member->m_value))
+    return object->get();
+
+  auto source = boost::get<json_t const *>(&member->m_value);
+  if (!source || !json_is_object(*source))
+    return nullptr;
+
+  auto object = std::make_unique<JsonObjectPatch>(*source);
+  auto result = object.get();
+  member->m_value = std::move(object);
+  return result;
+}
+
+JsonObjectPatch & JsonObjectPatch::GetObligatoryObject(std::string const & key)
+{
+  auto object = GetObject(key);
+  if (!object)
+    MYTHROW(base::Json::Exception, ("Obligatory object field", key, "is absent."));
+
+  return *object;
+}
+
+JsonObjectPatch & JsonObjectPatch::GetOrCreateObject(std::string const & key)
+{
+  if (auto object = GetObject(key))
+    return *object;
+
+  auto object = std::make_unique<JsonObjectPatch>();
+  auto result = object.get();
+  SetValue(key, std::move(object));
+  return *result;
+}
+
+json_t const * JsonObjectPatch::GetSource(std::string const & key) const
+{
+  if (!m_materialized)
+    return json_object_get(m_object, key.c_str());
+
+  auto const it = std::find_if(m_members.cbegin(), m_members.cend(),
+                               [&key](Member const & member) { return member.m_key == key; });
+  if (it == m_members.cend())
+    return nullptr;
+
+  auto source = boost::get<json_t const *>(&it->m_value);
+  return source ? *source : nullptr;
+}
+
+void JsonObjectPatch::Write(JsonWriter & writer) const
+{
+  if (!m_materialized)
+  {
+    writer.Json(m_object);
+    return;
+  }
+
+  ValueWriter const valueWriter(writer);
+  writer.StartObject();
+  for (auto const & member : m_members)
+  {
+    writer.Key(member.m_key);
+    boost::apply_visitor(valueWriter, member.m_value);
+  }
+  writer.EndObject();
+}
+
+void JsonObjectPatch::Materialize()
+{
+  if (m_materialized)
+    return;
+
+  m_members.reserve(json_object_size(m_object) + 1);
+  for (auto it = json_object_iter(const_cast<json_t *>(m_object)); it;
+       it = json_object_iter_next(const_cast<json_t *>(m_object), it))
+  {
+    json_t const * value = json_object_iter_value(it);
+    m_members.push_back({json_object_iter_key(it), value});
+  }
+  m_materialized = true;
+}
+
+JsonObjectPatch::Member * JsonObjectPatch::Find(std::string const & key)
+{
+  Materialize();
+  auto const it = std::find_if(m_members.begin(), m_members.end(),
+                               [&key](Member const & member) { return member.m_key == key; });
+  return it != m_members.end() ? &*it : nullptr;
+}
+
+void JsonObjectPatch::SetValue(std::string const & key, Value && value)
+{
+  if (auto member = Find(key))
+    member->m_value = std::move(value);
+  else
+    m_members.push_back({key, std::move(value)});
+}
+}  // namespace generator
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "coding/json.hpp"
+
+#include "3party/jansson/myjansson.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <boost/variant.hpp>
+
+namespace generator
+{
+// |JsonWriter| appends json to a string without building a jansson tree. The output is the same
+// as the output of the jansson dump with the JSON_COMPACT | JSON_REAL_PRECISION(|precision|) flags.
+class JsonWriter
+{
+public:
+  explicit JsonWriter(std::string & out, int precision);
+
+  void StartObject() { m_writer.StartObject(); }
+  void EndObject() { m_writer.EndObject(); }
+  void StartArray() { m_writer.StartArray(); }
+  void EndArray() { m_writer.EndArray(); }
+
+  void Key(std::string const & key) { m_writer.Key(key.data(), key.size()); }
+  void Key(char const * key) { m_writer.Key(key); }
+
+  void Null() { m_writer.Null(); }
+  void String(std::string const & value) { m_writer.String(value.data(), value.size()); }
+  void String(char const * value) { m_writer.String(value); }
+  void Int(int64_t value) { m_writer.Int64(value); }
+  void Double(double value);
+  // Writes the jansson value as is.
+  void Json(json_t const * value);
+
+private:
+  class StringStream
+  {
+  public:
+    using Ch = char;
+
+    explicit StringStream(std::string & out) : m_out(out) {}
+
+    void Put(char c) { m_out.push_back(c); }
+    void Flush() {}
+
+  private:
+    std::string & m_out;
+  };
+
+  StringStream m_stream;
+  rapidjson::Writer<StringStream> m_writer;
+  int m_precision;
+};
+
+// |JsonObjectPatch| is the changes of a jansson object, which is written with the changes by
+// JsonWriter, so the object is not copied to change it. The unchanged members of the object are
+// not copied too. The members are written in the order of the same changes of the jansson object.
+class JsonObjectPatch
+{
+public:
+  struct Null
+  {
+  };
+
+  // The changes of the new empty object if |object| is nullptr.
+  explicit JsonObjectPatch(json_t const * object = nullptr);
+
+  // Sets the member as json_object_set(): the existing member keeps its position.
+  void Set(std::string const & key, std::string const & value);
+  void Set(std::string const & key, char const * value);
+  void Set(std::string const & key, double value);
+  void Set(std::string const & key, std::vector<double> const & values);
+  template <typename T, typename std::enable_if<std::is_integral<T>::value, void>::type * = nullptr>
+  void Set(std::string const & key, T value)
+  {
+    SetValue(key, static_cast<int64_t>(value));
+  }
+  void SetNull(std::string const & key);
+  // Sets the jansson value which is not copied.
+  void Set(std::string const & key, json_t const * value);
+
+  // Removes the member as json_object_del().
+  void Remove(std::string const & key);
+
+  // Returns the changes of the object member or nullptr if the member is not an object.
+  JsonObjectPatch * GetObject(std::string const & key);
+  // Throws base::Json::Exception if the member is not an object.
+  JsonObjectPatch & GetObligatoryObject(std::string const & key);
+  // The member is replaced by the new empty object if it is not an object.
+  JsonObjectPatch & GetOrCreateObject(std::string const & key);
+
+  // Returns the unchanged value of the member or nullptr.
+  json_t const * GetSource(std::string const & key) const;
+
+  void Write(JsonWriter & writer) const;
+
+  // Calls |fn(key, value)| for the members in the order they are written. |value| is
+  // json_t const * of an unchanged member, JsonObjectPatch const & of the changes of an object
+  // member, Null, std::string, int64_t, double or std::vector<double>.
+  template <typename Fn>
+  void ForEachMember(Fn && fn) const
+  {
+    if (!m_materialized)
+    {
+      auto object = const_cast<json_t *>(m_object);
+      for (auto it = json_object_iter(object); it; it = json_object_iter_next(object, it))
+        fn(json_object_iter_key(it), static_cast<json_t const *>(json_object_iter_value(it)));
+      return;
+    }
+
+    for (auto const & member : m_members)
+      boost::apply_visitor(MemberVisitor<Fn>(member.m_key.c_str(), fn), member.m_value);
+  }
+
+private:
+  using Value = boost::variant<json_t const *, std::unique_ptr<JsonObjectPatch>, Null, std::string,
+                               int64_t, double, std::vector<double>>;
+
+  class ValueWriter;
+
+  template <typename Fn>
+  class MemberVisitor : public boost::static_visitor<void>
+  {
+  public:
+    MemberVisitor(char const * key, Fn & fn) : m_key(key), m_fn(fn) {}
+
+    void operator()(std::unique_ptr<JsonObjectPatch> const & object) const
+    {
+      m_fn(m_key, static_cast<JsonObjectPatch const &>(*object));
+    }
+    template <typename Value>
+    void operator()(Value const & value) const
+    {
+      m_fn(m_key, value);
+    }
+
+  private:
+    char const * m_key;
+    Fn & m_fn;
+  };
+
+  struct Member
+  {
+    std::string m_key;
+    Value m_value;
+  };
+
+  // The members of |m_object| are copied to |m_members| before the first change.
+  void Materialize();
+  Member * Find(std::string const & key);
+  void SetValue(std::string const & key, Value && value);
+
+  json_t const * m_object = nullptr;
+  bool m_materialized = false;
+  std::vector<Member> m_members;
+};
+}  // namespace generator
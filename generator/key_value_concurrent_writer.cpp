@@ -7,23 +7,83 @@
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 namespace generator
 {
-KeyValueConcurrentWriter::KeyValueConcurrentWriter(
-    std::string const & keyValuePath, size_t bufferSize)
-  : m_bufferSize{bufferSize}
+namespace
+{
+int OpenKeyValueFile(std::string const & keyValuePath, int flags)
 {
   // Posix API are used for concurrent atomic write from threads.
   ::mode_t mode{S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH};
-  m_keyValueFile = ::open(keyValuePath.c_str(), O_CREAT | O_WRONLY | O_APPEND, mode);
-  if (m_keyValueFile == -1)
+  auto const file = ::open(keyValuePath.c_str(), O_CREAT | O_WRONLY | flags, mode);
+  if (file == -1)
   {
     throw std::runtime_error("failed to open file " + keyValuePath + ": " +
                              std::strerror(errno));
   }
+  return file;
+}
+}  // namespace
+
+// KeyValueConcurrentFile --------------------------------------------------------------------------
+
+KeyValueConcurrentFile::KeyValueConcurrentFile(std::string const & keyValuePath)
+  : m_keyValueFile{OpenKeyValueFile(keyValuePath, 0 /* flags */)}
+{
+  struct stat fileStat;
+  if (::fstat(m_keyValueFile, &fileStat) == -1)
+  {
+    ::close(m_keyValueFile);
+    throw std::runtime_error("failed to stat file " + keyValuePath + ": " +
+                             std::strerror(errno));
+  }
+  m_size = static_cast<uint64_t>(fileStat.st_size);
+}
+
+KeyValueConcurrentFile::~KeyValueConcurrentFile()
+{
+  ::close(m_keyValueFile);
+}
+
+void KeyValueConcurrentFile::Write(char const * data, size_t size)
+{
+  auto offset = m_size.fetch_add(size);
+  while (size != 0)
+  {
+    auto const written = ::pwrite(m_keyValueFile, data, size, static_cast<off_t>(offset));
+    if (written == -1 && errno == EINTR)
+      continue;
+
+    CHECK_GREATER(written, 0, (std::strerror(errno)));
+    data += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
 }
-  
+
+// KeyValueConcurrentWriter ------------------------------------------------------------------------
+
+// static
+size_t constexpr KeyValueConcurrentWriter::kDefaultBufferSize;
+
+KeyValueConcurrentWriter::KeyValueConcurrentWriter(
+    std::string const & keyValuePath, size_t bufferSize)
+  : m_keyValueFile{OpenKeyValueFile(keyValuePath, O_APPEND)}
+  , m_bufferSize{bufferSize}
+{
+  m_keyValueBuffer.reserve(m_bufferSize);
+}
+
+KeyValueConcurrentWriter::KeyValueConcurrentWriter(
+    std::shared_ptr<KeyValueConcurrentFile> keyValueFile, size_t bufferSize)
+  : m_sharedKeyValueFile{std::move(keyValueFile)}, m_bufferSize{bufferSize}
+{
+  CHECK(m_sharedKeyValueFile, ());
+  m_keyValueBuffer.reserve(m_bufferSize);
+}
+
 KeyValueConcurrentWriter::KeyValueConcurrentWriter(KeyValueConcurrentWriter && other)
 {
   *this = std::move(other);
@@ -32,45 +92,85 @@ KeyValueConcurrentWriter::KeyValueConcurrentWriter(KeyValueConcurrentWriter && o
 KeyValueConcurrentWriter & KeyValueConcurrentWriter::operator=(
     KeyValueConcurrentWriter && other)
 {
-  if (m_keyValueFile != -1)
-  {
-    FlushBuffer();
-    ::close(m_keyValueFile);
-    m_keyValueFile = -1;
-  }
+  Close();
 
   std::swap(m_keyValueFile, other.m_keyValueFile);
+  m_sharedKeyValueFile = std::move(other.m_sharedKeyValueFile);
   m_keyValueBuffer = std::move(other.m_keyValueBuffer);
   m_bufferSize = other.m_bufferSize;
+  m_hierarchyFile = std::move(other.m_hierarchyFile);
+  m_hierarchy = std::move(other.m_hierarchy);
+  other.m_keyValueBuffer.clear();
   return *this;
 }
 
 KeyValueConcurrentWriter::~KeyValueConcurrentWriter()
 {
-  if (m_keyValueFile == -1)
-    return;
+  Close();
+}
 
-  FlushBuffer();
-  ::close(m_keyValueFile);
+void KeyValueConcurrentWriter::SetHierarchyFile(
+    std::shared_ptr<KeyValueConcurrentFile> hierarchyFile)
+{
+  m_hierarchyFile = std::move(hierarchyFile);
 }
 
 void KeyValueConcurrentWriter::Write(base::GeoObjectId const & id, JsonValue const & jsonValue)
 {
   KeyValueStorage::SerializeFullLine(m_keyValueBuffer, id.GetEncodedId(), jsonValue);
+  if (m_hierarchyFile)
+    m_hierarchy.Add(id.GetEncodedId(), jsonValue);
+
+  if (m_keyValueBuffer.size() + 1'000 >= m_bufferSize)
+    FlushBuffer();
+}
 
-  if (size_t{m_keyValueBuffer.tellp()} + 1'000 >= m_bufferSize)
+void KeyValueConcurrentWriter::Write(base::GeoObjectId const & id, JsonObjectPatch const & value)
+{
+  KeyValueStorage::SerializeFullLine(m_keyValueBuffer, id.GetEncodedId(), value);
+  if (m_hierarchyFile)
+    m_hierarchy.Add(id.GetEncodedId(), value);
+
+  if (m_keyValueBuffer.size() + 1'000 >= m_bufferSize)
     FlushBuffer();
 }
 
 void KeyValueConcurrentWriter::FlushBuffer()
 {
-  auto const & data = m_keyValueBuffer.str();
-  if (data.empty())
+  if (m_hierarchyFile && !m_hierarchy.IsEmpty())
+  {
+    auto const chunk = m_hierarchy.ReleaseChunk();
+    m_hierarchyFile->Write(chunk.data(), chunk.size());
+  }
+
+  if (m_keyValueBuffer.empty())
+    return;
+
+  if (m_sharedKeyValueFile)
+  {
+    m_sharedKeyValueFile->Write(m_keyValueBuffer.data(), m_keyValueBuffer.size());
+  }
+  else
+  {
+    auto writed = ::write(m_keyValueFile, m_keyValueBuffer.data(), m_keyValueBuffer.size());
+    // Error if ::write() interrupted by a signal.
+    CHECK(static_cast<size_t>(writed) == m_keyValueBuffer.size(), ());
+  }
+  m_keyValueBuffer.clear();
+}
+
+void KeyValueConcurrentWriter::Close()
+{
+  if (m_keyValueFile == -1 && !m_sharedKeyValueFile)
     return;
 
-  auto writed = ::write(m_keyValueFile, data.data(), data.size());
-  // Error if ::write() interrupted by a signal.
-  CHECK(static_cast<size_t>(writed) == data.size(), ());
-  m_keyValueBuffer.str({});
+  FlushBuffer();
+  if (m_keyValueFile != -1)
+  {
+    ::close(m_keyValueFile);
+    m_keyValueFile = -1;
+  }
+  m_sharedKeyValueFile.reset();
+  m_hierarchyFile.reset();
 }
 }  // namespace generator
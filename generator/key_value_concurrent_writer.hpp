@@ -1,30 +1,71 @@
+#pragma once
+
+#include "generator/binary_hierarchy_collector.hpp"
 #include "generator/key_value_storage.hpp"
 
 #include "base/geo_object_id.hpp"
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
-#include <sstream>
 
 namespace generator
 {
+// |KeyValueConcurrentFile| is the KV-file which is shared by the writers of threads. The writers
+// reserve the ranges at the end of the file for their buffers, so the buffers are written in
+// parallel. The file is appended to the existing data.
+class KeyValueConcurrentFile
+{
+public:
+  explicit KeyValueConcurrentFile(std::string const & keyValuePath);
+  ~KeyValueConcurrentFile();
+
+  KeyValueConcurrentFile(KeyValueConcurrentFile const &) = delete;
+  KeyValueConcurrentFile & operator=(KeyValueConcurrentFile const &) = delete;
+
+  // Thread-safe.
+  void Write(char const * data, size_t size);
+
+private:
+  int m_keyValueFile{-1};
+  std::atomic<uint64_t> m_size{0};
+};
+
 // |KeyValueConcurrentWriter| allow concurrent write to the same KV-file by multiple instance of
 // this class from threads.
 class KeyValueConcurrentWriter
 {
 public:
-  KeyValueConcurrentWriter(std::string const & keyValuePath, size_t bufferSize = 1'000'000);
+  static size_t constexpr kDefaultBufferSize = 8'000'000;
+
+  // The instances write to the file opened in the append mode.
+  KeyValueConcurrentWriter(std::string const & keyValuePath,
+                           size_t bufferSize = kDefaultBufferSize);
+  // The instances write to the ranges of |keyValueFile|.
+  KeyValueConcurrentWriter(std::shared_ptr<KeyValueConcurrentFile> keyValueFile,
+                           size_t bufferSize = kDefaultBufferSize);
   KeyValueConcurrentWriter(KeyValueConcurrentWriter && other);
   KeyValueConcurrentWriter & operator=(KeyValueConcurrentWriter && other);
   ~KeyValueConcurrentWriter();
 
+  // The binary hierarchy entries of the values are written to |hierarchyFile| too, a chunk per
+  // the buffer, see BinaryHierarchyCollector.
+  void SetHierarchyFile(std::shared_ptr<KeyValueConcurrentFile> hierarchyFile);
+
   // No thread-safety.
   void Write(base::GeoObjectId const & id, JsonValue const & jsonValue);
+  void Write(base::GeoObjectId const & id, JsonObjectPatch const & value);
 
 private:
   int m_keyValueFile{-1};
-  std::ostringstream m_keyValueBuffer;
-  size_t m_bufferSize{1'000'000};
+  std::shared_ptr<KeyValueConcurrentFile> m_sharedKeyValueFile;
+  std::string m_keyValueBuffer;
+  size_t m_bufferSize{kDefaultBufferSize};
+  std::shared_ptr<KeyValueConcurrentFile> m_hierarchyFile;
+  BinaryHierarchyCollector m_hierarchy;
 
   void FlushBuffer();
+  void Close();
 };
 }  // namespace generator
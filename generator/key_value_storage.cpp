@@ -1,46 +1,294 @@
 #include "generator/key_value_storage.hpp"
 
+#include "coding/internal/file_data.hpp"
+#include "coding/mmap_reader.hpp"
 #include "coding/reader.hpp"
 
+#include "base/assert.hpp"
 #include "base/exception.hpp"
 #include "base/logging.hpp"
 
 #include <algorithm>
 #include <cstring>
-#include <iomanip>
-
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 namespace generator
 {
-KeyValueStorage::KeyValueStorage(std::string const & path)
+namespace
+{
+bool ParseKey(std::string const & idStr, std::streamoff lineNumber, uint64_t & key)
 {
-  auto storage = std::ifstream{path};
-  std::string line;
-  std::streamoff lineNumber = 0;
-  while (std::getline(storage, line))
+  if (!strings::to_uint64(idStr, key, 16))
+  {
+    LOG(LWARNING, ("Cannot parse id", idStr, "in line", lineNumber));
+    return false;
+  }
+
+  return true;
+}
+
+char const kKeyValueStorageTag[] = "key_value_storage";
+
+int AppendToString(char const * buffer, size_t size, void * data)
+{
+  static_cast<std::string *>(data)->append(buffer, size);
+  return 0;
+}
+}  // namespace
+
+// KeyValueStorage::LazyValues ---------------------------------------------------------------------
+class KeyValueStorage::LazyValues
+{
+public:
+  LazyValues(std::string const & path, size_t cacheSize) : m_cacheSize(cacheSize)
+  {
+    CHECK_GREATER(m_cacheSize, 0, ());
+
+    uint64_t fileSize = 0;
+    if (!base::GetFileSize(path, fileSize) || fileSize == 0)
+      return;
+
+    m_reader = std::make_unique<MmapReader>(path);
+    auto const begin = reinterpret_cast<char const *>(m_reader->Data());
+    auto const end = begin + fileSize;
+    std::streamoff lineNumber = 0;
+    for (auto lineBegin = begin; lineBegin < end;)
+    {
+      ++lineNumber;
+      auto lineEnd = static_cast<char const *>(std::memchr(lineBegin, '\n', end - lineBegin));
+      if (!lineEnd)
+        lineEnd = end;
+
+      auto const separator =
+          static_cast<char const *>(std::memchr(lineBegin, ' ', lineEnd - lineBegin));
+      uint64_t key;
+      if (!separator)
+        LOG(LWARNING, ("Cannot find separator in line", lineNumber));
+      else if (ParseKey(std::string(lineBegin, separator), lineNumber, key))
+        m_index.push_back({key, static_cast<uint64_t>(separator + 1 - begin),
+                           static_cast<uint64_t>(lineEnd - separator - 1)});
+
+      lineBegin = lineEnd + 1;
+    }
+
+    // The first value of a key wins as in the eager mode.
+    std::stable_sort(m_index.begin(), m_index.end(),
+                     [](Entry const & l, Entry const & r) { return l.m_key < r.m_key; });
+    m_index.erase(std::unique(m_index.begin(), m_index.end(),
+                              [](Entry const & l, Entry const & r) { return l.m_key == r.m_key; }),
+                  m_index.end());
+    m_index.shrink_to_fit();
+    m_indexMemory.Set(m_index.capacity() * sizeof(Entry));
+  }
+
+  std::shared_ptr<JsonValue> Find(uint64_t key)
   {
-    ++lineNumber;
+    auto const entry =
+        std::lower_bound(m_index.cbegin(), m_index.cend(), key,
+                         [](Entry const & e, uint64_t k) { return e.m_key < k; });
+    if (entry == m_index.cend() || entry->m_key != key)
+      return {};
 
-    uint64_t key;
-    auto value = std::string{};
-    if (!ParseKeyValueLine(line, lineNumber, key, value))
-      continue;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto const cached = m_cache.find(key);
+      if (cached != m_cache.end())
+      {
+        m_lru.splice(m_lru.begin(), m_lru, cached->second);
+        return cached->second->second;
+      }
+    }
 
     std::shared_ptr<JsonValue> json;
+    auto const data = reinterpret_cast<char const *>(m_reader->Data()) + entry->m_offset;
     try
     {
-      json = std::make_shared<JsonValue>(base::LoadFromString(value));
+      json = std::make_shared<JsonValue>(base::LoadFromString(std::string(data, entry->m_size)));
     }
     catch (base::Json::Exception const & e)
     {
-      LOG(LWARNING, ("Cannot create base::Json in line", lineNumber, ":", e.Msg()));
-      continue;
+      LOG(LWARNING, ("Cannot create base::Json for key", KeyValueStorage::SerializeDref(key), ":",
+                     e.Msg()));
+      return {};
     }
 
-    m_values.emplace(key, std::move(json));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const emplaced = m_cache.emplace(key, m_lru.end());
+    if (!emplaced.second)
+    {
+      // The value has been parsed by a concurrent Find().
+      m_lru.splice(m_lru.begin(), m_lru, emplaced.first->second);
+      return emplaced.first->second->second;
+    }
+
+    m_lru.emplace_front(key, json);
+    emplaced.first->second = m_lru.begin();
+    if (m_lru.size() > m_cacheSize)
+    {
+      m_cache.erase(m_lru.back().first);
+      m_lru.pop_back();
+    }
+
+    return json;
+  }
+
+  size_t Size() const { return m_index.size(); }
+
+private:
+  struct Entry
+  {
+    uint64_t m_key;
+    // The offset and the size of the value in the file.
+    uint64_t m_offset;
+    uint64_t m_size;
+  };
+
+  using CacheItem = std::pair<uint64_t, std::shared_ptr<JsonValue>>;
+
+  std::unique_ptr<MmapReader> m_reader;
+  std::vector<Entry> m_index;
+  base::memory::ScopedBytes m_indexMemory{base::memory::GetTag(kKeyValueStorageTag)};
+  size_t m_cacheSize;
+
+  std::mutex m_mutex;
+  // The recently found values are first.
+  std::list<CacheItem> m_lru;
+  std::unordered_map<uint64_t, std::list<CacheItem>::iterator> m_cache;
+};
+
+// KeyValueStorage ---------------------------------------------------------------------------------
+// static
+size_t constexpr KeyValueStorage::kDefaultCacheSize;
+
+KeyValueStorage::KeyValueStorage(std::string const & path, Mode mode, size_t cacheSize,
+                                 unsigned int threadsCount)
+{
+  switch (mode)
+  {
+  case Mode::Eager: LoadValues(path, threadsCount); break;
+  case Mode::Lazy: m_lazyValues = std::make_unique<LazyValues>(path, cacheSize); break;
   }
 }
 
+KeyValueStorage::~KeyValueStorage() = default;
+
+KeyValueStorage::KeyValueStorage(KeyValueStorage &&) = default;
+KeyValueStorage & KeyValueStorage::operator=(KeyValueStorage &&) = default;
+
+void KeyValueStorage::LoadValues(std::string const & path, unsigned int threadsCount)
+{
+  CHECK_GREATER(threadsCount, 0, ());
+
+  uint64_t fileSize = 0;
+  if (!base::GetFileSize(path, fileSize) || fileSize == 0)
+    return;
+
+  MmapReader reader(path);
+  reader.Advise(MmapReader::Advice::Sequential);
+  auto const begin = reinterpret_cast<char const *>(reader.Data());
+  auto const end = begin + fileSize;
+
+  // The ranges of whole lines: range i is [bounds[i], bounds[i + 1]).
+  std::vector<char const *> bounds{begin};
+  for (unsigned int i = 1; i < threadsCount; ++i)
+  {
+    auto bound = begin + fileSize * i / threadsCount;
+    if (bound <= bounds.back())
+    {
+      bound = bounds.back();
+    }
+    else
+    {
+      auto const newLine =
+          static_cast<char const *>(std::memchr(bound - 1, '\n', end - bound + 1));
+      bound = newLine ? newLine + 1 : end;
+    }
+    bounds.push_back(bound);
+  }
+  bounds.push_back(end);
+
+  auto const forEachRange = [threadsCount](auto && fn) {
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadsCount; ++i)
+      threads.emplace_back(fn, i);
+    for (auto & thread : threads)
+      thread.join();
+  };
+
+  // The lines are counted first, so the ranges are parsed with the right line numbers
+  // in the warnings.
+  std::vector<std::streamoff> firstLineNumbers(threadsCount + 1, 0);
+  forEachRange([&](unsigned int i) {
+    firstLineNumbers[i + 1] = std::count(bounds[i], bounds[i + 1], '\n');
+  });
+  firstLineNumbers[0] = 1;
+  for (unsigned int i = 1; i < threadsCount; ++i)
+    firstLineNumbers[i] += firstLineNumbers[i - 1];
+
+  struct Value
+  {
+    uint64_t m_key;
+    std::shared_ptr<JsonValue> m_json;
+    size_t m_size;
+  };
+
+  std::vector<std::vector<Value>> rangesValues(threadsCount);
+  forEachRange([&](unsigned int i) {
+    auto & values = rangesValues[i];
+    auto lineNumber = firstLineNumbers[i];
+    std::string line;
+    for (auto lineBegin = bounds[i]; lineBegin < bounds[i + 1]; ++lineNumber)
+    {
+      auto lineEnd = static_cast<char const *>(
+          std::memchr(lineBegin, '\n', bounds[i + 1] - lineBegin));
+      if (!lineEnd)
+        lineEnd = bounds[i + 1];
+      line.assign(lineBegin, lineEnd);
+      lineBegin = lineEnd + 1;
+
+      uint64_t key;
+      auto value = std::string{};
+      if (!ParseKeyValueLine(line, lineNumber, key, value))
+        continue;
+
+      try
+      {
+        values.push_back({key, std::make_shared<JsonValue>(base::LoadFromString(value)),
+                          value.size()});
+      }
+      catch (base::Json::Exception const & e)
+      {
+        LOG(LWARNING, ("Cannot create base::Json in line", lineNumber, ":", e.Msg()));
+      }
+    }
+  });
+
+  // The ranges are merged in the order of the file, so the first value of a key wins.
+  size_t valuesCount = 0;
+  for (auto const & values : rangesValues)
+    valuesCount += values.size();
+  m_values.reserve(valuesCount);
+
+  size_t valuesSize = 0;
+  for (auto & values : rangesValues)
+  {
+    for (auto & value : values)
+    {
+      if (m_values.emplace(value.m_key, std::move(value.m_json)).second)
+        valuesSize += value.m_size;
+    }
+    values = {};
+  }
+
+  m_valuesMemory = base::memory::ScopedBytes(
+      base::memory::GetTag(kKeyValueStorageTag),
+      valuesSize + m_values.size() * (sizeof(KeyValue) + sizeof(JsonValue)));
+}
+
 // static
 bool KeyValueStorage::ParseKeyValueLine(std::string const & line, std::streamoff lineNumber,
                                         uint64_t & key, std::string & value)
@@ -52,13 +300,8 @@ bool KeyValueStorage::ParseKeyValueLine(std::string const & line, std::streamoff
     return false;
   }
 
-  std::string idStr = line.substr(0, pos);
-
-  if (!strings::to_uint64(idStr, key, 16))
-  {
-    LOG(LWARNING, ("Cannot parse id", line.substr(0, pos), "in line", lineNumber));
+  if (!ParseKey(line.substr(0, pos), lineNumber, key))
     return false;
-  }
 
   value = line.c_str() + pos + 1;
   return true;
@@ -74,6 +317,33 @@ void KeyValueStorage::SerializeFullLine(
   out << SerializeDref(key) << " " << json << "\n";
 }
 
+// static
+void KeyValueStorage::SerializeFullLine(std::string & out, uint64_t key, JsonValue const & value)
+{
+  SerializeDref(out, key);
+  out += ' ';
+
+  auto const size = out.size();
+  auto const flags = JSON_COMPACT | JSON_REAL_PRECISION(kDefaultPrecision);
+  CHECK_EQUAL(json_dump_callback(value, &AppendToString, &out, flags), 0, ());
+  CHECK_GREATER(out.size(), size, ());
+
+  out += '\n';
+}
+
+// static
+void KeyValueStorage::SerializeFullLine(std::string & out, uint64_t key,
+                                        JsonObjectPatch const & value)
+{
+  SerializeDref(out, key);
+  out += ' ';
+
+  JsonWriter writer(out, kDefaultPrecision);
+  value.Write(writer);
+
+  out += '\n';
+}
+
 // static
 std::string KeyValueStorage::SerializeFullLine(uint64_t key, JsonValue const & jsonValue)
 {
@@ -84,6 +354,9 @@ std::string KeyValueStorage::SerializeFullLine(uint64_t key, JsonValue const & j
 
 std::shared_ptr<JsonValue> KeyValueStorage::Find(uint64_t key) const
 {
+  if (m_lazyValues)
+    return m_lazyValues->Find(key);
+
   auto const it = m_values.find(key);
   if (it == std::end(m_values))
     return {};
@@ -93,11 +366,27 @@ std::shared_ptr<JsonValue> KeyValueStorage::Find(uint64_t key) const
 
 std::string KeyValueStorage::SerializeDref(uint64_t number)
 {
-  std::stringstream stream;
-  stream << std::setw(16) << std::setfill('0') << std::hex << std::uppercase << number;
+  std::string result;
+  SerializeDref(result, number);
+  return result;
+}
 
-  return stream.str();
+// static
+void KeyValueStorage::SerializeDref(std::string & out, uint64_t number)
+{
+  // The 16 upper case hex digits with the leading zeros.
+  static char const kDigits[] = "0123456789ABCDEF";
+  auto const size = out.size();
+  out.resize(size + 16);
+  for (size_t i = 0; i < 16; ++i)
+  {
+    out[size + 15 - i] = kDigits[number & 0xF];
+    number >>= 4;
+  }
 }
 
-size_t KeyValueStorage::Size() const { return m_values.size(); }
+size_t KeyValueStorage::Size() const
+{
+  return m_lazyValues ? m_lazyValues->Size() : m_values.size();
+}
 }  // namespace generator
@@ -6,11 +6,15 @@
 #include <memory>
 #include <ostream>
 #include <string>
-#include <unordered_map>
 #include <utility>
 
 #include <boost/variant.hpp>
 
+#include "generator/json_writer.hpp"
+
+#include "base/flat_hash_map.hpp"
+#include "base/memory_accounting.hpp"
+
 #include "3party/jansson/myjansson.hpp"
 
 namespace generator
@@ -43,17 +47,36 @@ public:
   // millimeters. Also, if you are quizzed by nautical mile, just forget, precision was defined in
   // https://jira.mail.ru/browse/MAPSB2B-41
   static uint32_t constexpr kDefaultPrecision = 9;
+  static size_t constexpr kDefaultCacheSize = 100000;
 
-  explicit KeyValueStorage(std::string const & kvPath);
-
-  KeyValueStorage(KeyValueStorage &&) = default;
-  KeyValueStorage & operator=(KeyValueStorage &&) = default;
+  enum class Mode
+  {
+    // All the values are parsed on load.
+    Eager,
+    // The file is mmapped and only the keys are read on load. A value is parsed on the first
+    // Find() of it, at most |cacheSize| recently found values are kept parsed. The values
+    // are not validated on load: Size() counts the invalid values too.
+    Lazy
+  };
+
+  // In the eager mode the file is split into |threadsCount| ranges of whole lines,
+  // which are parsed concurrently.
+  explicit KeyValueStorage(std::string const & kvPath, Mode mode = Mode::Eager,
+                           size_t cacheSize = kDefaultCacheSize, unsigned int threadsCount = 1);
+  ~KeyValueStorage();
+
+  KeyValueStorage(KeyValueStorage &&);
+  KeyValueStorage & operator=(KeyValueStorage &&);
 
   KeyValueStorage(KeyValueStorage const &) = delete;
   KeyValueStorage & operator=(KeyValueStorage const &) = delete;
 
   static std::string SerializeFullLine(uint64_t key, JsonValue const & valueJson);
   static void SerializeFullLine(std::ostream & out, uint64_t key, JsonValue const & jsonValue);
+  // Appends the line to |out| without the intermediate strings.
+  static void SerializeFullLine(std::string & out, uint64_t key, JsonValue const & jsonValue);
+  // Appends the line to |out| with the value streamed by JsonWriter in the same format.
+  static void SerializeFullLine(std::string & out, uint64_t key, JsonObjectPatch const & value);
 
   std::shared_ptr<JsonValue> Find(uint64_t key) const;
   size_t Size() const;
@@ -64,10 +87,19 @@ public:
   }
 
   static std::string SerializeDref(uint64_t number);
+  static void SerializeDref(std::string & out, uint64_t number);
 
-private:
   static bool ParseKeyValueLine(std::string const & line, std::streamoff lineNumber, uint64_t & key,
                                 std::string & value);
-  std::unordered_map<uint64_t, std::shared_ptr<JsonValue>> m_values;
+
+private:
+  class LazyValues;
+
+  void LoadValues(std::string const & kvPath, unsigned int threadsCount);
+
+  base::FlatHashMap<uint64_t, std::shared_ptr<JsonValue>> m_values;
+  std::unique_ptr<LazyValues> m_lazyValues;
+  // The parsed values are estimated by the size of their text.
+  base::memory::ScopedBytes m_valuesMemory;
 };
 }  // namespace generator
@@ -65,6 +65,35 @@ private:
   vector<string> m_values;
 };
 
+// |lower| is an ascii lower case string.
+bool EqualsAsciiNoCase(string const & s, string const & lower)
+{
+  auto const equals = [](char c, char l) {
+    return (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) == l;
+  };
+  return s.size() == lower.size() && equal(s.cbegin(), s.cend(), lower.cbegin(), equals);
+}
+
+bool ParseLevels(string const & v, double & levels)
+{
+  auto const parse = [&levels](string const & str) {
+    char * stop;
+    char const * s = str.c_str();
+    levels = strtod(s, &stop);
+    return s != stop && isfinite(levels);
+  };
+
+  // Some mappers use full width unicode digits. We can handle that. The value is copied
+  // only when it is not ascii.
+  auto const isAscii = [](char c) { return static_cast<unsigned char>(c) < 0x80; };
+  if (all_of(v.cbegin(), v.cend(), isAscii))
+    return parse(v);
+
+  string normalized = v;
+  strings::NormalizeDigits(normalized);
+  return parse(normalized);
+}
+
 void CollapseMultipleConsecutiveCharsIntoOne(char c, string & str)
 {
   auto const comparator = [c](char lhs, char rhs) { return lhs == rhs && lhs == c; };
@@ -149,14 +178,20 @@ string MetadataTagProcessorImpl::ValidateAndFormat_flats(string const & v) const
   return v;
 }
 
-string MetadataTagProcessorImpl::ValidateAndFormat_internet(string v) const
+string MetadataTagProcessorImpl::ValidateAndFormat_internet(string const & v) const
 {
   // TODO(AlexZ): Reuse/synchronize this code with MapObject::SetInternet().
-  strings::AsciiToLower(v);
-  if (v == "wlan" || v == "wired" || v == "yes" || v == "no")
-    return v;
+  auto const equals = [&v](string const & value) { return EqualsAsciiNoCase(v, value); };
+  if (equals("wlan"))
+    return "wlan";
+  if (equals("wired"))
+    return "wired";
+  if (equals("yes"))
+    return "yes";
+  if (equals("no"))
+    return "no";
   // Process wifi=free tag.
-  if (v == "free")
+  if (equals("free"))
     return "wlan";
   return {};
 }
@@ -166,27 +201,19 @@ string MetadataTagProcessorImpl::ValidateAndFormat_height(string const & v) cons
   return measurement_utils::OSMDistanceToMetersString(v, false /*supportZeroAndNegativeValues*/, 1);
 }
 
-string MetadataTagProcessorImpl::ValidateAndFormat_building_levels(string v) const
+string MetadataTagProcessorImpl::ValidateAndFormat_building_levels(string const & v) const
 {
-  // Some mappers use full width unicode digits. We can handle that.
-  strings::NormalizeDigits(v);
-  char * stop;
-  char const * s = v.c_str();
-  double const levels = strtod(s, &stop);
-  if (s != stop && isfinite(levels) && levels >= 0 && levels <= kMaxBuildingLevelsInTheWorld)
+  double levels;
+  if (ParseLevels(v, levels) && levels >= 0 && levels <= kMaxBuildingLevelsInTheWorld)
     return strings::to_string_dac(levels, 1);
 
   return {};
 }
 
-string MetadataTagProcessorImpl::ValidateAndFormat_level(string v) const
+string MetadataTagProcessorImpl::ValidateAndFormat_level(string const & v) const
 {
-  // Some mappers use full width unicode digits. We can handle that.
-  strings::NormalizeDigits(v);
-  char * stop;
-  char const * s = v.c_str();
-  double const levels = strtod(s, &stop);
-  if (s != stop && isfinite(levels) && levels >= kMinBuildingLevel &&
+  double levels;
+  if (ParseLevels(v, levels) && levels >= kMinBuildingLevel &&
       levels <= kMaxBuildingLevelsInTheWorld)
   {
     return strings::to_string(levels);
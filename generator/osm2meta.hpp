@@ -2,9 +2,11 @@
 
 #include "indexer/feature_data.hpp"
 #include "indexer/classificator.hpp"
+#include "indexer/classificator_type_path.hpp"
 #include "indexer/ftypes_matcher.hpp"
 
 #include <string>
+#include <utility>
 
 struct MetadataTagProcessorImpl
 {
@@ -27,10 +29,10 @@ struct MetadataTagProcessorImpl
   std::string ValidateAndFormat_email(std::string const & v) const;
   std::string ValidateAndFormat_postcode(std::string const & v) const;
   std::string ValidateAndFormat_flats(std::string const & v) const;
-  std::string ValidateAndFormat_internet(std::string v) const;
+  std::string ValidateAndFormat_internet(std::string const & v) const;
   std::string ValidateAndFormat_height(std::string const & v) const;
-  std::string ValidateAndFormat_building_levels(std::string v) const;
-  std::string ValidateAndFormat_level(std::string v) const;
+  std::string ValidateAndFormat_building_levels(std::string const & v) const;
+  std::string ValidateAndFormat_level(std::string const & v) const;
   std::string ValidateAndFormat_denomination(std::string const & v) const;
   std::string ValidateAndFormat_wikipedia(std::string v) const;
   std::string ValidateAndFormat_airport_iata(std::string const & v) const;
@@ -98,8 +100,8 @@ public:
     case Metadata::FMD_AIRPORT_IATA: valid = ValidateAndFormat_airport_iata(v); break;
     case Metadata::FMD_DURATION:
     {
-      static uint32_t const kFerryType = classif().GetTypeByPath({"route", "ferry"});
-      if (m_params.FindType(kFerryType, 2 /* level */) != ftype::GetEmptyValue())
+      static classificator::TypePath const kFerryType("route-ferry");
+      if (m_params.FindType(kFerryType.Get(), 2 /* level */) != ftype::GetEmptyValue())
         valid = ValidateAndFormat_duration(v);
 
       break;
@@ -112,7 +114,7 @@ public:
     case Metadata::FMD_TEST_ID:
     case Metadata::FMD_COUNT: CHECK(false, (mdType, "should not be parsed from OSM"));
     }
-    md.Set(mdType, valid);
+    md.Set(mdType, std::move(valid));
     return false;
   }
 };
@@ -9,6 +9,7 @@
 #include "geometry/mercator.hpp"
 
 #include "base/assert.hpp"
+#include "base/buffer_vector.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/string_utils.hpp"
 
@@ -88,24 +89,48 @@ Result ForEachTag(OsmElement * p, ToDo && toDo)
   return res;
 }
 
+// A tag of an element which can match a classificator type. The tags are checked once per
+// element, so the passes of MatchTypes() do not compare the ignored and the name tags again.
+struct MatchingTag
+{
+  string const * m_key;
+  string const * m_value;
+  bool m_needMatchValue;
+  // The object of the classificator root which matches the key.
+  ClassifObjectPtr m_rootObject;
+  // The tag is already matched.
+  bool m_matched = false;
+};
+
+using MatchingTags = buffer_vector<MatchingTag, 32>;
+
+MatchingTags GetMatchingTags(OsmElement * p, ClassifObject const * root)
+{
+  MatchingTags tags;
+  ForEachTag<bool>(p, [&](string const & k, string const & v) {
+    if (string::npos == k.find("name"))
+      tags.push_back({&k, &v, NeedMatchValue(k, v), root->BinaryFind(k)});
+    return false;
+  });
+  return tags;
+}
+
 template <typename Result, class ToDo>
-Result ForEachTagEx(OsmElement * p, set<int> & skipTags, ToDo && toDo)
+Result ForEachMatchingTag(MatchingTags & tags, ToDo && toDo)
 {
-  int id = 0;
-  return ForEachTag<Result>(p, [&](string const & k, string const & v) {
-    int currentId = id++;
-    if (skipTags.count(currentId) != 0)
-      return Result();
-    if (string::npos != k.find("name"))
+  for (auto & tag : tags)
+  {
+    if (tag.m_matched)
+      continue;
+
+    Result res = toDo(tag);
+    if (res)
     {
-      skipTags.insert(currentId);
-      return Result();
+      tag.m_matched = true;
+      return res;
     }
-    Result res = toDo(k, v);
-    if (res)
-      skipTags.insert(currentId);
-    return res;
-  });
+  }
+  return {};
 }
 
 class NamesExtractor
@@ -320,23 +345,24 @@ private:
 // See https://jira.mail.ru/browse/MAPSME-10611.
 void MatchTypes(OsmElement * p, FeatureParams & params, function<bool(uint32_t)> filterType)
 {
-  set<int> skipRows;
-  vector<ClassifObjectPtr> path;
+  ClassifObject const * root = classif().GetRoot();
+  auto tags = GetMatchingTags(p, root);
+  buffer_vector<ClassifObjectPtr, 8> path;
   ClassifObject const * current = nullptr;
 
-  auto matchTagToClassificator = [&path, &current](string const & k, string const & v) -> bool {
+  auto matchTagToClassificator = [&path, &current, root](MatchingTag const & tag) -> bool {
     // First try to match key.
-    ClassifObjectPtr elem = current->BinaryFind(k);
+    ClassifObjectPtr elem = current == root ? tag.m_rootObject : current->BinaryFind(*tag.m_key);
     if (!elem)
       return false;
 
     path.push_back(elem);
 
     // Now try to match correspondent value.
-    if (!NeedMatchValue(k, v))
+    if (!tag.m_needMatchValue)
       return true;
 
-    if (ClassifObjectPtr velem = elem->BinaryFind(v))
+    if (ClassifObjectPtr velem = elem->BinaryFind(*tag.m_value))
       path.push_back(velem);
 
     return true;
@@ -344,11 +370,11 @@ void MatchTypes(OsmElement * p, FeatureParams & params, function<bool(uint32_t)>
 
   do
   {
-    current = classif().GetRoot();
+    current = root;
     path.clear();
 
     // Find first root object by key.
-    if (!ForEachTagEx<bool>(p, skipRows, matchTagToClassificator))
+    if (!ForEachMatchingTag<bool>(tags, matchTagToClassificator))
       break;
     CHECK(!path.empty(), ());
 
@@ -363,17 +389,16 @@ void MatchTypes(OsmElement * p, FeatureParams & params, function<bool(uint32_t)>
       ClassifObjectPtr pObj;
       if (path.size() != 1)
       {
-        pObj = ForEachTagEx<ClassifObjectPtr>(
-            p, skipRows, [&current](string const & k, string const & v) {
-              return NeedMatchValue(k, v) ? current->BinaryFind(v) : ClassifObjectPtr();
-            });
+        pObj = ForEachMatchingTag<ClassifObjectPtr>(tags, [&current](MatchingTag const & tag) {
+          return tag.m_needMatchValue ? current->BinaryFind(*tag.m_value) : ClassifObjectPtr();
+        });
       }
 
       if (pObj)
       {
         path.push_back(pObj);
       }
-      else if (!ForEachTagEx<bool>(p, skipRows, matchTagToClassificator))
+      else if (!ForEachMatchingTag<bool>(tags, matchTagToClassificator))
       {
         // If no - try find object by key (in case of k = "area", v = "yes").
         break;
@@ -0,0 +1,124 @@
+#include "generator/osm_element_view.hpp"
+
+#include "base/assert.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+// OsmElementView ----------------------------------------------------------------------------------
+OsmSpan<uint64_t> OsmElementView::Nodes() const
+{
+  CHECK(m_chunk, ());
+  return {m_chunk->m_nodes.data() + m_nodesBegin, m_nodesEnd - m_nodesBegin};
+}
+
+OsmSpan<OsmElementView::Member> OsmElementView::Members() const
+{
+  CHECK(m_chunk, ());
+  return {m_chunk->m_members.data() + m_membersBegin, m_membersEnd - m_membersBegin};
+}
+
+OsmSpan<OsmElementView::Tag> OsmElementView::Tags() const
+{
+  CHECK(m_chunk, ());
+  return {m_chunk->m_tags.data() + m_tagsBegin, m_tagsEnd - m_tagsBegin};
+}
+
+void OsmElementView::Materialize(OsmElement & element) const
+{
+  element.Clear();
+  element.m_type = m_type;
+  element.m_id = m_id;
+  element.m_lon = m_lon;
+  element.m_lat = m_lat;
+
+  for (auto const nd : Nodes())
+    element.AddNd(nd);
+  for (auto const & member : Members())
+    element.AddMember(member.m_ref, member.m_type, member.m_role);
+  for (auto const & tag : Tags())
+    element.AddTag(tag.m_key, tag.m_value);
+}
+
+OsmElement OsmElementView::Materialize() const
+{
+  OsmElement element;
+  Materialize(element);
+  return element;
+}
+
+// OsmElementsChunk --------------------------------------------------------------------------------
+// static
+size_t constexpr OsmElementsChunk::kStringsBlockSize;
+
+void OsmElementsChunk::Clear()
+{
+  m_elements.clear();
+  m_nodes.clear();
+  m_members.clear();
+  m_tags.clear();
+  m_longStrings.clear();
+  m_currentBlock = 0;
+  m_blockPos = 0;
+}
+
+OsmElementView & OsmElementsChunk::AddElement(OsmElement::EntityType type, uint64_t id)
+{
+  m_elements.emplace_back();
+  auto & element = m_elements.back();
+  element.m_type = type;
+  element.m_id = id;
+  element.m_chunk = this;
+  element.m_nodesBegin = element.m_nodesEnd = m_nodes.size();
+  element.m_membersBegin = element.m_membersEnd = m_members.size();
+  element.m_tagsBegin = element.m_tagsEnd = m_tags.size();
+  return element;
+}
+
+void OsmElementsChunk::AddNd(uint64_t ref)
+{
+  ASSERT(!m_elements.empty(), ());
+  m_nodes.push_back(ref);
+  m_elements.back().m_nodesEnd = m_nodes.size();
+}
+
+void OsmElementsChunk::AddMember(uint64_t ref, OsmElement::EntityType type, char const * role)
+{
+  ASSERT(!m_elements.empty(), ());
+  m_members.push_back({ref, type, AddString(role)});
+  m_elements.back().m_membersEnd = m_members.size();
+}
+
+void OsmElementsChunk::AddTag(char const * key, char const * value)
+{
+  ASSERT(!m_elements.empty(), ());
+  m_tags.push_back({AddString(key), AddString(value)});
+  m_elements.back().m_tagsEnd = m_tags.size();
+}
+
+char const * OsmElementsChunk::AddString(char const * s)
+{
+  ASSERT(s, ());
+  auto const size = strlen(s) + 1;
+  if (size > kStringsBlockSize)
+  {
+    m_longStrings.emplace_back(new char[size]);
+    memcpy(m_longStrings.back().get(), s, size);
+    return m_longStrings.back().get();
+  }
+
+  if (m_stringsBlocks.empty() || m_blockPos + size > kStringsBlockSize)
+  {
+    if (!m_stringsBlocks.empty())
+      ++m_currentBlock;
+    if (m_currentBlock == m_stringsBlocks.size())
+      m_stringsBlocks.emplace_back(new char[kStringsBlockSize]);
+    m_blockPos = 0;
+  }
+
+  auto const result = m_stringsBlocks[m_currentBlock].get() + m_blockPos;
+  memcpy(result, s, size);
+  m_blockPos += size;
+  return result;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "generator/osm_element.hpp"
+
+#include "base/macros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class OsmElementsChunk;
+
+template <typename T>
+class OsmSpan
+{
+public:
+  OsmSpan() = default;
+  OsmSpan(T const * data, size_t size) : m_data(data), m_size(size) {}
+
+  T const * begin() const { return m_data; }
+  T const * end() const { return m_data + m_size; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  T const & operator[](size_t i) const { return m_data[i]; }
+
+private:
+  T const * m_data = nullptr;
+  size_t m_size = 0;
+};
+
+// A non-owning element: the strings, nodes and members belong to the OsmElementsChunk
+// the element is read to and are valid until the chunk is cleared. Tags are kept
+// as they are in the source, Materialize() filters them as OsmElement::AddTag() does.
+struct OsmElementView
+{
+  struct Member
+  {
+    uint64_t m_ref = 0;
+    OsmElement::EntityType m_type = OsmElement::EntityType::Unknown;
+    char const * m_role = nullptr;
+  };
+
+  struct Tag
+  {
+    char const * m_key = nullptr;
+    char const * m_value = nullptr;
+  };
+
+  OsmSpan<uint64_t> Nodes() const;
+  OsmSpan<Member> Members() const;
+  OsmSpan<Tag> Tags() const;
+
+  // Copies the element to the owning OsmElement for translators which keep the data.
+  void Materialize(OsmElement & element) const;
+  OsmElement Materialize() const;
+
+  OsmElement::EntityType m_type = OsmElement::EntityType::Unknown;
+  uint64_t m_id = 0;
+  double m_lon = 0.0;
+  double m_lat = 0.0;
+
+private:
+  friend class OsmElementsChunk;
+
+  OsmElementsChunk const * m_chunk = nullptr;
+  size_t m_nodesBegin = 0;
+  size_t m_nodesEnd = 0;
+  size_t m_membersBegin = 0;
+  size_t m_membersEnd = 0;
+  size_t m_tagsBegin = 0;
+  size_t m_tagsEnd = 0;
+};
+
+// An arena of the element views of a chunk of source data. All the nodes, members and tags
+// of the chunk are kept in shared arrays and the strings are copied to reused blocks,
+// so reading a chunk does not allocate once the arena has grown to the chunk size.
+class OsmElementsChunk
+{
+public:
+  OsmElementsChunk() = default;
+
+  // Drops the elements but keeps the allocated memory.
+  void Clear();
+
+  // Starts a new element, AddNd(), AddMember() and AddTag() add data to the last element.
+  OsmElementView & AddElement(OsmElement::EntityType type, uint64_t id);
+  void AddNd(uint64_t ref);
+  void AddMember(uint64_t ref, OsmElement::EntityType type, char const * role);
+  void AddTag(char const * key, char const * value);
+
+  size_t Size() const { return m_elements.size(); }
+  bool Empty() const { return m_elements.empty(); }
+  OsmElementView const & operator[](size_t i) const { return m_elements[i]; }
+  std::vector<OsmElementView>::const_iterator begin() const { return m_elements.cbegin(); }
+  std::vector<OsmElementView>::const_iterator end() const { return m_elements.cend(); }
+
+private:
+  friend struct OsmElementView;
+
+  static size_t constexpr kStringsBlockSize = 64 * 1024;
+
+  char const * AddString(char const * s);
+
+  std::vector<OsmElementView> m_elements;
+  std::vector<uint64_t> m_nodes;
+  std::vector<OsmElementView::Member> m_members;
+  std::vector<OsmElementView::Tag> m_tags;
+
+  std::vector<std::unique_ptr<char[]>> m_stringsBlocks;
+  // Strings longer than a block are allocated separately.
+  std::vector<std::unique_ptr<char[]>> m_longStrings;
+  size_t m_currentBlock = 0;
+  size_t m_blockPos = 0;
+
+  DISALLOW_COPY_AND_MOVE(OsmElementsChunk);
+};
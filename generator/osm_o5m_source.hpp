@@ -575,12 +575,14 @@ public:
   Iterator const begin() { return Iterator(this); }
   Iterator const end() { return Iterator(); }
 
-  O5MSource(TReadFunc reader, size_t readBufferSizeInBytes = 60000) : m_buffer(reader, readBufferSizeInBytes)
+  // |withHeader| is false when |reader| starts at a reset dataset in the middle of a file.
+  O5MSource(TReadFunc reader, size_t readBufferSizeInBytes = 60000, bool withHeader = true)
+    : m_buffer(reader, readBufferSizeInBytes)
   {
     if (EntityType::Reset != EntityType(m_buffer.Get()))
       throw std::runtime_error("Incorrect o5m start");
 
-    if (!CheckHeader())
+    if (withHeader && !CheckHeader())
         throw std::runtime_error("Incorrect o5m header");
   }
 
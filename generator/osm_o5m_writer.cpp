@@ -0,0 +1,167 @@
+#include "generator/osm_o5m_writer.hpp"
+
+#include "coding/varint.hpp"
+#include "coding/writer.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <cmath>
+
+namespace generator
+{
+namespace
+{
+// See osm::O5MSource::EntityType.
+uint8_t constexpr kNode = 0x10;
+uint8_t constexpr kWay = 0x11;
+uint8_t constexpr kRelation = 0x12;
+uint8_t constexpr kHeader = 0xe0;
+uint8_t constexpr kEnd = 0xfe;
+uint8_t constexpr kReset = 0xff;
+
+int64_t ToO5MCoord(double coord) { return static_cast<int64_t>(std::llround(coord * 1e7)); }
+
+char GetMemberTypeChar(OsmElement::EntityType type)
+{
+  switch (type)
+  {
+  case OsmElement::EntityType::Node: return '0';
+  case OsmElement::EntityType::Way: return '1';
+  case OsmElement::EntityType::Relation: return '2';
+  default: CHECK(false, ("Unexpected member type:", type));
+  }
+  return '0';
+}
+}  // namespace
+
+// static
+size_t constexpr O5MWriter::kDefaultElementsPerReset;
+
+O5MWriter::O5MWriter(std::string const & filename, size_t elementsPerReset)
+  : m_writer(filename), m_elementsPerReset(elementsPerReset)
+{
+  CHECK_GREATER(m_elementsPerReset, 0, ());
+  uint8_t const header[] = {kReset, kHeader, 0x04, 'o', '5', 'm', '2'};
+  m_writer.Write(header, sizeof(header));
+}
+
+O5MWriter::~O5MWriter()
+{
+  try
+  {
+    Finish();
+  }
+  catch (Writer::Exception const & e)
+  {
+    LOG(LERROR, ("Failed to finish the o5m file:", e.Msg()));
+  }
+}
+
+void O5MWriter::Write(OsmElement const & element)
+{
+  CHECK(!m_finished, ());
+  if (m_elementsCount != 0 && m_elementsCount % m_elementsPerReset == 0)
+    WriteReset();
+  ++m_elementsCount;
+
+  m_dataset.clear();
+  MemWriter<std::vector<uint8_t>> dataset(m_dataset);
+  auto const id = static_cast<int64_t>(element.m_id);
+  WriteVarInt(dataset, id - m_id);
+  m_id = id;
+  // No version.
+  WriteVarUint(dataset, 0U);
+
+  uint8_t type = 0;
+  switch (element.m_type)
+  {
+  case OsmElement::EntityType::Node:
+  {
+    type = kNode;
+    auto const lon = ToO5MCoord(element.m_lon);
+    auto const lat = ToO5MCoord(element.m_lat);
+    WriteVarInt(dataset, lon - m_lon);
+    WriteVarInt(dataset, lat - m_lat);
+    m_lon = lon;
+    m_lat = lat;
+    break;
+  }
+  case OsmElement::EntityType::Way:
+  {
+    type = kWay;
+    m_refs.clear();
+    MemWriter<std::vector<uint8_t>> refs(m_refs);
+    for (auto const node : element.Nodes())
+    {
+      auto const ref = static_cast<int64_t>(node);
+      WriteVarInt(refs, ref - m_nodeRef);
+      m_nodeRef = ref;
+    }
+    WriteVarUint(dataset, static_cast<uint64_t>(m_refs.size()));
+    dataset.Write(m_refs.data(), m_refs.size());
+    break;
+  }
+  case OsmElement::EntityType::Relation:
+  {
+    type = kRelation;
+    m_refs.clear();
+    MemWriter<std::vector<uint8_t>> refs(m_refs);
+    for (auto const & member : element.Members())
+    {
+      auto & lastRef = member.m_type == OsmElement::EntityType::Node
+                           ? m_nodeRef
+                           : member.m_type == OsmElement::EntityType::Way ? m_wayRef
+                                                                          : m_relationRef;
+      auto const ref = static_cast<int64_t>(member.m_ref);
+      WriteVarInt(refs, ref - lastRef);
+      lastRef = ref;
+
+      // The type and the role are a single string.
+      uint8_t const inlineString = 0;
+      refs.Write(&inlineString, 1);
+      char const memberType = GetMemberTypeChar(member.m_type);
+      refs.Write(&memberType, 1);
+      refs.Write(member.m_role.c_str(), member.m_role.size() + 1);
+    }
+    WriteVarUint(dataset, static_cast<uint64_t>(m_refs.size()));
+    dataset.Write(m_refs.data(), m_refs.size());
+    break;
+  }
+  default: CHECK(false, ("Unexpected element type:", element.m_type));
+  }
+
+  for (auto const & tag : element.Tags())
+  {
+    uint8_t const inlineString = 0;
+    dataset.Write(&inlineString, 1);
+    dataset.Write(tag.m_key.c_str(), tag.m_key.size() + 1);
+    dataset.Write(tag.m_value.c_str(), tag.m_value.size() + 1);
+  }
+
+  m_writer.Write(&type, 1);
+  WriteVarUint(m_writer, static_cast<uint64_t>(m_dataset.size()));
+  m_writer.Write(m_dataset.data(), m_dataset.size());
+}
+
+void O5MWriter::Finish()
+{
+  if (m_finished)
+    return;
+
+  m_finished = true;
+  m_writer.Write(&kEnd, 1);
+  m_writer.Flush();
+}
+
+void O5MWriter::WriteReset()
+{
+  m_writer.Write(&kReset, 1);
+  m_id = 0;
+  m_lon = 0;
+  m_lat = 0;
+  m_nodeRef = 0;
+  m_wayRef = 0;
+  m_relationRef = 0;
+}
+}  // namespace generator
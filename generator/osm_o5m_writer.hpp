@@ -0,0 +1,54 @@
+#pragma once
+
+#include "generator/osm_element.hpp"
+
+#include "coding/file_writer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+// Writes the osm elements to an o5m file, see https://wiki.openstreetmap.org/wiki/O5m and
+// osm::O5MSource. The elements are written without the versions and the strings are written
+// inline. The nodes should precede the ways and the ways should precede the relations. A reset
+// dataset is written every |elementsPerReset| elements, so the file is decoded by the ranges in
+// parallel, see FindO5MResetOffsets().
+class O5MWriter
+{
+public:
+  static size_t constexpr kDefaultElementsPerReset = 10000;
+
+  explicit O5MWriter(std::string const & filename,
+                     size_t elementsPerReset = kDefaultElementsPerReset);
+  // Finishes the file if Finish() has not been called.
+  ~O5MWriter();
+
+  void Write(OsmElement const & element);
+  // Writes the end of the file.
+  void Finish();
+
+  uint64_t GetElementsCount() const { return m_elementsCount; }
+
+private:
+  void WriteReset();
+
+  FileWriter m_writer;
+  size_t const m_elementsPerReset;
+  // The dataset which is being written.
+  std::vector<uint8_t> m_dataset;
+  std::vector<uint8_t> m_refs;
+  uint64_t m_elementsCount = 0;
+  bool m_finished = false;
+
+  // The deltas are relative to the previous values since the last reset.
+  int64_t m_id = 0;
+  int64_t m_lon = 0;
+  int64_t m_lat = 0;
+  int64_t m_nodeRef = 0;
+  int64_t m_wayRef = 0;
+  int64_t m_relationRef = 0;
+};
+}  // namespace generator
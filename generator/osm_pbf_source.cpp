@@ -0,0 +1,596 @@
+#include "generator/osm_pbf_source.hpp"
+
+#include "base/arena.hpp"
+#include "base/assert.hpp"
+#include "base/scope_guard.hpp"
+
+#include <cstring>
+#include <utility>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+using namespace std;
+
+namespace generator
+{
+namespace pbf
+{
+namespace
+{
+// The limits from the format definition.
+uint32_t constexpr kMaxBlobHeaderSize = 64 * 1024;
+uint32_t constexpr kMaxBlobSize = 32 * 1024 * 1024;
+
+enum class WireType : uint8_t
+{
+  Varint = 0,
+  Fixed64 = 1,
+  LengthDelimited = 2,
+  Fixed32 = 5
+};
+
+// A reader of the protobuf wire format which is just enough for the osm.pbf messages.
+class MessageReader
+{
+public:
+  MessageReader(char const * data, size_t size) : m_pos(data), m_end(data + size) {}
+
+  // Reads the key of the next field. Returns false at the end of the message.
+  bool Next()
+  {
+    if (m_pos == m_end)
+      return false;
+
+    auto const key = ReadVarint();
+    m_field = static_cast<uint32_t>(key >> 3);
+    m_wireType = static_cast<WireType>(key & 0x7);
+    return true;
+  }
+
+  uint32_t Field() const { return m_field; }
+  WireType GetWireType() const { return m_wireType; }
+
+  uint64_t Varint()
+  {
+    Expect(WireType::Varint);
+    return ReadVarint();
+  }
+
+  int64_t SignedVarint() { return DecodeZigZag(Varint()); }
+
+  pair<char const *, size_t> Bytes()
+  {
+    Expect(WireType::LengthDelimited);
+    auto const size = ReadVarint();
+    if (size > static_cast<uint64_t>(m_end - m_pos))
+      MYTHROW(PbfException, ("Length-delimited field", m_field, "is out of the message."));
+
+    auto const data = m_pos;
+    m_pos += size;
+    return {data, static_cast<size_t>(size)};
+  }
+
+  string String()
+  {
+    auto const bytes = Bytes();
+    return {bytes.first, bytes.second};
+  }
+
+  MessageReader Message()
+  {
+    auto const bytes = Bytes();
+    return {bytes.first, bytes.second};
+  }
+
+  // Calls |fn| for every value of a repeated varint field, packed or not.
+  template <typename Fn>
+  void ForEachVarint(Fn && fn)
+  {
+    if (m_wireType != WireType::LengthDelimited)
+    {
+      fn(Varint());
+      return;
+    }
+
+    auto packed = Message();
+    while (packed.m_pos != packed.m_end)
+      fn(packed.ReadVarint());
+  }
+
+  template <typename Fn>
+  void ForEachSignedVarint(Fn && fn)
+  {
+    ForEachVarint([&fn](uint64_t v) { fn(DecodeZigZag(v)); });
+  }
+
+  void Skip()
+  {
+    switch (m_wireType)
+    {
+    case WireType::Varint: ReadVarint(); return;
+    case WireType::Fixed64: SkipBytes(8); return;
+    case WireType::LengthDelimited: Bytes(); return;
+    case WireType::Fixed32: SkipBytes(4); return;
+    }
+    MYTHROW(PbfException, ("Unsupported wire type", static_cast<int>(m_wireType), "of field",
+                           m_field));
+  }
+
+private:
+  static int64_t DecodeZigZag(uint64_t v)
+  {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+
+  void Expect(WireType wireType) const
+  {
+    if (m_wireType != wireType)
+    {
+      MYTHROW(PbfException, ("Unexpected wire type", static_cast<int>(m_wireType), "of field",
+                             m_field));
+    }
+  }
+
+  uint64_t ReadVarint()
+  {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+      if (m_pos == m_end)
+        MYTHROW(PbfException, ("Unexpected end of a varint."));
+
+      auto const byte = static_cast<uint8_t>(*m_pos++);
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return result;
+    }
+    MYTHROW(PbfException, ("Too long varint."));
+  }
+
+  void SkipBytes(size_t size)
+  {
+    if (size > static_cast<size_t>(m_end - m_pos))
+      MYTHROW(PbfException, ("Unexpected end of the message."));
+    m_pos += size;
+  }
+
+  char const * m_pos;
+  char const * m_end;
+  uint32_t m_field = 0;
+  WireType m_wireType = WireType::Varint;
+};
+
+uint32_t ReadBigEndian32(char const * data)
+{
+  auto const bytes = reinterpret_cast<uint8_t const *>(data);
+  return (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16) | (uint32_t{bytes[2]} << 8) |
+         uint32_t{bytes[3]};
+}
+
+// Parses a BlobHeader message and returns the size of the following Blob.
+uint32_t ParseBlobHeader(char const * data, size_t size, string & type)
+{
+  type.clear();
+  uint64_t blobSize = 0;
+  MessageReader header(data, size);
+  while (header.Next())
+  {
+    switch (header.Field())
+    {
+    case 1: type = header.String(); break;
+    case 3: blobSize = header.Varint(); break;
+    default: header.Skip(); break;
+    }
+  }
+
+  if (blobSize > kMaxBlobSize)
+    MYTHROW(PbfException, ("Too large blob of", blobSize, "bytes."));
+  return static_cast<uint32_t>(blobSize);
+}
+
+// Returns the uncompressed content of a Blob message.
+string UnpackBlob(char const * data, size_t size)
+{
+  uint64_t rawSize = 0;
+  pair<char const *, size_t> raw{nullptr, 0};
+  pair<char const *, size_t> zlibData{nullptr, 0};
+  MessageReader blob(data, size);
+  while (blob.Next())
+  {
+    switch (blob.Field())
+    {
+    case 1: raw = blob.Bytes(); break;
+    case 2: rawSize = blob.Varint(); break;
+    case 3: zlibData = blob.Bytes(); break;
+    case 4:
+    case 5:
+    case 6:
+    case 7: MYTHROW(PbfException, ("Unsupported blob compression", blob.Field()));
+    default: blob.Skip(); break;
+    }
+  }
+
+  if (raw.first)
+    return {raw.first, raw.second};
+
+  if (!zlibData.first)
+    return {};
+
+  if (rawSize > kMaxBlobSize)
+    MYTHROW(PbfException, ("Too large blob of", rawSize, "bytes."));
+
+  namespace io = boost::iostreams;
+  string result;
+  result.reserve(static_cast<size_t>(rawSize));
+  try
+  {
+    io::filtering_streambuf<io::input> in;
+    in.push(io::zlib_decompressor());
+    in.push(io::array_source(zlibData.first, zlibData.second));
+    io::copy(in, io::back_inserter(result));
+  }
+  catch (io::zlib_error const & e)
+  {
+    MYTHROW(PbfException, ("Failed to inflate a blob:", e.what()));
+  }
+
+  if (result.size() != rawSize)
+    MYTHROW(PbfException, ("Blob size", result.size(), "differs from raw_size", rawSize));
+  return result;
+}
+
+OsmElement::EntityType ToEntityType(uint64_t memberType)
+{
+  switch (memberType)
+  {
+  case 0: return OsmElement::EntityType::Node;
+  case 1: return OsmElement::EntityType::Way;
+  case 2: return OsmElement::EntityType::Relation;
+  }
+  return OsmElement::EntityType::Unknown;
+}
+
+// The string table and the temporary arrays of a block are allocated in |arena|.
+class PrimitiveBlockDecoder
+{
+public:
+  PrimitiveBlockDecoder(vector<OsmElement> & elements, base::Arena & arena)
+    : m_elements(elements), m_arena(arena), m_strings(base::ArenaAllocator<char const *>(arena))
+  {
+  }
+
+  void Decode(char const * data, size_t size)
+  {
+    // The string table and the coordinates parameters may follow the groups,
+    // so the groups are decoded after the whole block is parsed.
+    auto groups = MakeVector<MessageReader>();
+    MessageReader block(data, size);
+    while (block.Next())
+    {
+      switch (block.Field())
+      {
+      case 1: ReadStringTable(block.Message()); break;
+      case 2: groups.push_back(block.Message()); break;
+      case 17: m_granularity = static_cast<int64_t>(block.Varint()); break;
+      case 19: m_latOffset = static_cast<int64_t>(block.Varint()); break;
+      case 20: m_lonOffset = static_cast<int64_t>(block.Varint()); break;
+      default: block.Skip(); break;
+      }
+    }
+
+    for (auto & group : groups)
+      DecodeGroup(group);
+  }
+
+private:
+  void ReadStringTable(MessageReader table)
+  {
+    while (table.Next())
+    {
+      if (table.Field() == 1)
+        m_strings.push_back(CopyString(table.Bytes()));
+      else
+        table.Skip();
+    }
+  }
+
+  template <typename T>
+  base::ArenaVector<T> MakeVector() const
+  {
+    return base::ArenaVector<T>(base::ArenaAllocator<T>(m_arena));
+  }
+
+  // Returns the zero terminated copy of |bytes| in the arena.
+  char const * CopyString(pair<char const *, size_t> const & bytes)
+  {
+    auto * copy = static_cast<char *>(m_arena.Allocate(bytes.second + 1, 1 /* alignment */));
+    memcpy(copy, bytes.first, bytes.second);
+    copy[bytes.second] = '\0';
+    return copy;
+  }
+
+  char const * GetString(uint64_t index) const
+  {
+    if (index >= m_strings.size())
+      MYTHROW(PbfException, ("String index", index, "is out of the table of", m_strings.size()));
+    return m_strings[static_cast<size_t>(index)];
+  }
+
+  double ToLat(int64_t lat) const { return 1e-9 * (m_latOffset + m_granularity * lat); }
+  double ToLon(int64_t lon) const { return 1e-9 * (m_lonOffset + m_granularity * lon); }
+
+  OsmElement & AddElement(OsmElement::EntityType type, int64_t id)
+  {
+    m_elements.emplace_back();
+    auto & element = m_elements.back();
+    element.m_type = type;
+    element.m_id = static_cast<uint64_t>(id);
+    return element;
+  }
+
+  void AddTags(OsmElement & element, vector<uint32_t> const & keys,
+               vector<uint32_t> const & values) const
+  {
+    if (keys.size() != values.size())
+      MYTHROW(PbfException, ("Keys and values of element", element.m_id, "differ in size."));
+
+    for (size_t i = 0; i < keys.size(); ++i)
+      element.AddTag(GetString(keys[i]), GetString(values[i]));
+  }
+
+  void DecodeGroup(MessageReader & group)
+  {
+    while (group.Next())
+    {
+      switch (group.Field())
+      {
+      case 1: DecodeNode(group.Message()); break;
+      case 2: DecodeDenseNodes(group.Message()); break;
+      case 3: DecodeWay(group.Message()); break;
+      case 4: DecodeRelation(group.Message()); break;
+      default: group.Skip(); break;
+      }
+    }
+  }
+
+  template <typename Indices>
+  void ReadIndices(MessageReader & message, Indices & indices) const
+  {
+    message.ForEachVarint([&indices](uint64_t v) { indices.push_back(static_cast<uint32_t>(v)); });
+  }
+
+  void DecodeNode(MessageReader node)
+  {
+    int64_t id = 0;
+    int64_t lat = 0;
+    int64_t lon = 0;
+    m_keys.clear();
+    m_values.clear();
+    while (node.Next())
+    {
+      switch (node.Field())
+      {
+      case 1: id = node.SignedVarint(); break;
+      case 2: ReadIndices(node, m_keys); break;
+      case 3: ReadIndices(node, m_values); break;
+      case 8: lat = node.SignedVarint(); break;
+      case 9: lon = node.SignedVarint(); break;
+      default: node.Skip(); break;
+      }
+    }
+
+    auto & element = AddElement(OsmElement::EntityType::Node, id);
+    element.m_lat = ToLat(lat);
+    element.m_lon = ToLon(lon);
+    AddTags(element, m_keys, m_values);
+  }
+
+  void DecodeDenseNodes(MessageReader dense)
+  {
+    auto ids = MakeVector<int64_t>();
+    auto lats = MakeVector<int64_t>();
+    auto lons = MakeVector<int64_t>();
+    auto keysValues = MakeVector<uint32_t>();
+    while (dense.Next())
+    {
+      switch (dense.Field())
+      {
+      case 1: dense.ForEachSignedVarint([&ids](int64_t v) { ids.push_back(v); }); break;
+      case 8: dense.ForEachSignedVarint([&lats](int64_t v) { lats.push_back(v); }); break;
+      case 9: dense.ForEachSignedVarint([&lons](int64_t v) { lons.push_back(v); }); break;
+      case 10: ReadIndices(dense, keysValues); break;
+      default: dense.Skip(); break;
+      }
+    }
+
+    if (ids.size() != lats.size() || ids.size() != lons.size())
+      MYTHROW(PbfException, ("Ids and coordinates of dense nodes differ in size."));
+
+    // Ids and coordinates are delta coded, tags of the nodes are separated by zeroes
+    // in |keysValues|, the array is empty when no node has tags.
+    int64_t id = 0;
+    int64_t lat = 0;
+    int64_t lon = 0;
+    size_t kv = 0;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      id += ids[i];
+      lat += lats[i];
+      lon += lons[i];
+      auto & element = AddElement(OsmElement::EntityType::Node, id);
+      element.m_lat = ToLat(lat);
+      element.m_lon = ToLon(lon);
+
+      while (kv < keysValues.size() && keysValues[kv] != 0)
+      {
+        if (kv + 1 == keysValues.size())
+          MYTHROW(PbfException, ("Dense node", id, "has a key without a value."));
+        element.AddTag(GetString(keysValues[kv]), GetString(keysValues[kv + 1]));
+        kv += 2;
+      }
+      ++kv;
+    }
+  }
+
+  void DecodeWay(MessageReader way)
+  {
+    int64_t id = 0;
+    m_keys.clear();
+    m_values.clear();
+    m_refs.clear();
+    while (way.Next())
+    {
+      switch (way.Field())
+      {
+      case 1: id = static_cast<int64_t>(way.Varint()); break;
+      case 2: ReadIndices(way, m_keys); break;
+      case 3: ReadIndices(way, m_values); break;
+      case 8: way.ForEachSignedVarint([this](int64_t v) { m_refs.push_back(v); }); break;
+      default: way.Skip(); break;
+      }
+    }
+
+    auto & element = AddElement(OsmElement::EntityType::Way, id);
+    int64_t ref = 0;
+    for (auto const delta : m_refs)
+    {
+      ref += delta;
+      element.AddNd(static_cast<uint64_t>(ref));
+    }
+    AddTags(element, m_keys, m_values);
+  }
+
+  void DecodeRelation(MessageReader relation)
+  {
+    int64_t id = 0;
+    m_keys.clear();
+    m_values.clear();
+    m_refs.clear();
+    auto roles = MakeVector<uint32_t>();
+    auto types = MakeVector<uint64_t>();
+    while (relation.Next())
+    {
+      switch (relation.Field())
+      {
+      case 1: id = static_cast<int64_t>(relation.Varint()); break;
+      case 2: ReadIndices(relation, m_keys); break;
+      case 3: ReadIndices(relation, m_values); break;
+      case 8: ReadIndices(relation, roles); break;
+      case 9: relation.ForEachSignedVarint([this](int64_t v) { m_refs.push_back(v); }); break;
+      case 10: relation.ForEachVarint([&types](uint64_t v) { types.push_back(v); }); break;
+      default: relation.Skip(); break;
+      }
+    }
+
+    if (m_refs.size() != roles.size() || m_refs.size() != types.size())
+      MYTHROW(PbfException, ("Members of relation", id, "differ in size."));
+
+    auto & element = AddElement(OsmElement::EntityType::Relation, id);
+    int64_t ref = 0;
+    for (size_t i = 0; i < m_refs.size(); ++i)
+    {
+      ref += m_refs[i];
+      element.AddMember(static_cast<uint64_t>(ref), ToEntityType(types[i]), GetString(roles[i]));
+    }
+    AddTags(element, m_keys, m_values);
+  }
+
+  vector<OsmElement> & m_elements;
+  base::Arena & m_arena;
+  base::ArenaVector<char const *> m_strings;
+  int64_t m_granularity = 100;
+  int64_t m_latOffset = 0;
+  int64_t m_lonOffset = 0;
+  // Buffers reused by elements.
+  vector<uint32_t> m_keys;
+  vector<uint32_t> m_values;
+  vector<int64_t> m_refs;
+};
+}  // namespace
+
+bool ReadBlob(ReadFn const & read, string & type, string & blob)
+{
+  char sizeBuffer[4];
+  auto const readBytes = read(sizeBuffer, sizeof(sizeBuffer));
+  if (readBytes == 0)
+    return false;
+  if (readBytes != sizeof(sizeBuffer))
+    MYTHROW(PbfException, ("Unexpected end of a blob header size."));
+
+  auto const headerSize = ReadBigEndian32(sizeBuffer);
+  if (headerSize > kMaxBlobHeaderSize)
+    MYTHROW(PbfException, ("Too large blob header of", headerSize, "bytes."));
+
+  string header(headerSize, '\0');
+  if (read(&header[0], headerSize) != headerSize)
+    MYTHROW(PbfException, ("Unexpected end of a blob header."));
+
+  auto const blobSize = ParseBlobHeader(header.data(), header.size(), type);
+  blob.resize(blobSize);
+  if (read(&blob[0], blobSize) != blobSize)
+    MYTHROW(PbfException, ("Unexpected end of a blob."));
+  return true;
+}
+
+vector<BlobRef> FindDataBlobs(char const * data, size_t size)
+{
+  vector<BlobRef> blobs;
+  string type;
+  size_t pos = 0;
+  while (pos < size)
+  {
+    if (size - pos < 4)
+      MYTHROW(PbfException, ("Unexpected end of a blob header size."));
+    auto const headerSize = ReadBigEndian32(data + pos);
+    pos += 4;
+    if (headerSize > kMaxBlobHeaderSize || headerSize > size - pos)
+      MYTHROW(PbfException, ("Bad blob header size", headerSize, "at", pos));
+
+    auto const blobSize = ParseBlobHeader(data + pos, headerSize, type);
+    pos += headerSize;
+    if (blobSize > size - pos)
+      MYTHROW(PbfException, ("Unexpected end of a blob at", pos));
+
+    if (type == "OSMData")
+      blobs.push_back({pos, blobSize});
+    else if (type == "OSMHeader")
+      CheckHeaderBlob(data + pos, blobSize);
+    pos += blobSize;
+  }
+  return blobs;
+}
+
+void CheckHeaderBlob(char const * blob, size_t size)
+{
+  auto const content = UnpackBlob(blob, size);
+  MessageReader header(content.data(), content.size());
+  while (header.Next())
+  {
+    if (header.Field() != 4 /* required_features */)
+    {
+      header.Skip();
+      continue;
+    }
+
+    auto const feature = header.String();
+    if (feature != "OsmSchema-V0.6" && feature != "DenseNodes")
+      MYTHROW(PbfException, ("Unsupported required feature", feature));
+  }
+}
+
+void DecodeDataBlob(char const * blob, size_t size, vector<OsmElement> & elements)
+{
+  // All the memory of the decoder dies with the block, so the arena of the thread
+  // is reset after every block.
+  static thread_local base::Arena arena;
+  SCOPE_GUARD(resetArena, [] { arena.Reset(); });
+
+  auto const content = UnpackBlob(blob, size);
+  PrimitiveBlockDecoder(elements, arena).Decode(content.data(), content.size());
+}
+}  // namespace pbf
+}  // namespace generator
@@ -0,0 +1,44 @@
+// See PBF Format definition at https://wiki.openstreetmap.org/wiki/PBF_Format
+#pragma once
+
+#include "generator/osm_element.hpp"
+
+#include "base/exception.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+namespace pbf
+{
+DECLARE_EXCEPTION(PbfException, RootException);
+
+// A Blob message of an osm.pbf file with an OSMData block. Blobs are independent
+// from each other, so they may be decoded in any order.
+struct BlobRef
+{
+  uint64_t m_offset = 0;
+  uint32_t m_size = 0;
+};
+
+// Reads the next (BlobHeader, Blob) pair: |read(buffer, size)| must return the number
+// of the read bytes. Returns false at the end of the stream.
+// |blob| gets the Blob message and |type| gets its type ("OSMHeader" or "OSMData").
+using ReadFn = std::function<size_t(char *, size_t)>;
+bool ReadBlob(ReadFn const & read, std::string & type, std::string & blob);
+
+// Returns the OSMData blobs of the file mapped to |data|. Only the blob headers are parsed,
+// the OSMHeader blob is checked for the features the decoder does not support.
+std::vector<BlobRef> FindDataBlobs(char const * data, size_t size);
+
+// Checks that the OSMHeader |blob| has no features the decoder does not support.
+void CheckHeaderBlob(char const * blob, size_t size);
+
+// Decodes the OSMData |blob| and appends its elements to |elements|.
+void DecodeDataBlob(char const * blob, size_t size, std::vector<OsmElement> & elements);
+}  // namespace pbf
+}  // namespace generator
@@ -8,14 +8,22 @@
 
 #include "platform/platform.hpp"
 
+#include "coding/file_reader.hpp"
+#include "coding/file_writer.hpp"
+#include "coding/reader.hpp"
+#include "coding/write_to_sink.hpp"
+
 #include "geometry/mercator.hpp"
 
 #include "base/assert.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/file_name_utils.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <memory>
+#include <numeric>
 #include <set>
 #include <thread>
 #include <vector>
@@ -128,6 +136,55 @@ void AddElementToCache(cache::IntermediateDataWriter & cache, OsmElement && elem
   }
 }
 
+void AddChangeToOverlay(cache::IntermediateDataOverlayWriter & overlay,
+                        OsmChangeXMLSource::Action action, OsmElement && element)
+{
+  auto const id = element.m_id;
+  if (action == OsmChangeXMLSource::Action::Delete)
+  {
+    switch (element.m_type)
+    {
+    case OsmElement::EntityType::Node: overlay.DeleteNode(id); break;
+    case OsmElement::EntityType::Way: overlay.DeleteWay(id); break;
+    case OsmElement::EntityType::Relation: overlay.DeleteRelation(id); break;
+    default: break;
+    }
+    return;
+  }
+
+  switch (element.m_type)
+  {
+  case OsmElement::EntityType::Node:
+  {
+    NodeElement node;
+    BuildIntermediateNode(std::move(element), node);
+    overlay.AddNode(id, node.m_lat, node.m_lon);
+    break;
+  }
+  case OsmElement::EntityType::Way:
+  {
+    // A way which is not valid anymore is dropped from the cache.
+    WayElement way(id);
+    if (BuildIntermediateWay(std::move(element), way))
+      overlay.AddWay(id, way);
+    else
+      overlay.DeleteWay(id);
+    break;
+  }
+  case OsmElement::EntityType::Relation:
+  {
+    RelationElement relation;
+    if (BuildIntermediateRelation(std::move(element), relation))
+      overlay.AddRelation(id, relation);
+    else
+      overlay.DeleteRelation(id);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
 void BuildIntermediateDataFromXML(SourceReader & stream, cache::IntermediateDataWriter & cache,
                                   TownsDumper & towns)
 {
@@ -155,6 +212,17 @@ void ProcessOsmElementsFromXML(SourceReader & stream, function<void(OsmElement &
     processor(std::move(element));
 }
 
+void ProcessOsmChangeFromXML(
+    SourceReader & stream, function<void(OsmChangeXMLSource::Action, OsmElement &&)> processor)
+{
+  OsmChangeXMLSource source([&processor](OsmChangeXMLSource::Action action, OsmElement * element) {
+    processor(action, std::move(*element));
+  });
+  XMLSequenceParser<SourceReader, OsmChangeXMLSource> parser(stream, source);
+  while (parser.Read())
+    ;
+}
+
 void BuildIntermediateData(std::vector<OsmElement> && elements,
                            cache::IntermediateDataWriter & cache, TownsDumper & towns,
                            bool concurrent)
@@ -175,17 +243,17 @@ void BuildIntermediateData(std::vector<OsmElement> && elements,
   if (firstElementType == OsmElement::EntityType::Relation)
     relations.reserve(elements.size());
 
+  towns.CheckElements(elements, concurrent);
   for (auto & osmElement : elements)
   {
-    towns.CheckElement(osmElement, concurrent);
-
     auto const id = osmElement.m_id;
     switch (osmElement.m_type)
     {
     case OsmElement::EntityType::Node:
     {
-      nodes.emplace_back(id, NodeElement{});
-      BuildIntermediateNode(std::move(osmElement), nodes.back().second);
+      // The latitudes are converted at once below.
+      nodes.emplace_back(
+          id, NodeElement{id, osmElement.m_lat, MercatorBounds::LonToX(osmElement.m_lon)});
       break;
     }
     case OsmElement::EntityType::Way:
@@ -208,7 +276,16 @@ void BuildIntermediateData(std::vector<OsmElement> && elements,
   }
 
   if (!nodes.empty())
+  {
+    std::vector<double> ys(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+      ys[i] = nodes[i].second.m_lat;
+    MercatorBounds::LatToY(ys.data(), ys.size(), ys.data());
+    for (size_t i = 0; i < nodes.size(); ++i)
+      nodes[i].second.m_lat = ys[i];
+
     cache.AddNodes(std::move(nodes), concurrent);
+  }
   if (!ways.empty())
     cache.AddWays(std::move(ways), concurrent);
   if (!relations.empty())
@@ -236,9 +313,38 @@ void BuildIntermediateDataFromO5M(
   BuildIntermediateData(std::move(elements), cache, towns, concurrent);
 }
 
+void BuildIntermediateDataFromO5MRanges(
+    boost::iostreams::mapped_file_source const & sourceMap, std::vector<O5MRange> const & ranges,
+    cache::IntermediateDataWriter & cache, TownsDumper & towns, unsigned int threadsCount,
+    size_t chunkSize)
+{
+  std::atomic<size_t> nextRange{0};
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([&] {
+      namespace io = boost::iostreams;
+      for (auto r = nextRange++; r < ranges.size(); r = nextRange++)
+      {
+        auto const & range = ranges[r];
+        auto && sourceArray = io::array_source{sourceMap.data() + range.m_begin,
+                                               static_cast<size_t>(range.m_end - range.m_begin)};
+        auto && stream = io::stream<io::array_source>{sourceArray, std::ios::binary};
+        auto && reader = SourceReader(stream);
+        auto && o5mReader = ProcessorOsmElementsFromO5M(reader, 1 /* taskCount */, 0 /* taskId */,
+                                                        chunkSize, range.m_begin == 0);
+        BuildIntermediateDataFromO5M(o5mReader, cache, towns, true /* concurrent */);
+      }
+    });
+  }
+
+  for (auto & thread : threads)
+    thread.join();
+}
+
 void BuildIntermediateDataFromO5M(
-    std::string const & filename, cache::IntermediateDataWriter & cache, TownsDumper & towns,
-    unsigned int threadsCount)
+    std::string const & filename, std::string const & resetsIndexFilename,
+    cache::IntermediateDataWriter & cache, TownsDumper & towns, unsigned int threadsCount)
 {
   if (filename.empty())
   {
@@ -259,9 +365,22 @@ void BuildIntermediateDataFromO5M(
   });
   readaheadTask.detach();
 
+  // The block index of the file is saved for the features generation.
+  auto const resetOffsets = FindO5MResetOffsets(sourceMap.data(), sourceMap.size());
+  SaveO5MResetOffsets(resetsIndexFilename, sourceMap.size(), resetOffsets);
+
   constexpr size_t chunkSize = 10'000;
+  threadsCount = std::max(threadsCount, 1u);
+  auto const ranges = MakeO5MRangesForThreads(resetOffsets, sourceMap.size(), threadsCount);
+  if (!ranges.empty())
+  {
+    LOG_SHORT(LINFO, ("Decoding", ranges.size(), "o5m ranges in", threadsCount, "threads"));
+    return BuildIntermediateDataFromO5MRanges(sourceMap, ranges, cache, towns, threadsCount,
+                                              chunkSize);
+  }
+
   std::vector<std::thread> threads;
-  for (unsigned int i = 0; i < std::max(threadsCount, 1u); ++i)
+  for (unsigned int i = 0; i < threadsCount; ++i)
   {
     threads.emplace_back([&sourceMap, &cache, &towns, threadsCount, i] {
       namespace io = boost::iostreams;
@@ -277,6 +396,54 @@ void BuildIntermediateDataFromO5M(
     thread.join();
 }
 
+void BuildIntermediateDataFromPbf(std::string const & filename,
+                                  cache::IntermediateDataWriter & cache, TownsDumper & towns,
+                                  unsigned int threadsCount)
+{
+  if (filename.empty())
+  {
+    // Read form stdin.
+    auto && reader = SourceReader{};
+    ProcessorOsmElementsFromPbf pbfReader(reader);
+    std::vector<OsmElement> elements;
+    while (pbfReader.ReadBlob(elements))
+      BuildIntermediateData(std::move(elements), cache, towns, false /* concurrent */);
+    return;
+  }
+
+  LOG_SHORT(LINFO, ("Reading OSM data from", filename));
+
+  auto sourceMap = boost::iostreams::mapped_file_source{filename};
+  if (!sourceMap.is_open())
+    MYTHROW(Writer::OpenException, ("Failed to open", filename));
+  // Try aggressively (MADV_WILLNEED) and asynchronously read ahead the pbf-file.
+  auto readaheadTask = std::thread([data = sourceMap.data(), size = sourceMap.size()] {
+    ::madvise(const_cast<char*>(data), size, MADV_WILLNEED);
+  });
+  readaheadTask.detach();
+
+  // Blobs are independent, every thread takes the next one, so the nodes of a blob
+  // are added to the cache by one batch.
+  auto const blobs = pbf::FindDataBlobs(sourceMap.data(), sourceMap.size());
+  threadsCount = std::max(threadsCount, 1u);
+  LOG_SHORT(LINFO, ("Decoding", blobs.size(), "pbf blobs in", threadsCount, "threads"));
+
+  std::atomic<size_t> nextBlob{0};
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([&sourceMap, &blobs, &nextBlob, &cache, &towns, threadsCount] {
+      ProcessorOsmElementsFromPbf pbfReader(sourceMap.data(), blobs, nextBlob);
+      std::vector<OsmElement> elements;
+      while (pbfReader.ReadBlob(elements))
+        BuildIntermediateData(std::move(elements), cache, towns, threadsCount > 1);
+    });
+  }
+
+  for (auto & thread : threads)
+    thread.join();
+}
+
 void ProcessOsmElementsFromO5M(SourceReader & stream, function<void(OsmElement &&)> processor)
 {
   ProcessorOsmElementsFromO5M processorOsmElementsFromO5M(stream);
@@ -286,12 +453,160 @@ void ProcessOsmElementsFromO5M(SourceReader & stream, function<void(OsmElement &
     processor(std::move(element));
 }
 
+void ProcessOsmElementViewsFromO5M(SourceReader & stream,
+                                   function<void(OsmElementView const &)> processor)
+{
+  ProcessorOsmElementsFromO5M processorOsmElementsFromO5M(stream, 1 /* taskCount */,
+                                                          0 /* taskId */, 1024 /* chunkSize */);
+
+  OsmElementsChunk chunk;
+  while (processorOsmElementsFromO5M.TryRead(chunk))
+  {
+    for (auto const & element : chunk)
+      processor(element);
+  }
+}
+
+vector<uint64_t> FindO5MResetOffsets(char const * data, size_t size)
+{
+  using Type = osm::O5MSource::EntityType;
+
+  vector<uint64_t> offsets;
+  auto const * bytes = reinterpret_cast<uint8_t const *>(data);
+  size_t pos = 0;
+  while (pos < size)
+  {
+    auto const type = bytes[pos];
+    if (type == base::Underlying(Type::End))
+      break;
+    if (type == base::Underlying(Type::Reset))
+      offsets.push_back(pos);
+    ++pos;
+
+    // Datasets 0xf0-0xff consist of a single byte, others are followed by their lengths.
+    if (type >= 0xf0)
+      continue;
+
+    uint64_t length = 0;
+    uint8_t shift = 0;
+    uint8_t b = 0;
+    do
+    {
+      CHECK_LESS(pos, size, ("Unexpected end of o5m data."));
+      b = bytes[pos++];
+      length |= static_cast<uint64_t>(b & 0x7f) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    pos += length;
+  }
+  return offsets;
+}
+
+vector<O5MRange> SplitO5MAtResets(vector<uint64_t> const & resetOffsets, uint64_t size,
+                                  uint64_t minRangeSize)
+{
+  vector<O5MRange> ranges;
+  if (resetOffsets.empty())
+    return ranges;
+
+  CHECK_EQUAL(resetOffsets.front(), 0, ("An o5m file must start with a reset."));
+  O5MRange range;
+  for (auto const offset : resetOffsets)
+  {
+    if (offset == range.m_begin || offset - range.m_begin < minRangeSize)
+      continue;
+
+    range.m_end = offset;
+    ranges.push_back(range);
+    range.m_begin = offset;
+  }
+  range.m_end = size;
+  ranges.push_back(range);
+  return ranges;
+}
+
+vector<O5MRange> MakeO5MRangesForThreads(vector<uint64_t> const & resetOffsets, uint64_t size,
+                                         unsigned int threadsCount)
+{
+  if (threadsCount <= 1)
+    return {};
+
+  // Several ranges per thread smooth out the differences in the decoding speed of the ranges.
+  auto ranges = SplitO5MAtResets(resetOffsets, size, size / (threadsCount * 4));
+  auto const maxRangeSize = accumulate(
+      ranges.begin(), ranges.end(), uint64_t{0}, [](uint64_t maxSize, O5MRange const & range) {
+        return max(maxSize, range.m_end - range.m_begin);
+      });
+  if (ranges.size() < threadsCount || maxRangeSize > 2 * size / threadsCount)
+    return {};
+  return ranges;
+}
+
+void SaveO5MResetOffsets(string const & filename, uint64_t fileSize,
+                         vector<uint64_t> const & resetOffsets)
+{
+  FileWriter writer(filename);
+  WriteToSink(writer, fileSize);
+  WriteToSink(writer, static_cast<uint64_t>(resetOffsets.size()));
+  for (auto const offset : resetOffsets)
+    WriteToSink(writer, offset);
+}
+
+bool LoadO5MResetOffsets(string const & filename, uint64_t fileSize,
+                         vector<uint64_t> & resetOffsets)
+{
+  if (!Platform::IsFileExistsByFullPath(filename))
+    return false;
+
+  try
+  {
+    FileReader reader(filename);
+    ReaderSource<FileReader> source(reader);
+    if (ReadPrimitiveFromSource<uint64_t>(source) != fileSize)
+    {
+      LOG_SHORT(LWARNING, ("The o5m block index", filename, "was built for another file."));
+      return false;
+    }
+
+    resetOffsets.resize(ReadPrimitiveFromSource<uint64_t>(source));
+    for (auto & offset : resetOffsets)
+      offset = ReadPrimitiveFromSource<uint64_t>(source);
+  }
+  catch (Reader::Exception const & e)
+  {
+    LOG_SHORT(LWARNING, ("Failed to read the o5m block index", filename, e.Msg()));
+    return false;
+  }
+  return true;
+}
+
+namespace
+{
+OsmElement::EntityType TranslateO5MEntityType(osm::O5MSource::EntityType type)
+{
+  using Type = osm::O5MSource::EntityType;
+  switch (type)
+  {
+  case Type::Node: return OsmElement::EntityType::Node;
+  case Type::Way: return OsmElement::EntityType::Way;
+  case Type::Relation: return OsmElement::EntityType::Relation;
+  default: return OsmElement::EntityType::Unknown;
+  }
+}
+}  // namespace
+
 ProcessorOsmElementsFromO5M::ProcessorOsmElementsFromO5M(
-    SourceReader & stream, size_t taskCount, size_t taskId, size_t chunkSize)
+    SourceReader & stream, size_t taskCount, size_t taskId, size_t chunkSize, bool withHeader)
   : m_stream(stream)
   , m_dataset([&](uint8_t * buffer, size_t size) {
-      return m_stream.Read(reinterpret_cast<char *>(buffer), size);
-    }, 1024 * 1024)
+      auto const readBytes = m_stream.Read(reinterpret_cast<char *>(buffer), size);
+      if (readBytes != 0 || m_endAdded || size == 0)
+        return static_cast<size_t>(readBytes);
+
+      m_endAdded = true;
+      buffer[0] = base::Underlying(osm::O5MSource::EntityType::End);
+      return size_t{1};
+    }, 1024 * 1024, withHeader)
   , m_taskCount{taskCount}
   , m_taskId{taskId}
   , m_chunkSize{chunkSize}
@@ -315,22 +630,69 @@ bool ProcessorOsmElementsFromO5M::TryRead(OsmElement & element)
   return false;
 }
 
+bool ProcessorOsmElementsFromO5M::TryRead(OsmElementsChunk & chunk)
+{
+  chunk.Clear();
+  while (m_pos != m_dataset.end() && chunk.Size() < m_chunkSize)
+  {
+    auto const chunkId = m_elementCounter / m_chunkSize;
+    auto const chunkTaskId = chunkId % m_taskCount;
+    if (chunkTaskId == m_taskId)
+    {
+      Read(chunk);
+      continue;
+    }
+
+    ++m_pos;
+    ++m_elementCounter;
+  }
+
+  return !chunk.Empty();
+}
+
+void ProcessorOsmElementsFromO5M::Read(OsmElementsChunk & chunk)
+{
+  using Type = osm::O5MSource::EntityType;
+
+  // See the order remarks in Read(OsmElement &).
+  auto const & entity = *m_pos;
+  auto & element = chunk.AddElement(TranslateO5MEntityType(entity.type), entity.id);
+  switch (entity.type)
+  {
+  case Type::Node:
+  {
+    element.m_lat = entity.lat;
+    element.m_lon = entity.lon;
+    break;
+  }
+  case Type::Way:
+  {
+    for (uint64_t nd : entity.Nodes())
+      chunk.AddNd(nd);
+    break;
+  }
+  case Type::Relation:
+  {
+    for (auto const & member : entity.Members())
+      chunk.AddMember(member.ref, TranslateO5MEntityType(member.type), member.role);
+    break;
+  }
+  default: break;
+  }
+
+  for (auto const & tag : entity.Tags())
+    chunk.AddTag(tag.key, tag.value);
+
+  ++m_pos;
+  ++m_elementCounter;
+}
+
 bool ProcessorOsmElementsFromO5M::Read(OsmElement & element)
 {
   using Type = osm::O5MSource::EntityType;
 
   element.Clear();
 
-  auto const translate = [](Type t) -> OsmElement::EntityType {
-    switch (t)
-    {
-    case Type::Node: return OsmElement::EntityType::Node;
-    case Type::Way: return OsmElement::EntityType::Way;
-    case Type::Relation: return OsmElement::EntityType::Relation;
-    default: return OsmElement::EntityType::Unknown;
-    }
-  };
-
   // Be careful, we could call Nodes(), Members(), Tags() from O5MSource::Entity
   // only once (!). Because these functions read data from file simultaneously with
   // iterating in loop. Furthermore, into Tags() method calls Nodes.Skip() and Members.Skip(),
@@ -358,7 +720,7 @@ bool ProcessorOsmElementsFromO5M::Read(OsmElement & element)
   {
     element.m_type = OsmElement::EntityType::Relation;
     for (auto const & member : entity.Members())
-      element.AddMember(member.ref, translate(member.type), member.role);
+      element.AddMember(member.ref, TranslateO5MEntityType(member.type), member.role);
     break;
   }
   default: break;
@@ -372,9 +734,74 @@ bool ProcessorOsmElementsFromO5M::Read(OsmElement & element)
   return true;
 }
 
+ProcessorOsmElementsFromPbf::ProcessorOsmElementsFromPbf(SourceReader & stream)
+  : m_stream(&stream)
+{
+}
+
+ProcessorOsmElementsFromPbf::ProcessorOsmElementsFromPbf(
+    char const * data, std::vector<pbf::BlobRef> const & blobs, std::atomic<size_t> & nextBlob)
+  : m_data(data), m_blobs(&blobs), m_nextBlob(&nextBlob)
+{
+}
+
+bool ProcessorOsmElementsFromPbf::TryRead(OsmElement & element)
+{
+  while (m_pos == m_elements.size())
+  {
+    m_pos = 0;
+    if (!ReadBlob(m_elements))
+      return false;
+  }
+
+  element = std::move(m_elements[m_pos++]);
+  return true;
+}
+
+bool ProcessorOsmElementsFromPbf::ReadBlob(std::vector<OsmElement> & elements)
+{
+  elements.clear();
+  if (m_blobs)
+  {
+    auto const blobIndex = (*m_nextBlob)++;
+    if (blobIndex >= m_blobs->size())
+      return false;
+
+    auto const & blob = (*m_blobs)[blobIndex];
+    pbf::DecodeDataBlob(m_data + blob.m_offset, blob.m_size, elements);
+    return true;
+  }
+
+  auto const read = [this](char * buffer, size_t size) {
+    return static_cast<size_t>(m_stream->Read(buffer, size));
+  };
+  while (pbf::ReadBlob(read, m_blobType, m_blob))
+  {
+    if (m_blobType == "OSMHeader")
+    {
+      pbf::CheckHeaderBlob(m_blob.data(), m_blob.size());
+    }
+    else if (m_blobType == "OSMData")
+    {
+      pbf::DecodeDataBlob(m_blob.data(), m_blob.size(), elements);
+      return true;
+    }
+  }
+  return false;
+}
+
 ProcessorOsmElementsFromXml::ProcessorOsmElementsFromXml(SourceReader & stream)
   : m_xmlSource([&, this](auto * element) { m_queue.emplace(*element); })
-  , m_parser(stream, m_xmlSource)
+  , m_parser(std::make_unique<XMLSequenceParser<SourceReader, XMLSource>>(stream, m_xmlSource))
+{
+}
+
+ProcessorOsmElementsFromXml::ProcessorOsmElementsFromXml(
+    char const * data, std::vector<xml::ChunkRef> const & chunks, std::atomic<size_t> & nextChunk)
+  : m_xmlSource([](auto * /* element */) {})
+  , m_data(data)
+  , m_chunks(&chunks)
+  , m_nextChunk(&nextChunk)
 {
 }
 
@@ -390,14 +817,39 @@ bool ProcessorOsmElementsFromXml::TryReadFromQueue(OsmElement & element)
 
 bool ProcessorOsmElementsFromXml::TryRead(OsmElement & element)
 {
+  if (m_chunks)
+  {
+    while (m_pos == m_elements.size())
+    {
+      m_pos = 0;
+      if (!ReadChunk(m_elements))
+        return false;
+    }
+
+    element = std::move(m_elements[m_pos++]);
+    return true;
+  }
+
   do {
     if (TryReadFromQueue(element))
       return true;
-  } while (m_parser.Read());
+  } while (m_parser->Read());
 
   return TryReadFromQueue(element);
 }
 
+bool ProcessorOsmElementsFromXml::ReadChunk(std::vector<OsmElement> & elements)
+{
+  CHECK(m_chunks, ("The chunks are read from a mapped file only."));
+  elements.clear();
+  auto const chunkIndex = (*m_nextChunk)++;
+  if (chunkIndex >= m_chunks->size())
+    return false;
+
+  xml::DecodeChunk(m_data, (*m_chunks)[chunkIndex], elements);
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Generate functions implementations.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -408,6 +860,8 @@ bool GenerateIntermediateData(feature::GenerateInfo const & info)
                                                info.GetIntermediateFileName(NODES_FILE));
   cache::IntermediateDataWriter cache(*nodes, info);
   TownsDumper towns;
+  // The changes of the previous data are outdated.
+  cache::IntermediateDataOverlayWriter::Remove(info);
 
   LOG(LINFO, ("Data source:", info.m_osmFileName));
 
@@ -417,7 +871,12 @@ bool GenerateIntermediateData(feature::GenerateInfo const & info)
     BuildIntermediateDataFromXML(info.m_osmFileName, cache, towns);
     break;
   case feature::GenerateInfo::OsmSourceType::O5M:
-    BuildIntermediateDataFromO5M(info.m_osmFileName, cache, towns, info.m_threadsCount);
+    BuildIntermediateDataFromO5M(info.m_osmFileName,
+                                 info.GetIntermediateFileName(O5M_RESETS_FILE), cache, towns,
+                                 info.m_threadsCount);
+    break;
+  case feature::GenerateInfo::OsmSourceType::PBF:
+    BuildIntermediateDataFromPbf(info.m_osmFileName, cache, towns, info.m_threadsCount);
     break;
   }
 
@@ -426,4 +885,24 @@ bool GenerateIntermediateData(feature::GenerateInfo const & info)
   LOG(LINFO, ("Added points count =", nodes->GetNumProcessedPoints()));
   return true;
 }
+
+bool ApplyOsmChange(feature::GenerateInfo const & info, std::string const & oscFilename)
+{
+  LOG(LINFO, ("Changes source:", oscFilename));
+
+  cache::IntermediateDataOverlayWriter overlay(info);
+  SourceReader reader(oscFilename);
+  size_t changesCount = 0;
+  ProcessOsmChangeFromXML(reader, [&](OsmChangeXMLSource::Action action, OsmElement && element) {
+    if (action == OsmChangeXMLSource::Action::Unknown)
+      return;
+
+    AddChangeToOverlay(overlay, action, std::move(element));
+    ++changesCount;
+  });
+
+  overlay.Save();
+  LOG(LINFO, ("Applied changes count =", changesCount));
+  return true;
+}
 }  // namespace generator
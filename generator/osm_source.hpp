@@ -2,18 +2,23 @@
 
 #include "generator/generate_info.hpp"
 #include "generator/intermediate_data.hpp"
+#include "generator/osm_element_view.hpp"
 #include "generator/osm_o5m_source.hpp"
+#include "generator/osm_pbf_source.hpp"
 #include "generator/osm_xml_source.hpp"
 #include "generator/translator_interface.hpp"
 
 #include "coding/parse_xml.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <queue>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct OsmElement;
 class FeatureParams;
@@ -45,7 +50,47 @@ public:
 
 bool GenerateIntermediateData(feature::GenerateInfo const & info);
 
+// Applies the osmChange diff |oscFilename| to the intermediate data of |info| generated by
+// GenerateIntermediateData(), see cache::IntermediateDataOverlayWriter.
+bool ApplyOsmChange(feature::GenerateInfo const & info, std::string const & oscFilename);
+
+void ProcessOsmChangeFromXML(
+    SourceReader & stream, std::function<void(OsmChangeXMLSource::Action, OsmElement &&)> processor);
+
 void ProcessOsmElementsFromO5M(SourceReader & stream, std::function<void(OsmElement &&)> processor);
+// Same as ProcessOsmElementsFromO5M() but the elements are not copied, see OsmElementView.
+void ProcessOsmElementViewsFromO5M(SourceReader & stream,
+                                   std::function<void(OsmElementView const &)> processor);
+
+// A byte range [m_begin, m_end) of an o5m file which starts at a reset dataset,
+// so it can be decoded independently from the preceding data.
+struct O5MRange
+{
+  uint64_t m_begin = 0;
+  uint64_t m_end = 0;
+};
+
+// Returns the offsets of the reset datasets of an o5m file. Datasets are skipped by their
+// lengths, so the scan is much faster than decoding.
+std::vector<uint64_t> FindO5MResetOffsets(char const * data, size_t size);
+
+// Splits |size| bytes of an o5m file at |resetOffsets| into consecutive ranges.
+// Every range but the last one is at least |minRangeSize| bytes long.
+std::vector<O5MRange> SplitO5MAtResets(std::vector<uint64_t> const & resetOffsets, uint64_t size,
+                                       uint64_t minRangeSize);
+
+// Returns ranges of an o5m file of |size| bytes for |threadsCount| threads. Returns nothing
+// when there are not enough resets to balance the threads.
+std::vector<O5MRange> MakeO5MRangesForThreads(std::vector<uint64_t> const & resetOffsets,
+                                              uint64_t size, unsigned int threadsCount);
+
+// The block index of an o5m file: the reset offsets and the file size to check that
+// the index is built for the same file.
+void SaveO5MResetOffsets(std::string const & filename, uint64_t fileSize,
+                         std::vector<uint64_t> const & resetOffsets);
+// Returns false when there is no index for a file of |fileSize| bytes.
+bool LoadO5MResetOffsets(std::string const & filename, uint64_t fileSize,
+                         std::vector<uint64_t> & resetOffsets);
 void ProcessOsmElementsFromXML(SourceReader & stream, std::function<void(OsmElement &&)> processor);
 
 class ProcessorOsmElementsInterface
@@ -59,17 +104,23 @@ public:
 class ProcessorOsmElementsFromO5M : public ProcessorOsmElementsInterface
 {
 public:
+  // |withHeader| is false when |stream| is an O5MRange in the middle of a file.
   explicit ProcessorOsmElementsFromO5M(SourceReader & stream,
                                        size_t taskCount = 1, size_t taskId = 0,
-                                       size_t chunkSize = 1);
+                                       size_t chunkSize = 1, bool withHeader = true);
 
   // ProcessorOsmElementsInterface overrides:
   bool TryRead(OsmElement & element) override;
+  // Reads the next chunk of the task elements to |chunk| without copying the strings
+  // to OsmElements. Returns false when there are no more elements.
+  bool TryRead(OsmElementsChunk & chunk);
 
   size_t ChunkSize() const noexcept { return m_chunkSize; }
 
 private:
   SourceReader & m_stream;
+  // A range of a file ends without the end dataset, it is added after the stream end.
+  bool m_endAdded = false;
   osm::O5MSource m_dataset;
   size_t const m_taskCount;
   size_t const m_taskId;
@@ -78,21 +129,63 @@ private:
   osm::O5MSource::Iterator m_pos;
 
   bool Read(OsmElement & element);
+  void Read(OsmElementsChunk & chunk);
+};
+
+class ProcessorOsmElementsFromPbf : public ProcessorOsmElementsInterface
+{
+public:
+  // Decodes the blobs of |stream| one by one.
+  explicit ProcessorOsmElementsFromPbf(SourceReader & stream);
+  // Decodes the |blobs| of the file mapped to |data|. Processors sharing |nextBlob|
+  // decode different blobs, so a file is decoded by them in parallel.
+  ProcessorOsmElementsFromPbf(char const * data, std::vector<pbf::BlobRef> const & blobs,
+                              std::atomic<size_t> & nextBlob);
+
+  // ProcessorOsmElementsInterface overrides:
+  bool TryRead(OsmElement & element) override;
+
+  // Returns the elements of the next blob. Returns false at the end of the data.
+  bool ReadBlob(std::vector<OsmElement> & elements);
+
+private:
+  SourceReader * m_stream = nullptr;
+  char const * m_data = nullptr;
+  std::vector<pbf::BlobRef> const * m_blobs = nullptr;
+  std::atomic<size_t> * m_nextBlob = nullptr;
+  std::string m_blobType;
+  std::string m_blob;
+  std::vector<OsmElement> m_elements;
+  size_t m_pos = 0;
 };
 
 class ProcessorOsmElementsFromXml : public ProcessorOsmElementsInterface
 {
 public:
+  // Parses |stream| sequentially.
   explicit ProcessorOsmElementsFromXml(SourceReader & stream);
+  // Parses the |chunks| of the file mapped to |data|. Processors sharing |nextChunk|
+  // parse different chunks, so a file is parsed by them in parallel.
+  ProcessorOsmElementsFromXml(char const * data, std::vector<xml::ChunkRef> const & chunks,
+                              std::atomic<size_t> & nextChunk);
 
   // ProcessorOsmElementsInterface overrides:
   bool TryRead(OsmElement & element) override;
 
+  // Returns the elements of the next chunk. Returns false at the end of the data.
+  bool ReadChunk(std::vector<OsmElement> & elements);
+
 private:
   bool TryReadFromQueue(OsmElement & element);
 
   XMLSource m_xmlSource;
-  XMLSequenceParser<SourceReader, XMLSource> m_parser;
+  std::unique_ptr<XMLSequenceParser<SourceReader, XMLSource>> m_parser;
   std::queue<OsmElement> m_queue;
+
+  char const * m_data = nullptr;
+  std::vector<xml::ChunkRef> const * m_chunks = nullptr;
+  std::atomic<size_t> * m_nextChunk = nullptr;
+  std::vector<OsmElement> m_elements;
+  size_t m_pos = 0;
 };
 }  // namespace generator
@@ -0,0 +1,94 @@
+#include "generator/osm_xml_source.hpp"
+
+#include "coding/parse_xml.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace generator
+{
+namespace xml
+{
+namespace
+{
+// The chunks after the first one have no root element of their own.
+char const kRootElement[] = "<osm>";
+
+bool IsTopLevelElementAt(char const * data, size_t size, size_t pos)
+{
+  for (auto const name : {"<node", "<way", "<relation"})
+  {
+    auto const length = strlen(name);
+    if (size - pos > length && memcmp(data + pos, name, length) == 0)
+    {
+      auto const next = data[pos + length];
+      return next == ' ' || next == '\t' || next == '\n' || next == '\r' || next == '>' ||
+             next == '/';
+    }
+  }
+  return false;
+}
+
+// Returns the position of the first top-level element at or after |pos|, or |size|.
+size_t FindTopLevelElement(char const * data, size_t size, size_t pos)
+{
+  while (pos < size)
+  {
+    auto const tagStart = static_cast<char const *>(memchr(data + pos, '<', size - pos));
+    if (tagStart == nullptr)
+      return size;
+
+    pos = static_cast<size_t>(tagStart - data);
+    if (IsTopLevelElementAt(data, size, pos))
+      return pos;
+    ++pos;
+  }
+  return size;
+}
+
+template <typename Parser>
+void Parse(Parser & parser, char const * data, uint64_t size)
+{
+  // Expat takes the sizes of int.
+  uint64_t constexpr kMaxPartSize = numeric_limits<int>::max();
+  while (size != 0)
+  {
+    auto const partSize = min(size, kMaxPartSize);
+    if (!parser.Parse(data, static_cast<int>(partSize), false /* fIsFinal */))
+      MYTHROW(XmlParseError, (parser.GetErrorMessage()));
+
+    data += partSize;
+    size -= partSize;
+  }
+}
+}  // namespace
+
+vector<ChunkRef> FindChunks(char const * data, size_t size, size_t chunkSize)
+{
+  CHECK_GREATER(chunkSize, 0, ());
+  vector<ChunkRef> chunks;
+  size_t begin = 0;
+  while (begin < size)
+  {
+    auto const end =
+        size - begin > chunkSize ? FindTopLevelElement(data, size, begin + chunkSize) : size;
+    chunks.push_back({begin, end - begin});
+    begin = end;
+  }
+  return chunks;
+}
+
+void DecodeChunk(char const * data, ChunkRef const & chunk, vector<OsmElement> & elements)
+{
+  XMLSource source([&elements](OsmElement * element) { elements.emplace_back(move(*element)); });
+  XmlParser<XMLSource> parser(source);
+  CHECK(parser.Create(), ());
+  if (chunk.m_offset != 0)
+    Parse(parser, kRootElement, sizeof(kRootElement) - 1);
+  Parse(parser, data + chunk.m_offset, chunk.m_size);
+}
+}  // namespace xml
+}  // namespace generator
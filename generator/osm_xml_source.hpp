@@ -5,8 +5,11 @@
 #include "base/assert.hpp"
 #include "base/string_utils.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <vector>
 
 class XMLSource
 {
@@ -106,3 +109,88 @@ private:
 
   Emitter m_emitter;
 };
+
+// Parses osmChange (.osc) diffs. The elements of the diffs are wrapped into the <create>,
+// <modify> and <delete> actions, the actions are not passed to XMLSource, so it parses
+// the elements as the ones of .osm files.
+class OsmChangeXMLSource
+{
+public:
+  enum class Action
+  {
+    Unknown,
+    Create,
+    Modify,
+    Delete
+  };
+
+  using Emitter = std::function<void(Action, OsmElement *)>;
+
+  OsmChangeXMLSource(Emitter fn)
+    : m_source([this](OsmElement * element) { m_emitter(m_action, element); }), m_emitter(fn)
+  {
+  }
+
+  void CharData(std::string const & data) { m_source.CharData(data); }
+
+  void AddAttr(std::string const & key, std::string const & value)
+  {
+    if (m_depth != kActionDepth)
+      m_source.AddAttr(key, value);
+  }
+
+  bool Push(std::string const & tagName)
+  {
+    if (++m_depth != kActionDepth)
+      return m_source.Push(tagName);
+
+    if (tagName == "create")
+      m_action = Action::Create;
+    else if (tagName == "modify")
+      m_action = Action::Modify;
+    else if (tagName == "delete")
+      m_action = Action::Delete;
+    else
+      m_action = Action::Unknown;
+    return true;
+  }
+
+  void Pop(std::string const & tagName)
+  {
+    if (m_depth-- != kActionDepth)
+      m_source.Pop(tagName);
+    else
+      m_action = Action::Unknown;
+  }
+
+private:
+  static size_t constexpr kActionDepth = 2;
+
+  XMLSource m_source;
+  Action m_action = Action::Unknown;
+  size_t m_depth = 0;
+
+  Emitter m_emitter;
+};
+
+namespace generator
+{
+namespace xml
+{
+// A range of the top-level elements of an .osm file. The first chunk also has the header
+// and the root element of the file.
+struct ChunkRef
+{
+  uint64_t m_offset = 0;
+  uint64_t m_size = 0;
+};
+
+// Splits the .osm file mapped to |data| into the chunks of about |chunkSize| bytes. The chunks
+// begin with the top-level <node>, <way> and <relation> elements, which never nest in .osm
+// files, so a chunk is parsed independently. The chunks are in the order of the file.
+std::vector<ChunkRef> FindChunks(char const * data, size_t size, size_t chunkSize);
+
+// Parses the chunk of the file mapped to |data| and appends its elements to |elements|.
+void DecodeChunk(char const * data, ChunkRef const & chunk, std::vector<OsmElement> & elements);
+}  // namespace xml
+}  // namespace generator
@@ -0,0 +1,58 @@
+#include "generator/pipeline_stage_stats.hpp"
+
+#include "base/logging.hpp"
+
+namespace generator
+{
+namespace
+{
+uint64_t ToMicros(double seconds) { return static_cast<uint64_t>(seconds * 1e6); }
+double ToSeconds(uint64_t micros) { return static_cast<double>(micros) / 1e6; }
+}  // namespace
+
+void PipelineStageStats::AddInputWait(double seconds)
+{
+  m_inputWaitMicros.fetch_add(ToMicros(seconds), std::memory_order_relaxed);
+}
+
+void PipelineStageStats::AddOutputWait(double seconds)
+{
+  m_outputWaitMicros.fetch_add(ToMicros(seconds), std::memory_order_relaxed);
+}
+
+void PipelineStageStats::AddQueueDepth(size_t depth)
+{
+  m_queueDepthSamples.fetch_add(1, std::memory_order_relaxed);
+  m_queueDepthSum.fetch_add(depth, std::memory_order_relaxed);
+  auto maxDepth = m_maxQueueDepth.load(std::memory_order_relaxed);
+  while (maxDepth < depth &&
+         !m_maxQueueDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed))
+  {
+  }
+}
+
+double PipelineStageStats::GetInputWait() const { return ToSeconds(m_inputWaitMicros); }
+
+double PipelineStageStats::GetOutputWait() const { return ToSeconds(m_outputWaitMicros); }
+
+double PipelineStageStats::GetMeanQueueDepth() const
+{
+  auto const samples = m_queueDepthSamples.load();
+  return samples == 0 ? 0.0 : static_cast<double>(m_queueDepthSum) / samples;
+}
+
+void PipelineStageStats::Log(unsigned int workersCount, double seconds) const
+{
+  auto const perSecond = seconds > 0.0 ? static_cast<double>(m_items) / seconds : 0.0;
+  // The waits are averaged over the workers to compare them with the wall time.
+  auto const workers = workersCount == 0 ? 1.0 : static_cast<double>(workersCount);
+  LOG(LINFO, ("Stage", m_name, "workers:", workersCount, "items:", m_items,
+              "items per second:", perSecond, "input wait, s:", GetInputWait() / workers,
+              "output wait, s:", GetOutputWait() / workers, "wall time, s:", seconds));
+  if (m_queueDepthSamples != 0)
+  {
+    LOG(LINFO, ("Stage", m_name, "mean queue depth:", GetMeanQueueDepth(),
+                "max queue depth:", GetMaxQueueDepth()));
+  }
+}
+}  // namespace generator
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace generator
+{
+// Throughput counters of a stage of the features generation pipeline, see RawGenerator.
+// The workers of a stage wait for the input when the previous stage is the bottleneck
+// and for the room in the output queue when the next stage is.
+class PipelineStageStats
+{
+public:
+  explicit PipelineStageStats(std::string const & name) : m_name(name) {}
+
+  void AddItems(uint64_t count) { m_items.fetch_add(count, std::memory_order_relaxed); }
+  void AddInputWait(double seconds);
+  void AddOutputWait(double seconds);
+  // Samples the depth of the input queue of the stage.
+  void AddQueueDepth(size_t depth);
+
+  uint64_t GetItems() const { return m_items; }
+  double GetInputWait() const;
+  double GetOutputWait() const;
+  double GetMeanQueueDepth() const;
+  uint64_t GetMaxQueueDepth() const { return m_maxQueueDepth; }
+
+  // Logs the counters of |workersCount| workers which worked for |seconds|.
+  void Log(unsigned int workersCount, double seconds) const;
+
+private:
+  std::string m_name;
+  std::atomic<uint64_t> m_items{0};
+  std::atomic<uint64_t> m_inputWaitMicros{0};
+  std::atomic<uint64_t> m_outputWaitMicros{0};
+  std::atomic<uint64_t> m_queueDepthSamples{0};
+  std::atomic<uint64_t> m_queueDepthSum{0};
+  std::atomic<uint64_t> m_maxQueueDepth{0};
+};
+}  // namespace generator
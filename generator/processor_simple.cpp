@@ -5,33 +5,45 @@
 
 #include "base/macros.hpp"
 
+#include <tuple>
+#include <utility>
+
 namespace generator
 {
 ProcessorSimple::ProcessorSimple(std::shared_ptr<FeatureProcessorQueue> const & queue,
                                  std::string const & name)
+  : ProcessorSimple(queue, name, std::make_shared<feature::SingleAffiliation const>(name))
+{
+}
+
+ProcessorSimple::ProcessorSimple(
+    std::shared_ptr<FeatureProcessorQueue> const & queue, std::string const & name,
+    std::shared_ptr<feature::AffiliationInterface const> const & affiliation)
   : m_name(name)
   , m_queue(queue)
+  , m_affiliation(affiliation)
+  , m_pipeline(std::make_tuple(),
+               std::make_tuple(kAffiliationsBufferSize, m_affiliation, m_queue))
 {
-  m_processingChain = std::make_shared<PreserializeLayer>();
-  auto affiliation = std::make_shared<feature::SingleAffiliation>(name);
-  m_affiliationsLayer = std::make_shared<AffiliationsFeatureLayer<
-                       feature::serialization_policy::MinSize>>(kAffiliationsBufferSize, affiliation, m_queue);
-  m_processingChain->Add(m_affiliationsLayer);
+  m_batch.reserve(kBatchSize);
 }
 
 std::shared_ptr<FeatureProcessorInterface>ProcessorSimple::Clone() const
 {
-  return std::make_shared<ProcessorSimple>(m_queue, m_name);
+  return std::make_shared<ProcessorSimple>(m_queue, m_name, m_affiliation);
 }
 
 void ProcessorSimple::Process(feature::FeatureBuilder & fb)
 {
-  m_processingChain->Handle(fb);
+  m_batch.push_back(std::move(fb));
+  if (m_batch.size() == kBatchSize)
+    HandleBatch();
 }
 
 void ProcessorSimple::Finish()
 {
-  m_affiliationsLayer->Flush();
+  HandleBatch();
+  m_pipeline.GetNext().GetLayer().Flush();
 }
 
 void ProcessorSimple::Merge(FeatureProcessorInterface const & other)
@@ -41,6 +53,13 @@ void ProcessorSimple::Merge(FeatureProcessorInterface const & other)
 
 void ProcessorSimple::MergeInto(ProcessorSimple & other) const
 {
-  other.m_processingChain->MergeChain(m_processingChain);
+  other.m_pipeline.Merge(m_pipeline);
+}
+
+void ProcessorSimple::HandleBatch()
+{
+  // The layers may leave some features in the batch, they are not needed anymore.
+  m_pipeline.HandleBatch(m_batch);
+  m_batch.clear();
 }
 }  // namespace generator
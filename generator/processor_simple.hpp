@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace generator
 {
@@ -16,6 +17,9 @@ public:
   // |name| is bucket name. For example it may be "World", "geo_objects", "regions" etc.
   explicit ProcessorSimple(std::shared_ptr<FeatureProcessorQueue> const & queue,
                            std::string const & name);
+  // The read-only |affiliation| is shared by all the clones of the processor.
+  ProcessorSimple(std::shared_ptr<FeatureProcessorQueue> const & queue, std::string const & name,
+                  std::shared_ptr<feature::AffiliationInterface const> const & affiliation);
 
   // FeatureProcessorInterface overrides:
   std::shared_ptr<FeatureProcessorInterface> Clone() const override;
@@ -29,9 +33,19 @@ public:
   std::string GetFilename() const { return m_name; }
 
 private:
+  using Pipeline =
+      LayersPipeline<PreserializeLayer,
+                     AffiliationsFeatureLayer<feature::serialization_policy::MinSize>>;
+
+  // The features are passed through the layers by batches of this size.
+  static size_t const kBatchSize = 256;
+
+  void HandleBatch();
+
   std::string m_name;
-  std::shared_ptr<AffiliationsFeatureLayer<feature::serialization_policy::MinSize>> m_affiliationsLayer;
   std::shared_ptr<FeatureProcessorQueue> m_queue;
-  std::shared_ptr<LayerBase> m_processingChain;
+  std::shared_ptr<feature::AffiliationInterface const> m_affiliation;
+  Pipeline m_pipeline;
+  std::vector<feature::FeatureBuilder> m_batch;
 };
 }  // namespace generator
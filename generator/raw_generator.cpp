@@ -3,12 +3,23 @@
 #include "generator/osm_source.hpp"
 #include "generator/processor_factory.hpp"
 #include "generator/raw_generator_writer.hpp"
+#include "generator/stages_report.hpp"
 #include "generator/translator_factory.hpp"
 
+#include "base/prof.hpp"
+#include "base/thread_affinity.hpp"
 #include "base/thread_pool_computational.hpp"
+#include "base/timer.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <boost/iostreams/device/array.hpp>
@@ -16,15 +27,48 @@
 
 #include <sys/mman.h>
 
+#include "defines.hpp"
+
 using namespace std;
 
 namespace generator
 {
+namespace
+{
+// The capacity of the queue between the decode and the translate stages.
+size_t const kBatchesPerTranslateThread = 4;
+// The capacity of the queue of RawGeneratorWriter.
+size_t const kWriterChunksPerThread = 16;
+// The size of the chunks of an xml file which are parsed in parallel, a chunk is a batch of
+// about ten thousand nodes.
+size_t const kXmlChunkSize = 1024 * 1024;
+// The default share of the decode stage threads.
+unsigned int const kThreadsPerDecodeThread = 4;
+// The default share of the threads writing the features.
+unsigned int const kThreadsPerWriteThread = 8;
+
+// Estimates the memory of |element| with its heap buffers, the allocator overhead and the spare
+// capacity of the strings are not counted.
+uint64_t GetMemorySize(OsmElement const & element)
+{
+  uint64_t size = sizeof(element) + element.m_k.size() + element.m_v.size() +
+                  element.m_role.size() + element.m_nodes.capacity() * sizeof(uint64_t) +
+                  element.m_members.capacity() * sizeof(OsmElement::Member) +
+                  element.m_tags.capacity() * sizeof(OsmElement::Tag);
+  for (auto const & member : element.m_members)
+    size += member.m_role.size();
+  for (auto const & tag : element.m_tags)
+    size += tag.m_key.size() + tag.m_value.size();
+  return size;
+}
+}  // namespace
+
 RawGenerator::RawGenerator(feature::GenerateInfo & genInfo, size_t chunkSize)
   : m_genInfo(genInfo)
   , m_chunkSize(chunkSize)
   , m_cache(std::make_shared<generator::cache::IntermediateData>(genInfo))
-  , m_queue(std::make_shared<FeatureProcessorQueue>())
+  , m_queue(std::make_shared<FeatureProcessorQueue>(kWriterChunksPerThread *
+                                                     std::max(genInfo.m_threadsCount, 1u)))
   , m_translators(std::make_shared<TranslatorCollection>())
 {
 }
@@ -63,33 +107,109 @@ void RawGenerator::GenerateCustom(std::shared_ptr<TranslatorInterface> const & t
                                   std::shared_ptr<FinalProcessorIntermediateMwmInterface> const & finalProcessor)
 {
   m_translators->Append(translator);
-  m_finalProcessors.emplace(finalProcessor);
+  m_finalProcessors.emplace_back(finalProcessor);
 }
 
 bool RawGenerator::Execute()
 {
-  if (!GenerateFilteredFeatures())
-    return false;
+  {
+    ScopedStage stage("features generation");
+    if (!GenerateFilteredFeatures())
+      return false;
+  }
 
-  while (!m_finalProcessors.empty())
   {
-    base::thread_pool::computational::ThreadPool threadPool(m_genInfo.m_threadsCount);
-    while (true)
-    {
-      auto const finalProcessor = m_finalProcessors.top();
-      m_finalProcessors.pop();
-      threadPool.SubmitWork([finalProcessor{finalProcessor}]() {
-        finalProcessor->Process();
-      });
-      if (m_finalProcessors.empty() || *finalProcessor != *m_finalProcessors.top())
-        break;
-    }
+    ScopedStage stage("final processing");
+    RunFinalProcessors();
   }
 
   LOG(LINFO, ("Final processing is finished."));
   return true;
 }
 
+void RawGenerator::RunFinalProcessors()
+{
+  auto const count = m_finalProcessors.size();
+  // The processors which wait for the i-th one and the numbers of the unfinished processors
+  // the i-th one waits for.
+  vector<vector<size_t>> dependents(count);
+  vector<size_t> waitingCounts(count, 0);
+  for (size_t i = 0; i < count; ++i)
+  {
+    m_finalProcessors[i]->SetThreadsCount(m_genInfo.m_threadsCount);
+    for (size_t j = 0; j < count; ++j)
+    {
+      if (i != j && m_finalProcessors[i]->DependsOn(*m_finalProcessors[j]))
+      {
+        dependents[j].emplace_back(i);
+        ++waitingCounts[i];
+      }
+    }
+  }
+  CHECK(!HasDependencyCycle(dependents, waitingCounts), ("Final processors wait for each other."));
+
+  mutex finishedMutex;
+  condition_variable finishedCv;
+  size_t finishedCount = 0;
+  base::thread_pool::computational::ThreadPool threadPool(m_genInfo.m_threadsCount,
+                                                          m_genInfo.m_threadsAffinity);
+  // A processor is submitted as soon as all the processors it waits for are finished.
+  function<void(size_t)> submit;
+  submit = [&](size_t i) {
+    threadPool.SubmitWork([&, i]() {
+      auto const & finalProcessor = m_finalProcessors[i];
+      {
+        ScopedStage stage("final processor, priority " +
+                          to_string(static_cast<int>(finalProcessor->GetPriority())));
+        finalProcessor->Process();
+      }
+
+      lock_guard<mutex> lock(finishedMutex);
+      for (auto const dependent : dependents[i])
+      {
+        if (--waitingCounts[dependent] == 0)
+          submit(dependent);
+      }
+      ++finishedCount;
+      finishedCv.notify_one();
+    });
+  };
+
+  unique_lock<mutex> lock(finishedMutex);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (waitingCounts[i] == 0)
+      submit(i);
+  }
+  finishedCv.wait(lock, [&] { return finishedCount == count; });
+}
+
+// static
+bool RawGenerator::HasDependencyCycle(vector<vector<size_t>> const & dependents,
+                                      vector<size_t> waitingCounts)
+{
+  vector<size_t> ready;
+  for (size_t i = 0; i < waitingCounts.size(); ++i)
+  {
+    if (waitingCounts[i] == 0)
+      ready.emplace_back(i);
+  }
+
+  size_t finishedCount = 0;
+  while (!ready.empty())
+  {
+    auto const i = ready.back();
+    ready.pop_back();
+    ++finishedCount;
+    for (auto const dependent : dependents[i])
+    {
+      if (--waitingCounts[dependent] == 0)
+        ready.emplace_back(dependent);
+    }
+  }
+  return finishedCount != waitingCounts.size();
+}
+
 std::vector<std::string> const & RawGenerator::GetNames() const
 {
   return m_names;
@@ -97,10 +217,20 @@ std::vector<std::string> const & RawGenerator::GetNames() const
 
 bool RawGenerator::GenerateFilteredFeatures()
 {
-  RawGeneratorWriter rawGeneratorWriter(m_queue);
+  auto writersCount = m_genInfo.m_writeThreadsCount;
+  if (writersCount == 0)
+    writersCount = std::max(m_genInfo.m_threadsCount / kThreadsPerWriteThread, 1u);
+  LOG_SHORT(LINFO, ("Write threads:", writersCount));
+
+  RawGeneratorWriter rawGeneratorWriter(m_queue,
+                                        m_genInfo.m_compressFeatures
+                                            ? feature::FeaturesCompression::Zlib
+                                            : feature::FeaturesCompression::None,
+                                        writersCount);
+  base::Timer timer;
   rawGeneratorWriter.Run();
 
-  auto processorThreadsCount = std::max(m_genInfo.m_threadsCount, 2u) - 1 /* writer */;
+  auto processorThreadsCount = std::max(m_genInfo.m_threadsCount, writersCount + 1) - writersCount;
   if (m_genInfo.m_osmFileName.empty())  // stdin
     processorThreadsCount = 1;
 
@@ -108,6 +238,7 @@ bool RawGenerator::GenerateFilteredFeatures()
     return false;
 
   rawGeneratorWriter.ShutdownAndJoin();
+  rawGeneratorWriter.LogStats(timer.ElapsedSeconds());
   m_names = rawGeneratorWriter.GetNames();
   LOG(LINFO, ("Names:", m_names));
   return true;
@@ -116,21 +247,126 @@ bool RawGenerator::GenerateFilteredFeatures()
 bool RawGenerator::GenerateFeatures(
     unsigned int threadsCount, RawGeneratorWriter & /* rawGeneratorWriter */)
 {
-  auto translators = std::vector<std::shared_ptr<TranslatorInterface>>{};
-  auto sourceMap = boost::optional<boost::iostreams::mapped_file_source>{};
+  auto sourceMap = SourceMap{};
   if (!m_genInfo.m_osmFileName.empty())
   {
     sourceMap = MakeFileMap(m_genInfo.m_osmFileName);
     LOG_SHORT(LINFO, ("Reading OSM data from", m_genInfo.m_osmFileName));
   }
 
+  auto const threadsCounts = GetStagesThreadsCounts(threadsCount);
+  auto const decodeThreadsCount = threadsCounts.first;
+  auto const translateThreadsCount = threadsCounts.second;
+  LOG_SHORT(LINFO, ("Decode threads:", decodeThreadsCount, "translate threads:",
+                    translateThreadsCount));
+
+  auto const queueSize = kBatchesPerTranslateThread * translateThreadsCount;
+  OsmElementsQueue queue(queueSize);
+  PipelineStageStats decodeStats("decode");
+  PipelineStageStats translateStats("translate");
+
+  BatchesGovernor::Params governorParams;
+  governorParams.m_memoryBudget = m_genInfo.m_batchesMemoryBudget != 0
+                                      ? m_genInfo.m_batchesMemoryBudget
+                                      : GetDefaultBatchesMemoryBudget();
+  // The queued batches, the translated ones and the ones which are decoded.
+  governorParams.m_slotsCount = queueSize + translateThreadsCount + decodeThreadsCount;
+  governorParams.m_initialBatchSize = m_chunkSize;
+  BatchesGovernor governor(governorParams);
+  base::Timer timer;
+
+  // Every translator is cloned by its bound thread, so the first touch of its buffers
+  // places them on the node of the thread. The clones are made one by one.
+  m_boundThreadsCount = 0;
+  auto translators = std::vector<std::shared_ptr<TranslatorInterface>>(translateThreadsCount);
+  std::mutex cloneMutex;
   std::vector<std::thread> threads;
-  for (unsigned int i = 0; i < threadsCount; ++i)
+  for (unsigned int i = 0; i < translateThreadsCount; ++i)
+  {
+    threads.emplace_back([this, &translator = translators[i], &cloneMutex, &queue,
+                          &translateStats, &governor] {
+      BindCurrentThread();
+      {
+        std::lock_guard<std::mutex> lock(cloneMutex);
+        translator = m_translators->Clone();
+      }
+      Translate(queue, *translator, translateStats, governor);
+    });
+  }
+
+  Decode(sourceMap, decodeThreadsCount, queue, decodeStats, governor);
+  auto const decodeSeconds = timer.ElapsedSeconds();
+
+  // Every translator stops at its own empty batch.
+  for (unsigned int i = 0; i < translateThreadsCount; ++i)
+    queue.Push({});
+  for (auto & thread : threads)
+    thread.join();
+  LOG(LINFO, ("Input was processed."));
+
+  decodeStats.Log(decodeThreadsCount, decodeSeconds);
+  translateStats.Log(translateThreadsCount, timer.ElapsedSeconds());
+  governor.Log();
+  return FinishTranslation(translators);
+}
+
+std::pair<unsigned int, unsigned int> RawGenerator::GetStagesThreadsCounts(
+    unsigned int threadsCount) const
+{
+  // A single stream is decoded by one thread.
+  auto const isSequential = m_genInfo.m_osmFileName.empty();
+
+  auto decodeThreadsCount = m_genInfo.m_decodeThreadsCount;
+  if (isSequential)
+    decodeThreadsCount = 1;
+  else if (decodeThreadsCount == 0)
+    decodeThreadsCount = std::max(threadsCount / kThreadsPerDecodeThread, 1u);
+
+  auto translateThreadsCount = m_genInfo.m_translateThreadsCount;
+  if (translateThreadsCount == 0)
+    translateThreadsCount = threadsCount > decodeThreadsCount ? threadsCount - decodeThreadsCount : 1;
+
+  return {decodeThreadsCount, translateThreadsCount};
+}
+
+void RawGenerator::Decode(SourceMap const & sourceMap, unsigned int threadsCount,
+                          OsmElementsQueue & queue, PipelineStageStats & stats,
+                          BatchesGovernor & governor) const
+{
+  if (sourceMap && m_genInfo.m_osmFileType == feature::GenerateInfo::OsmSourceType::O5M)
+  {
+    auto const ranges = GetO5MRanges(*sourceMap, threadsCount);
+    if (!ranges.empty())
+    {
+      LOG_SHORT(LINFO, ("Decoding", ranges.size(), "o5m ranges in", threadsCount, "threads"));
+      DecodeO5MRanges(*sourceMap, ranges, threadsCount, queue, stats, governor);
+      return;
+    }
+  }
+
+  if (sourceMap && m_genInfo.m_osmFileType == feature::GenerateInfo::OsmSourceType::PBF)
+  {
+    DecodePbf(*sourceMap, threadsCount, queue, stats, governor);
+    return;
+  }
+
+  if (sourceMap && m_genInfo.m_osmFileType == feature::GenerateInfo::OsmSourceType::XML)
   {
-    auto translator = m_translators->Clone();
-    translators.push_back(translator);
+    DecodeXml(*sourceMap, threadsCount, queue, stats, governor);
+    return;
+  }
+
+  DecodeSequential(sourceMap, threadsCount, queue, stats, governor);
+}
 
-    constexpr size_t chunkSize = 10'000;
+void RawGenerator::DecodeSequential(SourceMap const & sourceMap, unsigned int threadsCount,
+                                    OsmElementsQueue & queue, PipelineStageStats & stats,
+                                    BatchesGovernor & governor) const
+{
+  constexpr size_t chunkSize = 10'000;
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
     auto processorMaker =
         [osmFileType = m_genInfo.m_osmFileType, threadsCount, i, chunkSize] (auto & reader)
             -> std::unique_ptr<ProcessorOsmElementsInterface>
@@ -139,18 +375,21 @@ bool RawGenerator::GenerateFeatures(
       {
       case feature::GenerateInfo::OsmSourceType::O5M:
         return std::make_unique<ProcessorOsmElementsFromO5M>(reader, threadsCount, i, chunkSize);
+      case feature::GenerateInfo::OsmSourceType::PBF:
+        return std::make_unique<ProcessorOsmElementsFromPbf>(reader);
       case feature::GenerateInfo::OsmSourceType::XML:
         return std::make_unique<ProcessorOsmElementsFromXml>(reader);
       }
       UNREACHABLE();
     };
 
-    threads.emplace_back([translator, processorMaker, &sourceMap] {
+    threads.emplace_back([this, processorMaker, &sourceMap, &queue, &stats, &governor] {
+      BindCurrentThread();
       if (!sourceMap)
       {
         auto reader = SourceReader{};
         auto processor = processorMaker(reader);
-        TranslateToFeatures(*processor, *translator);
+        PushBatches(*processor, queue, stats, governor);
         return;
       }
 
@@ -159,23 +398,185 @@ bool RawGenerator::GenerateFeatures(
       auto && stream = io::stream<io::array_source>{sourceArray, std::ios::binary};
       auto && reader = SourceReader(stream);
       auto processor = processorMaker(reader);
-      TranslateToFeatures(*processor, *translator);
+      PushBatches(*processor, queue, stats, governor);
     });
   }
   for (auto & thread : threads)
     thread.join();
-  LOG(LINFO, ("Input was processed."));
+}
 
-  return FinishTranslation(translators);
+std::vector<O5MRange> RawGenerator::GetO5MRanges(
+    boost::iostreams::mapped_file_source const & sourceMap, unsigned int threadsCount) const
+{
+  if (threadsCount <= 1)
+    return {};
+
+  // The block index is saved by the preprocessing, the file is scanned when there is no index.
+  std::vector<uint64_t> resetOffsets;
+  if (!LoadO5MResetOffsets(m_genInfo.GetIntermediateFileName(O5M_RESETS_FILE), sourceMap.size(),
+                           resetOffsets))
+  {
+    resetOffsets = FindO5MResetOffsets(sourceMap.data(), sourceMap.size());
+  }
+  return MakeO5MRangesForThreads(resetOffsets, sourceMap.size(), threadsCount);
+}
+
+void RawGenerator::DecodeO5MRanges(boost::iostreams::mapped_file_source const & sourceMap,
+                                   std::vector<O5MRange> const & ranges,
+                                   unsigned int threadsCount, OsmElementsQueue & queue,
+                                   PipelineStageStats & stats, BatchesGovernor & governor) const
+{
+  constexpr size_t chunkSize = 10'000;
+  std::atomic<size_t> nextRange{0};
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([this, &sourceMap, &ranges, &nextRange, &queue, &stats, &governor,
+                          chunkSize] {
+      BindCurrentThread();
+      namespace io = boost::iostreams;
+      for (auto r = nextRange++; r < ranges.size(); r = nextRange++)
+      {
+        auto const & range = ranges[r];
+        auto && sourceArray = io::array_source{sourceMap.data() + range.m_begin,
+                                               static_cast<size_t>(range.m_end - range.m_begin)};
+        auto && stream = io::stream<io::array_source>{sourceArray, std::ios::binary};
+        auto && reader = SourceReader(stream);
+        auto && processor = ProcessorOsmElementsFromO5M(reader, 1 /* taskCount */, 0 /* taskId */,
+                                                        chunkSize, range.m_begin == 0);
+        PushBatches(processor, queue, stats, governor);
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+}
+
+void RawGenerator::DecodePbf(boost::iostreams::mapped_file_source const & sourceMap,
+                             unsigned int threadsCount, OsmElementsQueue & queue,
+                             PipelineStageStats & stats, BatchesGovernor & governor) const
+{
+  auto const blobs = pbf::FindDataBlobs(sourceMap.data(), sourceMap.size());
+  LOG_SHORT(LINFO, ("Decoding", blobs.size(), "pbf blobs in", threadsCount, "threads"));
+
+  std::atomic<size_t> nextBlob{0};
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([this, &sourceMap, &blobs, &nextBlob, &queue, &stats, &governor] {
+      BindCurrentThread();
+      ProcessorOsmElementsFromPbf processor(sourceMap.data(), blobs, nextBlob);
+      // A blob is a batch.
+      std::vector<OsmElement> elements;
+      while (processor.ReadBlob(elements))
+        PushBatch(std::move(elements), queue, stats, governor);
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+}
+
+void RawGenerator::DecodeXml(boost::iostreams::mapped_file_source const & sourceMap,
+                             unsigned int threadsCount, OsmElementsQueue & queue,
+                             PipelineStageStats & stats, BatchesGovernor & governor) const
+{
+  auto const chunks = xml::FindChunks(sourceMap.data(), sourceMap.size(), kXmlChunkSize);
+  LOG_SHORT(LINFO, ("Decoding", chunks.size(), "xml chunks in", threadsCount, "threads"));
+
+  std::atomic<size_t> nextChunk{0};
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadsCount; ++i)
+  {
+    threads.emplace_back([this, &sourceMap, &chunks, &nextChunk, &queue, &stats, &governor] {
+      BindCurrentThread();
+      ProcessorOsmElementsFromXml processor(sourceMap.data(), chunks, nextChunk);
+      // A chunk is a batch.
+      std::vector<OsmElement> elements;
+      while (processor.ReadChunk(elements))
+      {
+        if (!elements.empty())
+          PushBatch(std::move(elements), queue, stats, governor);
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+}
+
+void RawGenerator::BindCurrentThread() const
+{
+  base::threads::SetCurrentThreadAffinity(m_genInfo.m_threadsAffinity, m_boundThreadsCount++);
 }
 
 // static
-void RawGenerator::TranslateToFeatures(ProcessorOsmElementsInterface & sourceProcessor,
-                                       TranslatorInterface & translator)
+void RawGenerator::PushBatches(ProcessorOsmElementsInterface & sourceProcessor,
+                               OsmElementsQueue & queue, PipelineStageStats & stats,
+                               BatchesGovernor & governor)
 {
-  OsmElement osmElement{};
-  while (sourceProcessor.TryRead(osmElement))
-    translator.Emit(osmElement);
+  auto batchSize = governor.GetBatchSize();
+  std::vector<OsmElement> elements;
+  elements.reserve(batchSize);
+  OsmElement element;
+  while (sourceProcessor.TryRead(element))
+  {
+    elements.push_back(std::move(element));
+    if (elements.size() < batchSize)
+      continue;
+
+    PushBatch(std::move(elements), queue, stats, governor);
+    batchSize = governor.GetBatchSize();
+    elements = {};
+    elements.reserve(batchSize);
+  }
+
+  if (!elements.empty())
+    PushBatch(std::move(elements), queue, stats, governor);
+}
+
+// static
+void RawGenerator::PushBatch(std::vector<OsmElement> && elements, OsmElementsQueue & queue,
+                             PipelineStageStats & stats, BatchesGovernor & governor)
+{
+  stats.AddItems(elements.size());
+  PROF_HISTOGRAM_ADD("raw generator: batch elements", elements.size());
+  auto batch = std::make_shared<OsmElements>();
+  for (auto const & element : elements)
+    batch->m_bytes += GetMemorySize(element);
+  batch->m_elements = std::move(elements);
+  base::Timer timer;
+  governor.Acquire(batch->m_bytes);
+  queue.Push(OsmElementsBatch(std::move(batch)));
+  stats.AddOutputWait(timer.ElapsedSeconds());
+}
+
+// static
+void RawGenerator::Translate(OsmElementsQueue & queue, TranslatorInterface & translator,
+                             PipelineStageStats & stats, BatchesGovernor & governor)
+{
+  while (true)
+  {
+    OsmElementsBatch batch;
+    base::Timer timer;
+    queue.WaitAndPop(batch);
+    stats.AddInputWait(timer.ElapsedSeconds());
+    if (batch.IsEmpty())
+      return;
+
+    auto const queueDepth = queue.Size();
+    stats.AddQueueDepth(queueDepth);
+
+    PROF_ZONE("raw generator: translate batch");
+    auto & elements = batch.Get()->m_elements;
+    timer.Reset();
+    for (auto & element : elements)
+      translator.Emit(element);
+    stats.AddItems(elements.size());
+
+    auto const bytes = batch.Get()->m_bytes;
+    governor.AddProcessedBatch(elements.size(), bytes, timer.ElapsedSeconds(), queueDepth);
+    batch = OsmElementsBatch();
+    governor.Release(bytes);
+  }
 }
 
 bool RawGenerator::FinishTranslation(
@@ -192,7 +593,8 @@ bool RawGenerator::FinishTranslation(
   }
   CHECK_GREATER_OR_EQUAL(queue.Size(), 1, ());
 
-  base::thread_pool::computational::ThreadPool pool(queue.Size() / 2 + 1);
+  base::thread_pool::computational::ThreadPool pool(queue.Size() / 2 + 1,
+                                                    m_genInfo.m_threadsAffinity);
   while (queue.Size() != 1)
   {
     std::future<TranslatorPtr> left;
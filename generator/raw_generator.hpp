@@ -1,15 +1,21 @@
 #pragma once
 
+#include "generator/batches_governor.hpp"
 #include "generator/features_processing_helpers.hpp"
 #include "generator/final_processor_intermediate_mwm.hpp"
 #include "generator/generate_info.hpp"
 #include "generator/intermediate_data.hpp"
+#include "generator/osm_element.hpp"
+#include "generator/pipeline_stage_stats.hpp"
 #include "generator/translator_collection.hpp"
 #include "generator/translator_interface.hpp"
 
+#include "base/thread_safe_queue.hpp"
+
+#include <atomic>
 #include <memory>
-#include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -19,7 +25,15 @@ namespace generator
 {
 class RawGeneratorWriter;
 class ProcessorOsmElementsInterface;
+struct O5MRange;
 
+// Features are generated by a pipeline of the stages: decoders read the source to batches of
+// elements, translators make, process and serialize the features of the elements and
+// RawGeneratorWriter writes them. The stages are linked by bounded queues, so a fast stage
+// waits for a slow one instead of queueing the whole source in memory. The batches of elements
+// are governed by BatchesGovernor: their size follows the translation time of the elements and
+// the decoders wait while the batches in flight use up the memory budget, see
+// feature::GenerateInfo::m_batchesMemoryBudget. |chunkSize| is the size of the first batches.
 class RawGenerator
 {
 public:
@@ -39,18 +53,64 @@ public:
 private:
   using FinalProcessorPtr = std::shared_ptr<FinalProcessorIntermediateMwmInterface>;
 
-  struct FinalProcessorPtrCmp
+  struct OsmElements
   {
-    bool operator()(FinalProcessorPtr const & l, FinalProcessorPtr const & r)
-    {
-      return *l < *r;
-    }
+    std::vector<OsmElement> m_elements;
+    // The estimated memory of the elements, see BatchesGovernor.
+    uint64_t m_bytes = 0;
   };
 
+  using OsmElementsBatch = base::threads::DataWrapper<std::shared_ptr<OsmElements>>;
+  using OsmElementsQueue = base::threads::ThreadSafeQueue<OsmElementsBatch>;
+  using SourceMap = boost::optional<boost::iostreams::mapped_file_source>;
+
   bool GenerateFilteredFeatures();
+  // Runs every final processor as soon as the processors it depends on are finished.
+  void RunFinalProcessors();
+  // |dependents| and |waitingCounts| are the dependencies of the final processors like in
+  // RunFinalProcessors().
+  static bool HasDependencyCycle(std::vector<std::vector<size_t>> const & dependents,
+                                 std::vector<size_t> waitingCounts);
   bool GenerateFeatures(unsigned int threadsCount, RawGeneratorWriter & rawGeneratorWriter);
-  static void TranslateToFeatures(ProcessorOsmElementsInterface & sourceProcessor,
-                                  TranslatorInterface & translator);
+  // Returns the workers counts of the decode and the translate stages.
+  std::pair<unsigned int, unsigned int> GetStagesThreadsCounts(unsigned int threadsCount) const;
+
+  // The decode stage, it returns when the whole source is pushed to |queue|.
+  void Decode(SourceMap const & sourceMap, unsigned int threadsCount, OsmElementsQueue & queue,
+              PipelineStageStats & stats, BatchesGovernor & governor) const;
+  // Threads decode their own ranges of an o5m file instead of skipping the chunks of others.
+  // Returns nothing when the file has not enough resets for |threadsCount| threads.
+  std::vector<O5MRange> GetO5MRanges(boost::iostreams::mapped_file_source const & sourceMap,
+                                     unsigned int threadsCount) const;
+  void DecodeO5MRanges(boost::iostreams::mapped_file_source const & sourceMap,
+                       std::vector<O5MRange> const & ranges, unsigned int threadsCount,
+                       OsmElementsQueue & queue, PipelineStageStats & stats,
+                       BatchesGovernor & governor) const;
+  // Threads take the next blob of a pbf file, the blobs are decoded independently.
+  void DecodePbf(boost::iostreams::mapped_file_source const & sourceMap,
+                 unsigned int threadsCount, OsmElementsQueue & queue,
+                 PipelineStageStats & stats, BatchesGovernor & governor) const;
+  // Threads parse the next chunk of an xml file, the chunks begin at the top-level elements.
+  void DecodeXml(boost::iostreams::mapped_file_source const & sourceMap,
+                 unsigned int threadsCount, OsmElementsQueue & queue,
+                 PipelineStageStats & stats, BatchesGovernor & governor) const;
+  void DecodeSequential(SourceMap const & sourceMap, unsigned int threadsCount,
+                        OsmElementsQueue & queue, PipelineStageStats & stats,
+                       BatchesGovernor & governor) const;
+  // Binds the calling worker of the features generation according to the threads affinity,
+  // every worker gets its own index.
+  void BindCurrentThread() const;
+  // Every batch is of the batch size of |governor| when the batch is started.
+  static void PushBatches(ProcessorOsmElementsInterface & sourceProcessor,
+                          OsmElementsQueue & queue, PipelineStageStats & stats,
+                          BatchesGovernor & governor);
+  // Waits until |governor| admits the memory of |elements|.
+  static void PushBatch(std::vector<OsmElement> && elements, OsmElementsQueue & queue,
+                        PipelineStageStats & stats, BatchesGovernor & governor);
+
+  // The translate stage, it returns when the empty batch is popped.
+  static void Translate(OsmElementsQueue & queue, TranslatorInterface & translator,
+                        PipelineStageStats & stats, BatchesGovernor & governor);
   bool FinishTranslation(std::vector<std::shared_ptr<TranslatorInterface>> & translators);
   boost::iostreams::mapped_file_source MakeFileMap(std::string const & filename);
 
@@ -59,7 +119,8 @@ private:
   std::shared_ptr<cache::IntermediateData const> m_cache;
   std::shared_ptr<FeatureProcessorQueue> m_queue;
   std::shared_ptr<TranslatorCollection> m_translators;
-  std::priority_queue<FinalProcessorPtr, std::vector<FinalProcessorPtr>, FinalProcessorPtrCmp> m_finalProcessors;
+  std::vector<FinalProcessorPtr> m_finalProcessors;
   std::vector<std::string> m_names;
+  mutable std::atomic<size_t> m_boundThreadsCount{0};
 };
 }  // namespace generator
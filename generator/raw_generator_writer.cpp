@@ -2,16 +2,35 @@
 
 #include "coding/varint.hpp"
 
+#include "base/exception.hpp"
 #include "base/file_name_utils.hpp"
+#include "base/logging.hpp"
+#include "base/string_utils.hpp"
+#include "base/timer.hpp"
 
+#include <functional>
 #include <iterator>
 
 namespace generator
 {
-RawGeneratorWriter::RawGeneratorWriter(std::shared_ptr<FeatureProcessorQueue> const & queue)
-  : m_queue(queue)
-{ }
+namespace
+{
+// The capacity of the queue of a writer thread.
+size_t const kChunksPerWriterQueue = 16;
+}  // namespace
 
+RawGeneratorWriter::RawGeneratorWriter(std::shared_ptr<FeatureProcessorQueue> const & queue,
+                                       feature::FeaturesCompression compression,
+                                       unsigned int writersCount)
+  : m_queue(queue), m_compression(compression)
+{
+  CHECK_GREATER(writersCount, 0, ());
+  for (unsigned int i = 0; i < writersCount; ++i)
+  {
+    m_writers.emplace_back(
+        std::make_unique<WriterThread>(kChunksPerWriterQueue, "write " + strings::to_string(i)));
+  }
+}
 
 RawGeneratorWriter::~RawGeneratorWriter()
 {
@@ -20,17 +39,39 @@ RawGeneratorWriter::~RawGeneratorWriter()
 
 void RawGeneratorWriter::Run()
 {
+  if (m_writers.size() > 1)
+  {
+    for (auto & writer : m_writers)
+      writer->m_thread = std::thread([this, &writer = *writer] { RunWriter(writer); });
+  }
+
   m_thread = std::thread([&]() {
+    std::vector<WriterTask> tasks(m_writers.size());
     while (true)
     {
       FeatureProcessorChunk chunk;
+      m_stats.AddQueueDepth(m_queue->Size());
+      base::Timer timer;
       m_queue->WaitAndPop(chunk);
+      m_stats.AddInputWait(timer.ElapsedSeconds());
       // As a sign of the end of tasks, we use an empty message. We have the right to do that,
       // because there is only one reader.
       if (chunk.IsEmpty())
-        return;
+        break;
 
-      Write(*chunk.Get());
+      if (m_writers.size() == 1)
+        Write(*chunk.Get());
+      else
+        Dispatch(chunk.Get(), tasks);
+      m_stats.AddItems(chunk.Get()->size());
+    }
+
+    if (m_writers.size() > 1)
+    {
+      for (auto & writer : m_writers)
+        writer->m_queue.Push(WriterTask{});
+      for (auto & writer : m_writers)
+        writer->m_thread.join();
     }
   });
 }
@@ -40,35 +81,110 @@ std::vector<std::string> RawGeneratorWriter::GetNames()
   CHECK(!m_thread.joinable(), ());
 
   std::vector<std::string> names;
-  names.reserve(m_writers.size());
-  for (const auto & p : m_writers)
-    names.emplace_back(p.first);
+  for (auto const & writer : m_writers)
+  {
+    for (auto const & p : writer->m_files)
+      names.emplace_back(p.first);
+  }
 
   return names;
 }
 
+void RawGeneratorWriter::LogStats(double seconds) const
+{
+  m_stats.Log(1 /* workersCount */, seconds);
+  if (m_writers.size() == 1)
+    return;
+
+  for (auto const & writer : m_writers)
+    writer->m_stats.Log(1 /* workersCount */, seconds);
+}
+
+void RawGeneratorWriter::Dispatch(std::shared_ptr<std::vector<ProcessedData>> const & chunk,
+                                  std::vector<WriterTask> & tasks)
+{
+  std::hash<std::string> const hash;
+  auto const & data = *chunk;
+  for (uint32_t i = 0; i < data.size(); ++i)
+  {
+    auto const & affiliations = *data[i].m_affiliations;
+    for (uint32_t j = 0; j < affiliations.size(); ++j)
+    {
+      if (!affiliations[j].empty())
+        tasks[hash(affiliations[j]) % tasks.size()].m_features.emplace_back(i, j);
+    }
+  }
+
+  for (size_t i = 0; i < tasks.size(); ++i)
+  {
+    if (tasks[i].m_features.empty())
+      continue;
+
+    auto & queue = m_writers[i]->m_queue;
+    tasks[i].m_chunk = chunk;
+    base::Timer timer;
+    queue.Push(std::move(tasks[i]));
+    m_stats.AddOutputWait(timer.ElapsedSeconds());
+    tasks[i] = WriterTask{};
+  }
+}
+
+void RawGeneratorWriter::RunWriter(WriterThread & writer)
+{
+  while (true)
+  {
+    WriterTask task;
+    writer.m_stats.AddQueueDepth(writer.m_queue.Size());
+    base::Timer timer;
+    writer.m_queue.WaitAndPop(task);
+    writer.m_stats.AddInputWait(timer.ElapsedSeconds());
+    if (!task.m_chunk)
+      return;
+
+    auto const & data = *task.m_chunk;
+    for (auto const & feature : task.m_features)
+    {
+      auto const & processed = data[feature.first];
+      Write(processed, (*processed.m_affiliations)[feature.second], writer);
+    }
+    writer.m_stats.AddItems(task.m_features.size());
+  }
+}
+
 void RawGeneratorWriter::Write(std::vector<ProcessedData> const & vecChunks)
 {
+  auto & writer = *m_writers.front();
   for (auto const & chunk : vecChunks)
   {
     for (auto const & affiliation : *chunk.m_affiliations)
     {
-      if (affiliation.empty())
-        continue;
+      if (!affiliation.empty())
+        Write(chunk, affiliation, writer);
+    }
+  }
+}
 
-      auto writerIt = m_writers.find(affiliation);
-      if (writerIt == std::cend(m_writers))
-      {
-        auto writer = std::make_unique<FileWriter>(std::move(affiliation));
-        writerIt = m_writers.emplace(affiliation, std::move(writer)).first;
-      }
+void RawGeneratorWriter::Write(ProcessedData const & data, std::string const & affiliation,
+                               WriterThread & writer) const
+{
+  auto writerIt = writer.m_files.find(affiliation);
+  if (writerIt == std::cend(writer.m_files))
+  {
+    auto file = std::make_unique<AffiliationWriter>(affiliation, m_compression);
+    writerIt = writer.m_files.emplace(affiliation, std::move(file)).first;
+  }
 
-      auto & writer = writerIt->second;
-      auto const & buffer = chunk.m_buffer;
-      WriteVarUint(*writer, static_cast<uint32_t>(buffer.size()));
-      writer->Write(buffer.data(), buffer.size());
-    }
+  auto const & buffer = data.m_buffer;
+  if (auto & compressedWriter = writerIt->second->m_compressedWriter)
+  {
+    compressedWriter->Write(buffer.data(), buffer.size());
+    return;
   }
+
+  auto & fileWriter = writerIt->second->m_writer;
+  writerIt->second->m_chunksIndex.AddFeature(fileWriter.Pos(), buffer.data(), buffer.size());
+  WriteVarUint(fileWriter, static_cast<uint32_t>(buffer.size()));
+  fileWriter.Write(buffer.data(), buffer.size());
 }
 
 void RawGeneratorWriter::ShutdownAndJoin()
@@ -77,6 +193,33 @@ void RawGeneratorWriter::ShutdownAndJoin()
   {
     m_queue->Push({});
     m_thread.join();
+    SaveChunksIndexes();
+  }
+}
+
+void RawGeneratorWriter::SaveChunksIndexes()
+{
+  for (auto const & writer : m_writers)
+  {
+    for (auto const & p : writer->m_files)
+    {
+      if (p.second->m_compressedWriter)
+      {
+        p.second->m_compressedWriter->Flush();
+        continue;
+      }
+
+      auto & fileWriter = p.second->m_writer;
+      fileWriter.Flush();
+      try
+      {
+        p.second->m_chunksIndex.Save(fileWriter.GetName(), fileWriter.Pos());
+      }
+      catch (RootException const & e)
+      {
+        LOG(LERROR, ("Failed to save the chunks index of", fileWriter.GetName(), e.Msg()));
+      }
+    }
   }
 }
 }  // namespace generator
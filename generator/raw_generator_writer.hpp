@@ -2,32 +2,100 @@
 
 #include "generator/feature_builder.hpp"
 #include "generator/features_processing_helpers.hpp"
+#include "generator/pipeline_stage_stats.hpp"
 
+#include "coding/buffered_file_writer.hpp"
+
+#include "base/bounded_mpmc_queue.hpp"
+
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace generator
 {
+// The files are partitioned between |writersCount| writer threads by the hashes of their names,
+// so every file is written by one thread in the order of the chunks in the queue. With several
+// writers a dispatching thread pops the chunks and hands out the features to the writers.
 class RawGeneratorWriter
 {
 public:
-  RawGeneratorWriter(std::shared_ptr<FeatureProcessorQueue> const & queue);
+  RawGeneratorWriter(std::shared_ptr<FeatureProcessorQueue> const & queue,
+                     feature::FeaturesCompression compression = feature::FeaturesCompression::None,
+                     unsigned int writersCount = 1);
   ~RawGeneratorWriter();
 
   void Run();
   void ShutdownAndJoin();
   std::vector<std::string> GetNames();
+  // The items of the stats are the written features.
+  PipelineStageStats const & GetStats() const { return m_stats; }
+  // Logs the stats of the dispatching and of every writer which worked for |seconds|.
+  void LogStats(double seconds) const;
 
 private:
   using FeatureBuilderWriter = feature::FeatureBuilderWriter<feature::serialization_policy::MaxAccuracy>;
 
+  struct AffiliationWriter
+  {
+    AffiliationWriter(std::string const & filename, feature::FeaturesCompression compression)
+      : m_writer(filename, FileWriter::OP_WRITE_TRUNCATE, kFileBufferSize)
+    {
+      if (compression != feature::FeaturesCompression::None)
+        m_compressedWriter = std::make_unique<feature::CompressedFeaturesWriter>(m_writer);
+    }
+
+    // Hundreds of files are written at once, so the buffers are moderate.
+    static size_t constexpr kFileBufferSize = 256 * 1024;
+
+    BufferedFileWriter m_writer;
+    // The chunks index is not saved for the compressed file.
+    std::unique_ptr<feature::CompressedFeaturesWriter> m_compressedWriter;
+    feature::FeaturesChunksIndex m_chunksIndex;
+  };
+
+  // The features of a chunk for a writer: the indices of the processed data and
+  // of the affiliation. The task without the chunk is the sign of the end.
+  struct WriterTask
+  {
+    std::shared_ptr<std::vector<ProcessedData>> m_chunk;
+    std::vector<std::pair<uint32_t, uint32_t>> m_features;
+  };
+
+  using WriterQueue = base::threads::BoundedMpmcQueue<WriterTask, base::threads::BlockingWait>;
+
+  struct WriterThread
+  {
+    WriterThread(size_t queueCapacity, std::string const & name)
+      : m_queue(queueCapacity), m_stats(name)
+    {
+    }
+
+    WriterQueue m_queue;
+    std::unordered_map<std::string, std::unique_ptr<AffiliationWriter>> m_files;
+    std::thread m_thread;
+    PipelineStageStats m_stats;
+  };
+
+  // Pushes the features of |chunk| to the writers of their files, |tasks| is a buffer.
+  void Dispatch(std::shared_ptr<std::vector<ProcessedData>> const & chunk,
+                std::vector<WriterTask> & tasks);
+  void RunWriter(WriterThread & writer);
+  // Writes a chunk when there is the only writer.
   void Write(std::vector<ProcessedData> const & vecChanks);
+  void Write(ProcessedData const & data, std::string const & affiliation,
+             WriterThread & writer) const;
+  // Flushes the compressed frames or saves the chunks indexes of the files.
+  void SaveChunksIndexes();
 
   std::thread m_thread;
   std::shared_ptr<FeatureProcessorQueue> m_queue;
-  std::unordered_map<std::string, std::unique_ptr<FileWriter>> m_writers;
+  feature::FeaturesCompression m_compression;
+  std::vector<std::unique_ptr<WriterThread>> m_writers;
+  PipelineStageStats m_stats{"write"};
 };
 }  // namespace generator
@@ -145,6 +145,8 @@ void CollectorRegionInfo::Merge(CollectorInterface const & collector)
 
 void CollectorRegionInfo::MergeInto(CollectorRegionInfo & collector) const
 {
+  collector.m_mapRegionData.reserve(collector.m_mapRegionData.size() + m_mapRegionData.size());
+  collector.m_mapIsoCode.reserve(collector.m_mapIsoCode.size() + m_mapIsoCode.size());
   collector.m_mapRegionData.insert(std::begin(m_mapRegionData), std::end(m_mapRegionData));
   collector.m_mapIsoCode.insert(std::begin(m_mapIsoCode), std::end(m_mapIsoCode));
 }
@@ -0,0 +1,171 @@
+#include "generator/regions/fixed_point_polygon.hpp"
+
+#include "geometry/mercator.hpp"
+
+#include "coding/point_coding.hpp"
+
+#include "base/assert.hpp"
+#include "base/bits.hpp"
+#include "base/checked_cast.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace generator
+{
+namespace regions
+{
+namespace
+{
+// The partial sums of the areas are moved to double before they overflow: the terms are less
+// than 2^61 as the coordinates are less than 2^30.
+int64_t constexpr kMaxAreaSum = int64_t{1} << 62;
+
+m2::PointU ToPointU(BoostPoint const & point)
+{
+  return PointDToPointU(point.get<0>(), point.get<1>(), kPointCoordBits);
+}
+
+BoostPoint ToBoostPoint(m2::PointU const & point)
+{
+  auto const p = PointUToPointD(point, kPointCoordBits);
+  return {p.x, p.y};
+}
+
+template <typename Ring>
+void AppendRing(Ring const & ring, std::vector<m2::PointU> & points)
+{
+  for (auto const & point : ring)
+    points.push_back(ToPointU(point));
+}
+}  // namespace
+
+FixedPointPolygon::FixedPointPolygon(BoostPolygon const & polygon)
+{
+  m_points.reserve(boost::geometry::num_points(polygon));
+  m_ringBegins.reserve(polygon.inners().size() + 2);
+  m_ringBegins.push_back(0);
+  AppendRing(polygon.outer(), m_points);
+  m_ringBegins.push_back(base::checked_cast<uint32_t>(m_points.size()));
+  for (auto const & inner : polygon.inners())
+  {
+    AppendRing(inner, m_points);
+    m_ringBegins.push_back(base::checked_cast<uint32_t>(m_points.size()));
+  }
+
+  m_min = m2::PointU(std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max());
+  m_max = m2::PointU(0, 0);
+  for (auto const & point : m_points)
+  {
+    m_min = m2::PointU(std::min(m_min.x, point.x), std::min(m_min.y, point.y));
+    m_max = m2::PointU(std::max(m_max.x, point.x), std::max(m_max.y, point.y));
+  }
+}
+
+bool FixedPointPolygon::Covers(BoostPoint const & point) const
+{
+  auto const p = ToPointU(point);
+  if (p.x < m_min.x || p.x > m_max.x || p.y < m_min.y || p.y > m_max.y)
+    return false;
+
+  auto const x = static_cast<int64_t>(p.x);
+  auto const y = static_cast<int64_t>(p.y);
+  bool onBoundary = false;
+  bool inside = false;
+  ForEachEdge([&](m2::PointU const & from, m2::PointU const & to) {
+    auto const fromX = static_cast<int64_t>(from.x);
+    auto const fromY = static_cast<int64_t>(from.y);
+    auto const toX = static_cast<int64_t>(to.x);
+    auto const toY = static_cast<int64_t>(to.y);
+    // The cross product of the edge and the vector from its start to the point.
+    auto const cross = (toX - fromX) * (y - fromY) - (toY - fromY) * (x - fromX);
+    if (cross == 0 && std::min(fromX, toX) <= x && x <= std::max(fromX, toX) &&
+        std::min(fromY, toY) <= y && y <= std::max(fromY, toY))
+    {
+      onBoundary = true;
+    }
+
+    // The edge crosses the ray from the point to the right.
+    if ((fromY > y) != (toY > y) && (toY > fromY ? cross > 0 : cross < 0))
+      inside = !inside;
+  });
+
+  return onBoundary || inside;
+}
+
+double FixedPointPolygon::GetArea() const
+{
+  CHECK_GREATER(m_ringBegins.size(), 1, ());
+
+  // The orientation of the rings is not relied on.
+  auto area = std::fabs(GetDoubledRingArea(0));
+  for (size_t ring = 1; ring + 1 < m_ringBegins.size(); ++ring)
+    area -= std::fabs(GetDoubledRingArea(ring));
+
+  auto const coordSize = static_cast<double>(bits::GetFullMask(kPointCoordBits));
+  auto const unitArea =
+      MercatorBounds::kRangeX / coordSize * (MercatorBounds::kRangeY / coordSize);
+  return std::max(area / 2 * unitArea, 0.0);
+}
+
+BoostPolygon FixedPointPolygon::ToBoostPolygon() const
+{
+  BoostPolygon polygon;
+  polygon.inners().resize(m_ringBegins.size() - 2);
+  for (size_t ring = 0; ring + 1 < m_ringBegins.size(); ++ring)
+  {
+    auto & boostRing = ring == 0 ? polygon.outer() : polygon.inners()[ring - 1];
+    boostRing.reserve(m_ringBegins[ring + 1] - m_ringBegins[ring]);
+    for (auto i = m_ringBegins[ring]; i < m_ringBegins[ring + 1]; ++i)
+      boostRing.push_back(ToBoostPoint(m_points[i]));
+  }
+  return polygon;
+}
+
+template <typename Fn>
+void FixedPointPolygon::ForEachEdge(Fn && fn) const
+{
+  for (size_t ring = 0; ring + 1 < m_ringBegins.size(); ++ring)
+  {
+    auto const begin = m_ringBegins[ring];
+    auto const end = m_ringBegins[ring + 1];
+    if (begin == end)
+      continue;
+
+    // The closing edge is degenerate when the ring is closed.
+    for (auto i = begin; i + 1 < end; ++i)
+      fn(m_points[i], m_points[i + 1]);
+    fn(m_points[end - 1], m_points[begin]);
+  }
+}
+
+double FixedPointPolygon::GetDoubledRingArea(size_t ring) const
+{
+  auto const begin = m_ringBegins[ring];
+  auto const end = m_ringBegins[ring + 1];
+  if (end - begin < 3)
+    return 0.0;
+
+  // The coordinates are relative to the first point to keep the terms small.
+  auto const originX = static_cast<int64_t>(m_points[begin].x);
+  auto const originY = static_cast<int64_t>(m_points[begin].y);
+  double area = 0.0;
+  int64_t sum = 0;
+  for (auto i = begin + 1; i + 1 < end; ++i)
+  {
+    auto const x1 = static_cast<int64_t>(m_points[i].x) - originX;
+    auto const y1 = static_cast<int64_t>(m_points[i].y) - originY;
+    auto const x2 = static_cast<int64_t>(m_points[i + 1].x) - originX;
+    auto const y2 = static_cast<int64_t>(m_points[i + 1].y) - originY;
+    sum += x1 * y2 - x2 * y1;
+    if (sum > kMaxAreaSum || sum < -kMaxAreaSum)
+    {
+      area += static_cast<double>(sum);
+      sum = 0;
+    }
+  }
+  return area + static_cast<double>(sum);
+}
+}  // namespace regions
+}  // namespace generator
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "generator/regions/region_base.hpp"
+
+#include "geometry/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace generator
+{
+namespace regions
+{
+// A polygon with the coordinates quantized to kPointCoordBits, the same as the points of the mwm,
+// see coding/point_coding.hpp. The vertices take half the memory of BoostPolygon. The
+// point-in-polygon tests and the area are computed in the integer arithmetic, so the results do
+// not depend on the rounding of the coordinates.
+class FixedPointPolygon
+{
+public:
+  explicit FixedPointPolygon(BoostPolygon const & polygon);
+
+  // The same as boost::geometry::covered_by(point, polygon) for the quantized |point|:
+  // the boundary is covered.
+  bool Covers(BoostPoint const & point) const;
+  // The area of the outer ring without the inner ones in the mercator units.
+  double GetArea() const;
+  BoostPolygon ToBoostPolygon() const;
+
+  size_t GetPointsCount() const { return m_points.size(); }
+
+private:
+  // Calls |fn(from, to)| for the edges of the rings.
+  template <typename Fn>
+  void ForEachEdge(Fn && fn) const;
+  // Returns the doubled area of the ring |ring| in the squared quantization units.
+  double GetDoubledRingArea(size_t ring) const;
+
+  // The points of the ring i are m_points[m_ringBegins[i], m_ringBegins[i + 1]), the first ring
+  // is the outer one.
+  std::vector<m2::PointU> m_points;
+  std::vector<uint32_t> m_ringBegins;
+  m2::PointU m_min;
+  m2::PointU m_max;
+};
+}  // namespace regions
+}  // namespace generator
@@ -2,15 +2,93 @@
 
 #include "geometry/mercator.hpp"
 
+#include "base/checked_cast.hpp"
+
 #include <algorithm>
 #include <array>
 #include <iomanip>
 #include <numeric>
+#include <string>
+#include <utility>
 
 namespace generator
 {
 namespace regions
 {
+namespace
+{
+// Chooses the ancestors of a node for its level path.
+class LevelPathFilter
+{
+public:
+  // Returns true when the ancestor of |level| is in the path, the ancestors are passed from the
+  // parent of the node.
+  bool Accept(PlaceLevel level)
+  {
+    if (PlaceLevel::Unknown == level)
+      return false;
+
+    auto levelIndex = static_cast<std::size_t>(level);
+    if (m_skipLevels.at(levelIndex))
+      return false;
+
+    m_skipLevels[levelIndex] = true;
+    if (PlaceLevel::Locality == level)
+    {
+      // To ignore covered locality.
+      m_skipLevels[static_cast<std::size_t>(PlaceLevel::Suburb)] = true;
+      m_skipLevels[static_cast<std::size_t>(PlaceLevel::Sublocality)] = true;
+    }
+    return true;
+  }
+
+private:
+  std::array<bool, static_cast<std::size_t>(PlaceLevel::Count)> m_skipLevels{};
+};
+
+void PrintData(LevelRegion const & d, std::ostream & stream)
+{
+  auto const point = d.GetCenter();
+  auto const center = MercatorBounds::ToLatLon({point.get<0>(), point.get<1>()});
+  auto const label = GetLabel(d.GetLevel());
+  stream << d.GetName() << "<"
+         << d.GetTranslatedOrTransliteratedName(StringUtf8Multilang::GetLangIndex("en")) << "> ("
+         << DebugPrint(d.GetId()) << ";" << (label ? label : "-") << ";"
+         << static_cast<size_t>(d.GetRank()) << ";[" << std::fixed << std::setprecision(7)
+         << center.m_lat << "," << center.m_lon << "])" << std::endl;
+}
+
+// Appends the prefix of a node to |stream| and returns the prefix of its children.
+std::string PrintPrefix(std::ostream & stream, std::string prefix, bool isTail)
+{
+  stream << prefix;
+  if (isTail)
+  {
+    stream << "└───";
+    prefix += "    ";
+  }
+  else
+  {
+    stream << "├───";
+    prefix += "│   ";
+  }
+  return prefix;
+}
+
+void PrintTree(FlatRegionsTree const & tree, uint32_t node, std::ostream & stream,
+               std::string const & prefix, bool isTail)
+{
+  auto const childrenPrefix = PrintPrefix(stream, prefix, isTail);
+  PrintData(tree.GetData(node), stream);
+  for (auto child = tree.GetFirstChild(node); child != FlatRegionsTree::kNoNode;)
+  {
+    auto const next = tree.GetNextSibling(child);
+    PrintTree(tree, child, stream, childrenPrefix, next == FlatRegionsTree::kNoNode);
+    child = next;
+  }
+}
+}  // namespace
+
 size_t TreeSize(Node::Ptr const & node)
 {
   if (node == nullptr)
@@ -39,27 +117,12 @@ NodePath MakeLevelPath(Node::Ptr const & node)
 {
   CHECK(node->GetData().GetLevel() != PlaceLevel::Unknown, ());
 
-  std::array<bool, static_cast<std::size_t>(PlaceLevel::Count)> skipLevels{};
+  LevelPathFilter filter;
   NodePath path{node};
   for (auto p = node->GetParent(); p; p = p->GetParent())
   {
-    auto const level = p->GetData().GetLevel();
-    if (PlaceLevel::Unknown == level)
-      continue;
-
-    auto levelIndex = static_cast<std::size_t>(level);
-    if (skipLevels.at(levelIndex))
-      continue;
-
-    skipLevels[levelIndex] = true;
-    if (PlaceLevel::Locality == level)
-    {
-      // To ignore covered locality.
-      skipLevels[static_cast<std::size_t>(PlaceLevel::Suburb)] = true;
-      skipLevels[static_cast<std::size_t>(PlaceLevel::Sublocality)] = true;
-    }
-
-    path.push_back(p);
+    if (filter.Accept(p->GetData().GetLevel()))
+      path.push_back(p);
   }
   std::reverse(path.begin(), path.end());
 
@@ -70,27 +133,8 @@ void PrintTree(Node::Ptr const & node, std::ostream & stream = std::cout, std::s
                bool isTail = true)
 {
   auto const & children = node->GetChildren();
-  stream << prefix;
-  if (isTail)
-  {
-    stream << "└───";
-    prefix += "    ";
-  }
-  else
-  {
-    stream << "├───";
-    prefix += "│   ";
-  }
-
-  auto const & d = node->GetData();
-  auto const point = d.GetCenter();
-  auto const center = MercatorBounds::ToLatLon({point.get<0>(), point.get<1>()});
-  auto const label = GetLabel(d.GetLevel());
-  stream << d.GetName() << "<"
-         << d.GetTranslatedOrTransliteratedName(StringUtf8Multilang::GetLangIndex("en")) << "> ("
-         << DebugPrint(d.GetId()) << ";" << (label ? label : "-") << ";"
-         << static_cast<size_t>(d.GetRank()) << ";[" << std::fixed << std::setprecision(7)
-         << center.m_lat << "," << center.m_lon << "])" << std::endl;
+  prefix = PrintPrefix(stream, prefix, isTail);
+  PrintData(node->GetData(), stream);
   for (size_t i = 0, size = children.size(); i < size; ++i)
     PrintTree(children[i], stream, prefix, i == size - 1);
 }
@@ -103,5 +147,90 @@ void DebugPrintTree(Node::Ptr const & tree, std::ostream & stream)
   PrintTree(tree, stream);
   stream << std::endl;
 }
+
+// static
+uint32_t constexpr FlatRegionsTree::kNoNode;
+
+FlatRegionsTree::FlatRegionsTree(Node::PtrList && trees)
+{
+  // The nodes to add with the indices of their parents, the nodes are added in the DFS order.
+  std::vector<std::pair<Node *, uint32_t>> stack;
+  for (auto it = trees.rbegin(); it != trees.rend(); ++it)
+    stack.emplace_back(it->get(), kNoNode);
+
+  uint32_t lastRoot = kNoNode;
+  std::vector<uint32_t> lastChildren;
+  while (!stack.empty())
+  {
+    auto const item = stack.back();
+    stack.pop_back();
+
+    auto & node = *item.first;
+    auto const parent = item.second;
+    auto const index = base::checked_cast<uint32_t>(m_regions.size());
+    m_levels.push_back(node.GetData().GetLevel());
+    m_regions.push_back(std::move(node.GetData()));
+    m_parents.push_back(parent);
+    m_firstChildren.push_back(kNoNode);
+    m_nextSiblings.push_back(kNoNode);
+    lastChildren.push_back(kNoNode);
+
+    auto & lastSibling = parent == kNoNode ? lastRoot : lastChildren[parent];
+    if (lastSibling != kNoNode)
+      m_nextSiblings[lastSibling] = index;
+    else if (parent != kNoNode)
+      m_firstChildren[parent] = index;
+    lastSibling = index;
+
+    auto const & children = node.GetChildren();
+    for (auto it = children.rbegin(); it != children.rend(); ++it)
+      stack.emplace_back(it->get(), index);
+  }
+}
+
+size_t FlatRegionsTree::GetMaxDepth() const
+{
+  // The parents precede the children.
+  std::vector<size_t> depths(m_regions.size());
+  size_t maxDepth = 0;
+  for (size_t node = 0; node < m_regions.size(); ++node)
+  {
+    depths[node] = m_parents[node] == kNoNode ? 1 : depths[m_parents[node]] + 1;
+    maxDepth = std::max(maxDepth, depths[node]);
+  }
+  return maxDepth;
+}
+
+void FlatRegionsTree::MakeLevelPath(uint32_t node, std::vector<uint32_t> const & ancestors,
+                                    Path & path) const
+{
+  CHECK(m_levels[node] != PlaceLevel::Unknown, ());
+
+  LevelPathFilter filter;
+  path.assign(1, node);
+  for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
+  {
+    if (filter.Accept(m_levels[*it]))
+      path.push_back(*it);
+  }
+  std::reverse(path.begin(), path.end());
+}
+
+void DebugPrintTree(FlatRegionsTree const & tree, std::ostream & stream)
+{
+  if (tree.IsEmpty())
+    return;
+
+  stream << "ROOT NAME: " << tree.GetData(0).GetName() << std::endl;
+  stream << "MAX DEPTH: " << tree.GetMaxDepth() << std::endl;
+  stream << "TREE SIZE: " << tree.GetSize() << std::endl;
+  for (uint32_t root = 0; root != FlatRegionsTree::kNoNode;)
+  {
+    auto const next = tree.GetNextSibling(root);
+    PrintTree(tree, root, stream, "" /* prefix */, next == FlatRegionsTree::kNoNode);
+    root = next;
+  }
+  stream << std::endl;
+}
 }  // namespace regions
 }  // namespace generator
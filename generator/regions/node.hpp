@@ -3,7 +3,11 @@
 #include "generator/place_node.hpp"
 #include "generator/regions/level_region.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <vector>
 
 namespace generator
 {
@@ -34,5 +38,65 @@ size_t TreeSize(Node::Ptr const & node);
 size_t MaxDepth(Node::Ptr const & node);
 
 void DebugPrintTree(Node::Ptr const & tree, std::ostream & stream = std::cout);
+
+// The region trees of a country in the parallel arrays of the nodes in the DFS order, the nodes
+// are linked by the indices of the parent, the first child and the next sibling. The roots are
+// the first node and its next siblings. The trees are built by Node and flattened when they are
+// done, the paths are enumerated by a sweep of the nodes with the stack of the ancestors.
+class FlatRegionsTree
+{
+public:
+  static uint32_t constexpr kNoNode = std::numeric_limits<uint32_t>::max();
+
+  // The nodes of a level path from the top, see MakeLevelPath().
+  using Path = std::vector<uint32_t>;
+
+  FlatRegionsTree() = default;
+  // The data of the nodes of |trees| is moved, the roots are in the order of |trees|.
+  explicit FlatRegionsTree(Node::PtrList && trees);
+
+  size_t GetSize() const { return m_regions.size(); }
+  bool IsEmpty() const { return m_regions.empty(); }
+
+  LevelRegion & GetData(uint32_t node) { return m_regions[node]; }
+  LevelRegion const & GetData(uint32_t node) const { return m_regions[node]; }
+  uint32_t GetParent(uint32_t node) const { return m_parents[node]; }
+  uint32_t GetFirstChild(uint32_t node) const { return m_firstChildren[node]; }
+  uint32_t GetNextSibling(uint32_t node) const { return m_nextSiblings[node]; }
+
+  size_t GetMaxDepth() const;
+
+  // Calls |fn(path)| for the nodes of the known levels in the DFS order, like ForEachLevelPath().
+  template <typename Fn>
+  void ForEachLevelPath(Fn && fn) const
+  {
+    std::vector<uint32_t> ancestors;
+    Path path;
+    for (uint32_t node = 0; node < m_regions.size(); ++node)
+    {
+      while (!ancestors.empty() && ancestors.back() != m_parents[node])
+        ancestors.pop_back();
+
+      if (m_levels[node] != PlaceLevel::Unknown)
+      {
+        MakeLevelPath(node, ancestors, path);
+        fn(static_cast<Path const &>(path));
+      }
+      ancestors.push_back(node);
+    }
+  }
+
+private:
+  // |ancestors| are the ancestors of |node| from the root.
+  void MakeLevelPath(uint32_t node, std::vector<uint32_t> const & ancestors, Path & path) const;
+
+  std::vector<LevelRegion> m_regions;
+  std::vector<PlaceLevel> m_levels;
+  std::vector<uint32_t> m_parents;
+  std::vector<uint32_t> m_firstChildren;
+  std::vector<uint32_t> m_nextSiblings;
+};
+
+void DebugPrintTree(FlatRegionsTree const & tree, std::ostream & stream = std::cout);
 }  // namespace regions
 }  // namespace generator
@@ -0,0 +1,299 @@
+#include "generator/regions/prepared_polygon.hpp"
+
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace generator
+{
+namespace regions
+{
+namespace
+{
+template <typename ToDo>
+void ForEachEdge(BoostPolygon const & polygon, ToDo && toDo)
+{
+  auto const forEachRingEdge = [&toDo](auto const & ring) {
+    if (ring.empty())
+      return;
+    for (size_t i = 1; i < ring.size(); ++i)
+      toDo(ring[i - 1], ring[i]);
+    if (!boost::geometry::equals(ring.back(), ring.front()))
+      toDo(ring.back(), ring.front());
+  };
+
+  forEachRingEdge(polygon.outer());
+  for (auto const & inner : polygon.inners())
+    forEachRingEdge(inner);
+}
+
+size_t GetIndex(double value, double min, double step, size_t count)
+{
+  auto const index = std::floor((value - min) / step);
+  if (!(index > 0))
+    return 0;
+  return std::min(static_cast<size_t>(index), count - 1);
+}
+
+double GetStep(double min, double max, size_t count)
+{
+  auto const step = (max - min) / count;
+  return step > 0 ? step : 1.0;
+}
+}  // namespace
+
+// static
+size_t constexpr PreparedPolygon::kGridSize;
+size_t constexpr PreparedPolygon::kEdgesPerBand;
+size_t constexpr PreparedPolygon::kMaxBandsCount;
+double constexpr PreparedPolygon::kCellMargin;
+
+PreparedPolygon::PreparedPolygon(BoostPolygon const & polygon)
+{
+  boost::geometry::envelope(polygon, m_rect);
+  auto const & minCorner = m_rect.min_corner();
+  auto const & maxCorner = m_rect.max_corner();
+
+  size_t edgesCount = 0;
+  ForEachEdge(polygon, [&edgesCount](BoostPoint const &, BoostPoint const &) { ++edgesCount; });
+
+  auto const bandsCount =
+      std::min(std::max(edgesCount / kEdgesPerBand, size_t{1}), kMaxBandsCount);
+  m_bandHeight = GetStep(minCorner.get<1>(), maxCorner.get<1>(), bandsCount);
+  m_bandOffsets.assign(bandsCount + 1, 0);
+
+  auto const getBands = [this](BoostPoint const & from, BoostPoint const & to) {
+    auto const minY = std::min(from.get<1>(), to.get<1>());
+    auto const maxY = std::max(from.get<1>(), to.get<1>());
+    return std::make_pair(GetBand(minY), GetBand(maxY));
+  };
+
+  // Count the edges of the bands and place them by the counts.
+  ForEachEdge(polygon, [&](BoostPoint const & from, BoostPoint const & to) {
+    auto const bands = getBands(from, to);
+    for (auto band = bands.first; band <= bands.second; ++band)
+      ++m_bandOffsets[band + 1];
+  });
+  for (size_t i = 1; i < m_bandOffsets.size(); ++i)
+    m_bandOffsets[i] += m_bandOffsets[i - 1];
+
+  m_bandEdges.resize(m_bandOffsets.back());
+  auto positions = m_bandOffsets;
+  ForEachEdge(polygon, [&](BoostPoint const & from, BoostPoint const & to) {
+    auto const bands = getBands(from, to);
+    for (auto band = bands.first; band <= bands.second; ++band)
+      m_bandEdges[positions[band]++] = {from, to};
+  });
+
+  // The cells the edges pass through are boundary ones, the other cells are entirely inside
+  // or outside the polygon.
+  m_cellWidth = GetStep(minCorner.get<0>(), maxCorner.get<0>(), kGridSize);
+  m_cellHeight = GetStep(minCorner.get<1>(), maxCorner.get<1>(), kGridSize);
+  m_cells.assign(kGridSize * kGridSize, Cell::Outside);
+  ForEachEdge(polygon, [this](BoostPoint const & from, BoostPoint const & to) {
+    auto const fromX = GetCellX(std::min(from.get<0>(), to.get<0>()));
+    auto const toX = GetCellX(std::max(from.get<0>(), to.get<0>()));
+    auto const fromY = GetCellY(std::min(from.get<1>(), to.get<1>()));
+    auto const toY = GetCellY(std::max(from.get<1>(), to.get<1>()));
+    for (auto y = fromY; y <= toY; ++y)
+    {
+      for (auto x = fromX; x <= toX; ++x)
+        m_cells[y * kGridSize + x] = Cell::Boundary;
+    }
+  });
+
+  for (size_t y = 0; y < kGridSize; ++y)
+  {
+    for (size_t x = 0; x < kGridSize; ++x)
+    {
+      auto & cell = m_cells[y * kGridSize + x];
+      if (cell == Cell::Boundary)
+        continue;
+
+      auto const center = GetCellCenter(x, y);
+      // The rounding may move the center to a neighbouring cell.
+      if (GetCellX(center.get<0>()) != x || GetCellY(center.get<1>()) != y)
+        cell = Cell::Boundary;
+      else
+        cell = CoversByEdges(center) ? Cell::Inside : Cell::Outside;
+    }
+  }
+}
+
+bool PreparedPolygon::Covers(BoostPoint const & point) const
+{
+  if (!boost::geometry::covered_by(point, m_rect))
+    return false;
+
+  switch (GetCell(GetCellX(point.get<0>()), GetCellY(point.get<1>())))
+  {
+  case Cell::Outside: return false;
+  case Cell::Inside: return true;
+  case Cell::Boundary: return CoversByEdges(point);
+  }
+  UNREACHABLE();
+}
+
+bool PreparedPolygon::CoversRectRough(BoostRect const & rect) const
+{
+  if (!boost::geometry::covered_by(rect, m_rect))
+    return false;
+
+  auto const fromX = GetCellX(rect.min_corner().get<0>());
+  auto const toX = GetCellX(rect.max_corner().get<0>());
+  auto const fromY = GetCellY(rect.min_corner().get<1>());
+  auto const toY = GetCellY(rect.max_corner().get<1>());
+  for (auto y = fromY; y <= toY; ++y)
+  {
+    for (auto x = fromX; x <= toX; ++x)
+    {
+      if (GetCell(x, y) != Cell::Inside)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool PreparedPolygon::CoversRough(PreparedPolygon const & other) const
+{
+  // The outer approximation of an empty polygon is empty, nothing is known about it.
+  bool empty = true;
+  bool covers = true;
+  other.ForEachOuterRun([&](BoostRect const & rect) {
+    empty = false;
+    if (covers && !CoversRectRough(rect))
+      covers = false;
+  });
+  return !empty && covers;
+}
+
+bool PreparedPolygon::MissesRough(PreparedPolygon const & other) const
+{
+  // The centers of the inside cells are inside |other|, see the constructor.
+  for (size_t y = 0; y < kGridSize; ++y)
+  {
+    for (size_t x = 0; x < kGridSize; ++x)
+    {
+      if (other.GetCell(x, y) != Cell::Inside)
+        continue;
+
+      auto const center = other.GetCellCenter(x, y);
+      if (!boost::geometry::covered_by(center, m_rect) ||
+          GetCell(GetCellX(center.get<0>()), GetCellY(center.get<1>())) == Cell::Outside)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool PreparedPolygon::DisjointRough(PreparedPolygon const & other) const
+{
+  bool disjoint = true;
+  other.ForEachOuterRun([&](BoostRect const & rect) {
+    if (!disjoint || !boost::geometry::intersects(rect, m_rect))
+      return;
+
+    auto const fromX = GetCellX(rect.min_corner().get<0>());
+    auto const toX = GetCellX(rect.max_corner().get<0>());
+    auto const fromY = GetCellY(rect.min_corner().get<1>());
+    auto const toY = GetCellY(rect.max_corner().get<1>());
+    for (auto y = fromY; y <= toY && disjoint; ++y)
+    {
+      for (auto x = fromX; x <= toX && disjoint; ++x)
+        disjoint = GetCell(x, y) == Cell::Outside;
+    }
+  });
+  return disjoint;
+}
+
+template <typename Fn>
+void PreparedPolygon::ForEachOuterRun(Fn && fn) const
+{
+  auto const & minCorner = m_rect.min_corner();
+  auto const & maxCorner = m_rect.max_corner();
+  auto const marginX = kCellMargin * m_cellWidth;
+  auto const marginY = kCellMargin * m_cellHeight;
+  for (size_t y = 0; y < kGridSize; ++y)
+  {
+    size_t x = 0;
+    while (x < kGridSize)
+    {
+      if (GetCell(x, y) == Cell::Outside)
+      {
+        ++x;
+        continue;
+      }
+
+      auto const from = x;
+      while (x < kGridSize && GetCell(x, y) != Cell::Outside)
+        ++x;
+
+      auto const minX = minCorner.get<0>() + from * m_cellWidth - marginX;
+      auto const minY = minCorner.get<1>() + y * m_cellHeight - marginY;
+      auto const maxX = minCorner.get<0>() + x * m_cellWidth + marginX;
+      auto const maxY = minCorner.get<1>() + (y + 1) * m_cellHeight + marginY;
+      fn(BoostRect{{std::max(minX, minCorner.get<0>()), std::max(minY, minCorner.get<1>())},
+                   {std::min(maxX, maxCorner.get<0>()), std::min(maxY, maxCorner.get<1>())}});
+    }
+  }
+}
+
+BoostPoint PreparedPolygon::GetCellCenter(size_t x, size_t y) const
+{
+  return {m_rect.min_corner().get<0>() + (x + 0.5) * m_cellWidth,
+          m_rect.min_corner().get<1>() + (y + 0.5) * m_cellHeight};
+}
+
+size_t PreparedPolygon::GetBand(double y) const
+{
+  return GetIndex(y, m_rect.min_corner().get<1>(), m_bandHeight, m_bandOffsets.size() - 1);
+}
+
+size_t PreparedPolygon::GetCellX(double x) const
+{
+  return GetIndex(x, m_rect.min_corner().get<0>(), m_cellWidth, kGridSize);
+}
+
+size_t PreparedPolygon::GetCellY(double y) const
+{
+  return GetIndex(y, m_rect.min_corner().get<1>(), m_cellHeight, kGridSize);
+}
+
+bool PreparedPolygon::CoversByEdges(BoostPoint const & point) const
+{
+  auto const x = point.get<0>();
+  auto const y = point.get<1>();
+  auto const band = GetBand(y);
+
+  // Even-odd rule over the edges of all the rings crossed by the ray to the right of the point.
+  bool inside = false;
+  for (auto i = m_bandOffsets[band]; i < m_bandOffsets[band + 1]; ++i)
+  {
+    auto const & edge = m_bandEdges[i];
+    auto const x1 = edge.m_from.get<0>();
+    auto const y1 = edge.m_from.get<1>();
+    auto const x2 = edge.m_to.get<0>();
+    auto const y2 = edge.m_to.get<1>();
+
+    auto const cross = (x2 - x1) * (y - y1) - (y2 - y1) * (x - x1);
+    if (cross == 0 && std::min(x1, x2) <= x && x <= std::max(x1, x2) &&
+        std::min(y1, y2) <= y && y <= std::max(y1, y2))
+    {
+      return true;
+    }
+
+    if ((y1 > y) != (y2 > y))
+    {
+      // The edge goes up and the point is to the left of it or the edge goes down
+      // and the point is to the right of it.
+      if ((cross > 0) == (y2 > y1))
+        inside = !inside;
+    }
+  }
+  return inside;
+}
+}  // namespace regions
+}  // namespace generator
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "generator/regions/region_base.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace generator
+{
+namespace regions
+{
+// A polygon prepared for the point-in-polygon tests. The edges are split to horizontal bands,
+// so the exact test checks only the edges of the band of a point. A grid over the polygon rect
+// marks the cells which are entirely inside or outside the polygon, the points and rects of
+// such cells are tested without the edges. The inside cells are the inner approximation of
+// the polygon and the cells which are not outside are the outer one, the polygon-in-polygon
+// tests compare the approximations first.
+class PreparedPolygon
+{
+public:
+  explicit PreparedPolygon(BoostPolygon const & polygon);
+
+  // The same as boost::geometry::covered_by(point, polygon): the boundary is covered.
+  bool Covers(BoostPoint const & point) const;
+  // The rough test by the grid: true when all the cells |rect| intersects are inside
+  // the polygon, false when it is not known.
+  bool CoversRectRough(BoostRect const & rect) const;
+  // True when the outer approximation of |other| is inside the inner approximation of
+  // the polygon, so |other| is covered. False when it is not known.
+  bool CoversRough(PreparedPolygon const & other) const;
+  // True when a point of the inner approximation of |other| is outside the outer approximation
+  // of the polygon, so |other| is not covered. False when it is not known.
+  bool MissesRough(PreparedPolygon const & other) const;
+  // True when the outer approximations do not intersect, so the polygons have no common
+  // area. False when it is not known.
+  bool DisjointRough(PreparedPolygon const & other) const;
+
+  BoostRect const & GetRect() const { return m_rect; }
+
+private:
+  static size_t constexpr kGridSize = 16;
+  static size_t constexpr kEdgesPerBand = 8;
+  static size_t constexpr kMaxBandsCount = 1 << 16;
+  // The rects of the cells compared with the other grid are extended by the part of the cell
+  // size, so the rounding of the cell bounds does not lose the points of the cells.
+  static double constexpr kCellMargin = 0.01;
+
+  enum class Cell : uint8_t
+  {
+    Outside,
+    Inside,
+    Boundary
+  };
+
+  struct Edge
+  {
+    BoostPoint m_from;
+    BoostPoint m_to;
+  };
+
+  size_t GetBand(double y) const;
+  size_t GetCellX(double x) const;
+  size_t GetCellY(double y) const;
+  Cell GetCell(size_t x, size_t y) const { return m_cells[y * kGridSize + x]; }
+  BoostPoint GetCellCenter(size_t x, size_t y) const;
+  // Calls |fn(rect)| for the rects of the runs of the adjacent cells of a row which are not
+  // outside the polygon. The rects are extended by kCellMargin and clipped by the polygon rect.
+  template <typename Fn>
+  void ForEachOuterRun(Fn && fn) const;
+  // The exact test of a point inside the rect.
+  bool CoversByEdges(BoostPoint const & point) const;
+
+  BoostRect m_rect;
+
+  double m_bandHeight = 1.0;
+  // The edges of band i are m_bandEdges[m_bandOffsets[i], m_bandOffsets[i + 1]).
+  std::vector<uint32_t> m_bandOffsets;
+  std::vector<Edge> m_bandEdges;
+
+  double m_cellWidth = 1.0;
+  double m_cellHeight = 1.0;
+  std::vector<Cell> m_cells;
+};
+}  // namespace regions
+}  // namespace generator
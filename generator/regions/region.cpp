@@ -25,9 +25,7 @@ Region::Region(FeatureBuilder const & fb, RegionDataProxy const & rd)
   , m_polygon(std::make_shared<BoostPolygon>())
 {
   FillPolygon(fb);
-  boost::geometry::envelope(*m_polygon, m_rect);
-  m_area = boost::geometry::area(*m_polygon);
-  CHECK_GREATER_OR_EQUAL(m_area, 0.0, ());
+  Prepare();
 }
 
 Region::Region(StringUtf8Multilang const & name, RegionDataProxy const & rd,
@@ -115,8 +113,24 @@ bool Region::IsLocality() const { return GetPlaceType() >= PlaceType::City; }
 void Region::SetPolygon(std::shared_ptr<BoostPolygon> const & polygon)
 {
   m_polygon = polygon;
-  m_rect = {};
-  boost::geometry::envelope(*m_polygon, m_rect);
+  m_fixedPointPolygon.reset();
+  Prepare();
+}
+
+void Region::SetFixedPointPolygon(std::shared_ptr<FixedPointPolygon const> const & polygon)
+{
+  CHECK(polygon, ());
+  m_fixedPointPolygon = polygon;
+  m_polygon.reset();
+  m_preparedPolygon.reset();
+  m_area = m_fixedPointPolygon->GetArea();
+}
+
+void Region::Prepare()
+{
+  CHECK(m_polygon, ());
+  m_preparedPolygon = std::make_shared<PreparedPolygon>(*m_polygon);
+  m_rect = m_preparedPolygon->GetRect();
   m_area = boost::geometry::area(*m_polygon);
   CHECK_GREATER_OR_EQUAL(m_area, 0.0, ());
 }
@@ -126,8 +140,26 @@ bool Region::Contains(Region const & smaller) const
   CHECK(m_polygon, ());
   CHECK(smaller.m_polygon, ());
 
-  return boost::geometry::covered_by(smaller.m_rect, m_rect) &&
-         boost::geometry::covered_by(*smaller.m_polygon, *m_polygon);
+  if (!boost::geometry::covered_by(smaller.m_rect, m_rect))
+    return false;
+
+  if (m_preparedPolygon->CoversRectRough(smaller.m_rect) ||
+      m_preparedPolygon->CoversRough(*smaller.m_preparedPolygon))
+  {
+    return true;
+  }
+
+  if (m_preparedPolygon->MissesRough(*smaller.m_preparedPolygon))
+    return false;
+
+  // All the vertices of a covered polygon are covered.
+  for (auto const & point : smaller.m_polygon->outer())
+  {
+    if (!m_preparedPolygon->Covers(point))
+      return false;
+  }
+
+  return boost::geometry::covered_by(*smaller.m_polygon, *m_polygon);
 }
 
 double Region::CalculateOverlapPercentage(Region const & other) const
@@ -138,10 +170,21 @@ double Region::CalculateOverlapPercentage(Region const & other) const
   if (!boost::geometry::intersects(other.m_rect, m_rect))
     return 0.0;
 
+  // One of the regions is entirely inside the other one.
+  if (m_preparedPolygon->CoversRectRough(other.m_rect) ||
+      other.m_preparedPolygon->CoversRectRough(m_rect) ||
+      m_preparedPolygon->CoversRough(*other.m_preparedPolygon) ||
+      other.m_preparedPolygon->CoversRough(*m_preparedPolygon))
+  {
+    return 100.0;
+  }
+
+  if (m_preparedPolygon->DisjointRough(*other.m_preparedPolygon))
+    return 0.0;
+
   std::vector<BoostPolygon> coll;
   boost::geometry::intersection(*other.m_polygon, *m_polygon, coll);
-  auto const min =
-      std::min(boost::geometry::area(*other.m_polygon), boost::geometry::area(*m_polygon));
+  auto const min = std::min(other.m_area, m_area);
   auto const binOp = [](double x, BoostPolygon const & y) { return x + boost::geometry::area(y); };
   auto const sum = std::accumulate(std::begin(coll), std::end(coll), 0., binOp);
   return (sum / min) * 100;
@@ -164,17 +207,17 @@ BoostPoint Region::GetCenter() const
 
 bool Region::Contains(PlacePoint const & place) const
 {
-  CHECK(m_polygon, ());
-
   return Contains(place.GetPosition());
 }
 
 bool Region::Contains(BoostPoint const & point) const
 {
+  if (m_fixedPointPolygon)
+    return m_fixedPointPolygon->Covers(point);
+
   CHECK(m_polygon, ());
 
-  return boost::geometry::covered_by(point, m_rect) &&
-         boost::geometry::covered_by(point, *m_polygon);
+  return m_preparedPolygon->Covers(point);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "generator/feature_builder.hpp"
+#include "generator/regions/fixed_point_polygon.hpp"
 #include "generator/regions/place_point.hpp"
+#include "generator/regions/prepared_polygon.hpp"
 #include "generator/regions/region_base.hpp"
 
 #include <memory>
@@ -49,15 +51,27 @@ public:
   BoostPoint GetCenter() const;
   bool IsLocality() const;
   BoostRect const & GetRect() const { return m_rect; }
+  // Null when the region keeps the fixed point polygon.
   std::shared_ptr<BoostPolygon> const & GetPolygon() const noexcept { return m_polygon; }
   void SetPolygon(std::shared_ptr<BoostPolygon> const & polygon);
+  std::shared_ptr<FixedPointPolygon const> const & GetFixedPointPolygon() const noexcept
+  {
+    return m_fixedPointPolygon;
+  }
+  // Replaces the polygon with |polygon|, the area is taken from it and the rect is kept. Only
+  // the points are tested against the region after that, see Contains(BoostPoint).
+  void SetFixedPointPolygon(std::shared_ptr<FixedPointPolygon const> const & polygon);
   double GetArea() const { return m_area; }
 
 private:
   void FillPolygon(feature::FeatureBuilder const & fb);
+  void Prepare();
 
   boost::optional<PlacePoint> m_placeLabel;
   std::shared_ptr<BoostPolygon> m_polygon;
+  // Shared by the copies of the region as the polygon is.
+  std::shared_ptr<PreparedPolygon const> m_preparedPolygon;
+  std::shared_ptr<FixedPointPolygon const> m_fixedPointPolygon;
   BoostRect m_rect;
   double m_area;
 };
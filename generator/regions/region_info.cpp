@@ -2,7 +2,7 @@
 
 #include "generator/regions/collector_region_info.hpp"
 
-#include "coding/file_reader.hpp"
+#include "coding/mmap_reader.hpp"
 
 #include "base/assert.hpp"
 
@@ -23,8 +23,9 @@ RegionInfo::RegionInfo(Platform::FilesList const & filenames)
 
 void RegionInfo::ParseFile(std::string const & filename)
 {
-  FileReader reader(filename);
-  ReaderSource<FileReader> src(reader);
+  // The records are trivially copyable, so they are copied right from the mapped file.
+  MmapReader reader(filename);
+  ReaderSource<MmapReader> src(reader);
   uint8_t version;
   ReadPrimitiveFromSource(src, version);
   CHECK_EQUAL(version, CollectorRegionInfo::kVersion, ());
@@ -46,6 +46,7 @@ private:
   {
     uint32_t size = 0;
     ReadPrimitiveFromSource(src, size);
+    seq.reserve(seq.size() + size);
     typename Map::mapped_type data;
     for (uint32_t i = 0; i < size; ++i)
     {
@@ -1,20 +1,46 @@
 #include "generator/regions/region_info_getter.hpp"
 
+#include "generator/shared_resources.hpp"
+
+#include "indexer/cell_id.hpp"
+
 #include "coding/mmap_reader.hpp"
 
 #include "base/logging.hpp"
 
+#include <algorithm>
+#include <utility>
+
 namespace generator
 {
 namespace regions
 {
+namespace
+{
+std::string PrepareStorage(std::string const & kvPath)
+{
+  RegionPropertiesStore::BuildIfNeeded(kvPath);
+  return RegionPropertiesStore::GetStorePath(kvPath);
+}
+}  // namespace
+
 RegionInfoGetter::RegionInfoGetter(std::string const & indexPath, std::string const & kvPath)
     : m_index{indexer::ReadIndex<indexer::RegionsIndexBox<IndexReader>, MmapReader>(indexPath)}
-    , m_storage(kvPath)
+    , m_storage(PrepareStorage(kvPath))
 {
   m_borders.Deserialize(indexPath);
 }
 
+// static
+std::shared_ptr<RegionInfoGetter const> RegionInfoGetter::GetShared(std::string const & indexPath,
+                                                                    std::string const & kvPath)
+{
+  return SharedResources::Get<RegionInfoGetter>({indexPath, kvPath}, [&]() {
+    LOG(LINFO, ("Loading regions of", indexPath, "and", kvPath));
+    return std::make_shared<RegionInfoGetter const>(indexPath, kvPath);
+  });
+}
+
 boost::optional<KeyValue> RegionInfoGetter::FindDeepest(m2::PointD const & point) const
 {
   return FindDeepest(point, [] (...) { return true; });
@@ -25,15 +51,69 @@ boost::optional<KeyValue> RegionInfoGetter::FindDeepest(
 {
   static_assert(std::is_base_of<ConcurrentGetProcessability, RegionInfoGetter>::value, "");
 
-  auto const ids = SearchObjectsInIndex(point);
+  auto const ids = SearchObjectsInIndex(Index::GetRectIntervals(m2::RectD(point, point)));
   return GetDeepest(point, ids, selector);
 }
 
-std::vector<base::GeoObjectId> RegionInfoGetter::SearchObjectsInIndex(m2::PointD const & point) const
+void RegionInfoGetter::FindDeepestBatch(std::vector<m2::PointD> const & points,
+                                        Selector const & selector,
+                                        std::vector<boost::optional<KeyValue>> & result) const
+{
+  using Converter = CellIdConverter<MercatorBounds, m2::CellId<kRegionsDepthLevels>>;
+
+  std::vector<std::pair<int64_t, size_t>> order;
+  order.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    auto const cell = Converter::ToCellId(points[i].x, points[i].y);
+    order.emplace_back(cell.ToInt64(kRegionsDepthLevels), i);
+  }
+  std::sort(order.begin(), order.end());
+
+  result.assign(points.size(), {});
+  covering::Intervals intervals;
+  std::vector<base::GeoObjectId> ids;
+  bool hasIds = false;
+  for (auto const & item : order)
+  {
+    auto const & point = points[item.second];
+    auto pointIntervals = Index::GetRectIntervals(m2::RectD(point, point));
+    if (!hasIds || pointIntervals != intervals)
+    {
+      intervals = std::move(pointIntervals);
+      ids = SearchObjectsInIndex(intervals);
+      hasIds = true;
+    }
+
+    result[item.second] = GetDeepest(point, ids, selector);
+  }
+}
+
+std::vector<base::GeoObjectId> RegionInfoGetter::FindCandidates(m2::RectD const & rect) const
+{
+  return SearchObjectsInIndex(Index::GetRectIntervals(rect));
+}
+
+boost::optional<double> RegionInfoGetter::FindFirstBorderCrossing(
+    std::vector<base::GeoObjectId> const & candidates, m2::PointD const & from,
+    m2::PointD const & to) const
+{
+  boost::optional<double> first;
+  for (auto const & id : candidates)
+  {
+    auto const crossing = m_borders.FindFirstCrossing(id.GetEncodedId(), from, to);
+    if (crossing && (!first || *crossing < *first))
+      first = crossing;
+  }
+  return first;
+}
+
+std::vector<base::GeoObjectId> RegionInfoGetter::SearchObjectsInIndex(
+    covering::Intervals const & intervals) const
 {
   std::vector<base::GeoObjectId> ids;
   auto const emplace = [&ids] (base::GeoObjectId const & osmId) { ids.emplace_back(osmId); };
-  m_index.ForEachAtPoint(emplace, point);
+  m_index.ForEachInIntervals(emplace, intervals);
   return ids;
 }
 
@@ -41,61 +121,45 @@ boost::optional<KeyValue> RegionInfoGetter::GetDeepest(m2::PointD const & point,
     std::vector<base::GeoObjectId> const & ids, Selector const & selector) const
 {
   // Minimize CPU consumption by minimizing the number of calls to heavy m_borders.IsPointInside().
-  std::multimap<int, KeyValue> regionsByRank;
+  std::vector<RegionPropertiesStore::Record const *> regions;
+  regions.reserve(ids.size());
   for (auto const & id : ids)
   {
-    auto const & region = m_storage.Find(id.GetEncodedId());
-    if (!region)
+    auto const record = m_storage.FindRecord(id.GetEncodedId());
+    if (!record)
     {
       LOG(LWARNING, ("Id not found in region key-value storage:", id));
       continue;
     }
 
-    auto rank = GetRank(*region);
-    regionsByRank.emplace(rank, KeyValue{id.GetEncodedId(), std::move(region)});
+    regions.push_back(record);
   }
+  // The deepest regions are checked first, the regions of the same rank are checked
+  // in the reverse order of the index.
+  std::stable_sort(regions.begin(), regions.end(), [](auto const & l, auto const & r) {
+    return l->m_rank < r->m_rank;
+  });
 
   boost::optional<uint64_t> borderCheckSkipRegionId;
-  for (auto i = regionsByRank.rbegin(); i != regionsByRank.rend(); ++i)
+  for (auto i = regions.rbegin(); i != regions.rend(); ++i)
   {
-    auto & kv = i->second;
-    auto regionId = kv.first;
-    if (regionId != borderCheckSkipRegionId && !m_borders.IsPointInside(regionId, point))
+    auto const & region = **i;
+    if (region.m_id != borderCheckSkipRegionId && !m_borders.IsPointInside(region.m_id, point))
       continue;
 
+    auto kv = KeyValue{region.m_id, m_storage.GetJson(region)};
     if (selector(kv))
-      return std::move(kv);
+      return kv;
 
     // Skip border check for parent region.
-    if (auto dref = GetDref(*kv.second))
+    if (auto const dref = region.GetDref())
       borderCheckSkipRegionId = dref;
   }
 
   return {};
 }
 
-int RegionInfoGetter::GetRank(JsonValue const & json) const
-{
-  auto && properties = base::GetJSONObligatoryField(json, "properties");
-  return FromJSONObject<int>(properties, "rank");
-}
-
-boost::optional<uint64_t> RegionInfoGetter::GetDref(JsonValue const & json) const
-{
-  auto && properties = base::GetJSONObligatoryField(json, "properties");
-  auto && drefField = base::GetJSONOptionalField(properties, "dref");
-  if (!drefField || base::JSONIsNull(drefField))
-    return {};
-
-  std::string drefStr = FromJSON<std::string>(drefField);
-  uint64_t dref = 0;
-
-  CHECK(strings::to_uint64(drefStr, dref, 16), ());
-
-  return dref;
-}
-
-KeyValueStorage const & RegionInfoGetter::GetStorage() const noexcept
+RegionPropertiesStore const & RegionInfoGetter::GetStorage() const noexcept
 {
   return m_storage;
 }
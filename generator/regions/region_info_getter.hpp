@@ -1,6 +1,7 @@
 #pragma once
 
 #include "generator/key_value_storage.hpp"
+#include "generator/regions/region_properties_store.hpp"
 
 #include "indexer/borders.hpp"
 #include "indexer/covering_index.hpp"
@@ -8,9 +9,11 @@
 #include "coding/reader.hpp"
 
 #include "geometry/point2d.hpp"
+#include "geometry/rect2d.hpp"
 
 #include "base/geo_object_id.hpp"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -33,23 +36,37 @@ public:
 
   RegionInfoGetter(std::string const & indexPath, std::string const & kvPath);
 
+  // Returns the getter loaded by the stages of the process, see SharedResources.
+  static std::shared_ptr<RegionInfoGetter const> GetShared(std::string const & indexPath,
+                                                           std::string const & kvPath);
+
   boost::optional<KeyValue> FindDeepest(m2::PointD const & point) const;
   boost::optional<KeyValue> FindDeepest(m2::PointD const & point, Selector const & selector) const;
-  KeyValueStorage const & GetStorage() const noexcept;
+  // The same as FindDeepest() for each of |points|. The points are processed in the order of
+  // their index cells and the index lookups are shared by the points of the same cell.
+  void FindDeepestBatch(std::vector<m2::PointD> const & points, Selector const & selector,
+                        std::vector<boost::optional<KeyValue>> & result) const;
+  // The ids of the regions which may cover a point of |rect|.
+  std::vector<base::GeoObjectId> FindCandidates(m2::RectD const & rect) const;
+  // Finds the first crossing of the segment [|from|, |to|] with a border of |candidates|, see
+  // indexer::Borders::FindFirstCrossing(). The deepest region of the segment points does not
+  // change between the crossings of the borders of the candidates of the segment rect.
+  boost::optional<double> FindFirstBorderCrossing(std::vector<base::GeoObjectId> const & candidates,
+                                                  m2::PointD const & from,
+                                                  m2::PointD const & to) const;
+  RegionPropertiesStore const & GetStorage() const noexcept;
 
 private:
   using IndexReader = ReaderPtr<Reader>;
+  using Index = indexer::RegionsIndex<IndexReader>;
 
-  std::vector<base::GeoObjectId> SearchObjectsInIndex(m2::PointD const & point) const;
+  std::vector<base::GeoObjectId> SearchObjectsInIndex(covering::Intervals const & intervals) const;
   boost::optional<KeyValue> GetDeepest(m2::PointD const & point, std::vector<base::GeoObjectId> const & ids,
                                        Selector const & selector) const;
-  int GetRank(JsonValue const & json) const;
-  // Get parent id of object: optional field `properties.dref` in JSON.
-  boost::optional<uint64_t> GetDref(JsonValue const & json) const;
 
-  indexer::RegionsIndex<IndexReader> m_index;
+  Index m_index;
   indexer::Borders m_borders;
-  KeyValueStorage m_storage;
+  RegionPropertiesStore m_storage;
 };
 }  // namespace regions
 }  // namespace generator
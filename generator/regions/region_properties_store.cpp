@@ -0,0 +1,335 @@
+#include "generator/regions/region_properties_store.hpp"
+
+#include "platform/platform.hpp"
+
+#include "coding/file_writer.hpp"
+#include "coding/internal/file_data.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <type_traits>
+
+#include <boost/filesystem.hpp>
+
+namespace generator
+{
+namespace regions
+{
+namespace
+{
+uint32_t constexpr kVersion = 0;
+uint64_t constexpr kAlignment = 8;
+
+PlaceLevel const kAddressLevels[] = {PlaceLevel::Country,  PlaceLevel::Region,
+                                     PlaceLevel::Subregion, PlaceLevel::Locality,
+                                     PlaceLevel::Suburb,   PlaceLevel::Sublocality};
+}  // namespace
+
+// The layout of the store: header, JSON texts, records, names, zero-terminated strings.
+struct RegionPropertiesStore::Header
+{
+  uint32_t m_version;
+  uint32_t m_recordsCount;
+  uint64_t m_jsonsOffset;
+  uint64_t m_recordsOffset;
+  uint64_t m_namesOffset;
+  uint64_t m_namesCount;
+  uint64_t m_stringsOffset;
+  uint64_t m_stringsSize;
+};
+
+struct RegionPropertiesStore::Name
+{
+  // Offsets in the strings.
+  uint32_t m_language;
+  uint32_t m_name;
+};
+
+static_assert(sizeof(RegionPropertiesStore::Record) == 72, "");
+static_assert(std::is_trivially_copyable<RegionPropertiesStore::Record>::value, "");
+
+// static
+char const RegionPropertiesStore::kExtension[] = ".props";
+
+namespace
+{
+class StringsBuilder
+{
+public:
+  uint32_t Add(std::string const & s)
+  {
+    CHECK_LESS(m_strings.size() + s.size(), std::numeric_limits<uint32_t>::max(), ());
+    auto const offset = static_cast<uint32_t>(m_strings.size());
+    m_strings.append(s.c_str(), s.size() + 1);
+    return offset;
+  }
+
+  uint32_t AddUnique(std::string const & s)
+  {
+    auto const it = m_unique.find(s);
+    if (it != m_unique.end())
+      return it->second;
+
+    auto const offset = Add(s);
+    m_unique.emplace(s, offset);
+    return offset;
+  }
+
+  std::string const & GetStrings() const { return m_strings; }
+
+private:
+  std::string m_strings;
+  std::map<std::string, uint32_t> m_unique;
+};
+
+void WritePadding(FileWriter & writer)
+{
+  char const zeros[kAlignment] = {};
+  if (auto const rest = writer.Pos() % kAlignment)
+    writer.Write(zeros, kAlignment - rest);
+}
+
+template <typename Name>
+void ReadProperties(json_t * json, RegionPropertiesStore::Record & record,
+                    std::vector<Name> & names, StringsBuilder & strings)
+{
+  auto && properties = base::GetJSONObligatoryField(json, "properties");
+  record.m_rank = static_cast<int16_t>(FromJSONObject<int>(properties, "rank"));
+
+  auto && drefField = base::GetJSONOptionalField(properties, "dref");
+  if (drefField && !base::JSONIsNull(drefField))
+  {
+    auto const drefStr = FromJSON<std::string>(drefField);
+    CHECK(strings::to_uint64(drefStr, record.m_dref, 16), (drefStr));
+    record.m_hasDref = 1;
+  }
+
+  record.m_namesBegin = static_cast<uint32_t>(names.size());
+  if (auto && locales = base::GetJSONOptionalField(properties, "locales"))
+  {
+    char const * language;
+    json_t * locale;
+    json_object_foreach(locales, language, locale)
+    {
+      auto && name = base::GetJSONOptionalField(locale, "name");
+      if (!name || !json_is_string(name))
+        continue;
+
+      names.push_back({strings.AddUnique(language), strings.Add(json_string_value(name))});
+    }
+
+    auto && defaultLocale = base::GetJSONOptionalField(locales, "default");
+    auto && address =
+        defaultLocale ? base::GetJSONOptionalField(defaultLocale, "address") : nullptr;
+    for (auto const level : kAddressLevels)
+    {
+      if (!address || !base::GetJSONOptionalField(address, GetLabel(level)))
+        continue;
+
+      record.m_addressLevels |= 1 << static_cast<uint8_t>(level);
+      record.m_level = static_cast<uint8_t>(level);
+    }
+  }
+  CHECK_LESS_OR_EQUAL(names.size() - record.m_namesBegin, std::numeric_limits<uint16_t>::max(), ());
+  record.m_namesCount = static_cast<uint16_t>(names.size() - record.m_namesBegin);
+
+  auto && bbox = base::GetJSONOptionalField(json, "bbox");
+  if (bbox && json_array_size(bbox) == 4)
+  {
+    for (size_t i = 0; i < 4; ++i)
+      record.m_bbox[i] = FromJSON<double>(json_array_get(bbox, i));
+  }
+}
+}  // namespace
+
+// RegionPropertiesStore::Record -------------------------------------------------------------------
+boost::optional<uint64_t> RegionPropertiesStore::Record::GetDref() const
+{
+  if (!m_hasDref)
+    return {};
+  return m_dref;
+}
+
+bool RegionPropertiesStore::Record::HasAddressLevel(PlaceLevel level) const
+{
+  return (m_addressLevels & (1 << static_cast<uint8_t>(level))) != 0;
+}
+
+// RegionPropertiesStore ---------------------------------------------------------------------------
+// static
+std::string RegionPropertiesStore::GetStorePath(std::string const & kvPath)
+{
+  return kvPath + kExtension;
+}
+
+// static
+void RegionPropertiesStore::Build(std::string const & kvPath, std::string const & storePath)
+{
+  std::vector<Record> records;
+  std::vector<Name> names;
+  StringsBuilder strings;
+
+  FileWriter writer(storePath);
+  Header header{};
+  writer.Write(&header, sizeof(header));
+  header.m_version = kVersion;
+  header.m_jsonsOffset = writer.Pos();
+
+  std::ifstream stream(kvPath);
+  std::string line;
+  std::streamoff lineNumber = 0;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+
+    uint64_t key;
+    auto value = std::string{};
+    if (!KeyValueStorage::ParseKeyValueLine(line, lineNumber, key, value))
+      continue;
+
+    base::JSONPtr json;
+    try
+    {
+      json = base::LoadFromString(value);
+    }
+    catch (base::Json::Exception const & e)
+    {
+      LOG(LWARNING, ("Cannot create base::Json in line", lineNumber, ":", e.Msg()));
+      continue;
+    }
+
+    CHECK_LESS_OR_EQUAL(value.size(), std::numeric_limits<uint32_t>::max(), ());
+    Record record{};
+    record.m_id = key;
+    record.m_jsonOffset = writer.Pos() - header.m_jsonsOffset;
+    record.m_jsonSize = static_cast<uint32_t>(value.size());
+    ReadProperties(json.get(), record, names, strings);
+    writer.Write(value.data(), value.size());
+    records.push_back(record);
+  }
+
+  // The first record of an id wins as in KeyValueStorage.
+  std::stable_sort(records.begin(), records.end(),
+                   [](Record const & l, Record const & r) { return l.m_id < r.m_id; });
+  records.erase(std::unique(records.begin(), records.end(),
+                            [](Record const & l, Record const & r) { return l.m_id == r.m_id; }),
+                records.end());
+  CHECK_LESS_OR_EQUAL(records.size(), std::numeric_limits<uint32_t>::max(), ());
+  header.m_recordsCount = static_cast<uint32_t>(records.size());
+
+  WritePadding(writer);
+  header.m_recordsOffset = writer.Pos();
+  writer.Write(records.data(), records.size() * sizeof(Record));
+
+  header.m_namesOffset = writer.Pos();
+  header.m_namesCount = names.size();
+  writer.Write(names.data(), names.size() * sizeof(Name));
+
+  header.m_stringsOffset = writer.Pos();
+  header.m_stringsSize = strings.GetStrings().size();
+  writer.Write(strings.GetStrings().data(), strings.GetStrings().size());
+
+  writer.Seek(0);
+  writer.Write(&header, sizeof(header));
+}
+
+// static
+void RegionPropertiesStore::BuildIfNeeded(std::string const & kvPath)
+{
+  auto const storePath = GetStorePath(kvPath);
+  // Modification times have a resolution of a second, the store of the same second is rebuilt.
+  if (Platform::IsFileExistsByFullPath(storePath) &&
+      boost::filesystem::last_write_time(storePath) > boost::filesystem::last_write_time(kvPath))
+  {
+    return;
+  }
+
+  LOG(LINFO, ("Building regions properties store", storePath));
+  CHECK(base::WriteToTempAndRenameToFile(storePath,
+                                         [&kvPath](std::string const & path) {
+                                           Build(kvPath, path);
+                                           return true;
+                                         }),
+        (storePath));
+}
+
+RegionPropertiesStore::RegionPropertiesStore(std::string const & storePath)
+  : m_reader(storePath)
+{
+  CHECK_GREATER_OR_EQUAL(m_reader.Size(), sizeof(Header), (storePath));
+  auto const data = m_reader.Data();
+  Header header;
+  std::memcpy(&header, data, sizeof(header));
+  CHECK_EQUAL(header.m_version, kVersion, (storePath));
+  CHECK_EQUAL(header.m_recordsOffset % kAlignment, 0, (storePath));
+  CHECK_LESS_OR_EQUAL(header.m_stringsOffset + header.m_stringsSize, m_reader.Size(), (storePath));
+
+  m_size = header.m_recordsCount;
+  m_records = reinterpret_cast<Record const *>(data + header.m_recordsOffset);
+  m_names = reinterpret_cast<Name const *>(data + header.m_namesOffset);
+  m_strings = reinterpret_cast<char const *>(data + header.m_stringsOffset);
+  m_jsons = reinterpret_cast<char const *>(data + header.m_jsonsOffset);
+  m_parsedJsons.resize(m_size);
+}
+
+size_t RegionPropertiesStore::Size() const { return m_size; }
+
+RegionPropertiesStore::Record const * RegionPropertiesStore::FindRecord(uint64_t id) const
+{
+  auto const end = m_records + m_size;
+  auto const it = std::lower_bound(m_records, end, id,
+                                   [](Record const & r, uint64_t id) { return r.m_id < id; });
+  if (it == end || it->m_id != id)
+    return nullptr;
+
+  return it;
+}
+
+boost::optional<std::string> RegionPropertiesStore::GetName(Record const & record,
+                                                            std::string const & language) const
+{
+  for (auto i = record.m_namesBegin; i < record.m_namesBegin + record.m_namesCount; ++i)
+  {
+    if (language == m_strings + m_names[i].m_language)
+      return std::string{m_strings + m_names[i].m_name};
+  }
+
+  return {};
+}
+
+std::shared_ptr<JsonValue> RegionPropertiesStore::GetJson(Record const & record) const
+{
+  auto const index = static_cast<size_t>(&record - m_records);
+  CHECK_LESS(index, m_size, ());
+
+  auto & cached = m_parsedJsons[index];
+  if (auto json = std::atomic_load(&cached))
+    return json;
+
+  // Concurrent callers may parse the same JSON, only one of the results is cached.
+  auto json = std::make_shared<JsonValue>(
+      base::LoadFromString(std::string(m_jsons + record.m_jsonOffset, record.m_jsonSize)));
+  std::shared_ptr<JsonValue> expected;
+  if (!std::atomic_compare_exchange_strong(&cached, &expected, json))
+    return expected;
+
+  return json;
+}
+
+std::shared_ptr<JsonValue> RegionPropertiesStore::Find(uint64_t id) const
+{
+  auto const record = FindRecord(id);
+  if (!record)
+    return {};
+
+  return GetJson(*record);
+}
+}  // namespace regions
+}  // namespace generator
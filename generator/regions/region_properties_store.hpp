@@ -0,0 +1,95 @@
+#pragma once
+
+#include "generator/key_value_storage.hpp"
+#include "generator/regions/collector_region_info.hpp"
+
+#include "coding/mmap_reader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace generator
+{
+namespace regions
+{
+// A binary store of the regions key-value file. The fields needed on the lookup paths are kept
+// in fixed-width records sorted by id, the region JSON is kept as text and is parsed only when
+// it is requested. The store is mmapped, so loading it does not parse the regions.
+// The store is an intermediate file of the generator and is written in host byte order.
+class RegionPropertiesStore
+{
+public:
+  struct Record
+  {
+    boost::optional<uint64_t> GetDref() const;
+    PlaceLevel GetLevel() const { return static_cast<PlaceLevel>(m_level); }
+    // Whether the address of the region has the label of |level|.
+    bool HasAddressLevel(PlaceLevel level) const;
+
+    uint64_t m_id;
+    uint64_t m_dref;
+    uint64_t m_jsonOffset;
+    // Lon/lat bbox: min lon, min lat, max lon, max lat.
+    double m_bbox[4];
+    uint32_t m_jsonSize;
+    uint32_t m_namesBegin;
+    uint16_t m_namesCount;
+    int16_t m_rank;
+    uint8_t m_level;
+    uint8_t m_addressLevels;
+    uint8_t m_hasDref;
+    uint8_t m_reserved;
+  };
+
+  static char const kExtension[];
+
+  // The path of the store of the regions key-value file |kvPath|.
+  static std::string GetStorePath(std::string const & kvPath);
+  static void Build(std::string const & kvPath, std::string const & storePath);
+  // Builds the store of |kvPath| if there is no store or it is older than |kvPath|.
+  static void BuildIfNeeded(std::string const & kvPath);
+
+  explicit RegionPropertiesStore(std::string const & storePath);
+
+  RegionPropertiesStore(RegionPropertiesStore &&) = default;
+  RegionPropertiesStore & operator=(RegionPropertiesStore &&) = default;
+
+  RegionPropertiesStore(RegionPropertiesStore const &) = delete;
+  RegionPropertiesStore & operator=(RegionPropertiesStore const &) = delete;
+
+  size_t Size() const;
+  Record const * FindRecord(uint64_t id) const;
+
+  template <typename ToDo>
+  void ForEachRecord(ToDo && toDo) const
+  {
+    for (size_t i = 0; i < Size(); ++i)
+      toDo(m_records[i]);
+  }
+
+  // Name of the region in locale |language|: field `properties.locales.<language>.name` in JSON.
+  boost::optional<std::string> GetName(Record const & record, std::string const & language) const;
+
+  // Parses the JSON of |record|. The parsed JSON is cached, so the JSON of each region is parsed
+  // at most once. Thread-safe.
+  std::shared_ptr<JsonValue> GetJson(Record const & record) const;
+  std::shared_ptr<JsonValue> Find(uint64_t id) const;
+
+private:
+  struct Header;
+  struct Name;
+
+  MmapReader m_reader;
+  size_t m_size = 0;
+  Record const * m_records = nullptr;
+  Name const * m_names = nullptr;
+  char const * m_strings = nullptr;
+  char const * m_jsons = nullptr;
+  mutable std::vector<std::shared_ptr<JsonValue>> m_parsedJsons;
+};
+}  // namespace regions
+}  // namespace generator
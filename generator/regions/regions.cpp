@@ -1,28 +1,35 @@
 #include "generator/regions/regions.hpp"
 #include "generator/key_value_storage.hpp"
 
+#include "generator/binary_hierarchy_collector.hpp"
 #include "generator/feature_builder.hpp"
 #include "generator/feature_generator.hpp"
 #include "generator/regions/node.hpp"
 #include "generator/regions/place_point.hpp"
 #include "generator/regions/regions_builder.hpp"
+#include "generator/stages_report.hpp"
 
 #include "geometry/mercator.hpp"
 
 #include "platform/platform.hpp"
 
+#include "base/arena.hpp"
 #include "base/assert.hpp"
 #include "base/logging.hpp"
+#include "base/memory_accounting.hpp"
 #include "base/scope_guard.hpp"
 #include "base/timer.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <map>
 #include <memory>
 #include <numeric>
 #include <set>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 
@@ -34,72 +41,120 @@ namespace regions
 {
 namespace
 {
+// The copies of a region share its polygon, so do the fixed point polygons.
+void SetFixedPointPolygons(FlatRegionsTree & tree)
+{
+  std::unordered_map<std::shared_ptr<BoostPolygon>, std::shared_ptr<FixedPointPolygon const>>
+      polygons;
+  for (uint32_t node = 0; node < tree.GetSize(); ++node)
+  {
+    auto & region = tree.GetData(node);
+    auto & polygon = polygons[region.GetPolygon()];
+    if (!polygon)
+      polygon = std::make_shared<FixedPointPolygon const>(*region.GetPolygon());
+    region.SetFixedPointPolygon(polygon);
+  }
+}
+
 class RegionsGenerator
 {
 public:
   RegionsGenerator(std::string const & pathRegionsTmpMwm,
                    std::string const & pathInRegionsCollector,
                    std::string const & pathOutRegionsKv,
-                   bool verbose, unsigned int threadsCount)
+                   bool verbose, unsigned int threadsCount, bool fixedPointPolygons,
+                   std::string const & pathOutRegionsHierarchy)
     : m_pathRegionsTmpMwm{pathRegionsTmpMwm}
     , m_pathOutRegionsKv{pathOutRegionsKv}
+    , m_pathOutRegionsHierarchy{pathOutRegionsHierarchy}
     , m_threadsCount{threadsCount}
     , m_taskProcessingThreadPool{threadsCount}
     , m_verbose{verbose}
+    , m_fixedPointPolygons{fixedPointPolygons}
     , m_regionsInfoCollector{pathInRegionsCollector}
     , m_regionsKv{pathOutRegionsKv, std::ofstream::out}
+    , m_writeHierarchy{!pathOutRegionsHierarchy.empty()}
+    , m_nodesArena{base::Arena::kDefaultChunkSize, &base::memory::GetTag("region_nodes")}
   {
     LOG(LINFO, ("Start generating regions from", m_pathRegionsTmpMwm));
+    if (m_writeHierarchy)
+      m_regionsHierarchy.open(pathOutRegionsHierarchy, std::ofstream::out | std::ofstream::binary);
     auto timer = base::Timer{};
 
     RegionsBuilder::Regions regions;
     PlacePointsMap placePointsMap;
-    std::tie(regions, placePointsMap) =
-        ReadDatasetFromTmpMwm(m_pathRegionsTmpMwm, m_regionsInfoCollector);
-    RegionsBuilder builder{
-        std::move(regions), std::move(placePointsMap), m_taskProcessingThreadPool};
+    {
+      ScopedStage stage("regions: reading dataset");
+      std::tie(regions, placePointsMap) =
+          ReadDatasetFromTmpMwm(m_pathRegionsTmpMwm, m_regionsInfoCollector);
+    }
+    // The polygons are shared by the regions and the nodes until the generator is destroyed.
+    size_t polygonsPoints = 0;
+    for (auto const & region : regions)
+      polygonsPoints += boost::geometry::num_points(*region.GetPolygon());
+    m_polygonsMemory = base::memory::ScopedBytes(base::memory::GetTag("region_polygons"),
+                                                 polygonsPoints * sizeof(BoostPoint));
+
+    RegionsBuilder builder{std::move(regions), std::move(placePointsMap),
+                           m_taskProcessingThreadPool, &m_nodesArena};
 
+    ScopedStage stage("regions: hierarchy and key-value");
     GenerateRegions(builder);
     LOG(LINFO, ("Finish generating regions.", timer.ElapsedSeconds(), "seconds."));
   }
 
 private:
+  // The key-value and the binary hierarchy chunk of a country.
+  struct SerializedCountry
+  {
+    std::string m_kv;
+    std::string m_hierarchy;
+  };
+
+  // The countries serialized ahead of the writer.
+  static size_t constexpr kPendingKvPerThread = 2;
+
   void GenerateRegions(RegionsBuilder & builder)
   {
-    builder.ForEachCountry([&](std::string const & /*name*/, Node::PtrList const & outers) {
-      auto const & countryPlace = outers.front()->GetData();
+    builder.ForEachCountry([&](std::string const & /*name*/, FlatRegionsTree && tree) {
+      auto const & countryPlace = tree.GetData(0);
       auto const & countryName =
           countryPlace.GetTranslatedOrTransliteratedName(StringUtf8Multilang::GetLangIndex("en"));
-      GenerateKv(countryName, outers);
+      GenerateKv(countryName, std::move(tree));
     });
+    FlushKv(0 /* maxPendingCount */);
 
     LOG(LINFO, ("Regions objects key-value for", builder.GetCountryInternationalNames().size(),
                 "countries storage saved to", m_pathOutRegionsKv));
+    if (m_writeHierarchy)
+      LOG(LINFO, ("Regions binary hierarchy saved to", m_pathOutRegionsHierarchy));
     LOG(LINFO,
         (m_objectsRegions.size(), "total regions.", m_regionsCountries.size(), "total objects."));
 
+    ScopedStage stage("regions: repacking features");
     RepackTmpMwm();
   }
 
-  base::JSONPtr BuildRegionValue(regions::NodePath const & path) const
+  JsonObjectPatch BuildRegionValue(FlatRegionsTree const & tree,
+                                   FlatRegionsTree::Path const & path) const
   {
-    auto const & main = path.back()->GetData();
-    auto geometry = base::NewJSONObject();
-    ToJSONObject(*geometry, "type", "Point");
-    auto coordinates = base::NewJSONArray();
+    auto const & main = tree.GetData(path.back());
+    JsonObjectPatch feature;
+    feature.Set("type", "Feature");
+
+    auto & geometry = feature.GetOrCreateObject("geometry");
+    geometry.Set("type", "Point");
     auto const tmpCenter = main.GetCenter();
     auto const center = MercatorBounds::ToLatLon({tmpCenter.get<0>(), tmpCenter.get<1>()});
-    ToJSONArray(*coordinates, center.m_lon);
-    ToJSONArray(*coordinates, center.m_lat);
-    ToJSONObject(*geometry, "coordinates", coordinates);
+    geometry.Set("coordinates", std::vector<double>{center.m_lon, center.m_lat});
 
-    auto properties = base::NewJSONObject();
+    auto & properties = feature.GetOrCreateObject("properties");
 
-    Localizator localizator(*properties);
+    PatchLocalizator localizator(properties);
 
-    for (auto const & p : path)
+    for (auto const p : path)
     {
-      auto const & region = p->GetData();
+      auto const & region = tree.GetData(p);
       CHECK(region.GetLevel() != regions::PlaceLevel::Unknown, ());
       auto const label = GetLabel(region.GetLevel());
       CHECK(label, ());
@@ -108,37 +163,32 @@ private:
       {
         localizator.AddVerbose(
             [&label, &region](auto & node) {
-              ToJSONObject(node, std::string{label} + "_i", DebugPrint(region.GetId()));
-              ToJSONObject(node, std::string{label} + "_a", region.GetArea());
-              ToJSONObject(node, std::string{label} + "_r", region.GetRank());
+              node.Set(std::string{label} + "_i", DebugPrint(region.GetId()));
+              node.Set(std::string{label} + "_a", region.GetArea());
+              node.Set(std::string{label} + "_r", region.GetRank());
             },
             "address");
       }
     }
 
     localizator.SetLocale("name", main);
-    ToJSONObject(*properties, "kind", GetPlaceKind(main));
-    ToJSONObject(*properties, "rank", main.GetRank());
+    properties.Set("kind", GetPlaceKind(main));
+    properties.Set("rank", main.GetRank());
 
     if (path.size() > 1)
     {
-      auto const & parent = (*(path.rbegin() + 1))->GetData();
+      auto const & parent = tree.GetData(*(path.rbegin() + 1));
       auto const parentId = parent.GetId().GetEncodedId();
-      ToJSONObject(*properties, "dref", KeyValueStorage::SerializeDref(parentId));
+      properties.Set("dref", KeyValueStorage::SerializeDref(parentId));
     }
     else
     {
-      ToJSONObject(*properties, "dref", base::NewJSONNull());
+      properties.SetNull("dref");
     }
 
-    auto const & country = path.front()->GetData();
+    auto const & country = tree.GetData(path.front());
     if (auto && isoCode = country.GetIsoCode())
-      ToJSONObject(*properties, "code", *isoCode);
-
-    auto feature = base::NewJSONObject();
-    ToJSONObject(*feature, "type", "Feature");
-    ToJSONObject(*feature, "geometry", geometry);
-    ToJSONObject(*feature, "properties", properties);
+      properties.Set("code", *isoCode);
 
     auto const & bbox = main.GetRect();
     auto const & leftBottom = MercatorBounds::ToLatLon({bbox.min_corner().get<0>(),
@@ -147,12 +197,12 @@ private:
                                                       bbox.max_corner().get<1>()});
     auto const & bboxArray =
         std::vector<double>{leftBottom.m_lon, leftBottom.m_lat, rightTop.m_lon, rightTop.m_lat};
-    ToJSONObject(*feature, "bbox", bboxArray);
+    feature.Set("bbox", bboxArray);
 
     return feature;
   }
 
-  void GenerateKv(std::string const & countryName, Node::PtrList const & outers)
+  void GenerateKv(std::string const & countryName, FlatRegionsTree && countryTree)
   {
     LOG(LINFO, ("Generate country", countryName));
 
@@ -161,62 +211,89 @@ private:
     size_t countryObjectCount = 0;
 
     std::vector<base::GeoObjectId> objectsOrder;
-    std::map<base::GeoObjectId, NodePath> objectsPaths;
+    std::map<base::GeoObjectId, FlatRegionsTree::Path> objectsPaths;
+
+    m_countriesTrees.push_back(std::move(countryTree));
+    if (m_fixedPointPolygons)
+      SetFixedPointPolygons(m_countriesTrees.back());
+    auto const & tree = m_countriesTrees.back();
+    if (m_verbose)
+      DebugPrintTree(tree);
+
+    tree.ForEachLevelPath([&](FlatRegionsTree::Path const & path) {
+      auto const & region = tree.GetData(path.back());
+      auto const & objectId = region.GetId();
+      auto const & regionCountryEmplace = m_regionsCountries.emplace(objectId, country);
+      bool firstRegionOfObject = regionCountryEmplace.second;
+      if (!regionCountryEmplace.second && regionCountryEmplace.first->second != country)
+      {
+        LOG(LWARNING, ("Failed to place", GetLabel(region.GetLevel()), "region", objectId, "(",
+                       GetRegionNotation(region), ")", "into", *country,
+                       ": region already exists in", *regionCountryEmplace.first->second));
+        return;
+      }
 
-    for (auto const & tree : outers)
-    {
-      if (m_verbose)
-        DebugPrintTree(tree);
-
-      ForEachLevelPath(tree, [&](NodePath const & path) {
-        auto const & node = path.back();
-        auto const & region = node->GetData();
-        auto const & objectId = region.GetId();
-        auto const & regionCountryEmplace = m_regionsCountries.emplace(objectId, country);
-        bool firstRegionOfObject = regionCountryEmplace.second;
-        if (!regionCountryEmplace.second && regionCountryEmplace.first->second != country)
-        {
-          LOG(LWARNING, ("Failed to place", GetLabel(region.GetLevel()), "region", objectId, "(",
-                         GetRegionNotation(region), ")", "into", *country,
-                         ": region already exists in", *regionCountryEmplace.first->second));
-          return;
-        }
-
-        m_objectsRegions.emplace(objectId, node);
-        ++countryRegionsCount;
-        if (firstRegionOfObject)
-        {
-          objectsOrder.push_back(objectId);
-          ++countryObjectCount;
-        }
-
-        auto pathEmplace = objectsPaths.emplace(objectId, path);
-        if (!pathEmplace.second)
-        {
-          auto & objectMaxRegionPath = pathEmplace.first->second;
-          auto & objectMaxRegion = objectMaxRegionPath.back()->GetData();
-          if (RegionsBuilder::IsAreaLessRely(objectMaxRegion, region))
-            objectMaxRegionPath = path;
-        }
-      });
-    }
+      m_objectsRegions.emplace(objectId, &region);
+      ++countryRegionsCount;
+      if (firstRegionOfObject)
+      {
+        objectsOrder.push_back(objectId);
+        ++countryObjectCount;
+      }
+
+      auto pathEmplace = objectsPaths.emplace(objectId, path);
+      if (!pathEmplace.second)
+      {
+        auto & objectMaxRegionPath = pathEmplace.first->second;
+        auto & objectMaxRegion = tree.GetData(objectMaxRegionPath.back());
+        if (RegionsBuilder::IsAreaLessRely(objectMaxRegion, region))
+          objectMaxRegionPath = path;
+      }
+    });
 
-    WriteObjectsInKv(objectsOrder, objectsPaths);
+    // The countries are serialized in parallel and written in the order they are generated.
+    m_pendingKv.push_back(m_taskProcessingThreadPool.Submit(
+        [this, &tree, objectsOrder{std::move(objectsOrder)},
+         objectsPaths{std::move(objectsPaths)}]() {
+          return SerializeObjectsKv(tree, objectsOrder, objectsPaths);
+        }));
+    FlushKv(kPendingKvPerThread * m_threadsCount);
 
     LOG(LINFO, ("Country regions of", *country, "has built:", countryRegionsCount, "total regions.",
                 countryObjectCount, "objects."));
   }
 
-  void WriteObjectsInKv(std::vector<base::GeoObjectId> const & objectsOrder,
-                        std::map<base::GeoObjectId, NodePath> const & objectsPaths)
+  SerializedCountry SerializeObjectsKv(
+      FlatRegionsTree const & tree, std::vector<base::GeoObjectId> const & objectsOrder,
+      std::map<base::GeoObjectId, FlatRegionsTree::Path> const & objectsPaths) const
   {
+    SerializedCountry country;
+    BinaryHierarchyCollector hierarchy;
     for (auto const & objectId : objectsOrder)
     {
       auto pathIter = objectsPaths.find(objectId);
       CHECK(pathIter != objectsPaths.end(), ());
       auto const & path = pathIter->second;
-      m_regionsKv << KeyValueStorage::SerializeDref(objectId.GetEncodedId()) << " "
-                  << KeyValueStorage::Serialize(BuildRegionValue(path)) << "\n";
+      auto const value = BuildRegionValue(tree, path);
+      KeyValueStorage::SerializeFullLine(country.m_kv, objectId.GetEncodedId(), value);
+      if (m_writeHierarchy)
+        hierarchy.Add(objectId.GetEncodedId(), value);
+    }
+    if (!hierarchy.IsEmpty())
+      country.m_hierarchy = hierarchy.ReleaseChunk();
+    return country;
+  }
+
+  // Writes the serialized countries until at most |maxPendingCount| of them are pending.
+  void FlushKv(size_t maxPendingCount)
+  {
+    while (m_pendingKv.size() > maxPendingCount)
+    {
+      auto const country = m_pendingKv.front().get();
+      m_regionsKv << country.m_kv;
+      if (m_writeHierarchy)
+        m_regionsHierarchy << country.m_hierarchy;
+      m_pendingKv.pop_front();
     }
   }
 
@@ -271,7 +348,7 @@ private:
 
       for (auto item = objectRegions.first; item != objectRegions.second; ++item)
       {
-        auto const & region = item->second->GetData();
+        auto const & region = *item->second;
         ResetGeometry(fb, region);
         fb.SetOsmId(region.GetId());
         fb.SetRank(0);
@@ -289,7 +366,10 @@ private:
   {
     fb.ResetGeometry();
 
-    auto const & polygon = region.GetPolygon();
+    auto const & fixedPointPolygon = region.GetFixedPointPolygon();
+    auto const polygon = fixedPointPolygon
+                             ? std::make_shared<BoostPolygon>(fixedPointPolygon->ToBoostPolygon())
+                             : region.GetPolygon();
     auto outer = GetPointSeq(polygon->outer());
     fb.AddPolygon(outer);
     FeatureBuilder::Geometry holes;
@@ -341,28 +421,41 @@ private:
 
   std::string m_pathRegionsTmpMwm;
   std::string m_pathOutRegionsKv;
+  std::string m_pathOutRegionsHierarchy;
 
   unsigned int m_threadsCount{1};
   base::thread_pool::computational::ThreadPool mutable m_taskProcessingThreadPool;
 
   bool m_verbose{false};
+  // The regions of the built countries keep the polygons with the fixed point coordinates.
+  bool m_fixedPointPolygons{false};
 
   RegionInfo m_regionsInfoCollector;
 
   std::ofstream m_regionsKv;
-
-  std::multimap<base::GeoObjectId, Node::Ptr> m_objectsRegions;
+  bool m_writeHierarchy{false};
+  std::ofstream m_regionsHierarchy;
+  std::deque<std::future<SerializedCountry>> m_pendingKv;
+
+  // The nodes of the region trees while the countries are built.
+  base::Arena m_nodesArena;
+  // The regions of the built countries, |m_objectsRegions| points to them.
+  std::deque<FlatRegionsTree> m_countriesTrees;
+  std::multimap<base::GeoObjectId, LevelRegion const *> m_objectsRegions;
   std::map<base::GeoObjectId, std::shared_ptr<std::string>> m_regionsCountries;
+  base::memory::ScopedBytes m_polygonsMemory;
 };
 }  // namespace
 
 void GenerateRegions(std::string const & pathRegionsTmpMwm,
                      std::string const & pathInRegionsCollector,
                      std::string const & pathOutRegionsKv,
-                     bool verbose, unsigned int threadsCount)
+                     bool verbose, unsigned int threadsCount, bool fixedPointPolygons,
+                     std::string const & pathOutRegionsHierarchy)
 {
+  ScopedStage stage("regions");
   RegionsGenerator(pathRegionsTmpMwm, pathInRegionsCollector, pathOutRegionsKv,
-                   verbose, threadsCount);
+                   verbose, threadsCount, fixedPointPolygons, pathOutRegionsHierarchy);
 }
 }  // namespace regions
 }  // namespace generator
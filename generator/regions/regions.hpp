@@ -6,10 +6,15 @@ namespace generator
 {
 namespace regions
 {
+// |fixedPointPolygons| keeps the polygons of the built regions with the fixed point coordinates,
+// see FixedPointPolygon. The binary hierarchy of the geocoder is written to
+// |pathOutRegionsHierarchy| if it is not empty, see BinaryHierarchyCollector.
 void GenerateRegions(std::string const & pathRegionsTmpMwm,
                      std::string const & pathInRegionsCollector,
                      std::string const & pathOutRegionsKv,
                      bool verbose,
-                     unsigned int threadsCount = 1);
+                     unsigned int threadsCount = 1,
+                     bool fixedPointPolygons = false,
+                     std::string const & pathOutRegionsHierarchy = {});
 }  // namespace regions
 }  // namespace generator
@@ -24,9 +24,11 @@ namespace regions
 {
 RegionsBuilder::RegionsBuilder(
     Regions && regions, PlacePointsMap && placePointsMap,
-    base::thread_pool::computational::ThreadPool & taskProcessingThreadPool)
+    base::thread_pool::computational::ThreadPool & taskProcessingThreadPool,
+    base::Arena * nodesArena)
   : m_threadsCount{static_cast<unsigned int>(taskProcessingThreadPool.Size())}
   , m_taskProcessingThreadPool{taskProcessingThreadPool}
+  , m_nodesArena{nodesArena}
 {
   std::erase_if(placePointsMap, [](auto const & item) {
     return strings::IsASCIINumeric(item.second.GetName());
@@ -37,6 +39,13 @@ RegionsBuilder::RegionsBuilder(
   m_regionsInAreaOrder = FormRegionsInAreaOrder(std::move(regions));
   m_countriesOuters = ExtractCountriesOuters(m_regionsInAreaOrder);
   m_placePointsMap = std::move(placePointsMap);
+
+  std::vector<RectsIndex::value_type> rects;
+  rects.reserve(m_regionsInAreaOrder.size());
+  for (size_t i = 0; i < m_regionsInAreaOrder.size(); ++i)
+    rects.emplace_back(m_regionsInAreaOrder[i].GetRect(), i);
+  // The packing constructor builds a better balanced tree than the insertions.
+  m_regionsInAreaOrderIndex = RectsIndex{rects.begin(), rects.end()};
 }
 
 void RegionsBuilder::MoveLabelPlacePoints(PlacePointsMap & placePointsMap, Regions & regions)
@@ -117,8 +126,7 @@ Node::Ptr RegionsBuilder::BuildCountryRegionTree(
     boost::optional<std::string> const & countryCode,
     CountrySpecifier const & countrySpecifier) const
 {
-  auto nodes = MakeCountryNodesInAreaOrder(outer, m_regionsInAreaOrder, countryCode,
-                                           countrySpecifier);
+  auto nodes = MakeCountryNodesInAreaOrder(outer, countryCode, countrySpecifier);
 
   auto && parentChildPairs = FindParentChildPairs(nodes, countrySpecifier);
 
@@ -145,30 +153,44 @@ Node::Ptr RegionsBuilder::BuildCountryRegionTree(
 }
 
 std::vector<Node::Ptr> RegionsBuilder::MakeCountryNodesInAreaOrder(
-    Region const & countryOuter, Regions const & regionsInAreaOrder,
-    boost::optional<std::string> const & countryCode,
+    Region const & countryOuter, boost::optional<std::string> const & countryCode,
     CountrySpecifier const & countrySpecifier) const
 {
+  std::vector<RectsIndex::value_type> rects;
+  m_regionsInAreaOrderIndex.query(
+      boost::geometry::index::covered_by(countryOuter.GetRect()), std::back_inserter(rects));
+  std::vector<size_t> indices;
+  indices.reserve(rects.size());
+  for (auto const & rect : rects)
+    indices.push_back(rect.second);
+  std::sort(std::begin(indices), std::end(indices));
+
   std::vector<Node::Ptr> nodes{
-      std::make_shared<Node>(LevelRegion{PlaceLevel::Country, countryOuter})};
-  for (auto const & region : regionsInAreaOrder)
+      MakeNode(LevelRegion{PlaceLevel::Country, countryOuter})};
+  for (auto const i : indices)
   {
-    if (countryOuter.ContainsRect(region))
-    {
-      auto && regionIsoCode = region.GetIsoCode();
-      if (regionIsoCode && countryCode && GetCountryCode(*regionIsoCode) != *countryCode)
-        continue;
+    auto const & region = m_regionsInAreaOrder[i];
+    auto && regionIsoCode = region.GetIsoCode();
+    if (regionIsoCode && countryCode && GetCountryCode(*regionIsoCode) != *countryCode)
+      continue;
 
-      auto level = strings::IsASCIINumeric(region.GetName()) ? PlaceLevel::Unknown
-                                                             : countrySpecifier.GetLevel(region);
-      auto node = std::make_shared<Node>(LevelRegion{level, region});
-      nodes.emplace_back(std::move(node));
-    }
+    auto level = strings::IsASCIINumeric(region.GetName()) ? PlaceLevel::Unknown
+                                                           : countrySpecifier.GetLevel(region);
+    auto node = MakeNode(LevelRegion{level, region});
+    nodes.emplace_back(std::move(node));
   }
 
   return nodes;
 }
 
+Node::Ptr RegionsBuilder::MakeNode(LevelRegion && region) const
+{
+  // The countries are built in parallel, the arena is shared by the threads.
+  if (m_nodesArena)
+    return std::allocate_shared<Node>(base::ArenaAllocator<Node>(*m_nodesArena), std::move(region));
+  return std::make_shared<Node>(std::move(region));
+}
+
 std::list<RegionsBuilder::ParentChildPairs> RegionsBuilder::FindParentChildPairs(
     std::vector<Node::Ptr> const & nodes, CountrySpecifier const & countrySpecifier) const
 {
@@ -177,6 +199,7 @@ std::list<RegionsBuilder::ParentChildPairs> RegionsBuilder::FindParentChildPairs
                                    size_t{m_taskProcessingThreadPool.Size()});
 
   CHECK(!nodes.empty(), ());
+  auto const nodesIndex = MakeRectsIndex(nodes);
   std::atomic_size_t unprocessedIndex{1};
   auto task = [&] {
     ParentChildPairs parentChildPairs;
@@ -190,7 +213,7 @@ std::list<RegionsBuilder::ParentChildPairs> RegionsBuilder::FindParentChildPairs
 
       auto itemIterator = nodes.begin() + i;
       auto itemReverseIterator = std::make_reverse_iterator(std::next(itemIterator));
-      if (auto && parent = ChooseParent(nodes, itemReverseIterator, countrySpecifier))
+      if (auto && parent = ChooseParent(nodes, nodesIndex, itemReverseIterator, countrySpecifier))
         parentChildPairs.emplace_back(parent, *itemIterator);
     }
 
@@ -209,8 +232,19 @@ std::list<RegionsBuilder::ParentChildPairs> RegionsBuilder::FindParentChildPairs
   return parentChildPairs;
 }
 
+// static
+RegionsBuilder::RectsIndex RegionsBuilder::MakeRectsIndex(std::vector<Node::Ptr> const & nodes)
+{
+  std::vector<RectsIndex::value_type> rects;
+  rects.reserve(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+    rects.emplace_back(nodes[i]->GetData().GetRect(), i);
+  return RectsIndex{rects.begin(), rects.end()};
+}
+
 // static
 Node::Ptr RegionsBuilder::ChooseParent(std::vector<Node::Ptr> const & nodesInAreaOrder,
+                                       RectsIndex const & nodesIndex,
                                        std::vector<Node::Ptr>::const_reverse_iterator forItem,
                                        CountrySpecifier const & countrySpecifier)
 {
@@ -219,11 +253,34 @@ Node::Ptr RegionsBuilder::ChooseParent(std::vector<Node::Ptr> const & nodesInAre
 
   auto const from = FindAreaLowerBoundRely(nodesInAreaOrder, forItem);
   CHECK(from <= forItem, ());
+  auto const fromIndex =
+      static_cast<size_t>(std::distance(from, std::crend(nodesInAreaOrder))) - 1;
+  auto const itemIndex =
+      static_cast<size_t>(std::distance(forItem, std::crend(nodesInAreaOrder))) - 1;
+
+  // A parent candidate either covers the rect of the region or contains its center,
+  // so its rect intersects the rect of the region extended to the center.
+  auto searchRect = region.GetRect();
+  boost::geometry::expand(searchRect, region.GetCenter());
+  std::vector<RectsIndex::value_type> rects;
+  nodesIndex.query(boost::geometry::index::intersects(searchRect), std::back_inserter(rects));
+
+  // The candidates are checked in the same order as by the scan of the nodes from |from| to
+  // the largest one. The skipped nodes can't be parents and the areas of the nodes grow in
+  // this order, so the area check stops at the same parent.
+  std::vector<size_t> candidates;
+  candidates.reserve(rects.size());
+  for (auto const & rect : rects)
+  {
+    if (rect.second <= fromIndex)
+      candidates.push_back(rect.second);
+  }
+  std::sort(std::begin(candidates), std::end(candidates), std::greater<size_t>());
 
   Node::Ptr parent;
-  for (auto i = from, end = std::crend(nodesInAreaOrder); i != end; ++i)
+  for (auto const i : candidates)
   {
-    auto const & candidate = *i;
+    auto const & candidate = nodesInAreaOrder[i];
     auto const & candidateRegion = candidate->GetData();
 
     if (parent)
@@ -236,7 +293,7 @@ Node::Ptr RegionsBuilder::ChooseParent(std::vector<Node::Ptr> const & nodesInAre
     if (!candidateRegion.ContainsRect(region) && !candidateRegion.Contains(region.GetCenter()))
       continue;
 
-    if (i == forItem)
+    if (i == itemIndex)
       continue;
 
     auto const c = CompareAffiliation(candidateRegion, region, countrySpecifier);
@@ -349,24 +406,25 @@ bool RegionsBuilder::IsAreaLessRely(Region const & l, Region const & r)
 
 void RegionsBuilder::ForEachCountry(CountryFn fn)
 {
-  std::vector<std::future<Node::PtrList>> buildingTasks;
+  std::vector<std::future<FlatRegionsTree>> buildingTasks;
+  base::thread_pool::computational::ThreadPool threadPool(m_threadsCount);
 
+  for (auto const & countryName : GetCountryInternationalNames())
   {
-    base::thread_pool::computational::ThreadPool threadPool(m_threadsCount);
-
-    for (auto const & countryName : GetCountryInternationalNames())
-    {
-      auto result = threadPool.Submit([this, countryName]() { return BuildCountry(countryName); });
-      buildingTasks.emplace_back(std::move(result));
-    }
+    auto result = threadPool.Submit([this, countryName]() {
+      return FlatRegionsTree(BuildCountry(countryName));
+    });
+    buildingTasks.emplace_back(std::move(result));
   }
 
+  // A built country is passed to |fn| while the next countries are being built, there is no
+  // barrier for all the countries.
   for (auto && task : buildingTasks)
   {
-    auto countryTrees = task.get();
-    CHECK(!countryTrees.empty(), ());
-    auto && countryName = countryTrees.front()->GetData().GetInternationalName();
-    fn(countryName, countryTrees);
+    auto countryTree = task.get();
+    CHECK(!countryTree.IsEmpty(), ());
+    auto const countryName = countryTree.GetData(0).GetInternationalName();
+    fn(countryName, std::move(countryTree));
   }
 }
 
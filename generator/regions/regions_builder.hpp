@@ -5,6 +5,7 @@
 #include "generator/regions/node.hpp"
 #include "generator/regions/region.hpp"
 
+#include "base/arena.hpp"
 #include "base/thread_pool_computational.hpp"
 
 #include <functional>
@@ -14,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/optional.hpp>
 
 namespace generator
@@ -27,14 +29,21 @@ class RegionsBuilder
 public:
   using Regions = std::vector<Region>;
   using StringsList = std::vector<std::string>;
-  using CountryFn = std::function<void(std::string const &, Node::PtrList const &)>;
+  using CountryFn = std::function<void(std::string const &, FlatRegionsTree &&)>;
 
+  // The nodes of the trees are allocated in |nodesArena| if it is set, so the arena should
+  // outlive the trees.
   explicit RegionsBuilder(
       Regions && regions, PlacePointsMap && placePointsMap,
-      base::thread_pool::computational::ThreadPool & taskProcessingThreadPool);
+      base::thread_pool::computational::ThreadPool & taskProcessingThreadPool,
+      base::Arena * nodesArena = nullptr);
 
   Regions const & GetCountriesOuters() const;
   StringsList GetCountryInternationalNames() const;
+  // Builds the trees of the countries in parallel, each one with the place points, the suburbs
+  // and the levels of its country, and calls |fn| for the countries in the order of
+  // GetCountryInternationalNames() as soon as each of them is built. The trees of a country are
+  // flattened by its builder, the nodes are released before |fn| is called.
   void ForEachCountry(CountryFn fn);
 
   static void InsertIntoSubtree(Node::Ptr & subtree, LevelRegion && region,
@@ -48,7 +57,11 @@ private:
   static constexpr double kAreaRelativeErrorPercent = 0.1;
 
   using ParentChildPairs = std::vector<std::pair<Node::Ptr, Node::Ptr>>;
+  // The rects of the regions with the indices of the regions in their vector.
+  using RectsIndex = boost::geometry::index::rtree<std::pair<BoostRect, size_t>,
+                                                   boost::geometry::index::quadratic<16>>;
 
+  Node::Ptr MakeNode(LevelRegion && region) const;
   void MoveLabelPlacePoints(PlacePointsMap & placePointsMap, Regions & regions);
   Regions FormRegionsInAreaOrder(Regions && regions);
   Regions ExtractCountriesOuters(Regions & regions);
@@ -62,12 +75,13 @@ private:
                                    boost::optional<std::string> const & countryCode,
                                    CountrySpecifier const & countrySpecifier) const;
   std::vector<Node::Ptr> MakeCountryNodesInAreaOrder(
-      Region const & countryOuter, Regions const & regionsInAreaOrder,
-      boost::optional<std::string> const & countryCode,
+      Region const & countryOuter, boost::optional<std::string> const & countryCode,
       CountrySpecifier const & countrySpecifier) const;
   std::list<ParentChildPairs> FindParentChildPairs(
       std::vector<Node::Ptr> const & nodes, CountrySpecifier const & countrySpecifier) const;
+  static RectsIndex MakeRectsIndex(std::vector<Node::Ptr> const & nodes);
   static Node::Ptr ChooseParent(std::vector<Node::Ptr> const & nodesInAreaOrder,
+                                RectsIndex const & nodesIndex,
                                 std::vector<Node::Ptr>::const_reverse_iterator forItem,
                                 CountrySpecifier const & countrySpecifier);
   static std::vector<Node::Ptr>::const_reverse_iterator FindAreaLowerBoundRely(
@@ -78,9 +92,11 @@ private:
 
   Regions m_countriesOuters;
   Regions m_regionsInAreaOrder;
+  RectsIndex m_regionsInAreaOrderIndex;
   PlacePointsMap m_placePointsMap;
   unsigned int m_threadsCount;
   base::thread_pool::computational::ThreadPool & m_taskProcessingThreadPool;
+  base::Arena * m_nodesArena;
 };
 }  // namespace regions
 }  // namespace generator
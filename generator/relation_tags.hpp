@@ -24,6 +24,9 @@ public:
 
   void Reset(uint64_t fID, OsmElement * p);
 
+  // Returns true if the relation |id| is read already, so it doesn't need to be prefetched.
+  bool IsCached(uint64_t id) const { return m_cache.HasKey(id); }
+
   template <class Reader>
   base::ControlFlow operator() (uint64_t id, Reader & reader)
   {
@@ -13,12 +13,16 @@ void RelationTagsEnricher::operator()(OsmElement & p)
   if (p.IsNode())
   {
     m_nodeRelations.Reset(p.m_id, &p);
-    m_cache->ForEachRelationByNodeCached(p.m_id, m_nodeRelations);
+    m_cache->ForEachRelationByNodeCached(p.m_id, m_nodeRelations, [this](uint64_t id) {
+      return m_nodeRelations.IsCached(id);
+    });
   }
   else if (p.IsWay())
   {
     m_wayRelations.Reset(p.m_id, &p);
-    m_cache->ForEachRelationByWayCached(p.m_id, m_wayRelations);
+    m_cache->ForEachRelationByWayCached(p.m_id, m_wayRelations, [this](uint64_t id) {
+      return m_wayRelations.IsCached(id);
+    });
   }
 }
 }  // namespace generator
@@ -0,0 +1,121 @@
+#include "generator/shared_resources.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <sys/stat.h>
+
+namespace generator
+{
+namespace
+{
+// Returns false if |path| is not a file.
+bool AppendFileStamp(std::string const & path, std::ostringstream & stamp)
+{
+  struct stat fileStat{};
+  if (::stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    return false;
+
+#if defined(__APPLE__)
+  auto const & time = fileStat.st_mtimespec;
+#else
+  auto const & time = fileStat.st_mtim;
+#endif
+  stamp << fileStat.st_size << ' ' << time.tv_sec << ' ' << time.tv_nsec << '\n';
+  return true;
+}
+
+class Registry
+{
+public:
+  static Registry & Instance()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  void EnterScope()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_scopesCount;
+  }
+
+  void LeaveScope()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CHECK_GREATER(m_scopesCount, 0, ());
+    if (--m_scopesCount != 0)
+      return;
+
+    for (auto & resource : m_resources)
+      resource.second.m_pinned.reset();
+  }
+
+  std::shared_ptr<void const> Get(std::string const & id, std::string const & stamp,
+                                  std::function<std::shared_ptr<void const>()> const & load)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto & resource = m_resources[id];
+    if (resource.m_stamp == stamp)
+    {
+      if (auto loaded = resource.m_resource.lock())
+        return loaded;
+    }
+
+    // The resource of the changed files is released with its users.
+    resource = {};
+    auto loaded = load();
+    resource.m_stamp = stamp;
+    resource.m_resource = loaded;
+    if (m_scopesCount != 0)
+      resource.m_pinned = loaded;
+    return loaded;
+  }
+
+private:
+  struct Resource
+  {
+    std::string m_stamp;
+    std::weak_ptr<void const> m_resource;
+    // The resource is kept while a scope is alive.
+    std::shared_ptr<void const> m_pinned;
+  };
+
+  std::mutex m_mutex;
+  size_t m_scopesCount = 0;
+  // The resources by their types and paths.
+  std::map<std::string, Resource> m_resources;
+};
+}  // namespace
+
+// SharedResources::Scope --------------------------------------------------------------------------
+SharedResources::Scope::Scope() { Registry::Instance().EnterScope(); }
+
+SharedResources::Scope::~Scope() { Registry::Instance().LeaveScope(); }
+
+// SharedResources ---------------------------------------------------------------------------------
+// static
+std::shared_ptr<void const> SharedResources::Get(
+    char const * type, std::vector<std::string> const & paths,
+    std::function<std::shared_ptr<void const>()> const & load)
+{
+  std::string id = type;
+  std::ostringstream stamp;
+  for (auto const & path : paths)
+  {
+    if (!AppendFileStamp(path, stamp))
+    {
+      LOG(LWARNING, ("Resource of absent file", path, "is not shared."));
+      return load();
+    }
+    id += '\n' + path;
+  }
+
+  return Registry::Instance().Get(id, stamp.str(), load);
+}
+}  // namespace generator
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace generator
+{
+// |SharedResources| shares the read-only resources loaded from files among the stages of
+// a process, e.g. the regions index and key-value of the streets and the geo objects stages.
+// A resource is keyed by its type and the paths, the sizes and the modification times of its
+// files, so a changed file is loaded again. A resource is released with its last user unless
+// a Scope is alive: then the loaded resources are kept until the end of the last scope, so the
+// consecutive stages of a run do not load them again.
+class SharedResources
+{
+public:
+  class Scope
+  {
+  public:
+    Scope();
+    ~Scope();
+
+    Scope(Scope const &) = delete;
+    Scope & operator=(Scope const &) = delete;
+  };
+
+  // Returns the resource of |paths| loaded by |load| now or before. Thread-safe, the resources
+  // are loaded under the lock of the registry. The resource is not shared if a file is absent.
+  template <typename Resource, typename Load>
+  static std::shared_ptr<Resource const> Get(std::vector<std::string> const & paths, Load && load)
+  {
+    auto const resource = Get(typeid(Resource).name(), paths, [&load]() {
+      return std::shared_ptr<void const>(std::shared_ptr<Resource const>(load()));
+    });
+    return std::static_pointer_cast<Resource const>(resource);
+  }
+
+private:
+  static std::shared_ptr<void const> Get(char const * type, std::vector<std::string> const & paths,
+                                         std::function<std::shared_ptr<void const>()> const & load);
+};
+}  // namespace generator
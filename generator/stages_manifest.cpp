@@ -0,0 +1,275 @@
+#include "generator/stages_manifest.hpp"
+
+#include "coding/file_reader.hpp"
+#include "coding/internal/file_data.hpp"
+
+#include "platform/platform.hpp"
+
+#include "base/exception.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include <boost/crc.hpp>
+
+#include "3party/jansson/myjansson.hpp"
+
+namespace generator
+{
+namespace
+{
+// CRC-64/XZ.
+using Crc64 = boost::crc_optimal<64, 0x42F0E1EBA9EA3693, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+                                 true, true>;
+
+uint64_t ComputeHash(std::string const & path)
+{
+  size_t constexpr kBufferSize = 1 << 20;
+
+  Crc64 crc;
+  FileReader reader(path);
+  std::vector<char> buffer(kBufferSize);
+  uint64_t const size = reader.Size();
+  for (uint64_t pos = 0; pos < size; pos += kBufferSize)
+  {
+    auto const count = static_cast<size_t>(std::min<uint64_t>(kBufferSize, size - pos));
+    reader.Read(pos, buffer.data(), count);
+    crc.process_bytes(buffer.data(), count);
+  }
+  return crc.checksum();
+}
+
+std::string HashToString(uint64_t hash)
+{
+  std::ostringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return stream.str();
+}
+
+uint64_t HashFromString(std::string const & str)
+{
+  uint64_t hash = 0;
+  std::istringstream stream(str);
+  if (!(stream >> std::hex >> hash))
+    MYTHROW(base::Json::Exception, ("Incorrect hash", str));
+  return hash;
+}
+
+std::vector<std::string> GetNotEmpty(std::vector<std::string> const & paths)
+{
+  std::vector<std::string> result;
+  std::copy_if(paths.cbegin(), paths.cend(), std::back_inserter(result),
+               [](std::string const & path) { return !path.empty(); });
+  return result;
+}
+}  // namespace
+
+StagesManifest::StagesManifest(std::string const & filename) : m_filename(filename)
+{
+  if (!m_filename.empty())
+    Load();
+}
+
+bool StagesManifest::IsUpToDate(Stage const & stage)
+{
+  auto const it = std::find_if(m_stages.cbegin(), m_stages.cend(), [&](StageRecord const & r) {
+    return r.m_name == stage.m_name;
+  });
+  return it != m_stages.cend() && it->m_parameters == stage.m_parameters &&
+         IsUpToDate(stage.m_inputs, it->m_inputs) && IsUpToDate(stage.m_outputs, it->m_outputs);
+}
+
+bool StagesManifest::GetState(std::string const & path, FileState & state)
+{
+  struct stat fileStat{};
+  if (::stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    return false;
+
+  state.m_path = path;
+  state.m_size = static_cast<uint64_t>(fileStat.st_size);
+#if defined(__APPLE__)
+  auto const & time = fileStat.st_mtimespec;
+#else
+  auto const & time = fileStat.st_mtim;
+#endif
+  state.m_modificationTime = static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+
+  auto it = m_files.find(path);
+  if (it != m_files.end() && it->second.m_size == state.m_size &&
+      it->second.m_modificationTime == state.m_modificationTime)
+  {
+    state.m_hash = it->second.m_hash;
+    return true;
+  }
+
+  state.m_hash = ComputeHash(path);
+  m_files[path] = state;
+  return true;
+}
+
+std::vector<StagesManifest::FileState> StagesManifest::GetStates(
+    std::vector<std::string> const & paths)
+{
+  std::vector<FileState> states;
+  for (auto const & path : GetNotEmpty(paths))
+  {
+    FileState state;
+    if (GetState(path, state))
+      states.push_back(state);
+  }
+  return states;
+}
+
+bool StagesManifest::IsUpToDate(std::vector<std::string> const & paths,
+                                std::vector<FileState> const & states)
+{
+  // The absent files are skipped both here and in the record, so an optional file is compared
+  // only if it exists.
+  auto const current = GetStates(paths);
+  return std::equal(current.cbegin(), current.cend(), states.cbegin(), states.cend(),
+                    [](FileState const & lhs, FileState const & rhs) {
+                      return lhs.m_path == rhs.m_path && lhs.m_size == rhs.m_size &&
+                             lhs.m_hash == rhs.m_hash;
+                    });
+}
+
+void StagesManifest::Finish(Stage const & stage, std::vector<FileState> && inputs)
+{
+  StageRecord record;
+  record.m_name = stage.m_name;
+  record.m_parameters = stage.m_parameters;
+  record.m_inputs = std::move(inputs);
+  record.m_outputs = GetStates(stage.m_outputs);
+
+  // The files changed in place are the inputs of the rerun in their new state, and the stages
+  // which have written them are not outdated by the change.
+  for (auto const & output : record.m_outputs)
+  {
+    auto const isOutput = [&output](FileState const & state) {
+      return state.m_path == output.m_path;
+    };
+    std::replace_if(record.m_inputs.begin(), record.m_inputs.end(), isOutput, output);
+    for (auto & other : m_stages)
+      std::replace_if(other.m_outputs.begin(), other.m_outputs.end(), isOutput, output);
+  }
+
+  auto const it = std::find_if(m_stages.begin(), m_stages.end(), [&](StageRecord const & r) {
+    return r.m_name == stage.m_name;
+  });
+  if (it != m_stages.end())
+    *it = std::move(record);
+  else
+    m_stages.push_back(std::move(record));
+
+  try
+  {
+    Save();
+  }
+  catch (std::ios_base::failure const & e)
+  {
+    LOG(LERROR, ("Can't write stages manifest to", m_filename, e.what()));
+  }
+}
+
+void StagesManifest::Load()
+{
+  if (!Platform::IsFileExistsByFullPath(m_filename))
+    return;
+
+  auto const loadStates = [](json_t * root, char const * field) {
+    std::vector<FileState> states;
+    auto const array = base::GetJSONObligatoryField(root, field);
+    for (size_t i = 0; i < json_array_size(array); ++i)
+    {
+      auto const json = json_array_get(array, i);
+      FileState state;
+      FromJSONObject(json, "path", state.m_path);
+      FromJSONObject(json, "size", state.m_size);
+      FromJSONObject(json, "modification_time", state.m_modificationTime);
+      state.m_hash = HashFromString(FromJSONObject<std::string>(json, "hash"));
+      states.push_back(state);
+    }
+    return states;
+  };
+
+  try
+  {
+    std::ifstream stream(m_filename);
+    std::string const content{std::istreambuf_iterator<char>(stream),
+                              std::istreambuf_iterator<char>()};
+    auto const root = base::LoadFromString(content);
+    auto const stages = base::GetJSONObligatoryField(root.get(), "stages");
+    for (size_t i = 0; i < json_array_size(stages); ++i)
+    {
+      auto const json = json_array_get(stages, i);
+      StageRecord record;
+      FromJSONObject(json, "name", record.m_name);
+      FromJSONObject(json, "parameters", record.m_parameters);
+      record.m_inputs = loadStates(json, "inputs");
+      record.m_outputs = loadStates(json, "outputs");
+      m_stages.push_back(std::move(record));
+    }
+  }
+  catch (base::Json::Exception const & e)
+  {
+    LOG(LWARNING, ("Broken stages manifest", m_filename, e.Msg()));
+    m_stages.clear();
+  }
+
+  for (auto const & stage : m_stages)
+  {
+    for (auto const * states : {&stage.m_inputs, &stage.m_outputs})
+    {
+      for (auto const & state : *states)
+        m_files[state.m_path] = state;
+    }
+  }
+}
+
+void StagesManifest::Save() const
+{
+  auto const saveStates = [](std::vector<FileState> const & states) {
+    auto array = base::NewJSONArray();
+    for (auto const & state : states)
+    {
+      auto json = base::NewJSONObject();
+      ToJSONObject(*json, "path", state.m_path);
+      ToJSONObject(*json, "size", state.m_size);
+      ToJSONObject(*json, "modification_time", state.m_modificationTime);
+      ToJSONObject(*json, "hash", HashToString(state.m_hash));
+      ToJSONArray(*array, json);
+    }
+    return array;
+  };
+
+  auto stages = base::NewJSONArray();
+  for (auto const & stage : m_stages)
+  {
+    auto json = base::NewJSONObject();
+    ToJSONObject(*json, "name", stage.m_name);
+    ToJSONObject(*json, "parameters", stage.m_parameters);
+    ToJSONObject(*json, "inputs", saveStates(stage.m_inputs));
+    ToJSONObject(*json, "outputs", saveStates(stage.m_outputs));
+    ToJSONArray(*stages, json);
+  }
+
+  auto manifest = base::NewJSONObject();
+  ToJSONObject(*manifest, "stages", stages);
+
+  // The manifest is replaced at once, so it is not broken by a crash of the run.
+  auto const tmpFilename = m_filename + ".tmp";
+  {
+    std::ofstream stream;
+    stream.exceptions(std::ios::failbit | std::ios::badbit);
+    stream.open(tmpFilename);
+    stream << base::DumpToString(manifest, JSON_INDENT(2)) << std::endl;
+  }
+  if (!base::RenameFileX(tmpFilename, m_filename))
+    throw std::ios_base::failure("Can't rename " + tmpFilename + " to " + m_filename);
+}
+}  // namespace generator
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "base/logging.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace generator
+{
+// |StagesManifest| keeps the stages finished by the runs of generator_tool, so a rerun skips the
+// stages which are up to date. A stage is up to date if it has been finished with the same
+// parameters, its inputs have the same content as then and its outputs have not been changed
+// since then. The content of a file is compared by its hash, which is not computed again while
+// the size and the modification time of the file are the same.
+class StagesManifest
+{
+public:
+  struct Stage
+  {
+    std::string m_name;
+    // The options and anything else that changes the outputs of the stage.
+    std::string m_parameters;
+    // The empty paths and the absent files are ignored, so the optional files may be listed.
+    std::vector<std::string> m_inputs;
+    // An output may be an input too, if the stage changes it in place.
+    std::vector<std::string> m_outputs;
+  };
+
+  // The checkpointing is disabled if |filename| is empty. The manifest is empty if the file is
+  // absent or broken.
+  explicit StagesManifest(std::string const & filename);
+
+  // Runs |fn|, which returns true on success, unless |stage| is up to date. The successfully
+  // finished stage is saved to the manifest. Returns false if |fn| fails.
+  template <typename Fn>
+  bool Run(Stage const & stage, Fn && fn)
+  {
+    if (m_filename.empty())
+      return fn();
+
+    if (IsUpToDate(stage))
+    {
+      LOG(LINFO, ("Stage", stage.m_name, "is up to date, skipped."));
+      return true;
+    }
+
+    auto inputs = GetStates(stage.m_inputs);
+    if (!fn())
+      return false;
+
+    Finish(stage, std::move(inputs));
+    return true;
+  }
+
+  bool IsUpToDate(Stage const & stage);
+
+private:
+  struct FileState
+  {
+    std::string m_path;
+    uint64_t m_size = 0;
+    // Nanoseconds since the epoch.
+    int64_t m_modificationTime = 0;
+    uint64_t m_hash = 0;
+  };
+
+  struct StageRecord
+  {
+    std::string m_name;
+    std::string m_parameters;
+    std::vector<FileState> m_inputs;
+    std::vector<FileState> m_outputs;
+  };
+
+  // Returns false if the file is absent.
+  bool GetState(std::string const & path, FileState & state);
+  // The absent files are skipped.
+  std::vector<FileState> GetStates(std::vector<std::string> const & paths);
+  bool IsUpToDate(std::vector<std::string> const & paths, std::vector<FileState> const & states);
+
+  // Records |stage| with the states of its inputs before the stage and saves the manifest.
+  void Finish(Stage const & stage, std::vector<FileState> && inputs);
+
+  void Load();
+  // Throws std::ios_base::failure when the file can't be written.
+  void Save() const;
+
+  std::string m_filename;
+  std::vector<StageRecord> m_stages;
+  // The last known states of the files by the paths, which keep the hashes.
+  std::map<std::string, FileState> m_files;
+};
+}  // namespace generator
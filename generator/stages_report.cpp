@@ -0,0 +1,149 @@
+#include "generator/stages_report.hpp"
+
+#include "base/logging.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include <sys/resource.h>
+
+#include "3party/jansson/myjansson.hpp"
+
+namespace generator
+{
+namespace
+{
+double ToSeconds(timeval const & time)
+{
+  return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+}
+
+double GetCpuSeconds()
+{
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+  return ToSeconds(usage.ru_utime) + ToSeconds(usage.ru_stime);
+}
+
+uint64_t GetPeakRssBytes()
+{
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  // Kilobytes on Linux.
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Reads the rchar and wchar counters of /proc/self/io.
+void GetIoBytes(uint64_t & readBytes, uint64_t & writtenBytes)
+{
+  readBytes = 0;
+  writtenBytes = 0;
+  std::ifstream stream("/proc/self/io");
+  std::string key;
+  uint64_t value = 0;
+  while (stream >> key >> value)
+  {
+    if (key == "rchar:")
+      readBytes = value;
+    else if (key == "wchar:")
+      writtenBytes = value;
+  }
+}
+}  // namespace
+
+// StagesReport ------------------------------------------------------------------------------------
+// static
+StagesReport & StagesReport::Instance()
+{
+  static StagesReport report;
+  return report;
+}
+
+void StagesReport::Add(StageReport const & stage)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stages.push_back(stage);
+}
+
+std::vector<StageReport> StagesReport::GetStages() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stages;
+}
+
+void StagesReport::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stages.clear();
+}
+
+std::string StagesReport::ToJson() const
+{
+  auto stages = base::NewJSONArray();
+  for (auto const & stage : GetStages())
+  {
+    auto json = base::NewJSONObject();
+    ToJSONObject(*json, "name", stage.m_name);
+    ToJSONObject(*json, "start_seconds", stage.m_startSeconds);
+    ToJSONObject(*json, "wall_seconds", stage.m_wallSeconds);
+    ToJSONObject(*json, "cpu_seconds", stage.m_cpuSeconds);
+    ToJSONObject(*json, "peak_rss_bytes", stage.m_peakRssBytes);
+    ToJSONObject(*json, "read_bytes", stage.m_readBytes);
+    ToJSONObject(*json, "written_bytes", stage.m_writtenBytes);
+    auto memory = base::NewJSONArray();
+    for (auto const & usage : stage.m_memory)
+    {
+      auto tag = base::NewJSONObject();
+      ToJSONObject(*tag, "tag", usage.m_name);
+      ToJSONObject(*tag, "bytes", usage.m_bytes);
+      ToJSONObject(*tag, "peak_bytes", usage.m_peakBytes);
+      ToJSONArray(*memory, tag);
+    }
+    ToJSONObject(*json, "memory", memory);
+    ToJSONArray(*stages, json);
+  }
+
+  auto report = base::NewJSONObject();
+  ToJSONObject(*report, "wall_seconds", GetElapsedSeconds());
+  ToJSONObject(*report, "cpu_seconds", GetCpuSeconds());
+  ToJSONObject(*report, "peak_rss_bytes", GetPeakRssBytes());
+  ToJSONObject(*report, "stages", stages);
+  return base::DumpToString(report, JSON_INDENT(2));
+}
+
+void StagesReport::Save(std::string const & filename) const
+{
+  std::ofstream stream;
+  stream.exceptions(std::ios::failbit | std::ios::badbit);
+  stream.open(filename);
+  stream << ToJson() << std::endl;
+  LOG(LINFO, ("Stages report has been written in", filename));
+}
+
+// ScopedStage -------------------------------------------------------------------------------------
+ScopedStage::ScopedStage(std::string const & name) : m_zone(name)
+{
+  m_stage.m_name = name;
+  m_stage.m_startSeconds = StagesReport::Instance().GetElapsedSeconds();
+  m_startCpuSeconds = GetCpuSeconds();
+  GetIoBytes(m_startReadBytes, m_startWrittenBytes);
+}
+
+ScopedStage::~ScopedStage()
+{
+  m_stage.m_wallSeconds = m_timer.ElapsedSeconds();
+  m_stage.m_cpuSeconds = GetCpuSeconds() - m_startCpuSeconds;
+  m_stage.m_peakRssBytes = GetPeakRssBytes();
+  GetIoBytes(m_stage.m_readBytes, m_stage.m_writtenBytes);
+  m_stage.m_readBytes -= std::min(m_stage.m_readBytes, m_startReadBytes);
+  m_stage.m_writtenBytes -= std::min(m_stage.m_writtenBytes, m_startWrittenBytes);
+  m_stage.m_memory = base::memory::GetUsage();
+  StagesReport::Instance().Add(m_stage);
+}
+}  // namespace generator
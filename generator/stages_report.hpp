@@ -0,0 +1,75 @@
+#pragma once
+
+#include "base/memory_accounting.hpp"
+#include "base/prof.hpp"
+#include "base/timer.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+// Resources used by a stage of a generator_tool run.
+struct StageReport
+{
+  std::string m_name;
+  // Seconds since the report creation when the stage has started.
+  double m_startSeconds = 0.0;
+  double m_wallSeconds = 0.0;
+  // The cpu time of the whole process while the stage was running, so the cpu time
+  // of the stages running in parallel is counted several times.
+  double m_cpuSeconds = 0.0;
+  // The peak resident set size of the process at the end of the stage.
+  uint64_t m_peakRssBytes = 0;
+  // The bytes read and written by the process while the stage was running. The data read
+  // from the mapped files is not counted. Zero where the counters are not available.
+  uint64_t m_readBytes = 0;
+  uint64_t m_writtenBytes = 0;
+  // The bytes counted in the memory tags at the end of the stage and their peaks since
+  // the process start, see base/memory_accounting.hpp.
+  std::vector<base::memory::TagUsage> m_memory;
+};
+
+// The process-wide report of the stages, see ScopedStage. The stages are kept
+// in the order they have been finished.
+class StagesReport
+{
+public:
+  static StagesReport & Instance();
+
+  void Add(StageReport const & stage);
+  std::vector<StageReport> GetStages() const;
+  double GetElapsedSeconds() const { return m_timer.ElapsedSeconds(); }
+  void Clear();
+
+  std::string ToJson() const;
+  // Throws std::ios_base::failure when the file can't be written.
+  void Save(std::string const & filename) const;
+
+private:
+  StagesReport() = default;
+
+  base::Timer m_timer;
+  mutable std::mutex m_mutex;
+  std::vector<StageReport> m_stages;
+};
+
+// Measures the resources used from the construction to the destruction and adds
+// them to StagesReport::Instance(). The stage is a base::prof zone as well.
+class ScopedStage
+{
+public:
+  explicit ScopedStage(std::string const & name);
+  ~ScopedStage();
+
+private:
+  StageReport m_stage;
+  base::Timer m_timer;
+  double m_startCpuSeconds = 0.0;
+  uint64_t m_startReadBytes = 0;
+  uint64_t m_startWrittenBytes = 0;
+  base::prof::Zone m_zone;
+};
+}  // namespace generator
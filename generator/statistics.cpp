@@ -8,24 +8,37 @@
 #include "geometry/triangle2d.hpp"
 
 #include "base/logging.hpp"
+#include "base/macros.hpp"
 #include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 using namespace feature;
 using namespace std;
 
 namespace stats
 {
-  void FileContainerStatistic(string const & fPath)
+  namespace
+  {
+  template <class TMap>
+  void MergeMaps(TMap const & src, TMap & dest)
+  {
+    for (auto const & p : src)
+      dest[p.first].Merge(p.second);
+  }
+
+  void WriteContainerStatistic(string const & fPath, ostream & out)
   {
     try
     {
       FilesContainerR cont(fPath);
-      cont.ForEachTag([&cont] (FilesContainerR::Tag const & tag)
+      cont.ForEachTag([&cont, &out] (FilesContainerR::Tag const & tag)
       {
-        std::cout << std::setw(10) << tag << " : " << cont.GetReader(tag).Size() << endl;
+        out << std::setw(10) << tag << " : " << cont.GetReader(tag).Size() << endl;
       });
     }
     catch (Reader::Exception const & ex)
@@ -33,6 +46,37 @@ namespace stats
       LOG(LWARNING, ("Error reading file:", fPath, ex.Msg()));
     }
   }
+  }  // namespace
+
+  void MapInfo::Merge(MapInfo const & info)
+  {
+    MergeMaps(info.m_byGeomType, m_byGeomType);
+    MergeMaps(info.m_byClassifType, m_byClassifType);
+    MergeMaps(info.m_byPointsCount, m_byPointsCount);
+    MergeMaps(info.m_byTrgCount, m_byTrgCount);
+    MergeMaps(info.m_byAreaSize, m_byAreaSize);
+
+    for (size_t i = 0; i < ARRAY_SIZE(m_inner); ++i)
+      m_inner[i].Merge(info.m_inner[i]);
+  }
+
+  void FileContainerStatistic(string const & fPath)
+  {
+    WriteContainerStatistic(fPath, std::cout);
+  }
+
+  void FileContainerStatistic(vector<string> const & fPaths, unsigned int threadsCount)
+  {
+    vector<ostringstream> outs(fPaths.size());
+    {
+      base::thread_pool::computational::ThreadPool threadPool(max(threadsCount, 1u));
+      for (size_t i = 0; i < fPaths.size(); ++i)
+        threadPool.SubmitWork([&fPaths, &outs, i]() { WriteContainerStatistic(fPaths[i], outs[i]); });
+    }
+
+    for (size_t i = 0; i < fPaths.size(); ++i)
+      std::cout << fPaths[i] << endl << outs[i].str();
+  }
 
   // 0.001 deg² ≈ 12.392 km² * cos(lat)
   double arrAreas[] = { 10, 20, 50, 100, 200, 500, 1000, 360*360*12400 };
@@ -47,10 +91,8 @@ namespace stats
 
   class AccumulateStatistic
   {
-    MapInfo & m_info;
-
   public:
-    explicit AccumulateStatistic(MapInfo & info) : m_info(info) {}
+    MapInfo m_info;
 
     void operator() (FeatureType & f, uint32_t)
     {
@@ -110,8 +152,27 @@ namespace stats
 
   void CalcStatistic(std::string const & fPath, MapInfo & info)
   {
-    AccumulateStatistic doProcess(info);
+    AccumulateStatistic doProcess;
     feature::ForEachFromDat(fPath, doProcess);
+    info.Merge(doProcess.m_info);
+  }
+
+  void CalcStatistic(std::string const & fPath, MapInfo & info, unsigned int threadsCount)
+  {
+    for (auto const & doProcess :
+         feature::ForEachFromDatParallel(fPath, AccumulateStatistic(), threadsCount))
+    {
+      info.Merge(doProcess.m_info);
+    }
+  }
+
+  void CalcStatistic(vector<string> const & fPaths, MapInfo & info, unsigned int threadsCount)
+  {
+    for (auto const & doProcess :
+         feature::ForEachFromDats(fPaths, AccumulateStatistic(), threadsCount))
+    {
+      info.Merge(doProcess.m_info);
+    }
   }
 
   void PrintInfo(std::string const & prefix, GeneralInfo const & info, bool measurements)
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace stats
 {
@@ -25,6 +26,15 @@ namespace stats
       }
     }
 
+    void Merge(GeneralInfo const & info)
+    {
+      m_count += info.m_count;
+      m_size += info.m_size;
+      m_names += info.m_names;
+      m_length += info.m_length;
+      m_area += info.m_area;
+    }
+
     uint64_t m_count;
     uint64_t m_size;
     uint64_t m_names;
@@ -52,11 +62,22 @@ namespace stats
     std::map<AreaType, GeneralInfo> m_byAreaSize;
 
     GeneralInfo m_inner[3];
+
+    void Merge(MapInfo const & info);
   };
 
   void FileContainerStatistic(std::string const & fPath);
+  // Prints the statistic of |fPaths| in their order, |threadsCount| files are read concurrently.
+  void FileContainerStatistic(std::vector<std::string> const & fPaths, unsigned int threadsCount);
 
   void CalcStatistic(std::string const & fPath, MapInfo & info);
+  // Adds the statistic of |fPath| to |info|, the features are split between |threadsCount|
+  // threads.
+  void CalcStatistic(std::string const & fPath, MapInfo & info, unsigned int threadsCount);
+  // Adds the statistic of all |fPaths| to |info|, |threadsCount| files are processed
+  // concurrently.
+  void CalcStatistic(std::vector<std::string> const & fPaths, MapInfo & info,
+                     unsigned int threadsCount);
   void PrintStatistic(MapInfo & info);
   void PrintTypeStatistic(MapInfo & info);
 }
@@ -9,6 +9,7 @@
 #include "base/exception.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <utility>
 
 #include <boost/geometry.hpp>
@@ -86,44 +87,64 @@ void StreetGeometry::AddBinding(base::GeoObjectId const & osmId, m2::PointD cons
 
 // HighwayGeometry -------------------------------------------------------------------------------------------
 
-Pin HighwayGeometry::ChoosePin() const
+namespace
 {
-  if (!m_areaParts.empty())
-    return ChooseAreaPin();
+int64_t GetCellCoord(double coord)
+{
+  return static_cast<int64_t>(std::floor(coord / HighwayGeometry::kCoordEqualityEps));
+}
 
-  return ChooseMultilinePin();
+uint64_t GetCellKey(int64_t x, int64_t y)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
 }
 
-m2::RectD const & HighwayGeometry::GetBbox() const
+// The points which are equal with kCoordEqualityEps lie in the same or in the adjacent cells.
+uint64_t GetCellKey(m2::PointD const & point)
 {
-  return m_limitRect;
+  return GetCellKey(GetCellCoord(point.x), GetCellCoord(point.y));
 }
 
-std::vector<HighwayGeometry::AreaPart> const & HighwayGeometry::GetAreaParts() const
+bool IsEqual(m2::PointD const & lhs, m2::PointD const & rhs)
 {
-  return m_areaParts;
+  return AlmostEqualAbs(lhs, rhs, HighwayGeometry::kCoordEqualityEps);
 }
+}  // namespace
 
-HighwayGeometry::MultiLine const & HighwayGeometry::GetMultiLine() const
+// static
+constexpr double HighwayGeometry::kCoordEqualityEps;
+HighwayGeometry::Index constexpr HighwayGeometry::kInvalidIndex;
+
+Pin HighwayGeometry::ChoosePin() const
 {
-  return m_multiLine;
+  if (!m_areaParts.empty())
+    return ChooseAreaPin();
+
+  return ChooseMultilinePin();
+}
+
+m2::RectD const & HighwayGeometry::GetBbox() const
+{
+  return m_limitRect;
 }
 
 Pin HighwayGeometry::ChooseMultilinePin() const
 {
-  auto const & lines = m_multiLine.m_lines;
-  CHECK(!lines.empty(), ());
-  auto longestLine = lines.cbegin();
-  auto longestLineLength = longestLine->CalculateLength();
-  for (auto l = std::next(longestLine), end = lines.cend(); l != end; ++l)
+  Line const * longestLine = nullptr;
+  double longestLineLength = 0.0;
+  for (auto const & line : m_lines)
   {
-    auto const length = l->CalculateLength();
-    if (longestLineLength < length)
+    if (line.IsEmpty())
+      continue;
+
+    auto const length = CalculateLength(line);
+    if (!longestLine || longestLineLength < length)
     {
-      longestLine = l;
+      longestLine = &line;
       longestLineLength = length;
     }
   }
+  CHECK(longestLine, ());
 
   return ChooseLinePin(*longestLine, longestLineLength / 2);
 }
@@ -132,14 +153,15 @@ Pin HighwayGeometry::ChooseLinePin(Line const & line, double disposeDistance) co
 {
   double length = 0.0;
 
-  for (auto const & segment : line.m_segments)
+  for (auto i = line.m_first; i != kInvalidIndex; i = m_segments[i].m_next)
   {
-    auto const & points = segment.m_points;
-    CHECK_GREATER_OR_EQUAL(points.size(), 2, ());
-    for (auto p = points.cbegin(), end = std::prev(points.cend()); p != end; ++p)
+    auto const & segment = m_segments[i];
+    auto const * points = GetPoints(segment.m_points);
+    CHECK_GREATER_OR_EQUAL(segment.m_points.m_size, 2, ());
+    for (size_t j = 0; j + 1 < segment.m_points.m_size; ++j)
     {
-      auto const & p1 = *p;
-      auto const & p2 = *std::next(p);
+      auto const & p1 = points[j];
+      auto const & p2 = points[j + 1];
       length += MercatorBounds::DistanceOnEarth(p1, p2);
       if (disposeDistance < length)
         return {p1.Mid(p2), segment.m_osmId};
@@ -157,199 +179,318 @@ Pin HighwayGeometry::ChooseAreaPin() const
   return {largestPart->m_center, largestPart->m_osmId};
 }
 
+double HighwayGeometry::CalculateLength(Line const & line) const
+{
+  double length = 0.0;
+  for (auto i = line.m_first; i != kInvalidIndex; i = m_segments[i].m_next)
+    length += CalculateLength(m_segments[i]);
+  return length;
+}
+
+double HighwayGeometry::CalculateLength(LineSegment const & segment) const
+{
+  return MercatorBounds::PolylineLengthOnEarth(GetPoints(segment.m_points),
+                                               segment.m_points.m_size);
+}
+
 void HighwayGeometry::AddLine(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & line)
 {
-  m_multiLine.Add({osmId, line});
+  CHECK_GREATER_OR_EQUAL(line.size(), 2, ());
+
+  auto const segment = static_cast<Index>(m_segments.size());
+  m_segments.push_back({osmId, AddPoints(line)});
   ExtendLimitRect(line);
+
+  auto const lineToAdd = FindLineToAdd(segment);
+  if (lineToAdd == kInvalidIndex)
+  {
+    m_lines.push_back({segment, segment});
+    AddLineEnds(static_cast<Index>(m_lines.size() - 1));
+    return;
+  }
+
+  RemoveLineEnds(lineToAdd);
+  CHECK(Add(lineToAdd, segment), ());
+
+  auto const lineToConcatenate = FindLineToConcatenate(lineToAdd);
+  if (lineToConcatenate == kInvalidIndex)
+  {
+    AddLineEnds(lineToAdd);
+    return;
+  }
+
+  RemoveLineEnds(lineToConcatenate);
+  CHECK(Concatenate(lineToConcatenate, lineToAdd), ());
+  AddLineEnds(lineToConcatenate);
 }
 
 void HighwayGeometry::AddArea(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & border)
 {
-  m_areaParts.emplace_back(osmId, border);
+  CHECK_GREATER_OR_EQUAL(border.size(), 3, ());
+
+  auto boostPolygon = boost_helpers::BoostPolygon{};
+  for (auto const & p : border)
+    boost::geometry::append(boostPolygon, boost_helpers::BoostPoint{p.x, p.y});
+  boost::geometry::correct(boostPolygon);
+
+  boost_helpers::BoostPoint center{};
+  boost::geometry::centroid(boostPolygon, center);
+
+  m_areaParts.push_back({osmId, AddPoints(border), {center.get<0>(), center.get<1>()},
+                         boost::geometry::area(boostPolygon)});
   ExtendLimitRect(border);
 }
 
+HighwayGeometry::PointsRange HighwayGeometry::AddPoints(std::vector<m2::PointD> const & points)
+{
+  CHECK_LESS_OR_EQUAL(m_points.size() + points.size(), kInvalidIndex, ());
+  PointsRange const range{static_cast<Index>(m_points.size()), static_cast<Index>(points.size())};
+  m_points.insert(m_points.end(), points.begin(), points.end());
+  return range;
+}
+
 void HighwayGeometry::ExtendLimitRect(std::vector<m2::PointD> const & points)
 {
   feature::CalcRect(points, m_limitRect);
 }
 
-// HighwayGeometry::MultiLine --------------------------------------------------------------------------------
+m2::PointD const & HighwayGeometry::GetFront(LineSegment const & segment) const
+{
+  return m_points[segment.m_points.m_offset];
+}
+
+m2::PointD const & HighwayGeometry::GetBack(LineSegment const & segment) const
+{
+  return m_points[segment.m_points.m_offset + segment.m_points.m_size - 1];
+}
+
+m2::PointD const & HighwayGeometry::GetFront(Line const & line) const
+{
+  CHECK(!line.IsEmpty(), ());
+  return GetFront(m_segments[line.m_first]);
+}
 
-void HighwayGeometry::MultiLine::Add(LineSegment && segment)
+m2::PointD const & HighwayGeometry::GetBack(Line const & line) const
 {
-  for (auto line = m_lines.begin(), end = m_lines.end(); line != end; ++line)
+  CHECK(!line.IsEmpty(), ());
+  return GetBack(m_segments[line.m_last]);
+}
+
+std::vector<HighwayGeometry::Index> HighwayGeometry::FindLinesNear(m2::PointD const & point) const
+{
+  std::vector<Index> lines;
+  auto const x = GetCellCoord(point.x);
+  auto const y = GetCellCoord(point.y);
+  for (auto dx = -1; dx <= 1; ++dx)
   {
-    if (line->Add(std::move(segment)))
+    for (auto dy = -1; dy <= 1; ++dy)
     {
-      if (Recombine(std::move(*line)))
-        m_lines.erase(line);
-      return;
+      auto const range = m_lineEnds.equal_range(GetCellKey(x + dx, y + dy));
+      for (auto it = range.first; it != range.second; ++it)
+        lines.push_back(it->second);
     }
   }
 
-  m_lines.emplace_back(Line{{std::move(segment)}});
+  base::SortUnique(lines);
+  return lines;
 }
 
-bool HighwayGeometry::MultiLine::Recombine(Line && line)
+HighwayGeometry::Index HighwayGeometry::FindLineToAdd(Index segment) const
 {
-  for (auto & l : m_lines)
+  auto const & s = m_segments[segment];
+  auto lines = FindLinesNear(GetFront(s));
+  auto const backLines = FindLinesNear(GetBack(s));
+  lines.insert(lines.end(), backLines.begin(), backLines.end());
+  base::SortUnique(lines);
+
+  for (auto const index : lines)
   {
-    if (l.Concatenate(std::move(line)))
-      return true;
+    auto const & line = m_lines[index];
+    // Ignore self-addition.
+    if (m_segments[line.m_first].m_osmId == s.m_osmId ||
+        m_segments[line.m_last].m_osmId == s.m_osmId)
+    {
+      continue;
+    }
+
+    auto const & lineFront = GetFront(line);
+    auto const & lineBack = GetBack(line);
+    if (IsEqual(lineBack, GetFront(s)) || IsEqual(lineBack, GetBack(s)) ||
+        IsEqual(lineFront, GetBack(s)) || IsEqual(lineFront, GetFront(s)))
+    {
+      return index;
+    }
   }
 
-  return false;
+  return kInvalidIndex;
 }
 
-// HighwayGeometry::Line -------------------------------------------------------------------------------------
+HighwayGeometry::Index HighwayGeometry::FindLineToConcatenate(Index line) const
+{
+  auto const & front = GetFront(m_lines[line]);
+  auto const & back = GetBack(m_lines[line]);
+  auto lines = FindLinesNear(front);
+  auto const backLines = FindLinesNear(back);
+  lines.insert(lines.end(), backLines.begin(), backLines.end());
+  base::SortUnique(lines);
 
-bool HighwayGeometry::Line::Concatenate(Line && other)
+  for (auto const index : lines)
+  {
+    // Ignore self-addition.
+    if (index == line)
+      continue;
+
+    auto const & otherFront = GetFront(m_lines[index]);
+    auto const & otherBack = GetBack(m_lines[index]);
+    if (IsEqual(otherBack, front) || IsEqual(otherFront, back) || IsEqual(otherFront, front) ||
+        IsEqual(otherBack, back))
+    {
+      return index;
+    }
+  }
+
+  return kInvalidIndex;
+}
+
+bool HighwayGeometry::Add(Index lineIndex, Index segmentIndex)
 {
-  // Ignore self-addition.
-  if (&other == this)
-    return false;
+  auto & line = m_lines[lineIndex];
+  auto & segment = m_segments[segmentIndex];
 
-  CHECK(!m_segments.empty(), ());
-  CHECK(!m_segments.front().m_points.empty() && !m_segments.back().m_points.empty(), ());
-  auto const & thisStart = m_segments.front().m_points.front();
-  auto const & thisEnd = m_segments.back().m_points.back();
+  auto const append = [&]() {
+    segment.m_prev = line.m_last;
+    m_segments[line.m_last].m_next = segmentIndex;
+    line.m_last = segmentIndex;
+  };
+  auto const prepend = [&]() {
+    segment.m_next = line.m_first;
+    m_segments[line.m_first].m_prev = segmentIndex;
+    line.m_first = segmentIndex;
+  };
 
-  CHECK(!other.m_segments.empty(), ());
-  CHECK(!other.m_segments.front().m_points.empty() && !other.m_segments.back().m_points.empty(), ());
-  auto const & otherStart = other.m_segments.front().m_points.front();
-  auto const & otherEnd = other.m_segments.back().m_points.back();
+  auto const & lineFront = GetFront(line);
+  auto const & lineBack = GetBack(line);
 
-  if (AlmostEqualAbs(thisEnd, otherStart, kCoordEqualityEps))
+  if (IsEqual(lineBack, GetFront(segment)))
   {
-    m_segments.splice(m_segments.end(), std::move(other.m_segments));
+    append();
     return true;
   }
 
-  if (AlmostEqualAbs(thisStart, otherEnd, kCoordEqualityEps))
+  if (IsEqual(lineBack, GetBack(segment)))
   {
-    m_segments.splice(m_segments.begin(), std::move(other.m_segments));
+    Reverse(segmentIndex);
+    append();
     return true;
   }
 
-  if (AlmostEqualAbs(thisStart, otherStart, kCoordEqualityEps))
+  if (IsEqual(lineFront, GetBack(segment)))
   {
-    other.Reverse();
-    m_segments.splice(m_segments.begin(), std::move(other.m_segments));
+    prepend();
     return true;
   }
 
-  if (AlmostEqualAbs(thisEnd, otherEnd, kCoordEqualityEps))
+  if (IsEqual(lineFront, GetFront(segment)))
   {
-    other.Reverse();
-    m_segments.splice(m_segments.end(), std::move(other.m_segments));
+    Reverse(segmentIndex);
+    prepend();
     return true;
   }
 
   return false;
 }
 
-void HighwayGeometry::Line::Reverse()
-{
-  for (auto & segment : m_segments)
-    std::reverse(segment.m_points.begin(), segment.m_points.end());
-  std::reverse(m_segments.begin(), m_segments.end());
-}
-
-bool HighwayGeometry::Line::Add(LineSegment && segment)
-{
-  CHECK(!m_segments.empty(), ());
-  auto const & startSegment = m_segments.front();
-  auto const & endSegment = m_segments.back();
-  CHECK(!startSegment.m_points.empty(), ());
-  auto const & lineStart = startSegment.m_points.front();
-  CHECK(!endSegment.m_points.empty(), ());
-  auto const & lineEnd = endSegment.m_points.back();
-
-  // Ignore self-addition.
-  if (startSegment.m_osmId == segment.m_osmId || endSegment.m_osmId == segment.m_osmId)
-    return false;
-
-  CHECK(!segment.m_points.empty(), ());
-  auto const & segmentStart = segment.m_points.front();
-  auto const & segmentEnd = segment.m_points.back();
-
-  if (AlmostEqualAbs(lineEnd, segmentStart, kCoordEqualityEps))
+bool HighwayGeometry::Concatenate(Index lineIndex, Index otherIndex)
+{
+  auto & line = m_lines[lineIndex];
+  auto & other = m_lines[otherIndex];
+
+  auto const append = [&]() {
+    m_segments[line.m_last].m_next = other.m_first;
+    m_segments[other.m_first].m_prev = line.m_last;
+    line.m_last = other.m_last;
+    other = {};
+  };
+  auto const prepend = [&]() {
+    m_segments[other.m_last].m_next = line.m_first;
+    m_segments[line.m_first].m_prev = other.m_last;
+    line.m_first = other.m_first;
+    other = {};
+  };
+
+  auto const & lineFront = GetFront(line);
+  auto const & lineBack = GetBack(line);
+  auto const & otherFront = GetFront(other);
+  auto const & otherBack = GetBack(other);
+
+  if (IsEqual(lineBack, otherFront))
   {
-    m_segments.push_back(std::move(segment));
+    append();
     return true;
   }
 
-  if (AlmostEqualAbs(lineEnd, segmentEnd, kCoordEqualityEps))
+  if (IsEqual(lineFront, otherBack))
   {
-    std::reverse(segment.m_points.begin(), segment.m_points.end());
-    m_segments.push_back(std::move(segment));
+    prepend();
     return true;
   }
 
-  if (AlmostEqualAbs(lineStart, segmentEnd, kCoordEqualityEps))
+  if (IsEqual(lineFront, otherFront))
   {
-    m_segments.push_front(std::move(segment));
+    Reverse(other);
+    prepend();
     return true;
   }
 
-  if (AlmostEqualAbs(lineStart, segmentStart, kCoordEqualityEps))
+  if (IsEqual(lineBack, otherBack))
   {
-    std::reverse(segment.m_points.begin(), segment.m_points.end());
-    m_segments.push_front(std::move(segment));
+    Reverse(other);
+    append();
     return true;
   }
 
   return false;
 }
 
-double HighwayGeometry::Line::CalculateLength() const noexcept
+void HighwayGeometry::Reverse(Index segmentIndex)
 {
-  double length = 0.0;
-  for (auto const & segment : m_segments)
-    length += segment.CalculateLength();
-  return length;
+  auto const & range = m_segments[segmentIndex].m_points;
+  auto const begin = m_points.begin() + range.m_offset;
+  std::reverse(begin, begin + range.m_size);
 }
 
-// HighwayGeometry::LineSegment ------------------------------------------------------------------------------
-
-HighwayGeometry::LineSegment::LineSegment(base::GeoObjectId const & osmId,
-                                          std::vector<m2::PointD> const & points)
-  : m_osmId{osmId}, m_points{points}
+void HighwayGeometry::Reverse(Line & line)
 {
-  CHECK_GREATER_OR_EQUAL(m_points.size(), 2, ());
+  for (auto i = line.m_first; i != kInvalidIndex;)
+  {
+    auto & segment = m_segments[i];
+    auto const next = segment.m_next;
+    Reverse(i);
+    std::swap(segment.m_prev, segment.m_next);
+    i = next;
+  }
+  std::swap(line.m_first, line.m_last);
 }
 
-double HighwayGeometry::LineSegment::CalculateLength() const noexcept
+void HighwayGeometry::AddLineEnds(Index line)
 {
-  if (m_points.size() < 2)
-    return 0.0;
-
-  double length = 0.0;
-  for (auto p1 = m_points.cbegin(), p2 = std::next(p1); p2 != m_points.cend(); p1 = p2, ++p2)
-    length += MercatorBounds::DistanceOnEarth(*p1, *p2);
-
-  return length;
+  m_lineEnds.emplace(GetCellKey(GetFront(m_lines[line])), line);
+  m_lineEnds.emplace(GetCellKey(GetBack(m_lines[line])), line);
 }
 
-// HighwayGeometry::AreaPart ---------------------------------------------------------------------------------
-
-HighwayGeometry::AreaPart::AreaPart(base::GeoObjectId const & osmId,
-                                    std::vector<m2::PointD> const & border)
-  : m_osmId{osmId}, m_border{border}
+void HighwayGeometry::RemoveLineEnds(Index line)
 {
-  CHECK_GREATER_OR_EQUAL(border.size(), 3, ());
-
-  auto boostPolygon = boost_helpers::BoostPolygon{};
-  for (auto const & p : border)
-    boost::geometry::append(boostPolygon, boost_helpers::BoostPoint{p.x, p.y});
-  boost::geometry::correct(boostPolygon);
-
-  boost_helpers::BoostPoint center{};
-  boost::geometry::centroid(boostPolygon, center);
-  m_center = {center.get<0>(), center.get<1>()};
+  RemoveLineEnd(GetFront(m_lines[line]), line);
+  RemoveLineEnd(GetBack(m_lines[line]), line);
+}
 
-  m_area = boost::geometry::area(boostPolygon);
+void HighwayGeometry::RemoveLineEnd(m2::PointD const & point, Index line)
+{
+  auto const range = m_lineEnds.equal_range(GetCellKey(point));
+  auto const it = std::find_if(range.first, range.second,
+                               [line](auto const & item) { return item.second == line; });
+  CHECK(it != range.second, ());
+  m_lineEnds.erase(it);
 }
 
 // BindingsGeometry ------------------------------------------------------------------------------------------
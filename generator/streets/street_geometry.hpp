@@ -5,8 +5,10 @@
 
 #include "base/geo_object_id.hpp"
 
-#include <list>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -48,69 +50,121 @@ private:
   std::unique_ptr<BindingsGeometry> m_bindingsGeometry;
 };
 
+// The lines and the areas of a street. The points of all the parts are stored in one buffer and
+// the parts refer to their ranges in it. The line segments are linked into the lines by their
+// indices, the ends of the lines are hashed by the cells of the coordinates equality precision,
+// so a segment is joined to a line without the walk over all the lines.
 class HighwayGeometry
 {
 public:
-  struct LineSegment
+  static constexpr double kCoordEqualityEps = 1e-5;
+
+  Pin ChoosePin() const;
+  m2::RectD const & GetBbox() const;
+
+  void AddLine(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & line);
+  void AddArea(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & border);
+
+  // Calls |toDo(osmId, points, pointsCount)| for the borders of the areas.
+  template <typename ToDo>
+  void ForEachAreaBorder(ToDo && toDo) const
+  {
+    for (auto const & part : m_areaParts)
+      toDo(part.m_osmId, GetPoints(part.m_border), part.m_border.m_size);
+  }
+
+  // Calls |toDo(osmId, points, pointsCount)| for the segments of all the lines. The segments
+  // of a line go in the order of the line, their points are directed along the line.
+  template <typename ToDo>
+  void ForEachLineSegment(ToDo && toDo) const
   {
-    LineSegment(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & points);
+    for (auto const & line : m_lines)
+    {
+      for (auto i = line.m_first; i != kInvalidIndex; i = m_segments[i].m_next)
+      {
+        auto const & segment = m_segments[i];
+        toDo(segment.m_osmId, GetPoints(segment.m_points), segment.m_points.m_size);
+      }
+    }
+  }
 
-    double CalculateLength() const noexcept;
+private:
+  using Index = uint32_t;
 
-    base::GeoObjectId m_osmId;
-    std::vector<m2::PointD> m_points;
+  static Index constexpr kInvalidIndex = std::numeric_limits<Index>::max();
+
+  // The range of the points in |m_points|.
+  struct PointsRange
+  {
+    Index m_offset;
+    Index m_size;
   };
 
-  struct Line
+  struct LineSegment
   {
-    static constexpr double kCoordEqualityEps = 1e-5;
-
-    // Try to append |line| to front or to back of |this| line.
-    bool Concatenate(Line && other);
-    void Reverse();
-    // The function does not check addition of line segment to ring line.
-    // Line configuration depends on addition sequences.
-    // |segment| will not modify if the function returns false.
-    bool Add(LineSegment && segment);
-    double CalculateLength() const noexcept;
-
-    std::list<LineSegment> m_segments;
+    base::GeoObjectId m_osmId;
+    PointsRange m_points;
+    // The adjacent segments of the line.
+    Index m_prev = kInvalidIndex;
+    Index m_next = kInvalidIndex;
   };
 
-  struct MultiLine
+  // The segments from |m_first| to |m_last|. The line which is concatenated to another one is
+  // left empty, so the indices of the lines do not change and keep the order of their creation.
+  struct Line
   {
-    void Add(LineSegment && lineSegment);
-    // This function tries to concatenate whole |line| to another line in this multiline.
-    bool Recombine(Line && line);
+    bool IsEmpty() const { return m_first == kInvalidIndex; }
 
-    std::list<Line> m_lines;
+    Index m_first = kInvalidIndex;
+    Index m_last = kInvalidIndex;
   };
 
   struct AreaPart
   {
-    AreaPart(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & border);
-
     base::GeoObjectId m_osmId;
-    std::vector<m2::PointD> m_border;
+    PointsRange m_border;
     m2::PointD m_center;
     double m_area;
   };
 
-  Pin ChoosePin() const;
-  m2::RectD const & GetBbox() const;
-  std::vector<AreaPart> const & GetAreaParts() const;
-  MultiLine const & GetMultiLine() const;
+  m2::PointD const * GetPoints(PointsRange const & range) const { return &m_points[range.m_offset]; }
+  PointsRange AddPoints(std::vector<m2::PointD> const & points);
 
-  void AddLine(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & line);
-  void AddArea(base::GeoObjectId const & osmId, std::vector<m2::PointD> const & border);
+  m2::PointD const & GetFront(LineSegment const & segment) const;
+  m2::PointD const & GetBack(LineSegment const & segment) const;
+  m2::PointD const & GetFront(Line const & line) const;
+  m2::PointD const & GetBack(Line const & line) const;
 
-private:
   Pin ChooseMultilinePin() const;
   Pin ChooseLinePin(Line const & line, double disposeDistance) const;
   Pin ChooseAreaPin() const;
+  double CalculateLength(Line const & line) const;
+  double CalculateLength(LineSegment const & segment) const;
   void ExtendLimitRect(std::vector<m2::PointD> const & points);
 
-  MultiLine m_multiLine; // TODO: cyclic graph
+  // The lines whose ends may be equal to |point|, in the order of the lines.
+  std::vector<Index> FindLinesNear(m2::PointD const & point) const;
+  // The first line which |segment| may be added to, see Add().
+  Index FindLineToAdd(Index segment) const;
+  // The first line which |line| may be concatenated to, see Concatenate().
+  Index FindLineToConcatenate(Index line) const;
+  // Tries to add |segment| to the front or to the back of |line|. The function does not check
+  // addition of the segment to a ring line, the line configuration depends on the addition
+  // sequences.
+  bool Add(Index line, Index segment);
+  // Tries to append |other| line to the front or to the back of |line|.
+  bool Concatenate(Index line, Index other);
+  void Reverse(Index segment);
+  void Reverse(Line & line);
+  void AddLineEnds(Index line);
+  void RemoveLineEnds(Index line);
+  void RemoveLineEnd(m2::PointD const & point, Index line);
+
+  std::vector<m2::PointD> m_points;
+  std::vector<LineSegment> m_segments;
+  std::vector<Line> m_lines;
+  // The lines by the cells of their ends.
+  std::unordered_multimap<uint64_t, Index> m_lineEnds;
   std::vector<AreaPart> m_areaParts;
   m2::RectD m_limitRect;
 };
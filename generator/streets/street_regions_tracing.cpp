@@ -12,10 +12,33 @@ namespace streets
 {
 constexpr m2::Meter const StreetRegionsTracing::kRegionCheckStepDistance;
 constexpr m2::Meter const StreetRegionsTracing::kRegionBoundarySearchStepDistance;
+constexpr m2::Meter const StreetRegionsTracing::kBorderCrossingStepDistance;
 
 StreetRegionsTracing::StreetRegionsTracing(Path const & path,
                                            StreetRegionInfoGetter const & streetRegionInfoGetter)
   : m_path{path}, m_streetRegionInfoGetter{streetRegionInfoGetter}
+{
+  Start();
+  Trace();
+}
+
+StreetRegionsTracing::StreetRegionsTracing(
+    Path const & path, StreetRegionInfoGetter const & streetRegionInfoGetter,
+    StreetRegionBorderCrossingFinder const & borderCrossingFinder)
+  : m_path{path}
+  , m_streetRegionInfoGetter{streetRegionInfoGetter}
+  , m_borderCrossingFinder{borderCrossingFinder}
+{
+  Start();
+  TraceByBorderCrossings();
+}
+
+StreetRegionsTracing::PathSegments && StreetRegionsTracing::StealPathSegments()
+{
+  return std::move(m_pathSegments);
+}
+
+void StreetRegionsTracing::Start()
 {
   CHECK_GREATER_OR_EQUAL(m_path.size(), 2, ());
 
@@ -25,13 +48,6 @@ StreetRegionsTracing::StreetRegionsTracing(Path const & path,
   m_currentRegion = m_streetRegionInfoGetter(m_currentPoint);
   if (m_currentRegion)
     StartNewSegment();
-
-  Trace();
-}
-
-StreetRegionsTracing::PathSegments && StreetRegionsTracing::StealPathSegments()
-{
-  return std::move(m_pathSegments);
 }
 
 void StreetRegionsTracing::Trace()
@@ -61,6 +77,49 @@ bool StreetRegionsTracing::TraceToNextCheckPointInCurrentRegion()
   return true;
 }
 
+void StreetRegionsTracing::TraceByBorderCrossings()
+{
+  CHECK(m_borderCrossingFinder, ());
+
+  while (m_nextPathPoint != m_path.end())
+    TraceToNextBorderCrossing();
+
+  if (m_currentRegion)
+    ReleaseCurrentSegment();
+}
+
+void StreetRegionsTracing::TraceToNextBorderCrossing()
+{
+  auto const nextPoint = *m_nextPathPoint;
+  auto const distanceToNextPoint = Meter{MercatorBounds::DistanceOnEarth(m_currentPoint, nextPoint)};
+  auto const crossing = m_borderCrossingFinder(m_currentPoint, nextPoint);
+  if (!crossing)
+  {
+    AdvanceTo(nextPoint, distanceToNextPoint, std::next(m_nextPathPoint));
+    return;
+  }
+
+  auto const crossingPoint = m_currentPoint + (nextPoint - m_currentPoint) * *crossing;
+  if (crossingPoint == nextPoint)
+    AdvanceTo(nextPoint, distanceToNextPoint, std::next(m_nextPathPoint));
+  else
+    AdvanceTo(crossingPoint, distanceToNextPoint * *crossing, m_nextPathPoint);
+
+  // A point on a border may belong to both regions, so the new region is looked up past the
+  // crossing. The step also moves the walk away from the crossed border, it goes to the next
+  // path segment when the border passes through a path point.
+  Meter probeDistance{};
+  auto probeNextPathPoint = m_nextPathPoint;
+  auto const probePoint = FollowToNextPoint(m_currentPoint, kBorderCrossingStepDistance,
+                                            m_nextPathPoint, probeDistance, probeNextPathPoint);
+
+  auto const probePointRegion = m_streetRegionInfoGetter(probePoint);
+  if (IsSameRegion(probePointRegion))
+    AdvanceTo(probePoint, probeDistance, probeNextPathPoint);
+  else
+    AdvanceToBoundary(probePointRegion, probePoint, probeDistance, probeNextPathPoint);
+}
+
 void StreetRegionsTracing::TraceUpToNextRegion()
 {
   while (m_nextPathPoint != m_path.end())
@@ -19,10 +19,16 @@ class StreetRegionsTracing final
 public:
   using Meter = m2::Meter;
   using StreetRegionInfoGetter = std::function<boost::optional<KeyValue>(m2::PointD const & pathPoint)>;
+  // Returns the position of the first point of the segment [|from|, |to|] where the region
+  // of the points may change, as the part of the segment length in (0, 1].
+  using StreetRegionBorderCrossingFinder =
+      std::function<boost::optional<double>(m2::PointD const & from, m2::PointD const & to)>;
   using Path = std::vector<m2::PointD>;
 
   constexpr static auto const kRegionCheckStepDistance = 100.0_m;
   constexpr static auto const kRegionBoundarySearchStepDistance = 10.0_m;
+  // The region of a border crossing is looked up at this distance past the crossing.
+  constexpr static auto const kBorderCrossingStepDistance = 0.1_m;
 
   struct Segment
   {
@@ -34,11 +40,18 @@ public:
   using PathSegments = std::vector<Segment>;
 
   StreetRegionsTracing(Path const & path, StreetRegionInfoGetter const & streetRegionInfoGetter);
+  // Walks the path from a border crossing to the next one, so the region is looked up at the
+  // crossings only rather than at the check points of the path.
+  StreetRegionsTracing(Path const & path, StreetRegionInfoGetter const & streetRegionInfoGetter,
+                       StreetRegionBorderCrossingFinder const & borderCrossingFinder);
 
   PathSegments && StealPathSegments();
 
 private:
+  void Start();
   void Trace();
+  void TraceByBorderCrossings();
+  void TraceToNextBorderCrossing();
   bool TraceToNextCheckPointInCurrentRegion();
   void TraceUpToNextRegion();
   void AdvanceTo(m2::PointD const toPoint, Meter distance, Path::const_iterator nextPathPoint);
@@ -53,6 +66,7 @@ private:
 
   Path const & m_path;
   StreetRegionInfoGetter const & m_streetRegionInfoGetter;
+  StreetRegionBorderCrossingFinder m_borderCrossingFinder;
   m2::PointD m_currentPoint;
   Path::const_iterator m_nextPathPoint;
   boost::optional<KeyValue> m_currentRegion;
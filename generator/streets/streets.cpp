@@ -1,12 +1,15 @@
 #include "generator/streets/streets.hpp"
 
 #include "generator/regions/region_info_getter.hpp"
+#include "generator/stages_report.hpp"
 #include "generator/streets/streets_builder.hpp"
 
 #include "base/logging.hpp"
 #include "base/scope_guard.hpp"
 #include "base/timer.hpp"
 
+#include <fstream>
+
 
 namespace generator
 {
@@ -16,21 +19,35 @@ void GenerateStreets(std::string const & pathInRegionsIndex, std::string const &
                      std::string const & pathInStreetsTmpMwm,
                      std::string const & pathInGeoObjectsTmpMwm,
                      std::string const & pathOutStreetsKv,
-                     bool /*verbose*/, unsigned int threadsCount)
+                     bool /*verbose*/, unsigned int threadsCount,
+                     std::string const & pathOutStreetsHierarchy)
 {
   LOG(LINFO, ("Start generating streets..."));
+  ScopedStage stage("streets");
   auto timer = base::Timer();
   SCOPE_GUARD(finishGeneratingStreets, [&timer]() {
     LOG(LINFO, ("Finish generating streets.", timer.ElapsedSeconds(), "seconds."));
   });
 
-  regions::RegionInfoGetter regionInfoGetter{pathInRegionsIndex, pathInRegionsKv};
+  auto const sharedRegionInfoGetter =
+      regions::RegionInfoGetter::GetShared(pathInRegionsIndex, pathInRegionsKv);
+  auto const & regionInfoGetter = *sharedRegionInfoGetter;
   LOG(LINFO, ("Size of regions key-value storage:", regionInfoGetter.GetStorage().Size()));
 
   auto const regionFinder = [&regionInfoGetter] (auto && point, auto && selector) {
     return regionInfoGetter.FindDeepest(point, selector);
   };
-  StreetsBuilder streetsBuilder{regionFinder, threadsCount};
+  auto const borderCrossingFinderMaker = [&regionInfoGetter](auto && path) {
+    m2::RectD pathRect;
+    for (auto const & point : path)
+      pathRect.Add(point);
+
+    auto candidates = regionInfoGetter.FindCandidates(pathRect);
+    return [&regionInfoGetter, candidates = std::move(candidates)](auto && from, auto && to) {
+      return regionInfoGetter.FindFirstBorderCrossing(candidates, from, to);
+    };
+  };
+  StreetsBuilder streetsBuilder{regionFinder, threadsCount, borderCrossingFinderMaker};
 
   streetsBuilder.AssembleStreets(pathInStreetsTmpMwm);
   LOG(LINFO, ("Streets were built."));
@@ -45,7 +62,16 @@ void GenerateStreets(std::string const & pathInRegionsIndex, std::string const &
   auto const regionGetter = [&regionStorage = regionInfoGetter.GetStorage()](uint64_t id) {
     return regionStorage.Find(id);
   };
-  streetsBuilder.SaveStreetsKv(regionGetter, streamStreetsKv);
+  if (pathOutStreetsHierarchy.empty())
+  {
+    streetsBuilder.SaveStreetsKv(regionGetter, streamStreetsKv);
+  }
+  else
+  {
+    std::ofstream streamStreetsHierarchy(pathOutStreetsHierarchy, std::ofstream::binary);
+    streetsBuilder.SaveStreetsKv(regionGetter, streamStreetsKv, &streamStreetsHierarchy);
+    LOG(LINFO, ("Streets binary hierarchy saved to", pathOutStreetsHierarchy));
+  }
   LOG(LINFO, ("Streets key-value storage saved to", pathOutStreetsKv));
 }
 }  // namespace streets
@@ -13,6 +13,7 @@ void GenerateStreets(std::string const & pathInRegionsIndex, std::string const &
                      std::string const & pathInStreetsTmpMwm,
                      std::string const & pathInGeoObjectsTmpMwm,
                      std::string const & pathOutStreetsKv,
-                     bool verbose, unsigned int threadsCount);
+                     bool verbose, unsigned int threadsCount,
+                     std::string const & pathOutStreetsHierarchy = {});
 }  // namespace streets
 }  // namespace generator
@@ -1,10 +1,15 @@
 #include "generator/streets/streets_builder.hpp"
 
 #include "generator/key_value_storage.hpp"
+#include "generator/stages_report.hpp"
 #include "generator/streets/street_regions_tracing.hpp"
 #include "generator/translation.hpp"
 
+#include "coding/file_reader.hpp"
+#include "coding/file_writer.hpp"
 #include "coding/internal/file_data.hpp"
+#include "coding/reader.hpp"
+#include "coding/varint.hpp"
 
 #include "indexer/classificator.hpp"
 #include "indexer/ftypes_matcher.hpp"
@@ -15,7 +20,13 @@
 
 #include "base/logging.hpp"
 #include "base/scope_guard.hpp"
+#include "base/thread_pool_computational.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
 #include <utility>
 
 #include "3party/jansson/myjansson.hpp"
@@ -26,74 +37,236 @@ namespace generator
 {
 namespace streets
 {
-StreetsBuilder::StreetsBuilder(RegionFinder const & regionFinder,
-                               unsigned int threadsCount)
-  : m_regionsArenas(GetArenasCount(threadsCount))
-  , m_featuresArenas{GetArenasCount(threadsCount)}
+// static
+uint64_t constexpr StreetsBuilder::kNoFeaturePos;
+
+StreetsBuilder::StreetsBuilder(RegionFinder const & regionFinder, unsigned int threadsCount,
+                               BorderCrossingFinderMaker const & borderCrossingFinderMaker)
+  : m_shards(GetShardsCount(threadsCount))
   , m_regionFinder{regionFinder}
+  , m_borderCrossingFinderMaker{borderCrossingFinderMaker}
   , m_threadsCount{threadsCount}
 {
 }
 
 void StreetsBuilder::AssembleStreets(std::string const & pathInStreetsTmpMwm)
 {
-  auto const transform = [this](FeatureBuilder & fb, uint64_t /* currPos */) { AddStreet(fb); };
-  if (m_threadsCount == 1)
-    ForEachFromDatRawFormat(pathInStreetsTmpMwm, transform);
-  else
-    ForEachParallelFromDatRawFormat(m_threadsCount, pathInStreetsTmpMwm, transform);
+  ScopedStage stage("streets: assembling streets");
+  CollectStreetParts(pathInStreetsTmpMwm,
+                     [this](FeatureBuilder & fb, uint64_t currPos, StreetPartsBuffer & parts) {
+                       AddStreet(fb, currPos, parts);
+                     });
 }
 
 void StreetsBuilder::AssembleBindings(std::string const & pathInGeoObjectsTmpMwm)
 {
-  auto const transform = [this](FeatureBuilder & fb, uint64_t /* currPos */) {
+  ScopedStage stage("streets: assembling bindings");
+  auto const collector = [this](FeatureBuilder & fb, uint64_t /* currPos */,
+                                StreetPartsBuffer & parts) {
     std::string streetName = fb.GetParams().GetStreet();
     if (!streetName.empty())
     {
       // TODO maybe (lagrunge): add localizations on street:lang tags
       StringUtf8Multilang multilangName;
       multilangName.AddString(StringUtf8Multilang::kDefaultCode, streetName);
-      AddStreetBinding(std::move(streetName), fb, multilangName);
+      AddStreetBinding(std::move(streetName), fb, multilangName, parts);
     }
   };
+  CollectStreetParts(pathInGeoObjectsTmpMwm, collector);
+}
+
+template <typename Collector>
+void StreetsBuilder::CollectStreetParts(std::string const & pathInTmpMwm, Collector && collector)
+{
+  std::vector<StreetPartsBuffer> threadsParts(m_threadsCount, StreetPartsBuffer(m_shards.size()));
+  size_t nextThread = 0;
+  auto const makeProcessor = [&] {
+    CHECK_LESS(nextThread, threadsParts.size(), ());
+    auto & parts = threadsParts[nextThread++];
+    return [&collector, &parts](FeatureBuilder & fb, uint64_t currPos) {
+      collector(fb, currPos, parts);
+    };
+  };
+  ProcessParallelFromDatRawFormat(m_threadsCount, pathInTmpMwm, makeProcessor);
 
-  if (m_threadsCount == 1)
-    ForEachFromDatRawFormat(pathInGeoObjectsTmpMwm, transform);
-  else
-    ForEachParallelFromDatRawFormat(m_threadsCount, pathInGeoObjectsTmpMwm, transform);
+  MergeStreetParts(threadsParts);
+}
+
+void StreetsBuilder::AddStreetPart(StreetPart && part, StreetPartsBuffer & parts) const
+{
+  auto const hash = std::hash<std::string>{}(part.m_streetName) * 31 +
+                    std::hash<uint64_t>{}(part.m_regionId);
+  parts[hash % parts.size()].push_back(std::move(part));
+}
+
+void StreetsBuilder::MergeStreetParts(std::vector<StreetPartsBuffer> & threadsParts)
+{
+  // The parts of a shard are merged in the order of the threads, the geometry of a street
+  // does not depend on the other shards.
+  auto const mergeShards = [&](size_t firstShard) {
+    for (auto shard = firstShard; shard < m_shards.size(); shard += m_threadsCount)
+    {
+      for (auto & parts : threadsParts)
+      {
+        for (auto & part : parts[shard])
+          MergeStreetPart(std::move(part), m_shards[shard]);
+        std::vector<StreetPart>().swap(parts[shard]);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < m_threadsCount; ++i)
+    threads.emplace_back(mergeShards, i);
+  mergeShards(0);
+  for (auto & thread : threads)
+    thread.join();
+
+  size_t bytes = 0;
+  for (auto const & shard : m_shards)
+    bytes += shard.m_bytes;
+  m_memory.Set(bytes);
+}
+
+// static
+void StreetsBuilder::MergeStreetPart(StreetPart && part, StreetsShard & shard)
+{
+  shard.m_bytes += part.m_streetName.size() + part.m_points.size() * sizeof(m2::PointD);
+  auto & street =
+      shard.InsertStreet(part.m_regionId, std::move(part.m_streetName), part.m_multilangName);
+  auto & geometry = street.m_geometry;
+  switch (part.m_type)
+  {
+  case StreetPart::Type::HighwayLine: geometry.AddHighwayLine(part.m_osmId, part.m_points); break;
+  case StreetPart::Type::HighwayArea: geometry.AddHighwayArea(part.m_osmId, part.m_points); break;
+  case StreetPart::Type::Pin: geometry.SetPin({part.m_points.front(), part.m_osmId}); break;
+  case StreetPart::Type::Binding: geometry.AddBinding(part.m_osmId, part.m_points.front()); break;
+  }
+
+  if (part.m_type != StreetPart::Type::Binding)
+    street.m_firstFeaturePos = std::min(street.m_firstFeaturePos, part.m_featurePos);
 }
 
 void StreetsBuilder::RegenerateAggregatedStreetsFeatures(
     std::string const & pathStreetsTmpMwm)
 {
+  ScopedStage stage("streets: regenerating features");
+  // A street is written by the thread which reads the first feature of the street. The threads
+  // write to their own chunks which are merged in the order of the features, so the result does
+  // not depend on the threads count.
+  auto const streets = GetStreetsByFirstFeatures();
+  std::vector<AggregatedStreetsChunk> chunks(m_threadsCount);
+  SCOPE_GUARD(chunksGuard, [&chunks] {
+    for (auto const & chunk : chunks)
+      Platform::RemoveFileIfExists(chunk.m_path);
+  });
+  for (auto & chunk : chunks)
+  {
+    chunk.m_path = GetPlatform().TmpPathForFile();
+    chunk.m_collector = std::make_unique<FeaturesCollector>(chunk.m_path);
+  }
+
+  size_t nextThread = 0;
+  auto const makeProcessor = [&] {
+    CHECK_LESS(nextThread, chunks.size(), ());
+    auto & chunk = chunks[nextThread++];
+    return [this, &streets, &chunk](FeatureBuilder & fb, uint64_t currPos) {
+      auto const range = std::equal_range(
+          streets.begin(), streets.end(), std::make_pair(currPos, nullptr),
+          [](auto const & lhs, auto const & rhs) { return lhs.first < rhs.first; });
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        auto const count = WriteAsAggregatedStreet(fb, *it->second, *chunk.m_collector);
+        chunk.m_streets.emplace_back(currPos, count);
+      }
+    };
+  };
+  ProcessParallelFromDatRawFormat(m_threadsCount, pathStreetsTmpMwm, makeProcessor);
+
+  for (auto & chunk : chunks)
+  {
+    chunk.m_collector->Finish();
+    chunk.m_collector.reset();
+  }
+
   auto const aggregatedStreetsTmpFile = GetPlatform().TmpPathForFile();
   SCOPE_GUARD(aggregatedStreetsTmpFileGuard,
               std::bind(Platform::RemoveFileIfExists, aggregatedStreetsTmpFile));
-  FeaturesCollector collector(aggregatedStreetsTmpFile);
+  MergeAggregatedStreetsChunks(chunks, aggregatedStreetsTmpFile);
 
-  std::set<Street const *> processedStreets;
-  auto const transform = [&](FeatureBuilder & fb, uint64_t /* currPos */) {
-    auto const osmId = fb.GetMostGenericOsmId();
-    auto const & featuresArena = GetFeaturesArena(osmId);
-    auto street = featuresArena.m_streetFeatures2Streets.find(osmId);
-    if (street == featuresArena.m_streetFeatures2Streets.end())
-        return;
+  CHECK(base::RenameFileX(aggregatedStreetsTmpFile, pathStreetsTmpMwm), ());
+}
+
+std::vector<std::pair<uint64_t, StreetsBuilder::Street const *>>
+StreetsBuilder::GetStreetsByFirstFeatures() const
+{
+  std::vector<std::pair<uint64_t, Street const *>> streets;
+  for (auto const & shard : m_shards)
+  {
+    for (auto const & region : shard.m_regions)
+    {
+      for (auto const & street : region.second)
+      {
+        if (street.second.m_firstFeaturePos != kNoFeaturePos)
+          streets.emplace_back(street.second.m_firstFeaturePos, &street.second);
+      }
+    }
+  }
 
-    if (!processedStreets.insert(street->second).second)
-      return;
+  std::stable_sort(streets.begin(), streets.end(),
+                   [](auto const & lhs, auto const & rhs) { return lhs.first < rhs.first; });
+  return streets;
+}
 
-    WriteAsAggregatedStreet(fb, *street->second, collector);
-  };
-  ForEachFromDatRawFormat(pathStreetsTmpMwm, transform);
+// static
+void StreetsBuilder::MergeAggregatedStreetsChunks(
+    std::vector<AggregatedStreetsChunk> const & chunks, std::string const & path)
+{
+  // The streets of a chunk are sorted by the positions of their first features as a thread
+  // reads the features in the order of the file.
+  std::vector<std::unique_ptr<FileReader>> readers;
+  std::vector<ReaderSource<FileReader>> sources;
+  for (auto const & chunk : chunks)
+  {
+    readers.push_back(std::make_unique<FileReader>(chunk.m_path));
+    sources.emplace_back(*readers.back());
+  }
 
-  collector.Finish();
+  FileWriter writer(path);
+  std::vector<char> buffer;
+  std::vector<size_t> nextStreets(chunks.size(), 0);
+  while (true)
+  {
+    auto best = chunks.size();
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+      if (nextStreets[i] == chunks[i].m_streets.size())
+        continue;
 
-  CHECK(base::RenameFileX(aggregatedStreetsTmpFile, pathStreetsTmpMwm), ());
+      auto const pos = chunks[i].m_streets[nextStreets[i]].first;
+      if (best == chunks.size() || pos < chunks[best].m_streets[nextStreets[best]].first)
+        best = i;
+    }
+
+    if (best == chunks.size())
+      break;
+
+    auto & source = sources[best];
+    for (size_t count = chunks[best].m_streets[nextStreets[best]++].second; count > 0; --count)
+    {
+      auto const size = ReadVarUint<uint32_t>(source);
+      buffer.resize(size);
+      source.Read(buffer.data(), size);
+      WriteVarUint(writer, size);
+      writer.Write(buffer.data(), size);
+    }
+  }
 }
 
-void StreetsBuilder::WriteAsAggregatedStreet(FeatureBuilder & fb, Street const & street,
-                                             FeaturesCollector & collector) const
+size_t StreetsBuilder::WriteAsAggregatedStreet(FeatureBuilder & fb, Street const & street,
+                                               FeaturesCollector & collector) const
 {
+  size_t count = 0;
   fb.GetParams().name = street.m_name;
 
   auto const & geometry = street.m_geometry;
@@ -105,199 +278,176 @@ void StreetsBuilder::WriteAsAggregatedStreet(FeatureBuilder & fb, Street const &
     fb.ResetGeometry();
     fb.SetCenter(pin->m_position);
     collector.Collect(fb);
+    ++count;
   }
 
   auto const * highwayGeometry = geometry.GetHighwayGeometry();
   if (!highwayGeometry)
-    return;
-
-  for (auto const & area : highwayGeometry->GetAreaParts())
-  {
-    fb.ResetGeometry();
-    fb.GetParams().SetGeomType(feature::GeomType::Area);
-    auto polygon = area.m_border;
-    fb.AddPolygon(polygon);
-    collector.Collect(fb);
-  }
+    return count;
+
+  highwayGeometry->ForEachAreaBorder(
+      [&fb, &collector, &count](base::GeoObjectId const & /* osmId */, m2::PointD const * border,
+                        size_t size) {
+        fb.ResetGeometry();
+        fb.GetParams().SetGeomType(feature::GeomType::Area);
+        std::vector<m2::PointD> polygon(border, border + size);
+        fb.AddPolygon(polygon);
+        collector.Collect(fb);
+        ++count;
+      });
+
+  highwayGeometry->ForEachLineSegment(
+      [&fb, &collector, &count](base::GeoObjectId const & /* osmId */, m2::PointD const * points,
+                        size_t size) {
+        fb.ResetGeometry();
+        fb.SetLinear();
+        for (size_t i = 0; i < size; ++i)
+          fb.AddPoint(points[i]);
+        collector.Collect(fb);
+        ++count;
+      });
+
+  return count;
+}
 
-  for (auto const & line : highwayGeometry->GetMultiLine().m_lines)
-  {
-    for (auto const & segment : line.m_segments)
+void StreetsBuilder::SaveStreetsKv(RegionGetter const & regionGetter,
+                                   std::ostream & streamStreetsKv,
+                                   std::ostream * streamStreetsHierarchy)
+{
+  ScopedStage stage("streets: key-value");
+  // The shards are serialized in parallel and are written in the order of the shards.
+  // At most kPendingShardsPerThread serialized shards per thread wait for writing.
+  size_t const kPendingShardsPerThread = 2;
+  base::thread_pool::computational::ThreadPool threadPool{m_threadsCount};
+  std::deque<std::future<SerializedShard>> pendingKv;
+  auto const flush = [&](size_t maxPendingCount) {
+    while (pendingKv.size() > maxPendingCount)
     {
-      fb.ResetGeometry();
-      fb.SetLinear();
-      for (auto const & point : segment.m_points)
-        fb.AddPoint(point);
-      collector.Collect(fb);
+      auto const shard = pendingKv.front().get();
+      streamStreetsKv << shard.m_kv;
+      if (streamStreetsHierarchy)
+        *streamStreetsHierarchy << shard.m_hierarchy;
+      pendingKv.pop_front();
     }
+  };
+
+  bool const withHierarchy = streamStreetsHierarchy != nullptr;
+  for (auto const & shard : m_shards)
+  {
+    pendingKv.push_back(threadPool.Submit([this, &shard, &regionGetter, withHierarchy]() {
+      return SerializeShardKv(shard, regionGetter, withHierarchy);
+    }));
+    flush(kPendingShardsPerThread * m_threadsCount);
   }
+  flush(0 /* maxPendingCount */);
 }
 
-void StreetsBuilder::SaveStreetsKv(RegionGetter const & regionGetter,
-                                   std::ostream & streamStreetsKv)
+StreetsBuilder::SerializedShard StreetsBuilder::SerializeShardKv(
+    StreetsShard const & shard, RegionGetter const & regionGetter, bool withHierarchy) const
 {
-  for (auto const & regionsArena : m_regionsArenas)
+  SerializedShard serialized;
+  BinaryHierarchyCollector hierarchy;
+  for (auto const & region : shard.m_regions)
   {
-    for (auto const & region : regionsArena.m_regions)
-    {
-      auto const & regionObject = regionGetter(region.first);
-      CHECK(regionObject, ());
-      SaveRegionStreetsKv(region.second, region.first, *regionObject, streamStreetsKv);
-    }
+    auto const & regionObject = regionGetter(region.first);
+    CHECK(regionObject, ());
+    SerializeRegionStreetsKv(region.second, region.first, *regionObject, serialized.m_kv,
+                             withHierarchy ? &hierarchy : nullptr);
   }
+  if (!hierarchy.IsEmpty())
+    serialized.m_hierarchy = hierarchy.ReleaseChunk();
+  return serialized;
 }
 
-void StreetsBuilder::SaveRegionStreetsKv(RegionStreets const & streets, uint64_t regionId,
-                                         JsonValue const & regionInfo,
-                                         std::ostream & streamStreetsKv)
+void StreetsBuilder::SerializeRegionStreetsKv(RegionStreets const & streets, uint64_t regionId,
+                                              JsonValue const & regionInfo, std::string & buffer,
+                                              BinaryHierarchyCollector * hierarchy) const
 {
   for (auto const & street : streets)
   {
     auto const & bbox = street.second.m_geometry.GetBbox();
     auto const & pin = street.second.m_geometry.GetOrChoosePin();
 
-    auto const id = KeyValueStorage::SerializeDref(pin.m_osmId.GetEncodedId());
     auto const & value =
         MakeStreetValue(regionId, regionInfo, street.second.m_name, bbox, pin.m_position);
-    streamStreetsKv << id << " " << KeyValueStorage::Serialize(value) << "\n";
+    KeyValueStorage::SerializeFullLine(buffer, pin.m_osmId.GetEncodedId(), value);
+    if (hierarchy)
+      hierarchy->Add(pin.m_osmId.GetEncodedId(), value);
   }
 }
 
-void StreetsBuilder::AddStreet(FeatureBuilder & fb)
+void StreetsBuilder::AddStreet(FeatureBuilder & fb, uint64_t featurePos,
+                               StreetPartsBuffer & parts)
 {
   if (fb.IsArea())
-    return AddStreetArea(fb);
+    return AddStreetArea(fb, featurePos, parts);
 
   if (fb.IsPoint())
-    return AddStreetPoint(fb);
+    return AddStreetPoint(fb, featurePos, parts);
 
   CHECK(fb.IsLine(), ());
-  AddStreetHighway(fb);
+  AddStreetHighway(fb, featurePos, parts);
 }
 
-void StreetsBuilder::AddStreetHighway(FeatureBuilder & fb)
+void StreetsBuilder::AddStreetHighway(FeatureBuilder & fb, uint64_t featurePos,
+                                      StreetPartsBuffer & parts)
 {
   auto streetRegionInfoGetter = [this](auto const & pathPoint) {
     return this->FindStreetRegionOwner(pathPoint);
   };
-  StreetRegionsTracing regionsTracing(fb.GetOuterGeometry(), streetRegionInfoGetter);
-
-  auto && pathSegments = regionsTracing.StealPathSegments();
+  auto const & path = fb.GetOuterGeometry();
+  auto pathSegments =
+      m_borderCrossingFinderMaker
+          ? StreetRegionsTracing(path, streetRegionInfoGetter, m_borderCrossingFinderMaker(path))
+                .StealPathSegments()
+          : StreetRegionsTracing(path, streetRegionInfoGetter).StealPathSegments();
   for (auto & segment : pathSegments)
   {
-    auto && region = segment.m_region;
-
     auto const osmId = fb.GetMostGenericOsmId();
     auto const streetId = pathSegments.size() == 1 ? osmId : NextOsmSurrogateId();
-    Street const * featureStreetPtr = nullptr;
-
-    {
-      auto & regionsArena = GetRegionsArena(region.first);
-      std::lock_guard<std::mutex> lock{regionsArena.m_updateMutex};
-
-      auto & street = regionsArena.InsertStreet(region.first, fb.GetName(), fb.GetMultilangName());
-      street.m_geometry.AddHighwayLine(streetId, std::move(segment.m_path));
-      featureStreetPtr = &street;
-    }
-
-    {
-      auto & featuresArena = GetFeaturesArena(osmId);
-      std::lock_guard<std::mutex> lock{featuresArena.m_updateMutex};
-
-      featuresArena.m_streetFeatures2Streets.emplace(osmId, featureStreetPtr);
-    }
+    AddStreetPart({StreetPart::Type::HighwayLine, segment.m_region.first, fb.GetName(),
+                   fb.GetMultilangName(), streetId, featurePos, std::move(segment.m_path)},
+                  parts);
   }
 }
 
-void StreetsBuilder::AddStreetArea(FeatureBuilder & fb)
+void StreetsBuilder::AddStreetArea(FeatureBuilder & fb, uint64_t featurePos,
+                                   StreetPartsBuffer & parts)
 {
   auto && region = FindStreetRegionOwner(fb.GetGeometryCenter(), true);
   if (!region)
     return;
 
   auto const osmId = fb.GetMostGenericOsmId();
-  Street const * featureStreetPtr = nullptr;
-
-  {
-    auto & regionsArena = GetRegionsArena(region->first);
-    std::lock_guard<std::mutex> lock{regionsArena.m_updateMutex};
-
-    auto & street = regionsArena.InsertStreet(region->first, fb.GetName(), fb.GetMultilangName());
-    street.m_geometry.AddHighwayArea(osmId, fb.GetOuterGeometry());
-    featureStreetPtr = &street;
-  }
-
-  {
-    auto & featuresArena = GetFeaturesArena(osmId);
-    std::lock_guard<std::mutex> lock{featuresArena.m_updateMutex};
-
-    featuresArena.m_streetFeatures2Streets.emplace(osmId, featureStreetPtr);
-  }
+  AddStreetPart({StreetPart::Type::HighwayArea, region->first, fb.GetName(),
+                 fb.GetMultilangName(), osmId, featurePos, fb.GetOuterGeometry()},
+                parts);
 }
 
-void StreetsBuilder::AddStreetPoint(FeatureBuilder & fb)
+void StreetsBuilder::AddStreetPoint(FeatureBuilder & fb, uint64_t featurePos,
+                                    StreetPartsBuffer & parts)
 {
   auto && region = FindStreetRegionOwner(fb.GetKeyPoint(), true);
   if (!region)
     return;
 
   auto const osmId = fb.GetMostGenericOsmId();
-  Street const * featureStreetPtr = nullptr;
-
-  {
-    auto & regionsArena = GetRegionsArena(region->first);
-    std::lock_guard<std::mutex> lock{regionsArena.m_updateMutex};
-
-    auto & street = regionsArena.InsertStreet(region->first, fb.GetName(), fb.GetMultilangName());
-    street.m_geometry.SetPin({fb.GetKeyPoint(), osmId});
-    featureStreetPtr = &street;
-  }
-
-  {
-    auto & featuresArena = GetFeaturesArena(osmId);
-    std::lock_guard<std::mutex> lock{featuresArena.m_updateMutex};
-
-    featuresArena.m_streetFeatures2Streets.emplace(osmId, featureStreetPtr);
-  }
+  AddStreetPart({StreetPart::Type::Pin, region->first, fb.GetName(), fb.GetMultilangName(),
+                 osmId, featurePos, {fb.GetKeyPoint()}},
+                parts);
 }
 
 void StreetsBuilder::AddStreetBinding(std::string && streetName, FeatureBuilder & fb,
-                                      StringUtf8Multilang const & multiLangName)
+                                      StringUtf8Multilang const & multiLangName,
+                                      StreetPartsBuffer & parts)
 {
   auto const region = FindStreetRegionOwner(fb.GetKeyPoint());
   if (!region)
     return;
 
-  auto const osmId = NextOsmSurrogateId();
-
-  {
-    auto & regionsArena = GetRegionsArena(region->first);
-    std::lock_guard<std::mutex> lock{regionsArena.m_updateMutex};
-
-    auto & street = regionsArena.InsertStreet(region->first, std::move(streetName), multiLangName);
-    street.m_geometry.AddBinding(osmId, fb.GetKeyPoint());
-  }
-}
-
-StreetsBuilder::RegionsArena & StreetsBuilder::GetRegionsArena(uint64_t regionId)
-{
-  return m_regionsArenas[std::hash<uint64_t>{}(regionId) % m_regionsArenas.size()];
-}
-
-StreetsBuilder::RegionsArena const & StreetsBuilder::GetRegionsArena(uint64_t regionId) const
-{
-  return m_regionsArenas[std::hash<uint64_t>{}(regionId) % m_regionsArenas.size()];
-}
-
-StreetsBuilder::FeaturesArena & StreetsBuilder::GetFeaturesArena(base::GeoObjectId const & osmId)
-{
-  return m_featuresArenas[std::hash<base::GeoObjectId>{}(osmId) % m_featuresArenas.size()];
-}
-
-StreetsBuilder::FeaturesArena const & StreetsBuilder::GetFeaturesArena(
-    base::GeoObjectId const & osmId) const
-{
-  return m_featuresArenas[std::hash<base::GeoObjectId>{}(osmId) % m_featuresArenas.size()];
+  AddStreetPart({StreetPart::Type::Binding, region->first, std::move(streetName), multiLangName,
+                 NextOsmSurrogateId(), kNoFeaturePos, {fb.GetKeyPoint()}},
+                parts);
 }
 
 boost::optional<KeyValue> StreetsBuilder::FindStreetRegionOwner(m2::PointD const & point,
@@ -334,7 +484,7 @@ StringUtf8Multilang MergeNames(const StringUtf8Multilang & first,
   return result;
 }
 
-StreetsBuilder::Street & StreetsBuilder::RegionsArena::InsertStreet(
+StreetsBuilder::Street & StreetsBuilder::StreetsShard::InsertStreet(
     uint64_t regionId, std::string && streetName, StringUtf8Multilang const & multilangName)
 {
   auto & regionStreets = m_regions[regionId];
@@ -343,36 +493,36 @@ StreetsBuilder::Street & StreetsBuilder::RegionsArena::InsertStreet(
   return street;
 }
 
-base::JSONPtr StreetsBuilder::MakeStreetValue(uint64_t regionId, JsonValue const & regionObject,
-                                              StringUtf8Multilang const & streetName,
-                                              m2::RectD const & bbox, m2::PointD const & pinPoint)
+JsonObjectPatch StreetsBuilder::MakeStreetValue(uint64_t regionId, JsonValue const & regionObject,
+                                                StringUtf8Multilang const & streetName,
+                                                m2::RectD const & bbox,
+                                                m2::PointD const & pinPoint) const
 {
-  auto streetObject = base::NewJSONObject();
+  JsonObjectPatch streetObject;
 
   auto && regionLocales = base::GetJSONObligatoryFieldByPath(regionObject, "properties", "locales");
-  auto locales = base::JSONPtr{json_deep_copy(const_cast<json_t *>(regionLocales))};
-  auto properties = base::NewJSONObject();
-  ToJSONObject(*properties, "locales", std::move(locales));
+  auto & properties = streetObject.GetOrCreateObject("properties");
+  // The region locales are not copied, only their changes are kept.
+  properties.Set("locales", regionLocales);
 
-  Localizator localizator(*properties);
+  PatchLocalizator localizator(properties);
   auto const & localizee = Localizator::EasyObjectWithTranslation(streetName);
   localizator.SetLocale("name", localizee);
 
   localizator.SetLocale("street", localizee, "address");
 
-  ToJSONObject(*properties, "kind", "street");
-  ToJSONObject(*properties, "dref", KeyValueStorage::SerializeDref(regionId));
-  ToJSONObject(*streetObject, "properties", std::move(properties));
+  properties.Set("kind", "street");
+  properties.Set("dref", KeyValueStorage::SerializeDref(regionId));
 
   auto const & leftBottom = MercatorBounds::ToLatLon(bbox.LeftBottom());
   auto const & rightTop = MercatorBounds::ToLatLon(bbox.RightTop());
   auto const & bboxArray =
       std::vector<double>{leftBottom.m_lon, leftBottom.m_lat, rightTop.m_lon, rightTop.m_lat};
-  ToJSONObject(*streetObject, "bbox", std::move(bboxArray));
+  streetObject.Set("bbox", bboxArray);
 
   auto const & pinLatLon = MercatorBounds::ToLatLon(pinPoint);
   auto const & pinArray = std::vector<double>{pinLatLon.m_lon, pinLatLon.m_lat};
-  ToJSONObject(*streetObject, "pin", std::move(pinArray));
+  streetObject.Set("pin", pinArray);
 
   return streetObject;
 }
@@ -416,10 +566,9 @@ bool StreetsBuilder::IsStreet(FeatureBuilder const & fb)
 }
 
 // static
-unsigned int StreetsBuilder::GetArenasCount(unsigned int threadsCount)
+unsigned int StreetsBuilder::GetShardsCount(unsigned int threadsCount)
 {
-  // N ^ 2 arenas to minimize concurrency of each thread (of N threads)
-  // with any N - 1 other threads.
+  // N ^ 2 shards to balance the merge of the big cities streets between N threads.
   return threadsCount * threadsCount;
 }
 }  // namespace streets
@@ -1,24 +1,29 @@
 #pragma once
 
+#include "generator/binary_hierarchy_collector.hpp"
 #include "generator/feature_builder.hpp"
 #include "generator/feature_generator.hpp"
 #include "generator/osm_element.hpp"
 #include "generator/regions/region_info_getter.hpp"
 #include "generator/streets/street_geometry.hpp"
+#include "generator/streets/street_regions_tracing.hpp"
 
 #include "coding/reader.hpp"
 
 #include "geometry/point2d.hpp"
 
+#include "base/flat_hash_map.hpp"
 #include "base/geo_object_id.hpp"
+#include "base/memory_accounting.hpp"
 
 #include <atomic>
 #include <functional>
+#include <limits>
 #include <memory>
-#include <mutex>
 #include <ostream>
 #include <stdint.h>
 #include <string>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -34,8 +39,16 @@ public:
   using RegionFinder = std::function<boost::optional<KeyValue>(
       m2::PointD const & point, std::function<bool(KeyValue const & json)> const & selector)>;
   using RegionGetter = std::function<std::shared_ptr<JsonValue>(uint64_t key)>;
+  // Prepares the borders of the regions of the points of |path| and returns the finder of their
+  // crossings by the path segments.
+  using BorderCrossingFinderMaker =
+      std::function<StreetRegionsTracing::StreetRegionBorderCrossingFinder(
+          StreetRegionsTracing::Path const & path)>;
 
-  explicit StreetsBuilder(RegionFinder const & regionFinder, unsigned int threadsCount = 1);
+  // The highways are split into the regions by the border crossings when
+  // |borderCrossingFinderMaker| is set, and by the region checks along the path otherwise.
+  explicit StreetsBuilder(RegionFinder const & regionFinder, unsigned int threadsCount = 1,
+                          BorderCrossingFinderMaker const & borderCrossingFinderMaker = {});
 
   void AssembleStreets(std::string const & pathInStreetsTmpMwm);
   void AssembleBindings(std::string const & pathInGeoObjectsTmpMwm);
@@ -44,65 +57,128 @@ public:
 
   // Save built streets in the jsonl format with the members: "properties", "bbox" (array: left
   // bottom longitude, left bottom latitude, right top longitude, right top latitude), "pin" (array:
-  // longitude, latitude).
-  void SaveStreetsKv(RegionGetter const & regionGetter, std::ostream & streamStreetsKv);
+  // longitude, latitude). The streets are serialized in parallel, |regionGetter| must be
+  // thread-safe. The binary hierarchy of the geocoder is written to |streamStreetsHierarchy| if
+  // it is set, see BinaryHierarchyCollector.
+  void SaveStreetsKv(RegionGetter const & regionGetter, std::ostream & streamStreetsKv,
+                     std::ostream * streamStreetsHierarchy = nullptr);
 
   static bool IsStreet(OsmElement const & element);
   static bool IsStreet(feature::FeatureBuilder const & fb);
 
 private:
+  static uint64_t constexpr kNoFeaturePos = std::numeric_limits<uint64_t>::max();
+
   struct Street
   {
     StringUtf8Multilang m_name;
     StreetGeometry m_geometry;
+    // The position of the first feature of the street in the streets features file,
+    // the aggregated street replaces this feature.
+    uint64_t m_firstFeaturePos = kNoFeaturePos;
   };
 
   using RegionStreets = std::unordered_map<std::string, Street>;
 
-  struct RegionsArena
+  // A piece of a street found by a worker thread. The pieces are collected in thread-local
+  // buffers and are merged into the streets at the end of a stage.
+  struct StreetPart
+  {
+    enum class Type
+    {
+      HighwayLine,
+      HighwayArea,
+      Pin,
+      Binding,
+    };
+
+    Type m_type;
+    uint64_t m_regionId;
+    std::string m_streetName;
+    StringUtf8Multilang m_multilangName;
+    // The id of the street geometry part.
+    base::GeoObjectId m_osmId;
+    // The position of the feature of the part in the features file, not set for bindings.
+    uint64_t m_featurePos;
+    std::vector<m2::PointD> m_points;
+  };
+
+  // The parts collected by one thread, by the shards.
+  using StreetPartsBuffer = std::vector<std::vector<StreetPart>>;
+
+  // The aggregated streets written by one thread to its own features file. The streets are
+  // written in the order of the positions of their first features.
+  struct AggregatedStreetsChunk
   {
-    std::unordered_map<uint64_t, RegionStreets> m_regions;
-    std::mutex m_updateMutex;
+    std::string m_path;
+    std::unique_ptr<feature::FeaturesCollector> m_collector;
+    // The positions of the first features of the written streets and the counts of the
+    // written features of the streets.
+    std::vector<std::pair<uint64_t, size_t>> m_streets;
+  };
+
+  // The streets with the same (region, street name) hash. A shard is updated by one thread.
+  struct StreetsShard
+  {
+    // The streets are not moved with RegionStreets, so the references to them stay valid.
+    base::FlatHashMap<uint64_t, RegionStreets> m_regions;
+    // The estimate of the memory of the streets: their names and points.
+    size_t m_bytes = 0;
 
     Street & InsertStreet(uint64_t regionId, std::string && streetName,
                           StringUtf8Multilang const & multilangName);
   };
 
-  struct FeaturesArena
+  template <typename Collector>
+  void CollectStreetParts(std::string const & pathInTmpMwm, Collector && collector);
+  void AddStreetPart(StreetPart && part, StreetPartsBuffer & parts) const;
+  void MergeStreetParts(std::vector<StreetPartsBuffer> & threadsParts);
+  static void MergeStreetPart(StreetPart && part, StreetsShard & shard);
+
+  // Returns the streets by the positions of their first features sorted by the positions.
+  std::vector<std::pair<uint64_t, Street const *>> GetStreetsByFirstFeatures() const;
+  // Returns the count of the written features.
+  size_t WriteAsAggregatedStreet(feature::FeatureBuilder & fb, Street const & street,
+                                 feature::FeaturesCollector & collector) const;
+  static void MergeAggregatedStreetsChunks(std::vector<AggregatedStreetsChunk> const & chunks,
+                                           std::string const & path);
+
+  // The key-value and the binary hierarchy chunk of a shard.
+  struct SerializedShard
   {
-    std::unordered_multimap<base::GeoObjectId, Street const *> m_streetFeatures2Streets;
-    std::mutex m_updateMutex;
+    std::string m_kv;
+    std::string m_hierarchy;
   };
 
-  RegionsArena & GetRegionsArena(uint64_t regionsId);
-  RegionsArena const & GetRegionsArena(uint64_t regionId) const;
-  FeaturesArena & GetFeaturesArena(base::GeoObjectId const & osmId);
-  FeaturesArena const & GetFeaturesArena(base::GeoObjectId const & osmId) const;
-  void WriteAsAggregatedStreet(feature::FeatureBuilder & fb, Street const & street,
-                               feature::FeaturesCollector & collector) const;
-
-  void SaveRegionStreetsKv(RegionStreets const & streets, uint64_t regionId,
-                           JsonValue const & regionInfo, std::ostream & streamStreetsKv);
-
-  void AddStreet(feature::FeatureBuilder & fb);
-  void AddStreetHighway(feature::FeatureBuilder & fb);
-  void AddStreetArea(feature::FeatureBuilder & fb);
-  void AddStreetPoint(feature::FeatureBuilder & fb);
+  SerializedShard SerializeShardKv(StreetsShard const & shard, RegionGetter const & regionGetter,
+                                   bool withHierarchy) const;
+  // The streets are added to |hierarchy| if it is set.
+  void SerializeRegionStreetsKv(RegionStreets const & streets, uint64_t regionId,
+                                JsonValue const & regionInfo, std::string & buffer,
+                                BinaryHierarchyCollector * hierarchy) const;
+
+  void AddStreet(feature::FeatureBuilder & fb, uint64_t featurePos, StreetPartsBuffer & parts);
+  void AddStreetHighway(feature::FeatureBuilder & fb, uint64_t featurePos,
+                        StreetPartsBuffer & parts);
+  void AddStreetArea(feature::FeatureBuilder & fb, uint64_t featurePos, StreetPartsBuffer & parts);
+  void AddStreetPoint(feature::FeatureBuilder & fb, uint64_t featurePos,
+                      StreetPartsBuffer & parts);
   void AddStreetBinding(std::string && streetName, feature::FeatureBuilder & fb,
-                        StringUtf8Multilang const & multiLangName);
+                        StringUtf8Multilang const & multiLangName, StreetPartsBuffer & parts);
   boost::optional<KeyValue> FindStreetRegionOwner(m2::PointD const & point,
                                                   bool needLocality = false);
-  base::JSONPtr MakeStreetValue(uint64_t regionId, JsonValue const & regionObject,
-                                const StringUtf8Multilang & streetName, m2::RectD const & bbox,
-                                m2::PointD const & pinPoint);
+  JsonObjectPatch MakeStreetValue(uint64_t regionId, JsonValue const & regionObject,
+                                  const StringUtf8Multilang & streetName, m2::RectD const & bbox,
+                                  m2::PointD const & pinPoint) const;
   base::GeoObjectId NextOsmSurrogateId();
 
-  static unsigned int GetArenasCount(unsigned int threadsCount);
+  static unsigned int GetShardsCount(unsigned int threadsCount);
 
-  std::vector<RegionsArena> m_regionsArenas;
-  std::vector<FeaturesArena> m_featuresArenas;
+  std::vector<StreetsShard> m_shards;
+  base::memory::ScopedBytes m_memory{base::memory::GetTag("streets")};
 
   RegionFinder m_regionFinder;
+  BorderCrossingFinderMaker m_borderCrossingFinderMaker;
   std::atomic<uint64_t> m_osmSurrogateCounter{0};
   unsigned int m_threadsCount;
 };
@@ -24,6 +24,11 @@ bool StreetsFilter::IsAccepted(FeatureBuilder const & feature)
   return feature.GetParams().IsValid() && IsStreet(feature);
 }
 
+std::vector<std::string> StreetsFilter::GetRequiredTagKeys() const
+{
+  return {"highway", "place"};
+}
+
 // static
 bool StreetsFilter::IsStreet(FeatureBuilder const & fb)
 {
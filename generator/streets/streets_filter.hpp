@@ -16,6 +16,7 @@ public:
 
   bool IsAccepted(OsmElement const & element) override;
   bool IsAccepted(feature::FeatureBuilder const & feature) override;
+  std::vector<std::string> GetRequiredTagKeys() const override;
 
   static bool IsStreet(feature::FeatureBuilder const & fb);
 };
@@ -0,0 +1,437 @@
+#include "generator/synthetic_planet.hpp"
+
+#include "generator/osm_element.hpp"
+#include "generator/osm_o5m_writer.hpp"
+
+#include "geometry/point2d.hpp"
+#include "geometry/rect2d.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace generator
+{
+namespace
+{
+// The side of a city block in degrees, about 200 meters.
+double constexpr kBlockSize = 0.002;
+// The share of a cell taken by a country, a region and a subregion, the rest is the margin
+// for the boundary vertices.
+double constexpr kCountryShare = 0.9;
+double constexpr kRegionShare = 0.95;
+// The share of a cell which a city may take.
+double constexpr kCityShare = 0.6;
+
+struct TagValue
+{
+  char const * m_key;
+  char const * m_value;
+  uint32_t m_weight;
+};
+
+// The weights are about the shares of the tags in the osm.
+TagValue const kBuildings[] = {
+    {"building", "yes", 50},        {"building", "house", 25},     {"building", "apartments", 12},
+    {"building", "residential", 6}, {"building", "commercial", 4}, {"building", "retail", 3}};
+
+TagValue const kPois[] = {
+    {"amenity", "restaurant", 12}, {"amenity", "cafe", 10},      {"amenity", "fast_food", 9},
+    {"shop", "convenience", 10},   {"shop", "supermarket", 6},   {"shop", "clothes", 7},
+    {"shop", "bakery", 5},         {"amenity", "pharmacy", 6},   {"amenity", "bank", 5},
+    {"amenity", "school", 4},      {"amenity", "place_of_worship", 4},
+    {"amenity", "fuel", 3},        {"tourism", "hotel", 3},      {"amenity", "post_office", 2}};
+
+char const * const kSyllables[] = {"ka", "lo", "mi", "ra", "ven", "dor", "sa", "tel", "bri", "no",
+                                   "an", "gor", "li", "ses", "ta", "mar", "vel", "zu", "ho", "den",
+                                   "pe", "ril", "ko", "vas", "ne", "tur", "bel", "sha", "ri", "mon"};
+
+char const * const kStreetSuffixes[] = {"Street", "Avenue", "Road", "Lane", "Boulevard"};
+
+// The distributions of the standard library are implementation defined, so the values are
+// made from the engine output here to be the same on all the platforms.
+class Random
+{
+public:
+  explicit Random(uint64_t seed) : m_engine(seed) {}
+
+  // Returns a value of [0, 1).
+  double Uniform() { return static_cast<double>(m_engine() >> 11) / (uint64_t{1} << 53); }
+  double Uniform(double min, double max) { return min + (max - min) * Uniform(); }
+  uint32_t Index(uint32_t count) { return static_cast<uint32_t>(m_engine() % count); }
+
+  template <size_t N>
+  TagValue const & Choose(TagValue const (&values)[N])
+  {
+    uint32_t total = 0;
+    for (auto const & value : values)
+      total += value.m_weight;
+
+    auto weight = Index(total);
+    for (auto const & value : values)
+    {
+      if (weight < value.m_weight)
+        return value;
+      weight -= value.m_weight;
+    }
+    UNREACHABLE();
+  }
+
+private:
+  std::mt19937_64 m_engine;
+};
+
+m2::RectD Scaled(m2::RectD rect, double scale)
+{
+  rect.Scale(scale);
+  return rect;
+}
+
+// Splits |rect| into a grid of at least |count| cells and calls |fn(cell)| for |count| of them.
+template <typename Fn>
+void ForEachGridCell(m2::RectD const & rect, uint32_t count, Fn && fn)
+{
+  if (count == 0)
+    return;
+
+  auto const columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  auto const rows = (count + columns - 1) / columns;
+  auto const width = rect.SizeX() / columns;
+  auto const height = rect.SizeY() / rows;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    auto const minX = rect.minX() + (i % columns) * width;
+    auto const minY = rect.minY() + (i / columns) * height;
+    fn(m2::RectD(minX, minY, minX + width, minY + height));
+  }
+}
+
+// Walks the planet and writes the elements of a type. The ids and the random values do not
+// depend on the type, so the passes of all the types make the same planet.
+class PlanetWriter
+{
+public:
+  using Tags = std::vector<OsmElement::Tag>;
+
+  PlanetWriter(SyntheticPlanetParams const & params, O5MWriter & writer,
+               OsmElement::EntityType type)
+    : m_params(params), m_writer(writer), m_type(type), m_random(params.m_seed)
+  {
+  }
+
+  void Write()
+  {
+    ForEachGridCell(m2::RectD(-170.0, -60.0, 170.0, 60.0), m_params.m_countriesCount,
+                    [this](m2::RectD const & cell) { WriteCountry(cell); });
+  }
+
+  SyntheticPlanetStats const & GetStats() const { return m_stats; }
+
+private:
+  void WriteCountry(m2::RectD const & cell)
+  {
+    auto const index = m_countriesCount++;
+    std::string const isoCode{static_cast<char>('A' + index / 26 % 26),
+                              static_cast<char>('A' + index % 26)};
+    auto const rect = Scaled(cell, kCountryShare);
+    WriteBoundary(rect, cell, 2 /* adminLevel */, MakeName(), {{"ISO3166-1", isoCode}});
+    ForEachGridCell(rect, m_params.m_regionsPerCountry,
+                    [this](m2::RectD const & cell) { WriteRegion(cell); });
+  }
+
+  void WriteRegion(m2::RectD const & cell)
+  {
+    auto const rect = Scaled(cell, kRegionShare);
+    WriteBoundary(rect, cell, 4 /* adminLevel */, MakeName(), {});
+    ForEachGridCell(rect, m_params.m_subregionsPerRegion,
+                    [this](m2::RectD const & cell) { WriteSubregion(cell); });
+  }
+
+  void WriteSubregion(m2::RectD const & cell)
+  {
+    auto const rect = Scaled(cell, kRegionShare);
+    WriteBoundary(rect, cell, 6 /* adminLevel */, MakeName(), {});
+    uint32_t place = 0;
+    ForEachGridCell(rect, m_params.m_citiesPerSubregion + m_params.m_villagesPerSubregion,
+                    [&](m2::RectD const & cell) {
+                      if (place++ < m_params.m_citiesPerSubregion)
+                        WriteCity(cell);
+                      else
+                        WriteVillage(cell);
+                    });
+  }
+
+  void WriteVillage(m2::RectD const & cell)
+  {
+    auto const rect = Scaled(cell, 0.5);
+    m2::PointD const point(m_random.Uniform(rect.minX(), rect.maxX()),
+                           m_random.Uniform(rect.minY(), rect.maxY()));
+    auto const population = 50 + m_random.Index(2000);
+    AddNode(point, {{"place", population < 200 ? "hamlet" : "village"},
+                    {"name", MakeName()},
+                    {"population", std::to_string(population)}});
+  }
+
+  void WriteCity(m2::RectD const & cell)
+  {
+    auto const streetsCount = std::max(m_params.m_streetsPerCity, 2U);
+    auto const side = std::min(std::min(cell.SizeX(), cell.SizeY()) * kCityShare,
+                               (streetsCount - 1) * kBlockSize);
+    auto const center = cell.Center();
+    m2::RectD const cityRect(center.x - side / 2, center.y - side / 2, center.x + side / 2,
+                             center.y + side / 2);
+
+    // The populations are about the Zipf's law.
+    auto const population = static_cast<uint32_t>(2e6 / (1 + m_random.Index(200)));
+    auto const name = MakeName();
+    auto const place = population >= 100000 ? "city" : "town";
+    auto const label = AddNode(center, {{"place", place},
+                                        {"name", name},
+                                        {"name:en", name},
+                                        {"population", std::to_string(population)}});
+    WriteBoundary(Scaled(cityRect, 1.1), cell, 8 /* adminLevel */, name, {{"place", place}},
+                  label);
+
+    std::vector<std::string> rowStreets(streetsCount);
+    std::vector<std::string> columnStreets(streetsCount);
+    for (auto & street : rowStreets)
+      street = MakeStreetName();
+    for (auto & street : columnStreets)
+      street = MakeStreetName();
+
+    auto const step = side / (streetsCount - 1);
+    std::vector<uint64_t> crossings(streetsCount * streetsCount);
+    for (uint32_t y = 0; y < streetsCount; ++y)
+    {
+      for (uint32_t x = 0; x < streetsCount; ++x)
+      {
+        crossings[y * streetsCount + x] =
+            AddNode({cityRect.minX() + x * step, cityRect.minY() + y * step}, {});
+      }
+    }
+
+    for (uint32_t i = 0; i < streetsCount; ++i)
+    {
+      std::vector<uint64_t> row(streetsCount);
+      std::vector<uint64_t> column(streetsCount);
+      for (uint32_t j = 0; j < streetsCount; ++j)
+      {
+        row[j] = crossings[i * streetsCount + j];
+        column[j] = crossings[j * streetsCount + i];
+      }
+      auto const highway = GetHighway(i, streetsCount);
+      AddWay(std::move(row), {{"highway", highway}, {"name", rowStreets[i]}});
+      AddWay(std::move(column), {{"highway", highway}, {"name", columnStreets[i]}});
+    }
+
+    // The blocks face the row streets.
+    for (uint32_t y = 0; y + 1 < streetsCount; ++y)
+    {
+      uint32_t houseNumber = 1;
+      for (uint32_t x = 0; x + 1 < streetsCount; ++x)
+      {
+        m2::RectD const block(cityRect.minX() + x * step, cityRect.minY() + y * step,
+                              cityRect.minX() + (x + 1) * step, cityRect.minY() + (y + 1) * step);
+        WriteBlock(block, rowStreets[y], houseNumber);
+      }
+    }
+  }
+
+  void WriteBlock(m2::RectD const & block, std::string const & street, uint32_t & houseNumber)
+  {
+    auto const buildingsCount = m_params.m_buildingsPerBlock;
+    if (buildingsCount != 0)
+    {
+      // The buildings are along the south side of the block.
+      auto const width = block.SizeX() / buildingsCount;
+      auto const half = std::min(width, block.SizeY() / 2) * 0.35;
+      for (uint32_t i = 0; i < buildingsCount; ++i)
+      {
+        m2::PointD const center(block.minX() + (i + 0.5) * width,
+                                block.minY() + block.SizeY() / 4);
+        auto const first = AddNode({center.x - half, center.y - half}, {});
+        std::vector<uint64_t> nodes{first,
+                                    AddNode({center.x + half, center.y - half}, {}),
+                                    AddNode({center.x + half, center.y + half}, {}),
+                                    AddNode({center.x - half, center.y + half}, {}), first};
+        auto const & building = m_random.Choose(kBuildings);
+        Tags tags{{building.m_key, building.m_value},
+                  {"addr:street", street},
+                  {"addr:housenumber", std::to_string(houseNumber)}};
+        if (m_random.Index(4) == 0)
+          tags.emplace_back("building:levels", std::to_string(1 + m_random.Index(16)));
+        AddWay(std::move(nodes), std::move(tags));
+        houseNumber += 1 + m_random.Index(2);
+      }
+    }
+
+    // The pois are in the north half of the block.
+    for (uint32_t i = 0; i < m_params.m_poisPerBlock; ++i)
+    {
+      m2::PointD const point(m_random.Uniform(block.minX(), block.maxX()),
+                             m_random.Uniform(block.Center().y, block.maxY()));
+      auto const & poi = m_random.Choose(kPois);
+      Tags tags{{poi.m_key, poi.m_value}};
+      if (m_random.Index(10) < 7)
+        tags.emplace_back("name", MakeName());
+      if (m_random.Index(2) == 0)
+      {
+        tags.emplace_back("addr:street", street);
+        tags.emplace_back("addr:housenumber", std::to_string(houseNumber));
+        houseNumber += 1 + m_random.Index(2);
+      }
+      AddNode(point, std::move(tags));
+    }
+  }
+
+  // Writes the boundary of |rect| which is inside |cell|. The vertices of the sides are moved
+  // out of |rect| by the random offsets within the margin to |cell|, so the boundaries of
+  // the cells do not intersect and the nested boundaries are inside.
+  void WriteBoundary(m2::RectD const & rect, m2::RectD const & cell, int adminLevel,
+                     std::string const & name, Tags && tags, uint64_t label = 0)
+  {
+    auto const margin = std::min({rect.minX() - cell.minX(), rect.minY() - cell.minY(),
+                                  cell.maxX() - rect.maxX(), cell.maxY() - rect.maxY()});
+    m2::PointD const corners[] = {{rect.minX(), rect.minY()},
+                                  {rect.maxX(), rect.minY()},
+                                  {rect.maxX(), rect.maxY()},
+                                  {rect.minX(), rect.maxY()}};
+    m2::PointD const normals[] = {{0.0, -1.0}, {1.0, 0.0}, {0.0, 1.0}, {-1.0, 0.0}};
+    auto const pointsPerSide = std::max(m_params.m_boundaryPointsPerSide, 1U);
+
+    std::vector<uint64_t> nodes;
+    nodes.reserve(4 * pointsPerSide + 1);
+    for (size_t side = 0; side < 4; ++side)
+    {
+      auto const & from = corners[side];
+      auto const & to = corners[(side + 1) % 4];
+      for (uint32_t i = 0; i < pointsPerSide; ++i)
+      {
+        auto point = from + (to - from) * (static_cast<double>(i) / pointsPerSide);
+        if (i != 0)
+          point += normals[side] * m_random.Uniform(0.0, margin / 2);
+        nodes.push_back(AddNode(point, {}));
+      }
+    }
+    nodes.push_back(nodes.front());
+    auto const way = AddWay(std::move(nodes), {});
+
+    std::vector<OsmElement::Member> members{{way, OsmElement::EntityType::Way, "outer"}};
+    if (label != 0)
+      members.emplace_back(label, OsmElement::EntityType::Node, "label");
+    tags.emplace_back("type", "boundary");
+    tags.emplace_back("boundary", "administrative");
+    tags.emplace_back("admin_level", std::to_string(adminLevel));
+    tags.emplace_back("name", name);
+    tags.emplace_back("name:en", name);
+    AddRelation(std::move(members), std::move(tags));
+  }
+
+  static char const * GetHighway(uint32_t street, uint32_t streetsCount)
+  {
+    if (street == streetsCount / 2)
+      return "primary";
+    if (street % 5 == 0)
+      return "secondary";
+    if (street % 3 == 0)
+      return "tertiary";
+    return "residential";
+  }
+
+  std::string MakeName()
+  {
+    std::string name;
+    auto const syllablesCount = 2 + m_random.Index(2);
+    for (uint32_t i = 0; i < syllablesCount; ++i)
+      name += kSyllables[m_random.Index(ARRAY_SIZE(kSyllables))];
+    name.front() = static_cast<char>(name.front() - 'a' + 'A');
+    return name;
+  }
+
+  std::string MakeStreetName()
+  {
+    return MakeName() + " " + kStreetSuffixes[m_random.Index(ARRAY_SIZE(kStreetSuffixes))];
+  }
+
+  uint64_t AddNode(m2::PointD const & point, Tags && tags)
+  {
+    auto const id = ++m_stats.m_nodes;
+    if (m_type == OsmElement::EntityType::Node)
+    {
+      m_element.Clear();
+      m_element.m_type = OsmElement::EntityType::Node;
+      m_element.m_id = id;
+      m_element.m_lon = point.x;
+      m_element.m_lat = point.y;
+      m_element.m_tags = std::move(tags);
+      m_writer.Write(m_element);
+    }
+    return id;
+  }
+
+  uint64_t AddWay(std::vector<uint64_t> && nodes, Tags && tags)
+  {
+    auto const id = ++m_stats.m_ways;
+    if (m_type == OsmElement::EntityType::Way)
+    {
+      m_element.Clear();
+      m_element.m_type = OsmElement::EntityType::Way;
+      m_element.m_id = id;
+      m_element.m_nodes = std::move(nodes);
+      m_element.m_tags = std::move(tags);
+      m_writer.Write(m_element);
+    }
+    return id;
+  }
+
+  uint64_t AddRelation(std::vector<OsmElement::Member> && members, Tags && tags)
+  {
+    auto const id = ++m_stats.m_relations;
+    if (m_type == OsmElement::EntityType::Relation)
+    {
+      m_element.Clear();
+      m_element.m_type = OsmElement::EntityType::Relation;
+      m_element.m_id = id;
+      m_element.m_members = std::move(members);
+      m_element.m_tags = std::move(tags);
+      m_writer.Write(m_element);
+    }
+    return id;
+  }
+
+  SyntheticPlanetParams const & m_params;
+  O5MWriter & m_writer;
+  OsmElement::EntityType const m_type;
+  Random m_random;
+  OsmElement m_element;
+  uint32_t m_countriesCount = 0;
+  SyntheticPlanetStats m_stats;
+};
+}  // namespace
+
+SyntheticPlanetStats GenerateSyntheticPlanet(SyntheticPlanetParams const & params,
+                                             std::string const & filename)
+{
+  O5MWriter writer(filename);
+  SyntheticPlanetStats stats;
+  for (auto const type : {OsmElement::EntityType::Node, OsmElement::EntityType::Way,
+                          OsmElement::EntityType::Relation})
+  {
+    PlanetWriter planetWriter(params, writer, type);
+    planetWriter.Write();
+    stats = planetWriter.GetStats();
+  }
+  writer.Finish();
+
+  LOG(LINFO, ("Synthetic planet", filename, "nodes:", stats.m_nodes, "ways:", stats.m_ways,
+              "relations:", stats.m_relations));
+  return stats;
+}
+}  // namespace generator
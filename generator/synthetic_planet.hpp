@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace generator
+{
+// The parameters of a synthetic planet for the scalability tests of the generator and the
+// geocoder. The countries are laid out by a grid, a country is split into the regions and
+// a region into the subregions by the grids too. A subregion has the cities and the villages,
+// a city has a grid of the named streets and its blocks have the buildings with the addresses
+// and the pois. The counts grow linearly with |m_countriesCount|, see Scale().
+struct SyntheticPlanetParams
+{
+  // Multiplies the countries count by |scale|.
+  void Scale(uint32_t scale) { m_countriesCount *= scale; }
+
+  uint64_t m_seed = 1;
+  uint32_t m_countriesCount = 4;
+  uint32_t m_regionsPerCountry = 4;
+  uint32_t m_subregionsPerRegion = 4;
+  uint32_t m_citiesPerSubregion = 2;
+  uint32_t m_villagesPerSubregion = 4;
+  // The streets of a city in each direction.
+  uint32_t m_streetsPerCity = 10;
+  uint32_t m_buildingsPerBlock = 4;
+  uint32_t m_poisPerBlock = 2;
+  // The vertices of a side of an admin boundary.
+  uint32_t m_boundaryPointsPerSide = 16;
+};
+
+struct SyntheticPlanetStats
+{
+  uint64_t m_nodes = 0;
+  uint64_t m_ways = 0;
+  uint64_t m_relations = 0;
+};
+
+// Writes the planet of |params| to the o5m file |filename|. The planet depends on |params| only,
+// so the files of the same params are the same on all the platforms. The planet is generated
+// by a pass per the elements type, so the memory does not depend on the planet size.
+SyntheticPlanetStats GenerateSyntheticPlanet(SyntheticPlanetParams const & params,
+                                             std::string const & filename);
+}  // namespace generator
@@ -0,0 +1,83 @@
+#include "generator/synthetic_planet.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+using namespace generator;
+using namespace std;
+
+namespace po = boost::program_options;
+
+namespace
+{
+struct Options
+{
+  string m_output;
+  uint32_t m_scale = 1;
+  SyntheticPlanetParams m_params;
+};
+
+Options DefineOptions(int argc, char * argv[])
+{
+  Options o;
+  auto & p = o.m_params;
+  po::options_description optionsDescription;
+
+  optionsDescription.add_options()
+    ("output", po::value(&o.m_output)->default_value(""), "Output o5m file")
+    ("scale", po::value(&o.m_scale)->default_value(1), "Multiplies the countries count, the planet grows linearly with the scale")
+    ("seed", po::value(&p.m_seed)->default_value(p.m_seed), "Seed of the random values, the planets of the same options are the same")
+    ("countries", po::value(&p.m_countriesCount)->default_value(p.m_countriesCount), "Countries count")
+    ("regions_per_country", po::value(&p.m_regionsPerCountry)->default_value(p.m_regionsPerCountry), "Regions of a country")
+    ("subregions_per_region", po::value(&p.m_subregionsPerRegion)->default_value(p.m_subregionsPerRegion), "Subregions of a region")
+    ("cities_per_subregion", po::value(&p.m_citiesPerSubregion)->default_value(p.m_citiesPerSubregion), "Cities of a subregion")
+    ("villages_per_subregion", po::value(&p.m_villagesPerSubregion)->default_value(p.m_villagesPerSubregion), "Villages of a subregion")
+    ("streets_per_city", po::value(&p.m_streetsPerCity)->default_value(p.m_streetsPerCity), "Streets of a city grid in each direction")
+    ("buildings_per_block", po::value(&p.m_buildingsPerBlock)->default_value(p.m_buildingsPerBlock), "Buildings with the addresses of a city block")
+    ("pois_per_block", po::value(&p.m_poisPerBlock)->default_value(p.m_poisPerBlock), "Pois of a city block")
+    ("boundary_points_per_side", po::value(&p.m_boundaryPointsPerSide)->default_value(p.m_boundaryPointsPerSide), "Vertices of a side of an admin boundary")
+    ("help", "produce help message");
+
+  po::variables_map vm;
+
+  po::store(po::parse_command_line(argc, argv, optionsDescription), vm);
+  po::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << optionsDescription << std::endl;
+    exit(1);
+  }
+
+  return o;
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  Options options;
+  try
+  {
+    options = DefineOptions(argc, argv);
+  }
+  catch(po::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    return 1;
+  }
+
+  if (options.m_output.empty() || options.m_scale == 0)
+  {
+    std::cerr << "ERROR: output and a positive scale are required" << std::endl;
+    return 1;
+  }
+
+  options.m_params.Scale(options.m_scale);
+  auto const stats = GenerateSyntheticPlanet(options.m_params, options.m_output);
+  cout << "nodes: " << stats.m_nodes << ", ways: " << stats.m_ways
+       << ", relations: " << stats.m_relations << endl;
+  return 0;
+}
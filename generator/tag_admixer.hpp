@@ -4,15 +4,19 @@
 
 #include "base/logging.hpp"
 #include "base/stl_helpers.hpp"
+#include "base/string_interner.hpp"
 #include "base/string_utils.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 
 class WaysParserHelper
@@ -169,16 +173,24 @@ public:
         values.push_back(*iter);
 
       if (values.size() >= 2 && values.size() % 2 == 0)
-        m_entries[tag].swap(values);
+      {
+        auto const id = GetTagId(m_strings.Intern(tag.m_key), m_strings.Intern(tag.m_value));
+        m_entries[id].swap(values);
+      }
     }
   }
 
-  TagReplacer(TagReplacer const & other) : m_entries(other.m_entries) {}
+  TagReplacer(TagReplacer const & other) : m_strings(other.m_strings), m_entries(other.m_entries)
+  {
+  }
 
   TagReplacer & operator=(TagReplacer const & other)
   {
     if (this != &other)
+    {
+      m_strings = other.m_strings;
       m_entries = other.m_entries;
+    }
 
     return *this;
   }
@@ -187,7 +199,16 @@ public:
   {
     for (auto & tag : element.m_tags)
     {
-      auto it = m_entries.find(tag);
+      // The tags with the strings which are not in the table are rejected by the interner,
+      // the rest are found by the integer ids.
+      auto const key = m_strings.Find(tag.m_key);
+      if (key == base::StringInterner::kInvalidId)
+        continue;
+      auto const value = m_strings.Find(tag.m_value);
+      if (value == base::StringInterner::kInvalidId)
+        continue;
+
+      auto it = m_entries.find(GetTagId(key, value));
       if (it != m_entries.end())
       {
         auto const & v = it->second;
@@ -200,7 +221,14 @@ public:
   }
 
 private:
-  std::map<OsmElement::Tag, std::vector<std::string>> m_entries;
+  static uint64_t GetTagId(base::StringInterner::Id key, base::StringInterner::Id value)
+  {
+    return (static_cast<uint64_t>(key) << 32) | value;
+  }
+
+  // The keys and the values of the replaced tags.
+  base::StringInterner m_strings;
+  std::unordered_map<uint64_t, std::vector<std::string>> m_entries;
 };
 
 class OsmTagMixer
@@ -0,0 +1,29 @@
+#include "generator/tag_keys_signature.hpp"
+
+#include "generator/osm_element.hpp"
+
+namespace generator
+{
+TagKeysSignature::Mask TagKeysSignature::AddKeys(std::vector<std::string> const & keys)
+{
+  Mask mask = 0;
+  for (auto const & key : keys)
+  {
+    auto const bit = Mask{1} << (m_masks.size() % 64);
+    mask |= m_masks.emplace(key, bit).first->second;
+  }
+  return mask;
+}
+
+TagKeysSignature::Mask TagKeysSignature::Get(OsmElement const & element) const
+{
+  Mask signature = 0;
+  for (auto const & tag : element.Tags())
+  {
+    auto const it = m_masks.find(tag.m_key);
+    if (it != m_masks.end())
+      signature |= it->second;
+  }
+  return signature;
+}
+}  // namespace generator
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct OsmElement;
+
+namespace generator
+{
+// A signature of an element is a bit mask of the keys of its tags among the registered keys.
+// It is computed by one pass over the tags, after that a filter which requires some keys
+// rejects the element by one bitwise and. There are only 64 bits, so different keys may share
+// a bit: a nonzero intersection means that an element may have one of the keys, not that it has.
+class TagKeysSignature
+{
+public:
+  using Mask = uint64_t;
+
+  // Registers |keys| and returns their mask. The mask of an empty list is zero.
+  Mask AddKeys(std::vector<std::string> const & keys);
+
+  Mask Get(OsmElement const & element) const;
+
+  bool IsEmpty() const { return m_masks.empty(); }
+
+private:
+  std::unordered_map<std::string, Mask> m_masks;
+};
+}  // namespace generator
@@ -1,64 +1,137 @@
 #include "towns_dumper.hpp"
 
 #include "geometry/distance_on_sphere.hpp"
-#include "geometry/tree4d.hpp"
 
 #include "base/logging.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <limits>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace
 {
 uint64_t constexpr kTownsEqualityMeters = 500000;
+
+// A static grid of the mercator plane with the kept towns for the neighbourhood queries.
+class TownsGrid
+{
+public:
+  explicit TownsGrid(double cellSize) : m_cellSize(cellSize) {}
+
+  void Add(m2::PointD const & point, size_t index)
+  {
+    m_cells[GetKey(GetCoord(point.x), GetCoord(point.y))].push_back(index);
+  }
+
+  template <typename ToDo>
+  void ForEachInRect(m2::RectD rect, ToDo && toDo) const
+  {
+    if (!rect.Intersect(MercatorBounds::FullRect()))
+      return;
+
+    for (auto x = GetCoord(rect.minX()); x <= GetCoord(rect.maxX()); ++x)
+    {
+      for (auto y = GetCoord(rect.minY()); y <= GetCoord(rect.maxY()); ++y)
+      {
+        auto const it = m_cells.find(GetKey(x, y));
+        if (it == m_cells.end())
+          continue;
+
+        for (auto const index : it->second)
+          toDo(index);
+      }
+    }
+  }
+
+private:
+  int32_t GetCoord(double c) const { return static_cast<int32_t>(std::floor(c / m_cellSize)); }
+
+  static uint64_t GetKey(int32_t x, int32_t y)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+  }
+
+  double m_cellSize;
+  std::unordered_map<uint64_t, std::vector<size_t>> m_cells;
+};
 }  // namespace
 
 TownsDumper::TownsDumper() {}
 void TownsDumper::FilterTowns()
 {
   LOG(LINFO, ("Preprocessing started. Have", m_records.size(), "towns."));
-  m4::Tree<Town> resultTree;
-  std::vector<Town> towns;
-  towns.reserve(m_records.size());
-  for (auto const & town : m_records)
-  {
-    if (town.capital)
-      resultTree.Add(town);
-    else
-      towns.push_back(town);
-  }
-  sort(towns.begin(), towns.end());
 
-  LOG(LINFO, ("Tree of capitals has size", resultTree.GetSize(), "towns has size:", towns.size()));
-  m_records.clear();
+  // All the capitals are kept. The other towns are taken by the descending population and a town
+  // is dropped when a kept one is closer than kTownsEqualityMeters.
+  std::sort(m_records.begin(), m_records.end(), [](Town const & lhs, Town const & rhs) {
+    if (lhs.capital != rhs.capital)
+      return lhs.capital;
+    if (lhs.population != rhs.population)
+      return lhs.population > rhs.population;
+    return lhs.id < rhs.id;
+  });
 
-  while (!towns.empty())
+  auto const cellSize =
+      MercatorBounds::RectByCenterXYAndSizeInMeters(m2::PointD::Zero(), kTownsEqualityMeters)
+          .SizeX();
+  TownsGrid grid(cellSize);
+  size_t count = 0;
+  for (size_t i = 0; i < m_records.size(); ++i)
   {
-    auto const & top = towns.back();
+    auto const & town = m_records[i];
+    auto const center = MercatorBounds::FromLatLon(town.point);
     bool isUniq = true;
-    resultTree.ForEachInRect(
-        MercatorBounds::RectByCenterXYAndSizeInMeters(MercatorBounds::FromLatLon(top.point),
-                                                      kTownsEqualityMeters),
-        [&top, &isUniq](Town const & candidate)
-        {
-          if (ms::DistanceOnEarth(top.point, candidate.point) < kTownsEqualityMeters)
-            isUniq = false;
-        });
-    if (isUniq)
-      resultTree.Add(top);
-    towns.pop_back();
+    if (!town.capital)
+    {
+      grid.ForEachInRect(
+          MercatorBounds::RectByCenterXYAndSizeInMeters(center, kTownsEqualityMeters),
+          [this, &town, &isUniq](size_t index) {
+            if (ms::DistanceOnEarth(town.point, m_records[index].point) < kTownsEqualityMeters)
+              isUniq = false;
+          });
+    }
+
+    if (!isUniq)
+      continue;
+
+    m_records[count] = town;
+    grid.Add(center, count);
+    ++count;
   }
+  m_records.erase(m_records.begin() + count, m_records.end());
 
-  resultTree.ForEach([this](Town const & town)
-                     {
-                       m_records.push_back(town);
-                     });
   LOG(LINFO, ("Preprocessing finished. Have", m_records.size(), "towns."));
 }
 
 void TownsDumper::CheckElement(OsmElement const & em, bool /* concurrent */)
+{
+  std::vector<Town> towns;
+  CheckElement(em, towns);
+  if (towns.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock{m_updateMutex};
+  m_records.insert(m_records.end(), towns.begin(), towns.end());
+}
+
+void TownsDumper::CheckElements(std::vector<OsmElement> const & elements, bool /* concurrent */)
+{
+  std::vector<Town> towns;
+  for (auto const & em : elements)
+    CheckElement(em, towns);
+  if (towns.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock{m_updateMutex};
+  m_records.insert(m_records.end(), towns.begin(), towns.end());
+}
+
+// static
+void TownsDumper::CheckElement(OsmElement const & em, std::vector<Town> & towns)
 {
   if (em.m_type != OsmElement::EntityType::Node)
     return;
@@ -96,10 +169,7 @@ void TownsDumper::CheckElement(OsmElement const & em, bool /* concurrent */)
     capital = false;
 
   if (town || capital)
-  {
-    std::lock_guard<std::mutex> lock{m_updateMutex};
-    m_records.emplace_back(em.m_lat, em.m_lon, em.m_id, capital, population);
-  }
+    towns.emplace_back(em.m_lat, em.m_lon, em.m_id, capital, population);
 }
 
 void TownsDumper::Dump(std::string const & filePath)
@@ -18,6 +18,8 @@ public:
   TownsDumper();
 
   void CheckElement(OsmElement const & em, bool concurrent);
+  // Checks |elements| with a local buffer of the towns, the towns are added under a single lock.
+  void CheckElements(std::vector<OsmElement> const & elements, bool concurrent);
 
   void Dump(std::string const & filePath);
 
@@ -35,14 +37,11 @@ private:
       : point(lat, lon), id(id), capital(isCapital), population(population)
     {
     }
-
-    bool operator<(Town const & rhs) const { return population < rhs.population; }
-    m2::RectD GetLimitRect() const
-    {
-      return m2::RectD(MercatorBounds::FromLatLon(point), MercatorBounds::FromLatLon(point));
-    }
   };
 
+  // Adds |em| to |towns| if it is a town.
+  static void CheckElement(OsmElement const & em, std::vector<Town> & towns);
+
   std::vector<Town> m_records;
   std::mutex m_updateMutex;
 };
@@ -76,5 +76,5 @@ std::string GetTranslatedOrTransliteratedName(StringUtf8Multilang const & name,
   return std::string();
 }
 
-Languages const & Localizator::LocaleLanguages() const { return kLocalelanguages; }
+Languages const & LocaleLanguages() { return kLocalelanguages; }
 }  // namespace generator
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "generator/json_writer.hpp"
+
 #include "coding/string_utf8_multilang.hpp"
 
 #include "3party/jansson/myjansson.hpp"
@@ -29,7 +31,67 @@ inline std::string GetName(StringUtf8Multilang const & name, LanguageCode lang)
 std::string GetTranslatedOrTransliteratedName(StringUtf8Multilang const & name,
                                               LanguageCode languageCode);
 
-class Localizator
+// Languages of the locales besides the default one.
+std::vector<std::string> const & LocaleLanguages();
+
+// |Node| is a jansson object or the changes of a jansson object which are streamed by JsonWriter.
+template <typename Node>
+struct LocalizatorNode;
+
+template <>
+struct LocalizatorNode<json_t>
+{
+  static json_t & GetOrCreate(json_t & root, std::string const & nodeName)
+  {
+    json_t * node = base::GetJSONOptionalField(&root, nodeName);
+    if (!node || base::JSONIsNull(node))
+    {
+      node = json_object();
+      ToJSONObject(root, nodeName, *node);
+    }
+
+    return *node;
+  }
+
+  static json_t * Get(json_t & root, std::string const & nodeName)
+  {
+    return base::GetJSONOptionalField(&root, nodeName);
+  }
+
+  static void Set(json_t & node, std::string const & label, std::string const & name)
+  {
+    ToJSONObject(node, label, name);
+  }
+
+  static void Remove(json_t & node, std::string const & label)
+  {
+    json_object_del(&node, label.c_str());
+  }
+};
+
+template <>
+struct LocalizatorNode<JsonObjectPatch>
+{
+  static JsonObjectPatch & GetOrCreate(JsonObjectPatch & root, std::string const & nodeName)
+  {
+    return root.GetOrCreateObject(nodeName);
+  }
+
+  static JsonObjectPatch * Get(JsonObjectPatch & root, std::string const & nodeName)
+  {
+    return root.GetObject(nodeName);
+  }
+
+  static void Set(JsonObjectPatch & node, std::string const & label, std::string const & name)
+  {
+    node.Set(label, name);
+  }
+
+  static void Remove(JsonObjectPatch & node, std::string const & label) { node.Remove(label); }
+};
+
+template <typename Node>
+class BasicLocalizator
 {
 public:
   class EasyObjectWithTranslation
@@ -50,7 +112,7 @@ public:
     StringUtf8Multilang const m_name;
   };
 
-  explicit Localizator(json_t & node) : m_node(GetOrCreateNode("locales", node)) {}
+  explicit BasicLocalizator(Node & node) : m_node(GetOrCreateNode("locales", node)) {}
 
   template <class Object>
   void SetLocale(std::string const & label, Object const & objectWithName,
@@ -79,8 +141,8 @@ public:
   template <class Verboser>
   void AddVerbose(Verboser && verboser, std::string const & level)
   {
-    json_t & locale = GetOrCreateNode(DefaultLocaleName(), m_node);
-    json_t & node = GetOrCreateNode(level, locale);
+    Node & locale = GetOrCreateNode(DefaultLocaleName(), m_node);
+    Node & node = GetOrCreateNode(level, locale);
     verboser(node);
   }
 
@@ -88,16 +150,16 @@ private:
   void AddLocale(std::string const & language, std::string const & level, std::string const & name,
                  std::string const & label)
   {
-    json_t & locale = GetOrCreateNode(language, m_node);
+    Node & locale = GetOrCreateNode(language, m_node);
 
     if (!level.empty())
     {
-      json_t & levelNode = GetOrCreateNode(level, locale);
-      ToJSONObject(levelNode, label, name);
+      Node & levelNode = GetOrCreateNode(level, locale);
+      LocalizatorNode<Node>::Set(levelNode, label, name);
     }
     else
     {
-      ToJSONObject(locale, label, name);
+      LocalizatorNode<Node>::Set(locale, label, name);
     }
   }
 
@@ -107,37 +169,32 @@ private:
     return kDefaultLocaleName;
   }
 
-  static json_t & GetOrCreateNode(std::string const & nodeName, json_t & root)
+  static Node & GetOrCreateNode(std::string const & nodeName, Node & root)
   {
-    json_t * node = base::GetJSONOptionalField(&root, nodeName);
-    if (!node || base::JSONIsNull(node))
-    {
-      node = json_object();
-      ToJSONObject(root, nodeName, *node);
-    }
-
-    return *node;
+    return LocalizatorNode<Node>::GetOrCreate(root, nodeName);
   }
 
   void RemoveLocale(std::string const & language, std::string const & level,
                     std::string const & label)
   {
-    json_t * node = base::GetJSONOptionalField(&m_node, language);
+    Node * node = LocalizatorNode<Node>::Get(m_node, language);
     if (!node)
       return;
 
     if (!level.empty())
     {
-      node = base::GetJSONOptionalField(node, level);
+      node = LocalizatorNode<Node>::Get(*node, level);
       if (!node)
         return;
     }
 
-    json_object_del(node, label.c_str());
+    LocalizatorNode<Node>::Remove(*node, label);
   }
 
-  std::vector<std::string> const & LocaleLanguages() const;
-
-  json_t & m_node;
+  Node & m_node;
 };
+
+using Localizator = BasicLocalizator<json_t>;
+// Localizator of the values which are streamed by JsonWriter.
+using PatchLocalizator = BasicLocalizator<JsonObjectPatch>;
 }  // namespace generator
@@ -23,6 +23,7 @@ Translator::Translator(std::shared_ptr<FeatureProcessorInterface> const & proces
   , m_cache(cache)
 {
   m_featureMaker->SetCache(cache);
+  UpdateRequiredKeys();
 }
 
 Translator::Translator(std::shared_ptr<FeatureProcessorInterface> const & processor,
@@ -40,10 +41,14 @@ void Translator::SetCollector(std::shared_ptr<CollectorInterface> const & collec
 void Translator::SetFilter(std::shared_ptr<FilterInterface> const & filter)
 {
   m_filter = filter;
+  UpdateRequiredKeys();
 }
 
 void Translator::Emit(OsmElement & element)
 {
+  if (m_requiredMask != 0 && (m_requiredKeys.Get(element) & m_requiredMask) == 0)
+    return;
+
   if (!m_filter->IsAccepted(element))
     return;
 
@@ -68,6 +73,12 @@ void Translator::Finish()
   m_processor->Finish();
 }
 
+void Translator::UpdateRequiredKeys()
+{
+  m_requiredKeys = {};
+  m_requiredMask = m_requiredKeys.AddKeys(m_filter->GetRequiredTagKeys());
+}
+
 bool Translator::Save()
 {
   m_collector->Save();
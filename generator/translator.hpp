@@ -6,6 +6,7 @@
 #include "generator/intermediate_data.hpp"
 #include "generator/processor_interface.hpp"
 #include "generator/relation_tags_enricher.hpp"
+#include "generator/tag_keys_signature.hpp"
 #include "generator/translator_interface.hpp"
 
 #include <memory>
@@ -55,6 +56,8 @@ protected:
     return std::make_shared<T>(processor, cache, featureMaker, filter, collector);
   }
 
+  void UpdateRequiredKeys();
+
   void MergeIntoBase(Translator & other) const
   {
     other.m_collector->Merge(*m_collector);
@@ -62,6 +65,10 @@ protected:
   }
 
   std::shared_ptr<FilterInterface> m_filter;
+  // The keys required by |m_filter|, an element without any of them is rejected before
+  // the filter is called.
+  TagKeysSignature m_requiredKeys;
+  TagKeysSignature::Mask m_requiredMask = 0;
   std::shared_ptr<CollectorInterface> m_collector;
   RelationTagsEnricher m_tagsEnricher;
   std::shared_ptr<FeatureMakerBase> m_featureMaker;
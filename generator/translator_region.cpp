@@ -76,6 +76,11 @@ bool FilterRegions::IsAccepted(FeatureBuilder const & feature)
   return feature.GetParams().IsValid() && !feature.IsLine();
 }
 
+std::vector<std::string> FilterRegions::GetRequiredTagKeys() const
+{
+  return {"place", "place:PH", "boundary"};
+}
+
 bool FilterRegions::IsEnclaveBoundaryWay(OsmElement const & element) const
 {
   if (!element.IsWay() || !IsGeometryClosed(element))
@@ -42,6 +42,7 @@ public:
   std::shared_ptr<FilterInterface> Clone() const override;
   bool IsAccepted(OsmElement const & element) override;
   bool IsAccepted(feature::FeatureBuilder const & feature) override;
+  std::vector<std::string> GetRequiredTagKeys() const override;
 
 protected:
   bool IsEnclaveBoundaryWay(OsmElement const & element) const;
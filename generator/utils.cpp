@@ -10,6 +10,8 @@
 #include "base/cancellable.hpp"
 #include "base/logging.hpp"
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 namespace generator
@@ -37,16 +39,14 @@ void LoadDataSource(DataSource & dataSource)
   platform::FindAllLocalMapsInDirectoryAndCleanup(platform.WritableDir(), 0 /* version */,
                                                   -1 /* latestVersion */, localFiles);
   for (auto const & localFile : localFiles)
-  {
     LOG(LINFO, ("Found mwm:", localFile));
-    try
-    {
-      dataSource.RegisterMap(localFile);
-    }
-    catch (RootException const & ex)
-    {
-      CHECK(false, (ex.Msg(), "Bad mwm file:", localFile));
-    }
+
+  auto const results =
+      dataSource.RegisterMaps(localFiles, std::max(std::thread::hardware_concurrency(), 1u));
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    CHECK_NOT_EQUAL(results[i].second, MwmSet::RegResult::BadFile,
+                    ("Bad mwm file:", localFiles[i]));
   }
 }
 
@@ -2,6 +2,9 @@
 
 namespace generator
 {
+// static
+size_t constexpr AreaWayMerger::kInvalidIndex;
+
 AreaWayMerger::AreaWayMerger(std::shared_ptr<cache::IntermediateDataReader> const & cache) :
   m_cache(cache)
 {
@@ -9,11 +12,49 @@ AreaWayMerger::AreaWayMerger(std::shared_ptr<cache::IntermediateDataReader> cons
 
 void AreaWayMerger::AddWay(uint64_t id)
 {
-  auto e = std::make_shared<WayElement>(id);
-  if (m_cache->GetWay(id, *e) && e->IsValid())
+  WayElement e(id);
+  if (m_cache->GetWay(id, e))
+    AddWay(std::move(e));
+}
+
+void AreaWayMerger::AddWays(std::vector<uint64_t> const & ids)
+{
+  m_ways.reserve(m_ways.size() + ids.size());
+  m_ends.reserve(m_ends.size() + 2 * ids.size());
+  m_waysByEnd.reserve(m_waysByEnd.size() + 2 * ids.size());
+  m_cache->ForEachWay(ids, [this](uint64_t /* id */, WayElement & way) {
+    AddWay(std::move(way));
+  });
+}
+
+void AreaWayMerger::AddWay(WayElement && e)
+{
+  if (!e.IsValid())
+    return;
+
+  auto const index = m_ways.size();
+  auto const front = e.nodes.front();
+  auto const back = e.nodes.back();
+  m_ways.push_back(std::move(e));
+
+  m_ends.emplace_back(front, index);
+  m_ends.emplace_back(back, index);
+  m_waysByEnd[front].push_back(index);
+  m_waysByEnd[back].push_back(index);
+}
+
+size_t AreaWayMerger::GetLastNotUsedWay(uint64_t endId, std::vector<bool> const & used) const
+{
+  auto const it = m_waysByEnd.find(endId);
+  if (it == m_waysByEnd.cend())
+    return kInvalidIndex;
+
+  auto const & ways = it->second;
+  for (size_t i = ways.size(); i > 0; --i)
   {
-    m_map.emplace(e->nodes.front(), e);
-    m_map.emplace(e->nodes.back(), e);
+    if (!used[ways[i - 1]])
+      return ways[i - 1];
   }
+  return kInvalidIndex;
 }
 }  // namespace generator
@@ -5,9 +5,14 @@
 
 #include "geometry/point2d.hpp"
 
+#include "base/buffer_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -16,67 +21,77 @@ namespace generator
 class AreaWayMerger
 {
   using PointSeq = std::vector<m2::PointD>;
-  using WayMap = std::multimap<uint64_t, std::shared_ptr<WayElement>>;
-  using WayMapIterator = WayMap::iterator;
 
 public:
   explicit AreaWayMerger(std::shared_ptr<cache::IntermediateDataReader> const & cache);
 
   void AddWay(uint64_t id);
+  // Reads all the ways by one batch, see IntermediateDataReader::ForEachWay().
+  void AddWays(std::vector<uint64_t> const & ids);
 
   template <class ToDo>
   void ForEachArea(bool collectID, ToDo toDo)
   {
-    while (!m_map.empty())
+    // The rings are started from the ends with the least node ids, like by an ordered multimap
+    // of the ends, but the next way of a ring is found by the hash table in O(1).
+    std::stable_sort(m_ends.begin(), m_ends.end(),
+                     [](auto const & lhs, auto const & rhs) { return lhs.first < rhs.first; });
+
+    std::vector<bool> used(m_ways.size(), false);
+    std::vector<m2::PointD> wayPoints;
+    for (auto const & end : m_ends)
     {
-      // start
-      WayMapIterator i = m_map.begin();
-      uint64_t id = i->first;
+      size_t curr = end.second;
+      if (used[curr])
+        continue;
 
+      uint64_t id = end.first;
       std::vector<uint64_t> ids;
       PointSeq points;
-
-      do
+      while (curr != kInvalidIndex)
       {
+        used[curr] = true;
+
         // process way points
-        std::shared_ptr<WayElement> e = i->second;
+        WayElement & e = m_ways[curr];
         if (collectID)
-          ids.push_back(e->m_wayOsmId);
+          ids.push_back(e.m_wayOsmId);
 
-        e->ForEachPointOrdered(id, [this, &points](uint64_t id)
-        {
-          m2::PointD pt;
-          if (m_cache->GetNode(id, pt.y, pt.x))
+        // The points which are not found are zero and skipped.
+        m_cache->GetNodes(e.nodes, wayPoints);
+        auto const addPoint = [&points](m2::PointD const & pt) {
+          if (pt != m2::PointD::Zero())
             points.push_back(pt);
-        });
-
-        m_map.erase(i);
+        };
+        if (id == e.nodes.front())
+          std::for_each(wayPoints.cbegin(), wayPoints.cend(), addPoint);
+        else
+          std::for_each(wayPoints.crbegin(), wayPoints.crend(), addPoint);
 
         // next 'id' to process
-        id = e->GetOtherEndPoint(id);
-        std::pair<WayMapIterator, WayMapIterator> r = m_map.equal_range(id);
-
-        // finally erase element 'e' and find next way in chain
-        i = r.second;
-        while (r.first != r.second)
-        {
-          if (r.first->second == e)
-            m_map.erase(r.first++);
-          else
-            i = r.first++;
-        }
-
-        if (i == r.second)
-          break;
-      } while (true);
+        id = e.GetOtherEndPoint(id);
+        curr = GetLastNotUsedWay(id, used);
+      }
 
       if (points.size() > 2 && points.front() == points.back())
         toDo(points, ids);
     }
+
+    m_ways.clear();
+    m_ends.clear();
+    m_waysByEnd.clear();
   }
 
 private:
+  static size_t constexpr kInvalidIndex = std::numeric_limits<size_t>::max();
+
+  void AddWay(WayElement && e);
+  size_t GetLastNotUsedWay(uint64_t endId, std::vector<bool> const & used) const;
+
   std::shared_ptr<cache::IntermediateDataReader> m_cache;
-  WayMap m_map;
+  std::vector<WayElement> m_ways;
+  // The end node ids with the indexes of |m_ways| in the order of adding.
+  std::vector<std::pair<uint64_t, size_t>> m_ends;
+  std::unordered_map<uint64_t, buffer_vector<size_t, 2>> m_waysByEnd;
 };
 }  // namespace generator
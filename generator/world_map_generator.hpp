@@ -10,9 +10,9 @@
 
 #include "coding/point_coding.hpp"
 
+#include "geometry/packed_tree4d.hpp"
 #include "geometry/polygon.hpp"
 #include "geometry/region2d.hpp"
-#include "geometry/tree4d.hpp"
 
 #include "base/logging.hpp"
 
@@ -33,7 +33,7 @@ class WaterBoundaryChecker
   {
     m2::RectD const & LimitRect(m2::RegionD const & r) const { return r.GetRect(); }
   };
-  m4::Tree<m2::RegionD, RegionTraits> m_tree;
+  m4::PackedTree<m2::RegionD, RegionTraits> m_tree;
 
   size_t m_totalFeatures = 0;
   size_t m_totalBorders = 0;
@@ -79,6 +79,7 @@ public:
         m_tree.Add(m2::RegionD(move(points)));
       }
     }
+    m_tree.Build();
     LOG_SHORT(LINFO, ("Load", total, "water geometries"));
   }
 
@@ -0,0 +1,165 @@
+#include "geocoder/binary_hierarchy.hpp"
+
+#include "geocoder/hierarchy.hpp"
+
+#include "coding/read_write_utils.hpp"
+#include "coding/varint.hpp"
+#include "coding/write_to_sink.hpp"
+#include "coding/writer.hpp"
+
+#include "base/exception.hpp"
+
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace geocoder
+{
+namespace
+{
+char const kMagic[] = {'\0', 'G', 'H', 'B'};
+
+uint8_t constexpr kHasNameFlag = 1;
+}  // namespace
+
+// BinaryHierarchyEntry ----------------------------------------------------------------------------
+void BinaryHierarchyEntry::Clear()
+{
+  m_osmId = base::GeoObjectId(base::GeoObjectId::kInvalid);
+  m_kind = Kind::Unknown;
+  m_rank = 0;
+  m_hasName = false;
+  for (auto & names : m_address)
+    names.clear();
+}
+
+// BinaryHierarchyChunkHeader ----------------------------------------------------------------------
+// static
+size_t constexpr BinaryHierarchyChunkHeader::kSize;
+// static
+uint32_t constexpr BinaryHierarchyChunkHeader::kVersion;
+
+// static
+bool BinaryHierarchyChunkHeader::IsChunkStart(int firstByte) { return firstByte == kMagic[0]; }
+
+bool BinaryHierarchyChunkHeader::Read(char const * data)
+{
+  if (memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    return false;
+
+  ReaderSource<MemReader> source(MemReader(data + sizeof(kMagic), kSize - sizeof(kMagic)));
+  m_version = ReadPrimitiveFromSource<uint32_t>(source);
+  m_entriesSize = ReadPrimitiveFromSource<uint64_t>(source);
+  return true;
+}
+
+void BinaryHierarchyChunkHeader::Write(string & out) const
+{
+  MemWriter<string> writer(out);
+  writer.Seek(out.size());
+  writer.Write(kMagic, sizeof(kMagic));
+  WriteToSink(writer, m_version);
+  WriteToSink(writer, m_entriesSize);
+}
+
+// BinaryHierarchyChunkBuilder ---------------------------------------------------------------------
+void BinaryHierarchyChunkBuilder::Add(BinaryHierarchyEntry const & entry)
+{
+  MemWriter<string> writer(m_entries);
+  writer.Seek(m_entries.size());
+  WriteVarUint(writer, entry.m_osmId.GetEncodedId());
+  WriteToSink(writer, static_cast<uint8_t>(entry.m_kind));
+  WriteToSink(writer, entry.m_rank);
+  WriteToSink(writer, static_cast<uint8_t>(entry.m_hasName ? kHasNameFlag : 0));
+
+  // The fields without the names are not written, the count is set after the fields.
+  auto const fieldsCountPos = m_entries.size();
+  WriteToSink(writer, uint8_t{0});
+  uint8_t fieldsCount = 0;
+  for (size_t type = 0; type < entry.m_address.size(); ++type)
+  {
+    auto const & names = entry.m_address[type];
+    if (names.empty())
+      continue;
+
+    auto const fieldPos = m_entries.size();
+    WriteToSink(writer, static_cast<uint8_t>(type));
+    // The count is set after the names.
+    WriteToSink(writer, uint8_t{0});
+    uint8_t namesCount = 0;
+    for (auto const & name : names)
+    {
+      Hierarchy::Entry::NormalizeName(name.second, m_tokens, m_normalizedName);
+      if (m_normalizedName.empty())
+        continue;
+
+      rw::Write(writer, name.first);
+      rw::Write(writer, m_normalizedName);
+      CHECK_LESS(namesCount, numeric_limits<uint8_t>::max(), ());
+      ++namesCount;
+    }
+
+    if (namesCount == 0)
+    {
+      m_entries.resize(fieldPos);
+      writer.Seek(fieldPos);
+      continue;
+    }
+    m_entries[fieldPos + 1] = static_cast<char>(namesCount);
+    ++fieldsCount;
+  }
+  m_entries[fieldsCountPos] = static_cast<char>(fieldsCount);
+}
+
+string BinaryHierarchyChunkBuilder::Release()
+{
+  string chunk;
+  chunk.reserve(BinaryHierarchyChunkHeader::kSize + m_entries.size());
+
+  BinaryHierarchyChunkHeader header;
+  header.m_entriesSize = m_entries.size();
+  header.Write(chunk);
+  chunk += m_entries;
+  m_entries.clear();
+  return chunk;
+}
+
+// BinaryHierarchyChunkReader ----------------------------------------------------------------------
+BinaryHierarchyChunkReader::BinaryHierarchyChunkReader(string const & entries)
+  : m_source(MemReaderWithExceptions(entries.data(), entries.size()))
+{
+}
+
+bool BinaryHierarchyChunkReader::Read(BinaryHierarchyEntry & entry)
+{
+  if (m_source.Size() == 0)
+    return false;
+
+  entry.Clear();
+  entry.m_osmId = base::GeoObjectId(ReadVarUint<uint64_t>(m_source));
+  auto const kind = ReadPrimitiveFromSource<uint8_t>(m_source);
+  if (kind >= static_cast<uint8_t>(Kind::Count))
+    MYTHROW(Reader::ReadException, ("Bad kind of the binary hierarchy entry", entry.m_osmId));
+  entry.m_kind = static_cast<Kind>(kind);
+  entry.m_rank = ReadPrimitiveFromSource<uint8_t>(m_source);
+  entry.m_hasName = (ReadPrimitiveFromSource<uint8_t>(m_source) & kHasNameFlag) != 0;
+
+  auto const fieldsCount = ReadPrimitiveFromSource<uint8_t>(m_source);
+  for (uint8_t i = 0; i < fieldsCount; ++i)
+  {
+    auto const type = ReadPrimitiveFromSource<uint8_t>(m_source);
+    if (type >= entry.m_address.size())
+      MYTHROW(Reader::ReadException, ("Bad field of the binary hierarchy entry", entry.m_osmId));
+
+    auto & names = entry.m_address[type];
+    names.resize(ReadPrimitiveFromSource<uint8_t>(m_source));
+    for (auto & name : names)
+    {
+      rw::Read(m_source, name.first);
+      rw::Read(m_source, name.second);
+    }
+  }
+  return true;
+}
+}  // namespace geocoder
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "geocoder/types.hpp"
+
+#include "indexer/search_string_utils.hpp"
+
+#include "coding/reader.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace geocoder
+{
+// The binary hierarchy is the hierarchy entries which the generator writes along with the
+// key-value, so they are loaded by HierarchyReader without formatting and parsing the json.
+// A file is a sequence of the chunks, so the files are concatenated as is. A chunk is a header
+// followed by the entries:
+//   header: the magic | uint32 version | uint64 size of the entries
+//   entry:  varuint encoded osm id | uint8 kind | uint8 rank | uint8 flags | uint8 fields count
+//           | fields
+//   field:  uint8 type | uint8 names count | names
+//   name:   string locale | string normalized name
+// The strings are the varuint size and the bytes. The magic starts with zero byte, so a binary
+// hierarchy is told from a jsonl one by the first byte.
+struct BinaryHierarchyEntry
+{
+  using Name = std::pair<std::string, std::string>;
+
+  void Clear();
+
+  base::GeoObjectId m_osmId = base::GeoObjectId(base::GeoObjectId::kInvalid);
+  Kind m_kind = Kind::Unknown;
+  // See Hierarchy::Entry::SetTypeByAddress().
+  uint8_t m_rank = 0;
+  bool m_hasName = false;
+  // The names of the address fields by the types, the locale and the name of every name.
+  std::array<std::vector<Name>, static_cast<size_t>(Type::Count)> m_address;
+};
+
+struct BinaryHierarchyChunkHeader
+{
+  static size_t constexpr kSize = 16;
+  static uint32_t constexpr kVersion = 1;
+
+  // Returns true if the first byte of a stream is the first byte of a chunk.
+  static bool IsChunkStart(int firstByte);
+
+  // Returns false if |data| of kSize bytes is not a chunk header.
+  bool Read(char const * data);
+  void Write(std::string & out) const;
+
+  uint32_t m_version = kVersion;
+  uint64_t m_entriesSize = 0;
+};
+
+// Builds the chunks of the binary hierarchy. The names of the entries are normalized as
+// Hierarchy::Entry::FetchAddressFieldNames() normalizes the names of the json.
+class BinaryHierarchyChunkBuilder
+{
+public:
+  void Add(BinaryHierarchyEntry const & entry);
+
+  bool IsEmpty() const { return m_entries.empty(); }
+  // Returns the chunk of the added entries and starts a new one.
+  std::string Release();
+
+private:
+  std::string m_entries;
+  search::NormalizedTokens m_tokens;
+  std::string m_normalizedName;
+};
+
+// Reads the entries of a chunk, |entries| must outlive the reader.
+class BinaryHierarchyChunkReader
+{
+public:
+  explicit BinaryHierarchyChunkReader(std::string const & entries);
+
+  // Returns false at the end of the chunk, throws Reader::Exception if the chunk is corrupted.
+  bool Read(BinaryHierarchyEntry & entry);
+
+private:
+  ReaderSource<MemReaderWithExceptions> m_source;
+};
+}  // namespace geocoder
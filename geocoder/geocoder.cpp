@@ -6,25 +6,41 @@
 
 #include "indexer/search_string_utils.hpp"
 
+#include "coding/file_container.hpp"
+#include "coding/file_reader.hpp"
+#include "coding/file_writer.hpp"
+#include "coding/reader.hpp"
+#include "coding/write_to_sink.hpp"
+
 #include "base/assert.hpp"
 #include "base/exception.hpp"
 #include "base/logging.hpp"
+#include "base/prof.hpp"
 #include "base/scope_guard.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
 #include "base/timer.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <numeric>
-#include <set>
+#include <sstream>
 #include <thread>
 #include <utility>
 
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
+#include <boost/crc.hpp>
 #include <boost/exception/exception.hpp>
 #include <boost/exception/diagnostic_information.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/optional.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 
@@ -35,6 +51,61 @@ namespace geocoder
 namespace
 {
 size_t const kMaxResults = 100;
+double const kCityStateExtraWeight = 0.05;
+// Covers the rounding errors of the certainties summed in a different order.
+double const kCertaintyBoundEps = 1e-9;
+// The anchored pass of a query is made when its rarest match has no more docs than
+// kMaxAnchorDocs and another match has kMinAnchorSelectivity times more docs.
+size_t const kMaxAnchorDocs = 64;
+size_t const kMinAnchorSelectivity = 16;
+
+Geocoder::TypesMask ToTypesMask(Type type)
+{
+  return Geocoder::TypesMask{1} << static_cast<size_t>(type);
+}
+
+char const kMappedIndexVersionTag[] = "geocoder_version";
+
+// The binary index is a sequence of the checksummed segments which are serialized and
+// deserialized concurrently. The header is kBinaryIndexMagic, the format version, the number of
+// the segments and the size and the CRC-32 of every segment, the segments follow the header.
+// Every segment is a separate boost binary archive.
+char const kBinaryIndexMagic[] = {'G', 'E', 'O', 'C', 'S', 'E', 'G', 'S'};
+size_t const kBinaryIndexSegmentHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+enum class BinaryIndexSegmentType
+{
+  HierarchyEntries,
+  NameDictionary,
+  TokenPostings,
+  RelatedBuildings,
+  Count
+};
+
+size_t const kBinaryIndexSegmentsCount = static_cast<size_t>(BinaryIndexSegmentType::Count);
+
+struct BinaryIndexSegment
+{
+  std::string m_data;
+  uint32_t m_checksum = 0;
+};
+
+uint32_t ComputeChecksum(std::string const & data)
+{
+  boost::crc_32_type crc;
+  crc.process_bytes(data.data(), data.size());
+  return crc.checksum();
+}
+
+// The binary indexes saved before the segments were introduced are a single boost archive.
+bool IsSegmentedBinaryIndex(FileReader const & reader)
+{
+  if (reader.Size() < sizeof(kBinaryIndexMagic))
+    return false;
+  char magic[sizeof(kBinaryIndexMagic)];
+  reader.Read(0, magic, sizeof(magic));
+  return std::equal(std::begin(magic), std::end(magic), std::begin(kBinaryIndexMagic));
+}
 
 // While Result's |m_certainty| is deliberately vaguely defined,
 // current implementation is a log-prob type measure of our belief
@@ -170,16 +241,74 @@ void Geocoder::Layer::SetCandidates(std::vector<Candidate> && candidates)
   m_candidatesByCertainty = std::move(candidates);
 }
 
+vector<Geocoder::Candidate> Geocoder::Layer::ReleaseCandidates()
+{
+  return std::move(m_candidatesByCertainty);
+}
+
 // Geocoder::Context -------------------------------------------------------------------------------
-Geocoder::Context::Context(string const & query) : m_beam(kMaxResults)
+Geocoder::Context::Context() : m_beam(kMaxResults) {}
+
+Geocoder::Context::Context(string const & query) : Context() { SetQuery(query); }
+
+void Geocoder::Context::SetQuery(string const & query, bool lastTokenIsPrefix)
 {
+  Clear();
   search::NormalizeAndTokenizeAsUtf8(query, m_tokens);
   m_tokenTypes.assign(m_tokens.size(), Type::Count);
+  m_lastTokenIsPrefix = lastTokenIsPrefix && !m_tokens.empty();
+
+  // A subquery looks like a house number only if its first token does: the first token is
+  // parsed to a prefix of the subquery parse.
+  m_houseNumberStarts.resize(m_tokens.size());
+  for (size_t i = 0; i < m_tokens.size(); ++i)
+  {
+    m_houseNumberStarts[i] =
+        search::house_numbers::LooksLikeHouseNumber(m_tokens[i], EndsWithPrefix(i + 1));
+  }
+}
+
+bool Geocoder::Context::EndsWithPrefix(size_t end) const
+{
+  return m_lastTokenIsPrefix && end == m_tokens.size();
+}
+
+bool Geocoder::Context::MayStartHouseNumber(size_t id) const
+{
+  CHECK_LESS(id, m_houseNumberStarts.size(), ());
+  return m_houseNumberStarts[id];
+}
+
+void Geocoder::Context::Clear()
+{
+  m_tokens.clear();
+  m_tokenIds.clear();
+  m_tokenTypes.clear();
+  m_houseNumberStarts.clear();
   m_numUsedTokens = 0;
+  m_houseNumberPositionsInQuery.clear();
+  m_beam.Clear();
+  m_resultsThreshold = 0.0;
+  m_tokenMatchedTypes.clear();
+  m_anchorType = Type::Count;
+  m_anchorDocIds.clear();
+  for (auto & layer : m_layers)
+    ReturnCandidatesBuffer(layer.ReleaseCandidates());
+  m_layers.clear();
 }
 
 vector<Type> & Geocoder::Context::GetTokenTypes() { return m_tokenTypes; }
 
+Tokens const & Geocoder::Context::GetTokens() const { return m_tokens; }
+
+vector<Index::TokenId> & Geocoder::Context::GetTokenIds() { return m_tokenIds; }
+
+Index::TokenId Geocoder::Context::GetTokenId(size_t id) const
+{
+  CHECK_LESS(id, m_tokenIds.size(), ());
+  return m_tokenIds[id];
+}
+
 size_t Geocoder::Context::GetNumTokens() const { return m_tokens.size(); }
 
 size_t Geocoder::Context::GetNumUsedTokens() const
@@ -222,9 +351,10 @@ bool Geocoder::Context::IsTokenUsed(size_t id) const
 bool Geocoder::Context::AllTokensUsed() const { return m_numUsedTokens == m_tokens.size(); }
 
 void Geocoder::Context::AddResult(base::GeoObjectId const & osmId, double certainty, Type type,
-                                  vector<size_t> const & tokensPositions,
-                                  vector<Type> const & allTypes, bool isOtherSimilar)
+                                  TokensPositions const & tokensPositions, TypesMask allTypes,
+                                  bool isOtherSimilar)
 {
+  UPDATE_QUERY_STATS(m_stats, [](QueryStats & stats) { ++stats.m_beamInsertions; });
   m_beam.Add(BeamKey(osmId, type, tokensPositions, allTypes, isOtherSimilar), certainty);
 }
 
@@ -235,12 +365,15 @@ void Geocoder::Context::FillResults(vector<Result> & results) const
 
   auto normalizationCertainty = 0.0;
 
-  set<base::GeoObjectId> seen;
+  // Encoded osm ids: base::GeoObjectId is not default constructible implicitly.
+  buffer_vector<uint64_t, kMaxResults> seen;
   bool const hasPotentialHouseNumber = !m_houseNumberPositionsInQuery.empty();
   for (auto const & e : m_beam.GetEntries())
   {
-    if (!seen.insert(e.m_key.m_osmId).second)
+    auto const encodedId = e.m_key.m_osmId.GetEncodedId();
+    if (find(seen.begin(), seen.end(), encodedId) != seen.end())
       continue;
+    seen.push_back(encodedId);
 
     if (hasPotentialHouseNumber && !IsGoodForPotentialHouseNumberAt(e.m_key, m_houseNumberPositionsInQuery))
       continue;
@@ -266,17 +399,71 @@ void Geocoder::Context::FillResults(vector<Result> & results) const
   ASSERT_LESS_OR_EQUAL(results.size(), kMaxResults, ());
 }
 
+bool Geocoder::Context::IsBelowResultsThreshold(double certainty) const
+{
+  if (certainty < m_resultsThreshold)
+    return true;
+  return m_beam.IsFull() && certainty < m_beam.GetLowestValue();
+}
+
+Geocoder::TypesMask Geocoder::Context::GetTokenMatchedTypes(size_t id) const
+{
+  CHECK_LESS(id, m_tokenMatchedTypes.size(), ());
+  return m_tokenMatchedTypes[id];
+}
+
+void Geocoder::Context::SetAnchor(Type type, vector<Index::DocId> && docIds)
+{
+  m_anchorType = type;
+  m_anchorDocIds = move(docIds);
+  sort(m_anchorDocIds.begin(), m_anchorDocIds.end());
+}
+
+void Geocoder::Context::FinishAnchoredPass()
+{
+  CHECK(IsAnchored(), ());
+  // Every result of the anchored pass is found by the full pass with the same or a greater
+  // certainty, so the results of the full pass are not less than the lowest one of a full beam.
+  if (m_beam.IsFull())
+    m_resultsThreshold = m_beam.GetLowestValue();
+  m_beam.Clear();
+  m_houseNumberPositionsInQuery.clear();
+  m_anchorType = Type::Count;
+  m_anchorDocIds.clear();
+}
+
 vector<Geocoder::Layer> & Geocoder::Context::GetLayers() { return m_layers; }
 
 vector<Geocoder::Layer> const & Geocoder::Context::GetLayers() const { return m_layers; }
 
-void Geocoder::Context::MarkHouseNumberPositionsInQuery(vector<size_t> const & tokensPositions)
+void Geocoder::Context::MarkHouseNumberPositionsInQuery(TokensPositions const & tokensPositions)
 {
-  m_houseNumberPositionsInQuery.insert(tokensPositions.begin(), tokensPositions.end());
+  m_houseNumberPositionsInQuery.insert(m_houseNumberPositionsInQuery.end(),
+                                       tokensPositions.begin(), tokensPositions.end());
+  base::SortUnique(m_houseNumberPositionsInQuery);
+}
+
+vector<Geocoder::Candidate> Geocoder::Context::TakeCandidatesBuffer()
+{
+  if (m_candidatesBuffers.empty())
+    return {};
+
+  auto candidates = move(m_candidatesBuffers.back());
+  m_candidatesBuffers.pop_back();
+  return candidates;
+}
+
+void Geocoder::Context::ReturnCandidatesBuffer(vector<Candidate> && candidates)
+{
+  if (candidates.capacity() == 0)
+    return;
+
+  candidates.clear();
+  m_candidatesBuffers.push_back(move(candidates));
 }
 
 bool Geocoder::Context::IsGoodForPotentialHouseNumberAt(
-    BeamKey const & beamKey, set<size_t> const & tokensPositions) const
+    BeamKey const & beamKey, vector<size_t> const & tokensPositions) const
 {
   if (beamKey.m_tokensPositions.size() == m_tokens.size())
     return true;
@@ -296,33 +483,19 @@ bool Geocoder::Context::IsBuildingWithAddress(BeamKey const & beamKey) const
   if (beamKey.m_type != Type::Building)
     return false;
 
-  bool gotLocality = false;
-  bool gotStreet = false;
-  bool gotBuilding = false;
-  for (Type t : beamKey.m_allTypes)
-  {
-    if (t == Type::Region || t == Type::Subregion || t == Type::Locality)
-      gotLocality = true;
-    if (t == Type::Street)
-      gotStreet = true;
-    if (t == Type::Building)
-      gotBuilding = true;
-  }
-  return gotLocality && gotStreet && gotBuilding;
+  return HasLocalityOrRegion(beamKey) && (beamKey.m_allTypes & ToTypesMask(Type::Street)) != 0 &&
+         (beamKey.m_allTypes & ToTypesMask(Type::Building)) != 0;
 }
 
 bool Geocoder::Context::HasLocalityOrRegion(BeamKey const & beamKey) const
 {
-  for (Type t : beamKey.m_allTypes)
-  {
-    if (t == Type::Region || t == Type::Subregion || t == Type::Locality)
-      return true;
-  }
-
-  return false;
+  auto const mask =
+      ToTypesMask(Type::Region) | ToTypesMask(Type::Subregion) | ToTypesMask(Type::Locality);
+  return (beamKey.m_allTypes & mask) != 0;
 }
 
-bool Geocoder::Context::ContainsTokens(BeamKey const & beamKey, set<size_t> const & needTokensPostions) const
+bool Geocoder::Context::ContainsTokens(BeamKey const & beamKey,
+                                       vector<size_t> const & needTokensPostions) const
 {
   auto const & tokensPositions = beamKey.m_tokensPositions;
   return base::Includes(tokensPositions.begin(), tokensPositions.end(),
@@ -331,11 +504,15 @@ bool Geocoder::Context::ContainsTokens(BeamKey const & beamKey, set<size_t> cons
 
 // Geocoder ----------------------------------------------------------------------------------------
 void Geocoder::LoadFromJsonl(std::string const & pathToJsonHierarchy, bool dataVersionHeadline,
-                             unsigned int loadThreadsCount)
+                             unsigned int loadThreadsCount,
+                             Hierarchy::NamesFilter const & namesFilter)
 try
 {
-  m_hierarchy = HierarchyReader{pathToJsonHierarchy, dataVersionHeadline}.Read(loadThreadsCount);
+  m_hierarchy = HierarchyReader{pathToJsonHierarchy, dataVersionHeadline, namesFilter}.Read(
+      loadThreadsCount);
   m_index.BuildIndex(loadThreadsCount);
+  BuildCertaintyBounds();
+  ClearResultCache();
 }
 catch (boost::exception const & err)
 {
@@ -346,16 +523,117 @@ catch (std::exception const & err)
   MYTHROW(Exception, ("Failed to load jsonl:", err.what()));
 }
 
+void Geocoder::ApplyDeltaFromJsonl(std::string const & pathToJsonDelta, bool dataVersionHeadline,
+                                   unsigned int loadThreadsCount,
+                                   Hierarchy::NamesFilter const & namesFilter)
+try
+{
+  m_hierarchy.ApplyDelta(HierarchyReader{pathToJsonDelta, dataVersionHeadline, namesFilter}
+                             .ReadDelta(loadThreadsCount));
+  m_index.BuildIndex(loadThreadsCount);
+  BuildCertaintyBounds();
+  ClearResultCache();
+}
+catch (boost::exception const & err)
+{
+  MYTHROW(Exception, ("Failed to apply jsonl delta:", boost::diagnostic_information(err)));
+}
+catch (std::exception const & err)
+{
+  MYTHROW(Exception, ("Failed to apply jsonl delta:", err.what()));
+}
+
 void Geocoder::LoadFromBinaryIndex(std::string const & pathToTokenIndex)
 try
 {
-  std::ifstream ifs{pathToTokenIndex};
-  if (!ifs)
-    MYTHROW(OpenException, ("Failed to open file", pathToTokenIndex));
-  ifs.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+  FileReader reader{pathToTokenIndex};
+  if (!IsSegmentedBinaryIndex(reader))
+  {
+    LoadFromLegacyBinaryIndex(pathToTokenIndex);
+    return;
+  }
 
-  boost::archive::binary_iarchive ia{ifs};
-  ia >> *this;
+  ReaderSource<FileReader> source{reader};
+  source.Skip(sizeof(kBinaryIndexMagic));
+  auto const version = ReadPrimitiveFromSource<uint32_t>(source);
+  if (version != kIndexFormatVersion)
+  {
+    MYTHROW(Exception, ("Unsupported version of geocoder binary index:", version,
+                        "expected:", kIndexFormatVersion));
+  }
+  auto const segmentsCount = ReadPrimitiveFromSource<uint32_t>(source);
+  if (segmentsCount != kBinaryIndexSegmentsCount)
+  {
+    MYTHROW(Exception, ("Unexpected number of geocoder binary index segments:", segmentsCount,
+                        "expected:", kBinaryIndexSegmentsCount));
+  }
+
+  // The truncated files are detected before the segments are read. The offsets have a sentinel.
+  std::vector<BinaryIndexSegment> segments(kBinaryIndexSegmentsCount);
+  std::vector<uint64_t> offsets = {source.Pos() +
+                                   kBinaryIndexSegmentsCount * kBinaryIndexSegmentHeaderSize};
+  for (auto & segment : segments)
+  {
+    auto const size = ReadPrimitiveFromSource<uint64_t>(source);
+    segment.m_checksum = ReadPrimitiveFromSource<uint32_t>(source);
+    if (size > reader.Size() - offsets.back())
+      break;
+    offsets.push_back(offsets.back() + size);
+  }
+  if (offsets.size() != segments.size() + 1 || offsets.back() != reader.Size())
+    MYTHROW(Exception, ("Truncated geocoder binary index, size:", reader.Size()));
+
+  base::thread_pool::computational::ThreadPool threadPool{kBinaryIndexSegmentsCount};
+
+  // All the segments are checked before any of them is deserialized.
+  std::vector<std::future<void>> reads;
+  for (size_t i = 0; i < segments.size(); ++i)
+  {
+    reads.push_back(threadPool.Submit([&pathToTokenIndex, &segments, &offsets, i]() {
+      auto & segment = segments[i];
+      segment.m_data.resize(static_cast<size_t>(offsets[i + 1] - offsets[i]));
+      FileReader{pathToTokenIndex}.Read(offsets[i], &segment.m_data[0], segment.m_data.size());
+      if (ComputeChecksum(segment.m_data) != segment.m_checksum)
+        MYTHROW(Exception, ("Corrupted geocoder binary index segment", i));
+    }));
+  }
+  for (auto & read : reads)
+    read.get();
+
+  m_hierarchy.Unmap();
+  m_index.Unmap();
+
+  std::vector<std::future<void>> loads;
+  for (size_t i = 0; i < segments.size(); ++i)
+  {
+    loads.push_back(threadPool.Submit([this, &segments, i]() {
+      auto & data = segments[i].m_data;
+      {
+        boost::iostreams::stream<boost::iostreams::array_source> stream{data.data(), data.size()};
+        boost::archive::binary_iarchive ia{stream};
+        switch (static_cast<BinaryIndexSegmentType>(i))
+        {
+        case BinaryIndexSegmentType::HierarchyEntries: m_hierarchy.LoadEntries(ia); break;
+        case BinaryIndexSegmentType::NameDictionary: m_hierarchy.LoadNameDictionary(ia); break;
+        case BinaryIndexSegmentType::TokenPostings: m_index.LoadTokenPostings(ia); break;
+        case BinaryIndexSegmentType::RelatedBuildings: m_index.LoadRelatedBuildings(ia); break;
+        case BinaryIndexSegmentType::Count: UNREACHABLE();
+        }
+      }
+      std::string().swap(data);
+    }));
+  }
+  for (auto & load : loads)
+    load.get();
+
+  m_hierarchy.OnSegmentsLoaded();
+  m_index.OnSegmentsLoaded();
+  BuildCertaintyBounds();
+  ClearResultCache();
+}
+catch (Reader::OpenException const & err)
+{
+  MYTHROW(OpenException, ("Failed to open file", pathToTokenIndex, err.Msg()));
 }
 catch (boost::exception const & err)
 {
@@ -369,13 +647,55 @@ catch (std::exception const & err)
 void Geocoder::SaveToBinaryIndex(std::string const & pathToTokenIndex) const
 try
 {
-  std::ofstream ofs{pathToTokenIndex};
-  if (!ofs)
-    MYTHROW(OpenException, ("Failed to open file", pathToTokenIndex));
-  ofs.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+  if (m_hierarchy.IsMapped() || m_index.IsMapped())
+    MYTHROW(Exception, ("Mapped geocoder index can't be saved to a binary index."));
+
+  std::vector<std::future<BinaryIndexSegment>> segments;
+  {
+    base::thread_pool::computational::ThreadPool threadPool{kBinaryIndexSegmentsCount};
+    for (size_t i = 0; i < kBinaryIndexSegmentsCount; ++i)
+    {
+      segments.push_back(threadPool.Submit([this, i]() {
+        std::ostringstream stream;
+        {
+          boost::archive::binary_oarchive oa{stream};
+          switch (static_cast<BinaryIndexSegmentType>(i))
+          {
+          case BinaryIndexSegmentType::HierarchyEntries: m_hierarchy.SaveEntries(oa); break;
+          case BinaryIndexSegmentType::NameDictionary: m_hierarchy.SaveNameDictionary(oa); break;
+          case BinaryIndexSegmentType::TokenPostings: m_index.SaveTokenPostings(oa); break;
+          case BinaryIndexSegmentType::RelatedBuildings: m_index.SaveRelatedBuildings(oa); break;
+          case BinaryIndexSegmentType::Count: UNREACHABLE();
+          }
+        }
 
-  boost::archive::binary_oarchive oa{ofs};
-  oa << *this;
+        BinaryIndexSegment segment;
+        segment.m_data = stream.str();
+        segment.m_checksum = ComputeChecksum(segment.m_data);
+        return segment;
+      }));
+    }
+  }
+
+  std::vector<BinaryIndexSegment> data;
+  for (auto & segment : segments)
+    data.push_back(segment.get());
+
+  FileWriter writer{pathToTokenIndex};
+  writer.Write(kBinaryIndexMagic, sizeof(kBinaryIndexMagic));
+  WriteToSink(writer, static_cast<uint32_t>(kIndexFormatVersion));
+  WriteToSink(writer, static_cast<uint32_t>(data.size()));
+  for (auto const & segment : data)
+  {
+    WriteToSink(writer, static_cast<uint64_t>(segment.m_data.size()));
+    WriteToSink(writer, segment.m_checksum);
+  }
+  for (auto const & segment : data)
+    writer.Write(segment.m_data.data(), segment.m_data.size());
+}
+catch (Writer::OpenException const & err)
+{
+  MYTHROW(OpenException, ("Failed to open file", pathToTokenIndex, err.Msg()));
 }
 catch (boost::exception const & err)
 {
@@ -386,6 +706,69 @@ catch (std::exception const & err)
   MYTHROW(Exception, ("Failed to save geocoder index:", err.what()));
 }
 
+void Geocoder::LoadFromLegacyBinaryIndex(std::string const & pathToTokenIndex)
+{
+  std::ifstream ifs{pathToTokenIndex};
+  if (!ifs)
+    MYTHROW(OpenException, ("Failed to open file", pathToTokenIndex));
+  ifs.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+
+  m_hierarchy.Unmap();
+  m_index.Unmap();
+  boost::archive::binary_iarchive ia{ifs};
+  ia >> *this;
+  BuildCertaintyBounds();
+  ClearResultCache();
+}
+
+void Geocoder::LoadFromMappedIndex(std::string const & pathToIndex)
+try
+{
+  FilesMappingContainer container{pathToIndex};
+
+  ReaderSource<FileReader> source(container.GetReader(kMappedIndexVersionTag));
+  auto const version = ReadPrimitiveFromSource<uint32_t>(source);
+  if (version != kIndexFormatVersion)
+  {
+    MYTHROW(Exception, ("Unsupported version of geocoder mapped index:", version,
+                        "expected:", kIndexFormatVersion));
+  }
+
+  m_hierarchy.Map(container);
+  m_index.Map(container);
+  BuildCertaintyBounds();
+  ClearResultCache();
+}
+catch (Reader::OpenException const & err)
+{
+  MYTHROW(OpenException, ("Failed to open geocoder index:", err.Msg()));
+}
+catch (RootException const & err)
+{
+  MYTHROW(Exception, ("Failed to load geocoder index:", err.Msg()));
+}
+
+void Geocoder::SaveToMappedIndex(std::string const & pathToIndex) const
+try
+{
+  FilesContainerW container{pathToIndex};
+  {
+    auto writer = container.GetWriter(kMappedIndexVersionTag);
+    WriteToSink(*writer, static_cast<uint32_t>(kIndexFormatVersion));
+  }
+  m_hierarchy.Serialize(container);
+  m_index.Serialize(container);
+  container.Finish();
+}
+catch (Writer::OpenException const & err)
+{
+  MYTHROW(OpenException, ("Failed to open file", pathToIndex, err.Msg()));
+}
+catch (RootException const & err)
+{
+  MYTHROW(Exception, ("Failed to save geocoder index:", err.Msg()));
+}
+
 void Geocoder::ProcessQuery(string const & query, vector<Result> & results) const
 {
 #if defined(DEBUG)
@@ -395,15 +778,288 @@ void Geocoder::ProcessQuery(string const & query, vector<Result> & results) cons
   });
 #endif
 
-  Context ctx(query);
+  Context ctx;
+  ProcessQuery(ctx, query, results);
+}
+
+void Geocoder::ProcessQuery(string const & query, vector<Result> & results,
+                            QueryStats & stats) const
+{
+  Context ctx;
+  ctx.SetStats(&stats);
+  ProcessQuery(ctx, query, results);
+}
+
+void Geocoder::ProcessPrefixQuery(string const & query, vector<Result> & results) const
+{
+  Context ctx;
+  ProcessQuery(ctx, query, results, true /* lastTokenIsPrefix */);
+}
+
+void Geocoder::ProcessQueries(vector<string> const & queries, vector<vector<Result>> & results,
+                              unsigned int threadsCount, QueryStats * stats) const
+{
+  CHECK_GREATER_OR_EQUAL(threadsCount, 1, ());
+
+  results.resize(queries.size());
+
+  // Queries are taken by small blocks to balance threads load.
+  size_t const kBlockSize = 16;
+  atomic<size_t> nextBlock{0};
+  mutex statsMutex;
+  auto const processBlocks = [&]() {
+    Context ctx;
+    QueryStats threadStats;
+    if (stats)
+      ctx.SetStats(&threadStats);
+    SCOPE_GUARD(mergeStats, [&]() {
+      if (!stats)
+        return;
+      lock_guard<mutex> lock(statsMutex);
+      *stats += threadStats;
+    });
+
+    while (true)
+    {
+      size_t const begin = nextBlock.fetch_add(kBlockSize);
+      if (begin >= queries.size())
+        break;
+
+      size_t const end = min(begin + kBlockSize, queries.size());
+      for (size_t i = begin; i < end; ++i)
+        ProcessQuery(ctx, queries[i], results[i]);
+    }
+  };
+
+  if (threadsCount == 1)
+  {
+    processBlocks();
+    return;
+  }
+
+  base::thread_pool::computational::ThreadPool threadPool{threadsCount};
+  threadPool.PerformParallelWorks(processBlocks, threadsCount);
+}
+
+void Geocoder::ProcessQuery(Context & ctx, string const & query, vector<Result> & results,
+                            bool lastTokenIsPrefix) const
+{
+  PROF_ZONE("geocoder: query");
+#if defined(GEOCODER_QUERY_STATS)
+  base::HighResTimer timer;
+#endif
+
+  ctx.SetQuery(query, lastTokenIsPrefix);
+
+  if (m_resultCache && m_resultCache->Get(ctx.GetTokens(), ctx.IsLastTokenPrefix(), results))
+  {
+    PROF_COUNTER_ADD("geocoder: cache hits", 1);
+    UPDATE_QUERY_STATS(ctx.GetStats(), [&timer](QueryStats & stats) {
+      ++stats.m_queries;
+      ++stats.m_cacheHits;
+      stats.m_totalTimeNs += timer.ElapsedNano();
+    });
+    return;
+  }
+
+  auto & tokenIds = ctx.GetTokenIds();
+  for (size_t i = 0; i < ctx.GetNumTokens(); ++i)
+  {
+    auto const & token = ctx.GetToken(i);
+    tokenIds.push_back(m_fuzzyMatching ? m_index.GetTokenIdWithMisprints(token)
+                                       : m_index.GetTokenId(token));
+  }
+
+  PlanQuery(ctx);
+  if (ctx.IsAnchored())
+  {
+    UPDATE_QUERY_STATS(ctx.GetStats(), [](QueryStats & stats) { ++stats.m_anchoredQueries; });
+    Go(ctx, Type::Country);
+    ctx.FinishAnchoredPass();
+  }
+
   Go(ctx, Type::Country);
+  if (ctx.IsLastTokenPrefix())
+  {
+    // The beam collects the best results of all the completions.
+    auto const lastTokenId = tokenIds.back();
+    m_index.ForEachTokenIdWithPrefix(ctx.GetTokens().back(), [&](Index::TokenId tokenId) {
+      if (tokenId == lastTokenId)
+        return;
+      tokenIds.back() = tokenId;
+      Go(ctx, Type::Country);
+    });
+    tokenIds.back() = lastTokenId;
+  }
   ctx.FillResults(results);
+
+  if (m_resultCache)
+    m_resultCache->Put(ctx.GetTokens(), ctx.IsLastTokenPrefix(), results);
+
+  UPDATE_QUERY_STATS(ctx.GetStats(), [&timer](QueryStats & stats) {
+    ++stats.m_queries;
+    stats.m_totalTimeNs += timer.ElapsedNano();
+  });
 }
 
 Hierarchy const & Geocoder::GetHierarchy() const { return m_hierarchy; }
 
 Index const & Geocoder::GetIndex() const { return m_index; }
 
+void Geocoder::SetFuzzyMatching(bool enabled)
+{
+  if (m_fuzzyMatching == enabled)
+    return;
+  m_fuzzyMatching = enabled;
+  ClearResultCache();
+}
+
+void Geocoder::EnableResultCache(uint32_t logCacheSize)
+{
+  m_resultCache = make_unique<ResultCache>(logCacheSize);
+}
+
+void Geocoder::DisableResultCache() { m_resultCache.reset(); }
+
+void Geocoder::ClearResultCache()
+{
+  if (m_resultCache)
+    m_resultCache->Clear();
+}
+
+void Geocoder::BuildCertaintyBounds()
+{
+  m_maxTokenWeights.fill(0.0);
+  auto const entries = m_hierarchy.GetEntries();
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    auto const & entry = entries[i];
+    if (entry.m_type == Type::Count || entry.m_type == Type::Building)
+      continue;
+    auto const weight =
+        entry.m_kind != Kind::Unknown ? GetWeight(entry.m_kind) : GetWeight(entry.m_type);
+    auto & maxWeight = m_maxTokenWeights[static_cast<size_t>(entry.m_type)];
+    maxWeight = max(maxWeight, weight);
+  }
+}
+
+void Geocoder::PlanQuery(Context & ctx) const
+{
+  auto const numTokens = ctx.GetNumTokens();
+  auto & matchedTypes = ctx.GetTokenMatchedTypes();
+  // The completions of the prefix token are not known yet, so any token may be matched.
+  auto const regularTypes = ToTypesMask(Type::Building) - 1;
+  matchedTypes.assign(numTokens, ctx.IsLastTokenPrefix() ? regularTypes : 0);
+
+  size_t anchorDocsCount = numeric_limits<size_t>::max();
+  size_t maxDocsCount = 0;
+  size_t anchorBegin = 0;
+  size_t anchorEnd = 0;
+  auto anchorType = Type::Count;
+  Index::TokenIds subqueryTokenIds;
+  for (size_t i = 0; i < numTokens; ++i)
+  {
+    subqueryTokenIds.clear();
+    for (size_t j = i; j < numTokens; ++j)
+    {
+      subqueryTokenIds.push_back(ctx.GetTokenId(j));
+      for (auto type = Type::Country; type != Type::Building; type = NextType(type))
+      {
+        auto const docsCount = m_index.GetDocIdsCount(subqueryTokenIds, type);
+        if (docsCount == 0)
+          continue;
+
+        for (size_t k = i; k <= j; ++k)
+          matchedTypes[k] |= ToTypesMask(type);
+
+        // The deepest of the equally rare matches restricts the most layers.
+        maxDocsCount = max(maxDocsCount, docsCount);
+        if (docsCount <= anchorDocsCount)
+        {
+          anchorDocsCount = docsCount;
+          anchorBegin = i;
+          anchorEnd = j + 1;
+          anchorType = type;
+        }
+      }
+    }
+  }
+
+  // The anchored pass is worth it when the anchor is much rarer than the other matches and
+  // it does not match the whole query.
+  if (!m_queryPlanning || anchorType == Type::Count || anchorDocsCount > kMaxAnchorDocs ||
+      maxDocsCount < kMinAnchorSelectivity * anchorDocsCount ||
+      anchorEnd - anchorBegin == numTokens)
+  {
+    return;
+  }
+
+  subqueryTokenIds.clear();
+  for (size_t i = anchorBegin; i < anchorEnd; ++i)
+    subqueryTokenIds.push_back(ctx.GetTokenId(i));
+  vector<Index::DocId> anchorDocIds;
+  anchorDocIds.reserve(anchorDocsCount);
+  m_index.ForEachDocIdByTokenIds(subqueryTokenIds, anchorType, [&](Index::DocId const & docId) {
+    anchorDocIds.push_back(docId);
+  });
+  ctx.SetAnchor(anchorType, move(anchorDocIds));
+}
+
+bool Geocoder::IsRelatedToAnchor(Context const & ctx, Type type, Index::DocId const & docId) const
+{
+  auto const & anchorDocIds = ctx.GetAnchorDocIds();
+  if (type == ctx.GetAnchorType())
+    return binary_search(anchorDocIds.begin(), anchorDocIds.end(), docId);
+
+  auto const & doc = m_index.GetDoc(docId);
+  auto const isAncestor = type < ctx.GetAnchorType();
+  return any_of(anchorDocIds.begin(), anchorDocIds.end(), [&](Index::DocId const & anchorDocId) {
+    auto const & anchor = m_index.GetDoc(anchorDocId);
+    return isAncestor ? m_hierarchy.IsParentTo(doc, anchor) : m_hierarchy.IsParentTo(anchor, doc);
+  });
+}
+
+bool Geocoder::CanPruneBranch(Context const & ctx, Type type) const
+{
+  auto bound = 0.0;
+  bool mayHaveHouseNumbers = type <= Type::Street;
+  for (auto const & layer : ctx.GetLayers())
+  {
+    auto const & candidates = layer.GetCandidatesByCertainty();
+    if (!candidates.empty())
+      bound = max(bound, candidates.back().m_totalCertainty);
+    if (layer.GetType() == Type::Street || layer.GetType() == Type::Locality)
+      mayHaveHouseNumbers = true;
+  }
+
+  for (size_t i = 0; i < ctx.GetNumTokens(); ++i)
+  {
+    if (ctx.IsTokenUsed(i))
+      continue;
+
+    // The branch is not skipped if it may mark the potential house numbers which filter
+    // the results, see FillBuildingsLayer().
+    if (mayHaveHouseNumbers && ctx.MayStartHouseNumber(i))
+      return false;
+
+    // Only the types of the docs found by the subqueries containing the token are weighed.
+    auto regularTokenWeight = 0.0;
+    auto const matchedTypes = ctx.GetTokenMatchedTypes(i);
+    for (auto t = type; t < Type::Building; t = NextType(t))
+    {
+      if ((matchedTypes & ToTypesMask(t)) != 0)
+        regularTokenWeight = max(regularTokenWeight, m_maxTokenWeights[static_cast<size_t>(t)]);
+    }
+
+    // A house number token is parsed to no more house number tokens than it has characters.
+    auto const buildingTokenWeight = GetWeight(Kind::Building) * ctx.GetToken(i).size();
+    bound += max(regularTokenWeight, buildingTokenWeight);
+  }
+
+  bound += kCityStateExtraWeight + kCertaintyBoundEps;
+  return ctx.IsBelowResultsThreshold(bound);
+}
+
 void Geocoder::Go(Context & ctx, Type type) const
 {
   if (ctx.GetNumTokens() == 0)
@@ -415,11 +1071,21 @@ void Geocoder::Go(Context & ctx, Type type) const
   if (type == Type::Count)
     return;
 
+  if (CanPruneBranch(ctx, type))
+  {
+    UPDATE_QUERY_STATS(ctx.GetStats(), [type](QueryStats & stats) {
+      ++stats.m_prunedBranches[static_cast<size_t>(type)];
+    });
+    return;
+  }
+
   Tokens subquery;
-  vector<size_t> subqueryTokensPositions;
+  Index::TokenIds subqueryTokenIds;
+  TokensPositions subqueryTokensPositions;
   for (size_t i = 0; i < ctx.GetNumTokens(); ++i)
   {
     subquery.clear();
+    subqueryTokenIds.clear();
     subqueryTokensPositions.clear();
     for (size_t j = i; j < ctx.GetNumTokens(); ++j)
     {
@@ -427,10 +1093,15 @@ void Geocoder::Go(Context & ctx, Type type) const
         break;
 
       subquery.push_back(ctx.GetToken(j));
+      subqueryTokenIds.push_back(ctx.GetTokenId(j));
       subqueryTokensPositions.push_back(j);
 
       Layer curLayer{m_index, type};
 
+#if defined(GEOCODER_QUERY_STATS)
+      base::HighResTimer fillLayerTimer;
+#endif
+
       // Buildings are indexed separately.
       if (type == Type::Building)
       {
@@ -443,9 +1114,20 @@ void Geocoder::Go(Context & ctx, Type type) const
       }
       else
       {
-        FillRegularLayer(ctx, type, subquery, curLayer);
+        FillRegularLayer(ctx, type, subquery, subqueryTokenIds, curLayer);
       }
 
+      UPDATE_QUERY_STATS(ctx.GetStats(), [&](QueryStats & stats) {
+        auto const t = static_cast<size_t>(type);
+        ++stats.m_subqueries[t];
+        stats.m_fillLayerTimeNs[t] += fillLayerTimer.ElapsedNano();
+        if (!curLayer.GetCandidatesByCertainty().empty())
+        {
+          ++stats.m_layers[t];
+          stats.m_candidates[t] += curLayer.GetCandidatesByCertainty().size();
+        }
+      });
+
       if (curLayer.GetCandidatesByCertainty().empty())
         continue;
 
@@ -458,7 +1140,10 @@ void Geocoder::Go(Context & ctx, Type type) const
       AddResults(ctx, curLayer.GetCandidatesByCertainty());
 
       ctx.GetLayers().emplace_back(move(curLayer));
-      SCOPE_GUARD(pop, [&] { ctx.GetLayers().pop_back(); });
+      SCOPE_GUARD(pop, [&] {
+        ctx.ReturnCandidatesBuffer(ctx.GetLayers().back().ReleaseCandidates());
+        ctx.GetLayers().pop_back();
+      });
 
       Go(ctx, NextType(type));
     }
@@ -469,14 +1154,15 @@ void Geocoder::Go(Context & ctx, Type type) const
 
 void Geocoder::FillBuildingsLayer(
     Context & ctx, Tokens const & subquery,
-    vector<size_t> const & subqueryTokensPositions, Layer & curLayer) const
+    TokensPositions const & subqueryTokensPositions, Layer & curLayer) const
 {
   if (ctx.GetLayers().empty())
     return;
 
   auto const & subqueryHN = MakeHouseNumber(subquery);
 
-  if (!search::house_numbers::LooksLikeHouseNumber(subqueryHN, false /* isPrefix */))
+  auto const isPrefix = ctx.EndsWithPrefix(subqueryTokensPositions.back() + 1);
+  if (!search::house_numbers::LooksLikeHouseNumber(subqueryHN, isPrefix))
     return;
 
   for (auto const & layer : boost::adaptors::reverse(ctx.GetLayers()))
@@ -490,9 +1176,9 @@ void Geocoder::FillBuildingsLayer(
     ctx.MarkHouseNumberPositionsInQuery(subqueryTokensPositions);
 
     auto subqueryNumberParse = std::vector<search::house_numbers::Token>{};
-    ParseQuery(subqueryHN, false /* queryIsPrefix */, subqueryNumberParse);
+    ParseQuery(subqueryHN, isPrefix /* queryIsPrefix */, subqueryNumberParse);
 
-    auto candidates = std::vector<Candidate>{};
+    auto candidates = ctx.TakeCandidatesBuffer();
 
     auto const & lastLayer = ctx.GetLayers().back();
     auto const forSublocalityLayer =
@@ -500,14 +1186,13 @@ void Geocoder::FillBuildingsLayer(
     for (auto const & buildingOwnerCandidate : layer.GetCandidatesByCertainty())
     {
       auto const & docId = buildingOwnerCandidate.m_entry;
-      m_index.ForEachRelatedBuilding(docId, [&](Index::DocId const & buildingDocId) {
+      m_index.ForEachRelatedBuildingWithHouseNumber(docId, subqueryNumberParse,
+                                                    [&](Index::DocId const & buildingDocId) {
         auto const & building = m_index.GetDoc(buildingDocId);
-        auto const & multipleHN = building.GetNormalizedMultipleNames(
-            Type::Building, m_hierarchy.GetNormalizedNameDictionary());
-        auto const & realHN = multipleHN.GetMainName();
-        auto const & realHNUniStr = strings::MakeUniString(realHN);
+        auto const & realHNParses = m_index.GetHouseNumberParses(building);
         auto matchResult = search::house_numbers::MatchResult{};
-        if (search::house_numbers::HouseNumbersMatch(realHNUniStr, subqueryNumberParse, matchResult))
+        UPDATE_QUERY_STATS(ctx.GetStats(), [](QueryStats & stats) { ++stats.m_houseNumberMatches; });
+        if (search::house_numbers::HouseNumbersMatch(realHNParses, subqueryNumberParse, matchResult))
         {
           auto && parentCandidateCertainty =
               forSublocalityLayer ? FindMaxCertaintyInParentCandidates(ctx.GetLayers(), building)
@@ -526,20 +1211,22 @@ void Geocoder::FillBuildingsLayer(
 
     if (!candidates.empty())
       curLayer.SetCandidates(std::move(candidates));
+    else
+      ctx.ReturnCandidatesBuffer(std::move(candidates));
     break;
   }
 }
 
-void Geocoder::FillRegularLayer(Context const & ctx, Type type, Tokens const & subquery,
-                                Layer & curLayer) const
+void Geocoder::FillRegularLayer(Context & ctx, Type type, Tokens const & subquery,
+                                Index::TokenIds const & subqueryTokenIds, Layer & curLayer) const
 {
-  auto candidates = std::vector<Candidate>{};
+  auto candidates = ctx.TakeCandidatesBuffer();
 
-  m_index.ForEachDocId(subquery, [&](Index::DocId const & docId) {
-    auto const & d = m_index.GetDoc(docId);
-    if (d.m_type != type)
+  m_index.ForEachDocIdByTokenIds(subqueryTokenIds, type, [&](Index::DocId const & docId) {
+    if (ctx.IsAnchored() && !IsRelatedToAnchor(ctx, type, docId))
       return;
 
+    auto const & d = m_index.GetDoc(docId);
     auto && parentCandidateCertainty = FindMaxCertaintyInParentCandidates(ctx.GetLayers(), d);
     if (!parentCandidateCertainty)
       return;
@@ -556,19 +1243,21 @@ void Geocoder::FillRegularLayer(Context const & ctx, Type type, Tokens const & s
 
   if (!candidates.empty())
     curLayer.SetCandidates(std::move(candidates));
+  else
+    ctx.ReturnCandidatesBuffer(std::move(candidates));
 }
 
 void Geocoder::AddResults(Context & ctx, std::vector<Candidate> const & candidates) const
 {
-  vector<size_t> tokensPositions;
-  vector<Type> allTypes;
+  TokensPositions tokensPositions;
+  TypesMask allTypes = 0;
   for (size_t tokenPos = 0; tokenPos < ctx.GetNumTokens(); ++tokenPos)
   {
     auto const t = ctx.GetTokenType(tokenPos);
     if (t != Type::Count)
     {
       tokensPositions.push_back(tokenPos);
-      allTypes.push_back(t);
+      allTypes |= ToTypesMask(t);
     }
   }
 
@@ -580,7 +1269,6 @@ void Geocoder::AddResults(Context & ctx, std::vector<Candidate> const & candidat
 
     if (InCityState(entry))
     {
-      constexpr auto kCityStateExtraWeight = 0.05;
       ASSERT_LESS(kCityStateExtraWeight, GetWeight(Type::Building),
                   ("kCityStateExtraWeight must be smallest"));
       // Prefer city-state (Moscow, Istambul) to other city types.
@@ -594,7 +1282,7 @@ void Geocoder::AddResults(Context & ctx, std::vector<Candidate> const & candidat
 
 bool Geocoder::IsValidHouseNumberWithNextUnusedToken(
     Context const & ctx, Tokens const & subquery,
-    vector<size_t> const & subqueryTokensPositions) const
+    TokensPositions const & subqueryTokensPositions) const
 {
   auto const nextTokenPos = subqueryTokensPositions.back() + 1;
   if (nextTokenPos >= ctx.GetNumTokens() || ctx.IsTokenUsed(nextTokenPos))
@@ -604,7 +1292,8 @@ bool Geocoder::IsValidHouseNumberWithNextUnusedToken(
   subqueryHouseNumber += strings::MakeUniString(" ");
   subqueryHouseNumber += strings::MakeUniString(ctx.GetToken(nextTokenPos));
 
-  return search::house_numbers::LooksLikeHouseNumber(subqueryHouseNumber, false /* isPrefix */);
+  return search::house_numbers::LooksLikeHouseNumber(subqueryHouseNumber,
+                                                     ctx.EndsWithPrefix(nextTokenPos + 1));
 }
 
 double Geocoder::SumHouseNumberSubqueryCertainty(
@@ -3,16 +3,22 @@
 #include "geocoder/hierarchy.hpp"
 #include "geocoder/house_numbers_matcher.hpp"
 #include "geocoder/index.hpp"
+#include "geocoder/query_stats.hpp"
 #include "geocoder/result.hpp"
+#include "geocoder/result_cache.hpp"
 #include "geocoder/types.hpp"
 
 #include "base/beam.hpp"
+#include "base/buffer_vector.hpp"
+#include "base/exception.hpp"
 #include "base/geo_object_id.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/string_utils.hpp"
 
+#include <array>
 #include <cstddef>
-#include <set>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -47,6 +53,12 @@ public:
   DECLARE_EXCEPTION(Exception, RootException);
   DECLARE_EXCEPTION(OpenException, Exception);
 
+  // Positions of the query tokens, short sequences are kept on the stack.
+  using TokensPositions = buffer_vector<size_t, 16>;
+  // A set of Types, the bit 1 << t is set for every Type t in the set.
+  using TypesMask = uint32_t;
+  static_assert(static_cast<size_t>(Type::Count) <= sizeof(TypesMask) * 8, "");
+
   // Candidate contain matched entry with certainty of all matched tokens.
   struct Candidate
   {
@@ -67,6 +79,8 @@ public:
       return m_candidatesByCertainty;
     }
     void SetCandidates(std::vector<Candidate> && candidates);
+    // Moves the candidates out of the layer.
+    std::vector<Candidate> ReleaseCandidates();
 
   private:
     Index const & m_index;
@@ -81,29 +95,43 @@ public:
   public:
     struct BeamKey
     {
-      BeamKey(base::GeoObjectId osmId, Type type, std::vector<size_t> const & tokensPositions,
-              std::vector<Type> const & allTypes, bool isOtherSimilar)
+      BeamKey(base::GeoObjectId osmId, Type type, TokensPositions const & tokensPositions,
+              TypesMask allTypes, bool isOtherSimilar)
         : m_osmId(osmId)
         , m_type(type)
-        , m_tokensPositions{tokensPositions}
+        , m_tokensPositions(tokensPositions)
         , m_allTypes(allTypes)
         , m_isOtherSimilar(isOtherSimilar)
       {
-        base::SortUnique(m_allTypes);
       }
 
       base::GeoObjectId m_osmId;
       Type m_type;
-      std::vector<size_t> m_tokensPositions;
-      std::vector<Type> m_allTypes;
+      TokensPositions m_tokensPositions;
+      TypesMask m_allTypes;
       bool m_isOtherSimilar;
     };
 
-    Context(std::string const & query);
+    Context();
+    explicit Context(std::string const & query);
+
+    // Resets the context to process |query|. Reuses the memory allocated for the previous query.
+    void SetQuery(std::string const & query, bool lastTokenIsPrefix = false);
+    // True when the last token of the query may be incomplete, see Geocoder::ProcessPrefixQuery().
+    bool IsLastTokenPrefix() const { return m_lastTokenIsPrefix; }
+    // Returns true if the subquery of the tokens before |end| ends with the prefix token.
+    bool EndsWithPrefix(size_t end) const;
+    // Returns true if a house number subquery may start with the token |id|,
+    // see Geocoder::FillBuildingsLayer().
+    bool MayStartHouseNumber(size_t id) const;
 
     void Clear();
 
     std::vector<Type> & GetTokenTypes();
+    Tokens const & GetTokens() const;
+    // Ids of the tokens in the index vocabulary, see Index::GetTokenId().
+    std::vector<Index::TokenId> & GetTokenIds();
+    Index::TokenId GetTokenId(size_t id) const;
     size_t GetNumTokens() const;
     size_t GetNumUsedTokens() const;
 
@@ -120,76 +148,196 @@ public:
     bool AllTokensUsed() const;
 
     void AddResult(base::GeoObjectId const & osmId, double certainty, Type type,
-                   std::vector<size_t> const & tokensPositions, std::vector<Type> const & allTypes,
+                   TokensPositions const & tokensPositions, TypesMask allTypes,
                    bool isOtherSimilar);
 
     void FillResults(std::vector<Result> & results) const;
+    // Returns true if the results with certainties less than |certainty| can't get to the beam.
+    bool IsBelowResultsThreshold(double certainty) const;
+
+    // The plan of the query, see Geocoder::PlanQuery(). |matchedTypes[i]| is the mask of the
+    // types of the docs found by the subqueries containing the token |i|.
+    std::vector<TypesMask> & GetTokenMatchedTypes() { return m_tokenMatchedTypes; }
+    TypesMask GetTokenMatchedTypes(size_t id) const;
+    // The regular layers of the anchored pass only keep the anchor docs of |type| and their
+    // ancestors and descendants, see Geocoder::IsRelatedToAnchor().
+    void SetAnchor(Type type, std::vector<Index::DocId> && docIds);
+    bool IsAnchored() const { return m_anchorType != Type::Count; }
+    Type GetAnchorType() const { return m_anchorType; }
+    std::vector<Index::DocId> const & GetAnchorDocIds() const { return m_anchorDocIds; }
+    // Starts the full pass of the query over the results of the anchored pass: the results
+    // are dropped but the lowest certainty of the full beam is kept as the results threshold.
+    void FinishAnchoredPass();
 
     std::vector<Layer> & GetLayers();
 
     std::vector<Layer> const & GetLayers() const;
 
-    void MarkHouseNumberPositionsInQuery(std::vector<size_t> const & tokensPositions);
+    void MarkHouseNumberPositionsInQuery(TokensPositions const & tokensPositions);
+
+    // Candidates buffers of the layers are reused by the next subqueries and queries,
+    // so a reused context does not allocate them again.
+    std::vector<Candidate> TakeCandidatesBuffer();
+    void ReturnCandidatesBuffer(std::vector<Candidate> && candidates);
+
+    // Statistics of the query are collected to |stats| when it is not null.
+    void SetStats(QueryStats * stats) { m_stats = stats; }
+    QueryStats * GetStats() const { return m_stats; }
 
   private:
     bool IsGoodForPotentialHouseNumberAt(BeamKey const & beamKey,
-                                         std::set<size_t> const & tokensPositions) const;
+                                         std::vector<size_t> const & tokensPositions) const;
     bool IsBuildingWithAddress(BeamKey const & beamKey) const;
     bool HasLocalityOrRegion(BeamKey const & beamKey) const;
-    bool ContainsTokens(BeamKey const & beamKey, std::set<size_t> const & needTokensPostions) const;
+    bool ContainsTokens(BeamKey const & beamKey,
+                        std::vector<size_t> const & needTokensPostions) const;
 
     Tokens m_tokens;
+    std::vector<Index::TokenId> m_tokenIds;
     std::vector<Type> m_tokenTypes;
+    std::vector<bool> m_houseNumberStarts;
 
     size_t m_numUsedTokens = 0;
+    bool m_lastTokenIsPrefix = false;
 
     // |m_houseNumberPositionsInQuery| has indexes of query tokens which are placed on
-    // context-dependent positions of house number.
+    // context-dependent positions of house number, sorted and unique.
     // The rationale is that we must only emit buildings in this case
     // and implement a fallback to a more powerful geocoder if we
     // could not find a building.
-    std::set<size_t> m_houseNumberPositionsInQuery;
+    std::vector<size_t> m_houseNumberPositionsInQuery;
 
     // The highest value of certainty for a fixed amount of
     // the most relevant retrieved osm ids.
     base::Beam<BeamKey, double> m_beam;
+    // The results with lesser certainties can't get to the beam, see FinishAnchoredPass().
+    double m_resultsThreshold = 0.0;
+
+    std::vector<TypesMask> m_tokenMatchedTypes;
+    Type m_anchorType = Type::Count;
+    // Sorted.
+    std::vector<Index::DocId> m_anchorDocIds;
 
     std::vector<Layer> m_layers;
+    std::vector<std::vector<Candidate>> m_candidatesBuffers;
+
+    QueryStats * m_stats = nullptr;
   };
 
+  // Only the alternative names passing |namesFilter| are loaded and indexed,
+  // see Hierarchy::NamesFilter.
   void LoadFromJsonl(std::string const & pathToJsonHierarchy, bool dataVersionHeadline = false,
-                     unsigned int loadThreadsCount = 1);
-
+                     unsigned int loadThreadsCount = 1,
+                     Hierarchy::NamesFilter const & namesFilter = {});
+
+  // Patches the loaded hierarchy by the delta jsonl, see HierarchyReader::ReadDelta(), and
+  // rebuilds the index from the patched entries. Only the delta is parsed. The patched geocoder
+  // is not mapped anymore, it can be saved to a new index.
+  void ApplyDeltaFromJsonl(std::string const & pathToJsonDelta, bool dataVersionHeadline = false,
+                           unsigned int loadThreadsCount = 1,
+                           Hierarchy::NamesFilter const & namesFilter = {});
+
+  // The binary index keeps the hierarchy entries, the name dictionary, the token postings and
+  // the related buildings in separate checksummed segments. The segments are serialized and
+  // deserialized concurrently, and a truncated or corrupted file is detected before the load.
+  // The binary indexes of the single archive format are still loaded if they are of the current
+  // format version. A mapped geocoder can't be saved to a binary index.
   void LoadFromBinaryIndex(std::string const & pathToTokenIndex);
   void SaveToBinaryIndex(std::string const & pathToTokenIndex) const;
 
+  // The mapped index is a files container with flat tables of the hierarchy entries
+  // and posting lists. Unlike the binary index, it is not deserialized on load:
+  // the geocoder works right with the mapped memory, so the load is fast and
+  // processes serving the same index share its pages.
+  void LoadFromMappedIndex(std::string const & pathToIndex);
+  void SaveToMappedIndex(std::string const & pathToIndex) const;
+
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version)
   {
-    CHECK_EQUAL(version, kIndexFormatVersion, ());
+    // The single archive binary indexes of the former versions are rejected before any of their
+    // parts is read, see LoadFromLegacyBinaryIndex().
+    if (version != kIndexFormatVersion)
+    {
+      MYTHROW(Exception, ("Unsupported version of geocoder binary index:", version,
+                          "expected:", kIndexFormatVersion));
+    }
     ar & m_hierarchy;
     ar & m_index;
   }
 
   void ProcessQuery(std::string const & query, std::vector<Result> & results) const;
+  // The same as above but also adds the statistics of the query to |stats|.
+  // |stats| are left intact when the geocoder is built without GEOCODER_QUERY_STATS.
+  void ProcessQuery(std::string const & query, std::vector<Result> & results,
+                    QueryStats & stats) const;
+
+  // The autocomplete mode: the last token of |query| is treated as a prefix of a token.
+  // The prefix is expanded to the tokens of the index occurring in the most names, see
+  // Index::ForEachTokenIdWithPrefix(), and to the house numbers starting with it.
+  void ProcessPrefixQuery(std::string const & query, std::vector<Result> & results) const;
+  // The same as the above queries but reuses the memory |ctx| has allocated for the previous
+  // queries. A context is to be used by one thread at a time.
+  void ProcessQuery(Context & ctx, std::string const & query, std::vector<Result> & results,
+                    bool lastTokenIsPrefix = false) const;
+
+  // Processes |queries| concurrently in |threadsCount| threads, every thread reuses
+  // its own Context. |results[i]| gets the results for |queries[i]|.
+  // The sum of the queries statistics is added to |stats| when it is not null.
+  void ProcessQueries(std::vector<std::string> const & queries,
+                      std::vector<std::vector<Result>> & results,
+                      unsigned int threadsCount = 1, QueryStats * stats = nullptr) const;
 
   Hierarchy const & GetHierarchy() const;
 
   Index const & GetIndex() const;
 
+  // When fuzzy matching is enabled, query tokens that do not occur in the index
+  // are replaced with the closest tokens of the index vocabulary,
+  // see Index::GetTokenIdWithMisprints().
+  void SetFuzzyMatching(bool enabled);
+
+  // When query planning is enabled, the query is first processed with the layers restricted to
+  // the most selective match of its tokens and to the ancestors and descendants of the match,
+  // see PlanQuery(). The results of this pass prune the branches of the full search which
+  // can't get to the results. The planning does not change the results. Enabled by default.
+  void SetQueryPlanning(bool enabled) { m_queryPlanning = enabled; }
+
+  // Enables the cache of results for 2^|logCacheSize| normalized queries.
+  // The cache is cleared when the hierarchy is reloaded (in particular, when
+  // its data version changes) and when the matching options change.
+  void EnableResultCache(uint32_t logCacheSize);
+  void DisableResultCache();
+  // Returns nullptr when the cache is disabled.
+  ResultCache const * GetResultCache() const { return m_resultCache.get(); }
+
 private:
+  // Loads the binary index of the single boost archive format. Only the archives of the current
+  // format version are loaded, the others are rejected with Exception.
+  void LoadFromLegacyBinaryIndex(std::string const & pathToTokenIndex);
+
   void Go(Context & ctx, Type type) const;
+  // Returns true if no result of Go(ctx, type) can get to the beam of |ctx|, so the branch
+  // may be skipped. The certainty of the results is estimated from above by the best candidate
+  // of the layers and the greatest weights of the unused tokens.
+  bool CanPruneBranch(Context const & ctx, Type type) const;
+  // Computes |m_maxTokenWeights| for the loaded hierarchy.
+  void BuildCertaintyBounds();
+  // Looks up the lengths of the posting lists of all the subqueries and chooses the rarest
+  // match of the query for the anchored pass.
+  void PlanQuery(Context & ctx) const;
+  bool IsRelatedToAnchor(Context const & ctx, Type type, Index::DocId const & docId) const;
 
   void FillBuildingsLayer(Context & ctx, Tokens const & subquery,
-                          std::vector<size_t> const & subqueryTokensPositions,
+                          TokensPositions const & subqueryTokensPositions,
                           Layer & curLayer) const;
-  void FillRegularLayer(Context const & ctx, Type type, Tokens const & subquery,
-                        Layer & curLayer) const;
+  void FillRegularLayer(Context & ctx, Type type, Tokens const & subquery,
+                        Index::TokenIds const & subqueryTokenIds, Layer & curLayer) const;
   void AddResults(Context & ctx, std::vector<Candidate> const & candidates) const;
 
   bool IsValidHouseNumberWithNextUnusedToken(
       Context const & ctx, Tokens const & subquery,
-      std::vector<size_t> const & subqueryTokensPositions) const;
+      TokensPositions const & subqueryTokensPositions) const;
   double SumHouseNumberSubqueryCertainty(
       search::house_numbers::MatchResult const & matchResult) const;
 
@@ -207,6 +355,16 @@ private:
 
   Hierarchy m_hierarchy;
   Index m_index{m_hierarchy};
+
+  void ClearResultCache();
+
+  bool m_fuzzyMatching = false;
+  bool m_queryPlanning = true;
+
+  std::unique_ptr<ResultCache> m_resultCache;
+  // m_maxTokenWeights[type] is the greatest certainty per token of the entries of |type|
+  // but buildings, see CanPruneBranch().
+  std::array<double, static_cast<size_t>(Type::Count)> m_maxTokenWeights{};
 };
 }  // namespace geocoder
 
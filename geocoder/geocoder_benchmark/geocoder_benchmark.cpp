@@ -0,0 +1,394 @@
+#include "geocoder/geocoder.hpp"
+#include "geocoder/index.hpp"
+#include "geocoder/query_stats.hpp"
+#include "geocoder/result.hpp"
+
+#include "base/assert.hpp"
+#include "base/prof.hpp"
+#include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
+#include "base/timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/program_options.hpp>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace geocoder;
+using namespace std;
+
+namespace po = boost::program_options;
+
+namespace
+{
+// The number of heap allocations made by the process, see the operator new below.
+atomic<uint64_t> g_allocationsCount{0};
+
+struct BenchmarkOptions
+{
+  string m_hierarchyPath;
+  string m_queriesPath;
+  string m_binaryIndexPath;
+  string m_profileTracePath;
+  bool m_mappedIndex = false;
+  unsigned int m_threads = 1;
+  unsigned int m_loadThreads = 1;
+  size_t m_passes = 1;
+  uint32_t m_shuffleSeed = 0;
+  bool m_fuzzy = false;
+  uint32_t m_cacheLogSize = 0;
+  bool m_json = false;
+};
+
+struct StartupTimings
+{
+  // Negative values mean that the stage was not run.
+  double m_loadSeconds = -1.0;
+  double m_buildIndexSeconds = -1.0;
+  double m_saveSeconds = -1.0;
+};
+
+struct ReplayResults
+{
+  size_t m_queriesCount = 0;
+  double m_wallSeconds = 0.0;
+  // Latencies of all processed queries in nanoseconds, sorted.
+  vector<uint64_t> m_latenciesNs;
+  uint64_t m_allocationsCount = 0;
+  uint64_t m_resultsCount = 0;
+  QueryStats m_stats;
+};
+
+uint64_t GetPeakRssBytes()
+{
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+double GetPercentileMs(vector<uint64_t> const & sortedLatenciesNs, double percentile)
+{
+  if (sortedLatenciesNs.empty())
+    return 0.0;
+  auto const rank = static_cast<size_t>(percentile / 100.0 * (sortedLatenciesNs.size() - 1) + 0.5);
+  return sortedLatenciesNs[min(rank, sortedLatenciesNs.size() - 1)] / 1e6;
+}
+
+vector<string> ReadQueries(string const & path, uint32_t shuffleSeed)
+{
+  ifstream stream(path.c_str());
+  CHECK(stream.is_open(), ("Can't open", path));
+
+  vector<string> queries;
+  string s;
+  while (getline(stream, s))
+  {
+    strings::Trim(s);
+    if (!s.empty())
+      queries.push_back(s);
+  }
+
+  // The same seed gives the same order of the queries on every platform:
+  // std::shuffle may differ between standard libraries, so the permutation is built here.
+  if (shuffleSeed != 0)
+  {
+    mt19937 rng{shuffleSeed};
+    for (size_t i = queries.size(); i > 1; --i)
+      swap(queries[i - 1], queries[rng() % i]);
+  }
+  return queries;
+}
+
+StartupTimings Load(Geocoder & geocoder, BenchmarkOptions const & options)
+{
+  StartupTimings timings;
+  base::Timer timer;
+  if (options.m_mappedIndex)
+  {
+    geocoder.LoadFromMappedIndex(options.m_hierarchyPath);
+    timings.m_loadSeconds = timer.ElapsedSeconds();
+  }
+  else if (strings::EndsWith(options.m_hierarchyPath, ".jsonl") ||
+           strings::EndsWith(options.m_hierarchyPath, ".jsonl.gz"))
+  {
+    geocoder.LoadFromJsonl(options.m_hierarchyPath, false /* dataVersionHeadline */,
+                           options.m_loadThreads);
+    timings.m_loadSeconds = timer.ElapsedSeconds();
+
+    // LoadFromJsonl() builds the index as well, the build alone is timed on a fresh index
+    // over the loaded hierarchy.
+    Index index{geocoder.GetHierarchy()};
+    timer.Reset();
+    index.BuildIndex(options.m_loadThreads);
+    timings.m_buildIndexSeconds = timer.ElapsedSeconds();
+  }
+  else
+  {
+    geocoder.LoadFromBinaryIndex(options.m_hierarchyPath);
+    timings.m_loadSeconds = timer.ElapsedSeconds();
+  }
+
+  if (!options.m_binaryIndexPath.empty())
+  {
+    timer.Reset();
+    geocoder.SaveToBinaryIndex(options.m_binaryIndexPath);
+    timings.m_saveSeconds = timer.ElapsedSeconds();
+  }
+  return timings;
+}
+
+ReplayResults Replay(Geocoder const & geocoder, vector<string> const & queries,
+                     BenchmarkOptions const & options)
+{
+  ReplayResults replay;
+  replay.m_queriesCount = queries.size() * options.m_passes;
+  replay.m_latenciesNs.resize(replay.m_queriesCount);
+
+  atomic<size_t> nextQuery{0};
+  atomic<uint64_t> resultsCount{0};
+  mutex statsMutex;
+  auto const processQueries = [&]() {
+    vector<Result> results;
+    QueryStats threadStats;
+    uint64_t threadResultsCount = 0;
+    while (true)
+    {
+      size_t const i = nextQuery.fetch_add(1);
+      if (i >= replay.m_queriesCount)
+        break;
+
+      base::Timer timer;
+      geocoder.ProcessQuery(queries[i % queries.size()], results, threadStats);
+      replay.m_latenciesNs[i] = timer.TimeElapsedAs<chrono::nanoseconds>().count();
+      threadResultsCount += results.size();
+    }
+
+    resultsCount += threadResultsCount;
+    lock_guard<mutex> lock(statsMutex);
+    replay.m_stats += threadStats;
+  };
+
+  auto const allocationsBefore = g_allocationsCount.load();
+  base::Timer timer;
+  if (options.m_threads == 1)
+  {
+    processQueries();
+  }
+  else
+  {
+    base::thread_pool::computational::ThreadPool threadPool{options.m_threads};
+    threadPool.PerformParallelWorks(processQueries, options.m_threads);
+  }
+  replay.m_wallSeconds = timer.ElapsedSeconds();
+  replay.m_allocationsCount = g_allocationsCount.load() - allocationsBefore;
+  replay.m_resultsCount = resultsCount;
+
+  sort(replay.m_latenciesNs.begin(), replay.m_latenciesNs.end());
+  return replay;
+}
+
+void PrintText(BenchmarkOptions const & options, StartupTimings const & timings,
+               ReplayResults const & replay, Geocoder const & geocoder)
+{
+  auto const printStage = [](char const * name, double seconds) {
+    if (seconds >= 0)
+      cout << name << ": " << fixed << setprecision(3) << seconds << " s" << endl;
+  };
+  printStage("Load", timings.m_loadSeconds);
+  printStage("Build index", timings.m_buildIndexSeconds);
+  printStage("Save to binary index", timings.m_saveSeconds);
+
+  auto const queriesCount = max<size_t>(replay.m_queriesCount, 1);
+  cout << "Queries: " << replay.m_queriesCount << " in " << options.m_threads << " threads"
+       << endl;
+  cout << "Wall time: " << replay.m_wallSeconds << " s" << endl;
+  cout << "QPS: " << (replay.m_wallSeconds > 0 ? replay.m_queriesCount / replay.m_wallSeconds : 0)
+       << endl;
+  cout << "Latency, ms: p50 " << GetPercentileMs(replay.m_latenciesNs, 50) << " p95 "
+       << GetPercentileMs(replay.m_latenciesNs, 95) << " p99 "
+       << GetPercentileMs(replay.m_latenciesNs, 99) << " max "
+       << GetPercentileMs(replay.m_latenciesNs, 100) << endl;
+  cout << "Allocations per query: "
+       << static_cast<double>(replay.m_allocationsCount) / queriesCount << endl;
+  cout << "Results per query: " << static_cast<double>(replay.m_resultsCount) / queriesCount
+       << endl;
+  cout << "Peak RSS: " << GetPeakRssBytes() / (1024 * 1024) << " MB" << endl;
+  if (auto const * cache = geocoder.GetResultCache())
+    cout << "Result cache hit ratio: " << cache->GetHitRatio() << endl;
+#if defined(GEOCODER_QUERY_STATS)
+  cout << DebugPrint(replay.m_stats) << endl;
+#endif
+}
+
+void PrintJson(BenchmarkOptions const & options, StartupTimings const & timings,
+               ReplayResults const & replay, Geocoder const & geocoder)
+{
+  auto const queriesCount = max<size_t>(replay.m_queriesCount, 1);
+
+  auto root = base::NewJSONObject();
+  auto startup = base::NewJSONObject();
+  auto const addStage = [&startup](char const * name, double seconds) {
+    if (seconds >= 0)
+      ToJSONObject(*startup, name, seconds);
+  };
+  addStage("load_s", timings.m_loadSeconds);
+  addStage("build_index_s", timings.m_buildIndexSeconds);
+  addStage("save_binary_index_s", timings.m_saveSeconds);
+  ToJSONObject(*root, "startup", startup);
+
+  auto queries = base::NewJSONObject();
+  ToJSONObject(*queries, "count", static_cast<uint64_t>(replay.m_queriesCount));
+  ToJSONObject(*queries, "threads", options.m_threads);
+  ToJSONObject(*queries, "passes", static_cast<uint64_t>(options.m_passes));
+  ToJSONObject(*queries, "shuffle_seed", options.m_shuffleSeed);
+  ToJSONObject(*queries, "wall_s", replay.m_wallSeconds);
+  ToJSONObject(*queries, "qps",
+               replay.m_wallSeconds > 0 ? replay.m_queriesCount / replay.m_wallSeconds : 0.0);
+  ToJSONObject(*queries, "p50_ms", GetPercentileMs(replay.m_latenciesNs, 50));
+  ToJSONObject(*queries, "p95_ms", GetPercentileMs(replay.m_latenciesNs, 95));
+  ToJSONObject(*queries, "p99_ms", GetPercentileMs(replay.m_latenciesNs, 99));
+  ToJSONObject(*queries, "max_ms", GetPercentileMs(replay.m_latenciesNs, 100));
+  ToJSONObject(*queries, "allocations_per_query",
+               static_cast<double>(replay.m_allocationsCount) / queriesCount);
+  ToJSONObject(*queries, "results_per_query",
+               static_cast<double>(replay.m_resultsCount) / queriesCount);
+  if (auto const * cache = geocoder.GetResultCache())
+    ToJSONObject(*queries, "cache_hit_ratio", cache->GetHitRatio());
+  ToJSONObject(*root, "queries", queries);
+
+  ToJSONObject(*root, "peak_rss_bytes", GetPeakRssBytes());
+
+  cout << base::DumpToString(root, JSON_INDENT(2)) << endl;
+}
+
+BenchmarkOptions DefineOptions(int argc, char * argv[])
+{
+  BenchmarkOptions o;
+  po::options_description optionsDescription;
+
+  optionsDescription.add_options()
+    ("hierarchy_path", po::value(&o.m_hierarchyPath), "Path to the hierarchy file (.jsonl, .jsonl.gz) or to the geocoder index")
+    ("mapped_index", po::bool_switch(&o.m_mappedIndex), "Treat hierarchy_path as a mapped geocoder index")
+    ("queries_path", po::value(&o.m_queriesPath)->default_value(""), "Path to the file with queries, one query per line")
+    ("binary_index_path", po::value(&o.m_binaryIndexPath)->default_value(""), "Path to save the binary index to, the save is timed")
+    ("threads", po::value(&o.m_threads)->default_value(1), "Number of threads to replay the queries")
+    ("load_threads", po::value(&o.m_loadThreads)->default_value(1), "Number of threads to load the jsonl hierarchy")
+    ("passes", po::value(&o.m_passes)->default_value(1), "Number of passes over the queries")
+    ("shuffle_seed", po::value(&o.m_shuffleSeed)->default_value(0), "Seed to shuffle the queries, 0 to replay them in the file order")
+    ("fuzzy", po::bool_switch(&o.m_fuzzy), "Match query tokens with misprints")
+    ("cache_log_size", po::value(&o.m_cacheLogSize)->default_value(0), "Log2 of the number of queries in the result cache, 0 to disable the cache")
+    ("json", po::bool_switch(&o.m_json), "Print the report as json")
+    ("profile_trace", po::value(&o.m_profileTracePath)->default_value(""), "Path to save the Chrome trace of the profiling zones to")
+    ("help", "produce help message");
+
+  po::variables_map vm;
+
+  po::store(po::parse_command_line(argc, argv, optionsDescription), vm);
+  po::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << optionsDescription << std::endl;
+    exit(1);
+  }
+
+  return o;
+}
+}  // namespace
+
+// Every allocation of the benchmark is counted to report the allocations per query.
+// The default operator delete is kept: both libstdc++ and libc++ release memory with free().
+void * operator new(size_t size)
+{
+  g_allocationsCount.fetch_add(1, memory_order_relaxed);
+  if (auto * p = malloc(size == 0 ? 1 : size))
+    return p;
+  throw bad_alloc();
+}
+
+int main(int argc, char * argv[])
+{
+  ios_base::sync_with_stdio(false);
+  BenchmarkOptions options;
+  try
+  {
+    options = DefineOptions(argc, argv);
+  }
+  catch(po::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    return 1;
+  }
+
+  if (options.m_hierarchyPath.empty())
+  {
+    std::cerr << "ERROR: hierarchy_path is required" << std::endl;
+    return 1;
+  }
+  if (options.m_threads == 0 || options.m_loadThreads == 0 || options.m_passes == 0)
+  {
+    std::cerr << "ERROR: threads, load_threads and passes must be positive" << std::endl;
+    return 1;
+  }
+  if (options.m_cacheLogSize >= 32)
+  {
+    std::cerr << "ERROR: cache_log_size must be less than 32" << std::endl;
+    return 1;
+  }
+
+  base::prof::SetEnabled(!options.m_profileTracePath.empty());
+
+  Geocoder geocoder;
+  auto const timings = Load(geocoder, options);
+
+  geocoder.SetFuzzyMatching(options.m_fuzzy);
+  if (options.m_cacheLogSize > 0)
+    geocoder.EnableResultCache(options.m_cacheLogSize);
+
+  ReplayResults replay;
+  if (!options.m_queriesPath.empty())
+  {
+    auto const queries = ReadQueries(options.m_queriesPath, options.m_shuffleSeed);
+    if (!queries.empty())
+      replay = Replay(geocoder, queries, options);
+  }
+
+  if (options.m_json)
+    PrintJson(options, timings, replay, geocoder);
+  else
+    PrintText(options, timings, replay, geocoder);
+
+  if (!options.m_profileTracePath.empty())
+  {
+    try
+    {
+      base::prof::SaveChromeTrace(options.m_profileTracePath);
+    }
+    catch (std::ios_base::failure const & e)
+    {
+      std::cerr << "ERROR: can't write the profile trace: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -1,5 +1,8 @@
 #include "geocoder/geocoder.hpp"
+#include "geocoder/query_server.hpp"
+#include "geocoder/query_stats.hpp"
 #include "geocoder/result.hpp"
+#include "geocoder/sharded_geocoder.hpp"
 
 #include "base/internal/message.hpp"
 #include "base/string_utils.hpp"
@@ -16,45 +19,72 @@ using namespace std;
 
 namespace po = boost::program_options;
 
-void PrintResults(Hierarchy const & hierarchy, vector<Result> const & results, int32_t top)
+void PrintResult(Hierarchy const * hierarchy, Result const & result)
+{
+  cout << "  " << DebugPrint(result);
+  auto const * e = hierarchy ? hierarchy->GetEntryForOsmId(result.m_osmId) : nullptr;
+  if (e)
+  {
+    auto const & dictionary = hierarchy->GetNormalizedNameDictionary();
+    cout << " [";
+    auto const * delimiter = "";
+    for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
+    {
+      if (e->m_normalizedAddress[i] != NameDictionary::kUnspecifiedPosition)
+      {
+        auto type = static_cast<Type>(i);
+        auto multipleNames = e->GetNormalizedMultipleNames(type, dictionary);
+        cout << delimiter << ToString(type) << ": " << multipleNames.GetMainName();
+        delimiter = ", ";
+      }
+    }
+    cout << "]";
+  }
+  cout << endl;
+}
+
+// |getHierarchy| returns the hierarchy of the result or nullptr.
+template <typename GetHierarchy>
+void PrintResultsWith(GetHierarchy && getHierarchy, vector<Result> const & results, int32_t top)
 {
   cout << "Found results: " << results.size() << endl;
   if (results.empty())
     return;
   cout << "Top results:" << endl;
 
-  auto const & dictionary = hierarchy.GetNormalizedNameDictionary();
   for (size_t i = 0; i < results.size(); ++i)
   {
     if (top >= 0 && static_cast<int32_t>(i) >= top)
       break;
-    cout << "  " << DebugPrint(results[i]);
-    if (auto const && e = hierarchy.GetEntryForOsmId(results[i].m_osmId))
-    {
-      cout << " [";
-      auto const * delimiter = "";
-      for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
-      {
-        if (e->m_normalizedAddress[i] != NameDictionary::kUnspecifiedPosition)
-        {
-          auto type = static_cast<Type>(i);
-          auto multipleNames = e->GetNormalizedMultipleNames(type, dictionary);
-          cout << delimiter << ToString(type) << ": " << multipleNames.GetMainName();
-          delimiter = ", ";
-        }
-      }
-      cout << "]";
-    }
-    cout << endl;
+    PrintResult(getHierarchy(results[i]), results[i]);
   }
 }
 
-void ProcessQueriesFromFile(Geocoder const & geocoder, string const & path, int32_t top)
+void PrintResults(Hierarchy const & hierarchy, vector<Result> const & results, int32_t top)
+{
+  PrintResultsWith([&hierarchy](Result const &) { return &hierarchy; }, results, top);
+}
+
+void ProcessQueriesFromFile(Geocoder const & geocoder, string const & path, int32_t top,
+                            unsigned int threads, size_t batchSize, bool printStats)
 {
   ifstream stream(path.c_str());
   CHECK(stream.is_open(), ("Can't open", path));
 
-  vector<Result> results;
+  vector<string> queries;
+  vector<vector<Result>> results;
+  QueryStats stats;
+  auto const processBatch = [&]() {
+    geocoder.ProcessQueries(queries, results, threads, printStats ? &stats : nullptr);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+      cout << queries[i] << endl;
+      PrintResults(geocoder.GetHierarchy(), results[i], top);
+      cout << endl;
+    }
+    queries.clear();
+  };
+
   string s;
   while (getline(stream, s))
   {
@@ -62,14 +92,24 @@ void ProcessQueriesFromFile(Geocoder const & geocoder, string const & path, int3
     if (s.empty())
       continue;
 
-    cout << s << endl;
-    geocoder.ProcessQuery(s, results);
-    PrintResults(geocoder.GetHierarchy(), results, top);
-    cout << endl;
+    queries.push_back(s);
+    if (queries.size() >= batchSize)
+      processBatch();
+  }
+
+  if (!queries.empty())
+    processBatch();
+
+  if (printStats)
+  {
+    cout << DebugPrint(stats) << endl;
+    if (auto const * cache = geocoder.GetResultCache())
+      cout << "Result cache hit ratio: " << cache->GetHitRatio() << endl;
   }
 }
 
-void ProcessQueriesFromCommandLine(Geocoder const & geocoder, int32_t top)
+void ProcessQueriesFromCommandLine(Geocoder const & geocoder, int32_t top, bool printStats,
+                                   bool prefix)
 {
   string query;
   vector<Result> results;
@@ -80,16 +120,73 @@ void ProcessQueriesFromCommandLine(Geocoder const & geocoder, int32_t top)
       break;
     if (query == "q" || query == ":q" || query == "quit")
       break;
-    geocoder.ProcessQuery(query, results);
-    PrintResults(geocoder.GetHierarchy(), results, top);
+    if (prefix)
+    {
+      geocoder.ProcessPrefixQuery(query, results);
+      PrintResults(geocoder.GetHierarchy(), results, top);
+    }
+    else if (printStats)
+    {
+      QueryStats stats;
+      geocoder.ProcessQuery(query, results, stats);
+      PrintResults(geocoder.GetHierarchy(), results, top);
+      cout << DebugPrint(stats) << endl;
+    }
+    else
+    {
+      geocoder.ProcessQuery(query, results);
+      PrintResults(geocoder.GetHierarchy(), results, top);
+    }
+  }
+}
+
+void ProcessShardedQueriesFromCommandLine(ShardedGeocoder const & geocoder,
+                                          string const & countryHint, int32_t top)
+{
+  auto const getHierarchy = [&geocoder](Result const & result) -> Hierarchy const * {
+    for (size_t i = 0; i < geocoder.GetShardsCount(); ++i)
+    {
+      auto const & hierarchy = geocoder.GetShard(i).GetHierarchy();
+      if (hierarchy.GetEntryForOsmId(result.m_osmId))
+        return &hierarchy;
+    }
+    return nullptr;
+  };
+
+  string query;
+  vector<Result> results;
+  while (true)
+  {
+    cout << "> ";
+    if (!getline(cin, query))
+      break;
+    if (query == "q" || query == ":q" || query == "quit")
+      break;
+    geocoder.ProcessQuery(query, results, countryHint);
+    PrintResultsWith(getHierarchy, results, top);
   }
 }
 
 struct CliCommandOptions
 {
   std::string m_hierarchy_path;
+  std::string m_delta_path;
   std::string m_queries_path;
   int32_t m_top;
+  bool m_mapped_index;
+  unsigned int m_threads;
+  size_t m_batch;
+  bool m_stats;
+  bool m_fuzzy;
+  uint32_t m_cache_log_size;
+  bool m_prefix;
+  std::string m_build_shards_dir;
+  std::string m_shards;
+  std::string m_country;
+  bool m_serve;
+  std::string m_socket_path;
+  std::string m_languages;
+  size_t m_max_alt_names;
 };
 
 CliCommandOptions DefineOptions(int argc, char * argv[])
@@ -99,8 +196,23 @@ CliCommandOptions DefineOptions(int argc, char * argv[])
 
   optionsDescription.add_options()
     ("hierarchy_path", po::value(&o.m_hierarchy_path), "Path to the hierarchy file for the geocoder")
+    ("delta_path", po::value(&o.m_delta_path)->default_value(""), "Path to the jsonl delta applied to the loaded hierarchy")
     ("queries_path", po::value(&o.m_queries_path)->default_value(""), "Path to the file with queries")
     ("top", po::value(&o.m_top)->default_value(5), "Number of top results to show for every query, -1 to show all results")
+    ("mapped_index", po::bool_switch(&o.m_mapped_index), "Treat hierarchy_path as a mapped geocoder index")
+    ("threads", po::value(&o.m_threads)->default_value(1), "Number of threads to process queries from queries_path")
+    ("batch", po::value(&o.m_batch)->default_value(10000), "Number of queries from queries_path processed at once")
+    ("stats", po::bool_switch(&o.m_stats), "Print statistics of the queries processing")
+    ("fuzzy", po::bool_switch(&o.m_fuzzy), "Match query tokens with misprints")
+    ("prefix", po::bool_switch(&o.m_prefix), "Treat the last token of the command line queries as a prefix")
+    ("cache_log_size", po::value(&o.m_cache_log_size)->default_value(0), "Log2 of the number of queries in the result cache, 0 to disable the cache")
+    ("build_shards_dir", po::value(&o.m_build_shards_dir)->default_value(""), "Split the jsonl hierarchy_path by countries into the mapped index shards in this directory and exit")
+    ("shards", po::value(&o.m_shards)->default_value(""), "Comma-separated paths of the mapped index shards to process the command line queries with")
+    ("country", po::value(&o.m_country)->default_value(""), "Country hint routing the queries to the shards")
+    ("serve", po::bool_switch(&o.m_serve), "Answer the queries from stdin with json lines in threads workers until the end of stdin")
+    ("socket_path", po::value(&o.m_socket_path)->default_value(""), "Answer the queries from the connections of this Unix socket like --serve")
+    ("languages", po::value(&o.m_languages)->default_value(""), "Comma-separated locales of the alternative names loaded from the jsonl, all locales if empty")
+    ("max_alt_names", po::value(&o.m_max_alt_names)->default_value(0), "Max number of the alternative names of an address field loaded from the jsonl, 0 for no limit")
     ("help", "produce help message");
 
   po::variables_map vm;
@@ -131,23 +243,86 @@ int main(int argc, char * argv[])
     return 1;
   }
 
+  Hierarchy::NamesFilter namesFilter;
+  namesFilter.m_locales = strings::Tokenize(options.m_languages, ",");
+  namesFilter.m_maxAltNames = options.m_max_alt_names;
+
+  if (!options.m_build_shards_dir.empty())
+  {
+    ShardedGeocoder::BuildShards(options.m_hierarchy_path, options.m_build_shards_dir,
+                                 false /* dataVersionHeadline */, options.m_threads, namesFilter);
+    return 0;
+  }
+
+  if (!options.m_shards.empty())
+  {
+    ShardedGeocoder shardedGeocoder;
+    for (auto const & path : strings::Tokenize(options.m_shards, ","))
+      shardedGeocoder.AddShard(path);
+    ProcessShardedQueriesFromCommandLine(shardedGeocoder, options.m_country, options.m_top);
+    return 0;
+  }
+
   Geocoder geocoder;
-  if (strings::EndsWith(options.m_hierarchy_path, ".jsonl") ||
+  if (options.m_mapped_index)
+  {
+    geocoder.LoadFromMappedIndex(options.m_hierarchy_path);
+  }
+  else if (strings::EndsWith(options.m_hierarchy_path, ".jsonl") ||
       strings::EndsWith(options.m_hierarchy_path, ".jsonl.gz"))
   {
-    geocoder.LoadFromJsonl(options.m_hierarchy_path);
+    geocoder.LoadFromJsonl(options.m_hierarchy_path, false /* dataVersionHeadline */,
+                           1 /* loadThreadsCount */, namesFilter);
   }
   else
   {
     geocoder.LoadFromBinaryIndex(options.m_hierarchy_path);
   }
 
+  if (!options.m_delta_path.empty())
+  {
+    geocoder.ApplyDeltaFromJsonl(options.m_delta_path, false /* dataVersionHeadline */,
+                                 1 /* loadThreadsCount */, namesFilter);
+  }
+
+  geocoder.SetFuzzyMatching(options.m_fuzzy);
+  if (options.m_cache_log_size > 0)
+  {
+    if (options.m_cache_log_size >= 32)
+    {
+      std::cerr << "ERROR: cache_log_size must be less than 32" << std::endl;
+      return 1;
+    }
+    geocoder.EnableResultCache(options.m_cache_log_size);
+  }
+
+  if (options.m_serve || !options.m_socket_path.empty())
+  {
+    if (options.m_threads == 0)
+    {
+      std::cerr << "ERROR: threads must be positive" << std::endl;
+      return 1;
+    }
+    QueryServer server(geocoder, options.m_threads);
+    if (!options.m_socket_path.empty())
+      server.ServeUnixSocket(options.m_socket_path);
+    else
+      server.Serve(cin, cout);
+    return 0;
+  }
+
   if (!options.m_queries_path.empty())
   {
-    ProcessQueriesFromFile(geocoder, options.m_queries_path, options.m_top);
+    if (options.m_threads == 0 || options.m_batch == 0)
+    {
+      std::cerr << "ERROR: threads and batch must be positive" << std::endl;
+      return 1;
+    }
+    ProcessQueriesFromFile(geocoder, options.m_queries_path, options.m_top, options.m_threads,
+                           options.m_batch, options.m_stats);
     return 0;
   }
 
-  ProcessQueriesFromCommandLine(geocoder, options.m_top);
+  ProcessQueriesFromCommandLine(geocoder, options.m_top, options.m_stats, options.m_prefix);
   return 0;
 }
@@ -0,0 +1,69 @@
+#include "geocoder/geocoder_handle.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/timer.hpp"
+
+#include <utility>
+
+using namespace std;
+
+namespace geocoder
+{
+GeocoderHandle::GeocoderHandle(SetUpFn setUp)
+  : m_setUp(move(setUp)), m_geocoder(make_shared<Geocoder const>())
+{
+}
+
+shared_ptr<Geocoder const> GeocoderHandle::Get() const { return atomic_load(&m_geocoder); }
+
+uint64_t GeocoderHandle::GetGeneration() const { return m_generation.load(); }
+
+void GeocoderHandle::Load(string const & path, IndexFormat format, unsigned int loadThreadsCount)
+{
+  lock_guard<mutex> lock(m_loadMutex);
+
+  base::Timer timer;
+  // The current geocoder keeps serving the queries while the new one is loaded.
+  auto geocoder = make_shared<Geocoder>();
+  switch (format)
+  {
+  case IndexFormat::Jsonl:
+    geocoder->LoadFromJsonl(path, false /* dataVersionHeadline */, loadThreadsCount);
+    break;
+  case IndexFormat::BinaryIndex: geocoder->LoadFromBinaryIndex(path); break;
+  case IndexFormat::MappedIndex: geocoder->LoadFromMappedIndex(path); break;
+  }
+  if (m_setUp)
+    m_setUp(*geocoder);
+
+  // The previous geocoder is destroyed by the last of the queries holding it.
+  atomic_store(&m_geocoder, shared_ptr<Geocoder const>(move(geocoder)));
+  auto const generation = ++m_generation;
+  LOG(LINFO, ("Geocoder generation", generation, "is loaded from", path, "as", format, "in",
+              timer.ElapsedSeconds(), "seconds"));
+}
+
+future<void> GeocoderHandle::LoadAsync(string const & path, IndexFormat format,
+                                       unsigned int loadThreadsCount)
+{
+  return async(launch::async,
+               [this, path, format, loadThreadsCount] { Load(path, format, loadThreadsCount); });
+}
+
+void GeocoderHandle::ProcessQuery(string const & query, vector<Result> & results) const
+{
+  Get()->ProcessQuery(query, results);
+}
+
+string DebugPrint(GeocoderHandle::IndexFormat format)
+{
+  switch (format)
+  {
+  case GeocoderHandle::IndexFormat::Jsonl: return "Jsonl";
+  case GeocoderHandle::IndexFormat::BinaryIndex: return "BinaryIndex";
+  case GeocoderHandle::IndexFormat::MappedIndex: return "MappedIndex";
+  }
+  UNREACHABLE();
+}
+}  // namespace geocoder
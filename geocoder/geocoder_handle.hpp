@@ -0,0 +1,63 @@
+#pragma once
+
+#include "geocoder/geocoder.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace geocoder
+{
+// A handle of the geocoder serving the queries which allows replacing its data without
+// a downtime. A new geocoder is loaded aside and is swapped with the current one atomically:
+// the queries started before the swap finish on the previous geocoder, which is destroyed
+// together with the last of its queries, and the next queries get the new one.
+// The mapped index is recommended for the reloads: the loaded geocoder works right with the
+// mapped memory, so the two versions do not take twice the memory unlike the binary index.
+// A new mapped index is to be written aside and renamed over the served one, the previous
+// geocoder keeps the mapping of the replaced file then.
+class GeocoderHandle
+{
+public:
+  enum class IndexFormat
+  {
+    Jsonl,
+    BinaryIndex,
+    MappedIndex,
+  };
+
+  // Sets up a newly loaded geocoder before it is swapped in, e.g. enables the result cache.
+  using SetUpFn = std::function<void(Geocoder & geocoder)>;
+
+  // The handle holds an empty geocoder until the first load.
+  explicit GeocoderHandle(SetUpFn setUp = {});
+
+  // Returns the current geocoder. The returned geocoder stays valid while it is held,
+  // even if the handle is reloaded meanwhile.
+  std::shared_ptr<Geocoder const> Get() const;
+  // The number of the successful loads.
+  uint64_t GetGeneration() const;
+
+  // Loads the geocoder from |path| and swaps it in. Throws Geocoder::Exception when the load
+  // fails, the current geocoder is kept then. Loads are serialized with each other.
+  void Load(std::string const & path, IndexFormat format, unsigned int loadThreadsCount = 1);
+  // The same as Load() in a background thread. The future rethrows the load exception.
+  std::future<void> LoadAsync(std::string const & path, IndexFormat format,
+                              unsigned int loadThreadsCount = 1);
+
+  void ProcessQuery(std::string const & query, std::vector<Result> & results) const;
+
+private:
+  SetUpFn m_setUp;
+  std::shared_ptr<Geocoder const> m_geocoder;
+  std::atomic<uint64_t> m_generation{0};
+  std::mutex m_loadMutex;
+};
+
+std::string DebugPrint(GeocoderHandle::IndexFormat format);
+}  // namespace geocoder
@@ -0,0 +1,81 @@
+#include "testing/testing.hpp"
+
+#include "geocoder/geocoder_handle.hpp"
+
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace platform::tests_support;
+using namespace std;
+
+namespace
+{
+using Id = base::GeoObjectId;
+
+string const kCubaData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Cuba"}}}, "rank": 2}}
+)#";
+string const kRussiaData = R"#(
+20 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Russia"}}}, "rank": 1}}
+)#";
+
+vector<Id> Search(geocoder::Geocoder const & geocoder, string const & query)
+{
+  vector<geocoder::Result> results;
+  geocoder.ProcessQuery(query, results);
+  vector<Id> ids;
+  for (auto const & result : results)
+    ids.push_back(result.m_osmId);
+  return ids;
+}
+}  // namespace
+
+namespace geocoder
+{
+UNIT_TEST(GeocoderHandle_Reload)
+{
+  ScopedFile const cubaJsonFile("cuba.jsonl", kCubaData);
+  ScopedFile const russiaJsonFile("russia.jsonl", kRussiaData);
+  ScopedFile const russiaIndexFile("russia.mapidx", ScopedFile::Mode::DoNotCreate);
+  {
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(russiaJsonFile.GetFullPath());
+    geocoder.SaveToMappedIndex(russiaIndexFile.GetFullPath());
+  }
+
+  size_t setUpsCount = 0;
+  GeocoderHandle handle([&setUpsCount](Geocoder & geocoder) {
+    geocoder.EnableResultCache(4 /* logCacheSize */);
+    ++setUpsCount;
+  });
+  TEST_EQUAL(handle.GetGeneration(), 0, ());
+  TEST(Search(*handle.Get(), "cuba").empty(), ());
+
+  handle.Load(cubaJsonFile.GetFullPath(), GeocoderHandle::IndexFormat::Jsonl);
+  TEST_EQUAL(handle.GetGeneration(), 1, ());
+  TEST_EQUAL(setUpsCount, 1, ());
+  TEST(handle.Get()->GetResultCache(), ());
+
+  // A query holding the previous geocoder finishes on it after the swap.
+  auto const cuba = handle.Get();
+  handle.LoadAsync(russiaIndexFile.GetFullPath(), GeocoderHandle::IndexFormat::MappedIndex).get();
+  TEST_EQUAL(handle.GetGeneration(), 2, ());
+  TEST_EQUAL(setUpsCount, 2, ());
+  TEST_EQUAL(Search(*cuba, "cuba"), vector<Id>{Id{0x10}}, ());
+  TEST(Search(*handle.Get(), "cuba").empty(), ());
+  TEST_EQUAL(Search(*handle.Get(), "russia"), vector<Id>{Id{0x20}}, ());
+
+  // A failed load keeps the current geocoder.
+  auto future = handle.LoadAsync(cubaJsonFile.GetFullPath() + ".missing",
+                                 GeocoderHandle::IndexFormat::MappedIndex);
+  TEST_ANY_THROW(future.get(), ());
+  TEST_EQUAL(handle.GetGeneration(), 2, ());
+  vector<Result> results;
+  handle.ProcessQuery("russia", results);
+  TEST_EQUAL(results.size(), 1, ());
+}
+}  // namespace geocoder
@@ -1,5 +1,6 @@
 #include "testing/testing.hpp"
 
+#include "geocoder/binary_hierarchy.hpp"
 #include "geocoder/geocoder.hpp"
 #include "geocoder/hierarchy_reader.hpp"
 
@@ -7,14 +8,21 @@
 #include "platform/platform_tests_support/scoped_file.hpp"
 
 #include "base/geo_object_id.hpp"
+#include "base/levenshtein_dfa.hpp"
 #include "base/math.hpp"
 #include "base/stl_helpers.hpp"
 
 #include <algorithm>
+#include <fstream>
 #include <iomanip>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <boost/archive/binary_oarchive.hpp>
+
 using namespace platform::tests_support;
 using namespace std;
 
@@ -28,8 +36,19 @@ C00000000004B279 {"type": "Feature", "geometry": {"type": "Point", "coordinates"
 C0000000001C4CA7 {"type": "Feature", "geometry": {"type": "Point", "coordinates": [-78.7260117405499, 21.74300205]}, "properties": {"kind": "province", "locales": {"default": {"name": "Ciego de Ávila", "address": {"region": "Ciego de Ávila", "country": "Cuba"}}}, "rank": 4}}
 C00000000059D6B5 {"type": "Feature", "geometry": {"type": "Point", "coordinates": [-78.9263054493181, 22.08185765]}, "properties": {"kind": "district", "locales": {"default": {"name": "Florencia", "address": {"subregion": "Florencia", "region": "Ciego de Ávila", "country": "Cuba"}}}, "rank": 6}}
 )#";
+
+// The single archive binary index of the former format version, only its version is written.
+struct FormerVersionIndex
+{
+  template <class Archive>
+  void serialize(Archive & /* ar */, unsigned int const /* version */)
+  {
+  }
+};
 }  // namespace
 
+BOOST_CLASS_VERSION(FormerVersionIndex, geocoder::kIndexFormatVersion - 1)
+
 namespace geocoder
 {
 void TestGeocoder(Geocoder & geocoder, string const & query, vector<Result> && expected)
@@ -85,6 +104,130 @@ UNIT_TEST(Geocoder_Hierarchy)
              "florencia", ());
 }
 
+UNIT_TEST(Geocoder_BinaryHierarchy)
+{
+  auto const makeEntry = [](Id const & osmId, string const & kind, uint8_t rank,
+                            vector<pair<Type, string>> const & address) {
+    BinaryHierarchyEntry entry;
+    entry.m_osmId = osmId;
+    entry.m_kind = KindFromString(kind);
+    entry.m_rank = rank;
+    entry.m_hasName = true;
+    for (auto const & field : address)
+      entry.m_address[static_cast<size_t>(field.first)].emplace_back("default", field.second);
+    return entry;
+  };
+
+  // The chunks of the regions of kRegionsData, the files of the chunks are concatenated.
+  BinaryHierarchyChunkBuilder builder;
+  builder.Add(makeEntry(Id{0xc00000000004b279}, "country", 2, {{Type::Country, "Cuba"}}));
+  auto data = builder.Release();
+  builder.Add(makeEntry(Id{0xc0000000001c4ca7}, "province", 4,
+                        {{Type::Region, "Ciego de Ávila"}, {Type::Country, "Cuba"}}));
+  builder.Add(makeEntry(Id{0xc00000000059d6b5}, "district", 6,
+                        {{Type::Subregion, "Florencia"}, {Type::Region, "Ciego de Ávila"},
+                         {Type::Country, "Cuba"}}));
+  data += builder.Release();
+
+  Geocoder geocoder;
+  ScopedFile const regionsBinaryFile("regions.ghb", data);
+  geocoder.LoadFromJsonl(regionsBinaryFile.GetFullPath());
+
+  Geocoder jsonGeocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  jsonGeocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  auto const & hierarchy = geocoder.GetHierarchy();
+  auto const & jsonHierarchy = jsonGeocoder.GetHierarchy();
+  auto const entries = hierarchy.GetEntries();
+  auto const jsonEntries = jsonHierarchy.GetEntries();
+  TEST_EQUAL(entries.size(), jsonEntries.size(), ());
+  for (size_t i = 0; i < min(entries.size(), jsonEntries.size()); ++i)
+  {
+    auto const & entry = entries[i];
+    auto const & jsonEntry = jsonEntries[i];
+    TEST_EQUAL(entry.m_osmId, jsonEntry.m_osmId, ());
+    TEST_EQUAL(entry.m_type, jsonEntry.m_type, ());
+    TEST_EQUAL(entry.m_kind, jsonEntry.m_kind, ());
+    for (size_t type = 0; type < static_cast<size_t>(Type::Count); ++type)
+    {
+      auto const t = static_cast<Type>(type);
+      TEST_EQUAL(entry.HasFieldInAddress(t), jsonEntry.HasFieldInAddress(t), ());
+      if (!entry.HasFieldInAddress(t))
+        continue;
+      TEST_EQUAL(
+          entry.GetNormalizedMultipleNames(t, hierarchy.GetNormalizedNameDictionary())
+              .GetMainName(),
+          jsonEntry.GetNormalizedMultipleNames(t, jsonHierarchy.GetNormalizedNameDictionary())
+              .GetMainName(),
+          ());
+    }
+  }
+
+  base::GeoObjectId const florenciaId(0xc00000000059d6b5);
+  base::GeoObjectId const cubaId(0xc00000000004b279);
+  TestGeocoder(geocoder, "cuba florencia", {{florenciaId, 1.0}, {cubaId, 0.713776}});
+}
+
+UNIT_TEST(Geocoder_IndexTokenIds)
+{
+  Geocoder geocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  auto const & index = geocoder.GetIndex();
+
+  TEST_NOT_EQUAL(index.GetTokenId("ciego"), Index::kInvalidTokenId, ());
+  TEST_EQUAL(index.GetTokenId("havana"), Index::kInvalidTokenId, ());
+
+  auto const countDocs = [&index](Tokens const & tokens) {
+    size_t count = 0;
+    index.ForEachDocId(tokens, [&count](Index::DocId const &) { ++count; });
+    return count;
+  };
+
+  TEST_EQUAL(countDocs({"ciego", "de", "avila"}), 1, ());
+  TEST_EQUAL(countDocs({"avila", "ciego", "de"}), 1, ());
+  // A prefix of the indexed name.
+  TEST_EQUAL(countDocs({"ciego", "de"}), 0, ());
+  TEST_EQUAL(countDocs({"ciego", "de", "avila", "havana"}), 0, ());
+  TEST_EQUAL(countDocs({}), 0, ());
+}
+
+UNIT_TEST(Geocoder_IndexTokensWithMisprints)
+{
+  Geocoder geocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  auto const & index = geocoder.GetIndex();
+
+  auto const florenciaId = index.GetTokenId("florencia");
+  TEST_NOT_EQUAL(florenciaId, Index::kInvalidTokenId, ());
+  TEST_EQUAL(index.GetTokenIdWithMisprints("florencia"), florenciaId, ());
+  TEST_EQUAL(index.GetTokenIdWithMisprints("florensia"), florenciaId, ());
+  TEST_EQUAL(index.GetTokenIdWithMisprints("florenca"), florenciaId, ());
+  TEST_EQUAL(index.GetTokenIdWithMisprints("havana"), Index::kInvalidTokenId, ());
+  // Short tokens are matched exactly only.
+  TEST_EQUAL(index.GetTokenIdWithMisprints("cub"), Index::kInvalidTokenId, ());
+
+  vector<Index::TokenId> matched;
+  index.ForEachTokenIdWithMisprints(strings::LevenshteinDFA("avilo", 1 /* maxErrors */),
+                                    [&](Index::TokenId tokenId, size_t errors) {
+                                      TEST_EQUAL(errors, 1, ());
+                                      matched.push_back(tokenId);
+                                    });
+  TEST_EQUAL(matched, vector<Index::TokenId>{index.GetTokenId("avila")}, ());
+
+  base::GeoObjectId const florenciaOsmId(0xc00000000059d6b5);
+  base::GeoObjectId const cubaOsmId(0xc00000000004b279);
+  vector<Result> results;
+  geocoder.ProcessQuery("cuba florensia", results);
+  TEST(none_of(results.begin(), results.end(),
+               [&](Result const & r) { return r.m_osmId == florenciaOsmId; }),
+       (results));
+  geocoder.SetFuzzyMatching(true);
+  TestGeocoder(geocoder, "cuba florensia", {{florenciaOsmId, 1.0}, {cubaOsmId, 0.713776}});
+}
+
 UNIT_TEST(Geocoder_EnglishNames)
 {
   string const kData = R"#(
@@ -99,6 +242,52 @@ UNIT_TEST(Geocoder_EnglishNames)
   TestGeocoder(geocoder, "Moscow, New Arbat", {{Id{0x11}, 1.0}, {Id{0x10}, 0.558011}});
 }
 
+UNIT_TEST(Geocoder_NamesFilter)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва"}}, "en": {"address": {"locality": "Moscow"}}, "de": {"address": {"locality": "Moskau"}}}}}
+)#";
+
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  auto const countNames = [](Geocoder const & geocoder) {
+    auto const & entry = geocoder.GetHierarchy().GetEntries()[0];
+    return entry
+        .GetNormalizedMultipleNames(Type::Locality,
+                                    geocoder.GetHierarchy().GetNormalizedNameDictionary())
+        .size();
+  };
+
+  {
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+    TEST_EQUAL(countNames(geocoder), 3, ());
+    TestGeocoder(geocoder, "Moskau", {{Id{0x10}, 1.0}});
+  }
+
+  {
+    Hierarchy::NamesFilter namesFilter;
+    namesFilter.m_locales = {"en"};
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath(), false /* dataVersionHeadline */,
+                           1 /* loadThreadsCount */, namesFilter);
+    TEST_EQUAL(countNames(geocoder), 2, ());
+    TestGeocoder(geocoder, "Москва", {{Id{0x10}, 1.0}});
+    TestGeocoder(geocoder, "Moscow", {{Id{0x10}, 1.0}});
+    TestGeocoder(geocoder, "Moskau", {});
+  }
+
+  {
+    Hierarchy::NamesFilter namesFilter;
+    namesFilter.m_maxAltNames = 1;
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath(), false /* dataVersionHeadline */,
+                           1 /* loadThreadsCount */, namesFilter);
+    TEST_EQUAL(countNames(geocoder), 2, ());
+    TestGeocoder(geocoder, "Moscow", {{Id{0x10}, 1.0}});
+    TestGeocoder(geocoder, "Moskau", {});
+  }
+}
+
 UNIT_TEST(Geocoder_OnlyBuildings)
 {
   string const kData = R"#(
@@ -193,6 +382,59 @@ UNIT_TEST(Geocoder_HouseNumberPartialMatch)
   TestGeocoder(geocoder, "Москва, Зорге 7 A", {{Id{0x12}, 0.95}});
 }
 
+UNIT_TEST(Geocoder_HouseNumbersIndex)
+{
+  ostringstream data;
+  data << R"#(
+10 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва"}}}}}
+11 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Зорге", "locality": "Москва"}}}}}
+12 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "7", "street": "Зорге", "locality": "Москва"}}}}}
+13 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "7 к2", "street": "Зорге", "locality": "Москва"}}}}}
+14 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "7 к2 с3", "street": "Зорге", "locality": "Москва"}}}}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "17", "street": "Зорге", "locality": "Москва"}}}}}
+)#";
+  // Enough buildings on the street to look them up by the house numbers index.
+  for (size_t i = 0; i < 64; ++i)
+  {
+    data << hex << 0x100 + i << dec << R"#( {"properties": {"kind": "building", "locales": {"default": {"address": {"building": ")#"
+         << 100 + i << R"#(", "street": "Зорге", "locality": "Москва"}}}}})#" << '\n';
+  }
+
+  ScopedFile const regionsJsonFile("regions.jsonl", data.str());
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  Geocoder geocoderFromJsonl;
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+  Geocoder geocoderFromMappedIndex;
+  geocoderFromMappedIndex.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+
+  for (auto * geocoder : {&geocoderFromJsonl, &geocoderFromMappedIndex})
+  {
+    auto const & index = geocoder->GetIndex();
+    vector<search::house_numbers::Token> queryParse;
+    search::house_numbers::ParseQuery(strings::MakeUniString("7 к2"), false /* queryIsPrefix */,
+                                      queryParse);
+    index.ForEachDocId({"зорге"}, [&](Index::DocId const & streetDocId) {
+      if (index.GetDoc(streetDocId).m_type != Type::Street)
+        return;
+
+      vector<Id> buildings;
+      index.ForEachRelatedBuildingWithHouseNumber(
+          streetDocId, queryParse, [&](Index::DocId const & buildingDocId) {
+            buildings.push_back(index.GetDoc(buildingDocId).m_osmId);
+          });
+      TEST_EQUAL(buildings, vector<Id>({Id{0x12}, Id{0x13}, Id{0x14}}), ());
+    });
+
+    TestGeocoder(*geocoder, "Москва, Зорге 7к2",
+                 {{Id{0x13}, 1.0}, {Id{0x14}, 0.995}, {Id{0x12}, 0.975}});
+    TestGeocoder(*geocoder, "Москва, Зорге 7",
+                 {{Id{0x12}, 1.0}, {Id{0x13}, 0.993}, {Id{0x14}, 0.990}});
+    TestGeocoder(*geocoder, "Москва, Зорге 7A", {{Id{0x12}, 0.95}});
+    TestGeocoder(*geocoder, "Москва, Зорге 117", {{Id{0x111}, 1.0}});
+  }
+}
+
 // Geocoder_Moscow* -----------------------------------------------------------------------------
 UNIT_TEST(Geocoder_MoscowLocalityRank)
 {
@@ -464,6 +706,587 @@ UNIT_TEST(Geocoder_Serialization)
   }
 }
 
+UNIT_TEST(Geocoder_BinaryIndexSegments)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}, "en": {"address": {"country": "Russia"}}}, "rank": 1}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+
+  Geocoder geocoderFromJsonl;
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  vector<Result> expected;
+  geocoderFromJsonl.ProcessQuery("Москва, Арбат, 4", expected);
+  TEST(!expected.empty(), ());
+
+  ScopedFile const indexFile("regions.tokidx", ScopedFile::Mode::DoNotCreate);
+  geocoderFromJsonl.SaveToBinaryIndex(indexFile.GetFullPath());
+  string index;
+  {
+    ifstream stream(indexFile.GetFullPath(), ios::binary);
+    index.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+  }
+
+  auto const load = [&indexFile](string const & data) {
+    {
+      ofstream stream(indexFile.GetFullPath(), ios::binary);
+      stream << data;
+    }
+    Geocoder geocoder;
+    geocoder.LoadFromBinaryIndex(indexFile.GetFullPath());
+  };
+
+  Geocoder geocoderFromIndex;
+  geocoderFromIndex.LoadFromBinaryIndex(indexFile.GetFullPath());
+  TestGeocoder(geocoderFromIndex, "Москва, Арбат, 4", vector<Result>(expected));
+
+  // The truncated and corrupted indexes are not loaded.
+  TEST_THROW(load(index.substr(0, index.size() - 1)), Geocoder::Exception, ());
+  TEST_THROW(load(index + '\0'), Geocoder::Exception, ());
+  auto corrupted = index;
+  corrupted[corrupted.size() / 2] ^= 1;
+  TEST_THROW(load(corrupted), Geocoder::Exception, ());
+
+  // The indexes of the single archive format of the current version are still loaded.
+  {
+    ofstream stream(indexFile.GetFullPath(), ios::binary);
+    boost::archive::binary_oarchive archive{stream};
+    archive << geocoderFromJsonl;
+  }
+  Geocoder geocoderFromLegacyIndex;
+  geocoderFromLegacyIndex.LoadFromBinaryIndex(indexFile.GetFullPath());
+  TestGeocoder(geocoderFromLegacyIndex, "Москва, Арбат, 4", move(expected));
+
+  // The single archive indexes of the former versions are rejected.
+  {
+    ofstream stream(indexFile.GetFullPath(), ios::binary);
+    boost::archive::binary_oarchive archive{stream};
+    archive << FormerVersionIndex();
+  }
+  Geocoder geocoderFromFormerIndex;
+  TEST_THROW(geocoderFromFormerIndex.LoadFromBinaryIndex(indexFile.GetFullPath()),
+             Geocoder::Exception, ());
+}
+
+UNIT_TEST(Geocoder_BinaryIndexOfMappedGeocoder)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+  string const kOtherData = R"#(
+20 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Беларусь"}}}, "rank": 1}}
+21 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Минск", "country": "Беларусь"}}}, "rank": 4}}
+)#";
+
+  Geocoder geocoderFromJsonl;
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+
+  Geocoder otherGeocoder;
+  ScopedFile const otherJsonFile("other_regions.jsonl", kOtherData);
+  otherGeocoder.LoadFromJsonl(otherJsonFile.GetFullPath());
+  ScopedFile const indexFile("other_regions.tokidx", ScopedFile::Mode::DoNotCreate);
+  otherGeocoder.SaveToBinaryIndex(indexFile.GetFullPath());
+
+  Geocoder geocoder;
+  geocoder.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+
+  // The mapped geocoder is not saved to a binary index.
+  ScopedFile const mappedBinaryIndexFile("regions.tokidx", ScopedFile::Mode::DoNotCreate);
+  TEST_THROW(geocoder.SaveToBinaryIndex(mappedBinaryIndexFile.GetFullPath()), Geocoder::Exception,
+             ());
+
+  // The binary index replaces the mapped one.
+  geocoder.LoadFromBinaryIndex(indexFile.GetFullPath());
+  TEST_EQUAL(geocoder.GetHierarchy().GetEntries().size(), 2, ());
+  TEST(!geocoder.GetHierarchy().GetEntryForOsmId(Id{0x13}), ());
+  TestGeocoder(geocoder, "Москва", {});
+  TestGeocoder(geocoder, "Минск", {{Id{0x21}, 1.0}});
+
+  // The loaded geocoder is not mapped anymore, so it is saved again.
+  geocoder.SaveToBinaryIndex(mappedBinaryIndexFile.GetFullPath());
+  Geocoder geocoderFromBinaryIndex;
+  geocoderFromBinaryIndex.LoadFromBinaryIndex(mappedBinaryIndexFile.GetFullPath());
+  TestGeocoder(geocoderFromBinaryIndex, "Минск", {{Id{0x21}, 1.0}});
+}
+
+UNIT_TEST(Geocoder_MappedIndex)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}, "en": {"address": {"country": "Russia"}}}, "rank": 1}}
+11 {"properties": {"kind": "state", "locales": {"default": {"address": {"region": "Москва", "country": "Россия"}}}, "rank": 2}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 8}}
+16 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "6", "street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+
+  Geocoder geocoderFromJsonl;
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+
+  Geocoder geocoderFromMappedIndex;
+  geocoderFromMappedIndex.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+
+  TEST_EQUAL(geocoderFromMappedIndex.GetHierarchy().GetEntries().size(),
+             geocoderFromJsonl.GetHierarchy().GetEntries().size(), ());
+  TEST(geocoderFromMappedIndex.GetHierarchy().GetEntryForOsmId(Id{0x13}), ());
+  TEST(!geocoderFromMappedIndex.GetHierarchy().GetEntryForOsmId(Id{0x14}), ());
+
+  auto const & hierarchy = geocoderFromMappedIndex.GetHierarchy();
+  auto const * city = hierarchy.GetEntryForOsmId(Id{0x12});
+  auto const * street = hierarchy.GetEntryForOsmId(Id{0x13});
+  auto const * building = hierarchy.GetEntryForOsmId(Id{0x15});
+  TEST(city && street && building, ());
+  TEST(hierarchy.IsParentTo(*city, *building), ());
+  TEST(hierarchy.IsParentTo(*street, *building), ());
+  TEST(!hierarchy.IsParentTo(*building, *street), ());
+  // The entries out of the hierarchy are compared by their addresses too.
+  auto const streetCopy = *street;
+  auto const buildingCopy = *building;
+  TEST(hierarchy.IsParentTo(streetCopy, buildingCopy), ());
+  TEST(!hierarchy.IsParentTo(buildingCopy, streetCopy), ());
+
+  for (auto const & name : {"russia", "россия", "москва", "арбат", "тверская"})
+  {
+    auto const collect = [&name](Index const & index) {
+      vector<base::GeoObjectId> objects;
+      index.ForEachDocId({name}, [&](Index::DocId const & docId) {
+        objects.emplace_back(index.GetDoc(docId).m_osmId);
+        index.ForEachRelatedBuilding(docId, [&](Index::DocId const & docId) {
+          objects.emplace_back(index.GetDoc(docId).m_osmId);
+        });
+      });
+      sort(objects.begin(), objects.end());
+      return objects;
+    };
+
+    TEST_EQUAL(collect(geocoderFromMappedIndex.GetIndex()), collect(geocoderFromJsonl.GetIndex()),
+               (name));
+  }
+
+  TestGeocoder(geocoderFromMappedIndex, "Москва, Арбат 4", {{Id{0x15}, 1.0}});
+  TestGeocoder(geocoderFromMappedIndex, "Russia", {{Id{0x10}, 1.0}});
+}
+
+UNIT_TEST(Geocoder_TypedPostings)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}}
+11 {"properties": {"kind": "state", "locales": {"default": {"address": {"region": "Москва", "country": "Россия"}}}, "rank": 2}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Москва", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 7}}
+)#";
+
+  Geocoder geocoderFromJsonl;
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+
+  Geocoder geocoderFromMappedIndex;
+  geocoderFromMappedIndex.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+
+  for (auto const * geocoder : {&geocoderFromJsonl, &geocoderFromMappedIndex})
+  {
+    auto const & index = geocoder->GetIndex();
+    Index::TokenIds tokenIds;
+    tokenIds.push_back(index.GetTokenId("москва"));
+
+    vector<Id> all;
+    index.ForEachDocIdByTokenIds(tokenIds, [&](Index::DocId const & docId) {
+      all.push_back(index.GetDoc(docId).m_osmId);
+    });
+    // The docs go in the order of their types.
+    TEST_EQUAL(all, vector<Id>({Id{0x11}, Id{0x12}, Id{0x13}}), ());
+
+    auto const collect = [&](Type type) {
+      vector<Id> objects;
+      index.ForEachDocIdByTokenIds(tokenIds, type, [&](Index::DocId const & docId) {
+        TEST_EQUAL(index.GetDoc(docId).m_type, type, ());
+        objects.push_back(index.GetDoc(docId).m_osmId);
+      });
+      return objects;
+    };
+
+    TEST_EQUAL(collect(Type::Country), vector<Id>(), ());
+    TEST_EQUAL(collect(Type::Region), vector<Id>({Id{0x11}}), ());
+    TEST_EQUAL(collect(Type::Locality), vector<Id>({Id{0x12}}), ());
+    TEST_EQUAL(collect(Type::Street), vector<Id>({Id{0x13}}), ());
+  }
+
+  vector<Result> expected;
+  geocoderFromJsonl.ProcessQuery("Москва", expected);
+  TEST_EQUAL(expected.size(), 3, (expected));
+  TestGeocoder(geocoderFromMappedIndex, "Москва", move(expected));
+}
+
+UNIT_TEST(Geocoder_ConcurrentIndexBuild)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}, "en": {"address": {"country": "Russia"}}}, "rank": 1}}
+11 {"properties": {"kind": "state", "locales": {"default": {"address": {"region": "Москва", "country": "Россия"}}}, "rank": 2}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 7}}
+14 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "улица Тверская", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 8}}
+16 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "6", "street": "Арбат", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 8}}
+17 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "1", "street": "улица Тверская", "locality": "Москва", "region": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+
+  auto const buildMappedIndex = [&](unsigned int threadsCount) {
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath(), false, threadsCount);
+
+    ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+    geocoder.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+
+    ifstream stream(mappedIndexFile.GetFullPath(), ios::binary);
+    return string(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+  };
+
+  // The index does not depend on the number of threads it is built with.
+  auto const expected = buildMappedIndex(1 /* threadsCount */);
+  TEST(!expected.empty(), ());
+  for (unsigned int threadsCount : {2, 3, 8})
+    TEST(buildMappedIndex(threadsCount) == expected, (threadsCount));
+}
+
+UNIT_TEST(Geocoder_EmptyMappedIndex)
+{
+  Geocoder geocoderFromJsonl;
+  ScopedFile const regionsJsonFile("regions.jsonl", "");
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+
+  Geocoder geocoder;
+  geocoder.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+  TEST_EQUAL(geocoder.GetHierarchy().GetEntries().size(), 0, ());
+  TestGeocoder(geocoder, "Москва", {});
+}
+
+UNIT_TEST(Geocoder_ApplyDelta)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+16 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "6", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+  string const kDelta = R"#(version 2
+11 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Тверская", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "8", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+16 null
+17 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "1", "street": "Тверская", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  ScopedFile const deltaJsonFile("regions_delta.jsonl", kDelta);
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  {
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+    geocoder.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+  }
+
+  // The mapped geocoder is patched too.
+  Geocoder geocoder;
+  geocoder.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+  geocoder.EnableResultCache(4 /* logCacheSize */);
+  TestGeocoder(geocoder, "Москва, Арбат 6", {{Id{0x16}, 1.0}});
+
+  geocoder.ApplyDeltaFromJsonl(deltaJsonFile.GetFullPath(), true /* dataVersionHeadline */);
+  auto const & hierarchy = geocoder.GetHierarchy();
+  TEST_EQUAL(hierarchy.GetDataVersion(), "2", ());
+  TEST_EQUAL(hierarchy.GetEntries().size(), 6, ());
+  TEST(!hierarchy.GetEntryForOsmId(Id{0x16}), ());
+  TEST(hierarchy.GetEntryForOsmId(Id{0x17}), ());
+
+  TestGeocoder(geocoder, "Москва, Арбат 8", {{Id{0x15}, 1.0}});
+  TestGeocoder(geocoder, "Москва, Тверская 1", {{Id{0x17}, 1.0}});
+
+  // The patched geocoder is the same as the loaded one.
+  string const kPatchedData = R"#(version 2
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}}
+11 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Тверская", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "8", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+17 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "1", "street": "Тверская", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+)#";
+  ScopedFile const patchedJsonFile("regions_patched.jsonl", kPatchedData);
+  Geocoder patchedGeocoder;
+  patchedGeocoder.LoadFromJsonl(patchedJsonFile.GetFullPath(), true /* dataVersionHeadline */);
+  for (auto const & query : {"Москва", "Арбат 6", "Арбат 8", "Тверская 1", "Россия Тверская"})
+  {
+    vector<Result> expected;
+    patchedGeocoder.ProcessQuery(query, expected);
+    TestGeocoder(geocoder, query, move(expected));
+  }
+}
+
+UNIT_TEST(Geocoder_PrefixQuery)
+{
+  string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}}
+12 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Москва", "country": "Россия"}}}, "rank": 4}}
+13 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+14 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбатская", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+15 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбат", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+16 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "4", "street": "Арбатская", "locality": "Москва", "country": "Россия"}}}, "rank": 8}}
+17 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Арбатская площадь", "locality": "Москва", "country": "Россия"}}}, "rank": 7}}
+)#";
+
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  ScopedFile const mappedIndexFile("regions.mapidx", ScopedFile::Mode::DoNotCreate);
+  Geocoder geocoderFromJsonl;
+  geocoderFromJsonl.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  geocoderFromJsonl.SaveToMappedIndex(mappedIndexFile.GetFullPath());
+  Geocoder geocoderFromMappedIndex;
+  geocoderFromMappedIndex.LoadFromMappedIndex(mappedIndexFile.GetFullPath());
+
+  for (auto * geocoder : {&geocoderFromJsonl, &geocoderFromMappedIndex})
+  {
+    auto const & index = geocoder->GetIndex();
+    // The tokens occurring in more names go first.
+    vector<Index::TokenId> completions;
+    index.ForEachTokenIdWithPrefix("арб", [&](Index::TokenId tokenId) {
+      completions.push_back(tokenId);
+    });
+    TEST_EQUAL(completions,
+               vector<Index::TokenId>({index.GetTokenId("арбатская"), index.GetTokenId("арбат")}),
+               ());
+
+    completions.clear();
+    index.ForEachTokenIdWithPrefix("арбатс", [&](Index::TokenId tokenId) {
+      completions.push_back(tokenId);
+    });
+    TEST_EQUAL(completions, vector<Index::TokenId>({index.GetTokenId("арбатская")}), ());
+
+    completions.clear();
+    index.ForEachTokenIdWithPrefix("тверская", [&](Index::TokenId tokenId) {
+      completions.push_back(tokenId);
+    });
+    TEST(completions.empty(), ());
+
+    vector<Result> results;
+    geocoder->ProcessPrefixQuery("Москва, Арбатск", results);
+    auto const hasResult = [&results](Id const & osmId) {
+      return any_of(results.begin(), results.end(),
+                    [&osmId](Result const & result) { return result.m_osmId == osmId; });
+    };
+    TEST(hasResult(Id{0x14}), (results));
+    TEST(hasResult(Id{0x17}), (results));
+    TEST(!hasResult(Id{0x13}), (results));
+
+    geocoder->ProcessPrefixQuery("Москва, Арбат 4", results);
+    TEST(!results.empty(), ());
+    TEST_EQUAL(results[0].m_osmId, Id{0x15}, ());
+
+    // The complete tokens are matched as usual.
+    geocoder->ProcessQuery("Москва, Арбатск", results);
+    TEST(!hasResult(Id{0x14}), (results));
+    geocoder->ProcessPrefixQuery("Моск", results);
+    TEST(!results.empty(), ());
+    TEST_EQUAL(results[0].m_osmId, Id{0x12}, ());
+  }
+}
+
+UNIT_TEST(Geocoder_FullBeamPruning)
+{
+  // More cities of the same name than the results beam holds.
+  size_t const kCitiesCount = 120;
+  ostringstream data;
+  data << R"#(10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}})#" << '\n';
+  for (size_t i = 0; i < kCitiesCount; ++i)
+  {
+    data << hex << 0x100 + i << dec
+         << R"#( {"properties": {"kind": "village", "locales": {"default": {"address": {"locality": "Завидово", "country": "Россия"}}}, "rank": 4}})#" << '\n';
+  }
+  data << R"#(20 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Озерная", "locality": "Завидово", "country": "Россия"}}}, "rank": 7}})#" << '\n';
+  data << R"#(21 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "5", "street": "Озерная", "locality": "Завидово", "country": "Россия"}}}, "rank": 8}})#" << '\n';
+
+  ScopedFile const regionsJsonFile("regions.jsonl", data.str());
+  Geocoder geocoder;
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  vector<Result> results;
+  geocoder.ProcessQuery("Россия Завидово", results);
+  TEST_EQUAL(results.size(), 100, ());
+  for (auto const & result : results)
+    TEST_NEAR(result.m_certainty, 1.0, kCertaintyEps, (result));
+
+  // The branches of the potential house numbers are not pruned.
+  geocoder.ProcessQuery("Россия Завидово Озерная 5", results);
+  TEST(!results.empty(), ());
+  TEST_EQUAL(results[0].m_osmId, Id{0x21}, (results));
+  TEST_NEAR(results[0].m_certainty, 1.0, kCertaintyEps, ());
+}
+
+UNIT_TEST(Geocoder_QueryPlanning)
+{
+  // One rare street among the localities of a common name.
+  size_t const kCitiesCount = 120;
+  ostringstream data;
+  data << R"#(10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Россия"}}}, "rank": 1}})#" << '\n';
+  for (size_t i = 0; i < kCitiesCount; ++i)
+  {
+    data << hex << 0x100 + i << dec
+         << R"#( {"properties": {"kind": "village", "locales": {"default": {"address": {"locality": "Завидово", "country": "Россия"}}}, "rank": 4}})#" << '\n';
+    data << hex << 0x200 + i << dec
+         << R"#( {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Центральная", "locality": "Завидово", "country": "Россия"}}}, "rank": 7}})#" << '\n';
+  }
+  data << R"#(20 {"properties": {"kind": "street", "locales": {"default": {"address": {"street": "Озерная", "locality": "Завидово", "country": "Россия"}}}, "rank": 7}})#" << '\n';
+  data << R"#(21 {"properties": {"kind": "building", "locales": {"default": {"address": {"building": "5", "street": "Озерная", "locality": "Завидово", "country": "Россия"}}}, "rank": 8}})#" << '\n';
+
+  ScopedFile const regionsJsonFile("regions.jsonl", data.str());
+  Geocoder geocoder;
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  // The planning does not change the results.
+  for (auto const & query :
+       {"Россия Завидово Озерная", "Россия Завидово Озерная 5", "Завидово Центральная Озерная",
+        "Россия Завидово", "Озерная"})
+  {
+    vector<Result> expected;
+    geocoder.SetQueryPlanning(false);
+    geocoder.ProcessQuery(query, expected);
+
+    vector<Result> results;
+    geocoder.SetQueryPlanning(true);
+    geocoder.ProcessQuery(query, results);
+    TEST_EQUAL(results.size(), expected.size(), (query));
+    for (size_t i = 0; i < min(results.size(), expected.size()); ++i)
+    {
+      TEST_EQUAL(results[i].m_osmId, expected[i].m_osmId, (query));
+      TEST_ALMOST_EQUAL_ULPS(results[i].m_certainty, expected[i].m_certainty, (query));
+    }
+  }
+
+  vector<Result> results;
+  geocoder.ProcessQuery("Россия Завидово Озерная", results);
+  TEST(!results.empty(), ());
+  TEST_EQUAL(results[0].m_osmId, Id{0x20}, (results));
+
+#if defined(GEOCODER_QUERY_STATS)
+  QueryStats stats;
+  geocoder.ProcessQuery("Россия Завидово Озерная", results, stats);
+  TEST_EQUAL(stats.m_anchoredQueries, 1, ());
+
+  // The only match of the query is not an anchor.
+  geocoder.ProcessQuery("Завидово", results, stats);
+  TEST_EQUAL(stats.m_anchoredQueries, 1, ());
+
+  geocoder.SetQueryPlanning(false);
+  geocoder.ProcessQuery("Россия Завидово Озерная", results, stats);
+  TEST_EQUAL(stats.m_anchoredQueries, 1, ());
+#endif
+}
+
+UNIT_TEST(Geocoder_ProcessQueries)
+{
+  Geocoder geocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  vector<string> queries;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    for (auto const & query : {"florencia", "cuba florencia", "cuba", "nowhere", ""})
+      queries.emplace_back(query);
+  }
+
+  vector<vector<Result>> results;
+  geocoder.ProcessQueries(queries, results, 4 /* threadsCount */);
+  TEST_EQUAL(results.size(), queries.size(), ());
+
+  vector<Result> expected;
+  for (size_t i = 0; i < queries.size(); ++i)
+  {
+    geocoder.ProcessQuery(queries[i], expected);
+    TEST_EQUAL(results[i].size(), expected.size(), (queries[i]));
+    for (size_t j = 0; j < min(results[i].size(), expected.size()); ++j)
+    {
+      TEST_EQUAL(results[i][j].m_osmId, expected[j].m_osmId, (queries[i]));
+      TEST_ALMOST_EQUAL_ULPS(results[i][j].m_certainty, expected[j].m_certainty, (queries[i]));
+    }
+  }
+}
+
+#if defined(GEOCODER_QUERY_STATS)
+UNIT_TEST(Geocoder_QueryStats)
+{
+  Geocoder geocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  vector<Result> results;
+  QueryStats stats;
+  geocoder.ProcessQuery("cuba florencia", results, stats);
+  TEST_EQUAL(stats.m_queries, 1, ());
+  TEST_GREATER(stats.m_subqueries[static_cast<size_t>(Type::Country)], 0, ());
+  TEST_EQUAL(stats.m_layers[static_cast<size_t>(Type::Country)], 1, ());
+  TEST_GREATER(stats.m_beamInsertions, 0, ());
+
+  vector<string> const queries = {"cuba florencia", "cuba florencia", "nowhere"};
+  vector<vector<Result>> batchResults;
+  QueryStats batchStats;
+  geocoder.ProcessQueries(queries, batchResults, 2 /* threadsCount */, &batchStats);
+  TEST_EQUAL(batchStats.m_queries, 3, ());
+  TEST_EQUAL(batchStats.m_beamInsertions, 2 * stats.m_beamInsertions, ());
+}
+#endif
+
+UNIT_TEST(Geocoder_ResultCache)
+{
+  Geocoder geocoder;
+  ScopedFile const regionsJsonFile("regions.jsonl", kRegionsData);
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+  geocoder.EnableResultCache(4 /* logCacheSize */);
+
+  base::GeoObjectId const florenciaId(0xc00000000059d6b5);
+  base::GeoObjectId const cubaId(0xc00000000004b279);
+
+  TestGeocoder(geocoder, "cuba florencia", {{florenciaId, 1.0}, {cubaId, 0.713776}});
+  // The same normalized tokens.
+  TestGeocoder(geocoder, "Cuba, Florencia", {{florenciaId, 1.0}, {cubaId, 0.713776}});
+  TestGeocoder(geocoder, "florencia", {{florenciaId, 1.0}});
+
+  auto const * cache = geocoder.GetResultCache();
+  TEST(cache, ());
+  TEST_EQUAL(cache->GetAccessesCount(), 3, ());
+  TEST_EQUAL(cache->GetHitsCount(), 1, ());
+
+  vector<string> queries(100, "cuba florencia");
+  vector<vector<Result>> results;
+  geocoder.ProcessQueries(queries, results, 4 /* threadsCount */);
+  for (auto const & r : results)
+    TEST_EQUAL(r.size(), 2, ());
+  TEST_EQUAL(cache->GetHitsCount(), 101, ());
+
+  // Reload drops the cached results.
+  ScopedFile const emptyJsonFile("empty.jsonl", "");
+  geocoder.LoadFromJsonl(emptyJsonFile.GetFullPath());
+  TEST_EQUAL(cache->GetAccessesCount(), 0, ());
+  TestGeocoder(geocoder, "cuba florencia", {});
+}
+
 //--------------------------------------------------------------------------------------------------
 UNIT_TEST(Geocoder_EmptyFileConcurrentRead)
 {
@@ -3,6 +3,7 @@
 #include "geocoder/house_numbers_matcher.hpp"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/string_utils.hpp"
@@ -146,6 +147,34 @@ UNIT_TEST(HouseNumbersMatcher_Smoke)
   TEST(HouseNumbersMatch("14 д 1", "дом 14 д1"), ());
 }
 
+UNIT_TEST(HouseNumbersMatcher_PrecomputedParses)
+{
+  vector<pair<string, string>> const tests = {
+      {"39с79", "39"},           {"39с79", "39 к. 79"},   {"127а корпус 2", "127а кор. 2"},
+      {"22к", "22я"},            {"6 корпус 2", "7"},     {"10/42 корпус 2", "42"},
+      {"16 к1", "дом 16 к1"},    {"", "16"},              {"16", ""}};
+
+  for (auto const & test : tests)
+  {
+    auto const houseNumber = MakeUniString(test.first);
+    vector<vector<Token>> houseNumberParses;
+    ParseHouseNumber(houseNumber, houseNumberParses);
+
+    vector<Token> queryParse;
+    ParseQuery(MakeUniString(test.second), false /* queryIsPrefix */, queryParse);
+
+    MatchResult expected{};
+    MatchResult actual{};
+    TEST_EQUAL(search::house_numbers::HouseNumbersMatch(houseNumber, queryParse, expected),
+               search::house_numbers::HouseNumbersMatch(houseNumberParses, queryParse, actual),
+               (test));
+    TEST_EQUAL(expected.matchedTokensCount, actual.matchedTokensCount, (test));
+    TEST_EQUAL(expected.houseNumberMismatchedTokensCount, actual.houseNumberMismatchedTokensCount,
+               (test));
+    TEST_EQUAL(expected.queryMismatchedTokensCount, actual.queryMismatchedTokensCount, (test));
+  }
+}
+
 UNIT_TEST(LooksLikeHouseNumber_Smoke)
 {
   TEST(LooksLikeHouseNumber("1", false /* isPrefix */), ());
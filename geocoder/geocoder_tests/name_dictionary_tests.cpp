@@ -0,0 +1,116 @@
+#include "testing/testing.hpp"
+
+#include "geocoder/name_dictionary.hpp"
+
+#include "coding/reader.hpp"
+#include "coding/writer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+geocoder::MultipleNames MakeNames(string const & mainName, vector<string> const & altNames = {})
+{
+  geocoder::MultipleNames names{mainName};
+  for (auto const & name : altNames)
+    names.AddAltName(name);
+  return names;
+}
+
+vector<string> ToStrings(geocoder::MultipleNamesView const & names)
+{
+  vector<string> strings;
+  for (auto const & name : names)
+    strings.emplace_back(name);
+  return strings;
+}
+}  // namespace
+
+namespace geocoder
+{
+UNIT_TEST(NameDictionary_Builder)
+{
+  NameDictionaryBuilder builder;
+  auto const moscow = builder.Add(MakeNames("moscow", {"москва"}));
+  auto const moscowOnly = builder.Add(MakeNames("moscow"));
+  auto const russia = builder.Add(MakeNames("russia", {"россия", "росія"}));
+  TEST_EQUAL(builder.Add(MakeNames("moscow", {"москва"})), moscow, ());
+  TEST_EQUAL(builder.Add(MakeNames("russia", {"росія", "россия"})), russia, ());
+  TEST_EQUAL(moscow, 1, ());
+  TEST_EQUAL(moscowOnly, 2, ());
+  TEST_EQUAL(russia, 3, ());
+
+  auto const dictionary = builder.Release();
+  TEST_EQUAL(dictionary.GetSize(), 3, ());
+  TEST_EQUAL(dictionary.Get(moscow).GetMainName(), "moscow", ());
+  TEST_EQUAL(ToStrings(dictionary.Get(moscow)), vector<string>({"moscow", "москва"}), ());
+  TEST_EQUAL(ToStrings(dictionary.Get(moscowOnly)), vector<string>({"moscow"}), ());
+  TEST_EQUAL(ToStrings(dictionary.Get(russia)), vector<string>({"russia", "россия", "росія"}),
+             ());
+
+  // The equal names of the different lists are interned.
+  TEST_EQUAL(dictionary.Get(moscow).GetMainName().data(),
+             dictionary.Get(moscowOnly).GetMainName().data(), ());
+}
+
+UNIT_TEST(NameDictionary_ConcurrentBuilder)
+{
+  size_t const kThreadsCount = 4;
+  size_t const kNamesCount = 1000;
+
+  NameDictionaryBuilder builder;
+  vector<vector<NameDictionary::Position>> positions(kThreadsCount);
+  vector<thread> threads;
+  for (size_t t = 0; t < kThreadsCount; ++t)
+  {
+    // All the threads add the same names in the different orders.
+    threads.emplace_back([&builder, &positions, t] {
+      for (size_t i = 0; i < kNamesCount; ++i)
+      {
+        auto const n = (i * (2 * t + 1)) % kNamesCount;
+        positions[t].push_back(builder.Add(MakeNames(to_string(n), {"alt " + to_string(n)})));
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  auto const dictionary = builder.Release();
+  TEST_EQUAL(dictionary.GetSize(), kNamesCount, ());
+  for (size_t t = 0; t < kThreadsCount; ++t)
+  {
+    for (size_t i = 0; i < kNamesCount; ++i)
+    {
+      auto const n = (i * (2 * t + 1)) % kNamesCount;
+      TEST_EQUAL(ToStrings(dictionary.Get(positions[t][i])),
+                 vector<string>({to_string(n), "alt " + to_string(n)}), ());
+    }
+  }
+}
+
+UNIT_TEST(NameDictionary_Serialization)
+{
+  NameDictionary dictionary;
+  dictionary.Add(MakeNames("cuba"));
+  dictionary.Add(MakeNames("havana", {"la habana"}));
+
+  vector<uint8_t> buffer;
+  {
+    MemWriter<vector<uint8_t>> writer(buffer);
+    dictionary.Write(writer);
+  }
+
+  NameDictionary deserialized;
+  MemReader reader(buffer.data(), buffer.size());
+  ReaderSource<MemReader> source(reader);
+  deserialized.Read(source);
+  TEST_EQUAL(deserialized.GetSize(), 2, ());
+  TEST_EQUAL(ToStrings(deserialized.Get(1)), vector<string>({"cuba"}), ());
+  TEST_EQUAL(ToStrings(deserialized.Get(2)), vector<string>({"havana", "la habana"}), ());
+}
+}  // namespace geocoder
@@ -0,0 +1,92 @@
+#include "testing/testing.hpp"
+
+#include "geocoder/posting_list.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace geocoder;
+using namespace std;
+
+namespace
+{
+vector<uint32_t> MakeIds(uint32_t first, uint32_t step, size_t count)
+{
+  vector<uint32_t> ids;
+  for (size_t i = 0; i < count; ++i)
+    ids.push_back(first + static_cast<uint32_t>(i) * step);
+  return ids;
+}
+
+vector<uint32_t> ReadAll(PostingListReader reader)
+{
+  vector<uint32_t> ids;
+  for (; !reader.IsEnd(); reader.Next())
+    ids.push_back(reader.Get());
+  return ids;
+}
+}  // namespace
+
+UNIT_TEST(PostingList_PackAndRead)
+{
+  for (size_t const count : {size_t{1}, kPostingsBlockSize, kPostingsBlockSize + 1, size_t{1000}})
+  {
+    auto const ids = MakeIds(7 /* first */, 3 /* step */, count);
+    vector<uint8_t> buffer;
+    PackPostingList(ids, buffer);
+    // The gaps take a byte each.
+    TEST_LESS(buffer.size(), ids.size() * sizeof(uint32_t), ());
+
+    PostingListReader const reader(buffer.data());
+    TEST_EQUAL(reader.Size(), count, ());
+    TEST_EQUAL(ReadAll(reader), ids, ());
+  }
+
+  TEST(PostingListReader().IsEnd(), ());
+}
+
+UNIT_TEST(PostingList_SkipTo)
+{
+  auto const ids = MakeIds(10 /* first */, 2 /* step */, 1000);
+  vector<uint8_t> buffer;
+  PackPostingList(ids, buffer);
+
+  PostingListReader reader(buffer.data());
+  reader.SkipTo(5);
+  TEST_EQUAL(reader.Get(), 10, ());
+  reader.SkipTo(11);
+  TEST_EQUAL(reader.Get(), 12, ());
+  // Into the next blocks by the skip records.
+  reader.SkipTo(1001);
+  TEST_EQUAL(reader.Get(), 1002, ());
+  reader.SkipTo(1002);
+  TEST_EQUAL(reader.Get(), 1002, ());
+  reader.SkipTo(10 + 2 * kPostingsBlockSize * 5);
+  TEST_EQUAL(reader.Get(), 10 + 2 * kPostingsBlockSize * 5, ());
+  reader.Next();
+  TEST_EQUAL(reader.Get(), 12 + 2 * kPostingsBlockSize * 5, ());
+  reader.SkipTo(ids.back());
+  TEST_EQUAL(reader.Get(), ids.back(), ());
+  reader.SkipTo(ids.back() + 1);
+  TEST(reader.IsEnd(), ());
+}
+
+UNIT_TEST(PostingList_ForEachCommonId)
+{
+  auto const evenIds = MakeIds(0 /* first */, 2 /* step */, 1000);
+  auto const tripleIds = MakeIds(0 /* first */, 3 /* step */, 700);
+  vector<uint8_t> evenBuffer;
+  vector<uint8_t> tripleBuffer;
+  PackPostingList(evenIds, evenBuffer);
+  PackPostingList(tripleIds, tripleBuffer);
+
+  vector<uint32_t> common;
+  ForEachCommonId(PostingListReader(evenBuffer.data()), PostingListReader(tripleBuffer.data()),
+                  [&](uint32_t id) { common.push_back(id); });
+  TEST_EQUAL(common, MakeIds(0 /* first */, 6 /* step */, 334), ());
+
+  common.clear();
+  ForEachCommonId(PostingListReader(evenBuffer.data()), PostingListReader(),
+                  [&](uint32_t id) { common.push_back(id); });
+  TEST(common.empty(), ());
+}
@@ -0,0 +1,98 @@
+#include "testing/testing.hpp"
+
+#include "geocoder/query_server.hpp"
+
+#include "platform/platform.hpp"
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "base/file_name_utils.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace platform::tests_support;
+using namespace std;
+
+namespace
+{
+string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Cuba"}}}, "rank": 2}}
+20 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Russia"}}}, "rank": 1}}
+)#";
+
+string const kCubaAnswer =
+    R"({"query":"cuba","results":[{"id":"0000000000000010","certainty":1.0}]})";
+string const kRussiaAnswer =
+    R"({"query":"Russia","results":[{"id":"0000000000000020","certainty":1.0}]})";
+string const kEmptyAnswer = R"({"query":"havana","results":[]})";
+}  // namespace
+
+namespace geocoder
+{
+UNIT_TEST(QueryServer_Serve)
+{
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  Geocoder geocoder;
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  QueryServer server(geocoder, 3 /* workersCount */);
+  ostringstream expected;
+  ostringstream queries;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    queries << "cuba\nRussia\nhavana\n";
+    expected << kCubaAnswer << '\n' << kRussiaAnswer << '\n' << kEmptyAnswer << '\n';
+  }
+
+  istringstream in(queries.str());
+  ostringstream out;
+  server.Serve(in, out);
+  TEST_EQUAL(out.str(), expected.str(), ());
+}
+
+UNIT_TEST(QueryServer_UnixSocket)
+{
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  // The server removes the socket file when it stops.
+  auto const socketPath = base::JoinPath(GetPlatform().TmpDir(), "geocoder.sock");
+  Geocoder geocoder;
+  geocoder.LoadFromJsonl(regionsJsonFile.GetFullPath());
+
+  QueryServer server(geocoder, 2 /* workersCount */);
+  thread serving([&] { server.ServeUnixSocket(socketPath); });
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+  auto const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  TEST_GREATER_OR_EQUAL(fd, 0, ());
+  // The server may be not listening yet.
+  while (connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0)
+    this_thread::yield();
+
+  string const queries = "cuba\nRussia\n";
+  TEST_EQUAL(send(fd, queries.data(), queries.size(), 0), queries.size(), ());
+
+  string const expected = kCubaAnswer + '\n' + kRussiaAnswer + '\n';
+  string answers;
+  while (answers.size() < expected.size())
+  {
+    char chunk[256];
+    auto const n = recv(fd, chunk, sizeof(chunk), 0);
+    TEST_GREATER(n, 0, ());
+    answers.append(chunk, static_cast<size_t>(n));
+  }
+  TEST_EQUAL(answers, expected, ());
+
+  server.Stop();
+  serving.join();
+  close(fd);
+}
+}  // namespace geocoder
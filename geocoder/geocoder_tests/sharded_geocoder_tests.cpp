@@ -0,0 +1,90 @@
+#include "testing/testing.hpp"
+
+#include "geocoder/sharded_geocoder.hpp"
+
+#include "platform/platform_tests_support/scoped_dir.hpp"
+#include "platform/platform_tests_support/scoped_file.hpp"
+
+#include "base/geo_object_id.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace platform::tests_support;
+using namespace std;
+
+namespace
+{
+using Id = base::GeoObjectId;
+
+string const kData = R"#(
+10 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "Russia"}}}, "rank": 1}}
+11 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Moscow", "country": "Russia"}}}, "rank": 4}}
+20 {"properties": {"kind": "country", "locales": {"default": {"address": {"country": "United States"}}}, "rank": 1}}
+21 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Moscow", "country": "United States"}}}, "rank": 4}}
+30 {"properties": {"kind": "city", "locales": {"default": {"address": {"locality": "Atlantis"}}}, "rank": 4}}
+)#";
+
+bool HasResult(vector<geocoder::Result> const & results, Id const & osmId)
+{
+  return any_of(results.begin(), results.end(),
+                [&osmId](geocoder::Result const & result) { return result.m_osmId == osmId; });
+}
+}  // namespace
+
+namespace geocoder
+{
+UNIT_TEST(ShardedGeocoder_Smoke)
+{
+  ScopedFile const regionsJsonFile("regions.jsonl", kData);
+  ScopedDir const shardsDir("geocoder_shards", true /* recursiveForceRemove */);
+
+  auto const shardPaths =
+      ShardedGeocoder::BuildShards(regionsJsonFile.GetFullPath(), shardsDir.GetFullPath());
+  TEST_EQUAL(shardPaths.size(), 3, (shardPaths));
+
+  ShardedGeocoder geocoder;
+  for (auto const & path : shardPaths)
+    geocoder.AddShard(path);
+  TEST_EQUAL(geocoder.GetShardsCount(), 3, ());
+
+  auto const shardOf = [&geocoder](Id const & osmId) {
+    for (size_t i = 0; i < geocoder.GetShardsCount(); ++i)
+    {
+      if (geocoder.GetShard(i).GetHierarchy().GetEntryForOsmId(osmId))
+        return i;
+    }
+    return geocoder.GetShardsCount();
+  };
+  auto const russia = shardOf(Id{0x10});
+  auto const unitedStates = shardOf(Id{0x20});
+  TEST_EQUAL(shardOf(Id{0x11}), russia, ());
+  TEST_EQUAL(shardOf(Id{0x21}), unitedStates, ());
+  TEST_NOT_EQUAL(russia, unitedStates, ());
+
+  TEST_EQUAL(geocoder.Route("Moscow"), vector<size_t>({0, 1, 2}), ());
+  TEST_EQUAL(geocoder.Route("Moscow, Russia"), vector<size_t>({russia}), ());
+  TEST_EQUAL(geocoder.Route("Moscow, united states"), vector<size_t>({unitedStates}), ());
+  TEST_EQUAL(geocoder.Route("Moscow", "United States"), vector<size_t>({unitedStates}), ());
+  // An unknown hint is ignored.
+  TEST_EQUAL(geocoder.Route("Moscow, Russia", "Atlantis"), vector<size_t>({russia}), ());
+
+  vector<Result> results;
+  geocoder.ProcessQuery("Moscow", results);
+  TEST(HasResult(results, Id{0x11}), (results));
+  TEST(HasResult(results, Id{0x21}), (results));
+
+  geocoder.ProcessQuery("Moscow, Russia", results);
+  TEST(!results.empty(), ());
+  TEST_EQUAL(results[0].m_osmId, Id{0x11}, (results));
+  TEST(!HasResult(results, Id{0x21}), (results));
+
+  geocoder.ProcessQuery("Moscow", results, "United States");
+  TEST(HasResult(results, Id{0x21}), (results));
+  TEST(!HasResult(results, Id{0x11}), (results));
+
+  geocoder.ProcessQuery("Atlantis", results);
+  TEST(HasResult(results, Id{0x30}), (results));
+}
+}  // namespace geocoder
@@ -2,6 +2,11 @@
 
 #include "indexer/search_string_utils.hpp"
 
+#include "coding/file_container.hpp"
+#include "coding/read_write_utils.hpp"
+#include "coding/reader.hpp"
+#include "coding/write_to_sink.hpp"
+
 #include "base/exception.hpp"
 #include "base/logging.hpp"
 #include "base/macros.hpp"
@@ -9,23 +14,56 @@
 #include "base/string_utils.hpp"
 
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <type_traits>
 #include <utility>
 
 using namespace std;
 
 namespace geocoder
 {
+namespace
+{
+char const kEntriesTag[] = "geocoder_entries";
+char const kNamesTag[] = "geocoder_names";
+char const kDataVersionTag[] = "geocoder_data_version";
+
+static_assert(is_trivially_copyable<Hierarchy::Entry>::value,
+              "Hierarchy::Entry is stored as is in the mapped index");
+
+// The finalizer of MurmurHash3.
+uint64_t HashOsmId(base::GeoObjectId const & osmId)
+{
+  auto key = osmId.GetEncodedId();
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+}  // namespace
+
+// Hierarchy::NamesFilter --------------------------------------------------------------------------
+bool Hierarchy::NamesFilter::IsLocaleKept(boost::string_view locale) const
+{
+  return m_locales.empty() || find(m_locales.begin(), m_locales.end(), locale) != m_locales.end();
+}
+
 // Hierarchy::Entry --------------------------------------------------------------------------------
 bool Hierarchy::Entry::DeserializeFromJSON(string const & jsonStr,
                                            NameDictionaryBuilder & normalizedNameDictionaryBuilder,
-                                           ParsingStats & stats)
+                                           ParsingStats & stats, NamesFilter const & namesFilter)
 {
   try
   {
     coding::JsonDocument document;
     document.Parse(jsonStr);
 
-    return DeserializeFromJSONImpl(document, jsonStr, normalizedNameDictionaryBuilder, stats);
+    return DeserializeFromJSONImpl(document, jsonStr, normalizedNameDictionaryBuilder, stats,
+                                   namesFilter);
   }
   catch (coding::JsonException const & e)
   {
@@ -37,7 +75,8 @@ bool Hierarchy::Entry::DeserializeFromJSON(string const & jsonStr,
 // todo(@m) Factor out to geojson.hpp? Add geojson to myjansson?
 bool Hierarchy::Entry::DeserializeFromJSONImpl(
     coding::JsonDocument const & root, string const & jsonStr,
-    NameDictionaryBuilder & normalizedNameDictionaryBuilder, ParsingStats & stats)
+    NameDictionaryBuilder & normalizedNameDictionaryBuilder, ParsingStats & stats,
+    NamesFilter const & namesFilter)
 {
   if (!root.IsObject())
   {
@@ -45,15 +84,16 @@ bool Hierarchy::Entry::DeserializeFromJSONImpl(
     MYTHROW(coding::JsonException, ("Not a json object."));
   }
 
-  if (!DeserializeAddressFromJSON(root, normalizedNameDictionaryBuilder, stats))
+  if (!DeserializeAddressFromJSON(root, normalizedNameDictionaryBuilder, stats, namesFilter))
     return false;
 
   coding::JsonValue const & properties = coding::GetJsonObligatoryField(root, "properties");
   coding::JsonValue const & defaultLocale =
       coding::GetJsonObligatoryFieldByPath(properties, "locales", "default");
 
-  coding::FromJsonObjectOptionalField(defaultLocale, "name", m_name);
-  if (m_name.empty())
+  string name;
+  coding::FromJsonObjectOptionalField(defaultLocale, "name", name);
+  if (name.empty())
     ++stats.m_emptyNames;
 
   if (auto const * kind = coding::GetJsonOptionalField(properties, "kind"))
@@ -69,7 +109,7 @@ bool Hierarchy::Entry::DeserializeFromJSONImpl(
 
 bool Hierarchy::Entry::DeserializeAddressFromJSON(
     coding::JsonDocument const & root, NameDictionaryBuilder & normalizedNameDictionaryBuilder,
-    ParsingStats & stats)
+    ParsingStats & stats, NamesFilter const & namesFilter)
 {
   coding::JsonValue const & properties = coding::GetJsonObligatoryField(root, "properties");
   coding::JsonValue const & locales = coding::GetJsonObligatoryField(properties, "locales");
@@ -79,26 +119,36 @@ bool Hierarchy::Entry::DeserializeAddressFromJSON(
   {
     Type const type = static_cast<Type>(i);
     MultipleNames multipleNames;
-    if (!FetchAddressFieldNames(locales, type, multipleNames))
+    if (!FetchAddressFieldNames(locales, type, namesFilter, multipleNames, stats))
     {
       return false;
     }
 
     if (!multipleNames.GetMainName().empty())
-    {
       m_normalizedAddress[i] = normalizedNameDictionaryBuilder.Add(move(multipleNames));
+  }
+
+  uint8_t rank = 0;
+  if (coding::JsonValue const * rankJson = coding::GetJsonOptionalField(properties, "rank"))
+    rank = static_cast<uint8_t>(rankJson->GetInt());
+
+  return SetTypeByAddress(rank, stats);
+}
+
+bool Hierarchy::Entry::SetTypeByAddress(uint8_t rank, ParsingStats & stats)
+{
+  m_type = Type::Count;
+  for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
+  {
+    if (m_normalizedAddress[i] != NameDictionary::kUnspecifiedPosition)
       m_type = static_cast<Type>(i);
-    }
   }
 
-  if (coding::JsonValue const * rank = coding::GetJsonOptionalField(properties, "rank"))
+  auto const rankType = RankToType(rank);
+  if (rankType != Type::Count &&
+      m_normalizedAddress[static_cast<size_t>(rankType)] != NameDictionary::kUnspecifiedPosition)
   {
-    auto const type = RankToType(rank->GetInt());
-    if (type != Type::Count &&
-        m_normalizedAddress[static_cast<size_t>(type)] != NameDictionary::kUnspecifiedPosition)
-    {
-      m_type = type;
-    }
+    m_type = rankType;
   }
 
   auto const & subregion = m_normalizedAddress[static_cast<size_t>(Type::Subregion)];
@@ -121,10 +171,12 @@ bool Hierarchy::Entry::DeserializeAddressFromJSON(
 
 // static
 bool Hierarchy::Entry::FetchAddressFieldNames(coding::JsonValue const & locales, Type type,
-                                              MultipleNames & multipleNames)
+                                              NamesFilter const & namesFilter,
+                                              MultipleNames & multipleNames, ParsingStats & stats)
 {
   string const & levelKey = ToString(type);
-  Tokens tokens;
+  search::NormalizedTokens normalizedTokens;
+  string normalizedValue;
 
   for (coding::JsonValue::ConstMemberIterator itr = locales.MemberBegin();
        itr != locales.MemberEnd(); ++itr)
@@ -143,22 +195,53 @@ bool Hierarchy::Entry::FetchAddressFieldNames(coding::JsonValue const & locales,
     if (levelValue.empty())
       continue;
 
-    search::NormalizeAndTokenizeAsUtf8(levelValue, tokens);
-    if (tokens.empty())
-      continue;
-
-    auto normalizedValue = strings::JoinStrings(tokens, " ");
-    static std::string defaultLocale = "default";
-    if (itr->name == defaultLocale)
-      multipleNames.SetMainName(normalizedValue);
-    else
-      multipleNames.AddAltName(normalizedValue);
+    NormalizeName(levelValue, normalizedTokens, normalizedValue);
+    AddFieldName({itr->name.GetString(), itr->name.GetStringLength()}, normalizedValue,
+                 namesFilter, multipleNames, stats);
   }
 
   return true;
 }
 
-MultipleNames const & Hierarchy::Entry::GetNormalizedMultipleNames(
+// static
+void Hierarchy::Entry::NormalizeName(string const & name, search::NormalizedTokens & tokens,
+                                     string & normalizedName)
+{
+  normalizedName.clear();
+  for (auto const & token : tokens.Tokenize(name))
+  {
+    if (!normalizedName.empty())
+      normalizedName += ' ';
+    normalizedName.append(token.data(), token.size());
+  }
+}
+
+// static
+void Hierarchy::Entry::AddFieldName(boost::string_view locale, string const & name,
+                                    NamesFilter const & namesFilter,
+                                    MultipleNames & multipleNames, ParsingStats & stats)
+{
+  if (name.empty())
+    return;
+
+  if (locale == "default")
+  {
+    multipleNames.SetMainName(name);
+    return;
+  }
+
+  // The main name goes first in the names.
+  auto const altNamesCount = multipleNames.GetNames().size() - 1;
+  if (!namesFilter.IsLocaleKept(locale) ||
+      (namesFilter.m_maxAltNames != 0 && altNamesCount >= namesFilter.m_maxAltNames))
+  {
+    ++stats.m_filteredAltNames;
+    return;
+  }
+  multipleNames.AddAltName(name);
+}
+
+MultipleNamesView Hierarchy::Entry::GetNormalizedMultipleNames(
     Type type, NameDictionary const & normalizedNameDictionary) const
 {
   auto const & addressField = m_normalizedAddress[static_cast<size_t>(type)];
@@ -196,9 +279,125 @@ Hierarchy::Hierarchy(vector<Entry> && entries, NameDictionary && normalizedNameD
     LOG(LINFO, ("Sorting entries..."));
     sort(m_entries.begin(), m_entries.end());
   }
+
+  BuildLookupTables();
+}
+
+// static
+size_t constexpr Hierarchy::kTypesCount;
+
+void Hierarchy::ApplyDelta(Delta && delta)
+{
+  auto const & removedOsmIds = delta.m_removedOsmIds;
+  auto & deltaEntries = delta.m_entries;
+  CHECK(is_sorted(removedOsmIds.begin(), removedOsmIds.end()), ());
+  CHECK(is_sorted(deltaEntries.begin(), deltaEntries.end()), ());
+
+  // The positions of the delta names follow the positions of the current ones.
+  auto const & deltaDictionary = delta.m_normalizedNameDictionary;
+  auto const positionsShift =
+      static_cast<NameDictionary::Position>(m_normalizedNameDictionary.GetSize());
+  for (size_t i = 1; i <= deltaDictionary.GetSize(); ++i)
+    m_normalizedNameDictionary.Add(deltaDictionary.Get(static_cast<NameDictionary::Position>(i)));
+  for (auto & entry : deltaEntries)
+  {
+    for (auto & position : entry.m_normalizedAddress)
+    {
+      if (position != NameDictionary::kUnspecifiedPosition)
+        position += positionsShift;
+    }
+  }
+
+  auto const entries = GetEntries();
+  vector<Entry> patchedEntries;
+  patchedEntries.reserve(entries.size() + deltaEntries.size());
+  size_t removedCount = 0;
+  size_t modifiedCount = 0;
+  auto removedIt = removedOsmIds.begin();
+  auto deltaIt = deltaEntries.begin();
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    auto const & entry = entries[i];
+    for (; deltaIt != deltaEntries.end() && deltaIt->m_osmId < entry.m_osmId; ++deltaIt)
+      patchedEntries.push_back(*deltaIt);
+    while (removedIt != removedOsmIds.end() && *removedIt < entry.m_osmId)
+      ++removedIt;
+
+    if (deltaIt != deltaEntries.end() && deltaIt->m_osmId == entry.m_osmId)
+    {
+      ++modifiedCount;
+      continue;
+    }
+    if (removedIt != removedOsmIds.end() && *removedIt == entry.m_osmId)
+    {
+      ++removedCount;
+      continue;
+    }
+    patchedEntries.push_back(entry);
+  }
+  patchedEntries.insert(patchedEntries.end(), deltaIt, deltaEntries.end());
+
+  LOG(LINFO, ("Hierarchy delta: entries removed:", removedCount, "modified:", modifiedCount,
+              "added:", deltaEntries.size() - modifiedCount));
+
+  m_mappedEntries.Unmap();
+  m_entries = move(patchedEntries);
+  if (!delta.m_dataVersion.empty())
+    m_dataVersion = move(delta.m_dataVersion);
+  BuildLookupTables();
+}
+
+void Hierarchy::Serialize(FilesContainerW & container) const
+{
+  auto const entries = GetEntries();
+  {
+    auto writer = container.GetWriter(kEntriesTag);
+    if (!entries.empty())
+      writer->Write(&entries[0], entries.size() * sizeof(Entry));
+  }
+
+  {
+    auto writer = container.GetWriter(kNamesTag);
+    m_normalizedNameDictionary.Write(*writer);
+  }
+
+  {
+    auto writer = container.GetWriter(kDataVersionTag);
+    rw::Write(*writer, m_dataVersion);
+  }
+}
+
+void Hierarchy::Map(FilesMappingContainer const & container)
+{
+  m_entries.clear();
+  m_mappedEntries = container.Map(kEntriesTag);
+
+  NameDictionary dictionary;
+  {
+    ReaderSource<FileReader> source(container.GetReader(kNamesTag));
+    dictionary.Read(source);
+  }
+  m_normalizedNameDictionary = move(dictionary);
+  BuildLookupTables();
+
+  {
+    ReaderSource<FileReader> source(container.GetReader(kDataVersionTag));
+    rw::Read(source, m_dataVersion);
+  }
+}
+
+void Hierarchy::Unmap()
+{
+  m_entries.clear();
+  m_mappedEntries.Unmap();
 }
 
-vector<Hierarchy::Entry> const & Hierarchy::GetEntries() const { return m_entries; }
+array_read<Hierarchy::Entry> Hierarchy::GetEntries() const
+{
+  if (m_mappedEntries.IsValid())
+    return {m_mappedEntries.GetData<Entry>(), m_mappedEntries.GetDataCount<Entry>()};
+  return make_read_adapter(m_entries);
+}
 
 NameDictionary const & Hierarchy::GetNormalizedNameDictionary() const
 {
@@ -207,21 +406,43 @@ NameDictionary const & Hierarchy::GetNormalizedNameDictionary() const
 
 Hierarchy::Entry const * Hierarchy::GetEntryForOsmId(base::GeoObjectId const & osmId) const
 {
-  auto const cmp = [](Hierarchy::Entry const & e, base::GeoObjectId const & id) {
-    return e.m_osmId < id;
-  };
-
-  auto const it = lower_bound(m_entries.begin(), m_entries.end(), osmId, cmp);
-
-  if (it == m_entries.end() || it->m_osmId != osmId)
+  if (m_osmIdSlots.empty())
     return nullptr;
 
-  return &(*it);
+  auto const entries = GetEntries();
+  auto const mask = m_osmIdSlots.size() - 1;
+  for (auto slot = static_cast<size_t>(HashOsmId(osmId)) & mask; m_osmIdSlots[slot] != 0;
+       slot = (slot + 1) & mask)
+  {
+    auto const & entry = entries[m_osmIdSlots[slot] - 1];
+    if (entry.m_osmId == osmId)
+      return &entry;
+  }
+
+  return nullptr;
 }
 
 bool Hierarchy::IsParentTo(Hierarchy::Entry const & entry, Hierarchy::Entry const & toEntry) const
 {
-  for (size_t i = 0; i < static_cast<size_t>(geocoder::Type::Count); ++i)
+  size_t index = 0;
+  size_t toIndex = 0;
+  if (!GetEntryIndex(entry, index) || !GetEntryIndex(toEntry, toIndex))
+    return IsParentToByPositions(entry, toEntry);
+
+  auto const * ids = &m_addressIds[index * kTypesCount];
+  auto const * toIds = &m_addressIds[toIndex * kTypesCount];
+  for (size_t i = 0; i < kTypesCount; ++i)
+  {
+    if (ids[i] != 0 && ids[i] != toIds[i])
+      return false;
+  }
+  return true;
+}
+
+bool Hierarchy::IsParentToByPositions(Hierarchy::Entry const & entry,
+                                      Hierarchy::Entry const & toEntry) const
+{
+  for (size_t i = 0; i < kTypesCount; ++i)
   {
     if (entry.m_normalizedAddress[i] == NameDictionary::kUnspecifiedPosition)
       continue;
@@ -234,11 +455,102 @@ bool Hierarchy::IsParentTo(Hierarchy::Entry const & entry, Hierarchy::Entry cons
     if (pos1 == pos2)
       continue;
 
-    auto const & name1 = m_normalizedNameDictionary.Get(pos1).GetMainName();
-    auto const & name2 = m_normalizedNameDictionary.Get(pos2).GetMainName();
-    if (name1 != name2)
+    ASSERT_LESS(pos1, m_mainNameIds.size(), ());
+    ASSERT_LESS(pos2, m_mainNameIds.size(), ());
+    if (m_mainNameIds[pos1] != m_mainNameIds[pos2])
       return false;
   }
   return true;
 }
+
+bool Hierarchy::GetEntryIndex(Entry const & entry, size_t & index) const
+{
+  auto const entries = GetEntries();
+  if (entries.empty())
+    return false;
+
+  auto const * begin = &entries[0];
+  auto const * end = begin + entries.size();
+  if (less<Entry const *>()(&entry, begin) || !less<Entry const *>()(&entry, end))
+    return false;
+
+  index = static_cast<size_t>(&entry - begin);
+  return true;
+}
+
+void Hierarchy::BuildLookupTables()
+{
+  BuildMainNameIds();
+  BuildAddressIds();
+  BuildOsmIdSlots();
+}
+
+void Hierarchy::BuildMainNameIds()
+{
+  auto const & dictionary = m_normalizedNameDictionary;
+  auto const mainName = [&dictionary](NameDictionary::Position position) {
+    return dictionary.Get(position).GetMainName();
+  };
+
+  vector<NameDictionary::Position> positions(dictionary.GetSize());
+  iota(positions.begin(), positions.end(), 1);
+  sort(positions.begin(), positions.end(),
+       [&](NameDictionary::Position lhs, NameDictionary::Position rhs) {
+         return mainName(lhs) < mainName(rhs);
+       });
+
+  m_mainNameIds.assign(dictionary.GetSize() + 1, 0);
+  uint32_t mainNameId = 0;
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    if (i > 0 && mainName(positions[i - 1]) != mainName(positions[i]))
+      ++mainNameId;
+    m_mainNameIds[positions[i]] = mainNameId;
+  }
+}
+
+void Hierarchy::BuildAddressIds()
+{
+  auto const entries = GetEntries();
+  m_addressIds.assign(entries.size() * kTypesCount, 0);
+  for (size_t index = 0; index < entries.size(); ++index)
+  {
+    auto const & address = entries[index].m_normalizedAddress;
+    for (size_t i = 0; i < kTypesCount; ++i)
+    {
+      auto const position = address[i];
+      if (position == NameDictionary::kUnspecifiedPosition)
+        continue;
+
+      CHECK_LESS(position, m_mainNameIds.size(), ());
+      m_addressIds[index * kTypesCount + i] = m_mainNameIds[position] + 1;
+    }
+  }
+}
+
+void Hierarchy::BuildOsmIdSlots()
+{
+  auto const entries = GetEntries();
+  CHECK_LESS(entries.size(), numeric_limits<uint32_t>::max(), ());
+
+  // The load factor is at most 1/2.
+  size_t capacity = 1;
+  while (capacity < 2 * entries.size())
+    capacity *= 2;
+  m_osmIdSlots.assign(entries.empty() ? 0 : capacity, 0);
+
+  auto const mask = capacity - 1;
+  for (size_t index = 0; index < entries.size(); ++index)
+  {
+    auto const & osmId = entries[index].m_osmId;
+    auto slot = static_cast<size_t>(HashOsmId(osmId)) & mask;
+    while (m_osmIdSlots[slot] != 0 && entries[m_osmIdSlots[slot] - 1].m_osmId != osmId)
+      slot = (slot + 1) & mask;
+
+    // The entries are sorted by osm ids, the first one of the duplicates is found as by the
+    // binary search.
+    if (m_osmIdSlots[slot] == 0)
+      m_osmIdSlots[slot] = static_cast<uint32_t>(index + 1);
+  }
+}
 }  // namespace geocoder
@@ -3,11 +3,13 @@
 #include "geocoder/name_dictionary.hpp"
 #include "geocoder/types.hpp"
 
+#include "coding/file_container.hpp"
+#include "coding/json.hpp"
+
+#include "base/array_adapters.hpp"
 #include "base/assert.hpp"
 #include "base/geo_object_id.hpp"
 
-#include "coding/json.hpp"
-
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -19,6 +21,12 @@
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/version.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace search
+{
+class NormalizedTokens;
+}  // namespace search
 
 namespace geocoder
 {
@@ -59,11 +67,31 @@ public:
     // specific parts of their addresses.
     // This is expected from POIs but not from regions or streets.
     uint64_t m_mismatchedNames = 0;
+
+    // Number of alternative names of the address fields dropped by the NamesFilter.
+    uint64_t m_filteredAltNames = 0;
+  };
+
+  // Restricts the alternative names of the address fields which are loaded, so the dictionary
+  // and the index of a geocoder serving a few languages keep only the names of them.
+  // The name of the default locale is the main name and is always kept.
+  struct NamesFilter
+  {
+    // Returns true if the names of |locale| may be kept.
+    bool IsLocaleKept(boost::string_view locale) const;
+
+    // The locales of the alternative names to keep, all of them are kept when it is empty.
+    std::vector<std::string> m_locales;
+    // The max number of the alternative names of an address field, zero is no limit.
+    // The names of the locales are taken in the order of the locales in the json.
+    size_t m_maxAltNames = 0;
   };
 
   // A single entry in the hierarchy directed acyclic graph.
   // Currently, this is more or less the "properties"-"address"
   // part of the geojson entry.
+  // The entry is trivially copyable: the mapped index format stores an array of
+  // entries as is (see Hierarchy::Map()).
   struct Entry
   {
     template<class Archive>
@@ -71,7 +99,6 @@ public:
     {
       CHECK_EQUAL(version, kIndexFormatVersion, ());
       ar & m_osmId;
-      ar & m_name;
       ar & m_type;
       ar & m_kind;
       ar & m_normalizedAddress;
@@ -79,28 +106,40 @@ public:
 
     bool DeserializeFromJSON(std::string const & jsonStr,
                              NameDictionaryBuilder & normalizedNameDictionaryBuilder,
-                             ParsingStats & stats);
+                             ParsingStats & stats, NamesFilter const & namesFilter);
     bool DeserializeFromJSONImpl(coding::JsonDocument const & root, std::string const & jsonStr,
                                  NameDictionaryBuilder & normalizedNameDictionaryBuilder,
-                                 ParsingStats & stats);
+                                 ParsingStats & stats, NamesFilter const & namesFilter);
     bool DeserializeAddressFromJSON(coding::JsonDocument const & root,
                                     NameDictionaryBuilder & normalizedNameDictionaryBuilder,
-                                    ParsingStats & stats);
+                                    ParsingStats & stats, NamesFilter const & namesFilter);
     static bool FetchAddressFieldNames(coding::JsonValue const & locales, Type type,
-                                       MultipleNames & multipleNames);
+                                       NamesFilter const & namesFilter,
+                                       MultipleNames & multipleNames, ParsingStats & stats);
+    // Writes the tokens of |name| joined by spaces to |normalizedName|, it is empty if |name|
+    // has no tokens. |tokens| is the tokenizer reused by the calls.
+    static void NormalizeName(std::string const & name, search::NormalizedTokens & tokens,
+                              std::string & normalizedName);
+    // Adds the normalized |name| of |locale| to |multipleNames|: the name of the default locale
+    // is the main name, the names of the other locales are the alternative names passing
+    // |namesFilter|.
+    static void AddFieldName(boost::string_view locale, std::string const & name,
+                             NamesFilter const & namesFilter, MultipleNames & multipleNames,
+                             ParsingStats & stats);
+    // Sets the type by the most specific field of the address or by |rank| if the field of its
+    // type is specified, zero rank is no rank. Returns false if the entry is a street or
+    // a building out of a locality.
+    bool SetTypeByAddress(uint8_t rank, ParsingStats & stats);
     bool HasFieldInAddress(Type type) const;
     // See generator::regions::LevelRegion::GetRank().
     static Type RankToType(uint8_t rank);
 
-    MultipleNames const & GetNormalizedMultipleNames(
+    MultipleNamesView GetNormalizedMultipleNames(
         Type type, NameDictionary const & normalizedNameDictionary) const;
     bool operator<(Entry const & rhs) const { return m_osmId < rhs.m_osmId; }
 
     base::GeoObjectId m_osmId = base::GeoObjectId(base::GeoObjectId::kInvalid);
 
-    // Original name of the entry. Useful for debugging.
-    std::string m_name;
-
     Type m_type = Type::Count;
     Kind m_kind{Kind::Unknown};
 
@@ -108,10 +147,30 @@ public:
     std::array<NameDictionary::Position, static_cast<size_t>(Type::Count)> m_normalizedAddress{};
   };
 
+  // Changes of the hierarchy, see HierarchyReader::ReadDelta().
+  struct Delta
+  {
+    // The added entries and the new versions of the modified ones, sorted by osm ids.
+    // Their addresses are the positions in |m_normalizedNameDictionary|.
+    std::vector<Entry> m_entries;
+    NameDictionary m_normalizedNameDictionary;
+    // Sorted.
+    std::vector<base::GeoObjectId> m_removedOsmIds;
+    // The data version of the patched hierarchy, the version is kept when it is empty.
+    std::string m_dataVersion;
+  };
+
   Hierarchy() = default;
   Hierarchy(std::vector<Entry> && entries, NameDictionary && normalizeNameDictionary,
             std::string && dataVersion);
 
+  // Removes the entries of |delta.m_removedOsmIds| and replaces or adds the entries of
+  // |delta.m_entries| by their osm ids. The entries are merged in one pass and the names of
+  // the delta are appended to the dictionary, the names of the removed entries are left in it.
+  // A mapped hierarchy is copied to memory.
+  // The index of the hierarchy must be rebuilt after, its DocIds are shifted.
+  void ApplyDelta(Delta && delta);
+
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version)
   {
@@ -119,9 +178,52 @@ public:
     ar & m_entries;
     ar & m_normalizedNameDictionary;
     ar & m_dataVersion;
+
+    if (Archive::is_loading::value)
+      BuildLookupTables();
   }
 
-  std::vector<Entry> const & GetEntries() const;
+  // The entries and the name dictionary are kept in separate segments of the binary index which
+  // are saved and loaded concurrently, see Geocoder::SaveToBinaryIndex(). OnSegmentsLoaded() is
+  // to be called when both segments are loaded.
+  template <class Archive>
+  void SaveEntries(Archive & ar) const
+  {
+    ar << m_entries;
+    ar << m_dataVersion;
+  }
+
+  template <class Archive>
+  void LoadEntries(Archive & ar)
+  {
+    ar >> m_entries;
+    ar >> m_dataVersion;
+  }
+
+  template <class Archive>
+  void SaveNameDictionary(Archive & ar) const
+  {
+    ar << m_normalizedNameDictionary;
+  }
+
+  template <class Archive>
+  void LoadNameDictionary(Archive & ar)
+  {
+    ar >> m_normalizedNameDictionary;
+  }
+
+  void OnSegmentsLoaded() { BuildLookupTables(); }
+
+  // Writes the hierarchy to |container| in the mapped index format.
+  void Serialize(FilesContainerW & container) const;
+  // Loads the hierarchy from the mapped index |container|. Entries are not copied,
+  // they are used right from the mapped memory.
+  void Map(FilesMappingContainer const & container);
+  // Detaches the hierarchy from the mapped index, the hierarchy is to be loaded after.
+  void Unmap();
+  bool IsMapped() const { return m_mappedEntries.IsValid(); }
+
+  array_read<Entry> GetEntries() const;
   NameDictionary const & GetNormalizedNameDictionary() const;
 
   Entry const * GetEntryForOsmId(base::GeoObjectId const & osmId) const;
@@ -133,8 +235,30 @@ public:
   }
 
 private:
+  static size_t constexpr kTypesCount = static_cast<size_t>(Type::Count);
+
+  void BuildLookupTables();
+  void BuildMainNameIds();
+  void BuildAddressIds();
+  void BuildOsmIdSlots();
+  // Returns false if |entry| is not an entry of the hierarchy.
+  bool GetEntryIndex(Entry const & entry, size_t & index) const;
+  bool IsParentToByPositions(Entry const & entry, Entry const & toEntry) const;
+
   std::vector<Entry> m_entries;
+  // Entries of the mapped index, |m_entries| is empty when this handle is valid.
+  FilesMappingContainer::Handle m_mappedEntries;
   NameDictionary m_normalizedNameDictionary;
+  // m_mainNameIds[position] is the same for the dictionary positions with equal main names,
+  // so the address fields are compared without touching the names.
+  std::vector<uint32_t> m_mainNameIds;
+  // m_addressIds[index * kTypesCount + type] is the main name id of the address field |type| of
+  // the entry |index| plus one or zero if the field is unspecified, so IsParentTo() compares
+  // the adjacent ids of the two entries only.
+  std::vector<uint32_t> m_addressIds;
+  // The open addressing index of the entries by osm ids with the linear probing, a slot keeps
+  // the index of an entry plus one or zero if the slot is empty. The size is a power of two.
+  std::vector<uint32_t> m_osmIdSlots;
   std::string m_dataVersion;
 };
 }  // namespace geocoder
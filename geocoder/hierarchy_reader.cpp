@@ -1,5 +1,7 @@
 #include "geocoder/hierarchy_reader.hpp"
 
+#include "geocoder/binary_hierarchy.hpp"
+
 #include "base/logging.hpp"
 #include "base/thread_pool_computational.hpp"
 
@@ -22,12 +24,16 @@ namespace
 // Information will be logged for every |kLogBatch| entries.
 size_t const kLogBatch = 100000;
 
+// The value of a removed entry in a delta.
+char const kRemovedEntryJson[] = "null";
+
 void operator+=(Hierarchy::ParsingStats & accumulator, Hierarchy::ParsingStats & stats)
 {
   struct ValidationStats
   {
     uint64_t m_numLoaded, m_badJsons, m_badOsmIds, m_duplicateOsmIds, m_duplicateAddresses,
-             m_emptyAddresses, m_emptyNames, m_noLocalityStreets, m_noLocalityBuildings, m_mismatchedNames;
+             m_emptyAddresses, m_emptyNames, m_noLocalityStreets, m_noLocalityBuildings,
+             m_mismatchedNames, m_filteredAltNames;
   };
   static_assert(sizeof(Hierarchy::ParsingStats) == sizeof(ValidationStats),
                 "Hierarchy::ParsingStats has been modified");
@@ -42,20 +48,26 @@ void operator+=(Hierarchy::ParsingStats & accumulator, Hierarchy::ParsingStats &
   accumulator.m_noLocalityStreets += stats.m_noLocalityStreets;
   accumulator.m_noLocalityBuildings += stats.m_noLocalityBuildings;
   accumulator.m_mismatchedNames += stats.m_mismatchedNames;
+  accumulator.m_filteredAltNames += stats.m_filteredAltNames;
 }
 } // namespace
 
-HierarchyReader::HierarchyReader(string const & pathToJsonHierarchy, bool dataVersionHeadline)
+HierarchyReader::HierarchyReader(string const & pathToJsonHierarchy, bool dataVersionHeadline,
+                                 NamesFilter const & namesFilter)
   : m_fileStream{CreateDataStream(pathToJsonHierarchy)}, m_in{*m_fileStream}
+  , m_namesFilter{namesFilter}
 {
-  if (dataVersionHeadline)
+  m_binary = BinaryHierarchyChunkHeader::IsChunkStart(m_in.peek());
+  if (dataVersionHeadline && !m_binary)
     m_dataVersion = ReadDataVersion(m_in);
 }
 
-HierarchyReader::HierarchyReader(istream & in, bool dataVersionHeadline)
-  : m_in{in}
+HierarchyReader::HierarchyReader(istream & in, bool dataVersionHeadline,
+                                 NamesFilter const & namesFilter)
+  : m_in{in}, m_namesFilter{namesFilter}
 {
-  if (dataVersionHeadline)
+  m_binary = BinaryHierarchyChunkHeader::IsChunkStart(m_in.peek());
+  if (dataVersionHeadline && !m_binary)
     m_dataVersion = ReadDataVersion(m_in);
 }
 
@@ -100,6 +112,31 @@ string HierarchyReader::ReadDataVersion(istream & stream)
 }
 
 Hierarchy HierarchyReader::Read(unsigned int readersCount)
+{
+  auto result = ReadEntries(readersCount);
+  if (!result.m_removedOsmIds.empty())
+  {
+    LOG(LWARNING, ("Removed entries are ignored out of a delta:", result.m_removedOsmIds.size()));
+  }
+
+  return Hierarchy{move(result.m_entries), move(result.m_nameDictionary), move(m_dataVersion)};
+}
+
+Hierarchy::Delta HierarchyReader::ReadDelta(unsigned int readersCount)
+{
+  auto result = ReadEntries(readersCount);
+  sort(result.m_removedOsmIds.begin(), result.m_removedOsmIds.end());
+  LOG(LINFO, ("Delta entries removed:", result.m_removedOsmIds.size()));
+
+  Hierarchy::Delta delta;
+  delta.m_entries = move(result.m_entries);
+  delta.m_normalizedNameDictionary = move(result.m_nameDictionary);
+  delta.m_removedOsmIds = move(result.m_removedOsmIds);
+  delta.m_dataVersion = move(m_dataVersion);
+  return delta;
+}
+
+HierarchyReader::ParsingResult HierarchyReader::ReadEntries(unsigned int readersCount)
 {
   CHECK_GREATER_OR_EQUAL(readersCount, 1, ());
 
@@ -109,34 +146,43 @@ Hierarchy HierarchyReader::Read(unsigned int readersCount)
   vector<Entry> entries;
   NameDictionaryBuilder nameDictionaryBuilder;
   ParsingStats stats{};
+  vector<base::GeoObjectId> removedOsmIds;
+
+  // Reading of the stream, parsing of the chunks and merging of the parsed chunks are pipelined:
+  // the stream is read in this thread in chunks of whole lines, the chunks are parsed by
+  // |readersCount| threads which share one name dictionary builder, and the parsed chunks are
+  // merged here in the order of the stream. No more than |kMaxChunksInFlight| chunks
+  // are kept in memory, so the memory used on load does not depend on the file size
+  // (except for the parsed entries themselves).
+  size_t const kChunkSize = 1 << 20;
+  size_t const kMaxChunksInFlight = 2 * readersCount + 1;
 
   base::thread_pool::computational::ThreadPool threadPool{readersCount};
   list<future<ParsingResult>> tasks{};
   while (!m_eof || !tasks.empty())
   {
-    size_t const kReadBlockLineCount = 1000;
-    while (!m_eof && tasks.size() <= 2 * readersCount)
-      tasks.emplace_back(threadPool.Submit([&] { return ReadEntries(kReadBlockLineCount); }));
+    while (!m_eof && tasks.size() < kMaxChunksInFlight)
+    {
+      auto chunk = ReadChunk(kChunkSize);
+      if (chunk.empty())
+        continue;
+      tasks.emplace_back(threadPool.Submit(
+          [this, chunk = move(chunk), &nameDictionaryBuilder] {
+            return DeserializeEntries(chunk, nameDictionaryBuilder);
+          }));
+    }
+
+    if (tasks.empty())
+      break;
 
-    CHECK(!tasks.empty(), ());
     auto & task = tasks.front();
     auto taskResult = task.get();
     tasks.pop_front();
 
     auto & taskEntries = taskResult.m_entries;
-    auto const & taskNameDictionary = taskResult.m_nameDictionary;
-    for (auto & entry : taskEntries)
-    {
-      for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
-      {
-        if (auto & position = entry.m_normalizedAddress[i])
-        {
-          auto const & multipleNames = taskNameDictionary.Get(position);
-          position = nameDictionaryBuilder.Add(MultipleNames{multipleNames});
-        }
-      }
-    }
     move(begin(taskEntries), end(taskEntries), back_inserter(entries));
+    auto const & taskRemovedOsmIds = taskResult.m_removedOsmIds;
+    removedOsmIds.insert(removedOsmIds.end(), taskRemovedOsmIds.begin(), taskRemovedOsmIds.end());
 
     stats += taskResult.m_stats;
   }
@@ -162,9 +208,10 @@ Hierarchy HierarchyReader::Read(unsigned int readersCount)
   LOG(LINFO, ("Building entries without a locality name:", stats.m_noLocalityBuildings));
   LOG(LINFO,
       ("Entries whose names do not match their most specific addresses:", stats.m_mismatchedNames));
+  LOG(LINFO, ("Alternative names dropped by the names filter:", stats.m_filteredAltNames));
   LOG(LINFO, ("(End of stats.)"));
 
-  return Hierarchy{move(entries), nameDictionaryBuilder.Release(), move(m_dataVersion)};
+  return {move(entries), nameDictionaryBuilder.Release(), move(stats), move(removedOsmIds)};
 }
 
 void HierarchyReader::CheckDuplicateOsmIds(vector<geocoder::Hierarchy::Entry> const & entries,
@@ -188,38 +235,76 @@ void HierarchyReader::CheckDuplicateOsmIds(vector<geocoder::Hierarchy::Entry> co
   }
 }
 
-HierarchyReader::ParsingResult HierarchyReader::ReadEntries(size_t count)
+string HierarchyReader::ReadChunk(size_t chunkSize)
 {
-  vector<string> linesBuffer(count);
-  size_t bufferSize = 0;
+  if (m_binary)
+    return ReadBinaryChunk();
 
+  string chunk(chunkSize, '\0');
+  m_in.read(&chunk[0], chunkSize);
+  chunk.resize(static_cast<size_t>(m_in.gcount()));
+  if (!m_in)
   {
-    lock_guard<mutex> lock(m_mutex);
+    m_eof = true;
+    return chunk;
+  }
 
-    for (; bufferSize < count; ++bufferSize)
-    {
-      if (!getline(m_in, linesBuffer[bufferSize]))
-      {
-        m_eof = true;
-        break;
-      }
-    }
+  // Completes the last line of the chunk.
+  string tail;
+  if (getline(m_in, tail))
+    chunk += tail;
+  else
+    m_eof = true;
+  chunk += '\n';
+  return chunk;
+}
+
+string HierarchyReader::ReadBinaryChunk()
+{
+  char headerData[BinaryHierarchyChunkHeader::kSize];
+  m_in.read(headerData, sizeof(headerData));
+  if (m_in.gcount() == 0)
+  {
+    m_eof = true;
+    return {};
+  }
+
+  BinaryHierarchyChunkHeader header;
+  if (static_cast<size_t>(m_in.gcount()) != sizeof(headerData) || !header.Read(headerData))
+    MYTHROW(Exception, ("Corrupted chunk header of the binary hierarchy"));
+  if (header.m_version != BinaryHierarchyChunkHeader::kVersion)
+  {
+    MYTHROW(Exception, ("Unsupported version of the binary hierarchy:", header.m_version,
+                        "expected:", BinaryHierarchyChunkHeader::kVersion));
   }
 
-  return DeserializeEntries(linesBuffer, bufferSize);
+  string entries(static_cast<size_t>(header.m_entriesSize), '\0');
+  m_in.read(&entries[0], entries.size());
+  if (static_cast<size_t>(m_in.gcount()) != entries.size())
+    MYTHROW(Exception, ("Truncated chunk of the binary hierarchy"));
+  return entries;
 }
 
 HierarchyReader::ParsingResult HierarchyReader::DeserializeEntries(
-    vector<string> const & linesBuffer, size_t const bufferSize)
+    string const & chunk, NameDictionaryBuilder & nameDictionaryBuilder)
 {
+  if (m_binary)
+    return DeserializeBinaryEntries(chunk, nameDictionaryBuilder);
+
   vector<Entry> entries;
-  entries.reserve(bufferSize);
-  NameDictionaryBuilder nameDictionaryBuilder;
   ParsingStats stats;
+  vector<base::GeoObjectId> removedOsmIds;
 
-  for (size_t i = 0; i < bufferSize; ++i)
+  string line;
+  string json;
+  size_t lineBegin = 0;
+  while (lineBegin < chunk.size())
   {
-    auto & line = linesBuffer[i];
+    auto lineEnd = chunk.find('\n', lineBegin);
+    if (lineEnd == string::npos)
+      lineEnd = chunk.size();
+    line.assign(chunk, lineBegin, lineEnd - lineBegin);
+    lineBegin = lineEnd + 1;
 
     if (line.empty())
       continue;
@@ -235,28 +320,80 @@ HierarchyReader::ParsingResult HierarchyReader::DeserializeEntries(
       ++stats.m_badOsmIds;
       continue;
     }
-    auto json = line.substr(p + 1);
+    json.assign(line, p + 1, string::npos);
 
-    Entry entry;
     auto const osmId = base::GeoObjectId(encodedId);
+    if (json == kRemovedEntryJson)
+    {
+      removedOsmIds.push_back(osmId);
+      continue;
+    }
+
+    Entry entry;
     entry.m_osmId = osmId;
 
-    if (!entry.DeserializeFromJSON(json, nameDictionaryBuilder, stats))
+    if (!entry.DeserializeFromJSON(json, nameDictionaryBuilder, stats, m_namesFilter))
       continue;
 
     if (entry.m_type == Type::Count)
       continue;
 
-    ++stats.m_numLoaded;
+    OnEntryLoaded(stats);
+    entries.push_back(move(entry));
+  }
+
+  return {move(entries), {}, move(stats), move(removedOsmIds)};
+}
+
+HierarchyReader::ParsingResult HierarchyReader::DeserializeBinaryEntries(
+    string const & chunk, NameDictionaryBuilder & nameDictionaryBuilder)
+{
+  vector<Entry> entries;
+  ParsingStats stats;
+
+  BinaryHierarchyChunkReader reader(chunk);
+  BinaryHierarchyEntry binaryEntry;
+  while (reader.Read(binaryEntry))
+  {
+    Entry entry;
+    entry.m_osmId = binaryEntry.m_osmId;
+    entry.m_kind = binaryEntry.m_kind;
+    for (size_t i = 0; i < binaryEntry.m_address.size(); ++i)
+    {
+      MultipleNames multipleNames;
+      for (auto const & name : binaryEntry.m_address[i])
+        Entry::AddFieldName(name.first, name.second, m_namesFilter, multipleNames, stats);
+
+      if (!multipleNames.GetMainName().empty())
+        entry.m_normalizedAddress[i] = nameDictionaryBuilder.Add(multipleNames);
+    }
+
+    if (!entry.SetTypeByAddress(binaryEntry.m_rank, stats))
+      continue;
+
+    if (!binaryEntry.m_hasName)
+      ++stats.m_emptyNames;
 
-    auto totalNumLoaded = m_totalNumLoaded.fetch_add(1) + 1;
-    if (totalNumLoaded % kLogBatch == 0)
-      LOG(LINFO, ("Read", totalNumLoaded, "entries"));
+    if (entry.m_type == Type::Count)
+    {
+      ++stats.m_emptyAddresses;
+      continue;
+    }
 
+    OnEntryLoaded(stats);
     entries.push_back(move(entry));
   }
 
-  return {move(entries), nameDictionaryBuilder.Release(), move(stats)};
+  return {move(entries), {}, move(stats), {}};
+}
+
+void HierarchyReader::OnEntryLoaded(ParsingStats & stats)
+{
+  ++stats.m_numLoaded;
+
+  auto totalNumLoaded = m_totalNumLoaded.fetch_add(1) + 1;
+  if (totalNumLoaded % kLogBatch == 0)
+    LOG(LINFO, ("Read", totalNumLoaded, "entries"));
 }
 
 // static
@@ -9,7 +9,6 @@
 #include <atomic>
 #include <fstream>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
@@ -24,19 +23,30 @@ class HierarchyReader
 public:
   using Entry = Hierarchy::Entry;
   using ParsingStats = Hierarchy::ParsingStats;
+  using NamesFilter = Hierarchy::NamesFilter;
 
   DECLARE_EXCEPTION(Exception, RootException);
   DECLARE_EXCEPTION(OpenException, Exception);
   DECLARE_EXCEPTION(NoVersion, Exception);
 
+  // The hierarchy is either the jsonl or the binary one, see BinaryHierarchyEntry. The binary
+  // hierarchy has no data version headline.
   explicit HierarchyReader(std::string const & pathToJsonHierarchy,
-                           bool dataVersionHeadline = false);
-  explicit HierarchyReader(std::istream & jsonHierarchy, bool dataVersionHeadline = false);
+                           bool dataVersionHeadline = false,
+                           NamesFilter const & namesFilter = {});
+  explicit HierarchyReader(std::istream & jsonHierarchy, bool dataVersionHeadline = false,
+                           NamesFilter const & namesFilter = {});
 
   // Read hierarchy file/stream concurrently in |readersCount| threads.
   Hierarchy Read(unsigned int readersCount = 1);
+  // Reads the file/stream as a delta of a hierarchy, see Hierarchy::ApplyDelta(). Lines of
+  // the delta are the lines of the hierarchy with the added or modified entries and the lines
+  // "<osm id> null" of the removed ones.
+  Hierarchy::Delta ReadDelta(unsigned int readersCount = 1);
 
   static std::string ReadDataVersion(std::string const & pathToJsonHierarchy);
+  // Opens the hierarchy file, the ".gz" files are decompressed on the fly.
+  static std::unique_ptr<std::istream> CreateDataStream(std::string const & pathToJsonHierarchy);
 
 private:
   struct ParsingResult
@@ -44,13 +54,25 @@ private:
     std::vector<Entry> m_entries;
     NameDictionary m_nameDictionary;
     ParsingStats m_stats;
+    std::vector<base::GeoObjectId> m_removedOsmIds;
   };
 
-  static std::unique_ptr<std::istream> CreateDataStream(std::string const & pathToJsonHierarchy);
+  // Reads all the entries to one name dictionary, the entries are sorted.
+  ParsingResult ReadEntries(unsigned int readersCount);
+
   static std::string ReadDataVersion(std::istream & stream);
-  ParsingResult ReadEntries(size_t count);
-  ParsingResult DeserializeEntries(std::vector<std::string> const & linesBuffer,
-                                   std::size_t const bufferSize);
+  // Reads about |chunkSize| bytes of whole lines from the stream or the entries of a chunk of
+  // the binary hierarchy.
+  std::string ReadChunk(size_t chunkSize);
+  std::string ReadBinaryChunk();
+  // Parses the lines of |chunk| into entries, the names are added to |nameDictionaryBuilder|
+  // which is shared by the parsing threads. The name dictionary of the result is empty.
+  ParsingResult DeserializeEntries(std::string const & chunk,
+                                   NameDictionaryBuilder & nameDictionaryBuilder);
+  ParsingResult DeserializeBinaryEntries(std::string const & chunk,
+                                         NameDictionaryBuilder & nameDictionaryBuilder);
+  // Counts the loaded entry.
+  void OnEntryLoaded(ParsingStats & stats);
   static bool DeserializeId(std::string const & str, uint64_t & id);
   static std::string SerializeId(uint64_t id);
 
@@ -58,9 +80,10 @@ private:
 
   std::unique_ptr<std::istream> m_fileStream;
   std::istream & m_in;
+  bool m_binary{false};
   bool m_eof{false};
-  std::mutex m_mutex;
   std::atomic<std::uint64_t> m_totalNumLoaded{0};
   std::string m_dataVersion;
+  NamesFilter m_namesFilter;
 };
 } // namespace geocoder
@@ -560,8 +560,19 @@ bool HouseNumbersMatch(strings::UniString const & houseNumber, vector<Token> con
 
   vector<vector<Token>> houseNumberParses;
   ParseHouseNumber(houseNumber, houseNumberParses);
+  return HouseNumbersMatch(houseNumberParses, queryParse, matchResult);
+}
+
+bool HouseNumbersMatch(vector<vector<Token>> const & houseNumberParses,
+                       vector<Token> const & queryParse, MatchResult & matchResult)
+{
+  if (queryParse.empty())
+  {
+    matchResult = {};
+    return false;
+  }
 
-  for (auto & parse : houseNumberParses)
+  for (auto const & parse : houseNumberParses)
   {
     if (parse.empty())
       continue;
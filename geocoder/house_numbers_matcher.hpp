@@ -82,6 +82,11 @@ bool HouseNumbersMatch(strings::UniString const & houseNumber,
 bool HouseNumbersMatch(strings::UniString const & houseNumber, std::vector<Token> const & queryParse,
                        MatchResult & matchResult);
 
+// The same as above but for the house number |houseNumberParses|
+// that are precomputed with ParseHouseNumber().
+bool HouseNumbersMatch(std::vector<std::vector<Token>> const & houseNumberParses,
+                       std::vector<Token> const & queryParse, MatchResult & matchResult);
+
 // Returns true if |s| looks like a house number.
 bool LooksLikeHouseNumber(strings::UniString const & s, bool isPrefix);
 bool LooksLikeHouseNumber(std::string const & s, bool isPrefix);
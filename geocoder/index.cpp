@@ -4,6 +4,8 @@
 
 #include "indexer/search_string_utils.hpp"
 
+#include "coding/file_container.hpp"
+
 #include "base/assert.hpp"
 #include "base/logging.hpp"
 #include "base/string_utils.hpp"
@@ -11,7 +13,10 @@
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
-#include <mutex>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <thread>
 
 using namespace std;
@@ -20,13 +25,58 @@ namespace
 {
 // Information will be logged for every |kLogBatch| docs.
 size_t const kLogBatch = 100000;
+
+// The buildings of the streets/localities with fewer buildings are matched by the linear scan.
+size_t const kMinIndexedHouseNumbers = 32;
+
+char const kTokensBlobTag[] = "geocoder_tokens_blob";
+char const kTokensTag[] = "geocoder_tokens";
+char const kTrieEdgesTag[] = "geocoder_trie_edges";
+char const kPostingsOffsetsTag[] = "geocoder_postings_offsets";
+char const kPostingsTag[] = "geocoder_packed_postings";
+char const kBuildingsOffsetsTag[] = "geocoder_buildings_offsets";
+char const kBuildingsTag[] = "geocoder_packed_buildings";
+
+template <typename T>
+uint32_t ToMappedOffset(T value)
+{
+  CHECK_LESS_OR_EQUAL(value, numeric_limits<uint32_t>::max(), ());
+  return static_cast<uint32_t>(value);
+}
+
+// The estimate of the memory of an std::unordered_map without the memory owned by the values.
+template <typename Map>
+size_t GetHashMapBytes(Map const & map)
+{
+  return map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void *)) +
+         map.bucket_count() * sizeof(void *);
+}
+
+template <typename T>
+size_t GetVectorBytes(vector<T> const & values)
+{
+  return values.capacity() * sizeof(T);
+}
+
+template <typename T>
+void WriteArray(FilesContainerW & container, string const & tag, vector<T> const & values)
+{
+  auto writer = container.GetWriter(tag);
+  if (!values.empty())
+    writer->Write(values.data(), values.size() * sizeof(T));
+}
 }  // namespace
 
 namespace geocoder
 {
+// static
+Index::TokenId constexpr Index::kInvalidTokenId;
+Index::NodeId constexpr Index::kRootNodeId;
+Index::NodeId constexpr Index::kInvalidNodeId;
+size_t constexpr Index::kTypesCount;
+
 Index::Index(Hierarchy const & hierarchy)
-  : m_docs(hierarchy.GetEntries())
-  , m_hierarchy{hierarchy}
+  : m_hierarchy{hierarchy}
 {
 }
 
@@ -34,71 +84,602 @@ void Index::BuildIndex(unsigned int loadThreadsCount)
 {
   CHECK_GREATER_OR_EQUAL(loadThreadsCount, 1, ());
 
-  m_docIdsByTokens.clear();
+  m_tokens.clear();
+  m_tokenIds.clear();
+  m_trieEdges.clear();
+  m_docIdsByNodes.assign(1 /* root */, {});
   m_relatedBuildings.clear();
+  Unmap();
 
   LOG(LINFO, ("Indexing hierarchy entries..."));
-  AddEntries();
+  AddEntries(loadThreadsCount);
   LOG(LINFO, ("Indexing houses..."));
   AddHouses(loadThreadsCount);
+  BuildTokensTrie();
+  BuildHouseNumberParses();
+  BuildHouseNumbersIndex();
+  UpdateMemory();
+  LOG(LINFO, ("Index vocabulary size:", m_tokens.size(), "trie nodes:", m_docIdsByNodes.size()));
+}
+
+void Index::OnSegmentsLoaded()
+{
+  RebuildTokenIds();
+  BuildHouseNumberParses();
+  BuildHouseNumbersIndex();
+  UpdateMemory();
+}
+
+void Index::Serialize(FilesContainerW & container) const
+{
+  CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+
+  vector<TokenId> sortedTokenIds(m_tokens.size());
+  iota(sortedTokenIds.begin(), sortedTokenIds.end(), 0);
+  sort(sortedTokenIds.begin(), sortedTokenIds.end(),
+       [this](TokenId lhs, TokenId rhs) { return m_tokens[lhs] < m_tokens[rhs]; });
+
+  vector<char> tokensBlob;
+  vector<MappedTokenRecord> tokens;
+  tokens.reserve(m_tokens.size() + 1);
+  for (auto const tokenId : sortedTokenIds)
+  {
+    auto const & token = m_tokens[tokenId];
+    tokens.push_back({ToMappedOffset(tokensBlob.size()), tokenId});
+    tokensBlob.insert(tokensBlob.end(), token.begin(), token.end());
+  }
+  tokens.push_back({ToMappedOffset(tokensBlob.size()), kInvalidTokenId});
+
+  vector<MappedEdgeRecord> edges;
+  edges.reserve(m_trieEdges.size());
+  for (auto const & edge : m_trieEdges)
+  {
+    edges.push_back({static_cast<NodeId>(edge.first >> 32), static_cast<TokenId>(edge.first),
+                     edge.second});
+  }
+  sort(edges.begin(), edges.end(), [](MappedEdgeRecord const & lhs, MappedEdgeRecord const & rhs) {
+    return MakeEdgeKey(lhs.m_parent, lhs.m_tokenId) < MakeEdgeKey(rhs.m_parent, rhs.m_tokenId);
+  });
+
+  vector<uint32_t> postingsOffsets;
+  vector<uint8_t> postings;
+  vector<DocId> docIds;
+  postingsOffsets.reserve(m_docIdsByNodes.size() * kTypesCount + 1);
+  for (NodeId node = 0; node < m_docIdsByNodes.size(); ++node)
+  {
+    for (size_t type = 0; type < kTypesCount; ++type)
+    {
+      postingsOffsets.push_back(ToMappedOffset(postings.size()));
+      auto const range = GetDocIdsRange(node, static_cast<Type>(type));
+      if (range.first == range.second)
+        continue;
+
+      docIds.assign(range.first, range.second);
+      PackPostingList(docIds, postings);
+    }
+  }
+  postingsOffsets.push_back(ToMappedOffset(postings.size()));
+
+  auto const docsCount = m_hierarchy.GetEntries().size();
+  vector<uint32_t> buildingsOffsets;
+  vector<uint8_t> buildings;
+  buildingsOffsets.reserve(docsCount + 1);
+  for (DocId docId = 0; docId < docsCount; ++docId)
+  {
+    buildingsOffsets.push_back(ToMappedOffset(buildings.size()));
+    auto const it = m_relatedBuildings.find(docId);
+    if (it == m_relatedBuildings.end() || it->second.empty())
+      continue;
+
+    PackPostingList(it->second, buildings);
+  }
+  buildingsOffsets.push_back(ToMappedOffset(buildings.size()));
+
+  WriteArray(container, kTokensBlobTag, tokensBlob);
+  WriteArray(container, kTokensTag, tokens);
+  WriteArray(container, kTrieEdgesTag, edges);
+  WriteArray(container, kPostingsOffsetsTag, postingsOffsets);
+  WriteArray(container, kPostingsTag, postings);
+  WriteArray(container, kBuildingsOffsetsTag, buildingsOffsets);
+  WriteArray(container, kBuildingsTag, buildings);
+}
+
+void Index::Map(FilesMappingContainer const & container)
+{
+  m_tokens.clear();
+  m_tokenIds.clear();
+  m_trieEdges.clear();
+  m_docIdsByNodes.clear();
+  m_relatedBuildings.clear();
+
+  m_mappedTokensBlob = container.Map(kTokensBlobTag);
+  m_mappedTokens = container.Map(kTokensTag);
+  m_mappedTrieEdges = container.Map(kTrieEdgesTag);
+  m_mappedPostingsOffsets = container.Map(kPostingsOffsetsTag);
+  m_mappedPostings = container.Map(kPostingsTag);
+  m_mappedBuildingsOffsets = container.Map(kBuildingsOffsetsTag);
+  m_mappedBuildings = container.Map(kBuildingsTag);
+
+  CHECK_GREATER(m_mappedTokens.GetDataCount<MappedTokenRecord>(), 0, ());
+  CHECK_GREATER(m_mappedPostingsOffsets.GetDataCount<uint32_t>(), 1, ());
+  CHECK_EQUAL((m_mappedPostingsOffsets.GetDataCount<uint32_t>() - 1) % kTypesCount, 0, ());
+  CHECK_EQUAL(m_mappedBuildingsOffsets.GetDataCount<uint32_t>(),
+              m_hierarchy.GetEntries().size() + 1, ());
+  m_isMapped = true;
+
+  BuildTokensTrie();
+  BuildHouseNumberParses();
+  BuildHouseNumbersIndex();
+  UpdateMemory();
+}
+
+void Index::Unmap()
+{
+  m_isMapped = false;
+  m_mappedTokensBlob.Unmap();
+  m_mappedTokens.Unmap();
+  m_mappedTrieEdges.Unmap();
+  m_mappedPostingsOffsets.Unmap();
+  m_mappedPostings.Unmap();
+  m_mappedBuildingsOffsets.Unmap();
+  m_mappedBuildings.Unmap();
+}
+
+void Index::UpdateMemory()
+{
+  size_t bytes = GetVectorBytes(m_tokens) + GetHashMapBytes(m_tokenIds);
+  for (auto const & token : m_tokens)
+    bytes += token.capacity();
+  bytes += GetHashMapBytes(m_trieEdges) + GetVectorBytes(m_docIdsByNodes);
+  for (auto const & docIds : m_docIdsByNodes)
+    bytes += GetVectorBytes(docIds);
+  bytes += GetHashMapBytes(m_relatedBuildings);
+  for (auto const & buildings : m_relatedBuildings)
+    bytes += GetVectorBytes(buildings.second);
+  bytes += GetHashMapBytes(m_houseNumberParses);
+  for (auto const & parses : m_houseNumberParses)
+  {
+    bytes += GetVectorBytes(parses.second);
+    for (auto const & parse : parses.second)
+      bytes += GetVectorBytes(parse);
+  }
+  bytes += GetHashMapBytes(m_houseNumbersByRelations);
+  for (auto const & records : m_houseNumbersByRelations)
+    bytes += GetVectorBytes(records.second);
+  m_memory.Set(bytes);
 }
 
 Index::Doc const & Index::GetDoc(DocId const id) const
 {
-  ASSERT_LESS(static_cast<size_t>(id), m_docs.size(), ());
-  return m_docs[static_cast<size_t>(id)];
+  return m_hierarchy.GetEntries()[static_cast<size_t>(id)];
+}
+
+Index::TokenId Index::GetTokenId(string const & token) const
+{
+  if (!m_isMapped)
+  {
+    auto const it = m_tokenIds.find(token);
+    return it == m_tokenIds.end() ? kInvalidTokenId : it->second;
+  }
+
+  auto const * blob = m_mappedTokensBlob.GetData<char>();
+  auto const * tokens = m_mappedTokens.GetData<MappedTokenRecord>();
+  // The last record is a sentinel.
+  auto const tokensCount = m_mappedTokens.GetDataCount<MappedTokenRecord>() - 1;
+
+  auto const compare = [&](size_t i) {
+    size_t const size = tokens[i + 1].m_tokenOffset - tokens[i].m_tokenOffset;
+    int const cmp = memcmp(blob + tokens[i].m_tokenOffset, token.data(), min(size, token.size()));
+    if (cmp != 0)
+      return cmp;
+    if (size == token.size())
+      return 0;
+    return size < token.size() ? -1 : 1;
+  };
+
+  size_t lo = 0;
+  size_t hi = tokensCount;
+  while (lo < hi)
+  {
+    size_t const mid = lo + (hi - lo) / 2;
+    int const cmp = compare(mid);
+    if (cmp == 0)
+      return tokens[mid].m_tokenId;
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return kInvalidTokenId;
+}
+
+Index::TokenId Index::GetTokenIdWithMisprints(string const & token) const
+{
+  auto const tokenId = GetTokenId(token);
+  if (tokenId != kInvalidTokenId)
+    return tokenId;
+
+  auto const uniToken = strings::MakeUniString(token);
+  if (search::GetMaxErrorsForToken(uniToken) == 0)
+    return kInvalidTokenId;
+
+  auto bestTokenId = kInvalidTokenId;
+  size_t bestErrors = numeric_limits<size_t>::max();
+  ForEachTokenIdWithMisprints(search::BuildLevenshteinDFA(uniToken),
+                              [&](TokenId tokenId, size_t errors) {
+                                if (errors < bestErrors ||
+                                    (errors == bestErrors && tokenId < bestTokenId))
+                                {
+                                  bestTokenId = tokenId;
+                                  bestErrors = errors;
+                                }
+                              });
+  return bestTokenId;
+}
+
+Index::NodeId Index::FindNode(TokenIds const & tokenIds) const
+{
+  if (tokenIds.empty())
+    return kInvalidNodeId;
+
+  TokenIds sortedTokenIds = tokenIds;
+  sort(sortedTokenIds.begin(), sortedTokenIds.end());
+  // Invalid ids are the greatest ones.
+  if (sortedTokenIds.back() == kInvalidTokenId)
+    return kInvalidNodeId;
+
+  NodeId node = kRootNodeId;
+  for (auto const tokenId : sortedTokenIds)
+  {
+    node = FindChild(node, tokenId);
+    if (node == kInvalidNodeId)
+      break;
+  }
+  return node;
+}
+
+Index::NodeId Index::FindChild(NodeId parent, TokenId tokenId) const
+{
+  if (!m_isMapped)
+  {
+    auto const it = m_trieEdges.find(MakeEdgeKey(parent, tokenId));
+    return it == m_trieEdges.end() ? kInvalidNodeId : it->second;
+  }
+
+  auto const * begin = m_mappedTrieEdges.GetData<MappedEdgeRecord>();
+  auto const * end = begin + m_mappedTrieEdges.GetDataCount<MappedEdgeRecord>();
+  auto const key = MakeEdgeKey(parent, tokenId);
+  auto const * it = lower_bound(begin, end, key, [](MappedEdgeRecord const & edge, uint64_t key) {
+    return MakeEdgeKey(edge.m_parent, edge.m_tokenId) < key;
+  });
+  if (it == end || it->m_parent != parent || it->m_tokenId != tokenId)
+    return kInvalidNodeId;
+  return it->m_child;
+}
+
+pair<vector<Index::DocId>::const_iterator, vector<Index::DocId>::const_iterator>
+Index::GetDocIdsRange(NodeId node, Type type) const
+{
+  auto const & docIds = m_docIdsByNodes[node];
+  auto const begin = partition_point(docIds.begin(), docIds.end(), [&](DocId const & docId) {
+    return GetDoc(docId).m_type < type;
+  });
+  auto const end = partition_point(begin, docIds.end(), [&](DocId const & docId) {
+    return GetDoc(docId).m_type == type;
+  });
+  return {begin, end};
+}
+
+size_t Index::GetDocIdsCount(TokenIds const & tokenIds, Type type) const
+{
+  auto const node = FindNode(tokenIds);
+  if (node == kInvalidNodeId)
+    return 0;
+
+  if (m_isMapped)
+    return GetMappedDocIds(node, type).Size();
+
+  auto const range = GetDocIdsRange(node, type);
+  return static_cast<size_t>(distance(range.first, range.second));
+}
+
+PostingListReader Index::GetMappedDocIds(NodeId node, Type type) const
+{
+  return GetMappedPostingList(m_mappedPostingsOffsets, m_mappedPostings,
+                              static_cast<size_t>(node) * kTypesCount + static_cast<size_t>(type));
+}
+
+PostingListReader Index::GetMappedRelatedBuildings(DocId const & docId) const
+{
+  return GetMappedPostingList(m_mappedBuildingsOffsets, m_mappedBuildings, docId);
 }
 
 // static
-string Index::MakeIndexKey(Tokens const & tokens)
+PostingListReader Index::GetMappedPostingList(FilesMappingContainer::Handle const & offsets,
+                                              FilesMappingContainer::Handle const & lists,
+                                              size_t index)
 {
-  if (tokens.size() == 1 || is_sorted(begin(tokens), end(tokens)))
-    return strings::JoinStrings(tokens, " ");
+  auto const * data = offsets.GetData<uint32_t>();
+  ASSERT_LESS(index + 1, offsets.GetDataCount<uint32_t>(), ());
+  if (data[index] == data[index + 1])
+    return {};
+  return PostingListReader(lists.GetData<uint8_t>() + data[index]);
+}
 
-  auto indexTokens = tokens;
-  sort(begin(indexTokens), end(indexTokens));
-  return strings::JoinStrings(indexTokens, " ");
+void Index::RebuildTokenIds()
+{
+  m_tokenIds.clear();
+  m_tokenIds.reserve(m_tokens.size());
+  for (TokenId tokenId = 0; tokenId < m_tokens.size(); ++tokenId)
+    m_tokenIds.emplace(m_tokens[tokenId], tokenId);
+
+  BuildTokensTrie();
 }
 
-void Index::AddEntries()
+Index::HouseNumberParses const & Index::GetHouseNumberParses(Doc const & doc) const
 {
-  size_t numIndexed = 0;
+  static HouseNumberParses const kEmptyParses;
+
+  auto const position = doc.m_normalizedAddress[static_cast<size_t>(Type::Building)];
+  auto const it = m_houseNumberParses.find(position);
+  return it == m_houseNumberParses.end() ? kEmptyParses : it->second;
+}
+
+void Index::BuildHouseNumberParses()
+{
+  m_houseNumberParses.clear();
+
   auto const & dictionary = m_hierarchy.GetNormalizedNameDictionary();
-  Tokens tokens;
-  for (DocId docId = 0; docId < static_cast<DocId>(m_docs.size()); ++docId)
+  auto const docs = m_hierarchy.GetEntries();
+  for (size_t i = 0; i < docs.size(); ++i)
+  {
+    auto const & doc = docs[i];
+    if (doc.m_type != Type::Building)
+      continue;
+
+    auto const position = doc.m_normalizedAddress[static_cast<size_t>(Type::Building)];
+    if (position == NameDictionary::kUnspecifiedPosition)
+      continue;
+
+    auto const it = m_houseNumberParses.emplace(position, HouseNumberParses{});
+    if (!it.second)
+      continue;
+
+    auto const & houseNumber = dictionary.Get(position).GetMainName();
+    search::house_numbers::ParseHouseNumber(strings::MakeUniString(string(houseNumber)),
+                                            it.first->second);
+  }
+}
+
+void Index::BuildHouseNumbersIndex()
+{
+  m_houseNumbersByRelations.clear();
+
+  auto const docsCount = m_hierarchy.GetEntries().size();
+  vector<HouseNumberRecord> records;
+  for (DocId docId = 0; docId < docsCount; ++docId)
   {
-    auto const & doc = m_docs[static_cast<size_t>(docId)];
-    // The doc is indexed only by its address.
-    // todo(@m) Index it by name too.
-    if (doc.m_type == Type::Count)
+    auto const type = GetDoc(docId).m_type;
+    if (type != Type::Street && type != Type::Locality)
       continue;
 
-    if (doc.m_type == Type::Building)
+    records.clear();
+    ForEachRelatedBuilding(docId, [&](DocId const & buildingDocId) {
+      for (auto const & parse : GetHouseNumberParses(GetDoc(buildingDocId)))
+      {
+        if (!parse.empty())
+          records.push_back({&parse[0], buildingDocId});
+      }
+    });
+    if (records.size() < kMinIndexedHouseNumbers)
       continue;
 
-    if (doc.m_type == Type::Street)
+    sort(records.begin(), records.end(), HouseNumberRecordLess());
+    records.erase(unique(records.begin(), records.end(),
+                         [](HouseNumberRecord const & lhs, HouseNumberRecord const & rhs) {
+                           return lhs.m_building == rhs.m_building &&
+                                  *lhs.m_firstToken == *rhs.m_firstToken;
+                         }),
+                  records.end());
+    m_houseNumbersByRelations.emplace(docId, records);
+  }
+}
+
+void Index::BuildTokensTrie()
+{
+  vector<pair<strings::UniString, TokenId>> tokens;
+  if (!m_isMapped)
+  {
+    tokens.reserve(m_tokens.size());
+    for (TokenId tokenId = 0; tokenId < m_tokens.size(); ++tokenId)
+      tokens.emplace_back(strings::MakeUniString(m_tokens[tokenId]), tokenId);
+  }
+  else
+  {
+    auto const * blob = m_mappedTokensBlob.GetData<char>();
+    auto const * records = m_mappedTokens.GetData<MappedTokenRecord>();
+    // The last record is a sentinel.
+    auto const tokensCount = m_mappedTokens.GetDataCount<MappedTokenRecord>() - 1;
+    tokens.reserve(tokensCount);
+    for (size_t i = 0; i < tokensCount; ++i)
     {
-      AddStreet(docId, doc);
+      string const token(blob + records[i].m_tokenOffset, blob + records[i + 1].m_tokenOffset);
+      tokens.emplace_back(strings::MakeUniString(token), records[i].m_tokenId);
     }
-    else
+  }
+  m_tokensTrie.Build(move(tokens), CountTokensNames());
+}
+
+vector<uint64_t> Index::CountTokensNames() const
+{
+  // The path from the root to a node of the names trie is the sorted token ids of the names
+  // ending in the node, so a token occurs in the names of the subtrees of its edges.
+  vector<NodeId> parents;
+  vector<TokenId> tokenIds;
+  vector<uint64_t> namesCounts;
+  auto const addEdge = [&](NodeId parent, TokenId tokenId, NodeId child) {
+    CHECK_LESS(parent, child, ());
+    CHECK_LESS(child, parents.size(), ());
+    parents[child] = parent;
+    tokenIds[child] = tokenId;
+  };
+
+  size_t tokensCount = 0;
+  if (!m_isMapped)
+  {
+    tokensCount = m_tokens.size();
+    parents.resize(m_docIdsByNodes.size());
+    tokenIds.resize(m_docIdsByNodes.size());
+    namesCounts.resize(m_docIdsByNodes.size());
+    for (auto const & edge : m_trieEdges)
+      addEdge(static_cast<NodeId>(edge.first >> 32), static_cast<TokenId>(edge.first), edge.second);
+    for (size_t node = 0; node < m_docIdsByNodes.size(); ++node)
+      namesCounts[node] = m_docIdsByNodes[node].size();
+  }
+  else
+  {
+    // The last records are sentinels.
+    tokensCount = m_mappedTokens.GetDataCount<MappedTokenRecord>() - 1;
+    auto const nodesCount = (m_mappedPostingsOffsets.GetDataCount<uint32_t>() - 1) / kTypesCount;
+    parents.resize(nodesCount);
+    tokenIds.resize(nodesCount);
+    namesCounts.resize(nodesCount);
+    auto const * edges = m_mappedTrieEdges.GetData<MappedEdgeRecord>();
+    for (size_t i = 0; i < m_mappedTrieEdges.GetDataCount<MappedEdgeRecord>(); ++i)
+      addEdge(edges[i].m_parent, edges[i].m_tokenId, edges[i].m_child);
+    for (size_t node = 0; node < nodesCount; ++node)
     {
-      for (auto const & name : doc.GetNormalizedMultipleNames(doc.m_type, dictionary))
+      for (size_t type = 0; type < kTypesCount; ++type)
       {
-        search::NormalizeAndTokenizeAsUtf8(name, tokens);
-        InsertToIndex(tokens, docId);
+        namesCounts[node] +=
+            GetMappedDocIds(static_cast<NodeId>(node), static_cast<Type>(type)).Size();
       }
     }
+  }
+
+  // The children follow their parents.
+  vector<uint64_t> tokensNames(tokensCount, 0);
+  for (auto node = namesCounts.size(); node-- > 1;)
+  {
+    namesCounts[parents[node]] += namesCounts[node];
+    CHECK_LESS(tokenIds[node], tokensCount, ());
+    tokensNames[tokenIds[node]] += namesCounts[node];
+  }
+  return tokensNames;
+}
+
+// Names of a range of docs tokenized by one thread. Token ids of the shard are local,
+// they are numbered in the order of the first occurrence.
+struct Index::NamesShard
+{
+  void Add(Tokens const & tokens, DocId docId)
+  {
+    if (tokens.empty())
+      return;
+
+    for (auto const & token : tokens)
+    {
+      auto const it = m_tokenIds.emplace(token, static_cast<TokenId>(m_tokens.size()));
+      if (it.second)
+        m_tokens.push_back(token);
+      m_nameTokens.push_back(it.first->second);
+    }
+    m_names.emplace_back(docId, m_nameTokens.size());
+  }
+
+  vector<string> m_tokens;
+  unordered_map<string, TokenId> m_tokenIds;
+  // Local token ids of all the names, one after another.
+  vector<TokenId> m_nameTokens;
+  // DocIds of the names and the ends of their tokens in |m_nameTokens|.
+  vector<pair<DocId, size_t>> m_names;
+};
+
+void Index::AddEntries(unsigned int loadThreadsCount)
+{
+  atomic<size_t> numIndexed{0};
+
+  vector<NamesShard> shards(loadThreadsCount);
+  vector<thread> threads(loadThreadsCount);
+  CHECK_GREATER(threads.size(), 0, ());
+
+  auto const & dictionary = m_hierarchy.GetNormalizedNameDictionary();
+  auto const docs = m_hierarchy.GetEntries();
+  auto const docsCount = docs.size();
+
+  for (size_t t = 0; t < threads.size(); ++t)
+  {
+    threads[t] = thread([&, t, this]() {
+      size_t const size = docsCount / threads.size();
+      size_t docId = t * size;
+      size_t const docIdEnd = (t + 1 == threads.size() ? docsCount : docId + size);
+
+      auto & shard = shards[t];
+      Tokens tokens;
+      for (; docId < docIdEnd; ++docId)
+      {
+        auto const & doc = docs[docId];
+        // The doc is indexed only by its address.
+        // todo(@m) Index it by name too.
+        if (doc.m_type == Type::Count)
+          continue;
+
+        if (doc.m_type == Type::Building)
+          continue;
 
-    ++numIndexed;
-    if (numIndexed % kLogBatch == 0)
-      LOG(LINFO, ("Indexed", numIndexed, "entries"));
+        if (doc.m_type == Type::Street)
+        {
+          AddStreet(docId, doc, shard);
+        }
+        else
+        {
+          for (auto const & name : doc.GetNormalizedMultipleNames(doc.m_type, dictionary))
+          {
+            search::NormalizeAndTokenizeAsUtf8(string(name), tokens);
+            shard.Add(tokens, docId);
+          }
+        }
+
+        auto const processedCount = numIndexed.fetch_add(1) + 1;
+        if (processedCount % kLogBatch == 0)
+          LOG(LINFO, ("Indexed", processedCount, "entries"));
+      }
+    });
   }
 
+  for (auto & t : threads)
+    t.join();
+
   if (numIndexed % kLogBatch != 0)
     LOG(LINFO, ("Indexed", numIndexed, "entries"));
+
+  // Shards are merged in the order of the docs, so the token ids and the trie
+  // do not depend on the number of threads.
+  vector<TokenId> tokenIdsMapping;
+  TokenIds tokenIds;
+  for (auto & shard : shards)
+  {
+    tokenIdsMapping.clear();
+    for (auto & token : shard.m_tokens)
+      tokenIdsMapping.push_back(AddToken(move(token)));
+
+    size_t nameBegin = 0;
+    for (auto const & name : shard.m_names)
+    {
+      tokenIds.clear();
+      for (size_t i = nameBegin; i < name.second; ++i)
+        tokenIds.push_back(tokenIdsMapping[shard.m_nameTokens[i]]);
+      InsertToIndex(tokenIds, name.first);
+      nameBegin = name.second;
+    }
+
+    shard = {};
+  }
+
+  PartitionDocIdsByTypes();
 }
 
-void Index::AddStreet(DocId const & docId, Index::Doc const & doc)
+void Index::AddStreet(DocId const & docId, Index::Doc const & doc, NamesShard & shard) const
 {
   CHECK_EQUAL(doc.m_type, Type::Street, ());
 
@@ -110,16 +691,16 @@ void Index::AddStreet(DocId const & docId, Index::Doc const & doc)
   Tokens tokens;
   for (auto const & name : doc.GetNormalizedMultipleNames(Type::Street, dictionary))
   {
-    search::NormalizeAndTokenizeAsUtf8(name, tokens);
+    search::NormalizeAndTokenizeAsUtf8(string(name), tokens);
 
     if (all_of(begin(tokens), end(tokens), isStreetSynonym))
     {
       if (tokens.size() > 1)
-        InsertToIndex(tokens, docId);
+        shard.Add(tokens, docId);
       return;
     }
 
-    InsertToIndex(tokens, docId);
+    shard.Add(tokens, docId);
 
     for (size_t i = 0; i < tokens.size(); ++i)
     {
@@ -127,7 +708,7 @@ void Index::AddStreet(DocId const & docId, Index::Doc const & doc)
         continue;
       auto addr = tokens;
       addr.erase(addr.begin() + i);
-      InsertToIndex(addr, docId);
+      shard.Add(addr, docId);
     }
   }
 }
@@ -135,19 +716,21 @@ void Index::AddStreet(DocId const & docId, Index::Doc const & doc)
 void Index::AddHouses(unsigned int loadThreadsCount)
 {
   atomic<size_t> numIndexed{0};
-  mutex buildingsMutex;
 
+  // Pairs of (street or locality, building) found by every thread.
+  vector<vector<pair<DocId, DocId>>> relations(loadThreadsCount);
   vector<thread> threads(loadThreadsCount);
   CHECK_GREATER(threads.size(), 0, ());
 
   auto const & dictionary = m_hierarchy.GetNormalizedNameDictionary();
+  auto const docsCount = m_hierarchy.GetEntries().size();
 
   for (size_t t = 0; t < threads.size(); ++t)
   {
     threads[t] = thread([&, t, this]() {
-      size_t const size = m_docs.size() / threads.size();
+      size_t const size = docsCount / threads.size();
       size_t docId = t * size;
-      size_t const docIdEnd = (t + 1 == threads.size() ? m_docs.size() : docId + size);
+      size_t const docIdEnd = (t + 1 == threads.size() ? docsCount : docId + size);
 
       for (; docId < docIdEnd; ++docId)
       {
@@ -171,7 +754,7 @@ void Index::AddHouses(unsigned int loadThreadsCount)
         auto const & relationMultipleNames = dictionary.Get(relation);
         auto const & relationName = relationMultipleNames.GetMainName();
         Tokens relationNameTokens;
-        search::NormalizeAndTokenizeAsUtf8(relationName, relationNameTokens);
+        search::NormalizeAndTokenizeAsUtf8(string(relationName), relationNameTokens);
         CHECK(!relationNameTokens.empty(), ());
 
         bool indexed = false;
@@ -180,9 +763,7 @@ void Index::AddHouses(unsigned int loadThreadsCount)
           if (m_hierarchy.IsParentTo(candidateDoc, buildingDoc))
           {
             indexed = true;
-
-            lock_guard<mutex> lock(buildingsMutex);
-            m_relatedBuildings[candidate].emplace_back(docId);
+            relations[t].emplace_back(candidate, docId);
           }
         });
 
@@ -199,14 +780,66 @@ void Index::AddHouses(unsigned int loadThreadsCount)
   for (auto & t : threads)
     t.join();
 
+  // Relations are merged in the order of the buildings, so the lists of buildings
+  // do not depend on the number of threads.
+  for (auto & threadRelations : relations)
+  {
+    for (auto const & relation : threadRelations)
+      m_relatedBuildings[relation.first].emplace_back(relation.second);
+    threadRelations = {};
+  }
+
   if (numIndexed % kLogBatch != 0)
     LOG(LINFO, ("Indexed", numIndexed, "houses"));
 }
 
-void Index::InsertToIndex(Tokens const & tokens, DocId docId)
+Index::TokenId Index::AddToken(string && token)
+{
+  auto const it = m_tokenIds.emplace(token, static_cast<TokenId>(m_tokens.size()));
+  if (it.second)
+  {
+    CHECK_LESS(m_tokens.size(), kInvalidTokenId, ());
+    m_tokens.push_back(move(token));
+  }
+  return it.first->second;
+}
+
+void Index::InsertToIndex(TokenIds tokenIds, DocId docId)
 {
-  auto & ids = m_docIdsByTokens[MakeIndexKey(tokens)];
-  if (0 == count(ids.begin(), ids.end(), docId))
+  if (tokenIds.empty())
+    return;
+
+  sort(tokenIds.begin(), tokenIds.end());
+
+  NodeId node = kRootNodeId;
+  for (auto const tokenId : tokenIds)
+  {
+    auto const it = m_trieEdges.emplace(MakeEdgeKey(node, tokenId),
+                                        static_cast<NodeId>(m_docIdsByNodes.size()));
+    if (it.second)
+    {
+      CHECK_LESS(m_docIdsByNodes.size(), kInvalidNodeId, ());
+      m_docIdsByNodes.emplace_back();
+    }
+    node = it.first->second;
+  }
+
+  // The docs are inserted in the increasing order of their ids, so the lists are sorted and
+  // a duplicate can only be the last id.
+  auto & ids = m_docIdsByNodes[node];
+  ASSERT(ids.empty() || ids.back() <= docId, ());
+  if (ids.empty() || ids.back() != docId)
     ids.emplace_back(docId);
 }
+
+void Index::PartitionDocIdsByTypes()
+{
+  // The lists are sorted by the ids, so the stable sort keeps the ids of every type sorted.
+  for (auto & docIds : m_docIdsByNodes)
+  {
+    stable_sort(docIds.begin(), docIds.end(), [this](DocId const & lhs, DocId const & rhs) {
+      return GetDoc(lhs).m_type < GetDoc(rhs).m_type;
+    });
+  }
+}
 }  // namespace geocoder
@@ -1,16 +1,29 @@
 #pragma once
 
 #include "geocoder/hierarchy.hpp"
+#include "geocoder/house_numbers_matcher.hpp"
+#include "geocoder/posting_list.hpp"
+#include "geocoder/token_trie.hpp"
 
+#include "coding/file_container.hpp"
+
+#include "base/buffer_vector.hpp"
 #include "base/geo_object_id.hpp"
+#include "base/memory_accounting.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/unordered_map.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/serialization/version.hpp>
 
 namespace geocoder
@@ -24,6 +37,13 @@ public:
   // that the index was constructed from.
   using DocId = std::vector<Doc>::size_type;
 
+  // Number of the token in the vocabulary of the index.
+  using TokenId = uint32_t;
+  static TokenId constexpr kInvalidTokenId = std::numeric_limits<TokenId>::max();
+
+  // Short sequences of token ids are kept on the stack.
+  using TokenIds = buffer_vector<TokenId, 16>;
+
   explicit Index(Hierarchy const & hierarchy);
 
   void BuildIndex(unsigned int loadThreadsCount = 1);
@@ -32,33 +52,166 @@ public:
   void serialize(Archive & ar, const unsigned int version)
   {
     CHECK_EQUAL(version, kIndexFormatVersion, ());
-    ar & m_docIdsByTokens;
+    CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+    ar & m_tokens;
+    ar & m_trieEdges;
+    ar & m_docIdsByNodes;
     ar & m_relatedBuildings;
+
+    if (Archive::is_loading::value)
+      OnSegmentsLoaded();
   }
 
+  // The token postings (the vocabulary, the token ids trie and the docs of its nodes) and
+  // the related buildings are kept in separate segments of the binary index, see
+  // Geocoder::SaveToBinaryIndex(). OnSegmentsLoaded() is to be called when both segments and
+  // the hierarchy are loaded.
+  template <class Archive>
+  void SaveTokenPostings(Archive & ar) const
+  {
+    CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+    ar << m_tokens;
+    ar << m_trieEdges;
+    ar << m_docIdsByNodes;
+  }
+
+  template <class Archive>
+  void LoadTokenPostings(Archive & ar)
+  {
+    CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+    ar >> m_tokens;
+    ar >> m_trieEdges;
+    ar >> m_docIdsByNodes;
+  }
+
+  template <class Archive>
+  void SaveRelatedBuildings(Archive & ar) const
+  {
+    CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+    ar << m_relatedBuildings;
+  }
+
+  template <class Archive>
+  void LoadRelatedBuildings(Archive & ar)
+  {
+    CHECK(!m_isMapped, ("Mapped index can't be serialized again."));
+    ar >> m_relatedBuildings;
+  }
+
+  void OnSegmentsLoaded();
+
+  // Writes the index to |container| in the mapped index format: sorted tables of
+  // the vocabulary and of the token ids trie edges and CSR-style packed posting lists
+  // for the trie nodes and for the related buildings, see PackPostingList().
+  void Serialize(FilesContainerW & container) const;
+  // Attaches the index to the mapped index |container|. Posting lists are not copied
+  // and are decoded right from the mapped memory.
+  void Map(FilesMappingContainer const & container);
+  // Detaches the index from the mapped index, the index is to be built or loaded after.
+  void Unmap();
+  bool IsMapped() const { return m_isMapped; }
+
   Doc const & GetDoc(DocId const id) const;
 
-  // Calls |fn| for DocIds of Docs whose names exactly match |tokens| (the order matters).
-  //
-  // todo This method (and the whole class, in fact) is in the
-  //      prototype stage and may be too slow. Proper indexing should
-  //      be implemented to perform this type of queries.
+  // Returns kInvalidTokenId when |token| does not occur in the indexed names.
+  TokenId GetTokenId(std::string const & token) const;
+
+  // Returns the id of |token| if it occurs in the indexed names. Otherwise returns
+  // the id of the closest token within search::GetMaxErrorsForToken() misprints
+  // (the smallest id among equally close ones) or kInvalidTokenId.
+  TokenId GetTokenIdWithMisprints(std::string const & token) const;
+
+  // Calls |fn(tokenId, errorsMade)| for every token of the vocabulary accepted by |dfa|,
+  // e.g. by strings::LevenshteinDFA. The vocabulary is walked once for all the tokens.
+  template <typename DFA, typename Fn>
+  void ForEachTokenIdWithMisprints(DFA const & dfa, Fn && fn) const
+  {
+    static_assert(std::is_same<TokenTrie::TokenId, TokenId>::value, "");
+    m_tokensTrie.ForEachMatch(dfa, std::forward<Fn>(fn));
+  }
+
+  // Calls |fn(tokenId)| for at most TokenTrie::kMaxCompletions tokens of the vocabulary which
+  // start with |prefix|, the tokens occurring in more names go first.
+  template <typename Fn>
+  void ForEachTokenIdWithPrefix(std::string const & prefix, Fn && fn) const
+  {
+    m_tokensTrie.ForEachCompletion(strings::MakeUniString(prefix), std::forward<Fn>(fn));
+  }
+
+  // Calls |fn| for DocIds of Docs whose names exactly match |tokens| (the order does not matter).
   template <typename Fn>
   void ForEachDocId(Tokens const & tokens, Fn && fn) const
   {
-    auto const it = m_docIdsByTokens.find(MakeIndexKey(tokens));
-    if (it == m_docIdsByTokens.end())
+    TokenIds tokenIds;
+    for (auto const & token : tokens)
+      tokenIds.push_back(GetTokenId(token));
+    ForEachDocIdByTokenIds(tokenIds, std::forward<Fn>(fn));
+  }
+
+  // The same as ForEachDocId() but for the tokens that are already converted to ids
+  // with GetTokenId(). Does not allocate memory for short |tokenIds|.
+  // The DocIds are grouped by the types of the docs, see ForEachDocIdByTokenIds() below.
+  template <typename Fn>
+  void ForEachDocIdByTokenIds(TokenIds const & tokenIds, Fn && fn) const
+  {
+    auto const node = FindNode(tokenIds);
+    if (node == kInvalidNodeId)
       return;
 
-    for (DocId const & docId : it->second)
+    if (m_isMapped)
+    {
+      for (size_t type = 0; type < kTypesCount; ++type)
+        ForEachMappedDocId(node, static_cast<Type>(type), fn);
+      return;
+    }
+
+    for (DocId const & docId : m_docIdsByNodes[node])
       fn(docId);
   }
 
+  // The same as ForEachDocIdByTokenIds() but only for the docs of |type|. The posting lists
+  // are partitioned by the types of the docs, so the docs of the other types are not visited.
+  template <typename Fn>
+  void ForEachDocIdByTokenIds(TokenIds const & tokenIds, Type type, Fn && fn) const
+  {
+    auto const node = FindNode(tokenIds);
+    if (node == kInvalidNodeId)
+      return;
+
+    if (m_isMapped)
+    {
+      ForEachMappedDocId(node, type, fn);
+      return;
+    }
+
+    auto const range = GetDocIdsRange(node, type);
+    for (auto it = range.first; it != range.second; ++it)
+      fn(*it);
+  }
+
+  // Returns the number of the docs of |type| visited by ForEachDocIdByTokenIds(tokenIds, type),
+  // the lengths of the posting lists are known without visiting them.
+  size_t GetDocIdsCount(TokenIds const & tokenIds, Type type) const;
+
+  using HouseNumberParses = std::vector<std::vector<search::house_numbers::Token>>;
+
+  // Returns the parses of the house number of the building |doc|, see
+  // search::house_numbers::ParseHouseNumber(). The parses are computed once
+  // for every distinct house number when the index is built or loaded.
+  HouseNumberParses const & GetHouseNumberParses(Doc const & doc) const;
+
   // Calls |fn| for DocIds of buildings that are located on the
   // street/locality whose DocId is |docId|.
   template <typename Fn>
   void ForEachRelatedBuilding(DocId const & docId, Fn && fn) const
   {
+    if (m_isMapped)
+    {
+      for (auto buildings = GetMappedRelatedBuildings(docId); !buildings.IsEnd(); buildings.Next())
+        fn(static_cast<DocId>(buildings.Get()));
+      return;
+    }
+
     auto const it = m_relatedBuildings.find(docId);
     if (it == m_relatedBuildings.end())
       return;
@@ -67,30 +220,186 @@ public:
       fn(docId);
   }
 
+  // Calls |fn| for DocIds of the buildings related to |docId| whose house numbers may match
+  // |queryParse|: a house number matches the query only if one of its parses starts with
+  // the first token of the query, see search::house_numbers::HouseNumbersMatch(). The buildings
+  // of the streets/localities with many buildings are found by the binary search.
+  template <typename Fn>
+  void ForEachRelatedBuildingWithHouseNumber(
+      DocId const & docId, std::vector<search::house_numbers::Token> const & queryParse,
+      Fn && fn) const
+  {
+    if (queryParse.empty())
+      return;
+
+    auto const it = m_houseNumbersByRelations.find(docId);
+    if (it == m_houseNumbersByRelations.end())
+    {
+      ForEachRelatedBuilding(docId, std::forward<Fn>(fn));
+      return;
+    }
+
+    auto const & records = it->second;
+    auto const range = std::equal_range(records.begin(), records.end(), queryParse[0],
+                                        HouseNumberRecordLess());
+    for (auto record = range.first; record != range.second; ++record)
+      fn(record->m_building);
+  }
+
 private:
-  void InsertToIndex(Tokens const & tokens, DocId docId);
+  // Number of the node in the trie of token ids, 0 is the root.
+  using NodeId = uint32_t;
+  static NodeId constexpr kRootNodeId = 0;
+  static NodeId constexpr kInvalidNodeId = std::numeric_limits<NodeId>::max();
+
+  // A record of the mapped vocabulary. Records are sorted by tokens, the token of the i-th
+  // record is [m_tokenOffset, m_tokenOffset of the next record) in the tokens blob.
+  // The last record is a sentinel.
+  struct MappedTokenRecord
+  {
+    uint32_t m_tokenOffset;
+    TokenId m_tokenId;
+  };
 
-  // Converts |tokens| to a single UTF-8 string that can be used
-  // as a key in the |m_docIdsByTokens| map.
-  static std::string MakeIndexKey(Tokens const & tokens);
+  // A record of the mapped trie edges. Records are sorted by (m_parent, m_tokenId).
+  struct MappedEdgeRecord
+  {
+    NodeId m_parent;
+    TokenId m_tokenId;
+    NodeId m_child;
+  };
+
+  // A building of a street/locality by the first token of a parse of its house number.
+  // The token is owned by |m_houseNumberParses|.
+  struct HouseNumberRecord
+  {
+    search::house_numbers::Token const * m_firstToken;
+    DocId m_building;
+  };
+
+  struct HouseNumberRecordLess
+  {
+    using Token = search::house_numbers::Token;
 
-  // Adds address information of |m_docs| to the index.
-  void AddEntries();
+    bool operator()(HouseNumberRecord const & lhs, HouseNumberRecord const & rhs) const
+    {
+      if (*lhs.m_firstToken != *rhs.m_firstToken)
+        return *lhs.m_firstToken < *rhs.m_firstToken;
+      return lhs.m_building < rhs.m_building;
+    }
+    bool operator()(HouseNumberRecord const & lhs, Token const & rhs) const
+    {
+      return *lhs.m_firstToken < rhs;
+    }
+    bool operator()(Token const & lhs, HouseNumberRecord const & rhs) const
+    {
+      return lhs < *rhs.m_firstToken;
+    }
+  };
 
-  // Adds the street |e| (which has the id of |docId|) to the index,
+  static uint64_t MakeEdgeKey(NodeId parent, TokenId tokenId)
+  {
+    return (static_cast<uint64_t>(parent) << 32) | tokenId;
+  }
+
+  // Returns the trie node of the sorted |tokenIds| or kInvalidNodeId.
+  NodeId FindNode(TokenIds const & tokenIds) const;
+  NodeId FindChild(NodeId parent, TokenId tokenId) const;
+
+  static size_t constexpr kTypesCount = static_cast<size_t>(Type::Count);
+
+  template <typename Fn>
+  void ForEachMappedDocId(NodeId node, Type type, Fn & fn) const
+  {
+    for (auto postings = GetMappedDocIds(node, type); !postings.IsEnd(); postings.Next())
+      fn(static_cast<DocId>(postings.Get()));
+  }
+
+  // Returns the range of the DocIds of the docs of |type| in m_docIdsByNodes[node].
+  std::pair<std::vector<DocId>::const_iterator, std::vector<DocId>::const_iterator>
+  GetDocIdsRange(NodeId node, Type type) const;
+
+  PostingListReader GetMappedDocIds(NodeId node, Type type) const;
+  PostingListReader GetMappedRelatedBuildings(DocId const & docId) const;
+  // Returns the packed list at offsets[index] of |lists|, the offsets array has a sentinel.
+  static PostingListReader GetMappedPostingList(FilesMappingContainer::Handle const & offsets,
+                                                FilesMappingContainer::Handle const & lists,
+                                                size_t index);
+
+  void RebuildTokenIds();
+  void BuildTokensTrie();
+  // Returns the number of the indexed names containing the token by the token ids.
+  std::vector<uint64_t> CountTokensNames() const;
+  void BuildHouseNumberParses();
+  // Fills the |m_houseNumbersByRelations| field, the house number parses are to be built.
+  void BuildHouseNumbersIndex();
+
+  struct NamesShard;
+
+  // Returns the id of |token| adding it to the vocabulary if needed.
+  TokenId AddToken(std::string && token);
+  void InsertToIndex(TokenIds tokenIds, DocId docId);
+  // Sorts the DocIds of every node by the types of the docs and by the ids.
+  void PartitionDocIdsByTypes();
+
+  // Adds address information of the hierarchy entries to the index.
+  // Names are tokenized concurrently in |loadThreadsCount| threads.
+  void AddEntries(unsigned int loadThreadsCount);
+
+  // Adds the street |e| (which has the id of |docId|) to |shard|,
   // with and without synonyms of the word "street".
-  void AddStreet(DocId const & docId, Doc const & e);
+  void AddStreet(DocId const & docId, Doc const & e, NamesShard & shard) const;
 
   // Fills the |m_relatedBuildings| field.
   void AddHouses(unsigned int loadThreadsCount);
 
-  std::vector<Doc> const & m_docs;
+  // Counts the estimate of the in-memory containers in the "geocoder_index" memory tag,
+  // the mapped sections are not counted.
+  void UpdateMemory();
+
   Hierarchy const & m_hierarchy;
 
-  std::unordered_map<std::string, std::vector<DocId>> m_docIdsByTokens;
+  // Vocabulary: m_tokens[tokenId] is the token with |tokenId|.
+  std::vector<std::string> m_tokens;
+  std::unordered_map<std::string, TokenId> m_tokenIds;
+  // The vocabulary for the lookup with misprints and by prefixes. It is built on load for both
+  // the regular and the mapped index.
+  TokenTrie m_tokensTrie;
+
+  // The trie over sorted token ids of the indexed names.
+  // Keys are built with MakeEdgeKey(), values are child nodes.
+  std::unordered_map<uint64_t, NodeId> m_trieEdges;
+  // DocIds of the docs whose names end in the node sorted by the types of the docs
+  // and by the ids.
+  std::vector<std::vector<DocId>> m_docIdsByNodes;
 
   // Lists of houses grouped by the streets/localities they belong to.
   std::unordered_map<DocId, std::vector<DocId>> m_relatedBuildings;
+
+  // House number parses by the name dictionary positions of the house numbers.
+  // They are derived from the hierarchy names and are not serialized.
+  std::unordered_map<NameDictionary::Position, HouseNumberParses> m_houseNumberParses;
+  // The buildings of the streets/localities with many buildings sorted by the first tokens of
+  // their house number parses, the buildings with several parses are repeated for every distinct
+  // first token. Like the parses, the records are built on load for both kinds of the index.
+  std::unordered_map<DocId, std::vector<HouseNumberRecord>> m_houseNumbersByRelations;
+
+  // Sections of the mapped index, the containers above are empty when |m_isMapped| is set.
+  bool m_isMapped = false;
+  FilesMappingContainer::Handle m_mappedTokensBlob;
+  FilesMappingContainer::Handle m_mappedTokens;
+  FilesMappingContainer::Handle m_mappedTrieEdges;
+  // m_mappedPostingsOffsets[node * kTypesCount + type] is the byte offset of the packed DocIds
+  // of the docs of |type| of |node| in |m_mappedPostings|, the array has a sentinel at the end.
+  // The offsets of the empty lists are equal to the next ones.
+  FilesMappingContainer::Handle m_mappedPostingsOffsets;
+  FilesMappingContainer::Handle m_mappedPostings;
+  // m_mappedBuildingsOffsets[docId] is the byte offset of the packed buildings of |docId|
+  // in |m_mappedBuildings| in the same way.
+  FilesMappingContainer::Handle m_mappedBuildingsOffsets;
+  FilesMappingContainer::Handle m_mappedBuildings;
+
+  base::memory::ScopedBytes m_memory{base::memory::GetTag("geocoder_index")};
 };
 }  // namespace geocoder
 
@@ -7,6 +7,8 @@
 #include <limits>
 #include <utility>
 
+#include <boost/functional/hash.hpp>
+
 namespace geocoder
 {
 // MultipleName ------------------------------------------------------------------------------------
@@ -58,43 +60,154 @@ bool operator!=(MultipleNames const & lhs, MultipleNames const & rhs) noexcept
 }
 
 // NameDictionary ----------------------------------------------------------------------------------
-MultipleNames const & NameDictionary::Get(Position position) const
+// static
+NameDictionary::Position constexpr NameDictionary::kUnspecifiedPosition;
+
+MultipleNamesView NameDictionary::Get(Position position) const
 {
   CHECK_GREATER(position, 0, ());
-  CHECK_LESS_OR_EQUAL(position, m_stock.size(), ());
-  return m_stock[position - 1];
+  CHECK_LESS_OR_EQUAL(position, m_listEnds.size(), ());
+  auto const begin = position == 1 ? 0 : m_listEnds[position - 2];
+  return {m_arena.data(), m_names.data() + begin, m_names.data() + m_listEnds[position - 1]};
 }
 
-NameDictionary::Position NameDictionary::Add(MultipleNames && names)
+NameDictionary::Position NameDictionary::Add(MultipleNames const & names)
+{
+  return AddNames(names);
+}
+
+NameDictionary::Position NameDictionary::Add(MultipleNamesView const & names)
+{
+  return AddNames(names);
+}
+
+template <typename Names>
+NameDictionary::Position NameDictionary::AddNames(Names const & names)
 {
   CHECK(!names.GetMainName().empty(), ());
-  CHECK_LESS(m_stock.size(), std::numeric_limits<uint32_t>::max(), ());
-  m_stock.push_back(std::move(names));
-  return static_cast<uint32_t>(m_stock.size());  // index + 1
+  CHECK_LESS(m_listEnds.size(), std::numeric_limits<Position>::max(), ());
+  for (auto const & name : names)
+  {
+    CHECK_LESS_OR_EQUAL(m_arena.size() + name.size(), std::numeric_limits<uint32_t>::max(), ());
+    m_names.push_back({static_cast<uint32_t>(m_arena.size()), static_cast<uint32_t>(name.size())});
+    m_arena.append(name.data(), name.size());
+  }
+  CHECK_LESS_OR_EQUAL(m_names.size(), std::numeric_limits<uint32_t>::max(), ());
+  m_listEnds.push_back(static_cast<uint32_t>(m_names.size()));
+  UpdateMemory();
+  return static_cast<Position>(m_listEnds.size());  // index + 1
 }
 
-// NameDictionaryBuilder::Hash ---------------------------------------------------------------------
-size_t NameDictionaryBuilder::Hash::operator()(MultipleNames const & names) const noexcept
+void NameDictionary::UpdateMemory()
 {
-  return std::hash<std::string>{}(names.GetMainName());
+  m_memory.Set(m_arena.capacity() + m_names.capacity() * sizeof(MultipleNamesView::Span) +
+               m_listEnds.capacity() * sizeof(std::uint32_t));
 }
 
-// NameDictionaryBuilder -----------------------------------------------------------------------------
-NameDictionary::Position NameDictionaryBuilder::Add(MultipleNames && names)
+// NameDictionaryBuilder::PositionsTable -----------------------------------------------------------
+void NameDictionaryBuilder::PositionsTable::Insert(size_t hash, NameDictionary::Position position)
 {
-  auto indexItem = m_index.find(names);
-  if (indexItem != m_index.end())
-    return indexItem->second;
+  CHECK_NOT_EQUAL(position, NameDictionary::kUnspecifiedPosition, ());
+  // The load factor is kept below 1/2.
+  if (2 * (m_size + 1) > m_slots.size())
+  {
+    std::vector<Slot> slots(std::max<size_t>(16, 2 * m_slots.size()));
+    m_slots.swap(slots);
+    m_size = 0;
+    for (auto const & slot : slots)
+    {
+      if (slot.m_position != NameDictionary::kUnspecifiedPosition)
+        Insert(slot.m_hash, slot.m_position);
+    }
+  }
+
+  auto const mask = m_slots.size() - 1;
+  auto i = hash & mask;
+  while (m_slots[i].m_position != NameDictionary::kUnspecifiedPosition)
+    i = (i + 1) & mask;
+  m_slots[i] = {hash, position};
+  ++m_size;
+}
 
-  auto p = m_dictionary.Add(std::move(names));
-  auto indexEmplace = m_index.emplace(m_dictionary.Get(p), p);
-  CHECK(indexEmplace.second, ());
-  return p;
+// NameDictionaryBuilder -----------------------------------------------------------------------------
+// static
+size_t constexpr NameDictionaryBuilder::kShardsCount;
+
+NameDictionary::Position NameDictionaryBuilder::Add(MultipleNames const & names)
+{
+  size_t hash = 0;
+  for (auto const & name : names)
+    hash = hash * 31 + std::hash<std::string>{}(name);
+
+  // The shard is chosen by the bits of the hash which are not used by the table of the shard.
+  auto & shard = m_shards[hash % kShardsCount];
+  hash /= kShardsCount;
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+  auto const isEqual = [&shard, &names](NameDictionary::Position position) {
+    auto const view = shard.m_dictionary.Get(position);
+    return view.size() == names.GetNames().size() &&
+           std::equal(view.begin(), view.end(), names.begin());
+  };
+  if (auto const position = shard.m_index.Find(hash, isEqual))
+    return shard.m_positions[position - 1];
+
+  shard.m_index.Insert(hash, shard.m_dictionary.Add(names));
+  auto const position = ++m_size;
+  shard.m_positions.push_back(position);
+  return position;
 }
 
 NameDictionary NameDictionaryBuilder::Release()
 {
-  m_index.clear();
-  return std::move(m_dictionary);
+  // The shard and the position in the shard of every position of the dictionary.
+  std::vector<std::pair<Shard const *, NameDictionary::Position>> lists(m_size);
+  for (auto const & shard : m_shards)
+  {
+    for (size_t i = 0; i < shard.m_positions.size(); ++i)
+      lists[shard.m_positions[i] - 1] = {&shard, static_cast<NameDictionary::Position>(i + 1)};
+  }
+
+  NameDictionary dictionary;
+  dictionary.Reserve(lists.size());
+  // The first spans of the distinct names in |dictionary.m_names|, by the hashes of the names.
+  PositionsTable names;
+  for (auto const & list : lists)
+  {
+    for (auto const & name : list.first->m_dictionary.Get(list.second))
+    {
+      auto const hash = boost::hash_range(name.begin(), name.end());
+      auto const existing = names.Find(hash, [&dictionary, &name](NameDictionary::Position i) {
+        auto const & span = dictionary.m_names[i - 1];
+        return name == boost::string_view(dictionary.m_arena.data() + span.m_offset, span.m_size);
+      });
+      if (existing != NameDictionary::kUnspecifiedPosition)
+      {
+        dictionary.m_names.push_back(dictionary.m_names[existing - 1]);
+        continue;
+      }
+
+      CHECK_LESS_OR_EQUAL(dictionary.m_arena.size() + name.size(),
+                          std::numeric_limits<uint32_t>::max(), ());
+      dictionary.m_names.push_back({static_cast<uint32_t>(dictionary.m_arena.size()),
+                                    static_cast<uint32_t>(name.size())});
+      dictionary.m_arena.append(name.data(), name.size());
+      names.Insert(hash, static_cast<NameDictionary::Position>(dictionary.m_names.size()));
+    }
+    dictionary.m_listEnds.push_back(static_cast<uint32_t>(dictionary.m_names.size()));
+  }
+
+  for (auto & shard : m_shards)
+  {
+    shard.m_dictionary = {};
+    shard.m_positions.clear();
+    shard.m_index = {};
+  }
+  m_size = 0;
+
+  dictionary.m_arena.shrink_to_fit();
+  dictionary.m_names.shrink_to_fit();
+  dictionary.UpdateMemory();
+  return dictionary;
 }
 }  // namespace geocoder
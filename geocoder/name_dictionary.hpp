@@ -2,16 +2,25 @@
 
 #include "geocoder/types.hpp"
 
+#include "coding/read_write_utils.hpp"
+#include "coding/varint.hpp"
+
 #include "base/assert.hpp"
+#include "base/memory_accounting.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/version.hpp>
+#include <boost/utility/string_view.hpp>
 
 namespace geocoder
 {
@@ -22,13 +31,6 @@ public:
 
   explicit MultipleNames(std::string const & mainName = {});
 
-  template<class Archive>
-  void serialize(Archive & ar, const unsigned int version)
-  {
-    CHECK_EQUAL(version, kIndexFormatVersion, ());
-    ar & m_names;
-  }
-
   std::string const & GetMainName() const noexcept;
   std::vector<std::string> const & GetNames() const noexcept;
 
@@ -46,6 +48,70 @@ private:
   std::vector<std::string> m_names;
 };
 
+// The names of a position of NameDictionary, the main name goes first. The view is valid
+// while the dictionary is not modified.
+class MultipleNamesView
+{
+public:
+  // A name in the arena of the dictionary.
+  struct Span
+  {
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int /* version */)
+    {
+      ar & m_offset;
+      ar & m_size;
+    }
+
+    std::uint32_t m_offset = 0;
+    std::uint32_t m_size = 0;
+  };
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = boost::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = boost::string_view;
+
+    const_iterator(char const * arena, Span const * span) : m_arena(arena), m_span(span) {}
+
+    boost::string_view operator*() const { return {m_arena + m_span->m_offset, m_span->m_size}; }
+    const_iterator & operator++()
+    {
+      ++m_span;
+      return *this;
+    }
+
+    bool operator==(const_iterator const & rhs) const { return m_span == rhs.m_span; }
+    bool operator!=(const_iterator const & rhs) const { return m_span != rhs.m_span; }
+
+  private:
+    char const * m_arena;
+    Span const * m_span;
+  };
+
+  MultipleNamesView(char const * arena, Span const * begin, Span const * end)
+    : m_arena(arena), m_begin(begin), m_end(end)
+  {
+  }
+
+  boost::string_view GetMainName() const noexcept { return *begin(); }
+  size_t size() const noexcept { return static_cast<size_t>(m_end - m_begin); }
+
+  const_iterator begin() const noexcept { return {m_arena, m_begin}; }
+  const_iterator end() const noexcept { return {m_arena, m_end}; }
+
+private:
+  char const * m_arena;
+  Span const * m_begin;
+  Span const * m_end;
+};
+
+// The name lists are pooled: the characters of all the names are kept in one arena and
+// every list is a range of the spans of its names in the arena.
 class NameDictionary
 {
 public:
@@ -65,16 +131,81 @@ public:
   void serialize(Archive & ar, const unsigned int version)
   {
     CHECK_EQUAL(version, kIndexFormatVersion, ());
-    ar & m_stock;
+    ar & m_arena;
+    ar & m_names;
+    ar & m_listEnds;
+    UpdateMemory();
+  }
+
+  // The pooled representation is written as is, so the interned names stay interned.
+  template <typename Sink>
+  void Write(Sink & sink) const
+  {
+    rw::Write(sink, m_arena);
+    WriteVarUint(sink, m_names.size());
+    for (auto const & name : m_names)
+    {
+      WriteVarUint(sink, name.m_offset);
+      WriteVarUint(sink, name.m_size);
+    }
+    WriteVarUint(sink, m_listEnds.size());
+    for (auto const end : m_listEnds)
+      WriteVarUint(sink, end);
+  }
+
+  template <typename Source>
+  void Read(Source & source)
+  {
+    rw::Read(source, m_arena);
+    m_names.resize(static_cast<size_t>(ReadVarUint<uint64_t>(source)));
+    for (auto & name : m_names)
+    {
+      name.m_offset = ReadVarUint<uint32_t>(source);
+      name.m_size = ReadVarUint<uint32_t>(source);
+      CHECK_LESS_OR_EQUAL(uint64_t{name.m_offset} + name.m_size, m_arena.size(), ());
+    }
+    m_listEnds.resize(static_cast<size_t>(ReadVarUint<uint64_t>(source)));
+    uint32_t begin = 0;
+    for (auto & end : m_listEnds)
+    {
+      end = ReadVarUint<uint32_t>(source);
+      CHECK_LESS(begin, end, ());
+      CHECK_LESS_OR_EQUAL(end, m_names.size(), ());
+      begin = end;
+    }
+    UpdateMemory();
   }
 
-  MultipleNames const & Get(Position position) const;
-  Position Add(MultipleNames && s);
+  MultipleNamesView Get(Position position) const;
+  // Appends the names, the names are not interned.
+  Position Add(MultipleNames const & names);
+  Position Add(MultipleNamesView const & names);
+
+  // The positions are 1, ..., GetSize().
+  size_t GetSize() const noexcept { return m_listEnds.size(); }
+  void Reserve(size_t size) { m_listEnds.reserve(size); }
 
 private:
-  std::vector<MultipleNames> m_stock;
+  friend class NameDictionaryBuilder;
+
+  template <typename Names>
+  Position AddNames(Names const & names);
+
+  // Counts the capacities of the containers in the "name_dictionary" memory tag.
+  void UpdateMemory();
+
+  std::string m_arena;
+  // The names of the lists one after another.
+  std::vector<MultipleNamesView::Span> m_names;
+  // The end of the names of every list in |m_names|, the list begins at the end of the previous.
+  std::vector<std::uint32_t> m_listEnds;
+  base::memory::ScopedBytes m_memory{base::memory::GetTag("name_dictionary")};
 };
 
+// Collects the unique name lists for NameDictionary. Add() may be called from several threads
+// at once: the lists are sharded by their hashes and every shard has its own lock and its own
+// arena. Release() joins the shards to one arena, the equal names of the different lists are
+// stored once there.
 class NameDictionaryBuilder
 {
 public:
@@ -82,19 +213,61 @@ public:
   NameDictionaryBuilder(NameDictionaryBuilder const &) = delete;
   NameDictionaryBuilder & operator=(NameDictionaryBuilder const &) = delete;
 
-  NameDictionary::Position Add(MultipleNames && s);
+  // Returns the position of |names| in the dictionary to be released. The new lists get
+  // the consecutive positions in the order of their addition.
+  NameDictionary::Position Add(MultipleNames const & names);
+  // Must not be called concurrently with Add().
   NameDictionary Release();
 
 private:
-  struct Hash
+  // An open addressing hash table of the positions, the keys are compared by the callers.
+  class PositionsTable
+  {
+  public:
+    template <typename Equal>
+    NameDictionary::Position Find(size_t hash, Equal && equal) const
+    {
+      if (m_slots.empty())
+        return NameDictionary::kUnspecifiedPosition;
+
+      auto const mask = m_slots.size() - 1;
+      for (auto i = hash & mask;; i = (i + 1) & mask)
+      {
+        auto const & slot = m_slots[i];
+        if (slot.m_position == NameDictionary::kUnspecifiedPosition)
+          return NameDictionary::kUnspecifiedPosition;
+        if (slot.m_hash == hash && equal(slot.m_position))
+          return slot.m_position;
+      }
+    }
+
+    void Insert(size_t hash, NameDictionary::Position position);
+
+  private:
+    struct Slot
+    {
+      size_t m_hash = 0;
+      NameDictionary::Position m_position = NameDictionary::kUnspecifiedPosition;
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+  };
+
+  struct Shard
   {
-    size_t operator()(MultipleNames const & names) const noexcept;
+    std::mutex m_mutex;
+    NameDictionary m_dictionary;
+    // The positions in the released dictionary of the lists of |m_dictionary|.
+    std::vector<NameDictionary::Position> m_positions;
+    PositionsTable m_index;
   };
 
-  NameDictionary m_dictionary;
-  std::unordered_map<MultipleNames, NameDictionary::Position, Hash> m_index;
+  static size_t constexpr kShardsCount = 32;
+
+  std::array<Shard, kShardsCount> m_shards;
+  std::atomic<NameDictionary::Position> m_size{0};
 };
 }  // namespace geocoder
 
-BOOST_CLASS_VERSION(geocoder::MultipleNames, geocoder::kIndexFormatVersion)
 BOOST_CLASS_VERSION(geocoder::NameDictionary, geocoder::kIndexFormatVersion)
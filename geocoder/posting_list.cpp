@@ -0,0 +1,82 @@
+#include "geocoder/posting_list.hpp"
+
+#include <algorithm>
+
+namespace geocoder
+{
+PostingListReader::PostingListReader(uint8_t const * data)
+{
+  ArrayByteSource source(data);
+  m_size = static_cast<size_t>(ReadVarUint<uint64_t>(source));
+  m_skips = source.PtrUC();
+  auto const blocksCount = GetBlocksCount();
+  m_blocks = m_skips + (blocksCount == 0 ? 0 : (blocksCount - 1) * 2 * sizeof(uint32_t));
+  if (m_size != 0)
+    StartBlock(0);
+}
+
+void PostingListReader::Next()
+{
+  ASSERT(!IsEnd(), ());
+  ++m_index;
+  if (m_index == m_size)
+    return;
+
+  if (m_index == m_blockEnd)
+  {
+    StartBlock(m_block + 1);
+    return;
+  }
+
+  m_current += ReadVarUint<uint32_t>(m_source);
+}
+
+void PostingListReader::SkipTo(uint32_t id)
+{
+  if (IsEnd() || id <= m_current)
+    return;
+
+  // The last block whose first id is not greater than |id| is searched for after the current
+  // one by the steps doubling until a greater first id and by the binary search then.
+  auto const blocksCount = GetBlocksCount();
+  auto lo = m_block;
+  size_t step = 1;
+  while (lo + step < blocksCount && GetBlockFirstId(lo + step) <= id)
+  {
+    lo += step;
+    step *= 2;
+  }
+  auto hi = std::min(lo + step, blocksCount);
+  while (lo + 1 < hi)
+  {
+    auto const mid = lo + (hi - lo) / 2;
+    if (GetBlockFirstId(mid) <= id)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  if (lo != m_block)
+    StartBlock(lo);
+
+  while (!IsEnd() && m_current < id)
+    Next();
+}
+
+void PostingListReader::StartBlock(size_t block)
+{
+  ASSERT_LESS(block, GetBlocksCount(), ());
+  m_block = block;
+  m_index = block * kPostingsBlockSize;
+  m_blockEnd = std::min(m_index + kPostingsBlockSize, m_size);
+  if (block == 0)
+  {
+    m_source = ArrayByteSource(m_blocks);
+    m_current = ReadVarUint<uint32_t>(m_source);
+    return;
+  }
+
+  m_source = ArrayByteSource(m_blocks + ReadSkip(block, 1));
+  m_current = GetBlockFirstId(block);
+}
+}  // namespace geocoder
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "coding/byte_stream.hpp"
+#include "coding/varint.hpp"
+#include "coding/write_to_sink.hpp"
+
+#include "base/assert.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace geocoder
+{
+// Sorted lists of doc ids of the mapped index packed in blocks of kPostingsBlockSize ids.
+// A list is:
+//   varuint: the number of the ids;
+//   the skip records of all the blocks but the first one, two uint32 each: the first id of the
+//   block and the offset of the block from the end of the skip records;
+//   the blocks: varuint-coded gaps between the consecutive ids, the first id of the first block
+//   is coded as the gap from zero and the first ids of the other blocks are not coded at all.
+// The skip records let PostingListReader::SkipTo() jump over the blocks without decoding them.
+size_t constexpr kPostingsBlockSize = 128;
+
+// Appends the packed list of strictly increasing |ids| to |buffer|.
+template <typename Ids>
+void PackPostingList(Ids const & ids, std::vector<uint8_t> & buffer)
+{
+  PushBackByteSink<std::vector<uint8_t>> sink(buffer);
+  WriteVarUint(sink, static_cast<uint64_t>(ids.size()));
+
+  std::vector<uint8_t> blocks;
+  PushBackByteSink<std::vector<uint8_t>> blocksSink(blocks);
+  uint64_t prev = 0;
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    auto const id = static_cast<uint64_t>(ids[i]);
+    CHECK_LESS_OR_EQUAL(id, std::numeric_limits<uint32_t>::max(), ());
+    CHECK(i == 0 || prev < id, ("The ids must be strictly increasing.", prev, id));
+    if (i != 0 && i % kPostingsBlockSize == 0)
+    {
+      CHECK_LESS_OR_EQUAL(blocks.size(), std::numeric_limits<uint32_t>::max(), ());
+      WriteToSink(sink, static_cast<uint32_t>(id));
+      WriteToSink(sink, static_cast<uint32_t>(blocks.size()));
+    }
+    else
+    {
+      WriteVarUint(blocksSink, id - prev);
+    }
+    prev = id;
+  }
+  buffer.insert(buffer.end(), blocks.begin(), blocks.end());
+}
+
+// A cursor over a packed posting list.
+class PostingListReader
+{
+public:
+  // An empty list.
+  PostingListReader() = default;
+  explicit PostingListReader(uint8_t const * data);
+
+  size_t Size() const { return m_size; }
+  bool IsEnd() const { return m_index >= m_size; }
+  uint32_t Get() const
+  {
+    ASSERT(!IsEnd(), ());
+    return m_current;
+  }
+  void Next();
+  // Moves to the first id which is not less than |id|. The blocks are found by the galloping
+  // search over the skip records.
+  void SkipTo(uint32_t id);
+
+private:
+  size_t GetBlocksCount() const { return (m_size + kPostingsBlockSize - 1) / kPostingsBlockSize; }
+  // The first id of |block| which is not the first block.
+  uint32_t GetBlockFirstId(size_t block) const { return ReadSkip(block, 0); }
+  uint32_t ReadSkip(size_t block, size_t field) const
+  {
+    uint32_t value = 0;
+    std::memcpy(&value, m_skips + ((block - 1) * 2 + field) * sizeof(uint32_t), sizeof(value));
+    return SwapIfBigEndianMacroBased(value);
+  }
+  void StartBlock(size_t block);
+
+  uint8_t const * m_skips = nullptr;
+  uint8_t const * m_blocks = nullptr;
+  size_t m_size = 0;
+  // The index of the current id in the list and the end of its block.
+  size_t m_index = 0;
+  size_t m_blockEnd = 0;
+  size_t m_block = 0;
+  ArrayByteSource m_source{nullptr};
+  uint32_t m_current = 0;
+};
+
+// Calls |fn| for the ids which are in both lists in the increasing order. The lists are
+// leapfrogged by SkipTo(), so a short list is intersected with a long one in the time of
+// the short one.
+template <typename Fn>
+void ForEachCommonId(PostingListReader lhs, PostingListReader rhs, Fn && fn)
+{
+  while (!lhs.IsEnd() && !rhs.IsEnd())
+  {
+    if (lhs.Get() < rhs.Get())
+    {
+      lhs.SkipTo(rhs.Get());
+    }
+    else if (rhs.Get() < lhs.Get())
+    {
+      rhs.SkipTo(lhs.Get());
+    }
+    else
+    {
+      fn(lhs.Get());
+      lhs.Next();
+      rhs.Next();
+    }
+  }
+}
+}  // namespace geocoder
@@ -0,0 +1,298 @@
+#include "geocoder/query_server.hpp"
+
+#include "coding/json.hpp"
+
+#include "base/assert.hpp"
+#include "base/logging.hpp"
+#include "base/stl_helpers.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "3party/rapidjson/stringbuffer.h"
+
+using namespace std;
+
+namespace geocoder
+{
+namespace
+{
+// The answers of a session which wait for being written. The session stops reading the queries
+// when a client does not read the answers.
+size_t const kMaxPendingAnswers = 1024;
+
+string SerializeId(uint64_t id)
+{
+  ostringstream s;
+  s << setw(16) << setfill('0') << hex << uppercase << id;
+  return s.str();
+}
+
+// Writes all of |data| or nothing when the connection is closed.
+void WriteAll(int fd, string const & data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    auto const n = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return;
+    written += static_cast<size_t>(n);
+  }
+}
+}  // namespace
+
+QueryServer::QueryServer(Geocoder const & geocoder, unsigned int workersCount)
+  : m_geocoder(geocoder)
+{
+  CHECK_GREATER_OR_EQUAL(workersCount, 1, ());
+  m_workers.reserve(workersCount);
+  for (unsigned int i = 0; i < workersCount; ++i)
+    m_workers.emplace_back(&QueryServer::ProcessTasks, this);
+}
+
+QueryServer::~QueryServer()
+{
+  {
+    lock_guard<mutex> lock(m_tasksMutex);
+    m_finished = true;
+  }
+  m_tasksCv.notify_all();
+  for (auto & worker : m_workers)
+    worker.join();
+}
+
+void QueryServer::Serve(istream & in, ostream & out)
+{
+  ServeLines([&in](string & line) { return static_cast<bool>(getline(in, line)); },
+             [&out](string const & line) { out << line << endl; });
+}
+
+void QueryServer::ServeUnixSocket(string const & path)
+{
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path))
+    MYTHROW(Geocoder::OpenException, ("Too long socket path", path));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  auto const listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+    MYTHROW(Geocoder::OpenException, ("Can't create socket:", strerror(errno)));
+
+  unlink(path.c_str());
+  if (bind(listenFd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0 ||
+      listen(listenFd, SOMAXCONN) != 0)
+  {
+    auto const error = errno;
+    close(listenFd);
+    MYTHROW(Geocoder::OpenException, ("Can't listen to", path, ":", strerror(error)));
+  }
+
+  {
+    lock_guard<mutex> lock(m_connectionsMutex);
+    m_listenFd = listenFd;
+  }
+  LOG(LINFO, ("Serving queries at", path));
+
+  vector<thread> connections;
+  while (!m_stopped)
+  {
+    auto const fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (!m_stopped)
+        LOG(LERROR, ("Can't accept connection:", strerror(errno)));
+      break;
+    }
+
+    lock_guard<mutex> lock(m_connectionsMutex);
+    if (m_stopped)
+    {
+      close(fd);
+      break;
+    }
+    m_connectionFds.push_back(fd);
+    connections.emplace_back(&QueryServer::ServeConnection, this, fd);
+  }
+
+  for (auto & connection : connections)
+    connection.join();
+
+  {
+    lock_guard<mutex> lock(m_connectionsMutex);
+    m_listenFd = -1;
+  }
+  close(listenFd);
+  unlink(path.c_str());
+}
+
+void QueryServer::Stop()
+{
+  m_stopped = true;
+
+  // Blocked accept() and recv() return on shutdown.
+  lock_guard<mutex> lock(m_connectionsMutex);
+  if (m_listenFd >= 0)
+    shutdown(m_listenFd, SHUT_RDWR);
+  for (auto const fd : m_connectionFds)
+    shutdown(fd, SHUT_RDWR);
+}
+
+// static
+string QueryServer::FormatAnswer(string const & query, vector<Result> const & results)
+{
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("query");
+  writer.String(query.data(), static_cast<rapidjson::SizeType>(query.size()));
+  writer.Key("results");
+  writer.StartArray();
+  for (auto const & result : results)
+  {
+    writer.StartObject();
+    writer.Key("id");
+    writer.String(SerializeId(result.m_osmId.GetEncodedId()));
+    writer.Key("certainty");
+    writer.Double(result.m_certainty);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+future<string> QueryServer::Submit(string const & query)
+{
+  future<string> answer;
+  {
+    lock_guard<mutex> lock(m_tasksMutex);
+    m_tasks.push_back({query, {}});
+    answer = m_tasks.back().m_answer.get_future();
+  }
+  m_tasksCv.notify_one();
+  return answer;
+}
+
+void QueryServer::ProcessTasks()
+{
+  Geocoder::Context ctx;
+  vector<Result> results;
+  while (true)
+  {
+    Task task;
+    {
+      unique_lock<mutex> lock(m_tasksMutex);
+      m_tasksCv.wait(lock, [this] { return m_finished || !m_tasks.empty(); });
+      if (m_tasks.empty())
+        return;
+      task = move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+
+    try
+    {
+      m_geocoder.ProcessQuery(ctx, task.m_query, results);
+    }
+    catch (exception const & e)
+    {
+      LOG(LERROR, ("Can't process query", task.m_query, ":", e.what()));
+      results.clear();
+    }
+    task.m_answer.set_value(FormatAnswer(task.m_query, results));
+  }
+}
+
+void QueryServer::ServeLines(ReadLineFn const & readLine, WriteLineFn const & writeLine)
+{
+  mutex answersMutex;
+  condition_variable answersCv;
+  deque<future<string>> answers;
+  bool allRead = false;
+
+  // The answers are written as soon as they are ready, not when the next query is read.
+  thread writer([&] {
+    while (true)
+    {
+      future<string> answer;
+      {
+        unique_lock<mutex> lock(answersMutex);
+        answersCv.wait(lock, [&] { return allRead || !answers.empty(); });
+        if (answers.empty())
+          return;
+        answer = move(answers.front());
+        answers.pop_front();
+      }
+      answersCv.notify_all();
+      writeLine(answer.get());
+    }
+  });
+
+  string query;
+  while (readLine(query))
+  {
+    {
+      unique_lock<mutex> lock(answersMutex);
+      answersCv.wait(lock, [&] { return answers.size() < kMaxPendingAnswers; });
+      answers.push_back(Submit(query));
+    }
+    answersCv.notify_all();
+  }
+
+  {
+    lock_guard<mutex> lock(answersMutex);
+    allRead = true;
+  }
+  answersCv.notify_all();
+  writer.join();
+}
+
+void QueryServer::ServeConnection(int fd)
+{
+  string buffer;
+  size_t lineBegin = 0;
+  auto const readLine = [&](string & line) {
+    while (true)
+    {
+      auto const lineEnd = buffer.find('\n', lineBegin);
+      if (lineEnd != string::npos)
+      {
+        line.assign(buffer, lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 1;
+        return true;
+      }
+
+      buffer.erase(0, lineBegin);
+      lineBegin = 0;
+      char chunk[4096];
+      auto const n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      buffer.append(chunk, static_cast<size_t>(n));
+    }
+  };
+
+  ServeLines(readLine, [fd](string const & line) { WriteAll(fd, line + '\n'); });
+
+  {
+    lock_guard<mutex> lock(m_connectionsMutex);
+    base::EraseIf(m_connectionFds, [fd](int connectionFd) { return connectionFd == fd; });
+  }
+  close(fd);
+}
+}  // namespace geocoder
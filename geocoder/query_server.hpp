@@ -0,0 +1,71 @@
+#pragma once
+
+#include "geocoder/geocoder.hpp"
+#include "geocoder/result.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace geocoder
+{
+// Serves the queries to a loaded geocoder so that the geocoder is loaded once for any number
+// of query sessions. Every line of the input is a query, it is answered by a line of json
+//   {"query": "<query>", "results": [{"id": "<encoded osm id>", "certainty": <certainty>}, ...]}
+// in the order of the queries. The queries of all the sessions are processed by a pool of
+// workers, every worker reuses its own Geocoder::Context.
+class QueryServer
+{
+public:
+  QueryServer(Geocoder const & geocoder, unsigned int workersCount);
+  ~QueryServer();
+
+  // Answers the queries of |in| until its end.
+  void Serve(std::istream & in, std::ostream & out);
+
+  // Listens to the Unix domain socket |path| and serves every connection like Serve() until
+  // Stop() is called. An existing file at |path| is replaced. Throws Geocoder::Exception when
+  // the socket can't be listened to.
+  void ServeUnixSocket(std::string const & path);
+  // Makes ServeUnixSocket() return, may be called from any thread.
+  void Stop();
+
+  static std::string FormatAnswer(std::string const & query, std::vector<Result> const & results);
+
+private:
+  struct Task
+  {
+    std::string m_query;
+    std::promise<std::string> m_answer;
+  };
+
+  using ReadLineFn = std::function<bool(std::string & line)>;
+  using WriteLineFn = std::function<void(std::string const & line)>;
+
+  std::future<std::string> Submit(std::string const & query);
+  void ProcessTasks();
+  // Writes the answers in the order of the queries while the next queries are read.
+  void ServeLines(ReadLineFn const & readLine, WriteLineFn const & writeLine);
+  void ServeConnection(int fd);
+
+  Geocoder const & m_geocoder;
+
+  std::mutex m_tasksMutex;
+  std::condition_variable m_tasksCv;
+  std::deque<Task> m_tasks;
+  bool m_finished = false;
+  std::vector<std::thread> m_workers;
+
+  std::atomic<bool> m_stopped{false};
+  std::mutex m_connectionsMutex;
+  int m_listenFd = -1;
+  std::vector<int> m_connectionFds;
+};
+}  // namespace geocoder
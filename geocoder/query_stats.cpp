@@ -0,0 +1,45 @@
+#include "geocoder/query_stats.hpp"
+
+#include <sstream>
+
+using namespace std;
+
+namespace geocoder
+{
+QueryStats & QueryStats::operator+=(QueryStats const & rhs)
+{
+  m_queries += rhs.m_queries;
+  m_cacheHits += rhs.m_cacheHits;
+  m_anchoredQueries += rhs.m_anchoredQueries;
+  for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
+  {
+    m_subqueries[i] += rhs.m_subqueries[i];
+    m_layers[i] += rhs.m_layers[i];
+    m_candidates[i] += rhs.m_candidates[i];
+    m_fillLayerTimeNs[i] += rhs.m_fillLayerTimeNs[i];
+    m_prunedBranches[i] += rhs.m_prunedBranches[i];
+  }
+  m_houseNumberMatches += rhs.m_houseNumberMatches;
+  m_beamInsertions += rhs.m_beamInsertions;
+  m_totalTimeNs += rhs.m_totalTimeNs;
+  return *this;
+}
+
+string DebugPrint(QueryStats const & stats)
+{
+  ostringstream oss;
+  oss << "queries: " << stats.m_queries << ", cache hits: " << stats.m_cacheHits
+      << ", anchored queries: " << stats.m_anchoredQueries
+      << ", total time: " << stats.m_totalTimeNs / 1e6 << " ms"
+      << ", house number matches: " << stats.m_houseNumberMatches
+      << ", beam insertions: " << stats.m_beamInsertions << "\n";
+  for (size_t i = 0; i < static_cast<size_t>(Type::Count); ++i)
+  {
+    oss << "  " << ToString(static_cast<Type>(i)) << ": subqueries: " << stats.m_subqueries[i]
+        << ", layers: " << stats.m_layers[i] << ", candidates: " << stats.m_candidates[i]
+        << ", fill time: " << stats.m_fillLayerTimeNs[i] / 1e6 << " ms"
+        << ", pruned branches: " << stats.m_prunedBranches[i] << "\n";
+  }
+  return oss.str();
+}
+}  // namespace geocoder
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geocoder/types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Statistics are collected only when GEOCODER_QUERY_STATS is defined,
+// otherwise the UPDATE_QUERY_STATS statements are compiled out.
+#if defined(GEOCODER_QUERY_STATS)
+#define UPDATE_QUERY_STATS(statsPtr, fn)     \
+  do                                         \
+  {                                          \
+    if (auto * statsToUpdate = (statsPtr))   \
+      fn(*statsToUpdate);                    \
+  } while (false)
+#else
+#define UPDATE_QUERY_STATS(statsPtr, fn) \
+  do                                     \
+  {                                      \
+  } while (false)
+#endif
+
+namespace geocoder
+{
+// Counters and timers of a single geocoder query (or the sum for a number of queries).
+// Arrays are indexed by Type of the hierarchy level.
+struct QueryStats
+{
+  using Counters = std::array<uint64_t, static_cast<size_t>(Type::Count)>;
+
+  QueryStats & operator+=(QueryStats const & rhs);
+
+  uint64_t m_queries = 0;
+  // Queries answered from the result cache, see Geocoder::EnableResultCache().
+  uint64_t m_cacheHits = 0;
+  // Queries processed with the anchored pass, see Geocoder::SetQueryPlanning().
+  uint64_t m_anchoredQueries = 0;
+
+  // Subqueries (sequences of consecutive unused tokens) looked up on every level.
+  Counters m_subqueries{};
+  // Nonempty layers and candidates in them.
+  Counters m_layers{};
+  Counters m_candidates{};
+  // Time of filling the layers, in nanoseconds.
+  Counters m_fillLayerTimeNs{};
+  // Branches of the search skipped on every level since their results can't get to the beam.
+  Counters m_prunedBranches{};
+
+  // Calls of the house number matcher for the related buildings.
+  uint64_t m_houseNumberMatches = 0;
+  uint64_t m_beamInsertions = 0;
+
+  // Total time of the queries processing, in nanoseconds.
+  uint64_t m_totalTimeNs = 0;
+};
+
+std::string DebugPrint(QueryStats const & stats);
+}  // namespace geocoder
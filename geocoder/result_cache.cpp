@@ -0,0 +1,101 @@
+#include "geocoder/result_cache.hpp"
+
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+using namespace std;
+
+namespace geocoder
+{
+// static
+size_t constexpr ResultCache::kShardsCount;
+
+ResultCache::ResultCache(uint32_t logCacheSize)
+{
+  static_assert((kShardsCount & (kShardsCount - 1)) == 0, "");
+  uint32_t logShardsCount = 0;
+  while ((size_t{1} << logShardsCount) < kShardsCount)
+    ++logShardsCount;
+
+  // base::Cache needs at least two slots.
+  auto const logShardSize = max<uint32_t>(logCacheSize, logShardsCount + 1) - logShardsCount;
+  for (auto & shard : m_shards)
+    shard.m_cache.Init(logShardSize);
+}
+
+bool ResultCache::Get(Tokens const & tokens, bool lastTokenIsPrefix, vector<Result> & results)
+{
+  ++m_accesses;
+  if (tokens.empty())
+    return false;
+
+  auto const hash = Hash(tokens, lastTokenIsPrefix);
+  auto & shard = m_shards[hash % kShardsCount];
+
+  lock_guard<mutex> lock(shard.m_mutex);
+  bool found = false;
+  auto & value = shard.m_cache.Find(hash, found);
+  if (!found || !value.m_valid || value.m_tokens != tokens ||
+      value.m_lastTokenIsPrefix != lastTokenIsPrefix)
+  {
+    // Find() has taken the slot for |hash|, the previous value must not be returned for it.
+    if (!found)
+      value.m_valid = false;
+    return false;
+  }
+
+  results = value.m_results;
+  ++m_hits;
+  return true;
+}
+
+void ResultCache::Put(Tokens const & tokens, bool lastTokenIsPrefix,
+                      vector<Result> const & results)
+{
+  if (tokens.empty())
+    return;
+
+  auto const hash = Hash(tokens, lastTokenIsPrefix);
+  auto & shard = m_shards[hash % kShardsCount];
+
+  lock_guard<mutex> lock(shard.m_mutex);
+  bool found = false;
+  auto & value = shard.m_cache.Find(hash, found);
+  value.m_valid = true;
+  value.m_tokens = tokens;
+  value.m_lastTokenIsPrefix = lastTokenIsPrefix;
+  value.m_results = results;
+}
+
+void ResultCache::Clear()
+{
+  for (auto & shard : m_shards)
+  {
+    lock_guard<mutex> lock(shard.m_mutex);
+    shard.m_cache.ForEachValue([](Value & value) { value = Value{}; });
+    shard.m_cache.Reset();
+  }
+  m_accesses = 0;
+  m_hits = 0;
+}
+
+double ResultCache::GetHitRatio() const
+{
+  uint64_t const accesses = m_accesses;
+  if (accesses == 0)
+    return 0.0;
+  return static_cast<double>(m_hits) / static_cast<double>(accesses);
+}
+
+// static
+uint64_t ResultCache::Hash(Tokens const & tokens, bool lastTokenIsPrefix)
+{
+  uint64_t result = tokens.size() * 2 + (lastTokenIsPrefix ? 1 : 0);
+  for (auto const & token : tokens)
+    result = result * 1000003ULL ^ std::hash<string>{}(token);
+  return result;
+}
+}  // namespace geocoder
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geocoder/result.hpp"
+#include "geocoder/types.hpp"
+
+#include "base/cache.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace geocoder
+{
+// A size-bounded thread-safe cache of the geocoder results keyed on the normalized
+// tokens of the queries. The cache is split into shards with their own locks,
+// every shard is a direct-mapped base::Cache: a query evicts the query
+// with the same hash slot.
+class ResultCache
+{
+public:
+  // |logCacheSize| is the log2 of the number of cached queries.
+  explicit ResultCache(uint32_t logCacheSize);
+
+  // Returns false when |tokens| are not cached. The results of the prefix queries, see
+  // Geocoder::ProcessPrefixQuery(), are cached apart from the results of the regular ones.
+  bool Get(Tokens const & tokens, bool lastTokenIsPrefix, std::vector<Result> & results);
+  void Put(Tokens const & tokens, bool lastTokenIsPrefix, std::vector<Result> const & results);
+
+  void Clear();
+
+  uint64_t GetAccessesCount() const { return m_accesses; }
+  uint64_t GetHitsCount() const { return m_hits; }
+  double GetHitRatio() const;
+
+private:
+  static size_t constexpr kShardsCount = 16;
+
+  struct Value
+  {
+    bool m_valid = false;
+    Tokens m_tokens;
+    bool m_lastTokenIsPrefix = false;
+    std::vector<Result> m_results;
+  };
+
+  struct Shard
+  {
+    std::mutex m_mutex;
+    base::Cache<uint64_t, Value> m_cache;
+  };
+
+  static uint64_t Hash(Tokens const & tokens, bool lastTokenIsPrefix);
+
+  std::array<Shard, kShardsCount> m_shards;
+  std::atomic<uint64_t> m_accesses{0};
+  std::atomic<uint64_t> m_hits{0};
+};
+}  // namespace geocoder
@@ -0,0 +1,229 @@
+#include "geocoder/sharded_geocoder.hpp"
+
+#include "geocoder/hierarchy_reader.hpp"
+
+#include "indexer/search_string_utils.hpp"
+
+#include "coding/json.hpp"
+
+#include "base/assert.hpp"
+#include "base/file_name_utils.hpp"
+#include "base/logging.hpp"
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <utility>
+
+using namespace std;
+
+namespace geocoder
+{
+namespace
+{
+// Returns the country of the default locale of the hierarchy jsonl |line| or an empty string.
+string GetCountry(string const & line)
+{
+  auto const p = line.find(' ');
+  if (p == string::npos)
+    return {};
+
+  try
+  {
+    coding::JsonDocument document;
+    document.Parse(line.c_str() + p + 1);
+    if (!document.IsObject())
+      return {};
+
+    auto const & address = coding::GetJsonObligatoryFieldByPath(document, "properties", "locales",
+                                                                "default", "address");
+    string country;
+    coding::FromJsonObjectOptionalField(address, "country", country);
+    return country;
+  }
+  catch (coding::JsonException const & e)
+  {
+    LOG(LDEBUG, ("Can't get the country of entry:", e.Msg(), line));
+  }
+  return {};
+}
+
+string GetShardName(string const & country)
+{
+  if (country.empty())
+    return ShardedGeocoder::kNoCountryShardName;
+
+  auto name = country;
+  replace_if(name.begin(), name.end(), [](char c) { return c == '/' || c == ' '; }, '_');
+  return name;
+}
+
+// Returns true if |name| is a subsequence of consecutive tokens of |tokens|.
+bool ContainsName(Tokens const & tokens, Tokens const & name)
+{
+  if (name.empty())
+    return false;
+  return std::search(tokens.begin(), tokens.end(), name.begin(), name.end()) != tokens.end();
+}
+}  // namespace
+
+// static
+constexpr char const * ShardedGeocoder::kNoCountryShardName;
+// static
+constexpr char const * ShardedGeocoder::kShardExtension;
+
+// static
+vector<string> ShardedGeocoder::BuildShards(string const & pathToJsonHierarchy,
+                                            string const & shardsDir, bool dataVersionHeadline,
+                                            unsigned int loadThreadsCount,
+                                            Hierarchy::NamesFilter const & namesFilter)
+{
+  auto in = HierarchyReader::CreateDataStream(pathToJsonHierarchy);
+  string headline;
+  if (dataVersionHeadline && !getline(*in, headline))
+    MYTHROW(Geocoder::Exception, ("No version info in", pathToJsonHierarchy));
+
+  // Jsonl files of the shards are written side by side with the shards.
+  map<string, ofstream> jsonFiles;
+  string line;
+  while (getline(*in, line))
+  {
+    if (line.empty())
+      continue;
+
+    auto const name = GetShardName(GetCountry(line));
+    auto it = jsonFiles.find(name);
+    if (it == jsonFiles.end())
+    {
+      auto const path = base::JoinPath(shardsDir, name + ".jsonl");
+      it = jsonFiles.emplace(name, ofstream(path)).first;
+      if (!it->second)
+        MYTHROW(Geocoder::OpenException, ("Can't open", path));
+      if (dataVersionHeadline)
+        it->second << headline << '\n';
+    }
+    it->second << line << '\n';
+  }
+
+  vector<string> shards;
+  for (auto & jsonFile : jsonFiles)
+  {
+    jsonFile.second.close();
+    auto const jsonPath = base::JoinPath(shardsDir, jsonFile.first + ".jsonl");
+    auto const path = base::JoinPath(shardsDir, jsonFile.first + kShardExtension);
+
+    Geocoder geocoder;
+    geocoder.LoadFromJsonl(jsonPath, dataVersionHeadline, loadThreadsCount, namesFilter);
+    geocoder.SaveToMappedIndex(path);
+    remove(jsonPath.c_str());
+
+    LOG(LINFO, ("Shard", jsonFile.first, "is written to", path));
+    shards.push_back(path);
+  }
+  return shards;
+}
+
+void ShardedGeocoder::AddShard(string const & pathToIndex)
+{
+  auto geocoder = make_unique<Geocoder>();
+  geocoder->LoadFromMappedIndex(pathToIndex);
+  AddShard(move(geocoder));
+}
+
+void ShardedGeocoder::AddShard(unique_ptr<Geocoder> geocoder)
+{
+  CHECK(geocoder, ());
+  auto countryNames = CollectCountryNames(*geocoder);
+  m_shards.push_back({move(geocoder), move(countryNames)});
+}
+
+Geocoder const & ShardedGeocoder::GetShard(size_t shard) const
+{
+  CHECK_LESS(shard, m_shards.size(), ());
+  return *m_shards[shard].m_geocoder;
+}
+
+vector<size_t> ShardedGeocoder::Route(string const & query, string const & countryHint) const
+{
+  vector<size_t> shards;
+  if (!countryHint.empty())
+  {
+    Tokens hint;
+    search::NormalizeAndTokenizeAsUtf8(countryHint, hint);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+      auto const & names = m_shards[i].m_countryNames;
+      if (find(names.begin(), names.end(), hint) != names.end())
+        shards.push_back(i);
+    }
+    if (!shards.empty())
+      return shards;
+    LOG(LDEBUG, ("Unknown country hint:", countryHint));
+  }
+
+  Tokens tokens;
+  search::NormalizeAndTokenizeAsUtf8(query, tokens);
+  for (size_t i = 0; i < m_shards.size(); ++i)
+  {
+    auto const & names = m_shards[i].m_countryNames;
+    if (any_of(names.begin(), names.end(),
+               [&tokens](Tokens const & name) { return ContainsName(tokens, name); }))
+    {
+      shards.push_back(i);
+    }
+  }
+  if (!shards.empty())
+    return shards;
+
+  shards.resize(m_shards.size());
+  iota(shards.begin(), shards.end(), 0);
+  return shards;
+}
+
+void ShardedGeocoder::ProcessQuery(string const & query, vector<Result> & results,
+                                   string const & countryHint) const
+{
+  results.clear();
+  vector<Result> shardResults;
+  for (auto const shard : Route(query, countryHint))
+  {
+    m_shards[shard].m_geocoder->ProcessQuery(query, shardResults);
+    results.insert(results.end(), shardResults.begin(), shardResults.end());
+  }
+
+  stable_sort(results.begin(), results.end(), [](Result const & lhs, Result const & rhs) {
+    return lhs.m_certainty > rhs.m_certainty;
+  });
+}
+
+// static
+vector<Tokens> ShardedGeocoder::CollectCountryNames(Geocoder const & geocoder)
+{
+  auto const & hierarchy = geocoder.GetHierarchy();
+  auto const & dictionary = hierarchy.GetNormalizedNameDictionary();
+  auto const entries = hierarchy.GetEntries();
+
+  vector<Tokens> countryNames;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    auto const & entry = entries[i];
+    if (entry.m_type != Type::Country)
+      continue;
+
+    for (auto const & name : entry.GetNormalizedMultipleNames(Type::Country, dictionary))
+    {
+      Tokens tokens;
+      search::NormalizeAndTokenizeAsUtf8(string(name), tokens);
+      if (!tokens.empty())
+        countryNames.push_back(move(tokens));
+    }
+  }
+
+  sort(countryNames.begin(), countryNames.end());
+  countryNames.erase(unique(countryNames.begin(), countryNames.end()), countryNames.end());
+  return countryNames;
+}
+}  // namespace geocoder
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "geocoder/geocoder.hpp"
+#include "geocoder/result.hpp"
+#include "geocoder/types.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace geocoder
+{
+// A geocoder over the data split by the countries into shards. Every shard is a separate
+// mapped index, so a process may load only a part of the shards and the others may be served
+// by other processes or nodes, see Route().
+// A query naming a country (by the hint or by the country name among the query tokens) is
+// searched in the shards of the country only, other queries are searched in all the shards.
+class ShardedGeocoder
+{
+public:
+  // The shard of the entries without a country in the address.
+  static constexpr char const * kNoCountryShardName = "no_country";
+  static constexpr char const * kShardExtension = ".mapidx";
+
+  // Splits the jsonl hierarchy by the countries of the entries and writes the mapped index
+  // of every shard to |shardsDir| (the shard file is named by the country).
+  // Returns the paths of the written shards.
+  static std::vector<std::string> BuildShards(
+      std::string const & pathToJsonHierarchy, std::string const & shardsDir,
+      bool dataVersionHeadline = false, unsigned int loadThreadsCount = 1,
+      Hierarchy::NamesFilter const & namesFilter = {});
+
+  // Loads the mapped index shard, see BuildShards().
+  void AddShard(std::string const & pathToIndex);
+  void AddShard(std::unique_ptr<Geocoder> geocoder);
+
+  size_t GetShardsCount() const { return m_shards.size(); }
+  Geocoder const & GetShard(size_t shard) const;
+
+  // Returns the shards |query| is to be searched in. The shards of the country |countryHint|
+  // are taken if the hint is not empty and is a name of a loaded country, otherwise the shards
+  // of the countries named in the query or all the shards if the query names no country.
+  std::vector<size_t> Route(std::string const & query, std::string const & countryHint = {}) const;
+
+  // Searches |query| in the shards of Route() and merges the results by their certainty.
+  // The certainties are normalized within every shard.
+  void ProcessQuery(std::string const & query, std::vector<Result> & results,
+                    std::string const & countryHint = {}) const;
+
+private:
+  struct Shard
+  {
+    std::unique_ptr<Geocoder> m_geocoder;
+    // Tokens of the normalized names of the countries of the shard.
+    std::vector<Tokens> m_countryNames;
+  };
+
+  static std::vector<Tokens> CollectCountryNames(Geocoder const & geocoder);
+
+  std::vector<Shard> m_shards;
+};
+}  // namespace geocoder
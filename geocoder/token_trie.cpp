@@ -0,0 +1,118 @@
+#include "geocoder/token_trie.hpp"
+
+#include "base/assert.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <queue>
+
+using namespace std;
+
+namespace geocoder
+{
+// static
+TokenTrie::TokenId constexpr TokenTrie::kInvalidTokenId;
+TokenTrie::NodeId constexpr TokenTrie::kRootNodeId;
+size_t constexpr TokenTrie::kMaxCompletions;
+
+void TokenTrie::Build(vector<pair<strings::UniString, TokenId>> && tokens,
+                      vector<uint64_t> const & weights)
+{
+  Clear();
+
+  sort(tokens.begin(), tokens.end());
+
+  // Nodes are built in the BFS order so that all edges of a node are added at once.
+  struct Task
+  {
+    NodeId m_node;
+    size_t m_begin;
+    size_t m_end;
+    size_t m_depth;
+  };
+
+  m_nodes.emplace_back();
+  queue<Task> tasks;
+  tasks.push({kRootNodeId, 0, tokens.size(), 0});
+  while (!tasks.empty())
+  {
+    auto task = tasks.front();
+    tasks.pop();
+
+    if (task.m_begin < task.m_end && tokens[task.m_begin].first.size() == task.m_depth)
+    {
+      m_nodes[task.m_node].m_tokenId = tokens[task.m_begin].second;
+      ++task.m_begin;
+    }
+
+    m_nodes[task.m_node].m_edgesBegin = static_cast<uint32_t>(m_edges.size());
+    for (size_t i = task.m_begin; i < task.m_end;)
+    {
+      auto const c = tokens[i].first[task.m_depth];
+      size_t j = i + 1;
+      while (j < task.m_end && tokens[j].first[task.m_depth] == c)
+        ++j;
+
+      auto const child = static_cast<NodeId>(m_nodes.size());
+      m_nodes.emplace_back();
+      m_edges.push_back({c, child});
+      tasks.push({child, i, j, task.m_depth + 1});
+      i = j;
+    }
+    m_nodes[task.m_node].m_edgesEnd = static_cast<uint32_t>(m_edges.size());
+  }
+
+  CHECK_EQUAL(m_nodes.size(), m_edges.size() + 1, ());
+  BuildCompletions(weights);
+}
+
+void TokenTrie::Clear()
+{
+  m_nodes.clear();
+  m_edges.clear();
+  m_completions.clear();
+}
+
+void TokenTrie::BuildCompletions(vector<uint64_t> const & weights)
+{
+  auto const isBetter = [&weights](TokenId lhs, TokenId rhs) {
+    auto const lhsWeight = lhs < weights.size() ? weights[lhs] : 0;
+    auto const rhsWeight = rhs < weights.size() ? weights[rhs] : 0;
+    if (lhsWeight != rhsWeight)
+      return lhsWeight > rhsWeight;
+    return lhs < rhs;
+  };
+
+  // The children follow their parents in the BFS order, so the completions of the children
+  // are ready when the nodes are visited backwards.
+  vector<TokenId> candidates;
+  for (auto nodeId = m_nodes.size(); nodeId-- > 0;)
+  {
+    auto & node = m_nodes[nodeId];
+    // The chains of the nodes without tokens share the completions of the chain ends.
+    if (node.m_tokenId == kInvalidTokenId && node.m_edgesEnd == node.m_edgesBegin + 1)
+    {
+      auto const & child = m_nodes[m_edges[node.m_edgesBegin].m_child];
+      node.m_completionsBegin = child.m_completionsBegin;
+      node.m_completionsEnd = child.m_completionsEnd;
+      continue;
+    }
+
+    candidates.clear();
+    if (node.m_tokenId != kInvalidTokenId)
+      candidates.push_back(node.m_tokenId);
+    for (auto i = node.m_edgesBegin; i < node.m_edgesEnd; ++i)
+    {
+      auto const & child = m_nodes[m_edges[i].m_child];
+      candidates.insert(candidates.end(), m_completions.begin() + child.m_completionsBegin,
+                        m_completions.begin() + child.m_completionsEnd);
+    }
+
+    auto const count = min(candidates.size(), kMaxCompletions);
+    partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), isBetter);
+    node.m_completionsBegin = static_cast<uint32_t>(m_completions.size());
+    m_completions.insert(m_completions.end(), candidates.begin(), candidates.begin() + count);
+    node.m_completionsEnd = static_cast<uint32_t>(m_completions.size());
+  }
+}
+}  // namespace geocoder
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace geocoder
+{
+// A character trie over the index vocabulary. Nodes and edges are kept in flat
+// arrays, edges of a node are contiguous and sorted by characters.
+// The trie is walked with an automaton (e.g. strings::LevenshteinDFA) to
+// retrieve all tokens accepted by it in a single pass.
+// Every node also keeps the best kMaxCompletions tokens of its subtree, so the
+// completions of a prefix are found by the walk down the prefix only.
+class TokenTrie
+{
+public:
+  using TokenId = uint32_t;
+  static TokenId constexpr kInvalidTokenId = std::numeric_limits<TokenId>::max();
+  static size_t constexpr kMaxCompletions = 8;
+
+  // |tokens| must not contain duplicates. The completions with greater |weights[tokenId]| are
+  // better, the completions with equal weights are ordered by the token ids. All the weights
+  // are equal when |weights| is empty.
+  void Build(std::vector<std::pair<strings::UniString, TokenId>> && tokens,
+             std::vector<uint64_t> const & weights = {});
+  void Clear();
+
+  bool IsEmpty() const { return m_nodes.empty(); }
+
+  // Calls |fn(tokenId)| for at most kMaxCompletions best tokens starting with |prefix|,
+  // the best ones go first. The token equal to |prefix| is a completion too.
+  template <typename Fn>
+  void ForEachCompletion(strings::UniString const & prefix, Fn && fn) const
+  {
+    if (IsEmpty())
+      return;
+
+    NodeId nodeId = kRootNodeId;
+    for (auto const c : prefix)
+    {
+      auto const & node = m_nodes[nodeId];
+      auto const begin = m_edges.begin() + node.m_edgesBegin;
+      auto const end = m_edges.begin() + node.m_edgesEnd;
+      auto const it = std::lower_bound(begin, end, c, [](Edge const & edge, strings::UniChar c) {
+        return edge.m_char < c;
+      });
+      if (it == end || it->m_char != c)
+        return;
+      nodeId = it->m_child;
+    }
+
+    auto const & node = m_nodes[nodeId];
+    for (auto i = node.m_completionsBegin; i < node.m_completionsEnd; ++i)
+      fn(m_completions[i]);
+  }
+
+  // Calls |fn(tokenId, errorsMade)| for every token accepted by |dfa|.
+  template <typename DFA, typename Fn>
+  void ForEachMatch(DFA const & dfa, Fn && fn) const
+  {
+    if (IsEmpty())
+      return;
+    ForEachMatch(kRootNodeId, dfa.Begin(), fn);
+  }
+
+private:
+  using NodeId = uint32_t;
+  static NodeId constexpr kRootNodeId = 0;
+
+  struct Node
+  {
+    // Edges of the node are [m_edgesBegin, m_edgesEnd) in |m_edges|.
+    uint32_t m_edgesBegin = 0;
+    uint32_t m_edgesEnd = 0;
+    TokenId m_tokenId = kInvalidTokenId;
+    // The best tokens of the subtree are [m_completionsBegin, m_completionsEnd)
+    // in |m_completions|.
+    uint32_t m_completionsBegin = 0;
+    uint32_t m_completionsEnd = 0;
+  };
+
+  struct Edge
+  {
+    strings::UniChar m_char;
+    NodeId m_child;
+  };
+
+  void BuildCompletions(std::vector<uint64_t> const & weights);
+
+  template <typename It, typename Fn>
+  void ForEachMatch(NodeId nodeId, It const & it, Fn & fn) const
+  {
+    auto const & node = m_nodes[nodeId];
+    if (node.m_tokenId != kInvalidTokenId && it.Accepts())
+      fn(node.m_tokenId, it.ErrorsMade());
+
+    for (auto i = node.m_edgesBegin; i < node.m_edgesEnd; ++i)
+    {
+      auto next = it;
+      next.Move(m_edges[i].m_char);
+      if (next.Rejects())
+        continue;
+      ForEachMatch(m_edges[i].m_child, next, fn);
+    }
+  }
+
+  std::vector<Node> m_nodes;
+  std::vector<Edge> m_edges;
+  std::vector<TokenId> m_completions;
+};
+}  // namespace geocoder
@@ -230,29 +230,24 @@ public:
     if (m_level >= depth)
       return AncestorAtLevel(depth - 1).ToInt64ZOrder(depth);
 
-    uint64_t bits = m_bits;
-    uint64_t res = 0;
     // When counting, group the nodes by their level.
     // All nodes to the left of the current one at its level
     // and, for every ancestor, all nodes to the left of the ancestor
     // at the ancestor's level will show up earlier during the traversal.
     // All ancestors are visited before the current node, so add +1 for them.
     // The result is 1-based, so add +1 for the node itself too.
-    for (int i = 0; i <= m_level; ++i)
-    {
-      res += bits + 1;
-      bits >>= 2;
-    }
+    // The ancestors' bits are m_bits >> 2i, their sum over i > 0 is (m_bits - s) / 3
+    // where s is the sum of the base-4 digits of m_bits.
+    uint64_t const kLowDigitBits = 0x5555555555555555ULL;
+    uint64_t const digitsSum = bits::PopCount(m_bits & kLowDigitBits) +
+                               2 * bits::PopCount(m_bits & (kLowDigitBits << 1));
+    uint64_t res = m_bits + (m_bits - digitsSum) / 3 + m_level + 1;
 
     // By the same reasoning, if the children of every node are ordered
     // left to right, then all nodes at deeper levels that
     // are strictly to the left will be visited before the current one.
-    bits = m_bits;
-    for (int i = m_level + 1; i < depth; ++i)
-    {
-      bits <<= 2;
-      res += bits;
-    }
+    // These are m_bits << 2i for 0 < i < depth - m_level, that is m_bits * (4 + 16 + ...).
+    res += m_bits * (TreeSizeForDepth(depth - m_level) - 1);
 
     ASSERT_GREATER(res, 0, (m_bits, m_level));
     ASSERT_LESS_OR_EQUAL(res, TreeSizeForDepth(depth), (m_bits, m_level));
@@ -271,11 +266,15 @@ public:
     int level = 0;
     while (v > 1)
     {
-      bits <<= 2;
       ++level;
       uint64_t const subtreeSize = TreeSizeForDepth(depth - level);
-      for (--v; static_cast<uint64_t>(v) > subtreeSize; v -= subtreeSize)
-        ++bits;
+      auto const n = static_cast<uint64_t>(v - 1);
+      // The child containing the n-th node of the subtrees, chosen without branches.
+      uint64_t const child =
+          (n > subtreeSize) + (n > 2 * subtreeSize) + (n > 3 * subtreeSize);
+      ASSERT_LESS(child, 4, (v, depth));
+      bits = (bits << 2) | child;
+      v = static_cast<int64_t>(n - child * subtreeSize);
     }
     return CellId(bits, level);
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "geometry/point2d.hpp"
+#include "geometry/rect2d.hpp"
 #include "geometry/segment2d.hpp"
 #include "geometry/triangle2d.hpp"
 
@@ -11,6 +12,7 @@
 #include "base/math.hpp"
 #include "base/thread_pool_computational.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -75,11 +77,71 @@ CellObjectIntersection IntersectCellWithTriangle(CellId const cell, m2::PointD c
   return CELL_OBJECT_NO_INTERSECTION;
 }
 
+template <class CellId>
+uint64_t GetCellArea(CellId const & cell, int cellDepth)
+{
+  return std::pow(uint64_t(1 << (cellDepth - 1 - cell.Level())), 2);
+}
+
+// Returns the cell the covering of an object with |rect| (in the cell coordinates) may start
+// from instead of the root: every bigger cell has the only child intersecting |rect| and
+// would be covered by the covering of this child. The cell is the deepest one for
+// the small objects, so their coverings are made without the descent from the root.
+// |cellPenaltyArea| is the one of CoverObject(), the cells it may cover an object by
+// are not skipped.
+template <class CellId>
+CellId GetCoveringRoot(m2::RectD const & rect, int cellDepth, uint64_t cellPenaltyArea = 0)
+{
+  auto cell = CellId::Root();
+  while (cell.Level() < cellDepth - 1 && cellPenaltyArea < GetCellArea(cell, cellDepth))
+  {
+    size_t intersectionsCount = 0;
+    CellId next;
+    for (uint8_t i = 0; i < 4 && intersectionsCount < 2; ++i)
+    {
+      auto const child = cell.Child(i);
+      std::pair<uint32_t, uint32_t> const xy = child.XY();
+      uint32_t const r = child.Radius();
+      if (m2::RectD(xy.first - r, xy.second - r, xy.first + r, xy.second + r).IsIntersect(rect))
+      {
+        next = child;
+        ++intersectionsCount;
+      }
+    }
+
+    if (intersectionsCount != 1)
+      break;
+    cell = next;
+  }
+  return cell;
+}
+
+// Returns the depth (not greater than |cellDepth|) an object with |rect| (in the cell coordinates)
+// may be covered up to, so that about |cellsBudget| cells of the deepest level cover the boundary
+// of the object: the bigger objects are covered by the coarser cells at their boundaries.
+// The depth may be passed to CoverObject() as |cellDepth|, the cells of the covering are still
+// coded with the depth of the index.
+template <class CellId>
+int GetCoveringDepth(m2::RectD const & rect, int cellDepth, size_t cellsBudget)
+{
+  auto const boundary = 4.0 * std::max(rect.SizeX(), rect.SizeY());
+  int depth = cellDepth;
+  while (depth > 1)
+  {
+    // The side of a cell of level |depth - 1|, see CellId::Radius().
+    auto const side = static_cast<double>(uint64_t{1} << (CellId::DEPTH_LEVELS - depth + 1));
+    if (boundary <= side * static_cast<double>(cellsBudget))
+      break;
+    --depth;
+  }
+  return depth;
+}
+
 template <class CellId, class CellIdContainerT, typename IntersectF>
 void CoverObject(IntersectF const & intersect, uint64_t cellPenaltyArea, CellIdContainerT & out,
                  int cellDepth, CellId cell)
 {
-  uint64_t const cellArea = std::pow(uint64_t(1 << (cellDepth - 1 - cell.Level())), 2);
+  uint64_t const cellArea = GetCellArea(cell, cellDepth);
   CellObjectIntersection const intersection = intersect(cell);
 
   if (intersection == CELL_OBJECT_NO_INTERSECTION)
@@ -102,7 +164,7 @@ void CoverObject(IntersectF const & intersect, uint64_t cellPenaltyArea, CellIdC
 
   uint64_t subdivArea = 0;
   for (size_t i = 0; i < subdiv.size(); ++i)
-    subdivArea += std::pow(uint64_t(1 << (cellDepth - 1 - subdiv[i].Level())), 2);
+    subdivArea += GetCellArea(subdiv[i], cellDepth);
 
   ASSERT(!subdiv.empty(), (cellPenaltyArea, out, cell));
 
@@ -130,12 +192,13 @@ public:
     , m_threadPool{threadPool}
   { }
 
-  std::vector<CellId> Cover() const
+  // |root| is the root or the cell by GetCoveringRoot().
+  std::vector<CellId> Cover(CellId const & root) const
   {
     std::vector<CellId> result;
 
-    auto covering = std::vector<ObjectCovering>{{result, CellId::Root(), {}}};
-    Cover(0, covering);
+    auto covering = std::vector<ObjectCovering>{{result, root, {}}};
+    Cover(root.Level(), covering);
 
     return result;
   }
@@ -253,10 +316,10 @@ private:
 template <class CellId, typename IntersectF>
 std::vector<CellId> CoverObject(
     IntersectF const & intersect, int cellDepth,
-    base::thread_pool::computational::ThreadPool & threadPool)
+    base::thread_pool::computational::ThreadPool & threadPool, CellId const & root = CellId::Root())
 {
   ObjectCoverer<CellId, IntersectF> coverer{intersect, cellDepth, threadPool};
-  return coverer.Cover();
+  return coverer.Cover(root);
 }
 
 }  // namespace covering
@@ -38,6 +38,9 @@ public:
     return points;
   }
 
+  // Returns the box in the coordinates (x + y, x - y).
+  BoundingBox const & GetRotatedBox() const { return m_box; }
+
   bool operator==(DiamondBox const & rhs) const { return m_box == rhs.m_box; }
 
   DECLARE_VISITOR(visitor(m_box, "box"))
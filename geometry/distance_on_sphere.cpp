@@ -18,13 +18,21 @@ double constexpr kOneDegreeEquatorLengthMeters = 111319.49079;
 
 namespace ms
 {
+SpherePoint::SpherePoint(LatLon const & ll)
+  : m_lat(base::DegToRad(ll.m_lat)), m_lon(base::DegToRad(ll.m_lon)), m_cosLat(cos(m_lat))
+{
+}
+
 double DistanceOnSphere(double lat1Deg, double lon1Deg, double lat2Deg, double lon2Deg)
 {
-  double const lat1 = base::DegToRad(lat1Deg);
-  double const lat2 = base::DegToRad(lat2Deg);
-  double const dlat = sin((lat2 - lat1) * 0.5);
-  double const dlon = sin((base::DegToRad(lon2Deg) - base::DegToRad(lon1Deg)) * 0.5);
-  double const y = dlat * dlat + dlon * dlon * cos(lat1) * cos(lat2);
+  return DistanceOnSphere(SpherePoint({lat1Deg, lon1Deg}), SpherePoint({lat2Deg, lon2Deg}));
+}
+
+double DistanceOnSphere(SpherePoint const & p1, SpherePoint const & p2)
+{
+  double const dlat = sin((p2.m_lat - p1.m_lat) * 0.5);
+  double const dlon = sin((p2.m_lon - p1.m_lon) * 0.5);
+  double const y = dlat * dlat + dlon * dlon * p1.m_cosLat * p2.m_cosLat;
   return 2.0 * atan2(sqrt(y), sqrt(max(0.0, 1.0 - y)));
 }
 
@@ -47,6 +55,35 @@ double DistanceOnEarth(LatLon const & ll1, LatLon const & ll2)
   return DistanceOnEarth(ll1.m_lat, ll1.m_lon, ll2.m_lat, ll2.m_lon);
 }
 
+double DistanceOnEarth(SpherePoint const & p1, SpherePoint const & p2)
+{
+  return kEarthRadiusMeters * DistanceOnSphere(p1, p2);
+}
+
+void DistanceOnEarth(LatLon const & origin, LatLon const * points, size_t count,
+                     double * distances)
+{
+  SpherePoint const originPoint(origin);
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = DistanceOnEarth(originPoint, SpherePoint(points[i]));
+}
+
+double PolylineLengthOnEarth(LatLon const * points, size_t count)
+{
+  if (count < 2)
+    return 0.0;
+
+  double length = 0.0;
+  SpherePoint prev(points[0]);
+  for (size_t i = 1; i < count; ++i)
+  {
+    SpherePoint const cur(points[i]);
+    length += DistanceOnEarth(prev, cur);
+    prev = cur;
+  }
+  return length;
+}
+
 double AreaOnEarth(LatLon const & ll1, LatLon const & ll2, LatLon const & ll3)
 {
   return kOneDegreeEquatorLengthMeters * kOneDegreeEquatorLengthMeters *
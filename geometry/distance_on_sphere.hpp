@@ -4,13 +4,31 @@
 
 #include "base/base.hpp"
 
+#include <cstddef>
+
 // namespace ms - "math on sphere", similar to namespace m2.
 namespace ms
 {
+// A point on the unit sphere with the values which DistanceOnSphere() computes for a point,
+// so the batches of the distances compute them once per point. The distances between
+// the sphere points are equal to the distances between their lat lons.
+struct SpherePoint
+{
+  SpherePoint() = default;
+  explicit SpherePoint(LatLon const & ll);
+
+  // In radians.
+  double m_lat = 0.0;
+  double m_lon = 0.0;
+  double m_cosLat = 1.0;
+};
+
 // Distance on unit sphere between (lat1, lon1) and (lat2, lon2).
 // lat1, lat2, lon1, lon2 - in degrees.
 double DistanceOnSphere(double lat1Deg, double lon1Deg, double lat2Deg, double lon2Deg);
 
+double DistanceOnSphere(SpherePoint const & p1, SpherePoint const & p2);
+
 // Area on unit sphere for a triangle (ll1, ll2, ll3).
 double AreaOnSphere(LatLon const & ll1, LatLon const & ll2, LatLon const & ll3);
 
@@ -20,5 +38,14 @@ double DistanceOnEarth(double lat1Deg, double lon1Deg, double lat2Deg, double lo
 
 double DistanceOnEarth(LatLon const & ll1, LatLon const & ll2);
 
+double DistanceOnEarth(SpherePoint const & p1, SpherePoint const & p2);
+
+// Distances in meters on Earth from |origin| to |points|, |distances| should have |count| values.
+void DistanceOnEarth(LatLon const & origin, LatLon const * points, size_t count,
+                     double * distances);
+
+// Length in meters on Earth of the polyline |points|.
+double PolylineLengthOnEarth(LatLon const * points, size_t count);
+
 double AreaOnEarth(LatLon const & ll1, LatLon const & ll2, LatLon const & ll3);
 }  // namespace ms
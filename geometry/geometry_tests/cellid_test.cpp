@@ -92,6 +92,33 @@ UNIT_TEST(CellId_FromInt64)
   TEST_EQUAL(m2::CellId<3>("33"), m2::CellId<3>::FromInt64(21, 3), ());
 }
 
+UNIT_TEST(CellId_Int64_PreOrder)
+{
+  using Id = m2::CellId<8>;
+
+  // The cells of the tree of depth 6 in the pre-order traversal.
+  vector<Id> cells = {Id::Root()};
+  for (size_t i = 0; i < cells.size(); ++i)
+  {
+    if (cells[i].Level() + 1 < 6)
+    {
+      for (int8_t c = 0; c < 4; ++c)
+        cells.push_back(cells[i].Child(c));
+    }
+  }
+  sort(cells.begin(), cells.end(),
+       [](Id const & lhs, Id const & rhs) { return lhs.ToString() < rhs.ToString(); });
+
+  for (int64_t i = 0; i < static_cast<int64_t>(cells.size()); ++i)
+  {
+    TEST_EQUAL(cells[i].ToInt64(6), i + 1, (cells[i]));
+    TEST_EQUAL(Id::FromInt64(i + 1, 6), cells[i], (i + 1));
+  }
+
+  auto const deepest = m2::CellId<31>("012301230123012301230123012301");
+  TEST_EQUAL(m2::CellId<31>::FromInt64(deepest.ToInt64(31), 31), deepest, ());
+}
+
 UNIT_TEST(CellId_XY)
 {
   TEST_EQUAL(m2::CellId<3>("").XY(), make_pair(4U, 4U), ());
@@ -2,6 +2,8 @@
 #include "geometry/distance_on_sphere.hpp"
 #include "base/math.hpp"
 
+#include <vector>
+
 UNIT_TEST(DistanceOnSphere)
 {
   TEST_LESS(fabs(ms::DistanceOnSphere(0, -180, 0, 180)), 1.0e-6, ());
@@ -20,3 +22,19 @@ UNIT_TEST(DistanceOnEarth)
   TEST_LESS(fabs(ms::DistanceOnEarth(47.37, 8.56, 53.91, 27.56) * 0.001 - 1519), 1, ());
   TEST_LESS(fabs(ms::DistanceOnEarth(43, 132, 38, -122.5) * 0.001 - 8302), 1, ());
 }
+
+UNIT_TEST(DistanceOnEarth_Batch)
+{
+  std::vector<ms::LatLon> const points = {{47.37, 8.56}, {53.91, 27.56}, {43, 132}, {38, -122.5}};
+  std::vector<double> distances(points.size());
+  ms::DistanceOnEarth(points[0], points.data(), points.size(), distances.data());
+
+  double length = 0.0;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    TEST_EQUAL(distances[i], ms::DistanceOnEarth(points[0], points[i]), (i));
+    if (i != 0)
+      length += ms::DistanceOnEarth(points[i - 1], points[i]);
+  }
+  TEST_EQUAL(ms::PolylineLengthOnEarth(points.data(), points.size()), length, ());
+}
@@ -6,6 +6,9 @@
 #include "base/macros.hpp"
 #include "base/math.hpp"
 
+#include <cstddef>
+#include <vector>
+
 UNIT_TEST(Mercator_Grid)
 {
   const double kEpsilon = 0.00000001;
@@ -82,3 +85,42 @@ UNIT_TEST(Mercator_Sample1)
   LOG(LINFO, (MercatorBounds::XToLon(27.531491200000001385),
               MercatorBounds::YToLat(64.392864299248202542)));
 }
+
+UNIT_TEST(Mercator_Batch)
+{
+  std::vector<ms::LatLon> latLons;
+  for (double lat = -89.5; lat < 90.0; lat += 3.7)
+    latLons.emplace_back(lat, lat * 1.9 - 10.0);
+
+  size_t const count = latLons.size();
+  std::vector<m2::PointD> points(count);
+  MercatorBounds::FromLatLon(latLons.data(), count, points.data());
+  std::vector<ms::LatLon> backLatLons(count);
+  MercatorBounds::ToLatLon(points.data(), count, backLatLons.data());
+
+  std::vector<double> values(count);
+  for (size_t i = 0; i < count; ++i)
+    values[i] = latLons[i].m_lat;
+  MercatorBounds::LatToY(values.data(), count, values.data());
+
+  std::vector<double> distances(count);
+  MercatorBounds::DistanceOnEarth(points[0], points.data(), count, distances.data());
+
+  double length = 0.0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // The batches give the same values as the single points.
+    TEST_EQUAL(points[i], MercatorBounds::FromLatLon(latLons[i]), (i));
+    TEST_EQUAL(backLatLons[i], MercatorBounds::ToLatLon(points[i]), (i));
+    TEST_EQUAL(values[i], MercatorBounds::LatToY(latLons[i].m_lat), (i));
+    TEST_EQUAL(distances[i], MercatorBounds::DistanceOnEarth(points[0], points[i]), (i));
+    if (i != 0)
+      length += MercatorBounds::DistanceOnEarth(points[i - 1], points[i]);
+  }
+  TEST_EQUAL(MercatorBounds::PolylineLengthOnEarth(points.data(), count), length, ());
+  TEST_EQUAL(MercatorBounds::PolylineLengthOnEarth(points.data(), 1), 0.0, ());
+
+  MercatorBounds::YToLat(values.data(), count, values.data());
+  for (size_t i = 0; i < count; ++i)
+    TEST_EQUAL(values[i], backLatLons[i].m_lat, (i));
+}
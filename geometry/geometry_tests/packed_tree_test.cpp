@@ -0,0 +1,103 @@
+#include "testing/testing.hpp"
+
+#include "geometry/packed_tree4d.hpp"
+#include "geometry/tree4d.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+using R = m2::RectD;
+
+struct RectTraits
+{
+  m2::RectD LimitRect(m2::RectD const & r) const { return r; }
+};
+
+struct IdTraits
+{
+  explicit IdTraits(vector<R> const & rects) : m_rects(&rects) {}
+  m2::RectD LimitRect(size_t id) const { return (*m_rects)[id]; }
+
+  vector<R> const * m_rects;
+};
+
+R RandomRect(mt19937 & rng, double maxSize)
+{
+  uniform_real_distribution<double> coord(-100.0, 100.0);
+  uniform_real_distribution<double> size(0.0, maxSize);
+  double const x = coord(rng);
+  double const y = coord(rng);
+  return R(x, y, x + size(rng), y + size(rng));
+}
+}  // namespace
+
+UNIT_TEST(PackedTree4D_Smoke)
+{
+  m4::PackedTree<R, RectTraits> tree;
+  tree.Build();
+  TEST(tree.IsEmpty(), ());
+  size_t count = 0;
+  tree.ForEachInRect(R(-1, -1, 1, 1), [&count](R const &) { ++count; });
+  TEST_EQUAL(count, 0, ());
+
+  R arr[] = {R(0, 0, 1, 1), R(5, 5, 10, 10), R(-1, -1, 0, 0), R(-10, -10, -5, -5)};
+  for (auto const & r : arr)
+    tree.Add(r);
+  tree.Build();
+  TEST_EQUAL(tree.GetSize(), ARRAY_SIZE(arr), ());
+
+  vector<R> found;
+  tree.ForEachInRect(R(1, 1, 5, 5), base::MakeBackInsertFunctor(found));
+  TEST(found.empty(), ());
+  tree.ForEachInRect(R(0.5, 0.5, 5.5, 5.5), base::MakeBackInsertFunctor(found));
+  TEST_EQUAL(found.size(), 2, ());
+  TEST(find(found.begin(), found.end(), R(0, 0, 1, 1)) != found.end(), ());
+  TEST(find(found.begin(), found.end(), R(5, 5, 10, 10)) != found.end(), ());
+
+  TEST(tree.ForAnyInRect(R(-100, -100, 100, 100), [](R const & r) { return r.maxX() > 5; }), ());
+  TEST(!tree.ForAnyInRect(R(-100, -100, 100, 100), [](R const & r) { return r.maxX() > 10; }), ());
+}
+
+// The packed tree finds the same objects as m4::Tree.
+UNIT_TEST(PackedTree4D_SameAsTree)
+{
+  mt19937 rng(42);
+  for (size_t const count : {1, 15, 16, 17, 256, 257, 5000})
+  {
+    vector<R> rects;
+    for (size_t i = 0; i < count; ++i)
+      rects.push_back(RandomRect(rng, 10.0 /* maxSize */));
+
+    IdTraits const traits(rects);
+    m4::Tree<size_t, IdTraits> tree(traits);
+    m4::PackedTree<size_t, IdTraits> packedTree(traits);
+    for (size_t i = 0; i < count; ++i)
+    {
+      tree.Add(i);
+      packedTree.Add(i);
+    }
+    packedTree.Build();
+    TEST_EQUAL(packedTree.GetSize(), count, ());
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+      auto const query = RandomRect(rng, 50.0 /* maxSize */);
+      vector<size_t> expected;
+      tree.ForEachInRect(query, base::MakeBackInsertFunctor(expected));
+      vector<size_t> actual;
+      packedTree.ForEachInRectEx(query, [&](R const & rect, size_t id) {
+        TEST_EQUAL(rect, rects[id], ());
+        actual.push_back(id);
+      });
+      sort(expected.begin(), expected.end());
+      sort(actual.begin(), actual.end());
+      TEST_EQUAL(actual, expected, (count, query));
+    }
+  }
+}
@@ -99,6 +99,43 @@ UNIT_TEST(RegionDifference_Smoke)
   }
 }
 
+UNIT_TEST(RegionIntersect_Clipped)
+{
+  // A comb which is mostly out of the clipper.
+  vector<P> comb = {P(-100, -1), P(100, -1), P(100, 100)};
+  for (int x = 90; x >= -90; x -= 10)
+  {
+    comb.emplace_back(x + 5, 1);
+    comb.emplace_back(x, 100);
+  }
+  comb.emplace_back(-100, 100);
+
+  R r1(comb.begin(), comb.end());
+  P arr2[] = { P(-2, -2), P(-2, 2), P(2, 2), P(2, -2) };
+  R r2(arr2, arr2 + ARRAY_SIZE(arr2));
+
+  vector<R> res;
+  m2::IntersectRegions(r1, r2, res);
+  TEST_EQUAL(res.size(), 1, ());
+  TEST_EQUAL(res[0].GetRect(), m2::RectI(-2, -1, 2, 2), ());
+
+  res.clear();
+  m2::DiffRegions(r2, r1, res);
+  TEST_EQUAL(res.size(), 1, ());
+  TEST_EQUAL(res[0].GetRect(), m2::RectI(-2, -2, 2, -1), ());
+
+  P arr3[] = { P(200, 200), P(200, 300), P(300, 300), P(300, 200) };
+  R r3(arr3, arr3 + ARRAY_SIZE(arr3));
+
+  res.clear();
+  m2::IntersectRegions(r1, r3, res);
+  TEST_EQUAL(res.size(), 0, ());
+
+  m2::DiffRegions(r1, r3, res);
+  TEST_EQUAL(res.size(), 1, ());
+  TEST_EQUAL(res[0].GetRect(), r1.GetRect(), ());
+}
+
 /*
 UNIT_TEST(RegionDifference_Data1)
 {
@@ -4,7 +4,9 @@
 #include "geometry/segment2d.hpp"
 #include "geometry/triangle2d.hpp"
 
+#include <cmath>
 #include <iterator>
+#include <vector>
 
 using namespace m2::robust;
 
@@ -38,6 +40,48 @@ UNIT_TEST(OrientedS_Smoke)
   TEST(OrientedS(arr[2], arr[0], arr[1]) < 0, ());
 }
 
+UNIT_TEST(OrientedS_NearDegenerate)
+{
+  // The points near the line y = x, the doubles lose the sign of the determinant for them.
+  P const p1(12.0, 12.0);
+  P const p2(24.0, 24.0);
+  double const ulp = std::ldexp(1.0, -53);
+  std::vector<P> points;
+  for (int i = 0; i < 16; ++i)
+  {
+    for (int j = 0; j < 16; ++j)
+    {
+      P const p(0.5 + i * ulp, 0.5 + j * ulp);
+      double const s = OrientedS(p1, p2, p);
+      TEST_EQUAL(s > 0, j > i, (i, j));
+      TEST_EQUAL(s < 0, j < i, (i, j));
+      points.push_back(p);
+    }
+  }
+
+  std::vector<double> results(points.size());
+  OrientedS(p1, p2, points.data(), points.size(), results.data());
+  for (size_t i = 0; i < points.size(); ++i)
+    TEST_EQUAL(results[i], OrientedS(p1, p2, points[i]), (i));
+}
+
+UNIT_TEST(OrientedS_Batch)
+{
+  std::vector<P> points;
+  for (int i = 0; i < 100; ++i)
+    points.emplace_back(std::sin(i) * 100.0, std::cos(i * 3) * 50.0);
+  P const p(1.0, 2.0);
+
+  std::vector<double> results(points.size());
+  OrientedS(points[0], points[1], points.data(), points.size(), results.data());
+  for (size_t i = 0; i < points.size(); ++i)
+    TEST_EQUAL(results[i], OrientedS(points[0], points[1], points[i]), (i));
+
+  OrientedS(points.data(), points.size(), p, results.data());
+  for (size_t i = 0; i + 1 < points.size(); ++i)
+    TEST_EQUAL(results[i], OrientedS(points[i], points[i + 1], p), (i));
+}
+
 UNIT_TEST(Segment_Smoke)
 {
   double constexpr eps = 1.0E-10;
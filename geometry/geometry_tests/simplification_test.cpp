@@ -143,3 +143,33 @@ UNIT_TEST(Simpfication_DP_DegenerateTrg)
               P(100.1, 450), P(100, 500),   P(0, 600)};
   CheckDPStrict(arr2, ARRAY_SIZE(arr2), 1.0, 4);
 }
+
+UNIT_TEST(Simplification_DP_Significance)
+{
+  auto const * points = LargePolylineTestData::m_Data;
+  auto const count = LargePolylineTestData::m_Size;
+
+  vector<double> significance;
+  CalculateSignificanceDP(points, points + count, DistanceFn(), significance);
+  TEST_EQUAL(significance.size(), count, ());
+
+  // The generic distance gives the same significance.
+  auto const genericDistFn = [](P const & a, P const & b, P const & p) {
+    return DistanceFn()(a, b, p);
+  };
+  vector<double> genericSignificance;
+  CalculateSignificanceDP(points, points + count, genericDistFn, genericSignificance);
+  TEST_EQUAL(significance, genericSignificance, ());
+
+  // One pass gives the simplifications for all the epsilons.
+  for (double epsilon = 1e-10; epsilon < 1.0; epsilon *= 3)
+  {
+    vector<m2::PointD> expected;
+    SimplifyDP(points, points + count, epsilon, DistanceFn(),
+               base::MakeBackInsertFunctor(expected));
+    vector<m2::PointD> result;
+    SimplifyBySignificance(points, points + count, significance, epsilon,
+                           base::MakeBackInsertFunctor(result));
+    TEST_EQUAL(result, expected, (epsilon));
+  }
+}
@@ -40,11 +40,59 @@ m2::PointD MercatorBounds::GetSmPoint(m2::PointD const & pt, double lonMetersR,
   return FromLatLon(newLat, newLon);
 }
 
+void MercatorBounds::LatToY(double const * lats, size_t count, double * ys)
+{
+  for (size_t i = 0; i < count; ++i)
+    ys[i] = LatToY(lats[i]);
+}
+
+void MercatorBounds::YToLat(double const * ys, size_t count, double * lats)
+{
+  for (size_t i = 0; i < count; ++i)
+    lats[i] = YToLat(ys[i]);
+}
+
+void MercatorBounds::FromLatLon(ms::LatLon const * latLons, size_t count, m2::PointD * points)
+{
+  for (size_t i = 0; i < count; ++i)
+    points[i] = FromLatLon(latLons[i]);
+}
+
+void MercatorBounds::ToLatLon(m2::PointD const * points, size_t count, ms::LatLon * latLons)
+{
+  for (size_t i = 0; i < count; ++i)
+    latLons[i] = ToLatLon(points[i]);
+}
+
 double MercatorBounds::DistanceOnEarth(m2::PointD const & p1, m2::PointD const & p2)
 {
   return ms::DistanceOnEarth(ToLatLon(p1), ToLatLon(p2));
 }
 
+void MercatorBounds::DistanceOnEarth(m2::PointD const & origin, m2::PointD const * points,
+                                     size_t count, double * distances)
+{
+  ms::SpherePoint const originPoint(ToLatLon(origin));
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = ms::DistanceOnEarth(originPoint, ms::SpherePoint(ToLatLon(points[i])));
+}
+
+double MercatorBounds::PolylineLengthOnEarth(m2::PointD const * points, size_t count)
+{
+  if (count < 2)
+    return 0.0;
+
+  double length = 0.0;
+  ms::SpherePoint prev(ToLatLon(points[0]));
+  for (size_t i = 1; i < count; ++i)
+  {
+    ms::SpherePoint const cur(ToLatLon(points[i]));
+    length += ms::DistanceOnEarth(prev, cur);
+    prev = cur;
+  }
+  return length;
+}
+
 double MercatorBounds::AreaOnEarth(m2::PointD const & p1, m2::PointD const & p2,
                                    m2::PointD const & p3)
 {
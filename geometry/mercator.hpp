@@ -6,6 +6,8 @@
 
 #include "base/math.hpp"
 
+#include <cstddef>
+
 struct MercatorBounds
 {
   static double constexpr kMinX = -180.0;
@@ -113,9 +115,28 @@ struct MercatorBounds
                      YToLat(mercatorRect.maxY()), XToLon(mercatorRect.maxX()));
   }
 
+  /// @name Batch versions of the conversions for the hot loops.
+  /// The results are equal to the ones of the point by point conversions.
+  /// The input and the output arrays may be the same for LatToY() and YToLat().
+  //@{
+  static void LatToY(double const * lats, size_t count, double * ys);
+  static void YToLat(double const * ys, size_t count, double * lats);
+  static void FromLatLon(ms::LatLon const * latLons, size_t count, m2::PointD * points);
+  static void ToLatLon(m2::PointD const * points, size_t count, ms::LatLon * latLons);
+  //@}
+
   /// Calculates distance on Earth in meters between two mercator points.
   static double DistanceOnEarth(m2::PointD const & p1, m2::PointD const & p2);
 
+  /// Calculates distances on Earth in meters from |origin| to |points|.
+  /// The origin and every point are converted once.
+  static void DistanceOnEarth(m2::PointD const & origin, m2::PointD const * points, size_t count,
+                              double * distances);
+
+  /// Calculates length on Earth in meters of the polyline |points|.
+  /// Every point is converted once, DistanceOnEarth() of the segments converts them twice.
+  static double PolylineLengthOnEarth(m2::PointD const * points, size_t count);
+
   /// Calculates area of a triangle on Earth in m² by three mercator points.
   static double AreaOnEarth(m2::PointD const & p1, m2::PointD const & p2, m2::PointD const & p3);
   /// Calculates area on Earth in m².
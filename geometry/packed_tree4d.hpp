@@ -0,0 +1,282 @@
+#pragma once
+
+#include "geometry/rect2d.hpp"
+#include "geometry/tree4d.hpp"
+
+#include "base/assert.hpp"
+#include "base/macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace m4
+{
+// A static R-tree for the build once, query many workloads. The objects are added first,
+// then Build() packs them with the Sort-Tile-Recursive algorithm into the contiguous
+// arrays of nodes, every node has up to kFanout children. The rects of the nodes are kept
+// as the separate arrays of the coordinates, so the overlap tests of the children of a node
+// are a branchless loop which the compiler vectorizes.
+// Has the same queries as m4::Tree and the same rect intersection semantics.
+template <typename T, typename Traits = TraitsDef<T>>
+class PackedTree
+{
+public:
+  static size_t constexpr kFanout = 16;
+
+  using elem_t = T;
+
+  PackedTree(Traits const & traits = Traits()) : m_traits(traits) {}
+
+  template <typename U>
+  void Add(U && obj)
+  {
+    auto const rect = m_traits.LimitRect(obj);
+    Add(std::forward<U>(obj), rect);
+  }
+
+  template <typename U>
+  void Add(U && obj, m2::RectD const & rect)
+  {
+    m_values.emplace_back(std::forward<U>(obj));
+    m_rects.push_back(rect);
+    m_built = false;
+  }
+
+  // Packs the added objects. Should be called after the last Add() before the queries.
+  void Build()
+  {
+    SortTileRecursive();
+
+    size_t const count = m_values.size();
+    m_minX.resize(count);
+    m_minY.resize(count);
+    m_maxX.resize(count);
+    m_maxY.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      m_minX[i] = m_rects[i].minX();
+      m_minY[i] = m_rects[i].minY();
+      m_maxX[i] = m_rects[i].maxX();
+      m_maxY[i] = m_rects[i].maxY();
+    }
+
+    // The children of the node |i| of a level are the nodes [i * kFanout, (i + 1) * kFanout)
+    // of the level below. The leaves are sorted by STR, so the consecutive nodes are close.
+    m_levelOffsets.assign(1, 0);
+    size_t levelBegin = 0;
+    size_t levelSize = count;
+    while (levelSize > kFanout)
+    {
+      size_t const parentsSize = (levelSize + kFanout - 1) / kFanout;
+      for (size_t i = 0; i < parentsSize; ++i)
+      {
+        size_t const begin = levelBegin + i * kFanout;
+        size_t const end = std::min(begin + kFanout, levelBegin + levelSize);
+        double const minX = *std::min_element(m_minX.begin() + begin, m_minX.begin() + end);
+        double const minY = *std::min_element(m_minY.begin() + begin, m_minY.begin() + end);
+        double const maxX = *std::max_element(m_maxX.begin() + begin, m_maxX.begin() + end);
+        double const maxY = *std::max_element(m_maxY.begin() + begin, m_maxY.begin() + end);
+        m_minX.push_back(minX);
+        m_minY.push_back(minY);
+        m_maxX.push_back(maxX);
+        m_maxY.push_back(maxY);
+      }
+      levelBegin += levelSize;
+      levelSize = parentsSize;
+      m_levelOffsets.push_back(levelBegin);
+    }
+    m_levelOffsets.push_back(levelBegin + levelSize);
+    m_built = true;
+  }
+
+  template <typename ToDo>
+  void ForEachInRect(m2::RectD const & rect, ToDo && toDo) const
+  {
+    ForAnyInRectImpl(rect, [this, &toDo](size_t i) {
+      toDo(m_values[i]);
+      return false;
+    });
+  }
+
+  template <typename ToDo>
+  void ForEachInRectEx(m2::RectD const & rect, ToDo && toDo) const
+  {
+    ForAnyInRectImpl(rect, [this, &toDo](size_t i) {
+      toDo(m_rects[i], m_values[i]);
+      return false;
+    });
+  }
+
+  template <typename ToDo>
+  bool ForAnyInRect(m2::RectD const & rect, ToDo && toDo) const
+  {
+    return ForAnyInRectImpl(rect, [this, &toDo](size_t i) { return toDo(m_values[i]); });
+  }
+
+  template <typename ToDo>
+  void ForEach(ToDo && toDo) const
+  {
+    for (auto const & value : m_values)
+      toDo(value);
+  }
+
+  template <typename ToDo>
+  void ForEachEx(ToDo && toDo) const
+  {
+    for (size_t i = 0; i < m_values.size(); ++i)
+      toDo(m_rects[i], m_values[i]);
+  }
+
+  bool IsEmpty() const { return m_values.empty(); }
+
+  size_t GetSize() const { return m_values.size(); }
+
+  void Clear()
+  {
+    m_values.clear();
+    m_rects.clear();
+    m_minX.clear();
+    m_minY.clear();
+    m_maxX.clear();
+    m_maxY.clear();
+    m_levelOffsets.clear();
+    m_built = false;
+  }
+
+private:
+  // Sorts the leaves by the centers: by x into the vertical slices, then by y in a slice.
+  void SortTileRecursive()
+  {
+    size_t const count = m_values.size();
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+
+    size_t const leavesCount = (count + kFanout - 1) / kFanout;
+    auto const slicesCount =
+        static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(leavesCount))));
+    size_t const sliceSize = std::max(slicesCount, size_t{1}) * kFanout;
+
+    std::sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+      return m_rects[lhs].minX() + m_rects[lhs].maxX() < m_rects[rhs].minX() + m_rects[rhs].maxX();
+    });
+    for (size_t begin = 0; begin < count; begin += sliceSize)
+    {
+      auto const end = std::min(begin + sliceSize, count);
+      std::sort(order.begin() + begin, order.begin() + end, [this](size_t lhs, size_t rhs) {
+        return m_rects[lhs].minY() + m_rects[lhs].maxY() <
+               m_rects[rhs].minY() + m_rects[rhs].maxY();
+      });
+    }
+
+    std::vector<T> values;
+    std::vector<m2::RectD> rects;
+    values.reserve(count);
+    rects.reserve(count);
+    for (auto const i : order)
+    {
+      values.emplace_back(std::move(m_values[i]));
+      rects.push_back(m_rects[i]);
+    }
+    m_values = std::move(values);
+    m_rects = std::move(rects);
+  }
+
+  // Calls |fn(index)| for the objects which intersect |rect| until it returns true.
+  template <typename Fn>
+  bool ForAnyInRectImpl(m2::RectD const & rect, Fn && fn) const
+  {
+    ASSERT(m_built || m_values.empty(), ("Build() should be called before the queries."));
+    if (m_values.empty())
+      return false;
+
+    struct Range
+    {
+      size_t m_level;
+      size_t m_begin;
+      size_t m_end;
+    };
+
+    double const minX = rect.minX();
+    double const minY = rect.minY();
+    double const maxX = rect.maxX();
+    double const maxY = rect.maxY();
+
+    // A level adds at most kFanout - 1 ranges to the stack and there are less than
+    // kMaxLevels levels of size_t objects.
+    size_t constexpr kMaxLevels = 16;
+    Range stack[kFanout * kMaxLevels];
+    size_t stackSize = 0;
+
+    size_t const topLevel = m_levelOffsets.size() - 2;
+    stack[stackSize++] = {topLevel, 0, LevelSize(topLevel)};
+    while (stackSize != 0)
+    {
+      auto const range = stack[--stackSize];
+
+      size_t const offset = m_levelOffsets[range.m_level];
+      size_t const count = range.m_end - range.m_begin;
+      ASSERT_LESS_OR_EQUAL(count, kFanout, ());
+
+      // The same test as in m4::Tree, without the branches.
+      bool intersects[kFanout];
+      double const * nodesMinX = &m_minX[offset + range.m_begin];
+      double const * nodesMinY = &m_minY[offset + range.m_begin];
+      double const * nodesMaxX = &m_maxX[offset + range.m_begin];
+      double const * nodesMaxY = &m_maxY[offset + range.m_begin];
+      for (size_t i = 0; i < count; ++i)
+      {
+        intersects[i] = (nodesMaxX[i] > minX) & (nodesMinX[i] < maxX) & (nodesMaxY[i] > minY) &
+                        (nodesMinY[i] < maxY);
+      }
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        if (!intersects[i])
+          continue;
+
+        size_t const node = range.m_begin + i;
+        if (range.m_level == 0)
+        {
+          if (fn(node))
+            return true;
+          continue;
+        }
+
+        size_t const childrenBegin = node * kFanout;
+        size_t const childrenEnd =
+            std::min(childrenBegin + kFanout, LevelSize(range.m_level - 1));
+        ASSERT_LESS(stackSize, ARRAY_SIZE(stack), ());
+        stack[stackSize++] = {range.m_level - 1, childrenBegin, childrenEnd};
+      }
+    }
+    return false;
+  }
+
+  size_t LevelSize(size_t level) const
+  {
+    return m_levelOffsets[level + 1] - m_levelOffsets[level];
+  }
+
+  Traits m_traits;
+
+  // The objects and their rects in the order of the leaves.
+  std::vector<T> m_values;
+  std::vector<m2::RectD> m_rects;
+
+  // The rects of the nodes of all the levels, from the leaves to the root level.
+  std::vector<double> m_minX;
+  std::vector<double> m_minY;
+  std::vector<double> m_maxX;
+  std::vector<double> m_maxY;
+  // The nodes of the level |i| are [m_levelOffsets[i], m_levelOffsets[i + 1]).
+  std::vector<size_t> m_levelOffsets;
+  bool m_built = false;
+};
+
+template <typename T, typename Traits>
+size_t constexpr PackedTree<T, Traits>::kFanout;
+}  // namespace m4
@@ -1,7 +1,9 @@
 #include "geometry/region2d/binary_operators.hpp"
 #include "geometry/region2d/boost_concept.hpp"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 using namespace std;
 
@@ -10,6 +12,103 @@ namespace m2
 using namespace boost::polygon;
 using namespace boost::polygon::operators;
 
+namespace
+{
+// Replaces every run of three or more consecutive points of |points| satisfying |isOutside| by
+// the first and the last points of the run. |isOutside| is a half-plane, the chord of a run
+// lies in it too, so the polygon is not changed out of the half-plane.
+template <typename IsOutside>
+void CutOutside(vector<PointI> & points, IsOutside && isOutside)
+{
+  auto const start = find_if_not(points.begin(), points.end(), isOutside);
+  if (start == points.end())
+  {
+    points.clear();
+    return;
+  }
+
+  rotate(points.begin(), start, points.end());
+  size_t count = 0;
+  size_t runBegin = 0;
+  for (size_t i = 0; i <= points.size(); ++i)
+  {
+    if (i < points.size() && isOutside(points[i]))
+      continue;
+
+    // The run is [runBegin, i).
+    if (i >= runBegin + 3)
+    {
+      points[count++] = points[runBegin];
+      points[count++] = points[i - 1];
+    }
+    else
+    {
+      for (auto j = runBegin; j < i; ++j)
+        points[count++] = points[j];
+    }
+
+    if (i < points.size())
+      points[count++] = points[i];
+    runBegin = i + 1;
+  }
+  points.resize(count);
+}
+
+// Doubled signed area.
+int64_t GetOrientedArea(vector<PointI> const & points)
+{
+  int64_t area = 0;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    auto const & p = points[i];
+    auto const & next = points[(i + 1) % points.size()];
+    area += static_cast<int64_t>(p.x) * next.y - static_cast<int64_t>(next.x) * p.y;
+  }
+  return area;
+}
+
+// Returns |region| which is the same inside |rect| and has no more points than |region|.
+// The points out of |rect| are only removed, so the coordinates are not rounded.
+RegionI ClipByRect(RegionI const & region, RectI const & rect)
+{
+  if (rect.IsRectInside(region.GetRect()))
+    return region;
+
+  auto points = region.Data();
+  CutOutside(points, [&rect](PointI const & p) { return p.x < rect.minX(); });
+  CutOutside(points, [&rect](PointI const & p) { return p.x > rect.maxX(); });
+  CutOutside(points, [&rect](PointI const & p) { return p.y < rect.minY(); });
+  CutOutside(points, [&rect](PointI const & p) { return p.y > rect.maxY(); });
+  if (points.size() < 3)
+    return RegionI();
+
+  // The orientation of a polygon is taken by the sign of its area, the chords may change it.
+  if ((GetOrientedArea(points) > 0) != (GetOrientedArea(region.Data()) > 0))
+    return region;
+  return RegionI(move(points));
+}
+
+// Whether |region| is its rect.
+bool IsRect(RegionI const & region)
+{
+  auto const & points = region.Data();
+  if (points.size() != 4)
+    return false;
+
+  auto const & rect = region.GetRect();
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    auto const & p = points[i];
+    auto const & next = points[(i + 1) % points.size()];
+    if ((p.x != rect.minX() && p.x != rect.maxX()) || (p.y != rect.minY() && p.y != rect.maxY()))
+      return false;
+    if ((p.x == next.x) == (p.y == next.y))
+      return false;
+  }
+  return true;
+}
+}  // namespace
+
 void SpliceRegions(vector<RegionI> & src, vector<RegionI> & res)
 {
   for (size_t i = 0; i < src.size(); ++i)
@@ -21,15 +120,53 @@ void SpliceRegions(vector<RegionI> & src, vector<RegionI> & res)
 
 void IntersectRegions(RegionI const & r1, RegionI const & r2, vector<RegionI> & res)
 {
+  auto const & rect1 = r1.GetRect();
+  auto const & rect2 = r2.GetRect();
+  if (!rect1.IsIntersect(rect2))
+    return;
+
+  if (IsRect(r2) && rect2.IsRectInside(rect1))
+  {
+    res.push_back(r1);
+    return;
+  }
+  if (IsRect(r1) && rect1.IsRectInside(rect2))
+  {
+    res.push_back(r2);
+    return;
+  }
+
+  auto const clipped1 = ClipByRect(r1, rect2);
+  auto const clipped2 = ClipByRect(r2, rect1);
+  if (clipped1.GetPointsCount() < 3 || clipped2.GetPointsCount() < 3)
+    return;
+
   vector<RegionI> local;
-  local += (r1 * r2);
+  local += (clipped1 * clipped2);
   SpliceRegions(local, res);
 }
 
 void DiffRegions(RegionI const & r1, RegionI const & r2, vector<RegionI> & res)
 {
+  auto const & rect1 = r1.GetRect();
+  if (!rect1.IsIntersect(r2.GetRect()))
+  {
+    res.push_back(r1);
+    return;
+  }
+
+  if (IsRect(r2) && r2.GetRect().IsRectInside(rect1))
+    return;
+
+  auto const clipped2 = ClipByRect(r2, rect1);
+  if (clipped2.GetPointsCount() < 3)
+  {
+    res.push_back(r1);
+    return;
+  }
+
   vector<RegionI> local;
-  local += boost::polygon::operators::operator-(r1, r2);
+  local += boost::polygon::operators::operator-(r1, clipped2);
   SpliceRegions(local, res);
 }
 }  // namespace m2
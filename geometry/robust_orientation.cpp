@@ -1,7 +1,11 @@
 #include "geometry/robust_orientation.hpp"
 
+#include "geometry/rect2d.hpp"
+
 #include "base/macros.hpp"
 
+#include <cmath>
+
 
 extern "C" {
 #if defined(__clang__)
@@ -31,7 +35,9 @@ bool Init()
   return true;
 }
 
-double OrientedS(PointD const & p1, PointD const & p2, PointD const & p)
+namespace internal
+{
+double OrientedSAdaptive(PointD const & p1, PointD const & p2, PointD const & p, double detSum)
 {
   static bool res = Init();
   ASSERT_EQUAL(res, true, ());
@@ -41,7 +47,55 @@ double OrientedS(PointD const & p1, PointD const & p2, PointD const & p)
   double b[] = {p2.x, p2.y};
   double c[] = {p.x, p.y};
 
-  return orient2d(a, b, c);
+  return orient2dadapt(a, b, c, detSum);
+}
+}  // namespace internal
+
+void OrientedS(PointD const & p1, PointD const & p2, PointD const * points, size_t count,
+               double * results)
+{
+  if (count == 0)
+    return;
+
+  m2::RectD rect;
+  rect.Add(p1);
+  rect.Add(p2);
+  for (size_t i = 0; i < count; ++i)
+    rect.Add(points[i]);
+
+  // |detLeft| + |detRight| <= 2 * width * height, the bound is slightly increased for
+  // the rounding of the width, the height and the products.
+  double const staticBound = internal::kOrientationErrorBound * 2.0 * rect.SizeX() *
+                             rect.SizeY() * (1.0 + 16.0 * internal::kEpsilon);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const & p = points[i];
+    double const det = (p1.x - p.x) * (p2.y - p.y) - (p1.y - p.y) * (p2.x - p.x);
+    results[i] = std::abs(det) > staticBound ? det : OrientedS(p1, p2, p);
+  }
+}
+
+void OrientedS(PointD const * points, size_t count, PointD const & p, double * results)
+{
+  if (count < 2)
+    return;
+
+  m2::RectD rect;
+  rect.Add(p);
+  for (size_t i = 0; i < count; ++i)
+    rect.Add(points[i]);
+
+  double const staticBound = internal::kOrientationErrorBound * 2.0 * rect.SizeX() *
+                             rect.SizeY() * (1.0 + 16.0 * internal::kEpsilon);
+
+  for (size_t i = 0; i + 1 < count; ++i)
+  {
+    auto const & p1 = points[i];
+    auto const & p2 = points[i + 1];
+    double const det = (p1.x - p.x) * (p2.y - p.y) - (p1.y - p.y) * (p2.x - p.x);
+    results[i] = std::abs(det) > staticBound ? det : OrientedS(p1, p2, p);
+  }
 }
 
 bool IsSegmentInCone(PointD const & v, PointD const & v1, PointD const & vPrev,
@@ -5,7 +5,10 @@
 #include "base/stl_helpers.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iterator>
+#include <limits>
 
 namespace m2
 {
@@ -13,10 +16,62 @@ namespace robust
 {
 bool Init();
 
+namespace internal
+{
+// Half of the machine epsilon, the bound of the relative rounding error.
+double constexpr kEpsilon = std::numeric_limits<double>::epsilon() / 2;
+// Shewchuk's bound of the error of the orientation determinant computed with doubles, relative
+// to |detLeft| + |detRight|. The sign of a bigger determinant is correct.
+double constexpr kOrientationErrorBound = (3.0 + 16.0 * kEpsilon) * kEpsilon;
+
+// The exact adaptive orientation test for the near-degenerate cases.
+double OrientedSAdaptive(PointD const & p1, PointD const & p2, PointD const & p, double detSum);
+}  // namespace internal
+
 /// @return > 0, (p1, p2, p) - is CCW (left oriented)
 ///         < 0, (p1, p2, p) - is CW (right oriented)
 /// Same as CrossProduct(p1 - p, p2 - p), but uses robust calculations.
-double OrientedS(PointD const & p1, PointD const & p2, PointD const & p);
+/// The result is computed with doubles when its sign is provably correct, the exact arithmetic
+/// is used only for the near-degenerate cases.
+inline double OrientedS(PointD const & p1, PointD const & p2, PointD const & p)
+{
+  double const detLeft = (p1.x - p.x) * (p2.y - p.y);
+  double const detRight = (p1.y - p.y) * (p2.x - p.x);
+  double const det = detLeft - detRight;
+
+  double detSum;
+  if (detLeft > 0.0)
+  {
+    if (detRight <= 0.0)
+      return det;
+    detSum = detLeft + detRight;
+  }
+  else if (detLeft < 0.0)
+  {
+    if (detRight >= 0.0)
+      return det;
+    detSum = -detLeft - detRight;
+  }
+  else
+  {
+    return det;
+  }
+
+  if (std::abs(det) >= internal::kOrientationErrorBound * detSum)
+    return det;
+
+  return internal::OrientedSAdaptive(p1, p2, p, detSum);
+}
+
+/// Computes OrientedS(p1, p2, points[i]) for all the |count| points to |results|.
+/// A static error bound is computed once by the bounding box of the points, so the most of
+/// the points are checked by one comparison.
+void OrientedS(PointD const & p1, PointD const & p2, PointD const * points, size_t count,
+               double * results);
+
+/// Computes OrientedS(points[i], points[i + 1], p) for all the |count| - 1 edges of the polyline
+/// |points| to |results|.
+void OrientedS(PointD const * points, size_t count, PointD const & p, double * results);
 
 /// Is segment (v, v1) in cone (vPrev, v, vNext)?
 /// @precondition (vPrev, v, vNext) is CCW.
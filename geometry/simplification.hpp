@@ -1,7 +1,9 @@
 #pragma once
 
+#include "geometry/parametrized_segment.hpp"
 #include "geometry/point2d.hpp"
 
+#include "base/assert.hpp"
 #include "base/base.hpp"
 #include "base/logging.hpp"
 #include "base/stl_helpers.hpp"
@@ -9,6 +11,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <utility>
 #include <vector>
 
@@ -41,19 +44,83 @@ std::pair<double, Iter> MaxDistance(Iter first, Iter last, DistanceFn & distFn)
   return res;
 }
 
-// Actual SimplifyDP implementation.
-template <typename DistanceFn, typename Iter, typename Out>
-void SimplifyDP(Iter first, Iter last, double epsilon, DistanceFn & distFn, Out & out)
+// The same as above for the most used distance. The segment is parametrized once
+// for all the points of the range instead of once per point.
+template <typename Iter>
+std::pair<double, Iter> MaxDistance(Iter first, Iter last,
+                                    m2::SquaredDistanceFromSegmentToPoint<m2::PointD> &)
 {
-  std::pair<double, Iter> maxDist = impl::MaxDistance(first, last, distFn);
-  if (maxDist.second == last || maxDist.first < epsilon)
+  std::pair<double, Iter> res(0.0, last);
+  if (std::distance(first, last) <= 1)
+    return res;
+
+  m2::ParametrizedSegment<m2::PointD> const segment{m2::PointD(*first), m2::PointD(*last)};
+  for (Iter i = first + 1; i != last; ++i)
   {
-    out(*last);
+    double const d = segment.SquaredDistanceToPoint(m2::PointD(*i));
+    if (res.first < d)
+    {
+      res.first = d;
+      res.second = i;
+    }
   }
-  else
+
+  return res;
+}
+
+// The ranges of SimplifyDP() which are not processed yet. The stack of a thread is reused
+// between the calls, so a simplification does not allocate.
+template <typename T>
+class DPStack
+{
+public:
+  DPStack() { m_stack.swap(GetThreadStack()); }
+  ~DPStack()
+  {
+    m_stack.clear();
+    m_stack.swap(GetThreadStack());
+  }
+
+  bool IsEmpty() const { return m_stack.empty(); }
+  void Push(T const & t) { m_stack.push_back(t); }
+  T Pop()
   {
-    impl::SimplifyDP(first, maxDist.second, epsilon, distFn, out);
-    impl::SimplifyDP(maxDist.second, last, epsilon, distFn, out);
+    T const t = m_stack.back();
+    m_stack.pop_back();
+    return t;
+  }
+
+private:
+  // The stack is taken by DPStack, so a nested simplification gets an empty one.
+  static std::vector<T> & GetThreadStack()
+  {
+    static thread_local std::vector<T> stack;
+    return stack;
+  }
+
+  std::vector<T> m_stack;
+};
+
+// Actual SimplifyDP implementation. Is iterative with the explicit stack, so the deep
+// polylines do not overflow the call stack. The left range is processed first,
+// so the points are emitted in the order of the polyline.
+template <typename DistanceFn, typename Iter, typename Out>
+void SimplifyDP(Iter first, Iter last, double epsilon, DistanceFn & distFn, Out & out)
+{
+  DPStack<std::pair<Iter, Iter>> stack;
+  stack.Push({first, last});
+  while (!stack.IsEmpty())
+  {
+    auto const range = stack.Pop();
+    std::pair<double, Iter> maxDist = impl::MaxDistance(range.first, range.second, distFn);
+    if (maxDist.second == range.second || maxDist.first < epsilon)
+    {
+      out(*range.second);
+      continue;
+    }
+
+    stack.Push({maxDist.second, range.second});
+    stack.Push({range.first, maxDist.second});
   }
 }
 //@}
@@ -82,6 +149,63 @@ void SimplifyDP(Iter beg, Iter end, double epsilon, DistanceFn distFn, Out out)
   }
 }
 
+// Calculates the significance of the points of [beg, end) for SimplifyDP(): SimplifyDP() with
+// any |epsilon| > 0 keeps exactly the points with the significance not less than |epsilon|.
+// The first and the last points have the infinite significance. So a single pass of DP gives
+// the simplifications for all the epsilons, e.g. for all the scales, see
+// SimplifyBySignificance().
+template <typename DistanceFn, typename Iter>
+void CalculateSignificanceDP(Iter beg, Iter end, DistanceFn distFn,
+                             std::vector<double> & significance)
+{
+  struct Range
+  {
+    size_t m_first;
+    size_t m_last;
+    // The range is split further for the epsilons which are not greater than it.
+    double m_significance;
+  };
+
+  auto const n = static_cast<size_t>(std::distance(beg, end));
+  significance.assign(n, 0.0);
+  if (n == 0)
+    return;
+
+  double const kInf = std::numeric_limits<double>::infinity();
+  significance.front() = kInf;
+  significance.back() = kInf;
+
+  impl::DPStack<Range> stack;
+  stack.Push({0, n - 1, kInf});
+  while (!stack.IsEmpty())
+  {
+    auto const range = stack.Pop();
+    auto const maxDist = impl::MaxDistance(beg + range.m_first, beg + range.m_last, distFn);
+    if (maxDist.second == beg + range.m_last)
+      continue;
+
+    auto const middle = static_cast<size_t>(std::distance(beg, maxDist.second));
+    double const middleSignificance = std::min(maxDist.first, range.m_significance);
+    significance[middle] = middleSignificance;
+    stack.Push({middle, range.m_last, middleSignificance});
+    stack.Push({range.m_first, middle, middleSignificance});
+  }
+}
+
+// Outputs the points of [beg, end) which SimplifyDP() keeps for |epsilon| by
+// the |significance| from CalculateSignificanceDP().
+template <typename Iter, typename Out>
+void SimplifyBySignificance(Iter beg, Iter end, std::vector<double> const & significance,
+                            double epsilon, Out out)
+{
+  ASSERT_EQUAL(static_cast<size_t>(std::distance(beg, end)), significance.size(), ());
+  for (size_t i = 0; beg != end; ++beg, ++i)
+  {
+    if (significance[i] >= epsilon)
+      out(*beg);
+  }
+}
+
 // Dynamic programming near-optimal simplification.
 // Uses O(n) additional memory.
 // Worst case O(n^3) performance, average O(n*k^2), where k is maxFalseLookAhead - parameter,
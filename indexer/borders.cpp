@@ -7,6 +7,8 @@
 #include "base/logging.hpp"
 #include "base/macros.hpp"
 
+#include <algorithm>
+
 #include "defines.hpp"
 
 using namespace std;
@@ -84,7 +86,193 @@ private:
 
 namespace indexer
 {
+// static
+size_t constexpr Borders::Border::kGridSize;
+size_t constexpr Borders::Border::kMinPointsToPrepare;
+
+void Borders::Border::Prepare()
+{
+  m_cells.clear();
+
+  size_t pointsCount = m_outer.Size();
+  for (auto const & inner : m_inners)
+    pointsCount += inner.Size();
+
+  auto const & rect = m_outer.GetRect();
+  if (pointsCount < kMinPointsToPrepare || rect.SizeX() <= 0.0 || rect.SizeY() <= 0.0)
+    return;
+
+  m_cellWidth = rect.SizeX() / kGridSize;
+  m_cellHeight = rect.SizeY() / kGridSize;
+  m_cells.assign(kGridSize * kGridSize, Cell::Outside);
+
+  // All the cells which may be touched by an edge are boundary ones. The bounding boxes of
+  // the edges are inflated because RegionD::Contains() treats the points near an edge as
+  // lying on it and because of the rounding of the cell bounds.
+  double const eps = 1e-7;
+  auto const markEdges = [&](m2::RegionD const & region) {
+    auto const & points = region.Data();
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+    {
+      auto const & p1 = points[j];
+      auto const & p2 = points[i];
+      size_t const minX = GetCellX(std::min(p1.x, p2.x) - eps);
+      size_t const maxX = GetCellX(std::max(p1.x, p2.x) + eps);
+      size_t const minY = GetCellY(std::min(p1.y, p2.y) - eps);
+      size_t const maxY = GetCellY(std::max(p1.y, p2.y) + eps);
+      for (size_t y = minY; y <= maxY; ++y)
+      {
+        for (size_t x = minX; x <= maxX; ++x)
+          m_cells[y * kGridSize + x] = Cell::Boundary;
+      }
+    }
+  };
+
+  if (m_outer.Size() != 0)
+    markEdges(m_outer);
+  for (auto const & inner : m_inners)
+  {
+    if (inner.Size() != 0)
+      markEdges(inner);
+  }
+
+  // No edge crosses the common side of two adjacent not boundary cells, so all the cells of
+  // a connected group of not boundary cells are either inside or outside. The group is
+  // classified by the exact check of any its point.
+  std::vector<bool> visited(m_cells.size(), false);
+  std::vector<size_t> queue;
+  for (size_t start = 0; start < m_cells.size(); ++start)
+  {
+    if (visited[start] || m_cells[start] == Cell::Boundary)
+      continue;
+
+    size_t const startX = start % kGridSize;
+    size_t const startY = start / kGridSize;
+    m2::PointD const center(rect.minX() + (startX + 0.5) * m_cellWidth,
+                            rect.minY() + (startY + 0.5) * m_cellHeight);
+    auto const cell = IsPointInsideExactly(center) ? Cell::Inside : Cell::Outside;
+
+    visited[start] = true;
+    queue.assign(1, start);
+    while (!queue.empty())
+    {
+      auto const curr = queue.back();
+      queue.pop_back();
+      m_cells[curr] = cell;
+
+      size_t const x = curr % kGridSize;
+      size_t const y = curr / kGridSize;
+      auto const visit = [&](size_t next) {
+        if (!visited[next] && m_cells[next] != Cell::Boundary)
+        {
+          visited[next] = true;
+          queue.push_back(next);
+        }
+      };
+      if (x > 0)
+        visit(curr - 1);
+      if (x + 1 < kGridSize)
+        visit(curr + 1);
+      if (y > 0)
+        visit(curr - kGridSize);
+      if (y + 1 < kGridSize)
+        visit(curr + kGridSize);
+    }
+  }
+}
+
 bool Borders::Border::IsPointInside(m2::PointD const & point) const
+{
+  if (m_cells.empty())
+    return IsPointInsideExactly(point);
+
+  if (!m_outer.GetRect().IsPointInside(point))
+    return false;
+
+  switch (m_cells[GetCellY(point.y) * kGridSize + GetCellX(point.x)])
+  {
+  case Cell::Outside: return false;
+  case Cell::Inside: return true;
+  case Cell::Boundary: return IsPointInsideExactly(point);
+  }
+  UNREACHABLE();
+}
+
+boost::optional<double> Borders::Border::FindFirstCrossing(m2::PointD const & from,
+                                                          m2::PointD const & to) const
+{
+  m2::RectD const segmentRect(from, to);
+  if (!segmentRect.IsIntersect(m_outer.GetRect()))
+    return {};
+
+  if (!m_cells.empty())
+  {
+    // The edges lie in the boundary cells only.
+    bool crossesBoundary = false;
+    for (size_t y = GetCellY(segmentRect.minY()); y <= GetCellY(segmentRect.maxY()); ++y)
+    {
+      for (size_t x = GetCellX(segmentRect.minX()); x <= GetCellX(segmentRect.maxX()); ++x)
+        crossesBoundary = crossesBoundary || m_cells[y * kGridSize + x] == Cell::Boundary;
+    }
+    if (!crossesBoundary)
+      return {};
+  }
+
+  boost::optional<double> first;
+  auto const d = to - from;
+  auto const findCrossings = [&](m2::RegionD const & region) {
+    auto const & points = region.Data();
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+    {
+      auto const & p1 = points[j];
+      auto const & p2 = points[i];
+      if (!segmentRect.IsIntersect(m2::RectD(p1, p2)))
+        continue;
+
+      auto const e = p2 - p1;
+      auto const denom = m2::CrossProduct(d, e);
+      if (denom == 0.0)
+        continue;
+
+      // |from| + |d| * t == |p1| + |e| * u.
+      auto const t = m2::CrossProduct(p1 - from, e) / denom;
+      auto const u = m2::CrossProduct(p1 - from, d) / denom;
+      if (t <= 0.0 || t > 1.0 || u < 0.0 || u > 1.0)
+        continue;
+
+      if (!first || t < *first)
+        first = t;
+    }
+  };
+
+  if (m_outer.Size() != 0)
+    findCrossings(m_outer);
+  for (auto const & inner : m_inners)
+  {
+    if (inner.Size() != 0)
+      findCrossings(inner);
+  }
+
+  return first;
+}
+
+size_t Borders::Border::GetCellX(double x) const
+{
+  auto const cell = (x - m_outer.GetRect().minX()) / m_cellWidth;
+  if (cell <= 0.0)
+    return 0;
+  return std::min(static_cast<size_t>(cell), kGridSize - 1);
+}
+
+size_t Borders::Border::GetCellY(double y) const
+{
+  auto const cell = (y - m_outer.GetRect().minY()) / m_cellHeight;
+  if (cell <= 0.0)
+    return 0;
+  return std::min(static_cast<size_t>(cell), kGridSize - 1);
+}
+
+bool Borders::Border::IsPointInsideExactly(m2::PointD const & point) const
 {
   if (!m_outer.Contains(point))
     return false;
@@ -98,6 +286,20 @@ bool Borders::Border::IsPointInside(m2::PointD const & point) const
   return true;
 }
 
+boost::optional<double> Borders::FindFirstCrossing(uint64_t id, m2::PointD const & from,
+                                                   m2::PointD const & to) const
+{
+  boost::optional<double> first;
+  auto const range = m_borders.equal_range(id);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    auto const crossing = it->second.FindFirstCrossing(from, to);
+    if (crossing && (!first || *crossing < *first))
+      first = crossing;
+  }
+  return first;
+}
+
 void Borders::Deserialize(string const & filename)
 {
   BordersVectorReader reader(filename);
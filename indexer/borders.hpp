@@ -9,6 +9,8 @@
 #include <utility>
 #include <vector>
 
+#include <boost/optional.hpp>
+
 namespace indexer
 {
 // Stores region borders for countries, states, cities, city districts in reverse geocoder.
@@ -32,6 +34,12 @@ public:
     return false;
   }
 
+  // Finds the first point of the segment [|from|, |to|] which lies on a border of the region
+  // |id|. Returns the position of the point as the part of the segment length in (0, 1].
+  // The segments which lie along a border edge are not considered as crossing it.
+  boost::optional<double> FindFirstCrossing(uint64_t id, m2::PointD const & from,
+                                            m2::PointD const & to) const;
+
   // Throws Reader::Exception in case of data reading errors.
   void Deserialize(std::string const & filename);
 
@@ -44,18 +52,47 @@ public:
       it->second.m_outer = m2::RegionD(outer);
       for (auto const & inner : inners)
         it->second.m_inners.push_back(m2::RegionD(inner));
+      it->second.Prepare();
     });
   }
 
 private:
   struct Border
   {
+    // The border is covered by a grid of kGridSize x kGridSize cells over the rect of the
+    // outer polygon. A cell which is crossed by no edge lies either inside or outside the
+    // border as a whole, so the points of such a cell are answered by the cell. The points of
+    // the boundary cells are checked exactly.
+    enum class Cell : uint8_t
+    {
+      Outside,
+      Inside,
+      Boundary
+    };
+
+    static size_t constexpr kGridSize = 16;
+    // The borders with less points are checked exactly, the grid would not pay back.
+    static size_t constexpr kMinPointsToPrepare = 32;
+
     Border() = default;
 
+    // Builds the grid. Must be called after |m_outer| and |m_inners| are set.
+    void Prepare();
+
     bool IsPointInside(m2::PointD const & point) const;
+    boost::optional<double> FindFirstCrossing(m2::PointD const & from, m2::PointD const & to) const;
+    bool IsPointInsideExactly(m2::PointD const & point) const;
+
+    size_t GetCellX(double x) const;
+    size_t GetCellY(double y) const;
 
     m2::RegionD m_outer;
     std::vector<m2::RegionD> m_inners;
+
+    // Is empty if the border is not prepared.
+    std::vector<Cell> m_cells;
+    double m_cellWidth = 0.0;
+    double m_cellHeight = 0.0;
   };
 
   std::multimap<uint64_t, Border> m_borders;
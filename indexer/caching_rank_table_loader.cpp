@@ -29,10 +29,14 @@ uint8_t CachingRankTableLoader::Get(FeatureID const & featureId) const
 
   if (it == m_deserializers.end())
   {
-    auto rankTable = search::RankTable::Load(handle.GetValue<MwmValue>()->m_cont, m_sectionName);
-
-    if (!rankTable)
-      rankTable = std::make_unique<search::DummyRankTable>();
+    auto * value = handle.GetValue<MwmValue>();
+    auto rankTable = value->GetSideTable<search::RankTable>(
+        m_sectionName, [&]() -> std::unique_ptr<search::RankTable const> {
+          auto table = search::RankTable::Load(value->m_cont, m_sectionName);
+          if (!table)
+            return std::make_unique<search::DummyRankTable>();
+          return table;
+        });
 
     auto const result = m_deserializers.emplace(featureId.m_mwmId, std::move(rankTable));
     it = result.first;
@@ -14,6 +14,7 @@
 class DataSource;
 struct FeatureID;
 
+// The tables are shared with the other loaders of the same mwms, see MwmValue::GetSideTable().
 // *NOTE* This class IS NOT thread-safe.
 class CachingRankTableLoader
 {
@@ -26,7 +27,7 @@ public:
 private:
   DataSource const & m_dataSource;
   std::string const m_sectionName;
-  mutable std::map<MwmSet::MwmId, std::unique_ptr<search::RankTable const> const> m_deserializers;
+  mutable std::map<MwmSet::MwmId, std::shared_ptr<search::RankTable const> const> m_deserializers;
 
   DISALLOW_COPY(CachingRankTableLoader);
 };
@@ -3,16 +3,50 @@
 #include "indexer/search_delimiters.hpp"
 #include "indexer/search_string_utils.hpp"
 
+#include "coding/read_write_utils.hpp"
 #include "coding/reader.hpp"
 #include "coding/reader_streambuf.hpp"
+#include "coding/varint.hpp"
+#include "coding/write_to_sink.hpp"
+#include "coding/writer.hpp"
 
 #include "base/logging.hpp"
 #include "base/stl_helpers.hpp"
 
+#include <cstring>
+
 using namespace std;
 
 namespace
 {
+// The compiled categories start with the magic and the version.
+char const kCompiledMagic[] = {'C', 'A', 'T', 'S'};
+uint8_t const kCompiledVersion = 0;
+
+template <typename Sink>
+void WriteNames(Sink & sink, vector<CategoriesHolder::Category::Name> const & names)
+{
+  WriteVarUint(sink, static_cast<uint32_t>(names.size()));
+  for (auto const & name : names)
+  {
+    WriteToSink(sink, name.m_locale);
+    WriteToSink(sink, name.m_prefixLengthToSuggest);
+    rw::Write(sink, name.m_name);
+  }
+}
+
+template <typename Source>
+void ReadNames(Source & src, vector<CategoriesHolder::Category::Name> & names)
+{
+  names.resize(ReadVarUint<uint32_t>(src));
+  for (auto & name : names)
+  {
+    name.m_locale = ReadPrimitiveFromSource<int8_t>(src);
+    name.m_prefixLengthToSuggest = ReadPrimitiveFromSource<uint8_t>(src);
+    rw::Read(src, name.m_name);
+  }
+}
+
 enum State
 {
   EParseTypes,
@@ -166,9 +200,16 @@ vector<string> CategoriesHolder::kDisabledLanguages = {"el", "he", "sw"};
 
 CategoriesHolder::CategoriesHolder(unique_ptr<Reader> && reader)
 {
-  ReaderStreamBuf buffer(move(reader));
-  istream s(&buffer);
-  LoadFromStream(s);
+  if (IsCompiled(*reader))
+  {
+    LoadCompiled(*reader);
+  }
+  else
+  {
+    ReaderStreamBuf buffer(move(reader));
+    istream s(&buffer);
+    LoadFromStream(s);
+  }
 
 #if defined(DEBUG)
   for (auto const & entry : kLocaleMapping)
@@ -176,7 +217,8 @@ CategoriesHolder::CategoriesHolder(unique_ptr<Reader> && reader)
 #endif
 }
 
-void CategoriesHolder::AddCategory(Category & cat, vector<uint32_t> & types)
+void CategoriesHolder::AddCategory(Category & cat, vector<uint32_t> & types,
+                                   TrieBuilder & name2type)
 {
   if (!cat.m_synonyms.empty() && !types.empty())
   {
@@ -203,7 +245,7 @@ void CategoriesHolder::AddCategory(Category & cat, vector<uint32_t> & types)
         if (!ValidKeyToken(token))
           continue;
         for (uint32_t const t : types)
-          m_name2type.Add(localePrefix + token, t);
+          name2type.Add(localePrefix + token, t);
       }
     }
   }
@@ -230,9 +272,10 @@ bool CategoriesHolder::ValidKeyToken(strings::UniString const & s)
 void CategoriesHolder::LoadFromStream(istream & s)
 {
   m_type2cat.clear();
-  m_name2type.Clear();
   m_groupTranslations.clear();
 
+  TrieBuilder name2type;
+
   State state = EParseTypes;
   string line;
   Category cat;
@@ -253,7 +296,7 @@ void CategoriesHolder::LoadFromStream(istream & s)
 
     if (state == EParseTypes)
     {
-      AddCategory(cat, types);
+      AddCategory(cat, types, name2type);
       currentGroups.clear();
 
       while (iter)
@@ -291,7 +334,111 @@ void CategoriesHolder::LoadFromStream(istream & s)
     }
   }
   // Add the last category.
-  AddCategory(cat, types);
+  AddCategory(cat, types, name2type);
+
+  m_name2type = Trie(name2type);
+}
+
+void CategoriesHolder::Serialize(Writer & writer) const
+{
+  writer.Write(kCompiledMagic, sizeof(kCompiledMagic));
+  WriteToSink(writer, kCompiledVersion);
+
+  // The categories shared by several types are written once. The pairs of a type and the
+  // index of its category are written in the order of |m_type2cat|, so it is restored as is.
+  vector<Category const *> categories;
+  map<Category const *, uint32_t> indices;
+  for (auto const & p : m_type2cat)
+  {
+    if (indices.emplace(p.second.get(), static_cast<uint32_t>(categories.size())).second)
+      categories.push_back(p.second.get());
+  }
+
+  WriteVarUint(writer, static_cast<uint32_t>(categories.size()));
+  for (auto const * category : categories)
+    WriteNames(writer, category->m_synonyms);
+
+  WriteVarUint(writer, static_cast<uint32_t>(m_type2cat.size()));
+  for (auto const & p : m_type2cat)
+  {
+    WriteVarUint(writer, p.first);
+    WriteVarUint(writer, indices[p.second.get()]);
+  }
+
+  vector<pair<strings::UniString, uint32_t>> tokens;
+  m_name2type.ForEachInTrie([&tokens](strings::UniString const & token, uint32_t type) {
+    tokens.emplace_back(token, type);
+  });
+  WriteVarUint(writer, static_cast<uint32_t>(tokens.size()));
+  for (auto const & token : tokens)
+  {
+    // The token starts with the locale, see ForEachTypeByName().
+    rw::Write(writer, strings::ToUtf8(token.first));
+    WriteVarUint(writer, token.second);
+  }
+
+  WriteVarUint(writer, static_cast<uint32_t>(m_groupTranslations.size()));
+  for (auto const & group : m_groupTranslations)
+  {
+    rw::Write(writer, group.first);
+    WriteNames(writer, group.second);
+  }
+}
+
+// static
+bool CategoriesHolder::IsCompiled(Reader & reader)
+{
+  char magic[sizeof(kCompiledMagic)];
+  if (reader.Size() < sizeof(magic))
+    return false;
+
+  reader.Read(0 /* pos */, magic, sizeof(magic));
+  return memcmp(magic, kCompiledMagic, sizeof(magic)) == 0;
+}
+
+void CategoriesHolder::LoadCompiled(Reader & reader)
+{
+  m_type2cat.clear();
+  m_groupTranslations.clear();
+
+  ReaderSource<Reader &> src(reader);
+  src.Skip(sizeof(kCompiledMagic));
+  auto const version = ReadPrimitiveFromSource<uint8_t>(src);
+  CHECK_EQUAL(version, kCompiledVersion, ("Unknown version of the compiled categories."));
+
+  vector<shared_ptr<Category>> categories(ReadVarUint<uint32_t>(src));
+  for (auto & category : categories)
+  {
+    category = make_shared<Category>();
+    ReadNames(src, category->m_synonyms);
+  }
+
+  auto const typesCount = ReadVarUint<uint32_t>(src);
+  for (uint32_t i = 0; i < typesCount; ++i)
+  {
+    auto const type = ReadVarUint<uint32_t>(src);
+    auto const index = ReadVarUint<uint32_t>(src);
+    CHECK_LESS(index, categories.size(), ());
+    m_type2cat.emplace(type, categories[index]);
+  }
+
+  auto const tokensCount = ReadVarUint<uint32_t>(src);
+  TrieBuilder name2type;
+  string token;
+  for (uint32_t i = 0; i < tokensCount; ++i)
+  {
+    rw::Read(src, token);
+    name2type.Add(strings::MakeUniString(token), ReadVarUint<uint32_t>(src));
+  }
+  m_name2type = Trie(name2type);
+
+  auto const groupsCount = ReadVarUint<uint32_t>(src);
+  string group;
+  for (uint32_t i = 0; i < groupsCount; ++i)
+  {
+    rw::Read(src, group);
+    ReadNames(src, m_groupTranslations[group]);
+  }
 }
 
 bool CategoriesHolder::GetNameByType(uint32_t type, int8_t locale, string & name) const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/frozen_mem_trie.hpp"
 #include "base/mem_trie.hpp"
 #include "base/stl_helpers.hpp"
 #include "base/string_utils.hpp"
@@ -15,6 +16,7 @@
 #include <vector>
 
 class Reader;
+class Writer;
 
 class CategoriesHolder
 {
@@ -51,7 +53,10 @@ public:
 
 private:
   using Type2CategoryCont = std::multimap<uint32_t, std::shared_ptr<Category>>;
-  using Trie = base::MemTrie<strings::UniString, base::VectorValues<uint32_t>>;
+  // The trie is built once on loading and only read afterwards, so it is frozen into
+  // the flat arrays of FrozenMemTrie after the build.
+  using TrieBuilder = base::MemTrie<strings::UniString, base::VectorValues<uint32_t>>;
+  using Trie = base::FrozenMemTrie<strings::UniString, uint32_t>;
 
   Type2CategoryCont m_type2cat;
 
@@ -71,6 +76,7 @@ public:
   // because their translations are not yet complete.
   static std::vector<std::string> kDisabledLanguages;
 
+  // Reads either the text categories or the compiled ones written by Serialize().
   explicit CategoriesHolder(std::unique_ptr<Reader> && reader);
 
   template <class ToDo>
@@ -138,6 +144,11 @@ public:
   Trie const & GetNameToTypesTrie() const { return m_name2type; }
   bool IsTypeExist(uint32_t type) const;
 
+  // Writes the categories, the normalized tokens of their names and the group translations,
+  // so they are read back without parsing and normalizing the text. The types are written
+  // as is, so the compiled categories must be rebuilt when the classificator changes.
+  void Serialize(Writer & writer) const;
+
   void Swap(CategoriesHolder & r)
   {
     m_type2cat.swap(r.m_type2cat);
@@ -154,8 +165,11 @@ public:
   static std::string MapIntegerToLocale(int8_t code);
 
 private:
+  static bool IsCompiled(Reader & reader);
+
   void LoadFromStream(std::istream & s);
-  void AddCategory(Category & cat, std::vector<uint32_t> & types);
+  void LoadCompiled(Reader & reader);
+  void AddCategory(Category & cat, std::vector<uint32_t> & types, TrieBuilder & name2type);
   static bool ValidKeyToken(strings::UniString const & s);
 };
 
@@ -55,6 +55,7 @@ void CategoriesIndex::AddCategoryByTypeAndLang(uint32_t type, int8_t lang)
 {
   ASSERT(lang >= 1 && static_cast<size_t>(lang) <= CategoriesHolder::kLocaleMapping.size(),
          ("Invalid lang code:", lang));
+  CHECK(!m_frozen, ("The index is frozen."));
   m_catHolder->ForEachNameByType(type, [&](Category::Name const & name)
                                  {
                                    if (name.m_locale == lang)
@@ -72,6 +73,7 @@ void CategoriesIndex::AddAllCategoriesInLang(int8_t lang)
 {
   ASSERT(lang >= 1 && static_cast<size_t>(lang) <= CategoriesHolder::kLocaleMapping.size(),
          ("Invalid lang code:", lang));
+  CHECK(!m_frozen, ("The index is frozen."));
   m_catHolder->ForEachTypeAndCategory([&](uint32_t type, Category const & cat)
                                       {
                                         for (auto const & name : cat.m_synonyms)
@@ -84,6 +86,7 @@ void CategoriesIndex::AddAllCategoriesInLang(int8_t lang)
 
 void CategoriesIndex::AddAllCategoriesInAllLangs()
 {
+  CHECK(!m_frozen, ("The index is frozen."));
   m_catHolder->ForEachTypeAndCategory([this](uint32_t type, Category const & cat)
                                       {
                                         for (auto const & name : cat.m_synonyms)
@@ -91,6 +94,16 @@ void CategoriesIndex::AddAllCategoriesInAllLangs()
                                       });
 }
 
+void CategoriesIndex::Freeze()
+{
+  if (m_frozen)
+    return;
+
+  m_frozenTrie = base::FrozenMemTrie<string, uint32_t>(m_trie);
+  m_trie.Clear();
+  m_frozen = true;
+}
+
 void CategoriesIndex::GetCategories(string const & query, vector<Category> & result) const
 {
   vector<uint32_t> types;
@@ -114,7 +127,10 @@ void CategoriesIndex::GetAssociatedTypes(string const & query, vector<uint32_t>
     {
       types.insert(type);
     };
-    m_trie.ForEachInSubtree(token, fn);
+    if (m_frozen)
+      m_frozenTrie.ForEachInSubtree(token, fn);
+    else
+      m_trie.ForEachInSubtree(token, fn);
 
     if (first)
     {
@@ -2,6 +2,7 @@
 
 #include "categories_holder.hpp"
 
+#include "base/frozen_mem_trie.hpp"
 #include "base/mem_trie.hpp"
 
 #include <string>
@@ -25,7 +26,10 @@ public:
   explicit CategoriesIndex(CategoriesHolder const & catHolder) : m_catHolder(&catHolder) {}
 
   CategoriesIndex(CategoriesIndex && other)
-    : m_catHolder(other.m_catHolder), m_trie(move(other.m_trie))
+    : m_catHolder(other.m_catHolder)
+    , m_trie(move(other.m_trie))
+    , m_frozenTrie(move(other.m_frozenTrie))
+    , m_frozen(other.m_frozen)
   {
   }
 
@@ -48,6 +52,10 @@ public:
   // Adds all categories from data/classificator.txt.
   void AddAllCategoriesInAllLangs();
 
+  // Converts the index to a compact read-only form. Call it when all the categories
+  // are added, no categories may be added afterwards.
+  void Freeze();
+
   // Returns all categories that have |query| as a substring. Note
   // that all synonyms for a category are contained in a returned
   // value even if only one language was used when adding this
@@ -61,7 +69,10 @@ public:
   void GetAssociatedTypes(std::string const & query, std::vector<uint32_t> & result) const;
 
 #ifdef DEBUG
-  inline size_t GetNumTrieNodes() const { return m_trie.GetNumNodes(); }
+  inline size_t GetNumTrieNodes() const
+  {
+    return m_frozen ? m_frozenTrie.GetNumNodes() : m_trie.GetNumNodes();
+  }
 #endif
 
 private:
@@ -70,5 +81,7 @@ private:
   // so a default constructor is needed.
   CategoriesHolder const * m_catHolder = nullptr;
   base::MemTrie<std::string, base::VectorValues<uint32_t>> m_trie;
+  base::FrozenMemTrie<std::string, uint32_t> m_frozenTrie;
+  bool m_frozen = false;
 };
 }  // namespace indexer
@@ -20,8 +20,17 @@ namespace search
 bool CentersTable::Get(uint32_t id, m2::PointD & center)
 {
   m2::PointU pointu;
-  if (!m_map->Get(id, pointu))
+  if (m_fixedWidthMap)
+  {
+    uint64_t packed;
+    if (!m_fixedWidthMap->Get(id, packed))
+      return false;
+    pointu = Unpack(packed);
+  }
+  else if (!m_map->Get(id, pointu))
+  {
     return false;
+  }
 
   center = PointUToPointD(pointu, m_codingParams.GetCoordBits());
   return true;
@@ -38,6 +47,18 @@ unique_ptr<CentersTable> CentersTable::Load(Reader & reader,
   return table;
 }
 
+// static
+unique_ptr<CentersTable> CentersTable::LoadFixedWidth(
+    Reader & reader, serial::GeometryCodingParams const & codingParams)
+{
+  auto table = make_unique<CentersTable>();
+  table->m_codingParams = codingParams;
+  table->m_fixedWidthMap = FixedWidthMap::LoadFixedWidth(reader);
+  if (!table->m_fixedWidthMap)
+    return {};
+  return table;
+}
+
 bool CentersTable::Init(Reader & reader, serial::GeometryCodingParams const & codingParams)
 {
   m_codingParams = codingParams;
@@ -85,4 +106,13 @@ void CentersTableBuilder::Freeze(Writer & writer) const
 
   m_builder.Freeze(writer, writeBlockCallback);
 }
+
+void CentersTableBuilder::FreezeFixedWidth(Writer & writer) const
+{
+  MapUint32ToValueBuilder<uint64_t> builder;
+  m_builder.ForEach([&builder](uint32_t id, m2::PointU const & pointu) {
+    builder.Put(id, CentersTable::Pack(pointu));
+  });
+  builder.FreezeFixedWidth(writer);
+}
 }  // namespace search
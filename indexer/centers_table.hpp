@@ -2,6 +2,7 @@
 
 #include "coding/geometry_coding.hpp"
 #include "coding/map_uint32_to_val.hpp"
+#include "coding/point_coding.hpp"
 
 #include "geometry/point2d.hpp"
 
@@ -23,18 +24,56 @@ public:
   // false if table does not have entry for the feature.
   WARN_UNUSED_RESULT bool Get(uint32_t id, m2::PointD & center);
 
+  // Calls |fn(id, center)| for each of the sorted |ids| which has an entry in the table.
+  // Each block of centers is decoded once for all the ids it covers.
+  template <typename Fn>
+  void GetMany(std::vector<uint32_t> const & ids, Fn && fn)
+  {
+    auto const coordBits = m_codingParams.GetCoordBits();
+    if (m_fixedWidthMap)
+    {
+      m_fixedWidthMap->GetMany(ids, [&](uint32_t id, uint64_t packed) {
+        fn(id, PointUToPointD(Unpack(packed), coordBits));
+      });
+      return;
+    }
+
+    m_map->GetMany(ids, [&](uint32_t id, m2::PointU const & pointu) {
+      fn(id, PointUToPointD(pointu, coordBits));
+    });
+  }
+
   // Loads CentersTable instance. Note that |reader| must be alive
   // until the destruction of loaded table. Returns nullptr if
   // CentersTable can't be loaded.
   static std::unique_ptr<CentersTable> Load(Reader & reader,
                                             serial::GeometryCodingParams const & codingParams);
+
+  // Loads the table written by CentersTableBuilder::FreezeFixedWidth(). The same as Load()
+  // otherwise.
+  static std::unique_ptr<CentersTable> LoadFixedWidth(
+      Reader & reader, serial::GeometryCodingParams const & codingParams);
+
+  static uint64_t Pack(m2::PointU const & pointu)
+  {
+    return (static_cast<uint64_t>(pointu.x) << 32) | pointu.y;
+  }
+
+  static m2::PointU Unpack(uint64_t packed)
+  {
+    return m2::PointU(static_cast<uint32_t>(packed >> 32), static_cast<uint32_t>(packed));
+  }
+
 private:
   using Map = MapUint32ToValue<m2::PointU>;
+  using FixedWidthMap = MapUint32ToValue<uint64_t>;
 
   bool Init(Reader & reader, serial::GeometryCodingParams const & codingParams);
 
   serial::GeometryCodingParams m_codingParams;
+  // Exactly one of the maps is loaded.
   std::unique_ptr<Map> m_map;
+  std::unique_ptr<FixedWidthMap> m_fixedWidthMap;
 };
 
 class CentersTableBuilder
@@ -47,6 +86,9 @@ public:
 
   void Put(uint32_t featureId, m2::PointD const & center);
   void Freeze(Writer & writer) const;
+  // Writes the centers as the raw packed points, so they are read without decoding. Takes
+  // about twice as much space as Freeze().
+  void FreezeFixedWidth(Writer & writer) const;
 
 private:
   serial::GeometryCodingParams m_codingParams;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "indexer/city_boundary.hpp"
+#include "indexer/packed_cities_boundaries.hpp"
 
 #include "coding/bit_streams.hpp"
 #include "coding/elias_coder.hpp"
@@ -316,6 +317,32 @@ public:
     }
   }
 
+  // The boundaries of the city |i| are added as the ones of |i|, Build() is not called.
+  void operator()(PackedCitiesBoundaries & boundaries)
+  {
+    auto const size = static_cast<size_t>(ReadVarUint<uint64_t>(m_source));
+    std::vector<size_t> counts(size);
+    {
+      BitReader<Source> reader(m_source);
+      for (auto & count : counts)
+      {
+        count = static_cast<size_t>(coding::GammaCoder::Decode(reader));
+        ASSERT_GREATER_OR_EQUAL(count, 1, ());
+        --count;
+      }
+    }
+
+    CityBoundary boundary;
+    for (size_t i = 0; i < size; ++i)
+    {
+      for (size_t j = 0; j < counts[i]; ++j)
+      {
+        m_visitor(boundary);
+        boundaries.Add(base::checked_cast<uint32_t>(i), boundary);
+      }
+    }
+  }
+
 private:
   Source & m_source;
   Visitor m_visitor;
@@ -400,6 +427,28 @@ struct CitiesBoundariesSerDes
   template <typename Source>
   static void Deserialize(Source & source, std::vector<std::vector<CityBoundary>> & boundaries,
                           double & precision)
+  {
+    auto const params = DeserializeHeader(source, precision);
+    CitiesBoundariesDecoderV0<Source> decoder(source, params);
+    decoder(boundaries);
+  }
+
+  // The boundaries are decoded to |boundaries| and packed for the tests with |precision|,
+  // see PackedCitiesBoundaries::Build(eps).
+  template <typename Source>
+  static void Deserialize(Source & source, PackedCitiesBoundaries & boundaries,
+                          double & precision)
+  {
+    auto const params = DeserializeHeader(source, precision);
+    CitiesBoundariesDecoderV0<Source> decoder(source, params);
+    boundaries.Clear();
+    decoder(boundaries);
+    boundaries.Build(precision);
+  }
+
+private:
+  template <typename Source>
+  static serial::GeometryCodingParams DeserializeHeader(Source & source, double & precision)
   {
     ReadFromSourceVisitor<Source> visitor(source);
 
@@ -415,10 +464,8 @@ struct CitiesBoundariesSerDes
     auto const wy = MercatorBounds::kRangeY;
     precision = std::max(wx, wy) / pow(2, header.m_coordBits);
 
-    serial::GeometryCodingParams const params(
+    return serial::GeometryCodingParams(
         header.m_coordBits, m2::PointD(MercatorBounds::kMinX, MercatorBounds::kMinY));
-    CitiesBoundariesDecoderV0<Source> decoder(source, params);
-    decoder(boundaries);
   }
 };
 }  // namespace indexer
@@ -422,7 +422,7 @@ uint32_t Classificator::GetTypeByReadableObjectName(string const & name) const
 
 void Classificator::ReadTypesMapping(istream & s)
 {
-  m_mapping.Load(s);
+  m_mapping.Load(s, *this);
 }
 
 void Classificator::Clear()
@@ -431,6 +431,13 @@ void Classificator::Clear()
   m_mapping.Clear();
 }
 
+void Classificator::CopyFrom(Classificator const & other)
+{
+  m_root = other.m_root;
+  m_mapping = other.m_mapping;
+  m_coastType = other.m_coastType;
+}
+
 string Classificator::GetReadableObjectName(uint32_t type) const
 {
   string s = GetFullObjectName(type);
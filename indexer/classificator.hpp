@@ -115,6 +115,7 @@ public:
 
   using VisibleMask = std::bitset<scales::UPPER_STYLE_SCALE+1>;
   void SetVisibilityOnScale(bool isVisible, int scale) { m_visibility[scale] = isVisible; }
+  VisibleMask const & GetVisibility() const { return m_visibility; }
 
   /// @name Policies for classificator tree serialization.
   //@{
@@ -169,6 +170,8 @@ public:
   //@}
 
   void Clear();
+  // Copies the tree and the types mapping of |other|, which are the same for all the styles.
+  void CopyFrom(Classificator const & other);
 
   bool HasTypesMapping() const { return m_mapping.IsLoaded(); }
 
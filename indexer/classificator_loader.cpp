@@ -1,4 +1,5 @@
 #include "indexer/classificator.hpp"
+#include "indexer/classificator_type_path.hpp"
 #include "indexer/drawing_rules.hpp"
 #include "indexer/map_style_reader.hpp"
 
@@ -15,9 +16,8 @@
 namespace
 {
 void ReadCommon(std::unique_ptr<Reader> classificator,
-                std::unique_ptr<Reader> types)
+                std::unique_ptr<Reader> types, Classificator & c)
 {
-  Classificator & c = classif();
   c.Clear();
 
   {
@@ -35,6 +35,10 @@ void ReadCommon(std::unique_ptr<Reader> classificator,
     std::istream s(&buffer);
     c.ReadTypesMapping(s);
   }
+
+  classificator::ResolveTypePaths(c);
+  for (auto const & path : classificator::GetUnresolvedTypePaths())
+    LOG(LERROR, ("Unresolved type path", path));
 }
 }  // namespace
 
@@ -48,6 +52,11 @@ void Load()
 
   MapStyle const originMapStyle = GetStyleReader().GetCurrentStyle();
 
+  // The classificator and the types don't depend on the style, so they are parsed once and
+  // are copied to the classificators of the styles before their drawing rules are applied.
+  Classificator parsed;
+  ReadCommon(p.GetReader("classificator.txt"), p.GetReader("types.txt"), parsed);
+
   for (size_t i = 0; i < MapStyleCount; ++i)
   {
     auto const mapStyle = static_cast<MapStyle>(i);
@@ -55,8 +64,7 @@ void Load()
     if (mapStyle != MapStyleMerged || originMapStyle == MapStyleMerged)
     {
       GetStyleReader().SetCurrentStyle(mapStyle);
-      ReadCommon(p.GetReader("classificator.txt"),
-                 p.GetReader("types.txt"));
+      classif().CopyFrom(parsed);
 
       drule::LoadRules();
     }
@@ -73,6 +81,7 @@ void LoadTypes(std::string const & classificatorFileStr,
   ReadCommon(std::make_unique<MemReaderWithExceptions>(classificatorFileStr.data(),
                                                        classificatorFileStr.size()),
              std::make_unique<MemReaderWithExceptions>(typesFileStr.data(),
-                                                       typesFileStr.size()));
+                                                       typesFileStr.size()),
+             classif());
 }
 }  // namespace classificator
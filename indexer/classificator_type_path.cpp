@@ -0,0 +1,102 @@
+#include "indexer/classificator_type_path.hpp"
+
+#include "indexer/classificator.hpp"
+
+#include "base/assert.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace classificator
+{
+namespace
+{
+class TypePathsRegistry
+{
+public:
+  static TypePathsRegistry & Instance()
+  {
+    static TypePathsRegistry registry;
+    return registry;
+  }
+
+  uint32_t Register(char const * path, uint64_t key, uint32_t const *& type)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const it = m_ids.find(key);
+    if (it != m_ids.end())
+    {
+      CHECK_EQUAL(m_paths[it->second], path, ("Hash collision of the type paths."));
+      type = &m_types[it->second];
+      return it->second;
+    }
+
+    auto const id = static_cast<uint32_t>(m_paths.size());
+    m_ids.emplace(key, id);
+    m_paths.emplace_back(path);
+    m_types.push_back(m_resolved ? classif().GetTypeByReadableObjectName(path) : 0);
+    type = &m_types.back();
+    return id;
+  }
+
+  void Resolve(Classificator const & c)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_paths.size(); ++i)
+      m_types[i] = c.GetTypeByReadableObjectName(m_paths[i]);
+    m_resolved = true;
+  }
+
+  std::vector<std::string> GetUnresolved() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> unresolved;
+    for (size_t i = 0; i < m_paths.size(); ++i)
+    {
+      if (m_types[i] == 0)
+        unresolved.push_back(m_paths[i]);
+    }
+    return unresolved;
+  }
+
+  std::string const & GetPath(uint32_t id) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_paths[id];
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::unordered_map<uint64_t, uint32_t> m_ids;
+  // The deques keep the references to the elements valid when the paths are added.
+  std::deque<std::string> m_paths;
+  std::deque<uint32_t> m_types;
+  bool m_resolved = false;
+};
+}  // namespace
+
+TypePath::TypePath(char const * path)
+{
+  m_id = TypePathsRegistry::Instance().Register(path, HashTypePath(path), m_type);
+}
+
+uint32_t TypePath::Get() const
+{
+  auto const type = *m_type;
+  CHECK_NOT_EQUAL(type, 0, ("Unresolved type path", GetPath()));
+  return type;
+}
+
+std::string const & TypePath::GetPath() const
+{
+  return TypePathsRegistry::Instance().GetPath(m_id);
+}
+
+void ResolveTypePaths(Classificator const & c) { TypePathsRegistry::Instance().Resolve(c); }
+
+std::vector<std::string> GetUnresolvedTypePaths()
+{
+  return TypePathsRegistry::Instance().GetUnresolved();
+}
+}  // namespace classificator
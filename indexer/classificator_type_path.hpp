@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Classificator;
+
+namespace classificator
+{
+// Returns the FNV-1a hash of the readable name of a type, e.g. "route-ferry". It is the key
+// of the type path in the registry, so the same path registered in many places is resolved once.
+constexpr uint64_t HashTypePath(char const * path, uint64_t hash = 14695981039346656037ULL)
+{
+  return *path == '\0'
+             ? hash
+             : HashTypePath(path + 1, (hash ^ static_cast<uint8_t>(*path)) * 1099511628211ULL);
+}
+
+// A type by its readable name, e.g. "railway-station-subway". The paths are registered by
+// TypePath objects and are resolved to the types all at once when the classificator is loaded,
+// so the type is got without the walk of the classificator tree by the strings. A path
+// registered after the classificator is loaded is resolved at the registration.
+// Usage:
+//   static classificator::TypePath const kFerryType("route-ferry");
+//   ... kFerryType.Get() ...
+class TypePath
+{
+public:
+  explicit TypePath(char const * path);
+
+  // Returns the type of the path. CHECKs that the path is resolved.
+  uint32_t Get() const;
+  std::string const & GetPath() const;
+
+private:
+  uint32_t m_id;
+  // Points to the resolved type in the registry, the type is 0 for an unresolved path.
+  uint32_t const * m_type;
+};
+
+// Resolves all the registered type paths by |c|. It is called by Load() and LoadTypes().
+void ResolveTypePaths(Classificator const & c);
+// Returns the registered paths which are not found in the loaded classificator. Use it to check
+// the paths at startup.
+std::vector<std::string> GetUnresolvedTypePaths();
+}  // namespace classificator
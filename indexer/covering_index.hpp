@@ -15,10 +15,14 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "defines.hpp"
 
@@ -45,19 +49,51 @@ public:
     ForEachInRect(processObject, m2::RectD(point, point));
   }
 
-  void ForEachInRect(ProcessObject const & processObject, m2::RectD const & rect) const
+  // The covering of |rect| is looked up in |cache| when it is not null.
+  void ForEachInRect(ProcessObject const & processObject, m2::RectD const & rect,
+                     covering::CoveringCache * cache = nullptr) const
   {
-    covering::CoveringGetter cov(rect, covering::CoveringMode::ViewportWithLowLevels);
-    covering::Intervals const & intervals = cov.Get<DEPTH_LEVELS>(scales::GetUpperScale());
+    covering::CoveringGetter cov(rect, covering::CoveringMode::ViewportWithLowLevels, cache);
+    ForEachInIntervals(processObject, cov.Get<DEPTH_LEVELS>(scales::GetUpperScale()));
+  }
 
-    for (auto const & i : intervals)
+  // The intervals of the index cells covering |rect|. The rects with the same intervals
+  // have the same objects, so the lookups may be shared between them.
+  static covering::Intervals GetRectIntervals(m2::RectD const & rect,
+                                              covering::CoveringCache * cache = nullptr)
+  {
+    covering::CoveringGetter cov(rect, covering::CoveringMode::ViewportWithLowLevels, cache);
+    return cov.Get<DEPTH_LEVELS>(scales::GetUpperScale());
+  }
+
+  void ForEachInIntervals(ProcessObject const & processObject,
+                          covering::Intervals const & intervals) const
+  {
+    auto const processStoredId = [&processObject](uint64_t /* key */, uint64_t storedId) {
+      processObject(CoveredObject::FromStoredId(storedId));
+    };
+
+    // The merged intervals of the rect coverings are walked at once.
+    if (covering::IsSortedAndDisjoint(intervals))
     {
-      m_intervalIndex->ForEach(
-            [&processObject](uint64_t /* key */, uint64_t storedId) {
-        processObject(CoveredObject::FromStoredId(storedId));
-      },
-      i.first, i.second);
+      m_intervalIndex->ForEachInIntervals(processStoredId, intervals);
+      return;
     }
+
+    for (auto const & i : intervals)
+      m_intervalIndex->ForEach(processStoredId, i.first, i.second);
+  }
+
+  // Applies |toDo| to all the (cell, object) pairs of the index in the order of the cells,
+  // which is the order of the pairs in the lookups.
+  template <typename ToDo>
+  void ForEachCell(ToDo && toDo) const
+  {
+    m_intervalIndex->ForEach(
+        [&toDo](uint64_t key, uint64_t storedId) {
+          toDo(key, CoveredObject::FromStoredId(storedId));
+        },
+        0, std::numeric_limits<uint64_t>::max());
   }
 
   // Applies |processObject| to the objects located within |radiusM| meters from |center|.
@@ -72,50 +108,13 @@ public:
   void ForClosestToPoint(ProcessCloseObject const & processObject, m2::PointD const & center,
                          double radiusM, uint32_t sizeHint) const
   {
-    using Converter = CellIdConverter<MercatorBounds, m2::CellId<DEPTH_LEVELS>>;
-
-    auto const rect =
-        MercatorBounds::RectByCenterXYAndSizeInMeters(center, radiusM);
-    covering::CoveringGetter cov(rect, covering::CoveringMode::Spiral);
-    covering::Intervals const & intervals = cov.Get<DEPTH_LEVELS>(scales::GetUpperScale());
-
-    CHECK_EQUAL(intervals.begin()->first, intervals.begin()->second - 1, ());
-    auto cellDepth = covering::GetCodingDepth<DEPTH_LEVELS>(scales::GetUpperScale());
-    auto bestCell = m2::CellId<DEPTH_LEVELS>::FromInt64(intervals.begin()->first, cellDepth);
-    std::set<int64_t> bestCells;
-    while (bestCell.Level() > 0)
-    {
-      bestCells.insert(bestCell.ToInt64(cellDepth));
-      bestCell = bestCell.Parent();
-    }
-
+    ClosenessWeights const closeness{center, radiusM};
     std::map<uint64_t, double> objectWeights{};
 
-    auto const centralCell = Converter::ToCellId(center.x, center.y);
-    auto const centralCellXY = centralCell.XY();
-
-    auto chebyshevDistance = [centralCellXY] (auto && cellXY) {
-      auto absDiff = [](auto && a, auto && b) { return a > b ? a - b : b - a; };
-      auto const distanceX = absDiff(centralCellXY.first, cellXY.first);
-      auto const distanceY = absDiff(centralCellXY.second, cellXY.second);
-      return std::max(distanceX, distanceY);
-    };
-
-    auto cellRelativeWeight = [&] (int64_t cellNumber) {
-      if (bestCells.find(cellNumber) != bestCells.end())
-        return 1.0;
-
-      auto const cell = m2::CellId<DEPTH_LEVELS>::FromInt64(cellNumber, cellDepth);
-      auto const distance = chebyshevDistance(cell.XY()) - cell.Radius();
-      CHECK_GREATER(distance, 0, ());
-
-      return 1.0 / distance;
-    };
-
     auto insertObject = [&] (int64_t cellNumber, uint64_t storedId) {
       auto const objectId = CoveredObject::FromStoredId(storedId).GetEncodedId();
       auto & objectWeight = objectWeights[objectId];
-      objectWeight = std::max(objectWeight, cellRelativeWeight(cellNumber));
+      objectWeight = std::max(objectWeight, closeness.GetWeight(cellNumber));
     };
 
     auto insertObjectWithinSizeLimit = [&](int64_t cellNumber, uint64_t storedId) {
@@ -123,9 +122,9 @@ public:
         insertObject(cellNumber, storedId);
     };
 
-    for (auto const & i : intervals)
+    for (auto const & i : closeness.GetIntervals())
     {
-      if (bestCells.find(i.first) != bestCells.end())
+      if (closeness.IsBestCell(i.first))
         m_intervalIndex->ForEach(insertObject, i.first, i.second);
       else if (objectWeights.size() < sizeHint)
         m_intervalIndex->ForEach(insertObjectWithinSizeLimit, i.first, i.second);
@@ -137,7 +136,134 @@ public:
       processObject(base::GeoObjectId(object.first), object.second);
   }
 
+  // Applies |processObject| to the |k| objects located within |radiusM| meters from |center|
+  // with the greatest closeness weights (see ForClosestToPoint()) in the order of decreasing
+  // weights. The cells are walked from the closest one and the walk stops as soon as the next
+  // cell is farther than the |k|-th object, so only the cells which may change the result are
+  // read. The objects with the same weight as the |k|-th object are processed too,
+  // thus probably overflowing the |k| limit.
+  void ForKNearestToPoint(ProcessCloseObject const & processObject, m2::PointD const & center,
+                          double radiusM, uint32_t k) const
+  {
+    if (k == 0)
+      return;
+
+    ClosenessWeights const closeness{center, radiusM};
+    // The intervals with their greatest weight: the weight of the cell of the interval
+    // is not less than the weights of its subcells.
+    std::vector<std::pair<double, covering::Interval>> intervals;
+    for (auto const & i : closeness.GetIntervals())
+      intervals.emplace_back(closeness.GetWeight(i.first), i);
+    std::stable_sort(intervals.begin(), intervals.end(),
+                     [](auto const & l, auto const & r) { return l.first > r.first; });
+
+    std::unordered_map<uint64_t, double> objectWeights;
+    std::vector<double> weights;
+    // The weight of the |k|-th object when there are |k| objects.
+    auto const getKthWeight = [&]() {
+      weights.clear();
+      for (auto const & object : objectWeights)
+        weights.push_back(object.second);
+      std::nth_element(weights.begin(), weights.begin() + (k - 1), weights.end(),
+                       std::greater<double>());
+      return weights[k - 1];
+    };
+
+    auto insertObject = [&](int64_t cellNumber, uint64_t storedId) {
+      auto const objectId = CoveredObject::FromStoredId(storedId).GetEncodedId();
+      auto & objectWeight = objectWeights[objectId];
+      objectWeight = std::max(objectWeight, closeness.GetWeight(cellNumber));
+    };
+
+    double kthWeight = 0.0;
+    for (auto const & i : intervals)
+    {
+      if (objectWeights.size() >= k && i.first < kthWeight)
+        break;
+
+      m_intervalIndex->ForEach(insertObject, i.second.first, i.second.second);
+      if (objectWeights.size() >= k)
+        kthWeight = getKthWeight();
+    }
+
+    if (objectWeights.empty())
+      return;
+
+    std::vector<std::pair<uint64_t, double>> result(objectWeights.begin(), objectWeights.end());
+    std::sort(result.begin(), result.end(), [](auto const & l, auto const & r) {
+      return l.second != r.second ? l.second > r.second : l.first < r.first;
+    });
+    auto const lastWeight = result[std::min<size_t>(k, result.size()) - 1].second;
+    for (auto const & object : result)
+    {
+      if (object.second < lastWeight)
+        break;
+      processObject(base::GeoObjectId(object.first), object.second);
+    }
+  }
+
 private:
+  // Spiral covering around a point and the closeness weights of its cells.
+  class ClosenessWeights
+  {
+  public:
+    ClosenessWeights(m2::PointD const & center, double radiusM)
+      : m_rect(MercatorBounds::RectByCenterXYAndSizeInMeters(center, radiusM))
+      , m_cellDepth(covering::GetCodingDepth<DEPTH_LEVELS>(scales::GetUpperScale()))
+      , m_centralCellXY(Converter::ToCellId(center.x, center.y).XY())
+    {
+      covering::CoveringGetter cov(m_rect, covering::CoveringMode::Spiral);
+      m_intervals = cov.Get<DEPTH_LEVELS>(scales::GetUpperScale());
+
+      CHECK_EQUAL(m_intervals.begin()->first, m_intervals.begin()->second - 1, ());
+      auto bestCell = m2::CellId<DEPTH_LEVELS>::FromInt64(m_intervals.begin()->first, m_cellDepth);
+      while (bestCell.Level() > 0)
+      {
+        m_bestCells.insert(bestCell.ToInt64(m_cellDepth));
+        bestCell = bestCell.Parent();
+      }
+    }
+
+    covering::Intervals const & GetIntervals() const { return m_intervals; }
+
+    // Whether the cell encloses the central cell.
+    bool IsBestCell(int64_t cellNumber) const
+    {
+      return m_bestCells.find(cellNumber) != m_bestCells.end();
+    }
+
+    double GetWeight(int64_t cellNumber) const
+    {
+      if (IsBestCell(cellNumber))
+        return 1.0;
+
+      auto const cell = m2::CellId<DEPTH_LEVELS>::FromInt64(cellNumber, m_cellDepth);
+      auto const distance = ChebyshevDistance(cell.XY()) - cell.Radius();
+      CHECK_GREATER(distance, 0, ());
+
+      return 1.0 / distance;
+    }
+
+  private:
+    using Converter = CellIdConverter<MercatorBounds, m2::CellId<DEPTH_LEVELS>>;
+
+    template <typename CellXY>
+    auto ChebyshevDistance(CellXY const & cellXY) const
+    {
+      auto absDiff = [](auto && a, auto && b) { return a > b ? a - b : b - a; };
+      auto const distanceX = absDiff(m_centralCellXY.first, cellXY.first);
+      auto const distanceY = absDiff(m_centralCellXY.second, cellXY.second);
+      return std::max(distanceX, distanceY);
+    }
+
+    // The covering getter keeps a reference to the rect.
+    m2::RectD m_rect;
+    int m_cellDepth;
+    std::pair<uint32_t, uint32_t> m_centralCellXY;
+    covering::Intervals m_intervals;
+    std::set<int64_t> m_bestCells;
+  };
+
   std::unique_ptr<IntervalIndex<Reader, uint64_t>> m_intervalIndex;
 };
 
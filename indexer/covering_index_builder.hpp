@@ -16,10 +16,16 @@
 
 #include "defines.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <future>
+#include <list>
+#include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/sort/sort.hpp>
@@ -27,6 +33,53 @@
 namespace covering
 {
 using ObjectsCovering = std::deque<CellValuePair<uint64_t>>;
+// Parts of the covering filled by the different threads.
+using ObjectsCoverings = std::list<ObjectsCovering>;
+
+// Input iterator over the merged sorted coverings.
+class MergedCoveringsIterator
+{
+public:
+  using value_type = CellValuePair<uint64_t>;
+
+  MergedCoveringsIterator() = default;
+  explicit MergedCoveringsIterator(ObjectsCoverings const & coverings)
+  {
+    for (auto const & covering : coverings)
+    {
+      if (!covering.empty())
+        m_heads.emplace(covering.begin(), covering.end());
+    }
+  }
+
+  value_type const & operator*() const { return *m_heads.top().first; }
+  value_type const * operator->() const { return &*m_heads.top().first; }
+
+  MergedCoveringsIterator & operator++()
+  {
+    auto head = m_heads.top();
+    m_heads.pop();
+    if (++head.first != head.second)
+      m_heads.push(head);
+    return *this;
+  }
+
+  bool operator==(MergedCoveringsIterator const & rhs) const
+  {
+    return m_heads.empty() && rhs.m_heads.empty();
+  }
+  bool operator!=(MergedCoveringsIterator const & rhs) const { return !(*this == rhs); }
+
+private:
+  using Head = std::pair<ObjectsCovering::const_iterator, ObjectsCovering::const_iterator>;
+
+  struct HeadGreater
+  {
+    bool operator()(Head const & l, Head const & r) const { return *r.first < *l.first; }
+  };
+
+  std::priority_queue<Head, std::vector<Head>, HeadGreater> m_heads;
+};
 }  // namespace covering
 
 namespace indexer
@@ -50,14 +103,18 @@ public:
       covering.emplace_back(cell, id);
   }
 
-  bool BuildCoveringIndex(covering::ObjectsCovering && covering,
+  bool BuildCoveringIndex(covering::ObjectsCoverings && coverings,
                           std::string const & localityIndexPath) const
   {
+    size_t cellsCount = 0;
+    for (auto const & covering : coverings)
+      cellsCount += covering.size();
+
     std::vector<char> buffer;
-    buffer.reserve(covering.size() * 10 /* ~ ratio file-size / cell-pair */);
+    buffer.reserve(cellsCount * 10 /* ~ ratio file-size / cell-pair */);
     MemWriter<std::vector<char>> indexWriter{buffer};
 
-    BuildCoveringIndex(std::move(covering), indexWriter, BuilderSpec::kDepthLevels);
+    BuildCoveringIndex(std::move(coverings), indexWriter, BuilderSpec::kDepthLevels);
 
     try
     {
@@ -76,13 +133,35 @@ public:
   template <typename Writer>
   void BuildCoveringIndex(covering::ObjectsCovering && covering, Writer && writer,
                           int depthLevel) const
+  {
+    covering::ObjectsCoverings coverings;
+    coverings.push_back(std::move(covering));
+    BuildCoveringIndex(std::move(coverings), std::forward<Writer>(writer), depthLevel);
+  }
+
+  // The parts of the covering are sorted concurrently and merged into the index without
+  // copying them into the whole covering.
+  template <typename Writer>
+  void BuildCoveringIndex(covering::ObjectsCoverings && coverings, Writer && writer,
+                          int depthLevel) const
   {
     // 32 threads block_indirect_sort is fastest for |block_size| (internal parameter) and
     // sizeof(CellValuePair<uint64_t>).
-    auto sortThreadsCount = std::min(32u, std::thread::hardware_concurrency());
-    boost::sort::block_indirect_sort(covering.begin(), covering.end(), sortThreadsCount);
+    auto const sortThreadsCount = std::min(32u, std::thread::hardware_concurrency());
+    auto const partsCount = static_cast<unsigned int>(std::max<size_t>(coverings.size(), 1));
+    auto const partSortThreadsCount = std::max(1u, sortThreadsCount / partsCount);
+    std::vector<std::future<void>> sorts;
+    for (auto & covering : coverings)
+    {
+      sorts.push_back(m_threadPool.Submit([&covering, partSortThreadsCount]() {
+        boost::sort::block_indirect_sort(covering.begin(), covering.end(), partSortThreadsCount);
+      }));
+    }
+    for (auto & sort : sorts)
+      sort.get();
 
-    BuildIntervalIndex(covering.begin(), covering.end(), std::forward<Writer>(writer),
+    BuildIntervalIndex(covering::MergedCoveringsIterator{coverings},
+                       covering::MergedCoveringsIterator{}, std::forward<Writer>(writer),
                        depthLevel * 2 + 1, IntervalIndexVersion::V2);
   }
 
@@ -95,11 +174,15 @@ struct RegionsIndexBuilderSpec
 {
   static constexpr int kDepthLevels = kRegionsDepthLevels;
   static constexpr auto const & kIndexFileTag = REGIONS_INDEX_FILE_TAG;
+  // About the number of the cells at the boundary of a region, the countries and the states
+  // are covered by the coarser cells than the cities. The candidates in the boundary cells are
+  // checked by the borders anyway.
+  static constexpr size_t kCellsBudget = 1 << 14;
 
   std::vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth,
                              base::thread_pool::computational::ThreadPool & threadPool) const
   {
-    return covering::CoverRegion(o, cellDepth, threadPool);
+    return covering::CoverRegion(o, cellDepth, kCellsBudget, threadPool);
   }
 };
 
@@ -107,11 +190,14 @@ struct GeoObjectsIndexBuilderSpec
 {
   static constexpr int kDepthLevels = kGeoObjectsDepthLevels;
   static constexpr auto const & kIndexFileTag = GEO_OBJECTS_INDEX_FILE_TAG;
+  // The buildings and the POIs are covered with the full depth, the budget limits the coverings
+  // of the rare big objects.
+  static constexpr size_t kCellsBudget = 1 << 12;
 
   std::vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth,
                              base::thread_pool::computational::ThreadPool & /* threadPool */) const
   {
-    return covering::CoverGeoObject(o, cellDepth);
+    return covering::CoverGeoObject(o, cellDepth, kCellsBudget);
   }
 };
 
@@ -73,6 +73,13 @@ namespace feature
     version::Format GetFormat() const { return m_format; }
     bool IsMWMSuitable() const { return m_format <= version::Format::lastFormat; }
 
+    /// Whether the outer paths are stored in the columnar point blocks.
+    /// The header which is being built has no format and is written in the last one.
+    bool HasPointsBlocks() const
+    {
+      return m_format == version::Format::unknownFormat || m_format >= version::Format::v10;
+    }
+
     void Save(FileWriter & w) const;
     void Load(FilesContainerR const & cont);
 
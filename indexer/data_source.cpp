@@ -1,8 +1,10 @@
 #include "indexer/data_source.hpp"
 
 #include "base/logging.hpp"
+#include "base/thread_pool_computational.hpp"
 
 #include <algorithm>
+#include <future>
 
 using platform::CountryFile;
 using platform::LocalCountryFile;
@@ -51,16 +53,27 @@ public:
       covering::Intervals const & intervals = cov.Get<RectId::DEPTH_LEVELS>(lastScale);
       ScaleIndex<ModelReaderPtr> index(mwmValue->m_cont.GetReader(INDEX_FILE_TAG), mwmValue->m_factory);
 
-      // iterate through intervals
-      for (auto const & i : intervals)
+      auto const processValue = [&](uint64_t /* key */, uint32_t value) {
+        if (!checkUnique(value))
+          return;
+        m_fn(value, *src);
+      };
+
+      // The merged intervals are walked at once, the spiral intervals are walked in their order
+      // to read the closest features first.
+      if (covering::IsSortedAndDisjoint(intervals))
+      {
+        index.ForEachInIntervalsAndScale(intervals, scale, processValue);
+      }
+      else
       {
-        index.ForEachInIntervalAndScale(i.first, i.second, scale, [&](uint64_t /* key */, uint32_t value) {
-          if (!checkUnique(value))
-            return;
-          m_fn(value, *src);
-        });
-        if (m_stop())
-          break;
+        // iterate through intervals
+        for (auto const & i : intervals)
+        {
+          index.ForEachInIntervalAndScale(i.first, i.second, scale, processValue);
+          if (m_stop())
+            break;
+        }
       }
     }
     // Check created features container.
@@ -76,13 +89,14 @@ private:
   DataSource::StopSearchCallback m_stop;
 };
 
-void ReadFeatureType(function<void(FeatureType &)> const & fn, FeatureSource & src, uint32_t index)
+// Returns nullptr for the deleted features.
+unique_ptr<FeatureType> GetFeatureType(FeatureSource & src, uint32_t index)
 {
   unique_ptr<FeatureType> ft;
   switch (src.GetFeatureStatus(index))
   {
   case FeatureStatus::Deleted:
-  case FeatureStatus::Obsolete: return;
+  case FeatureStatus::Obsolete: return {};
   case FeatureStatus::Created:
   case FeatureStatus::Modified:
   {
@@ -96,7 +110,79 @@ void ReadFeatureType(function<void(FeatureType &)> const & fn, FeatureSource & s
   }
   }
   CHECK(ft, ());
-  fn(*ft);
+  return ft;
+}
+
+void ReadFeatureType(function<void(FeatureType &)> const & fn, FeatureSource & src, uint32_t index)
+{
+  auto const ft = GetFeatureType(src, index);
+  if (ft)
+    fn(*ft);
+}
+
+// Reads the features |indices| of |handle| by the batches of |batchSize|. The indices are sorted
+// first: the features are stored in the order of the indices, so the reads are sequential.
+// The offsets of the untouched features are looked up by the chunks of |batchSize| indices.
+void ReadFeatureTypes(FeatureSourceFactory const & factory, MwmSet::MwmHandle const & handle,
+                      vector<uint32_t> & indices, size_t batchSize,
+                      DataSource::FeaturesBatchCallback const & fn)
+{
+  CHECK_GREATER(batchSize, 0, ());
+
+  sort(indices.begin(), indices.end());
+  indices.erase(unique(indices.begin(), indices.end()), indices.end());
+
+  auto src = factory(handle);
+  DataSource::FeaturesBatch batch;
+  batch.reserve(min(batchSize, indices.size()));
+  vector<uint32_t> untouched;
+  for (size_t begin = 0; begin < indices.size(); begin += batchSize)
+  {
+    size_t const end = min(begin + batchSize, indices.size());
+    untouched.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (src->GetFeatureStatus(indices[i]) == FeatureStatus::Untouched)
+        untouched.push_back(indices[i]);
+    }
+
+    auto originals = src->GetOriginalFeatures(untouched);
+    auto original = originals.begin();
+    for (size_t i = begin; i < end; ++i)
+    {
+      unique_ptr<FeatureType> ft;
+      if (original != originals.end() && (*original)->GetID().m_index == indices[i])
+        ft = move(*original++);
+      else
+        ft = GetFeatureType(*src, indices[i]);
+
+      if (!ft)
+        continue;
+
+      batch.push_back(move(ft));
+      if (batch.size() == batchSize)
+      {
+        fn(batch);
+        batch.clear();
+      }
+    }
+  }
+
+  if (!batch.empty())
+    fn(batch);
+}
+
+void ReadFeatureTypesInRect(FeatureSourceFactory const & factory, MwmSet::MwmHandle const & handle,
+                            covering::CoveringGetter & cov, int scale, size_t batchSize,
+                            DataSource::FeaturesBatchCallback const & fn)
+{
+  vector<uint32_t> indices;
+  ReadMWMFunctor collectIndices(factory, [&indices](uint32_t index, FeatureSource & /* src */) {
+    indices.push_back(index);
+  });
+  collectIndices(handle, cov, scale);
+
+  ReadFeatureTypes(factory, handle, indices, batchSize, fn);
 }
 }  //  namespace
 
@@ -174,7 +260,7 @@ unique_ptr<MwmSet::MwmValueBase> DataSource::CreateValue(MwmInfo & info) const
 {
   // Create a section with rank table if it does not exist.
   platform::LocalCountryFile const & localFile = info.GetLocalFile();
-  unique_ptr<MwmValue> p(new MwmValue(localFile));
+  unique_ptr<MwmValue> p(new MwmValue(localFile, m_readMode));
   p->SetTable(dynamic_cast<MwmInfoEx &>(info));
   ASSERT(p->GetHeader().IsMWMSuitable(), ());
   return unique_ptr<MwmSet::MwmValueBase>(move(p));
@@ -185,6 +271,12 @@ pair<MwmSet::MwmId, MwmSet::RegResult> DataSource::RegisterMap(LocalCountryFile
   return Register(localFile);
 }
 
+vector<pair<MwmSet::MwmId, MwmSet::RegResult>> DataSource::RegisterMaps(
+    vector<LocalCountryFile> const & localFiles, size_t threadsCount)
+{
+  return Register(localFiles, threadsCount);
+}
+
 bool DataSource::DeregisterMap(CountryFile const & countryFile) { return Deregister(countryFile); }
 
 void DataSource::ForEachInIntervals(ReaderCallback const & fn, covering::CoveringMode mode,
@@ -193,7 +285,7 @@ void DataSource::ForEachInIntervals(ReaderCallback const & fn, covering::Coverin
   vector<shared_ptr<MwmInfo>> mwms;
   GetMwmsInfo(mwms);
 
-  covering::CoveringGetter cov(rect, mode);
+  covering::CoveringGetter cov(rect, mode, m_coveringCache.get());
 
   MwmId worldID[2];
 
@@ -241,6 +333,12 @@ void DataSource::ForEachInRect(FeatureCallback const & f, m2::RectD const & rect
   ForEachInIntervals(readFunctor, covering::ViewportWithLowLevels, rect, scale);
 }
 
+void DataSource::ForEachInTile(FeatureCallback const & f, uint32_t x, uint32_t y, uint8_t zoom,
+                               int scale) const
+{
+  ForEachInRect(f, covering::GetTileRect(x, y, zoom), scale);
+}
+
 void DataSource::ForClosestToPoint(FeatureCallback const & f, StopSearchCallback const & stop,
                                    m2::PointD const & center, double sizeM, int scale) const
 {
@@ -269,7 +367,7 @@ void DataSource::ForEachInRectForMWM(FeatureCallback const & f, m2::RectD const
   MwmHandle const handle = GetMwmHandleById(id);
   if (handle.IsAlive())
   {
-    covering::CoveringGetter cov(rect, covering::ViewportWithLowLevels);
+    covering::CoveringGetter cov(rect, covering::ViewportWithLowLevels, m_coveringCache.get());
     auto readFeatureType = [&f](uint32_t index, FeatureSource & src) {
       ReadFeatureType(f, src, index);
     };
@@ -279,6 +377,80 @@ void DataSource::ForEachInRectForMWM(FeatureCallback const & f, m2::RectD const
   }
 }
 
+void DataSource::ForEachBatchInRect(FeaturesBatchCallback const & fn, m2::RectD const & rect,
+                                    int scale, size_t batchSize) const
+{
+  auto readFeatureTypes = [&](MwmHandle const & handle, covering::CoveringGetter & cov,
+                              int scale) {
+    ReadFeatureTypesInRect(*m_factory, handle, cov, scale, batchSize, fn);
+  };
+
+  ForEachInIntervals(readFeatureTypes, covering::ViewportWithLowLevels, rect, scale);
+}
+
+void DataSource::ForEachBatchInRect(FeaturesBatchCallback const & fn, m2::RectD const & rect,
+                                    int scale, size_t batchSize, size_t threadsCount) const
+{
+  CHECK_GREATER(threadsCount, 0, ());
+
+  vector<future<void>> results;
+  {
+    base::thread_pool::computational::ThreadPool threadPool(threadsCount);
+    // The walk through the index is a part of the task too, so every task takes its own
+    // handle and covering.
+    auto submitMwm = [&](MwmHandle const & handle, covering::CoveringGetter & /* cov */,
+                         int scale) {
+      auto const id = handle.GetId();
+      results.push_back(threadPool.Submit([this, &fn, id, rect, scale, batchSize]() {
+        auto const handle = GetMwmHandleById(id);
+        if (!handle.IsAlive())
+          return;
+
+        covering::CoveringGetter cov(rect, covering::ViewportWithLowLevels,
+                                     m_coveringCache.get());
+        ReadFeatureTypesInRect(*m_factory, handle, cov, scale, batchSize, fn);
+      }));
+    };
+
+    ForEachInIntervals(submitMwm, covering::ViewportWithLowLevels, rect, scale);
+  }
+
+  // Rethrows the exceptions of the tasks.
+  for (auto & result : results)
+    result.get();
+}
+
+void DataSource::EnableCoveringCache(uint32_t logCacheSize)
+{
+  m_coveringCache = make_unique<covering::CoveringCache>(logCacheSize);
+}
+
+void DataSource::DisableCoveringCache() { m_coveringCache.reset(); }
+
+void DataSource::ReadFeatures(FeaturesBatchCallback const & fn, vector<FeatureID> const & features,
+                              size_t batchSize) const
+{
+  ASSERT(is_sorted(features.begin(), features.end()), ());
+
+  vector<uint32_t> indices;
+  auto fidIter = features.begin();
+  auto const endIter = features.end();
+  while (fidIter != endIter)
+  {
+    MwmId const & id = fidIter->m_mwmId;
+    indices.clear();
+    do
+    {
+      indices.push_back(fidIter->m_index);
+    } while (++fidIter != endIter && id == fidIter->m_mwmId);
+
+    // Skip unregistered mwm files.
+    MwmHandle const handle = GetMwmHandleById(id);
+    if (handle.IsAlive())
+      ReadFeatureTypes(*m_factory, handle, indices, batchSize, fn);
+  }
+}
+
 void DataSource::ReadFeatures(FeatureCallback const & fn, vector<FeatureID> const & features) const
 {
   ASSERT(is_sorted(features.begin(), features.end()), ());
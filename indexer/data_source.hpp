@@ -28,11 +28,17 @@ public:
   using FeatureCallback = std::function<void(FeatureType &)>;
   using FeatureIdCallback = std::function<void(FeatureID const &)>;
   using StopSearchCallback = std::function<bool(void)>;
+  using FeaturesBatch = std::vector<std::unique_ptr<FeatureType>>;
+  // Is called with the consecutive features of one mwm.
+  using FeaturesBatchCallback = std::function<void(FeaturesBatch & features)>;
 
   ~DataSource() override = default;
 
   /// Registers a new map.
   std::pair<MwmId, RegResult> RegisterMap(platform::LocalCountryFile const & localFile);
+  /// Registers the maps reading them by |threadsCount| threads, see MwmSet::Register().
+  std::vector<std::pair<MwmId, RegResult>> RegisterMaps(
+      std::vector<platform::LocalCountryFile> const & localFiles, size_t threadsCount);
 
   /// Deregisters a map from internal records.
   ///
@@ -43,6 +49,11 @@ public:
 
   void ForEachFeatureIDInRect(FeatureIdCallback const & f, m2::RectD const & rect, int scale) const;
   void ForEachInRect(FeatureCallback const & f, m2::RectD const & rect, int scale) const;
+  // The same as ForEachInRect() for the rect of the tile, see covering::GetTileRect().
+  // The coverings of the tiles are shared by the repeated queries when the coverings cache
+  // is enabled.
+  void ForEachInTile(FeatureCallback const & f, uint32_t x, uint32_t y, uint8_t zoom,
+                     int scale) const;
   // Calls |f| for features closest to |center| until |stopCallback| returns true or distance
   // |sizeM| from has been reached. Then for EditableDataSource calls |f| for each edited feature
   // inside square with center |center| and side |2 * sizeM|. Edited features are not in the same
@@ -52,6 +63,15 @@ public:
   void ForEachInScale(FeatureCallback const & f, int scale) const;
   void ForEachInRectForMWM(FeatureCallback const & f, m2::RectD const & rect, int scale,
                            MwmId const & id) const;
+  // Calls |fn| for the batches of at most |batchSize| features in |rect|. The features of each
+  // mwm are read in the order of their offsets, so the reads go forward through the file,
+  // the edited features of the mwm follow the original ones.
+  void ForEachBatchInRect(FeaturesBatchCallback const & fn, m2::RectD const & rect, int scale,
+                          size_t batchSize) const;
+  // The same, but the mwms are read by |threadsCount| threads. |fn| is called concurrently for
+  // the batches of the different mwms.
+  void ForEachBatchInRect(FeaturesBatchCallback const & fn, m2::RectD const & rect, int scale,
+                          size_t batchSize, size_t threadsCount) const;
   // "features" must be sorted using FeatureID::operator< as predicate.
   void ReadFeatures(FeatureCallback const & fn, std::vector<FeatureID> const & features) const;
 
@@ -59,12 +79,29 @@ public:
   {
     return ReadFeatures(fn, {feature});
   }
+  // Reads |features| like ReadFeatures() and calls |fn| for the batches of at most |batchSize|
+  // of them. The duplicates are read once.
+  void ReadFeatures(FeaturesBatchCallback const & fn, std::vector<FeatureID> const & features,
+                    size_t batchSize) const;
+
+  // Enables the cache of the coverings of 2^|logCacheSize| rects, see covering::CoveringCache.
+  // The coverings do not depend on the registered maps, so the cache is shared by all of them.
+  // Not thread-safe: the cache is to be enabled or disabled when there are no queries.
+  void EnableCoveringCache(uint32_t logCacheSize);
+  void DisableCoveringCache();
+  // Returns nullptr when the cache is disabled.
+  covering::CoveringCache const * GetCoveringCache() const { return m_coveringCache.get(); }
 
 protected:
   using ReaderCallback = std::function<void(MwmSet::MwmHandle const & handle,
                                             covering::CoveringGetter & cov, int scale)>;
 
-  explicit DataSource(std::unique_ptr<FeatureSourceFactory> factory) : m_factory(std::move(factory)) {}
+  explicit DataSource(std::unique_ptr<FeatureSourceFactory> factory,
+                      Concurrency concurrency = Concurrency::Serial,
+                      MwmReadMode readMode = MwmReadMode::Cached)
+    : MwmSet(kDefaultCacheSize, concurrency), m_factory(std::move(factory)), m_readMode(readMode)
+  {
+  }
 
   void ForEachInIntervals(ReaderCallback const & fn, covering::CoveringMode mode,
                           m2::RectD const & rect, int scale) const;
@@ -77,6 +114,10 @@ private:
   friend class FeaturesLoaderGuard;
 
   std::unique_ptr<FeatureSourceFactory> m_factory;
+  // How the values read the mwms, e.g. the scanning services map the files for the
+  // sequential reads.
+  MwmReadMode const m_readMode;
+  std::unique_ptr<covering::CoveringCache> m_coveringCache;
 };
 
 // DataSource which operates with features from mwm file and does not support features creation
@@ -84,7 +125,11 @@ private:
 class FrozenDataSource : public DataSource
 {
 public:
-  FrozenDataSource() : DataSource(std::make_unique<FeatureSourceFactory>()) {}
+  explicit FrozenDataSource(Concurrency concurrency = Concurrency::Serial,
+                            MwmReadMode readMode = MwmReadMode::Cached)
+    : DataSource(std::make_unique<FeatureSourceFactory>(), concurrency, readMode)
+  {
+  }
 };
 
 /// Guard for loading features from particular MWM by demand.
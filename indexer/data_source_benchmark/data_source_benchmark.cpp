@@ -0,0 +1,622 @@
+#include "indexer/cell_id.hpp"
+#include "indexer/covering_index.hpp"
+#include "indexer/data_source.hpp"
+#include "indexer/feature.hpp"
+#include "indexer/feature_decl.hpp"
+#include "indexer/mwm_set.hpp"
+#include "indexer/scales.hpp"
+
+#include "platform/local_country_file.hpp"
+
+#include "coding/mmap_reader.hpp"
+#include "coding/reader.hpp"
+
+#include "geometry/mercator.hpp"
+#include "geometry/point2d.hpp"
+#include "geometry/rect2d.hpp"
+
+#include "base/assert.hpp"
+#include "base/geo_object_id.hpp"
+#include "base/logging.hpp"
+#include "base/stl_helpers.hpp"
+#include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
+#include "base/timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace std;
+
+namespace po = boost::program_options;
+
+namespace
+{
+using IndexReader = ReaderPtr<Reader>;
+
+struct BenchmarkOptions
+{
+  vector<string> m_mwmPaths;
+  string m_regionsIndexPath;
+  string m_geoObjectsIndexPath;
+  string m_pointsPath;
+  size_t m_queriesCount = 1000;
+  uint32_t m_seed = 1;
+  unsigned int m_threads = 1;
+  int m_scale = scales::GetUpperScale();
+  double m_viewportSizeM = 1000.0;
+  double m_radiusM = 500.0;
+  uint32_t m_sizeHint = 100;
+  string m_cacheMode = "both";
+  bool m_json = false;
+};
+
+// Runs the query |i| and returns the number of the features or the objects it has found.
+using Query = function<size_t(size_t i)>;
+
+struct Workload
+{
+  string m_name;
+  // The files to evict from the page cache before a cold replay.
+  vector<string> m_files;
+  // Opens the data anew and returns the queries to it, so a cold replay does not find
+  // anything in the caches of the process either.
+  function<Query()> m_open;
+  size_t m_queriesCount = 0;
+};
+
+// The counters of the process to report their growth during a replay.
+struct ResourceCounters
+{
+  static ResourceCounters Get()
+  {
+    ResourceCounters counters;
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+      counters.m_majorFaults = static_cast<uint64_t>(usage.ru_majflt);
+      counters.m_minorFaults = static_cast<uint64_t>(usage.ru_minflt);
+    }
+
+    // rchar counts the bytes read by the syscalls, read_bytes counts the bytes fetched
+    // from the storage including the faults of the mapped files.
+    ifstream stream("/proc/self/io");
+    string key;
+    uint64_t value = 0;
+    while (stream >> key >> value)
+    {
+      if (key == "rchar:")
+        counters.m_readBytes = value;
+      else if (key == "read_bytes:")
+        counters.m_storageReadBytes = value;
+    }
+    return counters;
+  }
+
+  ResourceCounters operator-(ResourceCounters const & rhs) const
+  {
+    ResourceCounters diff;
+    diff.m_majorFaults = m_majorFaults - rhs.m_majorFaults;
+    diff.m_minorFaults = m_minorFaults - rhs.m_minorFaults;
+    diff.m_readBytes = m_readBytes - rhs.m_readBytes;
+    diff.m_storageReadBytes = m_storageReadBytes - rhs.m_storageReadBytes;
+    return diff;
+  }
+
+  uint64_t m_majorFaults = 0;
+  uint64_t m_minorFaults = 0;
+  uint64_t m_readBytes = 0;
+  uint64_t m_storageReadBytes = 0;
+};
+
+struct ReplayResults
+{
+  string m_name;
+  bool m_cold = false;
+  size_t m_queriesCount = 0;
+  double m_wallSeconds = 0.0;
+  // Latencies of all processed queries in nanoseconds, sorted.
+  vector<uint64_t> m_latenciesNs;
+  uint64_t m_featuresCount = 0;
+  ResourceCounters m_counters;
+};
+
+double GetPercentileMs(vector<uint64_t> const & sortedLatenciesNs, double percentile)
+{
+  if (sortedLatenciesNs.empty())
+    return 0.0;
+  auto const rank = static_cast<size_t>(percentile / 100.0 * (sortedLatenciesNs.size() - 1) + 0.5);
+  return sortedLatenciesNs[min(rank, sortedLatenciesNs.size() - 1)] / 1e6;
+}
+
+// Evicts the clean pages of |files| from the page cache. The pages mapped by the process stay
+// in the cache, so it is called before the files are opened.
+void DropPageCache(vector<string> const & files)
+{
+  for (auto const & file : files)
+  {
+    int const fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+      LOG(LWARNING, ("Can't open", file, "to drop its pages"));
+      continue;
+    }
+#if defined(__linux__)
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+      LOG(LWARNING, ("Can't drop the pages of", file));
+#endif
+    close(fd);
+  }
+}
+
+ReplayResults Replay(Query const & query, size_t queriesCount, unsigned int threads)
+{
+  ReplayResults replay;
+  replay.m_queriesCount = queriesCount;
+  replay.m_latenciesNs.resize(queriesCount);
+
+  atomic<size_t> nextQuery{0};
+  atomic<uint64_t> featuresCount{0};
+  auto const processQueries = [&]() {
+    uint64_t threadFeaturesCount = 0;
+    while (true)
+    {
+      size_t const i = nextQuery.fetch_add(1);
+      if (i >= queriesCount)
+        break;
+
+      base::Timer timer;
+      threadFeaturesCount += query(i);
+      replay.m_latenciesNs[i] = timer.TimeElapsedAs<chrono::nanoseconds>().count();
+    }
+    featuresCount += threadFeaturesCount;
+  };
+
+  auto const countersBefore = ResourceCounters::Get();
+  base::Timer timer;
+  if (threads == 1)
+  {
+    processQueries();
+  }
+  else
+  {
+    base::thread_pool::computational::ThreadPool threadPool{threads};
+    threadPool.PerformParallelWorks(processQueries, threads);
+  }
+  replay.m_wallSeconds = timer.ElapsedSeconds();
+  replay.m_counters = ResourceCounters::Get() - countersBefore;
+  replay.m_featuresCount = featuresCount;
+
+  sort(replay.m_latenciesNs.begin(), replay.m_latenciesNs.end());
+  return replay;
+}
+
+ReplayResults RunCold(Workload const & workload, unsigned int threads)
+{
+  DropPageCache(workload.m_files);
+  auto const query = workload.m_open();
+  auto replay = Replay(query, workload.m_queriesCount, threads);
+  replay.m_name = workload.m_name;
+  replay.m_cold = true;
+  return replay;
+}
+
+ReplayResults RunWarm(Workload const & workload, unsigned int threads)
+{
+  auto const query = workload.m_open();
+  Replay(query, workload.m_queriesCount, threads);
+  auto replay = Replay(query, workload.m_queriesCount, threads);
+  replay.m_name = workload.m_name;
+  return replay;
+}
+
+// Points ------------------------------------------------------------------------------------------
+// Reads the points of the lines "lat lon".
+vector<m2::PointD> ReadPoints(string const & path)
+{
+  ifstream stream(path.c_str());
+  CHECK(stream.is_open(), ("Can't open", path));
+
+  vector<m2::PointD> points;
+  string line;
+  while (getline(stream, line))
+  {
+    strings::Trim(line);
+    if (line.empty())
+      continue;
+
+    double lat = 0.0;
+    double lon = 0.0;
+    istringstream lineStream(line);
+    CHECK(lineStream >> lat >> lon, ("Bad point", line, "in", path));
+    points.push_back(MercatorBounds::FromLatLon(lat, lon));
+  }
+  return points;
+}
+
+vector<m2::PointD> MakeRandomPoints(vector<m2::RectD> const & rects, size_t count, mt19937 & rng)
+{
+  CHECK(!rects.empty(), ());
+  uniform_int_distribution<size_t> rectIndex(0, rects.size() - 1);
+  uniform_real_distribution<double> ratio(0.0, 1.0);
+
+  vector<m2::PointD> points;
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const & rect = rects[rectIndex(rng)];
+    points.emplace_back(rect.minX() + ratio(rng) * rect.SizeX(),
+                        rect.minY() + ratio(rng) * rect.SizeY());
+  }
+  return points;
+}
+
+// The centers of |count| random cells of |index|, so the points are where the objects are.
+template <int DEPTH_LEVELS>
+vector<m2::PointD> MakeRandomPoints(indexer::CoveringIndex<IndexReader, DEPTH_LEVELS> const & index,
+                                    size_t count, mt19937 & rng)
+{
+  using CellId = m2::CellId<DEPTH_LEVELS>;
+  using Converter = CellIdConverter<MercatorBounds, CellId>;
+
+  // Reservoir sampling of the cells.
+  vector<uint64_t> keys;
+  uint64_t seen = 0;
+  index.ForEachCell([&](uint64_t key, base::GeoObjectId const & /* objectId */) {
+    ++seen;
+    if (keys.size() < count)
+    {
+      keys.push_back(key);
+      return;
+    }
+
+    auto const j = uniform_int_distribution<uint64_t>(0, seen - 1)(rng);
+    if (j < count)
+      keys[j] = key;
+  });
+
+  auto const depth = covering::GetCodingDepth<DEPTH_LEVELS>(scales::GetUpperScale());
+  vector<m2::PointD> points;
+  for (auto const key : keys)
+    points.push_back(Converter::FromCellId(CellId::FromInt64(static_cast<int64_t>(key), depth)));
+  return points;
+}
+
+// Workloads ---------------------------------------------------------------------------------------
+// A data source with the mwms registered anew.
+struct DataSourceWithMwms
+{
+  explicit DataSourceWithMwms(vector<string> const & mwmPaths)
+    : m_dataSource(MwmSet::Concurrency::Concurrent)
+  {
+    vector<platform::LocalCountryFile> files;
+    for (auto const & path : mwmPaths)
+      files.push_back(platform::LocalCountryFile::MakeTemporary(path));
+
+    for (auto const & result : m_dataSource.RegisterMaps(files, files.size()))
+    {
+      CHECK_EQUAL(result.second, MwmSet::RegResult::Success, ());
+      m_mwmIds.push_back(result.first);
+    }
+  }
+
+  FrozenDataSource m_dataSource;
+  // The ids of the mwms in the order of the paths.
+  vector<MwmSet::MwmId> m_mwmIds;
+};
+
+vector<Workload> MakeDataSourceWorkloads(BenchmarkOptions const & options, mt19937 & rng)
+{
+  auto const & paths = options.m_mwmPaths;
+  DataSourceWithMwms const probe(paths);
+
+  vector<m2::PointD> points;
+  if (!options.m_pointsPath.empty())
+  {
+    points = ReadPoints(options.m_pointsPath);
+  }
+  else
+  {
+    vector<m2::RectD> rects;
+    for (auto const & id : probe.m_mwmIds)
+      rects.push_back(id.GetInfo()->m_bordersRect);
+    points = MakeRandomPoints(rects, options.m_queriesCount, rng);
+  }
+
+  vector<m2::RectD> viewports;
+  for (auto const & point : points)
+  {
+    viewports.push_back(
+        MercatorBounds::RectByCenterXYAndSizeInMeters(point, options.m_viewportSizeM / 2));
+  }
+
+  // The features of the viewports are collected once, an mwm is referenced by its path index
+  // since the MwmIds of the probe are not valid for the other data sources.
+  vector<vector<pair<size_t, uint32_t>>> features(viewports.size());
+  for (size_t i = 0; i < viewports.size(); ++i)
+  {
+    probe.m_dataSource.ForEachFeatureIDInRect(
+        [&](FeatureID const & id) {
+          auto const it = find(probe.m_mwmIds.begin(), probe.m_mwmIds.end(), id.m_mwmId);
+          CHECK(it != probe.m_mwmIds.end(), (id));
+          features[i].emplace_back(static_cast<size_t>(distance(probe.m_mwmIds.begin(), it)),
+                                   id.m_index);
+        },
+        viewports[i], options.m_scale);
+  }
+
+  auto const scale = options.m_scale;
+  auto const radiusM = options.m_radiusM;
+  vector<Workload> workloads;
+
+  workloads.push_back({"data_source/for_each_in_rect", paths,
+                       [paths, viewports, scale]() -> Query {
+                         auto source = make_shared<DataSourceWithMwms>(paths);
+                         return [source, viewports, scale](size_t i) {
+                           size_t count = 0;
+                           source->m_dataSource.ForEachInRect([&count](FeatureType &) { ++count; },
+                                                              viewports[i], scale);
+                           return count;
+                         };
+                       },
+                       viewports.size()});
+
+  workloads.push_back({"data_source/for_closest_to_point", paths,
+                       [paths, points, radiusM, scale]() -> Query {
+                         auto source = make_shared<DataSourceWithMwms>(paths);
+                         return [source, points, radiusM, scale](size_t i) {
+                           size_t count = 0;
+                           source->m_dataSource.ForClosestToPoint(
+                               [&count](FeatureType &) { ++count; }, []() { return false; },
+                               points[i], radiusM, scale);
+                           return count;
+                         };
+                       },
+                       points.size()});
+
+  workloads.push_back({"data_source/read_features", paths,
+                       [paths, features]() -> Query {
+                         auto source = make_shared<DataSourceWithMwms>(paths);
+                         auto ids = make_shared<vector<vector<FeatureID>>>();
+                         for (auto const & viewport : features)
+                         {
+                           ids->emplace_back();
+                           for (auto const & f : viewport)
+                             ids->back().emplace_back(source->m_mwmIds[f.first], f.second);
+                           // A feature of several cells of the covering is found several times.
+                           base::SortUnique(ids->back());
+                         }
+                         return [source, ids](size_t i) {
+                           size_t count = 0;
+                           source->m_dataSource.ReadFeatures([&count](FeatureType &) { ++count; },
+                                                             (*ids)[i]);
+                           return count;
+                         };
+                       },
+                       features.size()});
+  return workloads;
+}
+
+template <typename IndexBox>
+vector<Workload> MakeIndexWorkloads(string const & name, string const & path,
+                                    BenchmarkOptions const & options, mt19937 & rng)
+{
+  using Index = typename IndexBox::IndexType;
+  auto const openIndex = [path]() {
+    return make_shared<Index>(indexer::ReadIndex<IndexBox, MmapReader>(path));
+  };
+
+  auto const points = options.m_pointsPath.empty()
+                          ? MakeRandomPoints(*openIndex(), options.m_queriesCount, rng)
+                          : ReadPoints(options.m_pointsPath);
+  auto const radiusM = options.m_radiusM;
+  auto const sizeHint = options.m_sizeHint;
+  vector<Workload> workloads;
+
+  workloads.push_back({name + "/for_each_at_point", {path},
+                       [openIndex, points]() -> Query {
+                         return [index = openIndex(), points](size_t i) {
+                           size_t count = 0;
+                           index->ForEachAtPoint([&count](base::GeoObjectId const &) { ++count; },
+                                                 points[i]);
+                           return count;
+                         };
+                       },
+                       points.size()});
+
+  workloads.push_back({name + "/for_closest_to_point", {path},
+                       [openIndex, points, radiusM, sizeHint]() -> Query {
+                         return [index = openIndex(), points, radiusM, sizeHint](size_t i) {
+                           size_t count = 0;
+                           index->ForClosestToPoint(
+                               [&count](base::GeoObjectId const &, double) { ++count; }, points[i],
+                               radiusM, sizeHint);
+                           return count;
+                         };
+                       },
+                       points.size()});
+  return workloads;
+}
+
+// Reports -----------------------------------------------------------------------------------------
+double GetFeaturesPerSecond(ReplayResults const & replay)
+{
+  return replay.m_wallSeconds > 0 ? replay.m_featuresCount / replay.m_wallSeconds : 0.0;
+}
+
+void PrintText(BenchmarkOptions const & options, vector<ReplayResults> const & replays)
+{
+  cout << "Threads: " << options.m_threads << endl;
+  for (auto const & replay : replays)
+  {
+    cout << replay.m_name << " (" << (replay.m_cold ? "cold" : "warm") << " cache)" << endl;
+    cout << "  Queries: " << replay.m_queriesCount << " in " << fixed << setprecision(3)
+         << replay.m_wallSeconds << " s" << endl;
+    cout << "  Latency, ms: p50 " << GetPercentileMs(replay.m_latenciesNs, 50) << " p99 "
+         << GetPercentileMs(replay.m_latenciesNs, 99) << " max "
+         << GetPercentileMs(replay.m_latenciesNs, 100) << endl;
+    cout << "  Features: " << replay.m_featuresCount << ", " << setprecision(0)
+         << GetFeaturesPerSecond(replay) << " per second" << endl;
+    cout << "  Page faults: " << replay.m_counters.m_majorFaults << " major "
+         << replay.m_counters.m_minorFaults << " minor" << endl;
+    cout << "  Read: " << replay.m_counters.m_readBytes << " bytes, "
+         << replay.m_counters.m_storageReadBytes << " bytes from the storage" << endl;
+  }
+}
+
+void PrintJson(BenchmarkOptions const & options, vector<ReplayResults> const & replays)
+{
+  auto root = base::NewJSONObject();
+  ToJSONObject(*root, "threads", options.m_threads);
+  ToJSONObject(*root, "seed", options.m_seed);
+
+  auto workloads = base::NewJSONArray();
+  for (auto const & replay : replays)
+  {
+    auto json = base::NewJSONObject();
+    ToJSONObject(*json, "name", replay.m_name);
+    ToJSONObject(*json, "cache", replay.m_cold ? "cold" : "warm");
+    ToJSONObject(*json, "queries", static_cast<uint64_t>(replay.m_queriesCount));
+    ToJSONObject(*json, "wall_s", replay.m_wallSeconds);
+    ToJSONObject(*json, "p50_ms", GetPercentileMs(replay.m_latenciesNs, 50));
+    ToJSONObject(*json, "p99_ms", GetPercentileMs(replay.m_latenciesNs, 99));
+    ToJSONObject(*json, "max_ms", GetPercentileMs(replay.m_latenciesNs, 100));
+    ToJSONObject(*json, "features", replay.m_featuresCount);
+    ToJSONObject(*json, "features_per_second", GetFeaturesPerSecond(replay));
+    ToJSONObject(*json, "major_faults", replay.m_counters.m_majorFaults);
+    ToJSONObject(*json, "minor_faults", replay.m_counters.m_minorFaults);
+    ToJSONObject(*json, "read_bytes", replay.m_counters.m_readBytes);
+    ToJSONObject(*json, "storage_read_bytes", replay.m_counters.m_storageReadBytes);
+    ToJSONArray(*workloads, json);
+  }
+  ToJSONObject(*root, "workloads", workloads);
+
+  cout << base::DumpToString(root, JSON_INDENT(2)) << endl;
+}
+
+BenchmarkOptions DefineOptions(int argc, char * argv[])
+{
+  BenchmarkOptions o;
+  po::options_description optionsDescription;
+
+  optionsDescription.add_options()
+    ("mwm_path", po::value(&o.m_mwmPaths)->multitoken(), "Paths to the mwms to register in FrozenDataSource")
+    ("regions_index", po::value(&o.m_regionsIndexPath)->default_value(""), "Path to the regions index")
+    ("geo_objects_index", po::value(&o.m_geoObjectsIndexPath)->default_value(""), "Path to the geo objects index")
+    ("points_path", po::value(&o.m_pointsPath)->default_value(""), "Path to the recorded query points, \"lat lon\" per line, the points are random otherwise")
+    ("queries", po::value(&o.m_queriesCount)->default_value(1000), "Number of the random query points")
+    ("seed", po::value(&o.m_seed)->default_value(1), "Seed of the random query points")
+    ("threads", po::value(&o.m_threads)->default_value(1), "Number of threads to replay the queries")
+    ("scale", po::value(&o.m_scale)->default_value(scales::GetUpperScale()), "Scale of the data source queries")
+    ("viewport_m", po::value(&o.m_viewportSizeM)->default_value(1000.0), "Side of the viewports around the points in meters")
+    ("radius_m", po::value(&o.m_radiusM)->default_value(500.0), "Radius of the closest to point queries in meters")
+    ("size_hint", po::value(&o.m_sizeHint)->default_value(100), "Number of the objects of the index closest to point queries")
+    ("cache", po::value(&o.m_cacheMode)->default_value("both"), "Page cache before the replays: cold, warm or both")
+    ("json", po::bool_switch(&o.m_json), "Print the report as json")
+    ("help", "produce help message");
+
+  po::variables_map vm;
+
+  po::store(po::parse_command_line(argc, argv, optionsDescription), vm);
+  po::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << optionsDescription << std::endl;
+    exit(1);
+  }
+
+  return o;
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  BenchmarkOptions options;
+  try
+  {
+    options = DefineOptions(argc, argv);
+  }
+  catch(po::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    return 1;
+  }
+
+  if (options.m_mwmPaths.empty() && options.m_regionsIndexPath.empty() &&
+      options.m_geoObjectsIndexPath.empty())
+  {
+    std::cerr << "ERROR: mwm_path, regions_index or geo_objects_index is required" << std::endl;
+    return 1;
+  }
+  if (options.m_threads == 0 || options.m_queriesCount == 0)
+  {
+    std::cerr << "ERROR: threads and queries must be positive" << std::endl;
+    return 1;
+  }
+  bool const cold = options.m_cacheMode == "cold" || options.m_cacheMode == "both";
+  bool const warm = options.m_cacheMode == "warm" || options.m_cacheMode == "both";
+  if (!cold && !warm)
+  {
+    std::cerr << "ERROR: cache must be cold, warm or both" << std::endl;
+    return 1;
+  }
+
+  mt19937 rng(options.m_seed);
+  vector<Workload> workloads;
+  auto const addWorkloads = [&workloads](vector<Workload> && added) {
+    move(added.begin(), added.end(), back_inserter(workloads));
+  };
+  if (!options.m_mwmPaths.empty())
+    addWorkloads(MakeDataSourceWorkloads(options, rng));
+  if (!options.m_regionsIndexPath.empty())
+  {
+    addWorkloads(MakeIndexWorkloads<indexer::RegionsIndexBox<IndexReader>>(
+        "regions_index", options.m_regionsIndexPath, options, rng));
+  }
+  if (!options.m_geoObjectsIndexPath.empty())
+  {
+    addWorkloads(MakeIndexWorkloads<indexer::GeoObjectsIndexBox<IndexReader>>(
+        "geo_objects_index", options.m_geoObjectsIndexPath, options, rng));
+  }
+
+  vector<ReplayResults> replays;
+  for (auto const & workload : workloads)
+  {
+    if (workload.m_queriesCount == 0)
+      continue;
+
+    // The cold replay goes first, the warm one would leave the files in the page cache anyway.
+    if (cold)
+      replays.push_back(RunCold(workload, options.m_threads));
+    if (warm)
+      replays.push_back(RunWarm(workload, options.m_threads));
+  }
+
+  if (options.m_json)
+    PrintJson(options, replays);
+  else
+    PrintText(options, replays);
+
+  return 0;
+}
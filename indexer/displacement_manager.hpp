@@ -2,7 +2,7 @@
 
 #include "indexer/cell_id.hpp"
 #include "indexer/cell_value_pair.hpp"
-#include "indexer/classificator.hpp"
+#include "indexer/classificator_type_path.hpp"
 #include "indexer/drawing_rules.hpp"
 #include "indexer/feature_data.hpp"
 #include "indexer/feature_visibility.hpp"
@@ -13,10 +13,18 @@
 #include "geometry/screenbase.hpp"
 #include "geometry/tree4d.hpp"
 
+#include "base/thread_pool_computational.hpp"
+
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <vector>
 
+#include <boost/optional.hpp>
+#include <boost/sort/sort.hpp>
+
 namespace
 {
 double constexpr kPOIDisplacementRadiusPixels = 80.;
@@ -63,7 +71,12 @@ class DisplacementManager
 public:
   using CellFeaturePair = CellFeatureBucketTuple::CellFeaturePair;
 
-  DisplacementManager(Sorter & sorter) : m_sorter(sorter) {}
+  /// The displacement is made by |threadsCount| threads, the result is the same for any
+  /// |threadsCount|.
+  DisplacementManager(Sorter & sorter, unsigned int threadsCount = 1)
+    : m_sorter(sorter), m_threadsCount(std::max(threadsCount, 1u))
+  {
+  }
 
   /// Add feature at bucket (zoom) to displaceable queue if possible. Pass to bucket otherwise.
   template <typename Feature>
@@ -72,7 +85,7 @@ public:
     // Add to displaceable storage if we need to displace POI.
     if (bucket != scales::GetUpperScale() && IsDisplaceable(ft))
     {
-      m_storage.emplace_back(cells, ft, index, bucket);
+      m_storage.emplace_back(cells, ft, index, bucket, m_cells);
       return;
     }
 
@@ -87,75 +100,48 @@ public:
   /// After all features passed to sorter.
   void Displace()
   {
-    m4::Tree<DisplaceableNode> acceptedNodes;
-
-    // Sort in priority descend mode.
-    std::sort(m_storage.begin(), m_storage.end(), std::greater<DisplaceableNode>());
-
-    for (auto const & node : m_storage)
-    {
-      auto scale = node.m_minScale;
-      // Do not filter high level objects. Including metro and country names.
-      static auto const maximumIgnoredZoom =
-          feature::GetDrawableScaleRange(classif().GetTypeByPath({"railway", "station", "subway"}))
-              .first;
-
-      if (maximumIgnoredZoom < 0 || scale <= maximumIgnoredZoom)
-      {
-        AddNodeToSorter(node, static_cast<uint32_t>(scale));
-        acceptedNodes.Add(node);
-        continue;
-      }
-      for (; scale < scales::GetUpperScale(); ++scale)
-      {
-        float const delta = CalculateDeltaForZoom(scale);
-        float const squaredDelta = delta * delta;
-
-        m2::RectD const displacementRect(node.m_center, node.m_center);
-        bool isDisplaced = false;
-        acceptedNodes.ForEachInRect(
-            m2::Inflate(displacementRect, {delta, delta}),
-            [&isDisplaced, &node, &squaredDelta, &scale](DisplaceableNode const & rhs) {
-              if (node.m_center.SquaredLength(rhs.m_center) < squaredDelta &&
-                  rhs.m_maxScale > scale)
-                isDisplaced = true;
-            });
-        if (isDisplaced)
-          continue;
-
-        // Add feature to index otherwise.
-        AddNodeToSorter(node, scale);
-        acceptedNodes.Add(node);
-        break;
-      }
-      if (scale == scales::GetUpperScale())
-        AddNodeToSorter(node, scale);
-    }
+    // Do not filter high level objects. Including metro and country names.
+    static classificator::TypePath const kSubwayStationType("railway-station-subway");
+    auto const maximumIgnoredZoom = feature::GetDrawableScaleRange(kSubwayStationType.Get()).first;
+    Displace(maximumIgnoredZoom);
   }
 
 private:
+  // The nodes are displaced by the blocks of this size in the priority order. The accepted
+  // nodes of the previous blocks are looked up in parallel, then the nodes of the block are
+  // accepted one by one with the accepted nodes of the block.
+  static size_t constexpr kBlockSize = 16 * 1024;
+
+  // A displaceable feature. The cells of all the nodes are kept in one vector and the accepted
+  // nodes are kept in the trees by AcceptedNode, so millions of nodes take little memory.
   struct DisplaceableNode
   {
-    uint32_t m_index;
-    FeatureID m_fID;
     m2::PointD m_center;
-    std::vector<int64_t> m_cells;
-
-    int m_minScale;
-    int m_maxScale;
-    uint32_t m_priority;
+    uint64_t m_cellsOffset = 0;
+    uint32_t m_cellsCount = 0;
+    uint32_t m_index = 0;
+    // The index of FeatureID, all the features are of the same mwm.
+    uint32_t m_featureIndex = 0;
+    uint32_t m_priority = 0;
+    int m_minScale = 0;
+    int m_maxScale = 0;
+    // The first scale the node is not displaced at by the nodes of the previous blocks.
+    int m_freeScale = 0;
 
-    DisplaceableNode() : m_index(0), m_minScale(0), m_maxScale(0), m_priority(0) {}
+    DisplaceableNode() = default;
 
     template <typename Feature>
     DisplaceableNode(std::vector<int64_t> const & cells, Feature & ft, uint32_t index,
-                     int zoomLevel)
-      : m_index(index)
-      , m_fID(ft.GetID())
-      , m_center(ft.GetCenter())
-      , m_cells(cells)
+                     int zoomLevel, std::vector<int64_t> & cellsStorage)
+      : m_center(ft.GetCenter())
+      , m_cellsOffset(cellsStorage.size())
+      , m_cellsCount(static_cast<uint32_t>(cells.size()))
+      , m_index(index)
+      , m_featureIndex(ft.GetID().m_index)
       , m_minScale(zoomLevel)
     {
+      cellsStorage.insert(cellsStorage.end(), cells.begin(), cells.end());
+
       feature::TypesHolder const types(ft);
       auto scaleRange = feature::GetDrawableScaleRange(types);
       m_maxScale = scaleRange.second;
@@ -185,11 +171,20 @@ private:
     {
       if (m_priority > rhs.m_priority)
         return true;
-      return (m_priority == rhs.m_priority && m_fID < rhs.m_fID);
+      return (m_priority == rhs.m_priority && m_featureIndex < rhs.m_featureIndex);
     }
+  };
+
+  struct AcceptedNode
+  {
+    m2::PointD m_center;
+    int m_maxScale;
+
     m2::RectD const GetLimitRect() const { return m2::RectD(m_center, m_center); }
   };
 
+  using AcceptedNodes = m4::Tree<AcceptedNode>;
+
   template <typename Feature>
   static bool IsDisplaceable(Feature & ft)
   {
@@ -197,6 +192,123 @@ private:
     return types.GetGeomType() == feature::GeomType::Point;
   }
 
+  void Displace(int maximumIgnoredZoom)
+  {
+    if (m_threadsCount > 1)
+    {
+      boost::sort::block_indirect_sort(m_storage.begin(), m_storage.end(),
+                                       std::greater<DisplaceableNode>(), m_threadsCount);
+    }
+    else
+    {
+      // Sort in priority descend mode.
+      std::sort(m_storage.begin(), m_storage.end(), std::greater<DisplaceableNode>());
+    }
+
+    auto const isIgnored = [maximumIgnoredZoom](DisplaceableNode const & node) {
+      return maximumIgnoredZoom < 0 || node.m_minScale <= maximumIgnoredZoom;
+    };
+
+    boost::optional<base::thread_pool::computational::ThreadPool> threadPool;
+    if (m_threadsCount > 1)
+      threadPool.emplace(m_threadsCount);
+
+    AcceptedNodes acceptedNodes;
+    AcceptedNodes blockAcceptedNodes;
+    std::vector<AcceptedNode> blockAccepted;
+    for (size_t blockBegin = 0; blockBegin < m_storage.size(); blockBegin += kBlockSize)
+    {
+      auto const blockEnd = std::min(blockBegin + kBlockSize, m_storage.size());
+      auto const setFreeScales = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+          auto & node = m_storage[i];
+          if (isIgnored(node))
+            continue;
+          node.m_freeScale = node.m_minScale;
+          while (node.m_freeScale < scales::GetUpperScale() &&
+                 IsDisplaced(acceptedNodes, node, node.m_freeScale))
+          {
+            ++node.m_freeScale;
+          }
+        }
+      };
+
+      if (threadPool)
+      {
+        std::vector<std::future<void>> tasks;
+        auto const partSize = (blockEnd - blockBegin + m_threadsCount - 1) / m_threadsCount;
+        for (auto begin = blockBegin; begin < blockEnd; begin += partSize)
+        {
+          auto const end = std::min(begin + partSize, blockEnd);
+          tasks.push_back(threadPool->Submit([&setFreeScales, begin, end]() {
+            setFreeScales(begin, end);
+          }));
+        }
+        for (auto & task : tasks)
+          task.get();
+      }
+      else
+      {
+        setFreeScales(blockBegin, blockEnd);
+      }
+
+      // A node is displaced at a scale by an accepted node of the previous block or by one of
+      // this block.
+      blockAcceptedNodes.Clear();
+      blockAccepted.clear();
+      for (auto i = blockBegin; i < blockEnd; ++i)
+      {
+        auto const & node = m_storage[i];
+        if (isIgnored(node))
+        {
+          AddNodeToSorter(node, static_cast<uint32_t>(node.m_minScale));
+          blockAccepted.push_back({node.m_center, node.m_maxScale});
+          blockAcceptedNodes.Add(blockAccepted.back());
+          continue;
+        }
+
+        auto scale = node.m_freeScale;
+        for (; scale < scales::GetUpperScale(); ++scale)
+        {
+          if (scale != node.m_freeScale && IsDisplaced(acceptedNodes, node, scale))
+            continue;
+          if (IsDisplaced(blockAcceptedNodes, node, scale))
+            continue;
+
+          // Add feature to index otherwise.
+          AddNodeToSorter(node, scale);
+          blockAccepted.push_back({node.m_center, node.m_maxScale});
+          blockAcceptedNodes.Add(blockAccepted.back());
+          break;
+        }
+        if (scale == scales::GetUpperScale())
+          AddNodeToSorter(node, scale);
+      }
+
+      for (auto const & accepted : blockAccepted)
+        acceptedNodes.Add(accepted);
+    }
+  }
+
+  bool IsDisplaced(AcceptedNodes const & acceptedNodes, DisplaceableNode const & node,
+                   int scale) const
+  {
+    float const delta = CalculateDeltaForZoom(scale);
+    float const squaredDelta = delta * delta;
+
+    m2::RectD const displacementRect(node.m_center, node.m_center);
+    bool isDisplaced = false;
+    acceptedNodes.ForEachInRect(
+        m2::Inflate(displacementRect, {delta, delta}),
+        [&isDisplaced, &node, &squaredDelta, &scale](AcceptedNode const & rhs) {
+          if (node.m_center.SquaredLength(rhs.m_center) < squaredDelta &&
+              rhs.m_maxScale > scale)
+            isDisplaced = true;
+        });
+    return isDisplaced;
+  }
+
   float CalculateDeltaForZoom(int32_t zoom) const
   {
     // zoom - 1 is similar to drape.
@@ -206,11 +318,13 @@ private:
 
   void AddNodeToSorter(DisplaceableNode const & node, uint32_t scale)
   {
-    for (auto const & cell : node.m_cells)
-      m_sorter.Add(CellFeatureBucketTuple(CellFeaturePair(cell, node.m_index), scale));
+    for (auto i = node.m_cellsOffset; i < node.m_cellsOffset + node.m_cellsCount; ++i)
+      m_sorter.Add(CellFeatureBucketTuple(CellFeaturePair(m_cells[i], node.m_index), scale));
   }
 
   Sorter & m_sorter;
+  unsigned int const m_threadsCount;
   std::vector<DisplaceableNode> m_storage;
+  std::vector<int64_t> m_cells;
 };
 }  // namespace indexer
@@ -173,6 +173,20 @@ uint8_t ReadByte(TSource & src)
 {
   return ReadPrimitiveFromSource<uint8_t>(src);
 }
+
+// Skips the string of utils::ReadString().
+void SkipString(ArrayByteSource & src)
+{
+  src.Advance(ReadVarUint<uint32_t>(src) + 1);
+}
+
+// Skips the string of StringNumericOptimal::Read().
+void SkipNumericOptimalString(ArrayByteSource & src)
+{
+  auto const sz = ReadVarUint<uint64_t>(src);
+  if ((sz & 1) == 0)
+    src.Advance(static_cast<size_t>((sz >> 1) + 1));
+}
 }  // namespace
 
 FeatureType::FeatureType(SharedLoadInfo const * loadInfo, Buffer buffer)
@@ -226,7 +240,7 @@ FeatureType::FeatureType(osm::MapObject const & emo)
     m_params.house.Clear();
   else
     m_params.house.Set(house);
-  m_parsed.m_common = true;
+  m_parsed.m_commonOffsets = m_parsed.m_names = m_parsed.m_common = true;
 
   m_metadata = emo.GetMetadata();
   m_parsed.m_metadata = true;
@@ -285,6 +299,77 @@ void FeatureType::ParseTypes()
   m_parsed.m_types = true;
 }
 
+void FeatureType::ParseFields(uint8_t fields)
+{
+  if (fields & FIELD_TYPES)
+    ParseTypes();
+  if (fields & FIELD_CENTER)
+    ParseCommonOffsets();
+  if (fields & FIELD_NAMES)
+    ParseNames();
+  if (fields & FIELD_COMMON)
+    ParseCommon();
+  if (fields & FIELD_HEADER2)
+    ParseHeader2();
+  if (fields & FIELD_METADATA)
+    ParseMetadata();
+}
+
+void FeatureType::ParseCommonOffsets()
+{
+  if (m_parsed.m_commonOffsets)
+    return;
+
+  CHECK(m_loadInfo, ());
+  ParseTypes();
+
+  ArrayByteSource source(m_data + m_offsets.m_common);
+  uint8_t const h = Header(m_data);
+  if (h & HEADER_MASK_HAS_NAME)
+    SkipString(source);
+
+  m_offsets.m_layer = CalcOffset(source, m_data);
+  if (h & HEADER_MASK_HAS_LAYER)
+    source.Advance(sizeof(int8_t));
+
+  m_offsets.m_addInfo = CalcOffset(source, m_data);
+  if (h & HEADER_MASK_HAS_ADDINFO)
+  {
+    switch (static_cast<HeaderGeomType>(h & HEADER_MASK_GEOMTYPE))
+    {
+    case HeaderGeomType::Point: source.Advance(sizeof(uint8_t)); break;
+    case HeaderGeomType::Line: SkipString(source); break;
+    case HeaderGeomType::Area:
+    case HeaderGeomType::PointEx: SkipNumericOptimalString(source); break;
+    }
+  }
+
+  if (GetGeomType() == GeomType::Point)
+  {
+    m_center = serial::LoadPoint(source, m_loadInfo->GetDefGeometryCodingParams());
+    m_limitRect.Add(m_center);
+  }
+
+  m_offsets.m_header2 = CalcOffset(source, m_data);
+  m_parsed.m_commonOffsets = true;
+}
+
+void FeatureType::ParseNames()
+{
+  if (m_parsed.m_names)
+    return;
+
+  CHECK(m_loadInfo, ());
+  ParseTypes();
+
+  if (HasName())
+  {
+    ArrayByteSource source(m_data + m_offsets.m_common);
+    m_params.name.Read(source);
+  }
+  m_parsed.m_names = true;
+}
+
 void FeatureType::ParseCommon()
 {
   if (m_parsed.m_common)
@@ -304,13 +389,13 @@ void FeatureType::ParseCommon()
   }
 
   m_offsets.m_header2 = CalcOffset(source, m_data);
-  m_parsed.m_common = true;
+  m_parsed.m_names = m_parsed.m_common = true;
 }
 
 m2::PointD FeatureType::GetCenter()
 {
   ASSERT_EQUAL(GetGeomType(), feature::GeomType::Point, ());
-  ParseCommon();
+  ParseCommonOffsets();
   return m_center;
 }
 
@@ -319,8 +404,11 @@ int8_t FeatureType::GetLayer()
   if ((m_header & feature::HEADER_MASK_HAS_LAYER) == 0)
     return 0;
 
-  ParseCommon();
-  return m_params.layer;
+  if (m_parsed.m_common)
+    return m_params.layer;
+
+  ParseCommonOffsets();
+  return static_cast<int8_t>(m_data[m_offsets.m_layer]);
 }
 
 void FeatureType::ParseHeader2()
@@ -329,7 +417,7 @@ void FeatureType::ParseHeader2()
     return;
 
   CHECK(m_loadInfo, ());
-  ParseCommon();
+  ParseCommonOffsets();
 
   uint8_t ptsCount = 0, ptsMask = 0, trgCount = 0, trgMask = 0;
   BitSource bitSource(m_data + m_offsets.m_header2);
@@ -440,7 +528,10 @@ uint32_t FeatureType::ParseGeometry(int scale)
 
           serial::GeometryCodingParams cp = m_loadInfo->GetGeometryCodingParams(ind);
           cp.SetBasePoint(m_points[0]);
-          serial::LoadOuterPath(src, cp, m_points);
+          if (m_loadInfo->HasPointsBlocks())
+            serial::LoadOuterPathBlocks(src, cp, m_points);
+          else
+            serial::LoadOuterPath(src, cp, m_points);
 
           sz = static_cast<uint32_t>(src.Pos() - m_offsets.m_pts[ind]);
         }
@@ -547,10 +638,23 @@ void FeatureType::ParseMetadata()
 
 StringUtf8Multilang const & FeatureType::GetNames()
 {
-  ParseCommon();
+  ParseNames();
   return m_params.name;
 }
 
+StringUtf8MultilangView FeatureType::GetNamesView()
+{
+  if (m_parsed.m_names)
+    return m_params.name.GetView();
+
+  if (!HasName())
+    return {};
+
+  ParseTypes();
+  ArrayByteSource source(m_data + m_offsets.m_common);
+  return StringUtf8MultilangView::Read(source);
+}
+
 namespace
 {
   template <class TCont>
@@ -677,8 +781,6 @@ void FeatureType::GetPreferredNames(string & primary, string & secondary)
   if (!mwmInfo)
     return;
 
-  ParseCommon();
-
   auto const deviceLang = StringUtf8Multilang::GetLangIndex(languages::GetCurrentNorm());
   ::GetPreferredNames(mwmInfo->GetRegionData(), GetNames(), deviceLang, false /* allowTranslit */,
                       primary, secondary);
@@ -695,8 +797,6 @@ void FeatureType::GetPreferredNames(bool allowTranslit, int8_t deviceLang, strin
   if (!mwmInfo)
     return;
 
-  ParseCommon();
-
   ::GetPreferredNames(mwmInfo->GetRegionData(), GetNames(), deviceLang, allowTranslit,
                       primary, secondary);
 }
@@ -711,8 +811,6 @@ void FeatureType::GetReadableName(string & name)
   if (!mwmInfo)
     return;
 
-  ParseCommon();
-
   auto const deviceLang = StringUtf8Multilang::GetLangIndex(languages::GetCurrentNorm());
   ::GetReadableName(mwmInfo->GetRegionData(), GetNames(), deviceLang, false /* allowTranslit */,
                     name);
@@ -728,8 +826,6 @@ void FeatureType::GetReadableName(bool allowTranslit, int8_t deviceLang, string
   if (!mwmInfo)
     return;
 
-  ParseCommon();
-
   ::GetReadableName(mwmInfo->GetRegionData(), GetNames(), deviceLang, allowTranslit, name);
 }
 
@@ -744,14 +840,23 @@ bool FeatureType::GetName(int8_t lang, string & name)
   if (!HasName())
     return false;
 
-  ParseCommon();
-  return m_params.name.GetString(lang, name);
+  // Look for the name in the record without decoding the other names.
+  return GetNamesView().GetString(lang, name);
 }
 
 uint8_t FeatureType::GetRank()
 {
-  ParseCommon();
-  return m_params.rank;
+  if (m_parsed.m_common)
+    return m_params.rank;
+
+  if ((m_header & feature::HEADER_MASK_HAS_ADDINFO) == 0 ||
+      static_cast<HeaderGeomType>(m_header & HEADER_MASK_GEOMTYPE) != HeaderGeomType::Point)
+  {
+    return 0;
+  }
+
+  ParseCommonOffsets();
+  return static_cast<uint8_t>(m_data[m_offsets.m_addInfo]);
 }
 
 uint64_t FeatureType::GetPopulation() { return feature::RankToPopulation(GetRank()); }
@@ -34,9 +34,29 @@ public:
   using Buffer = char const *;
   using GeometryOffsets = buffer_vector<uint32_t, feature::DataHeader::kMaxScalesCount>;
 
+  /// Parts of the feature for ParseFields().
+  enum Field : uint8_t
+  {
+    FIELD_TYPES = 1 << 0,
+    /// The center of the point features.
+    FIELD_CENTER = 1 << 1,
+    FIELD_NAMES = 1 << 2,
+    /// The names, the layer and the additional info: the rank, the road number or the house.
+    FIELD_COMMON = 1 << 3,
+    /// The inner geometry and the offsets of the outer geometry.
+    FIELD_HEADER2 = 1 << 4,
+    FIELD_METADATA = 1 << 5
+  };
+
   FeatureType(feature::SharedLoadInfo const * loadInfo, Buffer buffer);
   FeatureType(osm::MapObject const & emo);
 
+  /// Decodes exactly the |fields| (a mask of Field) at once, the other parts of the record
+  /// which precede them are skipped by the stored lengths. The accessors decode only what they
+  /// need too: GetCenter(), GetLayer(), GetRank(), GetName(lang) and the geometry do not decode
+  /// the names and the other strings.
+  void ParseFields(uint8_t fields);
+
   feature::GeomType GetGeomType() const;
   FeatureParamsBase & GetParams() { return m_params; }
 
@@ -44,6 +64,9 @@ public:
 
   bool HasName() const { return (m_header & feature::HEADER_MASK_HAS_NAME) != 0; }
   StringUtf8Multilang const & GetNames();
+  // The view of the names in the feature data which does not copy them. The view is valid
+  // while the feature is alive.
+  StringUtf8MultilangView GetNamesView();
 
   m2::PointD GetCenter();
 
@@ -53,7 +76,7 @@ public:
     if (!HasName())
       return false;
 
-    ParseCommon();
+    ParseNames();
     m_params.name.ForEach(std::forward<T>(fn));
     return true;
   }
@@ -188,31 +211,42 @@ private:
   struct ParsedFlags
   {
     bool m_types = false;
+    bool m_commonOffsets = false;
+    bool m_names = false;
     bool m_common = false;
     bool m_header2 = false;
     bool m_points = false;
     bool m_triangles = false;
     bool m_metadata = false;
 
-    void Reset() { m_types = m_common = m_header2 = m_points = m_triangles = m_metadata = false; }
+    void Reset()
+    {
+      m_types = m_commonOffsets = m_names = m_common = m_header2 = m_points = m_triangles =
+          m_metadata = false;
+    }
   };
 
   struct Offsets
   {
     uint32_t m_common = 0;
+    uint32_t m_layer = 0;
+    uint32_t m_addInfo = 0;
     uint32_t m_header2 = 0;
     GeometryOffsets m_pts;
     GeometryOffsets m_trg;
 
     void Reset()
     {
-      m_common = m_header2 = 0;
+      m_common = m_layer = m_addInfo = m_header2 = 0;
       m_pts.clear();
       m_trg.clear();
     }
   };
 
   void ParseTypes();
+  // Finds the offsets of the common fields and decodes the center.
+  void ParseCommonOffsets();
+  void ParseNames();
   void ParseCommon();
   void ParseHeader2();
   void ParseMetadata();
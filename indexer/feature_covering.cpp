@@ -5,6 +5,14 @@
 
 #include "geometry/covering_utils.hpp"
 
+#include "base/buffer_vector.hpp"
+#include "base/math.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
 using namespace std;
 
 namespace
@@ -25,6 +33,37 @@ public:
   vector<Trg> m_trg;
   m2::RectD m_rect;
 
+  // Indexes the triangles and the segments of the polyline by the cells of a grid over m_rect,
+  // so a covering cell is tested against the items of the grid cells it overlaps only. Must be
+  // called when all the points are added.
+  void BuildIndex()
+  {
+    size_t const itemsCount = max(m_trg.size(), m_polyline.size());
+    if (itemsCount < kMinItemsToIndex)
+      return;
+
+    m_gridSize = min(kMaxGridSize, static_cast<uint32_t>(ceil(sqrt(itemsCount))));
+    m_gridCellWidth = max(m_rect.SizeX(), 1.0) / m_gridSize;
+    m_gridCellHeight = max(m_rect.SizeY(), 1.0) / m_gridSize;
+
+    m_trgGrid.assign(m_gridSize * m_gridSize, {});
+    for (size_t i = 0; i < m_trg.size(); ++i)
+    {
+      m2::RectD r;
+      r.Add(m_trg[i].m_a);
+      r.Add(m_trg[i].m_b);
+      r.Add(m_trg[i].m_c);
+      AddToGrid(r, static_cast<uint32_t>(i), m_trgGrid);
+    }
+
+    m_segmentsGrid.assign(m_gridSize * m_gridSize, {});
+    for (size_t i = 1; i < m_polyline.size(); ++i)
+    {
+      m2::RectD r(m_polyline[i - 1], m_polyline[i]);
+      AddToGrid(r, static_cast<uint32_t>(i), m_segmentsGrid);
+    }
+  }
+
   // Note:
   // 1. Here we don't need to differentiate between CELL_OBJECT_INTERSECT and OBJECT_INSIDE_CELL.
   // 2. We can return CELL_OBJECT_INTERSECT instead of CELL_INSIDE_OBJECT - it's just
@@ -46,7 +85,9 @@ public:
         return CELL_OBJECT_NO_INTERSECTION;
     }
 
-    for (size_t i = 0; i < m_trg.size(); ++i)
+    buffer_vector<uint32_t, 32> candidates;
+    GetCandidates(cellRect, m_trgGrid, 0 /* first */, m_trg.size(), candidates);
+    for (auto const i : candidates)
     {
       m2::RectD r;
       r.Add(m_trg[i].m_a);
@@ -70,7 +111,8 @@ public:
       }
     }
 
-    for (size_t i = 1; i < m_polyline.size(); ++i)
+    GetCandidates(cellRect, m_segmentsGrid, 1 /* first */, m_polyline.size(), candidates);
+    for (auto const i : candidates)
     {
       CellObjectIntersection const res =
           IntersectCellWithLine(cell, m_polyline[i], m_polyline[i-1]);
@@ -108,6 +150,79 @@ public:
   {
     m_trg.emplace_back(ConvertPoint(a), ConvertPoint(b), ConvertPoint(c));
   }
+
+private:
+  static size_t constexpr kMinItemsToIndex = 32;
+  static uint32_t constexpr kMaxGridSize = 256;
+  // The cells overlapping more grid cells are tested against all the items.
+  static uint32_t constexpr kMaxGridCellsToLookUp = 16;
+
+  using Grid = vector<vector<uint32_t>>;
+
+  // Returns the range [minX, maxX] x [minY, maxY] of the grid cells overlapping |r|.
+  array<uint32_t, 4> GetGridRange(m2::RectD const & r) const
+  {
+    auto const toCell = [this](double c, double origin, double cellSize) {
+      auto const i = floor((c - origin) / cellSize);
+      return static_cast<uint32_t>(base::clamp(i, 0.0, static_cast<double>(m_gridSize - 1)));
+    };
+    return {{toCell(r.minX(), m_rect.minX(), m_gridCellWidth),
+             toCell(r.minY(), m_rect.minY(), m_gridCellHeight),
+             toCell(r.maxX(), m_rect.minX(), m_gridCellWidth),
+             toCell(r.maxY(), m_rect.minY(), m_gridCellHeight)}};
+  }
+
+  void AddToGrid(m2::RectD const & r, uint32_t item, Grid & grid) const
+  {
+    auto const range = GetGridRange(r);
+    for (auto y = range[1]; y <= range[3]; ++y)
+    {
+      for (auto x = range[0]; x <= range[2]; ++x)
+        grid[y * m_gridSize + x].push_back(item);
+    }
+  }
+
+  // Gets the items of [first, last) which may intersect |cellRect| in the ascending order, so
+  // the intersection is the same as by all the items.
+  template <typename Candidates>
+  void GetCandidates(m2::RectD const & cellRect, Grid const & grid, size_t first, size_t last,
+                     Candidates & candidates) const
+  {
+    candidates.clear();
+    if (!grid.empty())
+    {
+      auto const range = GetGridRange(cellRect);
+      size_t const gridCellsCount = (range[2] - range[0] + 1) * (range[3] - range[1] + 1);
+      if (gridCellsCount <= kMaxGridCellsToLookUp)
+      {
+        for (auto y = range[1]; y <= range[3]; ++y)
+        {
+          for (auto x = range[0]; x <= range[2]; ++x)
+          {
+            auto const & items = grid[y * m_gridSize + x];
+            candidates.insert(candidates.end(), items.begin(), items.end());
+          }
+        }
+
+        if (gridCellsCount > 1)
+        {
+          sort(candidates.begin(), candidates.end());
+          candidates.resize(static_cast<size_t>(
+              unique(candidates.begin(), candidates.end()) - candidates.begin()));
+        }
+        return;
+      }
+    }
+
+    for (size_t i = first; i < last; ++i)
+      candidates.push_back(static_cast<uint32_t>(i));
+  }
+
+  uint32_t m_gridSize = 0;
+  double m_gridCellWidth = 0.0;
+  double m_gridCellHeight = 0.0;
+  Grid m_trgGrid;
+  Grid m_segmentsGrid;
 };
 
 template <int DEPTH_LEVELS>
@@ -120,6 +235,7 @@ void GetIntersection(FeatureType & f, FeatureIntersector<DEPTH_LEVELS> & fIsect)
 
   f.ForEachPoint(fIsect, scale);
   f.ForEachTriangle(fIsect, scale);
+  fIsect.BuildIndex();
 
   CHECK(!(fIsect.m_trg.empty() && fIsect.m_polyline.empty()) &&
         f.GetLimitRect(scale).IsValid(), (f.DebugString(scale)));
@@ -154,42 +270,68 @@ vector<int64_t> CoverIntersection(
   auto cover = [cellPenaltyArea] (auto const & intersect, int cellDepth) {
     vector<m2::CellId<DEPTH_LEVELS>> cells;
     covering::CoverObject(intersect, cellPenaltyArea, cells, cellDepth,
-                          m2::CellId<DEPTH_LEVELS>::Root());
+                          covering::GetCoveringRoot<m2::CellId<DEPTH_LEVELS>>(
+                              intersect.m_rect, cellDepth, cellPenaltyArea));
     return cells;
   };
 
   return CoverIntersection(cover, fIsect, cellDepth);
 }
 
+// The covering is refined up to the depth by covering::GetCoveringDepth() and is coded
+// with |cellDepth|.
 template <int DEPTH_LEVELS>
-vector<int64_t> CoverIntersection(
-    FeatureIntersector<DEPTH_LEVELS> const & fIsect, int cellDepth,
+vector<int64_t> CoverIntersectionByBudget(FeatureIntersector<DEPTH_LEVELS> const & fIsect,
+                                          int cellDepth, size_t cellsBudget)
+{
+  auto cover = [cellsBudget] (auto const & intersect, int cellDepth) {
+    auto const coveringDepth = covering::GetCoveringDepth<m2::CellId<DEPTH_LEVELS>>(
+        intersect.m_rect, cellDepth, cellsBudget);
+    vector<m2::CellId<DEPTH_LEVELS>> cells;
+    covering::CoverObject(intersect, 0 /* cellPenaltyArea */, cells, coveringDepth,
+                          covering::GetCoveringRoot<m2::CellId<DEPTH_LEVELS>>(
+                              intersect.m_rect, coveringDepth));
+    return cells;
+  };
+
+  return CoverIntersection(cover, fIsect, cellDepth);
+}
+
+template <int DEPTH_LEVELS>
+vector<int64_t> CoverIntersectionByBudget(
+    FeatureIntersector<DEPTH_LEVELS> const & fIsect, int cellDepth, size_t cellsBudget,
     base::thread_pool::computational::ThreadPool & threadPool)
 {
   auto cover = [&] (auto const & intersect, int cellDepth) {
-    return covering::CoverObject<m2::CellId<DEPTH_LEVELS>>(intersect, cellDepth, threadPool);
+    auto const coveringDepth = covering::GetCoveringDepth<m2::CellId<DEPTH_LEVELS>>(
+        intersect.m_rect, cellDepth, cellsBudget);
+    return covering::CoverObject<m2::CellId<DEPTH_LEVELS>>(
+        intersect, coveringDepth, threadPool,
+        covering::GetCoveringRoot<m2::CellId<DEPTH_LEVELS>>(intersect.m_rect, coveringDepth));
   };
 
   return CoverIntersection(cover, fIsect, cellDepth);
 }
 
 template <int DEPTH_LEVELS>
-vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth)
+vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth, size_t cellsBudget)
 {
   FeatureIntersector<DEPTH_LEVELS> fIsect;
   o.ForEachPoint(fIsect);
   o.ForEachTriangle(fIsect);
-  return CoverIntersection(fIsect, cellDepth, 0 /* cellPenaltyArea */);
+  fIsect.BuildIndex();
+  return CoverIntersectionByBudget(fIsect, cellDepth, cellsBudget);
 }
 
 template <int DEPTH_LEVELS>
-vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth,
+vector<int64_t> Cover(indexer::CoveredObject const & o, int cellDepth, size_t cellsBudget,
                       base::thread_pool::computational::ThreadPool & threadPool)
 {
   FeatureIntersector<DEPTH_LEVELS> fIsect;
   o.ForEachPoint(fIsect);
   o.ForEachTriangle(fIsect);
-  return CoverIntersection(fIsect, cellDepth, threadPool);
+  fIsect.BuildIndex();
+  return CoverIntersectionByBudget(fIsect, cellDepth, cellsBudget, threadPool);
 }
 }  // namespace
 
@@ -202,15 +344,16 @@ vector<int64_t> CoverFeature(FeatureType & f, int cellDepth, uint64_t cellPenalt
   return CoverIntersection(fIsect, cellDepth, cellPenaltyArea);
 }
 
-vector<int64_t> CoverGeoObject(indexer::CoveredObject const & o, int cellDepth)
+vector<int64_t> CoverGeoObject(indexer::CoveredObject const & o, int cellDepth,
+                               size_t cellsBudget)
 {
-  return Cover<kGeoObjectsDepthLevels>(o, cellDepth);
+  return Cover<kGeoObjectsDepthLevels>(o, cellDepth, cellsBudget);
 }
 
-vector<int64_t> CoverRegion(indexer::CoveredObject const & o, int cellDepth,
+vector<int64_t> CoverRegion(indexer::CoveredObject const & o, int cellDepth, size_t cellsBudget,
                             base::thread_pool::computational::ThreadPool & threadPool)
 {
-  return Cover<kRegionsDepthLevels>(o, cellDepth, threadPool);
+  return Cover<kRegionsDepthLevels>(o, cellDepth, cellsBudget, threadPool);
 }
 
 void SortAndMergeIntervals(Intervals v, Intervals & res)
@@ -239,4 +382,128 @@ Intervals SortAndMergeIntervals(Intervals const & v)
   SortAndMergeIntervals(v, res);
   return res;
 }
+
+bool IsSortedAndDisjoint(Intervals const & intervals)
+{
+  for (size_t i = 1; i < intervals.size(); ++i)
+  {
+    if (intervals[i - 1].second > intervals[i].first)
+      return false;
+  }
+  return true;
+}
+
+m2::RectD GetTileRect(uint32_t x, uint32_t y, uint8_t zoom)
+{
+  CHECK_LESS(zoom, 32, ());
+  uint64_t const tilesCount = uint64_t{1} << zoom;
+  CHECK_LESS(x, tilesCount, ());
+  CHECK_LESS(y, tilesCount, ());
+
+  double const sizeX = MercatorBounds::kRangeX / tilesCount;
+  double const sizeY = MercatorBounds::kRangeY / tilesCount;
+  return {MercatorBounds::kMinX + sizeX * x, MercatorBounds::kMinY + sizeY * y,
+          MercatorBounds::kMinX + sizeX * (x + 1), MercatorBounds::kMinY + sizeY * (y + 1)};
+}
+
+// CoveringCache -----------------------------------------------------------------------------------
+// static
+size_t constexpr CoveringCache::kShardsCount;
+
+CoveringCache::CoveringCache(uint32_t logCacheSize)
+{
+  static_assert((kShardsCount & (kShardsCount - 1)) == 0, "");
+  uint32_t logShardsCount = 0;
+  while ((size_t{1} << logShardsCount) < kShardsCount)
+    ++logShardsCount;
+
+  // base::Cache needs at least two slots.
+  auto const logShardSize = max<uint32_t>(logCacheSize, logShardsCount + 1) - logShardsCount;
+  for (auto & shard : m_shards)
+    shard.m_cache.Init(logShardSize);
+}
+
+shared_ptr<Intervals const> CoveringCache::Get(m2::RectD const & rect, CoveringMode mode,
+                                               int depthLevels, int cellDepth)
+{
+  ++m_accesses;
+  Key const key{rect, mode, depthLevels, cellDepth};
+  auto const hash = Hash(key);
+  auto & shard = m_shards[hash % kShardsCount];
+
+  lock_guard<mutex> lock(shard.m_mutex);
+  bool found = false;
+  auto & value = shard.m_cache.Find(hash, found);
+  if (!found || !value.m_valid || !(value.m_key == key))
+  {
+    // Find() has taken the slot for |hash|, the previous value must not be returned for it.
+    if (!found)
+      value = Value{};
+    return {};
+  }
+
+  ++m_hits;
+  return value.m_intervals;
+}
+
+void CoveringCache::Put(m2::RectD const & rect, CoveringMode mode, int depthLevels, int cellDepth,
+                        shared_ptr<Intervals const> intervals)
+{
+  Key const key{rect, mode, depthLevels, cellDepth};
+  auto const hash = Hash(key);
+  auto & shard = m_shards[hash % kShardsCount];
+
+  lock_guard<mutex> lock(shard.m_mutex);
+  bool found = false;
+  auto & value = shard.m_cache.Find(hash, found);
+  value.m_valid = true;
+  value.m_key = key;
+  value.m_intervals = move(intervals);
+}
+
+void CoveringCache::Clear()
+{
+  for (auto & shard : m_shards)
+  {
+    lock_guard<mutex> lock(shard.m_mutex);
+    shard.m_cache.ForEachValue([](Value & value) { value = Value{}; });
+    shard.m_cache.Reset();
+  }
+  m_accesses = 0;
+  m_hits = 0;
+}
+
+double CoveringCache::GetHitRatio() const
+{
+  uint64_t const accesses = m_accesses;
+  if (accesses == 0)
+    return 0.0;
+  return static_cast<double>(m_hits) / static_cast<double>(accesses);
+}
+
+bool CoveringCache::Key::operator==(Key const & rhs) const
+{
+  // The coverings of the close rects may differ, so the rects are compared exactly.
+  return m_rect.minX() == rhs.m_rect.minX() && m_rect.minY() == rhs.m_rect.minY() &&
+         m_rect.maxX() == rhs.m_rect.maxX() && m_rect.maxY() == rhs.m_rect.maxY() &&
+         m_mode == rhs.m_mode && m_depthLevels == rhs.m_depthLevels &&
+         m_cellDepth == rhs.m_cellDepth;
+}
+
+// static
+uint64_t CoveringCache::Hash(Key const & key)
+{
+  uint64_t result = (static_cast<uint64_t>(key.m_mode) << 16) ^
+                    (static_cast<uint64_t>(key.m_depthLevels) << 8) ^
+                    static_cast<uint64_t>(key.m_cellDepth);
+  for (double const coord :
+       {key.m_rect.minX(), key.m_rect.minY(), key.m_rect.maxX(), key.m_rect.maxY()})
+  {
+    uint64_t bits = 0;
+    static_assert(sizeof(bits) == sizeof(coord), "");
+    memcpy(&bits, &coord, sizeof(bits));
+    result = result * 1000003ULL ^ bits;
+  }
+  return result;
+}
 }
@@ -10,10 +10,16 @@
 #include "geometry/mercator.hpp"
 #include "geometry/rect2d.hpp"
 
+#include "base/cache.hpp"
 #include "base/logging.hpp"
 #include "base/thread_pool_computational.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <utility>
 #include <vector>
@@ -33,13 +39,19 @@ typedef std::vector<Interval> Intervals;
 // Cover feature with RectIds and return their integer representations.
 std::vector<int64_t> CoverFeature(FeatureType & feature, int cellDepth, uint64_t cellPenaltyArea);
 
+// The coverings are coded with |cellDepth|. The boundaries of the bigger objects are covered by
+// the coarser cells, about |cellsBudget| of them, see covering::GetCoveringDepth().
 std::vector<int64_t> CoverRegion(indexer::CoveredObject const & o, int cellDepth,
+                                 size_t cellsBudget,
                                  base::thread_pool::computational::ThreadPool & threadPool);
-std::vector<int64_t> CoverGeoObject(indexer::CoveredObject const & o, int cellDepth);
+std::vector<int64_t> CoverGeoObject(indexer::CoveredObject const & o, int cellDepth,
+                                    size_t cellsBudget);
 
 // Given a vector of intervals [a, b), sort them and merge overlapping intervals.
 Intervals SortAndMergeIntervals(Intervals const & intervals);
 void SortAndMergeIntervals(Intervals v, Intervals & res);
+// Whether intervals [a, b) are sorted and do not overlap as the merged intervals are.
+bool IsSortedAndDisjoint(Intervals const & intervals);
 
 template <int DEPTH_LEVELS>
 m2::CellId<DEPTH_LEVELS> GetRectIdAsIs(m2::RectD const & r)
@@ -99,15 +111,82 @@ enum CoveringMode
   Spiral
 };
 
+// Returns the rect of the tile (|x|, |y|) of the mercator plane split into 2^|zoom| x 2^|zoom|
+// tiles, |x| grows to the east and |y| grows to the north. A tile has the same rect for every
+// call, so the repeated queries of the tiles hit the CoveringCache.
+m2::RectD GetTileRect(uint32_t x, uint32_t y, uint8_t zoom);
+
+// A size-bounded thread-safe cache of the coverings computed by CoveringGetter. The coverings
+// are keyed on the exact rect, the mode and the depths of the cells, so the repeated queries
+// of the same rects, e.g. of the tiles, do not compute them again. The cache is split into
+// shards with their own locks, every shard is a direct-mapped base::Cache.
+class CoveringCache
+{
+public:
+  // |logCacheSize| is the log2 of the number of cached coverings.
+  explicit CoveringCache(uint32_t logCacheSize);
+
+  // Returns nullptr when the covering is not cached.
+  std::shared_ptr<Intervals const> Get(m2::RectD const & rect, CoveringMode mode, int depthLevels,
+                                       int cellDepth);
+  void Put(m2::RectD const & rect, CoveringMode mode, int depthLevels, int cellDepth,
+           std::shared_ptr<Intervals const> intervals);
+
+  void Clear();
+
+  uint64_t GetAccessesCount() const { return m_accesses; }
+  uint64_t GetHitsCount() const { return m_hits; }
+  double GetHitRatio() const;
+
+private:
+  static size_t constexpr kShardsCount = 8;
+
+  struct Key
+  {
+    bool operator==(Key const & rhs) const;
+
+    m2::RectD m_rect;
+    CoveringMode m_mode = ViewportWithLowLevels;
+    int m_depthLevels = 0;
+    int m_cellDepth = 0;
+  };
+
+  struct Value
+  {
+    bool m_valid = false;
+    Key m_key;
+    std::shared_ptr<Intervals const> m_intervals;
+  };
+
+  struct Shard
+  {
+    std::mutex m_mutex;
+    base::Cache<uint64_t, Value> m_cache;
+  };
+
+  static uint64_t Hash(Key const & key);
+
+  std::array<Shard, kShardsCount> m_shards;
+  std::atomic<uint64_t> m_accesses{0};
+  std::atomic<uint64_t> m_hits{0};
+};
+
 class CoveringGetter
 {
   Intervals m_res[2];
+  // The coverings shared with |m_cache|.
+  std::shared_ptr<Intervals const> m_cached[2];
 
   m2::RectD const & m_rect;
   CoveringMode m_mode;
+  CoveringCache * m_cache;
 
 public:
-  CoveringGetter(m2::RectD const & r, CoveringMode mode) : m_rect(r), m_mode(mode) {}
+  // The coverings are looked up in |cache| and put to it when it is not null.
+  CoveringGetter(m2::RectD const & r, CoveringMode mode, CoveringCache * cache = nullptr)
+    : m_rect(r), m_mode(mode), m_cache(cache)
+  {
+  }
 
   m2::RectD const & GetRect() const { return m_rect; }
 
@@ -117,61 +196,81 @@ public:
     int const cellDepth = GetCodingDepth<DEPTH_LEVELS>(scale);
     int const ind = (cellDepth == DEPTH_LEVELS ? 0 : 1);
 
-    if (m_res[ind].empty())
+    if (m_cached[ind])
+      return *m_cached[ind];
+
+    if (m_cache)
     {
-      switch (m_mode)
+      m_cached[ind] = m_cache->Get(m_rect, m_mode, DEPTH_LEVELS, cellDepth);
+      if (!m_cached[ind])
       {
-      case ViewportWithLowLevels:
-        CoverViewportAndAppendLowerLevels<DEPTH_LEVELS>(m_rect, cellDepth, m_res[ind]);
-        break;
+        Intervals res;
+        Cover<DEPTH_LEVELS>(cellDepth, res);
+        m_cached[ind] = std::make_shared<Intervals const>(std::move(res));
+        m_cache->Put(m_rect, m_mode, DEPTH_LEVELS, cellDepth, m_cached[ind]);
+      }
+      return *m_cached[ind];
+    }
 
-      case LowLevelsOnly:
-      {
-        m2::CellId<DEPTH_LEVELS> id = GetRectIdAsIs<DEPTH_LEVELS>(m_rect);
-        while (id.Level() >= cellDepth)
-          id = id.Parent();
-        AppendLowerLevels<DEPTH_LEVELS>(id, cellDepth, [this, ind](Interval const & interval) {
-          m_res[ind].push_back(interval);
-        });
-
-        // Check for optimal result intervals.
+    if (m_res[ind].empty())
+      Cover<DEPTH_LEVELS>(cellDepth, m_res[ind]);
+
+    return m_res[ind];
+  }
+
+private:
+  template <int DEPTH_LEVELS>
+  void Cover(int cellDepth, Intervals & res) const
+  {
+    switch (m_mode)
+    {
+    case ViewportWithLowLevels:
+      CoverViewportAndAppendLowerLevels<DEPTH_LEVELS>(m_rect, cellDepth, res);
+      break;
+
+    case LowLevelsOnly:
+    {
+      m2::CellId<DEPTH_LEVELS> id = GetRectIdAsIs<DEPTH_LEVELS>(m_rect);
+      while (id.Level() >= cellDepth)
+        id = id.Parent();
+      AppendLowerLevels<DEPTH_LEVELS>(id, cellDepth, [&res](Interval const & interval) {
+        res.push_back(interval);
+      });
+
+      // Check for optimal result intervals.
 #if 0
-        size_t oldSize = m_res[ind].size();
-        Intervals res;
-        SortAndMergeIntervals(m_res[ind], res);
-        if (res.size() != oldSize)
-          LOG(LINFO, ("Old =", oldSize, "; New =", res.size()));
-        res.swap(m_res[ind]);
+      size_t oldSize = res.size();
+      Intervals merged;
+      SortAndMergeIntervals(res, merged);
+      if (merged.size() != oldSize)
+        LOG(LINFO, ("Old =", oldSize, "; New =", merged.size()));
+      merged.swap(res);
 #endif
-        break;
-      }
+      break;
+    }
+
+    case FullCover:
+      res.push_back(Intervals::value_type(0, static_cast<int64_t>((uint64_t{1} << 63) - 1)));
+      break;
 
-      case FullCover:
-        m_res[ind].push_back(
-            Intervals::value_type(0, static_cast<int64_t>((uint64_t{1} << 63) - 1)));
-        break;
+    case Spiral:
+    {
+      std::vector<m2::CellId<DEPTH_LEVELS>> ids;
+      CoverSpiral<MercatorBounds, m2::CellId<DEPTH_LEVELS>>(m_rect, cellDepth - 1, ids);
 
-      case Spiral:
+      std::set<Interval> uniqueIds;
+      auto insertInterval = [&res, &uniqueIds](Interval const & interval) {
+        if (uniqueIds.insert(interval).second)
+          res.push_back(interval);
+      };
+
+      for (auto const & id : ids)
       {
-        std::vector<m2::CellId<DEPTH_LEVELS>> ids;
-        CoverSpiral<MercatorBounds, m2::CellId<DEPTH_LEVELS>>(m_rect, cellDepth - 1, ids);
-
-        std::set<Interval> uniqueIds;
-        auto insertInterval = [this, ind, &uniqueIds](Interval const & interval) {
-          if (uniqueIds.insert(interval).second)
-            m_res[ind].push_back(interval);
-        };
-
-        for (auto const & id : ids)
-        {
-          if (cellDepth > id.Level())
-            AppendLowerLevels<DEPTH_LEVELS>(id, cellDepth, insertInterval);
-        }
-      }
+        if (cellDepth > id.Level())
+          AppendLowerLevels<DEPTH_LEVELS>(id, cellDepth, insertInterval);
       }
     }
-
-    return m_res[ind];
+    }
   }
 };
 }
@@ -257,6 +257,16 @@ bool IsDummyName(string const & s)
 // FeatureParams implementation
 /////////////////////////////////////////////////////////////////////////////////////////
 
+void FeatureParams::Clear()
+{
+  MakeZero();
+  m_geomType = feature::HeaderGeomType::Point;
+  m_metadata.Clear();
+  m_addrTags.Clear();
+  m_types.clear();
+  m_reverseGeometry = false;
+}
+
 void FeatureParams::ClearName()
 {
   name.Clear();
@@ -229,6 +229,10 @@ public:
 
   FeatureParams() : m_reverseGeometry(false) {}
 
+  /// Resets the params to the default constructed ones, unlike MakeZero() which resets only
+  /// the base params. Keeps the capacity of the strings and the types.
+  void Clear();
+
   void ClearName();
 
   bool AddName(std::string const & lang, std::string const & s);
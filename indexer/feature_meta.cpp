@@ -1,7 +1,7 @@
 #include "indexer/feature_meta.hpp"
 
-
 #include <sstream>
+#include <unordered_map>
 
 using namespace std;
 
@@ -40,59 +40,46 @@ string Metadata::GetWikiURL() const
 // static
 bool Metadata::TypeFromString(string const & k, Metadata::EType & outType)
 {
-  if (k == "cuisine")
-    outType = Metadata::FMD_CUISINE;
-  else if (k == "opening_hours")
-    outType = Metadata::FMD_OPEN_HOURS;
-  else if (k == "phone" || k == "contact:phone")
-    outType = Metadata::FMD_PHONE_NUMBER;
-  else if (k == "fax" || k == "contact:fax")
-    outType = Metadata::EType::FMD_FAX_NUMBER;
-  else if (k == "stars")
-    outType = Metadata::FMD_STARS;
-  else if (k == "operator")
-    outType = Metadata::FMD_OPERATOR;
-  else if (k == "url")  // TODO: Should we match url to website here?
-    outType = Metadata::FMD_WEBSITE;
-  else if (k == "website" || k == "contact:website")
-    outType = Metadata::FMD_WEBSITE;
-  else if (k == "internet_access" || k == "wifi")
-    outType = Metadata::FMD_INTERNET;
-  else if (k == "ele")
-    outType = Metadata::FMD_ELE;
-  else if (k == "turn:lanes")
-    outType = Metadata::FMD_TURN_LANES;
-  else if (k == "turn:lanes:forward")
-    outType = Metadata::FMD_TURN_LANES_FORWARD;
-  else if (k == "turn:lanes:backward")
-    outType = Metadata::FMD_TURN_LANES_BACKWARD;
-  else if (k == "email" || k == "contact:email")
-    outType = Metadata::FMD_EMAIL;
-  else if (k == "addr:postcode")
-    outType = Metadata::FMD_POSTCODE;
-  else if (k == "wikipedia")
-    outType = Metadata::FMD_WIKIPEDIA;
-  else if (k == "addr:flats")
-    outType = Metadata::FMD_FLATS;
-  else if (k == "height")
-    outType = Metadata::FMD_HEIGHT;
-  else if (k == "min_height")
-    outType = Metadata::FMD_MIN_HEIGHT;
-  else if (k == "building:levels")
-    outType = Metadata::FMD_BUILDING_LEVELS;
-  else if (k == "denomination")
-    outType = Metadata::FMD_DENOMINATION;
-  else if (k == "banner_url")
-    outType = Metadata::FMD_BANNER_URL;
-  else if (k == "level")
-    outType = Metadata::FMD_LEVEL;
-  else if (k == "iata")
-    outType = Metadata::FMD_AIRPORT_IATA;
-  else if (k == "duration")
-    outType = Metadata::FMD_DURATION;
-  else
+  // The metadata is looked up for every tag of every element in the generator, so the keys
+  // are hashed once instead of being compared one by one.
+  static unordered_map<string, Metadata::EType> const kTypes = {
+      {"cuisine", Metadata::FMD_CUISINE},
+      {"opening_hours", Metadata::FMD_OPEN_HOURS},
+      {"phone", Metadata::FMD_PHONE_NUMBER},
+      {"contact:phone", Metadata::FMD_PHONE_NUMBER},
+      {"fax", Metadata::FMD_FAX_NUMBER},
+      {"contact:fax", Metadata::FMD_FAX_NUMBER},
+      {"stars", Metadata::FMD_STARS},
+      {"operator", Metadata::FMD_OPERATOR},
+      // TODO: Should we match url to website here?
+      {"url", Metadata::FMD_WEBSITE},
+      {"website", Metadata::FMD_WEBSITE},
+      {"contact:website", Metadata::FMD_WEBSITE},
+      {"internet_access", Metadata::FMD_INTERNET},
+      {"wifi", Metadata::FMD_INTERNET},
+      {"ele", Metadata::FMD_ELE},
+      {"turn:lanes", Metadata::FMD_TURN_LANES},
+      {"turn:lanes:forward", Metadata::FMD_TURN_LANES_FORWARD},
+      {"turn:lanes:backward", Metadata::FMD_TURN_LANES_BACKWARD},
+      {"email", Metadata::FMD_EMAIL},
+      {"contact:email", Metadata::FMD_EMAIL},
+      {"addr:postcode", Metadata::FMD_POSTCODE},
+      {"wikipedia", Metadata::FMD_WIKIPEDIA},
+      {"addr:flats", Metadata::FMD_FLATS},
+      {"height", Metadata::FMD_HEIGHT},
+      {"min_height", Metadata::FMD_MIN_HEIGHT},
+      {"building:levels", Metadata::FMD_BUILDING_LEVELS},
+      {"denomination", Metadata::FMD_DENOMINATION},
+      {"banner_url", Metadata::FMD_BANNER_URL},
+      {"level", Metadata::FMD_LEVEL},
+      {"iata", Metadata::FMD_AIRPORT_IATA},
+      {"duration", Metadata::FMD_DURATION}};
+
+  auto const it = kTypes.find(k);
+  if (it == kTypes.cend())
     return false;
 
+  outType = it->second;
   return true;
 }
 
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace feature
@@ -44,6 +45,7 @@ public:
 
   inline bool Empty() const { return m_metadata.empty(); }
   inline size_t Size() const { return m_metadata.size(); }
+  inline void Clear() { m_metadata.clear(); }
 
   template <class TSink>
   void Serialize(TSink & sink) const
@@ -75,20 +77,20 @@ public:
 
 protected:
   // TODO: Change uint8_t to appropriate type when FMD_COUNT reaches 256.
-  void Set(uint8_t type, std::string const & value)
+  void Set(uint8_t type, std::string value)
   {
     auto found = m_metadata.find(type);
     if (found == m_metadata.end())
     {
       if (!value.empty())
-        m_metadata[type] = value;
+        m_metadata[type] = std::move(value);
     }
     else
     {
       if (value.empty())
         m_metadata.erase(found);
       else
-        found->second = value;
+        found->second = std::move(value);
     }
   }
 
@@ -145,7 +147,7 @@ public:
   static bool TypeFromString(std::string const & osmTagKey, EType & outType);
   static bool IsSponsoredType(EType const & type);
 
-  void Set(EType type, std::string const & value) { MetadataBase::Set(type, value); }
+  void Set(EType type, std::string value) { MetadataBase::Set(type, std::move(value)); }
   void Drop(EType type) { Set(type, std::string()); }
   std::string GetWikiURL() const;
 
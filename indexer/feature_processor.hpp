@@ -5,9 +5,15 @@
 #include "coding/file_reader.hpp"
 #include "coding/file_container.hpp"
 
+#include "base/thread_pool_computational.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace feature
 {
@@ -23,4 +29,81 @@ void ForEachFromDat(std::string const & fPath, ToDo && toDo)
 {
   ForEachFromDat(std::make_unique<FileReader>(fPath), std::forward<ToDo>(toDo));
 }
+
+// Calls the copies of |toDo| for the features of the mapped |fPath| from |threadsCount|
+// threads. Every copy gets a contiguous range of the features and the copies are returned in
+// the order of the ranges, so the caller merges the thread-local aggregates.
+template <class ToDo>
+std::vector<ToDo> ForEachFromDatParallel(std::string const & fPath, ToDo const & toDo,
+                                         unsigned int threadsCount)
+{
+  // The features are read by the chunks of sorted indices to get their offsets by batches.
+  uint32_t constexpr kChunkSize = 1024;
+
+  FeaturesVectorTest features(FeaturesVectorTest::MapContainer(fPath));
+  auto const & vector = features.GetVector();
+  auto const featuresCount = static_cast<uint32_t>(vector.GetNumFeatures());
+  if (threadsCount <= 1 || !vector.IsConcurrent() || featuresCount == 0)
+  {
+    std::vector<ToDo> results(1, toDo);
+    vector.ForEach(results.front());
+    return results;
+  }
+
+  std::vector<ToDo> results(threadsCount, toDo);
+  auto const rangeSize = (featuresCount + threadsCount - 1) / threadsCount;
+  std::vector<std::future<void>> futures;
+  {
+    base::thread_pool::computational::ThreadPool threadPool(threadsCount);
+    for (unsigned int i = 0; i < threadsCount; ++i)
+    {
+      futures.push_back(threadPool.Submit([&vector, &results, featuresCount, rangeSize, i]() {
+        auto const end = std::min(featuresCount, (i + 1) * rangeSize);
+        std::vector<uint32_t> indices;
+        for (auto begin = i * rangeSize; begin < end; begin += kChunkSize)
+        {
+          indices.clear();
+          for (auto index = begin; index < std::min(end, begin + kChunkSize); ++index)
+            indices.push_back(index);
+
+          auto const fts = vector.GetByIndices(indices);
+          for (size_t j = 0; j < fts.size(); ++j)
+          {
+            fts[j]->SetID(FeatureID(MwmSet::MwmId(), indices[j]));
+            results[i](*fts[j], indices[j]);
+          }
+        }
+      }));
+    }
+  }
+
+  // Rethrows the exceptions of the tasks.
+  for (auto & future : futures)
+    future.get();
+  return results;
+}
+
+// Calls the copies of |toDo| for the features of |fPaths|, |threadsCount| files are processed
+// concurrently. The copies are returned in the order of |fPaths|.
+template <class ToDo>
+std::vector<ToDo> ForEachFromDats(std::vector<std::string> const & fPaths, ToDo const & toDo,
+                                  unsigned int threadsCount)
+{
+  std::vector<ToDo> results(fPaths.size(), toDo);
+  std::vector<std::future<void>> futures;
+  {
+    base::thread_pool::computational::ThreadPool threadPool(std::max(threadsCount, 1u));
+    for (size_t i = 0; i < fPaths.size(); ++i)
+    {
+      futures.push_back(threadPool.Submit([&fPaths, &results, i]() {
+        FeaturesVectorTest features(FeaturesVectorTest::MapContainer(fPaths[i]));
+        features.GetVector().ForEach(results[i]);
+      }));
+    }
+  }
+
+  for (auto & future : futures)
+    future.get();
+  return results;
+}
 }  // namespace feature
@@ -42,6 +42,17 @@ unique_ptr<FeatureType> FeatureSource::GetOriginalFeature(uint32_t index) const
   return ft;
 }
 
+vector<unique_ptr<FeatureType>> FeatureSource::GetOriginalFeatures(
+    vector<uint32_t> const & indices) const
+{
+  ASSERT(m_handle.IsAlive(), ());
+  ASSERT(m_vector != nullptr, ());
+  auto fts = m_vector->GetByIndices(indices);
+  for (size_t i = 0; i < fts.size(); ++i)
+    fts[i]->SetID(FeatureID(m_handle.GetId(), indices[i]));
+  return fts;
+}
+
 FeatureStatus FeatureSource::GetFeatureStatus(uint32_t /*index*/) const
 {
   return FeatureStatus::Untouched;
@@ -10,6 +10,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 enum class FeatureStatus
 {
@@ -34,6 +35,9 @@ public:
   size_t GetNumFeatures() const;
 
   std::unique_ptr<FeatureType> GetOriginalFeature(uint32_t index) const;
+  // Returns the original features |indices| sorted in the ascending order.
+  std::vector<std::unique_ptr<FeatureType>> GetOriginalFeatures(
+      std::vector<uint32_t> const & indices) const;
 
   FeatureID GetFeatureId(uint32_t index) const { return FeatureID(m_handle.GetId(), index); }
 
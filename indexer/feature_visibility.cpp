@@ -131,27 +131,6 @@ void FilterRulesByRuntimeSelector(FeatureType & f, int zoomLevel, drule::KeysT &
 
 namespace
 {
-  class IsDrawableChecker
-  {
-    int m_scale;
-
-  public:
-    explicit IsDrawableChecker(int scale) : m_scale(scale) {}
-
-    typedef bool ResultType;
-
-    void operator() (ClassifObject const *) {}
-    bool operator() (ClassifObject const * p, bool & res)
-    {
-      if (p->IsDrawable(m_scale))
-      {
-        res = true;
-        return true;
-      }
-      return false;
-    }
-  };
-
   class IsDrawableLikeChecker
   {
     GeomType m_geomType;
@@ -287,6 +266,24 @@ namespace
 
     return false;
   }
+
+  // Returns the levels on which at least one of |types| is drawable for index. Each type is
+  // looked up in the classificator once for all the levels.
+  ClassifObject::VisibleMask GetDrawableForIndexLevels(TypesHolder const & types)
+  {
+    Classificator const & c = classif();
+    ClassifObject::VisibleMask levels;
+    for (uint32_t t : types)
+    {
+      if (TypeAlwaysExists(t))
+        return ClassifObject::VisibleMask().set();
+
+      ClassifObject const * p = c.GetObject(t);
+      if (p != c.GetRoot() && p->IsDrawableAny())
+        levels |= p->GetVisibility();
+    }
+    return levels;
+  }
 }  // namespace
 
 bool TypeIsUseful(uint32_t type)
@@ -317,6 +314,19 @@ bool IsDrawableForIndex(TypesHolder const & types, m2::RectD limitRect, int leve
          IsDrawableForIndexClassifOnly(types, level);
 }
 
+bool IsDrawableForIndexInRange(TypesHolder const & types, m2::RectD limitRect, int lowLevel,
+                               int highLevel)
+{
+  auto const levels = GetDrawableForIndexLevels(types);
+  highLevel = min(highLevel, scales::GetUpperStyleScale());
+  for (int level = lowLevel; level <= highLevel; ++level)
+  {
+    if (levels[level] && IsDrawableForIndexGeometryOnly(types, limitRect, level))
+      return true;
+  }
+  return false;
+}
+
 bool IsDrawableForIndexGeometryOnly(FeatureType & ft, int level)
 {
   return IsDrawableForIndexGeometryOnly(TypesHolder(ft),
@@ -337,15 +347,8 @@ bool IsDrawableForIndexGeometryOnly(TypesHolder const & types, m2::RectD limitRe
 
 bool IsDrawableForIndexClassifOnly(TypesHolder const & types, int level)
 {
-  Classificator const & c = classif();
-  IsDrawableChecker doCheck(level);
-  for (uint32_t t : types)
-  {
-    if (TypeAlwaysExists(t) || c.ProcessObjects(t, doCheck))
-      return true;
-  }
-
-  return false;
+  ASSERT_LESS_OR_EQUAL(level, scales::GetUpperStyleScale(), ());
+  return GetDrawableForIndexLevels(types)[level];
 }
 
 bool IsUsefulType(uint32_t t, GeomType geomType, bool emptyName)
@@ -398,10 +401,11 @@ int GetMinDrawableScale(FeatureType & ft)
 int GetMinDrawableScale(TypesHolder const & types, m2::RectD limitRect)
 {
   int const upBound = scales::GetUpperStyleScale();
+  auto const levels = GetDrawableForIndexLevels(types);
 
   for (int level = 0; level <= upBound; ++level)
   {
-    if (IsDrawableForIndex(types, limitRect, level))
+    if (levels[level] && IsDrawableForIndexGeometryOnly(types, limitRect, level))
       return level;
   }
 
@@ -411,10 +415,11 @@ int GetMinDrawableScale(TypesHolder const & types, m2::RectD limitRect)
 int GetMinDrawableScaleClassifOnly(TypesHolder const & types)
 {
   int const upBound = scales::GetUpperStyleScale();
+  auto const levels = GetDrawableForIndexLevels(types);
 
   for (int level = 0; level <= upBound; ++level)
   {
-    if (IsDrawableForIndexClassifOnly(types, level))
+    if (levels[level])
       return level;
   }
 
@@ -484,10 +489,13 @@ bool IsVisibleInRange(uint32_t type, pair<int, int> const & scaleRange)
     return true;
 
   Classificator const & c = classif();
+  ClassifObject const * p = c.GetObject(type);
+  if (p == c.GetRoot() || !p->IsDrawableAny())
+    return false;
+
   for (int scale = scaleRange.first; scale <= scaleRange.second; ++scale)
   {
-    IsDrawableChecker doCheck(scale);
-    if (c.ProcessObjects(type, doCheck))
+    if (p->GetVisibility()[scale])
       return true;
   }
   return false;
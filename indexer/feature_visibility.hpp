@@ -21,6 +21,9 @@ namespace feature
   bool TypeIsUseful(uint32_t type);
   bool IsDrawableForIndex(FeatureType & ft, int level);
   bool IsDrawableForIndex(TypesHolder const & types, m2::RectD limitRect, int level);
+  /// @return true if the feature is drawable for index on any level of [lowLevel, highLevel].
+  bool IsDrawableForIndexInRange(TypesHolder const & types, m2::RectD limitRect, int lowLevel,
+                                 int highLevel);
 
   // The separation into ClassifOnly and GeometryOnly versions is needed to speed up
   // the geometrical index (see indexer/scale_index_builder.hpp).
@@ -12,6 +12,8 @@
 #include "base/logging.hpp"
 #include "base/scope_guard.hpp"
 
+#include <algorithm>
+
 using namespace platform;
 using namespace std;
 
@@ -106,6 +108,9 @@ namespace feature
   unique_ptr<FeaturesOffsetsTable> FeaturesOffsetsTable::CreateIfNotExistsAndLoad(
       LocalCountryFile const & localFile, FilesContainerR const & cont)
   {
+    if (cont.IsExist(FEATURE_OFFSETS_FILE_TAG))
+      return Load(cont);
+
     string const offsetsFilePath = CountryIndexes::GetPath(localFile, CountryIndexes::Index::Offsets);
 
     if (Platform::IsFileExistsByFullPath(offsetsFilePath))
@@ -146,6 +151,38 @@ namespace feature
     return static_cast<uint32_t>(m_table.select(index));
   }
 
+  void FeaturesOffsetsTable::GetFeatureOffsets(vector<uint32_t> const & indices,
+                                               vector<uint32_t> & offsets) const
+  {
+    ASSERT(is_sorted(indices.begin(), indices.end()), ());
+
+    // A select costs much more than a step of the enumerator.
+    uint32_t constexpr kMaxStepsToSkip = 64;
+
+    offsets.clear();
+    offsets.reserve(indices.size());
+    if (indices.empty())
+      return;
+
+    ASSERT_LESS(indices.back(), size(), ("Index out of bounds", indices.back(), size()));
+    succinct::elias_fano::select_enumerator it(m_table, indices.front());
+    // The index of the offset which is returned by the next step of |it|.
+    uint32_t nextIndex = indices.front();
+    uint32_t offset = 0;
+    for (auto const index : indices)
+    {
+      if (index >= nextIndex + kMaxStepsToSkip)
+      {
+        it = succinct::elias_fano::select_enumerator(m_table, index);
+        nextIndex = index;
+      }
+
+      for (; nextIndex <= index; ++nextIndex)
+        offset = static_cast<uint32_t>(it.next());
+      offsets.push_back(offset);
+    }
+  }
+
   size_t FeaturesOffsetsTable::GetFeatureIndexbyOffset(uint32_t offset) const
   {
     ASSERT_GREATER(size(), 0, ("We must not ask empty table"));
@@ -71,6 +71,7 @@ namespace feature
                                                        std::string const & storePath);
 
     /// Get table for the MWM map, represented by localFile and cont.
+    /// The table section of cont is mapped when it exists.
     static std::unique_ptr<FeaturesOffsetsTable> CreateIfNotExistsAndLoad(
              platform::LocalCountryFile const & localFile, FilesContainerR const & cont);
 
@@ -92,6 +93,14 @@ namespace feature
     /// \return offset a feature
     uint32_t GetFeatureOffset(size_t index) const;
 
+    /// Gets the offsets of the features |indices| sorted in the ascending order. Close indices
+    /// are decoded by one forward pass over the table instead of a select per index.
+    ///
+    /// \param indices sorted indices of features
+    /// \param offsets offsets of the features in the order of |indices|
+    void GetFeatureOffsets(std::vector<uint32_t> const & indices,
+                           std::vector<uint32_t> & offsets) const;
+
     /// \param offset offset of a feature
     /// \return index of a feature
     size_t GetFeatureIndexbyOffset(uint32_t offset) const;
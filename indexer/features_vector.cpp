@@ -5,12 +5,42 @@
 #include "platform/constants.hpp"
 #include "platform/mwm_version.hpp"
 
+#include "coding/mmap_reader.hpp"
+
 #include <string>
 
 std::unique_ptr<FeatureType> FeaturesVector::GetByIndex(uint32_t index) const
 {
+  return GetByOffset(m_table ? m_table->GetFeatureOffset(index) : index);
+}
+
+std::vector<std::unique_ptr<FeatureType>> FeaturesVector::GetByIndices(
+    std::vector<uint32_t> const & indices) const
+{
+  std::vector<uint32_t> offsets;
+  if (m_table)
+    m_table->GetFeatureOffsets(indices, offsets);
+  else
+    offsets = indices;
+
+  std::vector<std::unique_ptr<FeatureType>> features;
+  features.reserve(offsets.size());
+  for (auto const offset : offsets)
+    features.push_back(GetByOffset(offset));
+  return features;
+}
+
+std::unique_ptr<FeatureType> FeaturesVector::GetByOffset(uint32_t ftOffset) const
+{
+  if (m_data)
+  {
+    ASSERT_LESS(ftOffset, m_dataSize, ());
+    ArrayByteSource source(m_data + ftOffset);
+    ReadVarUint<uint32_t>(source);
+    return std::make_unique<FeatureType>(&m_loadInfo, source.PtrC());
+  }
+
   uint32_t offset = 0, size = 0;
-  auto const ftOffset = m_table ? m_table->GetFeatureOffset(index) : index;
   m_recordReader.ReadRecord(ftOffset, m_buffer, offset, size);
   return std::make_unique<FeatureType>(&m_loadInfo, &m_buffer[offset]);
 }
@@ -35,6 +65,12 @@ FeaturesVectorTest::FeaturesVectorTest(FilesContainerR const & cont)
     m_vector.m_table = feature::FeaturesOffsetsTable::Load(m_cont).release();
 }
 
+// static
+FilesContainerR FeaturesVectorTest::MapContainer(std::string const & filePath)
+{
+  return FilesContainerR(std::make_unique<MmapReader>(filePath));
+}
+
 FeaturesVectorTest::~FeaturesVectorTest()
 {
   delete m_vector.m_table;
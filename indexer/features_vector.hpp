@@ -11,8 +11,11 @@
 
 namespace feature { class FeaturesOffsetsTable; }
 
-/// Note! This class is NOT Thread-Safe.
+/// Note! This class is NOT Thread-Safe unless IsConcurrent().
 /// You should have separate instance of Vector for every thread.
+/// The vector is concurrent when the container reads from memory (see
+/// FeaturesVectorTest::MapContainer()): the features are decoded straight from the memory
+/// and one vector may be shared by all the threads.
 class FeaturesVector
 {
   DISALLOW_COPY(FeaturesVector);
@@ -22,16 +25,24 @@ public:
                  feature::FeaturesOffsetsTable const * table)
     : m_loadInfo(cont, header), m_recordReader(m_loadInfo.GetDataReader(), 256), m_table(table)
   {
+    auto const dataReader = m_loadInfo.GetDataReader();
+    m_data = static_cast<char const *>(dataReader.GetDirectData());
+    m_dataSize = dataReader.Size();
   }
 
+  bool IsConcurrent() const { return m_data != nullptr; }
+
   std::unique_ptr<FeatureType> GetByIndex(uint32_t index) const;
+  /// Returns the features |indices| sorted in the ascending order. The offsets of the features
+  /// are got from the table by one batch.
+  std::vector<std::unique_ptr<FeatureType>> GetByIndices(std::vector<uint32_t> const & indices) const;
 
   size_t GetNumFeatures() const;
 
   template <class ToDo> void ForEach(ToDo && toDo) const
   {
     uint32_t index = 0;
-    m_recordReader.ForEachRecord([&](uint32_t pos, char const * data, uint32_t /*size*/) {
+    auto const processRecord = [&](uint32_t pos, char const * data, uint32_t /*size*/) {
       FeatureType ft(&m_loadInfo, data);
 
       // We can't properly set MwmId here, because FeaturesVector
@@ -40,7 +51,9 @@ public:
       // be used later for Metadata loading.
       ft.SetID(FeatureID(MwmSet::MwmId(), index));
       toDo(ft, m_table ? index++ : pos);
-    });
+    };
+
+    m_recordReader.ForEachRecord(processRecord);
   }
 
   template <class ToDo> static void ForEachOffset(ModelReaderPtr reader, ToDo && toDo)
@@ -55,10 +68,15 @@ public:
 private:
   friend class FeaturesVectorTest;
 
+  std::unique_ptr<FeatureType> GetByOffset(uint32_t offset) const;
+
   feature::SharedLoadInfo m_loadInfo;
   VarRecordReader<FilesContainerR::TReader, &VarRecordSizeReaderVarint> m_recordReader;
   mutable std::vector<char> m_buffer;
   feature::FeaturesOffsetsTable const * m_table;
+  // The features section in memory for the concurrent reading.
+  char const * m_data = nullptr;
+  uint64_t m_dataSize = 0;
 };
 
 /// Test features vector (reader) that combines all the needed data for stand-alone work.
@@ -76,6 +94,9 @@ public:
   explicit FeaturesVectorTest(FilesContainerR const & cont);
   ~FeaturesVectorTest();
 
+  /// Returns the container of the mapped file for the concurrent features vector.
+  static FilesContainerR MapContainer(std::string const & filePath);
+
   feature::DataHeader const & GetHeader() const { return m_header; }
   FeaturesVector const & GetVector() const { return m_vector; }
 };
@@ -1,6 +1,7 @@
 #include "indexer/ftypes_matcher.hpp"
 
 #include "indexer/classificator.hpp"
+#include "indexer/classificator_type_path.hpp"
 #include "indexer/feature.hpp"
 #include "indexer/feature_data.hpp"
 
@@ -19,6 +20,57 @@ using namespace std;
 
 namespace
 {
+classificator::TypePath const kRouteFerryType("route-ferry");
+classificator::TypePath const kRouteShuttleTrainType("route-shuttle_train");
+classificator::TypePath const kRailwayRailType("railway-rail");
+classificator::TypePath const kHighwayMotorwayType("highway-motorway");
+classificator::TypePath const kHighwayMotorwayLinkType("highway-motorway_link");
+classificator::TypePath const kHighwayTrunkType("highway-trunk");
+classificator::TypePath const kHighwayTrunkLinkType("highway-trunk_link");
+classificator::TypePath const kHighwayPrimaryType("highway-primary");
+classificator::TypePath const kHighwayPrimaryLinkType("highway-primary_link");
+classificator::TypePath const kHighwaySecondaryType("highway-secondary");
+classificator::TypePath const kHighwaySecondaryLinkType("highway-secondary_link");
+classificator::TypePath const kHighwayTertiaryType("highway-tertiary");
+classificator::TypePath const kHighwayTertiaryLinkType("highway-tertiary_link");
+classificator::TypePath const kHighwayUnclassifiedType("highway-unclassified");
+classificator::TypePath const kHighwayResidentialType("highway-residential");
+classificator::TypePath const kHighwayLivingStreetType("highway-living_street");
+classificator::TypePath const kHighwayRoadType("highway-road");
+classificator::TypePath const kHighwayServiceType("highway-service");
+classificator::TypePath const kHighwayTrackType("highway-track");
+classificator::TypePath const kManMadePierType("man_made-pier");
+classificator::TypePath const kHighwayPedestrianType("highway-pedestrian");
+classificator::TypePath const kHighwayFootwayType("highway-footway");
+classificator::TypePath const kHighwayBridlewayType("highway-bridleway");
+classificator::TypePath const kHighwayStepsType("highway-steps");
+classificator::TypePath const kHighwayCyclewayType("highway-cycleway");
+classificator::TypePath const kHighwayPathType("highway-path");
+classificator::TypePath const kNaturalPeakType("natural-peak");
+classificator::TypePath const kAmenityAtmType("amenity-atm");
+classificator::TypePath const kHighwaySpeedCameraType("highway-speed_camera");
+classificator::TypePath const kAmenityFuelType("amenity-fuel");
+classificator::TypePath const kRailwayStationType("railway-station");
+classificator::TypePath const kBuildingTrainStationType("building-train_station");
+classificator::TypePath const kRailwayStationSubwayType("railway-station-subway");
+classificator::TypePath const kAerowayAerodromeType("aeroway-aerodrome");
+classificator::TypePath const kPlaceSquareType("place-square");
+classificator::TypePath const kLanduseResidentialType("landuse-residential");
+classificator::TypePath const kPlaceNeighbourhoodType("place-neighbourhood");
+classificator::TypePath const kPlaceSuburbType("place-suburb");
+classificator::TypePath const kHwtagOnewayType("hwtag-oneway");
+classificator::TypePath const kJunctionRoundaboutType("junction-roundabout");
+classificator::TypePath const kBuildingType("building");
+classificator::TypePath const kPlaceType("place");
+classificator::TypePath const kNaturalLandType("natural-land");
+classificator::TypePath const kNaturalCoastlineType("natural-coastline");
+classificator::TypePath const kSponsoredBookingType("sponsored-booking");
+classificator::TypePath const kInternetAccessWlanType("internet_access-wlan");
+classificator::TypePath const kCuisineType("cuisine");
+classificator::TypePath const kPlaceCityType("place-city");
+classificator::TypePath const kHighwayBusStopType("highway-bus_stop");
+classificator::TypePath const kRailwayTramStopType("railway-tram_stop");
+
 class HighwayClasses
 {
   map<uint32_t, ftypes::HighwayClass> m_map;
@@ -26,40 +78,39 @@ class HighwayClasses
 public:
   HighwayClasses()
   {
-    auto const & c = classif();
-    m_map[c.GetTypeByPath({"route", "ferry"})] = ftypes::HighwayClass::Transported;
-    m_map[c.GetTypeByPath({"route", "shuttle_train"})] = ftypes::HighwayClass::Transported;
-    m_map[c.GetTypeByPath({"railway", "rail"})] = ftypes::HighwayClass::Transported;
-
-    m_map[c.GetTypeByPath({"highway", "motorway"})] = ftypes::HighwayClass::Trunk;
-    m_map[c.GetTypeByPath({"highway", "motorway_link"})] = ftypes::HighwayClass::Trunk;
-    m_map[c.GetTypeByPath({"highway", "trunk"})] = ftypes::HighwayClass::Trunk;
-    m_map[c.GetTypeByPath({"highway", "trunk_link"})] = ftypes::HighwayClass::Trunk;
-
-    m_map[c.GetTypeByPath({"highway", "primary"})] = ftypes::HighwayClass::Primary;
-    m_map[c.GetTypeByPath({"highway", "primary_link"})] = ftypes::HighwayClass::Primary;
-
-    m_map[c.GetTypeByPath({"highway", "secondary"})] = ftypes::HighwayClass::Secondary;
-    m_map[c.GetTypeByPath({"highway", "secondary_link"})] = ftypes::HighwayClass::Secondary;
-
-    m_map[c.GetTypeByPath({"highway", "tertiary"})] = ftypes::HighwayClass::Tertiary;
-    m_map[c.GetTypeByPath({"highway", "tertiary_link"})] = ftypes::HighwayClass::Tertiary;
-
-    m_map[c.GetTypeByPath({"highway", "unclassified"})] = ftypes::HighwayClass::LivingStreet;
-    m_map[c.GetTypeByPath({"highway", "residential"})] = ftypes::HighwayClass::LivingStreet;
-    m_map[c.GetTypeByPath({"highway", "living_street"})] = ftypes::HighwayClass::LivingStreet;
-    m_map[c.GetTypeByPath({"highway", "road"})] = ftypes::HighwayClass::LivingStreet;
-
-    m_map[c.GetTypeByPath({"highway", "service"})] = ftypes::HighwayClass::Service;
-    m_map[c.GetTypeByPath({"highway", "track"})] = ftypes::HighwayClass::Service;
-    m_map[c.GetTypeByPath({"man_made", "pier"})] = ftypes::HighwayClass::Service;
-
-    m_map[c.GetTypeByPath({"highway", "pedestrian"})] = ftypes::HighwayClass::Pedestrian;
-    m_map[c.GetTypeByPath({"highway", "footway"})] = ftypes::HighwayClass::Pedestrian;
-    m_map[c.GetTypeByPath({"highway", "bridleway"})] = ftypes::HighwayClass::Pedestrian;
-    m_map[c.GetTypeByPath({"highway", "steps"})] = ftypes::HighwayClass::Pedestrian;
-    m_map[c.GetTypeByPath({"highway", "cycleway"})] = ftypes::HighwayClass::Pedestrian;
-    m_map[c.GetTypeByPath({"highway", "path"})] = ftypes::HighwayClass::Pedestrian;
+    m_map[kRouteFerryType.Get()] = ftypes::HighwayClass::Transported;
+    m_map[kRouteShuttleTrainType.Get()] = ftypes::HighwayClass::Transported;
+    m_map[kRailwayRailType.Get()] = ftypes::HighwayClass::Transported;
+
+    m_map[kHighwayMotorwayType.Get()] = ftypes::HighwayClass::Trunk;
+    m_map[kHighwayMotorwayLinkType.Get()] = ftypes::HighwayClass::Trunk;
+    m_map[kHighwayTrunkType.Get()] = ftypes::HighwayClass::Trunk;
+    m_map[kHighwayTrunkLinkType.Get()] = ftypes::HighwayClass::Trunk;
+
+    m_map[kHighwayPrimaryType.Get()] = ftypes::HighwayClass::Primary;
+    m_map[kHighwayPrimaryLinkType.Get()] = ftypes::HighwayClass::Primary;
+
+    m_map[kHighwaySecondaryType.Get()] = ftypes::HighwayClass::Secondary;
+    m_map[kHighwaySecondaryLinkType.Get()] = ftypes::HighwayClass::Secondary;
+
+    m_map[kHighwayTertiaryType.Get()] = ftypes::HighwayClass::Tertiary;
+    m_map[kHighwayTertiaryLinkType.Get()] = ftypes::HighwayClass::Tertiary;
+
+    m_map[kHighwayUnclassifiedType.Get()] = ftypes::HighwayClass::LivingStreet;
+    m_map[kHighwayResidentialType.Get()] = ftypes::HighwayClass::LivingStreet;
+    m_map[kHighwayLivingStreetType.Get()] = ftypes::HighwayClass::LivingStreet;
+    m_map[kHighwayRoadType.Get()] = ftypes::HighwayClass::LivingStreet;
+
+    m_map[kHighwayServiceType.Get()] = ftypes::HighwayClass::Service;
+    m_map[kHighwayTrackType.Get()] = ftypes::HighwayClass::Service;
+    m_map[kManMadePierType.Get()] = ftypes::HighwayClass::Service;
+
+    m_map[kHighwayPedestrianType.Get()] = ftypes::HighwayClass::Pedestrian;
+    m_map[kHighwayFootwayType.Get()] = ftypes::HighwayClass::Pedestrian;
+    m_map[kHighwayBridlewayType.Get()] = ftypes::HighwayClass::Pedestrian;
+    m_map[kHighwayStepsType.Get()] = ftypes::HighwayClass::Pedestrian;
+    m_map[kHighwayCyclewayType.Get()] = ftypes::HighwayClass::Pedestrian;
+    m_map[kHighwayPathType.Get()] = ftypes::HighwayClass::Pedestrian;
   }
 
   ftypes::HighwayClass Get(uint32_t t) const
@@ -125,7 +176,28 @@ uint32_t BaseChecker::PrepareToMatch(uint32_t type, uint8_t level)
 
 bool BaseChecker::IsMatched(uint32_t type) const
 {
-  return (find(m_types.begin(), m_types.end(), PrepareToMatch(type, m_level)) != m_types.end());
+  type = PrepareToMatch(type, m_level);
+  if (!m_typesBits.empty())
+    return type < m_typesBits.size() && m_typesBits[type];
+  return (find(m_types.begin(), m_types.end(), type) != m_types.end());
+}
+
+void BaseChecker::BuildTypesBits()
+{
+  // The types of the level 2 are less than 2^15.
+  uint32_t constexpr kMaxBitsCount = 1 << 16;
+
+  m_typesBits.clear();
+  if (m_types.empty())
+    return;
+
+  auto const maxType = *max_element(m_types.cbegin(), m_types.cend());
+  if (maxType >= kMaxBitsCount)
+    return;
+
+  m_typesBits.resize(maxType + 1, false);
+  for (auto const t : m_types)
+    m_typesBits[t] = true;
 }
 
 bool BaseChecker::operator()(feature::TypesHolder const & types) const
@@ -157,59 +229,50 @@ bool BaseChecker::operator()(vector<uint32_t> const & types) const
 
 IsPeakChecker::IsPeakChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"natural", "peak"}));
+  m_types.push_back(kNaturalPeakType.Get());
 }
 
 IsATMChecker::IsATMChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"amenity", "atm"}));
+  m_types.push_back(kAmenityAtmType.Get());
 }
 
 IsSpeedCamChecker::IsSpeedCamChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"highway", "speed_camera"}));
+  m_types.push_back(kHighwaySpeedCameraType.Get());
 }
 
 IsFuelStationChecker::IsFuelStationChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"amenity", "fuel"}));
+  m_types.push_back(kAmenityFuelType.Get());
 }
 
 IsRailwayStationChecker::IsRailwayStationChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"railway", "station"}));
-  m_types.push_back(c.GetTypeByPath({"building", "train_station"}));
+  m_types.push_back(kRailwayStationType.Get());
+  m_types.push_back(kBuildingTrainStationType.Get());
 }
 
 IsSubwayStationChecker::IsSubwayStationChecker() : BaseChecker(3 /* level */)
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"railway", "station", "subway"}));
+  m_types.push_back(kRailwayStationSubwayType.Get());
 }
 
 IsAirportChecker::IsAirportChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"aeroway", "aerodrome"}));
+  m_types.push_back(kAerowayAerodromeType.Get());
 }
 
 IsSquareChecker::IsSquareChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"place", "square"}));
+  m_types.push_back(kPlaceSquareType.Get());
 }
 
 IsSuburbChecker::IsSuburbChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"landuse", "residential"}));
-  m_types.push_back(c.GetTypeByPath({"place", "neighbourhood"}));
-  m_types.push_back(c.GetTypeByPath({"place", "suburb"}));
+  m_types.push_back(kLanduseResidentialType.Get());
+  m_types.push_back(kPlaceNeighbourhoodType.Get());
+  m_types.push_back(kPlaceSuburbType.Get());
 }
 
 IsWayChecker::IsWayChecker()
@@ -274,14 +337,12 @@ IsVillageChecker::IsVillageChecker()
 
 IsOneWayChecker::IsOneWayChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"hwtag", "oneway"}));
+  m_types.push_back(kHwtagOnewayType.Get());
 }
 
 IsRoundAboutChecker::IsRoundAboutChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"junction", "roundabout"}));
+  m_types.push_back(kJunctionRoundaboutType.Get());
 }
 
 IsLinkChecker::IsLinkChecker()
@@ -299,7 +360,7 @@ IsLinkChecker::IsLinkChecker()
 
 IsBuildingChecker::IsBuildingChecker() : BaseChecker(1 /* level */)
 {
-  m_types.push_back(classif().GetTypeByPath({"building"}));
+  m_types.push_back(kBuildingType.Get());
 }
 
 // static
@@ -359,7 +420,7 @@ WikiChecker::WikiChecker() : BaseChecker(2 /* level */)
 
 IsPlaceChecker::IsPlaceChecker() : BaseChecker(1 /* level */)
 {
-  m_types.push_back(classif().GetTypeByPath({"place"}));
+  m_types.push_back(kPlaceType.Get());
 }
 
 IsBridgeChecker::IsBridgeChecker() : BaseChecker(3 /* level */) {}
@@ -488,8 +549,7 @@ IsIslandChecker::IsIslandChecker()
 
 IsLandChecker::IsLandChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"natural", "land"}));
+  m_types.push_back(kNaturalLandType.Get());
 }
 
 uint32_t IsLandChecker::GetLandType() const
@@ -500,8 +560,7 @@ uint32_t IsLandChecker::GetLandType() const
 
 IsCoastlineChecker::IsCoastlineChecker()
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"natural", "coastline"}));
+  m_types.push_back(kNaturalCoastlineType.Get());
 }
 
 uint32_t IsCoastlineChecker::GetCoastlineType() const
@@ -550,12 +609,12 @@ char const * IsHotelChecker::GetHotelTypeTag(Type type)
 
 IsBookingHotelChecker::IsBookingHotelChecker()
 {
-  m_types.push_back(classif().GetTypeByPath({"sponsored", "booking"}));
+  m_types.push_back(kSponsoredBookingType.Get());
 }
 
 IsWifiChecker::IsWifiChecker()
 {
-  m_types.push_back(classif().GetTypeByPath({"internet_access", "wlan"}));
+  m_types.push_back(kInternetAccessWlanType.Get());
 }
 
 IsEatChecker::IsEatChecker()
@@ -590,19 +649,18 @@ IsEatChecker::Type IsEatChecker::GetType(uint32_t t) const
 
 IsCuisineChecker::IsCuisineChecker() : BaseChecker(1 /* level */)
 {
-  Classificator const & c = classif();
-  m_types.push_back(c.GetTypeByPath({"cuisine"}));
+  m_types.push_back(kCuisineType.Get());
 }
 
 IsCityChecker::IsCityChecker()
 {
-  m_types.push_back(classif().GetTypeByPath({"place", "city"}));
+  m_types.push_back(kPlaceCityType.Get());
 }
 
 IsPublicTransportStopChecker::IsPublicTransportStopChecker()
 {
-  m_types.push_back(classif().GetTypeByPath({"highway", "bus_stop"}));
-  m_types.push_back(classif().GetTypeByPath({"railway", "tram_stop"}));
+  m_types.push_back(kHighwayBusStopType.Get());
+  m_types.push_back(kRailwayTramStopType.Get());
 }
 
 IsLocalityChecker::IsLocalityChecker()
@@ -22,7 +22,8 @@ namespace feature { class TypesHolder; }
 class FeatureType;
 
 #define DECLARE_CHECKER_INSTANCE(CheckerType) static CheckerType const & Instance() { \
-                                              static CheckerType const inst; return inst; }
+                                              static CheckerType const inst = Prepare(CheckerType()); \
+                                              return inst; }
 
 namespace ftypes
 {
@@ -36,6 +37,14 @@ protected:
   BaseChecker(size_t level = 2) : m_level(level) {}
   virtual ~BaseChecker() = default;
 
+  // Is called by Instance() when |m_types| are filled by the constructor of |checker|.
+  template <typename Checker>
+  static Checker Prepare(Checker && checker)
+  {
+    checker.BuildTypesBits();
+    return std::move(checker);
+  }
+
 public:
   virtual bool IsMatched(uint32_t type) const;
 
@@ -51,6 +60,13 @@ public:
   {
     std::for_each(m_types.cbegin(), m_types.cend(), std::forward<TFn>(fn));
   }
+
+private:
+  void BuildTypesBits();
+
+  // The bits of |m_types| by the types (which are small up to the level 2), so a type is
+  // matched by one bit test. Is empty when the types are too big.
+  std::vector<bool> m_typesBits;
 };
 
 class IsPeakChecker : public BaseChecker
@@ -9,7 +9,8 @@
 
 namespace indexer
 {
-  bool BuildIndexFromDataFile(std::string const & datFile, std::string const & tmpFile)
+  bool BuildIndexFromDataFile(std::string const & datFile, std::string const & tmpFile,
+                              unsigned int threadsCount)
   {
     try
     {
@@ -18,7 +19,7 @@ namespace indexer
         FeaturesVectorTest features(datFile);
         FileWriter writer(idxFileName);
 
-        BuildIndex(features.GetHeader(), features.GetVector(), writer, tmpFile);
+        BuildIndex(features.GetHeader(), features.GetVector(), writer, tmpFile, threadsCount);
       }
 
       FilesContainerW(datFile, FileWriter::OP_WRITE_EXISTING).Write(idxFileName, INDEX_FILE_TAG);
@@ -9,18 +9,20 @@ namespace indexer
 {
 template <class TFeaturesVector, typename TWriter>
 void BuildIndex(feature::DataHeader const & header, TFeaturesVector const & features,
-                TWriter & writer, std::string const & tmpFilePrefix)
+                TWriter & writer, std::string const & tmpFilePrefix,
+                unsigned int threadsCount = 1)
   {
     LOG(LINFO, ("Building scale index."));
     uint64_t indexSize;
     {
       SubWriter<TWriter> subWriter(writer);
-      covering::IndexScales(header, features, subWriter, tmpFilePrefix);
+      covering::IndexScales(header, features, subWriter, tmpFilePrefix, threadsCount);
       indexSize = subWriter.Size();
     }
     LOG(LINFO, ("Built scale index. Size =", indexSize));
   }
 
   // doesn't throw exceptions
-  bool BuildIndexFromDataFile(std::string const & datFile, std::string const & tmpFile);
+  bool BuildIndexFromDataFile(std::string const & datFile, std::string const & tmpFile,
+                              unsigned int threadsCount = 1);
 }
@@ -3,8 +3,11 @@
 #include "indexer/borders.hpp"
 
 #include "geometry/point2d.hpp"
+#include "geometry/region2d.hpp"
 
+#include <cmath>
 #include <cstdint>
+#include <random>
 #include <vector>
 
 using namespace indexer;
@@ -117,4 +120,69 @@ UNIT_TEST(BordersTest)
     TEST(!borders.IsPointInside(0, m2::PointD{7, 7}), ());
   }
 }
+
+UNIT_TEST(BordersTest_Prepared)
+{
+  // A star with many points is prepared, so the grid answers are compared with the exact ones.
+  vector<m2::PointD> outer;
+  size_t const kPointsCount = 200;
+  for (size_t i = 0; i < kPointsCount; ++i)
+  {
+    double const angle = 2 * M_PI * i / kPointsCount;
+    double const radius = i % 2 == 0 ? 10.0 : 6.0;
+    outer.emplace_back(radius * cos(angle), radius * sin(angle));
+  }
+  vector<m2::PointD> const inner = {m2::PointD{-1, -1}, m2::PointD{1, -1}, m2::PointD{1, 1},
+                                    m2::PointD{-1, 1}};
+
+  BordersVector vec;
+  vec.m_borders.resize(1);
+  vec.m_borders[0].m_id = 0;
+  vec.m_borders[0].m_outer = outer;
+  vec.m_borders[0].m_inners = {inner};
+
+  indexer::Borders borders;
+  borders.DeserializeFromVec(vec);
+
+  m2::RegionD const outerRegion(outer);
+  m2::RegionD const innerRegion(inner);
+  mt19937 rng(0);
+  uniform_real_distribution<double> coord(-11.0, 11.0);
+  for (size_t i = 0; i < 10000; ++i)
+  {
+    m2::PointD const point(coord(rng), coord(rng));
+    bool const expected = outerRegion.Contains(point) && !innerRegion.Contains(point);
+    TEST_EQUAL(borders.IsPointInside(0, point), expected, (point));
+  }
+
+  for (auto const & point : outer)
+    TEST(borders.IsPointInside(0, point), (point));
+  TEST(borders.IsPointInside(0, m2::PointD{3, 3}), ());
+  TEST(!borders.IsPointInside(0, m2::PointD{0, 0}), ());
+  TEST(!borders.IsPointInside(0, m2::PointD{9, 9}), ());
+}
+UNIT_TEST(BordersTest_FindFirstCrossing)
+{
+  BordersVector vec;
+  vec.m_borders.resize(1);
+  vec.m_borders[0].m_id = 0;
+  vec.m_borders[0].m_outer = {m2::PointD{0, 0}, m2::PointD{10, 0}, m2::PointD{10, 10}, m2::PointD{0, 10}};
+  vec.m_borders[0].m_inners = {{m2::PointD{2, 2}, m2::PointD{8, 2}, m2::PointD{8, 8}, m2::PointD{2, 8}}};
+
+  indexer::Borders borders;
+  borders.DeserializeFromVec(vec);
+
+  auto const crossing = [&borders](m2::PointD const & from, m2::PointD const & to) {
+    return borders.FindFirstCrossing(0, from, to);
+  };
+
+  TEST(!crossing({1, 1}, {1, 9}), ());
+  TEST(!crossing({20, 20}, {30, 20}), ());
+  TEST(!crossing({0, 1}, {0, 9}), ());
+  TEST_NEAR(*crossing({1, 5}, {5, 5}), 0.25, 1e-9, ());
+  TEST_NEAR(*crossing({5, 5}, {15, 5}), 0.3, 1e-9, ());
+  TEST_NEAR(*crossing({-10, 5}, {10, 5}), 0.5, 1e-9, ());
+  // The crossing at the segment start is skipped.
+  TEST_NEAR(*crossing({2, 5}, {12, 5}), 0.6, 1e-9, ());
+}
 }  // namespace
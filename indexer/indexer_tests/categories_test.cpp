@@ -6,10 +6,13 @@
 #include "indexer/classificator_loader.hpp"
 
 #include "coding/reader.hpp"
+#include "coding/writer.hpp"
 
 #include "base/string_utils.hpp"
 
 #include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
 using namespace indexer;
@@ -169,6 +172,49 @@ UNIT_TEST(CategoriesHolder_ForEach)
   }
 }
 
+UNIT_TEST(CategoriesHolder_Compiled)
+{
+  classificator::Load();
+
+  CategoriesHolder holder(
+      make_unique<MemReader>(g_testCategoriesTxt, sizeof(g_testCategoriesTxt) - 1));
+
+  vector<uint8_t> buffer;
+  {
+    MemWriter<vector<uint8_t>> writer(buffer);
+    holder.Serialize(writer);
+  }
+  CategoriesHolder compiled(make_unique<MemReader>(buffer.data(), buffer.size()));
+
+  using Entry = tuple<uint32_t, string, int8_t, uint8_t>;
+  auto const getEntries = [](CategoriesHolder const & h) {
+    vector<Entry> entries;
+    h.ForEachNameAndType([&entries](CategoriesHolder::Category::Name const & name, uint32_t type) {
+      entries.emplace_back(type, name.m_name, name.m_locale, name.m_prefixLengthToSuggest);
+    });
+    return entries;
+  };
+  TEST_EQUAL(getEntries(compiled), getEntries(holder), ());
+  TEST_EQUAL(getEntries(holder).size(), 14, ());
+
+  auto const getTypes = [](CategoriesHolder const & h, int8_t locale, string const & token) {
+    vector<uint32_t> types;
+    h.ForEachTypeByName(locale, strings::MakeUniString(token),
+                        [&types](uint32_t type) { types.push_back(type); });
+    return types;
+  };
+  int8_t const en = CategoriesHolder::MapLocaleToInteger("en");
+  int8_t const de = CategoriesHolder::MapLocaleToInteger("de");
+  for (auto const & token : {"bench", "sit", "village"})
+    TEST_EQUAL(getTypes(compiled, en, token), getTypes(holder, en, token), (token));
+  TEST_EQUAL(getTypes(compiled, de, "weiler").size(), 2, ());
+  TEST(getTypes(compiled, en, "weiler").empty(), ());
+
+  string name;
+  TEST(compiled.GetNameByType(classif().GetTypeByPath({"amenity", "bench"}), de, name), ());
+  TEST_EQUAL(name, "bank", ());
+}
+
 UNIT_TEST(CategoriesIndex_Smoke)
 {
   classificator::Load();
@@ -297,6 +343,33 @@ UNIT_TEST(CategoriesIndex_Groups)
   testTypes("http", {});
 }
 
+UNIT_TEST(CategoriesIndex_Freeze)
+{
+  classificator::Load();
+
+  CategoriesHolder holder(
+      make_unique<MemReader>(g_testCategoriesTxt, sizeof(g_testCategoriesTxt) - 1));
+  CategoriesIndex index(holder);
+  index.AddAllCategoriesInAllLangs();
+
+  vector<string> const queries = {"bench", "BENCH", "down", "benck", "strafbank",
+                                  "ie strafbank sc", "rafb", "i", "a", "village", ""};
+  vector<vector<uint32_t>> expected;
+  for (auto const & query : queries)
+  {
+    expected.emplace_back();
+    index.GetAssociatedTypes(query, expected.back());
+  }
+
+  index.Freeze();
+  for (size_t i = 0; i < queries.size(); ++i)
+  {
+    vector<uint32_t> result;
+    index.GetAssociatedTypes(queries[i], result);
+    TEST_EQUAL(result, expected[i], (queries[i]));
+  }
+}
+
 #ifdef DEBUG
 // A check that this data structure is not too heavy.
 UNIT_TEST(CategoriesIndex_AllCategories)
@@ -4,8 +4,12 @@
 #include "indexer/cell_coverer.hpp"
 #include "indexer/indexer_tests/bounds.hpp"
 
+#include "geometry/covering_utils.hpp"
 
+#include "base/thread_pool_computational.hpp"
 
+#include <algorithm>
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -61,3 +65,88 @@ UNIT_TEST(MaxDepthCoverSpiral)
     TEST_EQUAL(cells[0].Level(), levelMax, ());
   }
 }
+
+UNIT_TEST(CoverObjectFromCoveringRoot)
+{
+  using SmallCellId = m2::CellId<10>;
+  int const kCellDepth = 10;
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> coordinate(1.0, 1000.0);
+  std::uniform_real_distribution<double> shift(-20.0, 20.0);
+  base::thread_pool::computational::ThreadPool threadPool(2);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    m2::PointD const a(coordinate(engine), coordinate(engine));
+    m2::PointD const b(a.x + shift(engine), a.y + shift(engine));
+    m2::RectD rect;
+    rect.Add(a);
+    rect.Add(b);
+    auto const intersect = [&](SmallCellId const & cell) {
+      auto const xy = cell.XY();
+      auto const r = cell.Radius();
+      if (!m2::RectD(xy.first - r, xy.second - r, xy.first + r, xy.second + r).IsIntersect(rect))
+        return covering::CELL_OBJECT_NO_INTERSECTION;
+      return covering::IntersectCellWithLine(cell, a, b);
+    };
+
+    for (uint64_t const cellPenaltyArea : {0, 4, 250})
+    {
+      vector<SmallCellId> expected;
+      covering::CoverObject(intersect, cellPenaltyArea, expected, kCellDepth, SmallCellId::Root());
+      vector<SmallCellId> cells;
+      covering::CoverObject(
+          intersect, cellPenaltyArea, cells, kCellDepth,
+          covering::GetCoveringRoot<SmallCellId>(rect, kCellDepth, cellPenaltyArea));
+      TEST_EQUAL(cells, expected, (a, b, cellPenaltyArea));
+    }
+
+    auto const expected = covering::CoverObject<SmallCellId>(intersect, kCellDepth, threadPool);
+    auto const cells = covering::CoverObject<SmallCellId>(
+        intersect, kCellDepth, threadPool,
+        covering::GetCoveringRoot<SmallCellId>(rect, kCellDepth));
+    TEST_EQUAL(cells, expected, (a, b));
+  }
+}
+
+UNIT_TEST(CoverObjectWithCellsBudget)
+{
+  using SmallCellId = m2::CellId<10>;
+  int const kCellDepth = 10;
+
+  // A small object is covered with the full depth.
+  TEST_EQUAL(covering::GetCoveringDepth<SmallCellId>({10.0, 10.0, 12.0, 12.0}, kCellDepth, 64),
+             kCellDepth, ());
+
+  // The boundary of a rect of 512 is covered by the cells of 32 with the budget of 64 cells.
+  m2::RectD const rect(100.0, 100.0, 612.0, 612.0);
+  auto const depth = covering::GetCoveringDepth<SmallCellId>(rect, kCellDepth, 64);
+  TEST_EQUAL(depth, 6, ());
+  TEST_EQUAL(covering::GetCoveringDepth<SmallCellId>(rect, kCellDepth, 1 << 20), kCellDepth, ());
+
+  auto const intersect = [&rect](SmallCellId const & cell) {
+    auto const xy = cell.XY();
+    auto const r = cell.Radius();
+    m2::RectD const cellRect(xy.first - r, xy.second - r, xy.first + r, xy.second + r);
+    if (!cellRect.IsIntersect(rect))
+      return covering::CELL_OBJECT_NO_INTERSECTION;
+    if (rect.IsRectInside(cellRect))
+      return covering::CELL_INSIDE_OBJECT;
+    return covering::CELL_OBJECT_INTERSECT;
+  };
+
+  vector<SmallCellId> fullCells;
+  covering::CoverObject(intersect, 0 /* cellPenaltyArea */, fullCells, kCellDepth,
+                        SmallCellId::Root());
+  vector<SmallCellId> cells;
+  covering::CoverObject(intersect, 0 /* cellPenaltyArea */, cells, depth, SmallCellId::Root());
+  TEST_LESS(cells.size(), fullCells.size(), ());
+
+  // The coarse covering covers the full one.
+  for (auto cell : fullCells)
+  {
+    while (cell.Level() > 0 && find(cells.begin(), cells.end(), cell) == cells.end())
+      cell = cell.Parent();
+    TEST(find(cells.begin(), cells.end(), cell) != cells.end(), (cell));
+  }
+}
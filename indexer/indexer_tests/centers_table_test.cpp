@@ -76,4 +76,68 @@ UNIT_CLASS_TEST(CentersTableTest, Subset)
     }
   }
 }
+
+UNIT_CLASS_TEST(CentersTableTest, GetManyAndFixedWidth)
+{
+  vector<pair<uint32_t, m2::PointD>> features;
+  for (uint32_t i = 0; i < 300; i += 3)
+    features.emplace_back(i, m2::PointD(i * 0.1, -(i * 0.2)));
+
+  vector<uint32_t> ids;
+  for (uint32_t i = 0; i < 310; i += 2)
+    ids.push_back(i);
+
+  serial::GeometryCodingParams codingParams;
+
+  TBuffer buffer;
+  TBuffer fixedWidthBuffer;
+  {
+    CentersTableBuilder builder;
+
+    builder.SetGeometryCodingParams(codingParams);
+    for (auto const & feature : features)
+      builder.Put(feature.first, feature.second);
+
+    MemWriter<TBuffer> writer(buffer);
+    builder.Freeze(writer);
+    MemWriter<TBuffer> fixedWidthWriter(fixedWidthBuffer);
+    builder.FreezeFixedWidth(fixedWidthWriter);
+  }
+
+  MemReader reader(buffer.data(), buffer.size());
+  MemReader fixedWidthReader(fixedWidthBuffer.data(), fixedWidthBuffer.size());
+  auto table = CentersTable::Load(reader, codingParams);
+  auto fixedWidthTable = CentersTable::LoadFixedWidth(fixedWidthReader, codingParams);
+  TEST(table, ());
+  TEST(fixedWidthTable, ());
+
+  for (auto * t : {table.get(), fixedWidthTable.get()})
+  {
+    vector<pair<uint32_t, m2::PointD>> actual;
+    t->GetMany(ids, [&actual](uint32_t id, m2::PointD const & center) {
+      actual.emplace_back(id, center);
+    });
+
+    size_t j = 0;
+    for (auto const & feature : features)
+    {
+      if (feature.first % 2 != 0)
+        continue;
+
+      TEST_LESS(j, actual.size(), ());
+      TEST_EQUAL(actual[j].first, feature.first, ());
+      TEST_LESS_OR_EQUAL(MercatorBounds::DistanceOnEarth(actual[j].second, feature.second), 1,
+                         ());
+
+      m2::PointD center;
+      TEST(t->Get(feature.first, center), ());
+      TEST_EQUAL(center, actual[j].second, ());
+      ++j;
+    }
+    TEST_EQUAL(j, actual.size(), ());
+
+    m2::PointD center;
+    TEST(!t->Get(1, center), ());
+  }
+}
 }  // namespace
@@ -2,6 +2,7 @@
 
 #include "indexer/cities_boundaries_serdes.hpp"
 #include "indexer/city_boundary.hpp"
+#include "indexer/packed_cities_boundaries.hpp"
 
 #include "coding/geometry_coding.hpp"
 #include "coding/reader.hpp"
@@ -11,6 +12,7 @@
 #include "geometry/point2d.hpp"
 
 #include <cstdint>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -158,5 +160,100 @@ UNIT_TEST(CitiesBoundaries_Moscow)
     TEST_EQUAL(boundaries[0].size(), 1, ());
     TEST(boundaries[0][0].HasPoint(target, precision), ());
   }
+
+  {
+    PackedCitiesBoundaries boundaries;
+    double precision;
+
+    MemReader reader(buffer.data(), buffer.size());
+    NonOwningReaderSource source(reader);
+    CitiesBoundariesSerDes::Deserialize(source, boundaries, precision);
+
+    TEST_EQUAL(boundaries.GetBoundariesCount(), 1, ());
+    TEST(boundaries.HasPoint(0 /* city */, target), ());
+    TEST(!boundaries.HasPoint(1 /* city */, target), ());
+  }
+}
+
+UNIT_TEST(PackedCitiesBoundaries_SameAsCityBoundary)
+{
+  mt19937 rng(42);
+  uniform_real_distribution<double> coord(-100.0, 100.0);
+  uniform_real_distribution<double> offset(0.0, 10.0);
+
+  Boundaries boundaries(200);
+  PackedCitiesBoundaries packed;
+  PackedCitiesBoundaries packedEps;
+  // The boundaries are added not by the cities.
+  for (size_t i = 0; i < 3 * boundaries.size(); ++i)
+  {
+    auto const city = static_cast<uint32_t>((i * 7) % boundaries.size());
+    PointD const center(coord(rng), coord(rng));
+    vector<PointD> points;
+    for (size_t j = 0; j < 5; ++j)
+      points.emplace_back(center.x + offset(rng), center.y + offset(rng));
+    // A point and a segment.
+    if (i % 50 == 0)
+      points.resize(1);
+    if (i % 50 == 1)
+      points.resize(2);
+
+    CityBoundary const boundary(points);
+    boundaries[city].push_back(boundary);
+    packed.Add(city, boundary);
+    packedEps.Add(city, boundary);
+  }
+  packed.Build();
+  double const eps = 0.5;
+  packedEps.Build(eps);
+
+  vector<PointD> points;
+  for (size_t i = 0; i < 10000; ++i)
+    points.emplace_back(coord(rng), coord(rng));
+  // The corners of the boxes.
+  for (auto const & boundary : boundaries)
+  {
+    for (auto const & b : boundary)
+    {
+      points.push_back(b.m_bbox.Min());
+      points.push_back(b.m_bbox.Max());
+    }
+  }
+
+  vector<vector<uint32_t>> batchCities;
+  packed.GetCitiesWithPoints(points, batchCities);
+  TEST_EQUAL(batchCities.size(), points.size(), ());
+  vector<uint32_t> pointCities;
+  size_t hitsCount = 0;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    auto const & p = points[i];
+    vector<uint32_t> expected;
+    vector<uint32_t> expectedEps;
+    for (size_t city = 0; city < boundaries.size(); ++city)
+    {
+      auto const & boundary = boundaries[city];
+      if (any_of(boundary.begin(), boundary.end(), [&](auto const & b) { return b.HasPoint(p); }))
+        expected.push_back(static_cast<uint32_t>(city));
+      if (any_of(boundary.begin(), boundary.end(),
+                 [&](auto const & b) { return b.HasPoint(p, eps); }))
+      {
+        expectedEps.push_back(static_cast<uint32_t>(city));
+      }
+    }
+    hitsCount += expected.size();
+
+    packed.GetCitiesWithPoint(p, pointCities);
+    TEST_EQUAL(pointCities, expected, (p));
+    TEST_EQUAL(batchCities[i], expected, (p));
+    packedEps.GetCitiesWithPoint(p, pointCities);
+    TEST_EQUAL(pointCities, expectedEps, (p));
+
+    if (!expected.empty())
+    {
+      TEST(packed.HasPoint(expected.front(), p), (p));
+    }
+  }
+  TEST_GREATER(hitsCount, 0, ());
 }
 }  // namespace
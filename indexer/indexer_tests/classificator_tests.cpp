@@ -1,6 +1,7 @@
 #include "testing/testing.hpp"
 
 #include "indexer/classificator.hpp"
+#include "indexer/classificator_type_path.hpp"
 
 #include "generator/generator_tests_support/test_with_classificator.hpp"
 
@@ -82,3 +83,23 @@ UNIT_CLASS_TEST(TestWithClassificator, Classificator_Subtree)
 
   TEST_EQUAL(expectedTypes, subtreeTypes, ());
 }
+
+UNIT_CLASS_TEST(TestWithClassificator, Classificator_TypePath)
+{
+  Classificator const & c = classif();
+
+  // The paths registered before and after the load are resolved.
+  static classificator::TypePath const subwayType("railway-station-subway");
+  TEST_EQUAL(subwayType.Get(), c.GetTypeByPath({"railway", "station", "subway"}), ());
+  TEST_EQUAL(subwayType.GetPath(), "railway-station-subway", ());
+
+  classificator::TypePath const sameSubwayType("railway-station-subway");
+  TEST_EQUAL(sameSubwayType.Get(), subwayType.Get(), ());
+
+  static_assert(classificator::HashTypePath("route-ferry") !=
+                    classificator::HashTypePath("railway-station-subway"),
+                "");
+
+  // All the paths registered in the linked code are found in the classificator.
+  TEST(classificator::GetUnresolvedTypePaths().empty(), (classificator::GetUnresolvedTypePaths()));
+}
@@ -0,0 +1,95 @@
+#include "testing/testing.hpp"
+
+#include "indexer/cell_id.hpp"
+#include "indexer/feature_covering.hpp"
+#include "indexer/scales.hpp"
+
+#include "geometry/mercator.hpp"
+#include "geometry/rect2d.hpp"
+
+#include "base/thread_pool_computational.hpp"
+
+#include <cstddef>
+#include <future>
+#include <vector>
+
+using namespace covering;
+using namespace std;
+
+UNIT_TEST(CoveringCache_TileRect)
+{
+  TEST(GetTileRect(0, 0, 0) == MercatorBounds::FullRect(), ());
+
+  auto const rect = GetTileRect(2, 1, 2);
+  TEST_NEAR(rect.minX(), 0.0, 1e-9, ());
+  TEST_NEAR(rect.minY(), -90.0, 1e-9, ());
+  TEST_NEAR(rect.maxX(), 90.0, 1e-9, ());
+  TEST_NEAR(rect.maxY(), 0.0, 1e-9, ());
+}
+
+UNIT_TEST(CoveringCache_SameCoverings)
+{
+  CoveringCache cache(4 /* logCacheSize */);
+  auto const rect = GetTileRect(1234, 567, 12);
+  for (auto const mode : {ViewportWithLowLevels, LowLevelsOnly, FullCover, Spiral})
+  {
+    for (auto const scale : {scales::GetUpperWorldScale(), scales::GetUpperScale()})
+    {
+      CoveringGetter expected(rect, mode);
+      CoveringGetter missed(rect, mode, &cache);
+      CoveringGetter hit(rect, mode, &cache);
+      auto const hits = cache.GetHitsCount();
+      TEST_EQUAL(missed.Get<RectId::DEPTH_LEVELS>(scale),
+                 expected.Get<RectId::DEPTH_LEVELS>(scale), (mode, scale));
+      TEST_EQUAL(cache.GetHitsCount(), hits, ());
+      TEST_EQUAL(hit.Get<RectId::DEPTH_LEVELS>(scale), expected.Get<RectId::DEPTH_LEVELS>(scale),
+                 (mode, scale));
+      TEST_EQUAL(cache.GetHitsCount(), hits + 1, ());
+    }
+  }
+
+  // The other rects are not mixed up with the cached ones.
+  auto const otherRect = GetTileRect(1235, 567, 12);
+  CoveringGetter expected(otherRect, ViewportWithLowLevels);
+  CoveringGetter cov(otherRect, ViewportWithLowLevels, &cache);
+  TEST_EQUAL(cov.Get<RectId::DEPTH_LEVELS>(scales::GetUpperScale()),
+             expected.Get<RectId::DEPTH_LEVELS>(scales::GetUpperScale()), ());
+
+  TEST_GREATER(cache.GetHitRatio(), 0.0, ());
+  cache.Clear();
+  TEST_EQUAL(cache.GetAccessesCount(), 0, ());
+  TEST_EQUAL(cache.GetHitRatio(), 0.0, ());
+}
+
+UNIT_TEST(CoveringCache_Concurrent)
+{
+  size_t const kTilesCount = 8;
+  size_t const kRepeatsCount = 16;
+  CoveringCache cache(10 /* logCacheSize */);
+
+  vector<Intervals> expected;
+  for (uint32_t x = 0; x < kTilesCount; ++x)
+  {
+    CoveringGetter cov(GetTileRect(x, 100, 10), ViewportWithLowLevels);
+    expected.push_back(cov.Get<RectId::DEPTH_LEVELS>(scales::GetUpperScale()));
+  }
+
+  vector<future<bool>> results;
+  {
+    base::thread_pool::computational::ThreadPool threadPool(4);
+    for (size_t i = 0; i < kTilesCount * kRepeatsCount; ++i)
+    {
+      results.push_back(threadPool.Submit([&cache, &expected, i]() {
+        auto const x = static_cast<uint32_t>(i % kTilesCount);
+        auto const rect = GetTileRect(x, 100, 10);
+        CoveringGetter cov(rect, ViewportWithLowLevels, &cache);
+        return cov.Get<RectId::DEPTH_LEVELS>(scales::GetUpperScale()) == expected[x];
+      }));
+    }
+  }
+
+  for (auto & result : results)
+    TEST(result.get(), ());
+  TEST_EQUAL(cache.GetAccessesCount(), kTilesCount * kRepeatsCount, ());
+  TEST_GREATER(cache.GetHitsCount(), 0, ());
+}
@@ -0,0 +1,57 @@
+#include "testing/testing.hpp"
+
+#include "indexer/classificator_loader.hpp"
+#include "indexer/feature.hpp"
+#include "indexer/features_vector.hpp"
+
+#include "platform/platform.hpp"
+
+#include "coding/string_utf8_multilang.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "defines.hpp"
+
+using namespace std;
+
+UNIT_TEST(FeatureType_SelectiveParsing)
+{
+  classificator::Load();
+
+  FeaturesVectorTest features(
+      (FilesContainerR(GetPlatform().GetReader("minsk-pass" DATA_FILE_EXTENSION))));
+  auto const & vector = features.GetVector();
+
+  size_t namesCount = 0;
+  for (uint32_t index = 0; index < vector.GetNumFeatures(); ++index)
+  {
+    auto const full = vector.GetByIndex(index);
+    full->ParseFields(FeatureType::FIELD_TYPES | FeatureType::FIELD_COMMON);
+
+    auto const partial = vector.GetByIndex(index);
+    partial->ParseFields(FeatureType::FIELD_TYPES | FeatureType::FIELD_CENTER);
+    TEST_EQUAL(partial->GetLayer(), full->GetLayer(), (index));
+    TEST_EQUAL(partial->GetRank(), full->GetRank(), (index));
+    if (partial->GetGeomType() == feature::GeomType::Point)
+    {
+      TEST_EQUAL(partial->GetCenter(), full->GetCenter(), (index));
+    }
+
+    for (int8_t lang = 0; lang < StringUtf8Multilang::kMaxSupportedLanguages; ++lang)
+    {
+      string name, fullName;
+      TEST_EQUAL(partial->GetName(lang, name), full->GetName(lang, fullName), (index, lang));
+      TEST_EQUAL(name, fullName, (index, lang));
+      if (!name.empty())
+        ++namesCount;
+    }
+
+    TEST_EQUAL(partial->GetLimitRect(FeatureType::BEST_GEOMETRY),
+               full->GetLimitRect(FeatureType::BEST_GEOMETRY), (index));
+    TEST_EQUAL(partial->GetNames(), full->GetNames(), (index));
+    TEST_EQUAL(partial->GetHouseNumber(), full->GetHouseNumber(), (index));
+    TEST_EQUAL(partial->GetRoadNumber(), full->GetRoadNumber(), (index));
+  }
+  TEST_GREATER(namesCount, 0, ());
+}
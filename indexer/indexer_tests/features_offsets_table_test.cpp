@@ -0,0 +1,34 @@
+#include "testing/testing.hpp"
+
+#include "indexer/features_offsets_table.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace feature;
+using namespace std;
+
+namespace
+{
+UNIT_TEST(FeaturesOffsetsTable_GetFeatureOffsets)
+{
+  FeaturesOffsetsTable::Builder builder;
+  for (uint32_t i = 0; i < 1000; ++i)
+    builder.PushOffset(i * i + 7 * i + 3);
+
+  auto const table = FeaturesOffsetsTable::Build(builder);
+  TEST(table, ());
+  TEST_EQUAL(table->size(), 1000, ());
+
+  // Duplicates, close indices and far ones.
+  vector<uint32_t> const indices = {0, 0, 1, 2, 5, 63, 64, 200, 201, 201, 700, 998, 999};
+  vector<uint32_t> offsets;
+  table->GetFeatureOffsets(indices, offsets);
+  TEST_EQUAL(offsets.size(), indices.size(), ());
+  for (size_t i = 0; i < indices.size(); ++i)
+    TEST_EQUAL(offsets[i], table->GetFeatureOffset(indices[i]), (indices[i]));
+
+  table->GetFeatureOffsets({}, offsets);
+  TEST(offsets.empty(), ());
+}
+}  // namespace
@@ -4,6 +4,7 @@
 #include "indexer/data_source.hpp"
 #include "indexer/features_vector.hpp"
 #include "indexer/index_builder.hpp"
+#include "indexer/scales.hpp"
 
 #include "defines.hpp"
 
@@ -14,6 +15,12 @@
 #include "base/macros.hpp"
 #include "base/stl_helpers.hpp"
 
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 UNIT_TEST(BuildIndexTest)
 {
   Platform & p = GetPlatform();
@@ -60,3 +67,150 @@ UNIT_TEST(BuildIndexTest)
   // Clean after the test.
   FileWriter::DeleteFileX(filePath);
 }
+
+UNIT_TEST(BuildIndexTest_ThreadsCount)
+{
+  Platform & p = GetPlatform();
+  classificator::Load();
+
+  FilesContainerR originalContainer(p.GetReader("minsk-pass" DATA_FILE_EXTENSION));
+  FeaturesVectorTest features(originalContainer);
+
+  // The in-memory parallel mode builds the same index.
+  vector<char> serialIndex;
+  MemWriter<vector<char>> serialWriter(serialIndex);
+  indexer::BuildIndex(features.GetHeader(), features.GetVector(), serialWriter, "build_index_test");
+
+  vector<char> parallelIndex;
+  MemWriter<vector<char>> parallelWriter(parallelIndex);
+  indexer::BuildIndex(features.GetHeader(), features.GetVector(), parallelWriter,
+                      "build_index_test", 4 /* threadsCount */);
+
+  TEST(!serialIndex.empty(), ());
+  TEST(serialIndex == parallelIndex, ());
+}
+
+UNIT_TEST(FeaturesVector_ConcurrentMode)
+{
+  Platform & p = GetPlatform();
+  classificator::Load();
+
+  FeaturesVectorTest features((FilesContainerR(p.GetReader("minsk-pass" DATA_FILE_EXTENSION))));
+  TEST(!features.GetVector().IsConcurrent(), ());
+  FeaturesVectorTest mappedFeatures(
+      FeaturesVectorTest::MapContainer(p.ReadPathForFile("minsk-pass" DATA_FILE_EXTENSION)));
+  auto const & mapped = mappedFeatures.GetVector();
+  TEST(mapped.IsConcurrent(), ());
+
+  vector<string> expected;
+  features.GetVector().ForEach([&expected](FeatureType & ft, uint32_t /* index */) {
+    expected.push_back(ft.DebugString(FeatureType::BEST_GEOMETRY));
+  });
+  TEST_EQUAL(expected.size(), mapped.GetNumFeatures(), ());
+
+  size_t count = 0;
+  mapped.ForEach([&](FeatureType & ft, uint32_t index) {
+    TEST_EQUAL(ft.DebugString(FeatureType::BEST_GEOMETRY), expected[index], ());
+    ++count;
+  });
+  TEST_EQUAL(count, expected.size(), ());
+
+  size_t const kThreadsCount = 4;
+  vector<vector<string>> results(kThreadsCount);
+  vector<thread> threads;
+  for (size_t i = 0; i < kThreadsCount; ++i)
+  {
+    threads.emplace_back([&mapped, &results, &expected, i]() {
+      for (size_t index = i; index < expected.size(); index += kThreadsCount)
+      {
+        auto const ft = mapped.GetByIndex(static_cast<uint32_t>(index));
+        results[i].push_back(ft->DebugString(FeatureType::BEST_GEOMETRY));
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  for (size_t i = 0; i < kThreadsCount; ++i)
+  {
+    for (size_t j = 0; j < results[i].size(); ++j)
+      TEST_EQUAL(results[i][j], expected[i + j * kThreadsCount], ());
+  }
+}
+
+UNIT_TEST(DataSource_Batches)
+{
+  classificator::Load();
+
+  FrozenDataSource dataSource;
+  auto const result = dataSource.RegisterMap(platform::LocalCountryFile::MakeForTesting("minsk-pass"));
+  TEST_EQUAL(result.second, MwmSet::RegResult::Success, ());
+
+  m2::RectD const rect = result.first.GetInfo()->m_bordersRect;
+  int const scale = scales::GetUpperScale();
+
+  vector<FeatureID> expected;
+  dataSource.ForEachInRect([&expected](FeatureType & ft) { expected.push_back(ft.GetID()); },
+                           rect, scale);
+  sort(expected.begin(), expected.end());
+  expected.erase(unique(expected.begin(), expected.end()), expected.end());
+  TEST(!expected.empty(), ());
+
+  size_t const kBatchSize = 100;
+  auto const collect = [kBatchSize](vector<FeatureID> & ids, mutex & idsMutex) {
+    return [&ids, &idsMutex, kBatchSize](DataSource::FeaturesBatch & batch) {
+      TEST(!batch.empty(), ());
+      TEST_LESS_OR_EQUAL(batch.size(), kBatchSize, ());
+      lock_guard<mutex> lock(idsMutex);
+      for (auto const & ft : batch)
+      {
+        // The features of a batch are in the order of their offsets.
+        TEST(ids.empty() || ids.back() < ft->GetID(), ());
+        ids.push_back(ft->GetID());
+      }
+    };
+  };
+
+  mutex idsMutex;
+  {
+    vector<FeatureID> ids;
+    dataSource.ForEachBatchInRect(collect(ids, idsMutex), rect, scale, kBatchSize);
+    TEST_EQUAL(ids, expected, ());
+  }
+  {
+    vector<FeatureID> ids;
+    dataSource.ForEachBatchInRect(collect(ids, idsMutex), rect, scale, kBatchSize,
+                                  4 /* threadsCount */);
+    TEST_EQUAL(ids, expected, ());
+  }
+  {
+    vector<FeatureID> ids;
+    dataSource.ReadFeatures(collect(ids, idsMutex), expected, kBatchSize);
+    TEST_EQUAL(ids, expected, ());
+  }
+}
+
+UNIT_TEST(DataSource_ReadModes)
+{
+  classificator::Load();
+
+  auto const readFeatures = [](MwmReadMode readMode) {
+    FrozenDataSource dataSource(MwmSet::Concurrency::Serial, readMode);
+    auto const result =
+        dataSource.RegisterMap(platform::LocalCountryFile::MakeForTesting("minsk-pass"));
+    TEST_EQUAL(result.second, MwmSet::RegResult::Success, ());
+
+    vector<string> features;
+    dataSource.ForEachInRect(
+        [&features](FeatureType & ft) {
+          features.push_back(ft.DebugString(FeatureType::BEST_GEOMETRY));
+        },
+        result.first.GetInfo()->m_bordersRect, scales::GetUpperScale());
+    return features;
+  };
+
+  auto const expected = readFeatures(MwmReadMode::Cached);
+  TEST(!expected.empty(), ());
+  TEST_EQUAL(readFeatures(MwmReadMode::MappedScan), expected, ());
+  TEST_EQUAL(readFeatures(MwmReadMode::MappedLookup), expected, ());
+}
@@ -318,3 +318,81 @@ UNIT_TEST(IntervalIndex_Simple5)
     TEST_EQUAL(values, vector<uint32_t>(expected, expected + ARRAY_SIZE(expected)), ());
   }
 }
+
+UNIT_TEST(IntervalIndex_ReaderWithoutDirectData)
+{
+  // Reads through Read() only as the readers of files do.
+  class CopyingReader : public Reader
+  {
+  public:
+    explicit CopyingReader(MemReader const & reader) : m_reader(reader) {}
+
+    uint64_t Size() const override { return m_reader.Size(); }
+    void Read(uint64_t pos, void * p, size_t size) const override { m_reader.Read(pos, p, size); }
+    unique_ptr<Reader> CreateSubReader(uint64_t pos, uint64_t size) const override
+    {
+      return m_reader.CreateSubReader(pos, size);
+    }
+
+  private:
+    MemReader m_reader;
+  };
+
+  vector<CellIdFeaturePairForTest> data;
+  for (uint32_t i = 0; i < 1000; ++i)
+    data.push_back(CellIdFeaturePairForTest((uint64_t{i} + 1) * 0x9E3779B1ULL % 0x10000000000ULL, i));
+  sort(data.begin(), data.end(), [](auto const & l, auto const & r) { return l.m_cell < r.m_cell; });
+  vector<char> serialIndex;
+  MemWriter<vector<char>> writer(serialIndex);
+  BuildIntervalIndex(data.begin(), data.end(), writer, 40);
+
+  MemReader const reader(&serialIndex[0], serialIndex.size());
+  TEST(reader.GetDirectData(), ());
+  TEST(!CopyingReader(reader).GetDirectData(), ());
+  IntervalIndex<MemReader, uint32_t> const index(reader);
+  IntervalIndex<CopyingReader, uint32_t> const copyingIndex{CopyingReader(reader)};
+
+  for (uint64_t beg = 0; beg < index.KeyEnd(); beg += 0x1234567890ULL)
+  {
+    vector<uint32_t> values;
+    vector<uint32_t> copyingValues;
+    index.ForEach(IndexValueInserter(values), beg, beg + 0x4000000000ULL);
+    copyingIndex.ForEach(IndexValueInserter(copyingValues), beg, beg + 0x4000000000ULL);
+    TEST_EQUAL(values, copyingValues, (beg));
+  }
+}
+
+UNIT_TEST(IntervalIndex_ForEachInIntervals)
+{
+  vector<CellIdFeaturePairForTest> data;
+  for (uint32_t i = 0; i < 1000; ++i)
+    data.push_back(CellIdFeaturePairForTest((uint64_t{i} + 1) * 0x9E3779B1ULL % 0x10000000000ULL, i));
+  sort(data.begin(), data.end(), [](auto const & l, auto const & r) { return l.m_cell < r.m_cell; });
+  vector<char> serialIndex;
+  MemWriter<vector<char>> writer(serialIndex);
+  BuildIntervalIndex(data.begin(), data.end(), writer, 40);
+  MemReader reader(&serialIndex[0], serialIndex.size());
+  IntervalIndex<MemReader, uint32_t> index(reader);
+
+  // Adjacent, empty, sparse and out of the keys intervals.
+  vector<pair<int64_t, int64_t>> const intervals = {{0, 0x100000000LL},
+                                                    {0x100000000LL, 0x2000000000LL},
+                                                    {0x2000000000LL, 0x2000000000LL},
+                                                    {0x3000000000LL, 0x3000000001LL},
+                                                    {0x4000000000LL, 0x8000000000LL},
+                                                    {0x8100000000LL, 0xA000000000LL},
+                                                    {0xFF00000000LL, 0x20000000000LL}};
+
+  vector<uint32_t> expected;
+  for (auto const & interval : intervals)
+    index.ForEach(IndexValueInserter(expected), interval.first, interval.second);
+
+  vector<uint32_t> values;
+  index.ForEachInIntervals(IndexValueInserter(values), intervals);
+  TEST(!values.empty(), ());
+  TEST_EQUAL(values, expected, ());
+
+  values.clear();
+  index.ForEachInIntervals(IndexValueInserter(values), vector<pair<int64_t, int64_t>>{});
+  TEST(values.empty(), ());
+}
@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <iterator>
 #include <set>
 #include <utility>
 #include <vector>
@@ -81,6 +82,32 @@ UNIT_TEST(BuildCoveringIndexTest)
   TEST_EQUAL(GetIds(index, m2::RectD{-0.5, -0.5, 1.5, 1.5}), (Ids{1, 2, 3, 4}), ());
 }
 
+UNIT_TEST(BuildCoveringIndexTest_Parts)
+{
+  vector<CoveredObject> objects(50);
+  for (size_t i = 0; i < objects.size(); ++i)
+    objects[i].SetForTesting(i + 1, m2::PointD{static_cast<double>(i % 7), i / 7.0});
+
+  vector<uint8_t> wholeIndex;
+  MemWriter<vector<uint8_t>> wholeWriter(wholeIndex);
+  BuildGeoObjectsIndex(objects, wholeWriter);
+
+  base::thread_pool::computational::ThreadPool threadPool{2};
+  indexer::GeoObjectsIndexBuilder indexBuilder{threadPool};
+  // The parts of the covering by the covering threads, one of them is empty.
+  covering::ObjectsCoverings objectsCoverings(4);
+  for (size_t i = 0; i < objects.size(); ++i)
+    indexBuilder.Cover(objects[i], *next(objectsCoverings.begin(), i % 3));
+
+  vector<uint8_t> partsIndex;
+  MemWriter<vector<uint8_t>> partsWriter(partsIndex);
+  indexBuilder.BuildCoveringIndex(std::move(objectsCoverings), partsWriter,
+                                  kGeoObjectsDepthLevels);
+
+  TEST(!wholeIndex.empty(), ());
+  TEST(wholeIndex == partsIndex, ());
+}
+
 UNIT_TEST(CoveringIndexRankTest)
 {
   vector<CoveredObject> objects;
@@ -221,4 +248,69 @@ UNIT_TEST(CoveringIndexWeightRankTest)
   TEST(ids[6].second < ids[3].second, ());
 }
 
+UNIT_TEST(CoveringIndexKNearestTest)
+{
+  m2::PointD queryPoint{0, 0};
+  m2::PointD queryBorder{0, 2};
+
+  vector<CoveredObject> objects;
+  objects.resize(6);
+  objects[0].SetForTesting(1, m2::PointD{0, 0});
+  objects[1].SetForTesting(2, m2::RectD{-1, -1, 1, 1});
+  objects[2].SetForTesting(3, m2::RectD{0.5, 0.5, 1.0, 1.0});
+  objects[3].SetForTesting(4, m2::PointD{1, 0});
+  objects[4].SetForTesting(5, m2::PointD{1.5, 1.5});
+  objects[5].SetForTesting(6, m2::PointD{5, 5});
+
+  vector<uint8_t> localityIndex;
+  MemWriter<vector<uint8_t>> writer(localityIndex);
+  BuildGeoObjectsIndex(objects, writer);
+  MemReader reader(localityIndex.data(), localityIndex.size());
+
+  indexer::GeoObjectsIndex<MemReader> index(reader);
+  auto const radiusM = MercatorBounds::DistanceOnEarth(queryPoint, queryBorder);
+
+  vector<pair<uint64_t, double>> closest;
+  index.ForClosestToPoint(
+      [&closest](base::GeoObjectId const & id, auto weight) {
+        closest.push_back({id.GetEncodedId(), weight});
+      },
+      queryPoint, radiusM, 100 /* sizeHint */);
+  // The object "6" is out of the radius.
+  TEST_EQUAL(closest.size(), 5, ());
+
+  for (uint32_t k = 1; k <= 6; ++k)
+  {
+    vector<pair<uint64_t, double>> nearest;
+    index.ForKNearestToPoint(
+        [&nearest](base::GeoObjectId const & id, auto weight) {
+          nearest.push_back({id.GetEncodedId(), weight});
+        },
+        queryPoint, radiusM, k);
+
+    TEST_GREATER_OR_EQUAL(nearest.size(), min<size_t>(k, closest.size()), (k));
+    for (size_t i = 0; i < nearest.size(); ++i)
+    {
+      TEST_EQUAL(nearest[i].second, closest[i].second, (k, i));
+      if (i > 0)
+      {
+        TEST_GREATER_OR_EQUAL(nearest[i - 1].second, nearest[i].second, (k, i));
+      }
+    }
+    // Only the objects as close as the k-th object are added over the |k| limit.
+    for (size_t i = k; i < nearest.size(); ++i)
+      TEST_EQUAL(nearest[i].second, nearest[k - 1].second, (k, i));
+    // All the objects as close as the last object are processed.
+    if (nearest.size() < closest.size())
+    {
+      TEST_LESS(closest[nearest.size()].second, nearest.back().second, (k));
+    }
+  }
+
+  size_t count = 0;
+  index.ForKNearestToPoint([&count](base::GeoObjectId const &, auto) { ++count; }, queryPoint,
+                           radiusM, 0 /* k */);
+  TEST_EQUAL(count, 0, ());
+}
+
 }  // namespace
@@ -6,8 +6,11 @@
 
 #include "base/macros.hpp"
 
+#include <atomic>
 #include <initializer_list>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 using namespace std;
 using platform::CountryFile;
@@ -158,3 +161,95 @@ UNIT_TEST(MwmSetLockAndIdTest)
   TEST(!handle.GetId().IsAlive(), ());
   TEST(!handle.GetId().GetInfo().get(), ());
 }
+
+UNIT_TEST(MwmSetConcurrentLockTest)
+{
+  TestMwmSet mwmSet(MwmSet::Concurrency::Concurrent);
+  vector<MwmSet::MwmId> ids;
+  for (auto const & name : {"1", "2", "3"})
+  {
+    auto const p = mwmSet.Register(LocalCountryFile::MakeForTesting(name));
+    TEST_EQUAL(MwmSet::RegResult::Success, p.second, (name));
+    ids.push_back(p.first);
+  }
+
+  vector<thread> threads;
+  atomic<size_t> deadHandles{0};
+  for (size_t i = 0; i < 8; ++i)
+  {
+    threads.emplace_back([&mwmSet, &ids, &deadHandles, i]() {
+      for (size_t j = 0; j < 1000; ++j)
+      {
+        auto const handle = mwmSet.GetMwmHandleById(ids[(i + j) % ids.size()]);
+        auto const handles = mwmSet.GetMwmHandlesByIds(ids);
+        if (!handle.IsAlive())
+          ++deadHandles;
+        for (auto const & h : handles)
+        {
+          if (!h.IsAlive())
+            ++deadHandles;
+        }
+      }
+    });
+  }
+  for (auto & thread : threads)
+    thread.join();
+
+  TEST_EQUAL(deadHandles.load(), 0, ());
+  for (auto const & id : ids)
+    TEST_EQUAL(id.GetInfo()->GetNumRefs(), 0, (id));
+
+  {
+    auto const handles = mwmSet.GetMwmHandlesByIds({ids[0], MwmSet::MwmId(), ids[2]});
+    TEST_EQUAL(handles.size(), 3, ());
+    TEST(handles[0].IsAlive(), ());
+    TEST(!handles[1].IsAlive(), ());
+    TEST(handles[2].IsAlive(), ());
+    TEST_EQUAL(handles[2].GetId(), ids[2], ());
+
+    TEST(!mwmSet.Deregister(CountryFile("3")), ());
+    TEST_EQUAL(MwmInfo::STATUS_MARKED_TO_DEREGISTER, ids[2].GetInfo()->GetStatus(), ());
+    TEST_EQUAL(ids[2].GetInfo()->GetNumRefs(), 1, ());
+  }
+
+  TEST(!ids[2].IsAlive(), ());
+  TEST_EQUAL(MwmInfo::STATUS_DEREGISTERED, ids[2].GetInfo()->GetStatus(), ());
+  TEST(!mwmSet.GetMwmHandleById(ids[2]).IsAlive(), ());
+  TEST(mwmSet.GetMwmHandleById(ids[1]).IsAlive(), ());
+}
+
+UNIT_TEST(MwmSetRegisterManyTest)
+{
+  TestMwmSet mwmSet;
+  MwmsInfo mwmsInfo;
+
+  vector<LocalCountryFile> localFiles;
+  for (char const * name : {"0", "1", "2", "3", "4"})
+    localFiles.push_back(LocalCountryFile::MakeForTesting(name));
+
+  auto results = mwmSet.Register(localFiles, 3 /* threadsCount */);
+  TEST_EQUAL(results.size(), localFiles.size(), ());
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    TEST_EQUAL(results[i].second, MwmSet::RegResult::Success, (i));
+    TEST(results[i].first.IsAlive(), (i));
+    TEST_EQUAL(results[i].first.GetInfo()->m_maxScale, i, ());
+  }
+
+  GetMwmsInfo(mwmSet, mwmsInfo);
+  TestFilesPresence(mwmsInfo, {"0", "1", "2", "3", "4"});
+
+  results = mwmSet.Register({LocalCountryFile::MakeForTesting("2"),
+                             LocalCountryFile::MakeForTesting("3", 1 /* version */),
+                             LocalCountryFile::MakeForTesting("5")},
+                            2 /* threadsCount */);
+  TEST_EQUAL(results.size(), 3, ());
+  TEST_EQUAL(results[0].second, MwmSet::RegResult::VersionAlreadyExists, ());
+  TEST_EQUAL(results[1].second, MwmSet::RegResult::Success, ());
+  TEST_EQUAL(results[1].first.GetInfo()->GetVersion(), 1, ());
+  TEST_EQUAL(results[2].second, MwmSet::RegResult::Success, ());
+
+  GetMwmsInfo(mwmSet, mwmsInfo);
+  TestFilesPresence(mwmsInfo, {"0", "1", "2", "3", "4", "5"});
+  TEST_EQUAL(mwmsInfo["3"]->GetVersion(), 1, ());
+}
@@ -0,0 +1,74 @@
+#include "testing/testing.hpp"
+
+#include "indexer/road_shields_parser.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace ftypes;
+using namespace std;
+
+namespace
+{
+vector<string> ToStrings(set<RoadShield> const & shields)
+{
+  vector<string> result;
+  for (auto const & shield : shields)
+    result.push_back(DebugPrint(shield));
+  return result;
+}
+}  // namespace
+
+UNIT_TEST(RoadShieldsCache_Smoke)
+{
+  RoadShieldsCache cache(4 /* logCacheSize */);
+
+  for (auto const & mwmName : {"US_Texas", "Russia_Moscow", "Italy_Lazio"})
+  {
+    for (auto const & roadNumber : {"I 95;US 1", "М-10;E 105", "A1", ""})
+    {
+      auto const shields = cache.Get(mwmName, roadNumber);
+      TEST(shields, ());
+      TEST_EQUAL(ToStrings(*shields), ToStrings(GetRoadShields(mwmName, roadNumber)),
+                 (mwmName, roadNumber));
+    }
+  }
+
+  // The mwms of a country share the shields.
+  auto const hits = cache.GetHitsCount();
+  TEST_EQUAL(cache.Get("US_Texas", "I 95;US 1"), cache.Get("US_Florida", "I 95;US 1"), ());
+  TEST_EQUAL(cache.GetHitsCount(), hits + 2, ());
+
+  // The refs are parsed by the rules of the countries.
+  TEST_NOT_EQUAL(ToStrings(*cache.Get("US_Texas", "I 95")),
+                 ToStrings(*cache.Get("Italy_Lazio", "I 95")), ());
+
+  cache.Clear();
+  TEST_EQUAL(cache.GetAccessesCount(), 0, ());
+  TEST_EQUAL(cache.GetHitRatio(), 0.0, ());
+}
+
+UNIT_TEST(RoadShieldsCache_Batch)
+{
+  string const mwmName = "Russia_Tver Oblast";
+  RoadShieldsCache cache(10 /* logCacheSize */);
+  vector<string> const roadNumbers = {"M-10", "A1", "M-10", "", "M-10"};
+  auto const shields = cache.Get(mwmName, roadNumbers);
+  TEST_EQUAL(shields.size(), roadNumbers.size(), ());
+  for (size_t i = 0; i < roadNumbers.size(); ++i)
+  {
+    TEST_EQUAL(ToStrings(*shields[i]), ToStrings(GetRoadShields(mwmName, roadNumbers[i])),
+               (roadNumbers[i]));
+  }
+
+  // Every distinct ref of the batch is looked up once.
+  TEST_EQUAL(shields[0], shields[2], ());
+  TEST_EQUAL(shields[0], shields[4], ());
+  TEST_EQUAL(cache.GetAccessesCount(), 2, ());
+  TEST_EQUAL(cache.GetHitsCount(), 0, ());
+
+  cache.Get(mwmName, roadNumbers);
+  TEST_EQUAL(cache.GetHitsCount(), 2, ());
+  TEST_NEAR(cache.GetHitRatio(), 0.5, 1e-9, ());
+}
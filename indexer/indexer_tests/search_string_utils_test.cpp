@@ -262,3 +262,43 @@ UNIT_TEST(NormalizeAndSimplifyString_Numero)
   TEST_EQUAL(NormalizeAndSimplifyStringUtf8("Area # "), "area   ", ());
   TEST_EQUAL(NormalizeAndSimplifyStringUtf8("Area #One"), "area #one", ());
 }
+
+UNIT_TEST(NormalizeAndTokenize_AsciiFastPath)
+{
+  TEST(IsAsciiString("Some Long ASCII string 12345"), ());
+  TEST(!IsAsciiString("Some Long ASCII string with ё"), ());
+  TEST(!IsAsciiString("ё"), ());
+
+  // The fast path gives the same tokens as the full normalization.
+  string ascii;
+  for (int c = 1; c < 0x80; ++c)
+    ascii += static_cast<char>(c);
+  for (auto const & s : {string("Main ST, 10-Berlin #5;;Zürich"), string("  UPPER lower 0_9 "),
+                         string("№5 Nw. #"), ascii, ascii + ascii + "tail"})
+  {
+    vector<string> expected;
+    SplitUniString(NormalizeAndSimplifyString(s), [&](UniString const & token) {
+      expected.push_back(ToUtf8(token));
+    }, Delimiters());
+
+    vector<string> tokens;
+    NormalizeAndTokenizeAsUtf8(s, tokens);
+    TEST_EQUAL(tokens, expected, (s));
+
+    vector<UniString> uniTokens;
+    NormalizeAndTokenizeString(s, uniTokens);
+    TEST_EQUAL(uniTokens.size(), expected.size(), (s));
+    for (size_t i = 0; i < uniTokens.size(); ++i)
+      TEST_EQUAL(ToUtf8(uniTokens[i]), expected[i], (s));
+
+    NormalizedTokens normalized;
+    auto const & views = normalized.Tokenize(s);
+    TEST_EQUAL(vector<string>(views.begin(), views.end()), expected, (s));
+  }
+
+  NormalizedTokens normalized;
+  normalized.Tokenize("Старый Арбат, 12");
+  auto const & views = normalized.Tokenize("Old ARBAT 12");
+  TEST_EQUAL(vector<string>(views.begin(), views.end()), vector<string>({"old", "arbat", "12"}),
+             ());
+}
@@ -18,6 +18,12 @@ namespace tests
 
 class TestMwmSet : public MwmSet
 {
+public:
+  explicit TestMwmSet(Concurrency concurrency = Concurrency::Serial)
+    : MwmSet(kDefaultCacheSize, concurrency)
+  {
+  }
+
 protected:
   /// @name MwmSet overrides
   //@{
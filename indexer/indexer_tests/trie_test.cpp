@@ -218,3 +218,112 @@ UNIT_TEST(TrieBuilder_Build)
     }
   }
 }
+
+UNIT_TEST(MappedTrie_Smoke)
+{
+  using Key = buffer_vector<trie::TrieChar, 8>;
+  using KeyValuePair = pair<Key, uint32_t>;
+
+  vector<string> const words = {"",     "a",     "ab",    "abc", "abd", "b",
+                                "bcd",  "bcde",  "bcdef", "z",   "zz",  string(70, 'x')};
+  auto makeKey = [](string const & s) { return Key(s.begin(), s.end()); };
+  vector<KeyValuePair> v;
+  for (uint32_t i = 0; i < words.size(); ++i)
+  {
+    v.emplace_back(makeKey(words[i]), i);
+    v.emplace_back(makeKey(words[i]), i + 100);
+  }
+  sort(v.begin(), v.end());
+
+  vector<uint8_t> buf;
+  PushBackByteSink<vector<uint8_t>> sink(buf);
+  SingleValueSerializer<uint32_t> serializer;
+  trie::Build<PushBackByteSink<vector<uint8_t>>, Key, ValueList<uint32_t>,
+              SingleValueSerializer<uint32_t>>(sink, serializer, v);
+  reverse(buf.begin(), buf.end());
+
+  trie::MappedTrie<ValueList<uint32_t>, SingleValueSerializer<uint32_t>> const trie(
+      buf.data(), buf.size(), serializer);
+
+  for (uint32_t i = 0; i < words.size(); ++i)
+  {
+    vector<uint32_t> values;
+    TEST(trie.ForEachValue(makeKey(words[i]), [&values](uint32_t v) { values.push_back(v); }),
+         (words[i]));
+    sort(values.begin(), values.end());
+    TEST_EQUAL(values, vector<uint32_t>({i, i + 100}), (words[i]));
+  }
+  for (auto const & word : {"abcd", "bc", "c", "zzz", "xxx"})
+    TEST(!trie.ForEachValue(makeKey(word), [](uint32_t) {}), (word));
+
+  vector<Key> prefixes;
+  for (auto const & prefix : {"ab", "bcd", "", "q", "bcdefg", "x", "a"})
+    prefixes.push_back(makeKey(prefix));
+
+  vector<vector<KeyValuePair>> batched(prefixes.size());
+  trie.ForEachWithPrefixes(prefixes, [&batched](size_t i, Key const & key, uint32_t value) {
+    batched[i].emplace_back(key, value);
+  });
+  for (size_t i = 0; i < prefixes.size(); ++i)
+  {
+    vector<KeyValuePair> expected;
+    for (auto const & kv : v)
+    {
+      if (kv.first.size() >= prefixes[i].size() &&
+          equal(prefixes[i].begin(), prefixes[i].end(), kv.first.begin()))
+      {
+        expected.push_back(kv);
+      }
+    }
+
+    vector<KeyValuePair> single;
+    trie.ForEachWithPrefix(prefixes[i], [&single](Key const & key, uint32_t value) {
+      single.emplace_back(key, value);
+    });
+
+    sort(batched[i].begin(), batched[i].end());
+    sort(single.begin(), single.end());
+    TEST_EQUAL(batched[i], expected, (i));
+    TEST_EQUAL(single, expected, (i));
+  }
+}
+
+UNIT_TEST(Trie_BuildParallel)
+{
+  using Key = buffer_vector<trie::TrieChar, 8>;
+  using KeyValuePair = pair<Key, uint32_t>;
+
+  vector<KeyValuePair> v;
+  v.emplace_back(Key{}, 7);
+  for (uint32_t i = 0; i < 3000; ++i)
+  {
+    auto const s = to_string(i * 7919 % 100003);
+    v.emplace_back(Key(s.begin(), s.end()), i);
+    v.emplace_back(Key(s.rbegin(), s.rend()), i + 5000);
+  }
+  sort(v.begin(), v.end());
+
+  SingleValueSerializer<uint32_t> serializer;
+  auto const build = [&](base::thread_pool::computational::ThreadPool * threadPool) {
+    vector<uint8_t> buf;
+    PushBackByteSink<vector<uint8_t>> sink(buf);
+    if (threadPool)
+    {
+      trie::Build<PushBackByteSink<vector<uint8_t>>, Key, ValueList<uint32_t>,
+                  SingleValueSerializer<uint32_t>>(sink, serializer, v, *threadPool);
+    }
+    else
+    {
+      trie::Build<PushBackByteSink<vector<uint8_t>>, Key, ValueList<uint32_t>,
+                  SingleValueSerializer<uint32_t>>(sink, serializer, v);
+    }
+    return buf;
+  };
+
+  auto const expected = build(nullptr);
+  for (size_t threadsCount : {1, 3, 8})
+  {
+    base::thread_pool::computational::ThreadPool threadPool(threadsCount);
+    TEST_EQUAL(build(&threadPool), expected, (threadsCount));
+  }
+}
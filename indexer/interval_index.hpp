@@ -7,8 +7,10 @@
 #include "base/assert.hpp"
 #include "base/buffer_vector.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <utility>
 
 enum class IntervalIndexVersion : uint8_t
 {
@@ -43,7 +45,8 @@ class IntervalIndex : public IntervalIndexBase
   typedef IntervalIndexBase base_t;
 public:
 
-  explicit IntervalIndex(ReaderT const & reader) : m_Reader(reader)
+  explicit IntervalIndex(ReaderT const & reader)
+    : m_Reader(reader), m_Data(static_cast<uint8_t const *>(m_Reader.GetDirectData()))
   {
     ReaderSource<ReaderT> src(reader);
     src.Read(&m_Header, sizeof(Header));
@@ -69,50 +72,74 @@ public:
   template <typename F>
   void ForEach(F const & f, uint64_t beg, uint64_t end) const
   {
-    if (m_Header.m_Levels != 0 && beg != end)
+    std::pair<uint64_t, uint64_t> const intervals[] = {{beg, end}};
+    ForEachInIntervals(f, intervals);
+  }
+
+  // Applies |f| to the objects of [beg, end) |intervals| of keys. The intervals must be sorted
+  // and must not overlap. The tree is walked once for all the intervals, so the nodes shared
+  // by the intervals are decoded once. The objects are in the same order as for the ForEach()
+  // calls for each interval.
+  template <typename F, typename Intervals>
+  void ForEachInIntervals(F const & f, Intervals const & intervals) const
+  {
+    if (m_Header.m_Levels == 0)
+      return;
+
+    // Inclusive ranges of keys.
+    buffer_vector<KeyRange, 32> ranges;
+    for (auto const & interval : intervals)
     {
-      // ASSERT_LESS_OR_EQUAL(beg, KeyEnd(), (end));
-      // ASSERT_LESS_OR_EQUAL(end, KeyEnd(), (beg));
-      if (beg > KeyEnd())
-        beg = KeyEnd();
-      if (end > KeyEnd())
-        end = KeyEnd();
-      --end;  // end is inclusive in ForEachImpl().
-      ForEachNode(f, beg, end, m_Header.m_Levels, 0,
-                  m_LevelOffsets[m_Header.m_Levels + 1] - m_LevelOffsets[m_Header.m_Levels],
-                  0 /* started keyBase */);
+      auto const beg = std::min(static_cast<uint64_t>(interval.first), KeyEnd());
+      auto const end = std::min(static_cast<uint64_t>(interval.second), KeyEnd());
+      if (beg >= end)
+        continue;
+
+      ASSERT(ranges.empty() || ranges.back().second < beg, (ranges.back(), beg, end));
+      ranges.emplace_back(beg, end - 1);
     }
+
+    if (ranges.empty())
+      return;
+
+    ForEachNode(f, ranges.data(), ranges.data() + ranges.size(), m_Header.m_Levels, 0,
+                m_LevelOffsets[m_Header.m_Levels + 1] - m_LevelOffsets[m_Header.m_Levels],
+                0 /* started keyBase */);
   }
 
 private:
+  using KeyRange = std::pair<uint64_t, uint64_t>;
+
+  // |first|, |last|: the ranges which intersect the node.
   template <typename F>
-  void ForEachLeaf(F const & f, uint64_t const beg, uint64_t const end,
+  void ForEachLeaf(F const & f, KeyRange const * first, KeyRange const * last,
       uint64_t const offset, uint64_t const size,
       uint64_t keyBase /* discarded part of object key value in the parent nodes*/) const
   {
-    buffer_vector<uint8_t, 1024> data;
-    data.resize_no_init(size);
-
-    m_Reader.Read(offset, &data[0], size);
-    ArrayByteSource src(&data[0]);
+    buffer_vector<uint8_t, 1024> buffer;
+    uint8_t const * data = GetData(offset, size, buffer);
+    ArrayByteSource src(data);
 
-    void const * pEnd = &data[0] + size;
+    void const * pEnd = data + size;
     Value value = 0;
     while (src.Ptr() < pEnd)
     {
       uint32_t key = 0;
       src.Read(&key, m_Header.m_LeafBytes);
       key = SwapIfBigEndianMacroBased(key);
-      if (key > end)
+      uint64_t const fullKey = keyBase + key;
+      while (first != last && first->second < fullKey)
+        ++first;
+      if (first == last)
         break;
       value += ReadVarInt<int64_t>(src);
-      if (key >= beg)
-        f(keyBase + key, value);
+      if (fullKey >= first->first)
+        f(fullKey, value);
     }
   }
 
   template <typename F>
-  void ForEachNode(F const & f, uint64_t beg, uint64_t end, int level,
+  void ForEachNode(F const & f, KeyRange const * first, KeyRange const * last, int level,
       uint64_t offset, uint64_t size,
       uint64_t keyBase /* discarded part of object key value in the parent nodes */) const
   {
@@ -120,23 +147,33 @@ private:
 
     if (level == 0)
     {
-      ForEachLeaf(f, beg, end, offset, size, keyBase);
+      ForEachLeaf(f, first, last, offset, size, keyBase);
       return;
     }
 
     uint8_t const skipBits = (m_Header.m_LeafBytes << 3) + (level - 1) * m_Header.m_BitsPerLevel;
-    ASSERT_LESS_OR_EQUAL(beg, end, (skipBits));
-
     uint64_t const levelBytesFF = (1ULL << skipBits) - 1;
-    uint32_t const beg0 = static_cast<uint32_t>(beg >> skipBits);
-    uint32_t const end0 = static_cast<uint32_t>(end >> skipBits);
-    ASSERT_LESS(end0, (1U << m_Header.m_BitsPerLevel), (beg, end, skipBits));
-
-    buffer_vector<uint8_t, 576> data;
-    data.resize_no_init(size);
 
-    m_Reader.Read(offset, &data[0], size);
-    ArrayByteSource src(&data[0]);
+    buffer_vector<uint8_t, 576> buffer;
+    uint8_t const * data = GetData(offset, size, buffer);
+    ArrayByteSource src(data);
+
+    // Walks down to the child |i| if it intersects the ranges,
+    // returns false when the rest of the children are after the ranges.
+    auto const forEachInChild = [&](uint32_t i, uint64_t childOffset, uint64_t childSize) {
+      uint64_t const childKeyBase = keyBase + (uint64_t{i} << skipBits);
+      while (first != last && first->second < childKeyBase)
+        ++first;
+      if (first == last)
+        return false;
+
+      auto childLast = first;
+      while (childLast != last && childLast->first <= childKeyBase + levelBytesFF)
+        ++childLast;
+      if (childLast != first)
+        ForEachNode(f, first, childLast, level - 1, childOffset, childSize, childKeyBase);
+      return true;
+    };
 
     uint64_t const offsetAndFlag = ReadVarUint<uint64_t>(src);
     uint64_t childOffset = offsetAndFlag >> 1;
@@ -145,45 +182,53 @@ private:
       // Reading bitmap.
       uint8_t const * pBitmap = static_cast<uint8_t const *>(src.Ptr());
       src.Advance(BitmapSize(m_Header.m_BitsPerLevel));
-      for (uint32_t i = 0; i <= end0; ++i)
+      uint32_t const childrenCount = 1U << m_Header.m_BitsPerLevel;
+      for (uint32_t i = 0; i < childrenCount; ++i)
       {
         if (bits::GetBit(pBitmap, i))
         {
           uint64_t childSize = ReadVarUint<uint64_t>(src);
-          if (i >= beg0)
-          {
-            uint64_t const beg1 = (i == beg0) ? (beg & levelBytesFF) : 0;
-            uint64_t const end1 = (i == end0) ? (end & levelBytesFF) : levelBytesFF;
-            ForEachNode(f, beg1, end1, level - 1, childOffset, childSize, keyBase + (uint64_t{i} << skipBits));
-          }
+          if (!forEachInChild(i, childOffset, childSize))
+            return;
           childOffset += childSize;
         }
       }
-      ASSERT(end0 != (static_cast<uint32_t>(1) << m_Header.m_BitsPerLevel) - 1 ||
-             static_cast<size_t>(static_cast<uint8_t const *>(src.Ptr()) - &data[0]) == size,
-             (beg, end, beg0, end0, offset, size, src.Ptr(), &data[0]));
+      ASSERT_EQUAL(static_cast<size_t>(static_cast<uint8_t const *>(src.Ptr()) - data), size,
+                   (offset, size));
     }
     else
     {
-      void const * pEnd = &data[0] + size;
+      void const * pEnd = data + size;
       while (src.Ptr() < pEnd)
       {
         uint8_t const i = src.ReadByte();
-        if (i > end0)
-          break;
         uint64_t childSize = ReadVarUint<uint64_t>(src);
-        if (i >= beg0)
-        {
-          uint64_t const beg1 = (i == beg0) ? (beg & levelBytesFF) : 0;
-          uint64_t const end1 = (i == end0) ? (end & levelBytesFF) : levelBytesFF;
-          ForEachNode(f, beg1, end1, level - 1, childOffset, childSize, keyBase + (uint64_t{i} << skipBits));
-        }
+        if (!forEachInChild(i, childOffset, childSize))
+          return;
         childOffset += childSize;
       }
     }
   }
 
+  // The data of the node at |offset|: the memory of the reader when the reader has direct data,
+  // a copy in |buffer| otherwise.
+  template <typename Buffer>
+  uint8_t const * GetData(uint64_t offset, uint64_t size, Buffer & buffer) const
+  {
+    if (m_Data)
+    {
+      ASSERT_LESS_OR_EQUAL(offset + size, m_Reader.Size(), (offset, size));
+      return m_Data + offset;
+    }
+
+    buffer.resize_no_init(size);
+    m_Reader.Read(offset, buffer.data(), size);
+    return buffer.data();
+  }
+
   ReaderT m_Reader;
+  // Direct data of |m_Reader| or nullptr.
+  uint8_t const * m_Data;
   Header m_Header;
   buffer_vector<uint64_t, 7> m_LevelOffsets;
 };
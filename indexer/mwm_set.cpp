@@ -1,6 +1,7 @@
 #include "indexer/mwm_set.hpp"
 #include "indexer/scales.hpp"
 
+#include "coding/mmap_reader.hpp"
 #include "coding/reader.hpp"
 
 #include "platform/local_country_file_utils.hpp"
@@ -8,10 +9,15 @@
 #include "base/assert.hpp"
 #include "base/logging.hpp"
 #include "base/stl_helpers.hpp"
+#include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
 
 #include <algorithm>
 #include <exception>
+#include <functional>
+#include <future>
 #include <sstream>
+#include <thread>
 
 
 using namespace std;
@@ -46,6 +52,18 @@ string DebugPrint(MwmSet::MwmId const & id)
   return ss.str();
 }
 
+// static
+size_t constexpr MwmSet::kDefaultCacheSize;
+// static
+size_t constexpr MwmSet::kConcurrentCacheStripes;
+
+MwmSet::MwmSet(size_t cacheSize, Concurrency concurrency)
+  : m_concurrency(concurrency)
+  , m_cache(concurrency == Concurrency::Concurrent ? kConcurrentCacheStripes : 1)
+  , m_stripeCacheSize((cacheSize + m_cache.size() - 1) / m_cache.size())
+{
+}
+
 MwmSet::MwmHandle::MwmHandle() : m_mwmSet(nullptr), m_value(nullptr) {}
 
 MwmSet::MwmHandle::MwmHandle(MwmSet & mwmSet, MwmId const & mwmId,
@@ -95,69 +113,114 @@ MwmSet::MwmId MwmSet::GetMwmIdByCountryFileImpl(CountryFile const & countryFile)
 pair<MwmSet::MwmId, MwmSet::RegResult> MwmSet::Register(LocalCountryFile const & localFile)
 {
   pair<MwmSet::MwmId, MwmSet::RegResult> result;
-  auto registerFile = [&](EventList & events)
+  WithEventLog([&](EventList & events) {
+    // CreateInfo() can throw an exception for a bad mwm file.
+    result = RegisterOrUpdateImpl(localFile, [&]() { return CreateInfo(localFile); }, events);
+  });
+  return result;
+}
+
+vector<pair<MwmSet::MwmId, MwmSet::RegResult>> MwmSet::Register(
+    vector<LocalCountryFile> const & localFiles, size_t threadsCount)
+{
+  vector<unique_ptr<MwmInfo>> infos(localFiles.size());
+  vector<bool> badFiles(localFiles.size(), false);
+  if (!localFiles.empty())
   {
-    CountryFile const & countryFile = localFile.GetCountryFile();
-    MwmId const id = GetMwmIdByCountryFileImpl(countryFile);
-    if (!id.IsAlive())
+    base::thread_pool::computational::ThreadPool threadPool(
+        max(min(threadsCount, localFiles.size()), size_t{1}));
+    vector<future<void>> futures;
+    futures.reserve(localFiles.size());
+    for (size_t i = 0; i < localFiles.size(); ++i)
     {
-      result = RegisterImpl(localFile, events);
-      return;
+      futures.push_back(threadPool.Submit([&, i]() {
+        try
+        {
+          infos[i] = CreateInfo(localFiles[i]);
+        }
+        catch (RootException const & ex)
+        {
+          LOG(LERROR, ("Bad mwm file:", localFiles[i], ex.Msg()));
+          badFiles[i] = true;
+        }
+      }));
     }
+    for (auto & f : futures)
+      f.get();
+  }
 
-    shared_ptr<MwmInfo> info = id.GetInfo();
-
-    // Deregister old mwm for the country.
-    if (info->GetVersion() < localFile.GetVersion())
+  vector<pair<MwmId, RegResult>> results(localFiles.size());
+  WithEventLog([&](EventList & events) {
+    for (size_t i = 0; i < localFiles.size(); ++i)
     {
-      EventList subEvents;
-      DeregisterImpl(id, subEvents);
-      result = RegisterImpl(localFile, subEvents);
-
-      // In the case of success all sub-events are
-      // replaced with a single UPDATE event. Otherwise,
-      // sub-events are reported as is.
-      if (result.second == MwmSet::RegResult::Success)
-        events.Add(Event(Event::TYPE_UPDATED, localFile, info->GetLocalFile()));
-      else
-        events.Append(subEvents);
-      return;
+      if (badFiles[i])
+      {
+        results[i] = make_pair(MwmId(), RegResult::BadFile);
+        continue;
+      }
+      results[i] =
+          RegisterOrUpdateImpl(localFiles[i], [&]() { return move(infos[i]); }, events);
     }
+  });
+  return results;
+}
 
-    string const name = countryFile.GetName();
-    // Update the status of the mwm with the same version.
-    if (info->GetVersion() == localFile.GetVersion())
-    {
-      LOG(LINFO, ("Updating already registered mwm:", name));
-      SetStatus(*info, MwmInfo::STATUS_REGISTERED, events);
-      info->m_file = localFile;
-      result = make_pair(id, RegResult::VersionAlreadyExists);
-      return;
-    }
+template <typename CreateInfoFn>
+pair<MwmSet::MwmId, MwmSet::RegResult> MwmSet::RegisterOrUpdateImpl(
+    LocalCountryFile const & localFile, CreateInfoFn && createInfo, EventList & events)
+{
+  CountryFile const & countryFile = localFile.GetCountryFile();
+  MwmId const id = GetMwmIdByCountryFileImpl(countryFile);
+  if (!id.IsAlive())
+    return RegisterImpl(localFile, createInfo(), events);
 
-    LOG(LWARNING, ("Trying to add too old (", localFile.GetVersion(), ") mwm (", name,
-                   "), current version:", info->GetVersion()));
-    result = make_pair(MwmId(), RegResult::VersionTooOld);
-    return;
-  };
+  shared_ptr<MwmInfo> info = id.GetInfo();
 
-  WithEventLog(registerFile);
-  return result;
+  // Deregister old mwm for the country.
+  if (info->GetVersion() < localFile.GetVersion())
+  {
+    EventList subEvents;
+    DeregisterImpl(id, subEvents);
+    auto const result = RegisterImpl(localFile, createInfo(), subEvents);
+
+    // In the case of success all sub-events are
+    // replaced with a single UPDATE event. Otherwise,
+    // sub-events are reported as is.
+    if (result.second == MwmSet::RegResult::Success)
+      events.Add(Event(Event::TYPE_UPDATED, localFile, info->GetLocalFile()));
+    else
+      events.Append(subEvents);
+    return result;
+  }
+
+  string const name = countryFile.GetName();
+  // Update the status of the mwm with the same version.
+  if (info->GetVersion() == localFile.GetVersion())
+  {
+    LOG(LINFO, ("Updating already registered mwm:", name));
+    SetStatus(*info, MwmInfo::STATUS_REGISTERED, events);
+    info->m_file = localFile;
+    return make_pair(id, RegResult::VersionAlreadyExists);
+  }
+
+  LOG(LWARNING, ("Trying to add too old (", localFile.GetVersion(), ") mwm (", name,
+                 "), current version:", info->GetVersion()));
+  return make_pair(MwmId(), RegResult::VersionTooOld);
 }
 
 pair<MwmSet::MwmId, MwmSet::RegResult> MwmSet::RegisterImpl(LocalCountryFile const & localFile,
+                                                            unique_ptr<MwmInfo> info,
                                                             EventList & events)
 {
-  // This function can throw an exception for a bad mwm file.
-  shared_ptr<MwmInfo> info(CreateInfo(localFile));
   if (!info)
     return make_pair(MwmId(), RegResult::UnsupportedFileFormat);
 
-  info->m_file = localFile;
-  SetStatus(*info, MwmInfo::STATUS_REGISTERED, events);
-  m_info[localFile.GetCountryName()].push_back(info);
+  shared_ptr<MwmInfo> sharedInfo(move(info));
+  sharedInfo->m_file = localFile;
+  SetStatus(*sharedInfo, MwmInfo::STATUS_REGISTERED, events);
+  m_info[localFile.GetCountryName()].push_back(sharedInfo);
 
-  return make_pair(MwmId(info), RegResult::Success);
+  return make_pair(MwmId(sharedInfo), RegResult::Success);
 }
 
 bool MwmSet::DeregisterImpl(MwmId const & id, EventList & events)
@@ -166,23 +229,18 @@ bool MwmSet::DeregisterImpl(MwmId const & id, EventList & events)
     return false;
 
   shared_ptr<MwmInfo> const & info = id.GetInfo();
+  // The mwm is marked before the references are checked, so a concurrent lock either
+  // is seen here or sees that the mwm is not registered.
+  SetStatus(*info, MwmInfo::STATUS_MARKED_TO_DEREGISTER, events);
   if (info->m_numRefs == 0)
   {
     SetStatus(*info, MwmInfo::STATUS_DEREGISTERED, events);
     vector<shared_ptr<MwmInfo>> & infos = m_info[info->GetCountryName()];
     infos.erase(remove(infos.begin(), infos.end(), info), infos.end());
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it)
-    {
-      if (it->first == id)
-      {
-        m_cache.erase(it);
-        break;
-      }
-    }
+    ClearCacheImpl(&id);
     return true;
   }
 
-  SetStatus(*info, MwmInfo::STATUS_MARKED_TO_DEREGISTER, events);
   return false;
 }
 
@@ -266,6 +324,9 @@ void MwmSet::ProcessEventList(EventList & events)
 unique_ptr<MwmSet::MwmValueBase> MwmSet::LockValue(MwmId const & id)
 {
   unique_ptr<MwmSet::MwmValueBase> result;
+  if (TryLockValueConcurrent(id, result))
+    return result;
+
   WithEventLog([&](EventList & events)
                {
                  result = LockValueImpl(id, events);
@@ -286,16 +347,8 @@ unique_ptr<MwmSet::MwmValueBase> MwmSet::LockValueImpl(MwmId const & id, EventLi
 
   ++info->m_numRefs;
 
-  // Search in cache.
-  for (auto it = m_cache.begin(); it != m_cache.end(); ++it)
-  {
-    if (it->first == id)
-    {
-      unique_ptr<MwmValueBase> result = move(it->second);
-      m_cache.erase(it);
-      return result;
-    }
-  }
+  if (auto result = TakeCachedValue(id))
+    return result;
 
   try
   {
@@ -317,8 +370,75 @@ unique_ptr<MwmSet::MwmValueBase> MwmSet::LockValueImpl(MwmId const & id, EventLi
   }
 }
 
+bool MwmSet::TryLockValueConcurrent(MwmId const & id, unique_ptr<MwmValueBase> & value)
+{
+  if (m_concurrency != Concurrency::Concurrent)
+    return false;
+
+  if (!id.IsAlive())
+  {
+    value = nullptr;
+    return true;
+  }
+
+  shared_ptr<MwmInfo> const & info = id.GetInfo();
+  ++info->m_numRefs;
+  if (info->IsRegistered())
+  {
+    value = TakeCachedValue(id);
+    if (value)
+      return true;
+
+    try
+    {
+      value = CreateValue(*info);
+      return true;
+    }
+    catch (exception const &)
+    {
+      // The failures are handled under the lock.
+    }
+  }
+
+  ReleaseRefConcurrent(id);
+  return false;
+}
+
+void MwmSet::ReleaseRefConcurrent(MwmId const & id)
+{
+  shared_ptr<MwmInfo> const & info = id.GetInfo();
+  ASSERT_GREATER(info->m_numRefs, 0, ());
+  if (--info->m_numRefs != 0 || info->GetStatus() != MwmInfo::STATUS_MARKED_TO_DEREGISTER)
+    return;
+
+  WithEventLog([&](EventList & events)
+               {
+                 if (info->m_numRefs == 0 &&
+                     info->GetStatus() == MwmInfo::STATUS_MARKED_TO_DEREGISTER)
+                 {
+                   VERIFY(DeregisterImpl(id, events), ());
+                 }
+               });
+}
+
 void MwmSet::UnlockValue(MwmId const & id, unique_ptr<MwmValueBase> p)
 {
+  if (m_concurrency == Concurrency::Concurrent)
+  {
+    ASSERT(id.IsAlive(), (id));
+    ASSERT(p.get() != nullptr, ());
+    if (!id.IsAlive() || !p)
+      return;
+
+    // The value is cached while the reference is held, so the deregistration,
+    // which waits for the references, drops it from the cache.
+    if (id.GetInfo()->IsUpToDate())
+      PutCachedValue(id, move(p));
+    p.reset();
+    ReleaseRefConcurrent(id);
+    return;
+  }
+
   WithEventLog([&](EventList & events)
                {
                  UnlockValueImpl(id, move(p), events);
@@ -342,27 +462,60 @@ void MwmSet::UnlockValueImpl(MwmId const & id, unique_ptr<MwmValueBase> p, Event
   {
     /// @todo Probably, it's better to store only "unique by id" free caches here.
     /// But it's no obvious if we have many threads working with the single mwm.
+    PutCachedValue(id, move(p));
+  }
+}
 
-    m_cache.push_back(make_pair(id, move(p)));
-    if (m_cache.size() > m_cacheSize)
+MwmSet::CacheStripe & MwmSet::GetCacheStripe()
+{
+  if (m_cache.size() == 1)
+    return m_cache.front();
+
+  // The threads take back the values they released, so the stripes are split by thread.
+  return m_cache[hash<thread::id>()(this_thread::get_id()) % m_cache.size()];
+}
+
+unique_ptr<MwmSet::MwmValueBase> MwmSet::TakeCachedValue(MwmId const & id)
+{
+  auto & stripe = GetCacheStripe();
+  lock_guard<mutex> lock(stripe.m_lock);
+  auto & values = stripe.m_values;
+  for (auto it = values.begin(); it != values.end(); ++it)
+  {
+    if (it->first == id)
     {
-      ASSERT_EQUAL(m_cache.size(), m_cacheSize + 1, ());
-      m_cache.pop_front();
+      unique_ptr<MwmValueBase> result = move(it->second);
+      values.erase(it);
+      return result;
     }
   }
+  return nullptr;
+}
+
+void MwmSet::PutCachedValue(MwmId const & id, unique_ptr<MwmValueBase> p)
+{
+  auto & stripe = GetCacheStripe();
+  lock_guard<mutex> lock(stripe.m_lock);
+  auto & values = stripe.m_values;
+  values.push_back(make_pair(id, move(p)));
+  if (values.size() > m_stripeCacheSize)
+  {
+    ASSERT_EQUAL(values.size(), m_stripeCacheSize + 1, ());
+    values.pop_front();
+  }
 }
 
 void MwmSet::Clear()
 {
   lock_guard<mutex> lock(m_lock);
-  ClearCacheImpl(m_cache.begin(), m_cache.end());
+  ClearCacheImpl(nullptr /* id */);
   m_info.clear();
 }
 
 void MwmSet::ClearCache()
 {
   lock_guard<mutex> lock(m_lock);
-  ClearCacheImpl(m_cache.begin(), m_cache.end());
+  ClearCacheImpl(nullptr /* id */);
 }
 
 MwmSet::MwmId MwmSet::GetMwmIdByCountryFile(CountryFile const & countryFile) const
@@ -383,6 +536,10 @@ MwmSet::MwmHandle MwmSet::GetMwmHandleByCountryFile(CountryFile const & countryF
 
 MwmSet::MwmHandle MwmSet::GetMwmHandleById(MwmId const & id)
 {
+  unique_ptr<MwmValueBase> value;
+  if (TryLockValueConcurrent(id, value))
+    return MwmHandle(*this, id, move(value));
+
   MwmSet::MwmHandle handle;
   WithEventLog([&](EventList & events)
                {
@@ -391,6 +548,30 @@ MwmSet::MwmHandle MwmSet::GetMwmHandleById(MwmId const & id)
   return handle;
 }
 
+vector<MwmSet::MwmHandle> MwmSet::GetMwmHandlesByIds(vector<MwmId> const & ids)
+{
+  vector<MwmHandle> handles(ids.size());
+  vector<size_t> lockedIds;
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    unique_ptr<MwmValueBase> value;
+    if (TryLockValueConcurrent(ids[i], value))
+      handles[i] = MwmHandle(*this, ids[i], move(value));
+    else
+      lockedIds.push_back(i);
+  }
+
+  if (lockedIds.empty())
+    return handles;
+
+  WithEventLog([&](EventList & events)
+               {
+                 for (auto const i : lockedIds)
+                   handles[i] = GetMwmHandleByIdImpl(ids[i], events);
+               });
+  return handles;
+}
+
 MwmSet::MwmHandle MwmSet::GetMwmHandleByIdImpl(MwmId const & id, EventList & events)
 {
   unique_ptr<MwmValueBase> value;
@@ -399,31 +580,97 @@ MwmSet::MwmHandle MwmSet::GetMwmHandleByIdImpl(MwmId const & id, EventList & eve
   return MwmHandle(*this, id, move(value));
 }
 
-void MwmSet::ClearCacheImpl(Cache::iterator beg, Cache::iterator end) { m_cache.erase(beg, end); }
-
-void MwmSet::ClearCache(MwmId const & id)
+void MwmSet::ClearCacheImpl(MwmId const * id)
 {
-  auto sameId = [&id](pair<MwmSet::MwmId, unique_ptr<MwmSet::MwmValueBase>> const & p)
+  auto sameId = [id](pair<MwmSet::MwmId, unique_ptr<MwmSet::MwmValueBase>> const & p)
   {
-    return (p.first == id);
+    return (p.first == *id);
   };
-  ClearCacheImpl(base::RemoveIfKeepValid(m_cache.begin(), m_cache.end(), sameId), m_cache.end());
+
+  for (auto & stripe : m_cache)
+  {
+    lock_guard<mutex> lock(stripe.m_lock);
+    auto & values = stripe.m_values;
+    if (id)
+      values.erase(base::RemoveIfKeepValid(values.begin(), values.end(), sameId), values.end());
+    else
+      values.clear();
+  }
 }
 
+void MwmSet::ClearCache(MwmId const & id) { ClearCacheImpl(&id); }
+
 // MwmValue ----------------------------------------------------------------------------------------
 
-MwmValue::MwmValue(LocalCountryFile const & localFile)
-  : m_cont(platform::GetCountryReader(localFile, MapOptions::Map)), m_file(localFile)
+namespace
+{
+// The indexes from this size are backed by the huge pages in the lookup mode.
+uint64_t constexpr kHugePagesMinSize = 2 * 1024 * 1024;
+
+bool IsFeaturesDataTag(string const & tag)
+{
+  return tag == DATA_FILE_TAG || tag == METADATA_FILE_TAG ||
+         strings::StartsWith(tag, GEOMETRY_FILE_TAG) || strings::StartsWith(tag, TRIANGLE_FILE_TAG);
+}
+
+void AdviseSections(FilesContainerR const & cont, MwmReadMode readMode)
+{
+  cont.ForEachTag([&cont, readMode](FilesContainerBase::Tag const & tag) {
+    auto const reader = cont.GetReader(tag);
+    auto const * mmapReader = dynamic_cast<MmapReader const *>(reader.GetPtr());
+    CHECK(mmapReader, (tag));
+
+    // The small sections which are read first.
+    if (tag == HEADER_FILE_TAG || tag == VERSION_FILE_TAG || tag == FEATURE_OFFSETS_FILE_TAG ||
+        tag == METADATA_INDEX_FILE_TAG)
+    {
+      mmapReader->Advise(MmapReader::Advice::WillNeed);
+      return;
+    }
+
+    bool const isFeaturesData = IsFeaturesDataTag(tag);
+    switch (readMode)
+    {
+    case MwmReadMode::Cached: break;
+    case MwmReadMode::MappedScan:
+      if (isFeaturesData)
+        mmapReader->Advise(MmapReader::Advice::Sequential);
+      break;
+    case MwmReadMode::MappedLookup:
+      mmapReader->Advise(MmapReader::Advice::Random,
+                         !isFeaturesData && reader.Size() >= kHugePagesMinSize /* hugePages */);
+      break;
+    }
+  });
+}
+
+FilesContainerR OpenContainer(LocalCountryFile const & localFile, MwmReadMode readMode)
+{
+  auto reader = platform::GetCountryReader(localFile, MapOptions::Map);
+  if (readMode == MwmReadMode::Cached)
+    return FilesContainerR(move(reader));
+
+  FilesContainerR cont(make_unique<MmapReader>(reader->GetName()));
+  AdviseSections(cont, readMode);
+  return cont;
+}
+}  // namespace
+
+MwmValue::MwmValue(LocalCountryFile const & localFile, MwmReadMode readMode)
+  : m_cont(OpenContainer(localFile, readMode)), m_file(localFile)
 {
   m_factory.Load(m_cont);
 }
 
 void MwmValue::SetTable(MwmInfoEx & info)
 {
+  m_info = &info;
+
   auto const version = GetHeader().GetFormat();
   if (version < version::Format::v5)
     return;
 
+  lock_guard<mutex> lock(info.m_tableLock);
   m_table = info.m_table.lock();
   if (!m_table)
   {
@@ -435,6 +682,17 @@ void MwmValue::SetTable(MwmInfoEx & info)
   }
 }
 
+string DebugPrint(MwmReadMode mode)
+{
+  switch (mode)
+  {
+  case MwmReadMode::Cached: return "Cached";
+  case MwmReadMode::MappedScan: return "MappedScan";
+  case MwmReadMode::MappedLookup: return "MappedLookup";
+  }
+  UNREACHABLE();
+}
+
 string DebugPrint(MwmSet::RegResult result)
 {
   switch (result)
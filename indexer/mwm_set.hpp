@@ -6,6 +6,7 @@
 
 #include "geometry/rect2d.hpp"
 
+#include "base/assert.hpp"
 #include "base/macros.hpp"
 
 #include "indexer/data_factory.hpp"
@@ -84,7 +85,7 @@ protected:
 
   platform::LocalCountryFile m_file;  ///< Path to the mwm file.
   std::atomic<Status> m_status;       ///< Current country status.
-  uint32_t m_numRefs;                 ///< Number of active handles.
+  std::atomic<uint32_t> m_numRefs;    ///< Number of active handles.
 };
 
 class MwmInfoEx : public MwmInfo
@@ -98,10 +99,13 @@ private:
   // MwmSet's cache. We can't use shared_ptr because of offsets table
   // must be removed as soon as the last corresponding MwmValue is
   // destroyed. Also, note that this value must be used and modified
-  // only in MwmValue::SetTable() method, which, in turn, is called
-  // only in the MwmSet critical section, protected by a lock.  So,
-  // there's an implicit synchronization on this field.
+  // only in MwmValue::SetTable() method under |m_tableLock|, because
+  // the values of the concurrent MwmSet are created without the MwmSet lock.
   std::weak_ptr<feature::FeaturesOffsetsTable> m_table;
+  // The side tables shared by the MwmValue-s by their names, see MwmValue::GetSideTable().
+  // Are guarded by |m_tableLock| as |m_table| is.
+  std::map<std::string, std::weak_ptr<void const>> m_sideTables;
+  std::mutex m_tableLock;
 };
 
 class MwmSet
@@ -132,8 +136,22 @@ public:
     std::shared_ptr<MwmInfo> m_info;
   };
 
+  // In the serial mode all the handles are acquired and released under the single lock.
+  // In the concurrent mode the handles of the registered mwms are acquired and released
+  // without it: the references are counted atomically and the free values are cached
+  // in the stripes of the threads, which are locked separately. Only the registration changes
+  // and the handles of the mwms which are being deregistered take the lock.
+  enum class Concurrency
+  {
+    Serial,
+    Concurrent
+  };
+
+  static size_t constexpr kDefaultCacheSize = 64;
+
 public:
-  explicit MwmSet(size_t cacheSize = 64) : m_cacheSize(cacheSize) {}
+  explicit MwmSet(size_t cacheSize = kDefaultCacheSize,
+                  Concurrency concurrency = Concurrency::Serial);
   virtual ~MwmSet() = default;
 
   class MwmValueBase
@@ -270,13 +288,32 @@ public:
   /// are older than the localFile (in this case mwm handle will point
   /// to just-registered file).
 protected:
+  /// Registers |localFile| with |info| made by CreateInfo().
   std::pair<MwmId, RegResult> RegisterImpl(platform::LocalCountryFile const & localFile,
-                                           EventList & events);
+                                           std::unique_ptr<MwmInfo> info, EventList & events);
 
 public:
   std::pair<MwmId, RegResult> Register(platform::LocalCountryFile const & localFile);
+
+  /// Registers the maps as Register() does for each of them. The infos of the maps are created
+  /// by |threadsCount| threads without the lock, as the files are opened and their headers
+  /// are read, and then all the maps are registered under the lock at once.
+  /// The maps which can't be read get RegResult::BadFile instead of an exception.
+  ///
+  /// \return The results in the order of |localFiles|.
+  std::vector<std::pair<MwmId, RegResult>> Register(
+      std::vector<platform::LocalCountryFile> const & localFiles, size_t threadsCount);
   //@}
 
+private:
+  /// Does the work of Register() under the lock. |createInfo| is called when the map has to be
+  /// registered.
+  template <typename CreateInfoFn>
+  std::pair<MwmId, RegResult> RegisterOrUpdateImpl(platform::LocalCountryFile const & localFile,
+                                                   CreateInfoFn && createInfo, EventList & events);
+
+public:
+
   /// @name Remove mwm.
   //@{
 protected:
@@ -324,12 +361,28 @@ public:
     return const_cast<MwmSet *>(this)->GetMwmHandleById(id);
   }
 
+  // Returns the handles of |ids| in the same order. The handles which need the lock
+  // are acquired under it at once.
+  std::vector<MwmHandle> GetMwmHandlesByIds(std::vector<MwmId> const & ids);
+
+  std::vector<MwmHandle> GetMwmHandlesByIds(std::vector<MwmId> const & ids) const
+  {
+    return const_cast<MwmSet *>(this)->GetMwmHandlesByIds(ids);
+  }
+
 protected:
   virtual std::unique_ptr<MwmInfo> CreateInfo(platform::LocalCountryFile const & localFile) const = 0;
   virtual std::unique_ptr<MwmValueBase> CreateValue(MwmInfo & info) const = 0;
 
 private:
-  using Cache = std::deque<std::pair<MwmId, std::unique_ptr<MwmValueBase>>>;
+  // Free values in the order of their release.
+  struct CacheStripe
+  {
+    std::mutex m_lock;
+    std::deque<std::pair<MwmId, std::unique_ptr<MwmValueBase>>> m_values;
+  };
+
+  static size_t constexpr kConcurrentCacheStripes = 16;
 
   // This is the only valid way to take |m_lock| and use *Impl()
   // functions. The reason is that event processing requires
@@ -363,12 +416,23 @@ private:
   void UnlockValue(MwmId const & id, std::unique_ptr<MwmValueBase> p);
   void UnlockValueImpl(MwmId const & id, std::unique_ptr<MwmValueBase> p, EventList & events);
 
-  /// Do the cleaning for [beg, end) without acquiring the mutex.
-  /// @precondition This function is always called under mutex m_lock.
-  void ClearCacheImpl(Cache::iterator beg, Cache::iterator end);
+  // Locks the value of |id| without |m_lock| in the concurrent mode. Returns false when
+  // the value must be locked under |m_lock|.
+  bool TryLockValueConcurrent(MwmId const & id, std::unique_ptr<MwmValueBase> & value);
+  // Drops the reference to |id| taken without |m_lock| and deregisters the mwm
+  // if it was the last reference to the mwm marked to deregister.
+  void ReleaseRefConcurrent(MwmId const & id);
+
+  CacheStripe & GetCacheStripe();
+  std::unique_ptr<MwmValueBase> TakeCachedValue(MwmId const & id);
+  void PutCachedValue(MwmId const & id, std::unique_ptr<MwmValueBase> p);
+
+  /// Do the cleaning of all the values or of the values of |id| when it is not null.
+  void ClearCacheImpl(MwmId const * id);
 
-  Cache m_cache;
-  size_t const m_cacheSize;
+  Concurrency const m_concurrency;
+  std::vector<CacheStripe> m_cache;
+  size_t const m_stripeCacheSize;
 
 protected:
   /// @precondition This function is always called under mutex m_lock.
@@ -386,6 +450,21 @@ private:
   base::ObserverListSafe<Observer> m_observers;
 }; // class MwmSet
 
+// How the values read their mwm files.
+enum class MwmReadMode
+{
+  // The sections are read by FileReader through its page cache.
+  Cached,
+  // The files are mapped. The features and their geometry are advised for the sequential
+  // access of the scans.
+  MappedScan,
+  // The files are mapped. All the sections are advised for the random access of the lookups,
+  // the large indexes may be backed by the huge pages.
+  MappedLookup
+};
+
+std::string DebugPrint(MwmReadMode mode);
+
 class MwmValue : public MwmSet::MwmValueBase
 {
 public:
@@ -395,9 +474,30 @@ public:
 
   std::shared_ptr<feature::FeaturesOffsetsTable> m_table;
 
-  explicit MwmValue(platform::LocalCountryFile const & localFile);
+  explicit MwmValue(platform::LocalCountryFile const & localFile,
+                    MwmReadMode readMode = MwmReadMode::Cached);
   void SetTable(MwmInfoEx & info);
 
+  // Returns the table named |name| which is shared by all the values of the mwm. The table
+  // is loaded by |load| if no one holds it now, and it is freed when the last holder
+  // releases it. |load| returns std::unique_ptr<Table const>, the tables which are not
+  // loaded are not shared. A name must be used for the tables of the same type only.
+  template <typename Table, typename Load>
+  std::shared_ptr<Table const> GetSideTable(std::string const & name, Load && load)
+  {
+    CHECK(m_info, ("SetTable() must be called before."));
+
+    std::lock_guard<std::mutex> lock(m_info->m_tableLock);
+    auto & sideTable = m_info->m_sideTables[name];
+    auto table = std::static_pointer_cast<Table const>(sideTable.lock());
+    if (!table)
+    {
+      table = load();
+      sideTable = table;
+    }
+    return table;
+  }
+
   feature::DataHeader const & GetHeader() const  { return m_factory.GetHeader(); }
   feature::RegionData const & GetRegionData() const { return m_factory.GetRegionData(); }
   version::MwmVersion const & GetMwmVersion() const { return m_factory.GetMwmVersion(); }
@@ -405,6 +505,10 @@ public:
 
   bool HasSearchIndex() { return m_cont.IsExist(SEARCH_INDEX_FILE_TAG); }
   bool HasGeometryIndex() { return m_cont.IsExist(INDEX_FILE_TAG); }
+
+private:
+  // The info outlives the value: the values are cached and handled with the ids of their mwms.
+  MwmInfoEx * m_info = nullptr;
 }; // class MwmValue
 
 
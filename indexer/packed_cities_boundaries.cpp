@@ -0,0 +1,294 @@
+#include "indexer/packed_cities_boundaries.hpp"
+
+#include "base/assert.hpp"
+#include "base/checked_cast.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+namespace indexer
+{
+namespace
+{
+// The entries of a cell are tested by the blocks of this size.
+size_t constexpr kBlockSize = 64;
+// The limit of the cells of a side of the grid.
+size_t constexpr kMaxGridSize = 1024;
+}  // namespace
+
+// static
+uint32_t constexpr PackedCitiesBoundaries::kNoCell;
+
+void PackedCitiesBoundaries::Add(uint32_t city, CityBoundary const & boundary)
+{
+  m_cities.push_back(city);
+  m_boundaries.push_back(boundary);
+  m_built = false;
+}
+
+void PackedCitiesBoundaries::Build() { BuildWithEps(0.0, 0.0, m2::CalipersBox::kEps); }
+
+void PackedCitiesBoundaries::Build(double eps) { BuildWithEps(eps, 2 * eps, eps); }
+
+bool PackedCitiesBoundaries::HasPoint(uint32_t city, m2::PointD const & p) const
+{
+  auto const cell = GetCell(p);
+  if (cell == kNoCell)
+    return false;
+
+  bool has = false;
+  ForEachBoundaryWithPoint(cell, p, [&](uint32_t boundary) {
+    has = has || m_cities[boundary] == city;
+  });
+  return has;
+}
+
+void PackedCitiesBoundaries::GetCitiesWithPoint(m2::PointD const & p,
+                                                vector<uint32_t> & cities) const
+{
+  cities.clear();
+  auto const cell = GetCell(p);
+  if (cell == kNoCell)
+    return;
+
+  // The boundaries of a cell are sorted by the cities.
+  ForEachBoundaryWithPoint(cell, p, [&](uint32_t boundary) {
+    if (cities.empty() || cities.back() != m_cities[boundary])
+      cities.push_back(m_cities[boundary]);
+  });
+}
+
+void PackedCitiesBoundaries::GetCitiesWithPoints(vector<m2::PointD> const & points,
+                                                 vector<vector<uint32_t>> & cities) const
+{
+  cities.assign(points.size(), {});
+
+  vector<uint32_t> cells(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+    cells[i] = GetCell(points[i]);
+
+  vector<size_t> order;
+  order.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    if (cells[i] != kNoCell)
+      order.push_back(i);
+  }
+  sort(order.begin(), order.end(), [&cells](size_t lhs, size_t rhs) {
+    return cells[lhs] < cells[rhs];
+  });
+
+  for (auto const i : order)
+  {
+    auto & pointCities = cities[i];
+    ForEachBoundaryWithPoint(cells[i], points[i], [&](uint32_t boundary) {
+      if (pointCities.empty() || pointCities.back() != m_cities[boundary])
+        pointCities.push_back(m_cities[boundary]);
+    });
+  }
+}
+
+void PackedCitiesBoundaries::Clear()
+{
+  m_cities.clear();
+  m_boundaries.clear();
+  m_cellBegins.clear();
+  ResizeEntries(0);
+  m_gridSize = 0;
+  m_built = false;
+}
+
+void PackedCitiesBoundaries::BuildWithEps(double bboxEps, double dboxEps, double cboxEps)
+{
+  vector<size_t> order(m_boundaries.size());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(),
+              [this](size_t lhs, size_t rhs) { return m_cities[lhs] < m_cities[rhs]; });
+
+  vector<uint32_t> cities;
+  vector<CityBoundary> boundaries;
+  cities.reserve(order.size());
+  boundaries.reserve(order.size());
+  for (auto const i : order)
+  {
+    cities.push_back(m_cities[i]);
+    boundaries.push_back(move(m_boundaries[i]));
+  }
+  m_cities = move(cities);
+  m_boundaries = move(boundaries);
+  m_cboxEps = cboxEps;
+
+  // The boxes are extended once instead of every test, the sums are the ones of
+  // BoundingBox::HasPoint(x, y, eps).
+  auto const count = m_boundaries.size();
+  vector<double> minX(count), minY(count), maxX(count), maxY(count);
+  vector<double> minU(count), minV(count), maxU(count), maxV(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto const & bbox = m_boundaries[i].m_bbox;
+    minX[i] = bbox.Min().x - bboxEps;
+    minY[i] = bbox.Min().y - bboxEps;
+    maxX[i] = bbox.Max().x + bboxEps;
+    maxY[i] = bbox.Max().y + bboxEps;
+
+    auto const & dbox = m_boundaries[i].m_dbox.GetRotatedBox();
+    minU[i] = dbox.Min().x - dboxEps;
+    minV[i] = dbox.Min().y - dboxEps;
+    maxU[i] = dbox.Max().x + dboxEps;
+    maxV[i] = dbox.Max().y + dboxEps;
+  }
+
+  m_gridSize = 0;
+  m_gridMinX = m_gridMinY = numeric_limits<double>::max();
+  m_gridMaxX = m_gridMaxY = numeric_limits<double>::lowest();
+  size_t nonEmptyCount = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // A boundary of an empty box has no points.
+    if (!(minX[i] <= maxX[i] && minY[i] <= maxY[i]))
+      continue;
+
+    ++nonEmptyCount;
+    m_gridMinX = min(m_gridMinX, minX[i]);
+    m_gridMinY = min(m_gridMinY, minY[i]);
+    m_gridMaxX = max(m_gridMaxX, maxX[i]);
+    m_gridMaxY = max(m_gridMaxY, maxY[i]);
+  }
+
+  m_cellBegins.clear();
+  ResizeEntries(0);
+  if (nonEmptyCount != 0)
+  {
+    m_gridSize = static_cast<size_t>(ceil(sqrt(static_cast<double>(nonEmptyCount))));
+    m_gridSize = min(max(m_gridSize, size_t{1}), kMaxGridSize);
+    auto const width = m_gridMaxX - m_gridMinX;
+    auto const height = m_gridMaxY - m_gridMinY;
+    m_scaleX = width > 0.0 ? m_gridSize / width : 0.0;
+    m_scaleY = height > 0.0 ? m_gridSize / height : 0.0;
+
+    // The cells are filled by the counting sort, the entries of a cell are in the boundaries
+    // order.
+    auto const forEachCell = [&](size_t i, auto && fn) {
+      if (!(minX[i] <= maxX[i] && minY[i] <= maxY[i]))
+        return;
+
+      auto const beginX = GetCellCoord(minX[i], m_gridMinX, m_scaleX);
+      auto const endX = GetCellCoord(maxX[i], m_gridMinX, m_scaleX);
+      auto const beginY = GetCellCoord(minY[i], m_gridMinY, m_scaleY);
+      auto const endY = GetCellCoord(maxY[i], m_gridMinY, m_scaleY);
+      for (auto y = beginY; y <= endY; ++y)
+      {
+        for (auto x = beginX; x <= endX; ++x)
+          fn(y * m_gridSize + x);
+      }
+    };
+
+    m_cellBegins.assign(m_gridSize * m_gridSize + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+      forEachCell(i, [&](size_t cell) { ++m_cellBegins[cell + 1]; });
+    partial_sum(m_cellBegins.begin(), m_cellBegins.end(), m_cellBegins.begin());
+
+    ResizeEntries(m_cellBegins.back());
+    vector<uint32_t> next(m_cellBegins.begin(), m_cellBegins.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+    {
+      forEachCell(i, [&](size_t cell) {
+        auto const entry = next[cell]++;
+        m_entryBoundaries[entry] = base::checked_cast<uint32_t>(i);
+        m_minX[entry] = minX[i];
+        m_minY[entry] = minY[i];
+        m_maxX[entry] = maxX[i];
+        m_maxY[entry] = maxY[i];
+        m_minU[entry] = minU[i];
+        m_minV[entry] = minV[i];
+        m_maxU[entry] = maxU[i];
+        m_maxV[entry] = maxV[i];
+      });
+    }
+  }
+
+  m_built = true;
+}
+
+void PackedCitiesBoundaries::ResizeEntries(size_t count)
+{
+  m_entryBoundaries.resize(count);
+  m_minX.resize(count);
+  m_minY.resize(count);
+  m_maxX.resize(count);
+  m_maxY.resize(count);
+  m_minU.resize(count);
+  m_minV.resize(count);
+  m_maxU.resize(count);
+  m_maxV.resize(count);
+}
+
+uint32_t PackedCitiesBoundaries::GetCell(m2::PointD const & p) const
+{
+  ASSERT(m_built || m_boundaries.empty(), ("Build() should be called before the queries."));
+  if (m_gridSize == 0 || !(p.x >= m_gridMinX && p.x <= m_gridMaxX && p.y >= m_gridMinY &&
+                           p.y <= m_gridMaxY))
+  {
+    return kNoCell;
+  }
+
+  auto const x = GetCellCoord(p.x, m_gridMinX, m_scaleX);
+  auto const y = GetCellCoord(p.y, m_gridMinY, m_scaleY);
+  return static_cast<uint32_t>(y * m_gridSize + x);
+}
+
+// The coord is monotonous, so a point of a box is in a cell of the box.
+size_t PackedCitiesBoundaries::GetCellCoord(double c, double min, double scale) const
+{
+  auto const coord = static_cast<size_t>(max((c - min) * scale, 0.0));
+  return std::min(coord, m_gridSize - 1);
+}
+
+template <typename Fn>
+void PackedCitiesBoundaries::ForEachBoundaryWithPoint(uint32_t cell, m2::PointD const & p,
+                                                      Fn && fn) const
+{
+  double const x = p.x;
+  double const y = p.y;
+  // The coordinates of DiamondBox.
+  double const u = x + y;
+  double const v = x - y;
+
+  auto const begin = m_cellBegins[cell];
+  auto const end = m_cellBegins[cell + 1];
+  for (auto blockBegin = begin; blockBegin < end; blockBegin += kBlockSize)
+  {
+    auto const blockSize = min(static_cast<size_t>(end - blockBegin), kBlockSize);
+
+    // The same tests as in BoundingBox and DiamondBox, without the branches.
+    bool has[kBlockSize];
+    double const * minX = &m_minX[blockBegin];
+    double const * minY = &m_minY[blockBegin];
+    double const * maxX = &m_maxX[blockBegin];
+    double const * maxY = &m_maxY[blockBegin];
+    double const * minU = &m_minU[blockBegin];
+    double const * minV = &m_minV[blockBegin];
+    double const * maxU = &m_maxU[blockBegin];
+    double const * maxV = &m_maxV[blockBegin];
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+      has[i] = (x >= minX[i]) & (x <= maxX[i]) & (y >= minY[i]) & (y <= maxY[i]) &
+               (u >= minU[i]) & (u <= maxU[i]) & (v >= minV[i]) & (v <= maxV[i]);
+    }
+
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+      if (!has[i])
+        continue;
+
+      auto const boundary = m_entryBoundaries[blockBegin + i];
+      if (m_boundaries[boundary].m_cbox.HasPoint(p, m_cboxEps))
+        fn(boundary);
+    }
+  }
+}
+}  // namespace indexer
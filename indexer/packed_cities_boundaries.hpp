@@ -0,0 +1,86 @@
+#pragma once
+
+#include "indexer/city_boundary.hpp"
+
+#include "geometry/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace indexer
+{
+// The boundaries of many cities packed for the containment tests of many points. A city has
+// several boundaries and has a point when one of them has it, see CityBoundary::HasPoint().
+// The boundaries are registered in the cells of a uniform grid by their bounding boxes. A cell
+// keeps the bounding and the diamond boxes of its boundaries as the separate arrays of the
+// coordinates, so a point is tested against the boxes of its cell by a branchless loop which the
+// compiler vectorizes. Only the boundaries which pass both boxes are tested by the calipers box.
+class PackedCitiesBoundaries
+{
+public:
+  // Adds a boundary of |city|. Build() should be called after the last Add() before the queries.
+  void Add(uint32_t city, CityBoundary const & boundary);
+
+  // Packs the boundaries for the tests of CityBoundary::HasPoint(p).
+  void Build();
+  // Packs the boundaries for the tests of CityBoundary::HasPoint(p, eps).
+  void Build(double eps);
+
+  bool HasPoint(uint32_t city, m2::PointD const & p) const;
+
+  // Returns the sorted cities which have |p|.
+  void GetCitiesWithPoint(m2::PointD const & p, std::vector<uint32_t> & cities) const;
+  // |cities[i]| are the sorted cities which have |points[i]|. The points are tested by the cells,
+  // so the boxes of a cell are loaded once for all its points.
+  void GetCitiesWithPoints(std::vector<m2::PointD> const & points,
+                           std::vector<std::vector<uint32_t>> & cities) const;
+
+  size_t GetBoundariesCount() const { return m_boundaries.size(); }
+  bool IsEmpty() const { return m_boundaries.empty(); }
+
+  void Clear();
+
+private:
+  static uint32_t constexpr kNoCell = std::numeric_limits<uint32_t>::max();
+
+  void BuildWithEps(double bboxEps, double dboxEps, double cboxEps);
+  void ResizeEntries(size_t count);
+
+  uint32_t GetCell(m2::PointD const & p) const;
+  size_t GetCellCoord(double c, double min, double scale) const;
+
+  // Calls |fn(boundary)| for the boundaries of |cell| which have |p|, by the boundaries order.
+  template <typename Fn>
+  void ForEachBoundaryWithPoint(uint32_t cell, m2::PointD const & p, Fn && fn) const;
+
+  // The boundaries sorted by the cities.
+  std::vector<uint32_t> m_cities;
+  std::vector<CityBoundary> m_boundaries;
+  double m_cboxEps = m2::CalipersBox::kEps;
+  bool m_built = false;
+
+  size_t m_gridSize = 0;
+  double m_gridMinX = 0.0;
+  double m_gridMinY = 0.0;
+  double m_gridMaxX = 0.0;
+  double m_gridMaxY = 0.0;
+  double m_scaleX = 0.0;
+  double m_scaleY = 0.0;
+  // The entries of the cell |i| are [m_cellBegins[i], m_cellBegins[i + 1]).
+  std::vector<uint32_t> m_cellBegins;
+
+  // The entries of the cells: the boundaries and their boxes extended by the eps of the tests.
+  // The diamond boxes are in the coordinates (x + y, x - y).
+  std::vector<uint32_t> m_entryBoundaries;
+  std::vector<double> m_minX;
+  std::vector<double> m_minY;
+  std::vector<double> m_maxX;
+  std::vector<double> m_maxY;
+  std::vector<double> m_minU;
+  std::vector<double> m_minV;
+  std::vector<double> m_maxU;
+  std::vector<double> m_maxV;
+};
+}  // namespace indexer
@@ -0,0 +1,656 @@
+#include "indexer/cell_id.hpp"
+#include "indexer/interval_index.hpp"
+#include "indexer/interval_index_builder.hpp"
+
+#include "coding/byte_stream.hpp"
+#include "coding/compressed_bit_vector.hpp"
+#include "coding/geometry_coding.hpp"
+#include "coding/huffman.hpp"
+#include "coding/reader.hpp"
+#include "coding/string_utf8_multilang.hpp"
+#include "coding/varint.hpp"
+#include "coding/writer.hpp"
+
+#include "geometry/mercator.hpp"
+#include "geometry/parametrized_segment.hpp"
+#include "geometry/point2d.hpp"
+#include "geometry/region2d.hpp"
+#include "geometry/simplification.hpp"
+
+#include "base/stl_helpers.hpp"
+#include "base/string_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "3party/jansson/myjansson.hpp"
+
+using namespace std;
+
+namespace po = boost::program_options;
+
+namespace
+{
+struct BenchmarkOptions
+{
+  string m_filter;
+  double m_minTimeSeconds = 0.5;
+  uint32_t m_seed = 1;
+  bool m_json = false;
+};
+
+// Runs one operation of a benchmark and returns the number of items it has processed.
+using Operation = function<size_t()>;
+
+struct Benchmark
+{
+  string m_name;
+  // Builds the inputs of the benchmark by |rng| out of the timed loop.
+  function<Operation(mt19937 & rng)> m_prepare;
+};
+
+struct BenchmarkResult
+{
+  string m_name;
+  uint64_t m_iterations = 0;
+  double m_nsPerOp = 0.0;
+  double m_itemsPerSecond = 0.0;
+};
+
+// Keeps the compiler from dropping the computation of |value| as unused.
+template <typename T>
+void DoNotOptimize(T const & value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+BenchmarkResult Run(string const & name, Operation const & operation, double minTimeSeconds)
+{
+  uint64_t const kMaxIterations = 1000000000;
+
+  uint64_t iterations = 1;
+  while (true)
+  {
+    size_t items = 0;
+    auto const start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+      items += operation();
+    double const seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (seconds >= minTimeSeconds || iterations >= kMaxIterations)
+    {
+      BenchmarkResult result;
+      result.m_name = name;
+      result.m_iterations = iterations;
+      result.m_nsPerOp = seconds * 1e9 / iterations;
+      result.m_itemsPerSecond = seconds > 0 ? items / seconds : 0.0;
+      return result;
+    }
+
+    // Predicts the iterations for the min time with a margin, but grows them at most tenfold
+    // since the short runs are noisy.
+    double const multiplier =
+        seconds > 0 ? min(10.0, max(2.0, 1.4 * minTimeSeconds / seconds)) : 10.0;
+    iterations = min(kMaxIterations, static_cast<uint64_t>(iterations * multiplier));
+  }
+}
+
+// Inputs ------------------------------------------------------------------------------------------
+// A random walk with the steps of about |step| inside the mercator bounds.
+vector<m2::PointD> MakePolyline(mt19937 & rng, size_t count, double step)
+{
+  uniform_real_distribution<double> start(-170.0, 170.0);
+  normal_distribution<double> delta(0.0, step);
+
+  vector<m2::PointD> points;
+  points.reserve(count);
+  m2::PointD pt(start(rng), start(rng));
+  for (size_t i = 0; i < count; ++i)
+  {
+    pt.x = MercatorBounds::ClampX(pt.x + delta(rng));
+    pt.y = MercatorBounds::ClampY(pt.y + delta(rng));
+    points.push_back(pt);
+  }
+  return points;
+}
+
+vector<uint64_t> MakeBitPositions(mt19937 & rng, uint64_t maxPosition, double density)
+{
+  bernoulli_distribution isSet(density);
+  vector<uint64_t> positions;
+  for (uint64_t i = 0; i < maxPosition; ++i)
+  {
+    if (isSet(rng))
+      positions.push_back(i);
+  }
+  return positions;
+}
+
+// The letters of the strings follow a skewed distribution, as in the real texts.
+string MakeString(mt19937 & rng, size_t minLength, size_t maxLength)
+{
+  uniform_int_distribution<size_t> length(minLength, maxLength);
+  geometric_distribution<int> letter(0.2);
+
+  string s(length(rng), ' ');
+  for (auto & c : s)
+    c = static_cast<char>('a' + letter(rng) % 26);
+  return s;
+}
+
+struct CellValue
+{
+  using ValueType = uint32_t;
+
+  uint64_t GetCell() const { return m_cell; }
+  uint32_t GetValue() const { return m_value; }
+
+  uint64_t m_cell;
+  uint32_t m_value;
+};
+
+// Benchmarks --------------------------------------------------------------------------------------
+size_t const kVarintsCount = 1024;
+size_t const kPolylinePointsCount = 1000;
+size_t const kStripPointsCount = 300;
+uint64_t const kBitVectorSize = 1 << 20;
+size_t const kHuffmanStringsCount = 1000;
+size_t const kPointsCount = 1024;
+size_t const kSimplifiedPointsCount = 10000;
+size_t const kRegionVerticesCount = 1000;
+size_t const kIndexedCellsCount = 1 << 16;
+size_t const kIntervalQueriesCount = 256;
+
+vector<uint64_t> MakeVarints(mt19937 & rng)
+{
+  uniform_int_distribution<uint64_t> value;
+  uniform_int_distribution<int> shift(0, 63);
+  vector<uint64_t> values(kVarintsCount);
+  for (auto & v : values)
+    v = value(rng) >> shift(rng);
+  return values;
+}
+
+Operation PrepareVarintEncode(mt19937 & rng)
+{
+  return [values = MakeVarints(rng), buffer = vector<uint8_t>()]() mutable {
+    buffer.clear();
+    PushBackByteSink<vector<uint8_t>> sink(buffer);
+    for (auto const v : values)
+      WriteVarUint(sink, v);
+    DoNotOptimize(buffer.data());
+    return values.size();
+  };
+}
+
+Operation PrepareVarintDecode(mt19937 & rng)
+{
+  vector<uint8_t> buffer;
+  PushBackByteSink<vector<uint8_t>> sink(buffer);
+  for (auto const v : MakeVarints(rng))
+    WriteVarUint(sink, v);
+
+  return [buffer = move(buffer)]() {
+    ArrayByteSource src(buffer.data());
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kVarintsCount; ++i)
+      sum += ReadVarUint<uint64_t>(src);
+    DoNotOptimize(sum);
+    return kVarintsCount;
+  };
+}
+
+Operation PrepareSaveOuterPath(mt19937 & rng)
+{
+  return [points = MakePolyline(rng, kPolylinePointsCount, 1e-3),
+          buffer = vector<char>()]() mutable {
+    buffer.clear();
+    PushBackByteSink<vector<char>> sink(buffer);
+    serial::SaveOuterPath(points, serial::GeometryCodingParams(), sink);
+    DoNotOptimize(buffer.data());
+    return points.size();
+  };
+}
+
+Operation PrepareLoadOuterPath(mt19937 & rng)
+{
+  vector<char> buffer;
+  PushBackByteSink<vector<char>> sink(buffer);
+  serial::SaveOuterPath(MakePolyline(rng, kPolylinePointsCount, 1e-3),
+                        serial::GeometryCodingParams(), sink);
+
+  return [buffer = move(buffer), points = vector<m2::PointD>()]() mutable {
+    points.clear();
+    ArrayByteSource src(buffer.data());
+    serial::LoadOuterPath(src, serial::GeometryCodingParams(), points);
+    DoNotOptimize(points.data());
+    return points.size();
+  };
+}
+
+Operation PrepareSaveInnerTriangles(mt19937 & rng)
+{
+  return [points = MakePolyline(rng, kStripPointsCount, 1e-4), buffer = vector<char>()]() mutable {
+    buffer.clear();
+    PushBackByteSink<vector<char>> sink(buffer);
+    serial::SaveInnerTriangles(points, serial::GeometryCodingParams(), sink);
+    DoNotOptimize(buffer.data());
+    return points.size() - 2;
+  };
+}
+
+Operation PrepareLoadInnerTriangles(mt19937 & rng)
+{
+  vector<char> buffer;
+  PushBackByteSink<vector<char>> sink(buffer);
+  serial::SaveInnerTriangles(MakePolyline(rng, kStripPointsCount, 1e-4),
+                             serial::GeometryCodingParams(), sink);
+
+  return [buffer = move(buffer)]() {
+    serial::OutPointsT triangles;
+    serial::LoadInnerTriangles(buffer.data(), kStripPointsCount, serial::GeometryCodingParams(),
+                               triangles);
+    DoNotOptimize(triangles.data());
+    return kStripPointsCount - 2;
+  };
+}
+
+template <typename Fn>
+Operation PrepareBitVectorOperation(mt19937 & rng, Fn && fn)
+{
+  // A sparse vector and a dense one, so the operations mix both representations.
+  shared_ptr<coding::CompressedBitVector> const lhs =
+      coding::CompressedBitVectorBuilder::FromBitPositions(
+          MakeBitPositions(rng, kBitVectorSize, 0.01));
+  shared_ptr<coding::CompressedBitVector> const rhs =
+      coding::CompressedBitVectorBuilder::FromBitPositions(
+          MakeBitPositions(rng, kBitVectorSize, 0.3));
+
+  return [lhs, rhs, fn]() {
+    auto const result = fn(*lhs, *rhs);
+    DoNotOptimize(result->PopCount());
+    return static_cast<size_t>(kBitVectorSize);
+  };
+}
+
+Operation PrepareBitVectorUnion(mt19937 & rng)
+{
+  return PrepareBitVectorOperation(rng, &coding::CompressedBitVector::Union);
+}
+
+Operation PrepareBitVectorIntersect(mt19937 & rng)
+{
+  return PrepareBitVectorOperation(rng, &coding::CompressedBitVector::Intersect);
+}
+
+Operation PrepareBitVectorSubtract(mt19937 & rng)
+{
+  return PrepareBitVectorOperation(rng, &coding::CompressedBitVector::Subtract);
+}
+
+// HuffmanCoder is not copyable, so it is shared by the copies of the operation.
+pair<shared_ptr<coding::HuffmanCoder>, vector<strings::UniString>> MakeHuffmanCoder(mt19937 & rng)
+{
+  vector<strings::UniString> strings;
+  for (size_t i = 0; i < kHuffmanStringsCount; ++i)
+    strings.push_back(strings::MakeUniString(MakeString(rng, 4, 24)));
+
+  auto coder = make_shared<coding::HuffmanCoder>();
+  coder->Init(strings);
+  return {move(coder), move(strings)};
+}
+
+Operation PrepareHuffmanEncode(mt19937 & rng)
+{
+  auto input = MakeHuffmanCoder(rng);
+  return [coder = move(input.first), strings = move(input.second),
+          buffer = vector<uint8_t>()]() mutable {
+    buffer.clear();
+    MemWriter<vector<uint8_t>> writer(buffer);
+    for (auto const & s : strings)
+      coder->EncodeAndWrite(writer, s);
+    DoNotOptimize(buffer.data());
+    return strings.size();
+  };
+}
+
+Operation PrepareHuffmanDecode(mt19937 & rng)
+{
+  auto input = MakeHuffmanCoder(rng);
+  vector<uint8_t> buffer;
+  MemWriter<vector<uint8_t>> writer(buffer);
+  for (auto const & s : input.second)
+    input.first->EncodeAndWrite(writer, s);
+
+  return [coder = move(input.first), buffer = move(buffer), s = strings::UniString()]() mutable {
+    MemReader reader(buffer.data(), buffer.size());
+    ReaderSource<MemReader> src(reader);
+    for (size_t i = 0; i < kHuffmanStringsCount; ++i)
+    {
+      s.clear();
+      coder->ReadAndDecode(src, back_inserter(s));
+      DoNotOptimize(s.data());
+    }
+    return kHuffmanStringsCount;
+  };
+}
+
+Operation PrepareMultilangForEach(mt19937 & rng)
+{
+  StringUtf8Multilang names;
+  for (int8_t lang = 0; lang < 16; ++lang)
+    names.AddString(lang, MakeString(rng, 4, 32));
+
+  return [names]() {
+    size_t count = 0;
+    size_t bytes = 0;
+    names.ForEach([&](int8_t /* lang */, string const & name) {
+      ++count;
+      bytes += name.size();
+    });
+    DoNotOptimize(bytes);
+    return count;
+  };
+}
+
+vector<pair<uint32_t, uint32_t>> MakeCellCoords(mt19937 & rng)
+{
+  uniform_int_distribution<uint32_t> coord(0, RectId::MAX_COORD - 1);
+  vector<pair<uint32_t, uint32_t>> coords(kPointsCount);
+  for (auto & xy : coords)
+    xy = {coord(rng), coord(rng)};
+  return coords;
+}
+
+Operation PrepareCellIdFromXY(mt19937 & rng)
+{
+  return [coords = MakeCellCoords(rng)]() {
+    int64_t sum = 0;
+    for (auto const & xy : coords)
+    {
+      sum += RectId::FromXY(xy.first, xy.second, RectId::DEPTH_LEVELS - 1)
+                 .ToInt64(RectId::DEPTH_LEVELS);
+    }
+    DoNotOptimize(sum);
+    return coords.size();
+  };
+}
+
+Operation PrepareCellIdToXY(mt19937 & rng)
+{
+  vector<int64_t> ids;
+  for (auto const & xy : MakeCellCoords(rng))
+  {
+    ids.push_back(RectId::FromXY(xy.first, xy.second, RectId::DEPTH_LEVELS - 1)
+                      .ToInt64(RectId::DEPTH_LEVELS));
+  }
+
+  return [ids = move(ids)]() {
+    uint64_t sum = 0;
+    for (auto const id : ids)
+    {
+      auto const xy = RectId::FromInt64(id, RectId::DEPTH_LEVELS).XY();
+      sum += xy.first + xy.second;
+    }
+    DoNotOptimize(sum);
+    return ids.size();
+  };
+}
+
+Operation PrepareMercatorFromLatLon(mt19937 & rng)
+{
+  uniform_real_distribution<double> lat(-85.0, 85.0);
+  uniform_real_distribution<double> lon(-180.0, 180.0);
+  vector<ms::LatLon> latLons;
+  for (size_t i = 0; i < kPointsCount; ++i)
+    latLons.emplace_back(lat(rng), lon(rng));
+
+  return [latLons = move(latLons)]() {
+    m2::PointD sum;
+    for (auto const & ll : latLons)
+      sum += MercatorBounds::FromLatLon(ll);
+    DoNotOptimize(sum);
+    return latLons.size();
+  };
+}
+
+Operation PrepareMercatorToLatLon(mt19937 & rng)
+{
+  uniform_real_distribution<double> coord(-180.0, 180.0);
+  vector<m2::PointD> points;
+  for (size_t i = 0; i < kPointsCount; ++i)
+    points.emplace_back(coord(rng), coord(rng));
+
+  return [points = move(points)]() {
+    double sum = 0.0;
+    for (auto const & pt : points)
+    {
+      auto const ll = MercatorBounds::ToLatLon(pt);
+      sum += ll.m_lat + ll.m_lon;
+    }
+    DoNotOptimize(sum);
+    return points.size();
+  };
+}
+
+Operation PrepareSimplifyDP(mt19937 & rng)
+{
+  return [points = MakePolyline(rng, kSimplifiedPointsCount, 1e-4),
+          result = vector<m2::PointD>()]() mutable {
+    result.clear();
+    // The epsilon is squared as the distance function is.
+    SimplifyDP(points.begin(), points.end(), 1e-8,
+               m2::SquaredDistanceFromSegmentToPoint<m2::PointD>(),
+               base::MakeBackInsertFunctor(result));
+    DoNotOptimize(result.data());
+    return points.size();
+  };
+}
+
+Operation PrepareRegionContains(mt19937 & rng)
+{
+  // A star shaped polygon: the vertices at the random distances from the center.
+  uniform_real_distribution<double> radius(5.0, 10.0);
+  vector<m2::PointD> vertices;
+  for (size_t i = 0; i < kRegionVerticesCount; ++i)
+  {
+    double const angle = 2 * M_PI * i / kRegionVerticesCount;
+    double const r = radius(rng);
+    vertices.emplace_back(r * cos(angle), r * sin(angle));
+  }
+
+  uniform_real_distribution<double> coord(-11.0, 11.0);
+  vector<m2::PointD> points;
+  for (size_t i = 0; i < kPointsCount; ++i)
+    points.emplace_back(coord(rng), coord(rng));
+
+  return [region = m2::RegionD(vertices.begin(), vertices.end()), points = move(points)]() {
+    size_t inside = 0;
+    for (auto const & pt : points)
+    {
+      if (region.Contains(pt))
+        ++inside;
+    }
+    DoNotOptimize(inside);
+    return points.size();
+  };
+}
+
+Operation PrepareIntervalIndexForEach(mt19937 & rng)
+{
+  uint32_t const keyBits = 2 * RectId::DEPTH_LEVELS;
+  uint64_t const keyEnd = uint64_t{1} << keyBits;
+  uniform_int_distribution<uint64_t> key(0, keyEnd - 1);
+
+  vector<CellValue> cells(kIndexedCellsCount);
+  for (size_t i = 0; i < cells.size(); ++i)
+    cells[i] = {key(rng), static_cast<uint32_t>(i)};
+  sort(cells.begin(), cells.end(),
+       [](CellValue const & lhs, CellValue const & rhs) { return lhs.m_cell < rhs.m_cell; });
+
+  auto buffer = make_shared<vector<uint8_t>>();
+  MemWriter<vector<uint8_t>> writer(*buffer);
+  BuildIntervalIndex(cells.begin(), cells.end(), writer, keyBits);
+
+  // Every interval holds about 64 cells.
+  uint64_t const intervalSize = keyEnd / kIndexedCellsCount * 64;
+  vector<pair<uint64_t, uint64_t>> intervals;
+  for (size_t i = 0; i < kIntervalQueriesCount; ++i)
+  {
+    auto const beg = key(rng) % (keyEnd - intervalSize);
+    intervals.emplace_back(beg, beg + intervalSize);
+  }
+
+  auto index = make_shared<IntervalIndex<MemReader, uint32_t>>(
+      MemReader(buffer->data(), buffer->size()));
+  return [buffer, index, intervals = move(intervals)]() {
+    uint64_t sum = 0;
+    for (auto const & interval : intervals)
+      index->ForEach([&sum](uint64_t, uint32_t value) { sum += value; }, interval.first,
+                     interval.second);
+    DoNotOptimize(sum);
+    return intervals.size();
+  };
+}
+
+vector<Benchmark> const & GetBenchmarks()
+{
+  static vector<Benchmark> const benchmarks = {
+      {"varint/encode", &PrepareVarintEncode},
+      {"varint/decode", &PrepareVarintDecode},
+      {"geometry_coding/save_outer_path", &PrepareSaveOuterPath},
+      {"geometry_coding/load_outer_path", &PrepareLoadOuterPath},
+      {"geometry_coding/save_inner_triangles", &PrepareSaveInnerTriangles},
+      {"geometry_coding/load_inner_triangles", &PrepareLoadInnerTriangles},
+      {"compressed_bit_vector/union", &PrepareBitVectorUnion},
+      {"compressed_bit_vector/intersect", &PrepareBitVectorIntersect},
+      {"compressed_bit_vector/subtract", &PrepareBitVectorSubtract},
+      {"huffman/encode", &PrepareHuffmanEncode},
+      {"huffman/decode", &PrepareHuffmanDecode},
+      {"string_utf8_multilang/for_each", &PrepareMultilangForEach},
+      {"cell_id/from_xy", &PrepareCellIdFromXY},
+      {"cell_id/to_xy", &PrepareCellIdToXY},
+      {"mercator/from_lat_lon", &PrepareMercatorFromLatLon},
+      {"mercator/to_lat_lon", &PrepareMercatorToLatLon},
+      {"simplification/simplify_dp", &PrepareSimplifyDP},
+      {"region/contains", &PrepareRegionContains},
+      {"interval_index/for_each", &PrepareIntervalIndexForEach},
+  };
+  return benchmarks;
+}
+
+void PrintText(vector<BenchmarkResult> const & results)
+{
+  cout << left << setw(40) << "benchmark" << right << setw(14) << "iterations" << setw(16)
+       << "ns/op" << setw(16) << "items/s" << endl;
+  for (auto const & r : results)
+  {
+    cout << left << setw(40) << r.m_name << right << setw(14) << r.m_iterations << setw(16)
+         << fixed << setprecision(1) << r.m_nsPerOp << setw(16) << setprecision(0)
+         << r.m_itemsPerSecond << endl;
+  }
+}
+
+// The layout follows the json reports of Google Benchmark, so the same tools can compare them.
+void PrintJson(BenchmarkOptions const & options, vector<BenchmarkResult> const & results)
+{
+  auto root = base::NewJSONObject();
+  auto context = base::NewJSONObject();
+  ToJSONObject(*context, "seed", options.m_seed);
+  ToJSONObject(*context, "min_time_s", options.m_minTimeSeconds);
+  ToJSONObject(*root, "context", context);
+
+  auto benchmarks = base::NewJSONArray();
+  for (auto const & r : results)
+  {
+    auto benchmark = base::NewJSONObject();
+    ToJSONObject(*benchmark, "name", r.m_name);
+    ToJSONObject(*benchmark, "iterations", r.m_iterations);
+    ToJSONObject(*benchmark, "real_time", r.m_nsPerOp);
+    ToJSONObject(*benchmark, "time_unit", "ns");
+    ToJSONObject(*benchmark, "items_per_second", r.m_itemsPerSecond);
+    ToJSONArray(*benchmarks, benchmark);
+  }
+  ToJSONObject(*root, "benchmarks", benchmarks);
+
+  cout << base::DumpToString(root, JSON_INDENT(2)) << endl;
+}
+
+BenchmarkOptions DefineOptions(int argc, char * argv[])
+{
+  BenchmarkOptions o;
+  po::options_description optionsDescription;
+
+  optionsDescription.add_options()
+    ("filter", po::value(&o.m_filter)->default_value(""), "Run only the benchmarks whose names contain the filter")
+    ("min_time", po::value(&o.m_minTimeSeconds)->default_value(0.5), "Minimal time in seconds to run a benchmark for")
+    ("seed", po::value(&o.m_seed)->default_value(1), "Seed of the generated inputs")
+    ("json", po::bool_switch(&o.m_json), "Print the report as json")
+    ("help", "produce help message");
+
+  po::variables_map vm;
+
+  po::store(po::parse_command_line(argc, argv, optionsDescription), vm);
+  po::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << optionsDescription << std::endl;
+    exit(1);
+  }
+
+  return o;
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  BenchmarkOptions options;
+  try
+  {
+    options = DefineOptions(argc, argv);
+  }
+  catch(po::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    return 1;
+  }
+
+  if (options.m_minTimeSeconds <= 0)
+  {
+    std::cerr << "ERROR: min_time must be positive" << std::endl;
+    return 1;
+  }
+
+  vector<BenchmarkResult> results;
+  for (auto const & benchmark : GetBenchmarks())
+  {
+    if (benchmark.m_name.find(options.m_filter) == string::npos)
+      continue;
+
+    // Every benchmark gets the same generator, so its inputs do not depend on the filter.
+    mt19937 rng(options.m_seed);
+    auto const operation = benchmark.m_prepare(rng);
+    results.push_back(Run(benchmark.m_name, operation, options.m_minTimeSeconds));
+  }
+
+  if (options.m_json)
+    PrintJson(options, results);
+  else
+    PrintText(results);
+
+  return 0;
+}
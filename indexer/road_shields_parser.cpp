@@ -6,6 +6,11 @@
 
 #include <algorithm>
 #include <array>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -526,6 +531,56 @@ public:
     return RoadShield(RoadShieldType::Default, rawText);
   }
 };
+
+template <typename Parser>
+std::set<RoadShield> Parse(std::string const & roadNumber)
+{
+  return Parser(roadNumber).GetRoadShields();
+}
+
+using ParseFn = std::set<RoadShield> (*)(std::string const & roadNumber);
+
+// The parsers of the countries, the roads of the other countries are parsed by
+// SimpleRoadShieldParser.
+std::array<std::pair<char const *, ParseFn>, 14> const kCountryParsers = {{
+    {"US", &Parse<USRoadShieldParser>},
+    {"UK", &Parse<UKRoadShieldParser>},
+    {"Russia", &Parse<RussiaRoadShieldParser>},
+    {"France", &Parse<FranceRoadShieldParser>},
+    {"Germany", &Parse<GermanyRoadShieldParser>},
+    {"Spain", &Parse<SpainRoadShieldParser>},
+    {"Ukraine", &Parse<UkraineRoadShieldParser>},
+    {"Belarus", &Parse<BelarusRoadShieldParser>},
+    {"Latvia", &Parse<LatviaRoadShieldParser>},
+    {"Netherlands", &Parse<NetherlandsRoadShieldParser>},
+    {"Finland", &Parse<FinlandRoadShieldParser>},
+    {"Estonia", &Parse<EstoniaRoadShieldParser>},
+    {"Malaysia", &Parse<MalaysiaRoadShieldParser>},
+    {"Mexico", &Parse<MexicoRoadShieldParser>},
+}};
+
+// Returns the index of the parser of the country of |mwmName| in kCountryParsers,
+// kCountryParsers.size() for SimpleRoadShieldParser.
+size_t GetParser(std::string const & mwmName)
+{
+  ASSERT_NOT_EQUAL(mwmName, FeatureID::kInvalidFileName, ());
+  // Find out country name.
+  auto const country = mwmName.substr(0, mwmName.find('_'));
+  auto const it = std::find_if(kCountryParsers.begin(), kCountryParsers.end(),
+                               [&country](auto const & parser) { return country == parser.first; });
+  return static_cast<size_t>(std::distance(kCountryParsers.begin(), it));
+}
+
+std::set<RoadShield> ParseRoadShields(size_t parser, std::string const & roadNumber)
+{
+  if (roadNumber.empty())
+    return std::set<RoadShield>();
+
+  if (parser < kCountryParsers.size())
+    return kCountryParsers[parser].second(roadNumber);
+
+  return SimpleRoadShieldParser(roadNumber, SimpleRoadShieldParser::ShieldTypes()).GetRoadShields();
+}
 }  // namespace
 
 namespace ftypes
@@ -536,43 +591,120 @@ std::set<RoadShield> GetRoadShields(FeatureType & f)
   if (roadNumber.empty())
     return std::set<RoadShield>();
 
-  // Find out country name.
-  std::string mwmName = f.GetID().GetMwmName();
-  ASSERT_NOT_EQUAL(mwmName, FeatureID::kInvalidFileName, ());
-  auto const underlinePos = mwmName.find('_');
-  if (underlinePos != std::string::npos)
-    mwmName = mwmName.substr(0, underlinePos);
-
-  if (mwmName == "US")
-    return USRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "UK")
-    return UKRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Russia")
-    return RussiaRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "France")
-    return FranceRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Germany")
-    return GermanyRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Spain")
-    return SpainRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Ukraine")
-    return UkraineRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Belarus")
-    return BelarusRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Latvia")
-    return LatviaRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Netherlands")
-    return NetherlandsRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Finland")
-    return FinlandRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Estonia")
-    return EstoniaRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Malaysia")
-    return MalaysiaRoadShieldParser(roadNumber).GetRoadShields();
-  if (mwmName == "Mexico")
-    return MexicoRoadShieldParser(roadNumber).GetRoadShields();
+  return GetRoadShields(f.GetID().GetMwmName(), roadNumber);
+}
 
-  return SimpleRoadShieldParser(roadNumber, SimpleRoadShieldParser::ShieldTypes()).GetRoadShields();
+std::set<RoadShield> GetRoadShields(std::string const & mwmName, std::string const & roadNumber)
+{
+  if (roadNumber.empty())
+    return std::set<RoadShield>();
+
+  return ParseRoadShields(GetParser(mwmName), roadNumber);
+}
+
+// RoadShieldsCache --------------------------------------------------------------------------------
+// static
+size_t constexpr RoadShieldsCache::kShardsCount;
+
+RoadShieldsCache::RoadShieldsCache(uint32_t logCacheSize)
+{
+  static_assert((kShardsCount & (kShardsCount - 1)) == 0, "");
+  uint32_t logShardsCount = 0;
+  while ((size_t{1} << logShardsCount) < kShardsCount)
+    ++logShardsCount;
+
+  // base::Cache needs at least two slots.
+  auto const logShardSize = std::max<uint32_t>(logCacheSize, logShardsCount + 1) - logShardsCount;
+  for (auto & shard : m_shards)
+    shard.m_cache.Init(logShardSize);
+}
+
+RoadShieldsPtr RoadShieldsCache::Get(FeatureType & f)
+{
+  std::string const roadNumber = f.GetRoadNumber();
+  if (roadNumber.empty())
+    return Get(0 /* parser */, roadNumber);
+
+  return Get(f.GetID().GetMwmName(), roadNumber);
+}
+
+RoadShieldsPtr RoadShieldsCache::Get(std::string const & mwmName, std::string const & roadNumber)
+{
+  return Get(GetParser(mwmName), roadNumber);
+}
+
+std::vector<RoadShieldsPtr> RoadShieldsCache::Get(std::string const & mwmName,
+                                                  std::vector<std::string> const & roadNumbers)
+{
+  auto const parser = GetParser(mwmName);
+  std::vector<RoadShieldsPtr> result(roadNumbers.size());
+  std::unordered_map<std::string, RoadShieldsPtr> batchShields;
+  for (size_t i = 0; i < roadNumbers.size(); ++i)
+  {
+    auto & shields = batchShields[roadNumbers[i]];
+    if (!shields)
+      shields = Get(parser, roadNumbers[i]);
+    result[i] = shields;
+  }
+  return result;
+}
+
+void RoadShieldsCache::Clear()
+{
+  for (auto & shard : m_shards)
+  {
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    shard.m_cache.ForEachValue([](Value & value) { value = Value{}; });
+    shard.m_cache.Reset();
+  }
+  m_accesses = 0;
+  m_hits = 0;
+}
+
+double RoadShieldsCache::GetHitRatio() const
+{
+  uint64_t const accesses = m_accesses;
+  if (accesses == 0)
+    return 0.0;
+  return static_cast<double>(m_hits) / static_cast<double>(accesses);
+}
+
+RoadShieldsPtr RoadShieldsCache::Get(size_t parser, std::string const & roadNumber)
+{
+  // Most of the roads have no refs.
+  static RoadShieldsPtr const kNoShields = std::make_shared<std::set<RoadShield> const>();
+  if (roadNumber.empty())
+    return kNoShields;
+
+  ++m_accesses;
+  auto const hash = std::hash<std::string>{}(roadNumber) * 1000003ULL ^ parser;
+  auto & shard = m_shards[hash % kShardsCount];
+  {
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    bool found = false;
+    auto & value = shard.m_cache.Find(hash, found);
+    if (found && value.m_valid && value.m_parser == parser && value.m_roadNumber == roadNumber)
+    {
+      ++m_hits;
+      return value.m_shields;
+    }
+
+    // Find() has taken the slot for |hash|, the previous value must not be returned for it.
+    if (!found)
+      value = Value{};
+  }
+
+  // The shields are parsed out of the lock.
+  auto shields = std::make_shared<std::set<RoadShield> const>(ParseRoadShields(parser, roadNumber));
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+  bool found = false;
+  auto & value = shard.m_cache.Find(hash, found);
+  value.m_valid = true;
+  value.m_parser = parser;
+  value.m_roadNumber = roadNumber;
+  value.m_shields = shields;
+  return shields;
 }
 
 std::string DebugPrint(RoadShieldType shieldType)
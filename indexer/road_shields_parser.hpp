@@ -4,7 +4,16 @@
 
 #include "geometry/rect2d.hpp"
 
+#include "base/cache.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -53,6 +62,60 @@ struct RoadShield
 };
 
 std::set<RoadShield> GetRoadShields(FeatureType & f);
+// The shields of the road with |roadNumber| (the ref) in the mwm |mwmName|, the shields are
+// parsed by the rules of the country of the mwm.
+std::set<RoadShield> GetRoadShields(std::string const & mwmName, std::string const & roadNumber);
+
+using RoadShieldsPtr = std::shared_ptr<std::set<RoadShield> const>;
+
+// A size-bounded thread-safe cache of the parsed road shields. The same refs repeat across
+// the segments of the roads, so the shields are parsed once for every country parser and ref
+// and the immutable shields are shared by the roads. The cache is split into shards with
+// their own locks, every shard is a direct-mapped base::Cache.
+class RoadShieldsCache
+{
+public:
+  // |logCacheSize| is the log2 of the number of cached refs.
+  explicit RoadShieldsCache(uint32_t logCacheSize);
+
+  // The same as GetRoadShields() above.
+  RoadShieldsPtr Get(FeatureType & f);
+  RoadShieldsPtr Get(std::string const & mwmName, std::string const & roadNumber);
+  // The shields of |roadNumbers| of the roads of one mwm for the generator passes,
+  // every distinct ref of the batch is looked up once.
+  std::vector<RoadShieldsPtr> Get(std::string const & mwmName,
+                                  std::vector<std::string> const & roadNumbers);
+
+  void Clear();
+
+  uint64_t GetAccessesCount() const { return m_accesses; }
+  uint64_t GetHitsCount() const { return m_hits; }
+  double GetHitRatio() const;
+
+private:
+  static size_t constexpr kShardsCount = 8;
+
+  struct Value
+  {
+    bool m_valid = false;
+    size_t m_parser = 0;
+    std::string m_roadNumber;
+    RoadShieldsPtr m_shields;
+  };
+
+  struct Shard
+  {
+    std::mutex m_mutex;
+    base::Cache<uint64_t, Value> m_cache;
+  };
+
+  RoadShieldsPtr Get(size_t parser, std::string const & roadNumber);
+
+  std::array<Shard, kShardsCount> m_shards;
+  std::atomic<uint64_t> m_accesses{0};
+  std::atomic<uint64_t> m_hits{0};
+};
+
 std::string DebugPrint(RoadShieldType shieldType);
 std::string DebugPrint(RoadShield const & shield);
 }  // namespace ftypes
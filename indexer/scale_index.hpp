@@ -63,6 +63,20 @@ public:
     }
   }
 
+  // Walks the index of each scale once for all the sorted non-overlapping |intervals|,
+  // see IntervalIndex::ForEachInIntervals().
+  template <typename Intervals>
+  void ForEachInIntervalsAndScale(Intervals const & intervals, int scale,
+                                  std::function<void(uint64_t, uint32_t)> const & fn) const
+  {
+    auto const scaleBucket = BucketByScale(scale);
+    if (scaleBucket < m_IndexForScale.size())
+    {
+      for (size_t i = 0; i <= scaleBucket; ++i)
+        m_IndexForScale[i]->ForEachInIntervals(fn, intervals);
+    }
+  }
+
 private:
   std::vector<std::unique_ptr<IntervalIndex<Reader, uint32_t>>> m_IndexForScale;
 };
@@ -19,13 +19,18 @@
 #include "base/logging.hpp"
 #include "base/macros.hpp"
 #include "base/scope_guard.hpp"
+#include "base/thread_pool_computational.hpp"
 
 #include <algorithm>
+#include <future>
+#include <iterator>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <boost/sort/sort.hpp>
+
 
 namespace covering
 {
@@ -120,50 +125,54 @@ private:
   std::vector<uint32_t> & m_cellsInBucket;
 };
 
-template <class FeaturesVector, class Writer>
-void IndexScales(feature::DataHeader const & header, FeaturesVector const & features,
-                 Writer & writer, std::string const & tmpFilePrefix)
-{
-  // TODO: Make scale bucketing dynamic.
-
-  uint32_t const bucketsCount = header.GetLastScale() + 1;
+// The cells of the features are sorted in memory up to this size.
+uint64_t constexpr kMaxInMemoryCellsBytes = uint64_t{4} * 1024 * 1024 * 1024;
 
-  std::string const cellsToFeatureAllBucketsFile =
-      tmpFilePrefix + CELL2FEATURE_SORTED_EXT + ".allbuckets";
-  SCOPE_GUARD(cellsToFeatureAllBucketsFileGuard,
-              bind(&FileWriter::DeleteFileX, cellsToFeatureAllBucketsFile));
+// Collects the cells of the features in memory up to |maxBytes|,
+// passes all the cells to |sorter| after that. Cells are not collected with zero |maxBytes|.
+template <typename Sorter>
+class InMemoryCellsCollector
+{
+public:
+  InMemoryCellsCollector(uint64_t maxBytes, Sorter & sorter)
+    : m_maxBytes(maxBytes), m_sorter(sorter), m_spilled(maxBytes == 0)
   {
-    FileWriter cellsToFeaturesAllBucketsWriter(cellsToFeatureAllBucketsFile);
+  }
 
-    using TSorter = FileSorter<CellFeatureBucketTuple, WriterFunctor<FileWriter>>;
-    using TDisplacementManager = DisplacementManager<TSorter>;
-    WriterFunctor<FileWriter> out(cellsToFeaturesAllBucketsWriter);
-    TSorter sorter(1024 * 1024 /* bufferBytes */, tmpFilePrefix + CELL2FEATURE_TMP_EXT, out);
-    // Heuristically rearrange and filter single-point features to simplify
-    // the runtime decision of whether we should draw a feature
-    // or sacrifice it for the sake of more important ones.
-    TDisplacementManager manager(sorter);
-    std::vector<uint32_t> featuresInBucket(bucketsCount);
-    std::vector<uint32_t> cellsInBucket(bucketsCount);
-    features.ForEach(
-        FeatureCoverer<TDisplacementManager>(header, manager, featuresInBucket, cellsInBucket));
-    manager.Displace();
-    sorter.SortAndFinish();
+  void Add(CellFeatureBucketTuple const & tuple)
+  {
+    if (m_spilled)
+    {
+      m_sorter.Add(tuple);
+      return;
+    }
 
-    for (uint32_t bucket = 0; bucket < bucketsCount; ++bucket)
+    m_tuples.push_back(tuple);
+    if (m_tuples.size() * sizeof(CellFeatureBucketTuple) > m_maxBytes)
     {
-      uint32_t const numCells = cellsInBucket[bucket];
-      uint32_t const numFeatures = featuresInBucket[bucket];
-      double const cellsPerFeature =
-          numFeatures == 0 ? 0.0 : static_cast<double>(numCells) / static_cast<double>(numFeatures);
-      LOG(LINFO, ("Scale index for bucket", bucket, ": Features:", numFeatures, "cells:", numCells,
-                  "cells per feature:", cellsPerFeature));
+      LOG(LINFO, ("Too many cells to sort them in memory, spilling them."));
+      for (auto const & t : m_tuples)
+        m_sorter.Add(t);
+      m_tuples = {};
+      m_spilled = true;
     }
   }
 
-  FileReader reader(cellsToFeatureAllBucketsFile);
-  DDVector<CellFeatureBucketTuple, FileReader, uint64_t> cellsToFeaturesAllBuckets(reader);
+  bool IsSpilled() const { return m_spilled; }
+  std::vector<CellFeatureBucketTuple> & GetTuples() { return m_tuples; }
+
+private:
+  uint64_t m_maxBytes;
+  Sorter & m_sorter;
+  bool m_spilled;
+  std::vector<CellFeatureBucketTuple> m_tuples;
+};
 
+template <class Writer>
+void WriteBucketsIndexes(
+    DDVector<CellFeatureBucketTuple, FileReader, uint64_t> const & cellsToFeaturesAllBuckets,
+    uint32_t bucketsCount, Writer & writer, std::string const & tmpFilePrefix)
+{
   VarSerialVectorWriter<Writer> recordWriter(writer, bucketsCount);
   auto it = cellsToFeaturesAllBuckets.begin();
 
@@ -192,6 +201,118 @@ void IndexScales(feature::DataHeader const & header, FeaturesVector const & feat
     }
     recordWriter.FinishRecord();
   }
+}
+
+// Builds the interval indexes of the buckets of sorted |tuples| concurrently in memory
+// and writes them in the order of the buckets.
+template <class Writer>
+void WriteBucketsIndexes(std::vector<CellFeatureBucketTuple> const & tuples,
+                         uint32_t bucketsCount, Writer & writer, unsigned int threadsCount)
+{
+  base::thread_pool::computational::ThreadPool threadPool{threadsCount};
+  std::vector<std::future<std::vector<char>>> bucketsIndexes;
+  auto it = tuples.begin();
+  for (uint32_t bucket = 0; bucket < bucketsCount; ++bucket)
+  {
+    auto const bucketEnd = std::find_if(it, tuples.end(), [bucket](auto const & tuple) {
+      return tuple.GetBucket() != bucket;
+    });
+    bucketsIndexes.push_back(threadPool.Submit([bucket, beg = it, end = bucketEnd]() {
+      std::vector<CellFeatureBucketTuple::CellFeaturePair> cellsToFeatures;
+      cellsToFeatures.reserve(static_cast<size_t>(std::distance(beg, end)));
+      for (auto i = beg; i != end; ++i)
+        cellsToFeatures.push_back(i->GetCellFeaturePair());
+
+      std::vector<char> buffer;
+      MemWriter<std::vector<char>> bufferWriter(buffer);
+      LOG(LINFO, ("Building interval index for bucket:", bucket));
+      BuildIntervalIndex(cellsToFeatures.begin(), cellsToFeatures.end(), bufferWriter,
+                         RectId::DEPTH_LEVELS * 2 + 1);
+      return buffer;
+    }));
+    it = bucketEnd;
+  }
+  CHECK(it == tuples.end(), ());
+
+  VarSerialVectorWriter<Writer> recordWriter(writer, bucketsCount);
+  for (auto & bucketIndex : bucketsIndexes)
+  {
+    auto const buffer = bucketIndex.get();
+    writer.Write(buffer.data(), buffer.size());
+    recordWriter.FinishRecord();
+  }
+}
+
+// Builds the scale index of |features|. With |threadsCount| > 1 the cells are sorted in memory
+// when their size is less than kMaxInMemoryCellsBytes and the indexes of the buckets are built
+// concurrently. The index is the same for any |threadsCount|.
+template <class FeaturesVector, class Writer>
+void IndexScales(feature::DataHeader const & header, FeaturesVector const & features,
+                 Writer & writer, std::string const & tmpFilePrefix, unsigned int threadsCount = 1)
+{
+  // TODO: Make scale bucketing dynamic.
+
+  uint32_t const bucketsCount = header.GetLastScale() + 1;
+
+  std::string const cellsToFeatureAllBucketsFile =
+      tmpFilePrefix + CELL2FEATURE_SORTED_EXT + ".allbuckets";
+  SCOPE_GUARD(cellsToFeatureAllBucketsFileGuard,
+              bind(&FileWriter::DeleteFileX, cellsToFeatureAllBucketsFile));
+  bool inMemory = false;
+  std::vector<CellFeatureBucketTuple> tuples;
+  {
+    FileWriter cellsToFeaturesAllBucketsWriter(cellsToFeatureAllBucketsFile);
+
+    using TSorter = ParallelFileSorter<CellFeatureBucketTuple, WriterFunctor<FileWriter>>;
+    using TCollector = InMemoryCellsCollector<TSorter>;
+    using TDisplacementManager = DisplacementManager<TCollector>;
+    WriterFunctor<FileWriter> out(cellsToFeaturesAllBucketsWriter);
+    // The large runs let the spilled cells be sorted in parallel too.
+    TSorter sorter((threadsCount > 1 ? 256 : 2) * 1024 * 1024 /* bufferBytes */,
+                   tmpFilePrefix + CELL2FEATURE_TMP_EXT, out, std::less<CellFeatureBucketTuple>(),
+                   threadsCount);
+    TCollector collector(threadsCount > 1 ? kMaxInMemoryCellsBytes : 0 /* maxBytes */, sorter);
+    // Heuristically rearrange and filter single-point features to simplify
+    // the runtime decision of whether we should draw a feature
+    // or sacrifice it for the sake of more important ones.
+    TDisplacementManager manager(collector, threadsCount);
+    std::vector<uint32_t> featuresInBucket(bucketsCount);
+    std::vector<uint32_t> cellsInBucket(bucketsCount);
+    features.ForEach(
+        FeatureCoverer<TDisplacementManager>(header, manager, featuresInBucket, cellsInBucket));
+    manager.Displace();
+    inMemory = threadsCount > 1 && !collector.IsSpilled();
+    if (inMemory)
+    {
+      tuples = std::move(collector.GetTuples());
+      boost::sort::block_indirect_sort(tuples.begin(), tuples.end(), threadsCount);
+    }
+    else
+    {
+      sorter.SortAndFinish();
+    }
+
+    for (uint32_t bucket = 0; bucket < bucketsCount; ++bucket)
+    {
+      uint32_t const numCells = cellsInBucket[bucket];
+      uint32_t const numFeatures = featuresInBucket[bucket];
+      double const cellsPerFeature =
+          numFeatures == 0 ? 0.0 : static_cast<double>(numCells) / static_cast<double>(numFeatures);
+      LOG(LINFO, ("Scale index for bucket", bucket, ": Features:", numFeatures, "cells:", numCells,
+                  "cells per feature:", cellsPerFeature));
+    }
+  }
+
+  if (inMemory)
+  {
+    WriteBucketsIndexes(tuples, bucketsCount, writer, threadsCount);
+  }
+  else
+  {
+    FileReader reader(cellsToFeatureAllBucketsFile);
+    DDVector<CellFeatureBucketTuple, FileReader, uint64_t> cellsToFeaturesAllBuckets(reader);
+    WriteBucketsIndexes(cellsToFeaturesAllBuckets, bucketsCount, writer, tmpFilePrefix);
+  }
 
   // todo(@pimenov). There was an old todo here that said there were
   // features (coastlines) that have been indexed despite being invisible at the last scale.
@@ -9,6 +9,8 @@
 #include "3party/utfcpp/source/utf8/unchecked.h"
 
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -74,12 +76,63 @@ size_t GetMaxErrorsForToken(strings::UniString const & token)
   return GetMaxErrorsForTokenLength(token.size());
 }
 
-strings::LevenshteinDFA BuildLevenshteinDFA(strings::UniString const & s)
+strings::UniversalLevenshteinDFA BuildLevenshteinDFA(strings::UniString const & s)
 {
   // In search we use LevenshteinDFAs for fuzzy matching. But due to
   // performance reasons, we limit prefix misprints to fixed set of substitutions defined in
   // kAllowedMisprints and skipped letters.
-  return strings::LevenshteinDFA(s, 1 /* prefixSize */, kAllowedMisprints, GetMaxErrorsForToken(s));
+  return strings::UniversalLevenshteinDFA(s, 1 /* prefixSize */, kAllowedMisprints,
+                                          GetMaxErrorsForToken(s));
+}
+
+bool IsAsciiString(string const & s)
+{
+  uint64_t constexpr kHighBits = 0x8080808080808080ULL;
+
+  size_t i = 0;
+  size_t const n = s.size();
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+  {
+    uint64_t word;
+    memcpy(&word, s.data() + i, sizeof(word));
+    if ((word & kHighBits) != 0)
+      return false;
+  }
+  for (; i < n; ++i)
+  {
+    if ((static_cast<uint8_t>(s[i]) & 0x80) != 0)
+      return false;
+  }
+  return true;
+}
+
+void NormalizeAsciiString(string const & s, string & result)
+{
+  ASSERT(IsAsciiString(s), (s));
+
+  uint64_t constexpr kOnes = 0x0101010101010101ULL;
+  uint64_t constexpr kHighBits = 0x80 * kOnes;
+
+  result.resize(s.size());
+  size_t i = 0;
+  size_t const n = s.size();
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+  {
+    uint64_t word;
+    memcpy(&word, s.data() + i, sizeof(word));
+    // The chars are less than 0x80, so the bytes do not overflow: the high bit of a byte
+    // of |geA| is set iff the char is not less than 'A', of |gtZ| iff it is greater than 'Z'.
+    uint64_t const geA = word + (0x80 - 'A') * kOnes;
+    uint64_t const gtZ = word + (0x80 - 'Z' - 1) * kOnes;
+    uint64_t const upper = geA & ~gtZ & kHighBits;
+    word |= upper >> 2;
+    memcpy(&result[i], &word, sizeof(word));
+  }
+  for (; i < n; ++i)
+  {
+    char const c = s[i];
+    result[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+  }
 }
 
 UniString NormalizeAndSimplifyString(string const & s)
@@ -194,6 +247,31 @@ void PreprocessBeforeTokenization(strings::UniString & query)
   }
 }
 
+// NormalizedTokens --------------------------------------------------------------------------------
+vector<boost::string_view> const & NormalizedTokens::Tokenize(string const & s)
+{
+  m_tokens.clear();
+  if (IsAsciiString(s))
+  {
+    NormalizeAsciiString(s, m_normalized);
+    ForEachAsciiToken(m_normalized,
+                      [this](char const * data, size_t size) { m_tokens.emplace_back(data, size); });
+    return m_tokens;
+  }
+
+  // The views are made at the end because the buffer may be reallocated.
+  m_buffer.clear();
+  m_ranges.clear();
+  SplitUniString(NormalizeAndSimplifyString(s), [this](UniString const & token) {
+    auto const start = m_buffer.size();
+    utf8::unchecked::utf32to8(token.begin(), token.end(), back_inserter(m_buffer));
+    m_ranges.emplace_back(start, m_buffer.size() - start);
+  }, Delimiters());
+  for (auto const & range : m_ranges)
+    m_tokens.emplace_back(m_buffer.data() + range.first, range.second);
+  return m_tokens;
+}
+
 UniString FeatureTypeToString(uint32_t type)
 {
   string const s = "!type:" + to_string(type);
@@ -426,7 +504,8 @@ bool IsStreetSynonymWithMisprints(UniString const & s)
 
 bool IsStreetSynonymPrefixWithMisprints(UniString const & s)
 {
-  auto const dfa = strings::PrefixDFAModifier<strings::LevenshteinDFA>(BuildLevenshteinDFA(s));
+  auto const dfa =
+      strings::PrefixDFAModifier<strings::UniversalLevenshteinDFA>(BuildLevenshteinDFA(s));
   return g_streets.MatchWithMisprints(dfa);
 }
 
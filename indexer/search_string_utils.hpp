@@ -6,22 +6,59 @@
 #include "base/stl_helpers.hpp"
 #include "base/string_utils.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
 
 namespace search
 {
 size_t GetMaxErrorsForTokenLength(size_t length);
 size_t GetMaxErrorsForToken(strings::UniString const & token);
 
-strings::LevenshteinDFA BuildLevenshteinDFA(strings::UniString const & s);
+// The automaton is not built per token, see strings::UniversalLevenshteinDFA.
+strings::UniversalLevenshteinDFA BuildLevenshteinDFA(strings::UniString const & s);
 
 // This function should be used for all search strings normalization.
 // It does some magic text transformation which greatly helps us to improve our search.
 strings::UniString NormalizeAndSimplifyString(std::string const & s);
 
+// Returns true if all the chars of |s| are ASCII. Checks eight chars at a time.
+bool IsAsciiString(std::string const & s);
+
+// The fast path of NormalizeAndSimplifyString() for an ASCII string: the normalization
+// of the ASCII chars is lowercasing only. Lowercases eight chars at a time.
+// |s| must be ASCII.
+void NormalizeAsciiString(std::string const & s, std::string & result);
+
+// Equals to search::Delimiters() for an ASCII char.
+inline bool IsAsciiDelimiter(char c)
+{
+  return !((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'));
+}
+
+// Calls |fn(char const * data, size_t size)| for the tokens of an ASCII string |s|.
+template <typename Fn>
+void ForEachAsciiToken(std::string const & s, Fn && fn)
+{
+  size_t i = 0;
+  size_t const n = s.size();
+  while (i < n)
+  {
+    while (i < n && IsAsciiDelimiter(s[i]))
+      ++i;
+    size_t const start = i;
+    while (i < n && !IsAsciiDelimiter(s[i]))
+      ++i;
+    if (start != i)
+      fn(s.data() + start, i - start);
+  }
+}
+
 // Replace abbreviations which can be split during tokenization with full form.
 // Eg. "пр-т" -> "проспект".
 void PreprocessBeforeTokenization(strings::UniString & query);
@@ -39,26 +76,62 @@ void NormalizeAndTokenizeString(std::string const & s, Tokens & tokens, Delims c
   SplitUniString(NormalizeAndSimplifyString(s), ::base::MakeBackInsertFunctor(tokens), delims);
 }
 
+template <typename Fn>
+void ForEachNormalizedToken(std::string const & s, Fn && fn)
+{
+  if (IsAsciiString(s))
+  {
+    std::string normalized;
+    NormalizeAsciiString(s, normalized);
+    ForEachAsciiToken(normalized, [&fn](char const * data, size_t size) {
+      fn(strings::UniString(data, data + size));
+    });
+    return;
+  }
+
+  SplitUniString(NormalizeAndSimplifyString(s), std::forward<Fn>(fn), search::Delimiters());
+}
+
 template <typename Tokens>
 void NormalizeAndTokenizeString(std::string const & s, Tokens & tokens)
 {
-  SplitUniString(NormalizeAndSimplifyString(s), ::base::MakeBackInsertFunctor(tokens),
-                 search::Delimiters());
+  ForEachNormalizedToken(s, ::base::MakeBackInsertFunctor(tokens));
 }
 
 template <typename Tokens>
 void NormalizeAndTokenizeAsUtf8(std::string const & s, Tokens & tokens)
 {
   tokens.clear();
+  if (IsAsciiString(s))
+  {
+    std::string normalized;
+    NormalizeAsciiString(s, normalized);
+    ForEachAsciiToken(normalized,
+                      [&tokens](char const * data, size_t size) { tokens.emplace_back(data, size); });
+    return;
+  }
+
   auto const fn = [&](strings::UniString const & s) { tokens.emplace_back(strings::ToUtf8(s)); };
   SplitUniString(NormalizeAndSimplifyString(s), fn, search::Delimiters());
 }
 
-template <typename Fn>
-void ForEachNormalizedToken(std::string const & s, Fn && fn)
+// The normalized UTF-8 tokens of a string as the views into a buffer which is reused
+// between the calls, so the tokenization of many strings does not allocate.
+// The ASCII strings are normalized without the conversion to UniString.
+class NormalizedTokens
 {
-  SplitUniString(NormalizeAndSimplifyString(s), std::forward<Fn>(fn), search::Delimiters());
-}
+public:
+  // The views are valid until the next call.
+  std::vector<boost::string_view> const & Tokenize(std::string const & s);
+
+  std::vector<boost::string_view> const & GetTokens() const { return m_tokens; }
+
+private:
+  std::string m_buffer;
+  std::string m_normalized;
+  std::vector<std::pair<size_t, size_t>> m_ranges;
+  std::vector<boost::string_view> m_tokens;
+};
 
 strings::UniString FeatureTypeToString(uint32_t type);
 
@@ -26,6 +26,7 @@ public:
   Reader GetTrianglesReader(int ind) const;
 
   version::Format GetMWMFormat() const { return m_header.GetFormat(); }
+  bool HasPointsBlocks() const { return m_header.HasPointsBlocks(); }
 
   serial::GeometryCodingParams const & GetDefGeometryCodingParams() const
   {
@@ -7,10 +7,13 @@
 #include "base/buffer_vector.hpp"
 #include "base/checked_cast.hpp"
 #include "base/logging.hpp"
+#include "base/thread_pool_computational.hpp"
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <future>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -230,23 +233,24 @@ void AppendValue(NodeInfo & node, Value const & value)
     LOG(LERROR, ("Cannot append to a finalized value list."));
 }
 
-template <typename Sink, typename Key, typename ValueList, typename Serializer>
-void Build(Sink & sink, Serializer const & serializer,
-           std::vector<std::pair<Key, typename ValueList::Value>> const & data)
+// Adds the keys of the sorted range [beg, end) to the trie whose root is nodes[0] and writes all
+// the nodes below the root to |sink|. The children of the root are left in nodes[0]. The sizes of
+// the children are relative, so the written nodes may be moved to any position of the trie.
+template <typename Sink, typename Iter, typename ValueList, typename Serializer>
+void BuildSubtries(Sink & sink, Serializer const & serializer, Iter const beg, Iter const end,
+                   std::vector<NodeInfo<ValueList>> & nodes)
 {
-  using Value = typename ValueList::Value;
-  using NodeInfo = NodeInfo<ValueList>;
+  using Entry = typename std::iterator_traits<Iter>::value_type;
 
-  std::vector<NodeInfo> nodes;
-  nodes.emplace_back(sink.Pos(), kDefaultChar);
+  ASSERT_EQUAL(nodes.size(), 1, ());
 
-  Key prevKey;
-  std::pair<Key, Value> prevE;  // e for "element".
+  typename Entry::first_type prevKey;
+  Entry prevE;  // e for "element".
 
-  for (auto it = data.begin(); it != data.end(); ++it)
+  for (auto it = beg; it != end; ++it)
   {
     auto e = *it;
-    if (it != data.begin() && e == prevE)
+    if (it != beg && e == prevE)
       continue;
 
     auto const & key = e.first;
@@ -266,10 +270,85 @@ void Build(Sink & sink, Serializer const & serializer,
     std::swap(e, prevE);
   }
 
-  // Pop all the nodes from the stack.
+  // Pop all the nodes except the root from the stack.
   PopNodes(sink, serializer, nodes, nodes.size() - 1);
+}
+
+template <typename Sink, typename Key, typename ValueList, typename Serializer>
+void Build(Sink & sink, Serializer const & serializer,
+           std::vector<std::pair<Key, typename ValueList::Value>> const & data)
+{
+  std::vector<NodeInfo<ValueList>> nodes;
+  nodes.emplace_back(sink.Pos(), kDefaultChar);
+
+  BuildSubtries(sink, serializer, data.begin(), data.end(), nodes);
 
   // Write the root.
   WriteNodeReverse(sink, serializer, kDefaultChar /* baseChar */, nodes.back(), true /* isRoot */);
 }
+
+// Builds the same trie as Build() on the threads of |threadPool|. The sorted keys are split by
+// the first char into parts of about equal size, the subtries of the parts are built into
+// separate buffers and then the buffers are written one after another under the common root.
+template <typename Sink, typename Key, typename ValueList, typename Serializer>
+void Build(Sink & sink, Serializer const & serializer,
+           std::vector<std::pair<Key, typename ValueList::Value>> const & data,
+           base::thread_pool::computational::ThreadPool & threadPool)
+{
+  using Iter = typename std::vector<std::pair<Key, typename ValueList::Value>>::const_iterator;
+  using Buffer = std::vector<uint8_t>;
+
+  struct Part
+  {
+    Iter m_beg;
+    Iter m_end;
+    Buffer m_buffer;
+    std::vector<ChildInfo> m_children;
+  };
+
+  std::vector<NodeInfo<ValueList>> nodes;
+  nodes.emplace_back(sink.Pos(), kDefaultChar);
+
+  // The values of the empty key belong to the root itself.
+  auto it = std::find_if(data.begin(), data.end(), [](auto const & e) { return !e.first.empty(); });
+  BuildSubtries(sink, serializer, data.begin(), it, nodes);
+
+  // A part contains all the keys with the same first char, so the parts share no nodes below
+  // the root. There are several parts per thread to balance the load.
+  auto const partSize = std::max<size_t>(1, data.size() / (threadPool.Size() * 4));
+  std::vector<Part> parts;
+  while (it != data.end())
+  {
+    auto partEnd = it + std::min<size_t>(partSize, data.end() - it);
+    auto const lastChar = (partEnd - 1)->first[0];
+    partEnd = std::find_if(partEnd, data.end(), [&](auto const & e) { return e.first[0] != lastChar; });
+    parts.push_back({it, partEnd, {}, {}});
+    it = partEnd;
+  }
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(parts.size());
+  for (auto & part : parts)
+  {
+    futures.emplace_back(threadPool.Submit([&serializer, &part]() {
+      PushBackByteSink<Buffer> partSink(part.m_buffer);
+      std::vector<NodeInfo<ValueList>> partNodes;
+      partNodes.emplace_back(partSink.Pos(), kDefaultChar);
+      BuildSubtries(partSink, serializer, part.m_beg, part.m_end, partNodes);
+      part.m_children = std::move(partNodes.back().m_children);
+    }));
+  }
+
+  auto & root = nodes.back();
+  for (size_t i = 0; i < parts.size(); ++i)
+  {
+    futures[i].get();
+    auto & part = parts[i];
+    sink.Write(part.m_buffer.data(), part.m_buffer.size());
+    std::move(part.m_children.begin(), part.m_children.end(), std::back_inserter(root.m_children));
+    Buffer().swap(part.m_buffer);
+  }
+
+  WriteNodeReverse(sink, serializer, kDefaultChar /* baseChar */, root, true /* isRoot */);
+}
 }  // namespace trie
@@ -5,13 +5,18 @@
 #include "coding/reader.hpp"
 #include "coding/varint.hpp"
 
+#include "coding/byte_stream.hpp"
+
 #include "base/assert.hpp"
 #include "base/bits.hpp"
+#include "base/buffer_vector.hpp"
 #include "base/macros.hpp"
 
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace trie
 {
@@ -157,6 +162,234 @@ private:
   Serializer m_serializer;
 };
 
+// The trie written by trie::Build() and read in place from the memory, e.g. from a memory
+// mapped section. Unlike Iterator0 the nodes are decoded on the stack, without the readers,
+// the virtual calls and the heap allocated iterators, so the trie can serve as a vocabulary
+// store for the lookups. The memory must outlive the trie.
+template <typename ValueList, typename Serializer>
+class MappedTrie
+{
+public:
+  using Value = typename ValueList::Value;
+  using Label = typename Iterator<ValueList>::Edge::EdgeLabel;
+
+  MappedTrie(void const * data, size_t size, Serializer const & serializer)
+    : m_data(static_cast<char const *>(data))
+    , m_size(static_cast<uint32_t>(size))
+    , m_serializer(serializer)
+  {
+  }
+
+  // Calls |toDo(value)| for the values of |key|.
+  // Returns false if there is no |key| in the trie.
+  template <typename String, typename ToDo>
+  bool ForEachValue(String const & key, ToDo && toDo) const
+  {
+    Node node;
+    ReadNode(0 /* offset */, m_size, false /* isLeaf */, kDefaultChar, node);
+
+    size_t matched = 0;
+    while (matched < key.size())
+    {
+      Child const * next = nullptr;
+      for (auto const & child : node.m_children)
+      {
+        if (child.m_label[0] == static_cast<TrieChar>(key[matched]))
+        {
+          next = &child;
+          break;
+        }
+      }
+      if (next == nullptr || next->m_label.size() > key.size() - matched ||
+          !Matches(key, matched, next->m_label))
+      {
+        return false;
+      }
+
+      matched += next->m_label.size();
+      Node childNode;
+      ReadNode(next->m_offset, next->m_size, next->m_isLeaf, next->m_label.back(), childNode);
+      node = std::move(childNode);
+    }
+
+    if (node.m_values.IsEmpty())
+      return false;
+    node.m_values.ForEach(toDo);
+    return true;
+  }
+
+  // Calls |toDo(key, value)| for each key which starts with |prefix|.
+  template <typename String, typename ToDo>
+  void ForEachWithPrefix(String const & prefix, ToDo && toDo) const
+  {
+    ForEachWithPrefixes(std::vector<String>{prefix},
+                        [&toDo](size_t /* prefixIndex */, String const & key, Value const & value) {
+                          toDo(key, value);
+                        });
+  }
+
+  // Calls |toDo(prefixIndex, key, value)| for each key which starts with |prefixes[prefixIndex]|.
+  // The trie is traversed once for all the prefixes: the nodes which are common to several
+  // prefixes are decoded once and the children to visit are prefetched before the descent.
+  template <typename String, typename ToDo>
+  void ForEachWithPrefixes(std::vector<String> const & prefixes, ToDo && toDo) const
+  {
+    Indices active;
+    for (size_t i = 0; i < prefixes.size(); ++i)
+      active.push_back(i);
+    if (active.empty())
+      return;
+
+    Node root;
+    ReadNode(0 /* offset */, m_size, false /* isLeaf */, kDefaultChar, root);
+    String key;
+    Visit(root, prefixes, active, key, toDo);
+  }
+
+private:
+  using Indices = buffer_vector<size_t, 8>;
+
+  struct Child
+  {
+    Label m_label;
+    uint32_t m_offset = 0;
+    uint32_t m_size = 0;
+    bool m_isLeaf = false;
+  };
+
+  struct Node
+  {
+    ValueList m_values;
+    buffer_vector<Child, 8> m_children;
+  };
+
+  // Returns true if the chars of |label| match the chars of |s| from |pos| while there are any.
+  template <typename String>
+  static bool Matches(String const & s, size_t pos, Label const & label)
+  {
+    for (size_t i = 0; i < label.size() && pos + i < s.size(); ++i)
+    {
+      if (static_cast<TrieChar>(s[pos + i]) != label[i])
+        return false;
+    }
+    return true;
+  }
+
+  // Decodes the node of |size| bytes at |offset| in the format of Iterator0::ParseNode().
+  void ReadNode(uint32_t offset, uint32_t size, bool isLeaf, TrieChar baseChar, Node & node) const
+  {
+    ASSERT_LESS_OR_EQUAL(offset + size, m_size, ());
+    char const * const begin = m_data + offset;
+    if (isLeaf)
+    {
+      MemReader reader(begin, size);
+      ReaderSource<MemReader> source(reader);
+      node.m_values.Deserialize(source, m_serializer);
+      return;
+    }
+
+    ArrayByteSource source(begin);
+    uint8_t const header = ReadPrimitiveFromSource<uint8_t>(source);
+    uint32_t valueCount = (header >> 6);
+    uint32_t childCount = (header & 63);
+    if (valueCount == 3)
+      valueCount = ReadVarUint<uint32_t>(source);
+    if (childCount == 63)
+      childCount = ReadVarUint<uint32_t>(source);
+
+    node.m_values.Deserialize(source, valueCount, m_serializer);
+
+    node.m_children.resize(childCount);
+    uint32_t childOffset = 0;
+    for (uint32_t i = 0; i < childCount; ++i)
+    {
+      auto & child = node.m_children[i];
+      uint8_t const childHeader = ReadPrimitiveFromSource<uint8_t>(source);
+      child.m_isLeaf = ((childHeader & 128) != 0);
+      if (childHeader & 64)
+      {
+        child.m_label.push_back(baseChar + bits::ZigZagDecode(childHeader & 63U));
+      }
+      else
+      {
+        uint32_t edgeLen = (childHeader & 63);
+        if (edgeLen == 63)
+          edgeLen = ReadVarUint<uint32_t>(source);
+        edgeLen += 1;
+
+        child.m_label.reserve(edgeLen);
+        for (uint32_t j = 0; j < edgeLen; ++j)
+          child.m_label.push_back(baseChar += ReadVarInt<int32_t>(source));
+      }
+
+      child.m_offset = childOffset;
+      if (i != childCount - 1)
+        childOffset += ReadVarUint<uint32_t>(source);
+
+      baseChar = child.m_label[0];
+    }
+
+    uint32_t const childrenOffset = offset + static_cast<uint32_t>(source.PtrC() - begin);
+    for (uint32_t i = 0; i < childCount; ++i)
+    {
+      auto & child = node.m_children[i];
+      child.m_offset += childrenOffset;
+      uint32_t const end =
+          i + 1 == childCount ? offset + size : node.m_children[i + 1].m_offset + childrenOffset;
+      child.m_size = end - child.m_offset;
+    }
+  }
+
+  template <typename String, typename ToDo>
+  void Visit(Node const & node, std::vector<String> const & prefixes, Indices const & active,
+             String & key, ToDo & toDo) const
+  {
+    node.m_values.ForEach([&](Value const & value) {
+      for (auto const i : active)
+      {
+        if (prefixes[i].size() <= key.size())
+          toDo(i, static_cast<String const &>(key), value);
+      }
+    });
+
+    buffer_vector<std::pair<size_t, Indices>, 8> moves;
+    for (size_t c = 0; c < node.m_children.size(); ++c)
+    {
+      Indices next;
+      for (auto const i : active)
+      {
+        if (prefixes[i].size() <= key.size() ||
+            Matches(prefixes[i], key.size(), node.m_children[c].m_label))
+        {
+          next.push_back(i);
+        }
+      }
+
+      if (next.empty())
+        continue;
+
+      __builtin_prefetch(m_data + node.m_children[c].m_offset);
+      moves.emplace_back(c, std::move(next));
+    }
+
+    for (auto const & move : moves)
+    {
+      auto const & child = node.m_children[move.first];
+      Node childNode;
+      ReadNode(child.m_offset, child.m_size, child.m_isLeaf, child.m_label.back(), childNode);
+
+      size_t const keySize = key.size();
+      key.insert(key.end(), child.m_label.begin(), child.m_label.end());
+      Visit(childNode, prefixes, move.second, key, toDo);
+      key.resize(keySize);
+    }
+  }
+
+  char const * m_data;
+  uint32_t m_size;
+  Serializer m_serializer;
+};
+
 // Returns iterator to the root of the trie.
 template <class Reader, class ValueList, class Serializer>
 std::unique_ptr<Iterator<ValueList>> ReadTrie(Reader const & reader, Serializer const & serializer)
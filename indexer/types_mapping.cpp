@@ -12,10 +12,8 @@ void IndexAndTypeMapping::Clear()
   m_map.clear();
 }
 
-void IndexAndTypeMapping::Load(istream & s)
+void IndexAndTypeMapping::Load(istream & s, Classificator const & c)
 {
-  Classificator const & c = classif();
-
   string v;
   vector<string> path;
 
@@ -6,12 +6,14 @@
 #include <map>
 #include <vector>
 
+class Classificator;
 
 class IndexAndTypeMapping
 {
 public:
   void Clear();
-  void Load(std::istream & s);
+  // Reads the types by their paths in |c|.
+  void Load(std::istream & s, Classificator const & c);
   bool IsLoaded() const { return !m_types.empty(); }
 
   // Throws std::out_of_range exception.
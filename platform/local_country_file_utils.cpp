@@ -11,12 +11,17 @@
 #include "base/file_name_utils.hpp"
 #include "base/logging.hpp"
 #include "base/string_utils.hpp"
+#include "base/thread_pool_computational.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <future>
 #include <memory>
 #include <regex>
+#include <thread>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "defines.hpp"
 
@@ -233,20 +238,45 @@ void FindAllLocalMapsAndCleanup(int64_t latestVersion, string const & dataDir,
 
   Platform::TFilesWithType fwts;
   Platform::GetFilesByType(dir, Platform::FILE_TYPE_DIRECTORY, fwts);
+
+  vector<pair<string, int64_t>> versionDirs;
   for (auto const & fwt : fwts)
   {
     string const & subdir = fwt.first;
     int64_t version;
     if (!ParseVersion(subdir, version) || version > latestVersion)
       continue;
+    versionDirs.emplace_back(base::JoinPath(dir, subdir), version);
+  }
 
-    string const fullPath = base::JoinPath(dir, subdir);
-    FindAllLocalMapsInDirectoryAndCleanup(fullPath, version, latestVersion, localFiles);
-    Platform::EError err = Platform::RmDir(fullPath);
-    if (err != Platform::ERR_OK && err != Platform::ERR_DIRECTORY_NOT_EMPTY)
-      LOG(LWARNING, ("Can't remove directory:", fullPath, err));
+  // The version directories are scanned and cleaned up in parallel, as the scans of a network
+  // storage are dominated by the latency. The files are collected in the order of directories.
+  vector<vector<LocalCountryFile>> versionFiles(versionDirs.size());
+  if (!versionDirs.empty())
+  {
+    auto const threadsCount = max(min(static_cast<size_t>(thread::hardware_concurrency()),
+                                      versionDirs.size()),
+                                  size_t{1});
+    base::thread_pool::computational::ThreadPool threadPool(threadsCount);
+    vector<future<void>> futures;
+    for (size_t i = 0; i < versionDirs.size(); ++i)
+    {
+      futures.push_back(threadPool.Submit([&, i]() {
+        auto const & fullPath = versionDirs[i].first;
+        FindAllLocalMapsInDirectoryAndCleanup(fullPath, versionDirs[i].second, latestVersion,
+                                              versionFiles[i]);
+        Platform::EError err = Platform::RmDir(fullPath);
+        if (err != Platform::ERR_OK && err != Platform::ERR_DIRECTORY_NOT_EMPTY)
+          LOG(LWARNING, ("Can't remove directory:", fullPath, err));
+      }));
+    }
+    for (auto & f : futures)
+      f.get();
   }
 
+  for (auto & files : versionFiles)
+    localFiles.insert(localFiles.end(), files.begin(), files.end());
+
   // World and WorldCoasts can be stored in app bundle or in resources
   // directory, thus it's better to get them via Platform.
   string const world(WORLD_FILE_NAME);
@@ -23,7 +23,8 @@ enum class Format
   v8,      // February 2016 (long strings in metadata; store seconds since epoch in MwmVersion).
            // December 2016 (index graph section was added in version 161206, between v8 and v9).
   v9,      // April 2017 (OSRM sections are deleted and replaced by cross mwm section).
-  lastFormat = v9
+  v10,     // October 2026 (outer paths are stored in the columnar point blocks).
+  lastFormat = v10
 };
 
 std::string DebugPrint(Format f);